@@ -21,6 +21,7 @@ void oc_on_key_up(oc_scan_code scan, oc_key_code key);
 void oc_on_frame_refresh(void);
 void oc_on_resize(f32 width, f32 height);
 void oc_on_raw_event(oc_event* event);
+void oc_on_events(oc_event* events, u32 count);
 void oc_on_terminate(void);
 
 //----------------------------------------------------------------
@@ -29,6 +30,11 @@ void oc_on_terminate(void);
 void oc_window_set_title(oc_str8 title);
 void oc_window_set_size(oc_vec2 size);
 
+//----------------------------------------------------------------
+// Frame info (time, window size and input state, read without calling the host)
+//----------------------------------------------------------------
+const oc_frame_info* oc_frame_info_get(void);
+
 //----------------------------------------------------------------
 // Quitting
 //----------------------------------------------------------------
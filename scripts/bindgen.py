@@ -124,7 +124,7 @@ def bindgen(apiName, spec, **kwargs):
             print(s, file=guest_bindings)
 
         # host-side stub
-        s = 'void ' + cname + '_stub(const i64* restrict _params, i64* restrict _returns, u8* _mem, oc_wasm* wasm)'
+        s = 'void ' + cname + '_stub(const oc_wasm_slot* restrict _params, oc_wasm_slot* restrict _returns, u8* _mem, oc_wasm* wasm)'
 
         gen_stub = decl.get('gen_stub', True)
         if gen_stub == False:
@@ -168,7 +168,8 @@ def bindgen(apiName, spec, **kwargs):
                 elif argTag == 'p':
                     s += typeCName + ' ' + argName + ' = ('+ typeCName +')((char*)_mem + *(u32*)&_params[' + str(firstArgIndex + argIndex) + ']);\n'
                 elif argTag == 'S':
-                    s += typeCName + ' ' + argName + ' = *('+ typeCName +'*)((char*)_mem + *(u32*)&_params[' + str(firstArgIndex + argIndex) + ']);\n'
+                    s += 'OC_ASSERT_DIALOG((u64)*(u32*)&_params[' + str(firstArgIndex + argIndex) + '] + sizeof(' + typeCName + ') <= oc_wasm_mem_size(wasm), "parameter \''+argName+'\' is out of bounds");\n'
+                    s += '\t' + typeCName + ' ' + argName + ' = *('+ typeCName +'*)((char*)_mem + *(u32*)&_params[' + str(firstArgIndex + argIndex) + ']);\n'
                 else:
                     print('unrecognized type ' + c + ' in procedure signature\n')
                     break
@@ -182,6 +183,10 @@ def bindgen(apiName, spec, **kwargs):
                 argTag = arg['type']['tag']
                 argLen = arg.get('len')
 
+                # length-prefixed strings are validated with a single range check, instead of scanning for a null terminator
+                if argTag == 'S' and typeCName == 'oc_wasm_str8':
+                    s += '\tOC_ASSERT_DIALOG((u64)' + argName + '.ptr + (u64)' + argName + '.len <= oc_wasm_mem_size(wasm), "parameter \''+argName+'\' is out of bounds");\n'
+
                 if argTag == 'p':
                     if argLen == None:
                         printError("binding '" + name + "' missing pointer length decoration for param '" + argName + "'")
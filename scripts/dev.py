@@ -13,7 +13,7 @@ import json
 from . import checksum
 from .bindgen import bindgen
 from .checksum import dirsum
-from .gles_gen import gles_gen
+from .gles_gen import gles_gen, gen_gles_command_buffer
 from .log import *
 from .utils import pushd, removeall, yeetdir, yeetfile
 from .embed_text_files import *
@@ -27,6 +27,11 @@ def attach_dev_commands(subparsers):
     build_cmd.add_argument("--version", help="embed a version string in the Orca CLI tool (default is git commit hash)")
     build_cmd.add_argument("--release", action="store_true", help="compile in release mode (default is debug)")
     build_cmd.add_argument("--wasm-backend", help="specify a wasm backend. Options: wasm3 (default), bytebox")
+    build_cmd.add_argument("--guard-pages", action="store_true", help="catch out-of-bounds wasm memory accesses with guard pages instead of bounds checks (wasm3 only)")
+    build_cmd.add_argument("--simd", action="store_true", help="compile orca-libc and the wasm SDK with wasm SIMD128 (requires the bytebox wasm backend)")
+    build_cmd.add_argument("--malloc-slabs", action="store_true", help="serve small orca-libc allocations from per-size-class slabs instead of dlmalloc")
+    build_cmd.add_argument("--malloc-tracking", action="store_true", help="record orca-libc heap usage per allocation tag, shown in the debug overlay")
+    build_cmd.add_argument("--gles-command-buffer", action="store_true", help="record GLES calls of the wasm SDK in a command buffer replayed by the runtime in bulk (apps must also define OC_GLES_COMMAND_BUFFER=1)")
     build_cmd.set_defaults(func=dev_shellish(build_all))
 
     platform_layer_cmd = subparsers.add_parser("build-platform-layer", help="Build the Orca platform layer from source.")
@@ -47,14 +52,20 @@ def attach_dev_commands(subparsers):
     runtime_cmd = subparsers.add_parser("build-runtime", help="Build the Orca runtime from source.")
     runtime_cmd.add_argument("--release", action="store_true", help="compile in release mode (default is debug)")
     runtime_cmd.add_argument("--wasm-backend", help="specify a wasm backend. Options: wasm3 (default), bytebox")
+    runtime_cmd.add_argument("--guard-pages", action="store_true", help="catch out-of-bounds wasm memory accesses with guard pages instead of bounds checks (wasm3 only)")
     runtime_cmd.set_defaults(func=dev_shellish(build_runtime))
 
     libc_cmd = subparsers.add_parser("build-orca-libc", help="Build the Orca libC from source.")
     libc_cmd.add_argument("--release", action="store_true", help="compile in release mode (default is debug)")
+    libc_cmd.add_argument("--simd", action="store_true", help="compile with wasm SIMD128 (requires the bytebox wasm backend)")
+    libc_cmd.add_argument("--malloc-slabs", action="store_true", help="serve small allocations from per-size-class slabs instead of dlmalloc")
+    libc_cmd.add_argument("--malloc-tracking", action="store_true", help="record heap usage per allocation tag, shown in the debug overlay")
     libc_cmd.set_defaults(func=dev_shellish(build_libc))
 
     sdk_cmd = subparsers.add_parser("build-wasm-sdk", help="Build the Orca wasm sdk from source.")
     sdk_cmd.add_argument("--release", action="store_true", help="compile in release mode (default is debug)")
+    sdk_cmd.add_argument("--simd", action="store_true", help="compile with wasm SIMD128 (requires the bytebox wasm backend)")
+    sdk_cmd.add_argument("--gles-command-buffer", action="store_true", help="record GLES calls in a command buffer replayed by the runtime in bulk (apps must also define OC_GLES_COMMAND_BUFFER=1)")
     sdk_cmd.set_defaults(func=dev_shellish(build_sdk))
 
     tool_cmd = subparsers.add_parser("build-tool", help="Build the Orca CLI tool from source.")
@@ -86,9 +97,13 @@ def dev_shellish(func):
 def build_all(args):
     ensure_programs()
 
-    build_runtime_internal(args.release, args.wasm_backend) # this also builds the platform layer
-    build_libc_internal(args.release)
-    build_sdk_internal(args.release)
+    if args.simd and args.wasm_backend != "bytebox":
+        log_error("--simd requires the bytebox wasm backend (wasm3 can't execute SIMD opcodes)")
+        exit(1)
+
+    build_runtime_internal(args.release, args.wasm_backend, args.guard_pages) # this also builds the platform layer
+    build_libc_internal(args.release, args.simd, args.malloc_slabs, args.malloc_tracking)
+    build_sdk_internal(args.release, args.simd, args.gles_command_buffer)
     build_tool(args)
 
     with open("build/orcaruntime.sum", "w") as f:
@@ -477,7 +492,7 @@ def build_angle_internal(release, force):
 # build runtime
 #------------------------------------------------------
 
-def build_wasm3(release):
+def build_wasm3(release, guard_pages=False):
     print("Building wasm3...")
 
     os.makedirs("build/bin", exist_ok=True)
@@ -485,16 +500,19 @@ def build_wasm3(release):
     os.makedirs("build/obj", exist_ok=True)
 
     if platform.system() == "Windows":
-        build_wasm3_lib_win(release)
+        build_wasm3_lib_win(release, guard_pages)
     elif platform.system() == "Darwin":
-        build_wasm3_lib_mac(release)
+        build_wasm3_lib_mac(release, guard_pages)
     else:
         log_error(f"can't build wasm3 for unknown platform '{platform.system()}'")
         exit(1)
 
 
-def build_wasm3_lib_win(release):
+def build_wasm3_lib_win(release, guard_pages):
     debug_flags = ["/O2", "/Zi"] if release else ["/O1", "/Zi"]
+    if guard_pages:
+        # out-of-bounds accesses fault on guard pages and are turned into traps by the runtime
+        debug_flags.append("/Dd_m3SkipMemoryBoundsCheck=1")
 
     for f in glob.iglob("./src/ext/wasm3/source/*.c"):
         name = os.path.splitext(os.path.basename(f))[0]
@@ -512,7 +530,7 @@ def build_wasm3_lib_win(release):
     ], check=True)
 
 
-def build_wasm3_lib_mac(release):
+def build_wasm3_lib_mac(release, guard_pages):
     includes = ["-Isrc/ext/wasm3/source"]
     debug_flags = ["-g", "-O2"] if release else ["-g", "-O1"]
     flags = [
@@ -522,6 +540,9 @@ def build_wasm3_lib_mac(release):
         "-Dd_m3VerboseErrorMessages",
         f"-mmacos-version-min={MACOS_VERSION_MIN}"
     ]
+    if guard_pages:
+        # out-of-bounds accesses fault on guard pages and are turned into traps by the runtime
+        flags.append("-Dd_m3SkipMemoryBoundsCheck=1")
 
     for f in glob.iglob("src/ext/wasm3/source/*.c"):
         name = os.path.splitext(os.path.basename(f))[0] + ".o"
@@ -549,15 +570,25 @@ def build_bytebox(release):
 
 def build_runtime(args):
     ensure_programs()
-    build_runtime_internal(args.release, args.wasm_backend)
+    build_runtime_internal(args.release, args.wasm_backend, args.guard_pages)
+
+def build_runtime_internal(release, wasm_backend, guard_pages=False):
+    if guard_pages and wasm_backend == "bytebox":
+        log_error("--guard-pages is only supported by the wasm3 backend")
+        exit(1)
 
-def build_runtime_internal(release, wasm_backend):
     build_platform_layer_internal(release)
 
     if wasm_backend == "bytebox":
         build_bytebox(release)
     else:
-        build_wasm3(release)
+        build_wasm3(release, guard_pages)
+
+    # zlib decodes compressed entries of data archives
+    build_zlib()
+
+    # libcurl runs the fetches of oc_fetch_start()
+    build_libcurl()
 
     print("Building Orca runtime...")
 
@@ -565,14 +596,14 @@ def build_runtime_internal(release, wasm_backend):
     os.makedirs("build/lib", exist_ok=True)
 
     if platform.system() == "Windows":
-        build_runtime_win(release, wasm_backend)
+        build_runtime_win(release, wasm_backend, guard_pages)
     elif platform.system() == "Darwin":
-        build_runtime_mac(release, wasm_backend)
+        build_runtime_mac(release, wasm_backend, guard_pages)
     else:
         log_error(f"can't build Orca for unknown platform '{platform.system()}'")
         exit(1)
 
-def build_runtime_win(release, wasm_backend):
+def build_runtime_win(release, wasm_backend, guard_pages):
 
     gen_all_bindings()
 
@@ -581,10 +612,24 @@ def build_runtime_win(release, wasm_backend):
         "/I", "src",
         "/I", "src/ext",
         "/I", "src/ext/angle/include",
+        "/I", "src/ext/zlib",
+        "/I", "src/ext/curl/builds/static/include",
     ]
 
-    defines = []
-    link_commands = ["build/bin/orca.dll.lib"]
+    defines = ["/DCURL_STATICLIB"]
+    link_commands = [
+        "build/bin/orca.dll.lib",
+        "/LIBPATH:src/ext/zlib/build", "zlib.lib",
+
+        # libs needed by curl
+        "advapi32.lib",
+        "crypt32.lib",
+        "normaliz.lib",
+        "ws2_32.lib",
+        "wldap32.lib",
+        "/LIBPATH:src/ext/curl/builds/static/lib",
+        "libcurl_a.lib",
+    ]
 
     debug_flags = ["/O2", "/Zi"] if release else ["/Zi", "/DOC_DEBUG", "/DOC_LOG_COMPILE_DEBUG"]
 
@@ -601,6 +646,9 @@ def build_runtime_win(release, wasm_backend):
         defines += ["/DOC_WASM_BACKEND_WASM3=1", "/DOC_WASM_BACKEND_BYTEBOX=0"]
         link_commands += ["build/bin/wasm3.lib"]
 
+    if guard_pages:
+        defines += ["/DOC_WASM_GUARD_PAGES=1"]
+
     compile_args=[
         "cl",
         *debug_flags,
@@ -618,17 +666,28 @@ def build_runtime_win(release, wasm_backend):
 
     subprocess.run(compile_args, check=True)
 
-def build_runtime_mac(release, wasm_backend):
+def build_runtime_mac(release, wasm_backend, guard_pages):
 
     includes = [
         "-Isrc",
         "-Isrc/ext",
         "-Isrc/ext/angle/include",
+        "-Isrc/ext/zlib",
+        "-Isrc/ext/curl/builds/static/include",
     ]
 
-    defines = []
+    defines = ["-DCURL_STATICLIB"]
+
+    libs = [
+        "-Lbuild/bin", "-Lbuild/lib", "-lorca",
+        "-Lsrc/ext/zlib/build", "-lz",
 
-    libs = ["-Lbuild/bin", "-Lbuild/lib", "-lorca"]
+        # libs needed by curl
+        "-framework", "SystemConfiguration",
+        "-framework", "CoreFoundation",
+        "-framework", "Security",
+        "-Lsrc/ext/curl/builds/static/lib", "-lcurl",
+    ]
 
     if wasm_backend == "bytebox":
         includes += ["-Isrc/ext/bytebox/zig-out/include"]
@@ -639,6 +698,9 @@ def build_runtime_mac(release, wasm_backend):
         defines += ["-DOC_WASM_BACKEND_WASM3=1", "-DOC_WASM_BACKEND_BYTEBOX=0"]
         libs += ["-lwasm3"]
 
+    if guard_pages:
+        defines += ["-DOC_WASM_GUARD_PAGES=1"]
+
     debug_flags = ["-O2"] if release else ["-g", "-DOC_DEBUG -DOC_LOG_COMPILE_DEBUG"]
     flags = [
         *debug_flags,
@@ -745,13 +807,18 @@ def build_platform_layer_lib_win(release):
     embed_text_files("src/graphics/wgpu_renderer_shaders.h", "oc_wgsl_", [
         "src/graphics/wgsl_shaders/common.wgsl",
         "src/graphics/wgsl_shaders/path_setup.wgsl",
+        "src/graphics/wgsl_shaders/path_setup_subgroups.wgsl",
         "src/graphics/wgsl_shaders/segment_setup.wgsl",
+        "src/graphics/wgsl_shaders/stroke_setup.wgsl",
+        "src/graphics/wgsl_shaders/glyph_expand.wgsl",
         "src/graphics/wgsl_shaders/backprop.wgsl",
+        "src/graphics/wgsl_shaders/backprop_subgroups.wgsl",
         "src/graphics/wgsl_shaders/chunk.wgsl",
         "src/graphics/wgsl_shaders/merge.wgsl",
         "src/graphics/wgsl_shaders/balance_workgroups.wgsl",
         "src/graphics/wgsl_shaders/raster.wgsl",
         "src/graphics/wgsl_shaders/blit.wgsl",
+        "src/graphics/wgsl_shaders/mipmap.wgsl",
         "src/graphics/wgsl_shaders/final_blit.wgsl",
     ])
 
@@ -771,6 +838,7 @@ def build_platform_layer_lib_win(release):
         "shcore.lib",
         "delayimp.lib",
         "dwmapi.lib",
+        "avrt.lib",
         "comctl32.lib",
         "ole32.lib",
         "shell32.lib",
@@ -812,13 +880,18 @@ def build_platform_layer_lib_mac(release):
     embed_text_files("src/graphics/wgpu_renderer_shaders.h", "oc_wgsl_", [
         "src/graphics/wgsl_shaders/common.wgsl",
         "src/graphics/wgsl_shaders/path_setup.wgsl",
+        "src/graphics/wgsl_shaders/path_setup_subgroups.wgsl",
         "src/graphics/wgsl_shaders/segment_setup.wgsl",
+        "src/graphics/wgsl_shaders/stroke_setup.wgsl",
+        "src/graphics/wgsl_shaders/glyph_expand.wgsl",
         "src/graphics/wgsl_shaders/backprop.wgsl",
+        "src/graphics/wgsl_shaders/backprop_subgroups.wgsl",
         "src/graphics/wgsl_shaders/chunk.wgsl",
         "src/graphics/wgsl_shaders/merge.wgsl",
         "src/graphics/wgsl_shaders/balance_workgroups.wgsl",
         "src/graphics/wgsl_shaders/raster.wgsl",
         "src/graphics/wgsl_shaders/blit.wgsl",
+        "src/graphics/wgsl_shaders/mipmap.wgsl",
         "src/graphics/wgsl_shaders/final_blit.wgsl",
     ])
 
@@ -852,7 +925,7 @@ def build_platform_layer_lib_mac(release):
         "-o", "build/bin/liborca.dylib",
         "build/orca_c.o", "build/orca_objc.o",
         "-Lbuild/bin", "-lc",
-        "-framework", "Carbon", "-framework", "Cocoa", "-framework", "Metal", "-framework", "QuartzCore", "-framework", "UniformTypeIdentifiers",
+        "-framework", "Carbon", "-framework", "Cocoa", "-framework", "CoreServices", "-framework", "AudioToolbox", "-framework", "Metal", "-framework", "QuartzCore", "-framework", "UniformTypeIdentifiers",
         "-weak-lEGL", "-weak-lGLESv2", "-weak-lwebgpu"
     ], check=True)
 
@@ -887,6 +960,11 @@ def gen_all_bindings():
         wasm3_bindings="src/wasmbind/gles_api_bind_gen.c",
     )
 
+    gen_gles_command_buffer("src/ext/gl.xml",
+        guest_stubs="src/graphics/orca_gles_command_stubs.c",
+        host_replay="src/wasmbind/gles_api_replay_gen.c",
+    )
+
     bindgen("core", "src/wasmbind/core_api.json",
         guest_stubs="src/wasmbind/core_api_stubs.c",
         wasm3_bindings="src/wasmbind/core_api_bind_gen.c",
@@ -908,14 +986,26 @@ def gen_all_bindings():
         wasm3_bindings="src/wasmbind/io_api_bind_gen.c",
     )
 
+    bindgen("net", "src/wasmbind/net_api.json",
+        guest_include="platform/platform_net.h",
+        guest_stubs="src/platform/orca_net_stubs.c",
+        wasm3_bindings="src/wasmbind/net_api_bind_gen.c",
+    )
+
+    bindgen("audio", "src/wasmbind/audio_api.json",
+        guest_include="platform/platform_audio.h",
+        guest_stubs="src/platform/orca_audio_stubs.c",
+        wasm3_bindings="src/wasmbind/audio_api_bind_gen.c",
+    )
+
 #------------------------------------------------------
 # build wasm SDK
 #------------------------------------------------------
 def build_sdk(args):
     ensure_programs()
-    build_sdk_internal(args.release)
+    build_sdk_internal(args.release, args.simd, args.gles_command_buffer)
 
-def build_sdk_internal(release):
+def build_sdk_internal(release, simd=False, gles_command_buffer=False):
     print("Building Orca wasm SDK...")
 
     includes = [
@@ -937,6 +1027,10 @@ def build_sdk_internal(release):
         "-Wl,--export-dynamic",
         "-Wl,--relocatable"
     ]
+    if simd:
+        flags.append("-msimd128")
+    if gles_command_buffer:
+        flags.append("-DOC_GLES_COMMAND_BUFFER=1")
 
     clang = 'clang'
 
@@ -965,9 +1059,9 @@ def build_sdk_internal(release):
 #------------------------------------------------------
 def build_libc(args):
     ensure_programs()
-    build_lib_internal(args.release)
+    build_libc_internal(args.release, args.simd, args.malloc_slabs, args.malloc_tracking)
 
-def build_libc_internal(release):
+def build_libc_internal(release, simd=False, malloc_slabs=False, malloc_tracking=False):
     print("Building orca-libc...")
 
     # create directory and copy header files
@@ -1010,6 +1104,12 @@ def build_libc_internal(release):
         "-mthread-model", "single",
         "-Wl,--relocatable"
     ]
+    if simd:
+        flags.append("-msimd128")
+    if malloc_slabs:
+        flags.append("-DORCA_MALLOC_SLABS")
+    if malloc_tracking:
+        flags.append("-DORCA_MALLOC_TRACKING")
 
     clang = 'clang'
     llvm_ar = 'llvm-ar'
@@ -17,7 +17,7 @@ removeProc = [
 
 def gen_gles_header(spec, filename, log_file):
 	# Generates the GLES header, wrapping gl functions
-	# prototypes in ORCA_IMPORT() macro
+	# prototypes in ORCA_GLES_IMPORT() macro
 
 	gles2through31Pat = '2\.[0-9]|3\.[01]'
 	allVersions = '.*'
@@ -29,7 +29,7 @@ def gen_gles_header(spec, filename, log_file):
 		versions=gles2through31Pat,
 		emitversions=allVersions,
 		protectProto=False,
-		procMacro='ORCA_IMPORT',
+		procMacro='ORCA_GLES_IMPORT',
 		removeProc = removeProc)
 
 	reg = Registry()
@@ -123,8 +123,21 @@ def gen_argcount_len_entry(name, argName, tokens):
 	entry += '}'
 	return entry
 
-def gen_gles_bindgen_json(spec, filename):
+# functions with hand-written bindings in src/wasmbind/gles_api_bind_manual.c
+manualBind = [
+	"glShaderSource",
+	"glGetVertexAttribPointerv",
+	"glVertexAttribPointer",
+	"glVertexAttribIPointer",
+	"glGetString",
+	"glGetStringi",
+	"glGetUniformIndices",
+	"glCreateShaderProgramv",
+	"glDrawArraysIndirect",
+	"glDrawElementsIndirect"
+]
 
+def gather_gles_commands(spec):
 	# Gather gles 3.1 required functions
 	tree = et.parse(spec)
 	api = []
@@ -151,17 +164,10 @@ def gen_gles_bindgen_json(spec, filename):
 		name = command.find('proto/name')
 		commands[name.text] = command
 
-	# TODO: Generate json descriptions for commands in api
+	return api, commands
 
-	manualBind = [
-		"glShaderSource",
-		"glGetVertexAttribPointerv",
-		"glVertexAttribPointer",
-		"glVertexAttribIPointer",
-		"glGetString",
-		"glGetStringi",
-		"glGetUniformIndices"
-	]
+def gen_gles_bindgen_json(spec, filename):
+	api, commands = gather_gles_commands(spec)
 
 	json = '[\n'
 	for name in api:
@@ -241,17 +247,9 @@ def gen_gles_bindgen_json(spec, filename):
 				"glGetUniformLocation"
 			]
 
-			drawIndirectProc = [
-				"glDrawArraysIndirect",
-				"glDrawElementsIndirect"
-			]
-
 			if typeTag == "p":
 				if lenString == None:
-					if name in drawIndirectProc:
-						entry += ',\n'
-						entry += gen_compsize_len_entry(name, argName, ['indirect'])
-					elif name in nullStringProcWithNoLen:
+					if name in nullStringProcWithNoLen:
 						entry += ',\n'
 						entry += gen_compsize_len_entry(name, argName, ['name'])
 					else:
@@ -297,6 +295,261 @@ def gen_gles_bindgen_json(spec, filename):
 	f.write(json)
 	f.close()
 
+#----------------------------------------
+# command buffer
+#----------------------------------------
+
+# Commands that return nothing and only take scalar arguments can be recorded in a buffer in guest memory
+# and replayed later by the host. Other commands (queries, commands that read or write guest memory) flush
+# the buffer and then call their import.
+
+def get_proto_decl(proto):
+	return ''.join(proto.itertext()).strip()
+
+def get_param_decl(param):
+	return ''.join(param.itertext()).strip()
+
+def get_param_type(param):
+	typeName = ''
+	if param.text != None:
+		typeName += param.text
+	typeNode = param.find('ptype')
+	if typeNode != None:
+		if typeNode.text != None:
+			typeName += typeNode.text
+		if typeNode.tail != None:
+			typeName += typeNode.tail
+	return typeName.strip()
+
+# commands that the guest expects to take effect immediately
+syncProc = [
+	"glFinish",
+	"glFlush"
+]
+
+def get_recorded_arg_words(command):
+	# returns the number of 32bit words each argument takes in the command buffer, or None if the command can't be recorded
+	retType = get_param_type(command.find('proto'))
+	if retType != 'void' or command.find('proto/name').text in syncProc:
+		return None
+
+	words = []
+	for param in command.iter('param'):
+		typeName = get_param_type(param)
+		tag = get_bindgen_tag_for_type(typeName)
+		if tag == 'i' or tag == 'f':
+			words.append(1)
+		elif tag == 'I' and typeName != 'GLsync':
+			words.append(2)
+		else:
+			return None
+	return words
+
+def gen_gles_command_buffer(spec, guest_stubs, host_replay):
+	api, commands = gather_gles_commands(spec)
+
+	recorded = []
+	forwarded = []
+	for name in api:
+		command = commands[name]
+		words = get_recorded_arg_words(command)
+		if words != None and name not in manualBind:
+			recorded.append((name, command, words))
+		else:
+			forwarded.append((name, command))
+
+	# the guest and host must agree on opcodes, so both sides are tagged with a hash of the recorded command list
+	tableHash = 0x811c9dc5
+	for name, command, words in recorded:
+		for c in (name + ':' + str(sum(words)) + ';').encode():
+			tableHash = ((tableHash ^ c) * 0x01000193) & 0xffffffff
+
+	header = '/*************************************************************************\n'
+	header += '*\n'
+	header += '*  Orca\n'
+	header += '*  Copyright 2023 Martin Fouilleul and the Orca project contributors\n'
+	header += '*  See LICENSE.txt for licensing information\n'
+	header += '*\n'
+	header += '**************************************************************************/\n'
+	header += '//NOTE: generated by scripts/gles_gen.py, do not edit\n\n'
+
+	#------------------------------------------------------------------------
+	# guest stubs
+	#------------------------------------------------------------------------
+	s = header
+	s += '#include "graphics/orca_gl31.h"\n\n'
+	s += '#ifndef OC_GLES_COMMAND_BUFFER_WORDS\n'
+	s += '    #define OC_GLES_COMMAND_BUFFER_WORDS 16384\n'
+	s += '#endif\n\n'
+	s += '#define OC_GLES_COMMAND_TABLE_HASH 0x%08xu\n\n' % tableHash
+	s += 'enum\n{\n'
+	for i, (name, command, words) in enumerate(recorded):
+		s += '    OC_GLES_CMD_' + name + ' = ' + str(i + 1) + ',\n'
+	s += '};\n\n'
+
+	s += '__attribute__((import_name("oc_gles_command_buffer_register"))) void oc_gles_import_command_buffer_register(void* buffer);\n'
+	s += '__attribute__((import_name("oc_gles_command_buffer_flush"))) void oc_gles_import_command_buffer_flush(void);\n'
+	s += '__attribute__((import_name("oc_gles_command_buffer_sync"))) void oc_gles_import_command_buffer_sync(void);\n\n'
+
+	s += '//NOTE: the runtime clears synced when it hands the GL context to another thread, see src/runtime_gles.h\n'
+
+	s += 'static struct\n{\n'
+	s += '    u32 tableHash;\n'
+	s += '    u32 count;\n'
+	s += '    u32 cap;\n'
+	s += '    u32 synced;\n'
+	s += '    u32 words[OC_GLES_COMMAND_BUFFER_WORDS];\n'
+	s += '} oc_glesCommandBuffer = { .tableHash = OC_GLES_COMMAND_TABLE_HASH, .cap = OC_GLES_COMMAND_BUFFER_WORDS, .synced = 1 };\n\n'
+	s += 'static bool oc_glesCommandBufferRegistered = false;\n\n'
+
+	s += 'static void oc_gles_command_buffer_flush(void)\n{\n'
+	s += '    if(oc_glesCommandBuffer.count)\n'
+	s += '    {\n'
+	s += '        oc_gles_import_command_buffer_flush();\n'
+	s += '        oc_glesCommandBuffer.count = 0;\n'
+	s += '    }\n'
+	s += '}\n\n'
+
+	s += '//NOTE: called before GL calls that aren\'t recorded, which must see the effects of the recorded ones\n'
+	s += 'static void oc_gles_command_buffer_sync(void)\n{\n'
+	s += '    if(oc_glesCommandBuffer.count || !oc_glesCommandBuffer.synced)\n'
+	s += '    {\n'
+	s += '        oc_gles_import_command_buffer_sync();\n'
+	s += '        oc_glesCommandBuffer.count = 0;\n'
+	s += '    }\n'
+	s += '}\n\n'
+
+	s += 'static u32* oc_gles_command_push(u32 opcode, u32 wordCount)\n{\n'
+	s += '    if(!oc_glesCommandBufferRegistered)\n'
+	s += '    {\n'
+	s += '        oc_gles_import_command_buffer_register(&oc_glesCommandBuffer);\n'
+	s += '        oc_glesCommandBufferRegistered = true;\n'
+	s += '    }\n'
+	s += '    if(oc_glesCommandBuffer.count + 1 + wordCount > oc_glesCommandBuffer.cap)\n'
+	s += '    {\n'
+	s += '        oc_gles_command_buffer_flush();\n'
+	s += '    }\n'
+	s += '    u32* words = oc_glesCommandBuffer.words + oc_glesCommandBuffer.count;\n'
+	s += '    oc_glesCommandBuffer.count += 1 + wordCount;\n'
+	s += '    words[0] = opcode;\n'
+	s += '    return (words + 1);\n'
+	s += '}\n\n'
+
+	s += 'static u32 oc_gles_command_f32(f32 x)\n{\n'
+	s += '    u32 bits;\n'
+	s += '    memcpy(&bits, &x, sizeof(u32));\n'
+	s += '    return (bits);\n'
+	s += '}\n\n'
+
+	for name, command, words in recorded:
+		params = list(command.iter('param'))
+		s += get_proto_decl(command.find('proto')) + '('
+		s += ', '.join([get_param_decl(p) for p in params]) if len(params) else 'void'
+		s += ')\n{\n'
+		if len(words):
+			s += '    u32* args = oc_gles_command_push(OC_GLES_CMD_' + name + ', ' + str(sum(words)) + ');\n'
+		else:
+			s += '    oc_gles_command_push(OC_GLES_CMD_' + name + ', 0);\n'
+		index = 0
+		for param, count in zip(params, words):
+			argName = param.find('name').text
+			tag = get_bindgen_tag_for_type(get_param_type(param))
+			if tag == 'f':
+				s += '    args[' + str(index) + '] = oc_gles_command_f32(' + argName + ');\n'
+			elif tag == 'I':
+				s += '    args[' + str(index) + '] = (u32)((u64)' + argName + ');\n'
+				s += '    args[' + str(index + 1) + '] = (u32)((u64)' + argName + ' >> 32);\n'
+			else:
+				s += '    args[' + str(index) + '] = (u32)' + argName + ';\n'
+			index += count
+		s += '}\n\n'
+
+	for name, command in forwarded:
+		params = list(command.iter('param'))
+		paramDecls = ', '.join([get_param_decl(p) for p in params]) if len(params) else 'void'
+		argNames = ', '.join([p.find('name').text for p in params])
+		proto = get_proto_decl(command.find('proto'))
+		retType = get_param_type(command.find('proto'))
+		importProto = proto[:-len(name)] + 'oc_gles_import_' + name
+
+		s += '__attribute__((import_name("' + name + '"))) ' + importProto + '(' + paramDecls + ');\n\n'
+		s += proto + '(' + paramDecls + ')\n{\n'
+		s += '    oc_gles_command_buffer_sync();\n'
+		if retType == 'void':
+			s += '    oc_gles_import_' + name + '(' + argNames + ');\n'
+		else:
+			s += '    return (oc_gles_import_' + name + '(' + argNames + '));\n'
+		s += '}\n\n'
+
+	f = open(guest_stubs, 'w')
+	f.write(s)
+	f.close()
+
+	#------------------------------------------------------------------------
+	# host replay
+	#------------------------------------------------------------------------
+	s = header
+	s += '#define OC_GLES_COMMAND_TABLE_HASH 0x%08xu\n\n' % tableHash
+	s += 'enum\n{\n'
+	for i, (name, command, words) in enumerate(recorded):
+		s += '    OC_GLES_CMD_' + name + ' = ' + str(i + 1) + ',\n'
+	s += '    OC_GLES_CMD_COUNT,\n'
+	s += '};\n\n'
+
+	s += 'static const u8 OC_GLES_CMD_WORD_COUNTS[OC_GLES_CMD_COUNT] = {\n'
+	for name, command, words in recorded:
+		s += '    [OC_GLES_CMD_' + name + '] = ' + str(sum(words)) + ',\n'
+	s += '};\n\n'
+
+	s += 'static f32 oc_gles_command_f32(u32 bits)\n{\n'
+	s += '    f32 x;\n'
+	s += '    memcpy(&x, &bits, sizeof(f32));\n'
+	s += '    return (x);\n'
+	s += '}\n\n'
+
+	s += '//NOTE: returns false if the buffer contains an invalid or truncated command. Commands before it are still replayed.\n'
+	s += 'static bool oc_gles_command_buffer_replay(const u32* words, u32 count)\n{\n'
+	s += '    u32 index = 0;\n'
+	s += '    while(index < count)\n'
+	s += '    {\n'
+	s += '        u32 opcode = words[index];\n'
+	s += '        if(opcode == 0 || opcode >= OC_GLES_CMD_COUNT || count - index - 1 < OC_GLES_CMD_WORD_COUNTS[opcode])\n'
+	s += '        {\n'
+	s += '            return (false);\n'
+	s += '        }\n'
+	s += '        const u32* args = words + index + 1;\n'
+	s += '        index += 1 + OC_GLES_CMD_WORD_COUNTS[opcode];\n\n'
+	s += '        switch(opcode)\n'
+	s += '        {\n'
+	for name, command, words in recorded:
+		params = list(command.iter('param'))
+		callArgs = []
+		index = 0
+		for param, count in zip(params, words):
+			typeName = get_param_type(param)
+			tag = get_bindgen_tag_for_type(typeName)
+			if tag == 'f':
+				callArgs.append('oc_gles_command_f32(args[' + str(index) + '])')
+			elif tag == 'I':
+				callArgs.append('(' + typeName + ')((u64)args[' + str(index) + '] | ((u64)args[' + str(index + 1) + '] << 32))')
+			elif typeName in ['GLint', 'GLsizei', 'GLintptr', 'GLsizeiptr', 'GLfixed', 'GLshort', 'GLbyte']:
+				# sign-extend values that are wider on the host
+				callArgs.append('(' + typeName + ')(i32)args[' + str(index) + ']')
+			else:
+				callArgs.append('(' + typeName + ')args[' + str(index) + ']')
+			index += count
+		s += '            case OC_GLES_CMD_' + name + ':\n'
+		s += '                ' + name + '(' + ', '.join(callArgs) + ');\n'
+		s += '                break;\n'
+	s += '        }\n'
+	s += '    }\n'
+	s += '    return (true);\n'
+	s += '}\n'
+
+	f = open(host_replay, 'w')
+	f.write(s)
+	f.close()
+
 def gles_gen(spec, json, header, log_file):
 	gen_gles_header(spec, header, log_file)
 	gen_gles_bindgen_json(spec, json)
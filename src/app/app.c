@@ -7,6 +7,7 @@
 **************************************************************************/
 #include "app_internal.h"
 #include "platform/platform_debug.h"
+#include "platform/platform_clock.h"
 
 oc_app oc_appData = { 0 };
 
@@ -82,99 +83,290 @@ void oc_window_recycle_ptr(oc_window_data* window)
 static void oc_init_common()
 {
     oc_init_window_handles();
-    oc_ringbuffer_init(&oc_appData.eventQueue, 16);
+    oc_event_queue_init(&oc_appData.eventQueue);
 }
 
 static void oc_terminate_common()
 {
-    oc_ringbuffer_cleanup(&oc_appData.eventQueue);
+    oc_event_queue_cleanup(&oc_appData.eventQueue);
 }
 
 //---------------------------------------------------------------
 // Event handling
 //---------------------------------------------------------------
 
-void oc_queue_event(oc_event* event)
+static void oc_file_change_notify(oc_file dir, u64 window)
 {
-    oc_ringbuffer* queue = &oc_appData.eventQueue;
+    oc_event event = {
+        .window = { .h = window },
+        .type = OC_EVENT_FILE_CHANGE,
+        .fileChange.dir = dir,
+    };
+    oc_queue_event(&event);
+}
 
-    if(oc_ringbuffer_write_available(queue) < sizeof(oc_event))
+void oc_event_queue_init(oc_event_queue* queue)
+{
+    for(u64 i = 0; i < OC_EVENT_QUEUE_CAP; i++)
     {
-        oc_log_error("event queue full\n");
+        atomic_store_explicit(&queue->slots[i].sequence, i, memory_order_relaxed);
+        queue->slots[i].payload = 0;
+        queue->slots[i].payloadSize = 0;
     }
-    else
+    atomic_store_explicit(&queue->enqueuePos, 0, memory_order_relaxed);
+    queue->dequeuePos = 0;
+    atomic_store_explicit(&queue->droppedEvents, 0, memory_order_relaxed);
+    atomic_store_explicit(&queue->droppedPayloads, 0, memory_order_relaxed);
+
+    atomic_store_explicit(&queue->waiterCount, 0, memory_order_relaxed);
+    queue->waitMutex = oc_mutex_create();
+    queue->waitCondition = oc_condition_create();
+
+    //NOTE: directory watches queue their events once the queue is ready
+    oc_io_set_watch_notify(oc_file_change_notify);
+}
+
+void oc_event_queue_cleanup(oc_event_queue* queue)
+{
+    oc_io_set_watch_notify(0);
+
+    for(u64 i = 0; i < OC_EVENT_QUEUE_CAP; i++)
     {
-        bool error = false;
-        oc_ringbuffer_reserve(queue, sizeof(oc_event), (u8*)event);
+        free(queue->slots[i].payload);
+        queue->slots[i].payload = 0;
+    }
+    oc_condition_destroy(queue->waitCondition);
+    oc_mutex_destroy(queue->waitMutex);
+}
 
-        if(event->type == OC_EVENT_PATHDROP)
+void oc_queue_event(oc_event* event)
+{
+    oc_event_queue* queue = &oc_appData.eventQueue;
+
+    //NOTE: build the payload before claiming a slot, so that a claimed slot is always published right away
+    char* payload = 0;
+    u64 payloadSize = 0;
+    if(event->type == OC_EVENT_PATHDROP)
+    {
+        oc_list_for(event->paths.list, elt, oc_str8_elt, listElt)
         {
+            payloadSize += sizeof(u64) + elt->string.len;
+        }
+        if(payloadSize)
+        {
+            payload = malloc(payloadSize);
+            if(!payload)
+            {
+                atomic_fetch_add_explicit(&queue->droppedPayloads, 1, memory_order_relaxed);
+                oc_log_error("couldn't allocate event payload\n");
+                return;
+            }
+            char* at = payload;
             oc_list_for(event->paths.list, elt, oc_str8_elt, listElt)
             {
-                oc_str8* path = &elt->string;
-                if(oc_ringbuffer_write_available(queue) < (sizeof(u64) + path->len))
-                {
-                    oc_log_error("event queue full\n");
-                    error = true;
-                    break;
-                }
-                else
-                {
-                    oc_ringbuffer_reserve(queue, sizeof(u64), (u8*)&path->len);
-                    oc_ringbuffer_reserve(queue, path->len, (u8*)path->ptr);
-                }
+                memcpy(at, &elt->string.len, sizeof(u64));
+                memcpy(at + sizeof(u64), elt->string.ptr, elt->string.len);
+                at += sizeof(u64) + elt->string.len;
             }
         }
-        if(error)
+    }
+
+    oc_event_slot* slot = 0;
+    u64 pos = atomic_load_explicit(&queue->enqueuePos, memory_order_relaxed);
+    while(1)
+    {
+        slot = &queue->slots[pos & (OC_EVENT_QUEUE_CAP - 1)];
+        u64 sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        i64 diff = (i64)sequence - (i64)pos;
+
+        if(diff == 0)
         {
-            oc_ringbuffer_rewind(queue);
+            //NOTE: the slot is free for this lap, try to claim it
+            if(atomic_compare_exchange_weak_explicit(&queue->enqueuePos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if(diff < 0)
+        {
+            //NOTE: the slot still holds an event from the previous lap, so the queue is full
+            atomic_fetch_add_explicit(&queue->droppedEvents, 1, memory_order_relaxed);
+            oc_log_error("event queue full\n");
+            free(payload);
+            return;
         }
         else
         {
-            oc_ringbuffer_commit(queue);
+            //NOTE: another producer claimed that slot, reload the position
+            pos = atomic_load_explicit(&queue->enqueuePos, memory_order_relaxed);
         }
     }
+
+    slot->event = *event;
+    if(event->type == OC_EVENT_MOUSE_MOVE && event->mouse.time == 0)
+    {
+        //NOTE: stamp moves when they're queued, so that apps can tell apart samples received during the same frame
+        slot->event.mouse.time = oc_clock_time(OC_CLOCK_MONOTONIC);
+    }
+    if(event->type == OC_EVENT_PATHDROP)
+    {
+        slot->event.paths = (oc_str8_list){ .eltCount = event->paths.eltCount };
+    }
+    slot->payload = payload;
+    slot->payloadSize = payloadSize;
+
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+
+    //NOTE: the event is published before we look for waiters, and waiters register before they look at the queue,
+    //      so either we see the waiter or it sees the event.
+    atomic_thread_fence(memory_order_seq_cst);
+    if(atomic_load_explicit(&queue->waiterCount, memory_order_relaxed))
+    {
+        oc_mutex_lock(queue->waitMutex);
+        oc_condition_broadcast(queue->waitCondition);
+        oc_mutex_unlock(queue->waitMutex);
+    }
+}
+
+//NOTE: returns the next published slot without popping it, or 0 if the queue is empty
+static oc_event_slot* oc_event_queue_peek(oc_event_queue* queue)
+{
+    oc_event_slot* slot = &queue->slots[queue->dequeuePos & (OC_EVENT_QUEUE_CAP - 1)];
+    u64 sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    return ((sequence == queue->dequeuePos + 1) ? slot : 0);
+}
+
+static void oc_event_queue_pop(oc_event_queue* queue, oc_event_slot* slot)
+{
+    free(slot->payload);
+    slot->payload = 0;
+    slot->payloadSize = 0;
+
+    atomic_store_explicit(&slot->sequence, queue->dequeuePos + OC_EVENT_QUEUE_CAP, memory_order_release);
+    queue->dequeuePos++;
+}
+
+bool oc_wait_events(f64 timeout)
+{
+    oc_event_queue* queue = &oc_appData.eventQueue;
+
+    bool available = (oc_event_queue_peek(queue) != 0);
+    if(!available && timeout != 0)
+    {
+        f64 deadline = oc_clock_time(OC_CLOCK_MONOTONIC) + timeout;
+
+        oc_mutex_lock(queue->waitMutex);
+        atomic_fetch_add_explicit(&queue->waiterCount, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+
+        while(!(available = (oc_event_queue_peek(queue) != 0)))
+        {
+            if(timeout < 0)
+            {
+                oc_condition_wait(queue->waitCondition, queue->waitMutex);
+            }
+            else
+            {
+                f64 remaining = deadline - oc_clock_time(OC_CLOCK_MONOTONIC);
+                if(remaining <= 0)
+                {
+                    break;
+                }
+                oc_condition_timedwait(queue->waitCondition, queue->waitMutex, remaining);
+            }
+        }
+
+        atomic_fetch_sub_explicit(&queue->waiterCount, 1, memory_order_relaxed);
+        oc_mutex_unlock(queue->waitMutex);
+    }
+    return (available);
+}
+
+void oc_set_event_coalescing(bool enable)
+{
+    oc_appData.coalesceEvents = enable;
+}
+
+oc_event_queue_stats oc_get_event_queue_stats(void)
+{
+    oc_event_queue* queue = &oc_appData.eventQueue;
+    oc_event_queue_stats stats = {
+        .droppedEvents = atomic_load_explicit(&queue->droppedEvents, memory_order_relaxed),
+        .droppedPayloads = atomic_load_explicit(&queue->droppedPayloads, memory_order_relaxed),
+    };
+    return (stats);
+}
+
+static bool oc_event_can_coalesce(oc_event* event, oc_event* next)
+{
+    return ((event->type == OC_EVENT_MOUSE_MOVE || event->type == OC_EVENT_MOUSE_WHEEL)
+            && next->type == event->type
+            && next->window.h == event->window.h
+            && next->mouse.mods == event->mouse.mods);
 }
 
 oc_event* oc_next_event(oc_arena* arena)
 {
     //NOTE: pop and return event from queue
     oc_event* event = 0;
-    oc_ringbuffer* queue = &oc_appData.eventQueue;
+    oc_event_queue* queue = &oc_appData.eventQueue;
 
-    if(oc_ringbuffer_read_available(queue) >= sizeof(oc_event))
+    oc_event_slot* slot = oc_event_queue_peek(queue);
+    if(slot)
     {
         event = oc_arena_push_type(arena, oc_event);
-        u64 read = oc_ringbuffer_read(queue, sizeof(oc_event), (u8*)event);
-        OC_DEBUG_ASSERT(read == sizeof(oc_event));
+        *event = slot->event;
 
         if(event->type == OC_EVENT_PATHDROP)
         {
             u64 pathCount = event->paths.eltCount;
             event->paths = (oc_str8_list){ 0 };
 
-            for(int i = 0; i < pathCount; i++)
+            char* at = slot->payload;
+            char* end = slot->payload + slot->payloadSize;
+            for(u64 i = 0; i < pathCount; i++)
             {
-                if(oc_ringbuffer_read_available(queue) < sizeof(u64))
+                u64 len = 0;
+                if(end - at < sizeof(u64))
                 {
                     oc_log_error("malformed path payload: no string size\n");
                     break;
                 }
+                memcpy(&len, at, sizeof(u64));
+                at += sizeof(u64);
 
-                u64 len = 0;
-                oc_ringbuffer_read(queue, sizeof(u64), (u8*)&len);
-                if(oc_ringbuffer_read_available(queue) < len)
+                if(end - at < len)
                 {
                     oc_log_error("malformed path payload: string shorter than expected\n");
                     break;
                 }
-
                 char* buffer = oc_arena_push_array(arena, char, len);
-                oc_ringbuffer_read(queue, len, (u8*)buffer);
+                memcpy(buffer, at, len);
+                at += len;
 
                 oc_str8_list_push(arena, &event->paths, oc_str8_from_buffer(len, buffer));
             }
         }
+        oc_event_queue_pop(queue, slot);
+
+        if(event->type != OC_EVENT_PATHDROP && oc_appData.coalesceEvents)
+        {
+            //NOTE: merge consecutive mouse move / wheel events that are already queued. We only ever
+            //      peek at published events, so this doesn't wait on events that are still being produced.
+            oc_event_slot* next = 0;
+            while((next = oc_event_queue_peek(queue)) != 0
+                  && oc_event_can_coalesce(event, &next->event))
+            {
+                event->mouse.x = next->event.mouse.x;
+                event->mouse.y = next->event.mouse.y;
+                event->mouse.deltaX += next->event.mouse.deltaX;
+                event->mouse.deltaY += next->event.mouse.deltaY;
+                event->mouse.pressure = next->event.mouse.pressure;
+                event->mouse.time = next->event.mouse.time;
+
+                oc_event_queue_pop(queue, next);
+            }
+        }
     }
     return (event);
 }
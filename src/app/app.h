@@ -12,6 +12,8 @@
 #include "util/typedefs.h"
 #include "util/utf8.h"
 #include "util/macros.h"
+#include "platform/platform_io.h"
+#include "platform/platform_net.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -71,7 +73,9 @@ typedef enum
     OC_EVENT_WINDOW_CLOSE,
     OC_EVENT_PATHDROP,
     OC_EVENT_FRAME,
-    OC_EVENT_QUIT
+    OC_EVENT_QUIT,
+    OC_EVENT_FILE_CHANGE,
+    OC_EVENT_FETCH,
 } oc_event_type;
 
 typedef enum
@@ -267,6 +271,8 @@ typedef struct oc_mouse_event // mouse move/scroll
     f32 deltaX;
     f32 deltaY;
     oc_keymod_flags mods;
+    f32 pressure; // from 0 to 1, devices without pressure report 1 while a button is down
+    f64 time;     // monotonic clock time at which the move was received, 0 for other events
 } oc_mouse_event;
 
 typedef struct oc_move_event // window resize / move
@@ -275,6 +281,11 @@ typedef struct oc_move_event // window resize / move
     oc_rect content;
 } oc_move_event;
 
+typedef struct oc_file_change_event // changes are pending on a watched directory, see oc_file_watch()
+{
+    oc_file dir;
+} oc_file_change_event;
+
 typedef struct oc_event
 {
     //TODO clipboard and path drop
@@ -288,10 +299,43 @@ typedef struct oc_event
         oc_mouse_event mouse;
         oc_move_event move;
         oc_str8_list paths;
+        oc_file_change_event fileChange;
+        oc_fetch_event fetch;
     };
 
 } oc_event;
 
+//NOTE: maximum number of events passed to a single call of oc_on_events()
+#define OC_EVENT_BATCH_MAX_COUNT 64
+
+/*NOTE: frame info.
+	Before each call to oc_on_frame_refresh(), the runtime writes a summary of the frame's state to the guest's
+	oc_frameInfo global, so that apps can read the frame time, window size and input state without calling into
+	the host. All fields are 0 until the first frame is written, which has a frameIndex of 1.
+
+	The layout only uses fixed size fields, so that it is the same in wasm memory and on the host.
+*/
+typedef struct oc_frame_info
+{
+    u64 frameIndex;      // index of the frame, starting at 1
+    f64 time;            // monotonic clock time at the start of the frame, in seconds
+    f64 deltaTime;       // time elapsed since the start of the previous frame, in seconds
+    oc_vec2 contentSize; // size of the window's content area, in points
+    f32 contentScaling;  // pixels per point of the window's content area
+    u32 focused;         // 1 if the window has keyboard focus
+    oc_vec2 mousePos;    // last mouse position, in points from the top-left corner of the content area
+    u32 mouseButtons;    // bit (1 << button) is set while that oc_mouse_button is down
+    u32 keyMods;         // oc_keymod_flags of the modifier keys held down
+    f64 presentTime;     // predicted time at which the frame will be displayed, on the same clock as time. 0 if unknown
+    f64 refreshPeriod;   // time between two refreshes of the window's display, in seconds. 0 if unknown
+
+} oc_frame_info;
+
+#if defined(OC_PLATFORM_ORCA) && OC_PLATFORM_ORCA
+// Returns the frame info the runtime wrote before the current call to oc_on_frame_refresh().
+ORCA_API const oc_frame_info* oc_frame_info_get(void);
+#endif
+
 //NOTE: these APIs are not directly available to Orca apps
 #if !defined(OC_PLATFORM_ORCA) || !(OC_PLATFORM_ORCA)
 //--------------------------------------------------------------------
@@ -315,9 +359,34 @@ ORCA_API void oc_set_cursor(oc_mouse_cursor cursor);
 	or the timeout elapses.
 
 	oc_next_event() get the next event from the event queue, allocating from the passed arena
+
+	oc_wait_events() blocks the calling thread until the event queue has events or the timeout elapses, without
+	pumping system events. This lets a thread other than the one pumping events sleep while the app is idle.
+	A timeout of -1 waits indefinitely. Returns true if events are available.
+
+	oc_set_event_coalescing() enables or disables coalescing of consecutive mouse move and mouse wheel
+	events of the same window. When enabled, oc_next_event() merges them into a single event carrying the
+	last position and the accumulated deltas. Coalescing is disabled by default, so that apps that need
+	the full history of these events (e.g. drawing apps) still get every event.
+
+	oc_get_event_queue_stats() returns the number of events dropped since init, either because the queue was full
+	or because their payload couldn't be allocated.
+
+	oc_queue_event() adds an event to the queue. It can be called from any thread, so that host services running
+	on their own threads can deliver their results through the event loop.
 */
+typedef struct oc_event_queue_stats
+{
+    u64 droppedEvents;
+    u64 droppedPayloads;
+} oc_event_queue_stats;
+
 ORCA_API void oc_pump_events(f64 timeout);
 ORCA_API oc_event* oc_next_event(oc_arena* arena);
+ORCA_API bool oc_wait_events(f64 timeout);
+ORCA_API void oc_set_event_coalescing(bool enable);
+ORCA_API oc_event_queue_stats oc_get_event_queue_stats(void);
+ORCA_API void oc_queue_event(oc_event* event);
 
 ORCA_API oc_key_code oc_scancode_to_keycode(oc_scan_code scanCode);
 
@@ -375,8 +444,22 @@ ORCA_API oc_rect oc_window_frame_rect_for_content_rect(oc_rect contentRect, oc_w
 //------------------------------------------------------------------------------------------
 //TODO: surface-api-rework: remove this?
 
+/*NOTE: oc_vsync_wait() blocks until the next vblank of the display a window is on.
+
+	oc_vsync_get_timing() returns the refresh timing of that display, on the OC_CLOCK_MONOTONIC clock: vblankTime is
+	the time of a recent or upcoming vblank, and refreshPeriod the time between two vblanks. Other vblanks are at
+	vblankTime + k * refreshPeriod. Both are 0 until the timing is known, e.g. before the first display link callback
+	on macOS.
+*/
+typedef struct oc_vsync_timing
+{
+    f64 vblankTime;
+    f64 refreshPeriod;
+} oc_vsync_timing;
+
 ORCA_API void oc_vsync_init(void);
 ORCA_API void oc_vsync_wait(oc_window window);
+ORCA_API oc_vsync_timing oc_vsync_get_timing(oc_window window);
 
 //---------------------------------------------------------------
 // Dispatching stuff to the main thread
@@ -405,8 +488,6 @@ ORCA_API oc_str8 oc_clipboard_get_data_for_tag(oc_arena* arena, const char* tag)
 // native open/save/alert windows
 //--------------------------------------------------------------------
 
-#include "platform/platform_io.h"
-
 typedef enum
 {
     OC_FILE_DIALOG_SAVE,
@@ -475,7 +556,16 @@ void oc_window_set_title(oc_str8 title);
 void oc_window_set_size(oc_vec2 size);
 
 void ORCA_IMPORT(oc_request_quit)(void);
+
+/*NOTE:
+	By default the runtime calls oc_on_frame_refresh() continuously, at the display rate. oc_set_idle_mode(true)
+	makes it wait instead until events arrive, or until the app calls oc_request_frame() to get another frame,
+	e.g. while it is animating. UI animations request their next frame automatically.
+*/
+void ORCA_IMPORT(oc_request_frame)(void);
+void ORCA_IMPORT(oc_set_idle_mode)(bool enable);
 oc_key_code ORCA_IMPORT(oc_scancode_to_keycode)(oc_scan_code scanCode);
+void ORCA_IMPORT(oc_set_event_coalescing)(bool enable);
 
 void oc_clipboard_set_string(oc_str8 string);
 
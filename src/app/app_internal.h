@@ -11,7 +11,8 @@
 
 #include "platform/platform.h"
 #include "platform/platform_io_internal.h"
-#include "util/ringbuffer.h"
+#include "platform/platform_thread.h"
+#include <stdatomic.h>
 
 #if OC_PLATFORM_WINDOWS
     #include "win32_app.h"
@@ -47,6 +48,53 @@ typedef struct oc_window_data
     OC_PLATFORM_WINDOW_DATA
 } oc_window_data;
 
+//---------------------------------------------------------------
+// Event queue
+//---------------------------------------------------------------
+
+/*NOTE:
+	Events are queued in a fixed array of slots, which OS callbacks can push to from any thread without locking.
+	Only the main thread pops events. Each slot has a sequence number: producers claim a slot by advancing
+	enqueuePos, and publish it by setting its sequence to pos + 1. The consumer frees it by setting its sequence
+	to pos + capacity, which is the value producers wait for on the next lap.
+
+	Payloads (the paths of a path drop) are stored out of line in a single heap block owned by the slot,
+	as a sequence of u64 lengths each followed by the string's bytes.
+
+	The consumer can block in oc_wait_events(). It registers itself in waiterCount before checking the queue,
+	and producers only take waitMutex to wake it up when waiterCount is non-zero, so that queueing an event
+	stays lock-free when nobody is waiting.
+*/
+typedef struct oc_event_slot
+{
+    _Atomic(u64) sequence;
+    oc_event event;
+    u64 payloadSize;
+    char* payload;
+} oc_event_slot;
+
+enum
+{
+    OC_EVENT_QUEUE_CAP = 1024,
+};
+
+typedef struct oc_event_queue
+{
+    oc_event_slot slots[OC_EVENT_QUEUE_CAP];
+    _Atomic(u64) enqueuePos;
+    u64 dequeuePos;
+
+    _Atomic(u64) droppedEvents;
+    _Atomic(u64) droppedPayloads;
+
+    _Atomic(u32) waiterCount;
+    oc_mutex* waitMutex;
+    oc_condition* waitCondition;
+} oc_event_queue;
+
+void oc_event_queue_init(oc_event_queue* queue);
+void oc_event_queue_cleanup(oc_event_queue* queue);
+
 //---------------------------------------------------------------
 // Global App State
 //---------------------------------------------------------------
@@ -65,7 +113,8 @@ typedef struct oc_app
     oc_str8 pendingPathDrop;
     oc_arena eventArena;
 
-    oc_ringbuffer eventQueue;
+    oc_event_queue eventQueue;
+    bool coalesceEvents;
 
     oc_frame_stats frameStats;
 
@@ -10,6 +10,17 @@
 //This is used to pass raw events from the runtime
 ORCA_EXPORT oc_event oc_rawEvent;
 
+//This is used to pass batches of events to oc_on_events()
+ORCA_EXPORT oc_event oc_eventBatch[OC_EVENT_BATCH_MAX_COUNT];
+
+//This is written by the runtime before each call to oc_on_frame_refresh()
+ORCA_EXPORT oc_frame_info oc_frameInfo;
+
+const oc_frame_info* oc_frame_info_get(void)
+{
+    return (&oc_frameInfo);
+}
+
 ORCA_EXPORT void* oc_arena_push_stub(oc_arena* arena, u64 size)
 {
     return (oc_arena_push(arena, size));
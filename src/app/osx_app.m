@@ -9,12 +9,13 @@
 #import <QuartzCore/QuartzCore.h>                         //CATransaction
 #import <UniformTypeIdentifiers/UniformTypeIdentifiers.h> // for file dialog
 
+#include <math.h>
+#include <stdatomic.h>
 #include <stdlib.h> // malloc/free
 
 #include "util/lists.h"
 #include "util/macros.h"
 #include "util/memory.h"
-#include "util/ringbuffer.h"
 #include "platform/platform_clock.h"
 #include "platform/platform_debug.h"
 #include "platform/platform_path.h"
@@ -322,6 +323,8 @@ oc_key_code oc_label_to_key(oc_str8 label)
     oc_window_data* mpWindow;
   @public
     CVDisplayLinkRef displayLink;
+    _Atomic(f64) vblankTime; // written by the display link thread, see oc_vsync_get_timing()
+    _Atomic(f64) refreshPeriod;
 }
 
 - (id)initWithWindowData:(oc_window_data*)window contentRect:(NSRect)rect styleMask:(uint32)style;
@@ -716,7 +719,12 @@ void oc_install_keyboard_layout_listener()
 - (BOOL)windowShouldClose:(id)sender
 {
     OCWindow* ocWindow = (OCWindow*)mpWindow->osx.nsWindow;
-    CVDisplayLinkStop(ocWindow->displayLink);
+    if(ocWindow->displayLink)
+    {
+        CVDisplayLinkStop(ocWindow->displayLink);
+        CVDisplayLinkRelease(ocWindow->displayLink);
+        ocWindow->displayLink = 0;
+    }
 
     mpWindow->shouldClose = true;
 
@@ -875,6 +883,7 @@ static void oc_process_mouse_button(NSEvent* nsEvent, oc_window_data* window, oc
     event.mouse.deltaX = [nsEvent deltaX];
     event.mouse.deltaY = [nsEvent deltaY];
     event.mouse.mods = oc_convert_osx_mods([nsEvent modifierFlags]);
+    event.mouse.pressure = [nsEvent pressure];
 
     oc_queue_event(&event);
 }
@@ -1171,7 +1180,7 @@ void oc_init()
 
             oc_init_window_handles();
 
-            oc_ringbuffer_init(&oc_appData.eventQueue, 16);
+            oc_event_queue_init(&oc_appData.eventQueue);
 
             [OCApplication sharedApplication];
             OCAppDelegate* delegate = [[OCAppDelegate alloc] init];
@@ -2122,12 +2131,19 @@ static CVReturn oc_display_link_callback(
     CVOptionFlags* flagsOut,
     void* displayLinkContext)
 {
-    oc_event event = { 0 };
-    event.type = OC_EVENT_FRAME;
-    oc_queue_event(&event);
-
     OCWindow* ocWindow = (OCWindow*)displayLinkContext;
 
+    //NOTE: inOutputTime is the upcoming vblank. Host times are mach absolute times, which we convert relative to the
+    //      current time so that they're on the OC_CLOCK_MONOTONIC clock.
+    f64 now = oc_clock_time(OC_CLOCK_MONOTONIC);
+    f64 hostFrequency = CVGetHostClockFrequency();
+    f64 vblankTime = now + (f64)((i64)inOutputTime->hostTime - (i64)inNow->hostTime) / hostFrequency;
+    f64 refreshPeriod = inOutputTime->videoTimeScale
+                          ? (f64)inOutputTime->videoRefreshPeriod / inOutputTime->videoTimeScale
+                          : 0;
+    atomic_store_explicit(&ocWindow->vblankTime, vblankTime, memory_order_relaxed);
+    atomic_store_explicit(&ocWindow->refreshPeriod, refreshPeriod, memory_order_relaxed);
+
     CGDirectDisplayID displays[4];
     uint32_t matchingDisplayCount;
     CGError err = CGGetDisplaysWithRect(ocWindow.frame, 4, displays, &matchingDisplayCount);
@@ -2173,17 +2189,9 @@ void oc_vsync_init(void)
 {
 }
 
-void oc_vsync_wait(oc_window window)
+//NOTE: the display link of a window is started the first time its timing is needed
+static void oc_osx_display_link_start(OCWindow* ocWindow)
 {
-    // TODO figure out why this causes stuttering with triple buffering
-    oc_window_data* windowData = oc_window_ptr_from_handle(window);
-    if(!windowData)
-    {
-        return;
-    }
-
-    OCWindow* ocWindow = (OCWindow*)windowData->osx.nsWindow;
-
     CVReturn ret;
 
     if((ret = CVDisplayLinkCreateWithActiveCGDisplays(&ocWindow->displayLink)) != kCVReturnSuccess)
@@ -2208,3 +2216,33 @@ void oc_vsync_wait(oc_window window)
         oc_log_error("CVDisplayLinkStart ret: %d\n", ret);
     }
 }
+
+oc_vsync_timing oc_vsync_get_timing(oc_window window)
+{
+    oc_vsync_timing timing = { 0 };
+    oc_window_data* windowData = oc_window_ptr_from_handle(window);
+    if(windowData && windowData->osx.nsWindow)
+    {
+        OCWindow* ocWindow = (OCWindow*)windowData->osx.nsWindow;
+        if(!ocWindow->displayLink)
+        {
+            oc_osx_display_link_start(ocWindow);
+        }
+        timing.vblankTime = atomic_load_explicit(&ocWindow->vblankTime, memory_order_relaxed);
+        timing.refreshPeriod = atomic_load_explicit(&ocWindow->refreshPeriod, memory_order_relaxed);
+    }
+    return (timing);
+}
+
+void oc_vsync_wait(oc_window window)
+{
+    //NOTE: sleeps until the next vblank predicted from the display link's timing, rather than blocking on the
+    //      display link thread, which would add its own wake up latency
+    oc_vsync_timing timing = oc_vsync_get_timing(window);
+    if(timing.refreshPeriod > 0)
+    {
+        f64 now = oc_clock_time(OC_CLOCK_MONOTONIC);
+        f64 next = timing.vblankTime + ceil((now - timing.vblankTime) / timing.refreshPeriod) * timing.refreshPeriod;
+        oc_sleep_until(next);
+    }
+}
@@ -221,6 +221,19 @@ void oc_init()
 
         oc_appData.win32.mainThreadID = GetCurrentThreadId();
 
+        //NOTE: raw mouse input is delivered to the focused window along with the legacy mouse messages
+        RAWINPUTDEVICE rawMouse = {
+            .usUsagePage = 0x01, // generic desktop controls
+            .usUsage = 0x02,     // mouse
+            .dwFlags = 0,
+            .hwndTarget = 0,
+        };
+        oc_appData.win32.rawMouse = RegisterRawInputDevices(&rawMouse, 1, sizeof(RAWINPUTDEVICE));
+        if(!oc_appData.win32.rawMouse)
+        {
+            oc_log_warning("couldn't register raw mouse input, pointer history will only hold cursor positions\n");
+        }
+
         oc_vsync_init();
 
         //NOTE: create DirectCompositionDevice
@@ -363,6 +376,37 @@ static void oc_win32_process_wheel_event(oc_window_data* window, f32 x, f32 y)
     oc_queue_event(&event);
 }
 
+//NOTE: the modal size loop only returns to the runloop thread's frames between two size steps, so the window border
+//      moves ahead of its contents and exposes stale or stretched pixels. When the client area changes size during a
+//      live resize, the modal loop queues the resize event and blocks until a surface presents a frame at the new
+//      size, which keeps the border and the contents in step. The wait is bounded so that an app that doesn't render
+//      (or is waiting on the main thread) doesn't freeze the resize.
+enum
+{
+    OC_WIN32_LIVE_RESIZE_FRAME_TIMEOUT_MS = 50,
+};
+
+static void oc_win32_wait_live_resize_frame(oc_window_data* window, oc_event* event, u32 width, u32 height)
+{
+    window->win32.liveResizeWidth = width;
+    window->win32.liveResizeHeight = height;
+    ResetEvent(window->win32.liveResizeFramePresented);
+
+    oc_queue_event(event);
+
+    WaitForSingleObject(window->win32.liveResizeFramePresented, OC_WIN32_LIVE_RESIZE_FRAME_TIMEOUT_MS);
+}
+
+void oc_win32_window_frame_presented(oc_window_data* window, u32 width, u32 height)
+{
+    if(window->win32.liveResize
+       && width == window->win32.liveResizeWidth
+       && height == window->win32.liveResizeHeight)
+    {
+        SetEvent(window->win32.liveResizeFramePresented);
+    }
+}
+
 static void oc_win32_update_child_surfaces(oc_window_data* window)
 {
     RECT clientRect;
@@ -375,18 +419,119 @@ static void oc_win32_update_child_surfaces(oc_window_data* window)
 
     //NOTE(martin): even though surface's window is cloaked, we still move it to the
     // parent window position, so it gets placed on the same monitor and gets consistent DPI
+    //NOTE: image surfaces are only a visual, and have no window to move
     oc_list_for(window->win32.surfaces, surface, oc_surface_base, view.listElt)
     {
-        SetWindowPos(surface->view.hWnd,
-                     0,
-                     point.x,
-                     point.y,
-                     clientWidth,
-                     clientHeight,
-                     SWP_NOACTIVATE | SWP_NOOWNERZORDER | SWP_NOZORDER);
+        if(surface->view.hWnd)
+        {
+            SetWindowPos(surface->view.hWnd,
+                         0,
+                         point.x,
+                         point.y,
+                         clientWidth,
+                         clientHeight,
+                         SWP_NOACTIVATE | SWP_NOOWNERZORDER | SWP_NOZORDER);
+        }
     }
 }
 
+//--------------------------------------------------------------------
+// raw mouse input
+//--------------------------------------------------------------------
+
+static void oc_win32_push_raw_mouse_sample(RAWINPUT* raw)
+{
+    if(raw->header.dwType != RIM_TYPEMOUSE
+       || (raw->data.mouse.usFlags & MOUSE_MOVE_ABSOLUTE)
+       || (raw->data.mouse.lLastX == 0 && raw->data.mouse.lLastY == 0))
+    {
+        return;
+    }
+    oc_vec2 last = { 0 };
+    if(oc_appData.win32.rawMouseSampleCount)
+    {
+        last = oc_appData.win32.rawMouseSamples[oc_appData.win32.rawMouseSampleCount - 1];
+    }
+    oc_vec2 sample = { last.x + raw->data.mouse.lLastX, last.y + raw->data.mouse.lLastY };
+
+    //NOTE: when the buffer is full, the last sample keeps accumulating so that the path still ends at the right place
+    if(oc_appData.win32.rawMouseSampleCount < OC_WIN32_RAW_MOUSE_MAX_SAMPLES)
+    {
+        oc_appData.win32.rawMouseSampleCount++;
+    }
+    oc_appData.win32.rawMouseSamples[oc_appData.win32.rawMouseSampleCount - 1] = sample;
+}
+
+//NOTE: a 4-8kHz mouse posts one WM_INPUT per packet. The first one is read with GetRawInputData(), then
+//      GetRawInputBuffer() reads every other packet queued for the thread and removes their messages, so that the
+//      message pump handles them in bulk instead of one message at a time.
+static void oc_win32_drain_raw_input(HRAWINPUT handle)
+{
+    RAWINPUT first;
+    UINT size = sizeof(RAWINPUT);
+    if(GetRawInputData(handle, RID_INPUT, &first, &size, sizeof(RAWINPUTHEADER)) != (UINT)-1)
+    {
+        oc_win32_push_raw_mouse_sample(&first);
+    }
+
+    _Alignas(8) u8 buffer[64 * sizeof(RAWINPUT)];
+    while(true)
+    {
+        size = sizeof(buffer);
+        UINT count = GetRawInputBuffer((RAWINPUT*)buffer, &size, sizeof(RAWINPUTHEADER));
+        if(count == 0 || count == (UINT)-1)
+        {
+            break;
+        }
+        RAWINPUT* raw = (RAWINPUT*)buffer;
+        for(UINT i = 0; i < count; i++)
+        {
+            oc_win32_push_raw_mouse_sample(raw);
+            raw = NEXTRAWINPUTBLOCK(raw);
+        }
+    }
+}
+
+//NOTE: WM_MOUSEMOVE is only generated when the thread reads an empty queue, so fast mice get one move per pump.
+//      Before queueing that move, we queue the intermediate positions given by the raw packets received since the
+//      previous move. Raw deltas are in device units and don't include pointer acceleration, so they're rescaled to
+//      go from the previous cursor position to the new one. Samples don't have timestamps, so they're spread evenly
+//      over the time between the two moves. This returns the position of the last queued sample.
+static oc_vec2 oc_win32_queue_raw_mouse_samples(oc_event* move, f64 now)
+{
+    oc_vec2 from = oc_appData.win32.lastMousePos;
+    u32 count = oc_appData.win32.rawMouseSampleCount;
+    oc_appData.win32.rawMouseSampleCount = 0;
+
+    //NOTE: with coalescing on, the intermediate moves would be merged back into the last one
+    if(count < 2 || oc_appData.coalesceEvents)
+    {
+        return (from);
+    }
+
+    oc_vec2 total = oc_appData.win32.rawMouseSamples[count - 1];
+    oc_vec2 to = { move->mouse.x, move->mouse.y };
+    f64 fromTime = oc_max(oc_appData.win32.lastMouseMoveTime, now - 0.1);
+
+    oc_vec2 pos = from;
+    for(u32 i = 0; i < count - 1; i++)
+    {
+        oc_vec2 sample = oc_appData.win32.rawMouseSamples[i];
+        f32 t = (f32)(i + 1) / count;
+
+        oc_event event = *move;
+        event.mouse.x = from.x + (to.x - from.x) * (total.x ? sample.x / total.x : t);
+        event.mouse.y = from.y + (to.y - from.y) * (total.y ? sample.y / total.y : t);
+        event.mouse.deltaX = event.mouse.x - pos.x;
+        event.mouse.deltaY = event.mouse.y - pos.y;
+        event.mouse.time = fromTime + (now - fromTime) * t;
+        oc_queue_event(&event);
+
+        pos = (oc_vec2){ event.mouse.x, event.mouse.y };
+    }
+    return (pos);
+}
+
 LRESULT oc_win32_win_proc(HWND windowHandle, UINT message, WPARAM wParam, LPARAM lParam)
 {
     LRESULT result = 0;
@@ -434,7 +579,18 @@ LRESULT oc_win32_win_proc(HWND windowHandle, UINT message, WPARAM wParam, LPARAM
         }
         break;
 
-        //TODO: enter/exit size & move
+        case WM_ENTERSIZEMOVE:
+        {
+            mpWindow->win32.liveResize = true;
+        }
+        break;
+
+        case WM_EXITSIZEMOVE:
+        {
+            mpWindow->win32.liveResize = false;
+        }
+        break;
+
         case WM_WINDOWPOSCHANGED:
         {
             oc_win32_update_child_surfaces(mpWindow);
@@ -505,7 +661,15 @@ LRESULT oc_win32_win_proc(HWND windowHandle, UINT message, WPARAM wParam, LPARAM
                 event.type = OC_EVENT_WINDOW_RESIZE;
                 event.move.frame = oc_window_get_frame_rect(event.window);
                 event.move.content = oc_window_get_content_rect(event.window);
-                oc_queue_event(&event);
+
+                if(mpWindow->win32.liveResize)
+                {
+                    oc_win32_wait_live_resize_frame(mpWindow, &event, LOWORD(lParam), HIWORD(lParam));
+                }
+                else
+                {
+                    oc_queue_event(&event);
+                }
             }
         }
         break;
@@ -559,6 +723,7 @@ LRESULT oc_win32_win_proc(HWND windowHandle, UINT message, WPARAM wParam, LPARAM
             event.type = OC_EVENT_MOUSE_MOVE;
             event.mouse.x = LOWORD(lParam) / scaling;
             event.mouse.y = HIWORD(lParam) / scaling;
+            event.mouse.pressure = (wParam & (MK_LBUTTON | MK_RBUTTON | MK_MBUTTON | MK_XBUTTON1 | MK_XBUTTON2)) ? 1 : 0;
 
             if(oc_appData.win32.mouseTracked || oc_appData.win32.mouseCaptureMask)
             {
@@ -573,7 +738,17 @@ LRESULT oc_win32_win_proc(HWND windowHandle, UINT message, WPARAM wParam, LPARAM
                     oc_appData.win32.clickCount[i] = 0;
                 }
             }
+            f64 now = oc_clock_time(OC_CLOCK_MONOTONIC);
+            if(oc_appData.win32.mouseTracked || oc_appData.win32.mouseCaptureMask)
+            {
+                oc_vec2 pos = oc_win32_queue_raw_mouse_samples(&event, now);
+                event.mouse.deltaX = event.mouse.x - pos.x;
+                event.mouse.deltaY = event.mouse.y - pos.y;
+            }
+            oc_appData.win32.rawMouseSampleCount = 0;
             oc_appData.win32.lastMousePos = (oc_vec2){ event.mouse.x, event.mouse.y };
+            oc_appData.win32.lastMouseMoveTime = now;
+            event.mouse.time = now;
 
             if(!oc_appData.win32.mouseTracked)
             {
@@ -597,9 +772,18 @@ LRESULT oc_win32_win_proc(HWND windowHandle, UINT message, WPARAM wParam, LPARAM
         }
         break;
 
+        case WM_INPUT:
+        {
+            oc_win32_drain_raw_input((HRAWINPUT)lParam);
+            //NOTE: DefWindowProc() releases the raw input data of the message
+            handled = false;
+        }
+        break;
+
         case WM_MOUSELEAVE:
         {
             oc_appData.win32.mouseTracked = false;
+            oc_appData.win32.rawMouseSampleCount = 0;
 
             oc_event event = { 0 };
             event.window = oc_window_handle_from_ptr(mpWindow);
@@ -834,6 +1018,7 @@ oc_window oc_window_create(oc_rect rect, oc_str8 title, oc_window_style style)
         goto quit;
     }
     window->win32.hWnd = windowHandle;
+    window->win32.liveResizeFramePresented = CreateEvent(NULL, FALSE, FALSE, NULL);
 
     UpdateWindow(windowHandle);
     SetPropW(windowHandle, L"MilePost", window);
@@ -878,6 +1063,7 @@ void oc_window_destroy(oc_window window)
     if(windowData)
     {
         DestroyWindow(windowData->win32.hWnd);
+        CloseHandle(windowData->win32.liveResizeFramePresented);
         //TODO: check when to unregister class
 
         oc_window_recycle_ptr(windowData);
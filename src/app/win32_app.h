@@ -25,12 +25,27 @@ typedef struct oc_win32_window_data
     IDCompositionTarget* dcompTarget;
     IDCompositionVisual* dcompRootVisual;
     oc_list surfaces;
+
+    //NOTE: set between WM_ENTERSIZEMOVE and WM_EXITSIZEMOVE. During a live resize, the modal size loop waits for a
+    //      frame of the new client size to be presented, see oc_win32_wait_live_resize_frame()
+    bool liveResize;
+    u32 liveResizeWidth;
+    u32 liveResizeHeight;
+    HANDLE liveResizeFramePresented;
 } oc_win32_window_data;
 
 typedef struct oc_window_data oc_window_data;
 
+//NOTE: called by surfaces after they present a frame of the given size, in pixels
+void oc_win32_window_frame_presented(oc_window_data* window, u32 width, u32 height);
+
 #define OC_PLATFORM_WINDOW_DATA oc_win32_window_data win32;
 
+enum
+{
+    OC_WIN32_RAW_MOUSE_MAX_SAMPLES = 64,
+};
+
 typedef struct oc_win32_app_data
 {
     u32 savedConsoleCodePage;
@@ -38,6 +53,13 @@ typedef struct oc_win32_app_data
     int mouseCaptureMask;
     bool mouseTracked;
     oc_vec2 lastMousePos;
+    f64 lastMouseMoveTime;
+
+    //NOTE: raw mouse packets received since the last WM_MOUSEMOVE, as cumulative device deltas. They give the shape
+    //      of the path between two cursor positions, see oc_win32_queue_raw_mouse_samples().
+    bool rawMouse;
+    u32 rawMouseSampleCount;
+    oc_vec2 rawMouseSamples[OC_WIN32_RAW_MOUSE_MAX_SAMPLES];
     u32 lastClickTime[OC_MOUSE_BUTTON_COUNT];
     u32 clickCount[OC_MOUSE_BUTTON_COUNT];
     u32 wheelScrollLines;
@@ -139,6 +139,13 @@ enum bb_debug_trap_mode
 };
 typedef enum bb_debug_trap_mode bb_debug_trap_mode;
 
+enum bb_vm_type
+{
+	BB_VM_TYPE_STACK,
+	BB_VM_TYPE_REGISTER,
+};
+typedef enum bb_vm_type bb_vm_type;
+
 const char* bb_error_str(bb_error err);
 
 bb_module_definition* bb_module_definition_create(bb_module_definition_init_opts opts);
@@ -154,6 +161,7 @@ bb_error bb_import_package_add_memory(bb_import_package* package, const bb_wasm_
 void bb_set_debug_trace_mode(bb_debug_trace_mode mode);
 
 bb_module_instance* bb_module_instance_create(bb_module_definition* definition);
+bb_module_instance* bb_module_instance_create_vm(bb_module_definition* definition, bb_vm_type vm_type);
 void bb_module_instance_destroy(bb_module_instance* instance);
 bb_error bb_module_instance_instantiate(bb_module_instance* instance, bb_module_instance_instantiate_opts opts);
 bb_error bb_module_instance_find_func(bb_module_instance* instance, const char* func_name, bb_func_handle* out_handle);
@@ -58,6 +58,11 @@ const CModuleInstanceInstantiateOpts = extern struct {
     enable_debug: bool,
 };
 
+const CVmType = enum(c_int) {
+    Stack,
+    Register,
+};
+
 const CModuleInstanceInvokeOpts = extern struct {
     trap_on_start: bool,
 };
@@ -335,12 +340,20 @@ export fn bb_set_debug_trace_mode(c_mode: CDebugTraceMode) void {
 }
 
 export fn bb_module_instance_create(module_definition: ?*ModuleDefinition) ?*ModuleInstance {
+    return bb_module_instance_create_vm(module_definition, CVmType.Stack);
+}
+
+export fn bb_module_instance_create_vm(module_definition: ?*ModuleDefinition, c_vm_type: CVmType) ?*ModuleInstance {
     var allocator = cffi_gpa.allocator();
 
     var module: ?*core.ModuleInstance = null;
 
     if (module_definition) |def| {
-        module = core.createModuleInstance(.Stack, def, allocator) catch null;
+        const vm_type: core.VmType = switch (c_vm_type) {
+            .Stack => .Stack,
+            .Register => .Register,
+        };
+        module = core.createModuleInstance(vm_type, def, allocator) catch null;
     }
 
     return module;
@@ -29,6 +29,11 @@
         #define OC_GRAPHICS_ENABLE_CANVAS 1
     #endif
 
+    //NOTE: the CPU canvas renderer is enabled by default on macOS, as a fallback for machines without a usable GPU
+    #ifndef OC_GRAPHICS_ENABLE_CPU_CANVAS
+        #define OC_GRAPHICS_ENABLE_CPU_CANVAS 1
+    #endif
+
     //NOTE: surface backends available but disabled by default on macOS are: Metal
     #ifndef OC_GRAPHICS_ENABLE_METAL
         #define OC_GRAPHICS_ENABLE_METAL 0
@@ -56,6 +61,11 @@
         #define OC_GRAPHICS_ENABLE_CANVAS 1
     #endif
 
+    //NOTE: the CPU canvas renderer is enabled by default on Windows, as a fallback for machines without a usable GPU
+    #ifndef OC_GRAPHICS_ENABLE_CPU_CANVAS
+        #define OC_GRAPHICS_ENABLE_CPU_CANVAS 1
+    #endif
+
     //NOTE: surface backends available but disabled by default on Windows are: OpenGL
     #ifndef OC_GRAPHICS_ENABLE_GL
         #define OC_GRAPHICS_ENABLE_GL 0
@@ -94,6 +104,8 @@ typedef enum
     OC_SURFACE_GL,
     OC_SURFACE_GLES,
     OC_SURFACE_WEBGPU,
+    OC_SURFACE_CPU,
+    OC_SURFACE_IMAGE,
     OC_SURFACE_CANVAS = 1 << 31,
 
 } oc_surface_api;
@@ -7,6 +7,8 @@
 **************************************************************************/
 #include "canvas_renderer.h"
 
+static void oc_image_decoder_poll(void);
+
 //---------------------------------------------------------------
 // typed handles
 //---------------------------------------------------------------
@@ -39,11 +41,55 @@ oc_image_base* oc_image_from_handle(oc_image handle)
 // renderer
 //---------------------------------------------------------------
 
+oc_canvas_renderer oc_canvas_renderer_create(void)
+{
+    oc_canvas_renderer_options options = { 0 };
+    return (oc_canvas_renderer_create_with_options(&options));
+}
+
+oc_canvas_renderer oc_canvas_renderer_create_with_options(oc_canvas_renderer_options* options)
+{
+    oc_canvas_renderer_base* renderer = 0;
+
+#if OC_GRAPHICS_ENABLE_CANVAS
+    if(options->backend != OC_CANVAS_BACKEND_CPU)
+    {
+        renderer = oc_wgpu_canvas_renderer_create(options);
+        if(!renderer && options->backend == OC_CANVAS_BACKEND_DEFAULT)
+        {
+            oc_log_warning("WebGPU canvas renderer unavailable, falling back to the CPU renderer.\n");
+        }
+    }
+#endif
+
+#if OC_GRAPHICS_ENABLE_CPU_CANVAS
+    if(!renderer && options->backend != OC_CANVAS_BACKEND_WEBGPU)
+    {
+        renderer = oc_cpu_canvas_renderer_create(options);
+    }
+#endif
+
+    oc_canvas_renderer handle = oc_canvas_renderer_nil();
+    if(renderer)
+    {
+        handle = oc_canvas_renderer_handle_alloc(renderer);
+    }
+    else
+    {
+        oc_log_error("couldn't create a canvas renderer.\n");
+    }
+    return (handle);
+}
+
+static void oc_image_cache_cleanup(oc_canvas_renderer_base* renderer);
+
 void oc_canvas_renderer_destroy(oc_canvas_renderer handle)
 {
     oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(handle);
     if(renderer)
     {
+        oc_image_cache_cleanup(renderer);
+
         if(renderer->destroy)
         {
             renderer->destroy(renderer);
@@ -57,24 +103,118 @@ void oc_canvas_renderer_submit(oc_canvas_renderer rendererHandle,
                                u32 msaaSampleCount,
                                bool clear,
                                oc_color clearColor,
+                               oc_rect damage,
                                u32 primitiveCount,
                                oc_primitive* primitives,
+                               u32 attributeCount,
+                               oc_attributes* attributes,
                                u32 eltCount,
                                oc_path_elt* elements)
 {
     oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(rendererHandle);
 
+    oc_image_decoder_poll();
+
     if(renderer && renderer->submit)
     {
+        OC_TRACE_BEGIN("canvas submit");
         renderer->submit(renderer,
                          surfaceHandle,
                          msaaSampleCount,
                          clear,
                          clearColor,
+                         damage,
                          primitiveCount,
                          primitives,
+                         attributeCount,
+                         attributes,
                          eltCount,
                          elements);
+        OC_TRACE_END();
+    }
+}
+
+void oc_canvas_renderer_submit_image(oc_canvas_renderer rendererHandle,
+                                     oc_image imageHandle,
+                                     u32 msaaSampleCount,
+                                     bool clear,
+                                     oc_color clearColor,
+                                     u32 primitiveCount,
+                                     oc_primitive* primitives,
+                                     u32 attributeCount,
+                                     oc_attributes* attributes,
+                                     u32 eltCount,
+                                     oc_path_elt* elements)
+{
+    oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(rendererHandle);
+    oc_image_base* image = oc_image_from_handle(imageHandle);
+
+    oc_image_decoder_poll();
+
+    if(renderer && image && renderer->submitImage)
+    {
+        if(image->renderer.h != rendererHandle.h)
+        {
+            oc_log_error("can't render to an image created by another renderer.\n");
+            return;
+        }
+        OC_TRACE_BEGIN("canvas submit image");
+        renderer->submitImage(renderer,
+                              image,
+                              msaaSampleCount,
+                              clear,
+                              clearColor,
+                              primitiveCount,
+                              primitives,
+                              attributeCount,
+                              attributes,
+                              eltCount,
+                              elements);
+        OC_TRACE_END();
+    }
+}
+
+void oc_canvas_renderer_submit_many(oc_canvas_renderer rendererHandle, u32 count, oc_canvas_submission* submissions)
+{
+    oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(rendererHandle);
+
+    oc_image_decoder_poll();
+
+    if(!renderer)
+    {
+        return;
+    }
+    if(renderer->submitMany)
+    {
+        OC_TRACE_BEGIN("canvas submit many");
+        renderer->submitMany(renderer, count, submissions);
+        OC_TRACE_END();
+    }
+    else if(renderer->submit)
+    {
+        //NOTE: backends that can't batch submissions still present all the surfaces after rendering them
+        OC_TRACE_BEGIN("canvas submit many");
+        for(u32 i = 0; i < count; i++)
+        {
+            oc_canvas_submission* submission = &submissions[i];
+            renderer->submit(renderer,
+                             submission->surface,
+                             submission->msaaSampleCount,
+                             submission->clear,
+                             submission->clearColor,
+                             submission->damage,
+                             submission->primitiveCount,
+                             submission->primitives,
+                             submission->attributeCount,
+                             submission->attributes,
+                             submission->eltCount,
+                             submission->elements);
+        }
+        for(u32 i = 0; renderer->present && i < count; i++)
+        {
+            renderer->present(renderer, submissions[i].surface);
+        }
+        OC_TRACE_END();
     }
 }
 
@@ -83,7 +223,76 @@ void oc_canvas_present(oc_canvas_renderer rendererHandle, oc_surface surfaceHand
     oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(rendererHandle);
     if(renderer && renderer->present)
     {
+        OC_TRACE_BEGIN("canvas present");
         renderer->present(renderer, surfaceHandle);
+        OC_TRACE_END();
+    }
+}
+
+void oc_canvas_renderer_set_present_mode(oc_canvas_renderer rendererHandle, oc_canvas_present_mode mode, u32 maxFrameLatency)
+{
+    oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(rendererHandle);
+    if(renderer && renderer->setPresentMode)
+    {
+        renderer->setPresentMode(renderer, mode, maxFrameLatency);
+    }
+}
+
+void oc_canvas_renderer_set_dynamic_scale(oc_canvas_renderer rendererHandle, f32 gpuBudget, f32 minScale)
+{
+    oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(rendererHandle);
+    if(renderer && renderer->setDynamicScale)
+    {
+        renderer->setDynamicScale(renderer, gpuBudget, minScale);
+    }
+}
+
+f32 oc_canvas_renderer_get_render_scale(oc_canvas_renderer rendererHandle)
+{
+    f32 scale = 1;
+    oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(rendererHandle);
+    if(renderer && renderer->getRenderScale)
+    {
+        scale = renderer->getRenderScale(renderer);
+    }
+    return (scale);
+}
+
+void oc_canvas_renderer_track_memory(oc_canvas_renderer_base* renderer, oc_canvas_memory_category category, i64 delta)
+{
+    oc_canvas_memory_counter* counters[2] = { &renderer->memory[category], &renderer->memory[OC_CANVAS_MEMORY_TOTAL] };
+    for(int i = 0; i < 2; i++)
+    {
+        u64 bytes = atomic_fetch_add(&counters[i]->bytes, (u64)delta) + (u64)delta;
+        u64 peak = atomic_load(&counters[i]->peakBytes);
+        while(bytes > peak && !atomic_compare_exchange_weak(&counters[i]->peakBytes, &peak, bytes))
+        {
+        }
+    }
+}
+
+oc_canvas_memory_stats oc_canvas_renderer_get_memory_stats(oc_canvas_renderer rendererHandle)
+{
+    oc_canvas_memory_stats stats = { 0 };
+    oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(rendererHandle);
+    if(renderer)
+    {
+        oc_canvas_memory_usage* usage = (oc_canvas_memory_usage*)&stats;
+        for(int category = 0; category < OC_CANVAS_MEMORY_CATEGORY_COUNT; category++)
+        {
+            usage[category].bytes = atomic_load(&renderer->memory[category].bytes);
+            usage[category].peakBytes = atomic_load(&renderer->memory[category].peakBytes);
+        }
+    }
+    return (stats);
+}
+
+void oc_canvas_renderer_wait_frame_latency(oc_canvas_renderer rendererHandle)
+{
+    oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(rendererHandle);
+    if(renderer && renderer->waitFrameLatency)
+    {
+        renderer->waitFrameLatency(renderer);
     }
 }
 
@@ -116,12 +325,29 @@ oc_image oc_image_create(oc_canvas_renderer handle, u32 width, u32 height)
         if(imageData)
         {
             imageData->renderer = handle;
+            imageData->decodePending = false;
+            imageData->tiled = false;
+            imageData->yuv = false;
+            imageData->cached = false;
+            imageData->refCount = 0;
             image = oc_image_handle_alloc(imageData);
         }
     }
     return (image);
 }
 
+static void oc_image_destroy_data(oc_image image, oc_image_base* imageData)
+{
+    oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(imageData->renderer);
+    if(renderer && renderer->imageDestroy)
+    {
+        renderer->imageDestroy(renderer, imageData);
+    }
+    oc_graphics_handle_recycle(image.h);
+}
+
+static void oc_image_cache_release(oc_canvas_renderer_base* renderer, oc_image_base* imageData);
+
 void oc_image_destroy(oc_image image)
 {
     oc_image_base* imageData = oc_image_from_handle(image);
@@ -129,11 +355,191 @@ void oc_image_destroy(oc_image image)
     if(imageData)
     {
         oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(imageData->renderer);
-        if(renderer && renderer->imageDestroy)
+        if(renderer && imageData->cached)
+        {
+            oc_image_cache_release(renderer, imageData);
+        }
+        else
+        {
+            oc_image_destroy_data(image, imageData);
+        }
+    }
+}
+
+//---------------------------------------------------------------
+// image cache
+//---------------------------------------------------------------
+
+enum
+{
+    OC_IMAGE_CACHE_DEFAULT_BUDGET = 64 << 20,
+
+    //NOTE: key seeds, so that flipped and async images don't share an entry with the others. Async images are still
+    //      being decoded when they're returned, which synchronous callers don't expect.
+    OC_IMAGE_CACHE_KEY_FLIP = 1 << 0,
+    OC_IMAGE_CACHE_KEY_ASYNC = 1 << 1,
+    OC_IMAGE_CACHE_KEY_PATH = 1 << 2,
+};
+
+void oc_canvas_renderer_enable_image_cache(oc_canvas_renderer handle, u64 budget)
+{
+    oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(handle);
+    if(renderer)
+    {
+        oc_image_cache* cache = &renderer->imageCache;
+        if(!cache->enabled)
+        {
+            oc_hash_map_init(&cache->images, sizeof(oc_image_base*));
+            oc_list_init(&cache->released);
+            cache->releasedSize = 0;
+            cache->enabled = true;
+        }
+        cache->budget = budget ? budget : OC_IMAGE_CACHE_DEFAULT_BUDGET;
+    }
+}
+
+static u64 oc_image_cache_image_size(oc_image_base* imageData)
+{
+    return ((u64)imageData->size.x * (u64)imageData->size.y * 4);
+}
+
+static u64 oc_image_cache_key_seed(bool flip, bool async)
+{
+    return ((flip ? OC_IMAGE_CACHE_KEY_FLIP : 0) | (async ? OC_IMAGE_CACHE_KEY_ASYNC : 0));
+}
+
+u64 oc_image_cache_data_key(oc_canvas_renderer handle, oc_str8 data, bool flip, bool async)
+{
+    u64 key = 0;
+    oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(handle);
+    if(renderer && renderer->imageCache.enabled)
+    {
+        key = oc_hash_xx64_string_seed(data, oc_image_cache_key_seed(flip, async));
+    }
+    return (key);
+}
+
+u64 oc_image_cache_path_key(oc_canvas_renderer handle, oc_str8 path, oc_file file, bool flip, bool async)
+{
+    u64 key = 0;
+    oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(handle);
+    if(renderer && renderer->imageCache.enabled)
+    {
+        //NOTE: the modification date is part of the key, so that images are loaded again once their file changed
+        oc_file_status status = oc_file_get_status(file);
+        key = oc_hash_xx64_string_seed(path, oc_image_cache_key_seed(flip, async) | OC_IMAGE_CACHE_KEY_PATH);
+        key = oc_hash_xx64_string_seed(oc_str8_from_buffer(sizeof(oc_datestamp), (char*)&status.modificationDate), key);
+    }
+    return (key);
+}
+
+oc_image oc_image_cache_acquire(oc_canvas_renderer handle, u64 key)
+{
+    oc_image image = oc_image_nil();
+    oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(handle);
+    if(renderer && renderer->imageCache.enabled && key)
+    {
+        oc_image_cache* cache = &renderer->imageCache;
+        oc_image_base** slot = oc_hash_map_find_type(&cache->images, key, oc_image_base*);
+        if(slot)
+        {
+            oc_image_base* imageData = *slot;
+            if(imageData->refCount == 0)
+            {
+                oc_list_remove(&cache->released, &imageData->cacheElt);
+                cache->releasedSize -= oc_image_cache_image_size(imageData);
+            }
+            imageData->refCount++;
+            image = imageData->cacheHandle;
+        }
+    }
+    return (image);
+}
+
+void oc_image_cache_insert(oc_canvas_renderer handle, u64 key, oc_image image)
+{
+    oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(handle);
+    oc_image_base* imageData = oc_image_from_handle(image);
+    if(renderer && renderer->imageCache.enabled && key && imageData)
+    {
+        bool inserted = false;
+        oc_image_base** slot = oc_hash_map_insert_type(&renderer->imageCache.images, key, oc_image_base*, &inserted);
+        if(inserted)
+        {
+            *slot = imageData;
+        }
+        if(!imageData->cached)
+        {
+            imageData->cached = true;
+            imageData->refCount = 1;
+            imageData->cacheHandle = image;
+        }
+    }
+}
+
+static void oc_image_cache_evict(oc_canvas_renderer_base* renderer, oc_image_base* imageData)
+{
+    oc_image_cache* cache = &renderer->imageCache;
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    //NOTE: an image can be cached under several keys, collect them before removing them from the map
+    u64 keyCount = 0;
+    u64* keys = oc_arena_push_array(scratch.arena, u64, cache->images.count);
+    u64 index = 0;
+    u64 key = 0;
+    oc_image_base** slot = 0;
+    while((slot = oc_hash_map_next(&cache->images, &index, &key)) != 0)
+    {
+        if(*slot == imageData)
+        {
+            keys[keyCount++] = key;
+        }
+    }
+    for(u64 i = 0; i < keyCount; i++)
+    {
+        oc_hash_map_remove(&cache->images, keys[i]);
+    }
+    oc_scratch_end(scratch);
+
+    oc_list_remove(&cache->released, &imageData->cacheElt);
+    cache->releasedSize -= oc_image_cache_image_size(imageData);
+
+    imageData->cached = false;
+    oc_image_destroy_data(imageData->cacheHandle, imageData);
+}
+
+static void oc_image_cache_release(oc_canvas_renderer_base* renderer, oc_image_base* imageData)
+{
+    oc_image_cache* cache = &renderer->imageCache;
+
+    OC_DEBUG_ASSERT(imageData->refCount, "cached image released more times than it was acquired");
+    imageData->refCount--;
+
+    if(imageData->refCount == 0)
+    {
+        oc_list_push_front(&cache->released, &imageData->cacheElt);
+        cache->releasedSize += oc_image_cache_image_size(imageData);
+
+        while(cache->releasedSize > cache->budget)
         {
-            renderer->imageDestroy(renderer, imageData);
+            oc_image_base* oldest = oc_list_last_entry(cache->released, oc_image_base, cacheElt);
+            oc_image_cache_evict(renderer, oldest);
         }
-        oc_graphics_handle_recycle(image.h);
+    }
+}
+
+static void oc_image_cache_cleanup(oc_canvas_renderer_base* renderer)
+{
+    oc_image_cache* cache = &renderer->imageCache;
+    if(cache->enabled)
+    {
+        //NOTE: images that are still referenced are destroyed with the renderer
+        oc_list_for_safe(cache->released, imageData, oc_image_base, cacheElt)
+        {
+            oc_image_cache_evict(renderer, imageData);
+        }
+        oc_hash_map_cleanup(&cache->images);
+        cache->enabled = false;
     }
 }
 
@@ -143,12 +549,340 @@ void oc_image_upload_region_rgba8(oc_image image, oc_rect region, u8* pixels)
 
     if(imageData)
     {
+        if(imageData->tiled)
+        {
+            oc_log_error("tiled images are uploaded with oc_tiled_image_upload_tile().\n");
+            return;
+        }
+        if(imageData->yuv)
+        {
+            oc_log_error("YUV images are uploaded with oc_image_upload_yuv_plane().\n");
+            return;
+        }
         oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(imageData->renderer);
         if(renderer && renderer->imageUploadRegion)
         {
+            OC_TRACE_BEGIN("image upload");
             renderer->imageUploadRegion(renderer, imageData, region, pixels);
+            OC_TRACE_END();
+        }
+    }
+}
+
+bool oc_image_upload_done(oc_image image)
+{
+    bool done = true;
+    oc_image_base* imageData = oc_image_from_handle(image);
+
+    if(imageData)
+    {
+        oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(imageData->renderer);
+        if(renderer && renderer->imageUploadDone)
+        {
+            done = renderer->imageUploadDone(renderer, imageData);
+        }
+    }
+    return (done);
+}
+
+bool oc_image_compressed_format_supported(oc_canvas_renderer handle, oc_image_compressed_format format)
+{
+    bool supported = false;
+    oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(handle);
+    if(renderer
+       && renderer->compressedFormatSupported
+       && format >= 0
+       && format < OC_IMAGE_COMPRESSED_FORMAT_COUNT)
+    {
+        supported = renderer->compressedFormatSupported(renderer, format);
+    }
+    return (supported);
+}
+
+oc_image oc_image_create_compressed(oc_canvas_renderer handle, oc_image_compressed_format format, u32 width, u32 height, oc_str8 data)
+{
+    oc_image image = oc_image_nil();
+
+    if(!oc_image_compressed_format_supported(handle, format))
+    {
+        oc_log_error("compressed image format %i is not supported by the renderer.\n", format);
+        return (image);
+    }
+    if(!width || !height || (width % 4) || (height % 4))
+    {
+        oc_log_error("compressed image size (%u, %u) must be a non-zero multiple of 4.\n", width, height);
+        return (image);
+    }
+    //NOTE: all supported formats use 4x4 blocks of 16 bytes
+    u64 dataSize = (u64)(width / 4) * (height / 4) * 16;
+    if(data.len < dataSize)
+    {
+        oc_log_error("compressed image data is too small (%llu bytes, expected %llu).\n", (unsigned long long)data.len, (unsigned long long)dataSize);
+        return (image);
+    }
+
+    oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(handle);
+    if(renderer->imageCreateCompressed)
+    {
+        oc_image_base* imageData = renderer->imageCreateCompressed(renderer, format, (oc_vec2){ width, height }, oc_str8_slice(data, 0, dataSize));
+        if(imageData)
+        {
+            imageData->renderer = handle;
+            imageData->decodePending = false;
+            imageData->tiled = false;
+            imageData->yuv = false;
+            imageData->cached = false;
+            imageData->refCount = 0;
+            image = oc_image_handle_alloc(imageData);
+        }
+    }
+    return (image);
+}
+
+oc_image oc_image_create_render_target(oc_canvas_renderer handle, u32 width, u32 height)
+{
+    oc_image image = oc_image_nil();
+    oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(handle);
+    if(renderer && renderer->imageCreateRenderTarget)
+    {
+        if(!width || !height)
+        {
+            oc_log_error("render target size (%u, %u) must not be zero.\n", width, height);
+            return (image);
+        }
+        oc_image_base* imageData = renderer->imageCreateRenderTarget(renderer, (oc_vec2){ width, height });
+        if(imageData)
+        {
+            imageData->renderer = handle;
+            imageData->decodePending = false;
+            imageData->tiled = false;
+            imageData->yuv = false;
+            imageData->cached = false;
+            imageData->refCount = 0;
+            image = oc_image_handle_alloc(imageData);
         }
     }
+    return (image);
+}
+
+void oc_image_readback_region(oc_image image, oc_rect region)
+{
+    oc_image_base* imageData = oc_image_from_handle(image);
+
+    if(imageData)
+    {
+        if(imageData->tiled)
+        {
+            oc_log_error("can't read back a tiled image.\n");
+            return;
+        }
+        if(imageData->yuv)
+        {
+            oc_log_error("can't read back a YUV image.\n");
+            return;
+        }
+        if(region.x < 0
+           || region.y < 0
+           || region.w <= 0
+           || region.h <= 0
+           || region.x + region.w > imageData->size.x
+           || region.y + region.h > imageData->size.y)
+        {
+            oc_log_error("readback region is out of the image bounds.\n");
+            return;
+        }
+        oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(imageData->renderer);
+        if(renderer && renderer->imageReadbackRegion)
+        {
+            renderer->imageReadbackRegion(renderer, imageData, region);
+        }
+    }
+}
+
+bool oc_image_readback_done(oc_image image)
+{
+    bool done = true;
+    oc_image_base* imageData = oc_image_from_handle(image);
+
+    if(imageData)
+    {
+        oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(imageData->renderer);
+        if(renderer && renderer->imageReadbackDone)
+        {
+            done = renderer->imageReadbackDone(renderer, imageData);
+        }
+    }
+    return (done);
+}
+
+bool oc_image_readback_get(oc_image image, u64 size, u8* pixels)
+{
+    bool result = false;
+    oc_image_base* imageData = oc_image_from_handle(image);
+
+    if(imageData)
+    {
+        oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(imageData->renderer);
+        if(renderer && renderer->imageReadbackGet)
+        {
+            result = renderer->imageReadbackGet(renderer, imageData, size, pixels);
+        }
+    }
+    return (result);
+}
+
+//---------------------------------------------------------------
+// async image decoding
+//---------------------------------------------------------------
+
+typedef struct oc_image_decode_job
+{
+    oc_list_elt listElt;
+    oc_image image;
+    oc_str8 mem;
+    bool flip;
+
+    bool tiled; // the job decodes a tile of a tiled image, of size width x height
+    oc_image_tile tile;
+
+    u8* pixels;
+    u32 width;
+    u32 height;
+
+} oc_image_decode_job;
+
+//NOTE: decoding runs on the platform job system, finished jobs are queued on the done list until they're polled
+typedef struct oc_image_decoder
+{
+    bool init;
+    oc_mutex* mutex;
+    oc_list done;
+
+} oc_image_decoder;
+
+static oc_image_decoder oc_imageDecoder = { 0 };
+
+static void oc_image_decode_job_proc(void* user)
+{
+    oc_image_decode_job* job = (oc_image_decode_job*)user;
+    oc_image_decoder* decoder = &oc_imageDecoder;
+
+    u32 width = 0, height = 0;
+    OC_TRACE_BEGIN("image decode");
+    job->pixels = oc_image_decode_rgba8(job->mem, job->flip, &width, &height);
+    OC_TRACE_END();
+    if(job->pixels && (width != job->width || height != job->height))
+    {
+        oc_log_error("decoded image size doesn't match its header\n");
+        free(job->pixels);
+        job->pixels = 0;
+    }
+
+    oc_mutex_lock(decoder->mutex);
+    oc_list_push_back(&decoder->done, &job->listElt);
+    oc_mutex_unlock(decoder->mutex);
+}
+
+static void oc_image_decoder_init(oc_image_decoder* decoder)
+{
+    decoder->mutex = oc_mutex_create();
+    oc_list_init(&decoder->done);
+    decoder->init = true;
+}
+
+//NOTE: uploads the images decoded since the last call. This must be called from the thread that uses the renderer.
+static void oc_image_decoder_poll(void)
+{
+    oc_image_decoder* decoder = &oc_imageDecoder;
+    if(!decoder->init)
+    {
+        return;
+    }
+
+    oc_list done = { 0 };
+    oc_mutex_lock(decoder->mutex);
+    done = decoder->done;
+    oc_list_init(&decoder->done);
+    oc_mutex_unlock(decoder->mutex);
+
+    oc_list_for_safe(done, job, oc_image_decode_job, listElt)
+    {
+        //NOTE: the image may have been destroyed while it was being decoded
+        oc_image_base* imageData = oc_image_from_handle(job->image);
+        if(imageData && job->tiled)
+        {
+            if(job->pixels)
+            {
+                oc_tiled_image_upload_tile(job->image, job->tile, job->pixels);
+            }
+        }
+        else if(imageData)
+        {
+            if(job->pixels)
+            {
+                oc_image_upload_region_rgba8(job->image, (oc_rect){ 0, 0, job->width, job->height }, job->pixels);
+            }
+            imageData->decodePending = false;
+        }
+        if(job->pixels)
+        {
+            free(job->pixels);
+        }
+        free(job->mem.ptr);
+        free(job);
+    }
+}
+
+oc_image oc_image_create_from_memory_async(oc_canvas_renderer renderer, oc_str8 mem, bool flip)
+{
+    u64 cacheKey = oc_image_cache_data_key(renderer, mem, flip, true);
+    oc_image image = oc_image_cache_acquire(renderer, cacheKey);
+    if(!oc_image_is_nil(image))
+    {
+        return (image);
+    }
+
+    u32 width, height;
+
+    if(oc_image_decode_size(mem, &width, &height))
+    {
+        image = oc_image_create(renderer, width, height);
+
+        oc_image_base* imageData = oc_image_from_handle(image);
+        if(imageData)
+        {
+            oc_image_decode_job* job = oc_malloc_type(oc_image_decode_job);
+            memset(job, 0, sizeof(oc_image_decode_job));
+
+            job->image = image;
+            job->flip = flip;
+            job->width = width;
+            job->height = height;
+            job->mem.ptr = oc_malloc_array(char, mem.len);
+            job->mem.len = mem.len;
+            memcpy(job->mem.ptr, mem.ptr, mem.len);
+
+            imageData->decodePending = true;
+
+            oc_image_decoder* decoder = &oc_imageDecoder;
+            if(!decoder->init)
+            {
+                oc_image_decoder_init(decoder);
+            }
+            oc_job_submit(oc_image_decode_job_proc, job, 0);
+
+            oc_image_cache_insert(renderer, cacheKey, image);
+        }
+    }
+    return (image);
+}
+
+bool oc_image_is_ready(oc_image image)
+{
+    oc_image_decoder_poll();
+
+    oc_image_base* imageData = oc_image_from_handle(image);
+    return (imageData && !imageData->decodePending);
 }
 
 oc_vec2 oc_image_size(oc_image image)
@@ -161,3 +895,290 @@ oc_vec2 oc_image_size(oc_image image)
     }
     return (res);
 }
+
+//---------------------------------------------------------------
+// tiled images
+//---------------------------------------------------------------
+
+oc_vec2 oc_tiled_image_level_size(oc_vec2 size, u32 level)
+{
+    u32 roundUp = (1 << level) - 1;
+    oc_vec2 levelSize = {
+        ((u32)size.x + roundUp) >> level,
+        ((u32)size.y + roundUp) >> level,
+    };
+    return (levelSize);
+}
+
+u32 oc_tiled_image_level_count_for_size(oc_vec2 size)
+{
+    u32 levelCount = 1;
+    oc_vec2 levelSize = size;
+    while((levelSize.x > OC_IMAGE_TILE_SIZE || levelSize.y > OC_IMAGE_TILE_SIZE) && levelCount < OC_IMAGE_TILE_MAX_LEVELS)
+    {
+        levelSize = oc_tiled_image_level_size(size, levelCount);
+        levelCount++;
+    }
+    return (levelCount);
+}
+
+oc_image oc_tiled_image_create(oc_canvas_renderer handle, u32 width, u32 height)
+{
+    oc_image image = oc_image_nil();
+    oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(handle);
+    if(renderer)
+    {
+        if(!renderer->imageCreateTiled)
+        {
+            oc_log_error("tiled images are not supported by the renderer.\n");
+            return (image);
+        }
+        //NOTE: the last level must fit in a tile
+        u32 maxSize = OC_IMAGE_TILE_SIZE << (OC_IMAGE_TILE_MAX_LEVELS - 1);
+        if(!width || !height || width > maxSize || height > maxSize)
+        {
+            oc_log_error("tiled image size (%u, %u) must be between 1 and %u.\n", width, height, maxSize);
+            return (image);
+        }
+        oc_image_base* imageData = renderer->imageCreateTiled(renderer, (oc_vec2){ width, height });
+        if(imageData)
+        {
+            imageData->renderer = handle;
+            imageData->decodePending = false;
+            imageData->tiled = true;
+            imageData->yuv = false;
+            imageData->cached = false;
+            imageData->refCount = 0;
+            image = oc_image_handle_alloc(imageData);
+        }
+    }
+    return (image);
+}
+
+u32 oc_tiled_image_level_count(oc_image image)
+{
+    u32 levelCount = 0;
+    oc_image_base* imageData = oc_image_from_handle(image);
+    if(imageData && imageData->tiled)
+    {
+        levelCount = oc_tiled_image_level_count_for_size(imageData->size);
+    }
+    return (levelCount);
+}
+
+oc_rect oc_tiled_image_tile_rect(oc_image image, oc_image_tile tile)
+{
+    oc_rect rect = { 0 };
+    oc_image_base* imageData = oc_image_from_handle(image);
+    if(imageData
+       && imageData->tiled
+       && tile.level < oc_tiled_image_level_count_for_size(imageData->size))
+    {
+        oc_vec2 levelSize = oc_tiled_image_level_size(imageData->size, tile.level);
+        u32 x = tile.x * OC_IMAGE_TILE_SIZE;
+        u32 y = tile.y * OC_IMAGE_TILE_SIZE;
+        if(x < levelSize.x && y < levelSize.y)
+        {
+            rect = (oc_rect){ x,
+                              y,
+                              oc_min(OC_IMAGE_TILE_SIZE, levelSize.x - x),
+                              oc_min(OC_IMAGE_TILE_SIZE, levelSize.y - y) };
+        }
+    }
+    return (rect);
+}
+
+u32 oc_tiled_image_requests(oc_image image, u32 maxCount, oc_image_tile* tiles)
+{
+    //NOTE: upload the tiles that finished decoding, so that they aren't requested again
+    oc_image_decoder_poll();
+
+    u32 count = 0;
+    oc_image_base* imageData = oc_image_from_handle(image);
+    if(imageData && imageData->tiled)
+    {
+        oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(imageData->renderer);
+        if(renderer && renderer->tiledImageRequests)
+        {
+            count = renderer->tiledImageRequests(renderer, imageData, maxCount, tiles);
+        }
+    }
+    return (count);
+}
+
+bool oc_tiled_image_upload_tile(oc_image image, oc_image_tile tile, u8* pixels)
+{
+    bool result = false;
+    oc_image_base* imageData = oc_image_from_handle(image);
+    if(imageData && imageData->tiled)
+    {
+        oc_rect rect = oc_tiled_image_tile_rect(image, tile);
+        if(rect.w <= 0 || rect.h <= 0)
+        {
+            oc_log_error("tile (%u, %u) of level %u is out of the image bounds.\n", tile.x, tile.y, tile.level);
+            return (false);
+        }
+        oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(imageData->renderer);
+        if(renderer && renderer->tiledImageUploadTile)
+        {
+            OC_TRACE_BEGIN("tile upload");
+            result = renderer->tiledImageUploadTile(renderer, imageData, tile, rect, pixels);
+            OC_TRACE_END();
+        }
+    }
+    return (result);
+}
+
+void oc_tiled_image_load_tile_from_memory_async(oc_image image, oc_image_tile tile, oc_str8 mem, bool flip)
+{
+    oc_image_base* imageData = oc_image_from_handle(image);
+    if(imageData && imageData->tiled)
+    {
+        oc_rect rect = oc_tiled_image_tile_rect(image, tile);
+        if(rect.w <= 0 || rect.h <= 0)
+        {
+            oc_log_error("tile (%u, %u) of level %u is out of the image bounds.\n", tile.x, tile.y, tile.level);
+            return;
+        }
+
+        oc_image_decode_job* job = oc_malloc_type(oc_image_decode_job);
+        memset(job, 0, sizeof(oc_image_decode_job));
+
+        job->image = image;
+        job->flip = flip;
+        job->tiled = true;
+        job->tile = tile;
+        job->width = rect.w;
+        job->height = rect.h;
+        job->mem.ptr = oc_malloc_array(char, mem.len);
+        job->mem.len = mem.len;
+        memcpy(job->mem.ptr, mem.ptr, mem.len);
+
+        oc_image_decoder* decoder = &oc_imageDecoder;
+        if(!decoder->init)
+        {
+            oc_image_decoder_init(decoder);
+        }
+        oc_job_submit(oc_image_decode_job_proc, job, 0);
+    }
+}
+
+//---------------------------------------------------------------
+// YUV images
+//---------------------------------------------------------------
+
+u32 oc_image_yuv_plane_count_for_format(oc_image_yuv_format format)
+{
+    return ((format == OC_IMAGE_YUV_NV12) ? 2 : 3);
+}
+
+oc_vec2 oc_image_yuv_plane_size_for_format(oc_image_yuv_format format, oc_vec2 size, u32 plane)
+{
+    oc_vec2 planeSize = { 0 };
+    if(plane == 0)
+    {
+        planeSize = size;
+    }
+    else if(plane < oc_image_yuv_plane_count_for_format(format))
+    {
+        //NOTE: chroma is subsampled by 2, rounding up. NV12 interleaves Cb and Cr in a single plane.
+        u32 chromaWidth = ((u32)size.x + 1) / 2;
+        u32 chromaHeight = ((u32)size.y + 1) / 2;
+        planeSize = (oc_vec2){ (format == OC_IMAGE_YUV_NV12) ? chromaWidth * 2 : chromaWidth, chromaHeight };
+    }
+    return (planeSize);
+}
+
+oc_image oc_image_create_yuv(oc_canvas_renderer handle,
+                             oc_image_yuv_format format,
+                             oc_image_yuv_color_space colorSpace,
+                             u32 width,
+                             u32 height)
+{
+    oc_image image = oc_image_nil();
+    oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(handle);
+    if(renderer)
+    {
+        if(!renderer->imageCreateYuv)
+        {
+            oc_log_error("YUV images are not supported by the renderer.\n");
+            return (image);
+        }
+        if(format < 0 || format >= OC_IMAGE_YUV_FORMAT_COUNT)
+        {
+            oc_log_error("invalid YUV format %i.\n", format);
+            return (image);
+        }
+        if(colorSpace < 0 || colorSpace >= OC_IMAGE_YUV_COLOR_SPACE_COUNT)
+        {
+            oc_log_error("invalid YUV color space %i.\n", colorSpace);
+            return (image);
+        }
+        if(!width || !height)
+        {
+            oc_log_error("YUV image size (%u, %u) must not be zero.\n", width, height);
+            return (image);
+        }
+        oc_image_base* imageData = renderer->imageCreateYuv(renderer, format, colorSpace, (oc_vec2){ width, height });
+        if(imageData)
+        {
+            imageData->renderer = handle;
+            imageData->decodePending = false;
+            imageData->tiled = false;
+            imageData->yuv = true;
+            imageData->yuvFormat = format;
+            imageData->yuvColorSpace = colorSpace;
+            imageData->cached = false;
+            imageData->refCount = 0;
+            image = oc_image_handle_alloc(imageData);
+        }
+    }
+    return (image);
+}
+
+u32 oc_image_yuv_plane_count(oc_image image)
+{
+    u32 count = 0;
+    oc_image_base* imageData = oc_image_from_handle(image);
+    if(imageData && imageData->yuv)
+    {
+        count = oc_image_yuv_plane_count_for_format(imageData->yuvFormat);
+    }
+    return (count);
+}
+
+oc_vec2 oc_image_yuv_plane_size(oc_image image, u32 plane)
+{
+    oc_vec2 size = { 0 };
+    oc_image_base* imageData = oc_image_from_handle(image);
+    if(imageData && imageData->yuv)
+    {
+        size = oc_image_yuv_plane_size_for_format(imageData->yuvFormat, imageData->size, plane);
+    }
+    return (size);
+}
+
+void oc_image_upload_yuv_plane(oc_image image, u32 plane, u8* pixels)
+{
+    oc_image_base* imageData = oc_image_from_handle(image);
+    if(imageData)
+    {
+        if(!imageData->yuv)
+        {
+            oc_log_error("can't upload a YUV plane to an image that wasn't created with oc_image_create_yuv().\n");
+            return;
+        }
+        if(plane >= oc_image_yuv_plane_count_for_format(imageData->yuvFormat))
+        {
+            oc_log_error("YUV image has no plane %u.\n", plane);
+            return;
+        }
+        oc_canvas_renderer_base* renderer = oc_canvas_renderer_from_handle(imageData->renderer);
+        if(renderer && renderer->imageUploadYuvPlane)
+        {
+            OC_TRACE_BEGIN("yuv plane upload");
+            renderer->imageUploadYuvPlane(renderer, imageData, plane, pixels);
+            OC_TRACE_END();
+        }
+    }
+}
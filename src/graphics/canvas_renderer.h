@@ -9,6 +9,8 @@
 
 #include "graphics.h"
 #include "surface.h"
+#include "platform/platform_thread.h"
+#include "util/hash_map.h"
 
 typedef struct oc_image_base
 {
@@ -16,6 +18,17 @@ typedef struct oc_image_base
     u32 generation;
     oc_canvas_renderer renderer;
     oc_vec2 size;
+    bool decodePending;
+    bool tiled; // created with oc_tiled_image_create(), only used with the oc_tiled_image_*() functions
+    bool yuv;   // created with oc_image_create_yuv(), uploaded with oc_image_upload_yuv_plane()
+    oc_image_yuv_format yuvFormat;
+    oc_image_yuv_color_space yuvColorSpace;
+
+    //NOTE: images shared through the renderer's image cache
+    bool cached;
+    u32 refCount;
+    oc_image cacheHandle;
+    oc_list_elt cacheElt; // in the cache's released list while refCount is 0
 
 } oc_image_base;
 
@@ -31,27 +44,156 @@ typedef void (*oc_canvas_renderer_image_upload_region_proc)(oc_canvas_renderer_b
                                                             oc_image_base* image,
                                                             oc_rect region,
                                                             u8* pixels);
+typedef bool (*oc_canvas_renderer_image_upload_done_proc)(oc_canvas_renderer_base* renderer, oc_image_base* image);
+typedef bool (*oc_canvas_renderer_compressed_format_supported_proc)(oc_canvas_renderer_base* renderer, oc_image_compressed_format format);
+typedef oc_image_base* (*oc_canvas_renderer_image_create_compressed_proc)(oc_canvas_renderer_base* renderer,
+                                                                          oc_image_compressed_format format,
+                                                                          oc_vec2 size,
+                                                                          oc_str8 data);
+typedef oc_image_base* (*oc_canvas_renderer_image_create_render_target_proc)(oc_canvas_renderer_base* renderer, oc_vec2 size);
+typedef void (*oc_canvas_renderer_image_readback_region_proc)(oc_canvas_renderer_base* renderer, oc_image_base* image, oc_rect region);
+typedef bool (*oc_canvas_renderer_image_readback_done_proc)(oc_canvas_renderer_base* renderer, oc_image_base* image);
+typedef bool (*oc_canvas_renderer_image_readback_get_proc)(oc_canvas_renderer_base* renderer, oc_image_base* image, u64 size, u8* pixels);
+typedef oc_image_base* (*oc_canvas_renderer_image_create_tiled_proc)(oc_canvas_renderer_base* renderer, oc_vec2 size);
+typedef u32 (*oc_canvas_renderer_tiled_image_requests_proc)(oc_canvas_renderer_base* renderer,
+                                                            oc_image_base* image,
+                                                            u32 maxCount,
+                                                            oc_image_tile* tiles);
+typedef bool (*oc_canvas_renderer_tiled_image_upload_tile_proc)(oc_canvas_renderer_base* renderer,
+                                                                oc_image_base* image,
+                                                                oc_image_tile tile,
+                                                                oc_rect rect,
+                                                                u8* pixels);
+typedef oc_image_base* (*oc_canvas_renderer_image_create_yuv_proc)(oc_canvas_renderer_base* renderer,
+                                                                   oc_image_yuv_format format,
+                                                                   oc_image_yuv_color_space colorSpace,
+                                                                   oc_vec2 size);
+typedef void (*oc_canvas_renderer_image_upload_yuv_plane_proc)(oc_canvas_renderer_base* renderer,
+                                                               oc_image_base* image,
+                                                               u32 plane,
+                                                               u8* pixels);
 
 typedef void (*oc_canvas_renderer_submit_proc)(oc_canvas_renderer_base* renderer,
                                                oc_surface surface,
                                                u32 sampleCount,
                                                bool clear,
                                                oc_color clearColor,
+                                               oc_rect damage,
                                                u32 primitiveCount,
                                                oc_primitive* primitives,
+                                               u32 attributeCount,
+                                               oc_attributes* attributes,
                                                u32 eltCount,
                                                oc_path_elt* pathElements);
 
+typedef void (*oc_canvas_renderer_submit_image_proc)(oc_canvas_renderer_base* renderer,
+                                                     oc_image_base* image,
+                                                     u32 sampleCount,
+                                                     bool clear,
+                                                     oc_color clearColor,
+                                                     u32 primitiveCount,
+                                                     oc_primitive* primitives,
+                                                     u32 attributeCount,
+                                                     oc_attributes* attributes,
+                                                     u32 eltCount,
+                                                     oc_path_elt* pathElements);
+
+typedef void (*oc_canvas_renderer_submit_many_proc)(oc_canvas_renderer_base* renderer,
+                                                    u32 count,
+                                                    oc_canvas_submission* submissions);
+
 typedef void (*oc_canvas_renderer_present_proc)(oc_canvas_renderer_base* renderer, oc_surface surface);
+typedef void (*oc_canvas_renderer_set_present_mode_proc)(oc_canvas_renderer_base* renderer,
+                                                         oc_canvas_present_mode mode,
+                                                         u32 maxFrameLatency);
+typedef void (*oc_canvas_renderer_wait_frame_latency_proc)(oc_canvas_renderer_base* renderer);
+typedef void (*oc_canvas_renderer_set_dynamic_scale_proc)(oc_canvas_renderer_base* renderer, f32 gpuBudget, f32 minScale);
+typedef f32 (*oc_canvas_renderer_get_render_scale_proc)(oc_canvas_renderer_base* renderer);
+
+//NOTE: cached images by key. Keys are hashes of a path and its modification date, or of the encoded data, so an image
+//      can have several keys. Released images are kept in released, most recently released first.
+typedef struct oc_image_cache
+{
+    bool enabled;
+    u64 budget;
+    u64 releasedSize;
+    oc_hash_map images; // oc_image_base* values
+    oc_list released;
+} oc_image_cache;
+
+//NOTE: memory accounting categories, in the order of the fields of oc_canvas_memory_stats
+typedef enum oc_canvas_memory_category
+{
+    OC_CANVAS_MEMORY_PATH_BUFFERS,
+    OC_CANVAS_MEMORY_RASTER_BUFFERS,
+    OC_CANVAS_MEMORY_IMAGES,
+    OC_CANVAS_MEMORY_TARGETS,
+    OC_CANVAS_MEMORY_STAGING,
+    OC_CANVAS_MEMORY_TOTAL,
+    OC_CANVAS_MEMORY_CATEGORY_COUNT,
+} oc_canvas_memory_category;
+
+typedef struct oc_canvas_memory_counter
+{
+    _Atomic(u64) bytes;
+    _Atomic(u64) peakBytes;
+
+} oc_canvas_memory_counter;
 
 typedef struct oc_canvas_renderer_base
 {
+    oc_canvas_backend backend;
+
+    //NOTE: updated by backends with oc_canvas_renderer_track_memory(), possibly from several threads
+    oc_canvas_memory_counter memory[OC_CANVAS_MEMORY_CATEGORY_COUNT];
+
+    oc_image_cache imageCache;
+
     oc_canvas_renderer_destroy_proc destroy;
     oc_canvas_renderer_create_surface_for_window_proc createSurfaceForWindow;
     oc_canvas_renderer_image_create_proc imageCreate;
     oc_canvas_renderer_image_destroy_proc imageDestroy;
     oc_canvas_renderer_image_upload_region_proc imageUploadRegion;
+    oc_canvas_renderer_image_upload_done_proc imageUploadDone;
+    oc_canvas_renderer_compressed_format_supported_proc compressedFormatSupported;
+    oc_canvas_renderer_image_create_compressed_proc imageCreateCompressed;
+    oc_canvas_renderer_image_create_render_target_proc imageCreateRenderTarget;
+    oc_canvas_renderer_image_readback_region_proc imageReadbackRegion;
+    oc_canvas_renderer_image_readback_done_proc imageReadbackDone;
+    oc_canvas_renderer_image_readback_get_proc imageReadbackGet;
+    oc_canvas_renderer_image_create_tiled_proc imageCreateTiled;
+    oc_canvas_renderer_tiled_image_requests_proc tiledImageRequests;
+    oc_canvas_renderer_tiled_image_upload_tile_proc tiledImageUploadTile;
+    oc_canvas_renderer_image_create_yuv_proc imageCreateYuv;
+    oc_canvas_renderer_image_upload_yuv_plane_proc imageUploadYuvPlane;
     oc_canvas_renderer_submit_proc submit;
+    oc_canvas_renderer_submit_image_proc submitImage;
+    oc_canvas_renderer_submit_many_proc submitMany;
     oc_canvas_renderer_present_proc present;
+    oc_canvas_renderer_set_present_mode_proc setPresentMode;
+    oc_canvas_renderer_wait_frame_latency_proc waitFrameLatency;
+    oc_canvas_renderer_set_dynamic_scale_proc setDynamicScale;
+    oc_canvas_renderer_get_render_scale_proc getRenderScale;
 
 } oc_canvas_renderer_base;
+
+//NOTE: geometry of tiled images, shared by backends
+u32 oc_tiled_image_level_count_for_size(oc_vec2 size);
+oc_vec2 oc_tiled_image_level_size(oc_vec2 size, u32 level);
+
+//NOTE: layout of the planes of YUV images, shared by backends. Plane sizes are in bytes per row and rows.
+u32 oc_image_yuv_plane_count_for_format(oc_image_yuv_format format);
+oc_vec2 oc_image_yuv_plane_size_for_format(oc_image_yuv_format format, oc_vec2 size, u32 plane);
+
+//NOTE: adds delta bytes to a memory category and to the total, and updates their peaks
+void oc_canvas_renderer_track_memory(oc_canvas_renderer_base* renderer, oc_canvas_memory_category category, i64 delta);
+
+//NOTE: backend constructors, called by oc_canvas_renderer_create_with_options(). They return 0 if the backend can't
+//      be initialized on this machine.
+#if OC_GRAPHICS_ENABLE_CANVAS
+oc_canvas_renderer_base* oc_wgpu_canvas_renderer_create(oc_canvas_renderer_options* options);
+#endif
+
+#if OC_GRAPHICS_ENABLE_CPU_CANVAS
+oc_canvas_renderer_base* oc_cpu_canvas_renderer_create(oc_canvas_renderer_options* options);
+#endif
@@ -0,0 +1,1772 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <math.h>
+#include <float.h>
+
+#include "canvas_renderer.h"
+#include "cpu_surface.h"
+#include "graphics_common.h"
+
+/*NOTE: CPU canvas renderer
+
+    This renderer consumes the same primitive stream as the WebGPU renderer, for machines that don't have a usable GPU.
+
+    Primitives are first encoded on the submitting thread, since fills continue from the pen position of the previous
+    primitive: their elements are transformed to pixels and flattened to lines, and strokes are expanded to polygons in
+    user space before being transformed, so that non-uniform transforms scale their width correctly.
+
+    The target is then split in bands of OC_CPU_CANVAS_BAND_HEIGHT rows, which are rendered in parallel on the job
+    system. Each band walks the paths in order, accumulates the signed area of the lines crossing it, and integrates
+    it along each row to get the coverage of every pixel. Coverage is always analytic, so the MSAA sample count is
+    ignored. Colors are composited back to front into planar float buffers, in premultiplied linear RGB, whose loops
+    have no dependency between pixels so that compilers can vectorize them for the target's SIMD instruction set.
+*/
+
+enum
+{
+    OC_CPU_CANVAS_BAND_HEIGHT = 16,
+    OC_CPU_CANVAS_SRGB_ENCODE_LUT_SIZE = 4096,
+    OC_CPU_CANVAS_MAX_CURVE_LINES = 256,
+    OC_CPU_CANVAS_BUFFER_DEFAULT_LEN = 4096,
+};
+
+static const f32 OC_CPU_CANVAS_TOLERANCE = 0.25; // max distance between curves and their flattened lines, in pixels
+
+typedef struct oc_cpu_image
+{
+    oc_image_base base;
+    u8* pixels; // RGBA8, sRGB encoded, with straight alpha and rows from top to bottom
+    bool renderTarget;
+
+    u8* readback; // copy of the region read back by oc_image_readback_region()
+    oc_rect readbackRegion;
+
+} oc_cpu_image;
+
+typedef struct oc_cpu_line
+{
+    f32 x0;
+    f32 y0;
+    f32 x1;
+    f32 y1;
+
+} oc_cpu_line;
+
+typedef struct oc_cpu_path
+{
+    oc_primitive_cmd cmd; // OC_CMD_FILL, OC_CMD_STROKE, OC_CMD_CLIP_PATH or OC_CMD_CLIP_POP
+    u32 lineStart;
+    u32 lineCount;
+    oc_vec4 box;  // bounds of the lines, in pixels
+    oc_vec4 clip; // clip rect, in pixels
+
+    oc_vec4 color;      // straight linear color
+    bool bilinear;      // blends corners over the path's box
+    oc_vec4 corners[4]; // bottom-left, bottom-right, top-right and top-left straight linear colors
+    oc_mat2x3 uvTransform; // pixel to normalized coordinates in the image or bilinear gradient
+
+    oc_gradient_kind gradientKind; // OC_GRADIENT_LINEAR and OC_GRADIENT_RADIAL blend stops instead of color
+    oc_gradient_blend_space blendSpace;
+    oc_mat2x3 gradientTransform; // pixel to gradient space, see oc_wgpu_canvas_push_gradient()
+    u32 stopCount;
+    f32 stopOffsets[OC_GRADIENT_MAX_STOPS];
+    oc_vec4 stopColors[OC_GRADIENT_MAX_STOPS]; // straight colors, in the blend space
+
+    oc_cpu_image* image;
+
+} oc_cpu_path;
+
+typedef struct oc_cpu_stroke_point
+{
+    oc_vec2 p;
+    bool elementEnd; // joints at element ends use the stroke's joint type, the others are bevels
+
+} oc_cpu_stroke_point;
+
+typedef struct oc_cpu_canvas_renderer
+{
+    oc_canvas_renderer_base base;
+
+    oc_cpu_path* paths;
+    u32 pathCount;
+    u32 pathCap;
+
+    oc_cpu_line* lines;
+    u32 lineCount;
+    u32 lineCap;
+
+    oc_cpu_stroke_point* strokePoints;
+    u32 strokePointCount;
+    u32 strokePointCap;
+
+    u64 lastSurface; // surface rendered by the last submit, which can be partially redrawn
+
+    f32 srgbDecode[256];
+    f32 srgbEncode[OC_CPU_CANVAS_SRGB_ENCODE_LUT_SIZE];
+
+} oc_cpu_canvas_renderer;
+
+//NOTE: state of the primitive being encoded
+typedef struct oc_cpu_canvas_encoder
+{
+    oc_cpu_canvas_renderer* renderer;
+    oc_attributes* attributes;
+    oc_mat2x3 userToPixel;
+    oc_vec2 scale;
+    oc_cpu_path* path;
+    oc_vec4 userExtents;
+
+} oc_cpu_canvas_encoder;
+
+typedef struct oc_cpu_canvas_frame
+{
+    oc_cpu_canvas_renderer* renderer;
+    u32 width;
+    u32 height;
+
+    //NOTE: region of the target that is redrawn, in pixels
+    i32 x0;
+    i32 y0;
+    i32 x1;
+    i32 y1;
+
+    oc_vec4 clearColor; // what the canvas is composited over if the target isn't loaded
+    bool load;          // composite over the previous contents of the target instead
+
+    u32* surfacePixels; // premultiplied BGRA8
+    u8* imagePixels;    // straight RGBA8
+
+} oc_cpu_canvas_frame;
+
+//------------------------------------------------------------------------------------------------
+// Buffers
+//------------------------------------------------------------------------------------------------
+
+static bool oc_cpu_canvas_reserve(oc_cpu_canvas_renderer* renderer, void** buffer, u32* cap, u64 minCap, u64 eltSize)
+{
+    if(minCap <= *cap)
+    {
+        return (true);
+    }
+
+    u64 newCap = oc_max(OC_CPU_CANVAS_BUFFER_DEFAULT_LEN, *cap);
+    while(newCap < minCap)
+    {
+        newCap = newCap * 3 / 2;
+    }
+    if(newCap > UINT32_MAX)
+    {
+        oc_log_error("CPU canvas buffer exceeds 2^32 elements\n");
+        return (false);
+    }
+
+    void* newBuffer = realloc(*buffer, newCap * eltSize);
+    if(!newBuffer)
+    {
+        oc_log_error("couldn't grow CPU canvas buffer to %llu elements\n", (unsigned long long)newCap);
+        return (false);
+    }
+    oc_canvas_renderer_track_memory(&renderer->base, OC_CANVAS_MEMORY_PATH_BUFFERS, (i64)((newCap - *cap) * eltSize));
+    *buffer = newBuffer;
+    *cap = newCap;
+    return (true);
+}
+
+static oc_cpu_path* oc_cpu_canvas_push_path(oc_cpu_canvas_renderer* renderer)
+{
+    if(!oc_cpu_canvas_reserve(renderer, (void**)&renderer->paths, &renderer->pathCap, renderer->pathCount + 1, sizeof(oc_cpu_path)))
+    {
+        return (0);
+    }
+    oc_cpu_path* path = &renderer->paths[renderer->pathCount];
+    renderer->pathCount++;
+
+    memset(path, 0, sizeof(oc_cpu_path));
+    path->lineStart = renderer->lineCount;
+    path->box = (oc_vec4){ FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+    return (path);
+}
+
+static void oc_cpu_canvas_push_line(oc_cpu_canvas_encoder* encoder, oc_vec2 p0, oc_vec2 p1)
+{
+    oc_cpu_canvas_renderer* renderer = encoder->renderer;
+
+    //NOTE: horizontal lines don't change the winding of any pixel
+    if(p0.y == p1.y
+       || !oc_cpu_canvas_reserve(renderer, (void**)&renderer->lines, &renderer->lineCap, renderer->lineCount + 1, sizeof(oc_cpu_line)))
+    {
+        return;
+    }
+    renderer->lines[renderer->lineCount] = (oc_cpu_line){ p0.x, p0.y, p1.x, p1.y };
+    renderer->lineCount++;
+
+    oc_cpu_path* path = encoder->path;
+    path->lineCount++;
+    path->box.x = oc_min(path->box.x, oc_min(p0.x, p1.x));
+    path->box.y = oc_min(path->box.y, oc_min(p0.y, p1.y));
+    path->box.z = oc_max(path->box.z, oc_max(p0.x, p1.x));
+    path->box.w = oc_max(path->box.w, oc_max(p0.y, p1.y));
+}
+
+static void oc_cpu_canvas_update_user_extents(oc_cpu_canvas_encoder* encoder, oc_vec2 p)
+{
+    encoder->userExtents.x = oc_min(encoder->userExtents.x, p.x);
+    encoder->userExtents.y = oc_min(encoder->userExtents.y, p.y);
+    encoder->userExtents.z = oc_max(encoder->userExtents.z, p.x);
+    encoder->userExtents.w = oc_max(encoder->userExtents.w, p.y);
+}
+
+//------------------------------------------------------------------------------------------------
+// Flattening
+//------------------------------------------------------------------------------------------------
+
+static oc_vec2 oc_cpu_bezier_point(oc_path_elt_type type, oc_vec2* p, f32 t)
+{
+    f32 s = 1 - t;
+    oc_vec2 r;
+    if(type == OC_PATH_QUADRATIC)
+    {
+        r.x = s * s * p[0].x + 2 * s * t * p[1].x + t * t * p[2].x;
+        r.y = s * s * p[0].y + 2 * s * t * p[1].y + t * t * p[2].y;
+    }
+    else
+    {
+        r.x = s * s * s * p[0].x + 3 * s * s * t * p[1].x + 3 * s * t * t * p[2].x + t * t * t * p[3].x;
+        r.y = s * s * s * p[0].y + 3 * s * s * t * p[1].y + 3 * s * t * t * p[2].y + t * t * t * p[3].y;
+    }
+    return (r);
+}
+
+static u32 oc_cpu_bezier_line_count(oc_path_elt_type type, oc_vec2* p, f32 tolerance)
+{
+    //NOTE: Wang's formula, the number of lines needed to stay within tolerance of the curve
+    f32 dd = 0;
+    f32 factor = 0;
+    if(type == OC_PATH_QUADRATIC)
+    {
+        dd = sqrtf(oc_square(p[0].x - 2 * p[1].x + p[2].x) + oc_square(p[0].y - 2 * p[1].y + p[2].y));
+        factor = 0.25;
+    }
+    else
+    {
+        f32 dd0 = sqrtf(oc_square(p[0].x - 2 * p[1].x + p[2].x) + oc_square(p[0].y - 2 * p[1].y + p[2].y));
+        f32 dd1 = sqrtf(oc_square(p[1].x - 2 * p[2].x + p[3].x) + oc_square(p[1].y - 2 * p[2].y + p[3].y));
+        dd = oc_max(dd0, dd1);
+        factor = 0.75;
+    }
+    f32 count = ceilf(sqrtf(factor * dd / tolerance));
+    //NOTE: also catches NaNs from degenerate transforms
+    if(!(count >= 1))
+    {
+        return (1);
+    }
+    return ((u32)oc_min(count, OC_CPU_CANVAS_MAX_CURVE_LINES));
+}
+
+static oc_vec2 oc_cpu_path_elt_end_point(oc_path_elt* elt)
+{
+    oc_vec2 p = { 0 };
+    switch(elt->type)
+    {
+        case OC_PATH_MOVE:
+        case OC_PATH_LINE:
+            p = elt->p[0];
+            break;
+
+        case OC_PATH_QUADRATIC:
+            p = elt->p[1];
+            break;
+
+        case OC_PATH_CUBIC:
+            p = elt->p[2];
+            break;
+    }
+    return (p);
+}
+
+static void oc_cpu_canvas_fill_element(oc_cpu_canvas_encoder* encoder, oc_path_elt_type type, oc_vec2* userPoints)
+{
+    oc_vec2 p[4];
+    int count = (type == OC_PATH_LINE) ? 2 : ((type == OC_PATH_QUADRATIC) ? 3 : 4);
+    for(int i = 0; i < count; i++)
+    {
+        oc_cpu_canvas_update_user_extents(encoder, userPoints[i]);
+        p[i] = oc_mat2x3_mul(encoder->userToPixel, userPoints[i]);
+    }
+
+    if(type == OC_PATH_LINE)
+    {
+        oc_cpu_canvas_push_line(encoder, p[0], p[1]);
+    }
+    else
+    {
+        //NOTE: curves are flattened in pixels, where the tolerance is defined
+        u32 lineCount = oc_cpu_bezier_line_count(type, p, OC_CPU_CANVAS_TOLERANCE);
+        oc_vec2 prev = p[0];
+        for(u32 i = 1; i <= lineCount; i++)
+        {
+            oc_vec2 next = (i == lineCount) ? p[count - 1] : oc_cpu_bezier_point(type, p, (f32)i / lineCount);
+            oc_cpu_canvas_push_line(encoder, prev, next);
+            prev = next;
+        }
+    }
+}
+
+static void oc_cpu_canvas_encode_fill(oc_cpu_canvas_encoder* encoder,
+                                      oc_path_elt* elements,
+                                      u32 eltCount,
+                                      oc_vec2* currentPos)
+{
+    //NOTE: subpaths are closed implicitly, which also keeps the winding consistent in paths that don't close them
+    oc_vec2 subpathStart = *currentPos;
+    for(u32 eltIndex = 0; eltIndex < eltCount; eltIndex++)
+    {
+        oc_path_elt* elt = &elements[eltIndex];
+        if(elt->type == OC_PATH_MOVE)
+        {
+            oc_vec2 closing[2] = { *currentPos, subpathStart };
+            oc_cpu_canvas_fill_element(encoder, OC_PATH_LINE, closing);
+
+            subpathStart = elt->p[0];
+            *currentPos = elt->p[0];
+        }
+        else
+        {
+            oc_vec2 p[4] = { *currentPos, elt->p[0], elt->p[1], elt->p[2] };
+            oc_cpu_canvas_fill_element(encoder, elt->type, p);
+            *currentPos = oc_cpu_path_elt_end_point(elt);
+        }
+    }
+    oc_vec2 closing[2] = { *currentPos, subpathStart };
+    oc_cpu_canvas_fill_element(encoder, OC_PATH_LINE, closing);
+}
+
+//------------------------------------------------------------------------------------------------
+// Strokes
+//------------------------------------------------------------------------------------------------
+
+static void oc_cpu_canvas_stroke_polygon(oc_cpu_canvas_encoder* encoder, u32 count, oc_vec2* points)
+{
+    //NOTE: stroke polygons are filled with the non-zero rule, so they must all have the same orientation for their
+    //      overlaps to add up instead of cancelling out
+    f32 area = 0;
+    for(u32 i = 0; i < count; i++)
+    {
+        oc_vec2 a = points[i];
+        oc_vec2 b = points[(i + 1) % count];
+        area += a.x * b.y - b.x * a.y;
+    }
+
+    oc_vec2 p[8];
+    for(u32 i = 0; i < count; i++)
+    {
+        u32 index = (area >= 0) ? i : count - 1 - i;
+        oc_cpu_canvas_update_user_extents(encoder, points[index]);
+        p[i] = oc_mat2x3_mul(encoder->userToPixel, points[index]);
+    }
+    for(u32 i = 0; i < count; i++)
+    {
+        oc_cpu_canvas_push_line(encoder, p[i], p[(i + 1) % count]);
+    }
+}
+
+static void oc_cpu_canvas_stroke_joint(oc_cpu_canvas_encoder* encoder, oc_vec2 p0, oc_vec2 t0, oc_vec2 t1, oc_joint_type joint)
+{
+    oc_attributes* attributes = encoder->attributes;
+
+    f32 norm_t0 = sqrtf(oc_square(t0.x) + oc_square(t0.y));
+    f32 norm_t1 = sqrtf(oc_square(t1.x) + oc_square(t1.y));
+
+    oc_vec2 n0 = { -t0.y / norm_t0, t0.x / norm_t0 };
+    oc_vec2 n1 = { -t1.y / norm_t1, t1.x / norm_t1 };
+
+    //NOTE: flip the normals so that they face outwards of the angle, like oc_wgpu_stroke_joint()
+    f32 crossZ = n0.x * n1.y - n0.y * n1.x;
+    if(crossZ > 0)
+    {
+        n0 = (oc_vec2){ -n0.x, -n0.y };
+        n1 = (oc_vec2){ -n1.x, -n1.y };
+    }
+    if(fabsf(crossZ) < 1e-6 && n0.x * n1.x + n0.y * n1.y > 0)
+    {
+        //NOTE: the segments are aligned, there is no gap to fill
+        return;
+    }
+
+    f32 halfW = 0.5 * attributes->width;
+    oc_vec2 u = { n0.x + n1.x, n0.y + n1.y };
+    f32 uNormSquare = u.x * u.x + u.y * u.y;
+    f32 alpha = attributes->width / uNormSquare;
+    oc_vec2 v = { u.x * alpha, u.y * alpha };
+
+    f32 excursionSquare = uNormSquare * oc_square(alpha - attributes->width / 4);
+
+    if(joint == OC_JOINT_MITER
+       && uNormSquare > 0
+       && excursionSquare <= oc_square(attributes->maxJointExcursion))
+    {
+        oc_vec2 points[] = { p0,
+                             { p0.x + n0.x * halfW, p0.y + n0.y * halfW },
+                             { p0.x + v.x, p0.y + v.y },
+                             { p0.x + n1.x * halfW, p0.y + n1.y * halfW } };
+        oc_cpu_canvas_stroke_polygon(encoder, 4, points);
+    }
+    else
+    {
+        oc_vec2 points[] = { p0,
+                             { p0.x + n0.x * halfW, p0.y + n0.y * halfW },
+                             { p0.x + n1.x * halfW, p0.y + n1.y * halfW } };
+        oc_cpu_canvas_stroke_polygon(encoder, 3, points);
+    }
+}
+
+static void oc_cpu_canvas_stroke_cap(oc_cpu_canvas_encoder* encoder, oc_vec2 p0, oc_vec2 direction)
+{
+    f32 dn = sqrtf(oc_square(direction.x) + oc_square(direction.y));
+    f32 alpha = 0.5 * encoder->attributes->width / dn;
+
+    oc_vec2 n0 = { -alpha * direction.y, alpha * direction.x };
+    oc_vec2 m0 = { alpha * direction.x, alpha * direction.y };
+
+    oc_vec2 points[] = { { p0.x + n0.x, p0.y + n0.y },
+                         { p0.x + n0.x + m0.x, p0.y + n0.y + m0.y },
+                         { p0.x - n0.x + m0.x, p0.y - n0.y + m0.y },
+                         { p0.x - n0.x, p0.y - n0.y } };
+    oc_cpu_canvas_stroke_polygon(encoder, 4, points);
+}
+
+static void oc_cpu_canvas_push_stroke_point(oc_cpu_canvas_renderer* renderer, oc_vec2 p, bool elementEnd)
+{
+    //NOTE: coincident points would give null tangents
+    if(renderer->strokePointCount)
+    {
+        oc_cpu_stroke_point* last = &renderer->strokePoints[renderer->strokePointCount - 1];
+        if(last->p.x == p.x && last->p.y == p.y)
+        {
+            last->elementEnd |= elementEnd;
+            return;
+        }
+    }
+    if(oc_cpu_canvas_reserve(renderer,
+                             (void**)&renderer->strokePoints,
+                             &renderer->strokePointCap,
+                             renderer->strokePointCount + 1,
+                             sizeof(oc_cpu_stroke_point)))
+    {
+        renderer->strokePoints[renderer->strokePointCount] = (oc_cpu_stroke_point){ p, elementEnd };
+        renderer->strokePointCount++;
+    }
+}
+
+static void oc_cpu_canvas_stroke_subpath(oc_cpu_canvas_encoder* encoder, u32 elementCount)
+{
+    oc_cpu_canvas_renderer* renderer = encoder->renderer;
+    oc_attributes* attributes = encoder->attributes;
+    oc_cpu_stroke_point* points = renderer->strokePoints;
+    u32 count = renderer->strokePointCount;
+
+    if(count < 2)
+    {
+        return;
+    }
+    f32 halfW = 0.5 * attributes->width;
+
+    for(u32 i = 0; i + 1 < count; i++)
+    {
+        oc_vec2 a = points[i].p;
+        oc_vec2 b = points[i + 1].p;
+        oc_vec2 d = { b.x - a.x, b.y - a.y };
+        f32 len = sqrtf(d.x * d.x + d.y * d.y);
+        oc_vec2 n = { -d.y * halfW / len, d.x * halfW / len };
+
+        oc_vec2 quad[] = { { a.x + n.x, a.y + n.y },
+                           { b.x + n.x, b.y + n.y },
+                           { b.x - n.x, b.y - n.y },
+                           { a.x - n.x, a.y - n.y } };
+        oc_cpu_canvas_stroke_polygon(encoder, 4, quad);
+
+        if(i > 0)
+        {
+            //NOTE: points inside flattened curves always get bevels, so that the outline has no gaps
+            oc_vec2 prev = points[i - 1].p;
+            oc_vec2 t0 = { a.x - prev.x, a.y - prev.y };
+            if(!points[i].elementEnd)
+            {
+                oc_cpu_canvas_stroke_joint(encoder, a, t0, d, OC_JOINT_BEVEL);
+            }
+            else if(attributes->joint != OC_JOINT_NONE)
+            {
+                oc_cpu_canvas_stroke_joint(encoder, a, t0, d, attributes->joint);
+            }
+        }
+    }
+
+    oc_vec2 start = points[0].p;
+    oc_vec2 end = points[count - 1].p;
+    oc_vec2 startTangent = { points[1].p.x - start.x, points[1].p.y - start.y };
+    oc_vec2 endTangent = { end.x - points[count - 2].p.x, end.y - points[count - 2].p.y };
+
+    //NOTE: like oc_wgpu_encode_stroke_subpath(), closed subpaths of at least two elements get a closing joint, and
+    //      the others get caps
+    if(elementCount > 1 && start.x == end.x && start.y == end.y)
+    {
+        if(attributes->joint != OC_JOINT_NONE)
+        {
+            oc_cpu_canvas_stroke_joint(encoder, end, endTangent, startTangent, attributes->joint);
+        }
+    }
+    else if(attributes->cap == OC_CAP_SQUARE)
+    {
+        oc_cpu_canvas_stroke_cap(encoder, start, (oc_vec2){ -startTangent.x, -startTangent.y });
+        oc_cpu_canvas_stroke_cap(encoder, end, endTangent);
+    }
+}
+
+static void oc_cpu_canvas_encode_stroke(oc_cpu_canvas_encoder* encoder, oc_path_elt* elements, u32 eltCount, oc_vec2 startPoint)
+{
+    oc_cpu_canvas_renderer* renderer = encoder->renderer;
+
+    //NOTE: curves are flattened in user space, with the tolerance scaled by the largest stretch of the transform
+    oc_mat2x3 m = encoder->userToPixel;
+    f32 stretch = sqrtf(oc_max(m.m[0] * m.m[0] + m.m[3] * m.m[3], m.m[1] * m.m[1] + m.m[4] * m.m[4]));
+    f32 tolerance = OC_CPU_CANVAS_TOLERANCE / oc_max(stretch, 1e-6);
+
+    oc_vec2 currentPoint = startPoint;
+    u32 eltIndex = 0;
+    while(eltIndex < eltCount)
+    {
+        while(eltIndex < eltCount && elements[eltIndex].type == OC_PATH_MOVE)
+        {
+            currentPoint = elements[eltIndex].p[0];
+            eltIndex++;
+        }
+
+        renderer->strokePointCount = 0;
+        oc_cpu_canvas_push_stroke_point(renderer, currentPoint, true);
+
+        u32 subpathEltCount = 0;
+        while(eltIndex < eltCount && elements[eltIndex].type != OC_PATH_MOVE)
+        {
+            oc_path_elt* elt = &elements[eltIndex];
+            oc_vec2 p[4] = { currentPoint, elt->p[0], elt->p[1], elt->p[2] };
+
+            if(elt->type == OC_PATH_LINE)
+            {
+                oc_cpu_canvas_push_stroke_point(renderer, p[1], true);
+            }
+            else
+            {
+                int count = (elt->type == OC_PATH_QUADRATIC) ? 3 : 4;
+                u32 lineCount = oc_cpu_bezier_line_count(elt->type, p, tolerance);
+                for(u32 i = 1; i < lineCount; i++)
+                {
+                    oc_cpu_canvas_push_stroke_point(renderer, oc_cpu_bezier_point(elt->type, p, (f32)i / lineCount), false);
+                }
+                oc_cpu_canvas_push_stroke_point(renderer, p[count - 1], true);
+            }
+            currentPoint = oc_cpu_path_elt_end_point(elt);
+            subpathEltCount++;
+            eltIndex++;
+        }
+        oc_cpu_canvas_stroke_subpath(encoder, subpathEltCount);
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+// Encoding
+//------------------------------------------------------------------------------------------------
+
+static void oc_cpu_canvas_encode_paint(oc_cpu_canvas_encoder* encoder)
+{
+    //NOTE: mirrors the paint setup of oc_wgpu_canvas_encode_path() and oc_wgpu_canvas_push_gradient()
+    oc_cpu_canvas_renderer* renderer = encoder->renderer;
+    oc_attributes* attributes = encoder->attributes;
+    oc_cpu_path* path = encoder->path;
+
+    oc_color colors[4];
+    for(int i = 0; i < 4; i++)
+    {
+        colors[i] = oc_color_convert(attributes->colors[i], OC_COLOR_SPACE_RGB);
+    }
+    path->color = (oc_vec4){ colors[0].r, colors[0].g, colors[0].b, colors[0].a };
+    path->blendSpace = attributes->blendSpace;
+    path->gradientKind = OC_GRADIENT_BILINEAR;
+
+    oc_mat2x3 pixelToUser = oc_mat2x3_inv(encoder->userToPixel);
+
+    if(attributes->hasGradient && attributes->gradientKind == OC_GRADIENT_BILINEAR)
+    {
+        path->bilinear = true;
+        for(int i = 0; i < 4; i++)
+        {
+            path->corners[i] = (oc_vec4){ colors[i].r, colors[i].g, colors[i].b, colors[i].a };
+        }
+    }
+    else if(attributes->hasGradient)
+    {
+        oc_vec2 p0 = attributes->gradientPoints[0];
+        oc_vec2 p1 = attributes->gradientPoints[1];
+        oc_mat2x3 userToGradient = { 0, 0, 1,
+                                     0, 0, 0 };
+
+        if(attributes->gradientKind == OC_GRADIENT_LINEAR)
+        {
+            oc_vec2 d = { p1.x - p0.x, p1.y - p0.y };
+            f32 lenSquared = d.x * d.x + d.y * d.y;
+            if(lenSquared > 0)
+            {
+                userToGradient = (oc_mat2x3){ d.x / lenSquared, d.y / lenSquared, -(p0.x * d.x + p0.y * d.y) / lenSquared,
+                                              0, 0, 0 };
+            }
+        }
+        else
+        {
+            f32 radius = p1.x;
+            if(radius > 0)
+            {
+                userToGradient = (oc_mat2x3){ 1 / radius, 0, -p0.x / radius,
+                                              0, 1 / radius, -p0.y / radius };
+            }
+        }
+        path->gradientKind = attributes->gradientKind;
+        path->gradientTransform = oc_mat2x3_mul_m(userToGradient, pixelToUser);
+        path->stopCount = attributes->gradientStopCount;
+
+        for(u32 i = 0; i < attributes->gradientStopCount; i++)
+        {
+            oc_color c = oc_color_convert(attributes->gradientStops[i].color, OC_COLOR_SPACE_RGB);
+            if(attributes->blendSpace == OC_GRADIENT_BLEND_SRGB)
+            {
+                for(int j = 0; j < 3; j++)
+                {
+                    c.c[j] = powf(c.c[j], 1 / 2.2);
+                }
+            }
+            path->stopOffsets[i] = attributes->gradientStops[i].offset;
+            path->stopColors[i] = (oc_vec4){ c.r, c.g, c.b, c.a };
+        }
+    }
+
+    if(!oc_image_is_nil(attributes->image))
+    {
+        oc_cpu_image* image = (oc_cpu_image*)oc_image_from_handle(attributes->image);
+        if(image && oc_canvas_renderer_from_handle(image->base.renderer) == &renderer->base && image->pixels)
+        {
+            path->image = image;
+        }
+    }
+
+    if(path->image || path->bilinear)
+    {
+        oc_vec2 texSize = { 1, 1 };
+        oc_rect srcRegion = { 0, 0, 1, 1 };
+        if(path->image)
+        {
+            texSize = path->image->base.size;
+            srcRegion = attributes->srcRegion;
+        }
+
+        oc_rect destRegion = {
+            encoder->userExtents.x,
+            encoder->userExtents.y,
+            encoder->userExtents.z - encoder->userExtents.x,
+            encoder->userExtents.w - encoder->userExtents.y,
+        };
+
+        oc_mat2x3 srcRegionToImage = {
+            1 / texSize.x, 0, srcRegion.x / texSize.x,
+            0, 1 / texSize.y, srcRegion.y / texSize.y
+        };
+        oc_mat2x3 destRegionToSrcRegion = {
+            srcRegion.w / destRegion.w, 0, 0,
+            0, srcRegion.h / destRegion.h, 0
+        };
+        oc_mat2x3 userToDestRegion = {
+            1, 0, -destRegion.x,
+            0, 1, -destRegion.y
+        };
+
+        oc_mat2x3 uvTransform = srcRegionToImage;
+        uvTransform = oc_mat2x3_mul_m(uvTransform, destRegionToSrcRegion);
+        uvTransform = oc_mat2x3_mul_m(uvTransform, userToDestRegion);
+        uvTransform = oc_mat2x3_mul_m(uvTransform, pixelToUser);
+        path->uvTransform = uvTransform;
+    }
+}
+
+static void oc_cpu_canvas_encode_primitive(oc_cpu_canvas_renderer* renderer,
+                                           oc_vec2 scale,
+                                           oc_vec2 targetSize,
+                                           oc_primitive* primitive,
+                                           u32 attributeCount,
+                                           oc_attributes* attributes,
+                                           u32 eltCount,
+                                           oc_path_elt* elements,
+                                           oc_vec2* currentPos)
+{
+    if(primitive->cmd == OC_CMD_JUMP)
+    {
+        return;
+    }
+    if(primitive->attributesIndex >= attributeCount)
+    {
+        oc_log_error("primitive attributes index out of bounds\n");
+        return;
+    }
+
+    oc_cpu_canvas_encoder encoder = {
+        .renderer = renderer,
+        .attributes = &attributes[primitive->attributesIndex],
+        .scale = scale,
+        .userExtents = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX },
+    };
+    oc_mat2x3 scaleM = {
+        scale.x, 0, 0,
+        0, scale.y, 0
+    };
+    encoder.userToPixel = oc_mat2x3_mul_m(scaleM, encoder.attributes->transform);
+
+    oc_rect clip = encoder.attributes->clip;
+    oc_vec4 pixelClip = {
+        oc_max(clip.x * scale.x, 0),
+        oc_max(clip.y * scale.y, 0),
+        oc_min((clip.x + clip.w) * scale.x, targetSize.x),
+        oc_min((clip.y + clip.h) * scale.y, targetSize.y),
+    };
+
+    if(primitive->cmd == OC_CMD_CLIP_POP)
+    {
+        oc_cpu_path* path = oc_cpu_canvas_push_path(renderer);
+        if(path)
+        {
+            path->cmd = OC_CMD_CLIP_POP;
+            path->clip = pixelClip;
+        }
+        return;
+    }
+    if(!primitive->path.count || primitive->path.startIndex >= eltCount)
+    {
+        return;
+    }
+
+    u32 pathEltCount = oc_min(primitive->path.count, eltCount - primitive->path.startIndex);
+    oc_path_elt* pathElements = elements + primitive->path.startIndex;
+
+    encoder.path = oc_cpu_canvas_push_path(renderer);
+    if(!encoder.path)
+    {
+        return;
+    }
+
+    //NOTE: polylines are unpacked into line elements
+    oc_arena_scope scratch = oc_scratch_begin();
+    u32 unpackedCount = oc_path_unpacked_count(pathEltCount, pathElements);
+    if(unpackedCount)
+    {
+        oc_path_elt* unpacked = oc_arena_push_array(scratch.arena, oc_path_elt, unpackedCount);
+        oc_path_unpack(pathEltCount, pathElements, unpacked);
+        pathElements = unpacked;
+        pathEltCount = unpackedCount;
+    }
+    oc_cpu_path* path = encoder.path;
+    path->clip = pixelClip;
+
+    if(primitive->cmd == OC_CMD_STROKE)
+    {
+        path->cmd = OC_CMD_STROKE;
+        oc_cpu_canvas_encode_stroke(&encoder, pathElements, pathEltCount, primitive->path.startPoint);
+    }
+    else
+    {
+        //NOTE: rects, rounded rects and glyphs are filled from their elements like any other path
+        path->cmd = (primitive->cmd == OC_CMD_CLIP_PATH) ? OC_CMD_CLIP_PATH : OC_CMD_FILL;
+        oc_cpu_canvas_encode_fill(&encoder, pathElements, pathEltCount, currentPos);
+    }
+    oc_scratch_end(scratch);
+
+    //NOTE: drop paths that are entirely clipped. Clip paths are kept, since they mask everything up to their marker.
+    bool visible = path->lineCount
+                && path->box.x < path->clip.z
+                && path->box.z > path->clip.x
+                && path->box.y < path->clip.w
+                && path->box.w > path->clip.y;
+
+    if(!visible && path->cmd != OC_CMD_CLIP_PATH)
+    {
+        renderer->lineCount = path->lineStart;
+        renderer->pathCount--;
+        return;
+    }
+    if(path->cmd != OC_CMD_CLIP_PATH)
+    {
+        oc_cpu_canvas_encode_paint(&encoder);
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+// Rasterization
+//------------------------------------------------------------------------------------------------
+
+static void oc_cpu_canvas_accumulate_line(f32* area, u32 stride, u32 width, u32 height, oc_cpu_line* line, f32 dx, f32 dy)
+{
+    /*NOTE: accumulates the signed area covered by a line in each cell of the rows it crosses, like font-rs does.
+            Summing the cells of a row from left to right then gives the winding of each pixel, weighted by the
+            fraction of the pixel that is covered. Lines are clamped to [0, width] horizontally in each row: the part
+            of a line left of the span still covers the whole row to its right, and the part right of it covers
+            nothing inside the span.
+    */
+    f32 x0 = line->x0 + dx;
+    f32 y0 = line->y0 + dy;
+    f32 x1 = line->x1 + dx;
+    f32 y1 = line->y1 + dy;
+    f32 dir = 1;
+
+    if(y0 > y1)
+    {
+        f32 tmp = x0;
+        x0 = x1;
+        x1 = tmp;
+        tmp = y0;
+        y0 = y1;
+        y1 = tmp;
+        dir = -1;
+    }
+    f32 dxdy = (x1 - x0) / (y1 - y0);
+    f32 x = x0;
+    if(y0 < 0)
+    {
+        x -= y0 * dxdy;
+    }
+
+    i32 rowStart = oc_max((i32)floorf(y0), 0);
+    i32 rowEnd = oc_min((i32)ceilf(y1), (i32)height);
+
+    for(i32 y = rowStart; y < rowEnd; y++)
+    {
+        f32 rowDy = oc_min((f32)(y + 1), y1) - oc_max((f32)y, y0);
+        f32 xNext = x + dxdy * rowDy;
+        f32 d = rowDy * dir;
+
+        f32 xa = oc_clamp(oc_min(x, xNext), 0, (f32)width);
+        f32 xb = oc_clamp(oc_max(x, xNext), 0, (f32)width);
+
+        f32* row = area + y * stride;
+        f32 xaFloor = floorf(xa);
+        i32 ia = (i32)xaFloor;
+        f32 xbCeil = ceilf(xb);
+        i32 ib = (i32)xbCeil;
+
+        if(ib <= ia + 1)
+        {
+            f32 xm = 0.5 * (xa + xb) - xaFloor;
+            row[ia] += d - d * xm;
+            row[ia + 1] += d * xm;
+        }
+        else
+        {
+            f32 s = 1 / (xb - xa);
+            f32 xaf = xa - xaFloor;
+            f32 a0 = 0.5 * s * (1 - xaf) * (1 - xaf);
+            f32 xbf = xb - xbCeil + 1;
+            f32 am = 0.5 * s * xbf * xbf;
+
+            row[ia] += d * a0;
+            if(ib == ia + 2)
+            {
+                row[ia + 1] += d * (1 - a0 - am);
+            }
+            else
+            {
+                f32 a1 = s * (1.5 - xaf);
+                row[ia + 1] += d * (a1 - a0);
+                for(i32 xi = ia + 2; xi < ib - 1; xi++)
+                {
+                    row[xi] += d * s;
+                }
+                f32 a2 = a1 + (ib - ia - 3) * s;
+                row[ib - 1] += d * (1 - a2 - am);
+            }
+            row[ib] += d * am;
+        }
+        x = xNext;
+    }
+}
+
+typedef struct oc_cpu_span
+{
+    i32 x0;
+    i32 y0;
+    i32 x1;
+    i32 y1;
+
+} oc_cpu_span;
+
+//NOTE: computes the coverage of a path over its span in the band, with a stride of the span's width. Returns false
+//      if the span is empty.
+static bool oc_cpu_canvas_rasterize(oc_cpu_canvas_frame* frame,
+                                    oc_cpu_path* path,
+                                    i32 bandY0,
+                                    i32 bandY1,
+                                    f32* area,
+                                    f32* coverage,
+                                    oc_cpu_span* span)
+{
+    oc_cpu_canvas_renderer* renderer = frame->renderer;
+
+    span->x0 = oc_max((i32)floorf(oc_max(path->box.x, path->clip.x)), frame->x0);
+    span->y0 = oc_max((i32)floorf(oc_max(path->box.y, path->clip.y)), bandY0);
+    span->x1 = oc_min((i32)ceilf(oc_min(path->box.z, path->clip.z)), frame->x1);
+    span->y1 = oc_min((i32)ceilf(oc_min(path->box.w, path->clip.w)), bandY1);
+
+    if(span->x0 >= span->x1 || span->y0 >= span->y1)
+    {
+        return (false);
+    }
+
+    u32 width = span->x1 - span->x0;
+    u32 height = span->y1 - span->y0;
+    u32 stride = width + 2;
+    memset(area, 0, stride * height * sizeof(f32));
+
+    for(u32 lineIndex = 0; lineIndex < path->lineCount; lineIndex++)
+    {
+        oc_cpu_line* line = &renderer->lines[path->lineStart + lineIndex];
+        if(oc_max(line->y0, line->y1) <= span->y0
+           || oc_min(line->y0, line->y1) >= span->y1
+           || oc_min(line->x0, line->x1) >= span->x1)
+        {
+            continue;
+        }
+        oc_cpu_canvas_accumulate_line(area, stride, width, height, line, -span->x0, -span->y0);
+    }
+
+    //NOTE: fractional overlap of the edge pixels with the clip rect
+    f32 clipX0 = path->clip.x - span->x0;
+    f32 clipX1 = path->clip.z - span->x0;
+
+    bool nonZero = (path->cmd == OC_CMD_STROKE);
+
+    for(u32 y = 0; y < height; y++)
+    {
+        f32 py = span->y0 + y;
+        f32 clipY = oc_clamp(oc_min(py + 1, path->clip.w) - oc_max(py, path->clip.y), 0, 1);
+
+        f32* row = area + y * stride;
+        f32* out = coverage + y * width;
+        f32 winding = 0;
+        for(u32 x = 0; x < width; x++)
+        {
+            winding += row[x];
+            f32 c;
+            if(nonZero)
+            {
+                c = fabsf(winding);
+            }
+            else
+            {
+                c = fabsf(winding - 2 * roundf(0.5 * winding));
+            }
+            out[x] = oc_min(c, 1) * clipY;
+        }
+        out[0] *= oc_clamp(oc_min(1, clipX1) - oc_max(0, clipX0), 0, 1);
+        out[width - 1] *= oc_clamp(oc_min((f32)width, clipX1) - oc_max((f32)(width - 1), clipX0), 0, 1);
+    }
+    return (true);
+}
+
+//------------------------------------------------------------------------------------------------
+// Shading and compositing
+//------------------------------------------------------------------------------------------------
+
+static oc_vec4 oc_cpu_vec4_mix(oc_vec4 a, oc_vec4 b, f32 t)
+{
+    return ((oc_vec4){ a.x + (b.x - a.x) * t,
+                       a.y + (b.y - a.y) * t,
+                       a.z + (b.z - a.z) * t,
+                       a.w + (b.w - a.w) * t });
+}
+
+static oc_vec4 oc_cpu_srgb_to_linear(oc_vec4 c)
+{
+    return ((oc_vec4){ powf(c.x, 2.2), powf(c.y, 2.2), powf(c.z, 2.2), c.w });
+}
+
+static oc_vec4 oc_cpu_canvas_sample_image(oc_cpu_canvas_renderer* renderer, oc_cpu_image* image, f32 u, f32 v)
+{
+    //NOTE: bilinear filtering with clamp to edge, on decoded texels, like the WebGPU sampler
+    i32 w = image->base.size.x;
+    i32 h = image->base.size.y;
+    f32 x = oc_clamp(u * w - 0.5, -1, w);
+    f32 y = oc_clamp(v * h - 0.5, -1, h);
+    f32 fx = floorf(x);
+    f32 fy = floorf(y);
+    f32 tx = x - fx;
+    f32 ty = y - fy;
+
+    i32 xs[2] = { oc_clamp((i32)fx, 0, w - 1), oc_clamp((i32)fx + 1, 0, w - 1) };
+    i32 ys[2] = { oc_clamp((i32)fy, 0, h - 1), oc_clamp((i32)fy + 1, 0, h - 1) };
+
+    oc_vec4 texels[4];
+    for(int i = 0; i < 4; i++)
+    {
+        u8* t = image->pixels + ((u64)ys[i / 2] * w + xs[i % 2]) * 4;
+        texels[i] = (oc_vec4){ renderer->srgbDecode[t[0]],
+                               renderer->srgbDecode[t[1]],
+                               renderer->srgbDecode[t[2]],
+                               t[3] / 255.f };
+    }
+    oc_vec4 top = oc_cpu_vec4_mix(texels[0], texels[1], tx);
+    oc_vec4 bottom = oc_cpu_vec4_mix(texels[2], texels[3], tx);
+    return (oc_cpu_vec4_mix(top, bottom, ty));
+}
+
+static oc_vec4 oc_cpu_canvas_shade(oc_cpu_canvas_renderer* renderer, oc_cpu_path* path, oc_vec2 p)
+{
+    //NOTE: returns the premultiplied linear color of the path at pixel center p, like get_next_color() in raster.wgsl
+    oc_vec4 color = path->color;
+
+    if(path->gradientKind != OC_GRADIENT_BILINEAR)
+    {
+        oc_vec2 q = oc_mat2x3_mul(path->gradientTransform, p);
+        f32 t = (path->gradientKind == OC_GRADIENT_RADIAL) ? sqrtf(q.x * q.x + q.y * q.y) : q.x;
+
+        color = path->stopCount ? path->stopColors[0] : (oc_vec4){ 0 };
+        for(u32 i = 1; i < path->stopCount; i++)
+        {
+            f32 o0 = path->stopOffsets[i - 1];
+            f32 o1 = path->stopOffsets[i];
+            if(t > o0)
+            {
+                f32 f = (o1 > o0) ? oc_clamp((t - o0) / (o1 - o0), 0, 1) : 1;
+                color = oc_cpu_vec4_mix(path->stopColors[i - 1], path->stopColors[i], f);
+            }
+        }
+        if(path->blendSpace == OC_GRADIENT_BLEND_SRGB)
+        {
+            color = oc_cpu_srgb_to_linear(color);
+        }
+    }
+    else if(path->bilinear)
+    {
+        oc_vec4 bl = path->corners[0];
+        oc_vec4 br = path->corners[1];
+        oc_vec4 tr = path->corners[2];
+        oc_vec4 tl = path->corners[3];
+
+        if(path->blendSpace == OC_GRADIENT_BLEND_SRGB)
+        {
+            oc_vec4* corners[4] = { &bl, &br, &tr, &tl };
+            for(int i = 0; i < 4; i++)
+            {
+                *corners[i] = (oc_vec4){ powf(corners[i]->x, 1 / 2.2), powf(corners[i]->y, 1 / 2.2), powf(corners[i]->z, 1 / 2.2), corners[i]->w };
+            }
+        }
+        oc_vec2 uv = oc_mat2x3_mul(path->uvTransform, p);
+        oc_vec4 bottom = oc_cpu_vec4_mix(bl, br, uv.x);
+        oc_vec4 top = oc_cpu_vec4_mix(tl, tr, uv.x);
+        color = oc_cpu_vec4_mix(top, bottom, uv.y);
+
+        if(path->blendSpace == OC_GRADIENT_BLEND_SRGB)
+        {
+            color = oc_cpu_srgb_to_linear(color);
+        }
+    }
+
+    color = (oc_vec4){ color.x * color.w, color.y * color.w, color.z * color.w, color.w };
+
+    if(path->image)
+    {
+        oc_vec2 uv = oc_mat2x3_mul(path->uvTransform, p);
+        oc_vec4 tex = oc_cpu_canvas_sample_image(renderer, path->image, uv.x, uv.y);
+        color = (oc_vec4){ color.x * tex.x * tex.w,
+                           color.y * tex.y * tex.w,
+                           color.z * tex.z * tex.w,
+                           color.w * tex.w };
+    }
+    return (color);
+}
+
+//NOTE: color buffers are planar, with one plane of premultiplied linear floats per channel
+typedef struct oc_cpu_color_buffer
+{
+    f32* c[4];
+
+} oc_cpu_color_buffer;
+
+static void oc_cpu_canvas_composite_solid(f32* restrict r,
+                                          f32* restrict g,
+                                          f32* restrict b,
+                                          f32* restrict a,
+                                          const f32* restrict coverage,
+                                          u32 count,
+                                          oc_vec4 color)
+{
+    for(u32 i = 0; i < count; i++)
+    {
+        f32 c = coverage[i];
+        f32 k = 1 - color.w * c;
+        r[i] = color.x * c + r[i] * k;
+        g[i] = color.y * c + g[i] * k;
+        b[i] = color.z * c + b[i] * k;
+        a[i] = color.w * c + a[i] * k;
+    }
+}
+
+static void oc_cpu_canvas_composite_row(f32* restrict r,
+                                        f32* restrict g,
+                                        f32* restrict b,
+                                        f32* restrict a,
+                                        const f32* restrict coverage,
+                                        u32 count,
+                                        const f32* restrict sr,
+                                        const f32* restrict sg,
+                                        const f32* restrict sb,
+                                        const f32* restrict sa)
+{
+    for(u32 i = 0; i < count; i++)
+    {
+        f32 c = coverage[i];
+        f32 k = 1 - sa[i] * c;
+        r[i] = sr[i] * c + r[i] * k;
+        g[i] = sg[i] * c + g[i] * k;
+        b[i] = sb[i] * c + b[i] * k;
+        a[i] = sa[i] * c + a[i] * k;
+    }
+}
+
+static void oc_cpu_canvas_composite_path(oc_cpu_canvas_frame* frame,
+                                         oc_cpu_path* path,
+                                         oc_cpu_color_buffer* dst,
+                                         i32 bandY0,
+                                         oc_cpu_span* span,
+                                         f32* coverage,
+                                         f32* shade)
+{
+    u32 frameWidth = frame->x1 - frame->x0;
+    u32 width = span->x1 - span->x0;
+    bool solid = !path->image && !path->bilinear && path->gradientKind == OC_GRADIENT_BILINEAR;
+    oc_vec4 color = { path->color.x * path->color.w,
+                      path->color.y * path->color.w,
+                      path->color.z * path->color.w,
+                      path->color.w };
+
+    for(i32 y = span->y0; y < span->y1; y++)
+    {
+        u64 offset = (u64)(y - bandY0) * frameWidth + (span->x0 - frame->x0);
+        f32* cov = coverage + (y - span->y0) * width;
+
+        if(solid)
+        {
+            oc_cpu_canvas_composite_solid(dst->c[0] + offset,
+                                          dst->c[1] + offset,
+                                          dst->c[2] + offset,
+                                          dst->c[3] + offset,
+                                          cov,
+                                          width,
+                                          color);
+        }
+        else
+        {
+            f32* sr = shade;
+            f32* sg = shade + width;
+            f32* sb = shade + 2 * width;
+            f32* sa = shade + 3 * width;
+            for(u32 x = 0; x < width; x++)
+            {
+                oc_vec4 c = { 0 };
+                if(cov[x] > 0)
+                {
+                    c = oc_cpu_canvas_shade(frame->renderer, path, (oc_vec2){ span->x0 + x + 0.5, y + 0.5 });
+                }
+                sr[x] = c.x;
+                sg[x] = c.y;
+                sb[x] = c.z;
+                sa[x] = c.w;
+            }
+            oc_cpu_canvas_composite_row(dst->c[0] + offset,
+                                        dst->c[1] + offset,
+                                        dst->c[2] + offset,
+                                        dst->c[3] + offset,
+                                        cov,
+                                        width,
+                                        sr,
+                                        sg,
+                                        sb,
+                                        sa);
+        }
+    }
+}
+
+static void oc_cpu_canvas_composite_layer(oc_cpu_color_buffer* dst,
+                                          oc_cpu_color_buffer* layer,
+                                          const f32* restrict mask,
+                                          u32 count)
+{
+    //NOTE: composites a clip layer over the layer below it, masked by the clip path's coverage
+    f32* restrict r = dst->c[0];
+    f32* restrict g = dst->c[1];
+    f32* restrict b = dst->c[2];
+    f32* restrict a = dst->c[3];
+    const f32* restrict lr = layer->c[0];
+    const f32* restrict lg = layer->c[1];
+    const f32* restrict lb = layer->c[2];
+    const f32* restrict la = layer->c[3];
+
+    for(u32 i = 0; i < count; i++)
+    {
+        f32 m = mask ? mask[i] : 1;
+        f32 k = 1 - la[i] * m;
+        r[i] = lr[i] * m + r[i] * k;
+        g[i] = lg[i] * m + g[i] * k;
+        b[i] = lb[i] * m + b[i] * k;
+        a[i] = la[i] * m + a[i] * k;
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+// Bands
+//------------------------------------------------------------------------------------------------
+
+typedef struct oc_cpu_band_buffers
+{
+    u32 planeSize;
+    oc_cpu_color_buffer layers[OC_CLIP_PATH_MAX_DEPTH + 1];
+    f32* masks[OC_CLIP_PATH_MAX_DEPTH];
+    bool layerVisible[OC_CLIP_PATH_MAX_DEPTH];
+    f32* area;
+    f32* coverage;
+    f32* shade;
+
+} oc_cpu_band_buffers;
+
+static void oc_cpu_canvas_clear_layer(oc_cpu_band_buffers* buffers, u32 layerIndex)
+{
+    for(int i = 0; i < 4; i++)
+    {
+        memset(buffers->layers[layerIndex].c[i], 0, buffers->planeSize * sizeof(f32));
+    }
+}
+
+static void oc_cpu_canvas_write_band(oc_cpu_canvas_frame* frame, oc_cpu_color_buffer* color, i32 bandY0, i32 bandY1)
+{
+    oc_cpu_canvas_renderer* renderer = frame->renderer;
+    u32 width = frame->x1 - frame->x0;
+    f32 lutScale = OC_CPU_CANVAS_SRGB_ENCODE_LUT_SIZE - 1;
+
+    for(i32 y = bandY0; y < bandY1; y++)
+    {
+        u64 rowOffset = (u64)(y - bandY0) * width;
+        u64 pixelOffset = (u64)y * frame->width + frame->x0;
+
+        for(u32 x = 0; x < width; x++)
+        {
+            f32 a = oc_clamp(color->c[3][rowOffset + x], 0, 1);
+            oc_vec4 dst = frame->clearColor;
+
+            if(frame->surfacePixels && frame->load)
+            {
+                u32 pixel = frame->surfacePixels[pixelOffset + x];
+                dst = (oc_vec4){ ((pixel >> 16) & 0xff) / 255.f,
+                                 ((pixel >> 8) & 0xff) / 255.f,
+                                 (pixel & 0xff) / 255.f,
+                                 (pixel >> 24) / 255.f };
+            }
+
+            //NOTE: like the final blit pass, encode the premultiplied color to sRGB and blend it over the target
+            f32 out[4];
+            for(int i = 0; i < 3; i++)
+            {
+                f32 c = oc_clamp(color->c[i][rowOffset + x], 0, 1);
+                out[i] = renderer->srgbEncode[(u32)(c * lutScale + 0.5)] + (1 - a) * dst.c[i];
+            }
+            out[3] = a + (1 - a) * dst.w;
+
+            if(frame->surfacePixels)
+            {
+                u32 bgra[4];
+                for(int i = 0; i < 4; i++)
+                {
+                    bgra[i] = (u32)(oc_clamp(out[i], 0, 1) * 255 + 0.5);
+                }
+                frame->surfacePixels[pixelOffset + x] = (bgra[3] << 24) | (bgra[0] << 16) | (bgra[1] << 8) | bgra[2];
+            }
+            else
+            {
+                //NOTE: image targets hold straight alpha
+                u8* pixel = frame->imagePixels + pixelOffset * 4 + x * 4;
+                f32 inv = (out[3] > 0) ? 1 / out[3] : 0;
+                for(int i = 0; i < 3; i++)
+                {
+                    pixel[i] = (u8)(oc_clamp(out[i] * inv, 0, 1) * 255 + 0.5);
+                }
+                pixel[3] = (u8)(oc_clamp(out[3], 0, 1) * 255 + 0.5);
+            }
+        }
+    }
+}
+
+static void oc_cpu_canvas_render_band(oc_cpu_canvas_frame* frame, oc_cpu_band_buffers* buffers, i32 bandY0, i32 bandY1)
+{
+    oc_cpu_canvas_renderer* renderer = frame->renderer;
+    u32 frameWidth = frame->x1 - frame->x0;
+    u32 bandSize = frameWidth * (bandY1 - bandY0);
+
+    oc_cpu_canvas_clear_layer(buffers, 0);
+
+    //NOTE: depth counts all the open clip paths, but only the first OC_CLIP_PATH_MAX_DEPTH get a layer, like in the
+    //      WebGPU renderer. Deeper clip paths only clip to their bounding box. Paths inside a clip path that covers
+    //      nothing in this band are skipped.
+    u32 depth = 0;
+    u32 hiddenCount = 0;
+
+    for(u32 pathIndex = 0; pathIndex < renderer->pathCount; pathIndex++)
+    {
+        oc_cpu_path* path = &renderer->paths[pathIndex];
+        u32 layerIndex = oc_min(depth, OC_CLIP_PATH_MAX_DEPTH);
+
+        if(path->cmd == OC_CMD_CLIP_PATH)
+        {
+            if(depth < OC_CLIP_PATH_MAX_DEPTH)
+            {
+                oc_cpu_span span;
+                bool visible = !hiddenCount
+                            && oc_cpu_canvas_rasterize(frame, path, bandY0, bandY1, buffers->area, buffers->coverage, &span);
+                if(visible)
+                {
+                    f32* mask = buffers->masks[depth];
+                    memset(mask, 0, bandSize * sizeof(f32));
+
+                    u32 width = span.x1 - span.x0;
+                    for(i32 y = span.y0; y < span.y1; y++)
+                    {
+                        memcpy(mask + (y - bandY0) * frameWidth + (span.x0 - frame->x0),
+                               buffers->coverage + (y - span.y0) * width,
+                               width * sizeof(f32));
+                    }
+                    oc_cpu_canvas_clear_layer(buffers, depth + 1);
+                }
+                else
+                {
+                    hiddenCount++;
+                }
+                buffers->layerVisible[depth] = visible;
+            }
+            depth++;
+        }
+        else if(path->cmd == OC_CMD_CLIP_POP)
+        {
+            //NOTE: markers without a matching clip path are ignored
+            if(depth)
+            {
+                depth--;
+                if(depth < OC_CLIP_PATH_MAX_DEPTH)
+                {
+                    if(buffers->layerVisible[depth])
+                    {
+                        oc_cpu_canvas_composite_layer(&buffers->layers[depth], &buffers->layers[depth + 1], buffers->masks[depth], bandSize);
+                    }
+                    else
+                    {
+                        hiddenCount--;
+                    }
+                }
+            }
+        }
+        else if(!hiddenCount)
+        {
+            oc_cpu_span span;
+            if(oc_cpu_canvas_rasterize(frame, path, bandY0, bandY1, buffers->area, buffers->coverage, &span))
+            {
+                oc_cpu_canvas_composite_path(frame, path, &buffers->layers[layerIndex], bandY0, &span, buffers->coverage, buffers->shade);
+            }
+        }
+    }
+
+    //NOTE: layers whose marker is missing are composited unmasked
+    while(depth)
+    {
+        depth--;
+        if(depth < OC_CLIP_PATH_MAX_DEPTH)
+        {
+            if(buffers->layerVisible[depth])
+            {
+                oc_cpu_canvas_composite_layer(&buffers->layers[depth], &buffers->layers[depth + 1], 0, bandSize);
+            }
+        }
+    }
+
+    oc_cpu_canvas_write_band(frame, &buffers->layers[0], bandY0, bandY1);
+}
+
+static void oc_cpu_canvas_render_bands(void* user, u64 start, u64 end)
+{
+    oc_cpu_canvas_frame* frame = (oc_cpu_canvas_frame*)user;
+    u32 frameWidth = frame->x1 - frame->x0;
+
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_cpu_band_buffers buffers = { .planeSize = frameWidth * OC_CPU_CANVAS_BAND_HEIGHT };
+    for(int layerIndex = 0; layerIndex <= OC_CLIP_PATH_MAX_DEPTH; layerIndex++)
+    {
+        for(int i = 0; i < 4; i++)
+        {
+            buffers.layers[layerIndex].c[i] = oc_arena_push_array(scratch.arena, f32, buffers.planeSize);
+        }
+    }
+    for(int maskIndex = 0; maskIndex < OC_CLIP_PATH_MAX_DEPTH; maskIndex++)
+    {
+        buffers.masks[maskIndex] = oc_arena_push_array(scratch.arena, f32, buffers.planeSize);
+    }
+    buffers.area = oc_arena_push_array(scratch.arena, f32, (frameWidth + 2) * OC_CPU_CANVAS_BAND_HEIGHT);
+    buffers.coverage = oc_arena_push_array(scratch.arena, f32, buffers.planeSize);
+    buffers.shade = oc_arena_push_array(scratch.arena, f32, 4 * frameWidth);
+
+    for(u64 band = start; band < end; band++)
+    {
+        i32 bandY0 = frame->y0 + band * OC_CPU_CANVAS_BAND_HEIGHT;
+        i32 bandY1 = oc_min(bandY0 + OC_CPU_CANVAS_BAND_HEIGHT, frame->y1);
+        oc_cpu_canvas_render_band(frame, &buffers, bandY0, bandY1);
+    }
+
+    oc_scratch_end(scratch);
+}
+
+static void oc_cpu_canvas_render(oc_cpu_canvas_frame* frame,
+                                 oc_vec2 scale,
+                                 u32 primitiveCount,
+                                 oc_primitive* primitives,
+                                 u32 attributeCount,
+                                 oc_attributes* attributes,
+                                 u32 eltCount,
+                                 oc_path_elt* elements)
+{
+    oc_cpu_canvas_renderer* renderer = frame->renderer;
+
+    OC_TRACE_BEGIN("cpu canvas encode");
+    renderer->pathCount = 0;
+    renderer->lineCount = 0;
+
+    oc_vec2 currentPos = { 0, 0 };
+    for(u32 primitiveIndex = 0; primitiveIndex < primitiveCount; primitiveIndex++)
+    {
+        oc_cpu_canvas_encode_primitive(renderer,
+                                       scale,
+                                       (oc_vec2){ frame->width, frame->height },
+                                       &primitives[primitiveIndex],
+                                       attributeCount,
+                                       attributes,
+                                       eltCount,
+                                       elements,
+                                       &currentPos);
+    }
+    OC_TRACE_END();
+
+    OC_TRACE_BEGIN("cpu canvas raster");
+    u32 bandCount = (frame->y1 - frame->y0 + OC_CPU_CANVAS_BAND_HEIGHT - 1) / OC_CPU_CANVAS_BAND_HEIGHT;
+
+    oc_job_counter counter = { 0 };
+    oc_job_parallel_for(bandCount, 1, oc_cpu_canvas_render_bands, frame, &counter);
+    oc_job_wait(&counter);
+    OC_TRACE_END();
+}
+
+//------------------------------------------------------------------------------------------------
+// Renderer interface
+//------------------------------------------------------------------------------------------------
+
+static oc_surface oc_cpu_canvas_surface_create_for_window(oc_canvas_renderer_base* base, oc_window window)
+{
+    return (oc_cpu_surface_create_for_window(window));
+}
+
+static void oc_cpu_canvas_submit(oc_canvas_renderer_base* base,
+                                 oc_surface surfaceHandle,
+                                 u32 msaaSampleCount,
+                                 bool clear,
+                                 oc_color clearColor,
+                                 oc_rect damage,
+                                 u32 primitiveCount,
+                                 oc_primitive* primitives,
+                                 u32 attributeCount,
+                                 oc_attributes* attributes,
+                                 u32 eltCount,
+                                 oc_path_elt* elements)
+{
+    oc_cpu_canvas_renderer* renderer = (oc_cpu_canvas_renderer*)base;
+
+    oc_cpu_surface_buffer buffer = oc_cpu_surface_get_buffer(surfaceHandle);
+    if(!buffer.pixels)
+    {
+        return;
+    }
+    oc_vec2 scale = oc_surface_contents_scaling(surfaceHandle);
+
+    oc_cpu_canvas_frame frame = {
+        .renderer = renderer,
+        .width = buffer.width,
+        .height = buffer.height,
+        .x0 = 0,
+        .y0 = 0,
+        .x1 = buffer.width,
+        .y1 = buffer.height,
+        .clearColor = { clearColor.r, clearColor.g, clearColor.b, clearColor.a },
+        .load = !clear && buffer.preserved,
+        .surfacePixels = buffer.pixels,
+    };
+
+    //NOTE: only redraw the damaged region if the frame buffer still holds the last frame of this surface
+    if(buffer.preserved
+       && renderer->lastSurface == surfaceHandle.h
+       && damage.w > 0
+       && damage.h > 0)
+    {
+        frame.x0 = oc_clamp((i32)floorf(damage.x * scale.x), 0, (i32)buffer.width);
+        frame.y0 = oc_clamp((i32)floorf(damage.y * scale.y), 0, (i32)buffer.height);
+        frame.x1 = oc_clamp((i32)ceilf((damage.x + damage.w) * scale.x), 0, (i32)buffer.width);
+        frame.y1 = oc_clamp((i32)ceilf((damage.y + damage.h) * scale.y), 0, (i32)buffer.height);
+    }
+    if(!clear && !buffer.preserved)
+    {
+        frame.clearColor = (oc_vec4){ 0 };
+    }
+    renderer->lastSurface = surfaceHandle.h;
+
+    if(frame.x0 < frame.x1 && frame.y0 < frame.y1)
+    {
+        oc_cpu_canvas_render(&frame, scale, primitiveCount, primitives, attributeCount, attributes, eltCount, elements);
+    }
+}
+
+static void oc_cpu_canvas_submit_image(oc_canvas_renderer_base* base,
+                                       oc_image_base* imageBase,
+                                       u32 msaaSampleCount,
+                                       bool clear,
+                                       oc_color clearColor,
+                                       u32 primitiveCount,
+                                       oc_primitive* primitives,
+                                       u32 attributeCount,
+                                       oc_attributes* attributes,
+                                       u32 eltCount,
+                                       oc_path_elt* elements)
+{
+    oc_cpu_canvas_renderer* renderer = (oc_cpu_canvas_renderer*)base;
+    oc_cpu_image* image = (oc_cpu_image*)imageBase;
+
+    if(!image->renderTarget)
+    {
+        oc_log_error("image was not created as a render target.\n");
+        return;
+    }
+
+    //NOTE: the canvas can sample the image it renders to, so it is rendered to a copy which then replaces it
+    u32 width = image->base.size.x;
+    u32 height = image->base.size.y;
+    u8* pixels = oc_malloc_array(u8, (u64)width * height * 4);
+    if(!pixels)
+    {
+        oc_log_error("couldn't allocate render target copy.\n");
+        return;
+    }
+
+    oc_cpu_canvas_frame frame = {
+        .renderer = renderer,
+        .width = width,
+        .height = height,
+        .x0 = 0,
+        .y0 = 0,
+        .x1 = width,
+        .y1 = height,
+        .imagePixels = pixels,
+    };
+    if(clear)
+    {
+        frame.clearColor = (oc_vec4){ clearColor.r, clearColor.g, clearColor.b, clearColor.a };
+    }
+
+    oc_cpu_canvas_render(&frame, (oc_vec2){ 1, 1 }, primitiveCount, primitives, attributeCount, attributes, eltCount, elements);
+
+    free(image->pixels);
+    image->pixels = pixels;
+}
+
+static void oc_cpu_canvas_present(oc_canvas_renderer_base* base, oc_surface surfaceHandle)
+{
+    oc_cpu_surface_present(surfaceHandle);
+}
+
+static oc_cpu_image* oc_cpu_canvas_image_alloc(oc_canvas_renderer_base* base, oc_vec2 size, bool renderTarget)
+{
+    oc_cpu_image* image = oc_malloc_type(oc_cpu_image);
+    if(image)
+    {
+        memset(image, 0, sizeof(oc_cpu_image));
+        image->base.size = size;
+        image->renderTarget = renderTarget;
+
+        u64 byteCount = (u64)size.x * size.y * 4;
+        image->pixels = oc_malloc_array(u8, byteCount);
+        if(!image->pixels)
+        {
+            oc_log_error("couldn't allocate image pixels.\n");
+            free(image);
+            return (0);
+        }
+        memset(image->pixels, 0, byteCount);
+        oc_canvas_renderer_track_memory(base, OC_CANVAS_MEMORY_IMAGES, byteCount);
+    }
+    return (image);
+}
+
+static oc_image_base* oc_cpu_canvas_image_create(oc_canvas_renderer_base* base, oc_vec2 size)
+{
+    return ((oc_image_base*)oc_cpu_canvas_image_alloc(base, size, false));
+}
+
+static oc_image_base* oc_cpu_canvas_image_create_render_target(oc_canvas_renderer_base* base, oc_vec2 size)
+{
+    return ((oc_image_base*)oc_cpu_canvas_image_alloc(base, size, true));
+}
+
+static void oc_cpu_canvas_image_destroy(oc_canvas_renderer_base* base, oc_image_base* imageBase)
+{
+    oc_cpu_image* image = (oc_cpu_image*)imageBase;
+    oc_canvas_renderer_track_memory(base, OC_CANVAS_MEMORY_IMAGES, -(i64)((u64)image->base.size.x * image->base.size.y * 4));
+    free(image->pixels);
+    free(image->readback);
+    free(image);
+}
+
+static void oc_cpu_canvas_image_upload_region(oc_canvas_renderer_base* base, oc_image_base* imageBase, oc_rect region, u8* pixels)
+{
+    oc_cpu_image* image = (oc_cpu_image*)imageBase;
+    u32 width = image->base.size.x;
+
+    i32 x0 = oc_max((i32)region.x, 0);
+    i32 y0 = oc_max((i32)region.y, 0);
+    i32 x1 = oc_min((i32)(region.x + region.w), (i32)image->base.size.x);
+    i32 y1 = oc_min((i32)(region.y + region.h), (i32)image->base.size.y);
+
+    for(i32 y = y0; y < y1; y++)
+    {
+        u8* src = pixels + ((u64)(y - (i32)region.y) * (u32)region.w + (x0 - (i32)region.x)) * 4;
+        memcpy(image->pixels + ((u64)y * width + x0) * 4, src, (x1 - x0) * 4);
+    }
+}
+
+static bool oc_cpu_canvas_image_upload_done(oc_canvas_renderer_base* base, oc_image_base* imageBase)
+{
+    return (true);
+}
+
+static bool oc_cpu_canvas_compressed_format_supported(oc_canvas_renderer_base* base, oc_image_compressed_format format)
+{
+    //NOTE: block compressed formats would have to be decoded on the CPU, decode the source image instead
+    return (false);
+}
+
+static void oc_cpu_canvas_image_readback_region(oc_canvas_renderer_base* base, oc_image_base* imageBase, oc_rect region)
+{
+    oc_cpu_image* image = (oc_cpu_image*)imageBase;
+    u32 width = image->base.size.x;
+    u32 regionWidth = region.w;
+    u32 regionHeight = region.h;
+
+    //NOTE: a new readback replaces the previous one. Rendering is synchronous, so the pixels are copied right away.
+    free(image->readback);
+    image->readback = oc_malloc_array(u8, (u64)regionWidth * regionHeight * 4);
+    if(!image->readback)
+    {
+        oc_log_error("couldn't allocate image readback.\n");
+        return;
+    }
+    image->readbackRegion = region;
+
+    for(u32 row = 0; row < regionHeight; row++)
+    {
+        memcpy(image->readback + (u64)row * regionWidth * 4,
+               image->pixels + (((u64)region.y + row) * width + (u32)region.x) * 4,
+               regionWidth * 4);
+    }
+}
+
+static bool oc_cpu_canvas_image_readback_done(oc_canvas_renderer_base* base, oc_image_base* imageBase)
+{
+    return (true);
+}
+
+static bool oc_cpu_canvas_image_readback_get(oc_canvas_renderer_base* base, oc_image_base* imageBase, u64 size, u8* pixels)
+{
+    oc_cpu_image* image = (oc_cpu_image*)imageBase;
+    if(!image->readback)
+    {
+        return (false);
+    }
+
+    u64 readbackSize = (u64)image->readbackRegion.w * image->readbackRegion.h * 4;
+    if(size < readbackSize)
+    {
+        oc_log_error("readback buffer is too small (%llu bytes, expected %llu).\n",
+                     (unsigned long long)size,
+                     (unsigned long long)readbackSize);
+        return (false);
+    }
+    memcpy(pixels, image->readback, readbackSize);
+
+    free(image->readback);
+    image->readback = 0;
+    return (true);
+}
+
+static void oc_cpu_canvas_destroy(oc_canvas_renderer_base* base)
+{
+    oc_cpu_canvas_renderer* renderer = (oc_cpu_canvas_renderer*)base;
+    free(renderer->paths);
+    free(renderer->lines);
+    free(renderer->strokePoints);
+    free(renderer);
+}
+
+oc_canvas_renderer_base* oc_cpu_canvas_renderer_create(oc_canvas_renderer_options* options)
+{
+    oc_cpu_canvas_renderer* renderer = oc_malloc_type(oc_cpu_canvas_renderer);
+    if(!renderer)
+    {
+        return (0);
+    }
+    memset(renderer, 0, sizeof(oc_cpu_canvas_renderer));
+
+    renderer->base.backend = OC_CANVAS_BACKEND_CPU;
+    renderer->base.destroy = oc_cpu_canvas_destroy;
+    renderer->base.createSurfaceForWindow = oc_cpu_canvas_surface_create_for_window;
+    renderer->base.imageCreate = oc_cpu_canvas_image_create;
+    renderer->base.imageDestroy = oc_cpu_canvas_image_destroy;
+    renderer->base.imageUploadRegion = oc_cpu_canvas_image_upload_region;
+    renderer->base.imageUploadDone = oc_cpu_canvas_image_upload_done;
+    renderer->base.compressedFormatSupported = oc_cpu_canvas_compressed_format_supported;
+    renderer->base.imageCreateRenderTarget = oc_cpu_canvas_image_create_render_target;
+    renderer->base.imageReadbackRegion = oc_cpu_canvas_image_readback_region;
+    renderer->base.imageReadbackDone = oc_cpu_canvas_image_readback_done;
+    renderer->base.imageReadbackGet = oc_cpu_canvas_image_readback_get;
+    renderer->base.submit = oc_cpu_canvas_submit;
+    renderer->base.submitImage = oc_cpu_canvas_submit_image;
+    renderer->base.present = oc_cpu_canvas_present;
+
+    //NOTE: sRGB conversion tables
+    for(int i = 0; i < 256; i++)
+    {
+        f32 c = i / 255.f;
+        renderer->srgbDecode[i] = (c <= 0.04045) ? c / 12.92 : powf((c + 0.055) / 1.055, 2.4);
+    }
+    for(int i = 0; i < OC_CPU_CANVAS_SRGB_ENCODE_LUT_SIZE; i++)
+    {
+        f32 c = (f32)i / (OC_CPU_CANVAS_SRGB_ENCODE_LUT_SIZE - 1);
+        renderer->srgbEncode[i] = (c <= 0.0031308) ? c * 12.92 : 1.055 * powf(c, 1 / 2.4) - 0.055;
+    }
+
+    return ((oc_canvas_renderer_base*)renderer);
+}
@@ -0,0 +1,27 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "app/app.h"
+
+//NOTE: CPU surfaces hold a frame buffer in memory shared with the window system (a DIB section on Windows, the
+//      backing store of the layer's image on macOS), which the CPU canvas renderer writes to directly. Pixels are
+//      32 bits, premultiplied BGRA in memory order, with rows from top to bottom.
+typedef struct oc_cpu_surface_buffer
+{
+    u32* pixels;
+    u32 width;
+    u32 height;
+    bool preserved; // the buffer still holds the last presented frame
+
+} oc_cpu_surface_buffer;
+
+ORCA_API oc_surface oc_cpu_surface_create_for_window(oc_window window);
+//NOTE: resizes the frame buffer to the size of the surface in pixels. Its contents are lost if it is resized.
+ORCA_API oc_cpu_surface_buffer oc_cpu_surface_get_buffer(oc_surface handle);
+ORCA_API void oc_cpu_surface_present(oc_surface handle);
@@ -0,0 +1,149 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+
+#include "platform/platform_memory.h"
+#include "surface.h"
+#include "cpu_surface.h"
+
+typedef struct oc_cpu_surface
+{
+    oc_surface_base base;
+    CGColorSpaceRef colorSpace;
+    u32* pixels;
+    u32 width;
+    u32 height;
+
+} oc_cpu_surface;
+
+void oc_cpu_surface_destroy(oc_surface_base* base)
+{
+    @autoreleasepool
+    {
+        oc_cpu_surface* surface = (oc_cpu_surface*)base;
+
+        free(surface->pixels);
+        CGColorSpaceRelease(surface->colorSpace);
+
+        oc_surface_base_cleanup(base);
+        free(surface);
+    }
+}
+
+oc_surface oc_cpu_surface_create_for_window(oc_window window)
+{
+    @autoreleasepool
+    {
+        oc_cpu_surface* surface = 0;
+        oc_window_data* windowData = oc_window_ptr_from_handle(window);
+        if(windowData)
+        {
+            surface = (oc_cpu_surface*)oc_malloc_type(oc_cpu_surface);
+            memset(surface, 0, sizeof(oc_cpu_surface));
+
+            oc_surface_base_init_for_window((oc_surface_base*)surface, windowData);
+
+            surface->base.api = OC_SURFACE_CPU;
+            surface->base.destroy = oc_cpu_surface_destroy;
+
+            surface->colorSpace = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
+            surface->base.view.layer.opaque = NO;
+        }
+        oc_surface handle = oc_surface_nil();
+        if(surface)
+        {
+            handle = oc_surface_handle_alloc((oc_surface_base*)surface);
+        }
+        return (handle);
+    }
+}
+
+oc_cpu_surface_buffer oc_cpu_surface_get_buffer(oc_surface handle)
+{
+    oc_cpu_surface_buffer buffer = { 0 };
+
+    oc_surface_base* base = oc_surface_from_handle(handle);
+    if(base && base->api == OC_SURFACE_CPU)
+    {
+        oc_cpu_surface* surface = (oc_cpu_surface*)base;
+        oc_vec2 size = base->getSize(base);
+        oc_vec2 scale = base->contentsScaling(base);
+        u32 width = (u32)(size.x * scale.x + 0.5);
+        u32 height = (u32)(size.y * scale.y + 0.5);
+
+        buffer.preserved = true;
+
+        if(surface->width != width || surface->height != height)
+        {
+            free(surface->pixels);
+            surface->pixels = 0;
+            surface->width = 0;
+            surface->height = 0;
+            buffer.preserved = false;
+
+            if(width && height)
+            {
+                surface->pixels = oc_malloc_array(u32, (u64)width * height);
+                if(surface->pixels)
+                {
+                    surface->width = width;
+                    surface->height = height;
+                }
+                else
+                {
+                    oc_log_error("couldn't allocate the frame buffer of a CPU surface.\n");
+                }
+            }
+        }
+
+        buffer.pixels = surface->pixels;
+        buffer.width = surface->width;
+        buffer.height = surface->height;
+    }
+    return (buffer);
+}
+
+void oc_cpu_surface_present(oc_surface handle)
+{
+    @autoreleasepool
+    {
+        oc_surface_base* base = oc_surface_from_handle(handle);
+        if(base && base->api == OC_SURFACE_CPU)
+        {
+            oc_cpu_surface* surface = (oc_cpu_surface*)base;
+            if(surface->pixels)
+            {
+                //NOTE: the layer keeps the image until the next present, while the renderer writes the next frame to
+                //      the frame buffer, so the image gets its own copy of the pixels
+                u64 size = (u64)surface->width * surface->height * 4;
+                CFDataRef data = CFDataCreate(0, (const UInt8*)surface->pixels, size);
+                CGDataProviderRef provider = CGDataProviderCreateWithCFData(data);
+
+                CGImageRef image = CGImageCreate(surface->width,
+                                                 surface->height,
+                                                 8,
+                                                 32,
+                                                 surface->width * 4,
+                                                 surface->colorSpace,
+                                                 kCGBitmapByteOrder32Little | kCGImageAlphaPremultipliedFirst,
+                                                 provider,
+                                                 0,
+                                                 false,
+                                                 kCGRenderingIntentDefault);
+
+                [CATransaction begin];
+                [CATransaction setDisableActions:YES];
+                surface->base.view.layer.contents = (id)image;
+                [CATransaction commit];
+
+                CGImageRelease(image);
+                CGDataProviderRelease(provider);
+                CFRelease(data);
+            }
+        }
+    }
+}
@@ -0,0 +1,147 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+
+#include "platform/platform_memory.h"
+#include "surface.h"
+#include "cpu_surface.h"
+
+typedef struct oc_cpu_surface
+{
+    oc_surface_base base;
+    HDC memoryDC;
+    HBITMAP bitmap;
+    HGDIOBJ previousBitmap;
+    u32* pixels;
+    u32 width;
+    u32 height;
+
+} oc_cpu_surface;
+
+static void oc_cpu_surface_release_bitmap(oc_cpu_surface* surface)
+{
+    if(surface->bitmap)
+    {
+        SelectObject(surface->memoryDC, surface->previousBitmap);
+        DeleteObject(surface->bitmap);
+        surface->bitmap = 0;
+        surface->pixels = 0;
+        surface->width = 0;
+        surface->height = 0;
+    }
+}
+
+void oc_cpu_surface_destroy(oc_surface_base* base)
+{
+    oc_cpu_surface* surface = (oc_cpu_surface*)base;
+
+    oc_cpu_surface_release_bitmap(surface);
+    DeleteDC(surface->memoryDC);
+
+    oc_surface_base_cleanup(base);
+    free(surface);
+}
+
+oc_surface oc_cpu_surface_create_for_window(oc_window window)
+{
+    oc_cpu_surface* surface = 0;
+    oc_window_data* windowData = oc_window_ptr_from_handle(window);
+    if(windowData)
+    {
+        surface = (oc_cpu_surface*)oc_malloc_type(oc_cpu_surface);
+        memset(surface, 0, sizeof(oc_cpu_surface));
+
+        oc_surface_base_init_for_window((oc_surface_base*)surface, windowData);
+
+        surface->base.api = OC_SURFACE_CPU;
+        surface->base.destroy = oc_cpu_surface_destroy;
+
+        surface->memoryDC = CreateCompatibleDC(0);
+    }
+    oc_surface handle = oc_surface_nil();
+    if(surface)
+    {
+        handle = oc_surface_handle_alloc((oc_surface_base*)surface);
+    }
+    return (handle);
+}
+
+oc_cpu_surface_buffer oc_cpu_surface_get_buffer(oc_surface handle)
+{
+    oc_cpu_surface_buffer buffer = { 0 };
+
+    oc_surface_base* base = oc_surface_from_handle(handle);
+    if(base && base->api == OC_SURFACE_CPU)
+    {
+        oc_cpu_surface* surface = (oc_cpu_surface*)base;
+        oc_vec2 size = base->getSize(base);
+        oc_vec2 scale = base->contentsScaling(base);
+        u32 width = (u32)(size.x * scale.x + 0.5);
+        u32 height = (u32)(size.y * scale.y + 0.5);
+
+        buffer.preserved = true;
+
+        if(surface->width != width || surface->height != height)
+        {
+            oc_cpu_surface_release_bitmap(surface);
+            buffer.preserved = false;
+
+            if(width && height)
+            {
+                //NOTE: a negative height makes a top-down DIB section
+                BITMAPINFO info = {
+                    .bmiHeader = {
+                        .biSize = sizeof(BITMAPINFOHEADER),
+                        .biWidth = (LONG)width,
+                        .biHeight = -(LONG)height,
+                        .biPlanes = 1,
+                        .biBitCount = 32,
+                        .biCompression = BI_RGB,
+                    },
+                };
+                void* pixels = 0;
+                surface->bitmap = CreateDIBSection(surface->memoryDC, &info, DIB_RGB_COLORS, &pixels, 0, 0);
+                if(surface->bitmap)
+                {
+                    surface->previousBitmap = SelectObject(surface->memoryDC, surface->bitmap);
+                    surface->pixels = (u32*)pixels;
+                    surface->width = width;
+                    surface->height = height;
+                }
+                else
+                {
+                    oc_log_error("couldn't create the frame buffer of a CPU surface.\n");
+                }
+            }
+        }
+
+        //NOTE: make sure GDI is done reading the DIB section before the renderer writes to it
+        GdiFlush();
+
+        buffer.pixels = surface->pixels;
+        buffer.width = surface->width;
+        buffer.height = surface->height;
+    }
+    return (buffer);
+}
+
+void oc_cpu_surface_present(oc_surface handle)
+{
+    oc_surface_base* base = oc_surface_from_handle(handle);
+    if(base && base->api == OC_SURFACE_CPU)
+    {
+        oc_cpu_surface* surface = (oc_cpu_surface*)base;
+        if(surface->bitmap)
+        {
+            HDC dc = GetDC(surface->base.view.hWnd);
+            BitBlt(dc, 0, 0, surface->width, surface->height, surface->memoryDC, 0, 0, SRCCOPY);
+            ReleaseDC(surface->base.view.hWnd, dc);
+
+            oc_win32_window_frame_presented(surface->base.view.parent, surface->width, surface->height);
+        }
+    }
+}
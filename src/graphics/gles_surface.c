@@ -19,18 +19,16 @@
     //NOTE: EGL_PLATFORM_ANGLE_TYPE_DEFAULT_ANGLE on osx defaults to CGL backend, which doesn't handle SwapInterval correctly
     #define OC_EGL_PLATFORM_ANGLE_TYPE EGL_PLATFORM_ANGLE_TYPE_METAL_ANGLE
 
-    //NOTE: hardcode GLES versions for now
-    //TODO: use version hints, once we have all api versions correctly categorized by glapi.py
-    #define OC_GLES_VERSION_MAJOR 3
-    #define OC_GLES_VERSION_MINOR 0
-    #define oc_gl_load_gles oc_gl_load_gles31
 #else
     #define OC_EGL_PLATFORM_ANGLE_TYPE EGL_PLATFORM_ANGLE_TYPE_DEFAULT_ANGLE
-    #define OC_GLES_VERSION_MAJOR 3
-    #define OC_GLES_VERSION_MINOR 1
-    #define oc_gl_load_gles oc_gl_load_gles32
 #endif
 
+//NOTE: we ask for a GLES 3.1 context first, so that apps can use compute shaders, shader storage buffers and image
+//      load/store, and fall back to GLES 3.0 if the backend doesn't support it.
+#define OC_GLES_VERSION_MAJOR 3
+#define OC_GLES_VERSION_MINOR 1
+#define OC_GLES_FALLBACK_VERSION_MINOR 0
+
 typedef struct oc_gles_surface
 {
     oc_surface_base base;
@@ -72,6 +70,16 @@ void oc_gles_surface_make_current(oc_surface handle)
         eglMakeCurrent(surface->eglDisplay, surface->eglSurface, surface->eglSurface, surface->eglContext);
         oc_gl_select_api(&surface->api);
     }
+    else if(oc_surface_is_nil(handle))
+    {
+        //NOTE: releases the calling thread's context, so that another thread can make it current
+        EGLDisplay display = eglGetCurrentDisplay();
+        if(display != EGL_NO_DISPLAY)
+        {
+            eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        }
+        oc_gl_deselect_api();
+    }
 }
 
 void oc_gles_surface_swap_buffers(oc_surface handle)
@@ -164,9 +172,22 @@ void oc_gles_surface_init(oc_gles_surface* surface)
     };
 
     surface->eglContext = eglCreateContext(surface->eglDisplay, surface->eglConfig, EGL_NO_CONTEXT, contextAttributes);
+    if(surface->eglContext == EGL_NO_CONTEXT)
+    {
+        oc_log_warning("couldn't create a GLES %i.%i context, falling back to GLES %i.%i\n",
+                       OC_GLES_VERSION_MAJOR,
+                       OC_GLES_VERSION_MINOR,
+                       OC_GLES_VERSION_MAJOR,
+                       OC_GLES_FALLBACK_VERSION_MINOR);
+
+        contextAttributes[3] = OC_GLES_FALLBACK_VERSION_MINOR;
+        surface->eglContext = eglCreateContext(surface->eglDisplay, surface->eglConfig, EGL_NO_CONTEXT, contextAttributes);
+    }
     eglMakeCurrent(surface->eglDisplay, surface->eglSurface, surface->eglSurface, surface->eglContext);
 
-    oc_gl_load_gles(&surface->api, (oc_gl_load_proc)eglGetProcAddress);
+    //NOTE: guest bindings only cover GLES 3.1, so load that api even on a fallback context. The backend reports an
+    //      error if a 3.1 proc is called on a 3.0 context.
+    oc_gl_load_gles31(&surface->api, (oc_gl_load_proc)eglGetProcAddress);
 
     eglSwapInterval(surface->eglDisplay, 1);
 }
@@ -16,6 +16,34 @@ ORCA_API oc_surface oc_gles_surface_create(void);
 ORCA_API oc_surface oc_gles_surface_create_for_window(oc_window window);
 #endif
 
-ORCA_API void oc_gles_surface_make_current(oc_surface surface);
+ORCA_API void oc_gles_surface_make_current(oc_surface surface); // a nil surface releases the calling thread's context
 ORCA_API void oc_gles_surface_swap_interval(oc_surface surface, int interval);
 ORCA_API void oc_gles_surface_swap_buffers(oc_surface surface);
+
+//------------------------------------------------------------------------------------------
+//SECTION: upload regions (Orca GLES extension)
+//------------------------------------------------------------------------------------------
+/*NOTE:
+	An upload region is host-owned memory for streaming buffer data, e.g. dynamic vertex data updated every frame.
+	It is placed in wasm memory outside the guest heap, and split into OC_GLES_UPLOAD_REGION_SLOTS slots that are
+	used in turn on each oc_gles_surface_swap_buffers(). The guest writes a frame's data directly into the current
+	slot, and oc_gles_upload_region_flush() uploads a range of it to the buffer bound to target, like
+	glBufferSubData(). The upload is queued with the other GL commands instead of forcing a synchronization, and
+	the runtime reads the slot in place, so the slot must not be written again until it comes back around.
+*/
+typedef struct oc_gles_upload_region
+{
+    u64 h;
+} oc_gles_upload_region;
+
+enum
+{
+    OC_GLES_UPLOAD_REGION_SLOTS = 3,
+};
+
+#if OC_PLATFORM_ORCA
+ORCA_API oc_gles_upload_region oc_gles_upload_region_create(u32 slotSize);
+ORCA_API void oc_gles_upload_region_destroy(oc_gles_upload_region region);
+ORCA_API void* oc_gles_upload_region_begin(oc_gles_upload_region region); // returns the current frame's slot
+ORCA_API void oc_gles_upload_region_flush(oc_gles_upload_region region, u32 target, u32 bufferOffset, u32 offset, u32 size);
+#endif
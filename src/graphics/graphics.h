@@ -57,6 +57,16 @@ typedef struct oc_image
     u64 h;
 } oc_image;
 
+typedef struct oc_display_list
+{
+    u64 h;
+} oc_display_list;
+
+typedef struct oc_layer
+{
+    u64 h;
+} oc_layer;
+
 typedef enum oc_gradient_blend_space
 {
     OC_GRADIENT_BLEND_LINEAR,
@@ -88,6 +98,18 @@ typedef struct oc_color
     oc_color_space colorSpace;
 } oc_color;
 
+//NOTE: a color stop of a linear or radial gradient. Offsets go from 0 at the gradient's start to 1 at its end.
+typedef struct oc_gradient_stop
+{
+    f32 offset;
+    oc_color color;
+} oc_gradient_stop;
+
+enum
+{
+    OC_GRADIENT_MAX_STOPS = 8,
+};
+
 typedef enum
 {
     OC_JOINT_MITER = 0,
@@ -126,6 +148,38 @@ typedef struct oc_text_metrics
 
 } oc_text_metrics;
 
+typedef enum oc_text_align
+{
+    OC_TEXT_ALIGN_LEFT = 0,
+    OC_TEXT_ALIGN_CENTER,
+    OC_TEXT_ALIGN_RIGHT,
+} oc_text_align;
+
+typedef struct oc_text_line
+{
+    u32 start;      // index of the first code point of the line
+    u32 count;      // number of code points in the line, including trailing spaces and line feed
+    f32 width;      // width of the line, without trailing spaces
+    oc_vec2 origin; // pen position at the start of the line's baseline, from the top-left corner of the paragraph
+
+} oc_text_line;
+
+typedef struct oc_text_layout
+{
+    oc_font font;
+    f32 fontSize;
+    oc_vec2 size; // width of the longest line and height of all lines
+
+    u32 codePointCount;
+    oc_utf32* codePoints;
+    u32* glyphIndices;
+    oc_vec2* positions; // pen position of each code point's glyph, from the top-left corner of the paragraph
+
+    u32 lineCount;
+    oc_text_line* lines;
+
+} oc_text_layout;
+
 //------------------------------------------------------------------------------------------
 //SECTION: color helpers
 //------------------------------------------------------------------------------------------
@@ -141,12 +195,90 @@ oc_color oc_color_convert(oc_color color, oc_color_space colorSpace);
 ORCA_API oc_canvas_renderer oc_canvas_renderer_nil(void);
 ORCA_API bool oc_canvas_renderer_is_nil(oc_canvas_renderer renderer);
 
+typedef enum oc_canvas_power_preference
+{
+    OC_CANVAS_POWER_HIGH_PERFORMANCE = 0,
+    OC_CANVAS_POWER_LOW_POWER,
+} oc_canvas_power_preference;
+
+//NOTE: mailbox and immediate presentation fall back to fifo on surfaces that don't support them
+typedef enum oc_canvas_present_mode
+{
+    OC_CANVAS_PRESENT_FIFO = 0,  // wait for vertical blank, never tears
+    OC_CANVAS_PRESENT_MAILBOX,   // replace the frame waiting for vertical blank, never tears
+    OC_CANVAS_PRESENT_IMMEDIATE, // present right away, can tear
+} oc_canvas_present_mode;
+
+//NOTE: the CPU backend rasterizes canvases on the job system's worker threads, for machines without a usable GPU.
+//      It ignores the power preference and MSAA sample count, and always computes analytic coverage.
+typedef enum oc_canvas_backend
+{
+    OC_CANVAS_BACKEND_DEFAULT = 0, // WebGPU, falling back to the CPU if no adapter is found
+    OC_CANVAS_BACKEND_WEBGPU,
+    OC_CANVAS_BACKEND_CPU,
+} oc_canvas_backend;
+
+typedef struct oc_canvas_renderer_options
+{
+    oc_canvas_power_preference powerPreference;
+    oc_canvas_present_mode presentMode;
+    u32 maxFrameLatency; // frames queued for presentation, 0 keeps the platform default
+    oc_canvas_backend backend;
+
+} oc_canvas_renderer_options;
+
 ORCA_API oc_canvas_renderer oc_canvas_renderer_create(void);
+ORCA_API oc_canvas_renderer oc_canvas_renderer_create_with_options(oc_canvas_renderer_options* options);
 ORCA_API void oc_canvas_renderer_destroy(oc_canvas_renderer renderer);
+//NOTE: changes the presentation of the renderer's surfaces. The power preference can only be chosen at creation.
+ORCA_API void oc_canvas_renderer_set_present_mode(oc_canvas_renderer renderer, oc_canvas_present_mode mode, u32 maxFrameLatency);
+//NOTE: blocks until at most maxFrameLatency of the frames submitted before this call are still being processed by the
+//      GPU. Called once per frame before polling input, so that input isn't sampled long before it's displayed.
+//      Does nothing if the renderer's max frame latency is 0.
+ORCA_API void oc_canvas_renderer_wait_frame_latency(oc_canvas_renderer renderer);
+//NOTE: enables dynamic resolution. While frames take more than gpuBudget milliseconds of GPU time, canvas surfaces are
+//      rasterized at a lower scale, down to minScale, and upscaled when they're presented. The scale goes back up once
+//      frames fit the budget again. A budget of 0 disables it. Renderers that can't time their frames on the GPU
+//      always render at full scale.
+ORCA_API void oc_canvas_renderer_set_dynamic_scale(oc_canvas_renderer renderer, f32 gpuBudget, f32 minScale);
+//NOTE: returns the scale that canvas surfaces are currently rasterized at, relative to their contents scaling
+ORCA_API f32 oc_canvas_renderer_get_render_scale(oc_canvas_renderer renderer);
+
+//NOTE: memory allocated by a canvas renderer, in GPU memory for the WebGPU backend. Peaks are the highest byte counts
+//      since the renderer was created.
+typedef struct oc_canvas_memory_usage
+{
+    u64 bytes;
+    u64 peakBytes;
+
+} oc_canvas_memory_usage;
+
+typedef struct oc_canvas_memory_stats
+{
+    oc_canvas_memory_usage pathBuffers;   // encoded paths, path elements, glyphs and gradients
+    oc_canvas_memory_usage rasterBuffers; // segments, path bins, tile queues and tile ops
+    oc_canvas_memory_usage images;        // images and render targets, including the shared image array
+    oc_canvas_memory_usage targets;       // intermediate textures canvases are rasterized to
+    oc_canvas_memory_usage staging;       // upload and readback buffers
+    oc_canvas_memory_usage total;
+
+} oc_canvas_memory_stats;
+
+ORCA_API oc_canvas_memory_stats oc_canvas_renderer_get_memory_stats(oc_canvas_renderer renderer);
 
 ORCA_API void oc_canvas_render(oc_canvas_renderer renderer, oc_canvas_context context, oc_surface surface);
+//NOTE: renders the canvas into an image created with oc_image_create_render_target(), replacing its contents.
+//      This doesn't need a window or surface, so it can be used for headless rendering.
+ORCA_API void oc_canvas_render_image(oc_canvas_renderer renderer, oc_canvas_context context, oc_image image);
 ORCA_API void oc_canvas_present(oc_canvas_renderer renderer, oc_surface surface);
 
+#if !OC_PLATFORM_ORCA
+//NOTE: renders contexts[i] to surfaces[i] for each of the count surfaces, and presents them, e.g. to update several
+//      windows at once. The WebGPU backend encodes all the surfaces in one command buffer, submits it once, and then
+//      presents all of them. Surfaces are fully redrawn, ignoring the damage of their contexts, unless count is 1.
+ORCA_API void oc_canvas_render_many(oc_canvas_renderer renderer, u32 count, oc_canvas_context* contexts, oc_surface* surfaces);
+#endif
+
 //------------------------------------------------------------------------------------------
 //SECTION: canvas surface
 //------------------------------------------------------------------------------------------
@@ -158,6 +290,26 @@ ORCA_API oc_surface oc_canvas_surface_create_for_window(oc_canvas_renderer rende
 
 ORCA_API void oc_canvas_surface_swap_interval(oc_surface surface, int swap);
 
+//------------------------------------------------------------------------------------------
+//SECTION: image surface
+//------------------------------------------------------------------------------------------
+//NOTE: image surfaces hand an image straight to the system compositor, as a DirectComposition visual on Windows and
+//      a CALayer on macOS, instead of drawing it into a canvas. The compositor keeps showing the last uploaded image
+//      without any work from the app, so they suit video frames and static backgrounds, which would otherwise be
+//      re-rasterized every frame. Like other surfaces, they can be moved above or below the canvas surface.
+//      oc_image_surface_set_frame() places the surface relative to the top-left of the window's content, in points,
+//      and the image is stretched to fill it. oc_image_surface_upload_rgba8() replaces the image with width * height
+//      rgba8 pixels with straight alpha, rows from top to bottom. The surface is empty until the first upload, and
+//      its size is the size of its frame.
+#if OC_PLATFORM_ORCA
+ORCA_API oc_surface oc_image_surface_create(void);
+#else
+ORCA_API oc_surface oc_image_surface_create_for_window(oc_window window);
+#endif
+
+ORCA_API void oc_image_surface_set_frame(oc_surface surface, oc_rect frame);
+ORCA_API void oc_image_surface_upload_rgba8(oc_surface surface, u32 width, u32 height, u8* pixels);
+
 //------------------------------------------------------------------------------------------
 //SECTION: canvas context
 //------------------------------------------------------------------------------------------
@@ -168,7 +320,56 @@ ORCA_API oc_canvas_context oc_canvas_context_create(void);
 ORCA_API void oc_canvas_context_destroy(oc_canvas_context context);
 ORCA_API oc_canvas_context oc_canvas_context_select(oc_canvas_context context);
 
+//NOTE: passing OC_CANVAS_SAMPLE_COUNT_ANALYTIC as the sample count computes the area of each pixel covered by paths,
+//      instead of testing sample points. It costs about as much as a single sample per pixel, and is exact on pixels
+//      crossed by a single edge, but can let thin seams show where edges of different paths meet.
+enum
+{
+    OC_CANVAS_SAMPLE_COUNT_ANALYTIC = 0x7fffffff,
+};
+
 ORCA_API void oc_canvas_context_set_msaa_sample_count(oc_canvas_context context, u32 sampleCount);
+
+//------------------------------------------------------------------------------------------
+//SECTION: display lists
+//------------------------------------------------------------------------------------------
+//NOTE: commands issued between oc_display_list_begin_record() and oc_display_list_end_record()
+//      are captured in a display list instead of being drawn. The list can then be replayed
+//      any number of times with oc_display_list_draw(), which only copies the recorded commands.
+ORCA_API oc_display_list oc_display_list_nil(void);
+ORCA_API bool oc_display_list_is_nil(oc_display_list list);
+
+ORCA_API void oc_display_list_begin_record(void);
+ORCA_API oc_display_list oc_display_list_end_record(void);
+ORCA_API void oc_display_list_destroy(oc_display_list list);
+
+ORCA_API void oc_display_list_draw(oc_display_list list, oc_mat2x3 transform);
+
+//NOTE: primitives of a display list are identified by their index in recording order. oc_display_list_record_count()
+//      returns the number of primitives recorded so far, which is the index of the next fill or stroke.
+//      oc_display_list_hit_test() writes the indices of up to maxCount primitives containing point, in the list's
+//      coordinates, front-most first, and returns their count. Candidates are found with a bounding volume hierarchy
+//      built by the first call, and then tested exactly against their path.
+ORCA_API u32 oc_display_list_record_count(void);
+ORCA_API u32 oc_display_list_hit_test(oc_display_list list, oc_vec2 point, u32 maxCount, u32* primitiveIndices);
+
+//------------------------------------------------------------------------------------------
+//SECTION: layers
+//------------------------------------------------------------------------------------------
+//NOTE: layers render canvas commands into an image they own, which can then be drawn any number of times as a
+//      single textured rectangle, e.g. with a group opacity. When oc_layer_begin() returns true, draw the layer's
+//      content in its own coordinates, then call oc_layer_end(). When cached is true and the layer was already
+//      drawn, oc_layer_begin() returns false and the previous content is kept.
+ORCA_API oc_layer oc_layer_nil(void);
+ORCA_API bool oc_layer_is_nil(oc_layer layer);
+
+ORCA_API oc_layer oc_layer_create(oc_canvas_renderer renderer, u32 width, u32 height);
+ORCA_API void oc_layer_destroy(oc_layer layer);
+
+ORCA_API bool oc_layer_begin(oc_layer layer, bool cached);
+ORCA_API void oc_layer_end(oc_layer layer);
+
+ORCA_API void oc_layer_draw(oc_layer layer, oc_rect rect, f32 opacity);
 //------------------------------------------------------------------------------------------
 //SECTION: fonts
 //------------------------------------------------------------------------------------------
@@ -179,6 +380,19 @@ ORCA_API oc_font oc_font_create_from_memory(oc_str8 mem, u32 rangeCount, oc_unic
 ORCA_API oc_font oc_font_create_from_file(oc_file file, u32 rangeCount, oc_unicode_range* ranges);
 ORCA_API oc_font oc_font_create_from_path(oc_str8 path, u32 rangeCount, oc_unicode_range* ranges);
 
+//NOTE: lazy fonts decode glyphs on first use instead of at creation. If maxLoadedOutlines is not 0,
+//      at most maxLoadedOutlines glyph outlines are kept in memory, evicting the least recently used first.
+//      Fonts created from a file or path map it read-only when the platform can, and lazy fonts decode their glyphs
+//      from that mapping instead of keeping a copy of the file.
+ORCA_API oc_font oc_font_create_from_memory_lazy(oc_str8 mem, u32 rangeCount, oc_unicode_range* ranges, u32 maxLoadedOutlines);
+ORCA_API oc_font oc_font_create_from_file_lazy(oc_file file, u32 rangeCount, oc_unicode_range* ranges, u32 maxLoadedOutlines);
+ORCA_API oc_font oc_font_create_from_path_lazy(oc_str8 path, u32 rangeCount, oc_unicode_range* ranges, u32 maxLoadedOutlines);
+
+//NOTE: a font collection draws each code point with the first of its fonts that has a glyph for it, and measures lines
+//      with the metrics of the first font. Up to 16 fonts can be chained, and they must outlive the collection, which
+//      is destroyed with oc_font_destroy(). Glyph indices returned for a collection are only valid with that collection.
+ORCA_API oc_font oc_font_create_collection(u32 fontCount, oc_font* fonts);
+
 ORCA_API void oc_font_destroy(oc_font font);
 
 ORCA_API oc_str32 oc_font_get_glyph_indices(oc_font font, oc_str32 codePoints, oc_str32 backing);
@@ -193,6 +407,12 @@ ORCA_API f32 oc_font_get_scale_for_em_pixels(oc_font font, f32 emSize);
 ORCA_API oc_text_metrics oc_font_text_metrics_utf32(oc_font font, f32 fontSize, oc_str32 codepoints);
 ORCA_API oc_text_metrics oc_font_text_metrics(oc_font font, f32 fontSize, oc_str8 text);
 
+//NOTE: breaks text into lines at most maxWidth wide, or only at line feeds if maxWidth is 0, and aligns them within
+//      maxWidth, or within the longest line if maxWidth is 0. Lines break after spaces, or between glyphs of words that
+//      don't fit on a line of their own. Layouts are cached by text and parameters, so laying out the same paragraph
+//      again only copies the cached result to arena.
+ORCA_API oc_text_layout oc_font_push_text_layout(oc_arena* arena, oc_font font, f32 fontSize, oc_str8 text, f32 maxWidth, oc_text_align align);
+
 //------------------------------------------------------------------------------------------
 //SECTION: images
 //------------------------------------------------------------------------------------------
@@ -205,22 +425,132 @@ ORCA_API oc_image oc_image_create_from_memory(oc_canvas_renderer renderer, oc_st
 ORCA_API oc_image oc_image_create_from_file(oc_canvas_renderer renderer, oc_file file, bool flip);
 ORCA_API oc_image oc_image_create_from_path(oc_canvas_renderer renderer, oc_str8 path, bool flip);
 
+//NOTE: async variants return an image of the right size right away, and decode and upload its pixels in the background.
+//      oc_image_is_ready() tells when the pixels are available.
+ORCA_API oc_image oc_image_create_from_memory_async(oc_canvas_renderer renderer, oc_str8 mem, bool flip);
+ORCA_API oc_image oc_image_create_from_file_async(oc_canvas_renderer renderer, oc_file file, bool flip);
+ORCA_API oc_image oc_image_create_from_path_async(oc_canvas_renderer renderer, oc_str8 path, bool flip);
+ORCA_API bool oc_image_is_ready(oc_image image);
+
+//NOTE: the image cache is disabled by default. Once it's enabled, images created from the same path and modification
+//      date, or from the same encoded data, share one texture: oc_image_create_from_memory/file/path() and their async
+//      variants return the image that is already loaded with an added reference, and oc_image_destroy() drops it.
+//      Images without references are kept until they take more than budget bytes (0 for 64MB), then the least recently
+//      released ones are destroyed. Cached images are shared, so they shouldn't be modified.
+ORCA_API void oc_canvas_renderer_enable_image_cache(oc_canvas_renderer renderer, u64 budget);
+
+//NOTE: compressed images are uploaded as-is and sampled by the GPU without being decompressed. All supported formats
+//      use 4x4 blocks of 16 bytes, so width and height must be multiples of 4 and data must hold (width/4)*(height/4)*16 bytes.
+typedef enum oc_image_compressed_format
+{
+    OC_IMAGE_COMPRESSED_BC7_SRGB = 0,
+    OC_IMAGE_COMPRESSED_ETC2_RGBA8_SRGB,
+    OC_IMAGE_COMPRESSED_ASTC_4X4_SRGB,
+    OC_IMAGE_COMPRESSED_FORMAT_COUNT,
+} oc_image_compressed_format;
+
+ORCA_API bool oc_image_compressed_format_supported(oc_canvas_renderer renderer, oc_image_compressed_format format);
+ORCA_API oc_image oc_image_create_compressed(oc_canvas_renderer renderer, oc_image_compressed_format format, u32 width, u32 height, oc_str8 data);
+
 ORCA_API void oc_image_destroy(oc_image image);
 
 ORCA_API void oc_image_upload_region_rgba8(oc_image image, oc_rect region, u8* pixels);
+ORCA_API bool oc_image_upload_done(oc_image image);
+
+//NOTE: render targets can be drawn to with oc_canvas_render_image(), and used as regular images afterwards.
+ORCA_API oc_image oc_image_create_render_target(oc_canvas_renderer renderer, u32 width, u32 height);
+
+//NOTE: readbacks copy a region of an image to the CPU asynchronously. Once oc_image_readback_done() returns true,
+//      oc_image_readback_get() writes the region as rgba8 pixels with straight alpha, region.w * region.h * 4 bytes.
+//      Starting a new readback cancels the previous one.
+ORCA_API void oc_image_readback_region(oc_image image, oc_rect region);
+ORCA_API bool oc_image_readback_done(oc_image image);
+ORCA_API bool oc_image_readback_get(oc_image image, u64 size, u8* pixels);
 ORCA_API oc_vec2 oc_image_size(oc_image image);
 
+//NOTE: tiled images are made of OC_IMAGE_TILE_SIZE square tiles, at each level of a mip chain that ends with a level
+//      that fits in a single tile. Level L is ceil(width / 2^L) x ceil(height / 2^L) pixels. Only the tiles needed by
+//      recent frames are kept on the GPU, in a pool of bounded size, and regions whose tiles aren't loaded are drawn
+//      from the nearest coarser level that is.
+//      oc_tiled_image_requests() writes up to maxCount missing tiles that were needed to draw the last frame, coarsest
+//      first, and returns their count. The app loads them with oc_tiled_image_upload_tile(), whose pixels hold the
+//      tile's rect of its level as rgba8, or decodes them in the background with oc_tiled_image_load_tile_from_memory_async().
+//      A tile isn't requested again while it's being loaded, unless it's still missing after a second.
+//      Tiled images are only supported by the GPU renderer.
+enum
+{
+    OC_IMAGE_TILE_SIZE = 256,
+    OC_IMAGE_TILE_MAX_LEVELS = 16,
+};
+
+typedef struct oc_image_tile
+{
+    u32 level;
+    u32 x;
+    u32 y;
+} oc_image_tile;
+
+ORCA_API oc_image oc_tiled_image_create(oc_canvas_renderer renderer, u32 width, u32 height);
+ORCA_API u32 oc_tiled_image_level_count(oc_image image);
+ORCA_API oc_rect oc_tiled_image_tile_rect(oc_image image, oc_image_tile tile); // in pixels of the tile's level
+ORCA_API u32 oc_tiled_image_requests(oc_image image, u32 maxCount, oc_image_tile* tiles);
+ORCA_API bool oc_tiled_image_upload_tile(oc_image image, oc_image_tile tile, u8* pixels);
+ORCA_API void oc_tiled_image_load_tile_from_memory_async(oc_image image, oc_image_tile tile, oc_str8 mem, bool flip);
+
+//NOTE: YUV images hold video frames as separate 8-bit planes, and are converted to RGB by the GPU when they are sampled.
+//      The luma plane has one byte per pixel. The chroma planes are subsampled by 2 in both directions, rounding up:
+//      NV12 has a second plane of interleaved Cb/Cr pairs, and I420 has a Cb plane followed by a Cr plane.
+//      oc_image_yuv_plane_size() returns the bytes per row and the row count of a plane, and oc_image_upload_yuv_plane()
+//      uploads a whole plane from tightly packed rows. YUV images are only supported by the GPU renderer. They have no
+//      mipmaps and can't be read back.
+typedef enum oc_image_yuv_format
+{
+    OC_IMAGE_YUV_NV12 = 0,
+    OC_IMAGE_YUV_I420,
+    OC_IMAGE_YUV_FORMAT_COUNT,
+} oc_image_yuv_format;
+
+typedef enum oc_image_yuv_color_space
+{
+    OC_IMAGE_YUV_BT601_LIMITED = 0,
+    OC_IMAGE_YUV_BT601_FULL,
+    OC_IMAGE_YUV_BT709_LIMITED,
+    OC_IMAGE_YUV_BT709_FULL,
+    OC_IMAGE_YUV_COLOR_SPACE_COUNT,
+} oc_image_yuv_color_space;
+
+ORCA_API oc_image oc_image_create_yuv(oc_canvas_renderer renderer, oc_image_yuv_format format, oc_image_yuv_color_space colorSpace, u32 width, u32 height);
+ORCA_API u32 oc_image_yuv_plane_count(oc_image image);
+ORCA_API oc_vec2 oc_image_yuv_plane_size(oc_image image, u32 plane);
+ORCA_API void oc_image_upload_yuv_plane(oc_image image, u32 plane, u8* pixels);
+
+//NOTE: conversions of tightly packed 4-channel 8-bit pixels, in place unless they have a separate destination. They use
+//      SSE2, NEON or wasm SIMD when available. sRGB conversions go through lookup tables: decoding is exact, encoding is
+//      within one step of the exact value. Alpha is stored linearly, and isn't converted.
+ORCA_API void oc_pixels_flip_rows(u8* pixels, u32 width, u32 height);
+ORCA_API void oc_pixels_premultiply_rgba8(u8* pixels, u64 count);
+ORCA_API void oc_pixels_swap_red_blue(u8* pixels, u64 count); // converts between RGBA and BGRA
+ORCA_API void oc_pixels_srgb_to_linear(f32* dst, u8* src, u64 count);
+ORCA_API void oc_pixels_linear_to_srgb(u8* dst, f32* src, u64 count);
+
 //------------------------------------------------------------------------------------------
 //SECTION: atlasing
 //------------------------------------------------------------------------------------------
 
-//NOTE: rectangle allocator
+//NOTE: rectangle allocator. Recycled rectangles can be reused by later allocations.
 typedef struct oc_rect_atlas oc_rect_atlas;
 
 ORCA_API oc_rect_atlas* oc_rect_atlas_create(oc_arena* arena, i32 width, i32 height);
 ORCA_API oc_rect oc_rect_atlas_alloc(oc_rect_atlas* atlas, i32 width, i32 height);
 ORCA_API void oc_rect_atlas_recycle(oc_rect_atlas* atlas, oc_rect rect);
 
+//NOTE: an atlas can grow into several pages of the same size, up to maxPages (16 at most). oc_rect_atlas_alloc() and
+//      oc_rect_atlas_recycle() only use the first page, the _paged versions use all of them.
+ORCA_API void oc_rect_atlas_set_max_pages(oc_rect_atlas* atlas, u32 maxPages);
+ORCA_API u32 oc_rect_atlas_page_count(oc_rect_atlas* atlas);
+ORCA_API oc_rect oc_rect_atlas_alloc_paged(oc_rect_atlas* atlas, i32 width, i32 height, u32* page);
+ORCA_API void oc_rect_atlas_recycle_paged(oc_rect_atlas* atlas, u32 page, oc_rect rect);
+
 //NOTE: image atlas helpers
 typedef struct oc_image_region
 {
@@ -234,6 +564,11 @@ ORCA_API oc_image_region oc_image_atlas_alloc_from_file(oc_rect_atlas* atlas, oc
 ORCA_API oc_image_region oc_image_atlas_alloc_from_path(oc_rect_atlas* atlas, oc_image backingImage, oc_str8 path, bool flip);
 ORCA_API void oc_image_atlas_recycle(oc_rect_atlas* atlas, oc_image_region imageRgn);
 
+//NOTE: lets the image atlas helpers add pages when the atlas is full, backed by images created with renderer. The
+//      returned regions then point to the image of their page. oc_image_atlas_cleanup() destroys these images.
+ORCA_API void oc_image_atlas_set_growth(oc_rect_atlas* atlas, oc_canvas_renderer renderer, u32 maxPages);
+ORCA_API void oc_image_atlas_cleanup(oc_rect_atlas* atlas);
+
 //------------------------------------------------------------------------------------------
 //SECTION: transform, viewport and clipping
 //------------------------------------------------------------------------------------------
@@ -246,6 +581,17 @@ ORCA_API void oc_clip_push(f32 x, f32 y, f32 w, f32 h);
 ORCA_API void oc_clip_pop(void);
 ORCA_API oc_rect oc_clip_top(void);
 
+//NOTE: clips subsequent drawing to the current path, which is consumed as if it was filled, until the matching
+//      oc_clip_path_pop(). The path's bounding box is also pushed on the clip stack, and is returned by oc_clip_top().
+//      Clip paths can be nested up to 4 deep (see OC_CLIP_PATH_MAX_DEPTH). Deeper ones only clip to their bounding box.
+ORCA_API void oc_clip_path_push(void);
+ORCA_API void oc_clip_path_pop(void);
+
+//NOTE: marks a rect, in the current transform, as changed since the last frame. If any rect was marked, the next
+//      oc_canvas_render() only redraws their bounding box, and keeps the rest of the previous frame. The whole frame
+//      still has to be submitted.
+ORCA_API void oc_add_damage_rect(f32 x, f32 y, f32 w, f32 h);
+
 //------------------------------------------------------------------------------------------
 //SECTION: graphics attributes setting/getting
 //------------------------------------------------------------------------------------------
@@ -254,26 +600,37 @@ ORCA_API void oc_set_color_rgba(f32 r, f32 g, f32 b, f32 a);
 ORCA_API void oc_set_color_srgba(f32 r, f32 g, f32 b, f32 a);
 
 ORCA_API void oc_set_gradient(oc_gradient_blend_space blendSpace, oc_color bottomLeft, oc_color bottomRight, oc_color topRight, oc_color topLeft);
+
+//NOTE: linear and radial gradients are evaluated in the user space of the primitives they paint, from the stops sorted by
+//      offset. Colors are clamped to the first and last stops outside of [0, 1]. Only the first OC_GRADIENT_MAX_STOPS
+//      stops are used.
+ORCA_API void oc_set_linear_gradient(oc_gradient_blend_space blendSpace, oc_vec2 start, oc_vec2 end, u32 stopCount, oc_gradient_stop* stops);
+ORCA_API void oc_set_radial_gradient(oc_gradient_blend_space blendSpace, oc_vec2 center, f32 radius, u32 stopCount, oc_gradient_stop* stops);
+
 ORCA_API void oc_set_width(f32 width);
 ORCA_API void oc_set_tolerance(f32 tolerance);
+ORCA_API void oc_set_tolerance_lod(bool lod);
 ORCA_API void oc_set_joint(oc_joint_type joint);
 ORCA_API void oc_set_max_joint_excursion(f32 maxJointExcursion);
 ORCA_API void oc_set_cap(oc_cap_type cap);
 ORCA_API void oc_set_font(oc_font font);
 ORCA_API void oc_set_font_size(f32 size);
 ORCA_API void oc_set_text_flip(bool flip);
+ORCA_API void oc_set_polyline_decimation(f32 columnWidth);
 ORCA_API void oc_set_image(oc_image image);
 ORCA_API void oc_set_image_source_region(oc_rect region);
 
 ORCA_API oc_color oc_get_color(void);
 ORCA_API f32 oc_get_width(void);
 ORCA_API f32 oc_get_tolerance(void);
+ORCA_API bool oc_get_tolerance_lod(void);
 ORCA_API oc_joint_type oc_get_joint(void);
 ORCA_API f32 oc_get_max_joint_excursion(void);
 ORCA_API oc_cap_type oc_get_cap(void);
 ORCA_API oc_font oc_get_font(void);
 ORCA_API f32 oc_get_font_size(void);
 ORCA_API bool oc_get_text_flip(void);
+ORCA_API f32 oc_get_polyline_decimation(void);
 ORCA_API oc_image oc_get_image(void);
 ORCA_API oc_rect oc_get_image_source_region(void);
 
@@ -285,6 +642,13 @@ ORCA_API void oc_move_to(f32 x, f32 y);
 ORCA_API void oc_line_to(f32 x, f32 y);
 ORCA_API void oc_quadratic_to(f32 x1, f32 y1, f32 x2, f32 y2);
 ORCA_API void oc_cubic_to(f32 x1, f32 y1, f32 x2, f32 y2, f32 x3, f32 y3);
+//NOTE: oc_polyline() moves to the first point and adds lines through the others. They are stored in a packed form,
+//      which takes about a third of the memory of the equivalent oc_line_to() calls.
+//      If a column width was set with oc_set_polyline_decimation(), the points falling in the same column of that
+//      width on screen are reduced to at most four, using the transform and clip current when oc_polyline() is called.
+//      This is meant for strokes of dense data series, and a width of 1 / (pixels per screen unit) leaves them visually
+//      unchanged.
+ORCA_API void oc_polyline(u32 count, oc_vec2* points);
 ORCA_API void oc_close_path(void);
 
 ORCA_API oc_rect oc_glyph_outlines(oc_str32 glyphIndices);
@@ -298,6 +662,12 @@ ORCA_API void oc_clear(void);
 ORCA_API void oc_fill(void);
 ORCA_API void oc_stroke(void);
 
+//NOTE: draw count copies of the current path, with transforms[i] applied on top of the current matrix.
+//      If colors is not null, copy i is painted with the solid color colors[i] instead of the current color or gradient.
+//      Each copy is rendered as its own path, this only saves recording the path's elements again.
+ORCA_API void oc_fill_copies(u32 count, oc_mat2x3* transforms, oc_color* colors);
+ORCA_API void oc_stroke_copies(u32 count, oc_mat2x3* transforms, oc_color* colors);
+
 //------------------------------------------------------------------------------------------
 //SECTION: shapes helpers
 //------------------------------------------------------------------------------------------
@@ -313,10 +683,27 @@ ORCA_API void oc_arc(f32 x, f32 y, f32 r, f32 arcAngle, f32 startAngle);
 
 ORCA_API void oc_text_fill(f32 x, f32 y, oc_str8 text);
 
+//NOTE: fills the lines of a text layout, with its top-left corner at x, y, using the layout's font and size.
+ORCA_API void oc_text_layout_fill(f32 x, f32 y, oc_text_layout* layout);
+
+//NOTE: lets oc_text_fill() draw glyphs of the current context from bitmaps, rasterized on first use into an atlas of
+//      images created with renderer. Only upright text with a uniform scale and at most maxPixelSize pixels per em on
+//      screen is cached, larger or transformed text is still filled from its outlines. pixelScale is the number of
+//      pixels per canvas unit of the surface, e.g. 2 on a high dpi display.
+ORCA_API void oc_text_cache_enable(oc_canvas_renderer renderer, f32 maxPixelSize, f32 pixelScale);
+ORCA_API void oc_text_cache_disable(void);
+
 //NOTE: image helpers
 ORCA_API void oc_image_draw(oc_image image, oc_rect rect);
 ORCA_API void oc_image_draw_region(oc_image image, oc_rect srcRegion, oc_rect dstRegion);
 
+//NOTE: draws count regions of an image, e.g. sprites from an atlas, sharing a single rectangle path. Sprite i draws
+//      srcRects[i] (or the whole image if srcRects is null) into dstRects[i] (or a rectangle of the source's size at
+//      the origin if dstRects is null), with transforms[i] applied on top of the current matrix if transforms is not
+//      null, and modulated by tints[i] if tints is not null. Sprites that stay axis-aligned are rasterized from
+//      their box without generating path segments. Any path under construction is discarded.
+ORCA_API void oc_sprite_batch_draw(oc_image image, u32 count, oc_rect* srcRects, oc_rect* dstRects, oc_mat2x3* transforms, oc_color* tints);
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,6 +24,17 @@
 #include "platform/platform_debug.h"
 #include "util/algebra.h"
 
+#if defined(__wasm_simd128__)
+    #include <wasm_simd128.h>
+    #define OC_PIXELS_WASM 1
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    #include <emmintrin.h>
+    #define OC_PIXELS_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    #include <arm_neon.h>
+    #define OC_PIXELS_NEON 1
+#endif
+
 typedef struct oc_glyph_map_entry
 {
     oc_unicode_range range;
@@ -33,11 +44,18 @@ typedef struct oc_glyph_map_entry
 
 typedef struct oc_glyph_data
 {
+    bool loaded;
     bool exists;
     oc_utf32 codePoint;
+    int stbttGlyphIndex;
     oc_path_descriptor pathDescriptor;
     oc_glyph_metrics metrics;
-    //...
+
+    //NOTE(martin): outline elements in font units. For lazily loaded fonts, outlines are decoded on first use
+    //              and can be evicted, in which case they are kept in the font's lru list while loaded.
+    bool outlineLoaded;
+    oc_path_elt* outline;
+    oc_list_elt lruElt;
 
 } oc_glyph_data;
 
@@ -45,10 +63,44 @@ enum
 {
     OC_MATRIX_STACK_MAX_DEPTH = 64,
     OC_CLIP_STACK_MAX_DEPTH = 64,
-    OC_MAX_PATH_ELEMENT_COUNT = 2 << 20,
-    OC_MAX_PRIMITIVE_COUNT = 8 << 14
+
+    //NOTE: path elements and primitives are stored in growable buffers. They start at these
+    //      capacities and are shrunk back after OC_CANVAS_SHRINK_PERIOD frames of low usage.
+    OC_CANVAS_DEFAULT_PATH_ELEMENT_CAP = 4 << 10,
+    OC_CANVAS_DEFAULT_PRIMITIVE_CAP = 1 << 10,
+    OC_CANVAS_DEFAULT_ATTRIBUTE_CAP = 1 << 8,
+    //NOTE: number of recent attribute table entries searched for a match before pushing a new one
+    OC_CANVAS_ATTRIBUTE_LOOKBACK = 4,
+    OC_CANVAS_SHRINK_PERIOD = 120,
+    //NOTE: free path elements requested before outlining a glyph run, the buffer grows further if a glyph doesn't fit
+    OC_GLYPH_RUN_ELT_RESERVE = 1 << 10,
+    //NOTE: number of glyph outlines whose elements are shared by the glyph primitives of a frame, see oc_canvas_glyph_slot
+    OC_CANVAS_GLYPH_SLOT_COUNT = 256,
+    //NOTE: glyph bitmap cache, see oc_text_cache_enable()
+    OC_TEXT_CACHE_ATLAS_SIZE = 512,
+    OC_TEXT_CACHE_MAX_PAGES = 8,
+    OC_TEXT_CACHE_ENTRY_COUNT = 4096,
+    OC_TEXT_CACHE_SUBPIXEL_STEPS = 4,
+    //NOTE: number of paragraph layouts kept by oc_font_push_text_layout()
+    OC_TEXT_LAYOUT_CACHE_SIZE = 128,
+    //NOTE: font collections, see oc_font_create_collection()
+    OC_FONT_COLLECTION_MAX_MEMBERS = 16,
+    OC_FONT_COLLECTION_MEMBER_SHIFT = 24,
+    OC_FONT_COLLECTION_LOOKUP_SIZE = 1024,
+    //NOTE: display list hit testing, see oc_display_list_hit_test()
+    OC_HIT_TEST_LEAF_SIZE = 4,
+    OC_HIT_TEST_STACK_SIZE = 64,
+    OC_HIT_TEST_MAX_CURVE_STEPS = 64,
 };
 
+typedef struct oc_font_collection_slot
+{
+    oc_utf32 codePoint;
+    u32 glyphIndex; // glyph index in the collection, with the member index in its top bits
+    bool valid;
+
+} oc_font_collection_slot;
+
 typedef struct oc_font_data
 {
     oc_list_elt freeListElt;
@@ -63,6 +115,33 @@ typedef struct oc_font_data
     f32 unitsPerEm;
     oc_font_metrics metrics;
 
+    //NOTE(martin): glyph used to render code points that are not present in the font, and metrics of the
+    //              empty rectangle drawn instead if the font doesn't have a replacement glyph.
+    u32 replacementGlyphIndex;
+    oc_glyph_metrics missingGlyphMetrics;
+
+    //NOTE(martin): lazy loading state. The font keeps a copy or a mapping of the font file, from which glyphs
+    //              are decoded on demand. If maxLoadedOutlines is not 0, it is the maximum number of
+    //              outlines kept in memory, least recently used outlines being evicted first.
+    bool lazy;
+    oc_str8 fileData;
+    bool fileMapped; // fileData is a read-only mapping of the font file instead of a malloc'd copy
+    stbtt_fontinfo stbttInfo;
+    u32 maxLoadedOutlines;
+    u32 loadedOutlineCount;
+    oc_list outlineLRU;
+
+    //NOTE: runtime's copy of the font on the Orca platform, used to measure and outline glyph runs natively
+    oc_font hostFont;
+
+    //NOTE: font collections have no glyphs of their own, only the metrics of their first member. Their glyph indices
+    //      hold the index of the member providing the glyph above OC_FONT_COLLECTION_MEMBER_SHIFT. Code points are
+    //      resolved through a lookup cache shared by all members, which is dropped whenever a font is destroyed.
+    u32 memberCount;
+    oc_font members[OC_FONT_COLLECTION_MAX_MEMBERS];
+    oc_font_collection_slot* lookupSlots;
+    u32 lookupFontDestroyCount;
+
 } oc_font_data;
 
 typedef struct oc_canvas_context_data oc_canvas_context_data;
@@ -76,6 +155,8 @@ typedef enum oc_graphics_handle_kind
     OC_GRAPHICS_HANDLE_FONT,
     OC_GRAPHICS_HANDLE_IMAGE,
     OC_GRAPHICS_HANDLE_SURFACE_SERVER,
+    OC_GRAPHICS_HANDLE_DISPLAY_LIST,
+    OC_GRAPHICS_HANDLE_LAYER,
 } oc_graphics_handle_kind;
 
 typedef struct oc_graphics_handle_slot
@@ -93,6 +174,22 @@ enum
     OC_GRAPHICS_HANDLES_MAX_COUNT = 512
 };
 
+//NOTE: a cached paragraph layout. The text and the layout's arrays are stored in a single allocation.
+typedef struct oc_text_layout_cache_entry
+{
+    u64 key;
+    u64 lastUse;
+    oc_font font;
+    f32 fontSize;
+    f32 maxWidth;
+    oc_text_align align;
+    oc_str8 text;
+
+    oc_text_layout layout;
+    void* block;
+
+} oc_text_layout_cache_entry;
+
 typedef struct oc_graphics_data
 {
     bool init;
@@ -104,17 +201,40 @@ typedef struct oc_graphics_data
     oc_arena resourceArena;
     oc_list canvasFreeList;
     oc_list fontFreeList;
+    oc_list displayListFreeList;
+    oc_list layerFreeList;
+
+    u32 glyphSlotGeneration; // last generation given to a context's glyph slots
+    u32 fontDestroyCount;    // glyph slots referencing a destroyed font are dropped when this changes
+
+    u64 textLayoutClock;
+    oc_text_layout_cache_entry textLayoutCache[OC_TEXT_LAYOUT_CACHE_SIZE];
 
 } oc_graphics_data;
 
+//NOTE: glyph outlines already pushed to a context's element stream since the last render. Each further occurrence of
+//      the glyph only pushes an OC_CMD_GLYPH primitive referencing the same elements, with the occurrence's transform.
+typedef struct oc_canvas_glyph_slot
+{
+    oc_font_data* font;
+    u32 glyphIndex;
+    u32 generation; // the slot is valid if it matches the context's glyphSlotGeneration
+    oc_path_descriptor path;
+
+} oc_canvas_glyph_slot;
+
+typedef struct oc_text_cache oc_text_cache;
+
 typedef struct oc_canvas_context_data
 {
     oc_list_elt freeListElt;
 
     oc_attributes attributes;
     bool textFlip;
+    f32 polylineDecimation; // column width of oc_polyline() decimation, in screen units, or 0 if it is disabled
 
-    oc_path_elt pathElements[OC_MAX_PATH_ELEMENT_COUNT];
+    u32 pathElementCap;
+    oc_path_elt* pathElements;
     oc_path_descriptor path;
     oc_vec2 subPathStartPoint;
     oc_vec2 subPathLastPoint;
@@ -125,20 +245,98 @@ typedef struct oc_canvas_context_data
     oc_rect clipStack[OC_CLIP_STACK_MAX_DEPTH];
     u32 clipStackSize;
 
+    //NOTE: each clip path also pushes its bounding box on the clip stack. 'masked' records whether it emitted an
+    //      OC_CMD_CLIP_PATH primitive, which oc_clip_path_pop() must close.
+    bool clipPathMasked[OC_CLIP_STACK_MAX_DEPTH];
+    u32 clipPathStackSize;
+    u32 clipPathDepth; // number of masked clip paths on the stack
+
     u32 primitiveCount;
-    oc_primitive primitives[OC_MAX_PRIMITIVE_COUNT];
+    u32 primitiveCap;
+    oc_primitive* primitives;
+
+    //NOTE: attributes referenced by primitives. Consecutive primitives sharing the same state
+    //      reference the same entry.
+    u32 attributeCount;
+    u32 attributeCap;
+    oc_attributes* attributeTable;
+
+    //NOTE: high-water marks used to shrink buffers back after a spike
+    u32 pathElementHighWater;
+    u32 primitiveHighWater;
+    u32 attributeHighWater;
+    u32 shrinkFrameCount;
+
+    //NOTE: display list recording state
+    bool recording;
+    u32 recordPrimitiveStart;
+    u32 recordAttributeStart;
+    u32 recordEltStart;
+    oc_path_descriptor recordSavedPath;
+    oc_vec2 recordSavedSubPathStartPoint;
+    oc_vec2 recordSavedSubPathLastPoint;
 
     //NOTE: these are used at render time
     i32 msaaSampleCount;
 
     bool clear;
     oc_color clearColor;
+    oc_rect damage; // union of the rects passed to oc_add_damage_rect() since the last render, empty for a full redraw
 
     oc_vec4 shapeExtents;
     oc_vec4 shapeScreenExtents;
 
+    u32 glyphSlotGeneration;
+    u32 glyphSlotFontDestroyCount;
+    oc_canvas_glyph_slot glyphSlots[OC_CANVAS_GLYPH_SLOT_COUNT];
+
+    oc_text_cache* textCache; // set by oc_text_cache_enable(), released when the context is destroyed
+
 } oc_canvas_context_data;
 
+typedef struct oc_hit_test_node
+{
+    oc_vec4 box;   // x0, y0, x1, y1, in the list's coordinates
+    u32 start;     // first primitive of a leaf in hitIndices
+    u32 count;     // number of primitives of a leaf, 0 for inner nodes
+    u32 right;     // second child of an inner node. The first child directly follows the node.
+} oc_hit_test_node;
+
+typedef struct oc_display_list_data
+{
+    oc_list_elt freeListElt;
+
+    u32 primitiveCount;
+    oc_primitive* primitives;
+
+    u32 attributeCount;
+    oc_attributes* attributes;
+
+    u32 eltCount;
+    oc_path_elt* elements;
+
+    //NOTE: bounding volume hierarchy over the bounds of the list's primitives, built by the first hit test
+    bool hitTestBuilt;
+    u32 hitNodeCount;
+    oc_hit_test_node* hitNodes;
+    u32* hitIndices;
+    oc_vec4* hitBounds;
+
+} oc_display_list_data;
+
+typedef struct oc_layer_data
+{
+    oc_list_elt freeListElt;
+
+    oc_canvas_renderer renderer;
+    oc_image image;
+    oc_canvas_context context;         // the layer's content is drawn in its own context
+    oc_canvas_context previousContext; // selected again by oc_layer_end()
+    bool drawn;
+    bool drawing;
+
+} oc_layer_data;
+
 static oc_graphics_data oc_graphicsData = { 0 };
 
 void oc_graphics_init()
@@ -345,16 +543,197 @@ void oc_clip_stack_pop(oc_canvas_context_data* context)
     }
 }
 
-void oc_push_command(oc_canvas_context_data* context, oc_primitive primitive)
+//------------------------------------------------------------------------------------------
+//NOTE(martin): growable command storage
+//------------------------------------------------------------------------------------------
+
+static bool oc_canvas_buffer_reserve(void** buffer, u32* cap, u32 minCap, u32 defaultCap, u64 eltSize)
+{
+    if(minCap <= *cap)
+    {
+        return (true);
+    }
+
+    u64 newCap = oc_max(defaultCap, *cap);
+    while(newCap < minCap)
+    {
+        newCap = newCap * 3 / 2;
+    }
+    if(newCap > UINT32_MAX)
+    {
+        oc_log_error("canvas command buffer exceeds 2^32 elements\n");
+        return (false);
+    }
+
+    void* newBuffer = realloc(*buffer, newCap * eltSize);
+    if(!newBuffer)
+    {
+        oc_log_error("couldn't grow canvas command buffer to %llu elements\n", (unsigned long long)newCap);
+        return (false);
+    }
+    *buffer = newBuffer;
+    *cap = newCap;
+    return (true);
+}
+
+static void oc_canvas_buffer_shrink(void** buffer, u32* cap, u32 highWater, u32 defaultCap, u64 eltSize)
+{
+    //NOTE: only shrink if we use less than a quarter of the buffer, and keep some headroom
+    if(*cap > defaultCap && highWater < *cap / 4)
+    {
+        u32 newCap = oc_max(defaultCap, highWater * 2);
+        void* newBuffer = realloc(*buffer, newCap * eltSize);
+        if(newBuffer)
+        {
+            *buffer = newBuffer;
+            *cap = newCap;
+        }
+    }
+}
+
+static void oc_canvas_context_update_buffers(oc_canvas_context_data* context, u32 eltCount)
+{
+    context->pathElementHighWater = oc_max(context->pathElementHighWater, eltCount);
+    context->primitiveHighWater = oc_max(context->primitiveHighWater, context->primitiveCount);
+    context->attributeHighWater = oc_max(context->attributeHighWater, context->attributeCount);
+    context->shrinkFrameCount++;
+
+    if(context->shrinkFrameCount >= OC_CANVAS_SHRINK_PERIOD)
+    {
+        oc_canvas_buffer_shrink((void**)&context->pathElements,
+                                &context->pathElementCap,
+                                context->pathElementHighWater,
+                                OC_CANVAS_DEFAULT_PATH_ELEMENT_CAP,
+                                sizeof(oc_path_elt));
+
+        oc_canvas_buffer_shrink((void**)&context->primitives,
+                                &context->primitiveCap,
+                                context->primitiveHighWater,
+                                OC_CANVAS_DEFAULT_PRIMITIVE_CAP,
+                                sizeof(oc_primitive));
+
+        oc_canvas_buffer_shrink((void**)&context->attributeTable,
+                                &context->attributeCap,
+                                context->attributeHighWater,
+                                OC_CANVAS_DEFAULT_ATTRIBUTE_CAP,
+                                sizeof(oc_attributes));
+
+        context->pathElementHighWater = 0;
+        context->primitiveHighWater = 0;
+        context->attributeHighWater = 0;
+        context->shrinkFrameCount = 0;
+    }
+}
+
+static bool oc_attributes_equal(oc_attributes* a, oc_attributes* b)
+{
+    //NOTE: compare field by field, since padding bytes are not guaranteed to match
+    if(a->width != b->width
+       || a->tolerance != b->tolerance
+       || a->toleranceLOD != b->toleranceLOD
+       || a->hasGradient != b->hasGradient
+       || a->blendSpace != b->blendSpace
+       || a->gradientKind != b->gradientKind
+       || a->gradientStopCount != b->gradientStopCount
+       || a->joint != b->joint
+       || a->maxJointExcursion != b->maxJointExcursion
+       || a->cap != b->cap
+       || a->font.h != b->font.h
+       || a->fontSize != b->fontSize
+       || a->clipPathDepth != b->clipPathDepth
+       || a->image.h != b->image.h
+       || memcmp(&a->srcRegion, &b->srcRegion, sizeof(oc_rect))
+       || memcmp(&a->transform, &b->transform, sizeof(oc_mat2x3))
+       || memcmp(&a->clip, &b->clip, sizeof(oc_rect)))
+    {
+        return (false);
+    }
+    for(int i = 0; i < 4; i++)
+    {
+        if(memcmp(&a->colors[i], &b->colors[i], sizeof(oc_color)))
+        {
+            return (false);
+        }
+    }
+    if(a->hasGradient && a->gradientKind != OC_GRADIENT_BILINEAR)
+    {
+        if(memcmp(a->gradientPoints, b->gradientPoints, 2 * sizeof(oc_vec2)))
+        {
+            return (false);
+        }
+        for(u32 i = 0; i < a->gradientStopCount; i++)
+        {
+            if(a->gradientStops[i].offset != b->gradientStops[i].offset
+               || memcmp(&a->gradientStops[i].color, &b->gradientStops[i].color, sizeof(oc_color)))
+            {
+                return (false);
+            }
+        }
+    }
+    return (true);
+}
+
+static bool oc_canvas_intern_attributes(oc_canvas_context_data* context, oc_attributes* attributes, u32* index)
+{
+    //NOTE: look for a match in the last few entries. While recording a display list, we don't look
+    //      past the start of the recording, so that the list's attributes stay contiguous.
+    u32 floor = context->recording ? context->recordAttributeStart : 0;
+    u32 searchCount = oc_min(context->attributeCount - floor, OC_CANVAS_ATTRIBUTE_LOOKBACK);
+
+    for(u32 i = 0; i < searchCount; i++)
+    {
+        u32 candidate = context->attributeCount - 1 - i;
+        if(oc_attributes_equal(&context->attributeTable[candidate], attributes))
+        {
+            *index = candidate;
+            return (true);
+        }
+    }
+
+    if(!oc_canvas_buffer_reserve((void**)&context->attributeTable,
+                                 &context->attributeCap,
+                                 context->attributeCount + 1,
+                                 OC_CANVAS_DEFAULT_ATTRIBUTE_CAP,
+                                 sizeof(oc_attributes)))
+    {
+        return (false);
+    }
+    *index = context->attributeCount;
+    context->attributeTable[context->attributeCount] = *attributes;
+    context->attributeCount++;
+    return (true);
+}
+
+static bool oc_push_command_with_transform(oc_canvas_context_data* context, oc_primitive primitive, oc_mat2x3 transform)
 {
     //NOTE(martin): push primitive and updates current stream, eventually patching a pending jump.
-    OC_ASSERT(context->primitiveCount < OC_MAX_PRIMITIVE_COUNT);
+    if(!oc_canvas_buffer_reserve((void**)&context->primitives,
+                                 &context->primitiveCap,
+                                 context->primitiveCount + 1,
+                                 OC_CANVAS_DEFAULT_PRIMITIVE_CAP,
+                                 sizeof(oc_primitive)))
+    {
+        return (false);
+    }
+
+    oc_attributes attributes = context->attributes;
+    attributes.transform = transform;
+    attributes.clip = oc_clip_stack_top(context);
+    attributes.clipPathDepth = context->clipPathDepth;
+
+    if(!oc_canvas_intern_attributes(context, &attributes, &primitive.attributesIndex))
+    {
+        return (false);
+    }
 
     context->primitives[context->primitiveCount] = primitive;
-    context->primitives[context->primitiveCount].attributes = context->attributes;
-    context->primitives[context->primitiveCount].attributes.transform = oc_matrix_stack_top(context);
-    context->primitives[context->primitiveCount].attributes.clip = oc_clip_stack_top(context);
     context->primitiveCount++;
+    return (true);
+}
+
+bool oc_push_command(oc_canvas_context_data* context, oc_primitive primitive)
+{
+    return (oc_push_command_with_transform(context, primitive, oc_matrix_stack_top(context)));
 }
 
 void oc_new_path(oc_canvas_context_data* context)
@@ -365,13 +744,26 @@ void oc_new_path(oc_canvas_context_data* context)
     context->path.startPoint = context->subPathStartPoint;
 }
 
-void oc_path_push_elements(oc_canvas_context_data* context, u32 count, oc_path_elt* elements)
+static bool oc_path_reserve_elements(oc_canvas_context_data* context, u32 count)
 {
-    OC_ASSERT(context->path.count + context->path.startIndex + count < OC_MAX_PATH_ELEMENT_COUNT);
+    u64 minCap = (u64)context->path.startIndex + context->path.count + count;
+    return (minCap <= UINT32_MAX
+            && oc_canvas_buffer_reserve((void**)&context->pathElements,
+                                        &context->pathElementCap,
+                                        minCap,
+                                        OC_CANVAS_DEFAULT_PATH_ELEMENT_CAP,
+                                        sizeof(oc_path_elt)));
+}
+
+bool oc_path_push_elements(oc_canvas_context_data* context, u32 count, oc_path_elt* elements)
+{
+    if(!oc_path_reserve_elements(context, count))
+    {
+        return (false);
+    }
     memcpy(context->pathElements + context->path.startIndex + context->path.count, elements, count * sizeof(oc_path_elt));
     context->path.count += count;
-
-    OC_ASSERT(context->path.count < OC_MAX_PATH_ELEMENT_COUNT);
+    return (true);
 }
 
 void oc_path_push_element(oc_canvas_context_data* context, oc_path_elt elt)
@@ -379,6 +771,160 @@ void oc_path_push_element(oc_canvas_context_data* context, oc_path_elt elt)
     oc_path_push_elements(context, 1, &elt);
 }
 
+u32 oc_path_unpacked_count(u32 count, oc_path_elt* elements)
+{
+    u32 polylineCount = 0;
+    for(u32 i = 0; i < count; i++)
+    {
+        polylineCount += (elements[i].type == OC_PATH_POLYLINE) ? 1 : 0;
+    }
+    return (polylineCount ? count + 2 * polylineCount : 0);
+}
+
+void oc_path_unpack(u32 count, oc_path_elt* elements, oc_path_elt* unpacked)
+{
+    for(u32 i = 0; i < count; i++)
+    {
+        if(elements[i].type == OC_PATH_POLYLINE)
+        {
+            for(int j = 0; j < 3; j++)
+            {
+                *unpacked = (oc_path_elt){ .type = OC_PATH_LINE, .p[0] = elements[i].p[j] };
+                unpacked++;
+            }
+        }
+        else
+        {
+            *unpacked = elements[i];
+            unpacked++;
+        }
+    }
+}
+
+static void oc_canvas_glyph_slots_reset(oc_canvas_context_data* context)
+{
+    //NOTE: called whenever elements referenced by the slots are discarded or moved. Generations are unique across
+    //      contexts, so that a recycled context doesn't pick up the slots of its previous use.
+    oc_graphicsData.glyphSlotGeneration++;
+    context->glyphSlotGeneration = oc_graphicsData.glyphSlotGeneration;
+    context->glyphSlotFontDestroyCount = oc_graphicsData.fontDestroyCount;
+}
+
+static oc_canvas_glyph_slot* oc_canvas_glyph_slot_lookup(oc_canvas_context_data* context, oc_font_data* font, u32 glyphIndex, bool* found)
+{
+    if(context->glyphSlotFontDestroyCount != oc_graphicsData.fontDestroyCount)
+    {
+        oc_canvas_glyph_slots_reset(context);
+    }
+
+    u64 hash = ((u64)(uintptr_t)font >> 4) ^ ((u64)glyphIndex * 2654435761u);
+    oc_canvas_glyph_slot* slot = &context->glyphSlots[hash % OC_CANVAS_GLYPH_SLOT_COUNT];
+
+    *found = (slot->generation == context->glyphSlotGeneration
+              && slot->font == font
+              && slot->glyphIndex == glyphIndex);
+    return (slot);
+}
+
+//NOTE: glyph bitmaps rasterized at a given pixel size and horizontal subpixel offset, keyed by font, glyph, size in
+//      quarter pixels and subpixel step. Entries are never evicted one by one: when the atlas or the table is full, or
+//      a font was destroyed, the cache stops taking new glyphs and is flushed after the next render.
+typedef struct oc_text_cache_entry
+{
+    oc_font_data* font;
+    u32 glyphIndex;
+    u32 sizeKey;
+    u32 subpixel;
+    bool used;
+
+    oc_image_region region; // empty for glyphs without coverage
+    oc_vec2 offset;         // top-left corner of the bitmap relative to the pen position, in pixels
+
+} oc_text_cache_entry;
+
+typedef struct oc_text_cache
+{
+    oc_canvas_renderer renderer;
+    f32 maxPixelSize;
+    f32 pixelScale;
+    bool enabled;
+
+    oc_arena arena;
+    oc_rect_atlas* atlas;
+    oc_image image; // backing image of the atlas' first page, other pages own theirs
+
+    bool full;
+    bool stale;
+    u32 fontDestroyCount;
+    u32 entryCount;
+    oc_text_cache_entry entries[OC_TEXT_CACHE_ENTRY_COUNT];
+
+} oc_text_cache;
+
+static void oc_text_cache_destroy(oc_text_cache* cache)
+{
+    oc_image_atlas_cleanup(cache->atlas);
+    oc_image_destroy(cache->image);
+    oc_arena_cleanup(&cache->arena);
+    free(cache);
+}
+
+static void oc_text_cache_flush(oc_text_cache* cache)
+{
+    //NOTE: called after a render, so that the regions are only overwritten by glyphs of the next frame
+    for(u32 i = 0; i < OC_TEXT_CACHE_ENTRY_COUNT; i++)
+    {
+        oc_text_cache_entry* entry = &cache->entries[i];
+        if(entry->used && !oc_image_is_nil(entry->region.image))
+        {
+            oc_image_atlas_recycle(cache->atlas, entry->region);
+        }
+    }
+    memset(cache->entries, 0, sizeof(cache->entries));
+    cache->entryCount = 0;
+    cache->full = false;
+    cache->stale = false;
+    cache->fontDestroyCount = oc_graphicsData.fontDestroyCount;
+}
+
+static void oc_text_cache_end_frame(oc_canvas_context_data* context)
+{
+    if(context->textCache && (context->textCache->full || context->textCache->stale))
+    {
+        oc_text_cache_flush(context->textCache);
+    }
+}
+
+static oc_text_cache_entry* oc_text_cache_lookup(oc_text_cache* cache, oc_font_data* font, u32 glyphIndex, u32 sizeKey, u32 subpixel)
+{
+    //NOTE: returns the glyph's entry, or the free entry it should be inserted in, or null if it is absent and the
+    //      table can't take it
+    u64 hash = ((u64)(uintptr_t)font >> 4) ^ ((u64)glyphIndex * 2654435761u) ^ ((u64)sizeKey * 40503u) ^ subpixel;
+
+    for(u32 probe = 0; probe < OC_TEXT_CACHE_ENTRY_COUNT; probe++)
+    {
+        oc_text_cache_entry* entry = &cache->entries[(hash + probe) % OC_TEXT_CACHE_ENTRY_COUNT];
+        if(!entry->used)
+        {
+            //NOTE: keep the table at most 3/4 full so that probe sequences stay short
+            if(cache->entryCount >= OC_TEXT_CACHE_ENTRY_COUNT * 3 / 4)
+            {
+                cache->full = true;
+                return (0);
+            }
+            return (entry);
+        }
+        if(entry->font == font
+           && entry->glyphIndex == glyphIndex
+           && entry->sizeKey == sizeKey
+           && entry->subpixel == subpixel)
+        {
+            return (entry);
+        }
+    }
+    return (0);
+}
+
 //------------------------------------------------------------------------------------------
 //NOTE(martin): fonts
 //------------------------------------------------------------------------------------------
@@ -399,7 +945,87 @@ oc_font_data* oc_font_data_from_handle(oc_font handle)
     return (data);
 }
 
-oc_font oc_font_create_from_memory(oc_str8 mem, u32 rangeCount, oc_unicode_range* ranges)
+static void oc_font_cache_missing_glyph(oc_font_data* fontData);
+
+static int oc_font_load_glyph_metrics(stbtt_fontinfo* stbttFontInfo, oc_glyph_data* glyph)
+{
+    //NOTE(martin): load the metrics of the glyph mapped to glyph->codePoint. Returns the stbtt glyph index,
+    //              or 0 if the codepoint is not found in the font.
+    glyph->loaded = true;
+
+    int stbttGlyphIndex = stbtt_FindGlyphIndex(stbttFontInfo, glyph->codePoint);
+    if(stbttGlyphIndex == 0)
+    {
+        glyph->exists = false;
+        return (0);
+    }
+
+    glyph->exists = true;
+    glyph->stbttGlyphIndex = stbttGlyphIndex;
+
+    int xAdvance, xBearing, x0, y0, x1, y1;
+    stbtt_GetGlyphHMetrics(stbttFontInfo, stbttGlyphIndex, &xAdvance, &xBearing);
+    stbtt_GetGlyphBox(stbttFontInfo, stbttGlyphIndex, &x0, &y0, &x1, &y1);
+
+    //NOTE(martin): stb stbtt_GetGlyphBox returns bottom left and top right corners, with y up,
+    //              so we have to set .y = -y1
+    glyph->metrics.ink = (oc_rect){
+        .x = x0,
+        .y = -y1,
+        .w = x1 - x0,
+        .h = y1 - y0
+    };
+
+    glyph->metrics.advance = (oc_vec2){ xAdvance, 0 };
+
+    return (stbttGlyphIndex);
+}
+
+static void oc_font_convert_glyph_outline(int vertexCount, stbtt_vertex* vertices, oc_path_elt* elements)
+{
+    for(int vertIndex = 0; vertIndex < vertexCount; vertIndex++)
+    {
+        f32 x = vertices[vertIndex].x;
+        f32 y = vertices[vertIndex].y;
+        f32 cx = vertices[vertIndex].cx;
+        f32 cy = vertices[vertIndex].cy;
+        f32 cx1 = vertices[vertIndex].cx1;
+        f32 cy1 = vertices[vertIndex].cy1;
+
+        switch(vertices[vertIndex].type)
+        {
+            case STBTT_vmove:
+                elements[vertIndex].type = OC_PATH_MOVE;
+                elements[vertIndex].p[0] = (oc_vec2){ x, y };
+                break;
+
+            case STBTT_vline:
+                elements[vertIndex].type = OC_PATH_LINE;
+                elements[vertIndex].p[0] = (oc_vec2){ x, y };
+                break;
+
+            case STBTT_vcurve:
+            {
+                elements[vertIndex].type = OC_PATH_QUADRATIC;
+                elements[vertIndex].p[0] = (oc_vec2){ cx, cy };
+                elements[vertIndex].p[1] = (oc_vec2){ x, y };
+            }
+            break;
+
+            case STBTT_vcubic:
+                elements[vertIndex].type = OC_PATH_CUBIC;
+                elements[vertIndex].p[0] = (oc_vec2){ cx, cy };
+                elements[vertIndex].p[1] = (oc_vec2){ cx1, cy1 };
+                elements[vertIndex].p[2] = (oc_vec2){ x, y };
+                break;
+        }
+    }
+}
+
+//NOTE: if mapped is true, mem is a file mapping and the font takes ownership of it. Lazy fonts decode glyphs
+//      directly from the mapping, so pages of the file are only read when a glyph needs them, and are shared with
+//      other fonts and processes mapping the same file. Other fonts unmap it once they're loaded.
+static oc_font oc_font_create_from_memory_internal(oc_str8 mem, bool mapped, u32 rangeCount, oc_unicode_range* ranges, bool lazy, u32 maxLoadedOutlines)
 {
     if(!oc_graphicsData.init)
     {
@@ -412,12 +1038,58 @@ oc_font oc_font_create_from_memory(oc_str8 mem, u32 rangeCount, oc_unicode_range
     {
         font = oc_arena_push_type(&oc_graphicsData.resourceArena, oc_font_data);
     }
+    if(!font && mapped)
+    {
+        oc_file_unmap(mem);
+    }
     if(font)
     {
         memset(font, 0, sizeof(oc_font_data));
-        fontHandle = oc_font_handle_alloc(font);
 
         stbtt_fontinfo stbttFontInfo;
+
+#if OC_PLATFORM_ORCA
+        //NOTE: glyph runs are measured and outlined by the runtime's copy of the font, so the guest copy
+        //      only decodes the glyphs it needs for other uses, on demand.
+        font->hostFont = oc_font_host_create(mem, rangeCount, ranges, lazy, maxLoadedOutlines);
+        if(!oc_font_is_nil(font->hostFont))
+        {
+            lazy = true;
+        }
+#endif
+
+        if(lazy && mapped)
+        {
+            font->fileData = mem;
+            font->fileMapped = true;
+            font->lazy = true;
+            font->maxLoadedOutlines = maxLoadedOutlines;
+        }
+        else if(lazy)
+        {
+            //NOTE(martin): glyphs are decoded on demand, so we keep our own copy of the font file
+            font->fileData.ptr = oc_malloc_array(char, mem.len);
+            if(!font->fileData.ptr)
+            {
+                oc_log_error("Couldn't allocate font data\n");
+#if OC_PLATFORM_ORCA
+                if(!oc_font_is_nil(font->hostFont))
+                {
+                    oc_font_host_destroy(font->hostFont);
+                }
+#endif
+                oc_list_push_front(&oc_graphicsData.fontFreeList, &font->freeListElt);
+                return (fontHandle);
+            }
+            font->fileData.len = mem.len;
+            memcpy(font->fileData.ptr, mem.ptr, mem.len);
+            mem = font->fileData;
+
+            font->lazy = true;
+            font->maxLoadedOutlines = maxLoadedOutlines;
+        }
+        fontHandle = oc_font_handle_alloc(font);
+
         stbtt_InitFont(&stbttFontInfo, (byte*)mem.ptr, 0);
 
         //NOTE(martin): load font metrics data
@@ -453,138 +1125,99 @@ oc_font oc_font_create_from_memory(oc_str8 mem, u32 rangeCount, oc_unicode_range
         }
 
         font->glyphs = oc_malloc_array(oc_glyph_data, font->glyphCount);
+        memset(font->glyphs, 0, font->glyphCount * sizeof(oc_glyph_data));
 
-        //NOTE(martin): first do a count of outlines
-        int outlineCount = 0;
         for(int rangeIndex = 0; rangeIndex < rangeCount; rangeIndex++)
         {
             oc_utf32 codePoint = font->glyphMap[rangeIndex].range.firstCodePoint;
             u32 firstGlyphIndex = font->glyphMap[rangeIndex].firstGlyphIndex;
             u32 endGlyphIndex = firstGlyphIndex + font->glyphMap[rangeIndex].range.count;
 
-            for(int glyphIndex = firstGlyphIndex;
-                glyphIndex < endGlyphIndex; glyphIndex++)
+            for(int glyphIndex = firstGlyphIndex; glyphIndex < endGlyphIndex; glyphIndex++)
             {
-                int stbttGlyphIndex = stbtt_FindGlyphIndex(&stbttFontInfo, codePoint);
-                if(stbttGlyphIndex == 0)
-                {
-                    //NOTE(martin): the codepoint is not found in the font
-                    codePoint++;
-                    continue;
-                }
-                //NOTE(martin): load glyph outlines
-                stbtt_vertex* vertices = 0;
-                outlineCount += stbtt_GetGlyphShape(&stbttFontInfo, stbttGlyphIndex, &vertices);
-                stbtt_FreeShape(&stbttFontInfo, vertices);
+                font->glyphs[glyphIndex - 1].codePoint = codePoint;
                 codePoint++;
             }
         }
-        //NOTE(martin): allocate outlines
-        font->outlines = oc_malloc_array(oc_path_elt, outlineCount);
-        font->outlineCount = 0;
 
-        //NOTE(martin): load metrics and outlines
-        for(int rangeIndex = 0; rangeIndex < rangeCount; rangeIndex++)
+        if(lazy)
         {
-            oc_utf32 codePoint = font->glyphMap[rangeIndex].range.firstCodePoint;
-            u32 firstGlyphIndex = font->glyphMap[rangeIndex].firstGlyphIndex;
-            u32 endGlyphIndex = firstGlyphIndex + font->glyphMap[rangeIndex].range.count;
-
-            for(int glyphIndex = firstGlyphIndex;
-                glyphIndex < endGlyphIndex; glyphIndex++)
+            font->stbttInfo = stbttFontInfo;
+        }
+        else
+        {
+            //NOTE(martin): load metrics and do a count of outlines
+            int outlineCount = 0;
+            for(int glyphIndex = 0; glyphIndex < font->glyphCount; glyphIndex++)
             {
-                oc_glyph_data* glyph = &(font->glyphs[glyphIndex - 1]);
-
-                int stbttGlyphIndex = stbtt_FindGlyphIndex(&stbttFontInfo, codePoint);
-                if(stbttGlyphIndex == 0)
+                oc_glyph_data* glyph = &(font->glyphs[glyphIndex]);
+                int stbttGlyphIndex = oc_font_load_glyph_metrics(&stbttFontInfo, glyph);
+                if(stbttGlyphIndex)
                 {
-                    //NOTE(martin): the codepoint is not found in the font, we zero the glyph info
-                    memset(glyph, 0, sizeof(*glyph));
-                    codePoint++;
-                    continue;
+                    stbtt_vertex* vertices = 0;
+                    outlineCount += stbtt_GetGlyphShape(&stbttFontInfo, stbttGlyphIndex, &vertices);
+                    stbtt_FreeShape(&stbttFontInfo, vertices);
                 }
+            }
 
-                glyph->exists = true;
-                glyph->codePoint = codePoint;
-
-                //NOTE(martin): load glyph metric
-                int xAdvance, xBearing, x0, y0, x1, y1;
-                stbtt_GetGlyphHMetrics(&stbttFontInfo, stbttGlyphIndex, &xAdvance, &xBearing);
-                stbtt_GetGlyphBox(&stbttFontInfo, stbttGlyphIndex, &x0, &y0, &x1, &y1);
-
-                //NOTE(martin): stb stbtt_GetGlyphBox returns bottom left and top right corners, with y up,
-                //              so we have to set .y = -y1
-                glyph->metrics.ink = (oc_rect){
-                    .x = x0,
-                    .y = -y1,
-                    .w = x1 - x0,
-                    .h = y1 - y0
-                };
-
-                glyph->metrics.advance = (oc_vec2){ xAdvance, 0 };
-
-                //NOTE(martin): load glyph outlines
+            //NOTE(martin): allocate and load outlines
+            font->outlines = oc_malloc_array(oc_path_elt, outlineCount);
+            font->outlineCount = 0;
 
+            for(int glyphIndex = 0; glyphIndex < font->glyphCount; glyphIndex++)
+            {
+                oc_glyph_data* glyph = &(font->glyphs[glyphIndex]);
+                if(!glyph->exists)
+                {
+                    continue;
+                }
                 stbtt_vertex* vertices = 0;
-                int vertexCount = stbtt_GetGlyphShape(&stbttFontInfo, stbttGlyphIndex, &vertices);
+                int vertexCount = stbtt_GetGlyphShape(&stbttFontInfo, glyph->stbttGlyphIndex, &vertices);
 
                 glyph->pathDescriptor = (oc_path_descriptor){ .startIndex = font->outlineCount,
                                                               .count = vertexCount,
                                                               .startPoint = { 0, 0 } };
-
-                oc_path_elt* elements = font->outlines + font->outlineCount;
+                glyph->outline = font->outlines + font->outlineCount;
+                glyph->outlineLoaded = true;
                 font->outlineCount += vertexCount;
-                oc_vec2 currentPos = { 0, 0 };
 
-                for(int vertIndex = 0; vertIndex < vertexCount; vertIndex++)
-                {
-                    f32 x = vertices[vertIndex].x;
-                    f32 y = vertices[vertIndex].y;
-                    f32 cx = vertices[vertIndex].cx;
-                    f32 cy = vertices[vertIndex].cy;
-                    f32 cx1 = vertices[vertIndex].cx1;
-                    f32 cy1 = vertices[vertIndex].cy1;
-
-                    switch(vertices[vertIndex].type)
-                    {
-                        case STBTT_vmove:
-                            elements[vertIndex].type = OC_PATH_MOVE;
-                            elements[vertIndex].p[0] = (oc_vec2){ x, y };
-                            break;
+                oc_font_convert_glyph_outline(vertexCount, vertices, glyph->outline);
+                stbtt_FreeShape(&stbttFontInfo, vertices);
+            }
+        }
+        oc_font_cache_missing_glyph(font);
 
-                        case STBTT_vline:
-                            elements[vertIndex].type = OC_PATH_LINE;
-                            elements[vertIndex].p[0] = (oc_vec2){ x, y };
-                            break;
-
-                        case STBTT_vcurve:
-                        {
-                            elements[vertIndex].type = OC_PATH_QUADRATIC;
-                            elements[vertIndex].p[0] = (oc_vec2){ cx, cy };
-                            elements[vertIndex].p[1] = (oc_vec2){ x, y };
-                        }
-                        break;
-
-                        case STBTT_vcubic:
-                            elements[vertIndex].type = OC_PATH_CUBIC;
-                            elements[vertIndex].p[0] = (oc_vec2){ cx, cy };
-                            elements[vertIndex].p[1] = (oc_vec2){ cx1, cy1 };
-                            elements[vertIndex].p[2] = (oc_vec2){ x, y };
-                            break;
-                    }
-                    currentPos = (oc_vec2){ x, y };
-                }
-                stbtt_FreeShape(&stbttFontInfo, vertices);
-                codePoint++;
-            }
+        if(mapped && !font->fileMapped)
+        {
+            oc_file_unmap(mem);
         }
     }
     return (fontHandle);
 }
 
-oc_font oc_font_create_from_file(oc_file file, u32 rangeCount, oc_unicode_range* ranges)
+oc_font oc_font_create_from_memory(oc_str8 mem, u32 rangeCount, oc_unicode_range* ranges)
+{
+    return (oc_font_create_from_memory_internal(mem, false, rangeCount, ranges, false, 0));
+}
+
+oc_font oc_font_create_from_memory_lazy(oc_str8 mem, u32 rangeCount, oc_unicode_range* ranges, u32 maxLoadedOutlines)
+{
+    return (oc_font_create_from_memory_internal(mem, false, rangeCount, ranges, true, maxLoadedOutlines));
+}
+
+static oc_font oc_font_create_from_file_internal(oc_file file, u32 rangeCount, oc_unicode_range* ranges, bool lazy, u32 maxLoadedOutlines)
 {
     oc_font font = oc_font_nil();
+
+#if OC_PLATFORM_ORCA
+    //NOTE: map the file rather than reading it, so that its pages are shared with the page cache
+    oc_str8 mapping = oc_file_map(file, 0, oc_file_size(file));
+    if(mapping.len)
+    {
+        return (oc_font_create_from_memory_internal(mapping, true, rangeCount, ranges, lazy, maxLoadedOutlines));
+    }
+#endif
+
     oc_arena_scope scratch = oc_scratch_begin();
 
     u64 size = oc_file_size(file);
@@ -597,17 +1230,36 @@ oc_font oc_font_create_from_file(oc_file file, u32 rangeCount, oc_unicode_range*
     }
     else
     {
-        font = oc_font_create_from_memory(oc_str8_from_buffer(size, buffer), rangeCount, ranges);
+        font = oc_font_create_from_memory_internal(oc_str8_from_buffer(size, buffer), false, rangeCount, ranges, lazy, maxLoadedOutlines);
     }
 
     oc_scratch_end(scratch);
     return (font);
 }
 
-oc_font oc_font_create_from_path(oc_str8 path, u32 rangeCount, oc_unicode_range* ranges)
+oc_font oc_font_create_from_file(oc_file file, u32 rangeCount, oc_unicode_range* ranges)
+{
+    return (oc_font_create_from_file_internal(file, rangeCount, ranges, false, 0));
+}
+
+oc_font oc_font_create_from_file_lazy(oc_file file, u32 rangeCount, oc_unicode_range* ranges, u32 maxLoadedOutlines)
+{
+    return (oc_font_create_from_file_internal(file, rangeCount, ranges, true, maxLoadedOutlines));
+}
+
+static oc_font oc_font_create_from_path_internal(oc_str8 path, u32 rangeCount, oc_unicode_range* ranges, bool lazy, u32 maxLoadedOutlines)
 {
     oc_font font = oc_font_nil();
 
+#if !OC_PLATFORM_ORCA
+    //NOTE: native file handles can't be mapped, but paths can
+    oc_str8 mapping = oc_file_map_read_only(path);
+    if(mapping.len)
+    {
+        return (oc_font_create_from_memory_internal(mapping, true, rangeCount, ranges, lazy, maxLoadedOutlines));
+    }
+#endif
+
     oc_file file = oc_file_open(path, OC_FILE_ACCESS_READ, OC_FILE_OPEN_NONE);
     if(oc_file_last_error(file) != OC_IO_OK)
     {
@@ -615,29 +1267,71 @@ oc_font oc_font_create_from_path(oc_str8 path, u32 rangeCount, oc_unicode_range*
     }
     else
     {
-        font = oc_font_create_from_file(file, rangeCount, ranges);
+        font = oc_font_create_from_file_internal(file, rangeCount, ranges, lazy, maxLoadedOutlines);
     }
     oc_file_close(file);
 
     return (font);
 }
 
+oc_font oc_font_create_from_path(oc_str8 path, u32 rangeCount, oc_unicode_range* ranges)
+{
+    return (oc_font_create_from_path_internal(path, rangeCount, ranges, false, 0));
+}
+
+oc_font oc_font_create_from_path_lazy(oc_str8 path, u32 rangeCount, oc_unicode_range* ranges, u32 maxLoadedOutlines)
+{
+    return (oc_font_create_from_path_internal(path, rangeCount, ranges, true, maxLoadedOutlines));
+}
+
 void oc_font_destroy(oc_font fontHandle)
 {
     oc_font_data* fontData = oc_font_data_from_handle(fontHandle);
     if(fontData)
     {
+        if(fontData->lazy)
+        {
+            oc_list_for(fontData->outlineLRU, glyph, oc_glyph_data, lruElt)
+            {
+                free(glyph->outline);
+            }
+            if(fontData->fileMapped)
+            {
+                oc_file_unmap(fontData->fileData);
+            }
+            else
+            {
+                free(fontData->fileData.ptr);
+            }
+        }
         free(fontData->glyphMap);
         free(fontData->glyphs);
         free(fontData->outlines);
+        free(fontData->lookupSlots);
+
+#if OC_PLATFORM_ORCA
+        if(!oc_font_is_nil(fontData->hostFont))
+        {
+            oc_font_host_destroy(fontData->hostFont);
+        }
+#endif
+
+        //NOTE: the font data can be reused by another font, so glyph slots referencing it must be dropped
+        oc_graphicsData.fontDestroyCount++;
 
         oc_list_push_front(&oc_graphicsData.fontFreeList, &fontData->freeListElt);
         oc_graphics_handle_recycle(fontHandle.h);
     }
 }
 
+static oc_str32 oc_font_collection_get_glyph_indices(oc_font_data* collection, oc_str32 codePoints, oc_str32 backing);
+
 oc_str32 oc_font_get_glyph_indices_from_font_data(oc_font_data* fontData, oc_str32 codePoints, oc_str32 backing)
 {
+    if(fontData->memberCount)
+    {
+        return (oc_font_collection_get_glyph_indices(fontData, codePoints, backing));
+    }
     u64 count = oc_min(codePoints.len, backing.len);
 
     for(int i = 0; i < count; i++)
@@ -702,7 +1396,208 @@ oc_glyph_data* oc_font_get_glyph_data(oc_font_data* fontData, u32 glyphIndex)
 {
     OC_DEBUG_ASSERT(glyphIndex);
     OC_DEBUG_ASSERT(glyphIndex < fontData->glyphCount);
-    return (&(fontData->glyphs[glyphIndex - 1]));
+
+    oc_glyph_data* glyph = &(fontData->glyphs[glyphIndex - 1]);
+    if(!glyph->loaded)
+    {
+        oc_font_load_glyph_metrics(&fontData->stbttInfo, glyph);
+    }
+    return (glyph);
+}
+
+oc_path_elt* oc_font_get_glyph_outline(oc_font_data* fontData, oc_glyph_data* glyph)
+{
+    //NOTE(martin): returns the glyph's outline elements, loading them if needed. The number of elements
+    //              is in glyph->pathDescriptor.count, and is only valid after this call for lazy fonts.
+    if(!glyph->exists)
+    {
+        return (0);
+    }
+    if(glyph->outlineLoaded)
+    {
+        if(glyph->outline && fontData->lazy)
+        {
+            oc_list_remove(&fontData->outlineLRU, &glyph->lruElt);
+            oc_list_push_front(&fontData->outlineLRU, &glyph->lruElt);
+        }
+        return (glyph->outline);
+    }
+
+    stbtt_vertex* vertices = 0;
+    int vertexCount = stbtt_GetGlyphShape(&fontData->stbttInfo, glyph->stbttGlyphIndex, &vertices);
+
+    glyph->pathDescriptor = (oc_path_descriptor){ .count = vertexCount };
+    glyph->outline = 0;
+
+    if(vertexCount)
+    {
+        if(fontData->maxLoadedOutlines && fontData->loadedOutlineCount >= fontData->maxLoadedOutlines)
+        {
+            oc_glyph_data* evicted = oc_list_pop_back_entry(&fontData->outlineLRU, oc_glyph_data, lruElt);
+            if(evicted)
+            {
+                free(evicted->outline);
+                evicted->outline = 0;
+                evicted->outlineLoaded = false;
+                fontData->loadedOutlineCount--;
+            }
+        }
+
+        glyph->outline = oc_malloc_array(oc_path_elt, vertexCount);
+        if(!glyph->outline)
+        {
+            oc_log_error("Couldn't allocate glyph outline\n");
+            glyph->pathDescriptor.count = 0;
+            stbtt_FreeShape(&fontData->stbttInfo, vertices);
+            return (0);
+        }
+        oc_font_convert_glyph_outline(vertexCount, vertices, glyph->outline);
+
+        oc_list_push_front(&fontData->outlineLRU, &glyph->lruElt);
+        fontData->loadedOutlineCount++;
+    }
+    stbtt_FreeShape(&fontData->stbttInfo, vertices);
+    glyph->outlineLoaded = true;
+
+    return (glyph->outline);
+}
+
+//------------------------------------------------------------------------------------------
+//NOTE: font collections
+//------------------------------------------------------------------------------------------
+
+oc_font oc_font_create_collection(u32 fontCount, oc_font* fonts)
+{
+    if(!oc_graphicsData.init)
+    {
+        oc_graphics_init();
+    }
+    oc_font fontHandle = oc_font_nil();
+
+    oc_font_data* first = fontCount ? oc_font_data_from_handle(fonts[0]) : 0;
+    if(!first || first->memberCount || fontCount > OC_FONT_COLLECTION_MAX_MEMBERS)
+    {
+        oc_log_error("font collections need 1 to %i fonts, the first of which is not a collection\n", OC_FONT_COLLECTION_MAX_MEMBERS);
+        return (fontHandle);
+    }
+
+    oc_font_data* font = oc_list_pop_front_entry(&oc_graphicsData.fontFreeList, oc_font_data, freeListElt);
+    if(!font)
+    {
+        font = oc_arena_push_type(&oc_graphicsData.resourceArena, oc_font_data);
+    }
+    if(font)
+    {
+        memset(font, 0, sizeof(oc_font_data));
+
+        font->lookupSlots = oc_malloc_array(oc_font_collection_slot, OC_FONT_COLLECTION_LOOKUP_SIZE);
+        if(!font->lookupSlots)
+        {
+            oc_log_error("Couldn't allocate font collection\n");
+            oc_list_push_front(&oc_graphicsData.fontFreeList, &font->freeListElt);
+            return (fontHandle);
+        }
+        memset(font->lookupSlots, 0, OC_FONT_COLLECTION_LOOKUP_SIZE * sizeof(oc_font_collection_slot));
+        font->lookupFontDestroyCount = oc_graphicsData.fontDestroyCount;
+
+        //NOTE: lines are measured with the metrics of the first member
+        font->unitsPerEm = first->unitsPerEm;
+        font->metrics = first->metrics;
+        font->missingGlyphMetrics = first->missingGlyphMetrics;
+
+        font->memberCount = fontCount;
+        memcpy(font->members, fonts, fontCount * sizeof(oc_font));
+
+        fontHandle = oc_font_handle_alloc(font);
+    }
+    return (fontHandle);
+}
+
+static oc_font_data* oc_font_collection_member(oc_font_data* collection, u32 glyphIndex)
+{
+    u32 memberIndex = glyphIndex >> OC_FONT_COLLECTION_MEMBER_SHIFT;
+    oc_font_data* member = 0;
+    if(memberIndex < collection->memberCount)
+    {
+        member = oc_font_data_from_handle(collection->members[memberIndex]);
+    }
+    return ((member && !member->memberCount) ? member : 0);
+}
+
+static u32 oc_font_collection_resolve(oc_font_data* collection, oc_utf32 codePoint)
+{
+    for(u32 memberIndex = 0; memberIndex < collection->memberCount; memberIndex++)
+    {
+        oc_font_data* member = oc_font_data_from_handle(collection->members[memberIndex]);
+        if(!member || member->memberCount)
+        {
+            continue;
+        }
+        u32 glyphIndex = oc_font_get_glyph_index_from_font_data(member, codePoint);
+        if(glyphIndex
+           && glyphIndex < member->glyphCount
+           && glyphIndex < (1 << OC_FONT_COLLECTION_MEMBER_SHIFT)
+           && oc_font_get_glyph_data(member, glyphIndex)->exists)
+        {
+            return ((memberIndex << OC_FONT_COLLECTION_MEMBER_SHIFT) | glyphIndex);
+        }
+    }
+    return (0);
+}
+
+static oc_str32 oc_font_collection_get_glyph_indices(oc_font_data* collection, oc_str32 codePoints, oc_str32 backing)
+{
+    if(collection->lookupFontDestroyCount != oc_graphicsData.fontDestroyCount)
+    {
+        //NOTE: a member may have been destroyed, or its font data reused by another font
+        memset(collection->lookupSlots, 0, OC_FONT_COLLECTION_LOOKUP_SIZE * sizeof(oc_font_collection_slot));
+        collection->lookupFontDestroyCount = oc_graphicsData.fontDestroyCount;
+    }
+
+    u64 count = oc_min(codePoints.len, backing.len);
+    for(u64 i = 0; i < count; i++)
+    {
+        oc_utf32 codePoint = codePoints.ptr[i];
+        oc_font_collection_slot* slot = &collection->lookupSlots[codePoint % OC_FONT_COLLECTION_LOOKUP_SIZE];
+        if(!slot->valid || slot->codePoint != codePoint)
+        {
+            *slot = (oc_font_collection_slot){
+                .codePoint = codePoint,
+                .glyphIndex = oc_font_collection_resolve(collection, codePoint),
+                .valid = true,
+            };
+        }
+        backing.ptr[i] = slot->glyphIndex;
+    }
+    return ((oc_str32){ .ptr = backing.ptr, .len = count });
+}
+
+static u32 oc_font_collection_next_segment(oc_font_data* collection, oc_str32 glyphIndices, u32 start, u32* backing, oc_font_data** outMember)
+{
+    //NOTE: finds the run of glyphs starting at start that come from the same member, and writes their indices in that
+    //      member to backing. Glyphs missing from all members are drawn with the member of the glyphs around them.
+    oc_font_data* member = 0;
+    u32 end = start;
+    for(; end < glyphIndices.len; end++)
+    {
+        u32 glyphIndex = glyphIndices.ptr[end];
+        if(glyphIndex)
+        {
+            oc_font_data* glyphMember = oc_font_collection_member(collection, glyphIndex);
+            if(member && glyphMember != member)
+            {
+                break;
+            }
+            member = glyphMember;
+        }
+        backing[end] = glyphIndex & ((1 << OC_FONT_COLLECTION_MEMBER_SHIFT) - 1);
+    }
+    if(!member)
+    {
+        member = oc_font_collection_member(collection, 0);
+    }
+    *outMember = member;
+    return (end);
 }
 
 oc_font_metrics oc_font_get_metrics_unscaled(oc_font font)
@@ -761,6 +1656,44 @@ void oc_font_get_glyph_metrics_from_font_data(oc_font_data* fontData,
     }
 }
 
+static void oc_font_cache_missing_glyph(oc_font_data* fontData)
+{
+    //NOTE(martin): find the replacement character, or the metrics of the empty rectangle drawn in place of missing glyphs
+    fontData->replacementGlyphIndex = oc_font_get_glyph_index_from_font_data(fontData, 0xfffd);
+    fontData->missingGlyphMetrics = (oc_glyph_metrics){ 0 };
+
+    if(fontData->replacementGlyphIndex)
+    {
+        oc_font_get_glyph_metrics_from_font_data(fontData,
+                                                 (oc_str32){ .ptr = &fontData->replacementGlyphIndex, .len = 1 },
+                                                 &fontData->missingGlyphMetrics);
+    }
+    else
+    {
+        //NOTE(martin): could not find replacement glyph, try to get an 'X' to get a somewhat correct dimensions
+        //              to render an empty rectangle. Otherwise just render with the max font width
+        u32 missingGlyphIndex = oc_font_get_glyph_index_from_font_data(fontData, 'X');
+        if(missingGlyphIndex)
+        {
+            oc_font_get_glyph_metrics_from_font_data(fontData,
+                                                     (oc_str32){ .ptr = &missingGlyphIndex, .len = 1 },
+                                                     &fontData->missingGlyphMetrics);
+        }
+        else
+        {
+            fontData->missingGlyphMetrics = (oc_glyph_metrics){
+                .ink = {
+                    .x = fontData->metrics.width * 0.1,
+                    .y = -fontData->metrics.ascent,
+                    .w = fontData->metrics.width * 0.8,
+                    .h = fontData->metrics.ascent,
+                },
+                .advance = { .x = fontData->metrics.width, .y = 0 },
+            };
+        }
+    }
+}
+
 /*
 int oc_font_get_glyph_metrics(oc_font font, oc_str32 glyphIndices, oc_text_metrics* outMetrics)
 {
@@ -791,54 +1724,79 @@ int oc_font_get_codepoint_metrics(oc_font font, oc_utf32 codePoint, oc_text_metr
 
 /////////////////////////////////////////////////
 
-oc_text_metrics oc_font_text_metrics_utf32(oc_font font, f32 fontSize, oc_str32 codePoints)
-{
-    if(!codePoints.len || !codePoints.ptr)
-    {
-        return ((oc_text_metrics){ 0 });
-    }
+static oc_text_metrics oc_glyph_run_metrics_from_font_data(oc_font_data* fontData, f32 fontSize, oc_str32 glyphIndices);
 
-    oc_font_data* fontData = oc_font_data_from_handle(font);
-    if(!fontData)
-    {
-        return ((oc_text_metrics){ 0 });
-    }
+static oc_text_metrics oc_font_collection_glyph_run_metrics(oc_font_data* collection, f32 fontSize, oc_str32 glyphIndices)
+{
+    //NOTE: measure the runs of glyphs coming from the same member, and place their extents one after the other
+    oc_text_metrics metrics = { 0 };
+    oc_vec2 pen = { 0, 0 };
+    bool first = true;
 
     oc_arena_scope scratch = oc_scratch_begin();
-    oc_str32 glyphIndices = oc_font_push_glyph_indices(scratch.arena, font, codePoints);
-
-    //NOTE(martin): find width of missing character
-    //TODO(martin): should cache that at font creation...
-    oc_glyph_metrics missingGlyphMetrics = { 0 };
-    u32 missingGlyphIndex = oc_font_get_glyph_index_from_font_data(fontData, 0xfffd);
+    u32* memberIndices = oc_arena_push_array(scratch.arena, u32, glyphIndices.len);
 
-    if(missingGlyphIndex)
-    {
-        oc_font_get_glyph_metrics_from_font_data(fontData, (oc_str32){ .ptr = &missingGlyphIndex, .len = 1 }, &missingGlyphMetrics);
-    }
-    else
+    u32 start = 0;
+    while(start < glyphIndices.len)
     {
-        //NOTE(martin): could not find replacement glyph, try to get an 'X' to get a somewhat correct dimensions
-        //              to render an empty rectangle. Otherwise just render with the max font width
-
-        missingGlyphIndex = oc_font_get_glyph_index_from_font_data(fontData, 'X');
-        if(missingGlyphIndex)
-        {
-            oc_font_get_glyph_metrics_from_font_data(fontData, (oc_str32){ .ptr = &missingGlyphIndex, .len = 1 }, &missingGlyphMetrics);
-        }
-        else
+        oc_font_data* member = 0;
+        u32 end = oc_font_collection_next_segment(collection, glyphIndices, start, memberIndices, &member);
+        if(member)
         {
-            missingGlyphMetrics = (oc_glyph_metrics){
-                .ink = {
-                    .x = fontData->metrics.width * 0.1,
-                    .y = -fontData->metrics.ascent,
-                    .w = fontData->metrics.width * 0.8,
-                    .h = fontData->metrics.ascent,
-                },
-                .advance = { .x = fontData->metrics.width, .y = 0 },
-            };
+            oc_str32 glyphs = { .ptr = memberIndices + start, .len = end - start };
+            oc_text_metrics run = oc_glyph_run_metrics_from_font_data(member, fontSize, glyphs);
+
+            oc_rect ink = { pen.x + run.ink.x, pen.y + run.ink.y, run.ink.w, run.ink.h };
+            oc_rect logical = { pen.x + run.logical.x, pen.y + run.logical.y, run.logical.w, run.logical.h };
+            if(first)
+            {
+                metrics.ink = ink;
+                metrics.logical = logical;
+                first = false;
+            }
+            else
+            {
+                f32 inkX1 = oc_max(metrics.ink.x + metrics.ink.w, ink.x + ink.w);
+                f32 inkY1 = oc_max(metrics.ink.y + metrics.ink.h, ink.y + ink.h);
+                metrics.ink.x = oc_min(metrics.ink.x, ink.x);
+                metrics.ink.y = oc_min(metrics.ink.y, ink.y);
+                metrics.ink.w = inkX1 - metrics.ink.x;
+                metrics.ink.h = inkY1 - metrics.ink.y;
+
+                f32 logicalX1 = oc_max(metrics.logical.x + metrics.logical.w, logical.x + logical.w);
+                f32 logicalY1 = oc_max(metrics.logical.y + metrics.logical.h, logical.y + logical.h);
+                metrics.logical.x = oc_min(metrics.logical.x, logical.x);
+                metrics.logical.y = oc_min(metrics.logical.y, logical.y);
+                metrics.logical.w = logicalX1 - metrics.logical.x;
+                metrics.logical.h = logicalY1 - metrics.logical.y;
+            }
+
+            //NOTE: a run containing a line feed ends on a new line, at its own horizontal advance
+            if(run.advance.y != 0)
+            {
+                pen.x = run.advance.x;
+                pen.y += run.advance.y;
+            }
+            else
+            {
+                pen.x += run.advance.x;
+            }
         }
+        start = end;
+    }
+    oc_scratch_end(scratch);
+
+    metrics.advance = pen;
+    return (metrics);
+}
+
+static oc_text_metrics oc_glyph_run_metrics_from_font_data(oc_font_data* fontData, f32 fontSize, oc_str32 glyphIndices)
+{
+    if(fontData->memberCount)
+    {
+        return (oc_font_collection_glyph_run_metrics(fontData, fontSize, glyphIndices));
     }
+    oc_glyph_metrics missingGlyphMetrics = fontData->missingGlyphMetrics;
 
     //NOTE(martin): accumulate text extents
     oc_text_metrics metrics = { 0 };
@@ -899,7 +1857,7 @@ oc_text_metrics oc_font_text_metrics_utf32(oc_font font, f32 fontSize, oc_str32
 
     OC_ASSERT(metrics.ink.y <= 0);
 
-    f32 fontScale = oc_font_get_scale_for_em_pixels(font, fontSize);
+    f32 fontScale = fontSize / fontData->unitsPerEm;
 
     metrics.ink.x *= fontScale;
     metrics.ink.y *= fontScale;
@@ -912,34 +1870,441 @@ oc_text_metrics oc_font_text_metrics_utf32(oc_font font, f32 fontSize, oc_str32
     metrics.advance.x *= fontScale;
     metrics.advance.y *= fontScale;
 
-    oc_scratch_end(scratch);
     return (metrics);
 }
 
-oc_text_metrics oc_font_text_metrics(oc_font font, f32 fontSize, oc_str8 text)
+#if !OC_PLATFORM_ORCA
+oc_text_metrics oc_font_glyph_run_metrics(oc_font font, f32 fontSize, u32 glyphCount, u32* glyphIndices)
 {
-    if(!text.len || !text.ptr)
+    oc_font_data* fontData = oc_font_data_from_handle(font);
+    if(!fontData)
     {
         return ((oc_text_metrics){ 0 });
     }
-
-    oc_arena_scope scratch = oc_scratch_begin();
-    oc_str32 codePoints = oc_utf8_push_to_codepoints(scratch.arena, text);
-    oc_text_metrics result = oc_font_text_metrics_utf32(font, fontSize, codePoints);
-    oc_scratch_end(scratch);
-    return (result);
+    return (oc_glyph_run_metrics_from_font_data(fontData, fontSize, (oc_str32){ .ptr = glyphIndices, .len = glyphCount }));
 }
+#endif
 
-//------------------------------------------------------------------------------------------
-//NOTE(martin): canvas context API
-//------------------------------------------------------------------------------------------
-
-oc_canvas_context oc_canvas_context_handle_alloc(oc_canvas_context_data* context)
+oc_text_metrics oc_font_text_metrics_utf32(oc_font font, f32 fontSize, oc_str32 codePoints)
 {
-    oc_canvas_context handle = { .h = oc_graphics_handle_alloc(OC_GRAPHICS_HANDLE_CANVAS_CONTEXT, (void*)context) };
-    return (handle);
-}
-
+    if(!codePoints.len || !codePoints.ptr)
+    {
+        return ((oc_text_metrics){ 0 });
+    }
+
+    oc_font_data* fontData = oc_font_data_from_handle(font);
+    if(!fontData)
+    {
+        return ((oc_text_metrics){ 0 });
+    }
+
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_str32 glyphIndices = oc_font_push_glyph_indices(scratch.arena, font, codePoints);
+
+    oc_text_metrics metrics = { 0 };
+#if OC_PLATFORM_ORCA
+    if(!oc_font_is_nil(fontData->hostFont))
+    {
+        metrics = oc_font_glyph_run_metrics(fontData->hostFont, fontSize, glyphIndices.len, glyphIndices.ptr);
+    }
+    else
+#endif
+    {
+        metrics = oc_glyph_run_metrics_from_font_data(fontData, fontSize, glyphIndices);
+    }
+
+    oc_scratch_end(scratch);
+    return (metrics);
+}
+
+oc_text_metrics oc_font_text_metrics(oc_font font, f32 fontSize, oc_str8 text)
+{
+    if(!text.len || !text.ptr)
+    {
+        return ((oc_text_metrics){ 0 });
+    }
+
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_str32 codePoints = oc_utf8_push_to_codepoints(scratch.arena, text);
+    oc_text_metrics result = oc_font_text_metrics_utf32(font, fontSize, codePoints);
+    oc_scratch_end(scratch);
+    return (result);
+}
+
+//------------------------------------------------------------------------------------------
+//NOTE: paragraph layout
+//------------------------------------------------------------------------------------------
+
+static f32 oc_font_data_glyph_advance(oc_font_data* fontData, f32 fontSize, u32 glyphIndex)
+{
+    if(fontData->memberCount)
+    {
+        //NOTE: members can have different units per em, so each glyph is scaled by its own font
+        oc_font_data* member = oc_font_collection_member(fontData, glyphIndex);
+        if(!member)
+        {
+            return (fontData->missingGlyphMetrics.advance.x * fontSize / fontData->unitsPerEm);
+        }
+        fontData = member;
+        glyphIndex &= (1 << OC_FONT_COLLECTION_MEMBER_SHIFT) - 1;
+    }
+    f32 advance = fontData->missingGlyphMetrics.advance.x;
+    if(glyphIndex && glyphIndex < fontData->glyphCount)
+    {
+        advance = oc_font_get_glyph_data(fontData, glyphIndex)->metrics.advance.x;
+    }
+    return (advance * fontSize / fontData->unitsPerEm);
+}
+
+static bool oc_text_layout_is_space(oc_utf32 codePoint)
+{
+    return (codePoint == ' ' || codePoint == '\t');
+}
+
+static oc_glyph_run_layout oc_glyph_run_layout_from_font_data(oc_font_data* fontData,
+                                                              f32 fontSize,
+                                                              f32 maxWidth,
+                                                              oc_text_align align,
+                                                              u32 glyphCount,
+                                                              u32* codePoints,
+                                                              u32* glyphIndices,
+                                                              oc_vec2* positions,
+                                                              u32 lineCap,
+                                                              oc_text_line* lines)
+{
+    oc_glyph_run_layout layout = { 0 };
+
+    f32 fontScale = fontSize / fontData->unitsPerEm;
+    f32 lineHeight = (fontData->metrics.ascent + fontData->metrics.descent + fontData->metrics.lineGap) * fontScale;
+    f32 firstBaseline = (fontData->metrics.ascent + fontData->metrics.lineGap) * fontScale;
+
+    u32 lineStart = 0;
+    f32 penX = 0;
+    f32 lineWidth = 0;  // width of the line up to its last non-space glyph
+    u32 breakIndex = 0; // first glyph after the line's last run of spaces, or lineStart if there is none
+    f32 breakWidth = 0; // width of the line before that run of spaces
+
+    for(u32 i = 0; i <= glyphCount && layout.lineCount < lineCap; i++)
+    {
+        bool end = (i == glyphCount);
+        oc_utf32 codePoint = end ? 0 : codePoints[i];
+        f32 advance = end ? 0 : oc_font_data_glyph_advance(fontData, fontSize, glyphIndices[i]);
+        bool space = oc_text_layout_is_space(codePoint);
+
+        if(!end && !space && i > lineStart && oc_text_layout_is_space(codePoints[i - 1]))
+        {
+            breakIndex = i;
+            breakWidth = lineWidth;
+        }
+
+        u32 lineEnd = i;
+        f32 endWidth = lineWidth;
+        bool newLine = false;
+
+        if(end)
+        {
+            newLine = (lineStart < glyphCount);
+        }
+        else if(codePoint == '\n')
+        {
+            positions[i] = (oc_vec2){ penX, 0 };
+            lineEnd = i + 1;
+            newLine = true;
+        }
+        else if(!space && maxWidth > 0 && penX + advance > maxWidth && i > lineStart)
+        {
+            //NOTE: break after the last run of spaces, or before this glyph if the line is a single word
+            if(breakIndex > lineStart)
+            {
+                lineEnd = breakIndex;
+                endWidth = breakWidth;
+            }
+            newLine = true;
+        }
+
+        if(newLine)
+        {
+            f32 baseline = firstBaseline + layout.lineCount * lineHeight;
+            lines[layout.lineCount] = (oc_text_line){
+                .start = lineStart,
+                .count = lineEnd - lineStart,
+                .width = endWidth,
+                .origin = { 0, baseline },
+            };
+            for(u32 j = lineStart; j < lineEnd; j++)
+            {
+                positions[j].y = baseline;
+            }
+            layout.lineCount++;
+            layout.size.x = oc_max(layout.size.x, endWidth);
+
+            //NOTE: the glyphs after the break move to the next line
+            lineStart = lineEnd;
+            penX = 0;
+            lineWidth = 0;
+            breakIndex = lineStart;
+            for(u32 j = lineStart; j < i; j++)
+            {
+                positions[j].x = penX;
+                penX += oc_font_data_glyph_advance(fontData, fontSize, glyphIndices[j]);
+            }
+            lineWidth = penX;
+
+            if(end || codePoint == '\n')
+            {
+                continue;
+            }
+        }
+
+        positions[i] = (oc_vec2){ penX, 0 };
+        penX += advance;
+        if(!space)
+        {
+            lineWidth = penX;
+        }
+    }
+    layout.size.y = layout.lineCount * lineHeight;
+
+    //NOTE: align the lines once the width of the paragraph is known
+    f32 alignWidth = (maxWidth > 0) ? maxWidth : layout.size.x;
+    for(u32 lineIndex = 0; lineIndex < layout.lineCount; lineIndex++)
+    {
+        oc_text_line* line = &lines[lineIndex];
+        f32 offset = 0;
+        if(align == OC_TEXT_ALIGN_CENTER)
+        {
+            offset = (alignWidth - line->width) / 2;
+        }
+        else if(align == OC_TEXT_ALIGN_RIGHT)
+        {
+            offset = alignWidth - line->width;
+        }
+        line->origin.x = offset;
+        for(u32 j = line->start; j < line->start + line->count; j++)
+        {
+            positions[j].x += offset;
+        }
+    }
+    return (layout);
+}
+
+#if !OC_PLATFORM_ORCA
+oc_glyph_run_layout oc_font_glyph_run_layout(oc_font font,
+                                             f32 fontSize,
+                                             f32 maxWidth,
+                                             oc_text_align align,
+                                             u32 glyphCount,
+                                             u32* codePoints,
+                                             u32* glyphIndices,
+                                             oc_vec2* positions,
+                                             u32 lineCap,
+                                             oc_text_line* lines)
+{
+    oc_font_data* fontData = oc_font_data_from_handle(font);
+    if(!fontData)
+    {
+        return ((oc_glyph_run_layout){ 0 });
+    }
+    return (oc_glyph_run_layout_from_font_data(fontData,
+                                               fontSize,
+                                               maxWidth,
+                                               align,
+                                               glyphCount,
+                                               codePoints,
+                                               glyphIndices,
+                                               positions,
+                                               lineCap,
+                                               lines));
+}
+#endif
+
+static oc_text_layout_cache_entry* oc_text_layout_cache_find(u64 key, oc_font font, f32 fontSize, f32 maxWidth, oc_text_align align, oc_str8 text)
+{
+    for(u32 i = 0; i < OC_TEXT_LAYOUT_CACHE_SIZE; i++)
+    {
+        oc_text_layout_cache_entry* entry = &oc_graphicsData.textLayoutCache[i];
+        if(entry->key == key
+           && entry->block
+           && entry->font.h == font.h
+           && entry->fontSize == fontSize
+           && entry->maxWidth == maxWidth
+           && entry->align == align
+           && !oc_str8_cmp(entry->text, text))
+        {
+            return (entry);
+        }
+    }
+    return (0);
+}
+
+static oc_text_layout_cache_entry* oc_text_layout_cache_insert(u64 key,
+                                                               oc_font font,
+                                                               f32 fontSize,
+                                                               f32 maxWidth,
+                                                               oc_text_align align,
+                                                               oc_str8 text,
+                                                               oc_text_layout* layout)
+{
+    //NOTE: replace the least recently used entry
+    oc_text_layout_cache_entry* entry = &oc_graphicsData.textLayoutCache[0];
+    for(u32 i = 1; i < OC_TEXT_LAYOUT_CACHE_SIZE; i++)
+    {
+        if(oc_graphicsData.textLayoutCache[i].lastUse < entry->lastUse)
+        {
+            entry = &oc_graphicsData.textLayoutCache[i];
+        }
+    }
+    free(entry->block);
+    memset(entry, 0, sizeof(oc_text_layout_cache_entry));
+
+    u64 count = layout->codePointCount;
+    u64 size = text.len
+             + count * (sizeof(oc_utf32) + sizeof(u32) + sizeof(oc_vec2))
+             + layout->lineCount * sizeof(oc_text_line);
+
+    char* block = malloc(size);
+    if(!block)
+    {
+        return (0);
+    }
+
+    //NOTE: the arrays are stored before the text, so that they stay aligned
+    oc_text_layout* cached = &entry->layout;
+    *cached = *layout;
+    cached->positions = (oc_vec2*)block;
+    cached->lines = (oc_text_line*)(cached->positions + count);
+    cached->codePoints = (oc_utf32*)(cached->lines + layout->lineCount);
+    cached->glyphIndices = (u32*)(cached->codePoints + count);
+
+    memcpy(cached->positions, layout->positions, count * sizeof(oc_vec2));
+    memcpy(cached->lines, layout->lines, layout->lineCount * sizeof(oc_text_line));
+    memcpy(cached->codePoints, layout->codePoints, count * sizeof(oc_utf32));
+    memcpy(cached->glyphIndices, layout->glyphIndices, count * sizeof(u32));
+
+    entry->text = oc_str8_from_buffer(text.len, (char*)(cached->glyphIndices + count));
+    memcpy(entry->text.ptr, text.ptr, text.len);
+
+    entry->block = block;
+    entry->key = key;
+    entry->font = font;
+    entry->fontSize = fontSize;
+    entry->maxWidth = maxWidth;
+    entry->align = align;
+    return (entry);
+}
+
+static oc_text_layout oc_text_layout_copy(oc_arena* arena, oc_text_layout* src)
+{
+    oc_text_layout layout = *src;
+    u32 count = src->codePointCount;
+
+    layout.codePoints = oc_arena_push_array(arena, oc_utf32, count);
+    layout.glyphIndices = oc_arena_push_array(arena, u32, count);
+    layout.positions = oc_arena_push_array(arena, oc_vec2, count);
+    layout.lines = oc_arena_push_array(arena, oc_text_line, src->lineCount);
+
+    memcpy(layout.codePoints, src->codePoints, count * sizeof(oc_utf32));
+    memcpy(layout.glyphIndices, src->glyphIndices, count * sizeof(u32));
+    memcpy(layout.positions, src->positions, count * sizeof(oc_vec2));
+    memcpy(layout.lines, src->lines, src->lineCount * sizeof(oc_text_line));
+
+    return (layout);
+}
+
+oc_text_layout oc_font_push_text_layout(oc_arena* arena, oc_font font, f32 fontSize, oc_str8 text, f32 maxWidth, oc_text_align align)
+{
+    oc_text_layout layout = { .font = font, .fontSize = fontSize };
+
+    oc_font_data* fontData = oc_font_data_from_handle(font);
+    if(!fontData || !text.len || !text.ptr)
+    {
+        return (layout);
+    }
+
+    //NOTE: font handles carry a generation, so entries of destroyed fonts are never hit and age out of the cache
+    u64 key = oc_hash_xx64_string_seed(text, font.h);
+    oc_text_layout_cache_entry* entry = oc_text_layout_cache_find(key, font, fontSize, maxWidth, align, text);
+    if(entry)
+    {
+        layout = oc_text_layout_copy(arena, &entry->layout);
+    }
+    else
+    {
+        oc_arena_scope scratch = oc_scratch_begin_next(arena);
+
+        oc_str32 codePoints = oc_utf8_push_to_codepoints(scratch.arena, text);
+        oc_str32 glyphIndices = oc_font_push_glyph_indices(scratch.arena, font, codePoints);
+        u32 count = codePoints.len;
+
+        //NOTE: each glyph can start a line, so there are at most count lines
+        oc_vec2* positions = oc_arena_push_array(scratch.arena, oc_vec2, count);
+        oc_text_line* lines = oc_arena_push_array(scratch.arena, oc_text_line, count);
+
+        oc_glyph_run_layout run = { 0 };
+#if OC_PLATFORM_ORCA
+        if(!oc_font_is_nil(fontData->hostFont))
+        {
+            run = oc_font_glyph_run_layout(fontData->hostFont,
+                                           fontSize,
+                                           maxWidth,
+                                           align,
+                                           count,
+                                           codePoints.ptr,
+                                           glyphIndices.ptr,
+                                           positions,
+                                           count,
+                                           lines);
+        }
+        else
+#endif
+        {
+            run = oc_glyph_run_layout_from_font_data(fontData,
+                                                     fontSize,
+                                                     maxWidth,
+                                                     align,
+                                                     count,
+                                                     codePoints.ptr,
+                                                     glyphIndices.ptr,
+                                                     positions,
+                                                     count,
+                                                     lines);
+        }
+
+        oc_text_layout computed = {
+            .font = font,
+            .fontSize = fontSize,
+            .size = run.size,
+            .codePointCount = count,
+            .codePoints = codePoints.ptr,
+            .glyphIndices = glyphIndices.ptr,
+            .positions = positions,
+            .lineCount = run.lineCount,
+            .lines = lines,
+        };
+        layout = oc_text_layout_copy(arena, &computed);
+
+        entry = oc_text_layout_cache_insert(key, font, fontSize, maxWidth, align, text, &computed);
+
+        oc_scratch_end(scratch);
+    }
+    if(entry)
+    {
+        oc_graphicsData.textLayoutClock++;
+        entry->lastUse = oc_graphicsData.textLayoutClock;
+    }
+    return (layout);
+}
+
+//------------------------------------------------------------------------------------------
+//NOTE(martin): canvas context API
+//------------------------------------------------------------------------------------------
+
+oc_canvas_context oc_canvas_context_handle_alloc(oc_canvas_context_data* context)
+{
+    oc_canvas_context handle = { .h = oc_graphics_handle_alloc(OC_GRAPHICS_HANDLE_CANVAS_CONTEXT, (void*)context) };
+    return (handle);
+}
+
 oc_canvas_context_data* oc_canvas_context_from_handle(oc_canvas_context handle)
 {
     oc_canvas_context_data* context = oc_graphics_data_from_handle(OC_GRAPHICS_HANDLE_CANVAS_CONTEXT, handle.h);
@@ -962,13 +2327,48 @@ oc_canvas_context oc_canvas_context_create()
     if(context)
     {
         context->textFlip = false;
+        context->polylineDecimation = 0;
         context->path = (oc_path_descriptor){ 0 };
         context->matrixStackSize = 0;
         context->clipStackSize = 0;
+        context->clipPathStackSize = 0;
+        context->clipPathDepth = 0;
         context->primitiveCount = 0;
         context->clearColor = (oc_color){ 0, 0, 0, 0 };
+        context->damage = (oc_rect){ 0 };
         context->msaaSampleCount = 8;
 
+        //NOTE: command buffers start small and grow on demand
+        context->pathElementCap = OC_CANVAS_DEFAULT_PATH_ELEMENT_CAP;
+        context->pathElements = oc_malloc_array(oc_path_elt, context->pathElementCap);
+        context->primitiveCap = OC_CANVAS_DEFAULT_PRIMITIVE_CAP;
+        context->primitives = oc_malloc_array(oc_primitive, context->primitiveCap);
+        context->attributeCount = 0;
+        context->attributeCap = OC_CANVAS_DEFAULT_ATTRIBUTE_CAP;
+        context->attributeTable = oc_malloc_array(oc_attributes, context->attributeCap);
+        if(!context->pathElements || !context->primitives || !context->attributeTable)
+        {
+            oc_log_error("couldn't allocate canvas command buffers\n");
+            free(context->pathElements);
+            free(context->primitives);
+            free(context->attributeTable);
+            context->pathElements = 0;
+            context->primitives = 0;
+            context->attributeTable = 0;
+            context->pathElementCap = 0;
+            context->primitiveCap = 0;
+            context->attributeCap = 0;
+            oc_list_push_front(&oc_graphicsData.canvasFreeList, &context->freeListElt);
+            return (contextHandle);
+        }
+        context->pathElementHighWater = 0;
+        context->primitiveHighWater = 0;
+        context->attributeHighWater = 0;
+        context->shrinkFrameCount = 0;
+        context->recording = false;
+        context->textCache = 0;
+        oc_canvas_glyph_slots_reset(context);
+
         context->attributes = (oc_attributes){ 0 };
         context->attributes.hasGradient = false;
         context->attributes.colors[0] = (oc_color){ 0, 0, 0, 1 };
@@ -993,6 +2393,21 @@ void oc_canvas_context_destroy(oc_canvas_context handle)
             oc_currentCanvasContext = 0;
             oc_currentCanvasContextHandle = oc_canvas_context_nil();
         }
+        free(context->pathElements);
+        free(context->primitives);
+        free(context->attributeTable);
+        if(context->textCache)
+        {
+            oc_text_cache_destroy(context->textCache);
+            context->textCache = 0;
+        }
+        context->pathElements = 0;
+        context->primitives = 0;
+        context->attributeTable = 0;
+        context->pathElementCap = 0;
+        context->primitiveCap = 0;
+        context->attributeCap = 0;
+
         oc_list_push_front(&oc_graphicsData.canvasFreeList, &context->freeListElt);
         oc_graphics_handle_recycle(handle.h);
     }
@@ -1015,6 +2430,21 @@ void oc_canvas_context_set_msaa_sample_count(oc_canvas_context handle, u32 sampl
     }
 }
 
+//NOTE: starts a new frame once the context's commands were submitted to a surface
+static void oc_canvas_context_end_frame(oc_canvas_context_data* context, u32 eltCount)
+{
+    oc_canvas_context_update_buffers(context, eltCount);
+
+    context->primitiveCount = 0;
+    context->attributeCount = 0;
+    context->path.startIndex = 0;
+    context->path.count = 0;
+    context->clear = false;
+    oc_canvas_glyph_slots_reset(context);
+    oc_text_cache_end_frame(context);
+    context->damage = (oc_rect){ 0 };
+}
+
 void oc_canvas_render(oc_canvas_renderer rendererHandle, oc_canvas_context contextHandle, oc_surface surfaceHandle)
 {
     oc_canvas_context_data* context = oc_canvas_context_from_handle(contextHandle);
@@ -1028,876 +2458,2969 @@ void oc_canvas_render(oc_canvas_renderer rendererHandle, oc_canvas_context conte
                                   context->msaaSampleCount,
                                   context->clear,
                                   context->clearColor,
+                                  context->damage,
                                   context->primitiveCount,
                                   context->primitives,
+                                  context->attributeCount,
+                                  context->attributeTable,
                                   eltCount,
                                   context->pathElements);
 
+        oc_canvas_context_end_frame(context, eltCount);
+    }
+}
+
+#if !OC_PLATFORM_ORCA
+void oc_canvas_render_many(oc_canvas_renderer rendererHandle, u32 count, oc_canvas_context* contexts, oc_surface* surfaces)
+{
+    if(oc_canvas_renderer_is_nil(rendererHandle) || !count)
+    {
+        return;
+    }
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_canvas_submission* submissions = oc_arena_push_array(scratch.arena, oc_canvas_submission, count);
+    oc_canvas_context_data** submittedContexts = oc_arena_push_array(scratch.arena, oc_canvas_context_data*, count);
+    u32 submissionCount = 0;
+
+    for(u32 i = 0; i < count; i++)
+    {
+        oc_canvas_context_data* context = oc_canvas_context_from_handle(contexts[i]);
+        if(context && !oc_surface_is_nil(surfaces[i]))
+        {
+            submissions[submissionCount] = (oc_canvas_submission){
+                .surface = surfaces[i],
+                .msaaSampleCount = context->msaaSampleCount,
+                .clear = context->clear,
+                .clearColor = context->clearColor,
+                .damage = context->damage,
+                .primitiveCount = context->primitiveCount,
+                .primitives = context->primitives,
+                .attributeCount = context->attributeCount,
+                .attributes = context->attributeTable,
+                .eltCount = context->path.startIndex + context->path.count,
+                .elements = context->pathElements,
+            };
+            submittedContexts[submissionCount] = context;
+            submissionCount++;
+        }
+    }
+
+    oc_canvas_renderer_submit_many(rendererHandle, submissionCount, submissions);
+
+    for(u32 i = 0; i < submissionCount; i++)
+    {
+        oc_canvas_context_end_frame(submittedContexts[i], submissions[i].eltCount);
+    }
+
+    oc_scratch_end(scratch);
+}
+#endif
+
+void oc_canvas_render_image(oc_canvas_renderer rendererHandle, oc_canvas_context contextHandle, oc_image image)
+{
+    oc_canvas_context_data* context = oc_canvas_context_from_handle(contextHandle);
+
+    if(context && !oc_canvas_renderer_is_nil(rendererHandle) && !oc_image_is_nil(image))
+    {
+        int eltCount = context->path.startIndex + context->path.count;
+
+        oc_canvas_renderer_submit_image(rendererHandle,
+                                        image,
+                                        context->msaaSampleCount,
+                                        context->clear,
+                                        context->clearColor,
+                                        context->primitiveCount,
+                                        context->primitives,
+                                        context->attributeCount,
+                                        context->attributeTable,
+                                        eltCount,
+                                        context->pathElements);
+
+        oc_canvas_context_update_buffers(context, eltCount);
+
         context->primitiveCount = 0;
+        context->attributeCount = 0;
         context->path.startIndex = 0;
         context->path.count = 0;
         context->clear = false;
+        oc_canvas_glyph_slots_reset(context);
+        oc_text_cache_end_frame(context);
     }
 }
 
 //------------------------------------------------------------------------------------------
-//NOTE(martin): transform, viewport and clipping
+//NOTE(martin): display lists
 //------------------------------------------------------------------------------------------
 
-void oc_matrix_push(oc_mat2x3 matrix)
+oc_display_list oc_display_list_nil(void)
 {
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
-    {
-        oc_matrix_stack_push(context, matrix);
-    }
+    return ((oc_display_list){ .h = 0 });
 }
 
-void oc_matrix_multiply_push(oc_mat2x3 matrix)
+bool oc_display_list_is_nil(oc_display_list list)
 {
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
-    {
-        oc_mat2x3 transform = oc_matrix_stack_top(context);
-        oc_matrix_stack_push(context, oc_mat2x3_mul_m(transform, matrix));
-    }
+    return (list.h == 0);
 }
 
-void oc_matrix_pop()
+oc_display_list oc_display_list_handle_alloc(oc_display_list_data* list)
 {
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
-    {
-        oc_matrix_stack_pop(context);
-    }
+    oc_display_list handle = { .h = oc_graphics_handle_alloc(OC_GRAPHICS_HANDLE_DISPLAY_LIST, (void*)list) };
+    return (handle);
 }
 
-oc_mat2x3 oc_matrix_top()
+oc_display_list_data* oc_display_list_from_handle(oc_display_list handle)
+{
+    oc_display_list_data* list = oc_graphics_data_from_handle(OC_GRAPHICS_HANDLE_DISPLAY_LIST, handle.h);
+    return (list);
+}
+
+void oc_display_list_begin_record(void)
 {
-    oc_mat2x3 mat = {
-        1, 0, 0,
-        0, 1, 0
-    };
     oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    if(!context)
     {
-        mat = oc_matrix_stack_top(context);
+        return;
     }
-
-    return (mat);
+    if(context->recording)
+    {
+        oc_log_error("display list recording already in progress\n");
+        return;
+    }
+    //NOTE: save the current path and record into a new one. Commands issued until
+    //      oc_display_list_end_record() are captured in the list and not drawn.
+    context->recording = true;
+    context->recordSavedPath = context->path;
+    context->recordSavedSubPathStartPoint = context->subPathStartPoint;
+    context->recordSavedSubPathLastPoint = context->subPathLastPoint;
+
+    context->recordPrimitiveStart = context->primitiveCount;
+    context->recordAttributeStart = context->attributeCount;
+    context->recordEltStart = context->path.startIndex + context->path.count;
+
+    context->path = (oc_path_descriptor){ .startIndex = context->recordEltStart };
+    context->subPathStartPoint = (oc_vec2){ 0, 0 };
+    context->subPathLastPoint = (oc_vec2){ 0, 0 };
+
+    //NOTE: recorded primitives can only reference elements pushed during the recording
+    oc_canvas_glyph_slots_reset(context);
 }
 
-void oc_clip_push(f32 x, f32 y, f32 w, f32 h)
+oc_display_list oc_display_list_end_record(void)
 {
+    oc_display_list handle = oc_display_list_nil();
+
     oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    if(!context)
     {
-        oc_rect clip = { x, y, w, h };
+        return (handle);
+    }
+    if(!context->recording)
+    {
+        oc_log_error("no display list recording in progress\n");
+        return (handle);
+    }
 
-        //NOTE(martin): transform clip
-        oc_mat2x3 transform = oc_matrix_stack_top(context);
-        oc_vec2 p0 = oc_mat2x3_mul(transform, (oc_vec2){ clip.x, clip.y });
-        oc_vec2 p1 = oc_mat2x3_mul(transform, (oc_vec2){ clip.x + clip.w, clip.y });
-        oc_vec2 p2 = oc_mat2x3_mul(transform, (oc_vec2){ clip.x + clip.w, clip.y + clip.h });
-        oc_vec2 p3 = oc_mat2x3_mul(transform, (oc_vec2){ clip.x, clip.y + clip.h });
-
-        f32 x0 = oc_min(p0.x, oc_min(p1.x, oc_min(p2.x, p3.x)));
-        f32 y0 = oc_min(p0.y, oc_min(p1.y, oc_min(p2.y, p3.y)));
-        f32 x1 = oc_max(p0.x, oc_max(p1.x, oc_max(p2.x, p3.x)));
-        f32 y1 = oc_max(p0.y, oc_max(p1.y, oc_max(p2.y, p3.y)));
+    oc_display_list_data* list = oc_list_pop_front_entry(&oc_graphicsData.displayListFreeList, oc_display_list_data, freeListElt);
+    if(!list)
+    {
+        list = oc_arena_push_type(&oc_graphicsData.resourceArena, oc_display_list_data);
+    }
+    if(list)
+    {
+        memset(list, 0, sizeof(oc_display_list_data));
 
-        oc_rect current = oc_clip_stack_top(context);
+        //NOTE: elements of an unfinished path are discarded
+        if(context->primitiveCount > context->recordPrimitiveStart)
+        {
+            list->primitiveCount = context->primitiveCount - context->recordPrimitiveStart;
+            list->attributeCount = context->attributeCount - context->recordAttributeStart;
+            list->eltCount = context->path.startIndex - context->recordEltStart;
+        }
 
-        //NOTE(martin): intersect with current clip
-        x0 = oc_max(current.x, x0);
-        y0 = oc_max(current.y, y0);
-        x1 = oc_min(current.x + current.w, x1);
-        y1 = oc_min(current.y + current.h, y1);
+        list->primitives = oc_malloc_array(oc_primitive, oc_max(list->primitiveCount, 1));
+        list->attributes = oc_malloc_array(oc_attributes, oc_max(list->attributeCount, 1));
+        list->elements = oc_malloc_array(oc_path_elt, oc_max(list->eltCount, 1));
 
-        oc_rect r = { x0, y0, oc_max(0, x1 - x0), oc_max(0, y1 - y0) };
-        oc_clip_stack_push(context, r);
+        if(!list->primitives || !list->attributes || !list->elements)
+        {
+            oc_log_error("couldn't allocate display list\n");
+            free(list->primitives);
+            free(list->attributes);
+            free(list->elements);
+            oc_list_push_front(&oc_graphicsData.displayListFreeList, &list->freeListElt);
+        }
+        else
+        {
+            memcpy(list->elements, context->pathElements + context->recordEltStart, list->eltCount * sizeof(oc_path_elt));
+            memcpy(list->primitives, context->primitives + context->recordPrimitiveStart, list->primitiveCount * sizeof(oc_primitive));
+            memcpy(list->attributes, context->attributeTable + context->recordAttributeStart, list->attributeCount * sizeof(oc_attributes));
 
-        context->attributes.clip = r;
+            for(u32 i = 0; i < list->primitiveCount; i++)
+            {
+                list->primitives[i].path.startIndex -= context->recordEltStart;
+                list->primitives[i].attributesIndex -= context->recordAttributeStart;
+            }
+            handle = oc_display_list_handle_alloc(list);
+        }
     }
+
+    //NOTE: restore the context as it was before recording
+    context->primitiveCount = oc_min(context->primitiveCount, context->recordPrimitiveStart);
+    context->attributeCount = oc_min(context->attributeCount, context->recordAttributeStart);
+    context->path = context->recordSavedPath;
+    context->subPathStartPoint = context->recordSavedSubPathStartPoint;
+    context->subPathLastPoint = context->recordSavedSubPathLastPoint;
+    context->recording = false;
+    oc_canvas_glyph_slots_reset(context);
+
+    return (handle);
 }
 
-void oc_clip_pop()
+void oc_display_list_destroy(oc_display_list handle)
 {
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    oc_display_list_data* list = oc_display_list_from_handle(handle);
+    if(list)
     {
-        oc_clip_stack_pop(context);
-        context->attributes.clip = oc_clip_stack_top(context);
+        free(list->primitives);
+        free(list->attributes);
+        free(list->elements);
+        free(list->hitNodes);
+        free(list->hitIndices);
+        free(list->hitBounds);
+
+        oc_list_push_front(&oc_graphicsData.displayListFreeList, &list->freeListElt);
+        oc_graphics_handle_recycle(handle.h);
     }
 }
 
-oc_rect oc_clip_top()
+void oc_display_list_draw(oc_display_list handle, oc_mat2x3 transform)
 {
-    oc_rect clip = { -FLT_MAX / 2, -FLT_MAX / 2, FLT_MAX, FLT_MAX };
-
     oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    oc_display_list_data* list = oc_display_list_from_handle(handle);
+    if(!context || !list || !list->primitiveCount)
     {
-        clip = oc_clip_stack_top(context);
+        return;
     }
 
-    return (clip);
-}
+    u32 insertIndex = context->path.startIndex;
+    u64 eltCount = (u64)insertIndex + context->path.count + list->eltCount;
+
+    if(eltCount > UINT32_MAX
+       || !oc_canvas_buffer_reserve((void**)&context->pathElements,
+                                    &context->pathElementCap,
+                                    eltCount,
+                                    OC_CANVAS_DEFAULT_PATH_ELEMENT_CAP,
+                                    sizeof(oc_path_elt))
+       || !oc_canvas_buffer_reserve((void**)&context->primitives,
+                                    &context->primitiveCap,
+                                    context->primitiveCount + list->primitiveCount,
+                                    OC_CANVAS_DEFAULT_PRIMITIVE_CAP,
+                                    sizeof(oc_primitive))
+       || !oc_canvas_buffer_reserve((void**)&context->attributeTable,
+                                    &context->attributeCap,
+                                    context->attributeCount + list->attributeCount,
+                                    OC_CANVAS_DEFAULT_ATTRIBUTE_CAP,
+                                    sizeof(oc_attributes)))
+    {
+        return;
+    }
 
-//------------------------------------------------------------------------------------------
-//NOTE(martin): color helpers
-//------------------------------------------------------------------------------------------
+    //NOTE: insert the list's elements before the path currently being built, so that
+    //      it stays contiguous and can still be filled or stroked afterwards.
+    memmove(context->pathElements + insertIndex + list->eltCount,
+            context->pathElements + insertIndex,
+            context->path.count * sizeof(oc_path_elt));
 
-oc_color oc_color_rgba(f32 r, f32 g, f32 b, f32 a)
-{
-    return ((oc_color){ r, g, b, a, OC_COLOR_SPACE_RGB });
-}
+    memcpy(context->pathElements + insertIndex, list->elements, list->eltCount * sizeof(oc_path_elt));
 
-oc_color oc_color_srgba(f32 r, f32 g, f32 b, f32 a)
-{
-    return ((oc_color){ r, g, b, a, OC_COLOR_SPACE_SRGB });
-}
+    context->path.startIndex += list->eltCount;
 
-oc_color oc_color_convert(oc_color color, oc_color_space colorSpace)
-{
-    switch(colorSpace)
+    //NOTE: append the list's attributes, composing their transform and clip with the current ones
+    oc_mat2x3 listTransform = oc_mat2x3_mul_m(oc_matrix_stack_top(context), transform);
+    oc_rect currentClip = oc_clip_stack_top(context);
+
+    oc_attributes* attributes = context->attributeTable + context->attributeCount;
+    memcpy(attributes, list->attributes, list->attributeCount * sizeof(oc_attributes));
+
+    for(u32 i = 0; i < list->attributeCount; i++)
     {
-        case OC_COLOR_SPACE_RGB:
-        {
-            switch(color.colorSpace)
-            {
-                case OC_COLOR_SPACE_RGB:
-                    // No conversion
-                    break;
+        attributes[i].transform = oc_mat2x3_mul_m(listTransform, attributes[i].transform);
 
-                case OC_COLOR_SPACE_SRGB:
-                {
-                    for(int i = 0; i < 3; i++)
-                    {
-                        if(color.c[i] <= 0.04045)
-                        {
-                            color.c[i] = color.c[i] / 12.92;
-                        }
-                        else
-                        {
-                            color.c[i] = powf((color.c[i] + 0.055) / 1.055, 2.4);
-                        }
-                    }
-                }
-                break;
-            }
+        oc_rect clip = attributes[i].clip;
+        if(clip.w >= FLT_MAX || clip.h >= FLT_MAX)
+        {
+            attributes[i].clip = currentClip;
         }
-        break;
-
-        case OC_COLOR_SPACE_SRGB:
+        else
         {
-            switch(color.colorSpace)
-            {
-                case OC_COLOR_SPACE_RGB:
-                {
-                    // RGBA to SRGBA
-                    for(int i = 0; i < 3; i++)
-                    {
-                        if(color.c[i] <= 0.0031308)
-                        {
-                            color.c[i] = color.c[i] * 12.92;
-                        }
-                        else
-                        {
-                            color.c[i] = 1.055 * powf(color.c[i], 1.0 / 2.4) - 0.055;
-                        }
-                    }
-                }
-                break;
+            oc_vec2 p0 = oc_mat2x3_mul(listTransform, (oc_vec2){ clip.x, clip.y });
+            oc_vec2 p1 = oc_mat2x3_mul(listTransform, (oc_vec2){ clip.x + clip.w, clip.y });
+            oc_vec2 p2 = oc_mat2x3_mul(listTransform, (oc_vec2){ clip.x + clip.w, clip.y + clip.h });
+            oc_vec2 p3 = oc_mat2x3_mul(listTransform, (oc_vec2){ clip.x, clip.y + clip.h });
 
-                case OC_COLOR_SPACE_SRGB:
-                    // No conversion
-                    break;
-            }
+            f32 x0 = oc_max(currentClip.x, oc_min(p0.x, oc_min(p1.x, oc_min(p2.x, p3.x))));
+            f32 y0 = oc_max(currentClip.y, oc_min(p0.y, oc_min(p1.y, oc_min(p2.y, p3.y))));
+            f32 x1 = oc_min(currentClip.x + currentClip.w, oc_max(p0.x, oc_max(p1.x, oc_max(p2.x, p3.x))));
+            f32 y1 = oc_min(currentClip.y + currentClip.h, oc_max(p0.y, oc_max(p1.y, oc_max(p2.y, p3.y))));
+
+            attributes[i].clip = (oc_rect){ x0, y0, oc_max(0, x1 - x0), oc_max(0, y1 - y0) };
         }
-        break;
+
+        //NOTE: the depth recorded in the list may already count enclosing clip paths. Overestimating it only
+        //      keeps renderers from culling what lies beneath opaque primitives.
+        attributes[i].clipPathDepth += context->clipPathDepth;
     }
-    color.colorSpace = colorSpace;
-    return (color);
+
+    //NOTE: append primitives, rebasing their path and attributes
+    oc_primitive* primitives = context->primitives + context->primitiveCount;
+    memcpy(primitives, list->primitives, list->primitiveCount * sizeof(oc_primitive));
+
+    for(u32 i = 0; i < list->primitiveCount; i++)
+    {
+        primitives[i].path.startIndex += insertIndex;
+        primitives[i].attributesIndex += context->attributeCount;
+    }
+    context->attributeCount += list->attributeCount;
+    context->primitiveCount += list->primitiveCount;
 }
 
-//------------------------------------------------------------------------------------------
-//NOTE(martin): graphics attributes setting/getting
-//------------------------------------------------------------------------------------------
-void oc_set_color(oc_color color)
+u32 oc_display_list_record_count(void)
 {
     oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    u32 count = 0;
+    if(context && context->recording)
     {
-        context->attributes.hasGradient = false;
-        context->attributes.colors[0] = color;
+        count = context->primitiveCount - context->recordPrimitiveStart;
     }
+    return (count);
 }
 
-void oc_set_color_rgba(f32 r, f32 g, f32 b, f32 a)
-{
-    oc_set_color((oc_color){ r, g, b, a, .colorSpace = OC_COLOR_SPACE_RGB });
-}
+//------------------------------------------------------------------------------------------
+//NOTE: display list hit testing
+//------------------------------------------------------------------------------------------
 
-void oc_set_color_srgba(f32 r, f32 g, f32 b, f32 a)
+static bool oc_hit_test_primitive_is_shape(oc_display_list_data* list, oc_primitive* primitive)
 {
-    oc_set_color((oc_color){ r, g, b, a, .colorSpace = OC_COLOR_SPACE_SRGB });
+    return ((primitive->cmd == OC_CMD_FILL
+             || primitive->cmd == OC_CMD_STROKE
+             || primitive->cmd == OC_CMD_RECT
+             || primitive->cmd == OC_CMD_RRECT
+             || primitive->cmd == OC_CMD_GLYPH)
+            && primitive->path.count
+            && primitive->path.startIndex + primitive->path.count <= list->eltCount
+            && primitive->attributesIndex < list->attributeCount);
 }
 
-void oc_set_gradient(oc_gradient_blend_space blendSpace, oc_color bottomLeft, oc_color bottomRight, oc_color topRight, oc_color topLeft)
+static oc_vec4 oc_hit_test_primitive_bounds(oc_display_list_data* list, oc_primitive* primitive)
 {
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    //NOTE: bounds of the control points, which contain the curves, expanded by the farthest a stroke's caps and joints
+    //      can reach, in the list's coordinates and clipped to the primitive's clip rect.
+    oc_attributes* attributes = &list->attributes[primitive->attributesIndex];
+
+    oc_vec4 userBox = { primitive->path.startPoint.x, primitive->path.startPoint.y, primitive->path.startPoint.x, primitive->path.startPoint.y };
+    for(u32 eltIndex = 0; eltIndex < primitive->path.count; eltIndex++)
     {
-        context->attributes.hasGradient = true;
-        context->attributes.blendSpace = blendSpace;
-        context->attributes.colors[0] = bottomLeft;
-        context->attributes.colors[1] = bottomRight;
-        context->attributes.colors[2] = topRight;
-        context->attributes.colors[3] = topLeft;
+        oc_path_elt* elt = &list->elements[primitive->path.startIndex + eltIndex];
+        int pointCount = (elt->type == OC_PATH_CUBIC || elt->type == OC_PATH_POLYLINE) ? 3 : ((elt->type == OC_PATH_QUADRATIC) ? 2 : 1);
+        for(int i = 0; i < pointCount; i++)
+        {
+            userBox.x = oc_min(userBox.x, elt->p[i].x);
+            userBox.y = oc_min(userBox.y, elt->p[i].y);
+            userBox.z = oc_max(userBox.z, elt->p[i].x);
+            userBox.w = oc_max(userBox.w, elt->p[i].y);
+        }
     }
-}
 
-void oc_set_width(f32 width)
-{
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    if(primitive->cmd == OC_CMD_STROKE)
     {
-        context->attributes.width = width;
+        f32 margin = 0.5 * attributes->width * sqrtf(2) + oc_max(attributes->maxJointExcursion, 0);
+        userBox = (oc_vec4){ userBox.x - margin, userBox.y - margin, userBox.z + margin, userBox.w + margin };
     }
-}
 
-void oc_set_tolerance(f32 tolerance)
-{
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    oc_vec2 corners[4] = {
+        oc_mat2x3_mul(attributes->transform, (oc_vec2){ userBox.x, userBox.y }),
+        oc_mat2x3_mul(attributes->transform, (oc_vec2){ userBox.z, userBox.y }),
+        oc_mat2x3_mul(attributes->transform, (oc_vec2){ userBox.z, userBox.w }),
+        oc_mat2x3_mul(attributes->transform, (oc_vec2){ userBox.x, userBox.w }),
+    };
+    oc_vec4 box = { corners[0].x, corners[0].y, corners[0].x, corners[0].y };
+    for(int i = 1; i < 4; i++)
     {
-        context->attributes.tolerance = tolerance;
+        box.x = oc_min(box.x, corners[i].x);
+        box.y = oc_min(box.y, corners[i].y);
+        box.z = oc_max(box.z, corners[i].x);
+        box.w = oc_max(box.w, corners[i].y);
     }
+
+    oc_rect clip = attributes->clip;
+    box.x = oc_max(box.x, clip.x);
+    box.y = oc_max(box.y, clip.y);
+    box.z = oc_min(box.z, clip.x + clip.w);
+    box.w = oc_min(box.w, clip.y + clip.h);
+
+    return (box);
 }
 
-void oc_set_joint(oc_joint_type joint)
+static f32 oc_hit_test_centroid(oc_vec4* bounds, u32 index, int axis)
 {
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
-    {
-        context->attributes.joint = joint;
-    }
+    return (axis ? bounds[index].y + bounds[index].w : bounds[index].x + bounds[index].z);
 }
 
-void oc_set_max_joint_excursion(f32 maxJointExcursion)
+static void oc_hit_test_select(oc_vec4* bounds, u32* indices, i32 count, i32 k, int axis)
 {
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    //NOTE: reorders indices so that the k-th one is in place, with no larger centroids before it and no smaller
+    //      centroids after it (Wirth's selection algorithm)
+    i32 l = 0;
+    i32 r = count - 1;
+    while(l < r)
     {
-        context->attributes.maxJointExcursion = maxJointExcursion;
+        f32 pivot = oc_hit_test_centroid(bounds, indices[k], axis);
+        i32 i = l;
+        i32 j = r;
+        do
+        {
+            while(oc_hit_test_centroid(bounds, indices[i], axis) < pivot)
+            {
+                i++;
+            }
+            while(pivot < oc_hit_test_centroid(bounds, indices[j], axis))
+            {
+                j--;
+            }
+            if(i <= j)
+            {
+                u32 tmp = indices[i];
+                indices[i] = indices[j];
+                indices[j] = tmp;
+                i++;
+                j--;
+            }
+        }
+        while(i <= j);
+
+        if(j < k)
+        {
+            l = i;
+        }
+        if(k < i)
+        {
+            r = j;
+        }
     }
 }
 
-void oc_set_cap(oc_cap_type cap)
+static u32 oc_hit_test_build_node(oc_display_list_data* list, u32 start, u32 count)
 {
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    u32 nodeIndex = list->hitNodeCount;
+    list->hitNodeCount++;
+
+    oc_hit_test_node* node = &list->hitNodes[nodeIndex];
+    node->box = list->hitBounds[list->hitIndices[start]];
+    for(u32 i = 1; i < count; i++)
     {
-        context->attributes.cap = cap;
+        oc_vec4 box = list->hitBounds[list->hitIndices[start + i]];
+        node->box.x = oc_min(node->box.x, box.x);
+        node->box.y = oc_min(node->box.y, box.y);
+        node->box.z = oc_max(node->box.z, box.z);
+        node->box.w = oc_max(node->box.w, box.w);
     }
-}
 
-void oc_set_font(oc_font font)
-{
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    if(count <= OC_HIT_TEST_LEAF_SIZE)
     {
-        context->attributes.font = font;
+        node->start = start;
+        node->count = count;
+        node->right = 0;
+    }
+    else
+    {
+        //NOTE: split at the median along the longest side of the node
+        int axis = (node->box.w - node->box.y > node->box.z - node->box.x) ? 1 : 0;
+        u32 half = count / 2;
+        oc_hit_test_select(list->hitBounds, list->hitIndices + start, count, half, axis);
+
+        node->start = 0;
+        node->count = 0;
+
+        oc_hit_test_build_node(list, start, half);
+        u32 right = oc_hit_test_build_node(list, start + half, count - half);
+
+        //NOTE: the node array is allocated up front, so the node pointer is still valid
+        node->right = right;
     }
+    return (nodeIndex);
 }
 
-void oc_set_font_size(f32 fontSize)
+static void oc_hit_test_build(oc_display_list_data* list)
 {
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    list->hitTestBuilt = true;
+
+    u32 shapeCount = 0;
+    for(u32 i = 0; i < list->primitiveCount; i++)
     {
-        context->attributes.fontSize = fontSize;
+        if(oc_hit_test_primitive_is_shape(list, &list->primitives[i]))
+        {
+            shapeCount++;
+        }
+    }
+    if(!shapeCount)
+    {
+        return;
     }
-}
 
-void oc_set_text_flip(bool flip)
-{
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    list->hitBounds = oc_malloc_array(oc_vec4, list->primitiveCount);
+    list->hitIndices = oc_malloc_array(u32, shapeCount);
+    list->hitNodes = oc_malloc_array(oc_hit_test_node, 2 * shapeCount);
+
+    if(!list->hitBounds || !list->hitIndices || !list->hitNodes)
     {
-        context->textFlip = flip;
+        oc_log_error("couldn't allocate display list hit test index\n");
+        free(list->hitBounds);
+        free(list->hitIndices);
+        free(list->hitNodes);
+        list->hitBounds = 0;
+        list->hitIndices = 0;
+        list->hitNodes = 0;
+        return;
     }
-}
 
-void oc_set_image(oc_image image)
-{
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    u32 indexCount = 0;
+    for(u32 i = 0; i < list->primitiveCount; i++)
     {
-        context->attributes.image = image;
-        oc_vec2 size = oc_image_size(image);
-        context->attributes.srcRegion = (oc_rect){ 0, 0, size.x, size.y };
+        if(oc_hit_test_primitive_is_shape(list, &list->primitives[i]))
+        {
+            list->hitBounds[i] = oc_hit_test_primitive_bounds(list, &list->primitives[i]);
+            list->hitIndices[indexCount] = i;
+            indexCount++;
+        }
     }
+    oc_hit_test_build_node(list, 0, indexCount);
 }
 
-void oc_set_image_source_region(oc_rect region)
+typedef struct oc_hit_test_state
 {
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    oc_vec2 point;
+    bool stroke;
+    f32 halfWidthSquared;
+    i32 crossings;
+    bool hit;
+
+} oc_hit_test_state;
+
+static void oc_hit_test_line(oc_hit_test_state* state, oc_vec2 a, oc_vec2 b)
+{
+    oc_vec2 p = state->point;
+    if(state->stroke)
     {
-        context->attributes.srcRegion = region;
+        //NOTE: strokes contain the points closer to their path than half their width. Joints and caps are
+        //      approximated as round.
+        oc_vec2 ab = { b.x - a.x, b.y - a.y };
+        f32 lenSquared = ab.x * ab.x + ab.y * ab.y;
+        f32 t = (lenSquared > 0) ? ((p.x - a.x) * ab.x + (p.y - a.y) * ab.y) / lenSquared : 0;
+        t = oc_clamp(t, 0, 1);
+
+        f32 dx = a.x + t * ab.x - p.x;
+        f32 dy = a.y + t * ab.y - p.y;
+        if(dx * dx + dy * dy <= state->halfWidthSquared)
+        {
+            state->hit = true;
+        }
+    }
+    else if((a.y > p.y) != (b.y > p.y))
+    {
+        //NOTE: count crossings of a ray going right from the point, for the even-odd fill rule used by the renderer
+        f32 x = a.x + (p.y - a.y) * (b.x - a.x) / (b.y - a.y);
+        if(x > p.x)
+        {
+            state->crossings++;
+        }
     }
 }
 
-oc_color oc_get_color()
+static void oc_hit_test_curve(oc_hit_test_state* state, int order, oc_vec2* p, f32 tolerance)
 {
-    oc_color color = { 0 };
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    //NOTE: flatten the curve in steps whose deviation from the curve is at most tolerance, estimated from the
+    //      second differences of its control points
+    f32 dev = 0;
+    for(int i = 0; i + 2 <= order; i++)
     {
-        color = context->attributes.colors[0];
+        f32 dx = p[i].x - 2 * p[i + 1].x + p[i + 2].x;
+        f32 dy = p[i].y - 2 * p[i + 1].y + p[i + 2].y;
+        dev = oc_max(dev, sqrtf(dx * dx + dy * dy));
     }
-    return (color);
-}
+    f32 factor = (order == 3) ? 0.75 : 0.25;
+    int steps = oc_clamp((int)ceilf(sqrtf(factor * dev / tolerance)), 1, OC_HIT_TEST_MAX_CURVE_STEPS);
 
-f32 oc_get_width()
-{
-    f32 width = 0;
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    oc_vec2 last = p[0];
+    for(int step = 1; step <= steps; step++)
     {
-        width = context->attributes.width;
+        f32 t = (f32)step / steps;
+        f32 s = 1 - t;
+        oc_vec2 next;
+        if(order == 2)
+        {
+            next = (oc_vec2){
+                s * s * p[0].x + 2 * s * t * p[1].x + t * t * p[2].x,
+                s * s * p[0].y + 2 * s * t * p[1].y + t * t * p[2].y,
+            };
+        }
+        else
+        {
+            next = (oc_vec2){
+                s * s * s * p[0].x + 3 * s * s * t * p[1].x + 3 * s * t * t * p[2].x + t * t * t * p[3].x,
+                s * s * s * p[0].y + 3 * s * s * t * p[1].y + 3 * s * t * t * p[2].y + t * t * t * p[3].y,
+            };
+        }
+        oc_hit_test_line(state, last, next);
+        last = next;
     }
-    return (width);
 }
 
-f32 oc_get_tolerance()
+static bool oc_hit_test_primitive(oc_display_list_data* list, oc_primitive* primitive, oc_vec2 point)
 {
-    f32 tolerance = 0;
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    oc_attributes* attributes = &list->attributes[primitive->attributesIndex];
+
+    oc_rect clip = attributes->clip;
+    if(point.x < clip.x || point.x >= clip.x + clip.w || point.y < clip.y || point.y >= clip.y + clip.h)
     {
-        tolerance = context->attributes.tolerance;
+        return (false);
     }
-    return (tolerance);
-}
 
-oc_joint_type oc_get_joint()
-{
-    oc_joint_type joint = 0;
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    //NOTE: test in the primitive's user space, with a flattening tolerance of a twentieth of a list unit
+    oc_mat2x3 transform = attributes->transform;
+    f32 scale = sqrtf(fabsf(transform.m[0] * transform.m[4] - transform.m[1] * transform.m[3]));
+    if(scale == 0)
     {
-        joint = context->attributes.joint;
+        return (false);
     }
-    return (joint);
-}
+    f32 tolerance = 0.05 / scale;
 
-f32 oc_get_max_joint_excursion()
-{
-    f32 maxJointExcursion = 0;
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    oc_hit_test_state state = {
+        .point = oc_mat2x3_mul(oc_mat2x3_inv(transform), point),
+        .stroke = (primitive->cmd == OC_CMD_STROKE),
+        .halfWidthSquared = 0.25 * attributes->width * attributes->width,
+    };
+
+    //NOTE: fills implicitly close their subpaths
+    oc_vec2 pen = primitive->path.startPoint;
+    oc_vec2 subPathStart = pen;
+
+    for(u32 eltIndex = 0; eltIndex < primitive->path.count && !state.hit; eltIndex++)
     {
-        maxJointExcursion = context->attributes.maxJointExcursion;
-    }
-    return (maxJointExcursion);
-}
+        oc_path_elt* elt = &list->elements[primitive->path.startIndex + eltIndex];
+        switch(elt->type)
+        {
+            case OC_PATH_MOVE:
+                if(!state.stroke)
+                {
+                    oc_hit_test_line(&state, pen, subPathStart);
+                }
+                pen = elt->p[0];
+                subPathStart = pen;
+                break;
 
-oc_cap_type oc_get_cap()
-{
-    oc_cap_type cap = 0;
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+            case OC_PATH_LINE:
+                oc_hit_test_line(&state, pen, elt->p[0]);
+                pen = elt->p[0];
+                break;
+
+            case OC_PATH_POLYLINE:
+                for(int i = 0; i < 3; i++)
+                {
+                    oc_hit_test_line(&state, pen, elt->p[i]);
+                    pen = elt->p[i];
+                }
+                break;
+
+            case OC_PATH_QUADRATIC:
+            {
+                oc_vec2 p[3] = { pen, elt->p[0], elt->p[1] };
+                oc_hit_test_curve(&state, 2, p, tolerance);
+                pen = elt->p[1];
+            }
+            break;
+
+            case OC_PATH_CUBIC:
+            {
+                oc_vec2 p[4] = { pen, elt->p[0], elt->p[1], elt->p[2] };
+                oc_hit_test_curve(&state, 3, p, tolerance);
+                pen = elt->p[2];
+            }
+            break;
+        }
+    }
+    if(!state.stroke)
     {
-        cap = context->attributes.cap;
+        oc_hit_test_line(&state, pen, subPathStart);
     }
-    return (cap);
+
+    return (state.stroke ? state.hit : (state.crossings & 1) != 0);
 }
 
-oc_font oc_get_font()
+static int oc_hit_test_index_cmp(const void* a, const void* b)
 {
-    oc_font font = oc_font_nil();
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
-    {
-        font = context->attributes.font;
-    }
-    return (font);
+    //NOTE: sort primitive indices in decreasing order, so that front-most primitives come first
+    u32 indexA = *(const u32*)a;
+    u32 indexB = *(const u32*)b;
+    return ((indexA < indexB) - (indexA > indexB));
 }
 
-f32 oc_get_font_size()
+u32 oc_display_list_hit_test(oc_display_list handle, oc_vec2 point, u32 maxCount, u32* primitiveIndices)
 {
-    f32 fontSize = 0;
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    oc_display_list_data* list = oc_display_list_from_handle(handle);
+    if(!list || !maxCount)
     {
-        fontSize = context->attributes.fontSize;
+        return (0);
+    }
+    if(!list->hitTestBuilt)
+    {
+        oc_hit_test_build(list);
+    }
+    if(!list->hitNodes)
+    {
+        return (0);
     }
-    return (fontSize);
-}
 
-bool oc_get_text_flip()
-{
-    bool flip = false;
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    //NOTE: collect the primitives whose bounds contain the point
+    u32* candidates = oc_arena_push_array(scratch.arena, u32, list->primitiveCount);
+    u32 candidateCount = 0;
+
+    u32 stack[OC_HIT_TEST_STACK_SIZE];
+    u32 stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while(stackSize)
     {
-        flip = context->textFlip;
+        oc_hit_test_node* node = &list->hitNodes[stack[--stackSize]];
+
+        if(point.x < node->box.x || point.x > node->box.z || point.y < node->box.y || point.y > node->box.w)
+        {
+            continue;
+        }
+
+        if(node->count)
+        {
+            for(u32 i = 0; i < node->count; i++)
+            {
+                u32 index = list->hitIndices[node->start + i];
+                oc_vec4 box = list->hitBounds[index];
+                if(point.x >= box.x && point.x <= box.z && point.y >= box.y && point.y <= box.w)
+                {
+                    candidates[candidateCount] = index;
+                    candidateCount++;
+                }
+            }
+        }
+        else if(stackSize + 2 <= OC_HIT_TEST_STACK_SIZE)
+        {
+            //NOTE: the tree is balanced, so its depth is about log2 of the primitive count and the stack can't overflow
+            stack[stackSize++] = node->right;
+            stack[stackSize++] = (u32)(node - list->hitNodes) + 1;
+        }
     }
-    return (flip);
-}
 
-oc_image oc_get_image()
-{
-    oc_image image = oc_image_nil();
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
+    //NOTE: run exact tests front to back, until maxCount primitives are hit
+    qsort(candidates, candidateCount, sizeof(u32), oc_hit_test_index_cmp);
+
+    u32 hitCount = 0;
+    for(u32 i = 0; i < candidateCount && hitCount < maxCount; i++)
     {
-        image = context->attributes.image;
+        if(oc_hit_test_primitive(list, &list->primitives[candidates[i]], point))
+        {
+            primitiveIndices[hitCount] = candidates[i];
+            hitCount++;
+        }
     }
-    return (image);
+
+    oc_scratch_end(scratch);
+    return (hitCount);
 }
 
-oc_rect oc_get_image_source_region()
+//------------------------------------------------------------------------------------------
+//NOTE(martin): transform, viewport and clipping
+//------------------------------------------------------------------------------------------
+
+void oc_matrix_push(oc_mat2x3 matrix)
 {
-    oc_rect rect = { 0 };
     oc_canvas_context_data* context = oc_currentCanvasContext;
     if(context)
     {
-        rect = context->attributes.srcRegion;
+        oc_matrix_stack_push(context, matrix);
     }
-    return (rect);
 }
 
-//------------------------------------------------------------------------------------------
-//NOTE(martin): path construction
-//------------------------------------------------------------------------------------------
-oc_vec2 oc_get_position()
+void oc_matrix_multiply_push(oc_mat2x3 matrix)
 {
     oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(!context)
+    if(context)
     {
-        return ((oc_vec2){ 0, 0 });
+        oc_mat2x3 transform = oc_matrix_stack_top(context);
+        oc_matrix_stack_push(context, oc_mat2x3_mul_m(transform, matrix));
     }
-    return (context->subPathLastPoint);
 }
 
-void oc_move_to(f32 x, f32 y)
+void oc_matrix_pop()
 {
     oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(!context)
+    if(context)
     {
-        return;
+        oc_matrix_stack_pop(context);
     }
-    oc_path_push_element(context, ((oc_path_elt){ .type = OC_PATH_MOVE, .p[0] = { x, y } }));
-    context->subPathStartPoint = (oc_vec2){ x, y };
-    context->subPathLastPoint = (oc_vec2){ x, y };
 }
 
-void oc_line_to(f32 x, f32 y)
+oc_mat2x3 oc_matrix_top()
 {
+    oc_mat2x3 mat = {
+        1, 0, 0,
+        0, 1, 0
+    };
     oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(!context)
+    if(context)
     {
-        return;
+        mat = oc_matrix_stack_top(context);
     }
-    oc_path_push_element(context, ((oc_path_elt){ .type = OC_PATH_LINE, .p[0] = { x, y } }));
-    context->subPathLastPoint = (oc_vec2){ x, y };
+
+    return (mat);
 }
 
-void oc_quadratic_to(f32 x1, f32 y1, f32 x2, f32 y2)
+void oc_add_damage_rect(f32 x, f32 y, f32 w, f32 h)
 {
     oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(!context)
+    if(context && w > 0 && h > 0)
     {
-        return;
+        oc_mat2x3 transform = oc_matrix_stack_top(context);
+        oc_vec2 p0 = oc_mat2x3_mul(transform, (oc_vec2){ x, y });
+        oc_vec2 p1 = oc_mat2x3_mul(transform, (oc_vec2){ x + w, y });
+        oc_vec2 p2 = oc_mat2x3_mul(transform, (oc_vec2){ x + w, y + h });
+        oc_vec2 p3 = oc_mat2x3_mul(transform, (oc_vec2){ x, y + h });
+
+        f32 x0 = oc_min(p0.x, oc_min(p1.x, oc_min(p2.x, p3.x)));
+        f32 y0 = oc_min(p0.y, oc_min(p1.y, oc_min(p2.y, p3.y)));
+        f32 x1 = oc_max(p0.x, oc_max(p1.x, oc_max(p2.x, p3.x)));
+        f32 y1 = oc_max(p0.y, oc_max(p1.y, oc_max(p2.y, p3.y)));
+
+        oc_rect damage = context->damage;
+        if(damage.w > 0 && damage.h > 0)
+        {
+            x0 = oc_min(x0, damage.x);
+            y0 = oc_min(y0, damage.y);
+            x1 = oc_max(x1, damage.x + damage.w);
+            y1 = oc_max(y1, damage.y + damage.h);
+        }
+        context->damage = (oc_rect){ x0, y0, x1 - x0, y1 - y0 };
     }
-    oc_path_push_element(context, ((oc_path_elt){ .type = OC_PATH_QUADRATIC, .p = { { x1, y1 }, { x2, y2 } } }));
-    context->subPathLastPoint = (oc_vec2){ x2, y2 };
 }
 
-void oc_cubic_to(f32 x1, f32 y1, f32 x2, f32 y2, f32 x3, f32 y3)
+void oc_clip_push(f32 x, f32 y, f32 w, f32 h)
 {
     oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(!context)
+    if(context)
     {
-        return;
+        oc_rect clip = { x, y, w, h };
+
+        //NOTE(martin): transform clip
+        oc_mat2x3 transform = oc_matrix_stack_top(context);
+        oc_vec2 p0 = oc_mat2x3_mul(transform, (oc_vec2){ clip.x, clip.y });
+        oc_vec2 p1 = oc_mat2x3_mul(transform, (oc_vec2){ clip.x + clip.w, clip.y });
+        oc_vec2 p2 = oc_mat2x3_mul(transform, (oc_vec2){ clip.x + clip.w, clip.y + clip.h });
+        oc_vec2 p3 = oc_mat2x3_mul(transform, (oc_vec2){ clip.x, clip.y + clip.h });
+
+        f32 x0 = oc_min(p0.x, oc_min(p1.x, oc_min(p2.x, p3.x)));
+        f32 y0 = oc_min(p0.y, oc_min(p1.y, oc_min(p2.y, p3.y)));
+        f32 x1 = oc_max(p0.x, oc_max(p1.x, oc_max(p2.x, p3.x)));
+        f32 y1 = oc_max(p0.y, oc_max(p1.y, oc_max(p2.y, p3.y)));
+
+        oc_rect current = oc_clip_stack_top(context);
+
+        //NOTE(martin): intersect with current clip
+        x0 = oc_max(current.x, x0);
+        y0 = oc_max(current.y, y0);
+        x1 = oc_min(current.x + current.w, x1);
+        y1 = oc_min(current.y + current.h, y1);
+
+        oc_rect r = { x0, y0, oc_max(0, x1 - x0), oc_max(0, y1 - y0) };
+        oc_clip_stack_push(context, r);
+
+        context->attributes.clip = r;
     }
-    oc_path_push_element(context, ((oc_path_elt){ .type = OC_PATH_CUBIC, .p = { { x1, y1 }, { x2, y2 }, { x3, y3 } } }));
-    context->subPathLastPoint = (oc_vec2){ x3, y3 };
 }
 
-void oc_close_path()
+void oc_clip_pop()
 {
     oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(!context)
-    {
-        return;
-    }
-    if(context->subPathStartPoint.x != context->subPathLastPoint.x
-       || context->subPathStartPoint.y != context->subPathLastPoint.y)
+    if(context)
     {
-        oc_line_to(context->subPathStartPoint.x, context->subPathStartPoint.y);
+        oc_clip_stack_pop(context);
+        context->attributes.clip = oc_clip_stack_top(context);
     }
-    context->subPathStartPoint = context->subPathLastPoint;
 }
 
-oc_rect oc_glyph_outlines_from_font_data(oc_font_data* fontData, oc_str32 glyphIndices)
+void oc_clip_path_push()
 {
     oc_canvas_context_data* context = oc_currentCanvasContext;
-
-    f32 startX = context->subPathLastPoint.x;
-    f32 startY = context->subPathLastPoint.y;
-    f32 maxWidth = 0;
-
-    f32 scale = context->attributes.fontSize / fontData->unitsPerEm;
-
-    for(int i = 0; i < glyphIndices.len; i++)
+    if(context)
     {
-        u32 glyphIndex = glyphIndices.ptr[i];
+        if(context->clipPathStackSize >= OC_CLIP_STACK_MAX_DEPTH)
+        {
+            oc_log_error("clip path stack overflow\n");
+            return;
+        }
 
-        f32 xOffset = context->subPathLastPoint.x;
-        f32 yOffset = context->subPathLastPoint.y;
-        f32 flip = context->textFlip ? 1 : -1;
+        //NOTE(martin): clip to the bounding box of the path's control points, in screen space, which contains the path
+        oc_mat2x3 transform = oc_matrix_stack_top(context);
+        oc_vec2 p = oc_mat2x3_mul(transform, context->path.startPoint);
+        f32 boxX0 = p.x;
+        f32 boxY0 = p.y;
+        f32 boxX1 = p.x;
+        f32 boxY1 = p.y;
 
-        if(!glyphIndex || glyphIndex >= fontData->glyphCount)
+        for(u32 eltIndex = 0; eltIndex < context->path.count; eltIndex++)
         {
-            oc_log_warning("code point is not present in font ranges\n");
-            //NOTE(martin): try to find the replacement character
-            glyphIndex = oc_font_get_glyph_index_from_font_data(fontData, 0xfffd);
-            if(!glyphIndex)
+            oc_path_elt* elt = &context->pathElements[context->path.startIndex + eltIndex];
+            int pointCount = (elt->type == OC_PATH_CUBIC || elt->type == OC_PATH_POLYLINE) ? 3 : ((elt->type == OC_PATH_QUADRATIC) ? 2 : 1);
+            for(int i = 0; i < pointCount; i++)
             {
-                //NOTE(martin): could not find replacement glyph, try to get an 'X' to get a somewhat correct dimensions
-                //              to render an empty rectangle. Otherwise just render with the max font width
+                p = oc_mat2x3_mul(transform, elt->p[i]);
+                boxX0 = oc_min(boxX0, p.x);
+                boxY0 = oc_min(boxY0, p.y);
+                boxX1 = oc_max(boxX1, p.x);
+                boxY1 = oc_max(boxY1, p.y);
+            }
+        }
 
-                oc_glyph_metrics missingGlyphMetrics = { 0 };
-                u32 missingGlyphIndex = oc_font_get_glyph_index_from_font_data(fontData, 'X');
+        oc_rect current = oc_clip_stack_top(context);
+        f32 x0 = oc_max(current.x, boxX0);
+        f32 y0 = oc_max(current.y, boxY0);
+        f32 x1 = oc_min(current.x + current.w, boxX1);
+        f32 y1 = oc_min(current.y + current.h, boxY1);
 
-                if(missingGlyphIndex)
-                {
-                    oc_font_get_glyph_metrics_from_font_data(fontData, (oc_str32){ .ptr = &missingGlyphIndex, .len = 1 }, &missingGlyphMetrics);
-                }
-                else
-                {
-                    missingGlyphMetrics = (oc_glyph_metrics){
-                        .ink = {
-                            .x = fontData->metrics.width * 0.1,
-                            .y = -fontData->metrics.ascent,
-                            .w = fontData->metrics.width * 0.8,
-                            .h = fontData->metrics.ascent,
-                        },
-                        .advance = { .x = fontData->metrics.width, .y = 0 },
-                    };
-                }
-
-                f32 oldStrokeWidth = context->attributes.width;
+        //NOTE(martin): an empty path clips everything
+        if(!context->path.count)
+        {
+            x1 = x0;
+            y1 = y0;
+        }
 
-                oc_set_width(missingGlyphMetrics.ink.w * 0.005);
-                oc_rectangle_stroke(xOffset + missingGlyphMetrics.ink.x * scale,
-                                    yOffset + missingGlyphMetrics.ink.y * scale,
-                                    missingGlyphMetrics.ink.w * scale * flip,
-                                    missingGlyphMetrics.ink.h * scale);
+        oc_rect r = { x0, y0, oc_max(0, x1 - x0), oc_max(0, y1 - y0) };
+        oc_clip_stack_push(context, r);
+        context->attributes.clip = r;
 
-                oc_set_width(oldStrokeWidth);
-                oc_move_to(xOffset + missingGlyphMetrics.advance.x * scale, yOffset);
-                maxWidth = oc_max(maxWidth, xOffset + missingGlyphMetrics.advance.x * scale - startX);
-                continue;
+        bool masked = false;
+        if(context->path.count)
+        {
+            if(context->clipPathDepth < OC_CLIP_PATH_MAX_DEPTH)
+            {
+                masked = oc_push_command(context, (oc_primitive){ .cmd = OC_CMD_CLIP_PATH, .path = context->path });
+            }
+            else
+            {
+                oc_log_warning("clip paths nested deeper than %i only clip to their bounding box\n", OC_CLIP_PATH_MAX_DEPTH);
             }
         }
+        if(masked)
+        {
+            context->clipPathDepth++;
+        }
+        context->clipPathMasked[context->clipPathStackSize] = masked;
+        context->clipPathStackSize++;
 
-        oc_glyph_data* glyph = oc_font_get_glyph_data(fontData, glyphIndex);
+        oc_new_path(context);
+    }
+}
 
-        oc_path_push_elements(context, glyph->pathDescriptor.count, fontData->outlines + glyph->pathDescriptor.startIndex);
+void oc_clip_path_pop()
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        if(context->clipPathStackSize == 0)
+        {
+            oc_log_error("clip path stack underflow\n");
+            return;
+        }
+        context->clipPathStackSize--;
 
-        oc_path_elt* elements = context->pathElements + context->path.count + context->path.startIndex - glyph->pathDescriptor.count;
-        for(int eltIndex = 0; eltIndex < glyph->pathDescriptor.count; eltIndex++)
+        //NOTE: the marker is pushed before popping the clip rect, so that it shares the clip path's clip rect
+        if(context->clipPathMasked[context->clipPathStackSize])
         {
-            for(int pIndex = 0; pIndex < 3; pIndex++)
+            oc_push_command(context, (oc_primitive){ .cmd = OC_CMD_CLIP_POP });
+            context->clipPathDepth--;
+        }
+        oc_clip_stack_pop(context);
+        context->attributes.clip = oc_clip_stack_top(context);
+    }
+}
+
+oc_rect oc_clip_top()
+{
+    oc_rect clip = { -FLT_MAX / 2, -FLT_MAX / 2, FLT_MAX, FLT_MAX };
+
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        clip = oc_clip_stack_top(context);
+    }
+
+    return (clip);
+}
+
+//------------------------------------------------------------------------------------------
+//NOTE(martin): color helpers
+//------------------------------------------------------------------------------------------
+
+oc_color oc_color_rgba(f32 r, f32 g, f32 b, f32 a)
+{
+    return ((oc_color){ r, g, b, a, OC_COLOR_SPACE_RGB });
+}
+
+oc_color oc_color_srgba(f32 r, f32 g, f32 b, f32 a)
+{
+    return ((oc_color){ r, g, b, a, OC_COLOR_SPACE_SRGB });
+}
+
+oc_color oc_color_convert(oc_color color, oc_color_space colorSpace)
+{
+    switch(colorSpace)
+    {
+        case OC_COLOR_SPACE_RGB:
+        {
+            switch(color.colorSpace)
             {
-                elements[eltIndex].p[pIndex].x = elements[eltIndex].p[pIndex].x * scale + xOffset;
-                elements[eltIndex].p[pIndex].y = elements[eltIndex].p[pIndex].y * scale * flip + yOffset;
+                case OC_COLOR_SPACE_RGB:
+                    // No conversion
+                    break;
+
+                case OC_COLOR_SPACE_SRGB:
+                {
+                    for(int i = 0; i < 3; i++)
+                    {
+                        if(color.c[i] <= 0.04045)
+                        {
+                            color.c[i] = color.c[i] / 12.92;
+                        }
+                        else
+                        {
+                            color.c[i] = powf((color.c[i] + 0.055) / 1.055, 2.4);
+                        }
+                    }
+                }
+                break;
             }
         }
-        oc_move_to(xOffset + scale * glyph->metrics.advance.x, yOffset);
+        break;
+
+        case OC_COLOR_SPACE_SRGB:
+        {
+            switch(color.colorSpace)
+            {
+                case OC_COLOR_SPACE_RGB:
+                {
+                    // RGBA to SRGBA
+                    for(int i = 0; i < 3; i++)
+                    {
+                        if(color.c[i] <= 0.0031308)
+                        {
+                            color.c[i] = color.c[i] * 12.92;
+                        }
+                        else
+                        {
+                            color.c[i] = 1.055 * powf(color.c[i], 1.0 / 2.4) - 0.055;
+                        }
+                    }
+                }
+                break;
 
-        maxWidth = oc_max(maxWidth, xOffset + scale * glyph->metrics.advance.x - startX);
+                case OC_COLOR_SPACE_SRGB:
+                    // No conversion
+                    break;
+            }
+        }
+        break;
     }
-    f32 lineHeight = (fontData->metrics.ascent + fontData->metrics.descent) * scale;
-    oc_rect box = { startX, startY, maxWidth, context->subPathLastPoint.y - startY + lineHeight };
-    return (box);
+    color.colorSpace = colorSpace;
+    return (color);
 }
 
-oc_rect oc_glyph_outlines(oc_str32 glyphIndices)
+//------------------------------------------------------------------------------------------
+//NOTE(martin): graphics attributes setting/getting
+//------------------------------------------------------------------------------------------
+void oc_set_color(oc_color color)
 {
     oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(!context)
+    if(context)
     {
-        return ((oc_rect){ 0 });
+        context->attributes.hasGradient = false;
+        context->attributes.colors[0] = color;
     }
-    oc_font_data* fontData = oc_font_data_from_handle(context->attributes.font);
-    if(!fontData)
+}
+
+void oc_set_color_rgba(f32 r, f32 g, f32 b, f32 a)
+{
+    oc_set_color((oc_color){ r, g, b, a, .colorSpace = OC_COLOR_SPACE_RGB });
+}
+
+void oc_set_color_srgba(f32 r, f32 g, f32 b, f32 a)
+{
+    oc_set_color((oc_color){ r, g, b, a, .colorSpace = OC_COLOR_SPACE_SRGB });
+}
+
+void oc_set_gradient(oc_gradient_blend_space blendSpace, oc_color bottomLeft, oc_color bottomRight, oc_color topRight, oc_color topLeft)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
     {
-        return ((oc_rect){ 0 });
+        context->attributes.hasGradient = true;
+        context->attributes.gradientKind = OC_GRADIENT_BILINEAR;
+        context->attributes.blendSpace = blendSpace;
+        context->attributes.colors[0] = bottomLeft;
+        context->attributes.colors[1] = bottomRight;
+        context->attributes.colors[2] = topRight;
+        context->attributes.colors[3] = topLeft;
     }
-    return (oc_glyph_outlines_from_font_data(fontData, glyphIndices));
 }
 
-void oc_codepoints_outlines(oc_str32 codePoints)
+static void oc_set_gradient_stops(oc_canvas_context_data* context,
+                                  oc_gradient_kind kind,
+                                  oc_gradient_blend_space blendSpace,
+                                  oc_vec2 p0,
+                                  oc_vec2 p1,
+                                  u32 stopCount,
+                                  oc_gradient_stop* stops)
 {
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(!context)
+    oc_attributes* attributes = &context->attributes;
+    stopCount = oc_min(stopCount, OC_GRADIENT_MAX_STOPS);
+
+    if(!stopCount)
     {
+        oc_log_warning("gradient has no stops, ignoring\n");
         return;
     }
-    oc_font_data* fontData = oc_font_data_from_handle(context->attributes.font);
-    if(!fontData)
+
+    attributes->hasGradient = true;
+    attributes->gradientKind = kind;
+    attributes->blendSpace = blendSpace;
+    attributes->gradientPoints[0] = p0;
+    attributes->gradientPoints[1] = p1;
+    attributes->gradientStopCount = stopCount;
+
+    //NOTE: insertion sort the stops by offset, keeping stops with equal offsets in order to allow hard transitions
+    for(u32 i = 0; i < stopCount; i++)
     {
-        return;
+        oc_gradient_stop stop = stops[i];
+        stop.offset = oc_clamp(stop.offset, 0, 1);
+
+        u32 j = i;
+        while(j > 0 && attributes->gradientStops[j - 1].offset > stop.offset)
+        {
+            attributes->gradientStops[j] = attributes->gradientStops[j - 1];
+            j--;
+        }
+        attributes->gradientStops[j] = stop;
     }
+}
 
-    oc_arena_scope scratch = oc_scratch_begin();
+void oc_set_linear_gradient(oc_gradient_blend_space blendSpace, oc_vec2 start, oc_vec2 end, u32 stopCount, oc_gradient_stop* stops)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        oc_set_gradient_stops(context, OC_GRADIENT_LINEAR, blendSpace, start, end, stopCount, stops);
+    }
+}
 
-    oc_str32 glyphIndices = oc_font_push_glyph_indices(scratch.arena, context->attributes.font, codePoints);
-    oc_glyph_outlines_from_font_data(fontData, glyphIndices);
+void oc_set_radial_gradient(oc_gradient_blend_space blendSpace, oc_vec2 center, f32 radius, u32 stopCount, oc_gradient_stop* stops)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        oc_set_gradient_stops(context, OC_GRADIENT_RADIAL, blendSpace, center, (oc_vec2){ radius, 0 }, stopCount, stops);
+    }
+}
 
-    oc_scratch_end(scratch);
+void oc_set_width(f32 width)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        context->attributes.width = width;
+    }
+}
+
+void oc_set_tolerance(f32 tolerance)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        context->attributes.tolerance = tolerance;
+    }
+}
+
+void oc_set_tolerance_lod(bool lod)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        context->attributes.toleranceLOD = lod;
+    }
+}
+
+void oc_set_joint(oc_joint_type joint)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        context->attributes.joint = joint;
+    }
+}
+
+void oc_set_max_joint_excursion(f32 maxJointExcursion)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        context->attributes.maxJointExcursion = maxJointExcursion;
+    }
+}
+
+void oc_set_cap(oc_cap_type cap)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        context->attributes.cap = cap;
+    }
+}
+
+void oc_set_font(oc_font font)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        context->attributes.font = font;
+    }
+}
+
+void oc_set_font_size(f32 fontSize)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        context->attributes.fontSize = fontSize;
+    }
+}
+
+void oc_set_text_flip(bool flip)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        context->textFlip = flip;
+    }
+}
+
+void oc_set_polyline_decimation(f32 columnWidth)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        context->polylineDecimation = oc_max(columnWidth, 0);
+    }
+}
+
+void oc_set_image(oc_image image)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        context->attributes.image = image;
+        oc_vec2 size = oc_image_size(image);
+        context->attributes.srcRegion = (oc_rect){ 0, 0, size.x, size.y };
+    }
+}
+
+void oc_set_image_source_region(oc_rect region)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        context->attributes.srcRegion = region;
+    }
+}
+
+oc_color oc_get_color()
+{
+    oc_color color = { 0 };
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        color = context->attributes.colors[0];
+    }
+    return (color);
+}
+
+f32 oc_get_width()
+{
+    f32 width = 0;
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        width = context->attributes.width;
+    }
+    return (width);
+}
+
+f32 oc_get_tolerance()
+{
+    f32 tolerance = 0;
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        tolerance = context->attributes.tolerance;
+    }
+    return (tolerance);
+}
+
+bool oc_get_tolerance_lod()
+{
+    bool lod = false;
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        lod = context->attributes.toleranceLOD;
+    }
+    return (lod);
+}
+
+oc_joint_type oc_get_joint()
+{
+    oc_joint_type joint = 0;
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        joint = context->attributes.joint;
+    }
+    return (joint);
+}
+
+f32 oc_get_max_joint_excursion()
+{
+    f32 maxJointExcursion = 0;
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        maxJointExcursion = context->attributes.maxJointExcursion;
+    }
+    return (maxJointExcursion);
+}
+
+oc_cap_type oc_get_cap()
+{
+    oc_cap_type cap = 0;
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        cap = context->attributes.cap;
+    }
+    return (cap);
+}
+
+oc_font oc_get_font()
+{
+    oc_font font = oc_font_nil();
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        font = context->attributes.font;
+    }
+    return (font);
+}
+
+f32 oc_get_font_size()
+{
+    f32 fontSize = 0;
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        fontSize = context->attributes.fontSize;
+    }
+    return (fontSize);
+}
+
+bool oc_get_text_flip()
+{
+    bool flip = false;
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        flip = context->textFlip;
+    }
+    return (flip);
+}
+
+f32 oc_get_polyline_decimation()
+{
+    f32 columnWidth = 0;
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        columnWidth = context->polylineDecimation;
+    }
+    return (columnWidth);
+}
+
+oc_image oc_get_image()
+{
+    oc_image image = oc_image_nil();
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        image = context->attributes.image;
+    }
+    return (image);
+}
+
+oc_rect oc_get_image_source_region()
+{
+    oc_rect rect = { 0 };
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        rect = context->attributes.srcRegion;
+    }
+    return (rect);
+}
+
+//------------------------------------------------------------------------------------------
+//NOTE(martin): path construction
+//------------------------------------------------------------------------------------------
+oc_vec2 oc_get_position()
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(!context)
+    {
+        return ((oc_vec2){ 0, 0 });
+    }
+    return (context->subPathLastPoint);
+}
+
+void oc_move_to(f32 x, f32 y)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(!context)
+    {
+        return;
+    }
+    oc_path_push_element(context, ((oc_path_elt){ .type = OC_PATH_MOVE, .p[0] = { x, y } }));
+    context->subPathStartPoint = (oc_vec2){ x, y };
+    context->subPathLastPoint = (oc_vec2){ x, y };
+}
+
+void oc_line_to(f32 x, f32 y)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(!context)
+    {
+        return;
+    }
+    oc_path_push_element(context, ((oc_path_elt){ .type = OC_PATH_LINE, .p[0] = { x, y } }));
+    context->subPathLastPoint = (oc_vec2){ x, y };
+}
+
+void oc_quadratic_to(f32 x1, f32 y1, f32 x2, f32 y2)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(!context)
+    {
+        return;
+    }
+    oc_path_push_element(context, ((oc_path_elt){ .type = OC_PATH_QUADRATIC, .p = { { x1, y1 }, { x2, y2 } } }));
+    context->subPathLastPoint = (oc_vec2){ x2, y2 };
+}
+
+void oc_cubic_to(f32 x1, f32 y1, f32 x2, f32 y2, f32 x3, f32 y3)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(!context)
+    {
+        return;
+    }
+    oc_path_push_element(context, ((oc_path_elt){ .type = OC_PATH_CUBIC, .p = { { x1, y1 }, { x2, y2 }, { x3, y3 } } }));
+    context->subPathLastPoint = (oc_vec2){ x3, y3 };
+}
+
+typedef struct oc_polyline_writer
+{
+    oc_canvas_context_data* context;
+    u32 pendingCount;
+    oc_vec2 pending[3];
+
+} oc_polyline_writer;
+
+static void oc_polyline_writer_push(oc_polyline_writer* writer, oc_vec2 p)
+{
+    writer->pending[writer->pendingCount] = p;
+    writer->pendingCount++;
+    if(writer->pendingCount == 3)
+    {
+        oc_path_push_element(writer->context,
+                             (oc_path_elt){ .type = OC_PATH_POLYLINE, .p = { writer->pending[0], writer->pending[1], writer->pending[2] } });
+        writer->pendingCount = 0;
+    }
+}
+
+static void oc_polyline_writer_end(oc_polyline_writer* writer)
+{
+    for(u32 i = 0; i < writer->pendingCount; i++)
+    {
+        oc_path_push_element(writer->context, (oc_path_elt){ .type = OC_PATH_LINE, .p[0] = writer->pending[i] });
+    }
+    writer->pendingCount = 0;
+}
+
+static void oc_polyline_decimate(oc_canvas_context_data* context, u32 count, oc_vec2* points)
+{
+    //NOTE: consecutive points falling in the same screen column are reduced to the first, last, lowest and highest of
+    //      them, in their original order. This keeps the pixels a stroke covers at the column's resolution, so that the
+    //      number of points kept depends on the width of the polyline on screen instead of its number of points.
+    //      Points more than a column outside of the clip rect all fall in the same column on each side.
+    oc_mat2x3 transform = oc_matrix_stack_top(context);
+    oc_rect clip = oc_clip_stack_top(context);
+    f32 columnWidth = context->polylineDecimation;
+    f32 firstColumn = floorf(clip.x / columnWidth) - 1;
+    f32 lastColumn = floorf((clip.x + clip.w) / columnWidth) + 1;
+
+    oc_polyline_writer writer = { .context = context };
+
+    u32 runStart = 0;
+    f32 runColumn = 0;
+    u32 runMin = 0;
+    u32 runMax = 0;
+    f32 minY = 0;
+    f32 maxY = 0;
+
+    for(u32 i = 0; i <= count; i++)
+    {
+        f32 column = 0;
+        f32 y = 0;
+        if(i < count)
+        {
+            oc_vec2 p = oc_mat2x3_mul(transform, points[i]);
+            column = oc_clamp(floorf(p.x / columnWidth), firstColumn, lastColumn);
+            y = p.y;
+        }
+
+        if(i == count || (i > runStart && column != runColumn))
+        {
+            //NOTE: emit the run's first, extreme and last points in order, without duplicates. The first point of the
+            //      polyline was already added by oc_move_to().
+            u32 indices[4] = { runStart, oc_min(runMin, runMax), oc_max(runMin, runMax), i - 1 };
+            u32 lastEmitted = 0;
+            for(int j = 0; j < 4; j++)
+            {
+                if(indices[j] > lastEmitted)
+                {
+                    oc_polyline_writer_push(&writer, points[indices[j]]);
+                    lastEmitted = indices[j];
+                }
+            }
+            if(i == count)
+            {
+                break;
+            }
+        }
+
+        if(i == runStart || column != runColumn)
+        {
+            runStart = i;
+            runColumn = column;
+            runMin = runMax = i;
+            minY = maxY = y;
+        }
+        else if(y < minY)
+        {
+            runMin = i;
+            minY = y;
+        }
+        else if(y > maxY)
+        {
+            runMax = i;
+            maxY = y;
+        }
+    }
+    oc_polyline_writer_end(&writer);
+}
+
+void oc_polyline(u32 count, oc_vec2* points)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(!context || !count)
+    {
+        return;
+    }
+    oc_move_to(points[0].x, points[0].y);
+
+    if(context->polylineDecimation > 0)
+    {
+        oc_polyline_decimate(context, count, points);
+        context->subPathLastPoint = points[count - 1];
+        return;
+    }
+
+    //NOTE: lines are packed three by three in OC_PATH_POLYLINE elements, and the remaining ones use OC_PATH_LINE
+    u32 lineCount = count - 1;
+    u32 polylineCount = lineCount / 3;
+    u32 eltCount = polylineCount + lineCount % 3;
+
+    if(!oc_path_reserve_elements(context, eltCount))
+    {
+        return;
+    }
+    oc_path_elt* elements = context->pathElements + context->path.startIndex + context->path.count;
+    oc_vec2* p = points + 1;
+
+    for(u32 i = 0; i < polylineCount; i++)
+    {
+        elements[i] = (oc_path_elt){ .type = OC_PATH_POLYLINE, .p = { p[0], p[1], p[2] } };
+        p += 3;
+    }
+    for(u32 i = polylineCount; i < eltCount; i++)
+    {
+        elements[i] = (oc_path_elt){ .type = OC_PATH_LINE, .p[0] = p[0] };
+        p++;
+    }
+    context->path.count += eltCount;
+    context->subPathLastPoint = points[count - 1];
+}
+
+void oc_close_path()
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(!context)
+    {
+        return;
+    }
+    if(context->subPathStartPoint.x != context->subPathLastPoint.x
+       || context->subPathStartPoint.y != context->subPathLastPoint.y)
+    {
+        oc_line_to(context->subPathStartPoint.x, context->subPathStartPoint.y);
+    }
+    context->subPathStartPoint = context->subPathLastPoint;
+}
+
+static f32 oc_font_stroke_missing_glyph(oc_canvas_context_data* context, oc_font_data* fontData, f32 x, f32 y, f32 scale, f32 flip)
+{
+    //NOTE(martin): render an empty rectangle in place of a missing glyph, and return its advance
+    oc_glyph_metrics missingGlyphMetrics = fontData->missingGlyphMetrics;
+    f32 oldStrokeWidth = context->attributes.width;
+
+    oc_set_width(missingGlyphMetrics.ink.w * 0.005);
+    oc_rectangle_stroke(x + missingGlyphMetrics.ink.x * scale,
+                        y + missingGlyphMetrics.ink.y * scale,
+                        missingGlyphMetrics.ink.w * scale * flip,
+                        missingGlyphMetrics.ink.h * scale);
+
+    oc_set_width(oldStrokeWidth);
+    return (missingGlyphMetrics.advance.x * scale);
+}
+
+static oc_glyph_run_outlines oc_glyph_run_outlines_from_font_data(oc_font_data* fontData,
+                                                                  f32 fontSize,
+                                                                  bool flip,
+                                                                  oc_vec2 start,
+                                                                  oc_str32 glyphIndices,
+                                                                  u32 eltCap,
+                                                                  oc_path_elt* elements)
+{
+    oc_glyph_run_outlines run = { .end = start };
+    f32 scale = fontSize / fontData->unitsPerEm;
+    f32 yScale = flip ? scale : -scale;
+
+    for(; run.glyphCount < glyphIndices.len; run.glyphCount++)
+    {
+        u32 glyphIndex = glyphIndices.ptr[run.glyphCount];
+        if(!glyphIndex || glyphIndex >= fontData->glyphCount)
+        {
+            //NOTE: missing glyphs without a replacement glyph are drawn by the caller
+            glyphIndex = fontData->replacementGlyphIndex;
+            if(!glyphIndex)
+            {
+                break;
+            }
+        }
+
+        oc_glyph_data* glyph = oc_font_get_glyph_data(fontData, glyphIndex);
+        oc_path_elt* outline = oc_font_get_glyph_outline(fontData, glyph);
+        u32 outlineCount = outline ? glyph->pathDescriptor.count : 0;
+
+        if(eltCap - run.eltCount < outlineCount + 1)
+        {
+            run.neededEltCount = outlineCount + 1;
+            break;
+        }
+
+        oc_path_elt* dst = elements + run.eltCount;
+        for(int eltIndex = 0; eltIndex < outlineCount; eltIndex++)
+        {
+            dst[eltIndex].type = outline[eltIndex].type;
+            for(int pIndex = 0; pIndex < 3; pIndex++)
+            {
+                dst[eltIndex].p[pIndex].x = outline[eltIndex].p[pIndex].x * scale + run.end.x;
+                dst[eltIndex].p[pIndex].y = outline[eltIndex].p[pIndex].y * yScale + run.end.y;
+            }
+        }
+        run.eltCount += outlineCount;
+
+        run.end.x += scale * glyph->metrics.advance.x;
+        elements[run.eltCount] = (oc_path_elt){ .type = OC_PATH_MOVE, .p[0] = run.end };
+        run.eltCount++;
+
+        run.maxWidth = oc_max(run.maxWidth, run.end.x - start.x);
+    }
+    return (run);
+}
+
+#if !OC_PLATFORM_ORCA
+oc_glyph_run_outlines oc_font_glyph_run_outlines(oc_font font,
+                                                 f32 fontSize,
+                                                 bool flip,
+                                                 oc_vec2 start,
+                                                 u32 glyphCount,
+                                                 u32* glyphIndices,
+                                                 u32 eltCap,
+                                                 oc_path_elt* elements)
+{
+    oc_font_data* fontData = oc_font_data_from_handle(font);
+    if(!fontData)
+    {
+        return ((oc_glyph_run_outlines){ .end = start });
+    }
+    return (oc_glyph_run_outlines_from_font_data(fontData,
+                                                 fontSize,
+                                                 flip,
+                                                 start,
+                                                 (oc_str32){ .ptr = glyphIndices, .len = glyphCount },
+                                                 eltCap,
+                                                 elements));
+}
+#endif
+
+oc_rect oc_glyph_outlines_from_font_data(oc_font_data* fontData, oc_str32 glyphIndices)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+
+    f32 startX = context->subPathLastPoint.x;
+    f32 startY = context->subPathLastPoint.y;
+    f32 maxWidth = 0;
+
+    f32 scale = context->attributes.fontSize / fontData->unitsPerEm;
+    f32 flip = context->textFlip ? 1 : -1;
+
+    if(fontData->memberCount)
+    {
+        //NOTE: outline the runs of glyphs coming from the same member one after the other
+        oc_arena_scope scratch = oc_scratch_begin();
+        u32* memberIndices = oc_arena_push_array(scratch.arena, u32, glyphIndices.len);
+
+        u32 start = 0;
+        while(start < glyphIndices.len)
+        {
+            oc_font_data* member = 0;
+            u32 end = oc_font_collection_next_segment(fontData, glyphIndices, start, memberIndices, &member);
+            if(member)
+            {
+                oc_rect box = oc_glyph_outlines_from_font_data(member, (oc_str32){ .ptr = memberIndices + start, .len = end - start });
+                maxWidth = oc_max(maxWidth, box.x + box.w - startX);
+            }
+            start = end;
+        }
+        oc_scratch_end(scratch);
+
+        f32 lineHeight = (fontData->metrics.ascent + fontData->metrics.descent) * scale;
+        return ((oc_rect){ startX, startY, maxWidth, context->subPathLastPoint.y - startY + lineHeight });
+    }
+
+    //NOTE(martin): outline the glyphs in runs written straight to the path elements buffer, growing it when a glyph
+    //              doesn't fit, and drawing missing glyphs between runs.
+    u32 eltReserve = OC_GLYPH_RUN_ELT_RESERVE;
+    u64 glyphStart = 0;
+    while(glyphStart < glyphIndices.len)
+    {
+        if(!oc_path_reserve_elements(context, eltReserve))
+        {
+            break;
+        }
+        u32 eltStart = context->path.startIndex + context->path.count;
+        oc_str32 glyphs = oc_str32_slice(glyphIndices, glyphStart, glyphIndices.len);
+        oc_vec2 pen = context->subPathLastPoint;
+        oc_glyph_run_outlines run = { 0 };
+
+#if OC_PLATFORM_ORCA
+        if(!oc_font_is_nil(fontData->hostFont))
+        {
+            run = oc_font_glyph_run_outlines(fontData->hostFont,
+                                             context->attributes.fontSize,
+                                             context->textFlip,
+                                             pen,
+                                             glyphs.len,
+                                             glyphs.ptr,
+                                             context->pathElementCap - eltStart,
+                                             context->pathElements + eltStart);
+        }
+        else
+#endif
+        {
+            run = oc_glyph_run_outlines_from_font_data(fontData,
+                                                       context->attributes.fontSize,
+                                                       context->textFlip,
+                                                       pen,
+                                                       glyphs,
+                                                       context->pathElementCap - eltStart,
+                                                       context->pathElements + eltStart);
+        }
+
+        context->path.count += run.eltCount;
+        if(run.glyphCount)
+        {
+            //NOTE(martin): each glyph ends with a move to the next pen position, as if set by oc_move_to()
+            context->subPathStartPoint = run.end;
+            context->subPathLastPoint = run.end;
+            maxWidth = oc_max(maxWidth, pen.x + run.maxWidth - startX);
+        }
+        glyphStart += run.glyphCount;
+
+        if(run.neededEltCount)
+        {
+            eltReserve = oc_max(eltReserve, run.neededEltCount);
+        }
+        else if(glyphStart < glyphIndices.len)
+        {
+            oc_log_warning("code point is not present in font ranges\n");
+
+            f32 xOffset = context->subPathLastPoint.x;
+            f32 yOffset = context->subPathLastPoint.y;
+            f32 advance = oc_font_stroke_missing_glyph(context, fontData, xOffset, yOffset, scale, flip);
+            oc_move_to(xOffset + advance, yOffset);
+            maxWidth = oc_max(maxWidth, xOffset + advance - startX);
+            glyphStart++;
+        }
+    }
+    f32 lineHeight = (fontData->metrics.ascent + fontData->metrics.descent) * scale;
+    oc_rect box = { startX, startY, maxWidth, context->subPathLastPoint.y - startY + lineHeight };
+    return (box);
+}
+
+oc_rect oc_glyph_outlines(oc_str32 glyphIndices)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(!context)
+    {
+        return ((oc_rect){ 0 });
+    }
+    oc_font_data* fontData = oc_font_data_from_handle(context->attributes.font);
+    if(!fontData)
+    {
+        return ((oc_rect){ 0 });
+    }
+    return (oc_glyph_outlines_from_font_data(fontData, glyphIndices));
+}
+
+void oc_codepoints_outlines(oc_str32 codePoints)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(!context)
+    {
+        return;
+    }
+    oc_font_data* fontData = oc_font_data_from_handle(context->attributes.font);
+    if(!fontData)
+    {
+        return;
+    }
+
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_str32 glyphIndices = oc_font_push_glyph_indices(scratch.arena, context->attributes.font, codePoints);
+    oc_glyph_outlines_from_font_data(fontData, glyphIndices);
+
+    oc_scratch_end(scratch);
+}
+
+void oc_text_outlines(oc_str8 text)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(!context)
+    {
+        return;
+    }
+    oc_font_data* fontData = oc_font_data_from_handle(context->attributes.font);
+    if(!fontData)
+    {
+        return;
+    }
+
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_str32 codePoints = oc_utf8_push_to_codepoints(scratch.arena, text);
+    oc_str32 glyphIndices = oc_font_push_glyph_indices(scratch.arena, context->attributes.font, codePoints);
+
+    oc_glyph_outlines_from_font_data(fontData, glyphIndices);
+
+    oc_scratch_end(scratch);
+}
+
+//------------------------------------------------------------------------------------------
+//NOTE(martin): clear/fill/stroke
+//------------------------------------------------------------------------------------------
+
+void oc_clear()
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        if(context->recording)
+        {
+            oc_log_warning("oc_clear() can't be recorded in a display list\n");
+            return;
+        }
+        context->primitiveCount = 0;
+        context->attributeCount = 0;
+        context->clearColor = context->attributes.colors[0];
+        context->clear = true;
+    }
+}
+
+void oc_fill()
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context && context->path.count)
+    {
+        oc_push_command(context, (oc_primitive){ .cmd = OC_CMD_FILL, .path = context->path });
+        oc_new_path(context);
+    }
+}
+
+void oc_stroke()
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context && context->path.count)
+    {
+        oc_push_command(context, (oc_primitive){ .cmd = OC_CMD_STROKE, .path = context->path });
+        oc_new_path(context);
+    }
+}
+
+static void oc_push_path_copies(oc_canvas_context_data* context, oc_primitive_cmd cmd, u32 count, oc_mat2x3* transforms, oc_color* colors)
+{
+    //NOTE: the path's elements are recorded once and shared by all copies. Each copy only adds a primitive
+    //      referencing them, and an attributes entry holding its transform and color. This isn't GPU instancing:
+    //      the renderer still encodes and rasterizes each copy as its own path.
+    if(!context || !context->path.count)
+    {
+        return;
+    }
+    if(!oc_canvas_buffer_reserve((void**)&context->primitives,
+                                 &context->primitiveCap,
+                                 context->primitiveCount + count,
+                                 OC_CANVAS_DEFAULT_PRIMITIVE_CAP,
+                                 sizeof(oc_primitive)))
+    {
+        oc_new_path(context);
+        return;
+    }
+
+    oc_mat2x3 transform = oc_matrix_stack_top(context);
+    oc_attributes savedAttributes = context->attributes;
+
+    for(u32 i = 0; i < count; i++)
+    {
+        if(colors)
+        {
+            context->attributes.hasGradient = false;
+            for(int colorIndex = 0; colorIndex < 4; colorIndex++)
+            {
+                context->attributes.colors[colorIndex] = colors[i];
+            }
+        }
+        if(!oc_push_command_with_transform(context,
+                                           (oc_primitive){ .cmd = cmd, .path = context->path },
+                                           oc_mat2x3_mul_m(transform, transforms[i])))
+        {
+            break;
+        }
+    }
+    context->attributes = savedAttributes;
+    oc_new_path(context);
+}
+
+void oc_fill_copies(u32 count, oc_mat2x3* transforms, oc_color* colors)
+{
+    oc_push_path_copies(oc_currentCanvasContext, OC_CMD_FILL, count, transforms, colors);
+}
+
+void oc_stroke_copies(u32 count, oc_mat2x3* transforms, oc_color* colors)
+{
+    oc_push_path_copies(oc_currentCanvasContext, OC_CMD_STROKE, count, transforms, colors);
+}
+
+//------------------------------------------------------------------------------------------
+//NOTE(martin): simple shape helpers
+//------------------------------------------------------------------------------------------
+
+void oc_rectangle_path(f32 x, f32 y, f32 w, f32 h)
+{
+    oc_move_to(x, y);
+    oc_line_to(x + w, y);
+    oc_line_to(x + w, y + h);
+    oc_line_to(x, y + h);
+    oc_close_path();
+}
+
+static void oc_fill_rect_shape(oc_canvas_context_data* context, bool newPath, oc_primitive_cmd cmd, f32 radius)
+{
+    //NOTE: rectangles are still pushed as a path, so that renderers can fall back to filling it, but they are tagged
+    //      so that the renderer can rasterize them directly. This is only possible if the path holds nothing else.
+    if(!newPath)
+    {
+        oc_fill();
+    }
+    else if(context->path.count)
+    {
+        oc_push_command(context, (oc_primitive){ .cmd = cmd, .path = context->path, .radius = radius });
+        oc_new_path(context);
+    }
+}
+
+void oc_rectangle_fill(f32 x, f32 y, f32 w, f32 h)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        bool newPath = (context->path.count == 0);
+        oc_rectangle_path(x, y, w, h);
+        oc_fill_rect_shape(context, newPath, OC_CMD_RECT, 0);
+    }
+}
+
+void oc_rectangle_stroke(f32 x, f32 y, f32 w, f32 h)
+{
+    oc_rectangle_path(x, y, w, h);
+    oc_stroke();
+}
+
+void oc_rounded_rectangle_path(f32 x, f32 y, f32 w, f32 h, f32 r)
+{
+    r = oc_min(r, oc_min(w / 2, h / 2));
+    f32 c = r * 4 * (sqrt(2) - 1) / 3;
+
+    oc_move_to(x + r, y);
+    oc_line_to(x + w - r, y);
+    oc_cubic_to(x + w - r + c, y, x + w, y + r - c, x + w, y + r);
+    oc_line_to(x + w, y + h - r);
+    oc_cubic_to(x + w, y + h - r + c, x + w - r + c, y + h, x + w - r, y + h);
+    oc_line_to(x + r, y + h);
+    oc_cubic_to(x + r - c, y + h, x, y + h - r + c, x, y + h - r);
+    oc_line_to(x, y + r);
+    oc_cubic_to(x, y + r - c, x + r - c, y, x + r, y);
+}
+
+void oc_rounded_rectangle_fill(f32 x, f32 y, f32 w, f32 h, f32 r)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context)
+    {
+        bool newPath = (context->path.count == 0);
+        oc_rounded_rectangle_path(x, y, w, h, r);
+        oc_fill_rect_shape(context, newPath, OC_CMD_RRECT, oc_min(r, oc_min(w / 2, h / 2)));
+    }
+}
+
+void oc_rounded_rectangle_stroke(f32 x, f32 y, f32 w, f32 h, f32 r)
+{
+    oc_rounded_rectangle_path(x, y, w, h, r);
+    oc_stroke();
+}
+
+void oc_ellipse_path(f32 x, f32 y, f32 rx, f32 ry)
+{
+    f32 cx = rx * 4 * (sqrt(2) - 1) / 3;
+    f32 cy = ry * 4 * (sqrt(2) - 1) / 3;
+
+    oc_move_to(x - rx, y);
+    oc_cubic_to(x - rx, y + cy, x - cx, y + ry, x, y + ry);
+    oc_cubic_to(x + cx, y + ry, x + rx, y + cy, x + rx, y);
+    oc_cubic_to(x + rx, y - cy, x + cx, y - ry, x, y - ry);
+    oc_cubic_to(x - cx, y - ry, x - rx, y - cy, x - rx, y);
+}
+
+void oc_ellipse_fill(f32 x, f32 y, f32 rx, f32 ry)
+{
+    oc_ellipse_path(x, y, rx, ry);
+    oc_fill();
+}
+
+void oc_ellipse_stroke(f32 x, f32 y, f32 rx, f32 ry)
+{
+    oc_ellipse_path(x, y, rx, ry);
+    oc_stroke();
+}
+
+void oc_circle_fill(f32 x, f32 y, f32 r)
+{
+    oc_ellipse_fill(x, y, r, r);
+}
+
+void oc_circle_stroke(f32 x, f32 y, f32 r)
+{
+    oc_ellipse_stroke(x, y, r, r);
+}
+
+//TODO: change to arc_to?
+void oc_arc(f32 x, f32 y, f32 r, f32 arcAngle, f32 startAngle)
+{
+    f32 endAngle = startAngle + arcAngle;
+
+    while(startAngle < endAngle)
+    {
+        f32 smallAngle = oc_min(endAngle - startAngle, M_PI / 4.);
+        if(smallAngle < 0.001)
+        {
+            break;
+        }
+
+        oc_vec2 v0 = { cos(smallAngle / 2), sin(smallAngle / 2) };
+        oc_vec2 v1 = { (4 - v0.x) / 3, (1 - v0.x) * (3 - v0.x) / (3 * v0.y) };
+        oc_vec2 v2 = { v1.x, -v1.y };
+        oc_vec2 v3 = { v0.x, -v0.y };
+
+        f32 rotAngle = smallAngle / 2 + startAngle;
+        f32 rotCos = cos(rotAngle);
+        f32 rotSin = sin(rotAngle);
+
+        oc_mat2x3 t = { r * rotCos, -r * rotSin, x,
+                        r * rotSin, r * rotCos, y };
+
+        v0 = oc_mat2x3_mul(t, v0);
+        v1 = oc_mat2x3_mul(t, v1);
+        v2 = oc_mat2x3_mul(t, v2);
+        v3 = oc_mat2x3_mul(t, v3);
+
+        oc_move_to(v0.x, v0.y);
+        oc_cubic_to(v1.x, v1.y, v2.x, v2.y, v3.x, v3.y);
+
+        startAngle += smallAngle;
+    }
+}
+
+void oc_text_cache_enable(oc_canvas_renderer renderer, f32 maxPixelSize, f32 pixelScale)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(!context || oc_canvas_renderer_is_nil(renderer) || pixelScale <= 0)
+    {
+        return;
+    }
+    oc_text_cache* cache = context->textCache;
+    if(cache && cache->renderer.h != renderer.h)
+    {
+        oc_text_cache_destroy(cache);
+        cache = context->textCache = 0;
+    }
+    if(!cache)
+    {
+        oc_image image = oc_image_create(renderer, OC_TEXT_CACHE_ATLAS_SIZE, OC_TEXT_CACHE_ATLAS_SIZE);
+        if(oc_image_is_nil(image))
+        {
+            return;
+        }
+        cache = oc_malloc_type(oc_text_cache);
+        memset(cache, 0, sizeof(oc_text_cache));
+        cache->renderer = renderer;
+        cache->image = image;
+        cache->fontDestroyCount = oc_graphicsData.fontDestroyCount;
+
+        oc_arena_init(&cache->arena);
+        cache->atlas = oc_rect_atlas_create(&cache->arena, OC_TEXT_CACHE_ATLAS_SIZE, OC_TEXT_CACHE_ATLAS_SIZE);
+        oc_image_atlas_set_growth(cache->atlas, renderer, OC_TEXT_CACHE_MAX_PAGES);
+
+        context->textCache = cache;
+    }
+    //NOTE: glyphs cached at another scale are kept, they are keyed by their pixel size
+    cache->maxPixelSize = maxPixelSize;
+    cache->pixelScale = pixelScale;
+    cache->enabled = true;
+}
+
+void oc_text_cache_disable(void)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(context && context->textCache)
+    {
+        //NOTE: primitives of the current frame may still reference the atlas, so it is kept until the context is destroyed
+        context->textCache->enabled = false;
+    }
+}
+
+static bool oc_text_cache_rasterize(oc_text_cache* cache,
+                                    oc_font_data* fontData,
+                                    oc_glyph_data* glyph,
+                                    oc_path_elt* outline,
+                                    f32 pixelSize,
+                                    f32 shiftX,
+                                    oc_text_cache_entry* entry)
+{
+    u32 eltCount = glyph->pathDescriptor.count;
+    f32 scale = pixelSize / fontData->unitsPerEm;
+    bool result = true;
+
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    //NOTE: convert the outline back to stb_truetype vertices, in font units with y up, and compute its bounding box
+    stbtt_vertex* vertices = oc_arena_push_array(scratch.arena, stbtt_vertex, eltCount);
+    oc_vec2 boxMin = { FLT_MAX, FLT_MAX };
+    oc_vec2 boxMax = { -FLT_MAX, -FLT_MAX };
+
+    for(u32 eltIndex = 0; eltIndex < eltCount; eltIndex++)
+    {
+        oc_path_elt* elt = &outline[eltIndex];
+        stbtt_vertex* vertex = &vertices[eltIndex];
+        memset(vertex, 0, sizeof(stbtt_vertex));
+
+        int pointCount = 1;
+        switch(elt->type)
+        {
+            case OC_PATH_MOVE:
+                vertex->type = STBTT_vmove;
+                break;
+
+            case OC_PATH_LINE:
+                vertex->type = STBTT_vline;
+                break;
+
+            case OC_PATH_QUADRATIC:
+                vertex->type = STBTT_vcurve;
+                vertex->cx = elt->p[0].x;
+                vertex->cy = elt->p[0].y;
+                pointCount = 2;
+                break;
+
+            case OC_PATH_CUBIC:
+                vertex->type = STBTT_vcubic;
+                vertex->cx = elt->p[0].x;
+                vertex->cy = elt->p[0].y;
+                vertex->cx1 = elt->p[1].x;
+                vertex->cy1 = elt->p[1].y;
+                pointCount = 3;
+                break;
+        }
+        vertex->x = elt->p[pointCount - 1].x;
+        vertex->y = elt->p[pointCount - 1].y;
+
+        for(int i = 0; i < pointCount; i++)
+        {
+            boxMin.x = oc_min(boxMin.x, elt->p[i].x);
+            boxMin.y = oc_min(boxMin.y, elt->p[i].y);
+            boxMax.x = oc_max(boxMax.x, elt->p[i].x);
+            boxMax.y = oc_max(boxMax.y, elt->p[i].y);
+        }
+    }
+
+    //NOTE: same bitmap box as stbtt_GetGlyphBitmapBoxSubpixel(), with y pointing down
+    int x0 = floorf(boxMin.x * scale + shiftX);
+    int y0 = floorf(-boxMax.y * scale);
+    int x1 = ceilf(boxMax.x * scale + shiftX);
+    int y1 = ceilf(-boxMin.y * scale);
+    int width = x1 - x0;
+    int height = y1 - y0;
+
+    entry->region = (oc_image_region){ 0 };
+    entry->offset = (oc_vec2){ x0, y0 };
+
+    if(eltCount && width > 0 && height > 0)
+    {
+        u8* coverage = oc_arena_push_array(scratch.arena, u8, width * height);
+        memset(coverage, 0, width * height);
+
+        stbtt__bitmap bitmap = { .w = width, .h = height, .stride = width, .pixels = coverage };
+        stbtt_Rasterize(&bitmap, 0.35f, vertices, eltCount, scale, scale, shiftX, 0, x0, y0, 1, 0);
+
+        //NOTE: the rasterizer premultiplies texels by their alpha and modulates them by the fill color, so coverage
+        //      is stored as white with coverage alpha
+        u8* pixels = oc_arena_push_array(scratch.arena, u8, width * height * 4);
+        for(int i = 0; i < width * height; i++)
+        {
+            pixels[4 * i + 0] = 255;
+            pixels[4 * i + 1] = 255;
+            pixels[4 * i + 2] = 255;
+            pixels[4 * i + 3] = coverage[i];
+        }
+        entry->region = oc_image_atlas_alloc_from_rgba8(cache->atlas, cache->image, width, height, pixels);
+        result = !oc_image_is_nil(entry->region.image);
+    }
+
+    oc_scratch_end(scratch);
+    return (result);
+}
+
+static oc_text_cache* oc_text_cache_for_run(oc_canvas_context_data* context, oc_mat2x3 transform, f32 flip, u32* sizeKey)
+{
+    oc_text_cache* cache = context->textCache;
+    if(!cache || !cache->enabled || context->recording)
+    {
+        //NOTE: display lists can be replayed after the cache is flushed, so they always get outlines
+        return (0);
+    }
+    if(cache->fontDestroyCount != oc_graphicsData.fontDestroyCount)
+    {
+        //NOTE: the font data of cached glyphs may have been reused by another font
+        cache->stale = true;
+    }
+    if(cache->stale)
+    {
+        return (0);
+    }
+
+    //NOTE: bitmaps are only used for upright text with a uniform scale, whose size on screen is small enough
+    f32 pixelSize = context->attributes.fontSize * transform.m[0] * cache->pixelScale;
+    if(transform.m[1] != 0
+       || transform.m[3] != 0
+       || transform.m[0] <= 0
+       || fabsf(transform.m[4] * flip + transform.m[0]) > 1e-5 * transform.m[0]
+       || pixelSize > cache->maxPixelSize
+       || pixelSize * 4 < 1)
+    {
+        return (0);
+    }
+    *sizeKey = (u32)(pixelSize * 4 + 0.5);
+    return (cache);
+}
+
+static bool oc_text_cache_draw_glyph(oc_canvas_context_data* context,
+                                     oc_text_cache* cache,
+                                     oc_font_data* fontData,
+                                     u32 glyphIndex,
+                                     oc_glyph_data* glyph,
+                                     oc_path_elt* outline,
+                                     u32 sizeKey,
+                                     oc_vec2 pen,
+                                     oc_path_descriptor* unitRect)
+{
+    //NOTE: the pen position is in pixels. It is snapped to the pixel grid vertically, and to a subpixel step horizontally
+    f32 penX = floorf(pen.x);
+    f32 penY = roundf(pen.y);
+    u32 subpixel = (u32)roundf((pen.x - penX) * OC_TEXT_CACHE_SUBPIXEL_STEPS);
+    if(subpixel == OC_TEXT_CACHE_SUBPIXEL_STEPS)
+    {
+        penX += 1;
+        subpixel = 0;
+    }
+
+    oc_text_cache_entry* entry = oc_text_cache_lookup(cache, fontData, glyphIndex, sizeKey, subpixel);
+    if(!entry)
+    {
+        return (false);
+    }
+    if(!entry->used)
+    {
+        if(!oc_text_cache_rasterize(cache,
+                                    fontData,
+                                    glyph,
+                                    outline,
+                                    sizeKey / 4.,
+                                    (f32)subpixel / OC_TEXT_CACHE_SUBPIXEL_STEPS,
+                                    entry))
+        {
+            cache->full = true;
+            return (false);
+        }
+        entry->font = fontData;
+        entry->glyphIndex = glyphIndex;
+        entry->sizeKey = sizeKey;
+        entry->subpixel = subpixel;
+        entry->used = true;
+        cache->entryCount++;
+    }
+    if(oc_image_is_nil(entry->region.image))
+    {
+        return (true);
+    }
+
+    if(unitRect->count == 0)
+    {
+        //NOTE: bitmap glyphs of a run share a unit square path, like oc_sprite_batch_draw()
+        oc_rectangle_path(0, 0, 1, 1);
+        *unitRect = context->path;
+        oc_new_path(context);
+        if(unitRect->count == 0)
+        {
+            return (false);
+        }
+    }
+
+    f32 invScale = 1. / cache->pixelScale;
+    oc_rect rect = entry->region.rect;
+    oc_mat2x3 quadTransform = { rect.w * invScale, 0, (penX + entry->offset.x) * invScale,
+                                0, rect.h * invScale, (penY + entry->offset.y) * invScale };
+
+    oc_attributes savedAttributes = context->attributes;
+    context->attributes.image = entry->region.image;
+    context->attributes.srcRegion = rect;
+
+    bool pushed = oc_push_command_with_transform(context, (oc_primitive){ .cmd = OC_CMD_RECT, .path = *unitRect }, quadTransform);
+
+    context->attributes = savedAttributes;
+    return (pushed);
+}
+
+static void oc_glyph_run_fill_from_font_data(oc_canvas_context_data* context, oc_font_data* fontData, f32 x, f32 y, oc_str32 glyphIndices)
+{
+    //NOTE(martin): fill each glyph as its own primitive, copying the glyph's outline verbatim from the font
+    //              and folding its scale and pen position into the primitive's transform, instead of
+    //              transforming every point of the outline. The outline is only copied the first time the
+    //              glyph is drawn in a frame, later occurrences reference the same elements.
+    //              Small upright text is drawn from the context's glyph cache instead, if it was enabled.
+    if(fontData->memberCount)
+    {
+        //NOTE: draw the runs of glyphs coming from the same member of a collection one after the other
+        oc_arena_scope scratch = oc_scratch_begin();
+        u32* memberIndices = oc_arena_push_array(scratch.arena, u32, glyphIndices.len);
+
+        u32 start = 0;
+        while(start < glyphIndices.len)
+        {
+            oc_font_data* member = 0;
+            u32 end = oc_font_collection_next_segment(fontData, glyphIndices, start, memberIndices, &member);
+            if(member)
+            {
+                oc_glyph_run_fill_from_font_data(context, member, x, y, (oc_str32){ .ptr = memberIndices + start, .len = end - start });
+                x = context->subPathLastPoint.x;
+            }
+            start = end;
+        }
+        oc_scratch_end(scratch);
+
+        context->subPathLastPoint = (oc_vec2){ x, y };
+        return;
+    }
+    f32 scale = context->attributes.fontSize / fontData->unitsPerEm;
+    f32 flip = context->textFlip ? 1 : -1;
+    oc_mat2x3 transform = oc_matrix_stack_top(context);
+    f32 xOffset = x;
+
+    u32 sizeKey = 0;
+    oc_text_cache* cache = oc_text_cache_for_run(context, transform, flip, &sizeKey);
+    oc_path_descriptor unitRect = { 0 };
+
+    for(int i = 0; i < glyphIndices.len; i++)
+    {
+        u32 glyphIndex = glyphIndices.ptr[i];
+
+        if(!glyphIndex || glyphIndex >= fontData->glyphCount)
+        {
+            oc_log_warning("code point is not present in font ranges\n");
+            glyphIndex = fontData->replacementGlyphIndex;
+            if(!glyphIndex)
+            {
+                xOffset += oc_font_stroke_missing_glyph(context, fontData, xOffset, y, scale, flip);
+                continue;
+            }
+        }
+
+        oc_glyph_data* glyph = oc_font_get_glyph_data(fontData, glyphIndex);
+        oc_path_elt* outline = oc_font_get_glyph_outline(fontData, glyph);
+
+        bool cached = outline
+                   && cache
+                   && oc_text_cache_draw_glyph(context,
+                                               cache,
+                                               fontData,
+                                               glyphIndex,
+                                               glyph,
+                                               outline,
+                                               sizeKey,
+                                               oc_vec2_mul(cache->pixelScale, oc_mat2x3_mul(transform, (oc_vec2){ xOffset, y })),
+                                               &unitRect);
+
+        if(outline && !cached)
+        {
+            oc_mat2x3 glyphTransform = { scale, 0, xOffset,
+                                         0, scale * flip, y };
+
+            bool found = false;
+            oc_canvas_glyph_slot* slot = oc_canvas_glyph_slot_lookup(context, fontData, glyphIndex, &found);
+            if(!found)
+            {
+                if(!oc_path_push_elements(context, glyph->pathDescriptor.count, outline))
+                {
+                    context->path.count = 0;
+                    break;
+                }
+                //NOTE: glyph paths start at the pen position, which is the origin of the glyph's outline
+                *slot = (oc_canvas_glyph_slot){
+                    .font = fontData,
+                    .glyphIndex = glyphIndex,
+                    .generation = context->glyphSlotGeneration,
+                    .path = { .startIndex = context->path.startIndex, .count = context->path.count },
+                };
+                oc_new_path(context);
+            }
+
+            if(!oc_push_command_with_transform(context,
+                                               (oc_primitive){ .cmd = OC_CMD_GLYPH, .path = slot->path },
+                                               oc_mat2x3_mul_m(transform, glyphTransform)))
+            {
+                break;
+            }
+        }
+        xOffset += scale * glyph->metrics.advance.x;
+    }
+    context->subPathLastPoint = (oc_vec2){ xOffset, y };
+    oc_new_path(context);
+}
+
+void oc_text_fill(f32 x, f32 y, oc_str8 text)
+{
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(!context)
+    {
+        return;
+    }
+    oc_font_data* fontData = oc_font_data_from_handle(context->attributes.font);
+
+    if(fontData
+       && !context->path.count
+       && !context->attributes.hasGradient
+       && oc_image_is_nil(context->attributes.image))
+    {
+        //NOTE(martin): gradients and images are mapped in user space over the whole path,
+        //              so we can only use per-glyph transforms when neither is set.
+        oc_arena_scope scratch = oc_scratch_begin();
+        oc_str32 codePoints = oc_utf8_push_to_codepoints(scratch.arena, text);
+        oc_str32 glyphIndices = oc_font_push_glyph_indices(scratch.arena, context->attributes.font, codePoints);
+
+        oc_glyph_run_fill_from_font_data(context, fontData, x, y, glyphIndices);
+
+        oc_scratch_end(scratch);
+    }
+    else
+    {
+        oc_move_to(x, y);
+        oc_text_outlines(text);
+        oc_fill();
+    }
 }
 
-void oc_text_outlines(oc_str8 text)
+void oc_text_layout_fill(f32 x, f32 y, oc_text_layout* layout)
 {
     oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(!context)
+    oc_font_data* fontData = oc_font_data_from_handle(layout->font);
+    if(!context || !fontData)
     {
         return;
     }
-    oc_font_data* fontData = oc_font_data_from_handle(context->attributes.font);
-    if(!fontData)
+    oc_font savedFont = context->attributes.font;
+    f32 savedFontSize = context->attributes.fontSize;
+    context->attributes.font = layout->font;
+    context->attributes.fontSize = layout->fontSize;
+
+    //NOTE: same conditions as oc_text_fill() for drawing each line as a glyph run
+    bool glyphRuns = !context->path.count
+                  && !context->attributes.hasGradient
+                  && oc_image_is_nil(context->attributes.image);
+
+    f32 flip = context->textFlip ? -1 : 1;
+
+    for(u32 lineIndex = 0; lineIndex < layout->lineCount; lineIndex++)
     {
-        return;
-    }
+        oc_text_line* line = &layout->lines[lineIndex];
 
-    oc_arena_scope scratch = oc_scratch_begin();
-    oc_str32 codePoints = oc_utf8_push_to_codepoints(scratch.arena, text);
-    oc_str32 glyphIndices = oc_font_push_glyph_indices(scratch.arena, context->attributes.font, codePoints);
+        //NOTE: trailing spaces and line feeds aren't drawn
+        u32 count = line->count;
+        while(count)
+        {
+            oc_utf32 codePoint = layout->codePoints[line->start + count - 1];
+            if(codePoint != '\n' && !oc_text_layout_is_space(codePoint))
+            {
+                break;
+            }
+            count--;
+        }
+        if(!count)
+        {
+            continue;
+        }
+        oc_str32 glyphIndices = { .ptr = layout->glyphIndices + line->start, .len = count };
+        f32 lineX = x + line->origin.x;
+        f32 lineY = y + flip * line->origin.y;
 
-    oc_glyph_outlines_from_font_data(fontData, glyphIndices);
+        if(glyphRuns)
+        {
+            oc_glyph_run_fill_from_font_data(context, fontData, lineX, lineY, glyphIndices);
+        }
+        else
+        {
+            oc_move_to(lineX, lineY);
+            oc_glyph_outlines_from_font_data(fontData, glyphIndices);
+        }
+    }
+    if(!glyphRuns)
+    {
+        oc_fill();
+    }
 
-    oc_scratch_end(scratch);
+    context->attributes.font = savedFont;
+    context->attributes.fontSize = savedFontSize;
 }
 
 //------------------------------------------------------------------------------------------
-//NOTE(martin): clear/fill/stroke
+//NOTE(martin): images
 //------------------------------------------------------------------------------------------
 
-void oc_clear()
+oc_image oc_image_nil()
 {
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context)
-    {
-        context->primitiveCount = 0;
-        context->clearColor = context->attributes.colors[0];
-        context->clear = true;
-    }
+    return ((oc_image){ .h = 0 });
 }
 
-void oc_fill()
+bool oc_image_is_nil(oc_image image)
 {
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context && context->path.count)
-    {
-        oc_push_command(context, (oc_primitive){ .cmd = OC_CMD_FILL, .path = context->path });
-        oc_new_path(context);
-    }
+    return (image.h == 0);
 }
 
-void oc_stroke()
+oc_image oc_image_create_from_rgba8(oc_canvas_renderer renderer, u32 width, u32 height, u8* pixels)
 {
-    oc_canvas_context_data* context = oc_currentCanvasContext;
-    if(context && context->path.count)
+    oc_image image = oc_image_create(renderer, width, height);
+    if(!oc_image_is_nil(image))
     {
-        oc_push_command(context, (oc_primitive){ .cmd = OC_CMD_STROKE, .path = context->path });
-        oc_new_path(context);
+        oc_image_upload_region_rgba8(image, (oc_rect){ 0, 0, width, height }, pixels);
     }
+    return (image);
 }
 
 //------------------------------------------------------------------------------------------
-//NOTE(martin): simple shape helpers
+//NOTE: pixel conversions
 //------------------------------------------------------------------------------------------
 
-void oc_rectangle_path(f32 x, f32 y, f32 w, f32 h)
+void oc_pixels_flip_rows(u8* pixels, u32 width, u32 height)
 {
-    oc_move_to(x, y);
-    oc_line_to(x + w, y);
-    oc_line_to(x + w, y + h);
-    oc_line_to(x, y + h);
-    oc_close_path();
-}
+    //NOTE: rows are swapped through a small buffer with memcpy(), which is already vectorized
+    u8 tmp[1024];
+    u64 rowSize = (u64)width * 4;
 
-void oc_rectangle_fill(f32 x, f32 y, f32 w, f32 h)
-{
-    oc_rectangle_path(x, y, w, h);
-    oc_fill();
+    for(u32 row = 0; row < height / 2; row++)
+    {
+        u8* a = pixels + row * rowSize;
+        u8* b = pixels + (height - 1 - row) * rowSize;
+
+        for(u64 offset = 0; offset < rowSize; offset += sizeof(tmp))
+        {
+            u64 size = oc_min(sizeof(tmp), rowSize - offset);
+            memcpy(tmp, a + offset, size);
+            memcpy(a + offset, b + offset, size);
+            memcpy(b + offset, tmp, size);
+        }
+    }
 }
 
-void oc_rectangle_stroke(f32 x, f32 y, f32 w, f32 h)
+//NOTE: x * a / 255, rounded to nearest. The SIMD versions below compute the same thing on 16-bit lanes.
+static inline u8 oc_pixels_mul_div_255(u32 x, u32 a)
 {
-    oc_rectangle_path(x, y, w, h);
-    oc_stroke();
+    u32 t = x * a + 128;
+    return ((u8)((t + (t >> 8)) >> 8));
 }
 
-void oc_rounded_rectangle_path(f32 x, f32 y, f32 w, f32 h, f32 r)
+void oc_pixels_premultiply_rgba8(u8* pixels, u64 count)
 {
-    r = oc_min(r, oc_min(w / 2, h / 2));
-    f32 c = r * 4 * (sqrt(2) - 1) / 3;
+    u64 i = 0;
 
-    oc_move_to(x + r, y);
-    oc_line_to(x + w - r, y);
-    oc_cubic_to(x + w - r + c, y, x + w, y + r - c, x + w, y + r);
-    oc_line_to(x + w, y + h - r);
-    oc_cubic_to(x + w, y + h - r + c, x + w - r + c, y + h, x + w - r, y + h);
-    oc_line_to(x + r, y + h);
-    oc_cubic_to(x + r - c, y + h, x, y + h - r + c, x, y + h - r);
-    oc_line_to(x, y + r);
-    oc_cubic_to(x, y + r - c, x + r - c, y, x + r, y);
-}
+#if OC_PIXELS_SSE2
+    const __m128i alphaMask = _mm_set1_epi32(0xff000000);
+    const __m128i half = _mm_set1_epi16(128);
+    const __m128i zero = _mm_setzero_si128();
 
-void oc_rounded_rectangle_fill(f32 x, f32 y, f32 w, f32 h, f32 r)
-{
-    oc_rounded_rectangle_path(x, y, w, h, r);
-    oc_fill();
-}
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((__m128i*)(pixels + i * 4));
 
-void oc_rounded_rectangle_stroke(f32 x, f32 y, f32 w, f32 h, f32 r)
-{
-    oc_rounded_rectangle_path(x, y, w, h, r);
-    oc_stroke();
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        __m128i alphaLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i alphaHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+        lo = _mm_add_epi16(_mm_mullo_epi16(lo, alphaLo), half);
+        hi = _mm_add_epi16(_mm_mullo_epi16(hi, alphaHi), half);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+        __m128i result = _mm_packus_epi16(lo, hi);
+        result = _mm_or_si128(_mm_andnot_si128(alphaMask, result), _mm_and_si128(alphaMask, v));
+        _mm_storeu_si128((__m128i*)(pixels + i * 4), result);
+    }
+#elif OC_PIXELS_NEON
+    for(; i + 16 <= count; i += 16)
+    {
+        uint8x16x4_t v = vld4q_u8(pixels + i * 4);
+        for(int c = 0; c < 3; c++)
+        {
+            //NOTE: vrsraq/vrshrn compute (t + ((t + 128) >> 8) + 128) >> 8, the rounded division by 255
+            uint16x8_t lo = vmull_u8(vget_low_u8(v.val[c]), vget_low_u8(v.val[3]));
+            uint16x8_t hi = vmull_u8(vget_high_u8(v.val[c]), vget_high_u8(v.val[3]));
+            lo = vrsraq_n_u16(lo, lo, 8);
+            hi = vrsraq_n_u16(hi, hi, 8);
+            v.val[c] = vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8));
+        }
+        vst4q_u8(pixels + i * 4, v);
+    }
+#elif OC_PIXELS_WASM
+    const v128_t alphaMask = wasm_i32x4_splat(0xff000000);
+    const v128_t half = wasm_i16x8_splat(128);
+
+    for(; i + 4 <= count; i += 4)
+    {
+        v128_t v = wasm_v128_load(pixels + i * 4);
+        v128_t alpha = wasm_i8x16_shuffle(v, v, 3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15);
+
+        v128_t lo = wasm_i16x8_add(wasm_i16x8_mul(wasm_u16x8_extend_low_u8x16(v), wasm_u16x8_extend_low_u8x16(alpha)), half);
+        v128_t hi = wasm_i16x8_add(wasm_i16x8_mul(wasm_u16x8_extend_high_u8x16(v), wasm_u16x8_extend_high_u8x16(alpha)), half);
+        lo = wasm_u16x8_shr(wasm_i16x8_add(lo, wasm_u16x8_shr(lo, 8)), 8);
+        hi = wasm_u16x8_shr(wasm_i16x8_add(hi, wasm_u16x8_shr(hi, 8)), 8);
+
+        v128_t result = wasm_u8x16_narrow_i16x8(lo, hi);
+        result = wasm_v128_bitselect(v, result, alphaMask);
+        wasm_v128_store(pixels + i * 4, result);
+    }
+#endif
+
+    for(; i < count; i++)
+    {
+        u8* p = pixels + i * 4;
+        p[0] = oc_pixels_mul_div_255(p[0], p[3]);
+        p[1] = oc_pixels_mul_div_255(p[1], p[3]);
+        p[2] = oc_pixels_mul_div_255(p[2], p[3]);
+    }
 }
 
-void oc_ellipse_path(f32 x, f32 y, f32 rx, f32 ry)
+void oc_pixels_swap_red_blue(u8* pixels, u64 count)
 {
-    f32 cx = rx * 4 * (sqrt(2) - 1) / 3;
-    f32 cy = ry * 4 * (sqrt(2) - 1) / 3;
+    u64 i = 0;
 
-    oc_move_to(x - rx, y);
-    oc_cubic_to(x - rx, y + cy, x - cx, y + ry, x, y + ry);
-    oc_cubic_to(x + cx, y + ry, x + rx, y + cy, x + rx, y);
-    oc_cubic_to(x + rx, y - cy, x + cx, y - ry, x, y - ry);
-    oc_cubic_to(x - cx, y - ry, x - rx, y - cy, x - rx, y);
+#if OC_PIXELS_SSE2
+    const __m128i greenAlpha = _mm_set1_epi32(0xff00ff00);
+    const __m128i low = _mm_set1_epi32(0xff);
+
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((__m128i*)(pixels + i * 4));
+        __m128i r = _mm_slli_epi32(_mm_and_si128(v, low), 16);
+        __m128i b = _mm_and_si128(_mm_srli_epi32(v, 16), low);
+        _mm_storeu_si128((__m128i*)(pixels + i * 4), _mm_or_si128(_mm_and_si128(v, greenAlpha), _mm_or_si128(r, b)));
+    }
+#elif OC_PIXELS_NEON
+    for(; i + 16 <= count; i += 16)
+    {
+        uint8x16x4_t v = vld4q_u8(pixels + i * 4);
+        uint8x16_t tmp = v.val[0];
+        v.val[0] = v.val[2];
+        v.val[2] = tmp;
+        vst4q_u8(pixels + i * 4, v);
+    }
+#elif OC_PIXELS_WASM
+    for(; i + 4 <= count; i += 4)
+    {
+        v128_t v = wasm_v128_load(pixels + i * 4);
+        v = wasm_i8x16_shuffle(v, v, 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        wasm_v128_store(pixels + i * 4, v);
+    }
+#endif
+
+    for(; i < count; i++)
+    {
+        u8* p = pixels + i * 4;
+        u8 tmp = p[0];
+        p[0] = p[2];
+        p[2] = tmp;
+    }
 }
 
-void oc_ellipse_fill(f32 x, f32 y, f32 rx, f32 ry)
+//NOTE: the decode table is exact for 8-bit inputs. The encode table samples the linear range finely enough that
+//      results are within one step of the exact encoding.
+enum
 {
-    oc_ellipse_path(x, y, rx, ry);
-    oc_fill();
-}
+    OC_PIXELS_SRGB_ENCODE_LUT_SIZE = 4096,
+};
 
-void oc_ellipse_stroke(f32 x, f32 y, f32 rx, f32 ry)
+typedef struct oc_pixels_srgb_luts
 {
-    oc_ellipse_path(x, y, rx, ry);
-    oc_stroke();
-}
+    volatile bool init;
+    f32 decode[256];
+    u8 encode[OC_PIXELS_SRGB_ENCODE_LUT_SIZE];
+} oc_pixels_srgb_luts;
 
-void oc_circle_fill(f32 x, f32 y, f32 r)
+static oc_pixels_srgb_luts oc_pixelsSrgbLuts = { 0 };
+
+static oc_pixels_srgb_luts* oc_pixels_srgb_luts_get(void)
 {
-    oc_ellipse_fill(x, y, r, r);
+    //NOTE: concurrent first calls compute the same values, and init is only set once the tables are filled
+    oc_pixels_srgb_luts* luts = &oc_pixelsSrgbLuts;
+    if(!luts->init)
+    {
+        for(int i = 0; i < 256; i++)
+        {
+            f32 c = i / 255.f;
+            luts->decode[i] = (c <= 0.04045) ? c / 12.92 : powf((c + 0.055) / 1.055, 2.4);
+        }
+        for(int i = 0; i < OC_PIXELS_SRGB_ENCODE_LUT_SIZE; i++)
+        {
+            f32 c = (f32)i / (OC_PIXELS_SRGB_ENCODE_LUT_SIZE - 1);
+            f32 e = (c <= 0.0031308) ? c * 12.92 : 1.055 * powf(c, 1 / 2.4) - 0.055;
+            luts->encode[i] = (u8)(oc_clamp(e, 0, 1) * 255 + 0.5);
+        }
+        luts->init = true;
+    }
+    return (luts);
 }
 
-void oc_circle_stroke(f32 x, f32 y, f32 r)
+void oc_pixels_srgb_to_linear(f32* dst, u8* src, u64 count)
 {
-    oc_ellipse_stroke(x, y, r, r);
+    oc_pixels_srgb_luts* luts = oc_pixels_srgb_luts_get();
+    for(u64 i = 0; i < count; i++)
+    {
+        dst[i * 4 + 0] = luts->decode[src[i * 4 + 0]];
+        dst[i * 4 + 1] = luts->decode[src[i * 4 + 1]];
+        dst[i * 4 + 2] = luts->decode[src[i * 4 + 2]];
+        dst[i * 4 + 3] = src[i * 4 + 3] / 255.f;
+    }
 }
 
-//TODO: change to arc_to?
-void oc_arc(f32 x, f32 y, f32 r, f32 arcAngle, f32 startAngle)
+void oc_pixels_linear_to_srgb(u8* dst, f32* src, u64 count)
 {
-    f32 endAngle = startAngle + arcAngle;
-
-    while(startAngle < endAngle)
+    oc_pixels_srgb_luts* luts = oc_pixels_srgb_luts_get();
+    const f32 scale = OC_PIXELS_SRGB_ENCODE_LUT_SIZE - 1;
+    for(u64 i = 0; i < count; i++)
     {
-        f32 smallAngle = oc_min(endAngle - startAngle, M_PI / 4.);
-        if(smallAngle < 0.001)
+        for(int c = 0; c < 3; c++)
         {
-            break;
+            dst[i * 4 + c] = luts->encode[(u32)(oc_clamp(src[i * 4 + c], 0, 1) * scale + 0.5)];
         }
-
-        oc_vec2 v0 = { cos(smallAngle / 2), sin(smallAngle / 2) };
-        oc_vec2 v1 = { (4 - v0.x) / 3, (1 - v0.x) * (3 - v0.x) / (3 * v0.y) };
-        oc_vec2 v2 = { v1.x, -v1.y };
-        oc_vec2 v3 = { v0.x, -v0.y };
-
-        f32 rotAngle = smallAngle / 2 + startAngle;
-        f32 rotCos = cos(rotAngle);
-        f32 rotSin = sin(rotAngle);
-
-        oc_mat2x3 t = { r * rotCos, -r * rotSin, x,
-                        r * rotSin, r * rotCos, y };
-
-        v0 = oc_mat2x3_mul(t, v0);
-        v1 = oc_mat2x3_mul(t, v1);
-        v2 = oc_mat2x3_mul(t, v2);
-        v3 = oc_mat2x3_mul(t, v3);
-
-        oc_move_to(v0.x, v0.y);
-        oc_cubic_to(v1.x, v1.y, v2.x, v2.y, v3.x, v3.y);
-
-        startAngle += smallAngle;
+        dst[i * 4 + 3] = (u8)(oc_clamp(src[i * 4 + 3], 0, 1) * 255 + 0.5);
     }
 }
 
-void oc_text_fill(f32 x, f32 y, oc_str8 text)
+//NOTE(martin): we never set stb_image's global flip flag and flip rows ourselves instead, so that images can be
+//              decoded on background threads concurrently with the main thread.
+u8* oc_image_decode_rgba8(oc_str8 mem, bool flip, u32* outWidth, u32* outHeight)
 {
-    oc_move_to(x, y);
-    oc_text_outlines(text);
-    oc_fill();
-}
+    int width, height, channels;
+    u8* pixels = stbi_load_from_memory((u8*)mem.ptr, mem.len, &width, &height, &channels, 4);
 
-//------------------------------------------------------------------------------------------
-//NOTE(martin): images
-//------------------------------------------------------------------------------------------
+    if(pixels)
+    {
+        if(flip)
+        {
+            oc_pixels_flip_rows(pixels, width, height);
+        }
+        *outWidth = width;
+        *outHeight = height;
+    }
+    else
+    {
+        oc_log_error("stbi_load_from_memory() failed: %s\n", stbi_failure_reason());
+    }
+    return (pixels);
+}
 
-oc_image oc_image_nil()
+bool oc_image_decode_size(oc_str8 mem, u32* outWidth, u32* outHeight)
 {
-    return ((oc_image){ .h = 0 });
+    int width, height, channels;
+    bool result = stbi_info_from_memory((u8*)mem.ptr, mem.len, &width, &height, &channels);
+    if(result)
+    {
+        *outWidth = width;
+        *outHeight = height;
+    }
+    else
+    {
+        oc_log_error("stbi_info_from_memory() failed: %s\n", stbi_failure_reason());
+    }
+    return (result);
 }
 
-bool oc_image_is_nil(oc_image image)
+oc_image oc_image_create_from_memory(oc_canvas_renderer renderer, oc_str8 mem, bool flip)
 {
-    return (image.h == 0);
+    oc_image image = oc_image_nil();
+    u32 width, height;
+
+#if !OC_PLATFORM_ORCA
+    u64 cacheKey = oc_image_cache_data_key(renderer, mem, flip, false);
+    image = oc_image_cache_acquire(renderer, cacheKey);
+    if(!oc_image_is_nil(image))
+    {
+        return (image);
+    }
+#endif
+
+    u8* pixels = oc_image_decode_rgba8(mem, flip, &width, &height);
+    if(pixels)
+    {
+        image = oc_image_create_from_rgba8(renderer, width, height, pixels);
+        free(pixels);
+    }
+
+#if !OC_PLATFORM_ORCA
+    oc_image_cache_insert(renderer, cacheKey, image);
+#endif
+    return (image);
 }
 
-oc_image oc_image_create_from_rgba8(oc_canvas_renderer renderer, u32 width, u32 height, u8* pixels)
+oc_image oc_image_create_from_file(oc_canvas_renderer renderer, oc_file file, bool flip)
 {
-    oc_image image = oc_image_create(renderer, width, height);
-    if(!oc_image_is_nil(image))
+    oc_image image = oc_image_nil();
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    u64 size = oc_file_size(file);
+    char* buffer = oc_arena_push(scratch.arena, size);
+    u64 read = oc_file_read(file, size, buffer);
+
+    if(read != size)
     {
-        oc_image_upload_region_rgba8(image, (oc_rect){ 0, 0, width, height }, pixels);
+        oc_log_error("Couldn't read image data\n");
+    }
+    else
+    {
+        image = oc_image_create_from_memory(renderer, oc_str8_from_buffer(size, buffer), flip);
     }
+
+    oc_scratch_end(scratch);
     return (image);
 }
 
-oc_image oc_image_create_from_memory(oc_canvas_renderer renderer, oc_str8 mem, bool flip)
+oc_image oc_image_create_from_path(oc_canvas_renderer renderer, oc_str8 path, bool flip)
 {
     oc_image image = oc_image_nil();
-    int width, height, channels;
-
-    stbi_set_flip_vertically_on_load(flip ? 1 : 0);
-    u8* pixels = stbi_load_from_memory((u8*)mem.ptr, mem.len, &width, &height, &channels, 4);
 
-    if(pixels)
+    oc_file file = oc_file_open(path, OC_FILE_ACCESS_READ, OC_FILE_OPEN_NONE);
+    if(oc_file_last_error(file) != OC_IO_OK)
     {
-        image = oc_image_create_from_rgba8(renderer, width, height, pixels);
-        free(pixels);
+        oc_log_error("Could not open file %*.s\n", oc_str8_ip(path));
     }
     else
     {
-        oc_log_error("stbi_load_from_memory() failed: %s\n", stbi_failure_reason());
+#if !OC_PLATFORM_ORCA
+        //NOTE: a path hit saves reading and hashing the file, a miss still finds images loaded from another path
+        u64 cacheKey = oc_image_cache_path_key(renderer, path, file, flip, false);
+        image = oc_image_cache_acquire(renderer, cacheKey);
+        if(oc_image_is_nil(image))
+        {
+            image = oc_image_create_from_file(renderer, file, flip);
+            oc_image_cache_insert(renderer, cacheKey, image);
+        }
+#else
+        image = oc_image_create_from_file(renderer, file, flip);
+#endif
     }
+    oc_file_close(file);
     return (image);
 }
 
-oc_image oc_image_create_from_file(oc_canvas_renderer renderer, oc_file file, bool flip)
+oc_image oc_image_create_from_file_async(oc_canvas_renderer renderer, oc_file file, bool flip)
 {
     oc_image image = oc_image_nil();
     oc_arena_scope scratch = oc_scratch_begin();
@@ -1912,14 +5435,15 @@ oc_image oc_image_create_from_file(oc_canvas_renderer renderer, oc_file file, bo
     }
     else
     {
-        image = oc_image_create_from_memory(renderer, oc_str8_from_buffer(size, buffer), flip);
+        //NOTE: the data is copied by oc_image_create_from_memory_async(), only decoding is deferred
+        image = oc_image_create_from_memory_async(renderer, oc_str8_from_buffer(size, buffer), flip);
     }
 
     oc_scratch_end(scratch);
     return (image);
 }
 
-oc_image oc_image_create_from_path(oc_canvas_renderer renderer, oc_str8 path, bool flip)
+oc_image oc_image_create_from_path_async(oc_canvas_renderer renderer, oc_str8 path, bool flip)
 {
     oc_image image = oc_image_nil();
 
@@ -1930,13 +5454,23 @@ oc_image oc_image_create_from_path(oc_canvas_renderer renderer, oc_str8 path, bo
     }
     else
     {
-        image = oc_image_create_from_file(renderer, file, flip);
+#if !OC_PLATFORM_ORCA
+        u64 cacheKey = oc_image_cache_path_key(renderer, path, file, flip, true);
+        image = oc_image_cache_acquire(renderer, cacheKey);
+        if(oc_image_is_nil(image))
+        {
+            image = oc_image_create_from_file_async(renderer, file, flip);
+            oc_image_cache_insert(renderer, cacheKey, image);
+        }
+#else
+        image = oc_image_create_from_file_async(renderer, file, flip);
+#endif
     }
     oc_file_close(file);
     return (image);
 }
 
-void oc_image_draw_region(oc_image image, oc_rect srcRegion, oc_rect dstRegion)
+static void oc_image_draw_region_with_color(oc_image image, oc_rect srcRegion, oc_rect dstRegion, oc_color color)
 {
     oc_canvas_context_data* context = oc_currentCanvasContext;
     if(context)
@@ -1949,7 +5483,7 @@ void oc_image_draw_region(oc_image image, oc_rect srcRegion, oc_rect dstRegion)
 
         context->attributes.image = image;
         context->attributes.srcRegion = srcRegion;
-        context->attributes.colors[0] = (oc_color){ 1, 1, 1, 1 };
+        context->attributes.colors[0] = color;
         context->attributes.hasGradient = false;
 
         oc_move_to(dstRegion.x, dstRegion.y);
@@ -1967,73 +5501,533 @@ void oc_image_draw_region(oc_image image, oc_rect srcRegion, oc_rect dstRegion)
     }
 }
 
+void oc_image_draw_region(oc_image image, oc_rect srcRegion, oc_rect dstRegion)
+{
+    oc_image_draw_region_with_color(image, srcRegion, dstRegion, (oc_color){ 1, 1, 1, 1 });
+}
+
 void oc_image_draw(oc_image image, oc_rect rect)
 {
     oc_vec2 size = oc_image_size(image);
     oc_image_draw_region(image, (oc_rect){ 0, 0, size.x, size.y }, rect);
 }
 
+void oc_sprite_batch_draw(oc_image image, u32 count, oc_rect* srcRects, oc_rect* dstRects, oc_mat2x3* transforms, oc_color* tints)
+{
+    //NOTE: the sprites share a unit square path, which each sprite maps to its destination rectangle through its
+    //      transform. The renderer maps the path's box to the source region, and rasterizes axis-aligned rect
+    //      primitives directly, so each sprite only costs a primitive and an attributes entry.
+    oc_canvas_context_data* context = oc_currentCanvasContext;
+    if(!context || !count || oc_image_is_nil(image))
+    {
+        return;
+    }
+    oc_new_path(context);
+
+    if(!oc_canvas_buffer_reserve((void**)&context->primitives,
+                                 &context->primitiveCap,
+                                 context->primitiveCount + count,
+                                 OC_CANVAS_DEFAULT_PRIMITIVE_CAP,
+                                 sizeof(oc_primitive)))
+    {
+        return;
+    }
+    oc_rectangle_path(0, 0, 1, 1);
+
+    oc_vec2 imageSize = oc_image_size(image);
+    oc_mat2x3 transform = oc_matrix_stack_top(context);
+    oc_attributes savedAttributes = context->attributes;
+
+    context->attributes.image = image;
+    context->attributes.hasGradient = false;
+    context->attributes.colors[0] = (oc_color){ 1, 1, 1, 1 };
+
+    for(u32 i = 0; i < count; i++)
+    {
+        oc_rect src = srcRects ? srcRects[i] : (oc_rect){ 0, 0, imageSize.x, imageSize.y };
+        oc_rect dst = dstRects ? dstRects[i] : (oc_rect){ 0, 0, src.w, src.h };
+        if(dst.w == 0 || dst.h == 0)
+        {
+            continue;
+        }
+
+        context->attributes.srcRegion = src;
+        if(tints)
+        {
+            context->attributes.colors[0] = tints[i];
+        }
+
+        oc_mat2x3 spriteTransform = { dst.w, 0, dst.x,
+                                      0, dst.h, dst.y };
+        if(transforms)
+        {
+            spriteTransform = oc_mat2x3_mul_m(transforms[i], spriteTransform);
+        }
+
+        if(!oc_push_command_with_transform(context,
+                                           (oc_primitive){ .cmd = OC_CMD_RECT, .path = context->path },
+                                           oc_mat2x3_mul_m(transform, spriteTransform)))
+        {
+            break;
+        }
+    }
+    context->attributes = savedAttributes;
+    oc_new_path(context);
+}
+
+//------------------------------------------------------------------------------------------
+//NOTE(martin): layers
+//------------------------------------------------------------------------------------------
+
+oc_layer oc_layer_nil(void)
+{
+    return ((oc_layer){ .h = 0 });
+}
+
+bool oc_layer_is_nil(oc_layer layer)
+{
+    return (layer.h == 0);
+}
+
+oc_layer oc_layer_handle_alloc(oc_layer_data* layer)
+{
+    oc_layer handle = { .h = oc_graphics_handle_alloc(OC_GRAPHICS_HANDLE_LAYER, (void*)layer) };
+    return (handle);
+}
+
+oc_layer_data* oc_layer_from_handle(oc_layer handle)
+{
+    oc_layer_data* layer = oc_graphics_data_from_handle(OC_GRAPHICS_HANDLE_LAYER, handle.h);
+    return (layer);
+}
+
+oc_layer oc_layer_create(oc_canvas_renderer renderer, u32 width, u32 height)
+{
+    if(!oc_graphicsData.init)
+    {
+        oc_graphics_init();
+    }
+
+    oc_layer handle = oc_layer_nil();
+
+    oc_image image = oc_image_create_render_target(renderer, width, height);
+    if(oc_image_is_nil(image))
+    {
+        oc_log_error("couldn't create layer image\n");
+        return (handle);
+    }
+
+    oc_canvas_context context = oc_canvas_context_create();
+    if(oc_canvas_context_is_nil(context))
+    {
+        oc_log_error("couldn't create layer context\n");
+        oc_image_destroy(image);
+        return (handle);
+    }
+
+    oc_layer_data* layer = oc_list_pop_front_entry(&oc_graphicsData.layerFreeList, oc_layer_data, freeListElt);
+    if(!layer)
+    {
+        layer = oc_arena_push_type(&oc_graphicsData.resourceArena, oc_layer_data);
+    }
+    if(layer)
+    {
+        memset(layer, 0, sizeof(oc_layer_data));
+        layer->renderer = renderer;
+        layer->image = image;
+        layer->context = context;
+
+        handle = oc_layer_handle_alloc(layer);
+    }
+    if(oc_layer_is_nil(handle))
+    {
+        oc_canvas_context_destroy(context);
+        oc_image_destroy(image);
+        if(layer)
+        {
+            oc_list_push_front(&oc_graphicsData.layerFreeList, &layer->freeListElt);
+        }
+    }
+    return (handle);
+}
+
+void oc_layer_destroy(oc_layer handle)
+{
+    oc_layer_data* layer = oc_layer_from_handle(handle);
+    if(layer)
+    {
+        if(layer->drawing)
+        {
+            oc_canvas_context_select(layer->previousContext);
+        }
+        oc_canvas_context_destroy(layer->context);
+        oc_image_destroy(layer->image);
+
+        oc_list_push_front(&oc_graphicsData.layerFreeList, &layer->freeListElt);
+        oc_graphics_handle_recycle(handle.h);
+    }
+}
+
+bool oc_layer_begin(oc_layer handle, bool cached)
+{
+    oc_layer_data* layer = oc_layer_from_handle(handle);
+    if(!layer)
+    {
+        return (false);
+    }
+    if(layer->drawing)
+    {
+        oc_log_error("layer is already being drawn\n");
+        return (false);
+    }
+    if(cached && layer->drawn)
+    {
+        return (false);
+    }
+
+    //NOTE: content is drawn in the layer's context, and replaces the previous content of the layer's image
+    layer->drawing = true;
+    layer->previousContext = oc_canvas_context_select(layer->context);
+
+    oc_canvas_context_data* context = oc_canvas_context_from_handle(layer->context);
+    context->clear = true;
+    context->clearColor = (oc_color){ 0, 0, 0, 0 };
+
+    return (true);
+}
+
+void oc_layer_end(oc_layer handle)
+{
+    oc_layer_data* layer = oc_layer_from_handle(handle);
+    if(!layer || !layer->drawing)
+    {
+        oc_log_error("no layer being drawn\n");
+        return;
+    }
+
+    //NOTE: the layer's image is rendered right away, so it's ready before the frame that draws it is rendered
+    oc_canvas_render_image(layer->renderer, layer->context, layer->image);
+    oc_canvas_context_select(layer->previousContext);
+
+    layer->drawing = false;
+    layer->drawn = true;
+}
+
+void oc_layer_draw(oc_layer handle, oc_rect rect, f32 opacity)
+{
+    oc_layer_data* layer = oc_layer_from_handle(handle);
+    if(layer && layer->drawn)
+    {
+        //NOTE: the layer's pixels are premultiplied, so modulating them by the color applies the opacity to the
+        //      layer as a whole instead of to each of its shapes
+        oc_vec2 size = oc_image_size(layer->image);
+        oc_image_draw_region_with_color(layer->image,
+                                        (oc_rect){ 0, 0, size.x, size.y },
+                                        rect,
+                                        (oc_color){ 1, 1, 1, oc_clamp(opacity, 0, 1) });
+    }
+}
+
 //------------------------------------------------------------------------------------------
 //NOTE(martin): atlasing
 //------------------------------------------------------------------------------------------
 
-//NOTE: rectangle allocator
+//NOTE: rectangle allocator.
+//      Each page keeps a list of free rectangles. Allocations take the free rectangle that leaves the least area
+//      unused, and split what's left of it in two along the shorter leftover axis (guillotine packing). Recycled
+//      rectangles go back to the free list of their page, merged with the free rectangles they share an edge with,
+//      so that a page whose allocations were all recycled is free as a whole again.
+//      Allocations are padded by one pixel on their right and bottom edges, so that sampling near the edge of a
+//      region doesn't bleed into its neighbours.
+enum
+{
+    OC_RECT_ATLAS_MAX_PAGES = 16,
+};
+
+typedef struct oc_rect_atlas_cell
+{
+    i32 x;
+    i32 y;
+    i32 w;
+    i32 h;
+} oc_rect_atlas_cell;
+
+typedef struct oc_rect_atlas_free_rect
+{
+    oc_list_elt listElt;
+    oc_rect_atlas_cell cell;
+} oc_rect_atlas_free_rect;
+
+typedef struct oc_rect_atlas_page
+{
+    oc_list freeRects;
+    u32 allocCount;
+    oc_image image; // backing image, for atlases used through the image atlas helpers
+    bool ownsImage; // the image was created by the atlas when it grew
+} oc_rect_atlas_page;
+
 typedef struct oc_rect_atlas
 {
     oc_arena* arena;
     oc_vec2i size;
-    oc_vec2i pos;
-    u32 lineHeight;
+    oc_list freeRectPool;
+
+    u32 pageCount;
+    u32 maxPages;
+    oc_rect_atlas_page pages[OC_RECT_ATLAS_MAX_PAGES];
+
+    oc_canvas_renderer renderer; // used to create the backing images of new pages
 
 } oc_rect_atlas;
 
+static void oc_rect_atlas_push_free_rect(oc_rect_atlas* atlas, oc_rect_atlas_page* page, oc_rect_atlas_cell cell)
+{
+    oc_rect_atlas_free_rect* freeRect = oc_list_pop_front_entry(&atlas->freeRectPool, oc_rect_atlas_free_rect, listElt);
+    if(!freeRect)
+    {
+        freeRect = oc_arena_push_type(atlas->arena, oc_rect_atlas_free_rect);
+    }
+    freeRect->cell = cell;
+    oc_list_push_back(&page->freeRects, &freeRect->listElt);
+}
+
+static void oc_rect_atlas_page_add(oc_rect_atlas* atlas)
+{
+    oc_rect_atlas_page* page = &atlas->pages[atlas->pageCount];
+    memset(page, 0, sizeof(oc_rect_atlas_page));
+    atlas->pageCount++;
+
+    oc_rect_atlas_push_free_rect(atlas, page, (oc_rect_atlas_cell){ 0, 0, atlas->size.x, atlas->size.y });
+}
+
 oc_rect_atlas* oc_rect_atlas_create(oc_arena* arena, i32 width, i32 height)
 {
     oc_rect_atlas* atlas = oc_arena_push_type(arena, oc_rect_atlas);
     memset(atlas, 0, sizeof(oc_rect_atlas));
     atlas->arena = arena;
     atlas->size = (oc_vec2i){ width, height };
+    atlas->maxPages = 1;
+
+    oc_rect_atlas_page_add(atlas);
     return (atlas);
 }
 
+void oc_rect_atlas_set_max_pages(oc_rect_atlas* atlas, u32 maxPages)
+{
+    atlas->maxPages = oc_clamp(maxPages, atlas->pageCount, OC_RECT_ATLAS_MAX_PAGES);
+}
+
+u32 oc_rect_atlas_page_count(oc_rect_atlas* atlas)
+{
+    return (atlas->pageCount);
+}
+
+static bool oc_rect_atlas_page_alloc(oc_rect_atlas* atlas, oc_rect_atlas_page* page, i32 width, i32 height, oc_rect* rect)
+{
+    i32 cellW = width + 1;
+    i32 cellH = height + 1;
+
+    //NOTE: find the free rect that fits with the least leftover area, breaking ties on the shorter leftover side
+    oc_rect_atlas_free_rect* best = 0;
+    i64 bestArea = 0;
+    i32 bestSide = 0;
+
+    oc_list_for(page->freeRects, freeRect, oc_rect_atlas_free_rect, listElt)
+    {
+        oc_rect_atlas_cell cell = freeRect->cell;
+        if(cell.w >= cellW && cell.h >= cellH)
+        {
+            i64 area = (i64)cell.w * cell.h - (i64)cellW * cellH;
+            i32 side = oc_min(cell.w - cellW, cell.h - cellH);
+            if(!best || area < bestArea || (area == bestArea && side < bestSide))
+            {
+                best = freeRect;
+                bestArea = area;
+                bestSide = side;
+            }
+        }
+    }
+    if(!best)
+    {
+        return (false);
+    }
+
+    oc_rect_atlas_cell cell = best->cell;
+    oc_list_remove(&page->freeRects, &best->listElt);
+    oc_list_push_back(&atlas->freeRectPool, &best->listElt);
+
+    //NOTE: split the leftover space along the shorter axis, so that the bigger of the two remainders is as big as
+    //      possible
+    i32 leftW = cell.w - cellW;
+    i32 leftH = cell.h - cellH;
+    oc_rect_atlas_cell right = { 0 };
+    oc_rect_atlas_cell bottom = { 0 };
+
+    if(leftW < leftH)
+    {
+        right = (oc_rect_atlas_cell){ cell.x + cellW, cell.y, leftW, cellH };
+        bottom = (oc_rect_atlas_cell){ cell.x, cell.y + cellH, cell.w, leftH };
+    }
+    else
+    {
+        right = (oc_rect_atlas_cell){ cell.x + cellW, cell.y, leftW, cell.h };
+        bottom = (oc_rect_atlas_cell){ cell.x, cell.y + cellH, cellW, leftH };
+    }
+    if(right.w > 0 && right.h > 0)
+    {
+        oc_rect_atlas_push_free_rect(atlas, page, right);
+    }
+    if(bottom.w > 0 && bottom.h > 0)
+    {
+        oc_rect_atlas_push_free_rect(atlas, page, bottom);
+    }
+
+    page->allocCount++;
+    *rect = (oc_rect){ cell.x, cell.y, width, height };
+    return (true);
+}
+
+oc_rect oc_rect_atlas_alloc_paged(oc_rect_atlas* atlas, i32 width, i32 height, u32* outPage)
+{
+    oc_rect rect = { 0, 0, 0, 0 };
+    //NOTE: don't add pages for rects that can't fit in an empty one
+    if(width > 0 && height > 0 && width < atlas->size.x && height < atlas->size.y)
+    {
+        for(u32 pageIndex = 0; pageIndex < atlas->maxPages; pageIndex++)
+        {
+            if(pageIndex == atlas->pageCount)
+            {
+                oc_rect_atlas_page_add(atlas);
+            }
+            if(oc_rect_atlas_page_alloc(atlas, &atlas->pages[pageIndex], width, height, &rect))
+            {
+                if(outPage)
+                {
+                    *outPage = pageIndex;
+                }
+                break;
+            }
+        }
+    }
+    return (rect);
+}
+
 oc_rect oc_rect_atlas_alloc(oc_rect_atlas* atlas, i32 width, i32 height)
 {
     oc_rect rect = { 0, 0, 0, 0 };
     if(width > 0 && height > 0)
     {
-        if(atlas->pos.x + width >= atlas->size.x)
+        oc_rect_atlas_page_alloc(atlas, &atlas->pages[0], width, height, &rect);
+    }
+    return (rect);
+}
+
+void oc_rect_atlas_recycle_paged(oc_rect_atlas* atlas, u32 pageIndex, oc_rect rect)
+{
+    if(pageIndex >= atlas->pageCount || rect.w <= 0 || rect.h <= 0 || atlas->pages[pageIndex].allocCount == 0)
+    {
+        return;
+    }
+    oc_rect_atlas_page* page = &atlas->pages[pageIndex];
+
+    page->allocCount--;
+    if(page->allocCount == 0)
+    {
+        //NOTE: edge merging can't always undo guillotine splits, so an empty page is reset to a single free rect
+        while(!oc_list_empty(page->freeRects))
         {
-            atlas->pos.x = 0;
-            atlas->pos.y += (atlas->lineHeight + 1);
-            atlas->lineHeight = 0;
+            oc_list_push_back(&atlas->freeRectPool, oc_list_pop_front(&page->freeRects));
         }
-        if(atlas->pos.x + width < atlas->size.x
-           && atlas->pos.y + height < atlas->size.y)
-        {
-            rect = (oc_rect){ atlas->pos.x, atlas->pos.y, width, height };
+        oc_rect_atlas_push_free_rect(atlas, page, (oc_rect_atlas_cell){ 0, 0, atlas->size.x, atlas->size.y });
+        return;
+    }
 
-            atlas->pos.x += (width + 1);
-            atlas->lineHeight = oc_max(atlas->lineHeight, height);
+    oc_rect_atlas_cell cell = { rect.x, rect.y, rect.w + 1, rect.h + 1 };
+
+    //NOTE: merge the recycled cell with any free rect that shares a whole edge with it, until none is left
+    bool merged = true;
+    while(merged)
+    {
+        merged = false;
+        oc_list_for(page->freeRects, freeRect, oc_rect_atlas_free_rect, listElt)
+        {
+            oc_rect_atlas_cell other = freeRect->cell;
+            if(other.y == cell.y && other.h == cell.h && (other.x + other.w == cell.x || cell.x + cell.w == other.x))
+            {
+                cell.x = oc_min(cell.x, other.x);
+                cell.w += other.w;
+                merged = true;
+            }
+            else if(other.x == cell.x && other.w == cell.w && (other.y + other.h == cell.y || cell.y + cell.h == other.y))
+            {
+                cell.y = oc_min(cell.y, other.y);
+                cell.h += other.h;
+                merged = true;
+            }
+            if(merged)
+            {
+                oc_list_remove(&page->freeRects, &freeRect->listElt);
+                oc_list_push_back(&atlas->freeRectPool, &freeRect->listElt);
+                break;
+            }
         }
     }
-    return (rect);
+    oc_rect_atlas_push_free_rect(atlas, page, cell);
 }
 
 void oc_rect_atlas_recycle(oc_rect_atlas* atlas, oc_rect rect)
 {
-    //TODO
+    oc_rect_atlas_recycle_paged(atlas, 0, rect);
+}
+
+//NOTE: image atlas helpers. The first page is backed by the image passed to the allocation functions. If growth was
+//      enabled with oc_image_atlas_set_growth(), new pages get backing images of the same size as the atlas.
+void oc_image_atlas_set_growth(oc_rect_atlas* atlas, oc_canvas_renderer renderer, u32 maxPages)
+{
+    atlas->renderer = renderer;
+    oc_rect_atlas_set_max_pages(atlas, maxPages);
+}
+
+void oc_image_atlas_cleanup(oc_rect_atlas* atlas)
+{
+    for(u32 pageIndex = 0; pageIndex < atlas->pageCount; pageIndex++)
+    {
+        oc_rect_atlas_page* page = &atlas->pages[pageIndex];
+        if(page->ownsImage)
+        {
+            oc_image_destroy(page->image);
+            page->image = oc_image_nil();
+            page->ownsImage = false;
+        }
+    }
 }
 
 oc_image_region oc_image_atlas_alloc_from_rgba8(oc_rect_atlas* atlas, oc_image backingImage, u32 width, u32 height, u8* pixels)
 {
     oc_image_region imageRgn = { 0 };
 
-    oc_rect rect = oc_rect_atlas_alloc(atlas, width, height);
+    atlas->pages[0].image = backingImage;
+
+    u32 pageIndex = 0;
+    oc_rect rect = oc_rect_atlas_alloc_paged(atlas, width, height, &pageIndex);
     if(rect.w == width && rect.h == height)
     {
-        oc_image_upload_region_rgba8(backingImage, rect, pixels);
-        imageRgn.rect = rect;
-        imageRgn.image = backingImage;
+        oc_rect_atlas_page* page = &atlas->pages[pageIndex];
+        if(oc_image_is_nil(page->image))
+        {
+            page->image = oc_image_create(atlas->renderer, atlas->size.x, atlas->size.y);
+            page->ownsImage = true;
+        }
+        if(oc_image_is_nil(page->image))
+        {
+            oc_rect_atlas_recycle_paged(atlas, pageIndex, rect);
+        }
+        else
+        {
+            oc_image_upload_region_rgba8(page->image, rect, pixels);
+            imageRgn.rect = rect;
+            imageRgn.image = page->image;
+        }
     }
     return (imageRgn);
 }
@@ -2042,10 +6036,9 @@ oc_image_region oc_image_atlas_alloc_from_memory(oc_rect_atlas* atlas, oc_image
 {
     oc_image_region imageRgn = { 0 };
 
-    int width, height, channels;
+    u32 width, height;
 
-    stbi_set_flip_vertically_on_load(flip ? 1 : 0);
-    u8* pixels = stbi_load_from_memory((u8*)mem.ptr, mem.len, &width, &height, &channels, 4);
+    u8* pixels = oc_image_decode_rgba8(mem, flip, &width, &height);
     if(pixels)
     {
         imageRgn = oc_image_atlas_alloc_from_rgba8(atlas, backingImage, width, height, pixels);
@@ -2096,5 +6089,12 @@ oc_image_region oc_image_atlas_alloc_from_path(oc_rect_atlas* atlas, oc_image ba
 
 void oc_image_atlas_recycle(oc_rect_atlas* atlas, oc_image_region imageRgn)
 {
-    oc_rect_atlas_recycle(atlas, imageRgn.rect);
+    for(u32 pageIndex = 0; pageIndex < atlas->pageCount; pageIndex++)
+    {
+        if(atlas->pages[pageIndex].image.h == imageRgn.image.h)
+        {
+            oc_rect_atlas_recycle_paged(atlas, pageIndex, imageRgn.rect);
+            break;
+        }
+    }
 }
@@ -17,7 +17,8 @@ typedef enum
     OC_PATH_MOVE,
     OC_PATH_LINE,
     OC_PATH_QUADRATIC,
-    OC_PATH_CUBIC
+    OC_PATH_CUBIC,
+    OC_PATH_POLYLINE, // three line segments ending at p[0], p[1] and p[2], written by oc_polyline()
 } oc_path_elt_type;
 
 typedef struct oc_path_elt
@@ -35,13 +36,27 @@ typedef struct oc_path_descriptor
 
 } oc_path_descriptor;
 
+//NOTE: bilinear gradients blend the 4 colors over the primitive's bounding box, linear and radial gradients blend
+//      gradientStops along gradientPoints
+typedef enum oc_gradient_kind
+{
+    OC_GRADIENT_BILINEAR = 0,
+    OC_GRADIENT_LINEAR,
+    OC_GRADIENT_RADIAL,
+} oc_gradient_kind;
+
 typedef struct oc_attributes
 {
     f32 width;
     f32 tolerance;
+    bool toleranceLOD; // tolerance is in output pixels instead of user space units
     bool hasGradient;
     oc_gradient_blend_space blendSpace;
     oc_color colors[4];
+    oc_gradient_kind gradientKind;
+    oc_vec2 gradientPoints[2]; // linear: start and end points, radial: center and (radius, 0)
+    u32 gradientStopCount;
+    oc_gradient_stop gradientStops[OC_GRADIENT_MAX_STOPS];
     oc_joint_type joint;
     f32 maxJointExcursion;
     oc_cap_type cap;
@@ -54,6 +69,7 @@ typedef struct oc_attributes
 
     oc_mat2x3 transform;
     oc_rect clip;
+    u32 clipPathDepth; // number of clip paths enclosing the primitive
 
 } oc_attributes;
 
@@ -61,13 +77,25 @@ typedef enum
 {
     OC_CMD_FILL = 0,
     OC_CMD_STROKE,
-    OC_CMD_JUMP
+    OC_CMD_JUMP,
+    OC_CMD_RECT,  // fill of a rectangle path, which renderers can rasterize without generating segments
+    OC_CMD_RRECT, // fill of a rounded rectangle path, with corner radius 'radius'
+    OC_CMD_GLYPH, // fill of a glyph outline starting at the origin. All occurrences of a glyph in a frame share its elements
+    OC_CMD_CLIP_PATH, // path whose coverage masks the primitives up to the matching OC_CMD_CLIP_POP
+    OC_CMD_CLIP_POP,  // closes the innermost OC_CMD_CLIP_PATH. Has no path, and the same clip rect as the clip path
 } oc_primitive_cmd;
 
+enum
+{
+    //NOTE: renderers composite the primitives of each clip path in a separate layer, and only keep that many layers
+    //      per pixel. Clip paths nested deeper only clip to their bounding box.
+    OC_CLIP_PATH_MAX_DEPTH = 4,
+};
+
 typedef struct oc_primitive
 {
     oc_primitive_cmd cmd;
-    oc_attributes attributes;
+    u32 attributesIndex; // index in the attributes table submitted alongside the primitives
 
     union
     {
@@ -75,15 +103,131 @@ typedef struct oc_primitive
         oc_rect rect;
         u32 jump;
     };
+    f32 radius; // corner radius of OC_CMD_RRECT primitives, in user space
 
 } oc_primitive;
 
+//NOTE: OC_PATH_POLYLINE elements keep long polylines compact in the command stream, and are unpacked into line elements
+//      by renderers, one path at a time. oc_path_unpacked_count() returns the number of elements after unpacking, or 0
+//      if there is no polyline to unpack.
+u32 oc_path_unpacked_count(u32 count, oc_path_elt* elements);
+void oc_path_unpack(u32 count, oc_path_elt* elements, oc_path_elt* unpacked);
+
 ORCA_API void oc_canvas_renderer_submit(oc_canvas_renderer renderer,
                                         oc_surface surface,
                                         u32 msaaSampleCount,
                                         bool clear,
                                         oc_color clearColor,
+                                        oc_rect damage,
                                         u32 primitiveCount,
                                         oc_primitive* primitives,
+                                        u32 attributeCount,
+                                        oc_attributes* attributes,
                                         u32 eltCount,
                                         oc_path_elt* elements);
+
+ORCA_API void oc_canvas_renderer_submit_image(oc_canvas_renderer renderer,
+                                              oc_image image,
+                                              u32 msaaSampleCount,
+                                              bool clear,
+                                              oc_color clearColor,
+                                              u32 primitiveCount,
+                                              oc_primitive* primitives,
+                                              u32 attributeCount,
+                                              oc_attributes* attributes,
+                                              u32 eltCount,
+                                              oc_path_elt* elements);
+
+//NOTE: the arguments of oc_canvas_renderer_submit() for one surface of oc_canvas_renderer_submit_many()
+typedef struct oc_canvas_submission
+{
+    oc_surface surface;
+    u32 msaaSampleCount;
+    bool clear;
+    oc_color clearColor;
+    oc_rect damage;
+    u32 primitiveCount;
+    oc_primitive* primitives;
+    u32 attributeCount;
+    oc_attributes* attributes;
+    u32 eltCount;
+    oc_path_elt* elements;
+
+} oc_canvas_submission;
+
+#if !OC_PLATFORM_ORCA
+//NOTE: renders several surfaces, and presents them once they're all submitted
+ORCA_API void oc_canvas_renderer_submit_many(oc_canvas_renderer renderer, u32 count, oc_canvas_submission* submissions);
+#endif
+
+/*NOTE: glyph run helpers.
+    On the Orca platform, the runtime keeps a native copy of each font created by the guest (see oc_font_host_create()),
+    and the guest's text measurement and text outlines call these helpers on that copy, so that their per-glyph loops
+    run natively instead of under the wasm interpreter. Glyph indices are the same on both sides, since both fonts are
+    created with the same unicode ranges.
+*/
+typedef struct oc_glyph_run_outlines
+{
+    u32 glyphCount;     // number of glyphs whose outlines were written
+    u32 eltCount;       // number of path elements written
+    u32 neededEltCount; // if not 0, the next glyph needs that many elements and didn't fit
+    oc_vec2 end;        // pen position after the last written glyph
+    f32 maxWidth;       // horizontal extent of the written glyphs, from the start position
+
+} oc_glyph_run_outlines;
+
+// Measures a run of glyph indices, like oc_font_text_metrics_utf32() does for code points.
+ORCA_API oc_text_metrics oc_font_glyph_run_metrics(oc_font font, f32 fontSize, u32 glyphCount, u32* glyphIndices);
+
+// Writes the outlines of a run of glyphs, scaled to fontSize and placed from start, to elements. Each glyph's outline
+// is followed by a move to the next pen position. Stops at the first glyph that doesn't fit in eltCap elements, or
+// that isn't in the font and has no replacement glyph, so that the caller can grow its buffer or draw the missing glyph.
+ORCA_API oc_glyph_run_outlines oc_font_glyph_run_outlines(oc_font font,
+                                                          f32 fontSize,
+                                                          bool flip,
+                                                          oc_vec2 start,
+                                                          u32 glyphCount,
+                                                          u32* glyphIndices,
+                                                          u32 eltCap,
+                                                          oc_path_elt* elements);
+
+typedef struct oc_glyph_run_layout
+{
+    u32 lineCount; // number of lines written
+    oc_vec2 size;  // width of the longest line and height of all lines
+
+} oc_glyph_run_layout;
+
+// Breaks a run of glyphs into aligned lines, as described for oc_font_push_text_layout(), writing the pen position of
+// each glyph to positions and the lines to lines. The code points are used to find line feeds and spaces. Every glyph
+// can start a line, so lines needs room for glyphCount lines.
+ORCA_API oc_glyph_run_layout oc_font_glyph_run_layout(oc_font font,
+                                                      f32 fontSize,
+                                                      f32 maxWidth,
+                                                      oc_text_align align,
+                                                      u32 glyphCount,
+                                                      u32* codePoints,
+                                                      u32* glyphIndices,
+                                                      oc_vec2* positions,
+                                                      u32 lineCap,
+                                                      oc_text_line* lines);
+
+#if OC_PLATFORM_ORCA
+//NOTE: create and destroy the runtime's copy of a guest font. The returned handle is only valid for the helpers above.
+oc_font oc_font_host_create(oc_str8 mem, u32 rangeCount, oc_unicode_range* ranges, bool lazy, u32 maxLoadedOutlines);
+void oc_font_host_destroy(oc_font font);
+#endif
+
+//NOTE: image decoding helpers, safe to call from any thread
+u8* oc_image_decode_rgba8(oc_str8 mem, bool flip, u32* outWidth, u32* outHeight);
+bool oc_image_decode_size(oc_str8 mem, u32* outWidth, u32* outHeight);
+
+#if !OC_PLATFORM_ORCA
+//NOTE: image cache helpers. Keys are 0 when the renderer's cache is disabled. oc_image_cache_acquire() returns the
+//      image cached under key with an added reference, or a nil image. oc_image_cache_insert() adds key to image, and
+//      takes over the caller's reference if the image wasn't cached yet.
+u64 oc_image_cache_data_key(oc_canvas_renderer renderer, oc_str8 data, bool flip, bool async);
+u64 oc_image_cache_path_key(oc_canvas_renderer renderer, oc_str8 path, oc_file file, bool flip, bool async);
+oc_image oc_image_cache_acquire(oc_canvas_renderer renderer, u64 key);
+void oc_image_cache_insert(oc_canvas_renderer renderer, u64 key, oc_image image);
+#endif
@@ -0,0 +1,136 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+
+#include "platform/platform_memory.h"
+#include "surface.h"
+
+typedef struct oc_image_surface
+{
+    oc_surface_base base;
+    CGColorSpaceRef colorSpace;
+
+} oc_image_surface;
+
+void oc_image_surface_destroy(oc_surface_base* base)
+{
+    @autoreleasepool
+    {
+        oc_image_surface* surface = (oc_image_surface*)base;
+
+        CGColorSpaceRelease(surface->colorSpace);
+
+        oc_surface_base_cleanup(base);
+        free(surface);
+    }
+}
+
+oc_surface oc_image_surface_create_for_window(oc_window window)
+{
+    @autoreleasepool
+    {
+        oc_image_surface* surface = 0;
+        oc_window_data* windowData = oc_window_ptr_from_handle(window);
+        if(windowData)
+        {
+            surface = (oc_image_surface*)oc_malloc_type(oc_image_surface);
+            memset(surface, 0, sizeof(oc_image_surface));
+
+            oc_surface_base_init_for_window((oc_surface_base*)surface, windowData);
+
+            surface->base.api = OC_SURFACE_IMAGE;
+            surface->base.destroy = oc_image_surface_destroy;
+
+            surface->colorSpace = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
+
+            //NOTE: the layer is empty until the first upload, and keeps its distance to the top-left of the window's
+            //      content when the window is resized
+            CALayer* layer = surface->base.view.layer;
+            layer.opaque = NO;
+            layer.frame = CGRectZero;
+            layer.contentsGravity = kCAGravityResize;
+            layer.autoresizingMask = kCALayerMaxXMargin | kCALayerMinYMargin;
+        }
+        oc_surface handle = oc_surface_nil();
+        if(surface)
+        {
+            handle = oc_surface_handle_alloc((oc_surface_base*)surface);
+        }
+        return (handle);
+    }
+}
+
+void oc_image_surface_set_frame(oc_surface handle, oc_rect frame)
+{
+    @autoreleasepool
+    {
+        oc_surface_base* base = oc_surface_from_handle(handle);
+        if(base && base->api == OC_SURFACE_IMAGE)
+        {
+            //NOTE: the window's content layer isn't flipped, so its origin is at the bottom-left
+            CALayer* layer = base->view.layer;
+            CGFloat parentHeight = layer.superlayer.bounds.size.height;
+
+            [CATransaction begin];
+            [CATransaction setDisableActions:YES];
+            layer.frame = CGRectMake(frame.x, parentHeight - frame.y - frame.h, frame.w, frame.h);
+            [CATransaction commit];
+        }
+    }
+}
+
+void oc_image_surface_upload_rgba8(oc_surface handle, u32 width, u32 height, u8* pixels)
+{
+    @autoreleasepool
+    {
+        oc_surface_base* base = oc_surface_from_handle(handle);
+        if(base && base->api == OC_SURFACE_IMAGE)
+        {
+            oc_image_surface* surface = (oc_image_surface*)base;
+            CGImageRef image = 0;
+
+            if(width && height)
+            {
+                //NOTE: the layer keeps the image after the call returns, so it gets its own premultiplied copy of the
+                //      pixels, which Core Animation can use without converting them
+                u64 size = (u64)width * height * 4;
+                CFMutableDataRef data = CFDataCreateMutable(0, size);
+                CFDataSetLength(data, size);
+                u8* copy = CFDataGetMutableBytePtr(data);
+                memcpy(copy, pixels, size);
+                oc_pixels_premultiply_rgba8(copy, (u64)width * height);
+
+                CGDataProviderRef provider = CGDataProviderCreateWithCFData(data);
+
+                image = CGImageCreate(width,
+                                      height,
+                                      8,
+                                      32,
+                                      width * 4,
+                                      surface->colorSpace,
+                                      kCGBitmapByteOrder32Big | kCGImageAlphaPremultipliedLast,
+                                      provider,
+                                      0,
+                                      false,
+                                      kCGRenderingIntentDefault);
+
+                CGDataProviderRelease(provider);
+                CFRelease(data);
+            }
+
+            [CATransaction begin];
+            [CATransaction setDisableActions:YES];
+            surface->base.view.layer.contents = (id)image;
+            [CATransaction commit];
+
+            if(image)
+            {
+                CGImageRelease(image);
+            }
+        }
+    }
+}
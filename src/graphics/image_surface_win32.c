@@ -0,0 +1,252 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+
+#include "platform/platform_memory.h"
+#include "surface.h"
+
+//NOTE: image surfaces don't have a window of their own: their visual is inserted in the parent window's root visual,
+//      and its content is a DirectComposition surface that the uploaded pixels are copied to.
+typedef struct oc_image_surface
+{
+    oc_surface_base base;
+    IDCompositionSurface* dcompSurface;
+    u32* pixels; // scratch buffer for converting uploads to premultiplied BGRA
+    u32 width;
+    u32 height;
+    oc_rect frame;
+    bool hidden;
+
+} oc_image_surface;
+
+static void oc_image_surface_release_content(oc_image_surface* surface)
+{
+    if(surface->dcompSurface)
+    {
+        surface->dcompSurface->lpVtbl->Release(surface->dcompSurface);
+        surface->dcompSurface = 0;
+    }
+    free(surface->pixels);
+    surface->pixels = 0;
+    surface->width = 0;
+    surface->height = 0;
+}
+
+static void oc_image_surface_update_visual(oc_image_surface* surface)
+{
+    IDCompositionVisual* visual = surface->base.view.dcompVisual;
+
+    //NOTE: the frame is in points, and the visual's coordinates are in pixels of the parent window
+    u32 dpi = GetDpiForWindow(surface->base.view.parent->win32.hWnd);
+    f32 scale = (f32)dpi / 96.;
+
+    D2D_MATRIX_3X2_F transform = {
+        ._11 = surface->width ? surface->frame.w * scale / surface->width : 0,
+        ._22 = surface->height ? surface->frame.h * scale / surface->height : 0,
+        ._31 = surface->frame.x * scale,
+        ._32 = surface->frame.y * scale,
+    };
+    visual->lpVtbl->SetTransformMatrixRef(visual, &transform);
+
+    IUnknown* content = surface->hidden ? 0 : (IUnknown*)surface->dcompSurface;
+    visual->lpVtbl->SetContent(visual, content);
+
+    IDCompositionDevice* device = oc_appData.win32.dcompDevice;
+    device->lpVtbl->Commit(device);
+}
+
+static void oc_image_surface_destroy(oc_surface_base* base)
+{
+    oc_image_surface* surface = (oc_image_surface*)base;
+    oc_window_data* window = base->view.parent;
+
+    oc_image_surface_release_content(surface);
+
+    IDCompositionVisual* rootVisual = window->win32.dcompRootVisual;
+    rootVisual->lpVtbl->RemoveVisual(rootVisual, base->view.dcompVisual);
+    base->view.dcompVisual->lpVtbl->Release(base->view.dcompVisual);
+
+    IDCompositionDevice* device = oc_appData.win32.dcompDevice;
+    device->lpVtbl->Commit(device);
+
+    oc_list_remove(&window->win32.surfaces, &base->view.listElt);
+    free(surface);
+}
+
+static oc_vec2 oc_image_surface_get_size(oc_surface_base* base)
+{
+    oc_image_surface* surface = (oc_image_surface*)base;
+    return ((oc_vec2){ surface->frame.w, surface->frame.h });
+}
+
+static oc_vec2 oc_image_surface_contents_scaling(oc_surface_base* base)
+{
+    u32 dpi = GetDpiForWindow(base->view.parent->win32.hWnd);
+    oc_vec2 contentsScaling = (oc_vec2){ (float)dpi / 96., (float)dpi / 96. };
+    return (contentsScaling);
+}
+
+static bool oc_image_surface_get_hidden(oc_surface_base* base)
+{
+    oc_image_surface* surface = (oc_image_surface*)base;
+    return (surface->hidden);
+}
+
+static void oc_image_surface_set_hidden(oc_surface_base* base, bool hidden)
+{
+    oc_image_surface* surface = (oc_image_surface*)base;
+    surface->hidden = hidden;
+    oc_image_surface_update_visual(surface);
+}
+
+oc_surface oc_image_surface_create_for_window(oc_window window)
+{
+    oc_surface handle = oc_surface_nil();
+    oc_window_data* windowData = oc_window_ptr_from_handle(window);
+    if(windowData)
+    {
+        IDCompositionDevice* device = oc_appData.win32.dcompDevice;
+        IDCompositionVisual* visual = 0;
+        HRESULT hr = device->lpVtbl->CreateVisual(device, &visual);
+        if(hr == S_OK)
+        {
+            visual->lpVtbl->SetBitmapInterpolationMode(visual, DCOMPOSITION_BITMAP_INTERPOLATION_MODE_LINEAR);
+
+            IDCompositionVisual* rootVisual = windowData->win32.dcompRootVisual;
+            hr = rootVisual->lpVtbl->AddVisual(rootVisual, visual, FALSE, NULL);
+        }
+
+        if(hr == S_OK)
+        {
+            device->lpVtbl->Commit(device);
+
+            oc_image_surface* surface = (oc_image_surface*)oc_malloc_type(oc_image_surface);
+            memset(surface, 0, sizeof(oc_image_surface));
+
+            surface->base.api = OC_SURFACE_IMAGE;
+            surface->base.view.parent = windowData;
+            surface->base.view.dcompVisual = visual;
+
+            surface->base.destroy = oc_image_surface_destroy;
+            surface->base.getSize = oc_image_surface_get_size;
+            surface->base.contentsScaling = oc_image_surface_contents_scaling;
+            surface->base.bringToFront = oc_surface_base_bring_to_front;
+            surface->base.sendToBack = oc_surface_base_send_to_back;
+            surface->base.getHidden = oc_image_surface_get_hidden;
+            surface->base.setHidden = oc_image_surface_set_hidden;
+
+            oc_list_push_front(&windowData->win32.surfaces, &surface->base.view.listElt);
+
+            handle = oc_surface_handle_alloc((oc_surface_base*)surface);
+        }
+        else
+        {
+            if(visual)
+            {
+                visual->lpVtbl->Release(visual);
+            }
+            oc_log_error("couldn't create the DirectComposition visual of an image surface.\n");
+        }
+    }
+    return (handle);
+}
+
+void oc_image_surface_set_frame(oc_surface handle, oc_rect frame)
+{
+    oc_surface_base* base = oc_surface_from_handle(handle);
+    if(base && base->api == OC_SURFACE_IMAGE)
+    {
+        oc_image_surface* surface = (oc_image_surface*)base;
+        surface->frame = frame;
+        oc_image_surface_update_visual(surface);
+    }
+}
+
+void oc_image_surface_upload_rgba8(oc_surface handle, u32 width, u32 height, u8* pixels)
+{
+    oc_surface_base* base = oc_surface_from_handle(handle);
+    if(base && base->api == OC_SURFACE_IMAGE)
+    {
+        oc_image_surface* surface = (oc_image_surface*)base;
+
+        if(surface->width != width || surface->height != height)
+        {
+            oc_image_surface_release_content(surface);
+
+            if(width && height)
+            {
+                IDCompositionDevice* device = oc_appData.win32.dcompDevice;
+                HRESULT hr = device->lpVtbl->CreateSurface(device,
+                                                           width,
+                                                           height,
+                                                           DXGI_FORMAT_B8G8R8A8_UNORM,
+                                                           DXGI_ALPHA_MODE_PREMULTIPLIED,
+                                                           &surface->dcompSurface);
+
+                surface->pixels = oc_malloc_array(u32, (u64)width * height);
+
+                if(hr == S_OK && surface->pixels)
+                {
+                    surface->width = width;
+                    surface->height = height;
+                }
+                else
+                {
+                    oc_image_surface_release_content(surface);
+                    oc_log_error("couldn't create the DirectComposition surface of an image surface.\n");
+                }
+            }
+        }
+
+        if(surface->dcompSurface)
+        {
+            u64 count = (u64)width * height;
+            memcpy(surface->pixels, pixels, count * 4);
+            oc_pixels_premultiply_rgba8((u8*)surface->pixels, count);
+            oc_pixels_swap_red_blue((u8*)surface->pixels, count);
+
+            //NOTE: the surface's pixels live at updateOffset in a texture that can be shared with other surfaces
+            ID3D11Texture2D* texture = 0;
+            POINT updateOffset = { 0 };
+            HRESULT hr = surface->dcompSurface->lpVtbl->BeginDraw(surface->dcompSurface,
+                                                                  NULL,
+                                                                  &IID_ID3D11Texture2D,
+                                                                  (void**)&texture,
+                                                                  &updateOffset);
+            if(hr == S_OK)
+            {
+                ID3D11Device* d3dDevice = 0;
+                ID3D11DeviceContext* d3dContext = 0;
+                ID3D11Texture2D_GetDevice(texture, &d3dDevice);
+                ID3D11Device_GetImmediateContext(d3dDevice, &d3dContext);
+
+                D3D11_BOX box = {
+                    .left = updateOffset.x,
+                    .top = updateOffset.y,
+                    .front = 0,
+                    .right = updateOffset.x + width,
+                    .bottom = updateOffset.y + height,
+                    .back = 1,
+                };
+                ID3D11DeviceContext_UpdateSubresource(d3dContext, (ID3D11Resource*)texture, 0, &box, surface->pixels, width * 4, 0);
+
+                ID3D11DeviceContext_Release(d3dContext);
+                ID3D11Device_Release(d3dDevice);
+                ID3D11Texture2D_Release(texture);
+
+                surface->dcompSurface->lpVtbl->EndDraw(surface->dcompSurface);
+            }
+            else
+            {
+                oc_log_error("couldn't draw to the DirectComposition surface of an image surface.\n");
+            }
+        }
+
+        //NOTE: sets the new content, and updates the scaling of the frame to the new image size
+        oc_image_surface_update_visual(surface);
+    }
+}
@@ -10,6 +10,14 @@
 #include "wgpu_renderer_shaders.h"
 #include "wgpu_renderer_debug.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    #include <emmintrin.h>
+    #define OC_WGPU_ENCODE_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    #include <arm_neon.h>
+    #define OC_WGPU_ENCODE_NEON 1
+#endif
+
 typedef struct oc_wgpu_path
 {
     f32 uvTransform[12];
@@ -20,9 +28,29 @@ typedef struct oc_wgpu_path
     i32 textureID;
     i32 hasGradient;
     i32 blendSpace;
+    oc_vec4 textureRegion;
+    f32 radius; // corner radius in pixels, for OC_CMD_RECT and OC_CMD_RRECT paths
+    i32 clipDepth; // number of clip paths enclosing the path
+    i32 gradientIndex; // index in the gradient buffer of a linear or radial gradient, or -1
+    char pad0[4];
     //...
 } oc_wgpu_path;
 
+//NOTE: a linear or radial gradient, shared by the paths of a batch that have the same attributes. Rows map pixels to
+//      the gradient's space, where linear gradients go from 0 to 1 along x, and radial gradients go from 0 at the
+//      origin to 1 at a distance of 1.
+typedef struct oc_wgpu_gradient
+{
+    oc_vec4 rows[2];
+    i32 kind;
+    i32 blendSpace;
+    u32 stopCount;
+    char pad0[4];
+    f32 offsets[OC_GRADIENT_MAX_STOPS];
+    oc_vec4 colors[OC_GRADIENT_MAX_STOPS]; // in the gradient's blend space, not premultiplied
+
+} oc_wgpu_gradient;
+
 typedef struct oc_wgpu_path_elt
 {
     i32 pathIndex;
@@ -31,6 +59,28 @@ typedef struct oc_wgpu_path_elt
 
 } oc_wgpu_path_elt;
 
+//NOTE: an occurrence of a cached glyph outline, whose elements are transformed and written to the element buffer by
+//      the glyph expand pass
+typedef struct oc_wgpu_glyph_instance
+{
+    oc_vec4 rows[2]; // rows of the glyph's transform to pixels, w is unused
+    u32 eltStart;    // first element of the outline in the glyph outlines buffer
+    u32 eltCount;
+    u32 outStart; // first element written to the element buffer
+    i32 pathIndex;
+
+} oc_wgpu_glyph_instance;
+
+//NOTE: element kinds that are expanded into stroke outlines by the segment setup shader. They share their values with
+//      the OC_SEG_STROKE_XXX constants of common.wgsl, and follow the OC_PATH_LINE/QUADRATIC/CUBIC values. The value of
+//      OC_PATH_POLYLINE is reused, since polylines are unpacked before encoding.
+enum
+{
+    OC_WGPU_ELT_STROKE_LINE = 4,
+    OC_WGPU_ELT_STROKE_JOINT = 5,
+    OC_WGPU_ELT_STROKE_CAP = 6,
+};
+
 typedef struct oc_wgpu_segment
 {
     int kind;
@@ -46,10 +96,8 @@ typedef struct oc_wgpu_segment
 
 typedef struct oc_wgpu_tile_op
 {
-    int kind;
+    u32 data;
     int next;
-    int index;
-    int windingOffsetOrCrossRight;
 } oc_wgpu_tile_op;
 
 typedef struct oc_wgpu_bin_queue
@@ -92,30 +140,135 @@ typedef struct oc_wgpu_debug_display_options
     u32 showClip;
     u32 textureOff;
     u32 debugTileQueues;
+    u32 heatmap;
+    u32 heatmapScale;
+    u32 batchIndex;
 
 } oc_wgpu_debug_display_options;
 
+//NOTE: pass timestamps follow the frame timestamps. Each timed batch writes OC_WGPU_CANVAS_PASS_COUNT + 1 timestamps,
+//      one before its first pass and one after each stage.
 enum
 {
     OC_WGPU_CANVAS_TIMESTAMP_INDEX_FRAME_BEGIN,
     OC_WGPU_CANVAS_TIMESTAMP_INDEX_FRAME_END,
-    OC_WGPU_CANVAS_TIMESTAMPS_COUNT,
+    OC_WGPU_CANVAS_TIMESTAMP_INDEX_PASSES,
+    OC_WGPU_CANVAS_TIMESTAMPS_PER_BATCH = OC_WGPU_CANVAS_PASS_COUNT + 1,
+    OC_WGPU_CANVAS_TIMESTAMPS_COUNT = OC_WGPU_CANVAS_TIMESTAMP_INDEX_PASSES
+                                    + OC_WGPU_CANVAS_PASS_TIMING_MAX_BATCHES * OC_WGPU_CANVAS_TIMESTAMPS_PER_BATCH,
 };
 
 typedef struct oc_wgpu_canvas_frame_timestamps
 {
     u64 frameBegin;
     u64 frameEnd;
+    u64 passes[OC_WGPU_CANVAS_PASS_TIMING_MAX_BATCHES][OC_WGPU_CANVAS_TIMESTAMPS_PER_BATCH];
 } oc_wgpu_canvas_frame_timestamps;
 
+static const char* OC_WGPU_CANVAS_PASS_NAMES[OC_WGPU_CANVAS_PASS_COUNT] = {
+    [OC_WGPU_CANVAS_PASS_SETUP] = "setup",
+    [OC_WGPU_CANVAS_PASS_BACKPROP] = "backprop",
+    [OC_WGPU_CANVAS_PASS_CHUNK] = "chunk",
+    [OC_WGPU_CANVAS_PASS_MERGE] = "merge",
+    [OC_WGPU_CANVAS_PASS_RASTER] = "raster",
+    [OC_WGPU_CANVAS_PASS_BLIT] = "blit",
+};
+
 enum
 {
     OC_WGPU_CANVAS_MAX_SAMPLE_COUNT = 8,
     OC_WGPU_CANVAS_DEFAULT_SAMPLE_COUNT = 8,
     OC_WGPU_CANVAS_BUFFER_DEFAULT_LEN = 1024,
     OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS = 8,
+
+    //NOTE: images up to OC_WGPU_CANVAS_IMAGE_ARRAY_MAX_SLOT_SIZE are allocated in square slots of the layers of a shared
+    //      texture array, which doesn't count against the OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS bindings of a batch.
+    //      Paths reference them with a texture ID of OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS + layer.
+    OC_WGPU_CANVAS_IMAGE_ARRAY_LAYER_SIZE = 1024,
+    OC_WGPU_CANVAS_IMAGE_ARRAY_MAX_LAYERS = 64,
+    OC_WGPU_CANVAS_IMAGE_ARRAY_MIN_SLOT_SIZE = 128,
+    OC_WGPU_CANVAS_IMAGE_ARRAY_MAX_SLOT_SIZE = 512,
+
+    //NOTE: resident tiles of tiled images are allocated in OC_IMAGE_TILE_SIZE slots of the image array, up to
+    //      OC_WGPU_CANVAS_MAX_RESIDENT_TILES tiles. Paths reference tiled images with OC_WGPU_CANVAS_TILED_TEXTURE_ID,
+    //      and find their tiles in the tile table, see oc_wgpu_tile_table. Tiles returned by oc_tiled_image_requests()
+    //      are returned again if they're still missing after OC_WGPU_CANVAS_TILE_REQUEST_RETRY_FRAMES frames.
+    OC_WGPU_CANVAS_TILED_TEXTURE_ID = OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS + OC_WGPU_CANVAS_IMAGE_ARRAY_MAX_LAYERS,
+    OC_WGPU_CANVAS_TILE_SLOTS_PER_ROW = OC_WGPU_CANVAS_IMAGE_ARRAY_LAYER_SIZE / OC_IMAGE_TILE_SIZE,
+    OC_WGPU_CANVAS_MAX_RESIDENT_TILES = 256,
+    OC_WGPU_CANVAS_TILE_TABLE_MIN_LEN = 4096,
+    OC_WGPU_CANVAS_TILE_REQUEST_RETRY_FRAMES = 60,
+
+    //NOTE: YUV images get their own R8 texture, with the luma plane on top and the chroma below it, see
+    //      oc_wgpu_yuv_plane_origin(). Paths sampling them have a textureRegion of (format, flags, width, height), where
+    //      format is one of the OC_WGPU_CANVAS_YUV_* values, and flags are OC_WGPU_CANVAS_YUV_FLAG_* bits.
+    OC_WGPU_CANVAS_YUV_NV12 = 1,
+    OC_WGPU_CANVAS_YUV_I420 = 2,
+    OC_WGPU_CANVAS_YUV_FLAG_FULL_RANGE = 1 << 0,
+    OC_WGPU_CANVAS_YUV_FLAG_BT709 = 1 << 1,
+
+    //NOTE: raster pipeline variants are indexed by the sample count and a mask of the OC_WGPU_CANVAS_RASTER_* features
+    //      that a batch uses, see oc_wgpu_canvas_raster_pipeline()
+    OC_WGPU_CANVAS_RASTER_IMAGES = 1 << 0,
+    OC_WGPU_CANVAS_RASTER_GRADIENTS = 1 << 1,
+    OC_WGPU_CANVAS_RASTER_DEBUG = 1 << 2,
+    OC_WGPU_CANVAS_RASTER_FEATURE_MASKS = 1 << 3,
+    OC_WGPU_CANVAS_RASTER_VARIANT_COUNT = OC_WGPU_CANVAS_RASTER_FEATURE_MASKS * (OC_WGPU_CANVAS_MAX_SAMPLE_COUNT + 1),
+
+    //NOTE: image uploads are staged in one of OC_WGPU_CANVAS_ROLLING_BUFFER_COUNT mapped buffers, and copied to their
+    //      textures at the next submit. Uploads that don't fit in the current staging buffer are written directly.
+    OC_WGPU_CANVAS_UPLOAD_BUFFER_SIZE = 8 << 20,
+    OC_WGPU_CANVAS_UPLOAD_MAX_COPIES = 256,
+    OC_WGPU_CANVAS_UPLOAD_ROW_ALIGNMENT = 256,
     OC_WGPU_CANVAS_CHUNK_SIZE = 256,
     OC_WGPU_CANVAS_ROLLING_BUFFER_COUNT = 3,
+
+    //NOTE: chunk sizes are tuned per surface size, rounded up to OC_WGPU_CANVAS_CHUNK_TUNING_BUCKET, by timing
+    //      OC_WGPU_CANVAS_CHUNK_TUNING_FRAMES frames with each candidate, see oc_wgpu_canvas_chunk_tuning.
+    OC_WGPU_CANVAS_CHUNK_SIZE_CANDIDATE_COUNT = 4,
+    OC_WGPU_CANVAS_CHUNK_TUNING_BUCKET = 256,
+    OC_WGPU_CANVAS_CHUNK_TUNING_FRAMES = 8,
+    OC_WGPU_CANVAS_CHUNK_TUNING_SLOTS = 4,
+
+    //NOTE: the dynamic render scale moves by steps of 1/OC_WGPU_CANVAS_DYNAMIC_SCALE_STEPS, and is only changed after
+    //      OC_WGPU_CANVAS_DYNAMIC_SCALE_FRAMES frames were timed at the current scale, see oc_wgpu_canvas_dynamic_scale_add_sample()
+    OC_WGPU_CANVAS_DYNAMIC_SCALE_STEPS = 16,
+    OC_WGPU_CANVAS_DYNAMIC_SCALE_FRAMES = 8,
+
+    //NOTE: encoded paths and elements are written directly into mapped staging buffers, see oc_wgpu_canvas_staging_ring
+    OC_WGPU_CANVAS_STAGING_BUFFER_COUNT = 8,
+    OC_WGPU_CANVAS_STAGING_BUFFER_MIN_SIZE = 1 << 20,
+
+    //NOTE: frame timestamps are read back through a ring of mappable buffers. If the next buffer is still being mapped
+    //      for an older frame, the current frame isn't timed, rather than waiting on the GPU.
+    OC_WGPU_CANVAS_TIMESTAMP_READ_BUFFER_COUNT = 8,
+
+    //NOTE: the counts reached by the GPU in the first OC_WGPU_CANVAS_COUNTERS_MAX_BATCHES batches of a frame are read
+    //      back the same way, to detect buffers that overflowed. Buffers that stay below 1/OC_WGPU_CANVAS_BUFFER_SHRINK_RATIO
+    //      of their capacity for bufferShrinkFrameCount frames are shrunk to fit their peak usage over that period.
+    OC_WGPU_CANVAS_COUNTERS_READ_BUFFER_COUNT = 4,
+    OC_WGPU_CANVAS_COUNTERS_MAX_BATCHES = 16,
+    OC_WGPU_CANVAS_BUFFER_SHRINK_RATIO = 4,
+    OC_WGPU_CANVAS_BUFFER_SHRINK_DEFAULT_FRAMES = 600,
+
+    //NOTE: batches are encoded as jobs of at least OC_WGPU_CANVAS_ENCODING_MIN_JOB_PRIMITIVES primitives,
+    //      by the worker threads and the submitting thread.
+    OC_WGPU_CANVAS_ENCODING_WORKER_COUNT = 3,
+    OC_WGPU_CANVAS_ENCODING_JOB_COUNT = 8,
+    OC_WGPU_CANVAS_ENCODING_MIN_JOB_PRIMITIVES = 128,
+
+    //NOTE: strokes of at least OC_WGPU_CANVAS_STROKE_CACHE_MIN_ELTS elements are cached across frames. Least recently
+    //      used entries are evicted when the cache grows past OC_WGPU_CANVAS_STROKE_CACHE_MAX_SIZE bytes.
+    OC_WGPU_CANVAS_STROKE_CACHE_MIN_ELTS = 4,
+    OC_WGPU_CANVAS_STROKE_CACHE_MAX_SIZE = 16 << 20,
+    OC_WGPU_CANVAS_STROKE_CACHE_BUCKET_COUNT = 1024,
+
+    //NOTE: outlines of OC_CMD_GLYPH primitives are kept in a GPU buffer of at most OC_WGPU_CANVAS_GLYPH_CACHE_MAX_ELTS
+    //      elements, which is flushed at the start of the next frame once it's full. Encoding jobs remember the entries
+    //      of their last OC_WGPU_CANVAS_GLYPH_MEMO_COUNT glyph outlines, to avoid hashing them at each occurrence.
+    OC_WGPU_CANVAS_GLYPH_CACHE_MAX_ELTS = 256 << 10,
+    OC_WGPU_CANVAS_GLYPH_CACHE_BUCKET_COUNT = 1024,
+    OC_WGPU_CANVAS_GLYPH_MEMO_COUNT = 64,
 };
 
 oc_vec2 OC_WGPU_CANVAS_OFFSETS[4][OC_WGPU_CANVAS_MAX_SAMPLE_COUNT] = {
@@ -155,13 +308,459 @@ u32 OC_WGPU_CANVAS_OFFSETS_LOOKUP[OC_WGPU_CANVAS_MAX_SAMPLE_COUNT] = {
 };
 
 typedef struct oc_wgpu_canvas_renderer oc_wgpu_canvas_renderer;
+typedef struct oc_wgpu_canvas_glyph_entry oc_wgpu_canvas_glyph_entry;
+
+//NOTE: a tiled image sampled by a path, and the level and uv box it is sampled at
+typedef struct oc_wgpu_tile_use
+{
+    oc_image image;
+    u32 level;
+    oc_vec4 uvBox;
+
+} oc_wgpu_tile_use;
+
+typedef struct oc_wgpu_canvas_encoding_context
+{
+    oc_wgpu_canvas_renderer* renderer;
+
+    oc_arena* arena;
+
+    u32 pathBatchStart;
+
+    u32 inputPrimitiveCount;
+    oc_primitive* inputPrimitives;
+
+    u32 inputAttributeCount;
+    oc_attributes* inputAttributes;
+
+    u32 inputEltCount;
+    oc_path_elt* inputElements;
+
+    u32 pathCount;
+    u32 pathCap;
+    oc_wgpu_path* pathData;
+
+    u32 eltCount;
+    u32 eltCap;
+    oc_wgpu_path_elt* elementData;
+
+    u32 glyphEltCount; // elements written by the glyph expand pass, after the eltCount elements encoded on the CPU
+    u32 glyphInstanceCount;
+    u32 glyphInstanceCap;
+    oc_wgpu_glyph_instance* glyphInstances;
+
+    u32 glyphMemoStart[OC_WGPU_CANVAS_GLYPH_MEMO_COUNT];
+    oc_wgpu_canvas_glyph_entry* glyphMemo[OC_WGPU_CANVAS_GLYPH_MEMO_COUNT];
+
+    u32 gradientCount;
+    u32 gradientCap;
+    oc_wgpu_gradient* gradients;
+    oc_attributes* gradientAttributes; // attributes of the last pushed gradient, which consecutive paths often share
+
+    u32 tileUseCount;
+    u32 tileUseCap;
+    oc_wgpu_tile_use* tileUses;
+
+    u32 maxSegmentCount;
+    u32 maxBinQueueCount;
+    u32 maxTileOpCount;
+
+    u32 chunkSize;
+    u32 chunkCount;
+    u32 maxChunkEltCount;
+
+    oc_primitive* primitive;
+    oc_attributes* attributes;
+
+    oc_vec4 pathUserExtents;
+    oc_vec4 pathScreenExtents;
+
+    bool gpuStroke;
+    f32 strokeScale;
+
+    bool analyticRect; // the current primitive is rasterized from its box and corner radius, without segments
+    f32 rectRadius;
+
+    oc_vec2 screenSize;
+    oc_vec2 targetCapacity; // size the batch and out textures are allocated with, at least screenSize
+    oc_vec2 scale;
+    f32 tileSize;
+    u32 screenTilesCount;
+
+    bool hasDamage;
+    oc_vec4 damage; // pixel rect that is redrawn when hasDamage is set, the rest of outTexture is kept
+
+    i32 currentImageIndex;
+    u32 imageCount;
+    oc_image imageBindings[OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS];
+
+    WGPUCommandEncoder encoder; // frame encoder, which batch uploads are copied in
+
+    bool rasterDebug;                   // the frame uses debug display options that are read by the raster pass
+    u32 rasterFeatures;                 // OC_WGPU_CANVAS_RASTER_* features used by the batch
+    WGPUComputePipeline rasterPipeline; // raster pipeline variant picked for the batch
+
+} oc_wgpu_canvas_encoding_context;
+
+typedef struct oc_wgpu_image_array_layer
+{
+    u32 slotSize; // all slots of a layer have the same size, 0 if the layer is unused
+    u64 usedSlots;
+
+} oc_wgpu_image_array_layer;
+
+typedef struct oc_wgpu_image_array
+{
+    WGPUTexture texture;
+    WGPUTextureView textureView;
+    u32 layerCap;
+    oc_wgpu_image_array_layer layers[OC_WGPU_CANVAS_IMAGE_ARRAY_MAX_LAYERS];
+
+} oc_wgpu_image_array;
+
+typedef struct oc_wgpu_tiled_image oc_wgpu_tiled_image;
+
+//NOTE: frame stamps of tiles are frameIndex + 1, so that 0 means never
+typedef struct oc_wgpu_image_tile
+{
+    oc_wgpu_tiled_image* tiled;
+    oc_list_elt residentElt; // in the tile table's resident list while arrayLayer >= 0
+    i32 arrayLayer;          // -1 if the tile isn't resident
+    oc_rect arrayRect;
+
+    u64 lastUsedFrame; // last frame that sampled the tile while it was resident
+    u64 neededFrame;   // last frame that needed the tile while it wasn't resident
+    u64 requestFrame;  // frame at which the tile was returned by oc_tiled_image_requests(), 0 once it's loaded
+
+} oc_wgpu_image_tile;
+
+typedef struct oc_wgpu_tiled_image
+{
+    oc_list_elt listElt; // in the tile table's images
+    u32 levelCount;
+    u32 levelTilesX[OC_IMAGE_TILE_MAX_LEVELS];
+    u32 levelTileStart[OC_IMAGE_TILE_MAX_LEVELS]; // index of the first tile of each level in tiles, row by row
+    u32 tileCount;
+    oc_wgpu_image_tile* tiles;
+
+    u32 tableOffset; // start of the image's range in the tile table
+    u32 tableLen;
+    bool tableDirty;
+
+} oc_wgpu_tiled_image;
+
+/*NOTE:
+	The tile table is a storage buffer of u32 entries, read by the raster shader. Each tiled image has a range that
+	starts with one entry per level, holding the table index of the level's first tile, followed by one entry per
+	tile, which is 0 if the tile isn't resident, or 1 + its slot in the image array, counted in OC_IMAGE_TILE_SIZE slots
+	from the first layer. Ranges are only updated between frames, with the images whose table is dirty.
+	Resident tiles are kept in a list, most recently used first, and the least recently used ones are evicted when
+	a new tile doesn't fit.
+*/
+typedef struct oc_wgpu_tile_table
+{
+    WGPUBuffer buffer;
+    u32 cap; // in entries
+    u32 len;
+    oc_list images;
+
+    oc_list residentTiles;
+    u32 residentCount;
+
+} oc_wgpu_tile_table;
+
+typedef struct oc_wgpu_canvas_upload_copy
+{
+    WGPUTexture texture; // referenced until the copy is flushed
+    WGPUOrigin3D origin;
+    WGPUExtent3D extent;
+    u64 offset;
+    u32 bytesPerRow;
+
+} oc_wgpu_canvas_upload_copy;
+
+typedef struct oc_wgpu_canvas_upload_ring oc_wgpu_canvas_upload_ring;
+
+typedef struct oc_wgpu_canvas_upload_slot
+{
+    oc_wgpu_canvas_upload_ring* ring;
+    WGPUBuffer buffer;
+    u8* mappedPtr; // null while the buffer is in use by the GPU
+    u64 offset;
+    u64 serial; // serial of the last upload staged in this buffer
+
+    u32 copyCount;
+    oc_wgpu_canvas_upload_copy copies[OC_WGPU_CANVAS_UPLOAD_MAX_COPIES];
+
+} oc_wgpu_canvas_upload_slot;
+
+typedef struct oc_wgpu_canvas_upload_ring
+{
+    u32 slotIndex;
+    u64 nextSerial;
+    u64 completedSerial;
+    oc_wgpu_canvas_upload_slot slots[OC_WGPU_CANVAS_ROLLING_BUFFER_COUNT];
+
+} oc_wgpu_canvas_upload_ring;
+
+/*NOTE: geometry staging ring.
+    All batches of a frame are encoded in one command buffer, so their inputs can't be written to the bound buffers
+    with queue writes (which would all land before the first batch runs). Instead, they're written to consecutive
+    ranges of mapped staging buffers, and copied to the bound buffers in the frame's encoder. The encoder writes paths
+    and elements straight into the mapped memory, which saves the extra copy queue writes make into the driver's own
+    staging memory.
+
+    Buffers written during a frame are unmapped before the frame is submitted and mapped again asynchronously, which
+    completes once the GPU is done copying from them. If no mapped buffer has room left, a buffer that isn't in use by
+    the current frame is replaced by a larger one, mapped at creation.
+*/
+typedef struct oc_wgpu_canvas_staging_slot
+{
+    WGPUBuffer buffer;
+    u8* mappedPtr; // null while the buffer is in use by the GPU
+    u64 size;
+    u64 offset;
+    bool used; // written to by the current frame
+
+} oc_wgpu_canvas_staging_slot;
+
+typedef struct oc_wgpu_canvas_staging_ring
+{
+    oc_wgpu_canvas_staging_slot* current;
+    u64 frameBytes;
+    u64 lastFrameBytes;
+    oc_wgpu_canvas_staging_slot slots[OC_WGPU_CANVAS_STAGING_BUFFER_COUNT];
+
+} oc_wgpu_canvas_staging_ring;
+
+typedef struct oc_wgpu_canvas_staging_alloc
+{
+    WGPUBuffer buffer;
+    u64 offset;
+    u8* ptr; // null if the allocation failed
+
+} oc_wgpu_canvas_staging_alloc;
+
+enum
+{
+    OC_WGPU_CANVAS_PIPELINE_CACHE_MAGIC = 0x4350434f, // 'OCPC'
+    OC_WGPU_CANVAS_PIPELINE_CACHE_VERSION = 1,
+};
+
+typedef struct oc_wgpu_canvas_pipeline_cache_entry
+{
+    oc_list_elt listElt;
+    u64 hash;
+    oc_str8 key;
+    oc_str8 value;
+
+} oc_wgpu_canvas_pipeline_cache_entry;
+
+typedef struct oc_wgpu_canvas_pipeline_cache
+{
+    oc_mutex* mutex; // Dawn can load and store blobs from its worker threads
+    oc_arena arena;
+    oc_str8 isolationKey;
+    oc_list entries;
+    FILE* file; // opened for appending new entries
+
+} oc_wgpu_canvas_pipeline_cache;
+
+//NOTE: candidates must be multiples of the tile size, since the merge pass splits chunks into whole tiles
+static const u32 OC_WGPU_CANVAS_CHUNK_SIZE_CANDIDATES[OC_WGPU_CANVAS_CHUNK_SIZE_CANDIDATE_COUNT] = { 64, 128, 256, 512 };
+
+typedef struct oc_wgpu_canvas_chunk_tuning
+{
+    u32 key; // surface size in OC_WGPU_CANVAS_CHUNK_TUNING_BUCKET units, width in the high bits, 0 if the slot is free
+    u64 lastUsedFrame;
+    u32 chunkSize; // 0 while candidates are being timed
+    u32 nextCandidate;
+
+    u32 frameCounts[OC_WGPU_CANVAS_CHUNK_SIZE_CANDIDATE_COUNT];
+    f64 times[OC_WGPU_CANVAS_CHUNK_SIZE_CANDIDATE_COUNT]; // chunk and merge pass times, summed over timed frames
+
+} oc_wgpu_canvas_chunk_tuning;
+
+typedef struct oc_wgpu_canvas_stroke_cache_entry
+{
+    oc_list_elt bucketElt;
+    oc_list_elt lruElt;
+    u64 hash;
+    u64 size; // size of the allocation, including the key and elements stored after the entry
+    oc_str8 key;
+
+    u32 eltCount;
+    oc_wgpu_path_elt* elements; // pathIndex is patched when the entry is reused
+    u32 maxSegmentCount;
+    u32 maxTileOpCount;
+    oc_vec4 userExtents;
+    oc_vec4 screenExtents;
+
+} oc_wgpu_canvas_stroke_cache_entry;
+
+typedef struct oc_wgpu_canvas_stroke_cache
+{
+    oc_mutex* mutex; // shared by the encoding jobs
+    oc_list lru;     // most recently used entries first
+    oc_list buckets[OC_WGPU_CANVAS_STROKE_CACHE_BUCKET_COUNT];
+    u64 size;
+
+} oc_wgpu_canvas_stroke_cache;
+
+typedef struct oc_wgpu_canvas_glyph_entry
+{
+    oc_list_elt bucketElt;
+    oc_list_elt listElt; // in the cache's pending list until the outline is uploaded, then in its entries list
+    u64 hash;
+    oc_str8 key; // input elements of the outline
+
+    u32 eltStart; // first element in the glyph outlines buffer
+    u32 eltCount;
+    oc_wgpu_path_elt* elements; // kept to upload them again if the buffer is reallocated
+    u32 maxSegmentCount;
+    oc_vec4 box; // bounding box of the control points, in font units
+    oc_vec2 endPoint;
+
+} oc_wgpu_canvas_glyph_entry;
+
+typedef struct oc_wgpu_canvas_glyph_cache
+{
+    oc_mutex* mutex; // shared by the encoding jobs
+    oc_list entries;
+    oc_list pending;
+    oc_list buckets[OC_WGPU_CANVAS_GLYPH_CACHE_BUCKET_COUNT];
+    u32 eltCount; // elements allocated in the buffer
+    bool full;    // an outline didn't fit, flush the cache before the next frame
+
+    WGPUBuffer buffer;
+
+} oc_wgpu_canvas_glyph_cache;
+
+typedef struct oc_wgpu_canvas_encoding_counts
+{
+    u32 pathCount;
+    u32 eltCount;
+    u32 glyphEltCount;
+    u32 glyphInstanceCount;
+    u32 gradientCount;
+    u32 maxSegmentCount;
+    u32 maxBinQueueCount;
+    u32 maxTileOpCount;
+
+} oc_wgpu_canvas_encoding_counts;
+
+typedef struct oc_wgpu_canvas_encoding_job
+{
+    //NOTE: each job encodes a range of the batch's primitives into its own context and arena
+    oc_wgpu_canvas_encoding_context context;
+    oc_arena arena;
+
+    u32 primitiveStart; // relative to the batch start
+    u32 primitiveCount;
+    i32* imageIndices;
+    oc_vec2 startPos;
+
+    oc_wgpu_canvas_encoding_counts* counts; // running counts after each primitive of the job
+    oc_wgpu_canvas_encoding_counts kept;    // counts merged into the batch
+
+} oc_wgpu_canvas_encoding_job;
+
+typedef struct oc_wgpu_canvas_encoding_pool
+{
+    oc_mutex* mutex;
+    oc_condition* workCondition;
+    oc_condition* doneCondition;
+    bool quit;
+
+    u32 jobCount;
+    u32 nextJob;
+    u32 pendingCount;
+    oc_wgpu_canvas_encoding_job jobs[OC_WGPU_CANVAS_ENCODING_JOB_COUNT];
+
+    u32 threadCount;
+    oc_thread* threads[OC_WGPU_CANVAS_ENCODING_WORKER_COUNT];
+
+} oc_wgpu_canvas_encoding_pool;
+
+typedef enum oc_wgpu_canvas_buffer_kind
+{
+    OC_WGPU_CANVAS_BUFFER_PATHS,
+    OC_WGPU_CANVAS_BUFFER_ELEMENTS,
+    OC_WGPU_CANVAS_BUFFER_SEGMENTS,
+    OC_WGPU_CANVAS_BUFFER_PATH_BINS,
+    OC_WGPU_CANVAS_BUFFER_BIN_QUEUES,
+    OC_WGPU_CANVAS_BUFFER_TILE_QUEUES,
+    OC_WGPU_CANVAS_BUFFER_TILE_OPS,
+    OC_WGPU_CANVAS_BUFFER_CHUNKS,
+    OC_WGPU_CANVAS_BUFFER_CHUNK_ELTS,
+    OC_WGPU_CANVAS_BUFFER_GLYPH_OUTLINES,
+    OC_WGPU_CANVAS_BUFFER_GLYPH_INSTANCES,
+    OC_WGPU_CANVAS_BUFFER_GRADIENTS,
+    OC_WGPU_CANVAS_BUFFER_STAGING,
+    OC_WGPU_CANVAS_BUFFER_KIND_COUNT,
+} oc_wgpu_canvas_buffer_kind;
+
+static const oc_canvas_memory_category OC_WGPU_CANVAS_BUFFER_MEMORY_CATEGORIES[OC_WGPU_CANVAS_BUFFER_KIND_COUNT] = {
+    [OC_WGPU_CANVAS_BUFFER_PATHS] = OC_CANVAS_MEMORY_PATH_BUFFERS,
+    [OC_WGPU_CANVAS_BUFFER_ELEMENTS] = OC_CANVAS_MEMORY_PATH_BUFFERS,
+    [OC_WGPU_CANVAS_BUFFER_SEGMENTS] = OC_CANVAS_MEMORY_RASTER_BUFFERS,
+    [OC_WGPU_CANVAS_BUFFER_PATH_BINS] = OC_CANVAS_MEMORY_RASTER_BUFFERS,
+    [OC_WGPU_CANVAS_BUFFER_BIN_QUEUES] = OC_CANVAS_MEMORY_RASTER_BUFFERS,
+    [OC_WGPU_CANVAS_BUFFER_TILE_QUEUES] = OC_CANVAS_MEMORY_RASTER_BUFFERS,
+    [OC_WGPU_CANVAS_BUFFER_TILE_OPS] = OC_CANVAS_MEMORY_RASTER_BUFFERS,
+    [OC_WGPU_CANVAS_BUFFER_CHUNKS] = OC_CANVAS_MEMORY_RASTER_BUFFERS,
+    [OC_WGPU_CANVAS_BUFFER_CHUNK_ELTS] = OC_CANVAS_MEMORY_RASTER_BUFFERS,
+    [OC_WGPU_CANVAS_BUFFER_GLYPH_OUTLINES] = OC_CANVAS_MEMORY_PATH_BUFFERS,
+    [OC_WGPU_CANVAS_BUFFER_GLYPH_INSTANCES] = OC_CANVAS_MEMORY_PATH_BUFFERS,
+    [OC_WGPU_CANVAS_BUFFER_GRADIENTS] = OC_CANVAS_MEMORY_PATH_BUFFERS,
+    [OC_WGPU_CANVAS_BUFFER_STAGING] = OC_CANVAS_MEMORY_STAGING,
+};
+
+//NOTE: buffers whose element count is reported by a GPU counter, in the order they're laid out in the counters read buffers
+enum
+{
+    OC_WGPU_CANVAS_COUNTER_COUNT = 5,
+};
+
+static const oc_wgpu_canvas_buffer_kind oc_wgpu_canvas_countedBuffers[OC_WGPU_CANVAS_COUNTER_COUNT] = {
+    OC_WGPU_CANVAS_BUFFER_SEGMENTS,
+    OC_WGPU_CANVAS_BUFFER_BIN_QUEUES,
+    OC_WGPU_CANVAS_BUFFER_TILE_OPS,
+    OC_WGPU_CANVAS_BUFFER_CHUNK_ELTS,
+    OC_WGPU_CANVAS_BUFFER_TILE_QUEUES,
+};
+
+typedef struct oc_wgpu_canvas_buffer_usage
+{
+    u64 frameIndex;          // last frame the buffer was requested in
+    u32 framePeak;           // highest element count requested during that frame
+    u32 lowUsagePeak;        // highest element count requested since usage went low
+    u32 lowUsageFrameCount;  // number of frames usage has been low
+    u32 gpuCount;            // highest count reported by the GPU since the buffer was last sized
+    u64 size;                // current size of the buffer in bytes
+
+} oc_wgpu_canvas_buffer_usage;
+
+typedef struct oc_wgpu_canvas_counters_read_callback_data
+{
+    oc_wgpu_canvas_renderer* renderer;
+    WGPUBuffer buffer;
+    u32 batchCount;
+
+} oc_wgpu_canvas_counters_read_callback_data;
 
 typedef struct oc_wgpu_canvas_timestamp_read_callback_data
 {
     oc_wgpu_canvas_renderer* renderer;
     WGPUBuffer buffer;
     oc_wgpu_canvas_frame_counters* frameCounters;
+    u32 frameIndex; // frame of the counters record, which might be recycled before the callback fires
+    u32 passBatchCount; // number of batches whose passes were timed
     u64 mapSize;
+    f64 submitTime; // CPU time at which the frame was submitted, used to place the GPU frame on the trace timeline
+    u32 tuningKey;  // chunk tuning the frame was timed for, or 0
+    u32 tuningCandidate;
+    f32 renderScale; // dynamic render scale the frame was rendered at, or 0 if it doesn't count towards the scale
 
 } oc_wgpu_canvas_timestamp_read_callback_data;
 
@@ -172,13 +771,36 @@ typedef struct oc_wgpu_canvas_renderer
     i32 msaaSampleCount; //TODO don't cache and reupload each frame?
 
     bool hasTimestamps;
+    bool hasSubgroups; // use the subgroup variants of the path setup and backprop shaders
+    bool compressedFormats[OC_IMAGE_COMPRESSED_FORMAT_COUNT];
     WGPULimits limits;
 
+    oc_wgpu_canvas_pipeline_cache pipelineCache;
+    u32 pendingPipelineCount; // pipelines still being compiled in the background
+
+    oc_wgpu_canvas_chunk_tuning chunkTunings[OC_WGPU_CANVAS_CHUNK_TUNING_SLOTS];
+
+    f32 dynamicScaleBudget;      // GPU time per frame, in milliseconds, 0 disables the dynamic render scale
+    f32 dynamicScaleMin;
+    f32 renderScale;             // scale surfaces are currently rendered at, relative to their contents scaling
+    f64 dynamicScaleGpuTime;     // moving average of the GPU time of frames rendered at renderScale
+    u32 dynamicScaleSampleCount; // number of frames timed since renderScale last changed
+
+    oc_wgpu_canvas_stroke_cache strokeCache;
+    oc_wgpu_canvas_glyph_cache glyphCache;
+
     WGPUInstance instance;
+    WGPUAdapter adapter; // kept to query the present modes supported by surfaces
     WGPUDevice device;
+
+    WGPUPresentMode presentMode;
+    u32 maxFrameLatency;
+    u64 pacedFrameCount;    // frames counted by oc_wgpu_canvas_wait_frame_latency()
+    u64 completedFrameCount; // counted frames whose GPU work is done
     WGPUQueue queue;
 
     WGPUBindGroup pathSetupBindGroup;
+    WGPUBindGroup glyphExpandBindGroup;
     WGPUBindGroup segmentSetupBindGroup;
     WGPUBindGroup backpropBindGroup;
     WGPUBindGroup chunkBindGroup;
@@ -190,6 +812,7 @@ typedef struct oc_wgpu_canvas_renderer
     WGPUBindGroup finalBlitBindGroup;
 
     WGPUBindGroupLayout pathSetupBindGroupLayout;
+    WGPUBindGroupLayout glyphExpandBindGroupLayout;
     WGPUBindGroupLayout segmentSetupBindGroupLayout;
     WGPUBindGroupLayout backpropBindGroupLayout;
     WGPUBindGroupLayout chunkBindGroupLayout;
@@ -198,17 +821,35 @@ typedef struct oc_wgpu_canvas_renderer
     WGPUBindGroupLayout rasterBindGroupLayout;
     WGPUBindGroupLayout srcTexturesBindGroupLayout;
     WGPUBindGroupLayout blitBindGroupLayout;
+    WGPUBindGroupLayout blitReplaceBindGroupLayout;
     WGPUBindGroupLayout finalBlitBindGroupLayout;
+    WGPUBindGroupLayout imageBlitBindGroupLayout;
+    WGPUBindGroupLayout scaledBlitBindGroupLayout;
+    WGPUBindGroupLayout mipmapBindGroupLayout;
 
     WGPUComputePipeline pathSetupPipeline;
+    WGPUComputePipeline glyphExpandPipeline;
     WGPUComputePipeline segmentSetupPipeline;
     WGPUComputePipeline backpropPipeline;
     WGPUComputePipeline chunkPipeline;
     WGPUComputePipeline mergePipeline;
     WGPUComputePipeline balancePipeline;
-    WGPUComputePipeline rasterPipeline;
+    WGPUComputePipeline rasterPipeline; // generic variant, used until the batch's specialized variant is compiled
     WGPURenderPipeline blitPipeline;
+    WGPURenderPipeline blitReplacePipeline; // blit without blending, used for the first batch of a partial redraw
     WGPURenderPipeline finalBlitPipeline;
+    WGPURenderPipeline imageBlitPipeline;
+    WGPURenderPipeline scaledBlitPipeline; // final blit that upscales frames rendered at a dynamic render scale
+    WGPURenderPipeline mipmapPipeline;
+
+    WGPUShaderModule rasterModule; // kept to compile raster variants when a batch first needs them
+    WGPUPipelineLayout rasterPipelineLayout;
+    WGPUComputePipeline rasterVariants[OC_WGPU_CANVAS_RASTER_VARIANT_COUNT];
+    bool rasterVariantRequested[OC_WGPU_CANVAS_RASTER_VARIANT_COUNT];
+    u32 pendingRasterVariantCount;
+
+    WGPUSampler linearSampler;
+    oc_list mipmapDirtyImages;
 
     WGPUBuffer pathBuffer;
     WGPUBuffer pathCountBuffer; // remove?
@@ -216,6 +857,11 @@ typedef struct oc_wgpu_canvas_renderer
     WGPUBuffer elementBuffer;
     WGPUBuffer elementCountBuffer; // remove?
 
+    WGPUBuffer glyphInstanceBuffer;
+    WGPUBuffer glyphInstanceCountBuffer;
+
+    WGPUBuffer gradientBuffer;
+
     WGPUBuffer segmentCountBuffer;
     WGPUBuffer segmentBuffer;
     WGPUBuffer pathBinBuffer;
@@ -239,10 +885,19 @@ typedef struct oc_wgpu_canvas_renderer
 
     WGPUBuffer maxWorkGroupsPerDimensionBuffer;
 
+    WGPUBuffer imageBlitClearColorBuffer;
+    WGPUBuffer scaledBlitParamsBuffer;
+
+    oc_wgpu_canvas_staging_ring stagingRing;
+
     WGPUTextureView batchTextureView;
-    oc_vec2 batchTextureSize;
+    oc_vec2 batchTextureSize;     // size of the last rendered target, in pixels
+    oc_vec2 batchTextureCapacity; // allocated size of the batch and out textures, see oc_wgpu_canvas_target_capacity()
+    u32 targetStableFrameCount;   // number of frames since the target size last changed
 
     WGPUTextureView outTextureView;
+    u64 outTextureSurface; // surface whose last frame outTexture holds, 0 if its contents can't be reused
+    oc_vec2 outTextureScale;
 
     WGPUTextureView dummyTextureView;
 
@@ -250,9 +905,16 @@ typedef struct oc_wgpu_canvas_renderer
     WGPUQuerySet timestampsQuerySet;
     WGPUBuffer timestampsResolveBuffer;
 
-    int rollingBufferIndex;
-    oc_wgpu_canvas_timestamp_read_callback_data timestampsReadCallbackData[OC_WGPU_CANVAS_ROLLING_BUFFER_COUNT];
-    WGPUBuffer timestampsReadBuffer[OC_WGPU_CANVAS_ROLLING_BUFFER_COUNT];
+    int timestampsReadIndex;
+    oc_wgpu_canvas_timestamp_read_callback_data timestampsReadCallbackData[OC_WGPU_CANVAS_TIMESTAMP_READ_BUFFER_COUNT];
+    WGPUBuffer timestampsReadBuffer[OC_WGPU_CANVAS_TIMESTAMP_READ_BUFFER_COUNT];
+
+    int countersReadIndex;
+    oc_wgpu_canvas_counters_read_callback_data countersReadCallbackData[OC_WGPU_CANVAS_COUNTERS_READ_BUFFER_COUNT];
+    WGPUBuffer countersReadBuffer[OC_WGPU_CANVAS_COUNTERS_READ_BUFFER_COUNT];
+
+    oc_wgpu_canvas_buffer_usage bufferUsage[OC_WGPU_CANVAS_BUFFER_KIND_COUNT];
+    u32 bufferShrinkFrameCount; // 0 disables shrinking
 
     u64 frameIndex;
     f64 lastFrameTimeStamp;
@@ -260,6 +922,7 @@ typedef struct oc_wgpu_canvas_renderer
 
     oc_wgpu_canvas_record_options debugRecordOptions;
     u32 debugRecordsCount;
+    oc_str8 debugCapturePath; // capture file of the next frame, see oc_wgpu_canvas_debug_capture_next_frame()
     oc_list debugRecords;
     oc_list frameCountersFreeList;
     oc_list batchCountersFreeList;
@@ -267,37 +930,159 @@ typedef struct oc_wgpu_canvas_renderer
     oc_wgpu_canvas_stats_buffer gpuTime;
     oc_wgpu_canvas_stats_buffer cpuEncodeTime;
     oc_wgpu_canvas_stats_buffer cpuFrameTime;
+    oc_wgpu_canvas_stats_buffer passTime[OC_WGPU_CANVAS_PASS_COUNT];
     //TODO: presentation time
 
     oc_wgpu_canvas_debug_display_options debugDisplayOptions;
     WGPUBuffer debugDisplayOptionsBuffer;
 
+    oc_wgpu_canvas_encoding_pool encodingPool;
+    oc_wgpu_image_array imageArray;
+    oc_wgpu_tile_table tileTable;
+    oc_wgpu_canvas_upload_ring uploadRing;
+
 } oc_wgpu_canvas_renderer;
 
+typedef struct oc_wgpu_image oc_wgpu_image;
+
+typedef struct oc_wgpu_image_readback
+{
+    oc_wgpu_image* image; // null if the image was destroyed while the readback was in flight
+    oc_canvas_renderer_base* renderer;
+    WGPUBuffer buffer;
+    u64 bufferSize;
+    oc_rect region;
+    u32 bytesPerRow;
+    bool done;
+    bool failed;
+
+} oc_wgpu_image_readback;
+
 typedef struct oc_wgpu_image
 {
     oc_image_base base;
     WGPUTexture texture;
     WGPUTextureView textureView;
+    WGPUTextureView renderView; // RGBA8Unorm view of the first mip level, only set for render targets
+
+    i32 arrayLayer; // -1 if the image has its own texture
+    oc_rect arrayRect;
+
+    u64 uploadSerial; // serial of the last staged upload to the image
+
+    u32 mipLevelCount;
+    bool mipmapDirty;
+    oc_list_elt mipmapElt;
+
+    bool compressed;
+    u64 memorySize; // bytes of the image's own texture, 0 for images in the image array
+
+    oc_wgpu_tiled_image* tiled; // tiles of tiled images, which have no texture of their own
+
+    oc_wgpu_image_readback* readback;
 
 } oc_wgpu_image;
 
+typedef struct oc_wgpu_canvas_target
+{
+    WGPUTextureView view;
+    oc_vec2 size;
+    oc_vec2 scale;
+    oc_wgpu_image* image; // null when rendering to a surface
+    u64 surface;          // surface handle, 0 when rendering to an image
+    oc_rect damage;       // region that changed since the last frame rendered to the same surface, empty to redraw everything
+
+} oc_wgpu_canvas_target;
+
+//NOTE: timings, counters and chunk size tuning of a frame, which are read back once its command buffer is submitted.
+//      When several targets are rendered in one command buffer, they're only recorded for the first one.
+typedef struct oc_wgpu_canvas_frame_records
+{
+    f64 encodeStart;
+    bool recordTimestamps;
+    bool recordCounters;
+    u32 batchCount;
+    u32 passBatchCount;
+    oc_wgpu_canvas_frame_counters* frameCounters;
+    bool tuneChunkSize;
+    u32 tuningKey;
+    u32 tuningCandidate;
+    f32 renderScale; // dynamic render scale of the frame, or 0
+
+} oc_wgpu_canvas_frame_records;
+
 void oc_wgpu_canvas_submit(oc_canvas_renderer_base* rendererBase,
                            oc_surface surfaceHandle,
                            u32 sampleCount,
                            bool clear,
                            oc_color clearColor,
+                           oc_rect damage,
                            u32 primitiveCount,
                            oc_primitive* primitives,
+                           u32 attributeCount,
+                           oc_attributes* attributes,
                            u32 eltCount,
                            oc_path_elt* pathElements);
 
+void oc_wgpu_canvas_submit_image(oc_canvas_renderer_base* rendererBase,
+                                 oc_image_base* imageBase,
+                                 u32 sampleCount,
+                                 bool clear,
+                                 oc_color clearColor,
+                                 u32 primitiveCount,
+                                 oc_primitive* primitives,
+                                 u32 attributeCount,
+                                 oc_attributes* attributes,
+                                 u32 eltCount,
+                                 oc_path_elt* pathElements);
+
+void oc_wgpu_canvas_submit_many(oc_canvas_renderer_base* rendererBase, u32 count, oc_canvas_submission* submissions);
 void oc_wgpu_canvas_present(oc_canvas_renderer_base* rendererBase, oc_surface surfaceHandle);
 
 void oc_wgpu_canvas_destroy(oc_canvas_renderer_base* base);
 oc_image_base* oc_wgpu_canvas_image_create(oc_canvas_renderer_base* base, oc_vec2 size);
 void oc_wgpu_canvas_image_destroy(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase);
 void oc_wgpu_canvas_image_upload_region(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase, oc_rect region, u8* pixels);
+bool oc_wgpu_canvas_image_upload_done(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase);
+bool oc_wgpu_canvas_compressed_format_supported(oc_canvas_renderer_base* rendererBase, oc_image_compressed_format format);
+oc_image_base* oc_wgpu_canvas_image_create_compressed(oc_canvas_renderer_base* rendererBase, oc_image_compressed_format format, oc_vec2 size, oc_str8 data);
+oc_image_base* oc_wgpu_canvas_image_create_render_target(oc_canvas_renderer_base* rendererBase, oc_vec2 size);
+void oc_wgpu_canvas_image_readback_region(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase, oc_rect region);
+bool oc_wgpu_canvas_image_readback_done(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase);
+bool oc_wgpu_canvas_image_readback_get(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase, u64 size, u8* pixels);
+oc_image_base* oc_wgpu_canvas_image_create_tiled(oc_canvas_renderer_base* rendererBase, oc_vec2 size);
+u32 oc_wgpu_canvas_tiled_image_requests(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase, u32 maxCount, oc_image_tile* tiles);
+bool oc_wgpu_canvas_tiled_image_upload_tile(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase, oc_image_tile tile, oc_rect rect, u8* pixels);
+oc_image_base* oc_wgpu_canvas_image_create_yuv(oc_canvas_renderer_base* rendererBase, oc_image_yuv_format format, oc_image_yuv_color_space colorSpace, oc_vec2 size);
+void oc_wgpu_canvas_image_upload_yuv_plane(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase, u32 plane, u8* pixels);
+
+static void oc_wgpu_canvas_encoding_pool_init(oc_wgpu_canvas_encoding_pool* pool);
+static void oc_wgpu_canvas_encoding_pool_cleanup(oc_wgpu_canvas_encoding_pool* pool);
+static void oc_wgpu_canvas_stroke_cache_init(oc_wgpu_canvas_stroke_cache* cache);
+static void oc_wgpu_canvas_stroke_cache_cleanup(oc_wgpu_canvas_stroke_cache* cache);
+static void oc_wgpu_canvas_glyph_cache_init(oc_wgpu_canvas_glyph_cache* cache);
+static void oc_wgpu_canvas_glyph_cache_cleanup(oc_wgpu_canvas_glyph_cache* cache);
+static bool oc_wgpu_image_array_grow(oc_wgpu_canvas_renderer* renderer, u32 layerCap);
+static void oc_wgpu_tile_table_init(oc_wgpu_canvas_renderer* renderer);
+static void oc_wgpu_tile_table_flush(oc_wgpu_canvas_renderer* renderer);
+static void oc_wgpu_tiled_image_use(oc_wgpu_canvas_renderer* renderer, oc_wgpu_tile_use* use);
+static void oc_wgpu_tiled_image_release(oc_wgpu_canvas_renderer* renderer, oc_wgpu_tiled_image* tiled);
+static void oc_wgpu_canvas_upload_ring_flush(oc_wgpu_canvas_renderer* renderer);
+static void oc_wgpu_canvas_upload_ring_cleanup(oc_wgpu_canvas_renderer* renderer);
+static void oc_wgpu_canvas_generate_mipmaps(oc_wgpu_canvas_renderer* renderer);
+static void oc_wgpu_image_readback_release(oc_wgpu_image* image);
+static void oc_wgpu_canvas_write_capture(oc_wgpu_canvas_renderer* renderer,
+                                         oc_surface surfaceHandle,
+                                         u32 msaaSampleCount,
+                                         bool clear,
+                                         oc_color clearColor,
+                                         oc_rect damage,
+                                         u32 primitiveCount,
+                                         oc_primitive* primitives,
+                                         u32 attributeCount,
+                                         oc_attributes* attributes,
+                                         u32 eltCount,
+                                         oc_path_elt* elements);
 
 void oc_wgpu_canvas_stats_reset(oc_wgpu_canvas_stats_buffer* stats)
 {
@@ -376,9 +1161,8 @@ static void oc_wgpu_canvas_on_adapter_request_ended(WGPURequestAdapterStatus sta
 {
     if(status != WGPURequestAdapterStatus_Success)
     {
-        // cannot find adapter?
+        //NOTE: leave the result null, the renderer creation fails and the caller can fall back to another backend
         oc_log_error("%s\n", message);
-        exit(-1);
     }
     else
     {
@@ -421,38 +1205,276 @@ static void oc_wgpu_canvas_on_shader_error(WGPUCompilationInfoRequestStatus stat
     }
 }
 
-void oc_wgpu_renderer_create_compute_pipeline(WGPUDevice device,
-                                              const char* label,
-                                              const char* src,
-                                              const char* entryPoint,
-                                              u32 bindGroupCount,
-                                              WGPUBindGroupLayoutDescriptor* bindGroupLayoutDescs,
-                                              WGPUBindGroupLayout* bindGroupLayouts,
-                                              WGPUComputePipeline* pipeline)
+//------------------------------------------------------------------------------------------------
+// Pipeline cache
+//------------------------------------------------------------------------------------------------
+
+//NOTE: Dawn hands us opaque blobs (compiled shaders and pipelines) keyed by its own hash of the shader code and
+//      pipeline state. We keep them in an append-only file next to the executable, which starts with the isolation
+//      key of the adapter/driver that wrote it and is discarded when that key doesn't match.
+
+static oc_wgpu_canvas_pipeline_cache_entry* oc_wgpu_canvas_pipeline_cache_find(oc_wgpu_canvas_pipeline_cache* cache, oc_str8 key, u64 hash)
 {
-    oc_arena_scope scratch = oc_scratch_begin();
-    oc_str8_list list = { 0 };
+    oc_list_for(cache->entries, entry, oc_wgpu_canvas_pipeline_cache_entry, listElt)
+    {
+        if(entry->hash == hash
+           && entry->key.len == key.len
+           && !memcmp(entry->key.ptr, key.ptr, key.len))
+        {
+            return (entry);
+        }
+    }
+    return (0);
+}
 
-    oc_str8_list_push(scratch.arena, &list, OC_STR8(src));
-    oc_str8_list_push(scratch.arena, &list, OC_STR8(oc_wgsl_common));
+static oc_wgpu_canvas_pipeline_cache_entry* oc_wgpu_canvas_pipeline_cache_insert(oc_wgpu_canvas_pipeline_cache* cache, oc_str8 key, oc_str8 value)
+{
+    oc_wgpu_canvas_pipeline_cache_entry* entry = oc_arena_push_type(&cache->arena, oc_wgpu_canvas_pipeline_cache_entry);
+    entry->hash = oc_hash_xx64_string(key);
+    entry->key = oc_str8_push_copy(&cache->arena, key);
+    entry->value = oc_str8_push_copy(&cache->arena, value);
+    oc_list_push_back(&cache->entries, &entry->listElt);
+    return (entry);
+}
 
-    oc_str8 code = oc_str8_list_join(scratch.arena, list);
+static void oc_wgpu_canvas_pipeline_cache_write_entry(FILE* file, oc_wgpu_canvas_pipeline_cache_entry* entry)
+{
+    u32 sizes[2] = { entry->key.len, entry->value.len };
+    fwrite(sizes, sizeof(sizes), 1, file);
+    fwrite(entry->key.ptr, 1, entry->key.len, file);
+    fwrite(entry->value.ptr, 1, entry->value.len, file);
+}
 
-    WGPUShaderModuleDescriptor desc = {
-        .nextInChain = &((WGPUShaderModuleWGSLDescriptor){
-                             .chain.sType = WGPUSType_ShaderModuleWGSLDescriptor,
-                             .code = code.ptr,
-                         })
-                            .chain,
-    };
+static size_t oc_wgpu_canvas_pipeline_cache_load(void const* key, size_t keySize, void* value, size_t valueSize, void* userdata)
+{
+    oc_wgpu_canvas_pipeline_cache* cache = (oc_wgpu_canvas_pipeline_cache*)userdata;
+    oc_str8 keyStr = { .ptr = (char*)key, .len = keySize };
+    size_t size = 0;
 
-    WGPUShaderModule module = wgpuDeviceCreateShaderModule(device, &desc);
-    WGPUCompilationInfoCallbackInfo2 callbackInfo = {
+    oc_mutex_lock(cache->mutex);
+    {
+        oc_wgpu_canvas_pipeline_cache_entry* entry = oc_wgpu_canvas_pipeline_cache_find(cache, keyStr, oc_hash_xx64_string(keyStr));
+        if(entry)
+        {
+            //NOTE: Dawn first queries the size with a null value, then loads the blob
+            size = entry->value.len;
+            if(value && valueSize >= size)
+            {
+                memcpy(value, entry->value.ptr, size);
+            }
+        }
+    }
+    oc_mutex_unlock(cache->mutex);
+
+    return (size);
+}
+
+static void oc_wgpu_canvas_pipeline_cache_store(void const* key, size_t keySize, void const* value, size_t valueSize, void* userdata)
+{
+    oc_wgpu_canvas_pipeline_cache* cache = (oc_wgpu_canvas_pipeline_cache*)userdata;
+    oc_str8 keyStr = { .ptr = (char*)key, .len = keySize };
+    oc_str8 valueStr = { .ptr = (char*)value, .len = valueSize };
+
+    oc_mutex_lock(cache->mutex);
+    {
+        if(!oc_wgpu_canvas_pipeline_cache_find(cache, keyStr, oc_hash_xx64_string(keyStr)))
+        {
+            oc_wgpu_canvas_pipeline_cache_entry* entry = oc_wgpu_canvas_pipeline_cache_insert(cache, keyStr, valueStr);
+            if(cache->file)
+            {
+                oc_wgpu_canvas_pipeline_cache_write_entry(cache->file, entry);
+                fflush(cache->file);
+            }
+        }
+    }
+    oc_mutex_unlock(cache->mutex);
+}
+
+static void oc_wgpu_canvas_pipeline_cache_init(oc_wgpu_canvas_pipeline_cache* cache, oc_str8 isolationKey)
+{
+    oc_arena_init(&cache->arena);
+    cache->mutex = oc_mutex_create();
+    cache->isolationKey = oc_str8_push_copy(&cache->arena, isolationKey);
+    oc_list_init(&cache->entries);
+
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_str8 path = oc_path_executable_relative(scratch.arena, OC_STR8("wgpu_pipeline_cache.bin"));
+
+    //NOTE: load existing entries. A file written with another isolation key is discarded, and a truncated entry
+    //      (e.g. if we crashed while storing it) is dropped along with what follows.
+    bool keyMatches = false;
+    bool truncated = false;
+
+    FILE* file = fopen(path.ptr, "rb");
+    if(file)
+    {
+        fseek(file, 0, SEEK_END);
+        u64 fileSize = ftell(file);
+        rewind(file);
+
+        char* contents = oc_arena_push(scratch.arena, fileSize);
+        if(contents && fread(contents, 1, fileSize, file) == fileSize)
+        {
+            u32 header[3];
+            if(fileSize >= sizeof(header))
+            {
+                memcpy(header, contents, sizeof(header));
+                keyMatches = header[0] == OC_WGPU_CANVAS_PIPELINE_CACHE_MAGIC
+                          && header[1] == OC_WGPU_CANVAS_PIPELINE_CACHE_VERSION
+                          && header[2] == isolationKey.len
+                          && fileSize >= sizeof(header) + isolationKey.len
+                          && !memcmp(contents + sizeof(header), isolationKey.ptr, isolationKey.len);
+            }
+
+            if(keyMatches)
+            {
+                u64 offset = sizeof(header) + isolationKey.len;
+                while(offset < fileSize)
+                {
+                    u32 sizes[2];
+                    if(fileSize - offset < sizeof(sizes))
+                    {
+                        truncated = true;
+                        break;
+                    }
+                    memcpy(sizes, contents + offset, sizeof(sizes));
+                    offset += sizeof(sizes);
+
+                    if(fileSize - offset < (u64)sizes[0] + sizes[1])
+                    {
+                        truncated = true;
+                        break;
+                    }
+                    oc_str8 key = { .ptr = contents + offset, .len = sizes[0] };
+                    oc_str8 value = { .ptr = contents + offset + sizes[0], .len = sizes[1] };
+                    offset += sizes[0] + sizes[1];
+
+                    if(!oc_wgpu_canvas_pipeline_cache_find(cache, key, oc_hash_xx64_string(key)))
+                    {
+                        oc_wgpu_canvas_pipeline_cache_insert(cache, key, value);
+                    }
+                }
+            }
+        }
+        fclose(file);
+    }
+
+    if(keyMatches && !truncated)
+    {
+        cache->file = fopen(path.ptr, "ab");
+    }
+    else
+    {
+        cache->file = fopen(path.ptr, "wb");
+        if(cache->file)
+        {
+            u32 header[3] = { OC_WGPU_CANVAS_PIPELINE_CACHE_MAGIC, OC_WGPU_CANVAS_PIPELINE_CACHE_VERSION, isolationKey.len };
+            fwrite(header, sizeof(header), 1, cache->file);
+            fwrite(isolationKey.ptr, 1, isolationKey.len, cache->file);
+
+            oc_list_for(cache->entries, entry, oc_wgpu_canvas_pipeline_cache_entry, listElt)
+            {
+                oc_wgpu_canvas_pipeline_cache_write_entry(cache->file, entry);
+            }
+            fflush(cache->file);
+        }
+    }
+    if(!cache->file)
+    {
+        oc_log_warning("couldn't open pipeline cache file %.*s, compiled pipelines won't be persisted.\n", oc_str8_ip(path));
+    }
+
+    oc_scratch_end(scratch);
+}
+
+static void oc_wgpu_canvas_pipeline_cache_cleanup(oc_wgpu_canvas_pipeline_cache* cache)
+{
+    if(cache->file)
+    {
+        fclose(cache->file);
+    }
+    oc_mutex_destroy(cache->mutex);
+    oc_arena_cleanup(&cache->arena);
+}
+
+//------------------------------------------------------------------------------------------------
+// Pipeline creation
+//------------------------------------------------------------------------------------------------
+
+//NOTE: pipelines are compiled asynchronously, so that the renderer is created without waiting on the driver.
+//      Submit presents cleared frames until pendingPipelineCount drops to zero.
+
+static void oc_wgpu_canvas_on_compute_pipeline_created(WGPUCreatePipelineAsyncStatus status,
+                                                       WGPUComputePipeline pipeline,
+                                                       char const* message,
+                                                       void* userdata1,
+                                                       void* userdata2)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)userdata1;
+    if(status != WGPUCreatePipelineAsyncStatus_Success)
+    {
+        OC_ABORT("couldn't create compute pipeline: %s\n", message);
+    }
+    *(WGPUComputePipeline*)userdata2 = pipeline;
+    renderer->pendingPipelineCount--;
+}
+
+static void oc_wgpu_canvas_on_render_pipeline_created(WGPUCreatePipelineAsyncStatus status,
+                                                      WGPURenderPipeline pipeline,
+                                                      char const* message,
+                                                      void* userdata1,
+                                                      void* userdata2)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)userdata1;
+    if(status != WGPUCreatePipelineAsyncStatus_Success)
+    {
+        OC_ABORT("couldn't create render pipeline: %s\n", message);
+    }
+    *(WGPURenderPipeline*)userdata2 = pipeline;
+    renderer->pendingPipelineCount--;
+}
+
+WGPUShaderModule oc_wgpu_renderer_create_shader_module(oc_wgpu_canvas_renderer* renderer, const char* src)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_str8_list list = { 0 };
+
+    oc_str8_list_push(scratch.arena, &list, OC_STR8(src));
+    oc_str8_list_push(scratch.arena, &list, OC_STR8(oc_wgsl_common));
+
+    oc_str8 code = oc_str8_list_join(scratch.arena, list);
+
+    WGPUShaderModuleDescriptor desc = {
+        .nextInChain = &((WGPUShaderModuleWGSLDescriptor){
+                             .chain.sType = WGPUSType_ShaderModuleWGSLDescriptor,
+                             .code = code.ptr,
+                         })
+                            .chain,
+    };
+
+    WGPUShaderModule module = wgpuDeviceCreateShaderModule(renderer->device, &desc);
+    WGPUCompilationInfoCallbackInfo2 callbackInfo = {
         .mode = WGPUCallbackMode_AllowSpontaneous,
         .callback = oc_wgpu_canvas_on_shader_error,
     };
     wgpuShaderModuleGetCompilationInfo2(module, callbackInfo);
 
+    oc_scratch_end(scratch);
+    return (module);
+}
+
+void oc_wgpu_renderer_create_compute_pipeline(oc_wgpu_canvas_renderer* renderer,
+                                              const char* label,
+                                              const char* src,
+                                              const char* entryPoint,
+                                              u32 bindGroupCount,
+                                              WGPUBindGroupLayoutDescriptor* bindGroupLayoutDescs,
+                                              WGPUBindGroupLayout* bindGroupLayouts,
+                                              WGPUComputePipeline* pipeline)
+{
+    WGPUDevice device = renderer->device;
+    WGPUShaderModule module = oc_wgpu_renderer_create_shader_module(renderer, src);
+
     for(int i = 0; i < bindGroupCount; i++)
     {
         bindGroupLayouts[i] = wgpuDeviceCreateBindGroupLayout(device, &bindGroupLayoutDescs[i]);
@@ -472,46 +1494,34 @@ void oc_wgpu_renderer_create_compute_pipeline(WGPUDevice device,
             .entryPoint = entryPoint,
         },
     };
-    *pipeline = wgpuDeviceCreateComputePipeline(device, &pipelineDesc);
+    *pipeline = 0;
+    renderer->pendingPipelineCount++;
+
+    WGPUCreateComputePipelineAsyncCallbackInfo2 pipelineCallbackInfo = {
+        .mode = WGPUCallbackMode_AllowProcessEvents,
+        .callback = oc_wgpu_canvas_on_compute_pipeline_created,
+        .userdata1 = renderer,
+        .userdata2 = pipeline,
+    };
+    wgpuDeviceCreateComputePipelineAsync2(device, &pipelineDesc, pipelineCallbackInfo);
 
     wgpuPipelineLayoutRelease(pipelineLayout);
     wgpuShaderModuleRelease(module);
-
-    oc_scratch_end(scratch);
 }
 
-void oc_wgpu_renderer_create_render_pipeline(WGPUDevice device,
+void oc_wgpu_renderer_create_render_pipeline(oc_wgpu_canvas_renderer* renderer,
                                              const char* label,
                                              const char* src,
                                              const char* vertexEntryPoint,
                                              const char* fragmentEntryPoint,
                                              WGPUTextureFormat textureFormat,
+                                             bool blend,
                                              WGPUBindGroupLayoutDescriptor* bindGroupLayoutDesc,
                                              WGPUBindGroupLayout* bindGroupLayout,
                                              WGPURenderPipeline* pipeline)
 {
-    oc_arena_scope scratch = oc_scratch_begin();
-    oc_str8_list list = { 0 };
-
-    oc_str8_list_push(scratch.arena, &list, OC_STR8(src));
-    oc_str8_list_push(scratch.arena, &list, OC_STR8(oc_wgsl_common));
-
-    oc_str8 code = oc_str8_list_join(scratch.arena, list);
-
-    WGPUShaderModuleDescriptor desc = {
-        .nextInChain = &((WGPUShaderModuleWGSLDescriptor){
-                             .chain.sType = WGPUSType_ShaderModuleWGSLDescriptor,
-                             .code = code.ptr,
-                         })
-                            .chain,
-    };
-
-    WGPUShaderModule module = wgpuDeviceCreateShaderModule(device, &desc);
-    WGPUCompilationInfoCallbackInfo2 callbackInfo = {
-        .mode = WGPUCallbackMode_AllowSpontaneous,
-        .callback = oc_wgpu_canvas_on_shader_error,
-    };
-    wgpuShaderModuleGetCompilationInfo2(module, callbackInfo);
+    WGPUDevice device = renderer->device;
+    WGPUShaderModule module = oc_wgpu_renderer_create_shader_module(renderer, src);
 
     *bindGroupLayout = wgpuDeviceCreateBindGroupLayout(device, bindGroupLayoutDesc);
 
@@ -543,10 +1553,10 @@ void oc_wgpu_renderer_create_render_pipeline(WGPUDevice device,
             .entryPoint = fragmentEntryPoint,
             .targetCount = 1,
             .targets = (WGPUColorTargetState[]){
-                // writing to one output, with alpha-blending enabled
+                // writing to one output, with alpha-blending enabled if requested
                 {
                     .format = textureFormat,
-                    .blend = &(WGPUBlendState){
+                    .blend = !blend ? 0 : &(WGPUBlendState){
                         .color.operation = WGPUBlendOperation_Add,
                         .color.srcFactor = WGPUBlendFactor_One,
                         .color.dstFactor = WGPUBlendFactor_OneMinusSrcAlpha,
@@ -568,27 +1578,201 @@ void oc_wgpu_renderer_create_render_pipeline(WGPUDevice device,
         },
     };
 
-    *pipeline = wgpuDeviceCreateRenderPipeline(device, &pipelineDesc);
+    *pipeline = 0;
+    renderer->pendingPipelineCount++;
+
+    WGPUCreateRenderPipelineAsyncCallbackInfo2 pipelineCallbackInfo = {
+        .mode = WGPUCallbackMode_AllowProcessEvents,
+        .callback = oc_wgpu_canvas_on_render_pipeline_created,
+        .userdata1 = renderer,
+        .userdata2 = pipeline,
+    };
+    wgpuDeviceCreateRenderPipelineAsync2(device, &pipelineDesc, pipelineCallbackInfo);
 
     wgpuPipelineLayoutRelease(pipelineLayout);
     wgpuShaderModuleRelease(module);
+}
 
-    oc_scratch_end(scratch);
+/*NOTE:
+	The raster shader branches on features that most batches don't use. Raster variants are the same shader, with the
+	OC_WGPU_RASTER_* override constants of raster.wgsl turning off the features that a batch doesn't use and fixing
+	the sample count, so that the driver can drop the dead branches and unroll the sample loops.
+
+	A variant is compiled in the background the first time a batch needs it. These don't count in
+	pendingPipelineCount, since the generic raster pipeline can draw the batch in the meantime. Compiled variants are
+	kept in the pipeline cache, so that later runs get them quickly.
+*/
+
+static void oc_wgpu_canvas_on_raster_variant_created(WGPUCreatePipelineAsyncStatus status,
+                                                     WGPUComputePipeline pipeline,
+                                                     char const* message,
+                                                     void* userdata1,
+                                                     void* userdata2)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)userdata1;
+    if(status == WGPUCreatePipelineAsyncStatus_Success)
+    {
+        *(WGPUComputePipeline*)userdata2 = pipeline;
+    }
+    else
+    {
+        //NOTE: the generic pipeline keeps drawing the batches that would have used this variant
+        oc_log_error("couldn't create raster pipeline variant: %s\n", message);
+    }
+    renderer->pendingRasterVariantCount--;
+}
+
+static WGPUComputePipeline oc_wgpu_canvas_raster_pipeline(oc_wgpu_canvas_renderer* renderer, u32 features)
+{
+    u32 sampleCount = oc_clamp(renderer->msaaSampleCount, 0, OC_WGPU_CANVAS_MAX_SAMPLE_COUNT);
+    u32 variantIndex = sampleCount * OC_WGPU_CANVAS_RASTER_FEATURE_MASKS + features;
+
+    if(!renderer->rasterVariantRequested[variantIndex] && renderer->rasterModule)
+    {
+        renderer->rasterVariantRequested[variantIndex] = true;
+
+        WGPUConstantEntry constants[] = {
+            { .key = "OC_WGPU_RASTER_IMAGES", .value = (features & OC_WGPU_CANVAS_RASTER_IMAGES) ? 1 : 0 },
+            { .key = "OC_WGPU_RASTER_GRADIENTS", .value = (features & OC_WGPU_CANVAS_RASTER_GRADIENTS) ? 1 : 0 },
+            { .key = "OC_WGPU_RASTER_DEBUG", .value = (features & OC_WGPU_CANVAS_RASTER_DEBUG) ? 1 : 0 },
+            { .key = "OC_WGPU_RASTER_SAMPLE_COUNT", .value = sampleCount },
+        };
+
+        WGPUComputePipelineDescriptor pipelineDesc = {
+            .label = "raster variant",
+            .layout = renderer->rasterPipelineLayout,
+            .compute = {
+                .module = renderer->rasterModule,
+                .entryPoint = "raster",
+                .constantCount = oc_array_size(constants),
+                .constants = constants,
+            },
+        };
+        renderer->pendingRasterVariantCount++;
+
+        WGPUCreateComputePipelineAsyncCallbackInfo2 pipelineCallbackInfo = {
+            .mode = WGPUCallbackMode_AllowProcessEvents,
+            .callback = oc_wgpu_canvas_on_raster_variant_created,
+            .userdata1 = renderer,
+            .userdata2 = &renderer->rasterVariants[variantIndex],
+        };
+        wgpuDeviceCreateComputePipelineAsync2(renderer->device, &pipelineDesc, pipelineCallbackInfo);
+    }
+
+    WGPUComputePipeline variant = renderer->rasterVariants[variantIndex];
+    return (variant ? variant : renderer->rasterPipeline);
+}
+
+static WGPUPresentMode oc_wgpu_canvas_present_mode(oc_canvas_present_mode mode)
+{
+    WGPUPresentMode result = WGPUPresentMode_Fifo;
+    switch(mode)
+    {
+        case OC_CANVAS_PRESENT_MAILBOX:
+            result = WGPUPresentMode_Mailbox;
+            break;
+        case OC_CANVAS_PRESENT_IMMEDIATE:
+            result = WGPUPresentMode_Immediate;
+            break;
+        default:
+            break;
+    }
+    return (result);
+}
+
+void oc_wgpu_canvas_set_present_mode(oc_canvas_renderer_base* base, oc_canvas_present_mode mode, u32 maxFrameLatency)
+{
+    //NOTE: surfaces are reconfigured with the new mode when they get their next texture
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)base;
+    renderer->presentMode = oc_wgpu_canvas_present_mode(mode);
+    renderer->maxFrameLatency = maxFrameLatency;
+}
+
+void oc_wgpu_canvas_set_dynamic_scale(oc_canvas_renderer_base* base, f32 gpuBudget, f32 minScale)
+{
+    //NOTE: dynamic scale adapts to the GPU time of frames, so it's disabled when we can't time them
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)base;
+    renderer->dynamicScaleBudget = renderer->hasTimestamps ? oc_max(gpuBudget, 0) : 0;
+    renderer->dynamicScaleMin = oc_clamp(minScale, 1. / OC_WGPU_CANVAS_DYNAMIC_SCALE_STEPS, 1);
+    renderer->dynamicScaleSampleCount = 0;
+
+    if(renderer->dynamicScaleBudget == 0)
+    {
+        renderer->renderScale = 1;
+    }
+    else
+    {
+        renderer->renderScale = oc_max(renderer->renderScale, renderer->dynamicScaleMin);
+    }
+}
+
+f32 oc_wgpu_canvas_get_render_scale(oc_canvas_renderer_base* base)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)base;
+    return (renderer->renderScale);
+}
+
+static void oc_wgpu_canvas_on_frame_work_done(WGPUQueueWorkDoneStatus status, void* userdata)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)userdata;
+    renderer->completedFrameCount++;
+}
+
+void oc_wgpu_canvas_wait_frame_latency(oc_canvas_renderer_base* base)
+{
+    //NOTE: Dawn doesn't expose the frame latency waitable object of its swap chains, so we track the completion of
+    //      the work submitted between calls instead, which bounds the frames queued ahead of the GPU.
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)base;
+    if(renderer->maxFrameLatency == 0)
+    {
+        return;
+    }
+
+    renderer->pacedFrameCount++;
+    wgpuQueueOnSubmittedWorkDone(renderer->queue, oc_wgpu_canvas_on_frame_work_done, renderer);
+
+    while(renderer->pacedFrameCount - renderer->completedFrameCount > renderer->maxFrameLatency)
+    {
+        wgpuInstanceProcessEvents(renderer->instance);
+        oc_sleep_nano(100000);
+    }
 }
 
-oc_canvas_renderer oc_canvas_renderer_create(void)
+oc_canvas_renderer_base* oc_wgpu_canvas_renderer_create(oc_canvas_renderer_options* options)
 {
     oc_wgpu_canvas_renderer* renderer = oc_malloc_type(oc_wgpu_canvas_renderer);
     memset(renderer, 0, sizeof(oc_wgpu_canvas_renderer));
 
     //NOTE: setup base functions
+    renderer->base.backend = OC_CANVAS_BACKEND_WEBGPU;
     renderer->base.destroy = oc_wgpu_canvas_destroy;
     renderer->base.createSurfaceForWindow = oc_wgpu_canvas_surface_create_for_window;
     renderer->base.imageCreate = oc_wgpu_canvas_image_create;
     renderer->base.imageDestroy = oc_wgpu_canvas_image_destroy;
     renderer->base.imageUploadRegion = oc_wgpu_canvas_image_upload_region;
+    renderer->base.imageUploadDone = oc_wgpu_canvas_image_upload_done;
+    renderer->base.compressedFormatSupported = oc_wgpu_canvas_compressed_format_supported;
+    renderer->base.imageCreateCompressed = oc_wgpu_canvas_image_create_compressed;
+    renderer->base.imageCreateRenderTarget = oc_wgpu_canvas_image_create_render_target;
+    renderer->base.imageReadbackRegion = oc_wgpu_canvas_image_readback_region;
+    renderer->base.imageReadbackDone = oc_wgpu_canvas_image_readback_done;
+    renderer->base.imageReadbackGet = oc_wgpu_canvas_image_readback_get;
+    renderer->base.imageCreateTiled = oc_wgpu_canvas_image_create_tiled;
+    renderer->base.tiledImageRequests = oc_wgpu_canvas_tiled_image_requests;
+    renderer->base.tiledImageUploadTile = oc_wgpu_canvas_tiled_image_upload_tile;
+    renderer->base.imageCreateYuv = oc_wgpu_canvas_image_create_yuv;
+    renderer->base.imageUploadYuvPlane = oc_wgpu_canvas_image_upload_yuv_plane;
     renderer->base.submit = oc_wgpu_canvas_submit;
+    renderer->base.submitImage = oc_wgpu_canvas_submit_image;
+    renderer->base.submitMany = oc_wgpu_canvas_submit_many;
     renderer->base.present = oc_wgpu_canvas_present;
+    renderer->base.setPresentMode = oc_wgpu_canvas_set_present_mode;
+    renderer->base.waitFrameLatency = oc_wgpu_canvas_wait_frame_latency;
+    renderer->base.setDynamicScale = oc_wgpu_canvas_set_dynamic_scale;
+    renderer->base.getRenderScale = oc_wgpu_canvas_get_render_scale;
+
+    oc_wgpu_canvas_set_present_mode(&renderer->base, options->presentMode, options->maxFrameLatency);
+    renderer->renderScale = 1;
 
     {
         int enabledToggleCount = 1;
@@ -613,27 +1797,88 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
     //NOTE: create adapter
     WGPUAdapter adapter = 0;
     {
-        WGPURequestAdapterOptions options = {
-            .powerPreference = WGPUPowerPreference_HighPerformance,
+        //NOTE: subgroups are an experimental feature, which adapters only expose if unsafe APIs are allowed
+        const char* enabledToggles[] = { "allow_unsafe_apis" };
+
+        WGPURequestAdapterOptions adapterOptions = {
+            .nextInChain = &((WGPUDawnTogglesDescriptor){
+                                 .chain.sType = WGPUSType_DawnTogglesDescriptor,
+                                 .enabledToggleCount = 1,
+                                 .enabledToggles = enabledToggles,
+                             })
+                                .chain,
+            .powerPreference = options->powerPreference == OC_CANVAS_POWER_LOW_POWER
+                                 ? WGPUPowerPreference_LowPower
+                                 : WGPUPowerPreference_HighPerformance,
         };
-        wgpuInstanceRequestAdapter(renderer->instance, &options, &oc_wgpu_canvas_on_adapter_request_ended, &adapter);
-        OC_ASSERT(adapter && "Failed to get WebGPU adapter");
+        wgpuInstanceRequestAdapter(renderer->instance, &adapterOptions, &oc_wgpu_canvas_on_adapter_request_ended, &adapter);
+        if(!adapter)
+        {
+            oc_log_error("couldn't get a WebGPU adapter.\n");
+            wgpuInstanceRelease(renderer->instance);
+            free(renderer);
+            return (0);
+        }
 
         renderer->hasTimestamps = wgpuAdapterHasFeature(adapter, WGPUFeatureName_TimestampQuery);
+        renderer->hasSubgroups = wgpuAdapterHasFeature(adapter, WGPUFeatureName_ChromiumExperimentalSubgroups);
+
+        renderer->compressedFormats[OC_IMAGE_COMPRESSED_BC7_SRGB] = wgpuAdapterHasFeature(adapter, WGPUFeatureName_TextureCompressionBC);
+        renderer->compressedFormats[OC_IMAGE_COMPRESSED_ETC2_RGBA8_SRGB] = wgpuAdapterHasFeature(adapter, WGPUFeatureName_TextureCompressionETC2);
+        renderer->compressedFormats[OC_IMAGE_COMPRESSED_ASTC_4X4_SRGB] = wgpuAdapterHasFeature(adapter, WGPUFeatureName_TextureCompressionASTC);
+    }
+
+    //NOTE: open the pipeline cache, isolated per adapter and driver
+    {
+        WGPUAdapterProperties properties = { 0 };
+        wgpuAdapterGetProperties(adapter, &properties);
+
+        oc_arena_scope scratch = oc_scratch_begin();
+        oc_str8 isolationKey = oc_str8_pushf(scratch.arena,
+                                             "%04x:%04x:%i:%s",
+                                             properties.vendorID,
+                                             properties.deviceID,
+                                             (int)properties.backendType,
+                                             properties.driverDescription ? properties.driverDescription : "");
+
+        oc_wgpu_canvas_pipeline_cache_init(&renderer->pipelineCache, isolationKey);
+
+        oc_scratch_end(scratch);
+        wgpuAdapterPropertiesFreeMembers(properties);
     }
 
     //NOTE: create device
     {
-        WGPUSupportedLimits supported = { 0 };
+        WGPUDawnExperimentalSubgroupLimits subgroupLimits = {
+            .chain.sType = WGPUSType_DawnExperimentalSubgroupLimits,
+        };
+        WGPUSupportedLimits supported = {
+            .nextInChain = renderer->hasSubgroups ? &subgroupLimits.chain : 0,
+        };
         wgpuAdapterGetLimits(adapter, &supported);
 
         renderer->limits = supported.limits;
 
+        //NOTE: the subgroup backprop shader needs its 16 invocations workgroups to fit in a single subgroup
+        if(renderer->hasSubgroups && subgroupLimits.minSubgroupSize < 16)
+        {
+            renderer->hasSubgroups = false;
+        }
+
         int enabledToggleCount = 1;
         const char* enabledToggles[] = { "use_dxc" };
 
+        WGPUDawnCacheDeviceDescriptor cacheDesc = {
+            .chain.sType = WGPUSType_DawnCacheDeviceDescriptor,
+            .isolationKey = renderer->pipelineCache.isolationKey.ptr,
+            .loadDataFunction = oc_wgpu_canvas_pipeline_cache_load,
+            .storeDataFunction = oc_wgpu_canvas_pipeline_cache_store,
+            .functionUserdata = &renderer->pipelineCache,
+        };
+
         WGPUDeviceDescriptor desc = {
             .nextInChain = &((WGPUDawnTogglesDescriptor){
+                                 .chain.next = &cacheDesc.chain,
                                  .chain.sType = WGPUSType_DawnTogglesDescriptor,
                                  .enabledToggleCount = enabledToggleCount,
                                  .enabledToggles = enabledToggles,
@@ -642,10 +1887,28 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
             .requiredLimits = &(WGPURequiredLimits){ .limits = supported.limits },
         };
 
-        desc.requiredFeatures = (WGPUFeatureName[]){ WGPUFeatureName_TimestampQuery };
+        WGPUFeatureName requiredFeatures[2 + OC_IMAGE_COMPRESSED_FORMAT_COUNT];
+        desc.requiredFeatures = requiredFeatures;
+
         if(renderer->hasTimestamps)
         {
-            desc.requiredFeatureCount = 1;
+            requiredFeatures[desc.requiredFeatureCount++] = WGPUFeatureName_TimestampQuery;
+        }
+        if(renderer->hasSubgroups)
+        {
+            requiredFeatures[desc.requiredFeatureCount++] = WGPUFeatureName_ChromiumExperimentalSubgroups;
+        }
+        if(renderer->compressedFormats[OC_IMAGE_COMPRESSED_BC7_SRGB])
+        {
+            requiredFeatures[desc.requiredFeatureCount++] = WGPUFeatureName_TextureCompressionBC;
+        }
+        if(renderer->compressedFormats[OC_IMAGE_COMPRESSED_ETC2_RGBA8_SRGB])
+        {
+            requiredFeatures[desc.requiredFeatureCount++] = WGPUFeatureName_TextureCompressionETC2;
+        }
+        if(renderer->compressedFormats[OC_IMAGE_COMPRESSED_ASTC_4X4_SRGB])
+        {
+            requiredFeatures[desc.requiredFeatureCount++] = WGPUFeatureName_TextureCompressionASTC;
         }
 
         renderer->device = wgpuAdapterCreateDevice(adapter, &desc);
@@ -658,8 +1921,7 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
         renderer->queue = wgpuDeviceGetQueue(renderer->device);
     }
 
-    //NOTE:release adapter, we don't need it anymore
-    wgpuAdapterRelease(adapter);
+    renderer->adapter = adapter;
 
     //NOTE: create resources:
     //      variable size buffers are created/resized when input is uploaded to GPU
@@ -684,6 +1946,16 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
         renderer->elementCountBuffer = wgpuDeviceCreateBuffer(renderer->device, &desc);
     }
 
+    //NOTE: create glyph instance count buffer
+    {
+        WGPUBufferDescriptor desc = {
+            .label = "glyphInstanceCount",
+            .usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst,
+            .size = sizeof(u32),
+        };
+        renderer->glyphInstanceCountBuffer = wgpuDeviceCreateBuffer(renderer->device, &desc);
+    }
+
     //NOTE: create segment count buffer
     {
         WGPUBufferDescriptor desc = {
@@ -728,7 +2000,7 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
     {
         WGPUBufferDescriptor desc = {
             .label = "chunkEltCount",
-            .usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+            .usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst | WGPUBufferUsage_CopySrc,
             .size = sizeof(u32),
         };
         renderer->chunkEltCountBuffer = wgpuDeviceCreateBuffer(renderer->device, &desc);
@@ -769,6 +2041,26 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
                              sizeof(u32));
     }
 
+    //NOTE: create image blit clear color buffer
+    {
+        WGPUBufferDescriptor desc = {
+            .label = "image blit clear color",
+            .usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst,
+            .size = 4 * sizeof(f32),
+        };
+        renderer->imageBlitClearColorBuffer = wgpuDeviceCreateBuffer(renderer->device, &desc);
+    }
+
+    //NOTE: create scaled blit params buffer
+    {
+        WGPUBufferDescriptor desc = {
+            .label = "scaled blit params",
+            .usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst,
+            .size = 4 * sizeof(f32),
+        };
+        renderer->scaledBlitParamsBuffer = wgpuDeviceCreateBuffer(renderer->device, &desc);
+    }
+
     //NOTE: create msaa offsets buffer
     {
         WGPUBufferDescriptor desc = {
@@ -800,8 +2092,8 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
         };
         renderer->msaaSampleCountBuffer = wgpuDeviceCreateBuffer(renderer->device, &desc);
 
-        u32 msaaSampleCount = 8;
-        wgpuQueueWriteBuffer(renderer->queue, renderer->msaaSampleCountBuffer, 0, &msaaSampleCount, sizeof(u32));
+        renderer->msaaSampleCount = 8;
+        wgpuQueueWriteBuffer(renderer->queue, renderer->msaaSampleCountBuffer, 0, &renderer->msaaSampleCount, sizeof(u32));
     }
 
     //NOTE: create dummy texture
@@ -829,7 +2121,24 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
         wgpuTextureRelease(texture);
     }
 
-    //----------------------------------------------------------
+    //NOTE: create the linear sampler used to sample images and generate their mipmaps
+    {
+        WGPUSamplerDescriptor desc = {
+            .label = "linear sampler",
+            .addressModeU = WGPUAddressMode_ClampToEdge,
+            .addressModeV = WGPUAddressMode_ClampToEdge,
+            .addressModeW = WGPUAddressMode_ClampToEdge,
+            .magFilter = WGPUFilterMode_Linear,
+            .minFilter = WGPUFilterMode_Linear,
+            .mipmapFilter = WGPUMipmapFilterMode_Linear,
+            .lodMinClamp = 0,
+            .lodMaxClamp = 32,
+            .maxAnisotropy = 1,
+        };
+        renderer->linearSampler = wgpuDeviceCreateSampler(renderer->device, &desc);
+    }
+
+    //----------------------------------------------------------
     //NOTE: create pipelines
     //----------------------------------------------------------
 
@@ -871,9 +2180,9 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
             },
         };
 
-        oc_wgpu_renderer_create_compute_pipeline(renderer->device,
+        oc_wgpu_renderer_create_compute_pipeline(renderer,
                                                  "path setup",
-                                                 oc_wgsl_path_setup,
+                                                 renderer->hasSubgroups ? oc_wgsl_path_setup_subgroups : oc_wgsl_path_setup,
                                                  "path_setup",
                                                  1,
                                                  &bindGroupLayoutDesc,
@@ -881,6 +2190,44 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
                                                  &renderer->pathSetupPipeline);
     }
 
+    //NOTE: glyph expand pipeline
+    {
+        WGPUBindGroupLayoutDescriptor bindGroupLayoutDesc = {
+            .entryCount = 4,
+            .entries = (WGPUBindGroupLayoutEntry[]){
+                {
+                    .binding = 0,
+                    .visibility = WGPUShaderStage_Compute,
+                    .buffer.type = WGPUBufferBindingType_ReadOnlyStorage,
+                },
+                {
+                    .binding = 1,
+                    .visibility = WGPUShaderStage_Compute,
+                    .buffer.type = WGPUBufferBindingType_ReadOnlyStorage,
+                },
+                {
+                    .binding = 2,
+                    .visibility = WGPUShaderStage_Compute,
+                    .buffer.type = WGPUBufferBindingType_Uniform,
+                },
+                {
+                    .binding = 3,
+                    .visibility = WGPUShaderStage_Compute,
+                    .buffer.type = WGPUBufferBindingType_Storage,
+                },
+            },
+        };
+
+        oc_wgpu_renderer_create_compute_pipeline(renderer,
+                                                 "glyph expand",
+                                                 oc_wgsl_glyph_expand,
+                                                 "glyph_expand",
+                                                 1,
+                                                 &bindGroupLayoutDesc,
+                                                 &renderer->glyphExpandBindGroupLayout,
+                                                 &renderer->glyphExpandPipeline);
+    }
+
     //NOTE: segment setup pipeline
     {
         WGPUBindGroupLayoutDescriptor bindGroupLayoutDesc = {
@@ -939,14 +2286,23 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
             },
         };
 
-        oc_wgpu_renderer_create_compute_pipeline(renderer->device,
+        //NOTE: stroke expansion functions live in their own file but are part of the segment setup module
+        oc_arena_scope scratch = oc_scratch_begin();
+        oc_str8_list list = { 0 };
+        oc_str8_list_push(scratch.arena, &list, OC_STR8(oc_wgsl_segment_setup));
+        oc_str8_list_push(scratch.arena, &list, OC_STR8(oc_wgsl_stroke_setup));
+        oc_str8 segmentSetupSrc = oc_str8_list_join(scratch.arena, list);
+
+        oc_wgpu_renderer_create_compute_pipeline(renderer,
                                                  "segment setup",
-                                                 oc_wgsl_segment_setup,
+                                                 segmentSetupSrc.ptr,
                                                  "segment_setup",
                                                  1,
                                                  &bindGroupLayoutDesc,
                                                  &renderer->segmentSetupBindGroupLayout,
                                                  &renderer->segmentSetupPipeline);
+
+        oc_scratch_end(scratch);
     }
 
     //NOTE: backprop pipeline
@@ -972,9 +2328,9 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
             },
         };
 
-        oc_wgpu_renderer_create_compute_pipeline(renderer->device,
+        oc_wgpu_renderer_create_compute_pipeline(renderer,
                                                  "backprop pass",
-                                                 oc_wgsl_backprop,
+                                                 renderer->hasSubgroups ? oc_wgsl_backprop_subgroups : oc_wgsl_backprop,
                                                  "backprop",
                                                  1,
                                                  &bindGroupLayoutDesc,
@@ -1020,7 +2376,7 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
             },
         };
 
-        oc_wgpu_renderer_create_compute_pipeline(renderer->device,
+        oc_wgpu_renderer_create_compute_pipeline(renderer,
                                                  "chunk pass",
                                                  oc_wgsl_chunk,
                                                  "chunk",
@@ -1103,7 +2459,7 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
             },
         };
 
-        oc_wgpu_renderer_create_compute_pipeline(renderer->device,
+        oc_wgpu_renderer_create_compute_pipeline(renderer,
                                                  "merge pass",
                                                  oc_wgsl_merge,
                                                  "merge",
@@ -1131,7 +2487,7 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
             },
         };
 
-        oc_wgpu_renderer_create_compute_pipeline(renderer->device,
+        oc_wgpu_renderer_create_compute_pipeline(renderer,
                                                  "balance workgroups pass",
                                                  oc_wgsl_balance_workgroups,
                                                  "balance_workgroups",
@@ -1164,7 +2520,7 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
 
     //NOTE: raster pipeline
     {
-        WGPUBindGroupLayoutEntry sourceTextureEntries[OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS];
+        WGPUBindGroupLayoutEntry sourceTextureEntries[OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS + 3];
 
         for(int i = 0; i < OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS; i++)
         {
@@ -1176,11 +2532,28 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
                 .texture.multisampled = 0,
             };
         }
+        sourceTextureEntries[OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS] = (WGPUBindGroupLayoutEntry){
+            .binding = OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS,
+            .visibility = WGPUShaderStage_Compute,
+            .texture.sampleType = WGPUTextureSampleType_Float,
+            .texture.viewDimension = WGPUTextureViewDimension_2DArray,
+            .texture.multisampled = 0,
+        };
+        sourceTextureEntries[OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS + 1] = (WGPUBindGroupLayoutEntry){
+            .binding = OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS + 1,
+            .visibility = WGPUShaderStage_Compute,
+            .sampler.type = WGPUSamplerBindingType_Filtering,
+        };
+        sourceTextureEntries[OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS + 2] = (WGPUBindGroupLayoutEntry){
+            .binding = OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS + 2,
+            .visibility = WGPUShaderStage_Compute,
+            .buffer.type = WGPUBufferBindingType_ReadOnlyStorage,
+        };
 
         WGPUBindGroupLayoutDescriptor bindGroupLayoutDescs[2] = {
             // raster bindgroup 0
             {
-                .entryCount = 9,
+                .entryCount = 10,
                 .entries = (WGPUBindGroupLayoutEntry[]){
                     {
                         .binding = 0,
@@ -1229,18 +2602,23 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
                         .visibility = WGPUShaderStage_Compute,
                         .buffer.type = WGPUBufferBindingType_Uniform,
                     },
+                    {
+                        .binding = 9,
+                        .visibility = WGPUShaderStage_Compute,
+                        .buffer.type = WGPUBufferBindingType_ReadOnlyStorage,
+                    },
                 },
             },
             // bindgroup 1 (source textures)
             {
-                .entryCount = OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS,
+                .entryCount = OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS + 3,
                 .entries = sourceTextureEntries,
             }
         };
 
         WGPUBindGroupLayout bindGroupLayouts[2] = { 0 };
 
-        oc_wgpu_renderer_create_compute_pipeline(renderer->device,
+        oc_wgpu_renderer_create_compute_pipeline(renderer,
                                                  "raster",
                                                  oc_wgsl_raster,
                                                  "raster",
@@ -1251,6 +2629,14 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
 
         renderer->rasterBindGroupLayout = bindGroupLayouts[0];
         renderer->srcTexturesBindGroupLayout = bindGroupLayouts[1];
+
+        //NOTE: specialized variants share the generic pipeline's layout, see oc_wgpu_canvas_raster_pipeline()
+        WGPUPipelineLayoutDescriptor pipelineLayoutDesc = {
+            .bindGroupLayoutCount = 2,
+            .bindGroupLayouts = bindGroupLayouts,
+        };
+        renderer->rasterPipelineLayout = wgpuDeviceCreatePipelineLayout(renderer->device, &pipelineLayoutDesc);
+        renderer->rasterModule = oc_wgpu_renderer_create_shader_module(renderer, oc_wgsl_raster);
     }
 
     //NOTE: blit pipeline
@@ -1268,15 +2654,27 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
             },
         };
 
-        oc_wgpu_renderer_create_render_pipeline(renderer->device,
+        oc_wgpu_renderer_create_render_pipeline(renderer,
                                                 "blit",
                                                 oc_wgsl_blit,
                                                 "vs",
                                                 "fs",
                                                 WGPUTextureFormat_RGBA8Unorm,
+                                                true,
                                                 &bindGroupLayoutDesc,
                                                 &renderer->blitBindGroupLayout,
                                                 &renderer->blitPipeline);
+
+        oc_wgpu_renderer_create_render_pipeline(renderer,
+                                                "blit_replace",
+                                                oc_wgsl_blit,
+                                                "vs",
+                                                "fs",
+                                                WGPUTextureFormat_RGBA8Unorm,
+                                                false,
+                                                &bindGroupLayoutDesc,
+                                                &renderer->blitReplaceBindGroupLayout,
+                                                &renderer->blitReplacePipeline);
     }
 
     //NOTE: final blit pipeline
@@ -1294,17 +2692,119 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
             },
         };
 
-        oc_wgpu_renderer_create_render_pipeline(renderer->device,
+        oc_wgpu_renderer_create_render_pipeline(renderer,
                                                 "final_blit",
                                                 oc_wgsl_final_blit,
                                                 "vs",
                                                 "fs",
                                                 WGPUTextureFormat_BGRA8Unorm,
+                                                true,
                                                 &bindGroupLayoutDesc,
                                                 &renderer->finalBlitBindGroupLayout,
                                                 &renderer->finalBlitPipeline);
     }
 
+    //NOTE: image blit pipeline, used instead of the final blit when rendering to an image
+    {
+        WGPUBindGroupLayoutDescriptor bindGroupLayoutDesc = {
+            .entryCount = 2,
+            .entries = (WGPUBindGroupLayoutEntry[]){
+                {
+                    .binding = 0,
+                    .visibility = WGPUShaderStage_Fragment,
+                    .texture.sampleType = WGPUTextureSampleType_Float,
+                    .texture.viewDimension = WGPUTextureViewDimension_2D,
+                    .texture.multisampled = 0,
+                },
+                {
+                    .binding = 1,
+                    .visibility = WGPUShaderStage_Fragment,
+                    .buffer.type = WGPUBufferBindingType_Uniform,
+                },
+            },
+        };
+
+        oc_wgpu_renderer_create_render_pipeline(renderer,
+                                                "image_blit",
+                                                oc_wgsl_final_blit,
+                                                "vs",
+                                                "fs_image",
+                                                WGPUTextureFormat_RGBA8Unorm,
+                                                true,
+                                                &bindGroupLayoutDesc,
+                                                &renderer->imageBlitBindGroupLayout,
+                                                &renderer->imageBlitPipeline);
+    }
+
+    //NOTE: scaled blit pipeline, used instead of the final blit when the frame was rendered at a dynamic render scale
+    {
+        WGPUBindGroupLayoutDescriptor bindGroupLayoutDesc = {
+            .entryCount = 3,
+            .entries = (WGPUBindGroupLayoutEntry[]){
+                {
+                    .binding = 0,
+                    .visibility = WGPUShaderStage_Fragment,
+                    .texture.sampleType = WGPUTextureSampleType_Float,
+                    .texture.viewDimension = WGPUTextureViewDimension_2D,
+                    .texture.multisampled = 0,
+                },
+                {
+                    .binding = 2,
+                    .visibility = WGPUShaderStage_Fragment,
+                    .buffer.type = WGPUBufferBindingType_Uniform,
+                },
+                {
+                    .binding = 3,
+                    .visibility = WGPUShaderStage_Fragment,
+                    .sampler.type = WGPUSamplerBindingType_Filtering,
+                },
+            },
+        };
+
+        oc_wgpu_renderer_create_render_pipeline(renderer,
+                                                "scaled_blit",
+                                                oc_wgsl_final_blit,
+                                                "vs",
+                                                "fs_scaled",
+                                                WGPUTextureFormat_BGRA8Unorm,
+                                                true,
+                                                &bindGroupLayoutDesc,
+                                                &renderer->scaledBlitBindGroupLayout,
+                                                &renderer->scaledBlitPipeline);
+    }
+
+    //NOTE: mipmap pipeline
+    {
+        WGPUBindGroupLayoutDescriptor bindGroupLayoutDesc = {
+            .entryCount = 2,
+            .entries = (WGPUBindGroupLayoutEntry[]){
+                {
+                    .binding = 0,
+                    .visibility = WGPUShaderStage_Fragment,
+                    .texture.sampleType = WGPUTextureSampleType_Float,
+                    .texture.viewDimension = WGPUTextureViewDimension_2D,
+                    .texture.multisampled = 0,
+                },
+                {
+                    .binding = 1,
+                    .visibility = WGPUShaderStage_Fragment,
+                    .sampler.type = WGPUSamplerBindingType_Filtering,
+                },
+            },
+        };
+
+        oc_wgpu_renderer_create_render_pipeline(renderer,
+                                                "mipmap",
+                                                oc_wgsl_mipmap,
+                                                "vs",
+                                                "fs",
+                                                WGPUTextureFormat_RGBA8UnormSrgb,
+                                                true,
+                                                &bindGroupLayoutDesc,
+                                                &renderer->mipmapBindGroupLayout,
+                                                &renderer->mipmapPipeline);
+    }
+
     //NOTE: create timestamps query set and buffers
     if(renderer->hasTimestamps)
     {
@@ -1331,12 +2831,26 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
                 .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_MapRead,
                 .size = sizeof(oc_wgpu_canvas_frame_timestamps),
             };
-            for(int i = 0; i < OC_WGPU_CANVAS_ROLLING_BUFFER_COUNT; i++)
+            for(int i = 0; i < OC_WGPU_CANVAS_TIMESTAMP_READ_BUFFER_COUNT; i++)
             {
                 renderer->timestampsReadBuffer[i] = wgpuDeviceCreateBuffer(renderer->device, &desc);
             }
         }
     }
+    //NOTE: create counters read buffers
+    {
+        WGPUBufferDescriptor desc = {
+            .label = "countersRead",
+            .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_MapRead,
+            .size = OC_WGPU_CANVAS_COUNTERS_MAX_BATCHES * OC_WGPU_CANVAS_COUNTER_COUNT * sizeof(u32),
+        };
+        for(int i = 0; i < OC_WGPU_CANVAS_COUNTERS_READ_BUFFER_COUNT; i++)
+        {
+            renderer->countersReadBuffer[i] = wgpuDeviceCreateBuffer(renderer->device, &desc);
+        }
+        renderer->bufferShrinkFrameCount = OC_WGPU_CANVAS_BUFFER_SHRINK_DEFAULT_FRAMES;
+    }
+
     //NOTE: create debug display options buffer
     {
         WGPUBufferDescriptor desc = {
@@ -1347,20 +2861,25 @@ oc_canvas_renderer oc_canvas_renderer_create(void)
         renderer->debugDisplayOptionsBuffer = wgpuDeviceCreateBuffer(renderer->device, &desc);
     }
 
+    oc_wgpu_canvas_encoding_pool_init(&renderer->encodingPool);
+    oc_wgpu_canvas_stroke_cache_init(&renderer->strokeCache);
+    oc_wgpu_canvas_glyph_cache_init(&renderer->glyphCache);
+    oc_wgpu_image_array_grow(renderer, 1);
+    oc_wgpu_tile_table_init(renderer);
+    oc_list_init(&renderer->mipmapDirtyImages);
+
     //NOTE: init debug stuff
     oc_arena_init(&renderer->debugArena);
 
     oc_wgpu_canvas_stats_reset(&renderer->gpuTime);
     oc_wgpu_canvas_stats_reset(&renderer->cpuEncodeTime);
     oc_wgpu_canvas_stats_reset(&renderer->cpuFrameTime);
-
-    oc_canvas_renderer handle = oc_canvas_renderer_nil();
-    if(renderer)
+    for(int passIndex = 0; passIndex < OC_WGPU_CANVAS_PASS_COUNT; passIndex++)
     {
-        handle = oc_canvas_renderer_handle_alloc((oc_canvas_renderer_base*)renderer);
+        oc_wgpu_canvas_stats_reset(&renderer->passTime[passIndex]);
     }
 
-    return (handle);
+    return ((oc_canvas_renderer_base*)renderer);
 }
 
 static void oc_update_box_extents(oc_vec4* extents, oc_vec2 p)
@@ -1371,50 +2890,130 @@ static void oc_update_box_extents(oc_vec4* extents, oc_vec2 p)
     extents->w = oc_max(extents->w, p.y);
 }
 
-typedef struct oc_wgpu_canvas_encoding_context
+static void oc_merge_box_extents(oc_vec4* extents, oc_vec4 box)
 {
-    oc_wgpu_canvas_renderer* renderer;
-
-    oc_arena* arena;
-
-    u32 pathBatchStart;
+    extents->x = oc_min(extents->x, box.x);
+    extents->y = oc_min(extents->y, box.y);
+    extents->z = oc_max(extents->z, box.z);
+    extents->w = oc_max(extents->w, box.w);
+}
 
-    u32 inputPrimitiveCount;
-    oc_primitive* inputPrimitives;
+//NOTE: transforms the 2 to 4 control points of an element, writes them scaled to pixels in dst, and returns the
+//      extents of the points before and after the transform. The SIMD versions process two points per vector,
+//      interleaved as (x0, y0, x1, y1), and compute the same values as oc_mat2x3_mul(). An odd last point is
+//      duplicated, which doesn't change the extents.
+static void oc_wgpu_canvas_transform_points(oc_mat2x3 m,
+                                            oc_vec2 scale,
+                                            int count,
+                                            oc_vec2* src,
+                                            oc_vec2* dst,
+                                            oc_vec4* userBox,
+                                            oc_vec4* screenBox)
+{
+#if OC_WGPU_ENCODE_SSE2
+    const __m128 m0 = _mm_setr_ps(m.m[0], m.m[3], m.m[0], m.m[3]);
+    const __m128 m1 = _mm_setr_ps(m.m[1], m.m[4], m.m[1], m.m[4]);
+    const __m128 m2 = _mm_setr_ps(m.m[2], m.m[5], m.m[2], m.m[5]);
+    const __m128 s = _mm_setr_ps(scale.x, scale.y, scale.x, scale.y);
+
+    __m128 userMin = _mm_set1_ps(FLT_MAX);
+    __m128 userMax = _mm_set1_ps(-FLT_MAX);
+    __m128 screenMin = _mm_set1_ps(FLT_MAX);
+    __m128 screenMax = _mm_set1_ps(-FLT_MAX);
+
+    for(int i = 0; i < count; i += 2)
+    {
+        bool pair = (i + 1 < count);
+        __m128 v = pair ? _mm_loadu_ps(&src[i].x) : _mm_castsi128_ps(_mm_loadl_epi64((__m128i*)&src[i]));
+        v = pair ? v : _mm_movelh_ps(v, v);
 
-    u32 inputEltCount;
-    oc_path_elt* inputElements;
+        __m128 x = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 0, 0));
+        __m128 y = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 1, 1));
+        __m128 screen = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m0), _mm_mul_ps(y, m1)), m2);
 
-    u32 pathCount;
-    u32 pathCap;
-    oc_wgpu_path* pathData;
+        userMin = _mm_min_ps(userMin, v);
+        userMax = _mm_max_ps(userMax, v);
+        screenMin = _mm_min_ps(screenMin, screen);
+        screenMax = _mm_max_ps(screenMax, screen);
 
-    u32 eltCount;
-    u32 eltCap;
-    oc_wgpu_path_elt* elementData;
+        __m128 pixels = _mm_mul_ps(screen, s);
+        if(pair)
+        {
+            _mm_storeu_ps(&dst[i].x, pixels);
+        }
+        else
+        {
+            _mm_storel_pi((__m64*)&dst[i], pixels);
+        }
+    }
 
-    u32 maxSegmentCount;
-    u32 maxBinQueueCount;
-    u32 maxTileOpCount;
+    userMin = _mm_min_ps(userMin, _mm_movehl_ps(userMin, userMin));
+    userMax = _mm_max_ps(userMax, _mm_movehl_ps(userMax, userMax));
+    screenMin = _mm_min_ps(screenMin, _mm_movehl_ps(screenMin, screenMin));
+    screenMax = _mm_max_ps(screenMax, _mm_movehl_ps(screenMax, screenMax));
+
+    _mm_storeu_ps(&userBox->x, _mm_movelh_ps(userMin, userMax));
+    _mm_storeu_ps(&screenBox->x, _mm_movelh_ps(screenMin, screenMax));
+
+#elif OC_WGPU_ENCODE_NEON
+    const f32 m0Lanes[4] = { m.m[0], m.m[3], m.m[0], m.m[3] };
+    const f32 m1Lanes[4] = { m.m[1], m.m[4], m.m[1], m.m[4] };
+    const f32 m2Lanes[4] = { m.m[2], m.m[5], m.m[2], m.m[5] };
+    const f32 sLanes[4] = { scale.x, scale.y, scale.x, scale.y };
+    const float32x4_t m0 = vld1q_f32(m0Lanes);
+    const float32x4_t m1 = vld1q_f32(m1Lanes);
+    const float32x4_t m2 = vld1q_f32(m2Lanes);
+    const float32x4_t s = vld1q_f32(sLanes);
+
+    float32x4_t userMin = vdupq_n_f32(FLT_MAX);
+    float32x4_t userMax = vdupq_n_f32(-FLT_MAX);
+    float32x4_t screenMin = vdupq_n_f32(FLT_MAX);
+    float32x4_t screenMax = vdupq_n_f32(-FLT_MAX);
+
+    for(int i = 0; i < count; i += 2)
+    {
+        bool pair = (i + 1 < count);
+        float32x4_t v = pair ? vld1q_f32(&src[i].x) : vcombine_f32(vld1_f32(&src[i].x), vld1_f32(&src[i].x));
 
-    u32 chunkCount;
-    u32 maxChunkEltCount;
+        //NOTE: multiply and add separately rather than with vfmaq_f32(), so that the results match the scalar code
+        float32x4_t x = vtrn1q_f32(v, v);
+        float32x4_t y = vtrn2q_f32(v, v);
+        float32x4_t screen = vaddq_f32(vaddq_f32(vmulq_f32(x, m0), vmulq_f32(y, m1)), m2);
 
-    oc_primitive* primitive;
+        userMin = vminq_f32(userMin, v);
+        userMax = vmaxq_f32(userMax, v);
+        screenMin = vminq_f32(screenMin, screen);
+        screenMax = vmaxq_f32(screenMax, screen);
 
-    oc_vec4 pathUserExtents;
-    oc_vec4 pathScreenExtents;
+        float32x4_t pixels = vmulq_f32(screen, s);
+        if(pair)
+        {
+            vst1q_f32(&dst[i].x, pixels);
+        }
+        else
+        {
+            vst1_f32(&dst[i].x, vget_low_f32(pixels));
+        }
+    }
 
-    oc_vec2 screenSize;
-    oc_vec2 scale;
-    f32 tileSize;
-    u32 screenTilesCount;
+    vst1q_f32(&userBox->x, vcombine_f32(vmin_f32(vget_low_f32(userMin), vget_high_f32(userMin)),
+                                        vmax_f32(vget_low_f32(userMax), vget_high_f32(userMax))));
+    vst1q_f32(&screenBox->x, vcombine_f32(vmin_f32(vget_low_f32(screenMin), vget_high_f32(screenMin)),
+                                          vmax_f32(vget_low_f32(screenMax), vget_high_f32(screenMax))));
+#else
+    *userBox = (oc_vec4){ FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+    *screenBox = (oc_vec4){ FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
 
-    i32 currentImageIndex;
-    u32 imageCount;
-    oc_image imageBindings[OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS];
+    for(int i = 0; i < count; i++)
+    {
+        oc_vec2 screenP = oc_mat2x3_mul(m, src[i]);
+        dst[i] = (oc_vec2){ screenP.x * scale.x, screenP.y * scale.y };
 
-} oc_wgpu_canvas_encoding_context;
+        oc_update_box_extents(userBox, src[i]);
+        oc_update_box_extents(screenBox, screenP);
+    }
+#endif
+}
 
 oc_wgpu_path_elt* oc_wgpu_canvas_push_element(oc_wgpu_canvas_encoding_context* context)
 {
@@ -1490,19 +3089,12 @@ static void oc_wgpu_canvas_encode_element(oc_wgpu_canvas_encoding_context* conte
         }
         context->maxSegmentCount += maxSegmentCount;
 
-        oc_vec4 segBox = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
-
-        for(int i = 0; i < count; i++)
-        {
-            oc_update_box_extents(&context->pathUserExtents, p[i]);
-
-            oc_vec2 screenP = oc_mat2x3_mul(context->primitive->attributes.transform, p[i]);
-
-            elt->p[i] = (oc_vec2){ screenP.x * context->scale.x, screenP.y * context->scale.y };
+        oc_vec4 userBox;
+        oc_vec4 segBox;
+        oc_wgpu_canvas_transform_points(context->attributes->transform, context->scale, count, p, elt->p, &userBox, &segBox);
 
-            oc_update_box_extents(&context->pathScreenExtents, screenP);
-            oc_update_box_extents(&segBox, screenP);
-        }
+        oc_merge_box_extents(&context->pathUserExtents, userBox);
+        oc_merge_box_extents(&context->pathScreenExtents, segBox);
 
         //NOTE: we make a conservative guess. An element can never use more tile ops than the number of tiles it covers
         // times the number of segments it can produce.
@@ -1519,65 +3111,279 @@ static void oc_wgpu_canvas_encode_element(oc_wgpu_canvas_encoding_context* conte
     }
 }
 
-void oc_wgpu_canvas_encode_path(oc_wgpu_canvas_encoding_context* context, oc_primitive* primitive)
+static oc_vec4 oc_wgpu_canvas_path_clip(oc_wgpu_canvas_encoding_context* context)
 {
-    oc_wgpu_path* path = oc_wgpu_canvas_push_path(context);
+    //NOTE: clip rect of the current primitive in pixels, intersected with the damage rect if there is one
+    oc_rect clip = context->attributes->clip;
+    oc_vec4 result = {
+        clip.x * context->scale.x,
+        clip.y * context->scale.y,
+        (clip.x + clip.w) * context->scale.x,
+        (clip.y + clip.h) * context->scale.y,
+    };
 
-    if(path)
+    if(context->hasDamage)
     {
-        path->cmd = primitive->cmd;
+        result.x = oc_max(result.x, context->damage.x);
+        result.y = oc_max(result.y, context->damage.y);
+        result.z = oc_min(result.z, context->damage.z);
+        result.w = oc_min(result.w, context->damage.w);
+    }
+    return (result);
+}
 
-        path->box = (oc_vec4){
-            context->pathScreenExtents.x * context->scale.x,
-            context->pathScreenExtents.y * context->scale.y,
-            context->pathScreenExtents.z * context->scale.x,
-            context->pathScreenExtents.w * context->scale.y,
-        };
+//NOTE: records the level and uv box at which a path samples a tiled image, from the part of the path's box that is
+//      visible. The level is picked like in sampleFromTiledImage(), see raster.wgsl.
+static void oc_wgpu_canvas_push_tile_use(oc_wgpu_canvas_encoding_context* context,
+                                         oc_image image,
+                                         u32 levelCount,
+                                         oc_vec2 imageSize,
+                                         oc_mat2x3 uvTransform,
+                                         oc_wgpu_path* path)
+{
+    oc_vec4 box = {
+        oc_max(oc_max(path->box.x, path->clip.x), 0),
+        oc_max(oc_max(path->box.y, path->clip.y), 0),
+        oc_min(oc_min(path->box.z, path->clip.z), context->screenSize.x),
+        oc_min(oc_min(path->box.w, path->clip.w), context->screenSize.y),
+    };
+    if(box.x >= box.z || box.y >= box.w)
+    {
+        return;
+    }
 
-        path->clip = (oc_vec4){
-            primitive->attributes.clip.x * context->scale.x,
-            primitive->attributes.clip.y * context->scale.y,
-            (primitive->attributes.clip.x + primitive->attributes.clip.w) * context->scale.x,
-            (primitive->attributes.clip.y + primitive->attributes.clip.h) * context->scale.y,
-        };
+    oc_vec2 corners[4] = {
+        { box.x, box.y },
+        { box.z, box.y },
+        { box.x, box.w },
+        { box.z, box.w },
+    };
+    oc_vec4 uvBox = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for(int i = 0; i < 4; i++)
+    {
+        oc_vec2 uv = oc_mat2x3_mul(uvTransform, corners[i]);
+        uvBox.x = oc_min(uvBox.x, uv.x);
+        uvBox.y = oc_min(uvBox.y, uv.y);
+        uvBox.z = oc_max(uvBox.z, uv.x);
+        uvBox.w = oc_max(uvBox.w, uv.y);
+    }
+    uvBox.x = oc_clamp(uvBox.x, 0, 1);
+    uvBox.y = oc_clamp(uvBox.y, 0, 1);
+    uvBox.z = oc_clamp(uvBox.z, 0, 1);
+    uvBox.w = oc_clamp(uvBox.w, 0, 1);
 
-        for(int i = 0; i < 4; i++)
-        {
-            oc_color c = oc_color_convert(primitive->attributes.colors[i], OC_COLOR_SPACE_RGB);
-            memcpy(path->colors[i].c, c.c, 4 * sizeof(f32));
-        }
-        path->hasGradient = primitive->attributes.hasGradient;
-        path->blendSpace = primitive->attributes.blendSpace;
+    oc_vec2 dx = { uvTransform.m[0] * imageSize.x, uvTransform.m[3] * imageSize.y };
+    oc_vec2 dy = { uvTransform.m[1] * imageSize.x, uvTransform.m[4] * imageSize.y };
+    f32 scale = oc_max(sqrtf(dx.x * dx.x + dx.y * dx.y), sqrtf(dy.x * dy.x + dy.y * dy.y));
+    f32 lod = (scale > 1) ? log2f(scale) : 0;
 
-        if(!oc_image_is_nil(primitive->attributes.image) || primitive->attributes.hasGradient)
-        {
-            oc_vec2 texSize;
-            oc_rect srcRegion;
-            if(!oc_image_is_nil(primitive->attributes.image))
-            {
-                texSize = oc_image_size(primitive->attributes.image);
-                srcRegion = primitive->attributes.srcRegion;
-            }
-            else
-            {
-                texSize = (oc_vec2){ 1, 1 };
-                srcRegion = (oc_rect){ 0, 0, 1, 1 };
-            }
+    if(context->tileUseCount >= context->tileUseCap)
+    {
+        u32 newCap = oc_max(64, context->tileUseCap * 2);
+        oc_wgpu_tile_use* tileUses = oc_arena_push_array(context->arena, oc_wgpu_tile_use, newCap);
+        memcpy(tileUses, context->tileUses, context->tileUseCount * sizeof(oc_wgpu_tile_use));
 
-            oc_rect destRegion = {
-                context->pathUserExtents.x,
-                context->pathUserExtents.y,
-                (context->pathUserExtents.z - context->pathUserExtents.x),
-                (context->pathUserExtents.w - context->pathUserExtents.y),
-            };
+        context->tileUses = tileUses;
+        context->tileUseCap = newCap;
+    }
+    context->tileUses[context->tileUseCount] = (oc_wgpu_tile_use){
+        .image = image,
+        .level = oc_min((u32)lod, levelCount - 1),
+        .uvBox = uvBox,
+    };
+    context->tileUseCount++;
+}
 
-            oc_mat2x3 srcRegionToImage = {
-                1 / texSize.x, 0, srcRegion.x / texSize.x,
-                0, 1 / texSize.y, srcRegion.y / texSize.y
-            };
+//NOTE: textureRegion of paths sampling a YUV image, read by sampleFromYuvTexture(), see raster.wgsl
+static oc_vec4 oc_wgpu_yuv_texture_region(oc_image_base* image)
+{
+    u32 flags = 0;
+    if(image->yuvColorSpace == OC_IMAGE_YUV_BT601_FULL || image->yuvColorSpace == OC_IMAGE_YUV_BT709_FULL)
+    {
+        flags |= OC_WGPU_CANVAS_YUV_FLAG_FULL_RANGE;
+    }
+    if(image->yuvColorSpace == OC_IMAGE_YUV_BT709_LIMITED || image->yuvColorSpace == OC_IMAGE_YUV_BT709_FULL)
+    {
+        flags |= OC_WGPU_CANVAS_YUV_FLAG_BT709;
+    }
+    u32 format = (image->yuvFormat == OC_IMAGE_YUV_NV12) ? OC_WGPU_CANVAS_YUV_NV12 : OC_WGPU_CANVAS_YUV_I420;
 
-            oc_mat2x3 destRegionToSrcRegion = {
-                srcRegion.w / destRegion.w, 0, 0,
+    return ((oc_vec4){ format, flags, image->size.x, image->size.y });
+}
+
+static i32 oc_wgpu_canvas_push_gradient(oc_wgpu_canvas_encoding_context* context)
+{
+    oc_attributes* attributes = context->attributes;
+    if(context->gradientCount && context->gradientAttributes == attributes)
+    {
+        return (context->gradientCount - 1);
+    }
+
+    if(context->gradientCount >= context->gradientCap)
+    {
+        u32 newCap = oc_max(OC_WGPU_CANVAS_BUFFER_DEFAULT_LEN, (u32)(context->gradientCap * 1.5));
+        oc_wgpu_gradient* gradients = oc_arena_push_array(context->arena, oc_wgpu_gradient, newCap);
+        memcpy(gradients, context->gradients, context->gradientCount * sizeof(oc_wgpu_gradient));
+
+        context->gradients = gradients;
+        context->gradientCap = newCap;
+    }
+
+    //NOTE: map user space points to the gradient's space, where the gradient is evaluated from the length of the point
+    //      for radial gradients, and from its x coordinate for linear gradients. Degenerate gradients get the color of
+    //      their last stop everywhere.
+    oc_vec2 p0 = attributes->gradientPoints[0];
+    oc_vec2 p1 = attributes->gradientPoints[1];
+    oc_mat2x3 userToGradient = { 0, 0, 1,
+                                 0, 0, 0 };
+
+    if(attributes->gradientKind == OC_GRADIENT_LINEAR)
+    {
+        oc_vec2 d = { p1.x - p0.x, p1.y - p0.y };
+        f32 lenSquared = d.x * d.x + d.y * d.y;
+        if(lenSquared > 0)
+        {
+            userToGradient = (oc_mat2x3){ d.x / lenSquared, d.y / lenSquared, -(p0.x * d.x + p0.y * d.y) / lenSquared,
+                                          0, 0, 0 };
+        }
+    }
+    else
+    {
+        f32 radius = p1.x;
+        if(radius > 0)
+        {
+            userToGradient = (oc_mat2x3){ 1 / radius, 0, -p0.x / radius,
+                                          0, 1 / radius, -p0.y / radius };
+        }
+    }
+
+    oc_mat2x3 scaleM = {
+        context->scale.x, 0, 0,
+        0, context->scale.y, 0
+    };
+    oc_mat2x3 userToScreen = oc_mat2x3_mul_m(scaleM, attributes->transform);
+    oc_mat2x3 screenToGradient = oc_mat2x3_mul_m(userToGradient, oc_mat2x3_inv(userToScreen));
+
+    oc_wgpu_gradient* gradient = &context->gradients[context->gradientCount];
+    *gradient = (oc_wgpu_gradient){
+        .rows = {
+            { screenToGradient.m[0], screenToGradient.m[1], screenToGradient.m[2], 0 },
+            { screenToGradient.m[3], screenToGradient.m[4], screenToGradient.m[5], 0 },
+        },
+        .kind = attributes->gradientKind,
+        .blendSpace = attributes->blendSpace,
+        .stopCount = attributes->gradientStopCount,
+    };
+
+    for(u32 i = 0; i < attributes->gradientStopCount; i++)
+    {
+        oc_color c = oc_color_convert(attributes->gradientStops[i].color, OC_COLOR_SPACE_RGB);
+        if(attributes->blendSpace == OC_GRADIENT_BLEND_SRGB)
+        {
+            //NOTE: the raster shader converts the blended color back to linear
+            for(int j = 0; j < 3; j++)
+            {
+                c.c[j] = powf(c.c[j], 1 / 2.2);
+            }
+        }
+        gradient->offsets[i] = attributes->gradientStops[i].offset;
+        memcpy(gradient->colors[i].c, c.c, 4 * sizeof(f32));
+    }
+
+    context->gradientAttributes = attributes;
+    context->gradientCount++;
+    return (context->gradientCount - 1);
+}
+
+void oc_wgpu_canvas_encode_path(oc_wgpu_canvas_encoding_context* context, oc_primitive* primitive)
+{
+    oc_wgpu_path* path = oc_wgpu_canvas_push_path(context);
+    oc_attributes* attributes = context->attributes;
+
+    if(path)
+    {
+        if(context->analyticRect)
+        {
+            path->cmd = primitive->cmd;
+            path->radius = context->rectRadius;
+        }
+        else
+        {
+            path->cmd = (primitive->cmd == OC_CMD_STROKE || primitive->cmd == OC_CMD_CLIP_PATH) ? primitive->cmd : OC_CMD_FILL;
+            path->radius = 0;
+        }
+
+        path->box = (oc_vec4){
+            context->pathScreenExtents.x * context->scale.x,
+            context->pathScreenExtents.y * context->scale.y,
+            context->pathScreenExtents.z * context->scale.x,
+            context->pathScreenExtents.w * context->scale.y,
+        };
+
+        path->clip = oc_wgpu_canvas_path_clip(context);
+        path->clipDepth = attributes->clipPathDepth;
+
+        if(primitive->cmd == OC_CMD_CLIP_PATH)
+        {
+            //NOTE: a clip path must cover the same tiles as the marker closing it, whose box is their shared clip rect.
+            //      Extending the clip path's box to that rect gives both the same tile area in the merge pass.
+            path->box.x = oc_min(path->box.x, path->clip.x);
+            path->box.y = oc_min(path->box.y, path->clip.y);
+            path->box.z = oc_max(path->box.z, path->clip.z);
+            path->box.w = oc_max(path->box.w, path->clip.w);
+        }
+
+        for(int i = 0; i < 4; i++)
+        {
+            oc_color c = oc_color_convert(attributes->colors[i], OC_COLOR_SPACE_RGB);
+            memcpy(path->colors[i].c, c.c, 4 * sizeof(f32));
+        }
+        path->hasGradient = attributes->hasGradient && attributes->gradientKind == OC_GRADIENT_BILINEAR;
+        path->blendSpace = attributes->blendSpace;
+        path->gradientIndex = -1;
+
+        if(attributes->hasGradient && attributes->gradientKind != OC_GRADIENT_BILINEAR)
+        {
+            path->gradientIndex = oc_wgpu_canvas_push_gradient(context);
+
+            //NOTE: the merge pass only looks at colors[0] to know if the path is opaque, see path_is_opaque()
+            f32 minAlpha = 1;
+            for(u32 i = 0; i < attributes->gradientStopCount; i++)
+            {
+                minAlpha = oc_min(minAlpha, attributes->gradientStops[i].color.a);
+            }
+            path->colors[0] = (oc_vec4){ 1, 1, 1, minAlpha };
+        }
+
+        if(!oc_image_is_nil(attributes->image) || path->hasGradient)
+        {
+            oc_vec2 texSize;
+            oc_rect srcRegion;
+            if(!oc_image_is_nil(attributes->image))
+            {
+                texSize = oc_image_size(attributes->image);
+                srcRegion = attributes->srcRegion;
+            }
+            else
+            {
+                texSize = (oc_vec2){ 1, 1 };
+                srcRegion = (oc_rect){ 0, 0, 1, 1 };
+            }
+
+            oc_rect destRegion = {
+                context->pathUserExtents.x,
+                context->pathUserExtents.y,
+                (context->pathUserExtents.z - context->pathUserExtents.x),
+                (context->pathUserExtents.w - context->pathUserExtents.y),
+            };
+
+            oc_mat2x3 srcRegionToImage = {
+                1 / texSize.x, 0, srcRegion.x / texSize.x,
+                0, 1 / texSize.y, srcRegion.y / texSize.y
+            };
+
+            oc_mat2x3 destRegionToSrcRegion = {
+                srcRegion.w / destRegion.w, 0, 0,
                 0, srcRegion.h / destRegion.h, 0
             };
 
@@ -1590,7 +3396,7 @@ void oc_wgpu_canvas_encode_path(oc_wgpu_canvas_encoding_context* context, oc_pri
                 context->scale.x, 0, 0,
                 0, context->scale.y, 0
             };
-            oc_mat2x3 userToScreen = oc_mat2x3_mul_m(scaleM, primitive->attributes.transform);
+            oc_mat2x3 userToScreen = oc_mat2x3_mul_m(scaleM, attributes->transform);
             oc_mat2x3 screenToUser = oc_mat2x3_inv(userToScreen); //TODO should have scale here
 
             oc_mat2x3 uvTransform = srcRegionToImage;
@@ -1613,12 +3419,42 @@ void oc_wgpu_canvas_encode_path(oc_wgpu_canvas_encoding_context* context, oc_pri
             path->uvTransform[11] = 0;
 
             path->textureID = context->currentImageIndex;
+
+            if(path->textureID == OC_WGPU_CANVAS_TILED_TEXTURE_ID)
+            {
+                //NOTE: tiled images are sampled from the image's size, its range of the tile table and its level count
+                oc_wgpu_image* image = (oc_wgpu_image*)oc_image_from_handle(attributes->image);
+                oc_wgpu_tiled_image* tiled = image->tiled;
+                path->textureRegion = (oc_vec4){ texSize.x, texSize.y, tiled->tableOffset, tiled->levelCount };
+
+                oc_wgpu_canvas_push_tile_use(context, attributes->image, tiled->levelCount, texSize, uvTransform, path);
+            }
+            else if(path->textureID >= OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS)
+            {
+                oc_wgpu_image* image = (oc_wgpu_image*)oc_image_from_handle(attributes->image);
+                oc_rect rect = image->arrayRect;
+                path->textureRegion = (oc_vec4){ rect.x, rect.y, rect.x + rect.w, rect.y + rect.h };
+            }
+            else
+            {
+                oc_image_base* image = oc_image_from_handle(attributes->image);
+                path->textureRegion = image->yuv ? oc_wgpu_yuv_texture_region(image) : (oc_vec4){ 0 };
+            }
         }
         else
         {
             path->textureID = -1;
         }
 
+        if(path->textureID >= 0)
+        {
+            context->rasterFeatures |= OC_WGPU_CANVAS_RASTER_IMAGES;
+        }
+        if(path->gradientIndex >= 0 || path->hasGradient)
+        {
+            context->rasterFeatures |= OC_WGPU_CANVAS_RASTER_GRADIENTS;
+        }
+
         int firstTileX = path->box.x / context->tileSize;
         int firstTileY = path->box.y / context->tileSize;
         int lastTileX = path->box.z / context->tileSize;
@@ -1627,7 +3463,11 @@ void oc_wgpu_canvas_encode_path(oc_wgpu_canvas_encoding_context* context, oc_pri
         int nTilesX = lastTileX - firstTileX + 1;
         int nTilesY = lastTileY - firstTileY + 1;
 
-        context->maxBinQueueCount += (nTilesX * nTilesY);
+        //NOTE: rectangles don't get per-tile bin queues, see path_setup.wgsl
+        if(!context->analyticRect)
+        {
+            context->maxBinQueueCount += (nTilesX * nTilesY);
+        }
 
         //NOTE: each tile covered by a path may have one start and end op, or one fill op
         context->maxTileOpCount += (nTilesX * nTilesY) * 2;
@@ -1823,6 +3663,84 @@ static void oc_cubic_split(oc_vec2 p[4], f32 t, oc_vec2 outLeft[4], oc_vec2 outR
     outRight[3] = p[3];
 }
 
+//NOTE: GPU stroke expansion. When the transform preserves angles, line strokes, joints and caps are sent as a single
+//      element in screen space, and the segment setup shader expands them into the same outlines we'd emit on the CPU.
+//      We still compute a conservative bounding box of the expanded outline here to size the segment and tile op buffers.
+
+static bool oc_wgpu_canvas_is_transform_similarity(oc_mat2x3 m, f32* scale)
+{
+    f32 det = m.m[0] * m.m[4] - m.m[1] * m.m[3];
+    f32 norm2 = m.m[0] * m.m[0] + m.m[3] * m.m[3];
+    f32 tolerance = 1e-5 * norm2;
+
+    bool result = (fabsf(m.m[0] * m.m[0] + m.m[3] * m.m[3] - (m.m[1] * m.m[1] + m.m[4] * m.m[4])) <= tolerance)
+               && (fabsf(m.m[0] * m.m[1] + m.m[3] * m.m[4]) <= tolerance)
+               && det != 0;
+
+    *scale = sqrtf(fabsf(det));
+    return (result);
+}
+
+static oc_vec2 oc_wgpu_canvas_stroke_vector_to_screen(oc_wgpu_canvas_encoding_context* context, oc_vec2 v)
+{
+    oc_mat2x3 m = context->attributes->transform;
+    oc_vec2 res = {
+        (m.m[0] * v.x + m.m[1] * v.y) * context->scale.x,
+        (m.m[3] * v.x + m.m[4] * v.y) * context->scale.y,
+    };
+    return (res);
+}
+
+static oc_wgpu_path_elt* oc_wgpu_canvas_push_stroke_element(oc_wgpu_canvas_encoding_context* context,
+                                                            i32 kind,
+                                                            u32 pointCount,
+                                                            oc_vec2* p,
+                                                            f32 userExtent)
+{
+    oc_wgpu_path_elt* elt = oc_wgpu_canvas_push_element(context);
+    if(elt)
+    {
+        elt->pathIndex = context->pathCount;
+        elt->kind = kind;
+
+        //NOTE: every stroke element expands into at most 4 lines
+        int maxSegmentCount = 4;
+        context->maxSegmentCount += maxSegmentCount;
+
+        f32 screenExtent = userExtent * context->strokeScale;
+        oc_vec4 segBox = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        for(int i = 0; i < pointCount; i++)
+        {
+            oc_update_box_extents(&context->pathUserExtents, (oc_vec2){ p[i].x - userExtent, p[i].y - userExtent });
+            oc_update_box_extents(&context->pathUserExtents, (oc_vec2){ p[i].x + userExtent, p[i].y + userExtent });
+
+            oc_vec2 screenP = oc_mat2x3_mul(context->attributes->transform, p[i]);
+
+            elt->p[i] = (oc_vec2){ screenP.x * context->scale.x, screenP.y * context->scale.y };
+
+            oc_vec2 screenMin = { screenP.x - screenExtent, screenP.y - screenExtent };
+            oc_vec2 screenMax = { screenP.x + screenExtent, screenP.y + screenExtent };
+
+            oc_update_box_extents(&context->pathScreenExtents, screenMin);
+            oc_update_box_extents(&context->pathScreenExtents, screenMax);
+            oc_update_box_extents(&segBox, screenMin);
+            oc_update_box_extents(&segBox, screenMax);
+        }
+
+        int firstTileX = segBox.x * context->scale.x / context->tileSize;
+        int firstTileY = segBox.y * context->scale.y / context->tileSize;
+        int lastTileX = segBox.z * context->scale.x / context->tileSize;
+        int lastTileY = segBox.w * context->scale.y / context->tileSize;
+
+        int nTilesX = lastTileX - firstTileX + 1;
+        int nTilesY = lastTileY - firstTileY + 1;
+
+        context->maxTileOpCount += (nTilesX * nTilesY) * maxSegmentCount;
+    }
+    return (elt);
+}
+
 void oc_wgpu_encode_stroke_line(oc_wgpu_canvas_encoding_context* context, oc_vec2* p)
 {
     if(p[0].x == p[1].x && p[0].y == p[1].y)
@@ -1830,7 +3748,17 @@ void oc_wgpu_encode_stroke_line(oc_wgpu_canvas_encoding_context* context, oc_vec
         return;
     }
 
-    f32 width = context->primitive->attributes.width;
+    f32 width = context->attributes->width;
+
+    if(context->gpuStroke)
+    {
+        oc_wgpu_path_elt* elt = oc_wgpu_canvas_push_stroke_element(context, OC_WGPU_ELT_STROKE_LINE, 2, p, 0.5 * width);
+        if(elt)
+        {
+            elt->p[2] = (oc_vec2){ 0.5 * width * context->strokeScale * context->scale.x, 0 };
+        }
+        return;
+    }
 
     oc_vec2 v = { p[1].x - p[0].x, p[1].y - p[0].y };
     oc_vec2 n = { v.y, -v.x };
@@ -1853,10 +3781,27 @@ enum
     OC_HULL_CHECK_SAMPLE_COUNT = 5
 };
 
+static f32 oc_wgpu_canvas_stroke_tolerance(oc_wgpu_canvas_encoding_context* context, f32 width)
+{
+    //NOTE: in LOD mode the tolerance is in pixels, so convert it to user space using the transform's area scale
+    oc_attributes* attributes = context->attributes;
+    f32 tolerance = attributes->tolerance;
+    if(attributes->toleranceLOD)
+    {
+        oc_mat2x3 m = attributes->transform;
+        f32 pixelScale = sqrtf(fabsf(m.m[0] * m.m[4] - m.m[1] * m.m[3]) * context->scale.x * context->scale.y);
+        if(pixelScale > 0)
+        {
+            tolerance /= pixelScale;
+        }
+    }
+    return (oc_min(tolerance, 0.5 * width));
+}
+
 void oc_wgpu_encode_stroke_quadratic(oc_wgpu_canvas_encoding_context* context, oc_vec2* p)
 {
-    f32 width = context->primitive->attributes.width;
-    f32 tolerance = oc_min(context->primitive->attributes.tolerance, 0.5 * width);
+    f32 width = context->attributes->width;
+    f32 tolerance = oc_wgpu_canvas_stroke_tolerance(context, width);
 
     //NOTE: check for degenerate line case
     const f32 equalEps = 1e-3;
@@ -1945,8 +3890,8 @@ void oc_wgpu_encode_stroke_quadratic(oc_wgpu_canvas_encoding_context* context, o
 
 void oc_wgpu_encode_stroke_cubic(oc_wgpu_canvas_encoding_context* context, oc_vec2* p)
 {
-    f32 width = context->primitive->attributes.width;
-    f32 tolerance = oc_min(context->primitive->attributes.tolerance, 0.5 * width);
+    f32 width = context->attributes->width;
+    f32 tolerance = oc_wgpu_canvas_stroke_tolerance(context, width);
 
     //NOTE: check degenerate line cases
     f32 equalEps = 1e-3;
@@ -2111,7 +4056,18 @@ void oc_wgpu_stroke_cap(oc_wgpu_canvas_encoding_context* context,
                         oc_vec2 p0,
                         oc_vec2 direction)
 {
-    oc_attributes* attributes = &context->primitive->attributes;
+    oc_attributes* attributes = context->attributes;
+
+    if(context->gpuStroke)
+    {
+        oc_wgpu_path_elt* elt = oc_wgpu_canvas_push_stroke_element(context, OC_WGPU_ELT_STROKE_CAP, 1, &p0, attributes->width);
+        if(elt)
+        {
+            elt->p[1] = oc_wgpu_canvas_stroke_vector_to_screen(context, direction);
+            elt->p[2] = (oc_vec2){ 0.5 * attributes->width * context->strokeScale * context->scale.x, 0 };
+        }
+        return;
+    }
 
     //NOTE(martin): compute the tangent and normal vectors (multiplied by half width) at the cap point
     f32 dn = sqrt(oc_square(direction.x) + oc_square(direction.y));
@@ -2140,7 +4096,26 @@ void oc_wgpu_stroke_joint(oc_wgpu_canvas_encoding_context* context,
                           oc_vec2 t0,
                           oc_vec2 t1)
 {
-    oc_attributes* attributes = &context->primitive->attributes;
+    oc_attributes* attributes = context->attributes;
+
+    if(context->gpuStroke)
+    {
+        //NOTE: the miter point is at most maxJointExcursion + halfWidth away from the joint point.
+        //      A negative excursion tells the shader to emit a bevel joint.
+        bool miter = (attributes->joint == OC_JOINT_MITER);
+        f32 extent = 0.5 * attributes->width + (miter ? attributes->maxJointExcursion : 0);
+        f32 pixelScale = context->strokeScale * context->scale.x;
+
+        oc_wgpu_path_elt* elt = oc_wgpu_canvas_push_stroke_element(context, OC_WGPU_ELT_STROKE_JOINT, 1, &p0, extent);
+        if(elt)
+        {
+            elt->p[1] = oc_wgpu_canvas_stroke_vector_to_screen(context, t0);
+            elt->p[2] = oc_wgpu_canvas_stroke_vector_to_screen(context, t1);
+            elt->p[3] = (oc_vec2){ 0.5 * attributes->width * pixelScale,
+                                   miter ? attributes->maxJointExcursion * pixelScale : -1 };
+        }
+        return;
+    }
 
     //NOTE(martin): compute the normals at the joint point
     f32 norm_t0 = sqrt(oc_square(t0.x) + oc_square(t0.y));
@@ -2289,7 +4264,7 @@ u32 oc_wgpu_encode_stroke_subpath(oc_wgpu_canvas_encoding_context* context,
     currentPoint = endPoint;
 
     //NOTE(martin): encode subsequent elements along with their joints
-    oc_attributes* attributes = &context->primitive->attributes;
+    oc_attributes* attributes = context->attributes;
 
     while(eltIndex < eltCount && elements[eltIndex].type != OC_PATH_MOVE)
     {
@@ -2348,6 +4323,12 @@ void oc_wgpu_encode_stroke(oc_wgpu_canvas_encoding_context* context,
     oc_vec2 startPoint = path->startPoint;
     u32 startIndex = 0;
 
+    //NOTE: line strokes, joints and caps are expanded on the GPU when the transform is a similarity and the
+    //      surface scale is uniform, since the offset is then the same in every direction. Curves are still
+    //      offset on the CPU.
+    context->gpuStroke = (context->scale.x == context->scale.y)
+                      && oc_wgpu_canvas_is_transform_similarity(context->attributes->transform, &context->strokeScale);
+
     while(startIndex < eltCount)
     {
         //NOTE(martin): eliminate leading moves
@@ -2363,62 +4344,374 @@ void oc_wgpu_encode_stroke(oc_wgpu_canvas_encoding_context* context,
     }
 }
 
-bool oc_wgpu_grow_buffer_if_needed(oc_wgpu_canvas_renderer* renderer,
-                                   WGPUBuffer* buffer,
-                                   u32 minCap,
-                                   u32 eltSize,
-                                   const char* label,
-                                   WGPUBufferUsageFlags usage)
+//------------------------------------------------------------------------------------------------
+// Stroke cache
+//------------------------------------------------------------------------------------------------
+
+//NOTE: the outline elements of strokes offset on the CPU are kept across frames, keyed on the stroke's path elements
+//      and on the attributes and scale that change its outline. Cached elements are already in screen space, so a
+//      stroke drawn again with the same transform is copied instead of being offset again.
+
+static void oc_wgpu_canvas_stroke_cache_init(oc_wgpu_canvas_stroke_cache* cache)
 {
-    bool updateBuffer = false;
+    cache->mutex = oc_mutex_create();
+    oc_list_init(&cache->lru);
+    for(u32 i = 0; i < OC_WGPU_CANVAS_STROKE_CACHE_BUCKET_COUNT; i++)
+    {
+        oc_list_init(&cache->buckets[i]);
+    }
+    cache->size = 0;
+}
 
-    if((*buffer == 0)
-       || (wgpuBufferGetSize(*buffer) < minCap * eltSize))
+static void oc_wgpu_canvas_stroke_cache_evict(oc_wgpu_canvas_stroke_cache* cache, oc_wgpu_canvas_stroke_cache_entry* entry)
+{
+    oc_list_remove(&cache->buckets[entry->hash % OC_WGPU_CANVAS_STROKE_CACHE_BUCKET_COUNT], &entry->bucketElt);
+    oc_list_remove(&cache->lru, &entry->lruElt);
+    cache->size -= entry->size;
+    free(entry);
+}
+
+static void oc_wgpu_canvas_stroke_cache_cleanup(oc_wgpu_canvas_stroke_cache* cache)
+{
+    while(!oc_list_empty(cache->lru))
     {
-        if(*buffer)
+        oc_wgpu_canvas_stroke_cache_evict(cache, oc_list_last_entry(cache->lru, oc_wgpu_canvas_stroke_cache_entry, lruElt));
+    }
+    oc_mutex_destroy(cache->mutex);
+}
+
+static oc_str8 oc_wgpu_canvas_stroke_cache_key(oc_arena* arena,
+                                               oc_wgpu_canvas_encoding_context* context,
+                                               oc_path_elt* elements,
+                                               oc_path_descriptor* path)
+{
+    //NOTE: attributes are copied field by field so that struct padding doesn't end up in the key
+    oc_attributes* attributes = context->attributes;
+    oc_mat2x3 transform = attributes->transform;
+    f32 params[] = {
+        path->startPoint.x,
+        path->startPoint.y,
+        attributes->width,
+        attributes->tolerance,
+        attributes->toleranceLOD,
+        attributes->joint,
+        attributes->maxJointExcursion,
+        attributes->cap,
+        context->scale.x,
+        context->scale.y,
+        transform.m[0],
+        transform.m[1],
+        transform.m[2],
+        transform.m[3],
+        transform.m[4],
+        transform.m[5],
+    };
+    u64 eltSize = path->count * sizeof(oc_path_elt);
+
+    oc_str8 key = {
+        .ptr = oc_arena_push(arena, sizeof(params) + eltSize),
+        .len = sizeof(params) + eltSize,
+    };
+    memcpy(key.ptr, params, sizeof(params));
+    memcpy(key.ptr + sizeof(params), elements, eltSize);
+    return (key);
+}
+
+static void oc_wgpu_canvas_encode_cached_stroke(oc_wgpu_canvas_encoding_context* context, oc_primitive* primitive)
+{
+    oc_path_descriptor* path = &primitive->path;
+    oc_path_elt* elements = context->inputElements + path->startIndex;
+
+    if(path->count < OC_WGPU_CANVAS_STROKE_CACHE_MIN_ELTS
+       || path->startIndex + path->count > context->inputEltCount)
+    {
+        oc_wgpu_encode_stroke(context, elements, path);
+        return;
+    }
+
+    oc_wgpu_canvas_stroke_cache* cache = &context->renderer->strokeCache;
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_str8 key = oc_wgpu_canvas_stroke_cache_key(scratch.arena, context, elements, path);
+    u64 hash = oc_hash_xx64_string(key);
+    oc_list* bucket = &cache->buckets[hash % OC_WGPU_CANVAS_STROKE_CACHE_BUCKET_COUNT];
+
+    oc_mutex_lock(cache->mutex);
+
+    oc_wgpu_canvas_stroke_cache_entry* found = 0;
+    oc_list_for(*bucket, entry, oc_wgpu_canvas_stroke_cache_entry, bucketElt)
+    {
+        if(entry->hash == hash && !oc_str8_cmp(entry->key, key))
         {
-            wgpuBufferRelease(*buffer);
+            found = entry;
+            break;
         }
+    }
 
-        u64 newCap = oc_max(minCap * 1.5, OC_WGPU_CANVAS_BUFFER_DEFAULT_LEN);
-        u64 bufferLimit = oc_min(renderer->limits.maxBufferSize, renderer->limits.maxStorageBufferBindingSize);
-        u64 newSize = oc_clamp_high(newCap * eltSize, bufferLimit);
+    if(found)
+    {
+        oc_list_remove(&cache->lru, &found->lruElt);
+        oc_list_push_front(&cache->lru, &found->lruElt);
 
-        WGPUBufferDescriptor desc = {
-            .label = label,
-            .usage = usage,
-            .size = newSize,
-        };
-        *buffer = wgpuDeviceCreateBuffer(renderer->device, &desc);
+        //NOTE: copy the elements while holding the lock, since another job could evict the entry
+        for(u32 i = 0; i < found->eltCount; i++)
+        {
+            oc_wgpu_path_elt* elt = oc_wgpu_canvas_push_element(context);
+            *elt = found->elements[i];
+            elt->pathIndex = context->pathCount;
+        }
+        context->maxSegmentCount += found->maxSegmentCount;
+        context->maxTileOpCount += found->maxTileOpCount;
 
-        updateBuffer = true;
+        oc_update_box_extents(&context->pathUserExtents, (oc_vec2){ found->userExtents.x, found->userExtents.y });
+        oc_update_box_extents(&context->pathUserExtents, (oc_vec2){ found->userExtents.z, found->userExtents.w });
+        oc_update_box_extents(&context->pathScreenExtents, (oc_vec2){ found->screenExtents.x, found->screenExtents.y });
+        oc_update_box_extents(&context->pathScreenExtents, (oc_vec2){ found->screenExtents.z, found->screenExtents.w });
+    }
+    oc_mutex_unlock(cache->mutex);
 
-        //oc_log_info("grow %s, elt = %i, size = %i\n", label, newCap, desc.size);
+    if(!found)
+    {
+        //NOTE: the path extents are reset before each primitive, so after encoding they only hold this stroke's extents
+        u32 eltStart = context->eltCount;
+        u32 maxSegmentCount = context->maxSegmentCount;
+        u32 maxTileOpCount = context->maxTileOpCount;
+
+        oc_wgpu_encode_stroke(context, elements, path);
+
+        u32 eltCount = context->eltCount - eltStart;
+        u64 size = sizeof(oc_wgpu_canvas_stroke_cache_entry) + eltCount * sizeof(oc_wgpu_path_elt) + key.len;
+
+        oc_wgpu_canvas_stroke_cache_entry* entry = 0;
+        if(size <= OC_WGPU_CANVAS_STROKE_CACHE_MAX_SIZE)
+        {
+            entry = malloc(size);
+        }
+        if(entry)
+        {
+            memset(entry, 0, sizeof(oc_wgpu_canvas_stroke_cache_entry));
+            entry->hash = hash;
+            entry->size = size;
+            entry->eltCount = eltCount;
+            entry->elements = (oc_wgpu_path_elt*)(entry + 1);
+            entry->key = (oc_str8){ .ptr = (char*)(entry->elements + eltCount), .len = key.len };
+            entry->maxSegmentCount = context->maxSegmentCount - maxSegmentCount;
+            entry->maxTileOpCount = context->maxTileOpCount - maxTileOpCount;
+            entry->userExtents = context->pathUserExtents;
+            entry->screenExtents = context->pathScreenExtents;
+
+            memcpy(entry->elements, context->elementData + eltStart, eltCount * sizeof(oc_wgpu_path_elt));
+            memcpy(entry->key.ptr, key.ptr, key.len);
+
+            //NOTE: if another job inserted the same stroke in the meantime, the older copy is shadowed and ages out
+            oc_mutex_lock(cache->mutex);
+            while(cache->size + size > OC_WGPU_CANVAS_STROKE_CACHE_MAX_SIZE)
+            {
+                oc_wgpu_canvas_stroke_cache_evict(cache, oc_list_last_entry(cache->lru, oc_wgpu_canvas_stroke_cache_entry, lruElt));
+            }
+            oc_list_push_front(bucket, &entry->bucketElt);
+            oc_list_push_front(&cache->lru, &entry->lruElt);
+            cache->size += size;
+            oc_mutex_unlock(cache->mutex);
+        }
     }
 
-    return (updateBuffer);
+    oc_scratch_end(scratch);
 }
 
-void oc_wgpu_canvas_update_resources_if_needed(oc_wgpu_canvas_encoding_context* context)
+//NOTE: while a window is live-resized the target size changes every frame, and reallocating the batch and out textures
+//      each time stalls the GPU. Once the size has changed twice within OC_WGPU_CANVAS_TARGET_SETTLE_FRAMES frames, the
+//      textures are allocated with headroom and the target is rendered into their top-left corner. They are reallocated
+//      when the target outgrows them, and shrunk back to the target size once it has been stable for that many frames.
+//      A one-off size change reallocates to the exact size.
+enum
 {
-    oc_wgpu_canvas_renderer* renderer = context->renderer;
+    OC_WGPU_CANVAS_TARGET_SETTLE_FRAMES = 30,
+    OC_WGPU_CANVAS_TARGET_GRANULARITY = 256,
+};
 
-    bool updatePathBuffer = oc_wgpu_grow_buffer_if_needed(renderer,
-                                                          &renderer->pathBuffer,
-                                                          context->pathCount,
-                                                          sizeof(oc_wgpu_path),
-                                                          "path buffer",
-                                                          WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst);
+static oc_vec2 oc_wgpu_canvas_target_capacity(oc_wgpu_canvas_renderer* renderer, oc_vec2 size)
+{
+    oc_vec2 capacity = renderer->batchTextureCapacity;
+
+    bool sizeChanged = (renderer->batchTextureSize.x != size.x || renderer->batchTextureSize.y != size.y);
+    bool resizing = sizeChanged && (renderer->targetStableFrameCount < OC_WGPU_CANVAS_TARGET_SETTLE_FRAMES);
+
+    if(sizeChanged)
+    {
+        renderer->targetStableFrameCount = 0;
+    }
+    else if(renderer->targetStableFrameCount < OC_WGPU_CANVAS_TARGET_SETTLE_FRAMES)
+    {
+        renderer->targetStableFrameCount++;
+    }
+
+    if(capacity.x < size.x || capacity.y < size.y)
+    {
+        if(resizing && renderer->outTextureView)
+        {
+            //NOTE: leave room for a quarter more in each direction, rounded up to the granularity
+            u32 maxDim = renderer->limits.maxTextureDimension2D;
+            capacity.x = oc_min(maxDim, oc_align_up_pow2((u32)(size.x * 1.25f), OC_WGPU_CANVAS_TARGET_GRANULARITY));
+            capacity.y = oc_min(maxDim, oc_align_up_pow2((u32)(size.y * 1.25f), OC_WGPU_CANVAS_TARGET_GRANULARITY));
+            capacity.x = oc_max(capacity.x, size.x);
+            capacity.y = oc_max(capacity.y, size.y);
+        }
+        else
+        {
+            capacity = size;
+        }
+    }
+    else if(renderer->targetStableFrameCount == OC_WGPU_CANVAS_TARGET_SETTLE_FRAMES
+            && (capacity.x != size.x || capacity.y != size.y))
+    {
+        capacity = size;
+    }
+    return (capacity);
+}
+
+bool oc_wgpu_grow_buffer_if_needed(oc_wgpu_canvas_renderer* renderer,
+                                   WGPUBuffer* buffer,
+                                   oc_wgpu_canvas_buffer_kind kind,
+                                   u32 minCap,
+                                   u32 eltSize,
+                                   const char* label,
+                                   WGPUBufferUsageFlags usage)
+{
+    bool updateBuffer = false;
+    oc_wgpu_canvas_buffer_usage* bufferUsage = &renderer->bufferUsage[kind];
+    u64 cap = *buffer ? wgpuBufferGetSize(*buffer) / eltSize : 0;
+
+    //NOTE: the CPU-side estimates are upper bounds, but if the GPU reported a higher count (i.e. the buffer overflowed
+    //      and some of its contents were dropped), size the buffer from that count instead.
+    if(bufferUsage->gpuCount > minCap)
+    {
+        if(bufferUsage->gpuCount > cap)
+        {
+            oc_log_warning("%s overflowed (%u elements needed, capacity %llu), growing it.\n",
+                           label,
+                           bufferUsage->gpuCount,
+                           (unsigned long long)cap);
+        }
+        minCap = bufferUsage->gpuCount;
+    }
+
+    //NOTE: roll the usage of the previous frame in which the buffer was requested
+    if(bufferUsage->frameIndex != renderer->frameIndex)
+    {
+        if((u64)bufferUsage->framePeak * OC_WGPU_CANVAS_BUFFER_SHRINK_RATIO < cap)
+        {
+            bufferUsage->lowUsageFrameCount += renderer->frameIndex - bufferUsage->frameIndex;
+            bufferUsage->lowUsagePeak = oc_max(bufferUsage->lowUsagePeak, bufferUsage->framePeak);
+        }
+        else
+        {
+            bufferUsage->lowUsageFrameCount = 0;
+            bufferUsage->lowUsagePeak = 0;
+        }
+        bufferUsage->frameIndex = renderer->frameIndex;
+        bufferUsage->framePeak = 0;
+    }
+    bufferUsage->framePeak = oc_max(bufferUsage->framePeak, minCap);
+
+    bool shrink = renderer->bufferShrinkFrameCount
+               && bufferUsage->lowUsageFrameCount >= renderer->bufferShrinkFrameCount
+               && (u64)bufferUsage->framePeak * OC_WGPU_CANVAS_BUFFER_SHRINK_RATIO < cap
+               && cap > OC_WGPU_CANVAS_BUFFER_DEFAULT_LEN;
+
+    if((*buffer == 0)
+       || (cap < minCap)
+       || shrink)
+    {
+        if(*buffer)
+        {
+            wgpuBufferRelease(*buffer);
+            oc_canvas_renderer_track_memory(&renderer->base, OC_WGPU_CANVAS_BUFFER_MEMORY_CATEGORIES[kind], -(i64)bufferUsage->size);
+        }
+
+        u64 targetCap = shrink ? oc_max(bufferUsage->lowUsagePeak, bufferUsage->framePeak) : minCap;
+        u64 newCap = oc_max(targetCap * 1.5, OC_WGPU_CANVAS_BUFFER_DEFAULT_LEN);
+        u64 bufferLimit = oc_min(renderer->limits.maxBufferSize, renderer->limits.maxStorageBufferBindingSize);
+        u64 newSize = oc_clamp_high(newCap * eltSize, bufferLimit);
+
+        WGPUBufferDescriptor desc = {
+            .label = label,
+            .usage = usage,
+            .size = newSize,
+        };
+        *buffer = wgpuDeviceCreateBuffer(renderer->device, &desc);
+
+        updateBuffer = true;
+
+        bufferUsage->size = *buffer ? newSize : 0;
+        oc_canvas_renderer_track_memory(&renderer->base, OC_WGPU_CANVAS_BUFFER_MEMORY_CATEGORIES[kind], bufferUsage->size);
+        bufferUsage->gpuCount = 0;
+        bufferUsage->lowUsageFrameCount = 0;
+        bufferUsage->lowUsagePeak = 0;
+
+        //oc_log_info("grow %s, elt = %i, size = %i\n", label, newCap, desc.size);
+    }
+
+    return (updateBuffer);
+}
+
+void oc_wgpu_canvas_update_resources_if_needed(oc_wgpu_canvas_encoding_context* context)
+{
+    oc_wgpu_canvas_renderer* renderer = context->renderer;
+
+    bool updatePathBuffer = oc_wgpu_grow_buffer_if_needed(renderer,
+                                                          &renderer->pathBuffer,
+                                                          OC_WGPU_CANVAS_BUFFER_PATHS,
+                                                          context->pathCount,
+                                                          sizeof(oc_wgpu_path),
+                                                          "path buffer",
+                                                          WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst);
 
     bool updateElementBuffer = oc_wgpu_grow_buffer_if_needed(renderer,
                                                              &renderer->elementBuffer,
-                                                             context->eltCount,
+                                                             OC_WGPU_CANVAS_BUFFER_ELEMENTS,
+                                                             context->eltCount + context->glyphEltCount,
                                                              sizeof(oc_wgpu_path_elt),
                                                              "element buffer",
                                                              WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst);
 
+    oc_wgpu_canvas_glyph_cache* glyphCache = &renderer->glyphCache;
+    bool updateGlyphOutlineBuffer = oc_wgpu_grow_buffer_if_needed(renderer,
+                                                                  &glyphCache->buffer,
+                                                                  OC_WGPU_CANVAS_BUFFER_GLYPH_OUTLINES,
+                                                                  glyphCache->eltCount,
+                                                                  sizeof(oc_wgpu_path_elt),
+                                                                  "glyph outlines buffer",
+                                                                  WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst);
+    if(updateGlyphOutlineBuffer)
+    {
+        //NOTE: the new buffer is empty, so all cached outlines are uploaded again
+        oc_list_for_safe(glyphCache->entries, entry, oc_wgpu_canvas_glyph_entry, listElt)
+        {
+            oc_list_remove(&glyphCache->entries, &entry->listElt);
+            oc_list_push_back(&glyphCache->pending, &entry->listElt);
+        }
+    }
+
+    bool updateGlyphInstanceBuffer = oc_wgpu_grow_buffer_if_needed(renderer,
+                                                                   &renderer->glyphInstanceBuffer,
+                                                                   OC_WGPU_CANVAS_BUFFER_GLYPH_INSTANCES,
+                                                                   context->glyphInstanceCount,
+                                                                   sizeof(oc_wgpu_glyph_instance),
+                                                                   "glyph instances buffer",
+                                                                   WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst);
+
+    bool updateGradientBuffer = oc_wgpu_grow_buffer_if_needed(renderer,
+                                                              &renderer->gradientBuffer,
+                                                              OC_WGPU_CANVAS_BUFFER_GRADIENTS,
+                                                              context->gradientCount,
+                                                              sizeof(oc_wgpu_gradient),
+                                                              "gradient buffer",
+                                                              WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst);
+
     bool updateSegmentBuffer = oc_wgpu_grow_buffer_if_needed(renderer,
                                                              &renderer->segmentBuffer,
+                                                             OC_WGPU_CANVAS_BUFFER_SEGMENTS,
                                                              context->maxSegmentCount,
                                                              sizeof(oc_wgpu_segment),
                                                              "segment buffer",
@@ -2426,6 +4719,7 @@ void oc_wgpu_canvas_update_resources_if_needed(oc_wgpu_canvas_encoding_context*
 
     bool updatePathBinBuffer = oc_wgpu_grow_buffer_if_needed(renderer,
                                                              &renderer->pathBinBuffer,
+                                                             OC_WGPU_CANVAS_BUFFER_PATH_BINS,
                                                              context->pathCount,
                                                              sizeof(oc_wgpu_path_bin),
                                                              "path bins buffer",
@@ -2433,6 +4727,7 @@ void oc_wgpu_canvas_update_resources_if_needed(oc_wgpu_canvas_encoding_context*
 
     bool updateBinQueueBuffer = oc_wgpu_grow_buffer_if_needed(renderer,
                                                               &renderer->binQueueBuffer,
+                                                              OC_WGPU_CANVAS_BUFFER_BIN_QUEUES,
                                                               context->maxBinQueueCount,
                                                               sizeof(oc_wgpu_bin_queue),
                                                               "bin queues buffer",
@@ -2441,6 +4736,7 @@ void oc_wgpu_canvas_update_resources_if_needed(oc_wgpu_canvas_encoding_context*
     u32 maxTileQueues = oc_min(context->maxBinQueueCount, context->screenTilesCount);
     bool updateTileQueueBuffer = oc_wgpu_grow_buffer_if_needed(renderer,
                                                                &renderer->tileQueueBuffer,
+                                                               OC_WGPU_CANVAS_BUFFER_TILE_QUEUES,
                                                                maxTileQueues,
                                                                sizeof(oc_wgpu_tile_queue),
                                                                "tile queues buffer",
@@ -2448,6 +4744,7 @@ void oc_wgpu_canvas_update_resources_if_needed(oc_wgpu_canvas_encoding_context*
 
     bool updateTileOpBuffer = oc_wgpu_grow_buffer_if_needed(renderer,
                                                             &renderer->tileOpBuffer,
+                                                            OC_WGPU_CANVAS_BUFFER_TILE_OPS,
                                                             context->maxTileOpCount,
                                                             sizeof(oc_wgpu_tile_op),
                                                             "tile ops buffer",
@@ -2455,6 +4752,7 @@ void oc_wgpu_canvas_update_resources_if_needed(oc_wgpu_canvas_encoding_context*
 
     bool updateChunkBuffer = oc_wgpu_grow_buffer_if_needed(renderer,
                                                            &renderer->chunkBuffer,
+                                                           OC_WGPU_CANVAS_BUFFER_CHUNKS,
                                                            context->chunkCount,
                                                            sizeof(oc_wgpu_chunk),
                                                            "chunks buffer",
@@ -2462,22 +4760,30 @@ void oc_wgpu_canvas_update_resources_if_needed(oc_wgpu_canvas_encoding_context*
 
     bool updateChunkEltBuffer = oc_wgpu_grow_buffer_if_needed(renderer,
                                                               &renderer->chunkEltBuffer,
+                                                              OC_WGPU_CANVAS_BUFFER_CHUNK_ELTS,
                                                               context->maxChunkEltCount,
                                                               sizeof(oc_wgpu_chunk_elt),
                                                               "chunk elements buffer",
                                                               WGPUBufferUsage_Storage);
 
     //NOTE: resize batchTexture and outTexture if needed
+    oc_vec2 capacity = context->targetCapacity;
     bool updateTexture = (renderer->outTextureView == 0)
                       || (renderer->batchTextureView == 0)
-                      || (renderer->batchTextureSize.x != context->screenSize.x)
-                      || (renderer->batchTextureSize.y != context->screenSize.y);
+                      || (renderer->batchTextureCapacity.x != capacity.x)
+                      || (renderer->batchTextureCapacity.y != capacity.y);
+
+    renderer->batchTextureSize = context->screenSize;
 
     if(updateTexture)
     {
+        //NOTE: the batch and out textures are both rgba8
         if(renderer->outTextureView)
         {
             wgpuTextureViewRelease(renderer->outTextureView);
+            oc_canvas_renderer_track_memory(&renderer->base,
+                                            OC_CANVAS_MEMORY_TARGETS,
+                                            -(i64)(renderer->batchTextureCapacity.x * renderer->batchTextureCapacity.y * 4 * 2));
         }
 
         if(renderer->batchTextureView)
@@ -2490,7 +4796,7 @@ void oc_wgpu_canvas_update_resources_if_needed(oc_wgpu_canvas_encoding_context*
             WGPUTextureDescriptor desc = {
                 .usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_StorageBinding | WGPUTextureUsage_RenderAttachment,
                 .dimension = WGPUTextureDimension_2D,
-                .size = { context->screenSize.x, context->screenSize.y, 1 },
+                .size = { capacity.x, capacity.y, 1 },
                 .format = WGPUTextureFormat_RGBA8Unorm,
                 .mipLevelCount = 1,
                 .sampleCount = 1,
@@ -2515,7 +4821,7 @@ void oc_wgpu_canvas_update_resources_if_needed(oc_wgpu_canvas_encoding_context*
             WGPUTextureDescriptor desc = {
                 .usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_RenderAttachment,
                 .dimension = WGPUTextureDimension_2D,
-                .size = { context->screenSize.x, context->screenSize.y, 1 },
+                .size = { capacity.x, capacity.y, 1 },
                 .format = WGPUTextureFormat_RGBA8Unorm,
                 .mipLevelCount = 1,
                 .sampleCount = 1,
@@ -2535,7 +4841,10 @@ void oc_wgpu_canvas_update_resources_if_needed(oc_wgpu_canvas_encoding_context*
             wgpuTextureRelease(texture);
         }
 
-        renderer->batchTextureSize = context->screenSize;
+        renderer->batchTextureCapacity = capacity;
+        oc_canvas_renderer_track_memory(&renderer->base,
+                                        OC_CANVAS_MEMORY_TARGETS,
+                                        (i64)(renderer->batchTextureCapacity.x * renderer->batchTextureCapacity.y * 4 * 2));
     }
 
     //----------------------------------------------------------------------------------------
@@ -2590,6 +4899,48 @@ void oc_wgpu_canvas_update_resources_if_needed(oc_wgpu_canvas_encoding_context*
         renderer->pathSetupBindGroup = wgpuDeviceCreateBindGroup(renderer->device, &bindGroupDesc);
     }
 
+    //----------------------------------------------------------------------------------------
+    //NOTE: glyph expand pass bindgroup
+
+    if((renderer->glyphExpandBindGroup == 0)
+       || updateElementBuffer
+       || updateGlyphOutlineBuffer
+       || updateGlyphInstanceBuffer)
+    {
+        if(renderer->glyphExpandBindGroup)
+        {
+            wgpuBindGroupRelease(renderer->glyphExpandBindGroup);
+        }
+
+        WGPUBindGroupDescriptor bindGroupDesc = {
+            .layout = renderer->glyphExpandBindGroupLayout,
+            .entryCount = 4,
+            .entries = (WGPUBindGroupEntry[]){
+                {
+                    .binding = 0,
+                    .buffer = glyphCache->buffer,
+                    .size = wgpuBufferGetSize(glyphCache->buffer),
+                },
+                {
+                    .binding = 1,
+                    .buffer = renderer->glyphInstanceBuffer,
+                    .size = wgpuBufferGetSize(renderer->glyphInstanceBuffer),
+                },
+                {
+                    .binding = 2,
+                    .buffer = renderer->glyphInstanceCountBuffer,
+                    .size = sizeof(u32),
+                },
+                {
+                    .binding = 3,
+                    .buffer = renderer->elementBuffer,
+                    .size = wgpuBufferGetSize(renderer->elementBuffer),
+                },
+            }
+        };
+        renderer->glyphExpandBindGroup = wgpuDeviceCreateBindGroup(renderer->device, &bindGroupDesc);
+    }
+
     //----------------------------------------------------------------------------------------
     //NOTE: segment setup pass bindgroup
 
@@ -2856,6 +5207,7 @@ void oc_wgpu_canvas_update_resources_if_needed(oc_wgpu_canvas_encoding_context*
        || updateSegmentBuffer
        || updateTileQueueBuffer
        || updateTileOpBuffer
+       || updateGradientBuffer
        || updateTexture)
     {
         if(renderer->rasterBindGroup)
@@ -2865,7 +5217,7 @@ void oc_wgpu_canvas_update_resources_if_needed(oc_wgpu_canvas_encoding_context*
 
         WGPUBindGroupDescriptor bindGroupDesc = {
             .layout = renderer->rasterBindGroupLayout,
-            .entryCount = 9,
+            .entryCount = 10,
             .entries = (WGPUBindGroupEntry[]){
                 {
                     .binding = 0,
@@ -2911,6 +5263,11 @@ void oc_wgpu_canvas_update_resources_if_needed(oc_wgpu_canvas_encoding_context*
                     .buffer = renderer->debugDisplayOptionsBuffer,
                     .size = sizeof(oc_wgpu_debug_display_options),
                 },
+                {
+                    .binding = 9,
+                    .buffer = renderer->gradientBuffer,
+                    .size = wgpuBufferGetSize(renderer->gradientBuffer),
+                },
             }
         };
 
@@ -2926,7 +5283,7 @@ void oc_wgpu_canvas_update_resources_if_needed(oc_wgpu_canvas_encoding_context*
             wgpuBindGroupRelease(renderer->srcTexturesBindGroup);
         }
 
-        WGPUBindGroupEntry entries[OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS];
+        WGPUBindGroupEntry entries[OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS + 3];
         for(int i = 0; i < OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS; i++)
         {
             oc_wgpu_image* image = (oc_wgpu_image*)oc_image_from_handle(context->imageBindings[i]);
@@ -2945,10 +5302,23 @@ void oc_wgpu_canvas_update_resources_if_needed(oc_wgpu_canvas_encoding_context*
                 };
             }
         }
+        entries[OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS] = (WGPUBindGroupEntry){
+            .binding = OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS,
+            .textureView = renderer->imageArray.textureView,
+        };
+        entries[OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS + 1] = (WGPUBindGroupEntry){
+            .binding = OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS + 1,
+            .sampler = renderer->linearSampler,
+        };
+        entries[OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS + 2] = (WGPUBindGroupEntry){
+            .binding = OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS + 2,
+            .buffer = renderer->tileTable.buffer,
+            .size = (u64)renderer->tileTable.cap * sizeof(u32),
+        };
 
         WGPUBindGroupDescriptor bindGroupDesc = {
             .layout = renderer->srcTexturesBindGroupLayout,
-            .entryCount = OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS,
+            .entryCount = OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS + 3,
             .entries = entries,
         };
         renderer->srcTexturesBindGroup = wgpuDeviceCreateBindGroup(renderer->device, &bindGroupDesc);
@@ -3002,926 +5372,4252 @@ void oc_wgpu_canvas_update_resources_if_needed(oc_wgpu_canvas_encoding_context*
     }
 }
 
-bool oc_wgpu_canvas_encode_batch(oc_wgpu_canvas_encoding_context* context)
+//------------------------------------------------------------------------------------------
+// parallel encoding
+//------------------------------------------------------------------------------------------
+
+static oc_vec2 oc_path_elt_end_point(oc_path_elt* elt)
 {
-    if(context->pathBatchStart >= context->inputPrimitiveCount)
+    oc_vec2 p = { 0 };
+    switch(elt->type)
+    {
+        case OC_PATH_MOVE:
+        case OC_PATH_LINE:
+            p = elt->p[0];
+            break;
+
+        case OC_PATH_QUADRATIC:
+            p = elt->p[1];
+            break;
+
+        case OC_PATH_CUBIC:
+        case OC_PATH_POLYLINE:
+            p = elt->p[2];
+            break;
+    }
+    return (p);
+}
+
+static bool oc_wgpu_canvas_primitive_end_pos(oc_wgpu_canvas_encoding_context* context, oc_primitive* primitive, oc_vec2* pos)
+{
+    //NOTE: returns the pen position after encoding a fill primitive, which is used as the start of the next fill
+    if(primitive->cmd == OC_CMD_STROKE
+       || !primitive->path.count
+       || primitive->path.startIndex >= context->inputEltCount
+       || primitive->attributesIndex >= context->inputAttributeCount)
     {
-        oc_wgpu_canvas_update_resources_if_needed(context);
         return (false);
     }
-    else
+    u32 lastIndex = oc_min(primitive->path.startIndex + primitive->path.count, context->inputEltCount) - 1;
+    *pos = oc_path_elt_end_point(&context->inputElements[lastIndex]);
+    return (true);
+}
+
+static bool oc_wgpu_canvas_box_is_visible(oc_wgpu_canvas_encoding_context* context, oc_vec4 box)
+{
+    //NOTE: box is in screen coordinates, before scaling to pixels. Tests it against the clip, the viewport, and the
+    //      damage rect if there is one.
+    oc_rect clip = context->attributes->clip;
+    f32 x0 = oc_max(clip.x, 0);
+    f32 y0 = oc_max(clip.y, 0);
+    f32 x1 = oc_min(clip.x + clip.w, context->screenSize.x / context->scale.x);
+    f32 y1 = oc_min(clip.y + clip.h, context->screenSize.y / context->scale.y);
+
+    if(context->hasDamage)
     {
-        oc_wgpu_canvas_renderer* renderer = context->renderer;
+        x0 = oc_max(x0, context->damage.x / context->scale.x);
+        y0 = oc_max(y0, context->damage.y / context->scale.y);
+        x1 = oc_min(x1, context->damage.z / context->scale.x);
+        y1 = oc_min(y1, context->damage.w / context->scale.y);
+    }
+    return (box.x < x1 && box.z > x0 && box.y < y1 && box.w > y0);
+}
 
-        //convert primitives to wgpu_paths
-        oc_arena_scope scratch = oc_scratch_begin();
-        context->arena = scratch.arena;
+static oc_vec4 oc_wgpu_canvas_primitive_bounds(oc_wgpu_canvas_encoding_context* context, oc_primitive* primitive, oc_vec2 startPos)
+{
+    //NOTE: conservative screen bounds of a primitive, computed from the control points of its elements, which
+    //      contain the curves, expanded by the farthest a stroke's caps and joints can reach.
+    oc_attributes* attributes = context->attributes;
+    oc_vec4 userBox = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
 
-        context->pathData = 0;
-        context->pathCap = 0;
-        context->pathCount = 0;
+    oc_update_box_extents(&userBox, startPos);
+    oc_update_box_extents(&userBox, primitive->path.startPoint);
 
-        context->elementData = 0;
-        context->eltCap = 0;
-        context->eltCount = 0;
+    u32 endIndex = oc_min(primitive->path.startIndex + primitive->path.count, context->inputEltCount);
+    for(u32 eltIndex = primitive->path.startIndex; eltIndex < endIndex; eltIndex++)
+    {
+        oc_path_elt* elt = &context->inputElements[eltIndex];
+        int pointCount = (elt->type == OC_PATH_CUBIC) ? 3 : ((elt->type == OC_PATH_QUADRATIC) ? 2 : 1);
+        for(int i = 0; i < pointCount; i++)
+        {
+            oc_update_box_extents(&userBox, elt->p[i]);
+        }
+    }
 
-        context->maxSegmentCount = 0;
-        context->maxBinQueueCount = 0;
-        context->maxTileOpCount = 0;
+    if(primitive->cmd == OC_CMD_STROKE)
+    {
+        f32 margin = 0.5 * attributes->width * sqrtf(2) + oc_max(attributes->maxJointExcursion, 0);
+        userBox = (oc_vec4){ userBox.x - margin, userBox.y - margin, userBox.z + margin, userBox.w + margin };
+    }
 
-        context->imageCount = 0;
-        context->currentImageIndex = -1;
+    oc_vec4 box = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+    oc_update_box_extents(&box, oc_mat2x3_mul(attributes->transform, (oc_vec2){ userBox.x, userBox.y }));
+    oc_update_box_extents(&box, oc_mat2x3_mul(attributes->transform, (oc_vec2){ userBox.z, userBox.y }));
+    oc_update_box_extents(&box, oc_mat2x3_mul(attributes->transform, (oc_vec2){ userBox.z, userBox.w }));
+    oc_update_box_extents(&box, oc_mat2x3_mul(attributes->transform, (oc_vec2){ userBox.x, userBox.w }));
+    return (box);
+}
 
-        // should be conveyed from one batch to the other
-        oc_vec2 currentPos = (oc_vec2){ 0, 0 };
+static bool oc_wgpu_canvas_rect_extents(oc_wgpu_canvas_encoding_context* context, oc_primitive* primitive)
+{
+    //NOTE: rectangles can only be rasterized from their box if their transform keeps them axis-aligned and their
+    //      corners circular. Their box is the bounding box of the end points of their path elements.
+    oc_mat2x3 transform = context->attributes->transform;
+    if(transform.m[1] != 0 || transform.m[3] != 0 || primitive->radius < 0)
+    {
+        return (false);
+    }
 
-        int primitiveIndex = 0;
-        for(; primitiveIndex + context->pathBatchStart < context->inputPrimitiveCount; primitiveIndex++)
+    f32 scaleX = fabsf(transform.m[0]) * context->scale.x;
+    f32 scaleY = fabsf(transform.m[4]) * context->scale.y;
+    f32 radius = 0;
+    if(primitive->cmd == OC_CMD_RRECT && primitive->radius > 0)
+    {
+        if(fabsf(scaleX - scaleY) > 0.0001 * oc_max(scaleX, scaleY))
         {
-            oc_primitive* primitive = &context->inputPrimitives[context->pathBatchStart + primitiveIndex];
+            return (false);
+        }
+        radius = primitive->radius * scaleX;
+    }
 
-            if(primitive->attributes.image.h != 0)
-            {
-                context->currentImageIndex = -1;
-                for(int i = 0; i < context->imageCount; i++)
-                {
-                    if(context->imageBindings[i].h == primitive->attributes.image.h)
-                    {
-                        context->currentImageIndex = i;
-                    }
-                }
-                if(context->currentImageIndex <= 0)
-                {
-                    if(context->imageCount < OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS)
-                    {
-                        context->imageBindings[context->imageCount] = primitive->attributes.image;
-                        context->currentImageIndex = context->imageCount;
-                        context->imageCount++;
-                    }
-                    else
-                    {
-                        break;
-                    }
-                }
-            }
-            else
-            {
-                context->currentImageIndex = -1;
-            }
+    u32 endIndex = oc_min(primitive->path.startIndex + primitive->path.count, context->inputEltCount);
+    for(u32 eltIndex = primitive->path.startIndex; eltIndex < endIndex; eltIndex++)
+    {
+        oc_vec2 p = oc_path_elt_end_point(&context->inputElements[eltIndex]);
+        oc_update_box_extents(&context->pathUserExtents, p);
+        oc_update_box_extents(&context->pathScreenExtents, oc_mat2x3_mul(transform, p));
+    }
 
-            u32 lastPathCount = context->pathCount;
-            u32 lastEltCount = context->eltCount;
-            u32 lastMaxSegmentCount = context->maxSegmentCount;
-            u32 lastMaxBinQueueCount = context->maxBinQueueCount;
-            u32 lastMaxTileOpCount = context->maxTileOpCount;
+    context->rectRadius = radius;
+    return (endIndex > primitive->path.startIndex);
+}
 
-            if(primitive->path.count)
-            {
-                context->primitive = primitive;
-                context->pathScreenExtents = (oc_vec4){ FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
-                context->pathUserExtents = (oc_vec4){ FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+//------------------------------------------------------------------------------------------------
+// Glyph cache
+//------------------------------------------------------------------------------------------------
 
-                if(primitive->cmd == OC_CMD_STROKE)
-                {
-                    oc_wgpu_encode_stroke(context, context->inputElements + primitive->path.startIndex, &primitive->path);
-                }
-                else
-                {
-                    for(int eltIndex = 0;
-                        (eltIndex < primitive->path.count) && (primitive->path.startIndex + eltIndex < context->inputEltCount);
-                        eltIndex++)
-                    {
-                        oc_path_elt* elt = &context->inputElements[primitive->path.startIndex + eltIndex];
+//NOTE: the outlines of OC_CMD_GLYPH primitives are encoded once in font units and kept in a GPU buffer, keyed on their
+//      path elements. Each occurrence of a glyph then only encodes a path and an instance holding its transform, and
+//      the glyph expand pass writes the transformed outline to the element buffer, after the elements encoded on the CPU.
 
-                        if(elt->type != OC_PATH_MOVE)
-                        {
-                            oc_vec2 p[4] = { currentPos, elt->p[0], elt->p[1], elt->p[2] };
-                            oc_wgpu_canvas_encode_element(context, elt->type, p);
-                        }
-                        switch(elt->type)
-                        {
-                            case OC_PATH_MOVE:
-                                currentPos = elt->p[0];
-                                break;
+static void oc_wgpu_canvas_glyph_cache_init(oc_wgpu_canvas_glyph_cache* cache)
+{
+    cache->mutex = oc_mutex_create();
+    oc_list_init(&cache->entries);
+    oc_list_init(&cache->pending);
+    for(u32 i = 0; i < OC_WGPU_CANVAS_GLYPH_CACHE_BUCKET_COUNT; i++)
+    {
+        oc_list_init(&cache->buckets[i]);
+    }
+    cache->eltCount = 0;
+    cache->full = false;
+}
 
-                            case OC_PATH_LINE:
-                                currentPos = elt->p[0];
-                                break;
+static void oc_wgpu_canvas_glyph_cache_flush(oc_wgpu_canvas_glyph_cache* cache)
+{
+    //NOTE: called between frames, when no encoding job is running
+    oc_list_for_safe(cache->entries, entry, oc_wgpu_canvas_glyph_entry, listElt)
+    {
+        free(entry);
+    }
+    oc_list_for_safe(cache->pending, entry, oc_wgpu_canvas_glyph_entry, listElt)
+    {
+        free(entry);
+    }
+    oc_list_init(&cache->entries);
+    oc_list_init(&cache->pending);
+    for(u32 i = 0; i < OC_WGPU_CANVAS_GLYPH_CACHE_BUCKET_COUNT; i++)
+    {
+        oc_list_init(&cache->buckets[i]);
+    }
+    cache->eltCount = 0;
+    cache->full = false;
+}
 
-                            case OC_PATH_QUADRATIC:
-                                currentPos = elt->p[1];
-                                break;
+static void oc_wgpu_canvas_glyph_cache_cleanup(oc_wgpu_canvas_glyph_cache* cache)
+{
+    oc_wgpu_canvas_glyph_cache_flush(cache);
+    oc_mutex_destroy(cache->mutex);
+    if(cache->buffer)
+    {
+        wgpuBufferRelease(cache->buffer);
+    }
+}
 
-                            case OC_PATH_CUBIC:
-                                currentPos = elt->p[2];
-                                break;
-                        }
-                    }
-                }
-                oc_wgpu_canvas_encode_path(context, primitive);
+static oc_wgpu_canvas_glyph_entry* oc_wgpu_canvas_glyph_cache_insert(oc_wgpu_canvas_glyph_cache* cache, u64 hash, oc_str8 key)
+{
+    //NOTE: called with the cache mutex held. Outlines that don't start with a move depend on the pen position and
+    //      aren't cached.
+    oc_path_elt* elements = (oc_path_elt*)key.ptr;
+    u32 inputCount = key.len / sizeof(oc_path_elt);
+    if(!inputCount || elements[0].type != OC_PATH_MOVE)
+    {
+        return (0);
+    }
 
-                //NOTE: check encoding limits
-                {
-                    u64 bufferLimit = oc_min(renderer->limits.maxBufferSize, renderer->limits.maxStorageBufferBindingSize);
-                    u64 maxTileQueues = oc_min(context->maxBinQueueCount, context->screenTilesCount);
+    u32 eltCount = 0;
+    for(u32 i = 0; i < inputCount; i++)
+    {
+        eltCount += (elements[i].type != OC_PATH_MOVE) ? 1 : 0;
+    }
+    if(cache->eltCount + eltCount > OC_WGPU_CANVAS_GLYPH_CACHE_MAX_ELTS)
+    {
+        cache->full = true;
+        return (0);
+    }
 
-                    if(context->pathCount * sizeof(oc_wgpu_path) >= bufferLimit
-                       || context->eltCount * sizeof(oc_wgpu_path_elt) >= bufferLimit
-                       || context->maxSegmentCount * sizeof(oc_wgpu_segment) >= bufferLimit
-                       || context->pathCount * sizeof(oc_wgpu_path_bin) >= bufferLimit
-                       || context->maxBinQueueCount * sizeof(oc_wgpu_bin_queue) >= bufferLimit
-                       || maxTileQueues * sizeof(oc_wgpu_tile_queue) >= bufferLimit
-                       || context->maxTileOpCount * sizeof(oc_wgpu_tile_op) >= bufferLimit)
-                    {
-                        //NOTE: if batch overflows max GPU buffer size, rewind to last path and break the batch here.
-                        context->pathCount = lastPathCount;
-                        context->eltCount = lastEltCount;
-                        context->maxSegmentCount = lastMaxSegmentCount;
-                        context->maxBinQueueCount = lastMaxBinQueueCount;
-                        context->maxTileOpCount = lastMaxTileOpCount;
-                        //TODO flush counter?
-                        break;
-                    }
-                }
+    u64 size = sizeof(oc_wgpu_canvas_glyph_entry) + eltCount * sizeof(oc_wgpu_path_elt) + key.len;
+    oc_wgpu_canvas_glyph_entry* entry = malloc(size);
+    if(!entry)
+    {
+        return (0);
+    }
+    memset(entry, 0, size);
+    entry->hash = hash;
+    entry->eltStart = cache->eltCount;
+    entry->eltCount = eltCount;
+    entry->elements = (oc_wgpu_path_elt*)(entry + 1);
+    entry->key = (oc_str8){ .ptr = (char*)(entry->elements + eltCount), .len = key.len };
+    entry->box = (oc_vec4){ FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+    memcpy(entry->key.ptr, key.ptr, key.len);
+
+    //NOTE: encode the outline like oc_wgpu_canvas_encode_element() does, without the transform
+    oc_vec2 pos = { 0 };
+    oc_wgpu_path_elt* dst = entry->elements;
+    for(u32 i = 0; i < inputCount; i++)
+    {
+        oc_path_elt* elt = &elements[i];
+        if(elt->type != OC_PATH_MOVE)
+        {
+            oc_vec2 p[4] = { pos, elt->p[0], elt->p[1], elt->p[2] };
+            int count = (elt->type == OC_PATH_CUBIC) ? 4 : ((elt->type == OC_PATH_QUADRATIC) ? 3 : 2);
+            entry->maxSegmentCount += (elt->type == OC_PATH_CUBIC) ? 7 : ((elt->type == OC_PATH_QUADRATIC) ? 3 : 1);
+
+            dst->kind = elt->type;
+            for(int pointIndex = 0; pointIndex < count; pointIndex++)
+            {
+                dst->p[pointIndex] = p[pointIndex];
+                oc_update_box_extents(&entry->box, p[pointIndex]);
             }
+            dst++;
         }
+        pos = oc_path_elt_end_point(elt);
+    }
+    entry->endPoint = pos;
 
-        int nChunkX = ((int)context->screenSize.x + OC_WGPU_CANVAS_CHUNK_SIZE - 1) / OC_WGPU_CANVAS_CHUNK_SIZE;
-        int nChunkY = ((int)context->screenSize.y + OC_WGPU_CANVAS_CHUNK_SIZE - 1) / OC_WGPU_CANVAS_CHUNK_SIZE;
-        context->chunkCount = nChunkX * nChunkY;
-        context->maxChunkEltCount = context->chunkCount * context->pathCount;
+    cache->eltCount += eltCount;
+    oc_list_push_back(&cache->buckets[hash % OC_WGPU_CANVAS_GLYPH_CACHE_BUCKET_COUNT], &entry->bucketElt);
+    oc_list_push_back(&cache->pending, &entry->listElt);
 
-        oc_wgpu_canvas_update_resources_if_needed(context);
+    return (entry);
+}
 
-        wgpuQueueWriteBuffer(renderer->queue, renderer->pathBuffer, 0, context->pathData, sizeof(oc_wgpu_path) * context->pathCount);
-        wgpuQueueWriteBuffer(renderer->queue, renderer->elementBuffer, 0, context->elementData, sizeof(oc_wgpu_path_elt) * context->eltCount);
+static oc_wgpu_canvas_glyph_entry* oc_wgpu_canvas_glyph_cache_find(oc_wgpu_canvas_encoding_context* context, oc_primitive* primitive)
+{
+    oc_path_descriptor* path = &primitive->path;
+    if(path->startIndex + path->count > context->inputEltCount)
+    {
+        return (0);
+    }
 
-        context->pathBatchStart += primitiveIndex;
+    //NOTE: the canvas pushes a glyph's elements once per frame, so its occurrences usually share their start index
+    u32 memoIndex = path->startIndex % OC_WGPU_CANVAS_GLYPH_MEMO_COUNT;
+    oc_wgpu_canvas_glyph_entry* entry = context->glyphMemo[memoIndex];
+    if(entry
+       && context->glyphMemoStart[memoIndex] == path->startIndex
+       && entry->key.len == path->count * sizeof(oc_path_elt))
+    {
+        return (entry);
+    }
 
-        oc_scratch_end(scratch);
+    oc_str8 key = {
+        .ptr = (char*)(context->inputElements + path->startIndex),
+        .len = path->count * sizeof(oc_path_elt),
+    };
+    u64 hash = oc_hash_xx64_string(key);
 
-        return (true);
-    }
-}
+    oc_wgpu_canvas_glyph_cache* cache = &context->renderer->glyphCache;
+    oc_mutex_lock(cache->mutex);
 
-void oc_wgpu_canvas_timestamp_read_callback(WGPUBufferMapAsyncStatus status, void* user)
-{
-    oc_wgpu_canvas_timestamp_read_callback_data* data = (oc_wgpu_canvas_timestamp_read_callback_data*)user;
-    oc_wgpu_canvas_renderer* renderer = data->renderer;
-    oc_wgpu_canvas_frame_counters* frameCounters = data->frameCounters;
-
-    u64 mapSize = data->mapSize;
-    const char* mappedBuffer = (const char*)wgpuBufferGetConstMappedRange(data->buffer,
-                                                                          0,
-                                                                          mapSize);
-
-    const oc_wgpu_canvas_frame_timestamps* frameTimestamps = (const oc_wgpu_canvas_frame_timestamps*)mappedBuffer;
-
-    if(frameTimestamps->frameEnd > frameTimestamps->frameBegin)
+    entry = 0;
+    oc_list_for(cache->buckets[hash % OC_WGPU_CANVAS_GLYPH_CACHE_BUCKET_COUNT], candidate, oc_wgpu_canvas_glyph_entry, bucketElt)
     {
-        frameCounters->gpuTime = (frameTimestamps->frameEnd - frameTimestamps->frameBegin) / 1000000.;
-
-        if(frameCounters->gpuTime)
+        if(candidate->hash == hash && !oc_str8_cmp(candidate->key, key))
         {
-            oc_wgpu_canvas_stats_add_sample(&renderer->gpuTime, frameCounters->gpuTime);
+            entry = candidate;
+            break;
         }
     }
+    if(!entry && !cache->full)
+    {
+        entry = oc_wgpu_canvas_glyph_cache_insert(cache, hash, key);
+    }
+    oc_mutex_unlock(cache->mutex);
 
-    wgpuBufferUnmap(data->buffer);
+    if(entry)
+    {
+        context->glyphMemo[memoIndex] = entry;
+        context->glyphMemoStart[memoIndex] = path->startIndex;
+    }
+    return (entry);
 }
 
-void oc_wgpu_canvas_submit(oc_canvas_renderer_base* rendererBase,
-                           oc_surface surfaceHandle,
-                           u32 msaaSampleCount,
-                           bool clear,
-                           oc_color clearColor,
-                           u32 primitiveCount,
-                           oc_primitive* primitives,
-                           u32 eltCount,
-                           oc_path_elt* elements)
+static bool oc_wgpu_canvas_encode_glyph(oc_wgpu_canvas_encoding_context* context, oc_primitive* primitive, oc_vec2* currentPos)
 {
-    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)rendererBase;
+    //NOTE: returns false if the glyph's outline isn't cached, in which case it's encoded like any other fill
+    oc_wgpu_canvas_glyph_entry* entry = oc_wgpu_canvas_glyph_cache_find(context, primitive);
+    if(!entry)
+    {
+        return (false);
+    }
 
-    wgpuDeviceTick(renderer->device);
+    if(entry->eltCount)
+    {
+        //NOTE: extents are computed from the outline's box, so they are conservative for rotated glyphs
+        oc_mat2x3 transform = context->attributes->transform;
+        oc_vec2 corners[4] = {
+            { entry->box.x, entry->box.y },
+            { entry->box.z, entry->box.y },
+            { entry->box.z, entry->box.w },
+            { entry->box.x, entry->box.w },
+        };
+        oc_vec4 glyphBox = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for(int i = 0; i < 4; i++)
+        {
+            oc_vec2 screenP = oc_mat2x3_mul(transform, corners[i]);
+            oc_update_box_extents(&context->pathUserExtents, corners[i]);
+            oc_update_box_extents(&context->pathScreenExtents, screenP);
+            oc_update_box_extents(&glyphBox, screenP);
+        }
 
-    WGPUTexture currentTexture = oc_wgpu_surface_get_current_texture(surfaceHandle, renderer->device);
+        //NOTE: no element of the outline covers more tiles than the whole glyph
+        int firstTileX = glyphBox.x * context->scale.x / context->tileSize;
+        int firstTileY = glyphBox.y * context->scale.y / context->tileSize;
+        int lastTileX = glyphBox.z * context->scale.x / context->tileSize;
+        int lastTileY = glyphBox.w * context->scale.y / context->tileSize;
 
-    WGPUTextureViewDescriptor desc = {
-        .format = WGPUTextureFormat_BGRA8Unorm,
-        .dimension = WGPUTextureViewDimension_2D,
-        .baseMipLevel = 0,
-        .mipLevelCount = 1,
-        .baseArrayLayer = 0,
-        .arrayLayerCount = 1,
-        .aspect = WGPUTextureAspect_All,
-    };
+        int nTilesX = lastTileX - firstTileX + 1;
+        int nTilesY = lastTileY - firstTileY + 1;
 
-    WGPUTextureView frameBuffer = wgpuTextureCreateView(currentTexture, &desc);
-    if(frameBuffer)
-    {
-        renderer->rollingBufferIndex = (renderer->rollingBufferIndex + 1) % OC_WGPU_CANVAS_ROLLING_BUFFER_COUNT;
+        context->maxSegmentCount += entry->maxSegmentCount;
+        context->maxTileOpCount += (nTilesX * nTilesY) * entry->maxSegmentCount;
 
-        if(renderer->hasTimestamps)
+        if(context->glyphInstanceCount >= context->glyphInstanceCap)
         {
-            while(wgpuBufferGetMapState(renderer->timestampsReadBuffer[renderer->rollingBufferIndex]) != WGPUBufferMapState_Unmapped)
-            {
-                wgpuDeviceTick(renderer->device);
-            }
-        }
+            u32 newCap = oc_max(OC_WGPU_CANVAS_BUFFER_DEFAULT_LEN, (u32)(context->glyphInstanceCap * 1.5));
+            oc_wgpu_glyph_instance* instances = oc_arena_push_array(context->arena, oc_wgpu_glyph_instance, newCap);
+            memcpy(instances, context->glyphInstances, context->glyphInstanceCount * sizeof(oc_wgpu_glyph_instance));
 
-        f64 submitStart = oc_clock_time(OC_CLOCK_MONOTONIC);
+            context->glyphInstances = instances;
+            context->glyphInstanceCap = newCap;
+        }
 
-        oc_vec2 scale = oc_surface_contents_scaling(surfaceHandle);
-        oc_vec2 screenSize = {
-            .x = wgpuTextureGetWidth(currentTexture),
-            .y = wgpuTextureGetHeight(currentTexture),
+        context->glyphInstances[context->glyphInstanceCount] = (oc_wgpu_glyph_instance){
+            .rows = {
+                { transform.m[0] * context->scale.x, transform.m[1] * context->scale.x, transform.m[2] * context->scale.x, 0 },
+                { transform.m[3] * context->scale.y, transform.m[4] * context->scale.y, transform.m[5] * context->scale.y, 0 },
+            },
+            .eltStart = entry->eltStart,
+            .eltCount = entry->eltCount,
+            .outStart = context->glyphEltCount,
+            .pathIndex = context->pathCount,
         };
+        context->glyphInstanceCount++;
+        context->glyphEltCount += entry->eltCount;
+    }
 
-        //TODO: move that to enum
-        i32 tileSize = 16;
-        i32 chunkSize = 256;
-        i32 nTilesX = (i32)(screenSize.x + tileSize - 1) / tileSize;
-        i32 nTilesY = (i32)(screenSize.y + tileSize - 1) / tileSize;
+    *currentPos = entry->endPoint;
+    return (true);
+}
 
-        oc_wgpu_canvas_encoding_context encodingContext = {
-            .renderer = renderer,
-            .inputPrimitiveCount = primitiveCount,
-            .inputPrimitives = primitives,
-            .inputEltCount = eltCount,
-            .inputElements = elements,
-            .screenSize = screenSize,
-            .scale = scale,
-            .tileSize = tileSize,
-            .screenTilesCount = nTilesX * nTilesY,
+static oc_vec4 oc_wgpu_canvas_clip_box(oc_wgpu_canvas_encoding_context* context)
+{
+    oc_rect clip = context->attributes->clip;
+    return ((oc_vec4){ clip.x, clip.y, clip.x + clip.w, clip.y + clip.h });
+}
+
+static void oc_wgpu_canvas_encode_clip_pop(oc_wgpu_canvas_encoding_context* context, oc_primitive* primitive)
+{
+    //NOTE: the marker closing a clip path has no elements. It has the same clip rect as the clip path, so it is culled
+    //      along with it, and covers the same tiles. The merge pass emits a clip begin op on each of these tiles, which
+    //      opens the layer that the clip path's coverage masks (see raster.wgsl).
+    context->primitive = primitive;
+    context->attributes = &context->inputAttributes[primitive->attributesIndex];
+
+    if(!oc_wgpu_canvas_box_is_visible(context, oc_wgpu_canvas_clip_box(context)))
+    {
+        return;
+    }
+
+    oc_wgpu_path* path = oc_wgpu_canvas_push_path(context);
+    if(path)
+    {
+        *path = (oc_wgpu_path){
+            .cmd = OC_CMD_CLIP_POP,
+            .textureID = -1,
+            .gradientIndex = -1,
+            .clipDepth = context->attributes->clipPathDepth,
         };
+        path->clip = oc_wgpu_canvas_path_clip(context);
+        path->box = path->clip;
 
-        if(renderer->debugDisplayOptions.pathCount)
-        {
-            i32 pathStart = oc_clamp(renderer->debugDisplayOptions.pathStart, 0, primitiveCount);
-            i32 pathCount = oc_clamp(renderer->debugDisplayOptions.pathCount,
-                                     1,
-                                     primitiveCount - pathStart);
+        int nTilesX = (int)(path->box.z / context->tileSize) - (int)(path->box.x / context->tileSize) + 1;
+        int nTilesY = (int)(path->box.w / context->tileSize) - (int)(path->box.y / context->tileSize) + 1;
+        context->maxTileOpCount += nTilesX * nTilesY;
+    }
+}
 
-            encodingContext.inputPrimitiveCount = pathCount;
-            encodingContext.inputPrimitives = primitives + pathStart;
-        }
+static void oc_wgpu_canvas_encode_primitive(oc_wgpu_canvas_encoding_context* context, oc_primitive* primitive, oc_vec2* currentPos);
 
-        //NOTE: allocate a new frame counters record
-        oc_wgpu_canvas_frame_counters* frameCounters = 0;
-        if(renderer->debugRecordOptions.maxRecordCount)
-        {
-            bool removeOld = false;
-            oc_wgpu_canvas_frame_counters* oldFrameCounters = oc_list_first_entry(renderer->debugRecords,
-                                                                                  oc_wgpu_canvas_frame_counters,
-                                                                                  listElt);
-            if(oldFrameCounters && (renderer->frameIndex - oldFrameCounters->frameIndex >= renderer->debugRecordOptions.maxRecordCount))
-            {
-                //NOTE: recycle first (oldest) record
-                oc_list_pop_front(&renderer->debugRecords);
+static bool oc_wgpu_canvas_encode_unpacked_primitive(oc_wgpu_canvas_encoding_context* context, oc_primitive* primitive, oc_vec2* currentPos)
+{
+    //NOTE: paths with polylines are unpacked into line elements, which then stand in for the input elements while the
+    //      primitive is encoded
+    if(primitive->cmd == OC_CMD_CLIP_POP
+       || !primitive->path.count
+       || primitive->path.startIndex + primitive->path.count > context->inputEltCount)
+    {
+        return (false);
+    }
+    oc_path_elt* elements = context->inputElements + primitive->path.startIndex;
+    u32 unpackedCount = oc_path_unpacked_count(primitive->path.count, elements);
+    if(!unpackedCount)
+    {
+        return (false);
+    }
 
-                for(oc_wgpu_canvas_batch_counters* batchCounters = oc_list_pop_front_entry(&oldFrameCounters->batches, oc_wgpu_canvas_batch_counters, listElt);
-                    batchCounters != 0;
-                    batchCounters = oc_list_pop_front_entry(&oldFrameCounters->batches, oc_wgpu_canvas_batch_counters, listElt))
-                {
-                    oc_list_push_front(&renderer->batchCountersFreeList, &batchCounters->listElt);
-                }
+    oc_arena_scope scratch = oc_scratch_begin_next(context->arena);
+    oc_path_elt* unpacked = oc_arena_push_array(scratch.arena, oc_path_elt, unpackedCount);
+    oc_path_unpack(primitive->path.count, elements, unpacked);
 
-                if(oldFrameCounters->gpuTime)
-                {
-                    oc_wgpu_canvas_stats_remove_sample(&renderer->gpuTime);
-                }
-                oc_wgpu_canvas_stats_remove_sample(&renderer->cpuEncodeTime);
-                oc_wgpu_canvas_stats_remove_sample(&renderer->cpuFrameTime);
+    oc_primitive unpackedPrimitive = *primitive;
+    unpackedPrimitive.path.startIndex = 0;
+    unpackedPrimitive.path.count = unpackedCount;
 
-                oc_list_push_front(&renderer->frameCountersFreeList, &oldFrameCounters->listElt);
-            }
+    oc_path_elt* inputElements = context->inputElements;
+    u32 inputEltCount = context->inputEltCount;
+    context->inputElements = unpacked;
+    context->inputEltCount = unpackedCount;
 
-            //NOTE: get new record from free list or allocate it fresh from debug arena
-            frameCounters = oc_list_pop_front_entry(&renderer->frameCountersFreeList,
-                                                    oc_wgpu_canvas_frame_counters,
-                                                    listElt);
-            if(!frameCounters)
-            {
-                frameCounters = oc_arena_push_type(&renderer->debugArena, oc_wgpu_canvas_frame_counters);
-            }
+    oc_wgpu_canvas_encode_primitive(context, &unpackedPrimitive, currentPos);
 
-            if(frameCounters)
-            {
-                memset(frameCounters, 0, sizeof(oc_wgpu_canvas_frame_counters));
+    context->inputElements = inputElements;
+    context->inputEltCount = inputEltCount;
+    context->primitive = primitive;
 
-                frameCounters->frameIndex = renderer->frameIndex;
-                frameCounters->inputPathCount = encodingContext.inputPrimitiveCount;
-                frameCounters->inputElementCount = encodingContext.inputEltCount;
+    oc_scratch_end(scratch);
+    return (true);
+}
 
-                oc_list_push_back(&renderer->debugRecords, &frameCounters->listElt);
-                renderer->debugRecordsCount++;
-            }
-            else
-            {
-                oc_log_error("Could not allocate frame counters record\n");
-            }
-        }
+static void oc_wgpu_canvas_encode_primitive(oc_wgpu_canvas_encoding_context* context, oc_primitive* primitive, oc_vec2* currentPos)
+{
+    if(primitive->attributesIndex >= context->inputAttributeCount)
+    {
+        oc_log_error("primitive attributes index out of bounds\n");
+        return;
+    }
+    if(oc_wgpu_canvas_encode_unpacked_primitive(context, primitive, currentPos))
+    {
+        return;
+    }
 
-        //TODO: move that elsewhere
-        wgpuQueueWriteBuffer(renderer->queue, renderer->tileSizeBuffer, 0, &tileSize, sizeof(i32));
-        wgpuQueueWriteBuffer(renderer->queue, renderer->chunkSizeBuffer, 0, &chunkSize, sizeof(i32));
+    if(primitive->cmd == OC_CMD_CLIP_POP)
+    {
+        oc_wgpu_canvas_encode_clip_pop(context, primitive);
+    }
+    else if(primitive->path.count)
+    {
+        context->primitive = primitive;
+        context->attributes = &context->inputAttributes[primitive->attributesIndex];
 
-        {
-            oc_wgpu_debug_display_options options = {
-                .showTileBorders = renderer->debugDisplayOptions.showTileBorders ? 1 : 0,
-                .showPathArea = renderer->debugDisplayOptions.showPathArea ? 1 : 0,
-                .showClip = renderer->debugDisplayOptions.showClip ? 1 : 0,
-                .textureOff = renderer->debugDisplayOptions.textureOff ? 1 : 0,
-                .debugTileQueues = renderer->debugDisplayOptions.debugTileQueues ? 1 : 0,
-            };
-            wgpuQueueWriteBuffer(renderer->queue,
-                                 renderer->debugDisplayOptionsBuffer,
-                                 0,
-                                 &options,
-                                 sizeof(oc_wgpu_debug_display_options));
-        }
+        //NOTE: clip paths are culled on their clip rect only, like the marker that closes them, so that both are
+        //      always encoded together
+        bool isClipPath = (primitive->cmd == OC_CMD_CLIP_PATH);
 
-        WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(renderer->device, NULL);
+        //NOTE: skip primitives that are entirely outside the visible area before encoding their elements. Fills still
+        //      move the pen to the end of their path.
+        oc_vec4 bounds = isClipPath
+                           ? oc_wgpu_canvas_clip_box(context)
+                           : oc_wgpu_canvas_primitive_bounds(context, primitive, *currentPos);
 
-        if(renderer->hasTimestamps && (renderer->debugRecordOptions.timingFlags & OC_WGPU_CANVAS_TIMING_FRAME))
+        if(!oc_wgpu_canvas_box_is_visible(context, bounds))
         {
-            wgpuCommandEncoderWriteTimestamp(encoder, renderer->timestampsQuerySet, OC_WGPU_CANVAS_TIMESTAMP_INDEX_FRAME_BEGIN);
+            oc_wgpu_canvas_primitive_end_pos(context, primitive, currentPos);
+            return;
         }
 
-        WGPUCommandBuffer command = wgpuCommandEncoderFinish(encoder, NULL);
-        wgpuQueueSubmit(renderer->queue, 1, &command);
-        wgpuCommandBufferRelease(command);
-        wgpuCommandEncoderRelease(encoder);
+        context->pathScreenExtents = (oc_vec4){ FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+        context->pathUserExtents = (oc_vec4){ FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
 
-        u32 batchCount = 0;
+        u32 eltCount = context->eltCount;
+        u32 glyphEltCount = context->glyphEltCount;
+        u32 glyphInstanceCount = context->glyphInstanceCount;
+        u32 maxSegmentCount = context->maxSegmentCount;
+        u32 maxTileOpCount = context->maxTileOpCount;
 
-        while(oc_wgpu_canvas_encode_batch(&encodingContext))
+        context->analyticRect = (primitive->cmd == OC_CMD_RECT || primitive->cmd == OC_CMD_RRECT)
+                             && oc_wgpu_canvas_rect_extents(context, primitive);
+
+        if(context->analyticRect)
+        {
+            oc_wgpu_canvas_primitive_end_pos(context, primitive, currentPos);
+        }
+        else if(primitive->cmd == OC_CMD_STROKE)
+        {
+            oc_wgpu_canvas_encode_cached_stroke(context, primitive);
+        }
+        else if(primitive->cmd == OC_CMD_GLYPH && oc_wgpu_canvas_encode_glyph(context, primitive, currentPos))
+        {
+        }
+        else
         {
-            //NOTE: allocate new batch counters
-            oc_wgpu_canvas_batch_counters* batchCounters = 0;
-            if(frameCounters)
+            for(int eltIndex = 0;
+                (eltIndex < primitive->path.count) && (primitive->path.startIndex + eltIndex < context->inputEltCount);
+                eltIndex++)
             {
-                batchCounters = oc_list_pop_front_entry(&renderer->batchCountersFreeList,
-                                                        oc_wgpu_canvas_batch_counters,
-                                                        listElt);
-                if(!batchCounters)
-                {
-                    batchCounters = oc_arena_push_type(&renderer->debugArena, oc_wgpu_canvas_batch_counters);
-                }
-                if(!batchCounters)
-                {
-                    oc_log_error("Could not allocate batch counters record\n");
-                }
+                oc_path_elt* elt = &context->inputElements[primitive->path.startIndex + eltIndex];
 
-                if(batchCounters)
+                if(elt->type != OC_PATH_MOVE)
                 {
-                    batchCounters->encodedPathCount = encodingContext.pathCount;
-                    batchCounters->encodedElementCount = encodingContext.eltCount;
-                    oc_list_push_front(&frameCounters->batches, &batchCounters->listElt);
-                }
-                else
-                {
-                    oc_log_error("Could not allocate batch counters record\n");
+                    oc_vec2 p[4] = { *currentPos, elt->p[0], elt->p[1], elt->p[2] };
+                    oc_wgpu_canvas_encode_element(context, elt->type, p);
                 }
+                *currentPos = oc_path_elt_end_point(elt);
             }
+        }
 
-            encoder = wgpuDeviceCreateCommandEncoder(renderer->device, NULL);
-
-            //----------------------------------------------------------------------------------------
-            //NOTE: reset counters
-            {
-                u32 zero = 0;
-                wgpuQueueWriteBuffer(renderer->queue, renderer->segmentCountBuffer, 0, &zero, sizeof(u32));
-                wgpuQueueWriteBuffer(renderer->queue, renderer->binQueueCountBuffer, 0, &zero, sizeof(u32));
-                wgpuQueueWriteBuffer(renderer->queue, renderer->tileOpCountBuffer, 0, &zero, sizeof(u32));
-                wgpuQueueWriteBuffer(renderer->queue, renderer->chunkEltCountBuffer, 0, &zero, sizeof(u32));
-
-                u32 dispatchInit[3] = { 0, 1, 1 };
-                wgpuQueueWriteBuffer(renderer->queue, renderer->tileQueueCountBuffer, 0, &dispatchInit, 3 * sizeof(u32));
-            }
+        //NOTE: the encoded extents are tighter than the bounds tested above, so test them again and drop the elements
+        //      of paths that turn out to be invisible
+        if(!isClipPath && !oc_wgpu_canvas_box_is_visible(context, context->pathScreenExtents))
+        {
+            context->eltCount = eltCount;
+            context->glyphEltCount = glyphEltCount;
+            context->glyphInstanceCount = glyphInstanceCount;
+            context->maxSegmentCount = maxSegmentCount;
+            context->maxTileOpCount = maxTileOpCount;
+            return;
+        }
 
-            //----------------------------------------------------------------------------------------
-            //NOTE: clear out texture if this is the first batch
-            if(batchCount == 0)
-            {
-                //clear out texture
-                WGPURenderPassDescriptor desc = {
-                    .colorAttachmentCount = 1,
-                    .colorAttachments = (WGPURenderPassColorAttachment[]){
-                        {
-                            .view = renderer->outTextureView,
-                            .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
-                            .loadOp = WGPULoadOp_Clear,
-                            .storeOp = WGPUStoreOp_Store,
-                            .clearValue = { 0, 0, 0, 0 },
-                        },
-                    },
-                };
+        oc_wgpu_canvas_encode_path(context, primitive);
+    }
+}
 
-                WGPURenderPassEncoder pass = wgpuCommandEncoderBeginRenderPass(encoder, &desc);
-                {
-                    wgpuRenderPassEncoderSetViewport(pass, 0.f, 0.f, screenSize.x, screenSize.y, 0.f, 1.f);
-                }
-                wgpuRenderPassEncoderEnd(pass);
-                wgpuRenderPassEncoderRelease(pass);
-            }
+static void oc_wgpu_canvas_run_encoding_job(oc_wgpu_canvas_encoding_job* job)
+{
+    oc_wgpu_canvas_encoding_context* context = &job->context;
+    oc_vec2 currentPos = job->startPos;
 
-            //----------------------------------------------------------------------------------------
-            //NOTE: clear batch texture
-            {
-                WGPURenderPassDescriptor desc = {
-                    .colorAttachmentCount = 1,
-                    .colorAttachments = (WGPURenderPassColorAttachment[]){
-                        {
-                            .view = renderer->batchTextureView,
-                            .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
-                            .loadOp = WGPULoadOp_Clear,
-                            .storeOp = WGPUStoreOp_Store,
-                            .clearValue = { 0, 0, 0, 0 },
-                        },
-                    },
-                };
+    job->counts = oc_arena_push_array(&job->arena, oc_wgpu_canvas_encoding_counts, job->primitiveCount);
 
-                WGPURenderPassEncoder pass = wgpuCommandEncoderBeginRenderPass(encoder, &desc);
-                {
-                    wgpuRenderPassEncoderSetViewport(pass, 0.f, 0.f, screenSize.x, screenSize.y, 0.f, 1.f);
-                }
-                wgpuRenderPassEncoderEnd(pass);
-                wgpuRenderPassEncoderRelease(pass);
-            }
+    for(u32 i = 0; i < job->primitiveCount; i++)
+    {
+        u32 batchIndex = job->primitiveStart + i;
+        oc_primitive* primitive = &context->inputPrimitives[context->pathBatchStart + batchIndex];
+
+        context->currentImageIndex = job->imageIndices[batchIndex];
+        oc_wgpu_canvas_encode_primitive(context, primitive, &currentPos);
+
+        job->counts[i] = (oc_wgpu_canvas_encoding_counts){
+            .pathCount = context->pathCount,
+            .eltCount = context->eltCount,
+            .glyphEltCount = context->glyphEltCount,
+            .glyphInstanceCount = context->glyphInstanceCount,
+            .gradientCount = context->gradientCount,
+            .maxSegmentCount = context->maxSegmentCount,
+            .maxBinQueueCount = context->maxBinQueueCount,
+            .maxTileOpCount = context->maxTileOpCount,
+        };
+    }
+}
 
-            /*NOTE(martin): On dispatch limits.
+static void oc_wgpu_canvas_encoding_pool_drain(oc_wgpu_canvas_encoding_pool* pool)
+{
+    //NOTE: take jobs until there are none left. Called with the pool mutex held.
+    while(pool->nextJob < pool->jobCount)
+    {
+        oc_wgpu_canvas_encoding_job* job = &pool->jobs[pool->nextJob];
+        pool->nextJob++;
 
-                There are several limits to how many invocations and workgroups can be dispatched in one call.
-                (see https://www.w3.org/TR/webgpu/#limits)
+        oc_mutex_unlock(pool->mutex);
+        oc_wgpu_canvas_run_encoding_job(job);
+        oc_mutex_lock(pool->mutex);
 
-                - The requires minimum for maxComputeWorkgroupSizeX and maxComputeWorkgroupSizeY is 256.
-                - The required minimum for maxComputeInvocationsPerWorkgroup is 256
-                - The required minimum for maxComputeWorkgroupsPerDimension is 65535 = 2^16
+        pool->pendingCount--;
+        if(pool->pendingCount == 0)
+        {
+            oc_condition_signal(pool->doneCondition);
+        }
+    }
+}
 
-                So, we use 16*16 workgroup sizes. Limits impact each pass as follows:
+static i32 oc_wgpu_canvas_encoding_worker(void* user)
+{
+    oc_wgpu_canvas_encoding_pool* pool = (oc_wgpu_canvas_encoding_pool*)user;
 
-                * Path setup: we use one invocation per path, in 16*16 workgroup sizes, and distribute
-                  workgroups on both axes. This gives a minimum limit of 2^40 paths per dispatch.
+    oc_mutex_lock(pool->mutex);
+    while(!pool->quit)
+    {
+        oc_wgpu_canvas_encoding_pool_drain(pool);
+        if(!pool->quit)
+        {
+            oc_condition_wait(pool->workCondition, pool->mutex);
+        }
+    }
+    oc_mutex_unlock(pool->mutex);
+    return (0);
+}
 
-                * Segment setup: we use one invocation per element, in 16*16 workgroup sizes, and distribute
-                  workgroups on both axes. This gives a minimum limit of 2^40 elements per dispatch.
+static void oc_wgpu_canvas_encoding_pool_init(oc_wgpu_canvas_encoding_pool* pool)
+{
+    memset(pool, 0, sizeof(oc_wgpu_canvas_encoding_pool));
+    pool->mutex = oc_mutex_create();
+    pool->workCondition = oc_condition_create();
+    pool->doneCondition = oc_condition_create();
 
-                * Backprop pass: we use one workgroup of 16*1 invocations per path, and distribute workgroups on both axes.
-                  This gives a minimum limit of 2^32 paths per dispatch.
+    for(int i = 0; i < OC_WGPU_CANVAS_ENCODING_JOB_COUNT; i++)
+    {
+        oc_arena_init(&pool->jobs[i].arena);
+    }
 
-                * Merge pass: we use one workgroup of 1*1 invocations per screen tile, which gives a minimum limit of 2^16
-                  tiles (= 2^20 pixels) on each axis.
+    for(int i = 0; i < OC_WGPU_CANVAS_ENCODING_WORKER_COUNT; i++)
+    {
+        oc_thread_options threadOptions = {
+            .name = OC_STR8("canvas encoder"),
+            .priority = OC_THREAD_PRIORITY_HIGH,
+        };
+        pool->threads[i] = oc_thread_create_with_options(oc_wgpu_canvas_encoding_worker, pool, &threadOptions);
+        if(!pool->threads[i])
+        {
+            oc_log_warning("couldn't create canvas encoding thread\n");
+            break;
+        }
+        pool->threadCount++;
+    }
+}
 
-                * Raster pass: we use one invocation per pixel, in 16*16 workgroups (ie, one workgroup per tile). The total
-                  number of workgroups is distributed on each axis in the balance_workgroups pass, which sets the indirect
-                  dispatch buffer for the raster pass. This gives, a max of 2^32 tiles total.
+static void oc_wgpu_canvas_encoding_pool_cleanup(oc_wgpu_canvas_encoding_pool* pool)
+{
+    oc_mutex_lock(pool->mutex);
+    pool->quit = true;
+    oc_condition_broadcast(pool->workCondition);
+    oc_mutex_unlock(pool->mutex);
 
-                  The first three limits are higher than the number of paths/elements we can index with an u32, while the
-                  last two are sufficient to completely cover a 10k screen, so we don't bother doing multiple dispatch passes.
-            */
-            //----------------------------------------------------------------------------------------
-            //NOTE: path setup pass
-            {
-                u32 invocationsPerWorkGroup = 16 * 16;
-                wgpuQueueWriteBuffer(renderer->queue, renderer->pathCountBuffer, 0, &encodingContext.pathCount, sizeof(u32));
+    for(int i = 0; i < pool->threadCount; i++)
+    {
+        oc_thread_join(pool->threads[i], 0);
+    }
+    for(int i = 0; i < OC_WGPU_CANVAS_ENCODING_JOB_COUNT; i++)
+    {
+        oc_arena_cleanup(&pool->jobs[i].arena);
+    }
+    oc_condition_destroy(pool->doneCondition);
+    oc_condition_destroy(pool->workCondition);
+    oc_mutex_destroy(pool->mutex);
+}
 
-                WGPUComputePassDescriptor desc = {
-                    .label = "path setup",
-                };
+static void oc_wgpu_canvas_encoding_pool_run(oc_wgpu_canvas_encoding_pool* pool, u32 jobCount)
+{
+    //NOTE: the submitting thread takes jobs too, then waits for the workers to finish theirs
+    oc_mutex_lock(pool->mutex);
 
-                WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, &desc);
-                {
-                    wgpuComputePassEncoderSetPipeline(pass, renderer->pathSetupPipeline);
-                    wgpuComputePassEncoderSetBindGroup(pass, 0, renderer->pathSetupBindGroup, 0, NULL);
+    pool->jobCount = jobCount;
+    pool->nextJob = 0;
+    pool->pendingCount = jobCount;
 
-                    u32 totalWorkGroupCount = (encodingContext.pathCount + invocationsPerWorkGroup - 1) / invocationsPerWorkGroup;
-                    u32 workGroupCountX = oc_min(totalWorkGroupCount, renderer->limits.maxComputeWorkgroupsPerDimension);
-                    u32 workGroupCountY = (totalWorkGroupCount + renderer->limits.maxComputeWorkgroupsPerDimension - 1)
-                                        / renderer->limits.maxComputeWorkgroupsPerDimension;
+    if(jobCount > 1)
+    {
+        oc_condition_broadcast(pool->workCondition);
+    }
+    oc_wgpu_canvas_encoding_pool_drain(pool);
 
-                    wgpuComputePassEncoderDispatchWorkgroups(pass, workGroupCountX, workGroupCountY, 1);
-                }
-                wgpuComputePassEncoderEnd(pass);
-                wgpuComputePassEncoderRelease(pass);
-            }
+    while(pool->pendingCount)
+    {
+        oc_condition_wait(pool->doneCondition, pool->mutex);
+    }
+    oc_mutex_unlock(pool->mutex);
+}
 
-            //----------------------------------------------------------------------------------------
-            //NOTE: segment setup pass
-            {
-                u32 invocationsPerWorkGroup = 16 * 16;
+//------------------------------------------------------------------------------------------------
+// Geometry staging ring
+//------------------------------------------------------------------------------------------------
 
-                wgpuQueueWriteBuffer(renderer->queue, renderer->elementCountBuffer, 0, &encodingContext.eltCount, sizeof(u32));
+static void oc_wgpu_canvas_staging_map_callback(WGPUBufferMapAsyncStatus status, void* user)
+{
+    oc_wgpu_canvas_staging_slot* slot = (oc_wgpu_canvas_staging_slot*)user;
 
-                WGPUComputePassDescriptor desc = {
-                    .label = "segment setup",
-                };
+    //NOTE: if the buffer was replaced while it was being mapped, the map is aborted and the slot is left alone
+    if(status == WGPUBufferMapAsyncStatus_Success)
+    {
+        slot->mappedPtr = (u8*)wgpuBufferGetMappedRange(slot->buffer, 0, slot->size);
+        slot->offset = 0;
+    }
+}
 
-                WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, &desc);
-                {
-                    wgpuComputePassEncoderSetPipeline(pass, renderer->segmentSetupPipeline);
-                    wgpuComputePassEncoderSetBindGroup(pass, 0, renderer->segmentSetupBindGroup, 0, NULL);
+static oc_wgpu_canvas_staging_alloc oc_wgpu_canvas_staging_reserve(oc_wgpu_canvas_renderer* renderer, u64 size)
+{
+    oc_wgpu_canvas_staging_ring* ring = &renderer->stagingRing;
+    oc_wgpu_canvas_staging_alloc alloc = { 0 };
 
-                    u32 workGroupCountX = (encodingContext.eltCount + invocationsPerWorkGroup - 1)
-                                        / invocationsPerWorkGroup;
+    //NOTE: copy sizes and offsets must be multiples of 4
+    size = oc_align_up_pow2(size, 4);
 
-                    wgpuComputePassEncoderDispatchWorkgroups(pass, workGroupCountX, 1, 1);
-                }
-                wgpuComputePassEncoderEnd(pass);
-                wgpuComputePassEncoderRelease(pass);
+    oc_wgpu_canvas_staging_slot* slot = ring->current;
+    if(!slot || !slot->mappedPtr || slot->offset + size > slot->size)
+    {
+        slot = 0;
+        for(int i = 0; i < OC_WGPU_CANVAS_STAGING_BUFFER_COUNT; i++)
+        {
+            oc_wgpu_canvas_staging_slot* candidate = &ring->slots[i];
+            if(!candidate->used && candidate->mappedPtr && candidate->offset + size <= candidate->size)
+            {
+                slot = candidate;
+                break;
             }
+        }
+    }
 
-            //----------------------------------------------------------------------------------------
-            //NOTE: backprop pass
+    if(!slot)
+    {
+        //NOTE: replace a buffer that isn't used by this frame, preferring empty slots, then buffers that are mapped
+        //      (but too small), then buffers still in use by the GPU, which are kept alive until it's done with them.
+        i32 bestRank = 3;
+        for(int i = 0; i < OC_WGPU_CANVAS_STAGING_BUFFER_COUNT; i++)
+        {
+            oc_wgpu_canvas_staging_slot* candidate = &ring->slots[i];
+            if(!candidate->used)
             {
-                WGPUComputePassDescriptor desc = {
-                    .label = "backprop",
-                };
-
-                WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, &desc);
+                i32 rank = !candidate->buffer ? 0 : (candidate->mappedPtr ? 1 : 2);
+                if(rank < bestRank)
                 {
-                    wgpuComputePassEncoderSetPipeline(pass, renderer->backpropPipeline);
-                    wgpuComputePassEncoderSetBindGroup(pass, 0, renderer->backpropBindGroup, 0, NULL);
-
-                    u32 workGroupCountX = oc_min(encodingContext.pathCount, renderer->limits.maxComputeWorkgroupsPerDimension);
-                    u32 workGroupCountY = (encodingContext.pathCount + renderer->limits.maxComputeWorkgroupsPerDimension - 1)
-                                        / renderer->limits.maxComputeWorkgroupsPerDimension;
-
-                    wgpuComputePassEncoderDispatchWorkgroups(pass, workGroupCountX, workGroupCountY, 1);
+                    slot = candidate;
+                    bestRank = rank;
                 }
-                wgpuComputePassEncoderEnd(pass);
-                wgpuComputePassEncoderRelease(pass);
             }
+        }
+        if(!slot)
+        {
+            oc_log_error("all geometry staging buffers are in use by the current frame\n");
+            return (alloc);
+        }
 
-            //----------------------------------------------------------------------------------------
-            //NOTE: chunk pass
-            {
-                WGPUComputePassDescriptor desc = {
-                    .label = "chunk",
-                };
+        if(slot->buffer)
+        {
+            renderer->bufferUsage[OC_WGPU_CANVAS_BUFFER_STAGING].size -= slot->size;
+            oc_canvas_renderer_track_memory(&renderer->base, OC_CANVAS_MEMORY_STAGING, -(i64)slot->size);
+            wgpuBufferRelease(slot->buffer);
+        }
 
-                WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, &desc);
-                {
-                    wgpuComputePassEncoderSetPipeline(pass, renderer->chunkPipeline);
-                    wgpuComputePassEncoderSetBindGroup(pass, 0, renderer->chunkBindGroup, 0, NULL);
+        //NOTE: size new buffers so that a frame like the last one, or twice what this frame staged so far, fits in one
+        u64 newSize = oc_max(oc_max(size, OC_WGPU_CANVAS_STAGING_BUFFER_MIN_SIZE),
+                             oc_max(ring->lastFrameBytes, 2 * ring->frameBytes));
+        newSize = oc_clamp_high(oc_align_up_pow2(newSize, 4), oc_max(size, renderer->limits.maxBufferSize));
 
-                    u32 workGroupCountX = (screenSize.x + OC_WGPU_CANVAS_CHUNK_SIZE - 1) / OC_WGPU_CANVAS_CHUNK_SIZE;
-                    u32 workGroupCountY = (screenSize.y + OC_WGPU_CANVAS_CHUNK_SIZE - 1) / OC_WGPU_CANVAS_CHUNK_SIZE;
+        WGPUBufferDescriptor desc = {
+            .label = "geometry staging",
+            .usage = WGPUBufferUsage_MapWrite | WGPUBufferUsage_CopySrc,
+            .size = newSize,
+            .mappedAtCreation = true,
+        };
+        slot->buffer = wgpuDeviceCreateBuffer(renderer->device, &desc);
+        slot->size = slot->buffer ? newSize : 0;
+        slot->offset = 0;
+        slot->mappedPtr = slot->buffer ? (u8*)wgpuBufferGetMappedRange(slot->buffer, 0, newSize) : 0;
 
-                    wgpuComputePassEncoderDispatchWorkgroups(pass, workGroupCountX, workGroupCountY, 1);
-                }
-                wgpuComputePassEncoderEnd(pass);
-                wgpuComputePassEncoderRelease(pass);
-            }
+        renderer->bufferUsage[OC_WGPU_CANVAS_BUFFER_STAGING].size += slot->size;
+        oc_canvas_renderer_track_memory(&renderer->base, OC_CANVAS_MEMORY_STAGING, slot->size);
 
-            //----------------------------------------------------------------------------------------
-            //NOTE: tile merge pass
-            {
-                WGPUComputePassDescriptor desc = {
-                    .label = "tile merge",
-                };
+        if(!slot->mappedPtr)
+        {
+            oc_log_error("couldn't create a geometry staging buffer of %llu bytes\n", (unsigned long long)newSize);
+            return (alloc);
+        }
+    }
 
-                WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, &desc);
-                {
-                    wgpuComputePassEncoderSetPipeline(pass, renderer->mergePipeline);
-                    wgpuComputePassEncoderSetBindGroup(pass, 0, renderer->mergeBindGroup, 0, NULL);
+    alloc = (oc_wgpu_canvas_staging_alloc){
+        .buffer = slot->buffer,
+        .offset = slot->offset,
+        .ptr = slot->mappedPtr + slot->offset,
+    };
 
-                    u32 workGroupCountX = nTilesX;
-                    u32 workGroupCountY = nTilesY;
-                    wgpuComputePassEncoderDispatchWorkgroups(pass, workGroupCountX, workGroupCountY, 1);
-                }
-                wgpuComputePassEncoderEnd(pass);
-                wgpuComputePassEncoderRelease(pass);
-            }
+    slot->used = true;
+    slot->offset += size;
+    ring->current = slot;
+    ring->frameBytes += size;
 
-            //----------------------------------------------------------------------------------------
-            //NOTE: balance workgroups for raster dispatch indirect command
-            {
-                WGPUComputePassDescriptor desc = {
-                    .label = "balance workgroups",
-                };
+    return (alloc);
+}
 
-                WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, &desc);
-                {
-                    wgpuComputePassEncoderSetPipeline(pass, renderer->balancePipeline);
-                    wgpuComputePassEncoderSetBindGroup(pass, 0, renderer->balanceBindGroup, 0, NULL);
-                    wgpuComputePassEncoderDispatchWorkgroups(pass, 1, 1, 1);
-                }
-                wgpuComputePassEncoderEnd(pass);
-                wgpuComputePassEncoderRelease(pass);
+static void oc_wgpu_canvas_staging_copy(WGPUCommandEncoder encoder, oc_wgpu_canvas_staging_alloc* alloc, WGPUBuffer dst, u64 size)
+{
+    if(alloc->ptr && size)
+    {
+        wgpuCommandEncoderCopyBufferToBuffer(encoder, alloc->buffer, alloc->offset, dst, 0, oc_align_up_pow2(size, 4));
+    }
+}
+
+//NOTE: stages data and copies it to the start of dst, in encoder order
+static void oc_wgpu_canvas_upload(oc_wgpu_canvas_renderer* renderer,
+                                  WGPUCommandEncoder encoder,
+                                  WGPUBuffer dst,
+                                  const void* data,
+                                  u32 size)
+{
+    oc_wgpu_canvas_staging_alloc alloc = oc_wgpu_canvas_staging_reserve(renderer, size);
+    if(alloc.ptr)
+    {
+        memcpy(alloc.ptr, data, size);
+        oc_wgpu_canvas_staging_copy(encoder, &alloc, dst, size);
+    }
+}
+
+//NOTE: unmaps the buffers written by the current frame, before it is submitted
+static void oc_wgpu_canvas_staging_ring_unmap(oc_wgpu_canvas_renderer* renderer)
+{
+    oc_wgpu_canvas_staging_ring* ring = &renderer->stagingRing;
+    for(int i = 0; i < OC_WGPU_CANVAS_STAGING_BUFFER_COUNT; i++)
+    {
+        oc_wgpu_canvas_staging_slot* slot = &ring->slots[i];
+        if(slot->used)
+        {
+            wgpuBufferUnmap(slot->buffer);
+            slot->mappedPtr = 0;
+        }
+    }
+}
+
+//NOTE: maps the buffers written by the current frame again, once it is submitted
+static void oc_wgpu_canvas_staging_ring_remap(oc_wgpu_canvas_renderer* renderer)
+{
+    oc_wgpu_canvas_staging_ring* ring = &renderer->stagingRing;
+    for(int i = 0; i < OC_WGPU_CANVAS_STAGING_BUFFER_COUNT; i++)
+    {
+        oc_wgpu_canvas_staging_slot* slot = &ring->slots[i];
+        if(slot->used)
+        {
+            slot->used = false;
+            wgpuBufferMapAsync(slot->buffer,
+                               WGPUMapMode_Write,
+                               0,
+                               slot->size,
+                               oc_wgpu_canvas_staging_map_callback,
+                               slot);
+        }
+    }
+    ring->current = 0;
+    ring->lastFrameBytes = ring->frameBytes;
+    ring->frameBytes = 0;
+}
+
+static bool oc_wgpu_canvas_counts_exceed_limits(oc_wgpu_canvas_encoding_context* context, oc_wgpu_canvas_encoding_counts* counts)
+{
+    oc_wgpu_canvas_renderer* renderer = context->renderer;
+
+    u64 bufferLimit = oc_min(renderer->limits.maxBufferSize, renderer->limits.maxStorageBufferBindingSize);
+    u64 maxTileQueues = oc_min(counts->maxBinQueueCount, context->screenTilesCount);
+
+    return (counts->pathCount * sizeof(oc_wgpu_path) >= bufferLimit
+            || ((u64)counts->eltCount + counts->glyphEltCount) * sizeof(oc_wgpu_path_elt) >= bufferLimit
+            || counts->glyphInstanceCount * sizeof(oc_wgpu_glyph_instance) >= bufferLimit
+            || counts->gradientCount * sizeof(oc_wgpu_gradient) >= bufferLimit
+            || counts->maxSegmentCount * sizeof(oc_wgpu_segment) >= bufferLimit
+            || counts->pathCount * sizeof(oc_wgpu_path_bin) >= bufferLimit
+            || counts->maxBinQueueCount * sizeof(oc_wgpu_bin_queue) >= bufferLimit
+            || maxTileQueues * sizeof(oc_wgpu_tile_queue) >= bufferLimit
+            || counts->maxTileOpCount * sizeof(oc_wgpu_tile_op) >= bufferLimit);
+}
+
+static void oc_wgpu_canvas_glyph_cache_upload(oc_wgpu_canvas_encoding_context* context)
+{
+    //NOTE: copy the outlines cached while encoding the batch to the glyph outlines buffer, ahead of the batch's passes.
+    //      Outlines that can't be staged stay pending and are retried with the next batch.
+    oc_wgpu_canvas_renderer* renderer = context->renderer;
+    oc_wgpu_canvas_glyph_cache* cache = &renderer->glyphCache;
+
+    oc_list_for_safe(cache->pending, entry, oc_wgpu_canvas_glyph_entry, listElt)
+    {
+        u64 size = entry->eltCount * sizeof(oc_wgpu_path_elt);
+        if(size)
+        {
+            oc_wgpu_canvas_staging_alloc alloc = oc_wgpu_canvas_staging_reserve(renderer, size);
+            if(!alloc.ptr)
+            {
+                break;
             }
+            memcpy(alloc.ptr, entry->elements, size);
+            wgpuCommandEncoderCopyBufferToBuffer(context->encoder,
+                                                 alloc.buffer,
+                                                 alloc.offset,
+                                                 cache->buffer,
+                                                 entry->eltStart * sizeof(oc_wgpu_path_elt),
+                                                 size);
+        }
+        oc_list_remove(&cache->pending, &entry->listElt);
+        oc_list_push_back(&cache->entries, &entry->listElt);
+    }
+}
+
+bool oc_wgpu_canvas_encode_batch(oc_wgpu_canvas_encoding_context* context)
+{
+    if(context->pathBatchStart >= context->inputPrimitiveCount)
+    {
+        oc_wgpu_canvas_update_resources_if_needed(context);
+        return (false);
+    }
+    else
+    {
+        oc_wgpu_canvas_renderer* renderer = context->renderer;
+
+        //convert primitives to wgpu_paths
+        oc_arena_scope scratch = oc_scratch_begin();
+        context->arena = scratch.arena;
+
+        context->pathData = 0;
+        context->pathCap = 0;
+        context->pathCount = 0;
+
+        context->elementData = 0;
+        context->eltCap = 0;
+        context->eltCount = 0;
+
+        context->glyphInstances = 0;
+        context->glyphInstanceCap = 0;
+        context->glyphInstanceCount = 0;
+        context->glyphEltCount = 0;
 
-            //----------------------------------------------------------------------------------------
-            //NOTE: raster pass
+        context->gradients = 0;
+        context->gradientCap = 0;
+        context->gradientCount = 0;
+        context->gradientAttributes = 0;
+
+        context->tileUses = 0;
+        context->tileUseCap = 0;
+        context->tileUseCount = 0;
+
+        context->maxSegmentCount = 0;
+        context->maxBinQueueCount = 0;
+        context->maxTileOpCount = 0;
+
+        context->imageCount = 0;
+        context->currentImageIndex = -1;
+
+        context->rasterFeatures = context->rasterDebug ? OC_WGPU_CANVAS_RASTER_DEBUG : 0;
+
+        //NOTE: assign image bindings and find the end of the batch
+        u32 remainingCount = context->inputPrimitiveCount - context->pathBatchStart;
+        i32* imageIndices = oc_arena_push_array(scratch.arena, i32, remainingCount);
+
+        u32 primitiveCount = 0;
+        for(; primitiveCount < remainingCount; primitiveCount++)
+        {
+            oc_primitive* primitive = &context->inputPrimitives[context->pathBatchStart + primitiveCount];
+            i32 imageIndex = -1;
+
+            if(primitive->attributesIndex < context->inputAttributeCount)
             {
-                msaaSampleCount = oc_clamp(msaaSampleCount, 0, OC_WGPU_CANVAS_MAX_SAMPLE_COUNT);
-                if(msaaSampleCount == 0)
+                oc_image image = context->inputAttributes[primitive->attributesIndex].image;
+                oc_wgpu_image* wgpuImage = (oc_wgpu_image*)oc_image_from_handle(image);
+                if(wgpuImage && wgpuImage->tiled)
                 {
-                    msaaSampleCount = OC_WGPU_CANVAS_DEFAULT_SAMPLE_COUNT;
+                    imageIndex = OC_WGPU_CANVAS_TILED_TEXTURE_ID;
                 }
-
-                if(renderer->msaaSampleCount != msaaSampleCount)
+                else if(wgpuImage && wgpuImage->arrayLayer >= 0)
+                {
+                    imageIndex = OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS + wgpuImage->arrayLayer;
+                }
+                else if(image.h != 0)
                 {
-                    renderer->msaaSampleCount = msaaSampleCount;
+                    for(int i = 0; i < context->imageCount; i++)
+                    {
+                        if(context->imageBindings[i].h == image.h)
+                        {
+                            imageIndex = i;
+                        }
+                    }
+                    if(imageIndex < 0)
+                    {
+                        if(context->imageCount < OC_WGPU_CANVAS_MAX_IMAGE_BINDINGS)
+                        {
+                            context->imageBindings[context->imageCount] = image;
+                            imageIndex = context->imageCount;
+                            context->imageCount++;
+                        }
+                        else
+                        {
+                            break;
+                        }
+                    }
+                }
+            }
+            imageIndices[primitiveCount] = imageIndex;
+        }
 
-                    u32 sampleOffsetsIndex = OC_WGPU_CANVAS_OFFSETS_LOOKUP[msaaSampleCount - 1];
-                    oc_vec2* offsets = OC_WGPU_CANVAS_OFFSETS[sampleOffsetsIndex];
+        //NOTE: split the batch into contiguous ranges of primitives, which are encoded in parallel into per-job buffers
+        oc_wgpu_canvas_encoding_pool* pool = &renderer->encodingPool;
 
-                    wgpuQueueWriteBuffer(renderer->queue, renderer->msaaOffsetsBuffer, 0, offsets, OC_WGPU_CANVAS_MAX_SAMPLE_COUNT * sizeof(oc_vec2));
-                    wgpuQueueWriteBuffer(renderer->queue, renderer->msaaSampleCountBuffer, 0, &renderer->msaaSampleCount, sizeof(u32));
-                }
+        u32 jobCount = oc_clamp(primitiveCount / OC_WGPU_CANVAS_ENCODING_MIN_JOB_PRIMITIVES, 1, OC_WGPU_CANVAS_ENCODING_JOB_COUNT);
+        u32 jobSize = (primitiveCount + jobCount - 1) / jobCount;
 
-                //TODO: remove?
-                wgpuQueueWriteBuffer(renderer->queue, renderer->pathCountBuffer, 0, &encodingContext.pathCount, sizeof(u32));
+        for(int jobIndex = 0; jobIndex < jobCount; jobIndex++)
+        {
+            oc_wgpu_canvas_encoding_job* job = &pool->jobs[jobIndex];
+            oc_arena_clear(&job->arena);
 
-                WGPUComputePassDescriptor desc = {
-                    .label = "raster",
-                };
+            job->context = *context;
+            job->context.arena = &job->arena;
 
-                WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, &desc);
-                {
-                    wgpuComputePassEncoderSetPipeline(pass, renderer->rasterPipeline);
-                    wgpuComputePassEncoderSetBindGroup(pass, 0, renderer->rasterBindGroup, 0, NULL);
-                    wgpuComputePassEncoderSetBindGroup(pass, 1, renderer->srcTexturesBindGroup, 0, NULL);
+            job->primitiveStart = jobIndex * jobSize;
+            job->primitiveCount = oc_min(jobSize, primitiveCount - job->primitiveStart);
+            job->imageIndices = imageIndices;
 
-                    wgpuComputePassEncoderDispatchWorkgroupsIndirect(pass, renderer->tileQueueCountBuffer, 0);
+            //NOTE: fills start at the pen position left by the previous fill in the batch
+            job->startPos = (oc_vec2){ 0, 0 };
+            for(i32 i = (i32)job->primitiveStart - 1; i >= 0; i--)
+            {
+                oc_primitive* primitive = &context->inputPrimitives[context->pathBatchStart + i];
+                if(oc_wgpu_canvas_primitive_end_pos(context, primitive, &job->startPos))
+                {
+                    break;
                 }
-                wgpuComputePassEncoderEnd(pass);
-                wgpuComputePassEncoderRelease(pass);
             }
+        }
+
+        oc_wgpu_canvas_encoding_pool_run(pool, jobCount);
+
+        //NOTE: merge job outputs in order. If the batch overflows max GPU buffer size, cut it before the first
+        //      primitive that doesn't fit.
+        oc_wgpu_canvas_encoding_counts total = { 0 };
+        u32 mergedJobCount = 0;
+        int primitiveIndex = 0;
+
+        for(int jobIndex = 0; jobIndex < jobCount; jobIndex++)
+        {
+            oc_wgpu_canvas_encoding_job* job = &pool->jobs[jobIndex];
+            job->kept = (oc_wgpu_canvas_encoding_counts){ 0 };
+            mergedJobCount++;
 
-            //----------------------------------------------------------------------------------------
-            //NOTE: blit pass
+            bool overflow = false;
+            for(int i = 0; i < job->primitiveCount; i++)
             {
-                WGPURenderPassDescriptor desc = {
-                    .label = "blit",
-                    .colorAttachmentCount = 1,
-                    .colorAttachments = (WGPURenderPassColorAttachment[]){
-                        {
-                            .view = renderer->outTextureView,
-                            .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
-                            .loadOp = WGPULoadOp_Load,
-                            .storeOp = WGPUStoreOp_Store,
-                        },
-                    },
+                oc_wgpu_canvas_encoding_counts counts = {
+                    .pathCount = total.pathCount + job->counts[i].pathCount,
+                    .eltCount = total.eltCount + job->counts[i].eltCount,
+                    .glyphEltCount = total.glyphEltCount + job->counts[i].glyphEltCount,
+                    .glyphInstanceCount = total.glyphInstanceCount + job->counts[i].glyphInstanceCount,
+                    .gradientCount = total.gradientCount + job->counts[i].gradientCount,
+                    .maxSegmentCount = total.maxSegmentCount + job->counts[i].maxSegmentCount,
+                    .maxBinQueueCount = total.maxBinQueueCount + job->counts[i].maxBinQueueCount,
+                    .maxTileOpCount = total.maxTileOpCount + job->counts[i].maxTileOpCount,
                 };
-
-                WGPURenderPassEncoder pass = wgpuCommandEncoderBeginRenderPass(encoder, &desc);
+                if(oc_wgpu_canvas_counts_exceed_limits(context, &counts))
                 {
-                    wgpuRenderPassEncoderSetViewport(pass, 0.f, 0.f, screenSize.x, screenSize.y, 0.f, 1.f);
-                    wgpuRenderPassEncoderSetPipeline(pass, renderer->blitPipeline);
-                    wgpuRenderPassEncoderSetBindGroup(pass, 0, renderer->blitBindGroup, 0, NULL);
-
-                    wgpuRenderPassEncoderDraw(pass, 4, 1, 0, 0);
+                    //TODO flush counter?
+                    overflow = true;
+                    break;
                 }
-                wgpuRenderPassEncoderEnd(pass);
-                wgpuRenderPassEncoderRelease(pass);
+                job->kept = job->counts[i];
+                primitiveIndex++;
             }
 
-            // submit to queue
-            WGPUCommandBuffer command = wgpuCommandEncoderFinish(encoder, NULL);
-            wgpuQueueSubmit(renderer->queue, 1, &command);
-            wgpuCommandBufferRelease(command);
-            wgpuCommandEncoderRelease(encoder);
+            total.pathCount += job->kept.pathCount;
+            total.eltCount += job->kept.eltCount;
+            total.glyphEltCount += job->kept.glyphEltCount;
+            total.glyphInstanceCount += job->kept.glyphInstanceCount;
+            total.gradientCount += job->kept.gradientCount;
+            total.maxSegmentCount += job->kept.maxSegmentCount;
+            total.maxBinQueueCount += job->kept.maxBinQueueCount;
+            total.maxTileOpCount += job->kept.maxTileOpCount;
 
-            batchCount++;
+            if(overflow)
+            {
+                break;
+            }
         }
 
-        encoder = wgpuDeviceCreateCommandEncoder(renderer->device, NULL);
-
-        //----------------------------------------------------------------------------------------
-        //NOTE: final blit pass
+        //NOTE: mark the tiles sampled by the batch as used, and the missing ones as needed. Uses of primitives cut
+        //      from an overflowing batch are counted too, they're encoded again in the next batch anyway.
+        for(int jobIndex = 0; jobIndex < mergedJobCount; jobIndex++)
+        {
+            oc_wgpu_canvas_encoding_job* job = &pool->jobs[jobIndex];
+            for(u32 useIndex = 0; useIndex < job->context.tileUseCount; useIndex++)
+            {
+                oc_wgpu_tiled_image_use(renderer, &job->context.tileUses[useIndex]);
+            }
+        }
 
-        WGPULoadOp loadOp = clear ? WGPULoadOp_Clear : WGPULoadOp_Load;
+        //NOTE: job outputs are merged straight into staging memory
+        oc_wgpu_canvas_staging_alloc pathStaging = { 0 };
+        oc_wgpu_canvas_staging_alloc eltStaging = { 0 };
+        oc_wgpu_canvas_staging_alloc glyphInstanceStaging = { 0 };
+        oc_wgpu_canvas_staging_alloc gradientStaging = { 0 };
+        if(total.pathCount)
+        {
+            pathStaging = oc_wgpu_canvas_staging_reserve(renderer, sizeof(oc_wgpu_path) * total.pathCount);
+        }
+        if(total.eltCount)
+        {
+            eltStaging = oc_wgpu_canvas_staging_reserve(renderer, sizeof(oc_wgpu_path_elt) * total.eltCount);
+        }
+        if(total.glyphInstanceCount)
+        {
+            glyphInstanceStaging = oc_wgpu_canvas_staging_reserve(renderer, sizeof(oc_wgpu_glyph_instance) * total.glyphInstanceCount);
+        }
+        if(total.gradientCount)
+        {
+            gradientStaging = oc_wgpu_canvas_staging_reserve(renderer, sizeof(oc_wgpu_gradient) * total.gradientCount);
+        }
 
-        if(clear || batchCount)
+        context->pathCount = total.pathCount;
+        context->pathCap = total.pathCount;
+        context->pathData = pathStaging.ptr
+                              ? (oc_wgpu_path*)pathStaging.ptr
+                              : oc_arena_push_array(scratch.arena, oc_wgpu_path, total.pathCount);
+
+        context->eltCount = total.eltCount;
+        context->eltCap = total.eltCount;
+        context->elementData = eltStaging.ptr
+                                 ? (oc_wgpu_path_elt*)eltStaging.ptr
+                                 : oc_arena_push_array(scratch.arena, oc_wgpu_path_elt, total.eltCount);
+
+        context->glyphEltCount = total.glyphEltCount;
+        context->glyphInstanceCount = total.glyphInstanceCount;
+        context->glyphInstanceCap = total.glyphInstanceCount;
+        context->glyphInstances = glyphInstanceStaging.ptr
+                                    ? (oc_wgpu_glyph_instance*)glyphInstanceStaging.ptr
+                                    : oc_arena_push_array(scratch.arena, oc_wgpu_glyph_instance, total.glyphInstanceCount);
+
+        context->gradientCount = total.gradientCount;
+        context->gradientCap = total.gradientCount;
+        context->gradients = gradientStaging.ptr
+                               ? (oc_wgpu_gradient*)gradientStaging.ptr
+                               : oc_arena_push_array(scratch.arena, oc_wgpu_gradient, total.gradientCount);
+
+        context->maxSegmentCount = total.maxSegmentCount;
+        context->maxBinQueueCount = total.maxBinQueueCount;
+        context->maxTileOpCount = total.maxTileOpCount;
+
+        u32 pathOffset = 0;
+        u32 eltOffset = 0;
+        u32 glyphEltOffset = total.eltCount;
+        u32 glyphInstanceOffset = 0;
+        u32 gradientOffset = 0;
+        for(int jobIndex = 0; jobIndex < mergedJobCount; jobIndex++)
         {
-            WGPURenderPassDescriptor desc = {
-                .label = "final blit",
-                .colorAttachmentCount = 1,
-                .colorAttachments = (WGPURenderPassColorAttachment[]){
-                    {
-                        .view = frameBuffer,
-                        .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
-                        .loadOp = loadOp,
-                        .storeOp = WGPUStoreOp_Store,
-                        .clearValue = { clearColor.r, clearColor.g, clearColor.b, clearColor.a },
-                    },
-                },
-            };
+            oc_wgpu_canvas_encoding_job* job = &pool->jobs[jobIndex];
 
-            WGPURenderPassEncoder pass = wgpuCommandEncoderBeginRenderPass(encoder, &desc);
+            //NOTE: gradient indices are fixed up in the job's paths, before they're copied to staging memory
+            if(gradientOffset)
             {
-                wgpuRenderPassEncoderSetViewport(pass, 0.f, 0.f, screenSize.x, screenSize.y, 0.f, 1.f);
-
-                if(batchCount)
+                for(int i = 0; i < job->kept.pathCount; i++)
                 {
-                    wgpuRenderPassEncoderSetPipeline(pass, renderer->finalBlitPipeline);
-                    wgpuRenderPassEncoderSetBindGroup(pass, 0, renderer->finalBlitBindGroup, 0, NULL);
-                    wgpuRenderPassEncoderDraw(pass, 4, 1, 0, 0);
+                    if(job->context.pathData[i].gradientIndex >= 0)
+                    {
+                        job->context.pathData[i].gradientIndex += gradientOffset;
+                    }
                 }
             }
-            wgpuRenderPassEncoderEnd(pass);
-            wgpuRenderPassEncoderRelease(pass);
+            memcpy(context->pathData + pathOffset, job->context.pathData, job->kept.pathCount * sizeof(oc_wgpu_path));
+            memcpy(context->gradients + gradientOffset, job->context.gradients, job->kept.gradientCount * sizeof(oc_wgpu_gradient));
+
+            //NOTE: staging memory may be write-combined, so elements are only written to it, never read back
+            oc_wgpu_path_elt* dstElements = context->elementData + eltOffset;
+            for(int i = 0; i < job->kept.eltCount; i++)
+            {
+                oc_wgpu_path_elt elt = job->context.elementData[i];
+                elt.pathIndex += pathOffset;
+                dstElements[i] = elt;
+            }
+
+            //NOTE: glyph outlines are expanded after all the elements encoded on the CPU
+            oc_wgpu_glyph_instance* dstInstances = context->glyphInstances + glyphInstanceOffset;
+            for(int i = 0; i < job->kept.glyphInstanceCount; i++)
+            {
+                oc_wgpu_glyph_instance instance = job->context.glyphInstances[i];
+                instance.pathIndex += pathOffset;
+                instance.outStart += glyphEltOffset;
+                dstInstances[i] = instance;
+            }
+            pathOffset += job->kept.pathCount;
+            eltOffset += job->kept.eltCount;
+            glyphEltOffset += job->kept.glyphEltCount;
+            glyphInstanceOffset += job->kept.glyphInstanceCount;
+            gradientOffset += job->kept.gradientCount;
+
+            //NOTE: features of primitives cut from the batch are kept, which only makes the variant more general
+            context->rasterFeatures |= job->context.rasterFeatures;
         }
+        context->rasterPipeline = oc_wgpu_canvas_raster_pipeline(renderer, context->rasterFeatures);
 
-        //NOTE: resolve frame timestamps
-        if(renderer->hasTimestamps && (renderer->debugRecordOptions.timingFlags & OC_WGPU_CANVAS_TIMING_FRAME))
-        {
-            wgpuCommandEncoderWriteTimestamp(encoder, renderer->timestampsQuerySet, OC_WGPU_CANVAS_TIMESTAMP_INDEX_FRAME_END);
+        int nChunkX = ((int)context->screenSize.x + context->chunkSize - 1) / context->chunkSize;
+        int nChunkY = ((int)context->screenSize.y + context->chunkSize - 1) / context->chunkSize;
+        context->chunkCount = nChunkX * nChunkY;
+        context->maxChunkEltCount = context->chunkCount * context->pathCount;
 
-            wgpuCommandEncoderResolveQuerySet(encoder,
-                                              renderer->timestampsQuerySet,
-                                              OC_WGPU_CANVAS_TIMESTAMP_INDEX_FRAME_BEGIN,
-                                              2,
-                                              renderer->timestampsResolveBuffer,
-                                              0);
+        oc_wgpu_canvas_update_resources_if_needed(context);
 
-            wgpuCommandEncoderCopyBufferToBuffer(encoder,
-                                                 renderer->timestampsResolveBuffer,
-                                                 0,
-                                                 renderer->timestampsReadBuffer[renderer->rollingBufferIndex],
-                                                 0,
-                                                 2 * sizeof(u64));
-        }
+        oc_wgpu_canvas_staging_copy(context->encoder, &pathStaging, renderer->pathBuffer, sizeof(oc_wgpu_path) * context->pathCount);
+        oc_wgpu_canvas_staging_copy(context->encoder, &eltStaging, renderer->elementBuffer, sizeof(oc_wgpu_path_elt) * context->eltCount);
+        oc_wgpu_canvas_staging_copy(context->encoder,
+                                    &glyphInstanceStaging,
+                                    renderer->glyphInstanceBuffer,
+                                    sizeof(oc_wgpu_glyph_instance) * context->glyphInstanceCount);
+        oc_wgpu_canvas_staging_copy(context->encoder, &gradientStaging, renderer->gradientBuffer, sizeof(oc_wgpu_gradient) * context->gradientCount);
+        oc_wgpu_canvas_glyph_cache_upload(context);
 
-        command = wgpuCommandEncoderFinish(encoder, NULL);
-        wgpuQueueSubmit(renderer->queue, 1, &command);
-        wgpuCommandBufferRelease(command);
-        wgpuCommandEncoderRelease(encoder);
+        context->pathBatchStart += primitiveIndex;
+
+        oc_scratch_end(scratch);
+
+        return (true);
+    }
+}
 
-        f64 submitEnd = oc_clock_time(OC_CLOCK_MONOTONIC);
+//------------------------------------------------------------------------------------------------
+// Chunk size tuning
+//------------------------------------------------------------------------------------------------
 
-        wgpuTextureViewRelease(frameBuffer);
+/*NOTE:
+	The chunk pass bins paths into square chunks, and the merge pass walks the paths of a tile's chunk. Small chunks
+	make that walk shorter but write more chunk elements, and the best trade-off depends on the GPU and on the surface
+	size. So instead of a fixed size, each surface size is tuned by timing the chunk and merge passes of
+	OC_WGPU_CANVAS_CHUNK_TUNING_FRAMES frames with each candidate. Candidates take turns, so that changes in the
+	scene affect them alike, and the fastest one is kept.
 
-        //NOTE: read back frame timestamps
-        if(frameCounters)
+	The choice is stored in the pipeline cache, whose isolation key identifies the adapter and driver, so that later
+	runs don't tune again. Tuning needs timestamp queries, without them we use OC_WGPU_CANVAS_CHUNK_SIZE.
+*/
+
+static int oc_wgpu_canvas_chunk_tuning_cache_key(char* buffer, int size, u32 key)
+{
+    return (snprintf(buffer, size, "oc_wgpu_canvas_chunk_size_%ux%u", key >> 16, key & 0xffff));
+}
+
+static oc_wgpu_canvas_chunk_tuning* oc_wgpu_canvas_chunk_tuning_find(oc_wgpu_canvas_renderer* renderer, u32 key)
+{
+    for(int i = 0; i < OC_WGPU_CANVAS_CHUNK_TUNING_SLOTS; i++)
+    {
+        if(renderer->chunkTunings[i].key == key)
         {
-            frameCounters->batchCount = batchCount;
+            return (&renderer->chunkTunings[i]);
+        }
+    }
+    return (0);
+}
 
-            if(renderer->hasTimestamps && (renderer->debugRecordOptions.timingFlags & OC_WGPU_CANVAS_TIMING_ALL))
+static oc_wgpu_canvas_chunk_tuning* oc_wgpu_canvas_chunk_tuning_get(oc_wgpu_canvas_renderer* renderer, oc_vec2 screenSize)
+{
+    u32 width = oc_clamp(((u32)screenSize.x + OC_WGPU_CANVAS_CHUNK_TUNING_BUCKET - 1) / OC_WGPU_CANVAS_CHUNK_TUNING_BUCKET, 1, 0xffff);
+    u32 height = oc_clamp(((u32)screenSize.y + OC_WGPU_CANVAS_CHUNK_TUNING_BUCKET - 1) / OC_WGPU_CANVAS_CHUNK_TUNING_BUCKET, 1, 0xffff);
+    u32 key = (width << 16) | height;
+
+    oc_wgpu_canvas_chunk_tuning* tuning = oc_wgpu_canvas_chunk_tuning_find(renderer, key);
+    if(!tuning)
+    {
+        //NOTE: recycle the least recently used slot, free slots have a lastUsedFrame of 0
+        tuning = &renderer->chunkTunings[0];
+        for(int i = 1; i < OC_WGPU_CANVAS_CHUNK_TUNING_SLOTS; i++)
+        {
+            if(renderer->chunkTunings[i].lastUsedFrame < tuning->lastUsedFrame)
             {
-                oc_wgpu_canvas_timestamp_read_callback_data* data = &renderer->timestampsReadCallbackData[renderer->rollingBufferIndex];
-                *data = (oc_wgpu_canvas_timestamp_read_callback_data){
-                    .renderer = renderer,
-                    .frameCounters = frameCounters,
-                    .mapSize = sizeof(u64) * OC_WGPU_CANVAS_TIMESTAMPS_COUNT,
-                    .buffer = renderer->timestampsReadBuffer[renderer->rollingBufferIndex],
-                };
-                wgpuBufferMapAsync(renderer->timestampsReadBuffer[renderer->rollingBufferIndex],
-                                   WGPUMapMode_Read,
-                                   0,
-                                   data->mapSize,
-                                   oc_wgpu_canvas_timestamp_read_callback,
-                                   data);
+                tuning = &renderer->chunkTunings[i];
             }
+        }
+        memset(tuning, 0, sizeof(oc_wgpu_canvas_chunk_tuning));
+        tuning->key = key;
 
-            frameCounters->cpuEncodeTime = (submitEnd - submitStart) * 1000.;
-            frameCounters->cpuFrameTime = (submitStart - renderer->lastFrameTimeStamp) * 1000.;
-
-            if(renderer->frameIndex)
+        char cacheKey[64];
+        int cacheKeyLen = oc_wgpu_canvas_chunk_tuning_cache_key(cacheKey, sizeof(cacheKey), key);
+        u32 chunkSize = 0;
+        if(oc_wgpu_canvas_pipeline_cache_load(cacheKey, cacheKeyLen, &chunkSize, sizeof(u32), &renderer->pipelineCache) == sizeof(u32))
+        {
+            for(int i = 0; i < OC_WGPU_CANVAS_CHUNK_SIZE_CANDIDATE_COUNT; i++)
             {
-                oc_wgpu_canvas_stats_add_sample(&renderer->cpuFrameTime, frameCounters->cpuFrameTime);
+                if(chunkSize == OC_WGPU_CANVAS_CHUNK_SIZE_CANDIDATES[i])
+                {
+                    tuning->chunkSize = chunkSize;
+                }
             }
-            oc_wgpu_canvas_stats_add_sample(&renderer->cpuEncodeTime, frameCounters->cpuEncodeTime);
         }
-        renderer->lastFrameTimeStamp = submitStart;
+        if(!tuning->chunkSize && !renderer->hasTimestamps)
+        {
+            tuning->chunkSize = OC_WGPU_CANVAS_CHUNK_SIZE;
+        }
     }
-
-    renderer->frameIndex++;
+    tuning->lastUsedFrame = renderer->frameIndex + 1;
+    return (tuning);
 }
 
-void oc_wgpu_canvas_present(oc_canvas_renderer_base* rendererBase, oc_surface surfaceHandle)
+static void oc_wgpu_canvas_chunk_tuning_add_sample(oc_wgpu_canvas_renderer* renderer, u32 key, u32 candidate, f64 time)
 {
-    oc_wgpu_surface_present(surfaceHandle);
-}
+    //NOTE: the slot might have been recycled, or tuned by other frames, while this one was in flight
+    oc_wgpu_canvas_chunk_tuning* tuning = oc_wgpu_canvas_chunk_tuning_find(renderer, key);
+    if(!tuning || tuning->chunkSize)
+    {
+        return;
+    }
 
-void oc_wgpu_canvas_destroy(oc_canvas_renderer_base* base)
-{
-    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)base;
+    tuning->frameCounts[candidate]++;
+    tuning->times[candidate] += time;
 
-// release bind groups
-#define release_bindgroup_if_needed(x) \
-    if(x)                              \
-    {                                  \
-        wgpuBindGroupRelease(x);       \
+    u32 best = 0;
+    for(int i = 0; i < OC_WGPU_CANVAS_CHUNK_SIZE_CANDIDATE_COUNT; i++)
+    {
+        if(tuning->frameCounts[i] < OC_WGPU_CANVAS_CHUNK_TUNING_FRAMES)
+        {
+            return;
+        }
+        if(tuning->times[i] / tuning->frameCounts[i] < tuning->times[best] / tuning->frameCounts[best])
+        {
+            best = i;
+        }
     }
+    tuning->chunkSize = OC_WGPU_CANVAS_CHUNK_SIZE_CANDIDATES[best];
 
-    release_bindgroup_if_needed(renderer->pathSetupBindGroup);
-    release_bindgroup_if_needed(renderer->segmentSetupBindGroup);
-    release_bindgroup_if_needed(renderer->backpropBindGroup);
-    release_bindgroup_if_needed(renderer->chunkBindGroup);
-    release_bindgroup_if_needed(renderer->mergeBindGroup);
-    release_bindgroup_if_needed(renderer->balanceBindGroup);
-    release_bindgroup_if_needed(renderer->rasterBindGroup);
-    release_bindgroup_if_needed(renderer->srcTexturesBindGroup);
-    release_bindgroup_if_needed(renderer->blitBindGroup);
+    char cacheKey[64];
+    int cacheKeyLen = oc_wgpu_canvas_chunk_tuning_cache_key(cacheKey, sizeof(cacheKey), key);
+    oc_wgpu_canvas_pipeline_cache_store(cacheKey, cacheKeyLen, &tuning->chunkSize, sizeof(u32), &renderer->pipelineCache);
+}
 
-#undef release_bindgroup_if_needed
+//------------------------------------------------------------------------------------------------
+// Dynamic render scale
+//------------------------------------------------------------------------------------------------
 
-    // release bind group layouts
-    wgpuBindGroupLayoutRelease(renderer->pathSetupBindGroupLayout);
-    wgpuBindGroupLayoutRelease(renderer->segmentSetupBindGroupLayout);
-    wgpuBindGroupLayoutRelease(renderer->backpropBindGroupLayout);
-    wgpuBindGroupLayoutRelease(renderer->chunkBindGroupLayout);
-    wgpuBindGroupLayoutRelease(renderer->mergeBindGroupLayout);
-    wgpuBindGroupLayoutRelease(renderer->balanceBindGroupLayout);
-    wgpuBindGroupLayoutRelease(renderer->rasterBindGroupLayout);
-    wgpuBindGroupLayoutRelease(renderer->srcTexturesBindGroupLayout);
-    wgpuBindGroupLayoutRelease(renderer->blitBindGroupLayout);
+/*NOTE:
+	When a GPU budget is set with oc_canvas_renderer_set_dynamic_scale(), surfaces are rasterized at renderScale times
+	their size, and the scaled blit upscales the result to the surface. The scale follows a moving average of the GPU
+	time of frames: it steps down as soon as frames exceed the budget, by as many steps as needed to fit it if we assume
+	that the time is proportional to the pixel count. It only steps up by one when the time predicted at the next step
+	leaves some headroom, so that it doesn't oscillate between two steps.
 
-    // release pipelines
-    wgpuComputePipelineRelease(renderer->pathSetupPipeline);
-    wgpuComputePipelineRelease(renderer->segmentSetupPipeline);
-    wgpuComputePipelineRelease(renderer->backpropPipeline);
-    wgpuComputePipelineRelease(renderer->chunkPipeline);
-    wgpuComputePipelineRelease(renderer->mergePipeline);
-    wgpuComputePipelineRelease(renderer->balancePipeline);
-    wgpuComputePipelineRelease(renderer->rasterPipeline);
-    wgpuRenderPipelineRelease(renderer->blitPipeline);
+	Frames that were still in flight when the scale changed were timed at their old scale, so they're ignored.
+*/
 
-#define release_buffer_if_needed(x) \
-    if(x)                           \
-    {                               \
-        wgpuBufferRelease(x);       \
+static void oc_wgpu_canvas_dynamic_scale_add_sample(oc_wgpu_canvas_renderer* renderer, f32 renderScale, f64 gpuTime)
+{
+    if(renderer->dynamicScaleBudget == 0 || renderScale != renderer->renderScale)
+    {
+        return;
     }
 
-    // release buffers
-    release_buffer_if_needed(renderer->pathBuffer);
-    release_buffer_if_needed(renderer->pathCountBuffer);
+    if(renderer->dynamicScaleSampleCount == 0)
+    {
+        renderer->dynamicScaleGpuTime = gpuTime;
+    }
+    else
+    {
+        renderer->dynamicScaleGpuTime += (gpuTime - renderer->dynamicScaleGpuTime) * 0.25;
+    }
+    renderer->dynamicScaleSampleCount++;
 
-    release_buffer_if_needed(renderer->elementBuffer);
-    release_buffer_if_needed(renderer->elementCountBuffer);
+    if(renderer->dynamicScaleSampleCount < OC_WGPU_CANVAS_DYNAMIC_SCALE_FRAMES)
+    {
+        return;
+    }
+
+    f32 step = 1. / OC_WGPU_CANVAS_DYNAMIC_SCALE_STEPS;
+    f64 budget = renderer->dynamicScaleBudget;
+    f64 time = renderer->dynamicScaleGpuTime;
+    f32 scale = renderScale;
+
+    if(time > budget)
+    {
+        f32 fit = floorf(renderScale * sqrt(budget / time) * OC_WGPU_CANVAS_DYNAMIC_SCALE_STEPS) * step;
+        scale = oc_min(renderScale - step, fit);
+    }
+    else
+    {
+        f32 next = renderScale + step;
+        f64 predicted = time * (next * next) / (renderScale * renderScale);
+        if(predicted < budget * 0.85)
+        {
+            scale = next;
+        }
+    }
+    scale = oc_clamp(scale, renderer->dynamicScaleMin, 1);
+
+    if(scale != renderScale)
+    {
+        renderer->renderScale = scale;
+        renderer->dynamicScaleSampleCount = 0;
+    }
+}
+
+void oc_wgpu_canvas_timestamp_read_callback(WGPUBufferMapAsyncStatus status, void* user)
+{
+    oc_wgpu_canvas_timestamp_read_callback_data* data = (oc_wgpu_canvas_timestamp_read_callback_data*)user;
+    oc_wgpu_canvas_renderer* renderer = data->renderer;
+    oc_wgpu_canvas_frame_counters* frameCounters = data->frameCounters;
+
+    if(status != WGPUBufferMapAsyncStatus_Success)
+    {
+        return;
+    }
+    if(frameCounters && frameCounters->frameIndex != data->frameIndex)
+    {
+        //NOTE: the record was recycled while the timestamps were in flight, drop them
+        wgpuBufferUnmap(data->buffer);
+        return;
+    }
+
+    u64 mapSize = data->mapSize;
+    const char* mappedBuffer = (const char*)wgpuBufferGetConstMappedRange(data->buffer,
+                                                                          0,
+                                                                          mapSize);
+
+    const oc_wgpu_canvas_frame_timestamps* frameTimestamps = (const oc_wgpu_canvas_frame_timestamps*)mappedBuffer;
+
+    if(frameCounters && frameTimestamps->frameEnd > frameTimestamps->frameBegin)
+    {
+        frameCounters->gpuTime = (frameTimestamps->frameEnd - frameTimestamps->frameBegin) / 1000000.;
+
+        //NOTE: GPU timestamps aren't in the CPU clock's domain, so we can only approximate the start of the
+        //      GPU frame by the time it was submitted.
+        oc_trace_zone_complete("gpu frame", OC_TRACE_TRACK_GPU, data->submitTime, data->submitTime + frameCounters->gpuTime / 1000.);
+
+        if(frameCounters->gpuTime)
+        {
+            oc_wgpu_canvas_stats_add_sample(&renderer->gpuTime, frameCounters->gpuTime);
+        }
+    }
+
+    if(data->renderScale && frameTimestamps->frameEnd > frameTimestamps->frameBegin)
+    {
+        oc_wgpu_canvas_dynamic_scale_add_sample(renderer,
+                                                data->renderScale,
+                                                (frameTimestamps->frameEnd - frameTimestamps->frameBegin) / 1000000.);
+    }
+
+    if(data->passBatchCount)
+    {
+        f64 passTimes[OC_WGPU_CANVAS_PASS_COUNT] = { 0 };
+        for(u32 batchIndex = 0; batchIndex < data->passBatchCount; batchIndex++)
+        {
+            const u64* passTimestamps = frameTimestamps->passes[batchIndex];
+            for(int passIndex = 0; passIndex < OC_WGPU_CANVAS_PASS_COUNT; passIndex++)
+            {
+                if(passTimestamps[passIndex + 1] > passTimestamps[passIndex])
+                {
+                    passTimes[passIndex] += (passTimestamps[passIndex + 1] - passTimestamps[passIndex]) / 1000000.;
+                }
+            }
+        }
+
+        if(frameCounters)
+        {
+            for(int passIndex = 0; passIndex < OC_WGPU_CANVAS_PASS_COUNT; passIndex++)
+            {
+                frameCounters->passTimes[passIndex] += passTimes[passIndex];
+                oc_wgpu_canvas_stats_add_sample(&renderer->passTime[passIndex], frameCounters->passTimes[passIndex]);
+            }
+            frameCounters->hasPassTimes = true;
+        }
+
+        if(data->tuningKey)
+        {
+            oc_wgpu_canvas_chunk_tuning_add_sample(renderer,
+                                                   data->tuningKey,
+                                                   data->tuningCandidate,
+                                                   passTimes[OC_WGPU_CANVAS_PASS_CHUNK] + passTimes[OC_WGPU_CANVAS_PASS_MERGE]);
+        }
+    }
+
+    wgpuBufferUnmap(data->buffer);
+}
+
+void oc_wgpu_canvas_counters_read_callback(WGPUBufferMapAsyncStatus status, void* user)
+{
+    oc_wgpu_canvas_counters_read_callback_data* data = (oc_wgpu_canvas_counters_read_callback_data*)user;
+    oc_wgpu_canvas_renderer* renderer = data->renderer;
+
+    if(status != WGPUBufferMapAsyncStatus_Success)
+    {
+        return;
+    }
+
+    u64 mapSize = data->batchCount * OC_WGPU_CANVAS_COUNTER_COUNT * sizeof(u32);
+    const u32* counts = (const u32*)wgpuBufferGetConstMappedRange(data->buffer, 0, mapSize);
+
+    for(u32 batchIndex = 0; batchIndex < data->batchCount; batchIndex++)
+    {
+        for(int counterIndex = 0; counterIndex < OC_WGPU_CANVAS_COUNTER_COUNT; counterIndex++)
+        {
+            oc_wgpu_canvas_buffer_usage* usage = &renderer->bufferUsage[oc_wgpu_canvas_countedBuffers[counterIndex]];
+            usage->gpuCount = oc_max(usage->gpuCount, counts[batchIndex * OC_WGPU_CANVAS_COUNTER_COUNT + counterIndex]);
+        }
+    }
+
+    wgpuBufferUnmap(data->buffer);
+}
+
+static void oc_wgpu_canvas_submit_clear_frame(oc_wgpu_canvas_renderer* renderer, oc_surface surfaceHandle, oc_color clearColor)
+{
+    WGPUTexture currentTexture = oc_wgpu_surface_get_current_texture(surfaceHandle,
+                                                                      renderer->adapter,
+                                                                      renderer->device,
+                                                                      renderer->presentMode,
+                                                                      renderer->maxFrameLatency);
+
+    WGPUTextureViewDescriptor viewDesc = {
+        .format = WGPUTextureFormat_BGRA8Unorm,
+        .dimension = WGPUTextureViewDimension_2D,
+        .baseMipLevel = 0,
+        .mipLevelCount = 1,
+        .baseArrayLayer = 0,
+        .arrayLayerCount = 1,
+        .aspect = WGPUTextureAspect_All,
+    };
+
+    WGPUTextureView frameBuffer = wgpuTextureCreateView(currentTexture, &viewDesc);
+    if(frameBuffer)
+    {
+        WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(renderer->device, NULL);
+
+        WGPURenderPassDescriptor desc = {
+            .label = "clear frame",
+            .colorAttachmentCount = 1,
+            .colorAttachments = (WGPURenderPassColorAttachment[]){
+                {
+                    .view = frameBuffer,
+                    .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
+                    .loadOp = WGPULoadOp_Clear,
+                    .storeOp = WGPUStoreOp_Store,
+                    .clearValue = { clearColor.r, clearColor.g, clearColor.b, clearColor.a },
+                },
+            },
+        };
+        WGPURenderPassEncoder pass = wgpuCommandEncoderBeginRenderPass(encoder, &desc);
+        wgpuRenderPassEncoderEnd(pass);
+        wgpuRenderPassEncoderRelease(pass);
+
+        WGPUCommandBuffer command = wgpuCommandEncoderFinish(encoder, NULL);
+        wgpuQueueSubmit(renderer->queue, 1, &command);
+        wgpuCommandBufferRelease(command);
+        wgpuCommandEncoderRelease(encoder);
+
+        wgpuTextureViewRelease(frameBuffer);
+    }
+}
+
+static void oc_wgpu_canvas_write_pass_timestamp(oc_wgpu_canvas_renderer* renderer,
+                                                WGPUCommandEncoder encoder,
+                                                bool timePasses,
+                                                u32 batchIndex,
+                                                u32 stampIndex)
+{
+    if(timePasses)
+    {
+        wgpuCommandEncoderWriteTimestamp(encoder,
+                                         renderer->timestampsQuerySet,
+                                         OC_WGPU_CANVAS_TIMESTAMP_INDEX_PASSES + batchIndex * OC_WGPU_CANVAS_TIMESTAMPS_PER_BATCH + stampIndex);
+    }
+}
+
+static void oc_wgpu_canvas_render(oc_wgpu_canvas_renderer* renderer,
+                                  WGPUCommandEncoder encoder,
+                                  oc_wgpu_canvas_frame_records* records,
+                                  oc_wgpu_canvas_target* target,
+                                  u32 msaaSampleCount,
+                                  bool clear,
+                                  oc_color clearColor,
+                                  u32 primitiveCount,
+                                  oc_primitive* primitives,
+                                  u32 attributeCount,
+                                  oc_attributes* attributes,
+                                  u32 eltCount,
+                                  oc_path_elt* elements)
+{
+    //NOTE: surfaces are rasterized at the dynamic render scale, and upscaled when they're blitted to their texture.
+    //      Images are always rendered at their own size.
+    bool dynamicScale = (target->surface && renderer->dynamicScaleBudget > 0);
+    f32 renderScale = dynamicScale ? renderer->renderScale : 1;
+
+    oc_vec2 scale = { target->scale.x * renderScale, target->scale.y * renderScale };
+    oc_vec2 screenSize = { ceilf(target->size.x * renderScale), ceilf(target->size.y * renderScale) };
+
+    //NOTE: only time the frame if the next read buffer is free. The device is ticked before rendering, so any map
+    //      callback that was ready has already run.
+    //      Frames are also timed while the chunk size of their surface size is being tuned, or to adjust the dynamic
+    //      render scale. Targets that don't record their frame use the candidate being tuned without timing it.
+    oc_wgpu_canvas_chunk_tuning* chunkTuning = oc_wgpu_canvas_chunk_tuning_get(renderer, screenSize);
+    bool tuneChunkSize = (chunkTuning->chunkSize == 0);
+    u32 tuningCandidate = 0;
+    u32 chunkSize = chunkTuning->chunkSize;
+    if(tuneChunkSize)
+    {
+        tuningCandidate = chunkTuning->nextCandidate;
+        chunkSize = OC_WGPU_CANVAS_CHUNK_SIZE_CANDIDATES[tuningCandidate];
+        if(records)
+        {
+            chunkTuning->nextCandidate = (tuningCandidate + 1) % OC_WGPU_CANVAS_CHUNK_SIZE_CANDIDATE_COUNT;
+        }
+        else
+        {
+            tuneChunkSize = false;
+        }
+    }
+
+    bool recordTimestamps = false;
+    if(records
+       && renderer->hasTimestamps
+       && ((renderer->debugRecordOptions.timingFlags & OC_WGPU_CANVAS_TIMING_ALL) || tuneChunkSize || dynamicScale))
+    {
+        int nextIndex = (renderer->timestampsReadIndex + 1) % OC_WGPU_CANVAS_TIMESTAMP_READ_BUFFER_COUNT;
+        if(wgpuBufferGetMapState(renderer->timestampsReadBuffer[nextIndex]) == WGPUBufferMapState_Unmapped)
+        {
+            renderer->timestampsReadIndex = nextIndex;
+            recordTimestamps = true;
+        }
+    }
+    bool recordPassTimestamps = recordTimestamps
+                             && ((renderer->debugRecordOptions.timingFlags & OC_WGPU_CANVAS_TIMING_PASSES) || tuneChunkSize);
+    u32 passBatchCount = 0;
+
+    //NOTE: likewise, only read back the counters if the next counters buffer is free
+    bool recordCounters = false;
+    if(records)
+    {
+        int nextIndex = (renderer->countersReadIndex + 1) % OC_WGPU_CANVAS_COUNTERS_READ_BUFFER_COUNT;
+        if(wgpuBufferGetMapState(renderer->countersReadBuffer[nextIndex]) == WGPUBufferMapState_Unmapped)
+        {
+            renderer->countersReadIndex = nextIndex;
+            recordCounters = true;
+        }
+    }
+
+    f64 encodeStart = oc_clock_time(OC_CLOCK_MONOTONIC);
+    OC_TRACE_BEGIN("canvas encode");
+
+    //TODO: move that to enum
+    i32 tileSize = 16;
+    i32 nTilesX = (i32)(screenSize.x + tileSize - 1) / tileSize;
+    i32 nTilesY = (i32)(screenSize.y + tileSize - 1) / tileSize;
+
+    //NOTE: drop the cached glyph outlines once the cache is full, before any encoding job can reference them
+    if(renderer->glyphCache.full)
+    {
+        oc_wgpu_canvas_glyph_cache_flush(&renderer->glyphCache);
+    }
+
+    oc_wgpu_canvas_encoding_context encodingContext = {
+        .renderer = renderer,
+        .inputPrimitiveCount = primitiveCount,
+        .inputPrimitives = primitives,
+        .inputAttributeCount = attributeCount,
+        .inputAttributes = attributes,
+        .inputEltCount = eltCount,
+        .inputElements = elements,
+        .screenSize = screenSize,
+        .targetCapacity = oc_wgpu_canvas_target_capacity(renderer, screenSize),
+        .scale = scale,
+        .tileSize = tileSize,
+        .chunkSize = chunkSize,
+        .screenTilesCount = nTilesX * nTilesY,
+    };
+
+    //NOTE: analytic coverage is passed to the raster pass as a sample count of 0
+    if(msaaSampleCount == OC_CANVAS_SAMPLE_COUNT_ANALYTIC)
+    {
+        msaaSampleCount = 0;
+    }
+    else
+    {
+        msaaSampleCount = oc_clamp(msaaSampleCount, 0, OC_WGPU_CANVAS_MAX_SAMPLE_COUNT);
+        if(msaaSampleCount == 0)
+        {
+            msaaSampleCount = OC_WGPU_CANVAS_DEFAULT_SAMPLE_COUNT;
+        }
+    }
+
+    //NOTE: only redraw the damaged region if outTexture still holds the previous frame of the same surface, rendered
+    //      with the same sample count and scale. The region is snapped to the tile grid so that no tile is partially
+    //      redrawn.
+    if(target->damage.w > 0
+       && target->damage.h > 0
+       && target->surface
+       && renderer->outTextureSurface == target->surface
+       && renderer->outTextureScale.x == scale.x
+       && renderer->outTextureScale.y == scale.y
+       && renderer->outTextureView
+       && renderer->batchTextureSize.x == screenSize.x
+       && renderer->batchTextureSize.y == screenSize.y
+       && renderer->batchTextureCapacity.x == encodingContext.targetCapacity.x
+       && renderer->batchTextureCapacity.y == encodingContext.targetCapacity.y
+       && renderer->msaaSampleCount == msaaSampleCount
+       && !renderer->debugDisplayOptions.pathCount
+       && renderer->debugDisplayOptions.heatmap == OC_WGPU_CANVAS_HEATMAP_NONE)
+    {
+        f32 x0 = floorf(target->damage.x * scale.x / tileSize) * tileSize;
+        f32 y0 = floorf(target->damage.y * scale.y / tileSize) * tileSize;
+        f32 x1 = ceilf((target->damage.x + target->damage.w) * scale.x / tileSize) * tileSize;
+        f32 y1 = ceilf((target->damage.y + target->damage.h) * scale.y / tileSize) * tileSize;
+
+        x0 = oc_clamp(x0, 0, screenSize.x);
+        y0 = oc_clamp(y0, 0, screenSize.y);
+        x1 = oc_clamp(x1, 0, screenSize.x);
+        y1 = oc_clamp(y1, 0, screenSize.y);
+
+        if(x1 > x0 && y1 > y0 && (x1 - x0 < screenSize.x || y1 - y0 < screenSize.y))
+        {
+            encodingContext.hasDamage = true;
+            encodingContext.damage = (oc_vec4){ x0, y0, x1, y1 };
+        }
+    }
+
+    if(renderer->debugDisplayOptions.pathCount)
+    {
+        i32 pathStart = oc_clamp(renderer->debugDisplayOptions.pathStart, 0, primitiveCount);
+        i32 pathCount = oc_clamp(renderer->debugDisplayOptions.pathCount,
+                                 1,
+                                 primitiveCount - pathStart);
+
+        encodingContext.inputPrimitiveCount = pathCount;
+        encodingContext.inputPrimitives = primitives + pathStart;
+    }
+
+    //NOTE: allocate a new frame counters record
+    oc_wgpu_canvas_frame_counters* frameCounters = 0;
+    if(records && renderer->debugRecordOptions.maxRecordCount)
+    {
+        bool removeOld = false;
+        oc_wgpu_canvas_frame_counters* oldFrameCounters = oc_list_first_entry(renderer->debugRecords,
+                                                                              oc_wgpu_canvas_frame_counters,
+                                                                              listElt);
+        if(oldFrameCounters && (renderer->frameIndex - oldFrameCounters->frameIndex >= renderer->debugRecordOptions.maxRecordCount))
+        {
+            //NOTE: recycle first (oldest) record
+            oc_list_pop_front(&renderer->debugRecords);
+
+            for(oc_wgpu_canvas_batch_counters* batchCounters = oc_list_pop_front_entry(&oldFrameCounters->batches, oc_wgpu_canvas_batch_counters, listElt);
+                batchCounters != 0;
+                batchCounters = oc_list_pop_front_entry(&oldFrameCounters->batches, oc_wgpu_canvas_batch_counters, listElt))
+            {
+                oc_list_push_front(&renderer->batchCountersFreeList, &batchCounters->listElt);
+            }
+
+            if(oldFrameCounters->gpuTime)
+            {
+                oc_wgpu_canvas_stats_remove_sample(&renderer->gpuTime);
+            }
+            if(oldFrameCounters->hasPassTimes)
+            {
+                for(int passIndex = 0; passIndex < OC_WGPU_CANVAS_PASS_COUNT; passIndex++)
+                {
+                    oc_wgpu_canvas_stats_remove_sample(&renderer->passTime[passIndex]);
+                }
+            }
+            oc_wgpu_canvas_stats_remove_sample(&renderer->cpuEncodeTime);
+            oc_wgpu_canvas_stats_remove_sample(&renderer->cpuFrameTime);
+
+            //NOTE: invalidate the frame index so that in-flight timestamps for that record are dropped
+            oldFrameCounters->frameIndex = UINT32_MAX;
+            oc_list_push_front(&renderer->frameCountersFreeList, &oldFrameCounters->listElt);
+        }
+
+        //NOTE: get new record from free list or allocate it fresh from debug arena
+        frameCounters = oc_list_pop_front_entry(&renderer->frameCountersFreeList,
+                                                oc_wgpu_canvas_frame_counters,
+                                                listElt);
+        if(!frameCounters)
+        {
+            frameCounters = oc_arena_push_type(&renderer->debugArena, oc_wgpu_canvas_frame_counters);
+        }
+
+        if(frameCounters)
+        {
+            memset(frameCounters, 0, sizeof(oc_wgpu_canvas_frame_counters));
+
+            frameCounters->frameIndex = renderer->frameIndex;
+            frameCounters->inputPathCount = encodingContext.inputPrimitiveCount;
+            frameCounters->inputElementCount = encodingContext.inputEltCount;
+
+            oc_list_push_back(&renderer->debugRecords, &frameCounters->listElt);
+            renderer->debugRecordsCount++;
+        }
+        else
+        {
+            oc_log_error("Could not allocate frame counters record\n");
+        }
+    }
+
+    //NOTE: per-frame inputs go through oc_wgpu_canvas_upload(), so that they're ordered with the passes of the other
+    //      targets encoded in the same command buffer
+    oc_wgpu_canvas_upload(renderer, encoder, renderer->tileSizeBuffer, &tileSize, sizeof(i32));
+    oc_wgpu_canvas_upload(renderer, encoder, renderer->chunkSizeBuffer, &chunkSize, sizeof(u32));
+
+    oc_wgpu_debug_display_options displayOptions = {
+        .showTileBorders = renderer->debugDisplayOptions.showTileBorders ? 1 : 0,
+        .showPathArea = renderer->debugDisplayOptions.showPathArea ? 1 : 0,
+        .showClip = renderer->debugDisplayOptions.showClip ? 1 : 0,
+        .textureOff = renderer->debugDisplayOptions.textureOff ? 1 : 0,
+        .debugTileQueues = renderer->debugDisplayOptions.debugTileQueues ? 1 : 0,
+    };
+    if(!target->surface || target->surface != renderer->debugDisplayOptions.heatmapExclude.h)
+    {
+        displayOptions.heatmap = renderer->debugDisplayOptions.heatmap;
+        displayOptions.heatmapScale = renderer->debugDisplayOptions.heatmapScale
+                                        ? renderer->debugDisplayOptions.heatmapScale
+                                        : oc_wgpu_canvas_heatmap_default_scale(renderer->debugDisplayOptions.heatmap);
+    }
+    oc_wgpu_canvas_upload(renderer,
+                          encoder,
+                          renderer->debugDisplayOptionsBuffer,
+                          &displayOptions,
+                          sizeof(oc_wgpu_debug_display_options));
+
+    encodingContext.rasterDebug = displayOptions.textureOff || displayOptions.heatmap != OC_WGPU_CANVAS_HEATMAP_NONE;
+
+    if(renderer->msaaSampleCount != msaaSampleCount)
+    {
+        renderer->msaaSampleCount = msaaSampleCount;
+
+        //NOTE: analytic coverage still samples cubic segments, with the offsets of the highest sample count
+        u32 sampleOffsetsIndex = OC_WGPU_CANVAS_OFFSETS_LOOKUP[(msaaSampleCount ? msaaSampleCount : OC_WGPU_CANVAS_MAX_SAMPLE_COUNT) - 1];
+        oc_vec2* offsets = OC_WGPU_CANVAS_OFFSETS[sampleOffsetsIndex];
+
+        oc_wgpu_canvas_upload(renderer, encoder, renderer->msaaOffsetsBuffer, offsets, OC_WGPU_CANVAS_MAX_SAMPLE_COUNT * sizeof(oc_vec2));
+        oc_wgpu_canvas_upload(renderer, encoder, renderer->msaaSampleCountBuffer, &renderer->msaaSampleCount, sizeof(u32));
+    }
+
+    //NOTE: the whole frame is encoded in the caller's command buffer, submitted once. Per-batch inputs go through
+    //      oc_wgpu_canvas_upload(), and counters are reset by encoder commands, so that they're ordered with the
+    //      batches' passes.
+    encodingContext.encoder = encoder;
+
+    if(recordTimestamps)
+    {
+        wgpuCommandEncoderWriteTimestamp(encoder, renderer->timestampsQuerySet, OC_WGPU_CANVAS_TIMESTAMP_INDEX_FRAME_BEGIN);
+    }
+
+    u32 batchCount = 0;
+
+    while(oc_wgpu_canvas_encode_batch(&encodingContext))
+    {
+        //NOTE: allocate new batch counters
+        oc_wgpu_canvas_batch_counters* batchCounters = 0;
+        if(frameCounters)
+        {
+            batchCounters = oc_list_pop_front_entry(&renderer->batchCountersFreeList,
+                                                    oc_wgpu_canvas_batch_counters,
+                                                    listElt);
+            if(!batchCounters)
+            {
+                batchCounters = oc_arena_push_type(&renderer->debugArena, oc_wgpu_canvas_batch_counters);
+            }
+            if(!batchCounters)
+            {
+                oc_log_error("Could not allocate batch counters record\n");
+            }
+
+            if(batchCounters)
+            {
+                batchCounters->encodedPathCount = encodingContext.pathCount;
+                batchCounters->encodedElementCount = encodingContext.eltCount + encodingContext.glyphEltCount;
+                oc_list_push_front(&frameCounters->batches, &batchCounters->listElt);
+            }
+            else
+            {
+                oc_log_error("Could not allocate batch counters record\n");
+            }
+        }
+
+        bool timePasses = recordPassTimestamps && batchCount < OC_WGPU_CANVAS_PASS_TIMING_MAX_BATCHES;
+
+        //----------------------------------------------------------------------------------------
+        //NOTE: set batch counts and reset counters
+        {
+            oc_wgpu_canvas_upload(renderer, encoder, renderer->pathCountBuffer, &encodingContext.pathCount, sizeof(u32));
+            u32 totalEltCount = encodingContext.eltCount + encodingContext.glyphEltCount;
+            oc_wgpu_canvas_upload(renderer, encoder, renderer->elementCountBuffer, &totalEltCount, sizeof(u32));
+            oc_wgpu_canvas_upload(renderer, encoder, renderer->glyphInstanceCountBuffer, &encodingContext.glyphInstanceCount, sizeof(u32));
+
+            if(displayOptions.heatmap == OC_WGPU_CANVAS_HEATMAP_BATCHES)
+            {
+                displayOptions.batchIndex = batchCount;
+                oc_wgpu_canvas_upload(renderer,
+                                      encoder,
+                                      renderer->debugDisplayOptionsBuffer,
+                                      &displayOptions,
+                                      sizeof(oc_wgpu_debug_display_options));
+            }
+
+            wgpuCommandEncoderClearBuffer(encoder, renderer->segmentCountBuffer, 0, sizeof(u32));
+            wgpuCommandEncoderClearBuffer(encoder, renderer->binQueueCountBuffer, 0, sizeof(u32));
+            wgpuCommandEncoderClearBuffer(encoder, renderer->tileOpCountBuffer, 0, sizeof(u32));
+            wgpuCommandEncoderClearBuffer(encoder, renderer->chunkEltCountBuffer, 0, sizeof(u32));
+
+            u32 dispatchInit[3] = { 0, 1, 1 };
+            oc_wgpu_canvas_upload(renderer, encoder, renderer->tileQueueCountBuffer, dispatchInit, 3 * sizeof(u32));
+        }
+
+        //----------------------------------------------------------------------------------------
+        //NOTE: clear out texture if this is the first batch. For a partial redraw, the first batch's blit replaces the
+        //      damaged region instead.
+        if(batchCount == 0 && !encodingContext.hasDamage)
+        {
+            //clear out texture
+            WGPURenderPassDescriptor desc = {
+                .colorAttachmentCount = 1,
+                .colorAttachments = (WGPURenderPassColorAttachment[]){
+                    {
+                        .view = renderer->outTextureView,
+                        .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
+                        .loadOp = WGPULoadOp_Clear,
+                        .storeOp = WGPUStoreOp_Store,
+                        .clearValue = { 0, 0, 0, 0 },
+                    },
+                },
+            };
+
+            WGPURenderPassEncoder pass = wgpuCommandEncoderBeginRenderPass(encoder, &desc);
+            {
+                wgpuRenderPassEncoderSetViewport(pass, 0.f, 0.f, screenSize.x, screenSize.y, 0.f, 1.f);
+            }
+            wgpuRenderPassEncoderEnd(pass);
+            wgpuRenderPassEncoderRelease(pass);
+        }
+
+        //----------------------------------------------------------------------------------------
+        //NOTE: clear batch texture
+        {
+            WGPURenderPassDescriptor desc = {
+                .colorAttachmentCount = 1,
+                .colorAttachments = (WGPURenderPassColorAttachment[]){
+                    {
+                        .view = renderer->batchTextureView,
+                        .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
+                        .loadOp = WGPULoadOp_Clear,
+                        .storeOp = WGPUStoreOp_Store,
+                        .clearValue = { 0, 0, 0, 0 },
+                    },
+                },
+            };
+
+            WGPURenderPassEncoder pass = wgpuCommandEncoderBeginRenderPass(encoder, &desc);
+            {
+                wgpuRenderPassEncoderSetViewport(pass, 0.f, 0.f, screenSize.x, screenSize.y, 0.f, 1.f);
+            }
+            wgpuRenderPassEncoderEnd(pass);
+            wgpuRenderPassEncoderRelease(pass);
+        }
+
+        /*NOTE(martin): On dispatch limits.
+
+            There are several limits to how many invocations and workgroups can be dispatched in one call.
+            (see https://www.w3.org/TR/webgpu/#limits)
+
+            - The requires minimum for maxComputeWorkgroupSizeX and maxComputeWorkgroupSizeY is 256.
+            - The required minimum for maxComputeInvocationsPerWorkgroup is 256
+            - The required minimum for maxComputeWorkgroupsPerDimension is 65535 = 2^16
+
+            So, we use 16*16 workgroup sizes. Limits impact each pass as follows:
+
+            * Path setup: we use one invocation per path, in 16*16 workgroup sizes, and distribute
+              workgroups on both axes. This gives a minimum limit of 2^40 paths per dispatch.
+
+            * Segment setup: we use one invocation per element, in 16*16 workgroup sizes, and distribute
+              workgroups on both axes. This gives a minimum limit of 2^40 elements per dispatch.
+
+            * Backprop pass: we use one workgroup of 16*1 invocations per path, and distribute workgroups on both axes.
+              This gives a minimum limit of 2^32 paths per dispatch.
+
+            * Merge pass: we use one workgroup of 1*1 invocations per screen tile, which gives a minimum limit of 2^16
+              tiles (= 2^20 pixels) on each axis.
+
+            * Raster pass: we use one invocation per pixel, in 16*16 workgroups (ie, one workgroup per tile). The total
+              number of workgroups is distributed on each axis in the balance_workgroups pass, which sets the indirect
+              dispatch buffer for the raster pass. This gives, a max of 2^32 tiles total.
+
+              The first three limits are higher than the number of paths/elements we can index with an u32, while the
+              last two are sufficient to completely cover a 10k screen, so we don't bother doing multiple dispatch passes.
+        */
+        oc_wgpu_canvas_write_pass_timestamp(renderer, encoder, timePasses, batchCount, 0);
+
+        //----------------------------------------------------------------------------------------
+        //NOTE: path setup pass
+        {
+            u32 invocationsPerWorkGroup = 16 * 16;
+
+            WGPUComputePassDescriptor desc = {
+                .label = "path setup",
+            };
+
+            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, &desc);
+            {
+                wgpuComputePassEncoderSetPipeline(pass, renderer->pathSetupPipeline);
+                wgpuComputePassEncoderSetBindGroup(pass, 0, renderer->pathSetupBindGroup, 0, NULL);
+
+                u32 totalWorkGroupCount = (encodingContext.pathCount + invocationsPerWorkGroup - 1) / invocationsPerWorkGroup;
+                u32 workGroupCountX = oc_min(totalWorkGroupCount, renderer->limits.maxComputeWorkgroupsPerDimension);
+                u32 workGroupCountY = (totalWorkGroupCount + renderer->limits.maxComputeWorkgroupsPerDimension - 1)
+                                    / renderer->limits.maxComputeWorkgroupsPerDimension;
+
+                wgpuComputePassEncoderDispatchWorkgroups(pass, workGroupCountX, workGroupCountY, 1);
+            }
+            wgpuComputePassEncoderEnd(pass);
+            wgpuComputePassEncoderRelease(pass);
+        }
+
+        //----------------------------------------------------------------------------------------
+        //NOTE: glyph expand pass. Like path setup, it uses one invocation per glyph instance, in 16*16 workgroups
+        //      distributed on both axes.
+        if(encodingContext.glyphInstanceCount)
+        {
+            u32 invocationsPerWorkGroup = 16 * 16;
+
+            WGPUComputePassDescriptor desc = {
+                .label = "glyph expand",
+            };
+
+            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, &desc);
+            {
+                wgpuComputePassEncoderSetPipeline(pass, renderer->glyphExpandPipeline);
+                wgpuComputePassEncoderSetBindGroup(pass, 0, renderer->glyphExpandBindGroup, 0, NULL);
+
+                u32 totalWorkGroupCount = (encodingContext.glyphInstanceCount + invocationsPerWorkGroup - 1) / invocationsPerWorkGroup;
+                u32 workGroupCountX = oc_min(totalWorkGroupCount, renderer->limits.maxComputeWorkgroupsPerDimension);
+                u32 workGroupCountY = (totalWorkGroupCount + renderer->limits.maxComputeWorkgroupsPerDimension - 1)
+                                    / renderer->limits.maxComputeWorkgroupsPerDimension;
+
+                wgpuComputePassEncoderDispatchWorkgroups(pass, workGroupCountX, workGroupCountY, 1);
+            }
+            wgpuComputePassEncoderEnd(pass);
+            wgpuComputePassEncoderRelease(pass);
+        }
+
+        //----------------------------------------------------------------------------------------
+        //NOTE: segment setup pass
+        {
+            u32 invocationsPerWorkGroup = 16 * 16;
+
+            WGPUComputePassDescriptor desc = {
+                .label = "segment setup",
+            };
+
+            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, &desc);
+            {
+                wgpuComputePassEncoderSetPipeline(pass, renderer->segmentSetupPipeline);
+                wgpuComputePassEncoderSetBindGroup(pass, 0, renderer->segmentSetupBindGroup, 0, NULL);
+
+                u32 workGroupCountX = (encodingContext.eltCount + encodingContext.glyphEltCount + invocationsPerWorkGroup - 1)
+                                    / invocationsPerWorkGroup;
+
+                wgpuComputePassEncoderDispatchWorkgroups(pass, workGroupCountX, 1, 1);
+            }
+            wgpuComputePassEncoderEnd(pass);
+            wgpuComputePassEncoderRelease(pass);
+        }
+
+        oc_wgpu_canvas_write_pass_timestamp(renderer, encoder, timePasses, batchCount, OC_WGPU_CANVAS_PASS_SETUP + 1);
+
+        //----------------------------------------------------------------------------------------
+        //NOTE: backprop pass
+        {
+            WGPUComputePassDescriptor desc = {
+                .label = "backprop",
+            };
+
+            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, &desc);
+            {
+                wgpuComputePassEncoderSetPipeline(pass, renderer->backpropPipeline);
+                wgpuComputePassEncoderSetBindGroup(pass, 0, renderer->backpropBindGroup, 0, NULL);
+
+                u32 workGroupCountX = oc_min(encodingContext.pathCount, renderer->limits.maxComputeWorkgroupsPerDimension);
+                u32 workGroupCountY = (encodingContext.pathCount + renderer->limits.maxComputeWorkgroupsPerDimension - 1)
+                                    / renderer->limits.maxComputeWorkgroupsPerDimension;
+
+                wgpuComputePassEncoderDispatchWorkgroups(pass, workGroupCountX, workGroupCountY, 1);
+            }
+            wgpuComputePassEncoderEnd(pass);
+            wgpuComputePassEncoderRelease(pass);
+        }
+
+        oc_wgpu_canvas_write_pass_timestamp(renderer, encoder, timePasses, batchCount, OC_WGPU_CANVAS_PASS_BACKPROP + 1);
+
+        //----------------------------------------------------------------------------------------
+        //NOTE: chunk pass
+        {
+            WGPUComputePassDescriptor desc = {
+                .label = "chunk",
+            };
+
+            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, &desc);
+            {
+                wgpuComputePassEncoderSetPipeline(pass, renderer->chunkPipeline);
+                wgpuComputePassEncoderSetBindGroup(pass, 0, renderer->chunkBindGroup, 0, NULL);
+
+                u32 workGroupCountX = (screenSize.x + chunkSize - 1) / chunkSize;
+                u32 workGroupCountY = (screenSize.y + chunkSize - 1) / chunkSize;
+
+                wgpuComputePassEncoderDispatchWorkgroups(pass, workGroupCountX, workGroupCountY, 1);
+            }
+            wgpuComputePassEncoderEnd(pass);
+            wgpuComputePassEncoderRelease(pass);
+        }
+
+        oc_wgpu_canvas_write_pass_timestamp(renderer, encoder, timePasses, batchCount, OC_WGPU_CANVAS_PASS_CHUNK + 1);
+
+        //----------------------------------------------------------------------------------------
+        //NOTE: tile merge pass
+        {
+            WGPUComputePassDescriptor desc = {
+                .label = "tile merge",
+            };
+
+            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, &desc);
+            {
+                wgpuComputePassEncoderSetPipeline(pass, renderer->mergePipeline);
+                wgpuComputePassEncoderSetBindGroup(pass, 0, renderer->mergeBindGroup, 0, NULL);
+
+                u32 workGroupCountX = nTilesX;
+                u32 workGroupCountY = nTilesY;
+                wgpuComputePassEncoderDispatchWorkgroups(pass, workGroupCountX, workGroupCountY, 1);
+            }
+            wgpuComputePassEncoderEnd(pass);
+            wgpuComputePassEncoderRelease(pass);
+        }
+
+        //----------------------------------------------------------------------------------------
+        //NOTE: balance workgroups for raster dispatch indirect command
+        {
+            WGPUComputePassDescriptor desc = {
+                .label = "balance workgroups",
+            };
+
+            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, &desc);
+            {
+                wgpuComputePassEncoderSetPipeline(pass, renderer->balancePipeline);
+                wgpuComputePassEncoderSetBindGroup(pass, 0, renderer->balanceBindGroup, 0, NULL);
+                wgpuComputePassEncoderDispatchWorkgroups(pass, 1, 1, 1);
+            }
+            wgpuComputePassEncoderEnd(pass);
+            wgpuComputePassEncoderRelease(pass);
+        }
+
+        oc_wgpu_canvas_write_pass_timestamp(renderer, encoder, timePasses, batchCount, OC_WGPU_CANVAS_PASS_MERGE + 1);
+
+        //----------------------------------------------------------------------------------------
+        //NOTE: raster pass
+        {
+            WGPUComputePassDescriptor desc = {
+                .label = "raster",
+            };
+
+            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, &desc);
+            {
+                wgpuComputePassEncoderSetPipeline(pass, encodingContext.rasterPipeline);
+                wgpuComputePassEncoderSetBindGroup(pass, 0, renderer->rasterBindGroup, 0, NULL);
+                wgpuComputePassEncoderSetBindGroup(pass, 1, renderer->srcTexturesBindGroup, 0, NULL);
+
+                wgpuComputePassEncoderDispatchWorkgroupsIndirect(pass, renderer->tileQueueCountBuffer, 0);
+            }
+            wgpuComputePassEncoderEnd(pass);
+            wgpuComputePassEncoderRelease(pass);
+        }
+
+        oc_wgpu_canvas_write_pass_timestamp(renderer, encoder, timePasses, batchCount, OC_WGPU_CANVAS_PASS_RASTER + 1);
+
+        //----------------------------------------------------------------------------------------
+        //NOTE: blit pass
+        {
+            WGPURenderPassDescriptor desc = {
+                .label = "blit",
+                .colorAttachmentCount = 1,
+                .colorAttachments = (WGPURenderPassColorAttachment[]){
+                    {
+                        .view = renderer->outTextureView,
+                        .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
+                        .loadOp = WGPULoadOp_Load,
+                        .storeOp = WGPUStoreOp_Store,
+                    },
+                },
+            };
+
+            WGPURenderPassEncoder pass = wgpuCommandEncoderBeginRenderPass(encoder, &desc);
+            {
+                wgpuRenderPassEncoderSetViewport(pass, 0.f, 0.f, screenSize.x, screenSize.y, 0.f, 1.f);
+
+                if(batchCount == 0 && encodingContext.hasDamage)
+                {
+                    oc_vec4 damage = encodingContext.damage;
+                    wgpuRenderPassEncoderSetScissorRect(pass, damage.x, damage.y, damage.z - damage.x, damage.w - damage.y);
+                    wgpuRenderPassEncoderSetPipeline(pass, renderer->blitReplacePipeline);
+                }
+                else
+                {
+                    wgpuRenderPassEncoderSetPipeline(pass, renderer->blitPipeline);
+                }
+                wgpuRenderPassEncoderSetBindGroup(pass, 0, renderer->blitBindGroup, 0, NULL);
+
+                wgpuRenderPassEncoderDraw(pass, 4, 1, 0, 0);
+            }
+            wgpuRenderPassEncoderEnd(pass);
+            wgpuRenderPassEncoderRelease(pass);
+        }
+
+        oc_wgpu_canvas_write_pass_timestamp(renderer, encoder, timePasses, batchCount, OC_WGPU_CANVAS_PASS_BLIT + 1);
+        if(timePasses)
+        {
+            passBatchCount++;
+        }
+
+        //----------------------------------------------------------------------------------------
+        //NOTE: copy the counts reached by this batch for readback
+        if(recordCounters && batchCount < OC_WGPU_CANVAS_COUNTERS_MAX_BATCHES)
+        {
+            WGPUBuffer countBuffers[OC_WGPU_CANVAS_COUNTER_COUNT] = {
+                renderer->segmentCountBuffer,
+                renderer->binQueueCountBuffer,
+                renderer->tileOpCountBuffer,
+                renderer->chunkEltCountBuffer,
+                renderer->tileQueueCountBuffer,
+            };
+            for(int counterIndex = 0; counterIndex < OC_WGPU_CANVAS_COUNTER_COUNT; counterIndex++)
+            {
+                wgpuCommandEncoderCopyBufferToBuffer(encoder,
+                                                     countBuffers[counterIndex],
+                                                     0,
+                                                     renderer->countersReadBuffer[renderer->countersReadIndex],
+                                                     (batchCount * OC_WGPU_CANVAS_COUNTER_COUNT + counterIndex) * sizeof(u32),
+                                                     sizeof(u32));
+            }
+        }
+
+        batchCount++;
+    }
+
+    renderer->outTextureSurface = batchCount ? target->surface : 0;
+    renderer->outTextureScale = scale;
+
+    //----------------------------------------------------------------------------------------
+    //NOTE: final blit pass
+
+    if(target->image)
+    {
+        //NOTE: image targets hold straight alpha, so the image blit composites the canvas over the clear color and
+        //      un-premultiplies it. The previous contents of the image are replaced.
+        oc_color imageClearColor = clear ? clearColor : (oc_color){ 0 };
+        oc_color passClearColor = { 0 };
+        if(!batchCount && imageClearColor.a > 0)
+        {
+            passClearColor = (oc_color){ imageClearColor.r / imageClearColor.a,
+                                         imageClearColor.g / imageClearColor.a,
+                                         imageClearColor.b / imageClearColor.a,
+                                         imageClearColor.a };
+        }
+
+        WGPURenderPassDescriptor desc = {
+            .label = "image blit",
+            .colorAttachmentCount = 1,
+            .colorAttachments = (WGPURenderPassColorAttachment[]){
+                {
+                    .view = target->view,
+                    .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
+                    .loadOp = WGPULoadOp_Clear,
+                    .storeOp = WGPUStoreOp_Store,
+                    .clearValue = { passClearColor.r, passClearColor.g, passClearColor.b, passClearColor.a },
+                },
+            },
+        };
+
+        WGPUBindGroup bindGroup = 0;
+        if(batchCount)
+        {
+            oc_wgpu_canvas_upload(renderer, encoder, renderer->imageBlitClearColorBuffer, imageClearColor.c, 4 * sizeof(f32));
+
+            WGPUBindGroupDescriptor bindGroupDesc = {
+                .layout = renderer->imageBlitBindGroupLayout,
+                .entryCount = 2,
+                .entries = (WGPUBindGroupEntry[]){
+                    {
+                        .binding = 0,
+                        .textureView = renderer->outTextureView,
+                    },
+                    {
+                        .binding = 1,
+                        .buffer = renderer->imageBlitClearColorBuffer,
+                        .size = 4 * sizeof(f32),
+                    },
+                },
+            };
+            bindGroup = wgpuDeviceCreateBindGroup(renderer->device, &bindGroupDesc);
+        }
+
+        WGPURenderPassEncoder pass = wgpuCommandEncoderBeginRenderPass(encoder, &desc);
+        {
+            wgpuRenderPassEncoderSetViewport(pass, 0.f, 0.f, screenSize.x, screenSize.y, 0.f, 1.f);
+
+            if(bindGroup)
+            {
+                wgpuRenderPassEncoderSetPipeline(pass, renderer->imageBlitPipeline);
+                wgpuRenderPassEncoderSetBindGroup(pass, 0, bindGroup, 0, NULL);
+                wgpuRenderPassEncoderDraw(pass, 4, 1, 0, 0);
+            }
+        }
+        wgpuRenderPassEncoderEnd(pass);
+        wgpuRenderPassEncoderRelease(pass);
+
+        if(bindGroup)
+        {
+            wgpuBindGroupRelease(bindGroup);
+        }
+    }
+    else if(clear || batchCount)
+    {
+        WGPULoadOp loadOp = clear ? WGPULoadOp_Clear : WGPULoadOp_Load;
+
+        //NOTE: frames rendered below full scale are upscaled with the scaled blit, which needs the ratio of the
+        //      rendered size to the target size, and the rendered size to clamp its taps to
+        WGPUBindGroup scaledBindGroup = 0;
+        if(batchCount && renderScale != 1)
+        {
+            f32 params[4] = {
+                screenSize.x / target->size.x,
+                screenSize.y / target->size.y,
+                screenSize.x,
+                screenSize.y,
+            };
+            oc_wgpu_canvas_upload(renderer, encoder, renderer->scaledBlitParamsBuffer, params, 4 * sizeof(f32));
+
+            WGPUBindGroupDescriptor bindGroupDesc = {
+                .layout = renderer->scaledBlitBindGroupLayout,
+                .entryCount = 3,
+                .entries = (WGPUBindGroupEntry[]){
+                    {
+                        .binding = 0,
+                        .textureView = renderer->outTextureView,
+                    },
+                    {
+                        .binding = 2,
+                        .buffer = renderer->scaledBlitParamsBuffer,
+                        .size = 4 * sizeof(f32),
+                    },
+                    {
+                        .binding = 3,
+                        .sampler = renderer->linearSampler,
+                    },
+                },
+            };
+            scaledBindGroup = wgpuDeviceCreateBindGroup(renderer->device, &bindGroupDesc);
+        }
+
+        WGPURenderPassDescriptor desc = {
+            .label = "final blit",
+            .colorAttachmentCount = 1,
+            .colorAttachments = (WGPURenderPassColorAttachment[]){
+                {
+                    .view = target->view,
+                    .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
+                    .loadOp = loadOp,
+                    .storeOp = WGPUStoreOp_Store,
+                    .clearValue = { clearColor.r, clearColor.g, clearColor.b, clearColor.a },
+                },
+            },
+        };
+
+        WGPURenderPassEncoder pass = wgpuCommandEncoderBeginRenderPass(encoder, &desc);
+        {
+            wgpuRenderPassEncoderSetViewport(pass, 0.f, 0.f, target->size.x, target->size.y, 0.f, 1.f);
+
+            if(scaledBindGroup)
+            {
+                wgpuRenderPassEncoderSetPipeline(pass, renderer->scaledBlitPipeline);
+                wgpuRenderPassEncoderSetBindGroup(pass, 0, scaledBindGroup, 0, NULL);
+                wgpuRenderPassEncoderDraw(pass, 4, 1, 0, 0);
+            }
+            else if(batchCount)
+            {
+                wgpuRenderPassEncoderSetPipeline(pass, renderer->finalBlitPipeline);
+                wgpuRenderPassEncoderSetBindGroup(pass, 0, renderer->finalBlitBindGroup, 0, NULL);
+                wgpuRenderPassEncoderDraw(pass, 4, 1, 0, 0);
+            }
+        }
+        wgpuRenderPassEncoderEnd(pass);
+        wgpuRenderPassEncoderRelease(pass);
+
+        if(scaledBindGroup)
+        {
+            wgpuBindGroupRelease(scaledBindGroup);
+        }
+    }
+
+    //NOTE: resolve frame timestamps
+    if(recordTimestamps)
+    {
+        wgpuCommandEncoderWriteTimestamp(encoder, renderer->timestampsQuerySet, OC_WGPU_CANVAS_TIMESTAMP_INDEX_FRAME_END);
+
+        //NOTE: only resolve the timestamps that were written, the pass timestamps of the timed batches are contiguous
+        u32 timestampCount = OC_WGPU_CANVAS_TIMESTAMP_INDEX_PASSES + passBatchCount * OC_WGPU_CANVAS_TIMESTAMPS_PER_BATCH;
+
+        wgpuCommandEncoderResolveQuerySet(encoder,
+                                          renderer->timestampsQuerySet,
+                                          OC_WGPU_CANVAS_TIMESTAMP_INDEX_FRAME_BEGIN,
+                                          timestampCount,
+                                          renderer->timestampsResolveBuffer,
+                                          0);
+
+        wgpuCommandEncoderCopyBufferToBuffer(encoder,
+                                             renderer->timestampsResolveBuffer,
+                                             0,
+                                             renderer->timestampsReadBuffer[renderer->timestampsReadIndex],
+                                             0,
+                                             timestampCount * sizeof(u64));
+    }
+
+    OC_TRACE_END();
+
+    if(records)
+    {
+        *records = (oc_wgpu_canvas_frame_records){
+            .encodeStart = encodeStart,
+            .recordTimestamps = recordTimestamps,
+            .recordCounters = recordCounters,
+            .batchCount = batchCount,
+            .passBatchCount = passBatchCount,
+            .frameCounters = frameCounters,
+            .tuneChunkSize = tuneChunkSize,
+            .tuningKey = tuneChunkSize ? chunkTuning->key : 0,
+            .tuningCandidate = tuningCandidate,
+            .renderScale = (dynamicScale && recordTimestamps) ? renderScale : 0,
+        };
+    }
+}
+
+//NOTE: submits the command buffer of a frame, and reads back the records of the frame once it is submitted
+static void oc_wgpu_canvas_render_submit(oc_wgpu_canvas_renderer* renderer,
+                                         WGPUCommandEncoder encoder,
+                                         oc_wgpu_canvas_frame_records* records)
+{
+    OC_TRACE_BEGIN("queue submit");
+    WGPUCommandBuffer command = wgpuCommandEncoderFinish(encoder, NULL);
+    oc_wgpu_canvas_staging_ring_unmap(renderer);
+    wgpuQueueSubmit(renderer->queue, 1, &command);
+    oc_wgpu_canvas_staging_ring_remap(renderer);
+    wgpuCommandBufferRelease(command);
+    OC_TRACE_END();
+
+    f64 submitEnd = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+    //NOTE: read back counters
+    if(records->recordCounters && records->batchCount)
+    {
+        oc_wgpu_canvas_counters_read_callback_data* data = &renderer->countersReadCallbackData[renderer->countersReadIndex];
+        *data = (oc_wgpu_canvas_counters_read_callback_data){
+            .renderer = renderer,
+            .buffer = renderer->countersReadBuffer[renderer->countersReadIndex],
+            .batchCount = oc_min(records->batchCount, OC_WGPU_CANVAS_COUNTERS_MAX_BATCHES),
+        };
+        wgpuBufferMapAsync(data->buffer,
+                           WGPUMapMode_Read,
+                           0,
+                           data->batchCount * OC_WGPU_CANVAS_COUNTER_COUNT * sizeof(u32),
+                           oc_wgpu_canvas_counters_read_callback,
+                           data);
+    }
+
+    //NOTE: read back frame timestamps, for the frame counters, the chunk size tuning and the dynamic render scale
+    oc_wgpu_canvas_frame_counters* frameCounters = records->frameCounters;
+    if(records->recordTimestamps && (frameCounters || records->tuneChunkSize || records->renderScale))
+    {
+        oc_wgpu_canvas_timestamp_read_callback_data* data = &renderer->timestampsReadCallbackData[renderer->timestampsReadIndex];
+        *data = (oc_wgpu_canvas_timestamp_read_callback_data){
+            .renderer = renderer,
+            .frameCounters = frameCounters,
+            .frameIndex = frameCounters ? frameCounters->frameIndex : 0,
+            .passBatchCount = records->passBatchCount,
+            .mapSize = sizeof(u64) * (OC_WGPU_CANVAS_TIMESTAMP_INDEX_PASSES + records->passBatchCount * OC_WGPU_CANVAS_TIMESTAMPS_PER_BATCH),
+            .buffer = renderer->timestampsReadBuffer[renderer->timestampsReadIndex],
+            .submitTime = submitEnd,
+            .tuningKey = records->tuningKey,
+            .tuningCandidate = records->tuningCandidate,
+            .renderScale = records->renderScale,
+        };
+        wgpuBufferMapAsync(renderer->timestampsReadBuffer[renderer->timestampsReadIndex],
+                           WGPUMapMode_Read,
+                           0,
+                           data->mapSize,
+                           oc_wgpu_canvas_timestamp_read_callback,
+                           data);
+    }
+
+    if(frameCounters)
+    {
+        frameCounters->batchCount = records->batchCount;
+        frameCounters->cpuEncodeTime = (submitEnd - records->encodeStart) * 1000.;
+        frameCounters->cpuFrameTime = (records->encodeStart - renderer->lastFrameTimeStamp) * 1000.;
+
+        if(renderer->frameIndex)
+        {
+            oc_wgpu_canvas_stats_add_sample(&renderer->cpuFrameTime, frameCounters->cpuFrameTime);
+        }
+        oc_wgpu_canvas_stats_add_sample(&renderer->cpuEncodeTime, frameCounters->cpuEncodeTime);
+    }
+    renderer->lastFrameTimeStamp = records->encodeStart;
+}
+
+//NOTE: acquires the current texture of a surface, and creates the view that its frame is rendered to
+static bool oc_wgpu_canvas_surface_target(oc_wgpu_canvas_renderer* renderer,
+                                          oc_surface surfaceHandle,
+                                          oc_rect damage,
+                                          oc_wgpu_canvas_target* target)
+{
+    WGPUTexture currentTexture = oc_wgpu_surface_get_current_texture(surfaceHandle,
+                                                                      renderer->adapter,
+                                                                      renderer->device,
+                                                                      renderer->presentMode,
+                                                                      renderer->maxFrameLatency);
+
+    WGPUTextureViewDescriptor desc = {
+        .format = WGPUTextureFormat_BGRA8Unorm,
+        .dimension = WGPUTextureViewDimension_2D,
+        .baseMipLevel = 0,
+        .mipLevelCount = 1,
+        .baseArrayLayer = 0,
+        .arrayLayerCount = 1,
+        .aspect = WGPUTextureAspect_All,
+    };
+
+    WGPUTextureView frameBuffer = wgpuTextureCreateView(currentTexture, &desc);
+    if(frameBuffer)
+    {
+        *target = (oc_wgpu_canvas_target){
+            .view = frameBuffer,
+            .size = { wgpuTextureGetWidth(currentTexture), wgpuTextureGetHeight(currentTexture) },
+            .scale = oc_surface_contents_scaling(surfaceHandle),
+            .surface = surfaceHandle.h,
+            .damage = damage,
+        };
+    }
+    return (frameBuffer != 0);
+}
+
+void oc_wgpu_canvas_submit(oc_canvas_renderer_base* rendererBase,
+                           oc_surface surfaceHandle,
+                           u32 msaaSampleCount,
+                           bool clear,
+                           oc_color clearColor,
+                           oc_rect damage,
+                           u32 primitiveCount,
+                           oc_primitive* primitives,
+                           u32 attributeCount,
+                           oc_attributes* attributes,
+                           u32 eltCount,
+                           oc_path_elt* elements)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)rendererBase;
+
+    wgpuDeviceTick(renderer->device);
+    if(renderer->pendingPipelineCount)
+    {
+        wgpuInstanceProcessEvents(renderer->instance);
+    }
+
+    //NOTE: copy the uploads staged since the last frame before any work that could sample the images
+    oc_wgpu_canvas_upload_ring_flush(renderer);
+    oc_wgpu_tile_table_flush(renderer);
+
+    if(renderer->debugCapturePath.len)
+    {
+        oc_wgpu_canvas_write_capture(renderer,
+                                     surfaceHandle,
+                                     msaaSampleCount,
+                                     clear,
+                                     clearColor,
+                                     damage,
+                                     primitiveCount,
+                                     primitives,
+                                     attributeCount,
+                                     attributes,
+                                     eltCount,
+                                     elements);
+    }
+
+    if(renderer->pendingPipelineCount)
+    {
+        //NOTE: pipelines are still being compiled, present a cleared frame in the meantime
+        oc_wgpu_canvas_submit_clear_frame(renderer, surfaceHandle, clear ? clearColor : (oc_color){ 0 });
+        renderer->outTextureSurface = 0;
+        renderer->frameIndex++;
+        return;
+    }
+
+    oc_wgpu_canvas_generate_mipmaps(renderer);
+
+    oc_wgpu_canvas_target target;
+    if(oc_wgpu_canvas_surface_target(renderer, surfaceHandle, damage, &target))
+    {
+        WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(renderer->device, NULL);
+        oc_wgpu_canvas_frame_records records = { 0 };
+
+        oc_wgpu_canvas_render(renderer,
+                              encoder,
+                              &records,
+                              &target,
+                              msaaSampleCount,
+                              clear,
+                              clearColor,
+                              primitiveCount,
+                              primitives,
+                              attributeCount,
+                              attributes,
+                              eltCount,
+                              elements);
+
+        oc_wgpu_canvas_render_submit(renderer, encoder, &records);
+
+        wgpuCommandEncoderRelease(encoder);
+        wgpuTextureViewRelease(target.view);
+    }
+
+    renderer->frameIndex++;
+}
+
+//NOTE: all the surfaces are rendered in one command buffer, submitted once, and presented after the submission. The
+//      renderer's intermediate textures and buffers are reused from one surface to the next, and its per-frame work,
+//      like flushing uploads and generating mipmaps, is done once. Partial redraws only apply to a surface rendered
+//      on its own, since the intermediate texture doesn't keep the previous frame of each surface.
+void oc_wgpu_canvas_submit_many(oc_canvas_renderer_base* rendererBase, u32 count, oc_canvas_submission* submissions)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)rendererBase;
+
+    wgpuDeviceTick(renderer->device);
+    if(renderer->pendingPipelineCount)
+    {
+        wgpuInstanceProcessEvents(renderer->instance);
+    }
+
+    oc_wgpu_canvas_upload_ring_flush(renderer);
+    oc_wgpu_tile_table_flush(renderer);
+
+    if(renderer->debugCapturePath.len && count)
+    {
+        //NOTE: captures hold a single canvas, so only the first surface is captured
+        oc_canvas_submission* submission = &submissions[0];
+        oc_wgpu_canvas_write_capture(renderer,
+                                     submission->surface,
+                                     submission->msaaSampleCount,
+                                     submission->clear,
+                                     submission->clearColor,
+                                     submission->damage,
+                                     submission->primitiveCount,
+                                     submission->primitives,
+                                     submission->attributeCount,
+                                     submission->attributes,
+                                     submission->eltCount,
+                                     submission->elements);
+    }
+
+    if(renderer->pendingPipelineCount)
+    {
+        for(u32 i = 0; i < count; i++)
+        {
+            oc_canvas_submission* submission = &submissions[i];
+            oc_wgpu_canvas_submit_clear_frame(renderer,
+                                              submission->surface,
+                                              submission->clear ? submission->clearColor : (oc_color){ 0 });
+            oc_wgpu_surface_present(submission->surface);
+        }
+        renderer->outTextureSurface = 0;
+        renderer->frameIndex++;
+        return;
+    }
+
+    oc_wgpu_canvas_generate_mipmaps(renderer);
+
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_wgpu_canvas_target* targets = oc_arena_push_array(scratch.arena, oc_wgpu_canvas_target, count);
+
+    WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(renderer->device, NULL);
+    oc_wgpu_canvas_frame_records records = { 0 };
+    bool recorded = false;
+
+    for(u32 i = 0; i < count; i++)
+    {
+        oc_canvas_submission* submission = &submissions[i];
+        if(oc_wgpu_canvas_surface_target(renderer, submission->surface, submission->damage, &targets[i]))
+        {
+            oc_wgpu_canvas_render(renderer,
+                                  encoder,
+                                  recorded ? 0 : &records,
+                                  &targets[i],
+                                  submission->msaaSampleCount,
+                                  submission->clear,
+                                  submission->clearColor,
+                                  submission->primitiveCount,
+                                  submission->primitives,
+                                  submission->attributeCount,
+                                  submission->attributes,
+                                  submission->eltCount,
+                                  submission->elements);
+            recorded = true;
+        }
+        else
+        {
+            targets[i].view = 0;
+        }
+    }
+
+    if(recorded)
+    {
+        oc_wgpu_canvas_render_submit(renderer, encoder, &records);
+    }
+    wgpuCommandEncoderRelease(encoder);
+
+    for(u32 i = 0; i < count; i++)
+    {
+        if(targets[i].view)
+        {
+            wgpuTextureViewRelease(targets[i].view);
+            oc_wgpu_surface_present(submissions[i].surface);
+        }
+    }
+
+    oc_scratch_end(scratch);
+    renderer->frameIndex++;
+}
+
+void oc_wgpu_canvas_submit_image(oc_canvas_renderer_base* rendererBase,
+                                 oc_image_base* imageBase,
+                                 u32 msaaSampleCount,
+                                 bool clear,
+                                 oc_color clearColor,
+                                 u32 primitiveCount,
+                                 oc_primitive* primitives,
+                                 u32 attributeCount,
+                                 oc_attributes* attributes,
+                                 u32 eltCount,
+                                 oc_path_elt* elements)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)rendererBase;
+    oc_wgpu_image* image = (oc_wgpu_image*)imageBase;
+
+    if(!image->renderView)
+    {
+        oc_log_error("image was not created as a render target.\n");
+        return;
+    }
+
+    //NOTE: there's no frame to present in the meantime, so wait for the pipelines to be compiled
+    wgpuDeviceTick(renderer->device);
+    while(renderer->pendingPipelineCount)
+    {
+        wgpuInstanceProcessEvents(renderer->instance);
+    }
+
+    oc_wgpu_canvas_upload_ring_flush(renderer);
+    oc_wgpu_tile_table_flush(renderer);
+    oc_wgpu_canvas_generate_mipmaps(renderer);
+
+    oc_wgpu_canvas_target target = {
+        .view = image->renderView,
+        .size = image->base.size,
+        .scale = { 1, 1 },
+        .image = image,
+    };
+    WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(renderer->device, NULL);
+    oc_wgpu_canvas_frame_records records = { 0 };
+
+    oc_wgpu_canvas_render(renderer,
+                          encoder,
+                          &records,
+                          &target,
+                          msaaSampleCount,
+                          clear,
+                          clearColor,
+                          primitiveCount,
+                          primitives,
+                          attributeCount,
+                          attributes,
+                          eltCount,
+                          elements);
+
+    oc_wgpu_canvas_render_submit(renderer, encoder, &records);
+    wgpuCommandEncoderRelease(encoder);
+
+    if(image->mipLevelCount > 1 && !image->mipmapDirty)
+    {
+        oc_list_push_back(&renderer->mipmapDirtyImages, &image->mipmapElt);
+        image->mipmapDirty = true;
+    }
+
+    renderer->frameIndex++;
+}
+
+void oc_wgpu_canvas_present(oc_canvas_renderer_base* rendererBase, oc_surface surfaceHandle)
+{
+    oc_wgpu_surface_present(surfaceHandle);
+}
+
+void oc_wgpu_canvas_destroy(oc_canvas_renderer_base* base)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)base;
+
+    //NOTE: wait for pipelines still being compiled, so that we don't release them before they're created
+    while(renderer->pendingPipelineCount || renderer->pendingRasterVariantCount)
+    {
+        wgpuInstanceProcessEvents(renderer->instance);
+    }
+
+    free(renderer->debugCapturePath.ptr);
+
+    oc_wgpu_canvas_encoding_pool_cleanup(&renderer->encodingPool);
+    oc_wgpu_canvas_stroke_cache_cleanup(&renderer->strokeCache);
+    oc_wgpu_canvas_glyph_cache_cleanup(&renderer->glyphCache);
+    oc_wgpu_canvas_upload_ring_cleanup(renderer);
+
+// release bind groups
+#define release_bindgroup_if_needed(x) \
+    if(x)                              \
+    {                                  \
+        wgpuBindGroupRelease(x);       \
+    }
+
+    release_bindgroup_if_needed(renderer->pathSetupBindGroup);
+    release_bindgroup_if_needed(renderer->glyphExpandBindGroup);
+    release_bindgroup_if_needed(renderer->segmentSetupBindGroup);
+    release_bindgroup_if_needed(renderer->backpropBindGroup);
+    release_bindgroup_if_needed(renderer->chunkBindGroup);
+    release_bindgroup_if_needed(renderer->mergeBindGroup);
+    release_bindgroup_if_needed(renderer->balanceBindGroup);
+    release_bindgroup_if_needed(renderer->rasterBindGroup);
+    release_bindgroup_if_needed(renderer->srcTexturesBindGroup);
+    release_bindgroup_if_needed(renderer->blitBindGroup);
+
+#undef release_bindgroup_if_needed
+
+    // release bind group layouts
+    wgpuBindGroupLayoutRelease(renderer->pathSetupBindGroupLayout);
+    wgpuBindGroupLayoutRelease(renderer->glyphExpandBindGroupLayout);
+    wgpuBindGroupLayoutRelease(renderer->segmentSetupBindGroupLayout);
+    wgpuBindGroupLayoutRelease(renderer->backpropBindGroupLayout);
+    wgpuBindGroupLayoutRelease(renderer->chunkBindGroupLayout);
+    wgpuBindGroupLayoutRelease(renderer->mergeBindGroupLayout);
+    wgpuBindGroupLayoutRelease(renderer->balanceBindGroupLayout);
+    wgpuBindGroupLayoutRelease(renderer->rasterBindGroupLayout);
+    wgpuBindGroupLayoutRelease(renderer->srcTexturesBindGroupLayout);
+    wgpuBindGroupLayoutRelease(renderer->blitBindGroupLayout);
+    wgpuBindGroupLayoutRelease(renderer->blitReplaceBindGroupLayout);
+    wgpuBindGroupLayoutRelease(renderer->imageBlitBindGroupLayout);
+    wgpuBindGroupLayoutRelease(renderer->scaledBlitBindGroupLayout);
+    wgpuBindGroupLayoutRelease(renderer->mipmapBindGroupLayout);
+
+    // release pipelines
+    wgpuComputePipelineRelease(renderer->pathSetupPipeline);
+    wgpuComputePipelineRelease(renderer->glyphExpandPipeline);
+    wgpuComputePipelineRelease(renderer->segmentSetupPipeline);
+    wgpuComputePipelineRelease(renderer->backpropPipeline);
+    wgpuComputePipelineRelease(renderer->chunkPipeline);
+    wgpuComputePipelineRelease(renderer->mergePipeline);
+    wgpuComputePipelineRelease(renderer->balancePipeline);
+    wgpuComputePipelineRelease(renderer->rasterPipeline);
+    for(int i = 0; i < OC_WGPU_CANVAS_RASTER_VARIANT_COUNT; i++)
+    {
+        if(renderer->rasterVariants[i])
+        {
+            wgpuComputePipelineRelease(renderer->rasterVariants[i]);
+        }
+    }
+    wgpuPipelineLayoutRelease(renderer->rasterPipelineLayout);
+    wgpuShaderModuleRelease(renderer->rasterModule);
+    wgpuRenderPipelineRelease(renderer->blitPipeline);
+    wgpuRenderPipelineRelease(renderer->blitReplacePipeline);
+    wgpuRenderPipelineRelease(renderer->imageBlitPipeline);
+    wgpuRenderPipelineRelease(renderer->scaledBlitPipeline);
+    wgpuRenderPipelineRelease(renderer->mipmapPipeline);
+
+#define release_buffer_if_needed(x) \
+    if(x)                           \
+    {                               \
+        wgpuBufferRelease(x);       \
+    }
+
+    // release buffers
+    release_buffer_if_needed(renderer->pathBuffer);
+    release_buffer_if_needed(renderer->pathCountBuffer);
+
+    release_buffer_if_needed(renderer->elementBuffer);
+    release_buffer_if_needed(renderer->elementCountBuffer);
+
+    release_buffer_if_needed(renderer->glyphInstanceBuffer);
+    release_buffer_if_needed(renderer->glyphInstanceCountBuffer);
+    release_buffer_if_needed(renderer->gradientBuffer);
+
+    release_buffer_if_needed(renderer->segmentCountBuffer);
+    release_buffer_if_needed(renderer->segmentBuffer);
+    release_buffer_if_needed(renderer->pathBinBuffer);
+    release_buffer_if_needed(renderer->binQueueBuffer);
+    release_buffer_if_needed(renderer->binQueueCountBuffer);
+
+    release_buffer_if_needed(renderer->chunkBuffer);
+    release_buffer_if_needed(renderer->chunkEltBuffer);
+    release_buffer_if_needed(renderer->chunkEltCountBuffer);
+
+    release_buffer_if_needed(renderer->tileQueueBuffer);
+    release_buffer_if_needed(renderer->tileQueueCountBuffer);
+    release_buffer_if_needed(renderer->tileOpBuffer);
+    release_buffer_if_needed(renderer->tileOpCountBuffer);
+
+    release_buffer_if_needed(renderer->tileSizeBuffer);
+    release_buffer_if_needed(renderer->chunkSizeBuffer);
+
+    release_buffer_if_needed(renderer->msaaOffsetsBuffer);
+    release_buffer_if_needed(renderer->msaaSampleCountBuffer);
+
+    release_buffer_if_needed(renderer->maxWorkGroupsPerDimensionBuffer);
+
+    for(int i = 0; i < OC_WGPU_CANVAS_STAGING_BUFFER_COUNT; i++)
+    {
+        release_buffer_if_needed(renderer->stagingRing.slots[i].buffer);
+    }
+
+    release_buffer_if_needed(renderer->imageBlitClearColorBuffer);
+    release_buffer_if_needed(renderer->scaledBlitParamsBuffer);
+
+    release_buffer_if_needed(renderer->timestampsResolveBuffer);
+    for(int i = 0; i < OC_WGPU_CANVAS_TIMESTAMP_READ_BUFFER_COUNT; i++)
+    {
+        release_buffer_if_needed(renderer->timestampsReadBuffer[i]);
+    }
+    for(int i = 0; i < OC_WGPU_CANVAS_COUNTERS_READ_BUFFER_COUNT; i++)
+    {
+        release_buffer_if_needed(renderer->countersReadBuffer[i]);
+    }
+
+    release_buffer_if_needed(renderer->debugDisplayOptionsBuffer);
+
+#undef release_buffer_if_needed
+
+    // release query set
+    if(renderer->timestampsQuerySet)
+    {
+        wgpuQuerySetRelease(renderer->timestampsQuerySet);
+    }
+
+    // release texture views and sample
+    if(renderer->batchTextureView)
+    {
+        wgpuTextureViewRelease(renderer->batchTextureView);
+    }
+    if(renderer->dummyTextureView)
+    {
+        wgpuTextureViewRelease(renderer->dummyTextureView);
+    }
+    if(renderer->linearSampler)
+    {
+        wgpuSamplerRelease(renderer->linearSampler);
+    }
+    if(renderer->imageArray.textureView)
+    {
+        wgpuTextureViewRelease(renderer->imageArray.textureView);
+        wgpuTextureRelease(renderer->imageArray.texture);
+    }
+    if(renderer->tileTable.buffer)
+    {
+        wgpuBufferRelease(renderer->tileTable.buffer);
+    }
+
+    // release queue/device/instance
+    wgpuQueueRelease(renderer->queue);
+    wgpuDeviceRelease(renderer->device);
+    wgpuAdapterRelease(renderer->adapter);
+    wgpuInstanceRelease(renderer->instance);
+
+    oc_wgpu_canvas_pipeline_cache_cleanup(&renderer->pipelineCache);
+
+    free(renderer);
+}
+
+//------------------------------------------------------------------------------------------------
+// Upload ring
+//------------------------------------------------------------------------------------------------
+
+static void oc_wgpu_canvas_upload_slot_map_callback(WGPUBufferMapAsyncStatus status, void* user)
+{
+    oc_wgpu_canvas_upload_slot* slot = (oc_wgpu_canvas_upload_slot*)user;
+
+    if(status == WGPUBufferMapAsyncStatus_Success)
+    {
+        //NOTE: the buffer can only be mapped once the GPU is done copying from it
+        slot->mappedPtr = (u8*)wgpuBufferGetMappedRange(slot->buffer, 0, OC_WGPU_CANVAS_UPLOAD_BUFFER_SIZE);
+        slot->offset = 0;
+        slot->ring->completedSerial = oc_max(slot->ring->completedSerial, slot->serial);
+    }
+}
+
+static void oc_wgpu_canvas_upload_ring_flush(oc_wgpu_canvas_renderer* renderer)
+{
+    oc_wgpu_canvas_upload_ring* ring = &renderer->uploadRing;
+    oc_wgpu_canvas_upload_slot* slot = &ring->slots[ring->slotIndex];
+
+    if(!slot->copyCount)
+    {
+        return;
+    }
+
+    wgpuBufferUnmap(slot->buffer);
+    slot->mappedPtr = 0;
+
+    WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(renderer->device, NULL);
+
+    for(u32 i = 0; i < slot->copyCount; i++)
+    {
+        oc_wgpu_canvas_upload_copy* copy = &slot->copies[i];
+
+        WGPUImageCopyBuffer src = {
+            .layout = {
+                .offset = copy->offset,
+                .bytesPerRow = copy->bytesPerRow,
+                .rowsPerImage = copy->extent.height,
+            },
+            .buffer = slot->buffer,
+        };
+        WGPUImageCopyTexture dst = {
+            .texture = copy->texture,
+            .mipLevel = 0,
+            .origin = copy->origin,
+        };
+        wgpuCommandEncoderCopyBufferToTexture(encoder, &src, &dst, &copy->extent);
+        wgpuTextureRelease(copy->texture);
+    }
+    slot->copyCount = 0;
+
+    WGPUCommandBuffer command = wgpuCommandEncoderFinish(encoder, NULL);
+    wgpuQueueSubmit(renderer->queue, 1, &command);
+    wgpuCommandBufferRelease(command);
+    wgpuCommandEncoderRelease(encoder);
+
+    wgpuBufferMapAsync(slot->buffer,
+                       WGPUMapMode_Write,
+                       0,
+                       OC_WGPU_CANVAS_UPLOAD_BUFFER_SIZE,
+                       oc_wgpu_canvas_upload_slot_map_callback,
+                       slot);
+
+    ring->slotIndex = (ring->slotIndex + 1) % OC_WGPU_CANVAS_ROLLING_BUFFER_COUNT;
+}
+
+static bool oc_wgpu_canvas_upload_ring_stage(oc_wgpu_canvas_renderer* renderer,
+                                             WGPUTexture texture,
+                                             WGPUOrigin3D origin,
+                                             u32 width,
+                                             u32 height,
+                                             u32 bytesPerPixel,
+                                             u8* pixels,
+                                             u64* serial)
+{
+    oc_wgpu_canvas_upload_ring* ring = &renderer->uploadRing;
+    oc_wgpu_canvas_upload_slot* slot = &ring->slots[ring->slotIndex];
+
+    if(!slot->buffer)
+    {
+        //NOTE: staging buffers are created on first use, mapped
+        WGPUBufferDescriptor desc = {
+            .label = "upload ring",
+            .usage = WGPUBufferUsage_MapWrite | WGPUBufferUsage_CopySrc,
+            .size = OC_WGPU_CANVAS_UPLOAD_BUFFER_SIZE,
+            .mappedAtCreation = true,
+        };
+        slot->ring = ring;
+        slot->buffer = wgpuDeviceCreateBuffer(renderer->device, &desc);
+        if(slot->buffer)
+        {
+            slot->mappedPtr = (u8*)wgpuBufferGetMappedRange(slot->buffer, 0, OC_WGPU_CANVAS_UPLOAD_BUFFER_SIZE);
+            oc_canvas_renderer_track_memory(&renderer->base, OC_CANVAS_MEMORY_STAGING, OC_WGPU_CANVAS_UPLOAD_BUFFER_SIZE);
+        }
+    }
+
+    u32 rowSize = width * bytesPerPixel;
+    u32 bytesPerRow = oc_align_up_pow2(rowSize, OC_WGPU_CANVAS_UPLOAD_ROW_ALIGNMENT);
+    u64 size = (u64)bytesPerRow * height;
+
+    if(!slot->mappedPtr
+       || slot->copyCount >= OC_WGPU_CANVAS_UPLOAD_MAX_COPIES
+       || slot->offset + size > OC_WGPU_CANVAS_UPLOAD_BUFFER_SIZE)
+    {
+        return (false);
+    }
+
+    u8* dst = slot->mappedPtr + slot->offset;
+    for(u32 row = 0; row < height; row++)
+    {
+        memcpy(dst + row * bytesPerRow, pixels + row * rowSize, rowSize);
+    }
+
+    wgpuTextureAddRef(texture);
+
+    slot->copies[slot->copyCount] = (oc_wgpu_canvas_upload_copy){
+        .texture = texture,
+        .origin = origin,
+        .extent = { width, height, 1 },
+        .offset = slot->offset,
+        .bytesPerRow = bytesPerRow,
+    };
+    slot->copyCount++;
+    slot->offset += size;
+
+    ring->nextSerial++;
+    slot->serial = ring->nextSerial;
+    *serial = slot->serial;
+
+    return (true);
+}
+
+static void oc_wgpu_canvas_upload_ring_cleanup(oc_wgpu_canvas_renderer* renderer)
+{
+    oc_wgpu_canvas_upload_ring* ring = &renderer->uploadRing;
+
+    for(int i = 0; i < OC_WGPU_CANVAS_ROLLING_BUFFER_COUNT; i++)
+    {
+        oc_wgpu_canvas_upload_slot* slot = &ring->slots[i];
+        for(u32 copyIndex = 0; copyIndex < slot->copyCount; copyIndex++)
+        {
+            wgpuTextureRelease(slot->copies[copyIndex].texture);
+        }
+        if(slot->buffer)
+        {
+            wgpuBufferRelease(slot->buffer);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+// Mipmaps
+//------------------------------------------------------------------------------------------------
+
+static void oc_wgpu_canvas_generate_mipmaps(oc_wgpu_canvas_renderer* renderer)
+{
+    if(oc_list_empty(renderer->mipmapDirtyImages))
+    {
+        return;
+    }
+
+    WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(renderer->device, NULL);
+
+    oc_list_for_safe(renderer->mipmapDirtyImages, image, oc_wgpu_image, mipmapElt)
+    {
+        oc_list_remove(&renderer->mipmapDirtyImages, &image->mipmapElt);
+        image->mipmapDirty = false;
+
+        //NOTE: render each level from the previous one
+        for(u32 level = 1; level < image->mipLevelCount; level++)
+        {
+            WGPUTextureViewDescriptor viewDesc = {
+                .format = WGPUTextureFormat_RGBA8UnormSrgb,
+                .dimension = WGPUTextureViewDimension_2D,
+                .baseMipLevel = level - 1,
+                .mipLevelCount = 1,
+                .baseArrayLayer = 0,
+                .arrayLayerCount = 1,
+                .aspect = WGPUTextureAspect_All,
+            };
+            WGPUTextureView srcView = wgpuTextureCreateView(image->texture, &viewDesc);
+
+            viewDesc.baseMipLevel = level;
+            WGPUTextureView dstView = wgpuTextureCreateView(image->texture, &viewDesc);
+
+            WGPUBindGroupDescriptor bindGroupDesc = {
+                .layout = renderer->mipmapBindGroupLayout,
+                .entryCount = 2,
+                .entries = (WGPUBindGroupEntry[]){
+                    {
+                        .binding = 0,
+                        .textureView = srcView,
+                    },
+                    {
+                        .binding = 1,
+                        .sampler = renderer->linearSampler,
+                    },
+                },
+            };
+            WGPUBindGroup bindGroup = wgpuDeviceCreateBindGroup(renderer->device, &bindGroupDesc);
+
+            WGPURenderPassDescriptor desc = {
+                .label = "mipmap",
+                .colorAttachmentCount = 1,
+                .colorAttachments = (WGPURenderPassColorAttachment[]){
+                    {
+                        .view = dstView,
+                        .depthSlice = WGPU_DEPTH_SLICE_UNDEFINED,
+                        .loadOp = WGPULoadOp_Clear,
+                        .storeOp = WGPUStoreOp_Store,
+                        .clearValue = { 0, 0, 0, 0 },
+                    },
+                },
+            };
+
+            WGPURenderPassEncoder pass = wgpuCommandEncoderBeginRenderPass(encoder, &desc);
+            {
+                wgpuRenderPassEncoderSetPipeline(pass, renderer->mipmapPipeline);
+                wgpuRenderPassEncoderSetBindGroup(pass, 0, bindGroup, 0, NULL);
+                wgpuRenderPassEncoderDraw(pass, 4, 1, 0, 0);
+            }
+            wgpuRenderPassEncoderEnd(pass);
+            wgpuRenderPassEncoderRelease(pass);
+
+            wgpuBindGroupRelease(bindGroup);
+            wgpuTextureViewRelease(dstView);
+            wgpuTextureViewRelease(srcView);
+        }
+    }
+
+    WGPUCommandBuffer command = wgpuCommandEncoderFinish(encoder, NULL);
+    wgpuQueueSubmit(renderer->queue, 1, &command);
+    wgpuCommandBufferRelease(command);
+    wgpuCommandEncoderRelease(encoder);
+}
+
+//------------------------------------------------------------------------------------------------
+// Image array
+//------------------------------------------------------------------------------------------------
+
+static bool oc_wgpu_image_array_grow(oc_wgpu_canvas_renderer* renderer, u32 layerCap)
+{
+    oc_wgpu_image_array* array = &renderer->imageArray;
+
+    WGPUTextureDescriptor desc = {
+        .label = "image array",
+        .usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst | WGPUTextureUsage_CopySrc,
+        .dimension = WGPUTextureDimension_2D,
+        .size = { OC_WGPU_CANVAS_IMAGE_ARRAY_LAYER_SIZE, OC_WGPU_CANVAS_IMAGE_ARRAY_LAYER_SIZE, layerCap },
+        .format = WGPUTextureFormat_RGBA8UnormSrgb,
+        .mipLevelCount = 1,
+        .sampleCount = 1,
+    };
+    WGPUTexture texture = wgpuDeviceCreateTexture(renderer->device, &desc);
+    if(!texture)
+    {
+        oc_log_error("couldn't allocate image array with %u layers\n", layerCap);
+        return (false);
+    }
+
+    WGPUTextureViewDescriptor viewDesc = {
+        .format = desc.format,
+        .dimension = WGPUTextureViewDimension_2DArray,
+        .baseMipLevel = 0,
+        .mipLevelCount = 1,
+        .baseArrayLayer = 0,
+        .arrayLayerCount = layerCap,
+        .aspect = WGPUTextureAspect_All,
+    };
+    WGPUTextureView textureView = wgpuTextureCreateView(texture, &viewDesc);
+
+    if(array->texture)
+    {
+        //NOTE: staged uploads target the old texture, so flush them before copying the existing layers to the new one
+        oc_wgpu_canvas_upload_ring_flush(renderer);
+        WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(renderer->device, NULL);
+
+        wgpuCommandEncoderCopyTextureToTexture(encoder,
+                                               &(WGPUImageCopyTexture){ .texture = array->texture },
+                                               &(WGPUImageCopyTexture){ .texture = texture },
+                                               &(WGPUExtent3D){ OC_WGPU_CANVAS_IMAGE_ARRAY_LAYER_SIZE,
+                                                                OC_WGPU_CANVAS_IMAGE_ARRAY_LAYER_SIZE,
+                                                                array->layerCap });
+
+        WGPUCommandBuffer command = wgpuCommandEncoderFinish(encoder, NULL);
+        wgpuQueueSubmit(renderer->queue, 1, &command);
+        wgpuCommandBufferRelease(command);
+        wgpuCommandEncoderRelease(encoder);
+
+        wgpuTextureViewRelease(array->textureView);
+        wgpuTextureRelease(array->texture);
+    }
+
+    oc_canvas_renderer_track_memory(&renderer->base,
+                                    OC_CANVAS_MEMORY_IMAGES,
+                                    ((i64)layerCap - array->layerCap)
+                                        * OC_WGPU_CANVAS_IMAGE_ARRAY_LAYER_SIZE
+                                        * OC_WGPU_CANVAS_IMAGE_ARRAY_LAYER_SIZE
+                                        * 4);
+
+    array->texture = texture;
+    array->textureView = textureView;
+    array->layerCap = layerCap;
+    return (true);
+}
+
+static bool oc_wgpu_image_array_alloc(oc_wgpu_canvas_renderer* renderer, oc_vec2 size, i32* outLayer, oc_rect* outRect)
+{
+    oc_wgpu_image_array* array = &renderer->imageArray;
+
+    if(size.x > OC_WGPU_CANVAS_IMAGE_ARRAY_MAX_SLOT_SIZE || size.y > OC_WGPU_CANVAS_IMAGE_ARRAY_MAX_SLOT_SIZE)
+    {
+        return (false);
+    }
+
+    u32 slotSize = OC_WGPU_CANVAS_IMAGE_ARRAY_MIN_SLOT_SIZE;
+    while(slotSize < size.x || slotSize < size.y)
+    {
+        slotSize *= 2;
+    }
+    u32 slotsPerRow = OC_WGPU_CANVAS_IMAGE_ARRAY_LAYER_SIZE / slotSize;
+    u32 slotCount = slotsPerRow * slotsPerRow;
+    u64 fullMask = (slotCount >= 64) ? ~0ULL : ((1ULL << slotCount) - 1);
+
+    //NOTE: find a layer of the same slot size with a free slot, or else the first unused layer
+    i32 layerIndex = -1;
+    for(i32 i = 0; i < OC_WGPU_CANVAS_IMAGE_ARRAY_MAX_LAYERS; i++)
+    {
+        oc_wgpu_image_array_layer* layer = &array->layers[i];
+        if(layer->slotSize == slotSize && layer->usedSlots != fullMask)
+        {
+            layerIndex = i;
+            break;
+        }
+        if(layerIndex < 0 && layer->slotSize == 0)
+        {
+            layerIndex = i;
+        }
+    }
+    if(layerIndex < 0)
+    {
+        return (false);
+    }
+
+    if(layerIndex >= array->layerCap)
+    {
+        u32 layerCap = oc_clamp(array->layerCap * 2, layerIndex + 1, OC_WGPU_CANVAS_IMAGE_ARRAY_MAX_LAYERS);
+        if(!oc_wgpu_image_array_grow(renderer, layerCap))
+        {
+            return (false);
+        }
+    }
+
+    oc_wgpu_image_array_layer* layer = &array->layers[layerIndex];
+    layer->slotSize = slotSize;
+
+    u32 slotIndex = 0;
+    while(layer->usedSlots & (1ULL << slotIndex))
+    {
+        slotIndex++;
+    }
+    layer->usedSlots |= (1ULL << slotIndex);
+
+    *outLayer = layerIndex;
+    *outRect = (oc_rect){ (slotIndex % slotsPerRow) * slotSize,
+                          (slotIndex / slotsPerRow) * slotSize,
+                          size.x,
+                          size.y };
+    return (true);
+}
+
+static void oc_wgpu_image_array_free(oc_wgpu_canvas_renderer* renderer, i32 layerIndex, oc_rect rect)
+{
+    oc_wgpu_image_array_layer* layer = &renderer->imageArray.layers[layerIndex];
+
+    u32 slotsPerRow = OC_WGPU_CANVAS_IMAGE_ARRAY_LAYER_SIZE / layer->slotSize;
+    u32 slotIndex = (rect.y / layer->slotSize) * slotsPerRow + (rect.x / layer->slotSize);
+
+    layer->usedSlots &= ~(1ULL << slotIndex);
+    if(!layer->usedSlots)
+    {
+        layer->slotSize = 0;
+    }
+}
+
+static u64 oc_wgpu_image_texture_memory_size(oc_vec2 size, u32 mipLevelCount, u32 bytesPerPixel)
+{
+    u64 memorySize = 0;
+    u32 width = (u32)size.x;
+    u32 height = (u32)size.y;
+    for(u32 level = 0; level < mipLevelCount; level++)
+    {
+        memorySize += (u64)oc_max(width >> level, 1) * oc_max(height >> level, 1) * bytesPerPixel;
+    }
+    return (memorySize);
+}
+
+oc_image_base* oc_wgpu_canvas_image_create(oc_canvas_renderer_base* base, oc_vec2 size)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)base;
+
+    oc_wgpu_image* image = oc_malloc_type(oc_wgpu_image);
+    if(image)
+    {
+        image->base.size = size;
+        image->uploadSerial = 0;
+        image->mipmapDirty = false;
+        image->compressed = false;
+        image->renderView = 0;
+        image->readback = 0;
+        image->memorySize = 0;
+        image->tiled = 0;
+
+        if(oc_wgpu_image_array_alloc(renderer, size, &image->arrayLayer, &image->arrayRect))
+        {
+            image->texture = 0;
+            image->textureView = 0;
+            image->mipLevelCount = 1;
+            return ((oc_image_base*)image);
+        }
+
+        //NOTE: standalone images get a full mip chain, which is regenerated at the next submit after each upload
+        image->mipLevelCount = 1;
+        while((u32)oc_max(size.x, size.y) >> image->mipLevelCount)
+        {
+            image->mipLevelCount++;
+        }
+
+        WGPUTextureDescriptor desc = {
+            .usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst | WGPUTextureUsage_CopySrc | WGPUTextureUsage_RenderAttachment,
+            .dimension = WGPUTextureDimension_2D,
+            .size = { size.x, size.y, 1 },
+            .format = WGPUTextureFormat_RGBA8UnormSrgb,
+            .mipLevelCount = image->mipLevelCount,
+            .sampleCount = 1,
+        };
+        image->texture = wgpuDeviceCreateTexture(renderer->device, &desc);
+
+        WGPUTextureViewDescriptor viewDesc = {
+            .format = desc.format,
+            .dimension = WGPUTextureViewDimension_2D,
+            .baseMipLevel = 0,
+            .mipLevelCount = image->mipLevelCount,
+            .baseArrayLayer = 0,
+            .arrayLayerCount = 1,
+            .aspect = WGPUTextureAspect_All,
+        };
+        image->textureView = wgpuTextureCreateView(image->texture, &viewDesc);
+
+        image->memorySize = oc_wgpu_image_texture_memory_size(size, image->mipLevelCount, 4);
+        oc_canvas_renderer_track_memory(base, OC_CANVAS_MEMORY_IMAGES, image->memorySize);
+
+        //TODO: check fail
+    }
+    return ((oc_image_base*)image);
+}
+
+oc_image_base* oc_wgpu_canvas_image_create_render_target(oc_canvas_renderer_base* base, oc_vec2 size)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)base;
+
+    oc_wgpu_image* image = oc_malloc_type(oc_wgpu_image);
+    if(image)
+    {
+        image->base.size = size;
+        image->uploadSerial = 0;
+        image->mipmapDirty = false;
+        image->compressed = false;
+        image->readback = 0;
+        image->tiled = 0;
+
+        //NOTE: render targets always get their own texture, since render passes can't target a region of the
+        //      texture array. The canvas is written in sRGB by the image blit, through a non-sRGB view of the texture.
+        image->arrayLayer = -1;
+        image->mipLevelCount = 1;
+        while((u32)oc_max(size.x, size.y) >> image->mipLevelCount)
+        {
+            image->mipLevelCount++;
+        }
+
+        WGPUTextureDescriptor desc = {
+            .usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst | WGPUTextureUsage_CopySrc | WGPUTextureUsage_RenderAttachment,
+            .dimension = WGPUTextureDimension_2D,
+            .size = { size.x, size.y, 1 },
+            .format = WGPUTextureFormat_RGBA8UnormSrgb,
+            .mipLevelCount = image->mipLevelCount,
+            .sampleCount = 1,
+            .viewFormatCount = 1,
+            .viewFormats = (WGPUTextureFormat[]){ WGPUTextureFormat_RGBA8Unorm },
+        };
+        image->texture = wgpuDeviceCreateTexture(renderer->device, &desc);
+
+        WGPUTextureViewDescriptor viewDesc = {
+            .format = desc.format,
+            .dimension = WGPUTextureViewDimension_2D,
+            .baseMipLevel = 0,
+            .mipLevelCount = image->mipLevelCount,
+            .baseArrayLayer = 0,
+            .arrayLayerCount = 1,
+            .aspect = WGPUTextureAspect_All,
+        };
+        image->textureView = wgpuTextureCreateView(image->texture, &viewDesc);
+
+        WGPUTextureViewDescriptor renderViewDesc = {
+            .format = WGPUTextureFormat_RGBA8Unorm,
+            .dimension = WGPUTextureViewDimension_2D,
+            .baseMipLevel = 0,
+            .mipLevelCount = 1,
+            .baseArrayLayer = 0,
+            .arrayLayerCount = 1,
+            .aspect = WGPUTextureAspect_All,
+        };
+        image->renderView = wgpuTextureCreateView(image->texture, &renderViewDesc);
+
+        image->memorySize = oc_wgpu_image_texture_memory_size(size, image->mipLevelCount, 4);
+        oc_canvas_renderer_track_memory(base, OC_CANVAS_MEMORY_IMAGES, image->memorySize);
+    }
+    return ((oc_image_base*)image);
+}
+
+void oc_wgpu_canvas_image_destroy(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)rendererBase;
+    oc_wgpu_image* image = (oc_wgpu_image*)imageBase;
+
+    //TODO: check image was created with the same renderer
+
+    if(image->mipmapDirty)
+    {
+        oc_list_remove(&renderer->mipmapDirtyImages, &image->mipmapElt);
+    }
+
+    oc_wgpu_image_readback_release(image);
+
+    if(image->tiled)
+    {
+        oc_wgpu_tiled_image_release(renderer, image->tiled);
+    }
+    else if(image->arrayLayer >= 0)
+    {
+        oc_wgpu_image_array_free(renderer, image->arrayLayer, image->arrayRect);
+    }
+    else
+    {
+        if(image->renderView)
+        {
+            wgpuTextureViewRelease(image->renderView);
+        }
+        wgpuTextureViewRelease(image->textureView);
+        wgpuTextureRelease(image->texture);
+        oc_canvas_renderer_track_memory(rendererBase, OC_CANVAS_MEMORY_IMAGES, -(i64)image->memorySize);
+    }
+    free(image);
+}
+
+static void oc_wgpu_canvas_upload_pixels(oc_wgpu_canvas_renderer* renderer,
+                                         WGPUImageCopyTexture* dst,
+                                         u32 width,
+                                         u32 height,
+                                         u32 bytesPerPixel,
+                                         u8* pixels,
+                                         u64* serial)
+{
+    if(oc_wgpu_canvas_upload_ring_stage(renderer, dst->texture, dst->origin, width, height, bytesPerPixel, pixels, serial))
+    {
+        return;
+    }
+
+    //NOTE: the upload doesn't fit in the staging buffer. Flush the staged uploads first so that they don't land
+    //      after this one, then write it directly.
+    oc_wgpu_canvas_upload_ring_flush(renderer);
+
+    WGPUTextureDataLayout src = {
+        .offset = 0,
+        .bytesPerRow = width * bytesPerPixel,
+        .rowsPerImage = height,
+    };
+    u32 pixelsSize = width * height * bytesPerPixel;
+    wgpuQueueWriteTexture(renderer->queue, dst, pixels, pixelsSize, &src, &(WGPUExtent3D){ width, height, 1 });
+}
+
+void oc_wgpu_canvas_image_upload_region(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase, oc_rect region, u8* pixels)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)rendererBase;
+    oc_wgpu_image* image = (oc_wgpu_image*)imageBase;
+
+    //TODO: check image was created with the same renderer
+
+    if(image->compressed)
+    {
+        oc_log_error("can't upload rgba8 pixels to a compressed image.\n");
+        return;
+    }
+
+    WGPUImageCopyTexture dst = {
+        .texture = image->texture,
+        .mipLevel = 0,
+        .origin = { (u32)region.x, (u32)region.y },
+    };
+    if(image->arrayLayer >= 0)
+    {
+        dst.texture = renderer->imageArray.texture;
+        dst.origin = (WGPUOrigin3D){ (u32)(image->arrayRect.x + region.x),
+                                     (u32)(image->arrayRect.y + region.y),
+                                     (u32)image->arrayLayer };
+    }
+
+    if(image->mipLevelCount > 1 && !image->mipmapDirty)
+    {
+        oc_list_push_back(&renderer->mipmapDirtyImages, &image->mipmapElt);
+        image->mipmapDirty = true;
+    }
+
+    oc_wgpu_canvas_upload_pixels(renderer, &dst, region.w, region.h, 4, pixels, &image->uploadSerial);
+}
+
+bool oc_wgpu_canvas_image_upload_done(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)rendererBase;
+    oc_wgpu_image* image = (oc_wgpu_image*)imageBase;
+
+    //NOTE: poll the map callbacks of the staging buffers, which tell us their copies are done
+    wgpuDeviceTick(renderer->device);
+
+    return (image->uploadSerial <= renderer->uploadRing.completedSerial);
+}
+
+//------------------------------------------------------------------------------------------------
+// Tiled images
+//------------------------------------------------------------------------------------------------
+
+static void oc_wgpu_tile_table_init(oc_wgpu_canvas_renderer* renderer)
+{
+    oc_wgpu_tile_table* table = &renderer->tileTable;
+    oc_list_init(&table->images);
+    oc_list_init(&table->residentTiles);
+
+    WGPUBufferDescriptor desc = {
+        .label = "tile table",
+        .usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+        .size = OC_WGPU_CANVAS_TILE_TABLE_MIN_LEN * sizeof(u32),
+    };
+    table->buffer = wgpuDeviceCreateBuffer(renderer->device, &desc);
+    table->cap = OC_WGPU_CANVAS_TILE_TABLE_MIN_LEN;
+    table->len = 0;
+    oc_canvas_renderer_track_memory(&renderer->base, OC_CANVAS_MEMORY_IMAGES, desc.size);
+}
+
+static bool oc_wgpu_tile_table_alloc(oc_wgpu_canvas_renderer* renderer, oc_wgpu_tiled_image* tiled)
+{
+    oc_wgpu_tile_table* table = &renderer->tileTable;
+
+    if(table->len + tiled->tableLen > table->cap)
+    {
+        //NOTE: ranges of destroyed images are only reclaimed here, by packing the ranges of live images at the start
+        //      of the table. The table is grown if they still don't leave enough room.
+        u64 len = tiled->tableLen;
+        oc_list_for(table->images, other, oc_wgpu_tiled_image, listElt)
+        {
+            len += other->tableLen;
+        }
+        u64 cap = table->cap;
+        while(cap < len)
+        {
+            cap *= 2;
+        }
+        if(cap != table->cap)
+        {
+            WGPUBufferDescriptor desc = {
+                .label = "tile table",
+                .usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+                .size = cap * sizeof(u32),
+            };
+            WGPUBuffer buffer = wgpuDeviceCreateBuffer(renderer->device, &desc);
+            if(!buffer)
+            {
+                oc_log_error("couldn't grow the tile table to %llu entries\n", (unsigned long long)cap);
+                return (false);
+            }
+            oc_canvas_renderer_track_memory(&renderer->base,
+                                            OC_CANVAS_MEMORY_IMAGES,
+                                            ((i64)cap - table->cap) * sizeof(u32));
+            wgpuBufferRelease(table->buffer);
+            table->buffer = buffer;
+            table->cap = cap;
+        }
 
-    release_buffer_if_needed(renderer->segmentCountBuffer);
-    release_buffer_if_needed(renderer->segmentBuffer);
-    release_buffer_if_needed(renderer->pathBinBuffer);
-    release_buffer_if_needed(renderer->binQueueBuffer);
-    release_buffer_if_needed(renderer->binQueueCountBuffer);
+        table->len = 0;
+        oc_list_for(table->images, other, oc_wgpu_tiled_image, listElt)
+        {
+            other->tableOffset = table->len;
+            other->tableDirty = true;
+            table->len += other->tableLen;
+        }
+    }
 
-    release_buffer_if_needed(renderer->chunkBuffer);
-    release_buffer_if_needed(renderer->chunkEltBuffer);
-    release_buffer_if_needed(renderer->chunkEltCountBuffer);
+    tiled->tableOffset = table->len;
+    tiled->tableDirty = true;
+    table->len += tiled->tableLen;
+    oc_list_push_back(&table->images, &tiled->listElt);
+    return (true);
+}
 
-    release_buffer_if_needed(renderer->tileQueueBuffer);
-    release_buffer_if_needed(renderer->tileQueueCountBuffer);
-    release_buffer_if_needed(renderer->tileOpBuffer);
-    release_buffer_if_needed(renderer->tileOpCountBuffer);
+//NOTE: writes the ranges of the images whose tiles changed since the last frame
+static void oc_wgpu_tile_table_flush(oc_wgpu_canvas_renderer* renderer)
+{
+    oc_wgpu_tile_table* table = &renderer->tileTable;
+
+    oc_list_for(table->images, tiled, oc_wgpu_tiled_image, listElt)
+    {
+        if(tiled->tableDirty)
+        {
+            oc_arena_scope scratch = oc_scratch_begin();
+            u32* entries = oc_arena_push_array(scratch.arena, u32, tiled->tableLen);
+
+            for(u32 level = 0; level < tiled->levelCount; level++)
+            {
+                entries[level] = tiled->tableOffset + tiled->levelCount + tiled->levelTileStart[level];
+            }
+            for(u32 tileIndex = 0; tileIndex < tiled->tileCount; tileIndex++)
+            {
+                oc_wgpu_image_tile* tile = &tiled->tiles[tileIndex];
+                u32 entry = 0;
+                if(tile->arrayLayer >= 0)
+                {
+                    u32 slot = (tile->arrayRect.y / OC_IMAGE_TILE_SIZE) * OC_WGPU_CANVAS_TILE_SLOTS_PER_ROW
+                             + (tile->arrayRect.x / OC_IMAGE_TILE_SIZE);
+                    entry = 1 + tile->arrayLayer * OC_WGPU_CANVAS_TILE_SLOTS_PER_ROW * OC_WGPU_CANVAS_TILE_SLOTS_PER_ROW + slot;
+                }
+                entries[tiled->levelCount + tileIndex] = entry;
+            }
+            wgpuQueueWriteBuffer(renderer->queue,
+                                 table->buffer,
+                                 (u64)tiled->tableOffset * sizeof(u32),
+                                 entries,
+                                 (u64)tiled->tableLen * sizeof(u32));
+
+            oc_scratch_end(scratch);
+            tiled->tableDirty = false;
+        }
+    }
+}
+
+static void oc_wgpu_tiled_image_evict_tile(oc_wgpu_canvas_renderer* renderer, oc_wgpu_image_tile* tile)
+{
+    oc_wgpu_tile_table* table = &renderer->tileTable;
+
+    oc_wgpu_image_array_free(renderer, tile->arrayLayer, tile->arrayRect);
+    oc_list_remove(&table->residentTiles, &tile->residentElt);
+    table->residentCount--;
+
+    tile->arrayLayer = -1;
+    tile->requestFrame = 0;
+    tile->tiled->tableDirty = true;
+}
+
+static bool oc_wgpu_tiled_image_alloc_tile(oc_wgpu_canvas_renderer* renderer, oc_wgpu_image_tile* tile)
+{
+    oc_wgpu_tile_table* table = &renderer->tileTable;
+    oc_vec2 slotSize = { OC_IMAGE_TILE_SIZE, OC_IMAGE_TILE_SIZE };
+
+    bool allocated = false;
+    while(!allocated)
+    {
+        if(table->residentCount < OC_WGPU_CANVAS_MAX_RESIDENT_TILES
+           && oc_wgpu_image_array_alloc(renderer, slotSize, &tile->arrayLayer, &tile->arrayRect))
+        {
+            allocated = true;
+        }
+        else
+        {
+            //NOTE: evict the least recently used tile, unless the last frame drew it. Evicting tiles of the last frame
+            //      would only get them requested again.
+            oc_wgpu_image_tile* oldest = oc_list_last_entry(table->residentTiles, oc_wgpu_image_tile, residentElt);
+            if(!oldest || oldest->lastUsedFrame >= renderer->frameIndex)
+            {
+                break;
+            }
+            oc_wgpu_tiled_image_evict_tile(renderer, oldest);
+        }
+    }
+
+    if(allocated)
+    {
+        oc_list_push_front(&table->residentTiles, &tile->residentElt);
+        table->residentCount++;
+        tile->lastUsedFrame = renderer->frameIndex;
+        tile->tiled->tableDirty = true;
+    }
+    else
+    {
+        tile->arrayLayer = -1;
+    }
+    return (allocated);
+}
+
+static void oc_wgpu_tiled_image_release(oc_wgpu_canvas_renderer* renderer, oc_wgpu_tiled_image* tiled)
+{
+    for(u32 tileIndex = 0; tileIndex < tiled->tileCount; tileIndex++)
+    {
+        oc_wgpu_image_tile* tile = &tiled->tiles[tileIndex];
+        if(tile->arrayLayer >= 0)
+        {
+            oc_wgpu_tiled_image_evict_tile(renderer, tile);
+        }
+    }
+    oc_list_remove(&renderer->tileTable.images, &tiled->listElt);
+    free(tiled->tiles);
+    free(tiled);
+}
+
+//NOTE: called when merging the tile uses of a batch. Tiles that are missing at the sampled level are replaced by
+//      coarser ones in the shader, so we walk up the levels until one has all the tiles of the box, marking missing
+//      tiles as needed and resident ones as used.
+static void oc_wgpu_tiled_image_use(oc_wgpu_canvas_renderer* renderer, oc_wgpu_tile_use* use)
+{
+    oc_wgpu_image* image = (oc_wgpu_image*)oc_image_from_handle(use->image);
+    if(!image || !image->tiled)
+    {
+        return;
+    }
+    oc_wgpu_tiled_image* tiled = image->tiled;
+    oc_wgpu_tile_table* table = &renderer->tileTable;
+    u64 frame = renderer->frameIndex + 1;
+
+    for(u32 level = use->level; level < tiled->levelCount; level++)
+    {
+        //NOTE: bilinear filtering reads one texel beyond the box
+        oc_vec2 levelSize = oc_tiled_image_level_size(image->base.size, level);
+        u32 tilesX = tiled->levelTilesX[level];
+        u32 tilesY = ((u32)levelSize.y + OC_IMAGE_TILE_SIZE - 1) / OC_IMAGE_TILE_SIZE;
+
+        u32 x0 = oc_clamp(use->uvBox.x * levelSize.x - 1, 0, levelSize.x - 1) / OC_IMAGE_TILE_SIZE;
+        u32 y0 = oc_clamp(use->uvBox.y * levelSize.y - 1, 0, levelSize.y - 1) / OC_IMAGE_TILE_SIZE;
+        u32 x1 = oc_min(oc_clamp(use->uvBox.z * levelSize.x + 1, 0, levelSize.x - 1) / OC_IMAGE_TILE_SIZE, tilesX - 1);
+        u32 y1 = oc_min(oc_clamp(use->uvBox.w * levelSize.y + 1, 0, levelSize.y - 1) / OC_IMAGE_TILE_SIZE, tilesY - 1);
+
+        bool complete = true;
+        for(u32 y = y0; y <= y1; y++)
+        {
+            for(u32 x = x0; x <= x1; x++)
+            {
+                oc_wgpu_image_tile* tile = &tiled->tiles[tiled->levelTileStart[level] + y * tilesX + x];
+                if(tile->arrayLayer >= 0)
+                {
+                    if(tile->lastUsedFrame != frame)
+                    {
+                        tile->lastUsedFrame = frame;
+                        oc_list_remove(&table->residentTiles, &tile->residentElt);
+                        oc_list_push_front(&table->residentTiles, &tile->residentElt);
+                    }
+                }
+                else
+                {
+                    tile->neededFrame = frame;
+                    complete = false;
+                }
+            }
+        }
+        if(complete)
+        {
+            break;
+        }
+    }
+}
+
+oc_image_base* oc_wgpu_canvas_image_create_tiled(oc_canvas_renderer_base* rendererBase, oc_vec2 size)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)rendererBase;
+
+    oc_wgpu_image* image = oc_malloc_type(oc_wgpu_image);
+    oc_wgpu_tiled_image* tiled = oc_malloc_type(oc_wgpu_tiled_image);
+    if(!image || !tiled)
+    {
+        free(image);
+        free(tiled);
+        return (0);
+    }
+    memset(image, 0, sizeof(oc_wgpu_image));
+    memset(tiled, 0, sizeof(oc_wgpu_tiled_image));
+
+    image->base.size = size;
+    image->arrayLayer = -1;
+    image->mipLevelCount = 1;
+    image->tiled = tiled;
+
+    tiled->levelCount = oc_tiled_image_level_count_for_size(size);
+    for(u32 level = 0; level < tiled->levelCount; level++)
+    {
+        oc_vec2 levelSize = oc_tiled_image_level_size(size, level);
+        u32 tilesX = ((u32)levelSize.x + OC_IMAGE_TILE_SIZE - 1) / OC_IMAGE_TILE_SIZE;
+        u32 tilesY = ((u32)levelSize.y + OC_IMAGE_TILE_SIZE - 1) / OC_IMAGE_TILE_SIZE;
+
+        tiled->levelTilesX[level] = tilesX;
+        tiled->levelTileStart[level] = tiled->tileCount;
+        tiled->tileCount += tilesX * tilesY;
+    }
+    tiled->tableLen = tiled->levelCount + tiled->tileCount;
+
+    tiled->tiles = oc_malloc_array(oc_wgpu_image_tile, tiled->tileCount);
+    if(!tiled->tiles)
+    {
+        free(tiled);
+        free(image);
+        return (0);
+    }
+    memset(tiled->tiles, 0, tiled->tileCount * sizeof(oc_wgpu_image_tile));
+    for(u32 tileIndex = 0; tileIndex < tiled->tileCount; tileIndex++)
+    {
+        tiled->tiles[tileIndex].tiled = tiled;
+        tiled->tiles[tileIndex].arrayLayer = -1;
+    }
+
+    if(!oc_wgpu_tile_table_alloc(renderer, tiled))
+    {
+        free(tiled->tiles);
+        free(tiled);
+        free(image);
+        return (0);
+    }
+    return ((oc_image_base*)image);
+}
+
+u32 oc_wgpu_canvas_tiled_image_requests(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase, u32 maxCount, oc_image_tile* tiles)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)rendererBase;
+    oc_wgpu_tiled_image* tiled = ((oc_wgpu_image*)imageBase)->tiled;
+
+    //NOTE: frameIndex was incremented after the last frame, so it's also that frame's stamp. Tiles needed by the
+    //      frame before are included, in case the app renders to an image in between.
+    u64 lastFrame = renderer->frameIndex;
+    u32 count = 0;
+
+    for(i32 level = tiled->levelCount - 1; level >= 0 && count < maxCount; level--)
+    {
+        u32 tilesX = tiled->levelTilesX[level];
+        u32 levelTileCount = (level + 1 < tiled->levelCount ? tiled->levelTileStart[level + 1] : tiled->tileCount)
+                           - tiled->levelTileStart[level];
+
+        for(u32 index = 0; index < levelTileCount && count < maxCount; index++)
+        {
+            oc_wgpu_image_tile* tile = &tiled->tiles[tiled->levelTileStart[level] + index];
+            if(tile->arrayLayer < 0
+               && tile->neededFrame
+               && tile->neededFrame + 1 >= lastFrame
+               && (!tile->requestFrame || lastFrame - tile->requestFrame >= OC_WGPU_CANVAS_TILE_REQUEST_RETRY_FRAMES))
+            {
+                tiles[count] = (oc_image_tile){ level, index % tilesX, index / tilesX };
+                tile->requestFrame = lastFrame;
+                count++;
+            }
+        }
+    }
+    return (count);
+}
+
+bool oc_wgpu_canvas_tiled_image_upload_tile(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase, oc_image_tile tileCoord, oc_rect rect, u8* pixels)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)rendererBase;
+    oc_wgpu_image* image = (oc_wgpu_image*)imageBase;
+    oc_wgpu_tiled_image* tiled = image->tiled;
+
+    u32 tileIndex = tiled->levelTileStart[tileCoord.level] + tileCoord.y * tiled->levelTilesX[tileCoord.level] + tileCoord.x;
+    oc_wgpu_image_tile* tile = &tiled->tiles[tileIndex];
+
+    if(tile->arrayLayer < 0 && !oc_wgpu_tiled_image_alloc_tile(renderer, tile))
+    {
+        oc_log_error("no room for tile (%u, %u) of level %u, the resident tiles are all in use.\n", tileCoord.x, tileCoord.y, tileCoord.level);
+        return (false);
+    }
+    tile->requestFrame = 0;
+
+    WGPUImageCopyTexture dst = {
+        .texture = renderer->imageArray.texture,
+        .mipLevel = 0,
+        .origin = { (u32)tile->arrayRect.x, (u32)tile->arrayRect.y, (u32)tile->arrayLayer },
+    };
+    oc_wgpu_canvas_upload_pixels(renderer, &dst, rect.w, rect.h, 4, pixels, &image->uploadSerial);
+    return (true);
+}
+
+//------------------------------------------------------------------------------------------------
+// YUV images
+//------------------------------------------------------------------------------------------------
+
+//NOTE: the planes of a YUV image share one R8 texture. The luma plane is at the top left, and the chroma is below it:
+//      the interleaved Cb/Cr plane of NV12 images, or the Cb and Cr planes of I420 images side by side.
+static WGPUOrigin3D oc_wgpu_yuv_plane_origin(oc_image_base* image, u32 plane)
+{
+    WGPUOrigin3D origin = { 0, 0, 0 };
+    if(plane > 0)
+    {
+        origin.y = (u32)image->size.y;
+    }
+    if(plane == 2)
+    {
+        origin.x = (u32)oc_image_yuv_plane_size_for_format(image->yuvFormat, image->size, 1).x;
+    }
+    return (origin);
+}
+
+oc_image_base* oc_wgpu_canvas_image_create_yuv(oc_canvas_renderer_base* rendererBase,
+                                               oc_image_yuv_format format,
+                                               oc_image_yuv_color_space colorSpace,
+                                               oc_vec2 size)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)rendererBase;
+
+    oc_wgpu_image* image = oc_malloc_type(oc_wgpu_image);
+    if(image)
+    {
+        image->base.size = size;
+        image->uploadSerial = 0;
+        image->mipmapDirty = false;
+        image->compressed = false;
+        image->renderView = 0;
+        image->readback = 0;
+        image->tiled = 0;
+
+        //NOTE: YUV images are converted when they are sampled, so they can't share the rgba8 texture array, and
+        //      they have no mipmaps
+        image->arrayLayer = -1;
+        image->mipLevelCount = 1;
+
+        //NOTE: in both layouts, the chroma takes chroma height rows of twice the chroma width bytes, which is the luma
+        //      width rounded up to even
+        oc_vec2 chromaSize = oc_image_yuv_plane_size_for_format(OC_IMAGE_YUV_I420, size, 1);
+        oc_vec2 textureSize = { chromaSize.x * 2, size.y + chromaSize.y };
+
+        WGPUTextureDescriptor desc = {
+            .usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst,
+            .dimension = WGPUTextureDimension_2D,
+            .size = { textureSize.x, textureSize.y, 1 },
+            .format = WGPUTextureFormat_R8Unorm,
+            .mipLevelCount = 1,
+            .sampleCount = 1,
+        };
+        image->texture = wgpuDeviceCreateTexture(renderer->device, &desc);
+
+        WGPUTextureViewDescriptor viewDesc = {
+            .format = desc.format,
+            .dimension = WGPUTextureViewDimension_2D,
+            .baseMipLevel = 0,
+            .mipLevelCount = 1,
+            .baseArrayLayer = 0,
+            .arrayLayerCount = 1,
+            .aspect = WGPUTextureAspect_All,
+        };
+        image->textureView = wgpuTextureCreateView(image->texture, &viewDesc);
+
+        image->memorySize = oc_wgpu_image_texture_memory_size(textureSize, 1, 1);
+        oc_canvas_renderer_track_memory(rendererBase, OC_CANVAS_MEMORY_IMAGES, image->memorySize);
+    }
+    return ((oc_image_base*)image);
+}
+
+void oc_wgpu_canvas_image_upload_yuv_plane(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase, u32 plane, u8* pixels)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)rendererBase;
+    oc_wgpu_image* image = (oc_wgpu_image*)imageBase;
+
+    oc_vec2 planeSize = oc_image_yuv_plane_size_for_format(imageBase->yuvFormat, imageBase->size, plane);
+
+    WGPUImageCopyTexture dst = {
+        .texture = image->texture,
+        .mipLevel = 0,
+        .origin = oc_wgpu_yuv_plane_origin(imageBase, plane),
+    };
+    oc_wgpu_canvas_upload_pixels(renderer, &dst, planeSize.x, planeSize.y, 1, pixels, &image->uploadSerial);
+}
+
+//------------------------------------------------------------------------------------------------
+// Image readback
+//------------------------------------------------------------------------------------------------
+
+static void oc_wgpu_image_readback_free(oc_wgpu_image_readback* readback)
+{
+    if(readback->done)
+    {
+        wgpuBufferUnmap(readback->buffer);
+    }
+    wgpuBufferRelease(readback->buffer);
+    oc_canvas_renderer_track_memory(readback->renderer, OC_CANVAS_MEMORY_STAGING, -(i64)readback->bufferSize);
+    free(readback);
+}
+
+static void oc_wgpu_image_readback_release(oc_wgpu_image* image)
+{
+    oc_wgpu_image_readback* readback = image->readback;
+    if(readback)
+    {
+        if(readback->done || readback->failed)
+        {
+            oc_wgpu_image_readback_free(readback);
+        }
+        else
+        {
+            //NOTE: the copy is still in flight, orphan the readback and let the map callback free it
+            readback->image = 0;
+        }
+        image->readback = 0;
+    }
+}
+
+static void oc_wgpu_image_readback_map_callback(WGPUBufferMapAsyncStatus status, void* user)
+{
+    oc_wgpu_image_readback* readback = (oc_wgpu_image_readback*)user;
+
+    if(status == WGPUBufferMapAsyncStatus_Success)
+    {
+        readback->done = true;
+    }
+    else
+    {
+        readback->failed = true;
+        if(readback->image)
+        {
+            oc_log_error("couldn't read back image pixels (status %i).\n", status);
+        }
+    }
+
+    if(!readback->image)
+    {
+        oc_wgpu_image_readback_free(readback);
+    }
+}
+
+void oc_wgpu_canvas_image_readback_region(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase, oc_rect region)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)rendererBase;
+    oc_wgpu_image* image = (oc_wgpu_image*)imageBase;
+
+    if(image->compressed)
+    {
+        oc_log_error("can't read back the pixels of a compressed image.\n");
+        return;
+    }
+
+    //NOTE: a new readback replaces the previous one
+    oc_wgpu_image_readback_release(image);
+
+    //NOTE: copy the staged uploads first, so that the readback sees them
+    oc_wgpu_canvas_upload_ring_flush(renderer);
+
+    oc_wgpu_image_readback* readback = oc_malloc_type(oc_wgpu_image_readback);
+    if(!readback)
+    {
+        oc_log_error("couldn't allocate image readback.\n");
+        return;
+    }
+    memset(readback, 0, sizeof(oc_wgpu_image_readback));
+
+    //NOTE: texture to buffer copies need rows aligned to 256 bytes
+    readback->image = image;
+    readback->region = region;
+    readback->bytesPerRow = ((u32)region.w * 4 + 255) & ~255;
+
+    WGPUBufferDescriptor bufferDesc = {
+        .label = "image readback",
+        .usage = WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst,
+        .size = (u64)readback->bytesPerRow * (u32)region.h,
+    };
+    readback->buffer = wgpuDeviceCreateBuffer(renderer->device, &bufferDesc);
+    readback->renderer = rendererBase;
+    readback->bufferSize = bufferDesc.size;
+    oc_canvas_renderer_track_memory(rendererBase, OC_CANVAS_MEMORY_STAGING, readback->bufferSize);
+
+    WGPUImageCopyTexture src = {
+        .texture = image->texture,
+        .mipLevel = 0,
+        .origin = { (u32)region.x, (u32)region.y, 0 },
+    };
+    if(image->arrayLayer >= 0)
+    {
+        src.texture = renderer->imageArray.texture;
+        src.origin = (WGPUOrigin3D){ (u32)(image->arrayRect.x + region.x),
+                                     (u32)(image->arrayRect.y + region.y),
+                                     (u32)image->arrayLayer };
+    }
+
+    WGPUImageCopyBuffer dst = {
+        .layout = {
+            .offset = 0,
+            .bytesPerRow = readback->bytesPerRow,
+            .rowsPerImage = (u32)region.h,
+        },
+        .buffer = readback->buffer,
+    };
+
+    WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(renderer->device, NULL);
+    wgpuCommandEncoderCopyTextureToBuffer(encoder, &src, &dst, &(WGPUExtent3D){ (u32)region.w, (u32)region.h, 1 });
 
-    release_buffer_if_needed(renderer->tileSizeBuffer);
-    release_buffer_if_needed(renderer->chunkSizeBuffer);
+    WGPUCommandBuffer command = wgpuCommandEncoderFinish(encoder, NULL);
+    wgpuQueueSubmit(renderer->queue, 1, &command);
+    wgpuCommandBufferRelease(command);
+    wgpuCommandEncoderRelease(encoder);
 
-    release_buffer_if_needed(renderer->msaaOffsetsBuffer);
-    release_buffer_if_needed(renderer->msaaSampleCountBuffer);
+    image->readback = readback;
+    wgpuBufferMapAsync(readback->buffer, WGPUMapMode_Read, 0, bufferDesc.size, oc_wgpu_image_readback_map_callback, readback);
+}
 
-    release_buffer_if_needed(renderer->maxWorkGroupsPerDimensionBuffer);
+bool oc_wgpu_canvas_image_readback_done(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)rendererBase;
+    oc_wgpu_image* image = (oc_wgpu_image*)imageBase;
 
-    release_buffer_if_needed(renderer->timestampsResolveBuffer);
-    for(int i = 0; i < OC_WGPU_CANVAS_ROLLING_BUFFER_COUNT; i++)
-    {
-        release_buffer_if_needed(renderer->timestampsReadBuffer[i]);
-    }
+    wgpuDeviceTick(renderer->device);
 
-    release_buffer_if_needed(renderer->debugDisplayOptionsBuffer);
+    return (!image->readback || image->readback->done || image->readback->failed);
+}
 
-#undef release_buffer_if_needed
+bool oc_wgpu_canvas_image_readback_get(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase, u64 size, u8* pixels)
+{
+    oc_wgpu_image* image = (oc_wgpu_image*)imageBase;
+    oc_wgpu_image_readback* readback = image->readback;
 
-    // release query set
-    if(renderer->timestampsQuerySet)
+    if(!readback || !readback->done)
     {
-        wgpuQuerySetRelease(renderer->timestampsQuerySet);
+        return (false);
     }
 
-    // release texture views and sample
-    if(renderer->batchTextureView)
+    u32 width = (u32)readback->region.w;
+    u32 height = (u32)readback->region.h;
+
+    if(size < (u64)width * height * 4)
     {
-        wgpuTextureViewRelease(renderer->batchTextureView);
+        oc_log_error("readback buffer is too small (%llu bytes, expected %llu).\n",
+                     (unsigned long long)size,
+                     (unsigned long long)width * height * 4);
+        return (false);
     }
-    if(renderer->dummyTextureView)
+    u8 const* mapped = wgpuBufferGetConstMappedRange(readback->buffer, 0, (u64)readback->bytesPerRow * height);
+
+    //NOTE: strip the row padding
+    for(u32 row = 0; row < height; row++)
     {
-        wgpuTextureViewRelease(renderer->dummyTextureView);
+        memcpy(pixels + (u64)row * width * 4, mapped + (u64)row * readback->bytesPerRow, width * 4);
     }
 
-    // release queue/device/instance
-    wgpuQueueRelease(renderer->queue);
-    wgpuDeviceRelease(renderer->device);
-    wgpuInstanceRelease(renderer->instance);
+    oc_wgpu_image_readback_release(image);
+    return (true);
+}
 
-    free(renderer);
+bool oc_wgpu_canvas_compressed_format_supported(oc_canvas_renderer_base* rendererBase, oc_image_compressed_format format)
+{
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)rendererBase;
+    return (renderer->compressedFormats[format]);
 }
 
-oc_image_base* oc_wgpu_canvas_image_create(oc_canvas_renderer_base* base, oc_vec2 size)
+oc_image_base* oc_wgpu_canvas_image_create_compressed(oc_canvas_renderer_base* rendererBase, oc_image_compressed_format format, oc_vec2 size, oc_str8 data)
 {
-    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)base;
+    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)rendererBase;
+
+    const WGPUTextureFormat formats[OC_IMAGE_COMPRESSED_FORMAT_COUNT] = {
+        [OC_IMAGE_COMPRESSED_BC7_SRGB] = WGPUTextureFormat_BC7RGBAUnormSrgb,
+        [OC_IMAGE_COMPRESSED_ETC2_RGBA8_SRGB] = WGPUTextureFormat_ETC2RGBA8UnormSrgb,
+        [OC_IMAGE_COMPRESSED_ASTC_4X4_SRGB] = WGPUTextureFormat_ASTC4x4UnormSrgb,
+    };
 
     oc_wgpu_image* image = oc_malloc_type(oc_wgpu_image);
     if(image)
     {
+        image->base.size = size;
+        image->uploadSerial = 0;
+        image->mipmapDirty = false;
+        image->compressed = true;
+        image->renderView = 0;
+        image->readback = 0;
+        image->tiled = 0;
+
+        //NOTE: compressed images always get their own texture, since they can't share the rgba8 texture array.
+        //      They can't be render attachments either, so we don't generate mipmaps for them.
+        image->arrayLayer = -1;
+        image->mipLevelCount = 1;
+
         WGPUTextureDescriptor desc = {
             .usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst,
             .dimension = WGPUTextureDimension_2D,
             .size = { size.x, size.y, 1 },
-            .format = WGPUTextureFormat_RGBA8UnormSrgb,
+            .format = formats[format],
             .mipLevelCount = 1,
             .sampleCount = 1,
         };
@@ -3938,51 +9634,33 @@ oc_image_base* oc_wgpu_canvas_image_create(oc_canvas_renderer_base* base, oc_vec
         };
         image->textureView = wgpuTextureCreateView(image->texture, &viewDesc);
 
-        //TODO: check fail
+        //NOTE: all supported formats use 16 bytes per 4x4 block
+        image->memorySize = oc_wgpu_image_texture_memory_size(size, 1, 1);
+        oc_canvas_renderer_track_memory(rendererBase, OC_CANVAS_MEMORY_IMAGES, image->memorySize);
 
-        image->base.size = size;
+        //NOTE: the blocks are written directly, data is laid out as rows of 4x4 blocks of 16 bytes
+        u32 blockCountX = (u32)size.x / 4;
+        u32 blockCountY = (u32)size.y / 4;
+
+        WGPUImageCopyTexture dst = {
+            .texture = image->texture,
+            .mipLevel = 0,
+            .origin = { 0, 0, 0 },
+        };
+        WGPUTextureDataLayout src = {
+            .offset = 0,
+            .bytesPerRow = blockCountX * 16,
+            .rowsPerImage = blockCountY,
+        };
+        wgpuQueueWriteTexture(renderer->queue, &dst, data.ptr, data.len, &src, &(WGPUExtent3D){ size.x, size.y, 1 });
     }
     return ((oc_image_base*)image);
 }
 
-void oc_wgpu_canvas_image_destroy(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase)
-{
-    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)rendererBase;
-    oc_wgpu_image* image = (oc_wgpu_image*)imageBase;
-
-    //TODO: check image was created with the same renderer
-
-    wgpuTextureViewRelease(image->textureView);
-    wgpuTextureRelease(image->texture);
-    free(image);
-}
-
-void oc_wgpu_canvas_image_upload_region(oc_canvas_renderer_base* rendererBase, oc_image_base* imageBase, oc_rect region, u8* pixels)
-{
-    oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)rendererBase;
-    oc_wgpu_image* image = (oc_wgpu_image*)imageBase;
-
-    //TODO: check image was created with the same renderer
-
-    WGPUImageCopyTexture dst = {
-        .texture = image->texture,
-        .mipLevel = 0,
-        .origin = { (u32)region.x, (u32)region.y },
-    };
-    WGPUTextureDataLayout src = {
-        .offset = 0,
-        .bytesPerRow = region.w * 4, // 4 bytes per pixel
-        .rowsPerImage = region.h,
-    };
-    u32 pixelsSize = region.w * region.h * 4;
-    wgpuQueueWriteTexture(renderer->queue, &dst, pixels, pixelsSize, &src, &(WGPUExtent3D){ region.w, region.h, 1 });
-}
-
 void oc_wgpu_canvas_debug_set_record_options(oc_canvas_renderer handle, oc_wgpu_canvas_record_options* options)
 {
     oc_canvas_renderer_base* base = oc_canvas_renderer_from_handle(handle);
-    //TODO: should check that the impl is webgpu
-    if(base)
+    if(base && base->backend == OC_CANVAS_BACKEND_WEBGPU)
     {
         oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)base;
         renderer->debugRecordOptions = *options;
@@ -4003,8 +9681,7 @@ oc_wgpu_canvas_record_options oc_wgpu_canvas_debug_get_record_options(oc_canvas_
 {
     oc_wgpu_canvas_record_options options = { 0 };
     oc_canvas_renderer_base* base = oc_canvas_renderer_from_handle(handle);
-    //TODO: should check that the impl is webgpu
-    if(base)
+    if(base && base->backend == OC_CANVAS_BACKEND_WEBGPU)
     {
         oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)base;
         options = renderer->debugRecordOptions;
@@ -4015,8 +9692,7 @@ oc_wgpu_canvas_record_options oc_wgpu_canvas_debug_get_record_options(oc_canvas_
 void oc_wgpu_canvas_debug_clear_records(oc_canvas_renderer handle)
 {
     oc_canvas_renderer_base* base = oc_canvas_renderer_from_handle(handle);
-    //TODO: should check that the impl is webgpu
-    if(base)
+    if(base && base->backend == OC_CANVAS_BACKEND_WEBGPU)
     {
         oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)base;
         oc_arena_clear(&renderer->debugArena);
@@ -4031,8 +9707,7 @@ oc_list oc_wgpu_canvas_debug_get_records(oc_canvas_renderer handle)
 {
     oc_list result = { 0 };
     oc_canvas_renderer_base* base = oc_canvas_renderer_from_handle(handle);
-    //TODO: should check that the impl is webgpu
-    if(base)
+    if(base && base->backend == OC_CANVAS_BACKEND_WEBGPU)
     {
         oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)base;
         result = renderer->debugRecords;
@@ -4083,8 +9758,7 @@ oc_wgpu_canvas_frame_stats oc_wgpu_canvas_get_frame_stats(oc_canvas_renderer han
 {
     oc_wgpu_canvas_frame_stats stats = { 0 };
     oc_canvas_renderer_base* base = oc_canvas_renderer_from_handle(handle);
-    //TODO: should check that the impl is webgpu
-    if(base)
+    if(base && base->backend == OC_CANVAS_BACKEND_WEBGPU)
     {
         oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)base;
         stats = (oc_wgpu_canvas_frame_stats){
@@ -4092,24 +9766,126 @@ oc_wgpu_canvas_frame_stats oc_wgpu_canvas_get_frame_stats(oc_canvas_renderer han
             .cpuEncodeTime = oc_wgpu_canvas_stats_resolve(&renderer->cpuEncodeTime, desiredSampleCount),
             .cpuFrameTime = oc_wgpu_canvas_stats_resolve(&renderer->cpuFrameTime, desiredSampleCount),
         };
+        for(int passIndex = 0; passIndex < OC_WGPU_CANVAS_PASS_COUNT; passIndex++)
+        {
+            stats.passTime[passIndex] = oc_wgpu_canvas_stats_resolve(&renderer->passTime[passIndex], desiredSampleCount);
+        }
+        for(int kind = 0; kind < OC_WGPU_CANVAS_BUFFER_KIND_COUNT; kind++)
+        {
+            stats.bufferMemory += renderer->bufferUsage[kind].size;
+        }
+        stats.imageArrayMemory = (u64)renderer->imageArray.layerCap
+                               * OC_WGPU_CANVAS_IMAGE_ARRAY_LAYER_SIZE
+                               * OC_WGPU_CANVAS_IMAGE_ARRAY_LAYER_SIZE
+                               * 4;
     }
     return (stats);
 }
 
+const char* oc_wgpu_canvas_pass_name(oc_wgpu_canvas_pass pass)
+{
+    return ((pass >= 0 && pass < OC_WGPU_CANVAS_PASS_COUNT) ? OC_WGPU_CANVAS_PASS_NAMES[pass] : "unknown");
+}
+
+static const char* OC_WGPU_CANVAS_HEATMAP_NAMES[OC_WGPU_CANVAS_HEATMAP_COUNT] = {
+    [OC_WGPU_CANVAS_HEATMAP_NONE] = "none",
+    [OC_WGPU_CANVAS_HEATMAP_TILE_OPS] = "tile ops",
+    [OC_WGPU_CANVAS_HEATMAP_SEGMENTS] = "segments",
+    [OC_WGPU_CANVAS_HEATMAP_OVERDRAW] = "overdraw",
+    [OC_WGPU_CANVAS_HEATMAP_BATCHES] = "batches",
+};
+
+static const u32 OC_WGPU_CANVAS_HEATMAP_DEFAULT_SCALES[OC_WGPU_CANVAS_HEATMAP_COUNT] = {
+    [OC_WGPU_CANVAS_HEATMAP_TILE_OPS] = 64,
+    [OC_WGPU_CANVAS_HEATMAP_SEGMENTS] = 32,
+    [OC_WGPU_CANVAS_HEATMAP_OVERDRAW] = 8,
+    [OC_WGPU_CANVAS_HEATMAP_BATCHES] = OC_WGPU_CANVAS_HEATMAP_BATCH_COLOR_COUNT,
+};
+
+//NOTE: these must match the ramp and palette of heatmap_color() in raster.wgsl
+static const oc_color OC_WGPU_CANVAS_HEATMAP_RAMP[] = {
+    { 0, 0, 1, 1 },
+    { 0, 1, 1, 1 },
+    { 0, 1, 0, 1 },
+    { 1, 1, 0, 1 },
+    { 1, 0, 0, 1 },
+};
+
+static const oc_color OC_WGPU_CANVAS_HEATMAP_BATCH_COLORS[OC_WGPU_CANVAS_HEATMAP_BATCH_COLOR_COUNT] = {
+    { 1, 0, 0, 1 },
+    { 0, 1, 0, 1 },
+    { 0, 0, 1, 1 },
+    { 1, 1, 0, 1 },
+    { 0, 1, 1, 1 },
+    { 1, 0, 1, 1 },
+};
+
+const char* oc_wgpu_canvas_heatmap_name(oc_wgpu_canvas_heatmap heatmap)
+{
+    return ((heatmap >= 0 && heatmap < OC_WGPU_CANVAS_HEATMAP_COUNT) ? OC_WGPU_CANVAS_HEATMAP_NAMES[heatmap] : "unknown");
+}
+
+u32 oc_wgpu_canvas_heatmap_default_scale(oc_wgpu_canvas_heatmap heatmap)
+{
+    return ((heatmap >= 0 && heatmap < OC_WGPU_CANVAS_HEATMAP_COUNT) ? OC_WGPU_CANVAS_HEATMAP_DEFAULT_SCALES[heatmap] : 0);
+}
+
+oc_color oc_wgpu_canvas_heatmap_color(oc_wgpu_canvas_heatmap heatmap, u32 count, u32 scale)
+{
+    oc_color color = { 0 };
+    if(heatmap == OC_WGPU_CANVAS_HEATMAP_BATCHES)
+    {
+        color = OC_WGPU_CANVAS_HEATMAP_BATCH_COLORS[count % OC_WGPU_CANVAS_HEATMAP_BATCH_COLOR_COUNT];
+    }
+    else if(heatmap > OC_WGPU_CANVAS_HEATMAP_NONE && heatmap < OC_WGPU_CANVAS_HEATMAP_COUNT)
+    {
+        scale = scale ? scale : oc_wgpu_canvas_heatmap_default_scale(heatmap);
+
+        u32 stopCount = oc_array_size(OC_WGPU_CANVAS_HEATMAP_RAMP);
+        f32 t = oc_clamp(log2f(1 + count) / log2f(1 + scale), 0, 1) * (stopCount - 1);
+        u32 index = oc_min((u32)t, stopCount - 2);
+        f32 f = t - index;
+
+        oc_color c0 = OC_WGPU_CANVAS_HEATMAP_RAMP[index];
+        oc_color c1 = OC_WGPU_CANVAS_HEATMAP_RAMP[index + 1];
+        color = (oc_color){
+            (1 - f) * c0.r + f * c1.r,
+            (1 - f) * c0.g + f * c1.g,
+            (1 - f) * c0.b + f * c1.b,
+            1,
+        };
+    }
+    return (color);
+}
+
 void oc_wgpu_canvas_debug_set_display_options(oc_canvas_renderer handle, oc_wgpu_canvas_debug_display_options* options)
 {
     oc_canvas_renderer_base* base = oc_canvas_renderer_from_handle(handle);
-    //TODO: should check that the impl is webgpu
-    if(base)
+    if(base && base->backend == OC_CANVAS_BACKEND_WEBGPU)
     {
         oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)base;
         renderer->debugDisplayOptions = *options;
         renderer->debugDisplayOptions.pathStart = oc_clamp_low(renderer->debugDisplayOptions.pathStart, 0);
         renderer->debugDisplayOptions.pathCount = oc_clamp_low(renderer->debugDisplayOptions.pathCount, 0);
+        if(renderer->debugDisplayOptions.heatmap < 0 || renderer->debugDisplayOptions.heatmap >= OC_WGPU_CANVAS_HEATMAP_COUNT)
+        {
+            renderer->debugDisplayOptions.heatmap = OC_WGPU_CANVAS_HEATMAP_NONE;
+        }
 
-        oc_log_info("options.pathStart = %i, options.pathCount = %i\n",
+        oc_log_info("options.pathStart = %i, options.pathCount = %i, options.heatmap = %s\n",
                     renderer->debugDisplayOptions.pathStart,
-                    renderer->debugDisplayOptions.pathCount);
+                    renderer->debugDisplayOptions.pathCount,
+                    oc_wgpu_canvas_heatmap_name(renderer->debugDisplayOptions.heatmap));
+    }
+}
+
+void oc_wgpu_canvas_set_buffer_shrink_delay(oc_canvas_renderer handle, u32 frameCount)
+{
+    oc_canvas_renderer_base* base = oc_canvas_renderer_from_handle(handle);
+    if(base && base->backend == OC_CANVAS_BACKEND_WEBGPU)
+    {
+        oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)base;
+        renderer->bufferShrinkFrameCount = frameCount;
     }
 }
 
@@ -4117,11 +9893,394 @@ oc_wgpu_canvas_debug_display_options oc_wgpu_canvas_debug_get_display_options(oc
 {
     oc_wgpu_canvas_debug_display_options options = { 0 };
     oc_canvas_renderer_base* base = oc_canvas_renderer_from_handle(handle);
-    //TODO: should check that the impl is webgpu
-    if(base)
+    if(base && base->backend == OC_CANVAS_BACKEND_WEBGPU)
     {
         oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)base;
         options = renderer->debugDisplayOptions;
     }
     return (options);
 }
+
+//------------------------------------------------------------------------------------------
+// frame captures
+//------------------------------------------------------------------------------------------
+
+/*NOTE: capture file layout
+
+    A capture starts with an oc_wgpu_canvas_capture_header, followed by the primitives, attributes, elements and image
+    descriptors, and the pixels of each image. Each section starts at an offset aligned to
+    OC_WGPU_CANVAS_CAPTURE_ALIGNMENT, so that the streams can be used right from the mapped file. Structs are written
+    as laid out in memory, and the header records their sizes, so captures can only be replayed by a build with the
+    same layout.
+*/
+enum
+{
+    OC_WGPU_CANVAS_CAPTURE_VERSION = 1,
+    OC_WGPU_CANVAS_CAPTURE_ALIGNMENT = 16,
+};
+
+static const char OC_WGPU_CANVAS_CAPTURE_MAGIC[8] = { 'O', 'C', 'C', 'A', 'P', 'T', 'U', 'R' };
+
+typedef struct oc_wgpu_canvas_capture_header
+{
+    char magic[8];
+    u32 version;
+    u32 headerSize;
+    u32 primitiveSize;
+    u32 attributesSize;
+    u32 eltSize;
+
+    u32 msaaSampleCount;
+    u32 clear;
+    oc_color clearColor;
+    oc_rect damage;
+    oc_vec2 surfaceSize;
+
+    u32 primitiveCount;
+    u32 attributeCount;
+    u32 eltCount;
+    u32 imageCount;
+
+    u64 primitivesOffset;
+    u64 attributesOffset;
+    u64 elementsOffset;
+    u64 imagesOffset;
+
+} oc_wgpu_canvas_capture_header;
+
+typedef struct oc_wgpu_canvas_capture_image
+{
+    u64 handle; // handle of the image when it was captured, referenced by the attributes
+    u32 width;
+    u32 height;
+    u64 pixelsOffset;
+    u64 pixelsSize; // rgba8 pixels with straight alpha, or 0 if the image couldn't be read back
+
+} oc_wgpu_canvas_capture_image;
+
+static u64 oc_wgpu_canvas_capture_align(u64 offset)
+{
+    return ((offset + OC_WGPU_CANVAS_CAPTURE_ALIGNMENT - 1) & ~((u64)OC_WGPU_CANVAS_CAPTURE_ALIGNMENT - 1));
+}
+
+static bool oc_wgpu_canvas_capture_write_section(oc_file file, u64* offset, u64 sectionOffset, u64 size, void* data)
+{
+    static const char zeros[OC_WGPU_CANVAS_CAPTURE_ALIGNMENT] = { 0 };
+
+    u64 padding = sectionOffset - *offset;
+    if(padding && oc_file_write(file, padding, (char*)zeros) != padding)
+    {
+        return (false);
+    }
+    if(size && oc_file_write(file, size, (char*)data) != size)
+    {
+        return (false);
+    }
+    *offset = sectionOffset + size;
+    return (true);
+}
+
+static void oc_wgpu_canvas_write_capture(oc_wgpu_canvas_renderer* renderer,
+                                         oc_surface surfaceHandle,
+                                         u32 msaaSampleCount,
+                                         bool clear,
+                                         oc_color clearColor,
+                                         oc_rect damage,
+                                         u32 primitiveCount,
+                                         oc_primitive* primitives,
+                                         u32 attributeCount,
+                                         oc_attributes* attributes,
+                                         u32 eltCount,
+                                         oc_path_elt* elements)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_str8 path = renderer->debugCapturePath;
+    renderer->debugCapturePath = (oc_str8){ 0 };
+
+    //NOTE: collect the images referenced by the attributes, and read them back synchronously
+    oc_wgpu_canvas_capture_image* images = oc_arena_push_array(scratch.arena, oc_wgpu_canvas_capture_image, attributeCount);
+    u8** imagePixels = oc_arena_push_array(scratch.arena, u8*, attributeCount);
+    u32 imageCount = 0;
+
+    for(u32 attrIndex = 0; attrIndex < attributeCount; attrIndex++)
+    {
+        oc_image handle = attributes[attrIndex].image;
+        oc_image_base* imageBase = oc_image_from_handle(handle);
+        if(!imageBase || oc_canvas_renderer_from_handle(imageBase->renderer) != &renderer->base)
+        {
+            continue;
+        }
+
+        bool found = false;
+        for(u32 i = 0; i < imageCount; i++)
+        {
+            if(images[i].handle == handle.h)
+            {
+                found = true;
+                break;
+            }
+        }
+        if(found)
+        {
+            continue;
+        }
+
+        oc_wgpu_canvas_capture_image* image = &images[imageCount];
+        image->handle = handle.h;
+        image->width = imageBase->size.x;
+        image->height = imageBase->size.y;
+        imagePixels[imageCount] = 0;
+
+        //NOTE: compressed, tiled and YUV images are captured without their pixels
+        if(!((oc_wgpu_image*)imageBase)->compressed && !((oc_wgpu_image*)imageBase)->tiled && !imageBase->yuv)
+        {
+            //NOTE: this cancels any readback the app started on that image
+            oc_rect region = { 0, 0, image->width, image->height };
+            oc_wgpu_canvas_image_readback_region(&renderer->base, imageBase, region);
+            while(!oc_wgpu_canvas_image_readback_done(&renderer->base, imageBase))
+                ;
+
+            u64 size = (u64)image->width * image->height * 4;
+            u8* pixels = oc_arena_push_array(scratch.arena, u8, size);
+            if(oc_wgpu_canvas_image_readback_get(&renderer->base, imageBase, size, pixels))
+            {
+                image->pixelsSize = size;
+                imagePixels[imageCount] = pixels;
+            }
+        }
+        imageCount++;
+    }
+
+    oc_vec2 size = oc_surface_get_size(surfaceHandle);
+    oc_vec2 scale = oc_surface_contents_scaling(surfaceHandle);
+
+    oc_wgpu_canvas_capture_header header = {
+        .version = OC_WGPU_CANVAS_CAPTURE_VERSION,
+        .headerSize = sizeof(oc_wgpu_canvas_capture_header),
+        .primitiveSize = sizeof(oc_primitive),
+        .attributesSize = sizeof(oc_attributes),
+        .eltSize = sizeof(oc_path_elt),
+        .msaaSampleCount = msaaSampleCount,
+        .clear = clear,
+        .clearColor = clearColor,
+        .damage = damage,
+        .surfaceSize = { size.x * scale.x, size.y * scale.y },
+        .primitiveCount = primitiveCount,
+        .attributeCount = attributeCount,
+        .eltCount = eltCount,
+        .imageCount = imageCount,
+    };
+    memcpy(header.magic, OC_WGPU_CANVAS_CAPTURE_MAGIC, sizeof(header.magic));
+
+    header.primitivesOffset = oc_wgpu_canvas_capture_align(sizeof(oc_wgpu_canvas_capture_header));
+    header.attributesOffset = oc_wgpu_canvas_capture_align(header.primitivesOffset + primitiveCount * sizeof(oc_primitive));
+    header.elementsOffset = oc_wgpu_canvas_capture_align(header.attributesOffset + attributeCount * sizeof(oc_attributes));
+    header.imagesOffset = oc_wgpu_canvas_capture_align(header.elementsOffset + eltCount * sizeof(oc_path_elt));
+
+    u64 pixelsOffset = oc_wgpu_canvas_capture_align(header.imagesOffset + imageCount * sizeof(oc_wgpu_canvas_capture_image));
+    for(u32 i = 0; i < imageCount; i++)
+    {
+        images[i].pixelsOffset = pixelsOffset;
+        pixelsOffset = oc_wgpu_canvas_capture_align(pixelsOffset + images[i].pixelsSize);
+    }
+
+    oc_file file = oc_file_open(path, OC_FILE_ACCESS_WRITE, OC_FILE_OPEN_CREATE | OC_FILE_OPEN_TRUNCATE);
+    if(oc_file_last_error(file) != OC_IO_OK)
+    {
+        oc_log_error("couldn't open capture file %.*s.\n", oc_str8_ip(path));
+    }
+    else
+    {
+        u64 offset = 0;
+        bool ok = oc_wgpu_canvas_capture_write_section(file, &offset, 0, sizeof(header), &header)
+               && oc_wgpu_canvas_capture_write_section(file, &offset, header.primitivesOffset, primitiveCount * sizeof(oc_primitive), primitives)
+               && oc_wgpu_canvas_capture_write_section(file, &offset, header.attributesOffset, attributeCount * sizeof(oc_attributes), attributes)
+               && oc_wgpu_canvas_capture_write_section(file, &offset, header.elementsOffset, eltCount * sizeof(oc_path_elt), elements)
+               && oc_wgpu_canvas_capture_write_section(file, &offset, header.imagesOffset, imageCount * sizeof(oc_wgpu_canvas_capture_image), images);
+
+        for(u32 i = 0; ok && i < imageCount; i++)
+        {
+            ok = oc_wgpu_canvas_capture_write_section(file, &offset, images[i].pixelsOffset, images[i].pixelsSize, imagePixels[i]);
+        }
+
+        if(ok)
+        {
+            oc_log_info("captured frame %llu (%u primitives, %u elements, %u images) to %.*s.\n",
+                        (unsigned long long)renderer->frameIndex,
+                        primitiveCount,
+                        eltCount,
+                        imageCount,
+                        oc_str8_ip(path));
+        }
+        else
+        {
+            oc_log_error("couldn't write capture file %.*s.\n", oc_str8_ip(path));
+        }
+    }
+    oc_file_close(file);
+
+    free(path.ptr);
+    oc_scratch_end(scratch);
+}
+
+void oc_wgpu_canvas_debug_capture_next_frame(oc_canvas_renderer handle, oc_str8 path)
+{
+    oc_canvas_renderer_base* base = oc_canvas_renderer_from_handle(handle);
+    if(base && base->backend == OC_CANVAS_BACKEND_WEBGPU)
+    {
+        oc_wgpu_canvas_renderer* renderer = (oc_wgpu_canvas_renderer*)base;
+
+        free(renderer->debugCapturePath.ptr);
+        renderer->debugCapturePath = (oc_str8){ 0 };
+
+        if(path.len)
+        {
+            char* copy = oc_malloc_array(char, path.len);
+            if(copy)
+            {
+                memcpy(copy, path.ptr, path.len);
+                renderer->debugCapturePath = oc_str8_from_buffer(path.len, copy);
+            }
+        }
+    }
+}
+
+static bool oc_wgpu_canvas_capture_section_is_valid(oc_str8 mapping, u64 offset, u64 count, u64 eltSize)
+{
+    return (offset % OC_WGPU_CANVAS_CAPTURE_ALIGNMENT == 0
+            && offset <= mapping.len
+            && count <= (mapping.len - offset) / eltSize);
+}
+
+oc_wgpu_canvas_capture oc_wgpu_canvas_capture_load(oc_arena* arena, oc_canvas_renderer renderer, oc_str8 path)
+{
+    oc_wgpu_canvas_capture capture = { 0 };
+
+    oc_str8 mapping = oc_file_map_read_only(path);
+    if(!mapping.ptr)
+    {
+        oc_log_error("couldn't map capture file %.*s.\n", oc_str8_ip(path));
+        return (capture);
+    }
+
+    oc_wgpu_canvas_capture_header* header = (oc_wgpu_canvas_capture_header*)mapping.ptr;
+
+    if(mapping.len < sizeof(oc_wgpu_canvas_capture_header)
+       || memcmp(header->magic, OC_WGPU_CANVAS_CAPTURE_MAGIC, sizeof(header->magic))
+       || header->version != OC_WGPU_CANVAS_CAPTURE_VERSION)
+    {
+        oc_log_error("%.*s is not a frame capture, or was written by an incompatible version.\n", oc_str8_ip(path));
+        oc_file_unmap(mapping);
+        return (capture);
+    }
+    if(header->headerSize != sizeof(oc_wgpu_canvas_capture_header)
+       || header->primitiveSize != sizeof(oc_primitive)
+       || header->attributesSize != sizeof(oc_attributes)
+       || header->eltSize != sizeof(oc_path_elt))
+    {
+        oc_log_error("capture %.*s was written by a build with a different canvas struct layout.\n", oc_str8_ip(path));
+        oc_file_unmap(mapping);
+        return (capture);
+    }
+    if(!oc_wgpu_canvas_capture_section_is_valid(mapping, header->primitivesOffset, header->primitiveCount, sizeof(oc_primitive))
+       || !oc_wgpu_canvas_capture_section_is_valid(mapping, header->attributesOffset, header->attributeCount, sizeof(oc_attributes))
+       || !oc_wgpu_canvas_capture_section_is_valid(mapping, header->elementsOffset, header->eltCount, sizeof(oc_path_elt))
+       || !oc_wgpu_canvas_capture_section_is_valid(mapping, header->imagesOffset, header->imageCount, sizeof(oc_wgpu_canvas_capture_image)))
+    {
+        oc_log_error("capture %.*s is truncated.\n", oc_str8_ip(path));
+        oc_file_unmap(mapping);
+        return (capture);
+    }
+
+    oc_wgpu_canvas_capture_image* capturedImages = (oc_wgpu_canvas_capture_image*)(mapping.ptr + header->imagesOffset);
+    for(u32 i = 0; i < header->imageCount; i++)
+    {
+        if(capturedImages[i].pixelsSize
+           && (capturedImages[i].pixelsSize != (u64)capturedImages[i].width * capturedImages[i].height * 4
+               || !oc_wgpu_canvas_capture_section_is_valid(mapping, capturedImages[i].pixelsOffset, capturedImages[i].pixelsSize, 1)))
+        {
+            oc_log_error("capture %.*s is truncated.\n", oc_str8_ip(path));
+            oc_file_unmap(mapping);
+            return (capture);
+        }
+    }
+
+    capture.mapping = mapping;
+    capture.msaaSampleCount = header->msaaSampleCount;
+    capture.clear = header->clear;
+    capture.clearColor = header->clearColor;
+    capture.damage = header->damage;
+    capture.surfaceSize = header->surfaceSize;
+    capture.primitiveCount = header->primitiveCount;
+    capture.primitives = (oc_primitive*)(mapping.ptr + header->primitivesOffset);
+    capture.eltCount = header->eltCount;
+    capture.elements = (oc_path_elt*)(mapping.ptr + header->elementsOffset);
+
+    //NOTE: recreate the images, and point the attributes to them instead of the captured handles
+    capture.imageCount = header->imageCount;
+    capture.images = oc_arena_push_array(arena, oc_image, header->imageCount);
+    for(u32 i = 0; i < header->imageCount; i++)
+    {
+        oc_wgpu_canvas_capture_image* captured = &capturedImages[i];
+        capture.images[i] = oc_image_create(renderer, captured->width, captured->height);
+        if(captured->pixelsSize && !oc_image_is_nil(capture.images[i]))
+        {
+            oc_image_upload_region_rgba8(capture.images[i],
+                                         (oc_rect){ 0, 0, captured->width, captured->height },
+                                         (u8*)mapping.ptr + captured->pixelsOffset);
+        }
+    }
+
+    capture.attributeCount = header->attributeCount;
+    capture.attributes = oc_arena_push_array(arena, oc_attributes, header->attributeCount);
+    memcpy(capture.attributes, mapping.ptr + header->attributesOffset, header->attributeCount * sizeof(oc_attributes));
+
+    for(u32 attrIndex = 0; attrIndex < capture.attributeCount; attrIndex++)
+    {
+        oc_attributes* attributes = &capture.attributes[attrIndex];
+        oc_image image = oc_image_nil();
+        for(u32 i = 0; i < capture.imageCount; i++)
+        {
+            if(capturedImages[i].handle == attributes->image.h)
+            {
+                image = capture.images[i];
+                break;
+            }
+        }
+        attributes->image = image;
+        //NOTE: fonts aren't used by the renderer, glyphs are submitted as path elements
+        attributes->font = oc_font_nil();
+    }
+
+    return (capture);
+}
+
+void oc_wgpu_canvas_capture_unload(oc_wgpu_canvas_capture* capture)
+{
+    for(u32 i = 0; i < capture->imageCount; i++)
+    {
+        oc_image_destroy(capture->images[i]);
+    }
+    oc_file_unmap(capture->mapping);
+    memset(capture, 0, sizeof(oc_wgpu_canvas_capture));
+}
+
+void oc_wgpu_canvas_capture_replay(oc_canvas_renderer renderer, oc_surface surface, oc_wgpu_canvas_capture* capture)
+{
+    if(capture->mapping.ptr)
+    {
+        oc_canvas_renderer_submit(renderer,
+                                  surface,
+                                  capture->msaaSampleCount,
+                                  capture->clear,
+                                  capture->clearColor,
+                                  capture->damage,
+                                  capture->primitiveCount,
+                                  capture->primitives,
+                                  capture->attributeCount,
+                                  capture->attributes,
+                                  capture->eltCount,
+                                  capture->elements);
+    }
+}
@@ -7,17 +7,36 @@
 **************************************************************************/
 #pragma once
 
-#include "graphics.h"
+#include "graphics_common.h"
 
 //TODO: remove?
 typedef enum
 {
     OC_WGPU_CANVAS_TIMING_NONE = 0,
     OC_WGPU_CANVAS_TIMING_FRAME = 1 << 0,
-    OC_WGPU_CANVAS_TIMING_ALL = OC_WGPU_CANVAS_TIMING_FRAME,
+    OC_WGPU_CANVAS_TIMING_PASSES = 1 << 1,
+    OC_WGPU_CANVAS_TIMING_ALL = OC_WGPU_CANVAS_TIMING_FRAME | OC_WGPU_CANVAS_TIMING_PASSES,
     //...
 } oc_wgpu_canvas_timing_flags;
 
+//NOTE: GPU passes timed with OC_WGPU_CANVAS_TIMING_PASSES. Each entry covers the passes of that stage in all batches
+//      of a frame, up to OC_WGPU_CANVAS_PASS_TIMING_MAX_BATCHES batches.
+typedef enum oc_wgpu_canvas_pass
+{
+    OC_WGPU_CANVAS_PASS_SETUP,    // path setup and segment setup
+    OC_WGPU_CANVAS_PASS_BACKPROP, // backprop
+    OC_WGPU_CANVAS_PASS_CHUNK,    // chunk
+    OC_WGPU_CANVAS_PASS_MERGE,    // tile merge and balance workgroups
+    OC_WGPU_CANVAS_PASS_RASTER,   // raster
+    OC_WGPU_CANVAS_PASS_BLIT,     // batch blit
+    OC_WGPU_CANVAS_PASS_COUNT,
+} oc_wgpu_canvas_pass;
+
+enum
+{
+    OC_WGPU_CANVAS_PASS_TIMING_MAX_BATCHES = 16,
+};
+
 typedef struct oc_wgpu_canvas_record_options
 {
     u32 maxRecordCount;
@@ -60,6 +79,9 @@ typedef struct oc_wgpu_canvas_frame_counters
         f64 frameTimings[OC_WGPU_CANVAS_FRAME_STATS_FIELD_COUNT];
     };
 
+    bool hasPassTimes;
+    f64 passTimes[OC_WGPU_CANVAS_PASS_COUNT];
+
     u64 batchCount;
     u64 recordedBatchCount;
     oc_list batches;
@@ -101,8 +123,32 @@ typedef struct oc_wgpu_canvas_frame_stats
 
         oc_wgpu_canvas_stats frameStats[OC_WGPU_CANVAS_FRAME_STATS_FIELD_COUNT];
     };
+
+    oc_wgpu_canvas_stats passTime[OC_WGPU_CANVAS_PASS_COUNT];
+
+    u64 bufferMemory;     // bytes allocated for the path, segment and tile buffers
+    u64 imageArrayMemory; // bytes allocated for the shared image array texture
 } oc_wgpu_canvas_frame_stats;
 
+//NOTE: heatmaps are blended over the frame to show where the renderer spends its time. Counts are taken per pixel by
+//      the raster pass, from the tile ops it processes before the pixel turns opaque, and are mapped to a blue to red
+//      ramp on a log scale, reaching red at the heatmap's scale.
+typedef enum oc_wgpu_canvas_heatmap
+{
+    OC_WGPU_CANVAS_HEATMAP_NONE = 0,
+    OC_WGPU_CANVAS_HEATMAP_TILE_OPS, // tile ops processed
+    OC_WGPU_CANVAS_HEATMAP_SEGMENTS, // segment ops processed
+    OC_WGPU_CANVAS_HEATMAP_OVERDRAW, // paths composited
+    OC_WGPU_CANVAS_HEATMAP_BATCHES,  // tiles touched by each batch, tinted by batch index
+    OC_WGPU_CANVAS_HEATMAP_COUNT,
+} oc_wgpu_canvas_heatmap;
+
+enum
+{
+    //NOTE: number of colors cycled through by the batches heatmap
+    OC_WGPU_CANVAS_HEATMAP_BATCH_COLOR_COUNT = 6,
+};
+
 typedef struct oc_wgpu_canvas_debug_display_options
 {
     bool showTileBorders;
@@ -113,6 +159,10 @@ typedef struct oc_wgpu_canvas_debug_display_options
     i32 pathStart;
     i32 pathCount;
 
+    oc_wgpu_canvas_heatmap heatmap;
+    u32 heatmapScale;          // count shown in red, 0 for the heatmap's default scale
+    oc_surface heatmapExclude; // surface drawn without the heatmap, e.g. a debug overlay
+
 } oc_wgpu_canvas_debug_display_options;
 
 ORCA_API void oc_wgpu_canvas_debug_set_record_options(oc_canvas_renderer handle, oc_wgpu_canvas_record_options* options);
@@ -123,7 +173,50 @@ ORCA_API oc_list oc_wgpu_canvas_debug_get_records(oc_canvas_renderer handle);
 ORCA_API void oc_wgpu_canvas_debug_log_records(oc_list records);
 
 ORCA_API oc_wgpu_canvas_frame_stats oc_wgpu_canvas_get_frame_stats(oc_canvas_renderer handle, int desiredSampleCount);
+ORCA_API const char* oc_wgpu_canvas_pass_name(oc_wgpu_canvas_pass pass);
+
+ORCA_API const char* oc_wgpu_canvas_heatmap_name(oc_wgpu_canvas_heatmap heatmap);
+ORCA_API u32 oc_wgpu_canvas_heatmap_default_scale(oc_wgpu_canvas_heatmap heatmap);
+//NOTE: color drawn by a heatmap for a count (or a batch index for the batches heatmap), to build legends
+ORCA_API oc_color oc_wgpu_canvas_heatmap_color(oc_wgpu_canvas_heatmap heatmap, u32 count, u32 scale);
 ORCA_API int oc_wgpu_canvas_stats_sample_count_for_95_confidence(oc_wgpu_canvas_stats* stats, f32 marginRelativeToMean);
 
+//NOTE: frame captures hold everything a renderer needs to draw a frame again: the primitive, attribute and element
+//      streams, the contents of the images they reference, and the submission settings. Captures are written in a
+//      binary format that can be mapped in memory and replayed as is, so that a slow frame can be profiled offline.
+//      Compressed images can't be read back, and are replayed as blank images of the same size.
+typedef struct oc_wgpu_canvas_capture
+{
+    oc_str8 mapping; // empty if the capture couldn't be loaded
+
+    u32 msaaSampleCount;
+    bool clear;
+    oc_color clearColor;
+    oc_rect damage;
+    oc_vec2 surfaceSize; // in pixels
+
+    u32 primitiveCount;
+    oc_primitive* primitives;
+    u32 attributeCount;
+    oc_attributes* attributes; // copy of the captured attributes, referencing the replay images
+    u32 eltCount;
+    oc_path_elt* elements;
+
+    u32 imageCount;
+    oc_image* images;
+
+} oc_wgpu_canvas_capture;
+
+//NOTE: writes the next frame submitted to a surface to a capture file at path
+ORCA_API void oc_wgpu_canvas_debug_capture_next_frame(oc_canvas_renderer handle, oc_str8 path);
+
+//NOTE: maps a capture file and creates its images with renderer. The capture stays valid until it is unloaded.
+ORCA_API oc_wgpu_canvas_capture oc_wgpu_canvas_capture_load(oc_arena* arena, oc_canvas_renderer renderer, oc_str8 path);
+ORCA_API void oc_wgpu_canvas_capture_unload(oc_wgpu_canvas_capture* capture);
+ORCA_API void oc_wgpu_canvas_capture_replay(oc_canvas_renderer renderer, oc_surface surface, oc_wgpu_canvas_capture* capture);
+
 ORCA_API void oc_wgpu_canvas_debug_set_display_options(oc_canvas_renderer handle, oc_wgpu_canvas_debug_display_options* options);
 ORCA_API oc_wgpu_canvas_debug_display_options oc_wgpu_canvas_debug_get_display_options(oc_canvas_renderer handle);
+
+//NOTE: GPU buffers that stay mostly unused for frameCount frames are shrunk to fit their recent usage. 0 disables shrinking.
+ORCA_API void oc_wgpu_canvas_set_buffer_shrink_delay(oc_canvas_renderer handle, u32 frameCount);
@@ -11,5 +11,11 @@
 #include "ext/dawn/include/webgpu.h"
 
 ORCA_API oc_surface oc_wgpu_surface_create_for_window(WGPUInstance instance, oc_window window);
-ORCA_API WGPUTexture oc_wgpu_surface_get_current_texture(oc_surface handle, WGPUDevice device);
+//NOTE: the surface is reconfigured when its size, device, present mode or max frame latency change. Present modes the
+//      surface doesn't support fall back to fifo, and a max frame latency of 0 keeps the platform default.
+ORCA_API WGPUTexture oc_wgpu_surface_get_current_texture(oc_surface handle,
+                                                         WGPUAdapter adapter,
+                                                         WGPUDevice device,
+                                                         WGPUPresentMode presentMode,
+                                                         u32 maxFrameLatency);
 ORCA_API void oc_wgpu_surface_present(oc_surface handle);
@@ -19,6 +19,8 @@ typedef struct oc_wgpu_surface
     WGPUSurface wgpuSurface;
     WGPUTexture currentTexture;
     oc_vec2 swapChainSize;
+    WGPUPresentMode presentMode; // as requested, before falling back to a supported mode
+    u32 maxFrameLatency;
 
 } oc_wgpu_surface;
 
@@ -44,6 +46,25 @@ void oc_wgpu_surface_destroy(oc_surface_base* base)
     }
 }
 
+//NOTE: a hidden surface doesn't need its swap chain. It is released, and recreated by the first
+//      oc_wgpu_surface_get_current_texture() after the surface is shown again.
+static void oc_wgpu_surface_set_hidden(oc_surface_base* base, bool hidden)
+{
+    oc_wgpu_surface* surface = (oc_wgpu_surface*)base;
+    oc_surface_base_set_hidden(base, hidden);
+
+    if(hidden && (surface->swapChainSize.x || surface->swapChainSize.y))
+    {
+        if(surface->currentTexture)
+        {
+            wgpuTextureRelease(surface->currentTexture);
+            surface->currentTexture = 0;
+        }
+        wgpuSurfaceUnconfigure(surface->wgpuSurface);
+        surface->swapChainSize = (oc_vec2){ 0, 0 };
+    }
+}
+
 oc_surface oc_wgpu_surface_create_for_window(WGPUInstance instance, oc_window window)
 {
     @autoreleasepool
@@ -59,6 +80,7 @@ oc_surface oc_wgpu_surface_create_for_window(WGPUInstance instance, oc_window wi
 
             surface->base.api = OC_SURFACE_WEBGPU;
             surface->base.destroy = oc_wgpu_surface_destroy;
+            surface->base.setHidden = oc_wgpu_surface_set_hidden;
 
             surface->mtlLayer = [CAMetalLayer layer];
 
@@ -99,7 +121,37 @@ oc_surface oc_wgpu_surface_create_for_window(WGPUInstance instance, oc_window wi
     }
 }
 
-WGPUTexture oc_wgpu_surface_get_current_texture(oc_surface handle, WGPUDevice device)
+static WGPUPresentMode oc_wgpu_surface_supported_present_mode(oc_wgpu_surface* surface, WGPUAdapter adapter, WGPUPresentMode mode)
+{
+    //NOTE: fifo is supported by all surfaces
+    WGPUPresentMode result = WGPUPresentMode_Fifo;
+    WGPUSurfaceCapabilities capabilities = { 0 };
+
+    if(mode != WGPUPresentMode_Fifo
+       && wgpuSurfaceGetCapabilities(surface->wgpuSurface, adapter, &capabilities) == WGPUStatus_Success)
+    {
+        for(size_t i = 0; i < capabilities.presentModeCount; i++)
+        {
+            if(capabilities.presentModes[i] == mode)
+            {
+                result = mode;
+                break;
+            }
+        }
+        wgpuSurfaceCapabilitiesFreeMembers(capabilities);
+    }
+    if(result != mode)
+    {
+        oc_log_warning("present mode not supported by surface, falling back to fifo\n");
+    }
+    return (result);
+}
+
+WGPUTexture oc_wgpu_surface_get_current_texture(oc_surface handle,
+                                                WGPUAdapter adapter,
+                                                WGPUDevice device,
+                                                WGPUPresentMode presentMode,
+                                                u32 maxFrameLatency)
 {
     WGPUTexture texture = 0;
 
@@ -129,9 +181,16 @@ WGPUTexture oc_wgpu_surface_get_current_texture(oc_surface handle, WGPUDevice de
             wgpuDeviceAddRef(surface->device);
 
             if(surface->swapChainSize.x != size.x
-               || surface->swapChainSize.y != size.y)
+               || surface->swapChainSize.y != size.y
+               || surface->presentMode != presentMode
+               || surface->maxFrameLatency != maxFrameLatency)
             {
                 surface->swapChainSize = size;
+                surface->presentMode = presentMode;
+                surface->maxFrameLatency = maxFrameLatency;
+
+                //NOTE: CAMetalLayer queues 2 or 3 drawables, which bounds how many frames wait for presentation
+                surface->mtlLayer.maximumDrawableCount = maxFrameLatency ? oc_clamp(maxFrameLatency + 1, 2, 3) : 3;
 
                 WGPUSurfaceConfiguration config = {
                     .device = device,
@@ -140,7 +199,7 @@ WGPUTexture oc_wgpu_surface_get_current_texture(oc_surface handle, WGPUDevice de
                     .alphaMode = WGPUCompositeAlphaMode_Premultiplied,
                     .width = size.x,
                     .height = size.y,
-                    .presentMode = WGPUPresentMode_Fifo,
+                    .presentMode = oc_wgpu_surface_supported_present_mode(surface, adapter, presentMode),
                 };
                 wgpuSurfaceConfigure(surface->wgpuSurface, &config);
             }
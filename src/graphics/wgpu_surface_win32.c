@@ -17,6 +17,8 @@ typedef struct oc_wgpu_surface
     WGPUSurface wgpuSurface;
     WGPUTexture currentTexture;
     oc_vec2 swapChainSize;
+    WGPUPresentMode presentMode; // as requested, before falling back to a supported mode
+    u32 maxFrameLatency;
 
 } oc_wgpu_surface;
 
@@ -37,6 +39,25 @@ void oc_wgpu_surface_destroy(oc_surface_base* base)
     free(surface);
 }
 
+//NOTE: a hidden surface doesn't need its swap chain. It is released, and recreated by the first
+//      oc_wgpu_surface_get_current_texture() after the surface is shown again.
+static void oc_wgpu_surface_set_hidden(oc_surface_base* base, bool hidden)
+{
+    oc_wgpu_surface* surface = (oc_wgpu_surface*)base;
+    oc_surface_base_set_hidden(base, hidden);
+
+    if(hidden && (surface->swapChainSize.x || surface->swapChainSize.y))
+    {
+        if(surface->currentTexture)
+        {
+            wgpuTextureRelease(surface->currentTexture);
+            surface->currentTexture = 0;
+        }
+        wgpuSurfaceUnconfigure(surface->wgpuSurface);
+        surface->swapChainSize = (oc_vec2){ 0, 0 };
+    }
+}
+
 oc_surface oc_wgpu_surface_create_for_window(WGPUInstance instance, oc_window window)
 {
     oc_wgpu_surface* surface = 0;
@@ -50,6 +71,7 @@ oc_surface oc_wgpu_surface_create_for_window(WGPUInstance instance, oc_window wi
 
         surface->base.api = OC_SURFACE_WEBGPU;
         surface->base.destroy = oc_wgpu_surface_destroy;
+        surface->base.setHidden = oc_wgpu_surface_set_hidden;
 
         WGPUSurfaceDescriptor desc = {
             .nextInChain = &((WGPUSurfaceDescriptorFromWindowsHWND){
@@ -69,7 +91,37 @@ oc_surface oc_wgpu_surface_create_for_window(WGPUInstance instance, oc_window wi
     return (handle);
 }
 
-WGPUTexture oc_wgpu_surface_get_current_texture(oc_surface handle, WGPUDevice device)
+static WGPUPresentMode oc_wgpu_surface_supported_present_mode(oc_wgpu_surface* surface, WGPUAdapter adapter, WGPUPresentMode mode)
+{
+    //NOTE: fifo is supported by all surfaces
+    WGPUPresentMode result = WGPUPresentMode_Fifo;
+    WGPUSurfaceCapabilities capabilities = { 0 };
+
+    if(mode != WGPUPresentMode_Fifo
+       && wgpuSurfaceGetCapabilities(surface->wgpuSurface, adapter, &capabilities) == WGPUStatus_Success)
+    {
+        for(size_t i = 0; i < capabilities.presentModeCount; i++)
+        {
+            if(capabilities.presentModes[i] == mode)
+            {
+                result = mode;
+                break;
+            }
+        }
+        wgpuSurfaceCapabilitiesFreeMembers(capabilities);
+    }
+    if(result != mode)
+    {
+        oc_log_warning("present mode not supported by surface, falling back to fifo\n");
+    }
+    return (result);
+}
+
+WGPUTexture oc_wgpu_surface_get_current_texture(oc_surface handle,
+                                                WGPUAdapter adapter,
+                                                WGPUDevice device,
+                                                WGPUPresentMode presentMode,
+                                                u32 maxFrameLatency)
 {
     WGPUTexture texture = 0;
 
@@ -99,9 +151,16 @@ WGPUTexture oc_wgpu_surface_get_current_texture(oc_surface handle, WGPUDevice de
             wgpuDeviceAddRef(surface->device);
 
             if(surface->swapChainSize.x != size.x
-               || surface->swapChainSize.y != size.y)
+               || surface->swapChainSize.y != size.y
+               || surface->presentMode != presentMode
+               || surface->maxFrameLatency != maxFrameLatency)
             {
                 surface->swapChainSize = size;
+                surface->presentMode = presentMode;
+                surface->maxFrameLatency = maxFrameLatency;
+
+                //NOTE: Dawn doesn't expose the frame latency of its DXGI swap chains, so maxFrameLatency isn't applied
+                //      on Windows. Mailbox and immediate presentation still avoid waiting on vertical blank.
 
                 WGPUSurfaceConfiguration config = {
                     .device = device,
@@ -110,7 +169,7 @@ WGPUTexture oc_wgpu_surface_get_current_texture(oc_surface handle, WGPUDevice de
                     .alphaMode = WGPUCompositeAlphaMode_Premultiplied,
                     .width = size.x,
                     .height = size.y,
-                    .presentMode = WGPUPresentMode_Fifo,
+                    .presentMode = oc_wgpu_surface_supported_present_mode(surface, adapter, presentMode),
                 };
                 wgpuSurfaceConfigure(surface->wgpuSurface, &config);
             }
@@ -134,6 +193,10 @@ void oc_wgpu_surface_present(oc_surface handle)
             wgpuSurfacePresent(surface->wgpuSurface);
             wgpuTextureRelease(surface->currentTexture);
             surface->currentTexture = 0;
+
+            oc_win32_window_frame_presented(surface->base.view.parent,
+                                            (u32)(surface->swapChainSize.x + 0.5),
+                                            (u32)(surface->swapChainSize.y + 0.5));
         }
     }
 }
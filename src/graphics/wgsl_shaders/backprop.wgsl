@@ -26,6 +26,11 @@ var<workgroup> nextRowIndex : atomic<i32>;
     let rowSize : i32 = (*pathBin).area.z;
     let rowCount : i32 = (*pathBin).area.w;
     let binQueueStartIndex = (*pathBin).binQueues;
+    if(binQueueStartIndex < 0)
+    {
+        //NOTE: rectangles and paths that overflowed the bin queues have no winding offsets to propagate
+        return;
+    }
 
     var rowIndex : i32 = atomicAdd(&nextRowIndex, 1);
 
@@ -0,0 +1,58 @@
+enable chromium_experimental_subgroups;
+
+//------------------------------------------------------------------------------------------------
+// Backprop pass, subgroup variant
+//------------------------------------------------------------------------------------------------
+
+//NOTE: same as backprop.wgsl, but instead of summing one row per invocation, the 16 invocations of the workgroup
+//      sum each row together, 16 tiles at a time from right to left, with a subgroup scan. This is only used when
+//      subgroups have at least 16 invocations, so that the workgroup is a single subgroup.
+
+@group(0) @binding(0) var<storage, read> pathBins : array<oc_path_bin>;
+@group(0) @binding(1) var<uniform> pathCount : u32;
+@group(0) @binding(2) var<storage, read_write> binQueues : array<oc_bin_queue>;
+
+@compute @workgroup_size(16) fn backprop(@builtin(num_workgroups) workGroupCount : vec3u,
+                                         @builtin(workgroup_id) workGroupID : vec3u)
+{
+    let pathIndex : u32 = workGroupID.y * workGroupCount.x + workGroupID.x;
+    if(pathIndex >= pathCount)
+    {
+        return;
+    }
+
+    let rowSize : i32 = pathBins[pathIndex].area.z;
+    let rowCount : i32 = pathBins[pathIndex].area.w;
+    let binQueueStartIndex = pathBins[pathIndex].binQueues;
+    if(binQueueStartIndex < 0)
+    {
+        //NOTE: rectangles and paths that overflowed the bin queues have no winding offsets to propagate
+        return;
+    }
+
+    let lane : i32 = subgroupExclusiveAdd(1);
+
+    for(var rowIndex : i32 = 0; rowIndex < rowCount; rowIndex++)
+    {
+        var sum : i32 = 0;
+        for(var lastX : i32 = rowSize - 1; lastX >= 0; lastX -= 16)
+        {
+            let x : i32 = lastX - lane;
+            let tileIndex : i32 = binQueueStartIndex + rowIndex * rowSize + x;
+
+            var offset : i32 = 0;
+            if(x >= 0)
+            {
+                offset = binQueues[tileIndex].windingOffset;
+            }
+
+            //NOTE: lanes are ordered from right to left, so the exclusive scan sums the tiles on the right
+            let rightSum : i32 = subgroupExclusiveAdd(offset);
+            if(x >= 0)
+            {
+                binQueues[tileIndex].windingOffset = sum + rightSum;
+            }
+            sum += subgroupAdd(offset);
+        }
+    }
+}
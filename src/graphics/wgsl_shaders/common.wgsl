@@ -9,6 +9,22 @@ struct oc_path
     textureID : i32,
     hasGradient : i32,
     blendSpace : i32,
+    textureRegion : vec4f,
+    radius : f32,
+    clipDepth : i32,
+    gradientIndex : i32,
+};
+
+//NOTE: linear or radial gradient referenced by a path's gradientIndex. Rows map pixels to the gradient's space, where
+//      linear gradients go from 0 to 1 along x, and radial gradients from 0 at the origin to 1 at a distance of 1.
+struct oc_gradient
+{
+    rows : array<vec4f, 2>,
+    kind : i32,
+    blendSpace : i32,
+    stopCount : u32,
+    offsets : array<vec4f, OC_GRADIENT_MAX_STOPS / 4>,
+    colors : array<vec4f, OC_GRADIENT_MAX_STOPS>,
 };
 
 struct oc_path_elt
@@ -31,12 +47,13 @@ struct oc_segment
     debugID : i32,
 };
 
+//NOTE: tile ops are packed in two words to halve the bandwidth of the raster loop.
+//      The top 3 bits of data hold the op kind, and bit 28 flags segments crossing the tile's right boundary.
+//      The low 28 bits hold the segment or path index, or the (signed) winding offset for start ops.
 struct oc_tile_op
 {
-    kind : i32,
+    data : u32,
     next : i32,
-    index : u32,
-    windingOffsetOrCrossRight : i32,
 };
 
 struct oc_bin_queue
@@ -84,10 +101,30 @@ struct oc_debug_display_options
     showClip : u32,
     textureOff: u32,
     debugTileQueues : u32,
+    heatmap : u32,
+    heatmapScale : u32,
+    batchIndex : u32,
 };
 
+const OC_HEATMAP_NONE : u32 = 0;
+const OC_HEATMAP_TILE_OPS : u32 = 1;
+const OC_HEATMAP_SEGMENTS : u32 = 2;
+const OC_HEATMAP_OVERDRAW : u32 = 3;
+const OC_HEATMAP_BATCHES : u32 = 4;
+const OC_HEATMAP_BATCH_COLOR_COUNT : u32 = 6;
+
 const OC_CMD_FILL : u32 = 0;
 const OC_CMD_STROKE : u32 = 1;
+const OC_CMD_RECT : u32 = 3;
+const OC_CMD_RRECT : u32 = 4;
+const OC_CMD_CLIP_PATH : u32 = 6;
+const OC_CMD_CLIP_POP : u32 = 7;
+
+const OC_CLIP_PATH_MAX_DEPTH : i32 = 4;
+
+const OC_GRADIENT_LINEAR : i32 = 1;
+const OC_GRADIENT_RADIAL : i32 = 2;
+const OC_GRADIENT_MAX_STOPS : u32 = 8;
 
 const OC_SEG_BL : i32 = 0; // curve on bottom left
 const OC_SEG_BR : i32 = 1; // curve on bottom right
@@ -97,12 +134,113 @@ const OC_SEG_TR : i32 = 3; // curve on top right
 const OC_SEG_LINE : i32 = 1;
 const OC_SEG_QUADRATIC : i32 = 2;
 const OC_SEG_CUBIC : i32 = 3;
+const OC_SEG_STROKE_LINE : i32 = 4;
+const OC_SEG_STROKE_JOINT : i32 = 5;
+const OC_SEG_STROKE_CAP : i32 = 6;
 
 const OC_OP_START : i32 = 0;
 const OC_OP_CLIP_FILL : i32 = 1;
 const OC_OP_FILL : i32 = 2;
 const OC_OP_SEGMENT : i32 = 3;
 const OC_OP_END : i32 = 4;
+const OC_OP_RECT : i32 = 5;
+const OC_OP_CLIP_BEGIN : i32 = 6;
+
+const OC_OP_KIND_SHIFT : u32 = 29u;
+const OC_OP_CROSS_RIGHT_BIT : u32 = 1u << 28u;
+const OC_OP_PAYLOAD_MASK : u32 = (1u << 28u) - 1u;
+
+fn tile_op_pack(kind : i32, payload : u32) -> u32
+{
+    return((u32(kind) << OC_OP_KIND_SHIFT) | (payload & OC_OP_PAYLOAD_MASK));
+}
+
+fn tile_op_pack_winding(kind : i32, windingOffset : i32) -> u32
+{
+    return(tile_op_pack(kind, bitcast<u32>(windingOffset)));
+}
+
+fn tile_op_kind(op : oc_tile_op) -> i32
+{
+    return(i32(op.data >> OC_OP_KIND_SHIFT));
+}
+
+fn tile_op_index(op : oc_tile_op) -> u32
+{
+    return(op.data & OC_OP_PAYLOAD_MASK);
+}
+
+fn tile_op_winding(op : oc_tile_op) -> i32
+{
+    //NOTE: sign-extend the 28 bits payload
+    return(bitcast<i32>(op.data << 4u) >> 4u);
+}
+
+fn tile_op_crosses_right(op : oc_tile_op) -> bool
+{
+    return((op.data & OC_OP_CROSS_RIGHT_BIT) != 0u);
+}
+
+const OC_RECT_TILE_OUTSIDE : i32 = 0;
+const OC_RECT_TILE_PARTIAL : i32 = 1;
+const OC_RECT_TILE_INSIDE : i32 = 2;
+
+//NOTE: accumulated alpha above which lower layers can't change the 8-bit output anymore
+const OC_OPAQUE_ALPHA : f32 = 1. - 1./512.;
+
+//NOTE: a path hides what's beneath it where it fully covers a pixel if all its colors are opaque.
+//      We don't know the alpha of textures, so textured paths are never considered opaque.
+//      Paths painted by a gradient of the gradient buffer hold the lowest alpha of its stops in colors[0].
+fn path_is_opaque(path : oc_path) -> bool
+{
+    var opaque = (path.textureID < 0) && (path.colors[0].a == 1);
+    if(path.hasGradient != 0)
+    {
+        opaque = opaque
+              && (path.colors[1].a == 1)
+              && (path.colors[2].a == 1)
+              && (path.colors[3].a == 1);
+    }
+    return(opaque);
+}
+
+//NOTE: rectangle paths have no segments, their coverage is computed from their box and corner radius.
+fn cmd_is_rect(cmd : u32) -> bool
+{
+    return(cmd == OC_CMD_RECT || cmd == OC_CMD_RRECT);
+}
+
+//NOTE: rectangles and clip pop markers have no segments, so they don't need per-tile bin queues
+fn cmd_has_bin_queues(cmd : u32) -> bool
+{
+    return(!cmd_is_rect(cmd) && cmd != OC_CMD_CLIP_POP);
+}
+
+fn rect_contains(box : vec4f, radius : f32, p : vec2f) -> bool
+{
+    let center = 0.5 * (box.xy + box.zw);
+    let corner = max(abs(p - center) - (0.5 * (box.zw - box.xy) - vec2f(radius, radius)), vec2f(0, 0));
+
+    return(p.x >= box.x && p.x < box.z
+        && p.y >= box.y && p.y < box.w
+        && dot(corner, corner) <= radius * radius);
+}
+
+fn rect_tile_coverage(box : vec4f, radius : f32, tileBox : vec4f) -> i32
+{
+    var coverage = OC_RECT_TILE_PARTIAL;
+    if(tileBox.x >= box.z || tileBox.z <= box.x || tileBox.y >= box.w || tileBox.w <= box.y)
+    {
+        coverage = OC_RECT_TILE_OUTSIDE;
+    }
+    else if((tileBox.x >= box.x + radius && tileBox.z <= box.z - radius && tileBox.y >= box.y && tileBox.w <= box.w)
+          ||(tileBox.x >= box.x && tileBox.z <= box.z && tileBox.y >= box.y + radius && tileBox.w <= box.w - radius))
+    {
+        //NOTE: the tile is inside the horizontal or vertical band of the rectangle that excludes the corners
+        coverage = OC_RECT_TILE_INSIDE;
+    }
+    return(coverage);
+}
 
 fn squaref(x : f32) -> f32
 {
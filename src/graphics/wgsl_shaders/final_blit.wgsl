@@ -21,15 +21,90 @@ struct vertex_out
     return out;
 }
 
-@fragment fn fs(@builtin(position) pos: vec4f) -> @location(0) vec4f
+fn srgb_encode(color: vec4f) -> vec4f
 {
-    var color = textureLoad(outTexture, vec2u(pos.xy), 0);
-
     let gamma : f32 = 1./2.4;
     let rgb = select(1.055 * pow(color.rgb, vec3f(gamma, gamma, gamma)) - vec3f(0.055, 0.055, 0.055),
                      color.rgb*12.92,
                      color.rgb <= vec3f(0.0031308, 0.0031308, 0.0031308));
 
-    color = vec4f(rgb, color.a);
+    return (vec4f(rgb, color.a));
+}
+
+fn blit_color(pos: vec4f) -> vec4f
+{
+    return (srgb_encode(textureLoad(outTexture, vec2u(pos.xy), 0)));
+}
+
+@fragment fn fs(@builtin(position) pos: vec4f) -> @location(0) vec4f
+{
+    return (blit_color(pos));
+}
+
+//NOTE: image targets hold straight alpha, so we composite over the clear color and un-premultiply
+@group(0) @binding(1) var<uniform> clearColor : vec4f;
+
+@fragment fn fs_image(@builtin(position) pos: vec4f) -> @location(0) vec4f
+{
+    var color = blit_color(pos);
+    color = color + (1 - color.a) * clearColor;
+
+    if(color.a > 0)
+    {
+        color = vec4f(color.rgb / color.a, color.a);
+    }
     return (color);
 }
+
+//NOTE: frames rendered at a dynamic render scale only cover part of outTexture, and are upscaled to the target with a
+//      Catmull-Rom filter, which keeps edges sharper than a bilinear one. Its 16 taps are folded into 9 bilinear samples
+//      by merging the two middle taps of each axis, whose weights are both positive.
+struct scaled_blit_params
+{
+    scale : vec2f,      // rendered size over target size
+    renderSize : vec2f, // rendered size, in texels of outTexture
+};
+
+@group(0) @binding(2) var<uniform> scaledBlitParams : scaled_blit_params;
+@group(0) @binding(3) var linearSampler : sampler;
+
+fn scaled_sample(texel: vec2f, texSize: vec2f) -> vec4f
+{
+    //NOTE: clamp to the centers of the edge texels, so that we don't filter in texels outside the rendered frame
+    let p = clamp(texel, vec2f(0.5, 0.5), scaledBlitParams.renderSize - vec2f(0.5, 0.5));
+    return (textureSampleLevel(outTexture, linearSampler, p / texSize, 0));
+}
+
+@fragment fn fs_scaled(@builtin(position) pos: vec4f) -> @location(0) vec4f
+{
+    let texSize = vec2f(textureDimensions(outTexture));
+    let samplePos = pos.xy * scaledBlitParams.scale;
+    let center = floor(samplePos - vec2f(0.5, 0.5)) + vec2f(0.5, 0.5);
+    let f = samplePos - center;
+
+    let w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    let w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    let w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    let w3 = f * f * (-0.5 + 0.5 * f);
+
+    let w12 = w1 + w2;
+    let p0 = center - vec2f(1, 1);
+    let p12 = center + w2 / w12;
+    let p3 = center + vec2f(2, 2);
+
+    var color = scaled_sample(vec2f(p0.x, p0.y), texSize) * w0.x * w0.y
+              + scaled_sample(vec2f(p12.x, p0.y), texSize) * w12.x * w0.y
+              + scaled_sample(vec2f(p3.x, p0.y), texSize) * w3.x * w0.y
+              + scaled_sample(vec2f(p0.x, p12.y), texSize) * w0.x * w12.y
+              + scaled_sample(vec2f(p12.x, p12.y), texSize) * w12.x * w12.y
+              + scaled_sample(vec2f(p3.x, p12.y), texSize) * w3.x * w12.y
+              + scaled_sample(vec2f(p0.x, p3.y), texSize) * w0.x * w3.y
+              + scaled_sample(vec2f(p12.x, p3.y), texSize) * w12.x * w3.y
+              + scaled_sample(vec2f(p3.x, p3.y), texSize) * w3.x * w3.y;
+
+    //NOTE: the filter's negative lobes can overshoot, keep the result a valid premultiplied color
+    color = clamp(color, vec4f(0, 0, 0, 0), vec4f(1, 1, 1, 1));
+    color = vec4f(min(color.rgb, vec3f(color.a, color.a, color.a)), color.a);
+
+    return (srgb_encode(color));
+}
@@ -0,0 +1,52 @@
+
+//------------------------------------------------------------------------------------------------
+// Glyph expand
+//------------------------------------------------------------------------------------------------
+
+struct oc_glyph_instance
+{
+    row0 : vec4f, // rows of the glyph's transform to pixels, w is unused
+    row1 : vec4f,
+    eltStart : u32, // first element of the glyph's outline in glyphOutlineBuffer
+    eltCount : u32,
+    outStart : u32, // first element written to eltBuffer
+    pathIndex : i32,
+};
+
+@group(0) @binding(0) var<storage, read> glyphOutlineBuffer : array<oc_path_elt>;
+@group(0) @binding(1) var<storage, read> glyphInstanceBuffer : array<oc_glyph_instance>;
+@group(0) @binding(2) var<uniform> glyphInstanceCount : u32;
+@group(0) @binding(3) var<storage, read_write> eltBuffer : array<oc_path_elt>;
+
+@compute @workgroup_size(16, 16) fn glyph_expand(@builtin(num_workgroups) workGroupCount : vec3u,
+                                                 @builtin(workgroup_id) workGroupID : vec3u,
+                                                 @builtin(local_invocation_id) localID : vec3u)
+{
+    let invocationsPerWorkGroups : u32 = 16*16;
+    let workGroupIndex : u32 = workGroupID.y*workGroupCount.x + workGroupID.x;
+    let instanceIndex : u32 = workGroupIndex * invocationsPerWorkGroups + localID.y*16 + localID.x;
+
+    if(instanceIndex >= glyphInstanceCount)
+    {
+        return;
+    }
+
+    let instance = glyphInstanceBuffer[instanceIndex];
+
+    //NOTE: cached outlines are in font units, with the same layout as the elements encoded on the CPU. Transform them
+    //      to pixels and write them after the CPU elements, so that the segment setup pass sees a single element stream.
+    for(var i : u32 = 0; i < instance.eltCount; i++)
+    {
+        let src = glyphOutlineBuffer[instance.eltStart + i];
+
+        var dst : oc_path_elt;
+        dst.pathIndex = instance.pathIndex;
+        dst.kind = src.kind;
+        for(var j : i32 = 0; j < 4; j++)
+        {
+            dst.p[j] = vec2f(dot(instance.row0.xy, src.p[j]) + instance.row0.z,
+                             dot(instance.row1.xy, src.p[j]) + instance.row1.z);
+        }
+        eltBuffer[instance.outStart + i] = dst;
+    }
+}
@@ -61,11 +61,16 @@
                 tileQueues[tileIndex].first = -1;
             }
 
+            //NOTE: paths without bin queues are rectangles, which have neither winding offsets nor segment ops
             let binQueueIndex : i32 = pathBin.binQueues + binCoord.y * pathBin.area.z + binCoord.x;
-            let binQueue = &binQueues[binQueueIndex];
 
-            let windingOffset : i32 = (*binQueue).windingOffset;
-            let firstOpIndex : i32 = (*binQueue).first;
+            var windingOffset : i32 = 0;
+            var firstOpIndex : i32 = -1;
+            if(pathBin.binQueues >= 0)
+            {
+                windingOffset = binQueues[binQueueIndex].windingOffset;
+                firstOpIndex = binQueues[binQueueIndex].first;
+            }
 
             var tileBox = vec4f(f32(tileCoord.x), f32(tileCoord.y), f32(tileCoord.x + 1), f32(tileCoord.y + 1));
             tileBox *= f32(tileSize);
@@ -78,11 +83,46 @@
                 //NOTE: tile is fully outside clip, cull it
                 //TODO: move that test up
             }
-            else if(firstOpIndex == -1)
+            else if(pathBuffer[pathIndex].cmd == OC_CMD_CLIP_POP)
+            {
+                //NOTE: the marker closing a clip path opens a clip layer, which the clip path's end op closes
+                //      further down the list (see raster.wgsl). Both cover the same tiles.
+                let opIndex = atomicAdd(&tileOpCount, 1u);
+                if(opIndex >= arrayLength(&tileOpBuffer))
+                {
+                    //TODO: signal there's not enough tile ops
+                    return;
+                }
+
+                tileOpBuffer[opIndex].data = tile_op_pack(OC_OP_CLIP_BEGIN, pathIndex);
+                tileOpBuffer[opIndex].next = -1;
+
+                if(lastOpIndex < 0)
+                {
+                    tileQueues[tileIndex].first = i32(opIndex);
+                }
+                else
+                {
+                    tileOpBuffer[lastOpIndex].next = i32(opIndex);
+                }
+                lastOpIndex = i32(opIndex);
+            }
+            else if(firstOpIndex == -1 && pathBuffer[pathIndex].cmd != OC_CMD_CLIP_PATH)
             {
-                //NOTE: This bin queue has no ops. This means the tile is fully inside or fully outside the path
-                if( ((pathBuffer[pathIndex].cmd == OC_CMD_FILL) && ((windingOffset & 1) != 0))
-                  ||((pathBuffer[pathIndex].cmd == OC_CMD_STROKE) && (windingOffset != 0)))
+                //NOTE: This bin queue has no ops. This means the tile is fully inside or fully outside the path,
+                //      or that the path is a rectangle, which may also cover the tile partially.
+                var covered = ((pathBuffer[pathIndex].cmd == OC_CMD_FILL) && ((windingOffset & 1) != 0))
+                           || ((pathBuffer[pathIndex].cmd == OC_CMD_STROKE) && (windingOffset != 0));
+                var partial = false;
+
+                if(cmd_is_rect(pathBuffer[pathIndex].cmd))
+                {
+                    let coverage = rect_tile_coverage(pathBox, pathBuffer[pathIndex].radius, tileBox);
+                    covered = (coverage != OC_RECT_TILE_OUTSIDE);
+                    partial = (coverage == OC_RECT_TILE_PARTIAL);
+                }
+
+                if(covered)
                 {
                     //NOTE: tile is full covered. Add fill op (with winding offset).
                     //      Additionally if color is opaque and tile is fully inside clip, trim tile list.
@@ -94,10 +134,8 @@
                         return;
                     }
 
-                    tileOpBuffer[opIndex].kind = OC_OP_CLIP_FILL;
+                    tileOpBuffer[opIndex].data = tile_op_pack(select(OC_OP_CLIP_FILL, OC_OP_RECT, partial), pathIndex);
                     tileOpBuffer[opIndex].next = -1;
-                    tileOpBuffer[opIndex].index = pathIndex;
-                    tileOpBuffer[opIndex].windingOffsetOrCrossRight = windingOffset;
 
                     if(lastOpIndex < 0)
                     {
@@ -108,18 +146,19 @@
                         tileOpBuffer[lastOpIndex].next = i32(opIndex);
                     }
 
-                    if(tileBox.x >= clip.x
+                    if(!partial
+                       && tileBox.x >= clip.x
                        && tileBox.z < clip.z
                        && tileBox.y >= clip.y
                        && tileBox.w < clip.w)
                     {
-                        tileOpBuffer[opIndex].kind = OC_OP_FILL;
+                        tileOpBuffer[opIndex].data = tile_op_pack(OC_OP_FILL, pathIndex);
 
-                        if(pathBuffer[pathIndex].colors[0].a == 1
-                           && pathBuffer[pathIndex].textureID < 0)
+                        if(path_is_opaque(pathBuffer[pathIndex]) && pathBuffer[pathIndex].clipDepth == 0)
                         {
                             //NOTE(martin): the tile is fully opaque, so no need to continue
-                            // traversing lower-Z paths
+                            // traversing lower-Z paths. Paths inside a clip layer can still be masked
+                            // out, and must not hide the end of their layer.
                             return;
                         }
                     }
@@ -129,6 +168,9 @@
             }
             else
             {
+                //NOTE: clip paths always get start and end ops, even on tiles they fully cover or don't cover at all,
+                //      to close the clip layer opened by their marker.
+
                 //NOTE: add path start op (with winding offset)
                 let startOpIndex : u32 = atomicAdd(&tileOpCount, 1u);
                 if(startOpIndex >= arrayLength(&tileOpBuffer))
@@ -137,10 +179,8 @@
                     return;
                 }
 
-                tileOpBuffer[startOpIndex].kind = OC_OP_START;
+                tileOpBuffer[startOpIndex].data = tile_op_pack_winding(OC_OP_START, windingOffset);
                 tileOpBuffer[startOpIndex].next = -1;
-                tileOpBuffer[startOpIndex].index = pathIndex;
-                tileOpBuffer[startOpIndex].windingOffsetOrCrossRight = windingOffset;
 
                 if(lastOpIndex < 0)
                 {
@@ -153,8 +193,11 @@
                 lastOpIndex = i32(startOpIndex);
 
                 //NOTE: chain remaining path ops to end of tile list
-                tileOpBuffer[lastOpIndex].next = firstOpIndex;
-                lastOpIndex = (*binQueue).last;
+                if(firstOpIndex >= 0)
+                {
+                    tileOpBuffer[lastOpIndex].next = firstOpIndex;
+                    lastOpIndex = binQueues[binQueueIndex].last;
+                }
 
                 //NOTE: add path end op
                 let endOpIndex : u32 = atomicAdd(&tileOpCount, 1u);
@@ -164,10 +207,8 @@
                     return;
                 }
 
-                tileOpBuffer[endOpIndex].kind = OC_OP_END;
+                tileOpBuffer[endOpIndex].data = tile_op_pack(OC_OP_END, pathIndex);
                 tileOpBuffer[endOpIndex].next = -1;
-                tileOpBuffer[endOpIndex].index = pathIndex;
-                //tileOpBuffer[endOpIndex].windingOffsetOrCrossRight = windingOffset;
 
                 if(lastOpIndex < 0)
                 {
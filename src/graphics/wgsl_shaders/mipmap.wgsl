@@ -0,0 +1,25 @@
+//------------------------------------------------------------------------------------------------
+// Mipmap
+//------------------------------------------------------------------------------------------------
+
+@group(0) @binding(0) var srcTexture : texture_2d<f32>;
+@group(0) @binding(1) var srcSampler : sampler;
+
+@vertex fn vs(@builtin(vertex_index) vertexIndex : u32) -> @builtin(position) vec4f
+{
+    var pos = vec2f(f32((vertexIndex << 1) & 2), f32(vertexIndex & 2));
+
+    var out : vec4f = vec4f(0, 0, 0, 1);
+
+    out = vec4f(pos * vec2f(2, 2) + vec2f(-1, -1), 0.0, 1.0);
+    return out;
+}
+
+@fragment fn fs(@builtin(position) pos: vec4f) -> @location(0) vec4f
+{
+    //NOTE: srcTexture is a view of the previous mip level. Sampling at the center of each destination pixel
+    //      lands between 2x2 source texels, which the linear sampler averages.
+    let dstSize = max(textureDimensions(srcTexture) / 2, vec2u(1, 1));
+    let uv = pos.xy / vec2f(dstSize);
+    return(textureSampleLevel(srcTexture, srcSampler, uv, 0));
+}
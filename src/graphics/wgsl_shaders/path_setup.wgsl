@@ -40,6 +40,16 @@
     let nTilesY : i32 = max(0, lastTile.y - firstTile.y + 1);
     let tileCount : u32 = u32(nTilesX * nTilesY);
 
+    if(!cmd_has_bin_queues(path.cmd))
+    {
+        //NOTE: the coverage of a rectangle on any tile is computed from its box, so it doesn't need per-tile bin
+        //      queues. It only records its tile area, which tiles test against in the merge pass. Clip pop markers
+        //      don't have any coverage, but also need their tile area.
+        pathBins[pathIndex].area = vec4i(firstTile.x, firstTile.y, nTilesX, nTilesY);
+        pathBins[pathIndex].binQueues = -1;
+        return;
+    }
+
     let binQueuesIndex : u32 = atomicAdd(&binQueueCount, tileCount);
 
     if(binQueuesIndex + tileCount >= arrayLength(&binQueueBuffer))
@@ -0,0 +1,99 @@
+enable chromium_experimental_subgroups;
+
+//------------------------------------------------------------------------------------------------
+// Path setup, subgroup variant
+//------------------------------------------------------------------------------------------------
+
+//NOTE: same as path_setup.wgsl, but the bin queues of a whole subgroup are allocated with a single atomic, which
+//      is offset by an exclusive scan of each path's tile count.
+
+@group(0) @binding(0) var<storage, read> pathBuffer : array<oc_path>;
+@group(0) @binding(1) var<uniform> pathCount : u32;
+@group(0) @binding(2) var<storage, read_write> pathBins : array<oc_path_bin>;
+@group(0) @binding(3) var<storage, read_write> binQueueBuffer : array<oc_bin_queue>;
+@group(0) @binding(4) var<storage, read_write> binQueueCount : atomic<u32>;
+@group(0) @binding(5) var<uniform> tileSize : i32;
+
+@compute @workgroup_size(16, 16) fn path_setup(@builtin(num_workgroups) workGroupCount : vec3u,
+                                               @builtin(workgroup_id) workGroupID : vec3u,
+                                               @builtin(local_invocation_id) localID : vec3u,
+                                               @builtin(subgroup_invocation_id) laneID : u32)
+{
+    let invocationsPerWorkGroups : u32 = 16*16;
+    let workGroupIndex : u32 = workGroupID.y*workGroupCount.x + workGroupID.x;
+    let pathIndex : u32 = workGroupIndex * invocationsPerWorkGroups + localID.y*16 + localID.x;
+
+    //NOTE: invocations past the last path stay alive until the subgroup operations are done, with no tiles
+    var area = vec4i(0, 0, 0, 0);
+    var isRect = false;
+
+    if(pathIndex < pathCount)
+    {
+        let path = pathBuffer[pathIndex];
+
+        //NOTE: we don't clip on the right, since we need those tiles to accurately compute
+        //      the prefix sum of winding increments in the backprop pass.
+
+        let clippedBox = vec4f(max(path.box.x, path.clip.x),
+                               max(path.box.y, path.clip.y),
+                               path.box.z,
+                               min(path.box.w, path.clip.w));
+
+        let firstTile = vec2i(clippedBox.xy) / tileSize;
+        let lastTile = vec2i(clippedBox.zw) / tileSize;
+
+        area = vec4i(firstTile.x,
+                     firstTile.y,
+                     max(0, lastTile.x - firstTile.x + 1),
+                     max(0, lastTile.y - firstTile.y + 1));
+
+        isRect = !cmd_has_bin_queues(path.cmd);
+    }
+
+    //NOTE: rectangles and clip pop markers don't need per-tile bin queues, see path_setup.wgsl
+    var tileCount : u32 = 0;
+    if(!isRect)
+    {
+        tileCount = u32(area.z * area.w);
+    }
+
+    let laneOffset : u32 = subgroupExclusiveAdd(tileCount);
+    let subgroupTileCount : u32 = subgroupAdd(tileCount);
+
+    var subgroupStart : u32 = 0;
+    if(laneID == 0)
+    {
+        subgroupStart = atomicAdd(&binQueueCount, subgroupTileCount);
+    }
+    subgroupStart = subgroupBroadcast(subgroupStart, 0u);
+
+    if(pathIndex >= pathCount)
+    {
+        return;
+    }
+
+    let binQueuesIndex : u32 = subgroupStart + laneOffset;
+
+    if(isRect)
+    {
+        pathBins[pathIndex].area = area;
+        pathBins[pathIndex].binQueues = -1;
+    }
+    else if(binQueuesIndex + tileCount >= arrayLength(&binQueueBuffer))
+    {
+        pathBins[pathIndex].area = vec4i(0, 0, 0, 0);
+        pathBins[pathIndex].binQueues = -1;
+    }
+    else
+    {
+        pathBins[pathIndex].area = area;
+        pathBins[pathIndex].binQueues = i32(binQueuesIndex);
+
+        for(var i : u32 = 0; i < tileCount; i++)
+        {
+            binQueueBuffer[binQueuesIndex + i].first = -1;
+            binQueueBuffer[binQueuesIndex + i].last = -1;
+            binQueueBuffer[binQueuesIndex + i].windingOffset = 0;
+        }
+    }
+}
@@ -5,6 +5,14 @@
 const OC_WGPU_MAX_SAMPLE_COUNT : u32 = 8;
 const OC_WGPU_SOURCE_SAMPLE_COUNT : u32 = 2;
 
+// specialization constants of the raster pipeline variants, see oc_wgpu_canvas_raster_pipeline(). Variants turn off
+// the features a batch doesn't use, and fix the sample count. The generic pipeline keeps the defaults, which read the
+// sample count from msaaSampleCount.
+override OC_WGPU_RASTER_IMAGES : bool = true;
+override OC_WGPU_RASTER_GRADIENTS : bool = true;
+override OC_WGPU_RASTER_DEBUG : bool = true;
+override OC_WGPU_RASTER_SAMPLE_COUNT : i32 = -1;
+
 
 @group(0) @binding(0) var<storage, read> pathBuffer : array<oc_path>;
 @group(0) @binding(1) var<storage, read> segmentBuffer : array<oc_segment>;
@@ -15,6 +23,7 @@ const OC_WGPU_SOURCE_SAMPLE_COUNT : u32 = 2;
 @group(0) @binding(6) var<uniform> tileSize : u32;
 @group(0) @binding(7) var outTexture : texture_storage_2d<rgba8unorm, write>;
 @group(0) @binding(8) var<uniform> debugDisplayOptions : oc_debug_display_options;
+@group(0) @binding(9) var<storage, read> gradientBuffer : array<oc_gradient>;
 
 // source textures bindgroup
 @group(1) @binding(0) var srcTexture0 : texture_2d<f32>;
@@ -25,10 +34,123 @@ const OC_WGPU_SOURCE_SAMPLE_COUNT : u32 = 2;
 @group(1) @binding(5) var srcTexture5 : texture_2d<f32>;
 @group(1) @binding(6) var srcTexture6 : texture_2d<f32>;
 @group(1) @binding(7) var srcTexture7 : texture_2d<f32>;
+@group(1) @binding(8) var srcTextureArray : texture_2d_array<f32>;
+@group(1) @binding(9) var srcSampler : sampler;
+@group(1) @binding(10) var<storage, read> tileTable : array<u32>;
+
+// texture IDs starting at OC_WGPU_IMAGE_ARRAY_TEXTURE_ID reference a layer of srcTextureArray, except for
+// OC_WGPU_TILED_TEXTURE_ID, which references a tiled image whose tiles are in srcTextureArray
+const OC_WGPU_IMAGE_ARRAY_TEXTURE_ID : i32 = 8;
+const OC_WGPU_TILED_TEXTURE_ID : i32 = 72;
+const OC_WGPU_TILE_SIZE : u32 = 256;
+const OC_WGPU_TILE_SLOTS_PER_ROW : u32 = 4;
+
+// textureRegion.x of paths sampling a YUV image from srcTexture0..7, 0 for other images. See oc_wgpu_yuv_texture_region().
+const OC_WGPU_YUV_NV12 : i32 = 1;
+const OC_WGPU_YUV_FLAG_FULL_RANGE : u32 = 1;
+const OC_WGPU_YUV_FLAG_BT709 : u32 = 2;
+
+
+//NOTE: bilinear sample of a plane of a YUV texture, whose samples are step texels apart horizontally
+fn yuvPlaneSample(texture : texture_2d<f32>, origin : vec2i, size : vec2i, step : i32, uv : vec2f) -> f32
+{
+    let p : vec2f = clamp(uv * vec2f(size) - vec2f(0.5, 0.5),
+                          vec2f(0, 0),
+                          vec2f(size - vec2i(1, 1)));
+    let r = fract(p);
+
+    let scale = vec2i(step, 1);
+    let tl = vec2i(p);
+    let br = min(tl + vec2i(1, 1), size - vec2i(1, 1));
+    let bl = vec2i(tl.x, br.y);
+    let tr = vec2i(br.x, tl.y);
+
+    let tlValue : f32 = textureLoad(texture, origin + tl * scale, 0).r;
+    let blValue : f32 = textureLoad(texture, origin + bl * scale, 0).r;
+    let trValue : f32 = textureLoad(texture, origin + tr * scale, 0).r;
+    let brValue : f32 = textureLoad(texture, origin + br * scale, 0).r;
+
+    let lValue : f32 = (1-r.y) * tlValue + r.y * blValue;
+    let rValue : f32 = (1-r.y) * trValue + r.y * brValue;
+    return((1-r.x) * lValue + r.x * rValue);
+}
+
+//NOTE: region holds the YUV format, its flags and the image size. Each plane is filtered at its own resolution, then
+//      the samples are converted to RGB and decoded with the sRGB transfer function, so that the result is linear like
+//      samples of sRGB textures. The layout of the planes is described in oc_wgpu_yuv_plane_origin().
+fn sampleFromYuvTexture(texture : texture_2d<f32>, region : vec4f, uv : vec2f) -> vec4f
+{
+    let format = i32(region.x);
+    let flags = u32(region.y);
+    let size = vec2i(region.zw);
+    let chromaSize = (size + vec2i(1, 1)) / 2;
+
+    var yuv = vec3f(yuvPlaneSample(texture, vec2i(0, 0), size, 1, uv), 0, 0);
+    if(format == OC_WGPU_YUV_NV12)
+    {
+        yuv.y = yuvPlaneSample(texture, vec2i(0, size.y), chromaSize, 2, uv);
+        yuv.z = yuvPlaneSample(texture, vec2i(1, size.y), chromaSize, 2, uv);
+    }
+    else
+    {
+        yuv.y = yuvPlaneSample(texture, vec2i(0, size.y), chromaSize, 1, uv);
+        yuv.z = yuvPlaneSample(texture, vec2i(chromaSize.x, size.y), chromaSize, 1, uv);
+    }
+
+    yuv -= vec3f(0, 128./255., 128./255.);
+    if((flags & OC_WGPU_YUV_FLAG_FULL_RANGE) == 0)
+    {
+        //NOTE: limited range luma goes from 16 to 235, and chroma from 16 to 240
+        yuv = (yuv - vec3f(16./255., 0, 0)) * vec3f(255./219., 255./224., 255./224.);
+    }
+
+    var rgb : vec3f;
+    if((flags & OC_WGPU_YUV_FLAG_BT709) != 0)
+    {
+        rgb = vec3f(yuv.x + 1.5748 * yuv.z,
+                    yuv.x - 0.187324 * yuv.y - 0.468124 * yuv.z,
+                    yuv.x + 1.8556 * yuv.y);
+    }
+    else
+    {
+        rgb = vec3f(yuv.x + 1.402 * yuv.z,
+                    yuv.x - 0.344136 * yuv.y - 0.714136 * yuv.z,
+                    yuv.x + 1.772 * yuv.y);
+    }
+    rgb = clamp(rgb, vec3f(0, 0, 0), vec3f(1, 1, 1));
+    rgb = select(pow((rgb + 0.055) / 1.055, vec3f(2.4, 2.4, 2.4)), rgb / 12.92, rgb <= vec3f(0.04045, 0.04045, 0.04045));
+
+    return(vec4f(rgb, 1));
+}
+
+//NOTE: compute shaders can't use implicit derivatives, so we pick the mip level from the derivatives of the
+//      path's uv transform, and sample with an explicit level.
+fn sampleFromTexture(texture : texture_2d<f32>, region : vec4f, uv : vec2f, uvTransform : mat3x3f) -> vec4f
+{
+    var color : vec4f;
+    if(uv.x < 0 || uv.y < 0 || uv.x > 1 || uv.y > 1)
+    {
+        color = vec4f(0, 0, 0, 0);
+    }
+    else if(region.x > 0)
+    {
+        color = sampleFromYuvTexture(texture, region, uv);
+    }
+    else
+    {
+        let texSize = vec2f(textureDimensions(texture));
+        let dx = uvTransform[0].xy * texSize;
+        let dy = uvTransform[1].xy * texSize;
+        let lod = max(0., log2(max(length(dx), length(dy))));
 
+        color = textureSampleLevel(texture, srcSampler, uv, lod);
+    }
+    return(color);
+}
 
-//NOTE: you can't sample from textures in a compute shaders (wtf?), so... we do it ourselves
-fn sampleFromTexture(texture : texture_2d<f32>, uv : vec2f) -> vec4f
+//NOTE: images in the texture array have no mipmaps. We filter them by hand so that samples are clamped to the
+//      image's region of the array layer, since it is shared with other images
+fn sampleFromTextureArray(layer : i32, region : vec4f, uv : vec2f) -> vec4f
 {
     var color : vec4f;
     if(uv.x < 0 || uv.y < 0 || uv.x > 1 || uv.y > 1)
@@ -37,20 +159,24 @@ fn sampleFromTexture(texture : texture_2d<f32>, uv : vec2f) -> vec4f
     }
     else
     {
-        let p : vec2f = clamp(uv * vec2f(textureDimensions(texture)) - vec2f(0.5, 0.5),
+        let regionSize = region.zw - region.xy;
+        let p : vec2f = clamp(uv * regionSize - vec2f(0.5, 0.5),
                               vec2f(0, 0),
-                              vec2f(textureDimensions(texture)) - vec2f(1, 1));
+                              regionSize - vec2f(1, 1));
         let r = fract(p);
 
-        let tl = vec2i(p);
-        let bl = tl + vec2i(0, 1);
-        let tr = tl + vec2i(1, 0);
-        let br = tl + vec2i(1, 1);
+        let minCoord = vec2i(region.xy);
+        let maxCoord = vec2i(region.zw) - vec2i(1, 1);
 
-        let tlColor : vec4f = textureLoad(texture, tl, 0);
-        let blColor : vec4f = textureLoad(texture, bl, 0);
-        let trColor : vec4f = textureLoad(texture, tr, 0);
-        let brColor : vec4f = textureLoad(texture, br, 0);
+        let tl = minCoord + vec2i(p);
+        let br = min(tl + vec2i(1, 1), maxCoord);
+        let bl = vec2i(tl.x, br.y);
+        let tr = vec2i(br.x, tl.y);
+
+        let tlColor : vec4f = textureLoad(srcTextureArray, tl, layer, 0);
+        let blColor : vec4f = textureLoad(srcTextureArray, bl, layer, 0);
+        let trColor : vec4f = textureLoad(srcTextureArray, tr, layer, 0);
+        let brColor : vec4f = textureLoad(srcTextureArray, br, layer, 0);
 
         let lColor : vec4f = (1-r.y) * tlColor + r.y * blColor;
         let rColor : vec4f = (1-r.y) * trColor + r.y * brColor;
@@ -59,6 +185,118 @@ fn sampleFromTexture(texture : texture_2d<f32>, uv : vec2f) -> vec4f
     return(color);
 }
 
+fn tiledImageLevelSize(imageSize : vec2u, level : u32) -> vec2u
+{
+    let roundUp = (1u << level) - 1;
+    return((imageSize + vec2u(roundUp, roundUp)) >> vec2u(level, level));
+}
+
+//NOTE: returns the coordinates of a texel of a tiled image in srcTextureArray, and its layer, or -1 if its tile
+//      isn't resident. See oc_wgpu_tile_table for the layout of the tile table.
+fn tiledImageTexel(tableOffset : u32, level : u32, levelSize : vec2u, texel : vec2u) -> vec3i
+{
+    let tilesX = (levelSize.x + OC_WGPU_TILE_SIZE - 1) / OC_WGPU_TILE_SIZE;
+    let tile = texel / OC_WGPU_TILE_SIZE;
+    let entry = tileTable[tileTable[tableOffset + level] + tile.y * tilesX + tile.x];
+
+    var result = vec3i(0, 0, -1);
+    if(entry != 0)
+    {
+        let slot = entry - 1;
+        let slotsPerLayer = OC_WGPU_TILE_SLOTS_PER_ROW * OC_WGPU_TILE_SLOTS_PER_ROW;
+        let slotOrigin = vec2u(slot % OC_WGPU_TILE_SLOTS_PER_ROW, (slot % slotsPerLayer) / OC_WGPU_TILE_SLOTS_PER_ROW) * OC_WGPU_TILE_SIZE;
+        result = vec3i(vec2i(slotOrigin + texel % OC_WGPU_TILE_SIZE), i32(slot / slotsPerLayer));
+    }
+    return(result);
+}
+
+//NOTE: region holds the image's size, the start of its range in the tile table, and its level count. We pick the level
+//      like sampleFromTexture() does, then fall back to coarser levels until the tile of the sample is resident.
+//      Neighbour texels whose tile is missing are replaced by the first one.
+fn sampleFromTiledImage(region : vec4f, uv : vec2f, uvTransform : mat3x3f) -> vec4f
+{
+    var color = vec4f(0, 0, 0, 0);
+    if(uv.x >= 0 && uv.y >= 0 && uv.x <= 1 && uv.y <= 1)
+    {
+        let imageSize = vec2u(region.xy);
+        let tableOffset = u32(region.z);
+        let levelCount = u32(region.w);
+
+        let dx = uvTransform[0].xy * region.xy;
+        let dy = uvTransform[1].xy * region.xy;
+        let lod = max(0., log2(max(length(dx), length(dy))));
+
+        var level = min(u32(lod), levelCount - 1);
+        loop
+        {
+            let levelSize = tiledImageLevelSize(imageSize, level);
+            let p : vec2f = clamp(uv * vec2f(levelSize) - vec2f(0.5, 0.5),
+                                  vec2f(0, 0),
+                                  vec2f(levelSize) - vec2f(1, 1));
+
+            let tl = vec2u(p);
+            let tlTexel = tiledImageTexel(tableOffset, level, levelSize, tl);
+
+            if(tlTexel.z >= 0)
+            {
+                let r = fract(p);
+                let br = min(tl + vec2u(1, 1), levelSize - vec2u(1, 1));
+
+                var trTexel = tiledImageTexel(tableOffset, level, levelSize, vec2u(br.x, tl.y));
+                var blTexel = tiledImageTexel(tableOffset, level, levelSize, vec2u(tl.x, br.y));
+                var brTexel = tiledImageTexel(tableOffset, level, levelSize, br);
+                trTexel = select(trTexel, tlTexel, trTexel.z < 0);
+                blTexel = select(blTexel, tlTexel, blTexel.z < 0);
+                brTexel = select(brTexel, tlTexel, brTexel.z < 0);
+
+                let tlColor : vec4f = textureLoad(srcTextureArray, tlTexel.xy, tlTexel.z, 0);
+                let blColor : vec4f = textureLoad(srcTextureArray, blTexel.xy, blTexel.z, 0);
+                let trColor : vec4f = textureLoad(srcTextureArray, trTexel.xy, trTexel.z, 0);
+                let brColor : vec4f = textureLoad(srcTextureArray, brTexel.xy, brTexel.z, 0);
+
+                let lColor : vec4f = (1-r.y) * tlColor + r.y * blColor;
+                let rColor : vec4f = (1-r.y) * trColor + r.y * brColor;
+                color = (1-r.x) * lColor + r.x * rColor;
+                break;
+            }
+            if(level + 1 >= levelCount)
+            {
+                break;
+            }
+            level += 1;
+        }
+    }
+    return(color);
+}
+
+fn gradient_color(gradientIndex : i32, sampleCoord : vec2f) -> vec4f
+{
+    let gradient = &gradientBuffer[gradientIndex];
+    let p = vec3f(sampleCoord, 1);
+    let q = vec2f(dot((*gradient).rows[0].xyz, p), dot((*gradient).rows[1].xyz, p));
+    let t : f32 = select(q.x, length(q), (*gradient).kind == OC_GRADIENT_RADIAL);
+
+    //NOTE: stops are sorted by offset, so the last stop whose offset is below t starts the interval containing t.
+    //      Colors are already in the gradient's blend space.
+    var color : vec4f = (*gradient).colors[0];
+    for(var i : u32 = 1; i < (*gradient).stopCount; i++)
+    {
+        let o0 : f32 = (*gradient).offsets[(i - 1) / 4][(i - 1) % 4];
+        let o1 : f32 = (*gradient).offsets[i / 4][i % 4];
+        if(t > o0)
+        {
+            let f : f32 = select(1., clamp((t - o0) / (o1 - o0), 0, 1), o1 > o0);
+            color = mix((*gradient).colors[i - 1], (*gradient).colors[i], f);
+        }
+    }
+
+    if((*gradient).blendSpace == 1)
+    {
+        color = pow(color, vec4f(2.2, 2.2, 2.2, 1));
+    }
+    return(color);
+}
+
 const DEBUG_COLOR_QUEUE_EMPTY = vec4f(1, 0, 1, 1);
 const DEBUG_COLOR_QUEUE_NOT_EMPTY = vec4f(0, 1, 0, 1);
 const DEBUG_COLOR_FILL_OP = vec4f(1, 0, 0, 1);
@@ -67,7 +305,11 @@ fn get_next_color(pathIndex : u32, sampleCoord : vec2f) -> vec4f
 {
     var nextColor : vec4f;
 
-    if(pathBuffer[pathIndex].hasGradient == 0)
+    if(OC_WGPU_RASTER_GRADIENTS && pathBuffer[pathIndex].gradientIndex >= 0)
+    {
+        nextColor = gradient_color(pathBuffer[pathIndex].gradientIndex, sampleCoord);
+    }
+    else if(!OC_WGPU_RASTER_GRADIENTS || pathBuffer[pathIndex].hasGradient == 0)
     {
         nextColor = pathBuffer[pathIndex].colors[0];
     }
@@ -106,45 +348,58 @@ fn get_next_color(pathIndex : u32, sampleCoord : vec2f) -> vec4f
     nextColor = vec4f(nextColor.rgb * nextColor.a, nextColor.a);
 
     let textureID : i32 = pathBuffer[pathIndex].textureID;
-    if(  textureID >= 0
-      && debugDisplayOptions.textureOff == 0)
+    if(  OC_WGPU_RASTER_IMAGES
+      && textureID >= 0
+      && (!OC_WGPU_RASTER_DEBUG || debugDisplayOptions.textureOff == 0))
     {
         var texColor = vec4f(0, 0, 0, 0);
 
         let sampleCoord3 = vec3f(sampleCoord, 1);
         let uv : vec2f = (pathBuffer[pathIndex].uvTransform * sampleCoord3).xy;
 
-        if(textureID == 0)
+        if(textureID == OC_WGPU_TILED_TEXTURE_ID)
         {
-            texColor += sampleFromTexture(srcTexture0, uv);
+            texColor += sampleFromTiledImage(pathBuffer[pathIndex].textureRegion,
+                                             uv,
+                                             pathBuffer[pathIndex].uvTransform);
+        }
+        else if(textureID >= OC_WGPU_IMAGE_ARRAY_TEXTURE_ID)
+        {
+            texColor += sampleFromTextureArray(textureID - OC_WGPU_IMAGE_ARRAY_TEXTURE_ID,
+                                               pathBuffer[pathIndex].textureRegion,
+                                               uv);
+        }
+        else if(textureID == 0)
+        {
+            texColor += sampleFromTexture(srcTexture0, pathBuffer[pathIndex].textureRegion, uv, pathBuffer[pathIndex].uvTransform);
         }
         else if(textureID == 1)
         {
-            texColor += sampleFromTexture(srcTexture1, uv);
+            texColor += sampleFromTexture(srcTexture1, pathBuffer[pathIndex].textureRegion, uv, pathBuffer[pathIndex].uvTransform);
         }
         else if(textureID == 2)
         {
-            texColor += sampleFromTexture(srcTexture2, uv);
+            texColor += sampleFromTexture(srcTexture2, pathBuffer[pathIndex].textureRegion, uv, pathBuffer[pathIndex].uvTransform);
         }
         else if(textureID == 3)
         {
-            texColor += sampleFromTexture(srcTexture3, uv);
+            texColor += sampleFromTexture(srcTexture3, pathBuffer[pathIndex].textureRegion, uv, pathBuffer[pathIndex].uvTransform);
         }
         else if(textureID == 4)
         {
-            texColor += sampleFromTexture(srcTexture4, uv);
+            texColor += sampleFromTexture(srcTexture4, pathBuffer[pathIndex].textureRegion, uv, pathBuffer[pathIndex].uvTransform);
         }
         else if(textureID == 5)
         {
-            texColor += sampleFromTexture(srcTexture5, uv);
+            texColor += sampleFromTexture(srcTexture5, pathBuffer[pathIndex].textureRegion, uv, pathBuffer[pathIndex].uvTransform);
         }
         else if(textureID == 6)
         {
-            texColor += sampleFromTexture(srcTexture6, uv);
+            texColor += sampleFromTexture(srcTexture6, pathBuffer[pathIndex].textureRegion, uv, pathBuffer[pathIndex].uvTransform);
         }
         else if(textureID == 7)
         {
-            texColor += sampleFromTexture(srcTexture7, uv);
+            texColor += sampleFromTexture(srcTexture7, pathBuffer[pathIndex].textureRegion, uv, pathBuffer[pathIndex].uvTransform);
         }
 
         texColor = vec4f(texColor.rgb*texColor.a, texColor.a);
@@ -244,6 +499,231 @@ fn get_next_color(pathIndex : u32, sampleCoord : vec2f) -> vec4f
 }
 */
 
+//NOTE: winding increment of a segment at a sample point
+fn sample_winding_increment(seg : oc_segment, crossesRight : bool, samplePos : vec2f) -> i32
+{
+    var increment : i32 = 0;
+    if((samplePos.y > seg.box.y)
+       && (samplePos.y <= seg.box.w)
+       && (side_of_segment(samplePos.xy, seg) < 0))
+    {
+        increment += seg.windingIncrement;
+    }
+
+    if(crossesRight)
+    {
+        if((seg.config == OC_SEG_BR || seg.config == OC_SEG_TL)
+           && (samplePos.y > seg.box.w))
+        {
+            increment += seg.windingIncrement;
+        }
+        else if((seg.config == OC_SEG_BL || seg.config == OC_SEG_TR)
+                && (samplePos.y > seg.box.y))
+        {
+            increment -= seg.windingIncrement;
+        }
+    }
+    return(increment);
+}
+
+//------------------------------------------------------------------------------------------------
+// Analytic coverage
+//------------------------------------------------------------------------------------------------
+//NOTE: when msaaSampleCount is 0, winding numbers are integrated over the area of the pixel instead of being tested at
+//      sample points. Lines and quadratics contribute the exact area of the pixel on their left, which is computed
+//      from their x coordinate where they enter and leave the pixel's row. Cubics are approximated with the 8 samples
+//      of the MSAA offsets table. Fractional windings are then folded into a coverage, which is exact where a single
+//      edge crosses the pixel.
+
+fn ramp_antiderivative(u : f32) -> f32
+{
+    var result : f32 = 0;
+    if(u >= 1)
+    {
+        result = u - 0.5;
+    }
+    else if(u > 0)
+    {
+        result = 0.5 * u * u;
+    }
+    return(result);
+}
+
+//NOTE: integral over [0, 1] of clamp(u, 0, 1), for u going linearly from a to b
+fn ramp_integral(a : f32, b : f32) -> f32
+{
+    var result : f32;
+    if(abs(b - a) < 1e-4)
+    {
+        result = clamp(0.5 * (a + b), 0, 1);
+    }
+    else
+    {
+        result = (ramp_antiderivative(b) - ramp_antiderivative(a)) / (b - a);
+    }
+    return(result);
+}
+
+//NOTE: x coordinate of a line or quadratic segment at y. Segments are monotonic, so there's a single solution.
+fn segment_x_at(seg : oc_segment, y : f32) -> f32
+{
+    var p0 : vec2f;
+    var p2 : vec2f;
+    if(seg.config == OC_SEG_TL || seg.config == OC_SEG_BR)
+    {
+        p0 = seg.box.xy;
+        p2 = seg.box.zw;
+    }
+    else
+    {
+        p0 = seg.box.xw;
+        p2 = seg.box.zy;
+    }
+
+    var x : f32;
+    if(seg.kind == OC_SEG_QUADRATIC)
+    {
+        //NOTE: the hull vertex of a quadratic segment is its control point
+        let p1 = seg.hullVertex;
+        let a : f32 = p0.y - 2 * p1.y + p2.y;
+        let b : f32 = 2 * (p1.y - p0.y);
+        let c : f32 = p0.y - y;
+
+        var t : f32;
+        if(abs(a) < 1e-6)
+        {
+            t = select(0., -c / b, b != 0);
+        }
+        else
+        {
+            //NOTE: pick the root closest to [0, 1]
+            let d : f32 = sqrt(max(b * b - 4 * a * c, 0));
+            let t0 : f32 = (-b + d) / (2 * a);
+            let t1 : f32 = (-b - d) / (2 * a);
+            t = select(t1, t0, max(max(-t0, t0 - 1), 0) <= max(max(-t1, t1 - 1), 0));
+        }
+        t = clamp(t, 0, 1);
+        let s : f32 = 1 - t;
+        x = s * s * p0.x + 2 * s * t * p1.x + t * t * p2.x;
+    }
+    else
+    {
+        let h : f32 = p2.y - p0.y;
+        x = select(p0.x + (y - p0.y) * (p2.x - p0.x) / h, p0.x, h == 0);
+    }
+    return(x);
+}
+
+//NOTE: integral of a segment's winding increment over a pixel
+fn segment_area_winding(seg : oc_segment, crossesRight : bool, pixelBox : vec4f) -> f32
+{
+    var area : f32 = 0;
+
+    if(seg.kind == OC_SEG_CUBIC)
+    {
+        let center = 0.5 * (pixelBox.xy + pixelBox.zw);
+        var increment : i32 = 0;
+        for(var sampleIndex : u32 = 0; sampleIndex < OC_WGPU_MAX_SAMPLE_COUNT; sampleIndex++)
+        {
+            increment += sample_winding_increment(seg, crossesRight, center + msaaOffsets[sampleIndex]);
+        }
+        area = f32(increment) / f32(OC_WGPU_MAX_SAMPLE_COUNT);
+    }
+    else
+    {
+        //NOTE: the part of the pixel's row on the left of the segment, within the segment's vertical extent
+        let y0 : f32 = max(pixelBox.y, seg.box.y);
+        let y1 : f32 = min(pixelBox.w, seg.box.w);
+        if(y1 > y0)
+        {
+            let xa : f32 = segment_x_at(seg, y0) - pixelBox.x;
+            let xb : f32 = segment_x_at(seg, y1) - pixelBox.x;
+            area = (y1 - y0) * ramp_integral(xa, xb);
+        }
+
+        //NOTE: corrections for segments crossing the tile's right boundary only depend on y
+        if(crossesRight)
+        {
+            if(seg.config == OC_SEG_BR || seg.config == OC_SEG_TL)
+            {
+                area += clamp(pixelBox.w - max(pixelBox.y, seg.box.w), 0, 1);
+            }
+            else
+            {
+                area -= clamp(pixelBox.w - max(pixelBox.y, seg.box.y), 0, 1);
+            }
+        }
+        area *= f32(seg.windingIncrement);
+    }
+    return(area);
+}
+
+//NOTE: area of the intersection of two boxes, one of which is a pixel
+fn box_pixel_overlap(box : vec4f, pixelBox : vec4f) -> f32
+{
+    let size = clamp(min(box.zw, pixelBox.zw) - max(box.xy, pixelBox.xy), vec2f(0, 0), vec2f(1, 1));
+    return(size.x * size.y);
+}
+
+fn rect_area_coverage(box : vec4f, radius : f32, pixelBox : vec4f) -> f32
+{
+    var coverage = box_pixel_overlap(box, pixelBox);
+    if(radius > 0)
+    {
+        //NOTE: in the corners, fade over one pixel across the corner's circle
+        let p = 0.5 * (pixelBox.xy + pixelBox.zw);
+        let center = 0.5 * (box.xy + box.zw);
+        let corner = abs(p - center) - (0.5 * (box.zw - box.xy) - vec2f(radius, radius));
+        if(corner.x > 0 && corner.y > 0)
+        {
+            coverage *= clamp(radius + 0.5 - length(corner), 0, 1);
+        }
+    }
+    return(coverage);
+}
+
+fn even_odd_coverage(winding : f32) -> f32
+{
+    return(min(abs(winding - 2 * round(0.5 * winding)), 1));
+}
+
+fn non_zero_coverage(winding : f32) -> f32
+{
+    return(min(abs(winding), 1));
+}
+
+//NOTE: the ramp and palette must match the ones of oc_wgpu_canvas_heatmap_color(), which draws the legends
+fn heatmap_color(count : u32) -> vec4f
+{
+    var color : vec4f;
+    if(debugDisplayOptions.heatmap == OC_HEATMAP_BATCHES)
+    {
+        var palette = array<vec3f, OC_HEATMAP_BATCH_COLOR_COUNT>(
+            vec3f(1, 0, 0),
+            vec3f(0, 1, 0),
+            vec3f(0, 0, 1),
+            vec3f(1, 1, 0),
+            vec3f(0, 1, 1),
+            vec3f(1, 0, 1)
+        );
+        color = vec4f(palette[count % OC_HEATMAP_BATCH_COLOR_COUNT], 1);
+    }
+    else
+    {
+        var ramp = array<vec3f, 5>(
+            vec3f(0, 0, 1),
+            vec3f(0, 1, 1),
+            vec3f(0, 1, 0),
+            vec3f(1, 1, 0),
+            vec3f(1, 0, 0)
+        );
+        let t = clamp(log2(1 + f32(count)) / log2(1 + f32(max(debugDisplayOptions.heatmapScale, 1))), 0, 1) * 4;
+        let index = min(u32(t), 3);
+        color = vec4f(mix(ramp[index], ramp[index + 1], t - f32(index)), 1);
+    }
+    return(color);
+}
+
 @compute @workgroup_size(16, 16) fn raster(@builtin(num_workgroups) workGroupCount : vec3u,
                                            @builtin(workgroup_id) workGroupID : vec3u,
                                            @builtin(local_invocation_id) localID : vec3u)
@@ -252,9 +732,10 @@ fn get_next_color(pathIndex : u32, sampleCoord : vec2f) -> vec4f
     let tileQueue = &tileQueues[tileQueueIndex];
     let pixCoord = vec2i((*tileQueue).tileCoord * tileSize + localID.xy);
     let centerCoord = vec2f(pixCoord) + vec2f(0.5, 0.5);
+    let sampleCount : u32 = select(msaaSampleCount, u32(OC_WGPU_RASTER_SAMPLE_COUNT), OC_WGPU_RASTER_SAMPLE_COUNT >= 0);
 
     var sampleCoords : array<vec2f, OC_WGPU_MAX_SAMPLE_COUNT>;
-    for(var sampleIndex : u32 = 0; sampleIndex < msaaSampleCount; sampleIndex++)
+    for(var sampleIndex : u32 = 0; sampleIndex < sampleCount; sampleIndex++)
     {
         sampleCoords[sampleIndex] = centerCoord + msaaOffsets[sampleIndex];
     }
@@ -273,6 +754,22 @@ fn get_next_color(pathIndex : u32, sampleCoord : vec2f) -> vec4f
         0, 0, 0, 0, 0, 0, 0, 0
     );
 
+    let analytic : bool = (sampleCount == 0);
+    let pixelBox = vec4f(vec2f(pixCoord), vec2f(pixCoord) + vec2f(1, 1));
+    var areaWinding : f32 = 0;
+
+    //NOTE: paths drawn between a clip path and its marker are composited in a separate layer, which is masked by the
+    //      clip path's coverage. Since ops are sorted front to back, the layer starts at the marker's clip begin op,
+    //      and ends at the clip path's end op. clipStack holds the colors accumulated in front of each open layer.
+    var clipStack : array<vec4f, OC_CLIP_PATH_MAX_DEPTH>;
+    var clipDepth : i32 = 0;
+
+    //NOTE: counts of the heatmap debug display
+    let heatmapEmpty : bool = (opIndex < 0);
+    var opCount : u32 = 0;
+    var segmentCount : u32 = 0;
+    var overdrawCount : u32 = 0;
+
     /*
     if(debugDisplayOptions.debugTileQueues != 0)
     {
@@ -290,52 +787,100 @@ fn get_next_color(pathIndex : u32, sampleCoord : vec2f) -> vec4f
     while(opIndex >= 0)
     {
         var op : oc_tile_op = tileOpBuffer[opIndex];
+        let opKind : i32 = tile_op_kind(op);
+        opCount++;
 
-        if(op.kind == OC_OP_START)
+        if(opKind == OC_OP_START)
         {
-            for(var sampleIndex : u32 = 0; sampleIndex < msaaSampleCount; sampleIndex++)
+            areaWinding = f32(tile_op_winding(op));
+            for(var sampleIndex : u32 = 0; sampleIndex < sampleCount; sampleIndex++)
             {
-                winding[sampleIndex] = op.windingOffsetOrCrossRight;
+                winding[sampleIndex] = tile_op_winding(op);
             }
         }
-        else if(op.kind == OC_OP_SEGMENT)
+        else if(opKind == OC_OP_SEGMENT)
         {
-            var seg : oc_segment = segmentBuffer[op.index];
+            var seg : oc_segment = segmentBuffer[tile_op_index(op)];
+            segmentCount++;
 
-            for(var sampleIndex : u32 = 0; sampleIndex < msaaSampleCount; sampleIndex++)
+            if(analytic)
             {
-                let samplePos : vec2f = sampleCoords[sampleIndex];
+                areaWinding += segment_area_winding(seg, tile_op_crosses_right(op), pixelBox);
+            }
 
-                if((samplePos.y > seg.box.y)
-                   && (samplePos.y <= seg.box.w)
-                   && (side_of_segment(samplePos.xy, seg) < 0))
-                {
-                    winding[sampleIndex] += seg.windingIncrement;
-                }
+            for(var sampleIndex : u32 = 0; sampleIndex < sampleCount; sampleIndex++)
+            {
+                winding[sampleIndex] += sample_winding_increment(seg, tile_op_crosses_right(op), sampleCoords[sampleIndex]);
+            }
+        }
+        else if(opKind == OC_OP_CLIP_BEGIN)
+        {
+            if(clipDepth < OC_CLIP_PATH_MAX_DEPTH)
+            {
+                clipStack[clipDepth] = color;
+                color = vec4f(0, 0, 0, 0);
+            }
+            clipDepth++;
+        }
+        else if(opKind == OC_OP_END && pathBuffer[tile_op_index(op)].cmd == OC_CMD_CLIP_PATH)
+        {
+            let pathIndex : u32 = tile_op_index(op);
+            let clip : vec4f = pathBuffer[pathIndex].clip;
+            var coverage : f32 = 0;
 
-                if(op.windingOffsetOrCrossRight != 0)
+            if(analytic)
+            {
+                coverage = even_odd_coverage(areaWinding) * box_pixel_overlap(clip, pixelBox);
+            }
+            else
+            {
+                for(var sampleIndex : u32 = 0; sampleIndex < sampleCount; sampleIndex++)
                 {
-                    if((seg.config == OC_SEG_BR || seg.config == OC_SEG_TL)
-                       && (samplePos.y > seg.box.w))
-                    {
-                        winding[sampleIndex] += seg.windingIncrement;
-                    }
-                    else if((seg.config == OC_SEG_BL || seg.config == OC_SEG_TR)
-                            && (samplePos.y > seg.box.y))
+                    let sampleCoord : vec2f = sampleCoords[sampleIndex];
+
+                    if(sampleCoord.x >= clip.x
+                      && sampleCoord.x < clip.z
+                      && sampleCoord.y >= clip.y
+                      && sampleCoord.y < clip.w
+                      && (winding[sampleIndex] & 1) != 0)
                     {
-                        winding[sampleIndex] -= seg.windingIncrement;
+                        coverage += 1;
                     }
                 }
+                coverage /= f32(sampleCount);
+            }
+
+            //NOTE: a clip path whose marker landed in another batch has no layer to close, it is ignored
+            if(clipDepth > 0)
+            {
+                clipDepth--;
+                if(clipDepth < OC_CLIP_PATH_MAX_DEPTH)
+                {
+                    let front = clipStack[clipDepth];
+                    color = coverage * color * (1 - front.a) + front;
+                }
+            }
+
+            if(color.a >= OC_OPAQUE_ALPHA && clipDepth == 0)
+            {
+                break;
             }
         }
         else
         {
-            let pathIndex : u32 = op.index;
+            let pathIndex : u32 = tile_op_index(op);
             let nextColor : vec4f = get_next_color(pathIndex, centerCoord);
 
-            if(op.kind == OC_OP_FILL)
+            if(opKind == OC_OP_FILL)
             {
                 color = nextColor * (1 - color.a) + color;
+                overdrawCount++;
+
+                if(color.a >= OC_OPAQUE_ALPHA && clipDepth == 0)
+                {
+                    //NOTE: ops are sorted front to back, so layers beneath can't show through anymore
+                    break;
+                }
 
                 // if(debugDisplayOptions.debugTileQueues != 0)
                 // {
@@ -347,33 +892,56 @@ fn get_next_color(pathIndex : u32, sampleCoord : vec2f) -> vec4f
                 let clip : vec4f = pathBuffer[pathIndex].clip;
                 var coverage : f32 = 0;
 
-                for(var sampleIndex : u32 = 0; sampleIndex < msaaSampleCount; sampleIndex++)
+                if(analytic)
                 {
-                    let sampleCoord : vec2f = sampleCoords[sampleIndex];
-
-                    //TODO: do that test when computing winding number?
-                    if(sampleCoord.x >= clip.x
-                      && sampleCoord.x < clip.z
-                      && sampleCoord.y >= clip.y
-                      && sampleCoord.y < clip.w)
+                    var shapeCoverage : f32 = 1;
+                    if(opKind == OC_OP_RECT)
+                    {
+                        shapeCoverage = rect_area_coverage(pathBuffer[pathIndex].box, pathBuffer[pathIndex].radius, pixelBox);
+                    }
+                    else if(opKind == OC_OP_END)
                     {
-                        var filled : bool = (op.kind == OC_OP_CLIP_FILL)
-                                          || (pathBuffer[pathIndex].cmd == OC_CMD_FILL
-                                              && ((winding[sampleIndex] & 1) != 0))
-                                          || (pathBuffer[pathIndex].cmd == OC_CMD_STROKE
-                                              && (winding[sampleIndex] != 0));
-                        if(filled)
+                        shapeCoverage = select(even_odd_coverage(areaWinding),
+                                               non_zero_coverage(areaWinding),
+                                               pathBuffer[pathIndex].cmd == OC_CMD_STROKE);
+                    }
+                    coverage = shapeCoverage * box_pixel_overlap(clip, pixelBox);
+                }
+                else
+                {
+                    for(var sampleIndex : u32 = 0; sampleIndex < sampleCount; sampleIndex++)
+                    {
+                        let sampleCoord : vec2f = sampleCoords[sampleIndex];
+
+                        //TODO: do that test when computing winding number?
+                        if(sampleCoord.x >= clip.x
+                          && sampleCoord.x < clip.z
+                          && sampleCoord.y >= clip.y
+                          && sampleCoord.y < clip.w)
                         {
-                            coverage += 1;
+                            var filled : bool = (opKind == OC_OP_CLIP_FILL)
+                                              || (opKind == OC_OP_RECT
+                                                  && rect_contains(pathBuffer[pathIndex].box,
+                                                                   pathBuffer[pathIndex].radius,
+                                                                   sampleCoord))
+                                              || (pathBuffer[pathIndex].cmd == OC_CMD_FILL
+                                                  && ((winding[sampleIndex] & 1) != 0))
+                                              || (pathBuffer[pathIndex].cmd == OC_CMD_STROKE
+                                                  && (winding[sampleIndex] != 0));
+                            if(filled)
+                            {
+                                coverage += 1;
+                            }
                         }
                     }
+                    coverage /= f32(sampleCount);
                 }
                 if(coverage != 0)
                 {
-                    coverage /= f32(msaaSampleCount);
                     color = coverage*nextColor * (1 - color.a) + color;
+                    overdrawCount++;
 
-                    if(coverage == 1 && nextColor.a == 1)
+                    if(color.a >= OC_OPAQUE_ALPHA && clipDepth == 0)
                     {
                         break;
                     }
@@ -383,7 +951,7 @@ fn get_next_color(pathIndex : u32, sampleCoord : vec2f) -> vec4f
                 // {
                 //     var coverage : f32 = 0;
 
-                //     for(var sampleIndex : u32 = 0; sampleIndex < msaaSampleCount; sampleIndex++)
+                //     for(var sampleIndex : u32 = 0; sampleIndex < sampleCount; sampleIndex++)
                 //     {
                 //         let sampleCoord : vec2f = sampleCoords[sampleIndex];
 
@@ -401,7 +969,7 @@ fn get_next_color(pathIndex : u32, sampleCoord : vec2f) -> vec4f
                 //             }
                 //         }
                 //     }
-                //     coverage /= f32(msaaSampleCount);
+                //     coverage /= f32(sampleCount);
                 //     color = coverage * vec4f(1,0,1,1) + (1 - coverage) * color;
                 // }
             }
@@ -409,11 +977,42 @@ fn get_next_color(pathIndex : u32, sampleCoord : vec2f) -> vec4f
         opIndex = op.next;
     }
 
+    //NOTE: layers whose clip path landed in another batch are composited unmasked, and are only clipped by the clip
+    //      path's bounding box
+    while(clipDepth > 0)
+    {
+        clipDepth--;
+        if(clipDepth < OC_CLIP_PATH_MAX_DEPTH)
+        {
+            let front = clipStack[clipDepth];
+            color = color * (1 - front.a) + front;
+        }
+    }
+
     // if(  debugDisplayOptions.showTileBorders != 0
     //   && (pixCoord.x % i32(tileSize) == 0 || pixCoord.y % i32(tileSize) == 0))
     // {
     //     color = 0.5 * color + vec4f(0, 0, 0, 0.5);
     // }
 
+    //NOTE: heatmaps are blended over the batch's output. Tiles a batch doesn't touch aren't rastered by it, so with
+    //      several batches, each pixel shows the counts of the last batch that touched its tile.
+    if(OC_WGPU_RASTER_DEBUG && debugDisplayOptions.heatmap != OC_HEATMAP_NONE)
+    {
+        var count : u32 = 0;
+        switch(debugDisplayOptions.heatmap)
+        {
+            case OC_HEATMAP_TILE_OPS: { count = opCount; }
+            case OC_HEATMAP_SEGMENTS: { count = segmentCount; }
+            case OC_HEATMAP_OVERDRAW: { count = overdrawCount; }
+            default: { count = debugDisplayOptions.batchIndex; }
+        }
+
+        if(debugDisplayOptions.heatmap != OC_HEATMAP_BATCHES || !heatmapEmpty)
+        {
+            color = mix(color, heatmap_color(count), 0.75);
+        }
+    }
+
     textureStore(outTexture, pixCoord, color);
 }
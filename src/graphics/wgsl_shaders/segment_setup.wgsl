@@ -187,9 +187,7 @@ fn bin_to_tiles(segIndex : u32)
 
                 if(tileOpIndex < arrayLength(&tileOpBuffer))
                 {
-                    tileOpBuffer[tileOpIndex].kind = OC_OP_SEGMENT;
-                    tileOpBuffer[tileOpIndex].index = segIndex;
-                    tileOpBuffer[tileOpIndex].windingOffsetOrCrossRight = 0;
+                    tileOpBuffer[tileOpIndex].data = tile_op_pack(OC_OP_SEGMENT, segIndex);
                     tileOpBuffer[tileOpIndex].next = -1;
 
                     let binQueueIndex = i32(pathBin.binQueues) + y * pathArea.z + x;
@@ -209,7 +207,7 @@ fn bin_to_tiles(segIndex : u32)
                     //NOTE: if the segment crosses the right boundary, mark it.
                     if(crossR)
                     {
-                        tileOpBuffer[tileOpIndex].windingOffsetOrCrossRight = 1;
+                        tileOpBuffer[tileOpIndex].data |= OC_OP_CROSS_RIGHT_BIT;
                     }
                 }
             }
@@ -956,5 +954,20 @@ fn cubic_setup(p : array<vec2f, 4>, pathIndex : i32)
         {
             cubic_setup(p, (*elt).pathIndex);
         }
+
+        case OC_SEG_STROKE_LINE:
+        {
+            stroke_line_setup(p, (*elt).pathIndex);
+        }
+
+        case OC_SEG_STROKE_JOINT:
+        {
+            stroke_joint_setup(p, (*elt).pathIndex);
+        }
+
+        case OC_SEG_STROKE_CAP:
+        {
+            stroke_cap_setup(p, (*elt).pathIndex);
+        }
     }
 }
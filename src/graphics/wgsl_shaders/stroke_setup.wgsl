@@ -0,0 +1,88 @@
+
+//------------------------------------------------------------------------------------------------
+// Stroke setup
+//------------------------------------------------------------------------------------------------
+//NOTE: this file is appended to segment_setup.wgsl. Stroke elements are in screen space, and are
+//      expanded into the closed outlines the CPU encoder would produce, which are then passed to line_setup.
+//
+//      - stroke line:  p[0], p[1] are the endpoints, p[2].x is the half width
+//      - stroke joint: p[0] is the joint point, p[1], p[2] are the incoming and outgoing tangents,
+//                      p[3].x is the half width and p[3].y the max miter excursion (negative for a bevel)
+//      - stroke cap:   p[0] is the cap point, p[1] is the direction, p[2].x is the half width
+
+fn stroke_push_line(a : vec2f, b : vec2f, pathIndex : i32)
+{
+    line_setup(array<vec2f, 4>(a, b, vec2f(0, 0), vec2f(0, 0)), pathIndex);
+}
+
+fn stroke_line_setup(p : array<vec2f, 4>, pathIndex : i32)
+{
+    let halfWidth = p[2].x;
+    let v = p[1] - p[0];
+    let n = vec2f(v.y, -v.x);
+    let offset = n * (halfWidth / length(n));
+
+    stroke_push_line(p[1] - offset, p[0] - offset, pathIndex);
+    stroke_push_line(p[0] + offset, p[1] + offset, pathIndex);
+    stroke_push_line(p[0] - offset, p[0] + offset, pathIndex);
+    stroke_push_line(p[1] + offset, p[1] - offset, pathIndex);
+}
+
+fn stroke_joint_setup(p : array<vec2f, 4>, pathIndex : i32)
+{
+    let p0 = p[0];
+    let halfWidth = p[3].x;
+    let width = 2 * halfWidth;
+    let maxJointExcursion = p[3].y;
+
+    var n0 = normalize(vec2f(-p[1].y, p[1].x));
+    var n1 = normalize(vec2f(-p[2].y, p[2].x));
+
+    //NOTE: flip the normals so that they face outwards the angle
+    if(n0.x * n1.y - n0.y * n1.x > 0)
+    {
+        n0 = -n0;
+        n1 = -n1;
+    }
+
+    //NOTE: let u = n0 + n1 and v = pIntersect - p0, then v = u * (width / norm(u)^2)
+    let u = n0 + n1;
+    let uNormSquare = dot(u, u);
+    let alpha = width / uNormSquare;
+    let v = u * alpha;
+    let excursionSquare = uNormSquare * squaref(alpha - width / 4);
+
+    let a = p0 + n0 * halfWidth;
+    let b = p0 + n1 * halfWidth;
+
+    if(maxJointExcursion >= 0 && excursionSquare <= squaref(maxJointExcursion))
+    {
+        //NOTE: miter joint
+        stroke_push_line(p0, a, pathIndex);
+        stroke_push_line(a, p0 + v, pathIndex);
+        stroke_push_line(p0 + v, b, pathIndex);
+        stroke_push_line(b, p0, pathIndex);
+    }
+    else
+    {
+        //NOTE: bevel joint
+        stroke_push_line(p0, a, pathIndex);
+        stroke_push_line(a, b, pathIndex);
+        stroke_push_line(b, p0, pathIndex);
+    }
+}
+
+fn stroke_cap_setup(p : array<vec2f, 4>, pathIndex : i32)
+{
+    let p0 = p[0];
+    let direction = p[1];
+    let alpha = p[2].x / length(direction);
+
+    let n0 = vec2f(-alpha * direction.y, alpha * direction.x);
+    let m0 = alpha * direction;
+
+    stroke_push_line(p0 + n0, p0 + n0 + m0, pathIndex);
+    stroke_push_line(p0 + n0 + m0, p0 - n0 + m0, pathIndex);
+    stroke_push_line(p0 - n0 + m0, p0 - n0, pathIndex);
+    stroke_push_line(p0 - n0, p0 + n0, pathIndex);
+}
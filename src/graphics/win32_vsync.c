@@ -13,6 +13,7 @@
 #define interface struct
 #include <d3d11_1.h>
 #include <dxgi1_6.h>
+#include <dwmapi.h>
 #undef interface
 
 typedef struct oc_vsync_data
@@ -155,3 +156,25 @@ void oc_vsync_wait(oc_window window)
         }
     }
 }
+
+//NOTE: DWM composes all displays at the rate of the primary one, and presents at its vblanks, so the timing doesn't
+//      depend on the window.
+oc_vsync_timing oc_vsync_get_timing(oc_window window)
+{
+    oc_vsync_timing timing = { 0 };
+
+    DWM_TIMING_INFO info = { .cbSize = sizeof(DWM_TIMING_INFO) };
+    if(SUCCEEDED(DwmGetCompositionTimingInfo(NULL, &info)) && info.qpcRefreshPeriod)
+    {
+        //NOTE: DWM times are performance counter values, which we convert relative to the current time
+        LARGE_INTEGER frequency;
+        LARGE_INTEGER counter;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&counter);
+        f64 now = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+        timing.vblankTime = now - (f64)((i64)counter.QuadPart - (i64)info.qpcVBlank) / frequency.QuadPart;
+        timing.refreshPeriod = (f64)info.qpcRefreshPeriod / frequency.QuadPart;
+    }
+    return (timing);
+}
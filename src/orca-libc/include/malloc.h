@@ -0,0 +1,84 @@
+#ifndef _MALLOC_H
+#define _MALLOC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define __NEED_size_t
+#define __NEED_uint32_t
+#define __NEED_uint64_t
+#include <bits/alltypes.h>
+
+void* malloc(size_t);
+void* calloc(size_t, size_t);
+void* realloc(void*, size_t);
+void free(void*);
+void* memalign(size_t, size_t);
+size_t malloc_usable_size(void*);
+
+/* Small allocations can be served by per-size-class slabs when orca-libc is built
+   with ORCA_MALLOC_SLABS. Sizes up to ORCA_MALLOC_SLAB_MAX_SIZE are rounded up to a
+   multiple of ORCA_MALLOC_SLAB_GRANULE, larger ones go to dlmalloc. */
+#define ORCA_MALLOC_SLAB_GRANULE 16
+#define ORCA_MALLOC_SLAB_MAX_SIZE 256
+#define ORCA_MALLOC_SLAB_CLASS_COUNT (ORCA_MALLOC_SLAB_MAX_SIZE / ORCA_MALLOC_SLAB_GRANULE)
+
+struct orca_malloc_stats
+{
+    int slabs_enabled;
+
+    size_t small_allocs;   /* allocations served by a slab */
+    size_t small_frees;
+    size_t small_reuses;   /* small allocations taken from a free list rather than bumped */
+    size_t large_allocs;   /* allocations forwarded to dlmalloc */
+    size_t large_frees;
+    size_t reallocs;
+    size_t slab_pages;     /* pages carved out of dlmalloc for slabs */
+
+    size_t class_allocs[ORCA_MALLOC_SLAB_CLASS_COUNT];
+    size_t class_frees[ORCA_MALLOC_SLAB_CLASS_COUNT];
+};
+
+/* Fills stats with the counters accumulated since startup. All counters are zero
+   when the slab front-end is not compiled in. */
+void orca_malloc_get_stats(struct orca_malloc_stats* stats);
+
+/* When orca-libc is built with ORCA_MALLOC_TRACKING, each allocation is charged to the
+   innermost tag pushed with orca_malloc_push_tag(), or to "untagged". Tags are compared
+   by content and must outlive the program, e.g. string literals. The site table is
+   shared with the host, which shows live and peak usage per tag in the debug overlay
+   and can dump it to a file. Without tracking, the tag functions do nothing and
+   orca_malloc_get_tracking() returns 0. */
+#define ORCA_MALLOC_MAX_SITES 256
+
+struct orca_malloc_site
+{
+    const char* tag;
+    uint32_t tag_len;
+    uint64_t alloc_count;
+    uint64_t free_count;
+    uint64_t total_bytes;
+    uint32_t live_bytes;
+    uint32_t peak_bytes;
+};
+
+struct orca_malloc_tracking
+{
+    uint32_t site_count;
+    uint32_t site_cap;
+    uint32_t live_bytes;
+    uint32_t peak_bytes;
+    uint64_t total_bytes;
+    struct orca_malloc_site sites[ORCA_MALLOC_MAX_SITES];
+};
+
+void orca_malloc_push_tag(const char* tag);
+void orca_malloc_pop_tag(void);
+const struct orca_malloc_tracking* orca_malloc_get_tracking(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
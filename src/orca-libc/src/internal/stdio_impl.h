@@ -80,6 +80,8 @@ hidden size_t __file_write_err_shim(FILE* stream, const unsigned char* buffer, s
 hidden off_t __file_seek_err_shim(FILE* stream, off_t offset, int origin);
 hidden int __file_close_err_shim(FILE* stream);
 
+hidden size_t __stdio_log_write(FILE* stream, const unsigned char* buffer, size_t size);
+
 hidden int __toread(FILE*);
 hidden int __towrite(FILE*);
 
@@ -14,10 +14,33 @@
 #define LACKS_UNISTD_H
 #define LACKS_SYS_PARAM_H
 
+#if defined(ORCA_MALLOC_SLABS) || defined(ORCA_MALLOC_TRACKING)
+    /* The slab front-end and tracking layer in orca_malloc.c provide the public
+       entry points and call into the dl-prefixed functions. */
+    #define USE_DL_PREFIX
+#endif
+
 __attribute__((import_name("oc_mem_grow")))
 void* oc_mem_grow(uint64_t size);
 
-#define MORECORE oc_mem_grow
+__attribute__((import_name("oc_mem_decommit")))
+void oc_mem_decommit(void* ptr, uint64_t size);
+
+static void* orca_morecore(intptr_t size)
+{
+    if(size < 0)
+    {
+        /* Wasm memory can't shrink, so trimming gives the pages back to the host
+           instead. The break doesn't move, so dlmalloc keeps the range in its top
+           chunk and can reuse it as is. */
+        char* end = (char*)oc_mem_grow(0);
+        oc_mem_decommit(end + size, (uint64_t)-size);
+        return end;
+    }
+    return oc_mem_grow((uint64_t)size);
+}
+
+#define MORECORE orca_morecore
 #define MORECORE_CONTIGUOUS 0
 /*
   This is a version (aka dlmalloc) of malloc/free/realloc written by
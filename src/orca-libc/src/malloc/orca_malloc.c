@@ -0,0 +1,612 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <malloc.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(ORCA_MALLOC_SLABS) || defined(ORCA_MALLOC_TRACKING)
+
+/* When either option is enabled, dlmalloc is built with USE_DL_PREFIX and this file
+   provides the public entry points. The orca_heap_xxx functions are the underlying
+   heap, which is the slab front-end or dlmalloc itself, and the tracking layer, if
+   any, sits on top of them. */
+
+void* dlmalloc(size_t);
+void* dlcalloc(size_t, size_t);
+void* dlrealloc(void*, size_t);
+void dlfree(void*);
+void* dlmemalign(size_t, size_t);
+void* dlvalloc(size_t);
+void* dlpvalloc(size_t);
+size_t dlmalloc_usable_size(void*);
+int dlmalloc_trim(size_t);
+
+#endif
+
+#ifdef ORCA_MALLOC_SLABS
+
+/* Slab front-end for small allocations.
+
+   Each size class owns a list of free blocks and a bump range in its current slab
+   page. Pages are ORCA_SLAB_PAGE_SIZE bytes, aligned on their size and allocated
+   from dlmalloc. A bitmap with one bit per page of the 32-bit address space tells
+   whether a pointer comes from a slab, and the page header holds its size class,
+   so that free() doesn't need any per-block header.
+
+   Slab pages are never given back to dlmalloc: freed blocks stay on the free list
+   of their class and are reused by later allocations of the same class. */
+
+enum
+{
+    ORCA_SLAB_PAGE_SHIFT = 16,
+    ORCA_SLAB_PAGE_SIZE = 1 << ORCA_SLAB_PAGE_SHIFT,
+    ORCA_SLAB_PAGE_COUNT = 1 << (32 - ORCA_SLAB_PAGE_SHIFT),
+    ORCA_SLAB_HEADER_SIZE = ORCA_MALLOC_SLAB_GRANULE,
+};
+
+_Static_assert(sizeof(void*) == 4, "the slab page bitmap covers a 32-bit address space");
+
+typedef struct orca_slab_block
+{
+    struct orca_slab_block* next;
+} orca_slab_block;
+
+typedef struct orca_slab_header
+{
+    uint32_t classIndex;
+} orca_slab_header;
+
+typedef struct orca_slab_class
+{
+    orca_slab_block* freeList;
+    char* bump;
+    char* end;
+} orca_slab_class;
+
+static orca_slab_class orca_slabClasses[ORCA_MALLOC_SLAB_CLASS_COUNT];
+static uint32_t orca_slabPageBits[ORCA_SLAB_PAGE_COUNT / 32];
+static struct orca_malloc_stats orca_mallocStats = { .slabs_enabled = 1 };
+
+static inline size_t orca_slab_class_size(uint32_t classIndex)
+{
+    return ((size_t)(classIndex + 1) * ORCA_MALLOC_SLAB_GRANULE);
+}
+
+static inline int orca_slab_owns(void* ptr)
+{
+    uint32_t page = (uint32_t)(uintptr_t)ptr >> ORCA_SLAB_PAGE_SHIFT;
+    return ((orca_slabPageBits[page >> 5] >> (page & 31)) & 1);
+}
+
+static inline uint32_t orca_slab_class_of(void* ptr)
+{
+    orca_slab_header* header = (orca_slab_header*)((uintptr_t)ptr & ~(uintptr_t)(ORCA_SLAB_PAGE_SIZE - 1));
+    return (header->classIndex);
+}
+
+static void* orca_slab_refill(uint32_t classIndex)
+{
+    char* page = dlmemalign(ORCA_SLAB_PAGE_SIZE, ORCA_SLAB_PAGE_SIZE);
+    if(!page)
+    {
+        return (0);
+    }
+    orca_mallocStats.slab_pages++;
+
+    ((orca_slab_header*)page)->classIndex = classIndex;
+
+    uint32_t pageIndex = (uint32_t)(uintptr_t)page >> ORCA_SLAB_PAGE_SHIFT;
+    orca_slabPageBits[pageIndex >> 5] |= 1u << (pageIndex & 31);
+
+    size_t size = orca_slab_class_size(classIndex);
+    orca_slab_class* slabClass = &orca_slabClasses[classIndex];
+    slabClass->bump = page + ORCA_SLAB_HEADER_SIZE + size;
+    slabClass->end = page + ORCA_SLAB_PAGE_SIZE;
+
+    return (page + ORCA_SLAB_HEADER_SIZE);
+}
+
+static inline void* orca_slab_alloc(size_t size)
+{
+    uint32_t classIndex = size ? (uint32_t)((size - 1) / ORCA_MALLOC_SLAB_GRANULE) : 0;
+    orca_slab_class* slabClass = &orca_slabClasses[classIndex];
+
+    orca_mallocStats.small_allocs++;
+    orca_mallocStats.class_allocs[classIndex]++;
+
+    void* ptr = slabClass->freeList;
+    if(ptr)
+    {
+        slabClass->freeList = slabClass->freeList->next;
+        orca_mallocStats.small_reuses++;
+    }
+    else
+    {
+        size_t blockSize = orca_slab_class_size(classIndex);
+        if((size_t)(slabClass->end - slabClass->bump) >= blockSize)
+        {
+            ptr = slabClass->bump;
+            slabClass->bump += blockSize;
+        }
+        else
+        {
+            ptr = orca_slab_refill(classIndex);
+        }
+    }
+    return (ptr);
+}
+
+static inline void orca_slab_free(void* ptr)
+{
+    uint32_t classIndex = orca_slab_class_of(ptr);
+    orca_slab_class* slabClass = &orca_slabClasses[classIndex];
+
+    orca_slab_block* block = (orca_slab_block*)ptr;
+    block->next = slabClass->freeList;
+    slabClass->freeList = block;
+
+    orca_mallocStats.small_frees++;
+    orca_mallocStats.class_frees[classIndex]++;
+}
+
+static void* orca_heap_malloc(size_t size)
+{
+    if(size <= ORCA_MALLOC_SLAB_MAX_SIZE)
+    {
+        return (orca_slab_alloc(size));
+    }
+    orca_mallocStats.large_allocs++;
+    return (dlmalloc(size));
+}
+
+static void orca_heap_free(void* ptr)
+{
+    if(!ptr)
+    {
+        return;
+    }
+    if(orca_slab_owns(ptr))
+    {
+        orca_slab_free(ptr);
+    }
+    else
+    {
+        orca_mallocStats.large_frees++;
+        dlfree(ptr);
+    }
+}
+
+static void* orca_heap_calloc(size_t count, size_t size)
+{
+    size_t total = count * size;
+    if(size && total / size != count)
+    {
+        return (0);
+    }
+    if(total <= ORCA_MALLOC_SLAB_MAX_SIZE)
+    {
+        /* blocks taken from a free list or a recycled dlmalloc chunk are dirty */
+        void* ptr = orca_slab_alloc(total);
+        if(ptr)
+        {
+            memset(ptr, 0, total);
+        }
+        return (ptr);
+    }
+    orca_mallocStats.large_allocs++;
+    return (dlcalloc(count, size));
+}
+
+static void* orca_heap_realloc(void* ptr, size_t size)
+{
+    if(!ptr)
+    {
+        return (orca_heap_malloc(size));
+    }
+    orca_mallocStats.reallocs++;
+
+    if(!orca_slab_owns(ptr))
+    {
+        return (dlrealloc(ptr, size));
+    }
+
+    size_t oldSize = orca_slab_class_size(orca_slab_class_of(ptr));
+    if(size <= oldSize && size > oldSize / 2)
+    {
+        /* still fits, and shrinking to a smaller class wouldn't save much */
+        return (ptr);
+    }
+
+    void* newPtr = orca_heap_malloc(size);
+    if(newPtr)
+    {
+        memcpy(newPtr, ptr, size < oldSize ? size : oldSize);
+        orca_slab_free(ptr);
+    }
+    return (newPtr);
+}
+
+static void* orca_heap_memalign(size_t alignment, size_t size)
+{
+    /* slab blocks are aligned on the granule, which is as much as dlmalloc guarantees */
+    if(alignment <= ORCA_MALLOC_SLAB_GRANULE)
+    {
+        return (orca_heap_malloc(size));
+    }
+    orca_mallocStats.large_allocs++;
+    return (dlmemalign(alignment, size));
+}
+
+static void* orca_heap_valloc(size_t size)
+{
+    orca_mallocStats.large_allocs++;
+    return (dlvalloc(size));
+}
+
+static void* orca_heap_pvalloc(size_t size)
+{
+    orca_mallocStats.large_allocs++;
+    return (dlpvalloc(size));
+}
+
+static size_t orca_heap_usable_size(void* ptr)
+{
+    if(ptr && orca_slab_owns(ptr))
+    {
+        return (orca_slab_class_size(orca_slab_class_of(ptr)));
+    }
+    return (dlmalloc_usable_size(ptr));
+}
+
+void orca_malloc_get_stats(struct orca_malloc_stats* stats)
+{
+    *stats = orca_mallocStats;
+}
+
+#else // ORCA_MALLOC_SLABS
+
+    #define orca_heap_malloc dlmalloc
+    #define orca_heap_free dlfree
+    #define orca_heap_calloc dlcalloc
+    #define orca_heap_realloc dlrealloc
+    #define orca_heap_memalign dlmemalign
+    #define orca_heap_valloc dlvalloc
+    #define orca_heap_pvalloc dlpvalloc
+    #define orca_heap_usable_size dlmalloc_usable_size
+
+void orca_malloc_get_stats(struct orca_malloc_stats* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+#endif // ORCA_MALLOC_SLABS
+
+#ifdef ORCA_MALLOC_TRACKING
+
+/* Tracking layer.
+
+   Each allocation is preceded by a header recording its requested size and the
+   site it was charged to, so that free() can update the counters of that site.
+   Sites are identified by the tag pushed with orca_malloc_push_tag(), since wasm
+   doesn't give us return addresses. The site table lives in linear memory and is
+   registered with the host on the first allocation, which reads it to show live
+   and peak usage per site and to dump it to a file. */
+
+__attribute__((import_name("oc_malloc_tracking_register")))
+void oc_malloc_tracking_register(const struct orca_malloc_tracking* tracking);
+
+enum
+{
+    ORCA_TRACKING_HEADER_SIZE = 16,
+    ORCA_TRACKING_MAGIC = 0x6f636d74,
+    ORCA_TRACKING_MAX_TAG_DEPTH = 64,
+};
+
+typedef struct orca_tracking_header
+{
+    uint32_t size;
+    uint32_t site;
+    uint32_t offset; // from the start of the underlying block to the user pointer
+    uint32_t magic;
+} orca_tracking_header;
+
+_Static_assert(sizeof(orca_tracking_header) == ORCA_TRACKING_HEADER_SIZE, "tracking header must keep user pointers aligned");
+
+static struct orca_malloc_tracking orca_mallocTracking = {
+    .site_count = 1,
+    .site_cap = ORCA_MALLOC_MAX_SITES,
+    .sites[0] = { .tag = "untagged", .tag_len = 8 },
+};
+static int orca_trackingRegistered = 0;
+
+static uint32_t orca_tagStack[ORCA_TRACKING_MAX_TAG_DEPTH];
+static uint32_t orca_tagDepth = 0;
+
+static uint32_t orca_tracking_find_site(const char* tag)
+{
+    for(uint32_t i = 0; i < orca_mallocTracking.site_count; i++)
+    {
+        const char* siteTag = orca_mallocTracking.sites[i].tag;
+        if(siteTag == tag || !strcmp(siteTag, tag))
+        {
+            return (i);
+        }
+    }
+    if(orca_mallocTracking.site_count >= ORCA_MALLOC_MAX_SITES)
+    {
+        /* out of sites, charge the allocations to "untagged" */
+        return (0);
+    }
+    uint32_t index = orca_mallocTracking.site_count++;
+    orca_mallocTracking.sites[index].tag = tag;
+    orca_mallocTracking.sites[index].tag_len = strlen(tag);
+    return (index);
+}
+
+void orca_malloc_push_tag(const char* tag)
+{
+    if(orca_tagDepth < ORCA_TRACKING_MAX_TAG_DEPTH)
+    {
+        orca_tagStack[orca_tagDepth] = orca_tracking_find_site(tag);
+    }
+    orca_tagDepth++;
+}
+
+void orca_malloc_pop_tag(void)
+{
+    if(orca_tagDepth)
+    {
+        orca_tagDepth--;
+    }
+}
+
+const struct orca_malloc_tracking* orca_malloc_get_tracking(void)
+{
+    return (&orca_mallocTracking);
+}
+
+static void* orca_tracking_commit(char* block, uint32_t offset, size_t size)
+{
+    if(!block)
+    {
+        return (0);
+    }
+    if(!orca_trackingRegistered)
+    {
+        orca_trackingRegistered = 1;
+        oc_malloc_tracking_register(&orca_mallocTracking);
+    }
+
+    uint32_t depth = orca_tagDepth < ORCA_TRACKING_MAX_TAG_DEPTH ? orca_tagDepth : ORCA_TRACKING_MAX_TAG_DEPTH;
+    uint32_t siteIndex = depth ? orca_tagStack[depth - 1] : 0;
+
+    char* ptr = block + offset;
+    orca_tracking_header* header = (orca_tracking_header*)(ptr - ORCA_TRACKING_HEADER_SIZE);
+    header->size = size;
+    header->site = siteIndex;
+    header->offset = offset;
+    header->magic = ORCA_TRACKING_MAGIC;
+
+    struct orca_malloc_site* site = &orca_mallocTracking.sites[siteIndex];
+    site->alloc_count++;
+    site->total_bytes += size;
+    site->live_bytes += size;
+    if(site->live_bytes > site->peak_bytes)
+    {
+        site->peak_bytes = site->live_bytes;
+    }
+
+    orca_mallocTracking.total_bytes += size;
+    orca_mallocTracking.live_bytes += size;
+    if(orca_mallocTracking.live_bytes > orca_mallocTracking.peak_bytes)
+    {
+        orca_mallocTracking.peak_bytes = orca_mallocTracking.live_bytes;
+    }
+    return (ptr);
+}
+
+static orca_tracking_header* orca_tracking_release(void* ptr)
+{
+    orca_tracking_header* header = (orca_tracking_header*)((char*)ptr - ORCA_TRACKING_HEADER_SIZE);
+    if(header->magic != ORCA_TRACKING_MAGIC)
+    {
+        /* double free or a pointer we didn't allocate */
+        __builtin_trap();
+    }
+    struct orca_malloc_site* site = &orca_mallocTracking.sites[header->site];
+    site->free_count++;
+    site->live_bytes -= header->size;
+    orca_mallocTracking.live_bytes -= header->size;
+
+    header->magic = 0;
+    return (header);
+}
+
+void* malloc(size_t size)
+{
+    if(size > SIZE_MAX - ORCA_TRACKING_HEADER_SIZE)
+    {
+        return (0);
+    }
+    return (orca_tracking_commit(orca_heap_malloc(size + ORCA_TRACKING_HEADER_SIZE), ORCA_TRACKING_HEADER_SIZE, size));
+}
+
+void free(void* ptr)
+{
+    if(ptr)
+    {
+        orca_tracking_header* header = orca_tracking_release(ptr);
+        orca_heap_free((char*)ptr - header->offset);
+    }
+}
+
+void* calloc(size_t count, size_t size)
+{
+    size_t total = count * size;
+    if(size && total / size != count)
+    {
+        return (0);
+    }
+    void* ptr = malloc(total);
+    if(ptr)
+    {
+        memset(ptr, 0, total);
+    }
+    return (ptr);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    if(!ptr)
+    {
+        return (malloc(size));
+    }
+    if(size > SIZE_MAX - ORCA_TRACKING_HEADER_SIZE)
+    {
+        return (0);
+    }
+
+    orca_tracking_header* header = (orca_tracking_header*)((char*)ptr - ORCA_TRACKING_HEADER_SIZE);
+    if(header->offset != ORCA_TRACKING_HEADER_SIZE)
+    {
+        /* over-aligned blocks are moved to a regular one */
+        void* newPtr = malloc(size);
+        if(newPtr)
+        {
+            memcpy(newPtr, ptr, size < header->size ? size : header->size);
+            free(ptr);
+        }
+        return (newPtr);
+    }
+
+    /* the old block is released from its site first, and the new one is charged to the current tag */
+    uint32_t oldSize = header->size;
+    uint32_t oldSite = header->site;
+    orca_tracking_release(ptr);
+
+    char* block = orca_heap_realloc(header, size + ORCA_TRACKING_HEADER_SIZE);
+    if(!block)
+    {
+        /* the old block is still valid, put it back */
+        header->magic = ORCA_TRACKING_MAGIC;
+        struct orca_malloc_site* site = &orca_mallocTracking.sites[oldSite];
+        site->free_count--;
+        site->live_bytes += oldSize;
+        orca_mallocTracking.live_bytes += oldSize;
+        return (0);
+    }
+    return (orca_tracking_commit(block, ORCA_TRACKING_HEADER_SIZE, size));
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    if(alignment <= ORCA_TRACKING_HEADER_SIZE)
+    {
+        return (malloc(size));
+    }
+    if(size > SIZE_MAX - alignment)
+    {
+        return (0);
+    }
+    /* the header goes in the padding in front of the aligned pointer */
+    return (orca_tracking_commit(orca_heap_memalign(alignment, size + alignment), alignment, size));
+}
+
+void* valloc(size_t size)
+{
+    return (memalign(4096, size));
+}
+
+void* pvalloc(size_t size)
+{
+    return (memalign(4096, (size + 4095) & ~(size_t)4095));
+}
+
+size_t malloc_usable_size(void* ptr)
+{
+    if(!ptr)
+    {
+        return (0);
+    }
+    orca_tracking_header* header = (orca_tracking_header*)((char*)ptr - ORCA_TRACKING_HEADER_SIZE);
+    return (orca_heap_usable_size((char*)ptr - header->offset) - header->offset);
+}
+
+#else // ORCA_MALLOC_TRACKING
+
+void orca_malloc_push_tag(const char* tag)
+{
+}
+
+void orca_malloc_pop_tag(void)
+{
+}
+
+const struct orca_malloc_tracking* orca_malloc_get_tracking(void)
+{
+    return (0);
+}
+
+    #ifdef ORCA_MALLOC_SLABS
+
+void* malloc(size_t size)
+{
+    return (orca_heap_malloc(size));
+}
+
+void free(void* ptr)
+{
+    orca_heap_free(ptr);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    return (orca_heap_calloc(count, size));
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    return (orca_heap_realloc(ptr, size));
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    return (orca_heap_memalign(alignment, size));
+}
+
+void* valloc(size_t size)
+{
+    return (orca_heap_valloc(size));
+}
+
+void* pvalloc(size_t size)
+{
+    return (orca_heap_pvalloc(size));
+}
+
+size_t malloc_usable_size(void* ptr)
+{
+    return (orca_heap_usable_size(ptr));
+}
+
+    #endif // ORCA_MALLOC_SLABS
+#endif // ORCA_MALLOC_TRACKING
+
+#if defined(ORCA_MALLOC_SLABS) || defined(ORCA_MALLOC_TRACKING)
+
+void cfree(void* ptr)
+{
+    free(ptr);
+}
+
+int malloc_trim(size_t pad)
+{
+    return (dlmalloc_trim(pad));
+}
+
+#endif
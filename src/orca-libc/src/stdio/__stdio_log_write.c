@@ -0,0 +1,72 @@
+#include "stdio_impl.h"
+#include <string.h>
+
+/* stdout and stderr are forwarded to the runtime's log console. Each call to
+   oc_bridge_log_lines() hands over a whole buffer, which the runtime splits
+   into log entries, so a flush costs one host call however many lines it holds.
+
+   When the streams are written out depends on their buffering mode (see
+   setvbuf()): fully buffered streams are flushed when their buffer is full,
+   line buffered streams after each newline, and unbuffered streams on every
+   write. The runtime also flushes both streams at the end of each frame and
+   before the app terminates. By default stdout is fully buffered and stderr is
+   line buffered. */
+
+/* mirrors oc_log_level */
+enum { ORCA_LOG_LEVEL_ERROR = 0, ORCA_LOG_LEVEL_INFO = 2 };
+
+__attribute__((import_name("oc_bridge_log_lines")))
+void oc_bridge_log_lines(int level, int len, const char* text);
+
+static void log_write(FILE* f, const unsigned char* text, size_t len)
+{
+	if (len)
+	{
+		int level = (f == __stderr_used) ? ORCA_LOG_LEVEL_ERROR : ORCA_LOG_LEVEL_INFO;
+		oc_bridge_log_lines(level, (int)len, (const char*)text);
+	}
+}
+
+size_t __stdio_log_write(FILE* f, const unsigned char* buffer, size_t size)
+{
+	if (!f->buf_size)
+	{
+		log_write(f, buffer, size);
+		return size;
+	}
+
+	/* append to the internal buffer, and only send full buffers, so that lines
+	   are only split when they are longer than the buffer */
+	size_t done = 0;
+	while (1)
+	{
+		size_t room = f->buf + f->buf_size - f->wpos;
+		size_t count = (size - done < room) ? size - done : room;
+		memcpy(f->wpos, buffer + done, count);
+		f->wpos += count;
+		done += count;
+
+		if (done == size)
+		{
+			break;
+		}
+		log_write(f, f->wbase, f->wpos - f->wbase);
+		f->wpos = f->wbase;
+	}
+	log_write(f, f->wbase, f->wpos - f->wbase);
+
+	f->wend = f->buf + f->buf_size;
+	f->wbase = f->buf;
+	f->wpos = f->wbase;
+	return size;
+}
+
+/* Called by the runtime at the end of each frame. */
+__attribute__((export_name("oc_stdio_flush_stub")))
+void oc_stdio_flush_stub(void)
+{
+	/* the std streams are weak symbols that stay null when they are not linked
+	   in, and fflush(0) would flush every open file */
+	if (__stdout_used) fflush(__stdout_used);
+	if (__stderr_used) fflush(__stderr_used);
+}
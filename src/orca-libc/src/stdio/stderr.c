@@ -7,9 +7,10 @@ hidden FILE __stderr_FILE = {
 	.buf = buf+UNGET,
 	.buf_size = sizeof buf-UNGET,
 	.orca_file =  0, // oc_file handle 0 is the nil handle,
-	.flags = F_PERM | F_NOWR | F_NORD,
+	.flags = F_PERM | F_NORD,
+	.lbf = '\n',
 	.read = __file_read_err_shim,
-	.write = __file_write_err_shim,
+	.write = __stdio_log_write,
 	.seek = __file_seek_err_shim,
 	.close = __file_close_err_shim,
 #if defined(__wasilibc_unmodified_upstream) || defined(_REENTRANT)
@@ -1,6 +1,9 @@
 #include <string.h>
 #include <stdint.h>
 #include <limits.h>
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
 
 #define SS (sizeof(size_t))
 #define ALIGN (sizeof(size_t)-1)
@@ -12,7 +15,28 @@ void *memchr(const void *src, int c, size_t n)
 {
 	const unsigned char *s = src;
 	c = (unsigned char)c;
-#ifdef __GNUC__
+#if defined(__wasm_simd128__)
+	/* Aligned 16-byte loads never cross a wasm page boundary, so
+	 * reading past the end of the buffer can't trap. Bytes before
+	 * s in the first block are masked out, and matches past the end
+	 * are rejected by comparing against the remaining length. */
+	if (!n) return 0;
+	uintptr_t align = (uintptr_t)s % sizeof(v128_t);
+	const v128_t *v = (const void *)(s - align);
+	const v128_t vc = wasm_i8x16_splat(c);
+	size_t left = n + align;
+	uint32_t mask = wasm_i8x16_bitmask(wasm_i8x16_eq(wasm_v128_load(v), vc)) >> align << align;
+	for (;;) {
+		if (mask) {
+			size_t i = __builtin_ctz(mask);
+			return i < left ? (void *)((const unsigned char *)v + i) : 0;
+		}
+		if (left <= sizeof(v128_t)) return 0;
+		left -= sizeof(v128_t);
+		v++;
+		mask = wasm_i8x16_bitmask(wasm_i8x16_eq(wasm_v128_load(v), vc));
+	}
+#elif defined(__GNUC__)
 	for (; ((uintptr_t)s & ALIGN) && n && *s != c; s++, n--);
 	if (n && *s != c) {
 		typedef size_t __attribute__((__may_alias__)) word;
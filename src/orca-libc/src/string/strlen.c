@@ -1,6 +1,9 @@
 #include <string.h>
 #include <stdint.h>
 #include <limits.h>
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
 
 #define ALIGN (sizeof(size_t))
 #define ONES ((size_t)-1/UCHAR_MAX)
@@ -10,7 +13,19 @@
 size_t strlen(const char *s)
 {
 	const char *a = s;
-#ifdef __GNUC__
+#if defined(__wasm_simd128__)
+	/* Aligned 16-byte loads never cross a wasm page boundary, so
+	 * reading past the terminator can't trap. Bytes before s in the
+	 * first block are masked out. */
+	uintptr_t align = (uintptr_t)s % sizeof(v128_t);
+	const v128_t *v = (const void *)(s - align);
+	uint32_t mask = wasm_i8x16_bitmask(wasm_i8x16_eq(wasm_v128_load(v), wasm_i8x16_splat(0))) >> align << align;
+	while (!mask) {
+		v++;
+		mask = wasm_i8x16_bitmask(wasm_i8x16_eq(wasm_v128_load(v), wasm_i8x16_splat(0)));
+	}
+	return (const char *)v + __builtin_ctz(mask) - a;
+#elif defined(__GNUC__)
 	typedef size_t __attribute__((__may_alias__)) word;
 	const word *w;
 	for (; (uintptr_t)s % ALIGN; s++) if (!*s) return s-a;
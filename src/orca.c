@@ -14,13 +14,20 @@
 #if OC_PLATFORM_WINDOWS
     #include "platform/native_debug.c"
     #include "platform/win32.c"
+    #include "platform/platform_jobs.c"
+    #include "platform/platform_pool.c"
+    #include "platform/platform_trace.c"
 #elif OC_PLATFORM_MACOS
     #include "platform/native_debug.c"
     #include "platform/unix_memory.c"
     #include "platform/osx_clock.c"
     #include "platform/osx_path.c"
     #include "platform/posix_io.c"
+    #include "platform/osx_audio.c"
     #include "platform/posix_thread.c"
+    #include "platform/platform_jobs.c"
+    #include "platform/platform_pool.c"
+    #include "platform/platform_trace.c"
     #include "platform/osx_platform.c"
 
 /*
@@ -35,6 +42,8 @@
     #include "platform/posix_io.c"
     #include "platform/platform_io_dialog.c"
     #include "platform/posix_thread.c"
+    #include "platform/platform_jobs.c"
+    #include "platform/platform_pool.c"
 /*
 	#include"platform/unix_rng.c"
 	#include"platform/posix_socket.c"
@@ -44,7 +53,10 @@
     #include "platform/orca_clock.c"
     #include "platform/orca_memory.c"
     #include "platform/platform_io_common.c"
+    #include "platform/platform_kv.c"
     #include "platform/orca_io_stubs.c"
+    #include "platform/orca_net_stubs.c"
+    #include "platform/orca_audio_stubs.c"
     #include "platform/orca_platform.c"
     #include "platform/platform_path.c"
 #else
@@ -55,10 +67,13 @@
 // utilities implementations
 //---------------------------------------------------------------
 #include "util/algebra.c"
+#include "util/fast_math.c"
 #include "util/hash.c"
+#include "util/hash_map.c"
 #include "util/memory.c"
 #include "util/lists.c"
 #include "util/ringbuffer.c"
+#include "util/sort.c"
 #include "util/strings.c"
 #include "util/utf8.c"
 
@@ -74,6 +89,7 @@
         #include "graphics/canvas_renderer.c"
         #include "graphics/surface.c"
         #include "graphics/win32_surface.c"
+        #include "graphics/image_surface_win32.c"
 
         #include "graphics/backends.h"
 
@@ -97,6 +113,11 @@
             #include "graphics/wgpu_renderer.c"
         #endif
 
+        #if OC_GRAPHICS_ENABLE_CPU_CANVAS
+            #include "graphics/cpu_surface_win32.c"
+            #include "graphics/cpu_renderer.c"
+        #endif
+
     #elif OC_PLATFORM_MACOS
         #include "platform/platform_io_dialog.c"
     //NOTE: macos application layer and graphics backends are defined in orca.m
@@ -105,6 +126,9 @@
         #include "wasmbind/core_api_stubs.c"
         #include "graphics/graphics_common.c"
         #include "graphics/orca_surface_stubs.c"
+        #if OC_GLES_COMMAND_BUFFER
+            #include "graphics/orca_gles_command_stubs.c"
+        #endif
     #else
         #error "Unsupported platform"
     #endif
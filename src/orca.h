@@ -9,10 +9,13 @@
 
 #include "util/algebra.h"
 #include "util/debug.h"
+#include "util/fast_math.h"
 #include "util/hash.h"
+#include "util/hash_map.h"
 #include "util/lists.h"
 #include "util/macros.h"
 #include "util/memory.h"
+#include "util/sort.h"
 #include "util/strings.h"
 #include "util/typedefs.h"
 #include "util/utf8.h"
@@ -20,7 +23,11 @@
 #include "platform/platform.h"
 #include "platform/platform_clock.h"
 #include "platform/platform_io.h"
+#include "platform/platform_kv.h"
+#include "platform/platform_net.h"
+#include "platform/platform_audio.h"
 #include "platform/platform_path.h"
+#include "platform/platform_trace.h"
 
 #if !defined(OC_PLATFORM_ORCA) || !(OC_PLATFORM_ORCA)
     #include "platform/platform_thread.h"
@@ -11,6 +11,7 @@
 #include "graphics/canvas_renderer.c"
 #include "graphics/surface.c"
 #include "graphics/osx_surface.m"
+#include "graphics/image_surface_osx.m"
 
 #include "graphics/backends.h"
 
@@ -30,3 +31,8 @@
 #if OC_GRAPHICS_ENABLE_CANVAS
     #include "graphics/wgpu_renderer.c"
 #endif
+
+#if OC_GRAPHICS_ENABLE_CPU_CANVAS
+    #include "graphics/cpu_surface_osx.m"
+    #include "graphics/cpu_renderer.c"
+#endif
@@ -88,8 +88,10 @@ void platform_log_push(oc_log_output* output,
 // Assert/Abort
 //----------------------------------------------------------------
 
-_Noreturn void ORCA_IMPORT(oc_bridge_abort_ext)(const char* file, const char* function, int line, const char* msg);
-_Noreturn void ORCA_IMPORT(oc_bridge_assert_fail)(const char* file, const char* function, int line, const char* src, const char* msg);
+//NOTE: these are defined in the generated core api stubs. Strings are passed with their length, so that the host
+//      only needs to range check them.
+void oc_bridge_abort_ext(oc_str8 file, oc_str8 function, int line, oc_str8 msg);
+void oc_bridge_assert_fail(oc_str8 file, oc_str8 function, int line, oc_str8 src, oc_str8 msg);
 
 _Noreturn void oc_abort_ext(const char* file, const char* function, int line, const char* fmt, ...)
 {
@@ -110,9 +112,10 @@ _Noreturn void oc_abort_ext(const char* file, const char* function, int line, co
 
     oc_str8 msg = oc_str8_list_join(scratch.arena, ctx.list);
 
-    oc_bridge_abort_ext(file, function, line, msg.ptr);
+    oc_bridge_abort_ext(OC_STR8(file), OC_STR8(function), line, msg);
 
     oc_scratch_end(scratch);
+    __builtin_trap();
 }
 
 _Noreturn void oc_assert_fail(const char* file, const char* function, int line, const char* src, const char* fmt, ...)
@@ -134,7 +137,8 @@ _Noreturn void oc_assert_fail(const char* file, const char* function, int line,
 
     oc_str8 msg = oc_str8_list_join(scratch.arena, ctx.list);
 
-    oc_bridge_assert_fail(file, function, line, src, msg.ptr);
+    oc_bridge_assert_fail(OC_STR8(file), OC_STR8(function), line, OC_STR8(src), msg);
 
     oc_scratch_end(scratch);
+    __builtin_trap();
 }
@@ -9,6 +9,7 @@
 #include "platform_memory.h"
 
 void* ORCA_IMPORT(oc_mem_grow)(u64 size);
+void ORCA_IMPORT(oc_mem_decommit)(void* ptr, u64 size);
 
 void* orca_oc_base_reserve(oc_base_allocator* context, u64 size)
 {
@@ -17,15 +18,38 @@ void* orca_oc_base_reserve(oc_base_allocator* context, u64 size)
 
 void orca_oc_base_nop(oc_base_allocator* context, void* ptr, u64 size) {}
 
+//NOTE: memory returned by oc_mem_grow() is already committed
+bool orca_oc_base_commit(oc_base_allocator* context, void* ptr, u64 size)
+{
+    return (true);
+}
+
+void orca_oc_base_decommit(oc_base_allocator* context, void* ptr, u64 size)
+{
+    oc_mem_decommit(ptr, size);
+}
+
+u64 oc_base_resident_size(void* ptr, u64 size)
+{
+    //NOTE: the guest can't query the host's page residency
+    return (size);
+}
+
 oc_base_allocator* oc_base_allocator_default()
 {
     static oc_base_allocator base = { 0 };
     if(base.reserve == 0)
     {
         base.reserve = orca_oc_base_reserve;
-        base.commit = orca_oc_base_nop;
-        base.decommit = orca_oc_base_nop;
+        base.commit = orca_oc_base_commit;
+        base.decommit = orca_oc_base_decommit;
         base.release = orca_oc_base_nop;
     }
     return (&base);
 }
+
+oc_base_allocator* oc_base_allocator_large_pages()
+{
+    //NOTE: page sizes are up to the runtime, which backs wasm memory with large pages when asked to
+    return (oc_base_allocator_default());
+}
@@ -0,0 +1,140 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <AudioToolbox/AudioToolbox.h>
+
+#include "platform_audio_internal.h"
+#include "platform_audio_common.c"
+
+typedef struct oc_audio_osx
+{
+    AudioComponentInstance unit;
+} oc_audio_osx;
+
+static OSStatus oc_audio_osx_render(void* user,
+                                    AudioUnitRenderActionFlags* flags,
+                                    const AudioTimeStamp* timestamp,
+                                    UInt32 bus,
+                                    UInt32 frameCount,
+                                    AudioBufferList* data)
+{
+    //NOTE: the stream format is interleaved, so there is a single buffer
+    oc_audio_output* output = (oc_audio_output*)user;
+    oc_audio_output_pull(output, frameCount, (f32*)data->mBuffers[0].mData);
+    return (noErr);
+}
+
+bool oc_audio_native_open(oc_audio_output* output)
+{
+    oc_audio_osx* native = calloc(1, sizeof(oc_audio_osx));
+    if(!native)
+    {
+        return (false);
+    }
+    output->native = native;
+
+    AudioComponentDescription desc = {
+        .componentType = kAudioUnitType_Output,
+        .componentSubType = kAudioUnitSubType_DefaultOutput,
+        .componentManufacturer = kAudioUnitManufacturer_Apple,
+    };
+    AudioComponent component = AudioComponentFindNext(0, &desc);
+    if(!component || AudioComponentInstanceNew(component, &native->unit) != noErr)
+    {
+        oc_log_error("couldn't create the default audio output unit\n");
+        free(native);
+        output->native = 0;
+        return (false);
+    }
+
+    if(!output->sampleRate)
+    {
+        AudioStreamBasicDescription deviceFormat = { 0 };
+        UInt32 size = sizeof(deviceFormat);
+        if(AudioUnitGetProperty(native->unit, kAudioUnitProperty_StreamFormat, kAudioUnitScope_Output, 0, &deviceFormat, &size) == noErr
+           && deviceFormat.mSampleRate > 0)
+        {
+            output->sampleRate = (u32)deviceFormat.mSampleRate;
+        }
+        else
+        {
+            output->sampleRate = 48000;
+        }
+    }
+
+    //NOTE: the default output unit converts our format to the device's one
+    AudioStreamBasicDescription format = {
+        .mSampleRate = output->sampleRate,
+        .mFormatID = kAudioFormatLinearPCM,
+        .mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked,
+        .mBytesPerPacket = output->frameSize,
+        .mFramesPerPacket = 1,
+        .mBytesPerFrame = output->frameSize,
+        .mChannelsPerFrame = output->channelCount,
+        .mBitsPerChannel = 32,
+    };
+
+    AURenderCallbackStruct callback = {
+        .inputProc = oc_audio_osx_render,
+        .inputProcRefCon = output,
+    };
+
+    OSStatus status = AudioUnitSetProperty(native->unit, kAudioUnitProperty_StreamFormat, kAudioUnitScope_Input, 0, &format, sizeof(format));
+    if(status == noErr)
+    {
+        status = AudioUnitSetProperty(native->unit, kAudioUnitProperty_SetRenderCallback, kAudioUnitScope_Input, 0, &callback, sizeof(callback));
+    }
+    if(status == noErr)
+    {
+        status = AudioUnitInitialize(native->unit);
+    }
+    if(status != noErr)
+    {
+        oc_log_error("couldn't set up the audio output unit (%i)\n", (int)status);
+        AudioComponentInstanceDispose(native->unit);
+        free(native);
+        output->native = 0;
+        return (false);
+    }
+
+    UInt32 deviceFrames = 0;
+    UInt32 size = sizeof(deviceFrames);
+    if(AudioUnitGetProperty(native->unit, kAudioDevicePropertyBufferFrameSize, kAudioUnitScope_Global, 0, &deviceFrames, &size) == noErr)
+    {
+        output->deviceFrames = deviceFrames;
+    }
+
+    Float64 unitLatency = 0;
+    size = sizeof(unitLatency);
+    AudioUnitGetProperty(native->unit, kAudioUnitProperty_Latency, kAudioUnitScope_Global, 0, &unitLatency, &size);
+
+    output->deviceLatency = unitLatency + (f64)output->deviceFrames / output->sampleRate;
+    return (true);
+}
+
+void oc_audio_native_start(oc_audio_output* output)
+{
+    oc_audio_osx* native = (oc_audio_osx*)output->native;
+    if(AudioOutputUnitStart(native->unit) != noErr)
+    {
+        oc_log_error("couldn't start the audio output unit\n");
+    }
+}
+
+void oc_audio_native_close(oc_audio_output* output)
+{
+    oc_audio_osx* native = (oc_audio_osx*)output->native;
+    if(native)
+    {
+        //NOTE: stopping waits for the render callback to return, so the queue can be freed after this
+        AudioOutputUnitStop(native->unit);
+        AudioUnitUninitialize(native->unit);
+        AudioComponentInstanceDispose(native->unit);
+        free(native);
+        output->native = 0;
+    }
+}
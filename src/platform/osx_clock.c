@@ -17,6 +17,11 @@
 #include <sys/sysctl.h>
 #include <sys/types.h>
 
+#if OC_ARCH_X64
+    #include <cpuid.h>      // __get_cpuid()
+    #include <x86intrin.h> // __rdtsc()
+#endif
+
 #include "platform_clock.h"
 
 typedef struct timeval timeval;
@@ -58,12 +63,85 @@ static inline u64 OSXGetMonotonicNanoseconds()
 #endif
 }
 
+//NOTE: when the CPU counter runs at a known, constant rate (the generic timer's virtual counter on ARM64, an
+//      invariant TSC on x64), the monotonic clock reads it directly, which costs a few nanoseconds instead of going
+//      through the system's clock, so that it can timestamp trace zones and per-frame work. The counter is anchored
+//      to CLOCK_MONOTONIC_RAW at init. Like the uptime clock, it may lag behind after the system sleeps.
+static bool __counterEnabled = false;
+static f64 __counterSecondsPerTick = 0;
+static u64 __counterAnchor = 0;
+static f64 __counterAnchorTime = 0;
+
+static inline u64 oc_clock_read_counter()
+{
+#if OC_ARCH_ARM64
+    u64 counter;
+    __asm__ volatile("isb\n\tmrs %0, cntvct_el0"
+                     : "=r"(counter)
+                     :
+                     : "memory");
+    return (counter);
+#elif OC_ARCH_X64
+    return (__rdtsc());
+#else
+    return (0);
+#endif
+}
+
+static u64 oc_clock_counter_frequency()
+{
+    u64 freq = 0;
+#if OC_ARCH_ARM64
+    __asm__ volatile("mrs %0, cntfrq_el0"
+                     : "=r"(freq));
+#elif OC_ARCH_X64
+    u32 eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if(__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1 << 8)))
+    {
+        size_t size = sizeof(freq);
+        if(sysctlbyname("machdep.tsc.frequency", &freq, &size, 0, 0) != 0)
+        {
+            freq = 0;
+        }
+    }
+#endif
+    return (freq);
+}
+
+static void oc_clock_counter_init()
+{
+    u64 freq = oc_clock_counter_frequency();
+    if(!freq)
+    {
+        return;
+    }
+
+    //NOTE: take the counter at the middle of the narrowest bracket around the system clock read, out of a few tries
+    u64 bestWidth = ~0ULL;
+    for(int i = 0; i < 8; i++)
+    {
+        u64 before = oc_clock_read_counter();
+        u64 ns = OSXGetMonotonicNanoseconds();
+        u64 after = oc_clock_read_counter();
+
+        if(after - before < bestWidth)
+        {
+            bestWidth = after - before;
+            __counterAnchor = before + (after - before) / 2;
+            __counterAnchorTime = (f64)ns * 1e-9;
+        }
+    }
+    __counterSecondsPerTick = 1. / (f64)freq;
+    __counterEnabled = true;
+}
+
 static const f64 CLK_TIMESTAMPS_PER_SECOND = 4294967296.; // 2^32 as a double
 static const u64 CLK_JAN_1970 = 2208988800ULL;            // seconds from january 1900 to january 1970
 
 void oc_clock_init()
 {
     mach_timebase_info(&__machTimeBase__);
+    oc_clock_counter_init();
 
     //NOTE(martin): get the date of system boot time
     timeval tv = { 0, 0 };
@@ -130,6 +208,10 @@ f64 oc_clock_time(oc_clock_kind clock)
     {
         case OC_CLOCK_MONOTONIC:
         {
+            if(__counterEnabled)
+            {
+                return (__counterAnchorTime + (f64)(i64)(oc_clock_read_counter() - __counterAnchor) * __counterSecondsPerTick);
+            }
             //NOTE(martin): compute monotonic offset and add it to bootup timestamp
             u64 noff = OSXGetMonotonicNanoseconds();
             return ((f64)noff * 1e-9);
@@ -157,3 +239,32 @@ f64 oc_clock_time(oc_clock_kind clock)
         break;
     }
 }
+
+//NOTE: mach_wait_until() usually wakes up within a few tens of microseconds of its deadline, the spin tail covers that
+static const f64 OC_SLEEP_SPIN_TAIL = 0.25e-3;
+
+void oc_sleep_until(f64 deadline)
+{
+    f64 remaining = deadline - oc_clock_time(OC_CLOCK_MONOTONIC);
+    while(remaining > OC_SLEEP_SPIN_TAIL)
+    {
+        //NOTE: mach_wait_until() takes a deadline in mach absolute time, which is our uptime clock and doesn't advance
+        //      at the same rate as the monotonic clock, so we convert the remaining time to mach ticks from now.
+        //      The wait can be interrupted early, in which case we just wait again for what's left.
+        u64 ns = (u64)((remaining - OC_SLEEP_SPIN_TAIL) * 1e9);
+        u64 ticks = ns * __machTimeBase__.denom / __machTimeBase__.numer;
+        mach_wait_until(mach_absolute_time() + ticks);
+
+        remaining = deadline - oc_clock_time(OC_CLOCK_MONOTONIC);
+    }
+
+    while(oc_clock_time(OC_CLOCK_MONOTONIC) < deadline)
+    {
+        //NOTE: spin
+    }
+}
+
+void oc_sleep(f64 seconds)
+{
+    oc_sleep_until(oc_clock_time(OC_CLOCK_MONOTONIC) + seconds);
+}
@@ -98,6 +98,14 @@
 #if OC_PLATFORM_ORCA
     #define ORCA_IMPORT(f) __attribute__((import_name(#f))) f
 
+    //NOTE: with OC_GLES_COMMAND_BUFFER, GL functions are defined by graphics/orca_gles_command_stubs.c, which records
+    //      them in a buffer that the runtime replays in bulk, instead of being imported one by one.
+    #if OC_GLES_COMMAND_BUFFER
+        #define ORCA_GLES_IMPORT(f) f
+    #else
+        #define ORCA_GLES_IMPORT(f) ORCA_IMPORT(f)
+    #endif
+
     #if OC_COMPILER_CLANG
         #ifdef __cplusplus
             #define ORCA_EXPORT __attribute__((visibility("default"))) extern "C"
@@ -0,0 +1,69 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "platform.h"
+#include "util/typedefs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+//----------------------------------------------------------------
+// Audio output
+//----------------------------------------------------------------
+
+typedef struct oc_audio_config
+{
+    u32 sampleRate;   // frames per second, or 0 for the device's rate
+    u32 channelCount; // interleaved channels per frame, or 0 for stereo
+    u32 bufferFrames; // capacity of the queue that feeds the device, or 0 for 100ms
+} oc_audio_config;
+
+typedef struct oc_audio_info
+{
+    u32 sampleRate;
+    u32 channelCount;
+    u32 bufferFrames; // capacity of the queue that feeds the device
+    u32 deviceFrames; // size of the device's own buffer
+    u64 queuedFrames; // frames that were written but not played yet
+    u64 underruns;    // device pulls that found the queue short since the first write, and were padded with silence
+    f64 latency;      // seconds until a frame written now is played
+} oc_audio_info;
+
+/*NOTE:
+	Samples are 32-bit floats in [-1, 1], with the channels of each frame interleaved. The device pulls them from a
+	queue on its own thread, so apps should write large blocks once per frame rather than one call per device
+	buffer. The queue holds up to bufferFrames frames, which bounds the latency: a bigger queue survives longer
+	frames without underruns, and a smaller one makes sounds start sooner.
+
+	oc_audio_open() opens the default output device, and replaces the output that is already open, if any.
+	oc_audio_write() copies as many whole frames as fit in the queue, and returns the number of samples it copied.
+	oc_audio_get_info() returns the actual format of the output, which can differ from the requested one, and how
+	full its queue is.
+*/
+ORCA_API bool oc_audio_open(oc_audio_config config);
+ORCA_API void oc_audio_close(void);
+ORCA_API u64 oc_audio_write(u64 sampleCount, f32* samples);
+ORCA_API oc_audio_info oc_audio_get_info(void);
+
+#if !defined(OC_PLATFORM_ORCA) || !OC_PLATFORM_ORCA
+
+//NOTE: host side of audio outputs. The runtime opens one for each app that asks for it.
+typedef struct oc_audio_output oc_audio_output;
+
+ORCA_API oc_audio_output* oc_audio_output_open(oc_audio_config config);
+ORCA_API void oc_audio_output_close(oc_audio_output* output);
+ORCA_API u64 oc_audio_output_write(oc_audio_output* output, u64 sampleCount, f32* samples);
+ORCA_API oc_audio_info oc_audio_output_info(oc_audio_output* output);
+
+#endif // !OC_PLATFORM_ORCA
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
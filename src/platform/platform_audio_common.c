@@ -0,0 +1,107 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include "platform_audio_internal.h"
+
+enum
+{
+    OC_AUDIO_DEFAULT_CHANNEL_COUNT = 2,
+    OC_AUDIO_MAX_CHANNEL_COUNT = 8,
+    OC_AUDIO_MIN_BUFFER_FRAMES = 64,
+    OC_AUDIO_MAX_BUFFER_SECONDS = 10,
+};
+
+oc_audio_output* oc_audio_output_open(oc_audio_config config)
+{
+    oc_audio_output* output = calloc(1, sizeof(oc_audio_output));
+    if(!output)
+    {
+        return (0);
+    }
+    output->sampleRate = config.sampleRate;
+    output->channelCount = config.channelCount ? oc_min(config.channelCount, OC_AUDIO_MAX_CHANNEL_COUNT)
+                                               : OC_AUDIO_DEFAULT_CHANNEL_COUNT;
+    output->frameSize = output->channelCount * sizeof(f32);
+
+    if(!oc_audio_native_open(output))
+    {
+        free(output);
+        return (0);
+    }
+
+    u32 bufferFrames = config.bufferFrames ? config.bufferFrames : output->sampleRate / 10;
+    output->bufferFrames = oc_clamp(bufferFrames, OC_AUDIO_MIN_BUFFER_FRAMES, output->sampleRate * OC_AUDIO_MAX_BUFFER_SECONDS);
+
+    //NOTE: the ring keeps one sentinel byte, and its capacity is rounded up to a power of two. Writes are limited to
+    //      bufferFrames, so that the latency is the one that was asked for.
+    u64 ringSize = (u64)output->bufferFrames * output->frameSize + 1;
+    u8 capExp = 0;
+    while((1ULL << capExp) < ringSize)
+    {
+        capExp++;
+    }
+    oc_ringbuffer_init(&output->ring, capExp);
+
+    oc_audio_native_start(output);
+    return (output);
+}
+
+void oc_audio_output_close(oc_audio_output* output)
+{
+    if(output)
+    {
+        oc_audio_native_close(output);
+        oc_ringbuffer_cleanup(&output->ring);
+        free(output);
+    }
+}
+
+u64 oc_audio_output_write(oc_audio_output* output, u64 sampleCount, f32* samples)
+{
+    u64 queued = oc_ringbuffer_read_available(&output->ring);
+    u64 available = (u64)output->bufferFrames * output->frameSize - queued;
+    u64 size = oc_min(sampleCount * sizeof(f32), available);
+    size -= size % output->frameSize;
+
+    if(size)
+    {
+        oc_ringbuffer_write(&output->ring, size, (u8*)samples);
+        atomic_store(&output->primed, true);
+    }
+    return (size / sizeof(f32));
+}
+
+oc_audio_info oc_audio_output_info(oc_audio_output* output)
+{
+    u64 queuedFrames = oc_ringbuffer_read_available(&output->ring) / output->frameSize;
+
+    oc_audio_info info = {
+        .sampleRate = output->sampleRate,
+        .channelCount = output->channelCount,
+        .bufferFrames = output->bufferFrames,
+        .deviceFrames = output->deviceFrames,
+        .queuedFrames = queuedFrames,
+        .underruns = atomic_load(&output->underruns),
+        .latency = (f64)queuedFrames / output->sampleRate + output->deviceLatency,
+    };
+    return (info);
+}
+
+void oc_audio_output_pull(oc_audio_output* output, u32 frameCount, f32* samples)
+{
+    u64 size = (u64)frameCount * output->frameSize;
+    u64 read = oc_ringbuffer_read(&output->ring, size, (u8*)samples);
+
+    if(read < size)
+    {
+        memset((u8*)samples + read, 0, size - read);
+        if(atomic_load(&output->primed))
+        {
+            atomic_fetch_add(&output->underruns, 1);
+        }
+    }
+}
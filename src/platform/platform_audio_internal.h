@@ -0,0 +1,38 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "platform_audio.h"
+#include "util/ringbuffer.h"
+
+typedef struct oc_audio_output
+{
+    u32 sampleRate;
+    u32 channelCount;
+    u32 bufferFrames;
+    u32 deviceFrames;
+    f64 deviceLatency; // seconds between a device pull and the output of its first frame
+    u32 frameSize;
+
+    //NOTE: single-producer, single-consumer queue. The app's thread writes to it, and the device's thread reads
+    //      from it without locking.
+    oc_ringbuffer ring;
+    _Atomic(u64) underruns;
+    _Atomic(bool) primed;
+
+    void* native;
+} oc_audio_output;
+
+//NOTE: called on the device's thread to fill frameCount frames at samples. Missing frames are filled with silence.
+void oc_audio_output_pull(oc_audio_output* output, u32 frameCount, f32* samples);
+
+//NOTE: backend functions. open sets up the device for the requested format, and fills in the actual sample rate,
+//      device frames and device latency, but doesn't pull frames until start is called.
+bool oc_audio_native_open(oc_audio_output* output);
+void oc_audio_native_start(oc_audio_output* output);
+void oc_audio_native_close(oc_audio_output* output);
@@ -23,6 +23,12 @@ typedef enum
 
 #if !defined(OC_PLATFORM_ORCA) || !OC_PLATFORM_ORCA
 ORCA_API void oc_clock_init(); // initialize the clock subsystem
+
+//NOTE: blocks the calling thread until OC_CLOCK_MONOTONIC reaches deadline (in seconds). The thread sleeps on the
+//      platform's high resolution timer until shortly before the deadline, then spins for the remaining time, so
+//      that wake ups aren't late by a scheduler quantum. Returns immediately if the deadline has already passed.
+ORCA_API void oc_sleep_until(f64 deadline);
+ORCA_API void oc_sleep(f64 seconds); // same as oc_sleep_until(oc_clock_time(OC_CLOCK_MONOTONIC) + seconds)
 #endif
 
 ORCA_API f64 oc_clock_time(oc_clock_kind clock);
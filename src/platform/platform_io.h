@@ -70,9 +70,74 @@ enum oc_io_op_enum
     OC_IO_WRITE,
 
     OC_OC_IO_ERROR,
+
+    //NOTE: positional ops read or write at offset, and don't change the file position.
+    //      Vectored ops take an array of size oc_io_vec in buffer.
+    OC_IO_PREAD,
+    OC_IO_PWRITE,
+    OC_IO_PREADV,
+    OC_IO_PWRITEV,
+
+    //NOTE: fills buffer with the entries of a directory, starting at entry index offset. See oc_io_dir_entry.
+    OC_IO_READDIR,
+
+    //NOTE: tells the host how the range [offset, offset + size) will be accessed. A size of 0 extends to the
+    //      end of the file. Advice is a hint, and never changes the results of other requests.
+    OC_IO_ADVISE,
+
+    //NOTE: OC_IO_WRITE_BUFFER gives a regular file a host-side write-behind buffer of size bytes, or removes it if
+    //      size is 0. The completion's size is the size of the buffer. OC_IO_FLUSH writes the buffered bytes to the
+    //      file, and waits for them to reach storage according to sync.
+    OC_IO_WRITE_BUFFER,
+    OC_IO_FLUSH,
+
+    //NOTE: OC_IO_WATCH starts watching a directory for changes according to watch, or stops if watch is
+    //      OC_FILE_WATCH_NONE. OC_IO_READ_CHANGES fills buffer with the pending changes. See oc_io_file_change.
+    OC_IO_WATCH,
+    OC_IO_READ_CHANGES,
     //...
 };
 
+typedef u32 oc_file_advice;
+
+enum oc_file_advice_enum
+{
+    OC_FILE_ADVICE_NORMAL = 0,
+    OC_FILE_ADVICE_SEQUENTIAL, // reads go forward from the file position. Small reads are buffered by the host.
+    OC_FILE_ADVICE_RANDOM,     // reads go anywhere. Disables read-ahead.
+    OC_FILE_ADVICE_WILLNEED,   // the range will be read soon, and can be prefetched
+    OC_FILE_ADVICE_DONTNEED,   // the range won't be read again soon, and can be dropped from caches
+};
+
+typedef u32 oc_file_sync;
+
+enum oc_file_sync_enum
+{
+    OC_FILE_SYNC_NONE = 0, // only hands the buffered bytes to the OS
+    OC_FILE_SYNC_DATA,     // also waits until the file's contents are written to the storage device
+    OC_FILE_SYNC_FULL,     // also waits for the file's metadata, and for the device's cache where the OS allows it
+};
+
+typedef u32 oc_file_watch_flags;
+
+enum oc_file_watch_flags_enum
+{
+    OC_FILE_WATCH_NONE = 0,           // stops watching
+    OC_FILE_WATCH_DIRECTORY = 1 << 0, // watches the entries of the directory
+    OC_FILE_WATCH_RECURSIVE = 1 << 1, // also watches the entries of its subdirectories
+};
+
+typedef struct oc_io_vec
+{
+    union
+    {
+        char* buffer;
+        u64 unused; // same layout hack as oc_io_req
+    };
+
+    u64 size;
+} oc_io_vec;
+
 typedef struct oc_io_req
 {
     oc_io_req_id id;
@@ -97,6 +162,9 @@ typedef struct oc_io_req
         } open;
 
         oc_file_whence whence;
+        oc_file_advice advice;
+        oc_file_sync sync;
+        oc_file_watch_flags watch;
     };
 
 } oc_io_req;
@@ -148,10 +216,24 @@ typedef struct oc_io_cmp
 } oc_io_cmp;
 
 //----------------------------------------------------------------
-//TODO: complete io queue api
+// IO queue API
 //----------------------------------------------------------------
 ORCA_API oc_io_cmp oc_io_wait_single_req(oc_io_req* req);
 
+//NOTE: oc_io_wait_reqs() executes count requests in order and writes their completions to cmps. This is equivalent
+//      to calling oc_io_wait_single_req() on each request, but only crosses the wasm bridge once.
+ORCA_API void oc_io_wait_reqs(u32 count, oc_io_req* reqs, oc_io_cmp* cmps);
+
+//NOTE: oc_io_submit() queues count requests and returns the number of requests submitted. The id of each request
+//      is written back to reqs[i].id, and is used to match it with its completion. Requests complete in submission
+//      order. Buffers referenced by a request must stay valid until its completion is returned.
+ORCA_API u32 oc_io_submit(u32 count, oc_io_req* reqs);
+
+//NOTE: oc_io_wait() writes up to max completions to cmps and returns their number. If no completion is available,
+//      it waits up to timeout seconds for one to arrive. oc_io_poll() returns immediately.
+ORCA_API u32 oc_io_wait(u32 max, oc_io_cmp* cmps, f64 timeout);
+ORCA_API u32 oc_io_poll(u32 max, oc_io_cmp* cmps);
+
 //----------------------------------------------------------------
 // File IO wrapper API
 //----------------------------------------------------------------
@@ -169,6 +251,22 @@ ORCA_API i64 oc_file_seek(oc_file file, i64 offset, oc_file_whence whence);
 ORCA_API u64 oc_file_write(oc_file file, u64 size, char* buffer);
 ORCA_API u64 oc_file_read(oc_file file, u64 size, char* buffer);
 
+//NOTE: these read or write at offset without changing the file position, and return the number of bytes transferred.
+ORCA_API u64 oc_file_write_at(oc_file file, i64 offset, u64 size, char* buffer);
+ORCA_API u64 oc_file_read_at(oc_file file, i64 offset, u64 size, char* buffer);
+ORCA_API u64 oc_file_writev_at(oc_file file, i64 offset, u32 count, oc_io_vec* vecs);
+ORCA_API u64 oc_file_readv_at(oc_file file, i64 offset, u32 count, oc_io_vec* vecs);
+
+ORCA_API oc_io_error oc_file_advise(oc_file file, i64 offset, u64 size, oc_file_advice advice);
+
+//NOTE: with a write buffer, writes at the file position are copied to a host-side buffer, and written to the file in
+//      one piece when it is full, when the file is closed, before any other request on the file, or by oc_file_flush().
+//      Writes at least as large as the buffer bypass it. An error while writing buffered bytes is reported by the
+//      request that flushed them, and the bytes are dropped. oc_file_set_write_buffer() returns the buffer's size,
+//      which is capped by the host. To sync without blocking, submit an OC_IO_FLUSH request with oc_io_submit().
+ORCA_API u64 oc_file_set_write_buffer(oc_file file, u64 size);
+ORCA_API oc_io_error oc_file_flush(oc_file file, oc_file_sync sync);
+
 ORCA_API oc_io_error oc_file_last_error(oc_file handle);
 
 //----------------------------------------------------------------
@@ -232,6 +330,64 @@ typedef struct oc_file_status
 ORCA_API oc_file_status oc_file_get_status(oc_file file);
 ORCA_API u64 oc_file_size(oc_file file);
 
+//----------------------------------------------------------------
+// Directory enumeration
+//----------------------------------------------------------------
+
+//NOTE: OC_IO_READDIR packs as many entries as fit in the request's buffer, and returns their number in the
+//      completion's result. Each entry is followed by its null-terminated name, and the next entry starts
+//      recordSize bytes after the current one. '.' and '..' are not listed.
+typedef struct oc_io_dir_entry
+{
+    u32 recordSize;
+    u32 nameLen; // excluding the null terminator
+    oc_file_type type;
+    u32 reserved;
+    u64 size;
+    oc_datestamp modificationDate;
+
+} oc_io_dir_entry;
+
+//NOTE: oc_file_read_dir() reads entries of dir starting at index start into buffer, and returns the number of entries
+//      read. It returns 0 once all entries have been read, or on error.
+ORCA_API u64 oc_file_read_dir(oc_file dir, u64 start, u64 size, char* buffer);
+ORCA_API oc_str8 oc_io_dir_entry_name(oc_io_dir_entry* entry);
+ORCA_API oc_io_dir_entry* oc_io_dir_entry_next(oc_io_dir_entry* entry);
+
+//----------------------------------------------------------------
+// Directory change notifications
+//----------------------------------------------------------------
+
+typedef u32 oc_file_change_kind;
+
+enum oc_file_change_kind_enum
+{
+    OC_FILE_CHANGE_ADDED,    // created, or moved into the watched tree
+    OC_FILE_CHANGE_REMOVED,  // deleted, or moved out of the watched tree
+    OC_FILE_CHANGE_MODIFIED, // contents or metadata changed
+    OC_FILE_CHANGE_OVERFLOW, // some changes were lost, and the watched tree must be read again. The path is empty.
+};
+
+//NOTE: OC_IO_READ_CHANGES packs as many pending changes as fit in the request's buffer, and returns their number in
+//      the completion's result. Each change is followed by its null-terminated path, relative to the watched directory
+//      and separated by '/', and the next change starts recordSize bytes after the current one.
+typedef struct oc_io_file_change
+{
+    u32 recordSize;
+    u32 pathLen; // excluding the null terminator
+    oc_file_change_kind kind;
+    u32 reserved;
+
+} oc_io_file_change;
+
+//NOTE: while a directory is watched, an OC_EVENT_FILE_CHANGE event is queued when changes become pending. Repeated
+//      changes to the same path are merged. Read changes with oc_file_read_changes() until it returns 0, after which
+//      the next change queues a new event. Watching a watched directory again replaces its flags.
+ORCA_API oc_io_error oc_file_watch(oc_file dir, oc_file_watch_flags flags);
+ORCA_API u64 oc_file_read_changes(oc_file dir, u64 size, char* buffer);
+ORCA_API oc_str8 oc_io_file_change_path(oc_io_file_change* change);
+ORCA_API oc_io_file_change* oc_io_file_change_next(oc_io_file_change* change);
+
 //TODO: Complete as needed...
 
 //----------------------------------------------------------------
@@ -240,6 +396,28 @@ ORCA_API u64 oc_file_size(oc_file file);
 
 ORCA_API oc_file oc_file_open_with_request(oc_str8 path, oc_file_access rights, oc_file_open_flags flags);
 
+#if !defined(OC_PLATFORM_ORCA) || !(OC_PLATFORM_ORCA)
+//----------------------------------------------------------------
+// Read-only file mappings (not available to Orca apps)
+//----------------------------------------------------------------
+
+//NOTE: oc_file_map_read_only() maps the whole file at path in memory, or returns an empty string on failure.
+//      The mapping stays valid until it is passed to oc_file_unmap().
+ORCA_API oc_str8 oc_file_map_read_only(oc_str8 path);
+ORCA_API void oc_file_unmap(oc_str8 mapping);
+#else
+//----------------------------------------------------------------
+// File mappings
+//----------------------------------------------------------------
+
+//NOTE: oc_file_map() makes [offset, offset + size) of file readable in the app's memory, clamped to the end of the file,
+//      or returns an empty string on failure. Where the host supports it, the pages are mapped from the file instead of
+//      being copied. The contents should be treated as read-only: writes only change the mapping, never the file.
+//      The mapping stays valid until it is passed to oc_file_unmap(), even if the file is closed.
+ORCA_API oc_str8 oc_file_map(oc_file file, i64 offset, u64 size);
+ORCA_API void oc_file_unmap(oc_str8 mapping);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
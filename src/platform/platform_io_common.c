@@ -22,6 +22,11 @@ bool oc_file_is_nil(oc_file handle)
     return (handle.h == 0);
 }
 
+u32 oc_io_poll(u32 max, oc_io_cmp* cmps)
+{
+    return (oc_io_wait(max, cmps, 0));
+}
+
 oc_file oc_file_open(oc_str8 path, oc_file_access rights, oc_file_open_flags flags)
 {
     oc_io_req req = { .op = OC_IO_OPEN_AT,
@@ -97,6 +102,86 @@ u64 oc_file_read(oc_file file, u64 size, char* buffer)
     return (cmp.size);
 }
 
+u64 oc_file_write_at(oc_file file, i64 offset, u64 size, char* buffer)
+{
+    oc_io_req req = { .op = OC_IO_PWRITE,
+                      .handle = file,
+                      .offset = offset,
+                      .size = size,
+                      .buffer = buffer };
+
+    oc_io_cmp cmp = oc_io_wait_single_req(&req);
+    return (cmp.size);
+}
+
+u64 oc_file_read_at(oc_file file, i64 offset, u64 size, char* buffer)
+{
+    oc_io_req req = { .op = OC_IO_PREAD,
+                      .handle = file,
+                      .offset = offset,
+                      .size = size,
+                      .buffer = buffer };
+
+    oc_io_cmp cmp = oc_io_wait_single_req(&req);
+    return (cmp.size);
+}
+
+u64 oc_file_writev_at(oc_file file, i64 offset, u32 count, oc_io_vec* vecs)
+{
+    oc_io_req req = { .op = OC_IO_PWRITEV,
+                      .handle = file,
+                      .offset = offset,
+                      .size = count,
+                      .buffer = (char*)vecs };
+
+    oc_io_cmp cmp = oc_io_wait_single_req(&req);
+    return (cmp.size);
+}
+
+u64 oc_file_readv_at(oc_file file, i64 offset, u32 count, oc_io_vec* vecs)
+{
+    oc_io_req req = { .op = OC_IO_PREADV,
+                      .handle = file,
+                      .offset = offset,
+                      .size = count,
+                      .buffer = (char*)vecs };
+
+    oc_io_cmp cmp = oc_io_wait_single_req(&req);
+    return (cmp.size);
+}
+
+oc_io_error oc_file_advise(oc_file file, i64 offset, u64 size, oc_file_advice advice)
+{
+    oc_io_req req = { .op = OC_IO_ADVISE,
+                      .handle = file,
+                      .offset = offset,
+                      .size = size,
+                      .advice = advice };
+
+    oc_io_cmp cmp = oc_io_wait_single_req(&req);
+    return (cmp.error);
+}
+
+u64 oc_file_set_write_buffer(oc_file file, u64 size)
+{
+    oc_io_req req = { .op = OC_IO_WRITE_BUFFER,
+                      .handle = file,
+                      .size = size };
+
+    oc_io_cmp cmp = oc_io_wait_single_req(&req);
+    return (cmp.size);
+}
+
+oc_io_error oc_file_flush(oc_file file, oc_file_sync sync)
+{
+    oc_io_req req = { .op = OC_IO_FLUSH,
+                      .handle = file,
+                      .sync = sync };
+
+    oc_io_cmp cmp = oc_io_wait_single_req(&req);
+    return (cmp.error);
+}
+
 oc_io_error oc_file_last_error(oc_file file)
 {
     oc_io_req req = { .op = OC_OC_IO_ERROR,
@@ -106,6 +191,59 @@ oc_io_error oc_file_last_error(oc_file file)
     return ((oc_io_error)cmp.result);
 }
 
+u64 oc_file_read_dir(oc_file dir, u64 start, u64 size, char* buffer)
+{
+    oc_io_req req = { .op = OC_IO_READDIR,
+                      .handle = dir,
+                      .offset = start,
+                      .size = size,
+                      .buffer = buffer };
+
+    oc_io_cmp cmp = oc_io_wait_single_req(&req);
+    return (cmp.size);
+}
+
+oc_str8 oc_io_dir_entry_name(oc_io_dir_entry* entry)
+{
+    return (oc_str8_from_buffer(entry->nameLen, (char*)(entry + 1)));
+}
+
+oc_io_dir_entry* oc_io_dir_entry_next(oc_io_dir_entry* entry)
+{
+    return ((oc_io_dir_entry*)((char*)entry + entry->recordSize));
+}
+
+oc_io_error oc_file_watch(oc_file dir, oc_file_watch_flags flags)
+{
+    oc_io_req req = { .op = OC_IO_WATCH,
+                      .handle = dir,
+                      .watch = flags };
+
+    oc_io_cmp cmp = oc_io_wait_single_req(&req);
+    return (cmp.error);
+}
+
+u64 oc_file_read_changes(oc_file dir, u64 size, char* buffer)
+{
+    oc_io_req req = { .op = OC_IO_READ_CHANGES,
+                      .handle = dir,
+                      .size = size,
+                      .buffer = buffer };
+
+    oc_io_cmp cmp = oc_io_wait_single_req(&req);
+    return (cmp.size);
+}
+
+oc_str8 oc_io_file_change_path(oc_io_file_change* change)
+{
+    return (oc_str8_from_buffer(change->pathLen, (char*)(change + 1)));
+}
+
+oc_io_file_change* oc_io_file_change_next(oc_io_file_change* change)
+{
+    return ((oc_io_file_change*)((char*)change + change->recordSize));
+}
+
 oc_file_status oc_file_get_status(oc_file file)
 {
     oc_file_status status = { 0 };
@@ -20,27 +20,58 @@ oc_file_slot* oc_file_slot_alloc(oc_file_table* table)
     oc_file_slot* slot = oc_list_pop_front_entry(&table->freeList, oc_file_slot, freeListElt);
     if(!slot && table->nextSlot < OC_IO_MAX_FILE_SLOTS)
     {
-        slot = &table->slots[table->nextSlot];
-        slot->generation = 1;
-        table->nextSlot++;
+        u32 pageIndex = table->nextSlot / OC_IO_FILE_SLOT_PAGE_SIZE;
+        if(!table->pages[pageIndex])
+        {
+            table->pages[pageIndex] = calloc(OC_IO_FILE_SLOT_PAGE_SIZE, sizeof(oc_file_slot));
+        }
+        if(table->pages[pageIndex])
+        {
+            slot = &table->pages[pageIndex][table->nextSlot % OC_IO_FILE_SLOT_PAGE_SIZE];
+            slot->index = table->nextSlot;
+            slot->generation = 1;
+            table->nextSlot++;
+        }
     }
 
-    u32 tmpGeneration = slot->generation;
-    memset(slot, 0, sizeof(oc_file_slot));
-    slot->generation = tmpGeneration;
+    if(slot)
+    {
+        u32 tmpIndex = slot->index;
+        u32 tmpGeneration = slot->generation;
+        memset(slot, 0, sizeof(oc_file_slot));
+        slot->index = tmpIndex;
+        slot->generation = tmpGeneration;
+    }
 
     return (slot);
 }
 
+void oc_io_dir_cache_invalidate_root(oc_file_table* table, oc_file_desc rootFd);
+
 void oc_file_slot_recycle(oc_file_table* table, oc_file_slot* slot)
 {
+    if(slot->type == OC_FILE_DIRECTORY)
+    {
+        oc_io_dir_cache_invalidate_root(table, slot->fd);
+    }
+    if(slot->readAhead.buffer)
+    {
+        free(slot->readAhead.buffer);
+        slot->readAhead.buffer = 0;
+    }
+    if(slot->writeBehind.buffer)
+    {
+        free(slot->writeBehind.buffer);
+        slot->writeBehind = (oc_io_write_behind){ 0 };
+    }
+    oc_io_watch_stop(slot);
     slot->generation++;
     oc_list_push_front(&table->freeList, &slot->freeListElt);
 }
 
 oc_file oc_file_from_slot(oc_file_table* table, oc_file_slot* slot)
 {
-    u64 index = slot - table->slots;
+    u64 index = slot->index;
     u64 generation = slot->generation;
     oc_file handle = { .h = (generation << 32) | index };
     return (handle);
@@ -55,7 +86,7 @@ oc_file_slot* oc_file_slot_from_handle(oc_file_table* table, oc_file handle)
 
     if(index < table->nextSlot)
     {
-        oc_file_slot* candidate = &table->slots[index];
+        oc_file_slot* candidate = &table->pages[index / OC_IO_FILE_SLOT_PAGE_SIZE][index % OC_IO_FILE_SLOT_PAGE_SIZE];
         if(candidate->generation == generation)
         {
             slot = candidate;
@@ -64,24 +95,156 @@ oc_file_slot* oc_file_slot_from_handle(oc_file_table* table, oc_file handle)
     return (slot);
 }
 
+//NOTE: closes the files that are still open in the table and frees its slots, e.g. when the app instance that owns
+//      it is stopped. The table can be used again afterwards.
+void oc_file_table_close_all(oc_file_table* table)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    bool* isFree = oc_arena_push_array(scratch.arena, bool, table->nextSlot);
+    memset(isFree, 0, table->nextSlot * sizeof(bool));
+    oc_list_for(table->freeList, slot, oc_file_slot, freeListElt)
+    {
+        isFree[slot->index] = true;
+    }
+
+    for(u32 index = 0; index < table->nextSlot; index++)
+    {
+        if(!isFree[index])
+        {
+            oc_file_slot* slot = &table->pages[index / OC_IO_FILE_SLOT_PAGE_SIZE][index % OC_IO_FILE_SLOT_PAGE_SIZE];
+            oc_io_req req = { .op = OC_IO_CLOSE, .handle = oc_file_from_slot(table, slot) };
+            oc_io_wait_single_req_for_table(&req, table);
+        }
+    }
+    oc_scratch_end(scratch);
+
+    //NOTE: closing the directories already dropped their cached subdirectories, this catches any leftover
+    for(u32 i = 0; i < OC_IO_DIR_CACHE_SIZE; i++)
+    {
+        oc_io_dir_cache_entry* entry = &table->dirCache.entries[i];
+        if(entry->used)
+        {
+            oc_io_raw_close(entry->fd);
+        }
+    }
+
+    for(u32 pageIndex = 0; pageIndex < OC_IO_MAX_FILE_SLOT_PAGES; pageIndex++)
+    {
+        free(table->pages[pageIndex]);
+    }
+
+    u64 watchWindow = table->watchWindow;
+    memset(table, 0, sizeof(oc_file_table));
+    table->watchWindow = watchWindow;
+}
+
+oc_io_queue* oc_globalIoQueue = 0;
+
 oc_io_cmp oc_io_wait_single_req(oc_io_req* req)
 {
-    return (oc_io_wait_single_req_for_table(req, &oc_globalFileTable));
+    //NOTE: the global queue's worker is the only other user of the global file table
+    if(oc_globalIoQueue)
+    {
+        oc_io_queue_lock_table(oc_globalIoQueue);
+    }
+    oc_io_cmp cmp = oc_io_wait_single_req_for_table(req, &oc_globalFileTable);
+    if(oc_globalIoQueue)
+    {
+        oc_io_queue_unlock_table(oc_globalIoQueue);
+    }
+    return (cmp);
+}
+
+void oc_io_wait_reqs_for_table(u32 count, oc_io_req* reqs, oc_io_cmp* cmps, oc_file_table* table)
+{
+    for(u32 i = 0; i < count; i++)
+    {
+        cmps[i] = oc_io_wait_single_req_for_table(&reqs[i], table);
+        cmps[i].id = reqs[i].id;
+    }
+}
+
+void oc_io_wait_reqs(u32 count, oc_io_req* reqs, oc_io_cmp* cmps)
+{
+    if(oc_globalIoQueue)
+    {
+        oc_io_queue_lock_table(oc_globalIoQueue);
+    }
+    oc_io_wait_reqs_for_table(count, reqs, cmps, &oc_globalFileTable);
+    if(oc_globalIoQueue)
+    {
+        oc_io_queue_unlock_table(oc_globalIoQueue);
+    }
+}
+
+u32 oc_io_submit(u32 count, oc_io_req* reqs)
+{
+    if(!oc_globalIoQueue)
+    {
+        oc_globalIoQueue = oc_io_queue_create(&oc_globalFileTable);
+    }
+    for(u32 i = 0; i < count; i++)
+    {
+        reqs[i].id = oc_io_queue_submit(oc_globalIoQueue, &reqs[i]);
+    }
+    return (count);
+}
+
+u32 oc_io_wait(u32 max, oc_io_cmp* cmps, f64 timeout)
+{
+    u32 count = 0;
+    if(oc_globalIoQueue)
+    {
+        count = oc_io_queue_wait(oc_globalIoQueue, max, cmps, timeout);
+    }
+    return (count);
 }
 
 //-----------------------------------------------------------------------
 // io common primitives
 //-----------------------------------------------------------------------
 
+//NOTE: appends an entry at *offset in the buffer of a OC_IO_READDIR request. Returns false if it doesn't fit.
+bool oc_io_dir_entry_push(oc_io_req* req, u64* offset, oc_str8 name, oc_file_type type, u64 size, oc_datestamp modificationDate)
+{
+    u64 recordSize = oc_align_up_pow2(sizeof(oc_io_dir_entry) + name.len + 1, 8);
+    if(*offset + recordSize > req->size || recordSize > UINT32_MAX)
+    {
+        return (false);
+    }
+
+    oc_io_dir_entry* entry = (oc_io_dir_entry*)(req->buffer + *offset);
+    memset(entry, 0, recordSize);
+    entry->recordSize = recordSize;
+    entry->nameLen = name.len;
+    entry->type = type;
+    entry->size = size;
+    entry->modificationDate = modificationDate;
+    memcpy((char*)(entry + 1), name.ptr, name.len);
+
+    *offset += recordSize;
+    return (true);
+}
+
 typedef struct oc_io_open_restrict_context
 {
     oc_io_error error;
     u64 rootUID;
     oc_file_desc rootFd;
+    oc_file_desc cachedFd; // directory borrowed from the dir cache, must not be closed
     oc_file_desc fd;
 
 } oc_io_open_restrict_context;
 
+static void oc_io_open_restrict_release(oc_io_open_restrict_context* context, oc_file_desc fd)
+{
+    if(fd != context->rootFd && fd != context->cachedFd)
+    {
+        oc_io_raw_close(fd);
+    }
+}
+
 oc_io_error oc_io_open_restrict_enter(oc_io_open_restrict_context* context, oc_str8 name, oc_file_access accessRights, oc_file_open_flags openFlags)
 {
     oc_file_desc nextFd = oc_io_raw_open_at(context->fd, name, accessRights, openFlags);
@@ -91,10 +254,7 @@ oc_io_error oc_io_open_restrict_enter(oc_io_open_restrict_context* context, oc_s
     }
     else
     {
-        if(context->fd != context->rootFd)
-        {
-            oc_io_raw_close(context->fd);
-        }
+        oc_io_open_restrict_release(context, context->fd);
         context->fd = nextFd;
     }
     return (context->error);
@@ -103,18 +263,150 @@ oc_io_error oc_io_open_restrict_enter(oc_io_open_restrict_context* context, oc_s
 typedef struct oc_io_open_restrict_result
 {
     oc_io_error error;
+    u64 rootUID;
     oc_file_desc fd;
 } oc_io_open_restrict_result;
 
-oc_io_open_restrict_result oc_io_open_restrict(oc_file_desc dirFd, oc_str8 path, oc_file_access accessRights, oc_file_open_flags openFlags)
+static void oc_io_open_restrict_walk(oc_arena* arena,
+                                     oc_io_open_restrict_context* context,
+                                     oc_str8_list pathElements,
+                                     oc_file_access accessRights,
+                                     oc_file_open_flags openFlags)
 {
-    oc_arena_scope scratch = oc_scratch_begin();
+    oc_list_for(pathElements.list, elt, oc_str8_elt, listElt)
+    {
+        oc_str8 name = elt->string;
+        oc_file_access eltAccessRights = OC_FILE_ACCESS_READ;
+        oc_file_open_flags eltOpenFlags = 0;
 
-    oc_str8_list pathElements = oc_path_split(scratch.arena, path);
+        bool atLastElement = (&elt->listElt == oc_list_last(pathElements.list));
+        if(atLastElement)
+        {
+            eltAccessRights = accessRights;
+            eltOpenFlags = openFlags;
+        }
+
+        if(!oc_str8_cmp(name, OC_STR8("."))
+           && !atLastElement)
+        {
+            //NOTE: if we're not at the last element we can just skip '.' elements
+            continue;
+        }
+        else if(!oc_str8_cmp(name, OC_STR8("..")))
+        {
+            //NOTE: check that we don't escape root dir
+            oc_file_status status;
+            context->error = oc_io_raw_fstat(context->fd, &status);
+            if(context->error)
+            {
+                break;
+            }
+            else if(status.uid == context->rootUID)
+            {
+                context->error = OC_IO_ERR_WALKOUT;
+                break;
+            }
+        }
+        else if(!oc_io_raw_file_exists_at(context->fd, name, OC_FILE_OPEN_SYMLINK))
+        {
+            //NOTE: if the file doesn't exists, but we're at the last element and OC_FILE_OPEN_CREATE
+            //      is set, we create the file. Otherwise it is a OC_IO_ERROR_NO_ENTRY error.
+            if(!atLastElement
+               || !(openFlags & OC_FILE_OPEN_CREATE))
+            {
+                context->error = OC_IO_ERR_NO_ENTRY;
+                break;
+            }
+        }
+        else
+        {
+            //NOTE: if the file exists, we check the type of file
+            oc_file_status status = { 0 };
+            context->error = oc_io_raw_fstat_at(context->fd, name, OC_FILE_OPEN_SYMLINK, &status);
+            if(context->error)
+            {
+                break;
+            }
+
+            if(status.type == OC_FILE_REGULAR)
+            {
+                if(!atLastElement)
+                {
+                    context->error = OC_IO_ERR_NOT_DIR;
+                    break;
+                }
+            }
+            else if(status.type == OC_FILE_SYMLINK)
+            {
+                //TODO  - do we need a OC_FILE_OPEN_NO_FOLLOW that fails if last element is a symlink?
+                //      - do we need a OC_FILE_OPEN_NO_SYMLINKS that fails if _any_ element is a symlink?
+
+                if(!atLastElement
+                   || !(openFlags & OC_FILE_OPEN_SYMLINK))
+                {
+                    oc_io_raw_read_link_result link = oc_io_raw_read_link_at(arena, context->fd, name);
+                    if(link.error)
+                    {
+                        context->error = link.error;
+                        break;
+                    }
+                    if(link.target.len == 0)
+                    {
+                        //NOTE: treat an empty target as a '.'
+                        link.target = OC_STR8(".");
+                    }
+                    else if(oc_path_is_absolute(link.target))
+                    {
+                        context->error = OC_IO_ERR_WALKOUT;
+                        break;
+                    }
+
+                    oc_str8_list linkElements = oc_path_split(arena, link.target);
+
+                    if(!oc_list_empty(linkElements.list))
+                    {
+                        //NOTE: insert linkElements into pathElements after elt
+                        oc_list_elt* tmp = elt->listElt.next;
+                        elt->listElt.next = linkElements.list.first;
+                        linkElements.list.last->next = tmp;
+                        if(!tmp)
+                        {
+                            pathElements.list.last = linkElements.list.last;
+                        }
+                    }
+                    continue;
+                }
+            }
+            else if(status.type != OC_FILE_DIRECTORY)
+            {
+                context->error = OC_IO_ERR_NOT_DIR;
+                break;
+            }
+        }
+
+        //NOTE: if we arrive here, we have no errors and the correct flags are set,
+        //      so we can enter the element
+        OC_DEBUG_ASSERT(context->error == OC_IO_OK);
+        oc_io_open_restrict_enter(context, name, eltAccessRights, eltOpenFlags);
+    }
+
+    if(context->error && !oc_file_desc_is_nil(context->fd))
+    {
+        oc_io_open_restrict_release(context, context->fd);
+        context->fd = oc_file_desc_nil();
+    }
+}
 
+static oc_io_open_restrict_result oc_io_open_restrict_uncached(oc_arena* arena,
+                                                               oc_file_desc dirFd,
+                                                               oc_str8_list pathElements,
+                                                               oc_file_access accessRights,
+                                                               oc_file_open_flags openFlags)
+{
     oc_io_open_restrict_context context = {
         .error = OC_IO_OK,
         .rootFd = dirFd,
+        .cachedFd = oc_file_desc_nil(),
         .fd = dirFd,
     };
 
@@ -131,142 +423,950 @@ oc_io_open_restrict_result oc_io_open_restrict(oc_file_desc dirFd, oc_str8 path,
 
     if(context.error == OC_IO_OK)
     {
-        oc_list_for(pathElements.list, elt, oc_str8_elt, listElt)
+        oc_io_open_restrict_walk(arena, &context, pathElements, accessRights, openFlags);
+    }
+    else
+    {
+        context.fd = oc_file_desc_nil();
+    }
+
+    oc_io_open_restrict_result result = {
+        .error = context.error,
+        .rootUID = context.rootUID,
+        .fd = context.fd,
+    };
+    return (result);
+}
+
+//-----------------------------------------------------------------------
+// restricted open directory cache
+//-----------------------------------------------------------------------
+/*NOTE:
+    Restricted opens walk the path one element at a time to enforce the root. When all the directory elements
+    of a path are plain names, the directory they lead to is cached, so that opening other files in the same
+    directory only costs an open of the last element.
+
+    Entries are invalidated when their root is closed, and evicted in least recently used order. A cached
+    directory that was concurrently removed or replaced makes opens fail. On failure we redo a full walk,
+    and drop the entry if that walk succeeds.
+*/
+
+void oc_io_dir_cache_invalidate_root(oc_file_table* table, oc_file_desc rootFd)
+{
+    oc_io_dir_cache* cache = &table->dirCache;
+    for(u32 i = 0; i < OC_IO_DIR_CACHE_SIZE; i++)
+    {
+        oc_io_dir_cache_entry* entry = &cache->entries[i];
+        if(entry->used && entry->rootFd == rootFd)
+        {
+            oc_io_raw_close(entry->fd);
+            entry->used = false;
+        }
+    }
+}
+
+static void oc_io_dir_cache_remove(oc_io_dir_cache_entry* entry)
+{
+    oc_io_raw_close(entry->fd);
+    entry->used = false;
+}
+
+static oc_io_dir_cache_entry* oc_io_dir_cache_find(oc_file_table* table, oc_file_desc rootFd, oc_str8 path)
+{
+    oc_io_dir_cache* cache = &table->dirCache;
+    for(u32 i = 0; i < OC_IO_DIR_CACHE_SIZE; i++)
+    {
+        oc_io_dir_cache_entry* entry = &cache->entries[i];
+        if(entry->used
+           && entry->rootFd == rootFd
+           && !oc_str8_cmp(oc_str8_from_buffer(entry->pathLen, entry->path), path))
         {
-            oc_str8 name = elt->string;
-            oc_file_access eltAccessRights = OC_FILE_ACCESS_READ;
-            oc_file_open_flags eltOpenFlags = 0;
+            cache->useCount++;
+            entry->lastUse = cache->useCount;
+            return (entry);
+        }
+    }
+    return (0);
+}
 
-            bool atLastElement = (&elt->listElt == oc_list_last(pathElements.list));
-            if(atLastElement)
-            {
-                eltAccessRights = accessRights;
-                eltOpenFlags = openFlags;
-            }
+static oc_io_dir_cache_entry* oc_io_dir_cache_insert(oc_file_table* table, oc_file_desc rootFd, u64 rootUID, oc_str8 path, oc_file_desc fd)
+{
+    oc_io_dir_cache* cache = &table->dirCache;
 
-            if(!oc_str8_cmp(name, OC_STR8("."))
-               && !atLastElement)
-            {
-                //NOTE: if we're not at the last element we can just skip '.' elements
-                continue;
-            }
-            else if(!oc_str8_cmp(name, OC_STR8("..")))
+    oc_io_dir_cache_entry* entry = &cache->entries[0];
+    for(u32 i = 0; i < OC_IO_DIR_CACHE_SIZE; i++)
+    {
+        oc_io_dir_cache_entry* candidate = &cache->entries[i];
+        if(!candidate->used)
+        {
+            entry = candidate;
+            break;
+        }
+        else if(candidate->lastUse < entry->lastUse)
+        {
+            entry = candidate;
+        }
+    }
+    if(entry->used)
+    {
+        oc_io_dir_cache_remove(entry);
+    }
+
+    cache->useCount++;
+
+    entry->used = true;
+    entry->lastUse = cache->useCount;
+    entry->rootFd = rootFd;
+    entry->rootUID = rootUID;
+    entry->fd = fd;
+    entry->pathLen = path.len;
+    memcpy(entry->path, path.ptr, path.len);
+
+    return (entry);
+}
+
+//NOTE: returns the path of the directory containing the last element, if it can be cached.
+static bool oc_io_dir_cache_key(oc_arena* arena, oc_str8_list pathElements, oc_str8* key)
+{
+    oc_str8_list dirElements = { 0 };
+    oc_list_for(pathElements.list, elt, oc_str8_elt, listElt)
+    {
+        if(&elt->listElt == oc_list_last(pathElements.list))
+        {
+            break;
+        }
+        oc_str8 name = elt->string;
+        if(!name.len
+           || !oc_str8_cmp(name, OC_STR8("."))
+           || !oc_str8_cmp(name, OC_STR8("..")))
+        {
+            return (false);
+        }
+        oc_str8_list_push(arena, &dirElements, name);
+    }
+
+    if(oc_list_empty(dirElements.list))
+    {
+        return (false);
+    }
+    *key = oc_path_join(arena, dirElements);
+
+    return (key->len <= OC_IO_DIR_CACHE_MAX_PATH);
+}
+
+oc_io_open_restrict_result oc_io_open_restrict(oc_file_table* table, oc_file_desc dirFd, oc_str8 path, oc_file_access accessRights, oc_file_open_flags openFlags)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_io_open_restrict_result result = { .error = OC_IO_ERR_UNKNOWN };
+    bool done = false;
+
+    oc_str8_list pathElements = oc_path_split(scratch.arena, path);
+
+    oc_str8 key = { 0 };
+    if(table && !oc_file_desc_is_nil(dirFd) && oc_io_dir_cache_key(scratch.arena, pathElements, &key))
+    {
+        oc_io_dir_cache_entry* entry = oc_io_dir_cache_find(table, dirFd, key);
+        if(!entry)
+        {
+            //NOTE: walk to the directory and cache it
+            oc_str8_list dirElements = oc_path_split(scratch.arena, key);
+            oc_io_open_restrict_result dir = oc_io_open_restrict_uncached(scratch.arena, dirFd, dirElements, OC_FILE_ACCESS_READ, 0);
+            if(dir.error == OC_IO_OK)
             {
-                //NOTE: check that we don't escape root dir
-                oc_file_status status;
-                context.error = oc_io_raw_fstat(context.fd, &status);
-                if(context.error)
-                {
-                    break;
-                }
-                else if(status.uid == context.rootUID)
+                oc_file_status status = { 0 };
+                if(oc_io_raw_fstat(dir.fd, &status) == OC_IO_OK && status.type == OC_FILE_DIRECTORY)
                 {
-                    context.error = OC_IO_ERR_WALKOUT;
-                    break;
+                    entry = oc_io_dir_cache_insert(table, dirFd, dir.rootUID, key, dir.fd);
                 }
-            }
-            else if(!oc_io_raw_file_exists_at(context.fd, name, OC_FILE_OPEN_SYMLINK))
-            {
-                //NOTE: if the file doesn't exists, but we're at the last element and OC_FILE_OPEN_CREATE
-                //      is set, we create the file. Otherwise it is a OC_IO_ERROR_NO_ENTRY error.
-                if(!atLastElement
-                   || !(openFlags & OC_FILE_OPEN_CREATE))
+                else
                 {
-                    context.error = OC_IO_ERR_NO_ENTRY;
-                    break;
+                    oc_io_raw_close(dir.fd);
                 }
             }
-            else
-            {
-                //NOTE: if the file exists, we check the type of file
-                oc_file_status status = { 0 };
-                context.error = oc_io_raw_fstat_at(context.fd, name, OC_FILE_OPEN_SYMLINK, &status);
-                if(context.error)
-                {
-                    break;
-                }
+        }
+
+        if(entry)
+        {
+            oc_str8_list lastElement = { 0 };
+            oc_str8_list_push(scratch.arena, &lastElement, oc_list_last_entry(pathElements.list, oc_str8_elt, listElt)->string);
 
-                if(status.type == OC_FILE_REGULAR)
+            oc_io_open_restrict_context context = {
+                .error = OC_IO_OK,
+                .rootUID = entry->rootUID,
+                .rootFd = dirFd,
+                .cachedFd = entry->fd,
+                .fd = entry->fd,
+            };
+            oc_io_open_restrict_walk(scratch.arena, &context, lastElement, accessRights, openFlags);
+
+            if(context.error == OC_IO_OK)
+            {
+                if(context.fd == entry->fd)
                 {
-                    if(!atLastElement)
+                    //NOTE: the last element resolved to the cached directory itself, so we need our own descriptor
+                    context.fd = oc_io_raw_open_at(entry->fd, OC_STR8("."), accessRights, 0);
+                    if(oc_file_desc_is_nil(context.fd))
                     {
-                        context.error = OC_IO_ERR_NOT_DIR;
-                        break;
+                        context.error = oc_io_raw_last_error();
                     }
                 }
-                else if(status.type == OC_FILE_SYMLINK)
-                {
-                    //TODO  - do we need a OC_FILE_OPEN_NO_FOLLOW that fails if last element is a symlink?
-                    //      - do we need a OC_FILE_OPEN_NO_SYMLINKS that fails if _any_ element is a symlink?
-
-                    if(!atLastElement
-                       || !(openFlags & OC_FILE_OPEN_SYMLINK))
-                    {
-                        oc_io_raw_read_link_result link = oc_io_raw_read_link_at(scratch.arena, context.fd, name);
-                        if(link.error)
-                        {
-                            context.error = link.error;
-                            break;
-                        }
-                        if(link.target.len == 0)
-                        {
-                            //NOTE: treat an empty target as a '.'
-                            link.target = OC_STR8(".");
-                        }
-                        else if(oc_path_is_absolute(link.target))
-                        {
-                            context.error = OC_IO_ERR_WALKOUT;
-                            break;
-                        }
-
-                        oc_str8_list linkElements = oc_path_split(scratch.arena, link.target);
+                result.error = context.error;
+                result.fd = context.fd;
+                done = (context.error == OC_IO_OK);
+            }
 
-                        if(!oc_list_empty(linkElements.list))
-                        {
-                            //NOTE: insert linkElements into pathElements after elt
-                            oc_list_elt* tmp = elt->listElt.next;
-                            elt->listElt.next = linkElements.list.first;
-                            linkElements.list.last->next = tmp;
-                            if(!tmp)
-                            {
-                                pathElements.list.last = linkElements.list.last;
-                            }
-                        }
-                        continue;
-                    }
-                }
-                else if(status.type != OC_FILE_DIRECTORY)
+            if(!done)
+            {
+                //NOTE: the entry may be stale, so redo a full walk to get an authoritative result
+                result = oc_io_open_restrict_uncached(scratch.arena, dirFd, pathElements, accessRights, openFlags);
+                if(result.error == OC_IO_OK)
                 {
-                    context.error = OC_IO_ERR_NOT_DIR;
-                    break;
+                    oc_io_dir_cache_remove(entry);
                 }
+                done = true;
             }
-
-            //NOTE: if we arrive here, we have no errors and the correct flags are set,
-            //      so we can enter the element
-            OC_DEBUG_ASSERT(context.error == OC_IO_OK);
-            oc_io_open_restrict_enter(&context, name, eltAccessRights, eltOpenFlags);
         }
     }
 
-    if(context.error && !oc_file_desc_is_nil(context.fd))
+    if(!done)
     {
-        if(context.fd != context.rootFd)
-        {
-            oc_io_raw_close(context.fd);
-        }
-        context.fd = oc_file_desc_nil();
+        result = oc_io_open_restrict_uncached(scratch.arena, dirFd, pathElements, accessRights, openFlags);
     }
 
-    oc_io_open_restrict_result result = {
-        .error = context.error,
-        .fd = context.fd
-    };
-
     oc_scratch_end(scratch);
     return (result);
 }
 
+//-----------------------------------------------------------------------
+// read-ahead
+//-----------------------------------------------------------------------
+
+void oc_io_read_ahead_sync(oc_file_slot* slot)
+{
+    oc_io_read_ahead* readAhead = &slot->readAhead;
+    if(readAhead->end > readAhead->pos)
+    {
+        oc_io_req seek = {
+            .op = OC_IO_SEEK,
+            .offset = -(i64)(readAhead->end - readAhead->pos),
+            .whence = OC_FILE_SEEK_CURRENT,
+        };
+        oc_io_seek(slot, &seek);
+    }
+    readAhead->pos = 0;
+    readAhead->end = 0;
+}
+
+void oc_io_read_ahead_enable(oc_file_slot* slot, bool enable)
+{
+    oc_io_read_ahead* readAhead = &slot->readAhead;
+    if(enable && !readAhead->buffer && slot->type == OC_FILE_REGULAR)
+    {
+        //NOTE: if the allocation fails, reads just aren't buffered
+        readAhead->buffer = malloc(OC_IO_READ_AHEAD_SIZE);
+        readAhead->pos = 0;
+        readAhead->end = 0;
+    }
+    else if(!enable && readAhead->buffer)
+    {
+        oc_io_read_ahead_sync(slot);
+        free(readAhead->buffer);
+        readAhead->buffer = 0;
+    }
+}
+
+oc_io_cmp oc_io_read_buffered(oc_file_slot* slot, oc_io_req* req)
+{
+    oc_io_read_ahead* readAhead = &slot->readAhead;
+    if(!readAhead->buffer)
+    {
+        return (oc_io_read(slot, req));
+    }
+
+    oc_io_cmp cmp = { 0 };
+
+    u64 count = oc_min(readAhead->end - readAhead->pos, req->size);
+    memcpy(req->buffer, readAhead->buffer + readAhead->pos, count);
+    readAhead->pos += count;
+
+    if(count < req->size)
+    {
+        //NOTE: the buffer is empty at this point. Reads at least as large as the buffer bypass it.
+        u64 remaining = req->size - count;
+        oc_io_req fill = *req;
+        oc_io_cmp fillCmp = { 0 };
+
+        if(remaining >= OC_IO_READ_AHEAD_SIZE)
+        {
+            fill.buffer = req->buffer + count;
+            fill.size = remaining;
+            fillCmp = oc_io_read(slot, &fill);
+            count += fillCmp.size;
+        }
+        else
+        {
+            fill.buffer = readAhead->buffer;
+            fill.size = OC_IO_READ_AHEAD_SIZE;
+            fillCmp = oc_io_read(slot, &fill);
+
+            u64 copySize = oc_min(fillCmp.size, remaining);
+            memcpy(req->buffer + count, readAhead->buffer, copySize);
+            readAhead->pos = copySize;
+            readAhead->end = fillCmp.size;
+            count += copySize;
+        }
+
+        //NOTE: a short read only reports an error if nothing was read, like an unbuffered read
+        if(!count)
+        {
+            cmp.error = fillCmp.error;
+        }
+    }
+    cmp.size = count;
+    return (cmp);
+}
+
+oc_io_cmp oc_io_seek_buffered(oc_file_slot* slot, oc_io_req* req)
+{
+    oc_io_read_ahead* readAhead = &slot->readAhead;
+    oc_io_cmp cmp = { 0 };
+
+    if(readAhead->end > readAhead->pos && req->whence == OC_FILE_SEEK_CURRENT && req->offset == 0)
+    {
+        //NOTE: position queries keep the buffer
+        cmp = oc_io_seek(slot, req);
+        if(cmp.error == OC_IO_OK)
+        {
+            cmp.offset -= readAhead->end - readAhead->pos;
+        }
+    }
+    else
+    {
+        oc_io_read_ahead_sync(slot);
+        cmp = oc_io_seek(slot, req);
+    }
+    return (cmp);
+}
+
+//-----------------------------------------------------------------------
+// write-behind
+//-----------------------------------------------------------------------
+
+oc_io_error oc_io_write_behind_flush(oc_file_slot* slot)
+{
+    oc_io_write_behind* writeBehind = &slot->writeBehind;
+    oc_io_error error = OC_IO_OK;
+
+    u64 offset = 0;
+    while(offset < writeBehind->size)
+    {
+        oc_io_req req = {
+            .op = OC_IO_WRITE,
+            .size = writeBehind->size - offset,
+            .buffer = writeBehind->buffer + offset,
+        };
+        oc_io_cmp cmp = oc_io_write(slot, &req);
+        if(cmp.error != OC_IO_OK)
+        {
+            error = cmp.error;
+            break;
+        }
+        else if(!cmp.size)
+        {
+            slot->error = OC_IO_ERR_UNKNOWN;
+            error = slot->error;
+            break;
+        }
+        offset += cmp.size;
+    }
+    writeBehind->size = 0;
+    return (error);
+}
+
+oc_io_cmp oc_io_write_buffered(oc_file_slot* slot, oc_io_req* req)
+{
+    oc_io_write_behind* writeBehind = &slot->writeBehind;
+    if(!writeBehind->buffer)
+    {
+        return (oc_io_write(slot, req));
+    }
+
+    oc_io_cmp cmp = { 0 };
+    if(writeBehind->size + req->size > writeBehind->cap)
+    {
+        cmp.error = oc_io_write_behind_flush(slot);
+        if(cmp.error != OC_IO_OK)
+        {
+            return (cmp);
+        }
+    }
+
+    if(req->size >= writeBehind->cap)
+    {
+        cmp = oc_io_write(slot, req);
+    }
+    else
+    {
+        memcpy(writeBehind->buffer + writeBehind->size, req->buffer, req->size);
+        writeBehind->size += req->size;
+        cmp.size = req->size;
+    }
+    return (cmp);
+}
+
+oc_io_cmp oc_io_set_write_buffer(oc_file_slot* slot, oc_io_req* req)
+{
+    oc_io_cmp cmp = { 0 };
+    oc_io_write_behind* writeBehind = &slot->writeBehind;
+
+    if(slot->type != OC_FILE_REGULAR)
+    {
+        cmp.error = OC_IO_ERR_ARG;
+        return (cmp);
+    }
+
+    u64 cap = oc_min(req->size, OC_IO_WRITE_BEHIND_MAX_SIZE);
+    if(cap != writeBehind->cap)
+    {
+        free(writeBehind->buffer);
+        *writeBehind = (oc_io_write_behind){ 0 };
+
+        if(cap)
+        {
+            writeBehind->buffer = malloc(cap);
+            if(writeBehind->buffer)
+            {
+                writeBehind->cap = cap;
+            }
+            else
+            {
+                cmp.error = OC_IO_ERR_MEM;
+            }
+        }
+    }
+    cmp.size = writeBehind->cap;
+    return (cmp);
+}
+
+oc_io_cmp oc_io_flush(oc_file_slot* slot, oc_io_req* req)
+{
+    oc_io_cmp cmp = { 0 };
+
+    if(req->sync > OC_FILE_SYNC_FULL)
+    {
+        cmp.error = OC_IO_ERR_ARG;
+    }
+    else if(req->sync != OC_FILE_SYNC_NONE && slot->type == OC_FILE_REGULAR)
+    {
+        oc_io_error error = oc_io_raw_sync(slot->fd, req->sync);
+        if(error != OC_IO_OK)
+        {
+            slot->error = error;
+            cmp.error = error;
+        }
+    }
+    return (cmp);
+}
+
+//-----------------------------------------------------------------------
+// directory watches
+//-----------------------------------------------------------------------
+
+static oc_io_watch_notify_proc oc_ioWatchNotify = 0;
+
+void oc_io_set_watch_notify(oc_io_watch_notify_proc proc)
+{
+    oc_ioWatchNotify = proc;
+}
+
+static u64 oc_io_file_change_record_size(oc_str8 path)
+{
+    return (oc_align_up_pow2(sizeof(oc_io_file_change) + path.len + 1, 8));
+}
+
+static void oc_io_file_change_write(char* at, u64 recordSize, oc_file_change_kind kind, oc_str8 path)
+{
+    oc_io_file_change* change = (oc_io_file_change*)at;
+    memset(change, 0, recordSize);
+    change->recordSize = recordSize;
+    change->pathLen = path.len;
+    change->kind = kind;
+    memcpy((char*)(change + 1), path.ptr, path.len);
+}
+
+void oc_io_watch_push(oc_io_watch* watch, oc_file_change_kind kind, oc_str8 path)
+{
+    u64 recordSize = oc_io_file_change_record_size(path);
+
+    oc_mutex_lock(watch->mutex);
+
+    bool notify = (watch->size == 0 && !watch->overflow);
+
+    if(kind == OC_FILE_CHANGE_OVERFLOW || watch->size + recordSize > OC_IO_WATCH_MAX_CHANGES_SIZE)
+    {
+        //NOTE: the app has to read the whole tree again, so the pending changes are useless
+        watch->size = 0;
+        watch->lastOffset = 0;
+        watch->overflow = true;
+    }
+    else if(!watch->overflow)
+    {
+        oc_io_file_change* last = (oc_io_file_change*)(watch->changes + watch->lastOffset);
+        if(watch->size
+           && last->kind == kind
+           && !oc_str8_cmp(oc_io_file_change_path(last), path))
+        {
+            //NOTE: editors often write a file in several steps, so merge repeats of the last change
+        }
+        else
+        {
+            if(watch->size + recordSize > watch->cap)
+            {
+                u64 cap = oc_max(oc_max(watch->cap * 2, watch->size + recordSize), 4 << 10);
+                char* changes = realloc(watch->changes, cap);
+                if(changes)
+                {
+                    watch->changes = changes;
+                    watch->cap = cap;
+                }
+            }
+            if(watch->size + recordSize > watch->cap)
+            {
+                watch->size = 0;
+                watch->lastOffset = 0;
+                watch->overflow = true;
+            }
+            else
+            {
+                oc_io_file_change_write(watch->changes + watch->size, recordSize, kind, path);
+                watch->lastOffset = watch->size;
+                watch->size += recordSize;
+            }
+        }
+    }
+
+    oc_mutex_unlock(watch->mutex);
+
+    oc_io_watch_notify_proc proc = oc_ioWatchNotify;
+    if(notify && proc)
+    {
+        proc(watch->handle, watch->window);
+    }
+}
+
+void oc_io_watch_stop(oc_file_slot* slot)
+{
+    oc_io_watch* watch = slot->watch;
+    if(watch)
+    {
+        oc_io_raw_watch_stop(watch);
+        oc_mutex_destroy(watch->mutex);
+        free(watch->changes);
+        free(watch);
+        slot->watch = 0;
+    }
+}
+
+oc_io_cmp oc_io_set_watch(oc_file_slot* slot, oc_io_req* req, oc_file_table* table)
+{
+    oc_io_cmp cmp = { 0 };
+
+    if(slot->type != OC_FILE_DIRECTORY)
+    {
+        cmp.error = OC_IO_ERR_NOT_DIR;
+        return (cmp);
+    }
+    if(req->watch & ~(OC_FILE_WATCH_DIRECTORY | OC_FILE_WATCH_RECURSIVE))
+    {
+        cmp.error = OC_IO_ERR_ARG;
+        return (cmp);
+    }
+
+    oc_io_watch_stop(slot);
+
+    if(req->watch != OC_FILE_WATCH_NONE)
+    {
+        oc_io_watch* watch = malloc(sizeof(oc_io_watch));
+        oc_mutex* mutex = oc_mutex_create();
+        if(!watch || !mutex)
+        {
+            free(watch);
+            if(mutex)
+            {
+                oc_mutex_destroy(mutex);
+            }
+            cmp.error = OC_IO_ERR_MEM;
+            return (cmp);
+        }
+        memset(watch, 0, sizeof(oc_io_watch));
+        watch->handle = oc_file_from_slot(table, slot);
+        watch->window = table->watchWindow;
+        watch->flags = req->watch;
+        watch->mutex = mutex;
+
+        oc_io_error error = oc_io_raw_watch_start(slot->fd, watch);
+        if(error != OC_IO_OK)
+        {
+            oc_mutex_destroy(watch->mutex);
+            free(watch);
+            slot->error = error;
+            cmp.error = error;
+        }
+        else
+        {
+            slot->watch = watch;
+        }
+    }
+    return (cmp);
+}
+
+oc_io_cmp oc_io_read_changes(oc_file_slot* slot, oc_io_req* req)
+{
+    oc_io_cmp cmp = { 0 };
+
+    oc_io_watch* watch = slot->watch;
+    if(!watch)
+    {
+        cmp.error = OC_IO_ERR_ARG;
+        return (cmp);
+    }
+
+    oc_mutex_lock(watch->mutex);
+
+    u64 offset = 0;
+    if(watch->overflow)
+    {
+        u64 recordSize = oc_io_file_change_record_size((oc_str8){ 0 });
+        if(recordSize <= req->size)
+        {
+            oc_io_file_change_write(req->buffer, recordSize, OC_FILE_CHANGE_OVERFLOW, (oc_str8){ 0 });
+            offset = recordSize;
+            watch->overflow = false;
+            cmp.result++;
+        }
+    }
+
+    u64 consumed = 0;
+    if(!watch->overflow)
+    {
+        while(consumed < watch->size)
+        {
+            oc_io_file_change* change = (oc_io_file_change*)(watch->changes + consumed);
+            if(offset + change->recordSize > req->size)
+            {
+                break;
+            }
+            memcpy(req->buffer + offset, change, change->recordSize);
+            offset += change->recordSize;
+            consumed += change->recordSize;
+            cmp.result++;
+        }
+    }
+
+    memmove(watch->changes, watch->changes + consumed, watch->size - consumed);
+    watch->size -= consumed;
+    watch->lastOffset = watch->size ? watch->lastOffset - consumed : 0;
+
+    if(cmp.result == 0 && (watch->size || watch->overflow))
+    {
+        //NOTE: the buffer is too small for the next change
+        cmp.error = OC_IO_ERR_ARG;
+    }
+
+    oc_mutex_unlock(watch->mutex);
+    return (cmp);
+}
+
+//-----------------------------------------------------------------------
+// file mappings
+//-----------------------------------------------------------------------
+
+oc_io_cmp oc_io_map_at_for_table(oc_file file, i64 offset, u64 size, char* buffer, oc_file_table* table)
+{
+    oc_io_cmp cmp = { 0 };
+
+    oc_file_status status = { 0 };
+    oc_io_req statReq = {
+        .op = OC_IO_FSTAT,
+        .handle = file,
+        .size = sizeof(oc_file_status),
+        .buffer = (char*)&status,
+    };
+    cmp = oc_io_wait_single_req_for_table(&statReq, table);
+    if(cmp.error != OC_IO_OK)
+    {
+        return (cmp);
+    }
+    if(offset < 0)
+    {
+        cmp.error = OC_IO_ERR_ARG;
+        return (cmp);
+    }
+    if((u64)offset >= status.size)
+    {
+        return (cmp);
+    }
+
+    //NOTE: clamp to the end of the file, so that no mapped page lies entirely past it. Touching such a page faults.
+    size = oc_min(size, status.size - offset);
+
+    //NOTE: only pages whose address and file offset line up on the mapping granularity can be mapped
+    u64 granularity = oc_io_map_granularity();
+    char* mapStart = (char*)oc_align_up_pow2((uintptr_t)buffer, granularity);
+    char* mapEnd = (char*)oc_align_down_pow2((uintptr_t)(buffer + size), granularity);
+    u64 mapOffset = offset + (mapStart - buffer);
+
+    oc_file_slot* slot = oc_file_slot_from_handle(table, file);
+    bool mapped = false;
+    if(slot
+       && !slot->memoryBacked
+       && status.type == OC_FILE_REGULAR
+       && mapStart < mapEnd
+       && (mapOffset & (granularity - 1)) == 0)
+    {
+        mapped = (oc_io_map_fixed(slot, mapOffset, mapEnd - mapStart, mapStart) == OC_IO_OK);
+    }
+    if(!mapped)
+    {
+        mapStart = mapEnd = buffer + size;
+    }
+
+    //NOTE: copy what couldn't be mapped
+    oc_io_req reqs[2] = {
+        {
+            .op = OC_IO_PREAD,
+            .handle = file,
+            .offset = offset,
+            .size = mapStart - buffer,
+            .buffer = buffer,
+        },
+        {
+            .op = OC_IO_PREAD,
+            .handle = file,
+            .offset = offset + (mapEnd - buffer),
+            .size = (buffer + size) - mapEnd,
+            .buffer = mapEnd,
+        },
+    };
+
+    cmp.size = 0;
+    for(int i = 0; i < 2; i++)
+    {
+        if(reqs[i].size)
+        {
+            oc_io_cmp readCmp = oc_io_wait_single_req_for_table(&reqs[i], table);
+            if(readCmp.error != OC_IO_OK || readCmp.size != reqs[i].size)
+            {
+                cmp.error = readCmp.error ? readCmp.error : OC_IO_ERR_UNKNOWN;
+                break;
+            }
+        }
+    }
+    if(cmp.error == OC_IO_OK)
+    {
+        cmp.size = size;
+    }
+    return (cmp);
+}
+
+//-----------------------------------------------------------------------
+// memory-backed files
+//-----------------------------------------------------------------------
+
+oc_io_cmp oc_io_open_memory_for_table(oc_str8 contents, oc_file_table* table)
+{
+    oc_io_cmp cmp = { 0 };
+
+    oc_file_slot* slot = oc_file_slot_alloc(table);
+    if(!slot)
+    {
+        cmp.error = OC_IO_ERR_MAX_FILES;
+    }
+    else
+    {
+        slot->fd = oc_file_desc_nil();
+        slot->type = OC_FILE_REGULAR;
+        slot->rights = OC_FILE_ACCESS_READ;
+        slot->memoryBacked = true;
+        slot->memory = contents;
+        cmp.handle = oc_file_from_slot(table, slot);
+    }
+    return (cmp);
+}
+
+oc_io_cmp oc_io_open_memory_source_for_table(oc_io_memory_source* source, oc_file_table* table)
+{
+    oc_io_cmp cmp = oc_io_open_memory_for_table((oc_str8){ 0 }, table);
+    if(cmp.error == OC_IO_OK)
+    {
+        oc_file_slot* slot = oc_file_slot_from_handle(table, cmp.handle);
+        slot->source = *source;
+    }
+    else if(source->close)
+    {
+        source->close(source->user);
+    }
+    return (cmp);
+}
+
+static u64 oc_io_memory_size(oc_file_slot* slot)
+{
+    return (slot->source.read ? slot->source.size : slot->memory.len);
+}
+
+static u64 oc_io_memory_copy(oc_file_slot* slot, u64 pos, char* buffer, u64 size, oc_io_error* error)
+{
+    u64 count = 0;
+    u64 fileSize = oc_io_memory_size(slot);
+    if(pos < fileSize)
+    {
+        count = oc_min(size, fileSize - pos);
+        if(slot->source.read)
+        {
+            count = slot->source.read(slot->source.user, pos, buffer, count, error);
+        }
+        else
+        {
+            memcpy(buffer, slot->memory.ptr + pos, count);
+        }
+    }
+    return (count);
+}
+
+oc_io_cmp oc_io_memory_req(oc_file_slot* slot, oc_io_req* req, oc_file_table* table)
+{
+    oc_io_cmp cmp = { 0 };
+
+    switch(req->op)
+    {
+        case OC_IO_CLOSE:
+            if(slot->source.close)
+            {
+                slot->source.close(slot->source.user);
+            }
+            oc_file_slot_recycle(table, slot);
+            break;
+
+        case OC_IO_FSTAT:
+        {
+            if(req->size < sizeof(oc_file_status))
+            {
+                cmp.error = OC_IO_ERR_ARG;
+            }
+            else
+            {
+                oc_file_status* status = (oc_file_status*)req->buffer;
+                memset(status, 0, sizeof(oc_file_status));
+                status->type = OC_FILE_REGULAR;
+                status->perm = OC_FILE_OWNER_READ | OC_FILE_GROUP_READ | OC_FILE_OTHER_READ;
+                status->size = oc_io_memory_size(slot);
+            }
+        }
+        break;
+
+        case OC_IO_SEEK:
+        {
+            i64 base = 0;
+            if(req->whence == OC_FILE_SEEK_CURRENT)
+            {
+                base = slot->memoryPos;
+            }
+            else if(req->whence == OC_FILE_SEEK_END)
+            {
+                base = oc_io_memory_size(slot);
+            }
+
+            i64 pos = base + req->offset;
+            if(pos < 0)
+            {
+                slot->error = OC_IO_ERR_ARG;
+                cmp.error = slot->error;
+            }
+            else
+            {
+                slot->memoryPos = pos;
+                cmp.offset = pos;
+            }
+        }
+        break;
+
+        case OC_IO_READ:
+            cmp.size = oc_io_memory_copy(slot, slot->memoryPos, req->buffer, req->size, &cmp.error);
+            slot->memoryPos += cmp.size;
+            break;
+
+        case OC_IO_PREAD:
+            if(req->offset < 0)
+            {
+                cmp.error = OC_IO_ERR_ARG;
+            }
+            else
+            {
+                cmp.size = oc_io_memory_copy(slot, req->offset, req->buffer, req->size, &cmp.error);
+            }
+            break;
+
+        case OC_IO_PREADV:
+        {
+            if(req->offset < 0)
+            {
+                cmp.error = OC_IO_ERR_ARG;
+                break;
+            }
+            oc_io_vec* vecs = (oc_io_vec*)req->buffer;
+            u64 pos = req->offset;
+            for(u64 i = 0; i < req->size; i++)
+            {
+                u64 count = oc_io_memory_copy(slot, pos, vecs[i].buffer, vecs[i].size, &cmp.error);
+                cmp.size += count;
+                pos += count;
+                if(count < vecs[i].size || cmp.error != OC_IO_OK)
+                {
+                    break;
+                }
+            }
+        }
+        break;
+
+        case OC_IO_WRITE:
+        case OC_IO_PWRITE:
+        case OC_IO_PWRITEV:
+        case OC_IO_WRITE_BUFFER:
+            slot->error = OC_IO_ERR_PERM;
+            cmp.error = slot->error;
+            break;
+
+        case OC_IO_FLUSH:
+            //NOTE: there is never anything to write
+            break;
+
+        case OC_IO_WATCH:
+        case OC_IO_READ_CHANGES:
+        case OC_IO_READDIR:
+            cmp.error = OC_IO_ERR_NOT_DIR;
+            break;
+
+        case OC_IO_ADVISE:
+            //NOTE: contents are already in memory, so there's nothing to prefetch
+            if(req->offset < 0 || req->advice > OC_FILE_ADVICE_DONTNEED)
+            {
+                cmp.error = OC_IO_ERR_ARG;
+            }
+            break;
+
+        case OC_OC_IO_ERROR:
+            cmp.result = slot->error;
+            break;
+
+        default:
+            slot->error = OC_IO_ERR_OP;
+            cmp.error = slot->error;
+            break;
+    }
+    return (cmp);
+}
+
 oc_io_cmp oc_io_open_at(oc_file_slot* atSlot, oc_io_req* req, oc_file_table* table)
 {
     oc_io_cmp cmp = { 0 };
@@ -310,7 +1410,7 @@ oc_io_cmp oc_io_open_at(oc_file_slot* atSlot, oc_io_req* req, oc_file_table* tab
 
                 if(req->open.flags & OC_FILE_OPEN_RESTRICT)
                 {
-                    oc_io_open_restrict_result res = oc_io_open_restrict(dirFd, path, slot->rights, req->open.flags);
+                    oc_io_open_restrict_result res = oc_io_open_restrict(table, dirFd, path, slot->rights, req->open.flags);
                     slot->error = res.error;
                     slot->fd = res.fd;
                 }
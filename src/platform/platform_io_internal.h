@@ -10,6 +10,7 @@
 #include "platform.h"
 #include "platform_io.h"
 #include "platform_io_dialog.h"
+#include "platform_thread.h"
 
 #if OC_PLATFORM_MACOS || PLATFORM_LINUX
 typedef int oc_file_desc;
@@ -21,8 +22,57 @@ typedef int oc_file_desc;
 typedef HANDLE oc_file_desc;
 #endif
 
+//NOTE: a memory source produces the contents of a memory-backed file on demand, e.g. by decoding them.
+//      read() copies up to size bytes at offset into buffer and returns the number of bytes copied, or
+//      sets *error and returns 0. close() is called when the file is closed, and may be null.
+typedef struct oc_io_memory_source
+{
+    u64 size;
+    void* user;
+    u64 (*read)(void* user, u64 offset, char* buffer, u64 size, oc_io_error* error);
+    void (*close)(void* user);
+} oc_io_memory_source;
+
+//NOTE: host-side buffer for small sequential reads, enabled by OC_FILE_ADVICE_SEQUENTIAL. The bytes in
+//      [pos, end) were read from the descriptor but not returned yet, so the descriptor's position is ahead
+//      of the file position by end - pos.
+typedef struct oc_io_read_ahead
+{
+    char* buffer;
+    u64 pos;
+    u64 end;
+} oc_io_read_ahead;
+
+//NOTE: host-side buffer for small writes at the file position, enabled by OC_IO_WRITE_BUFFER. The size bytes in the
+//      buffer go after the descriptor's position.
+typedef struct oc_io_write_behind
+{
+    char* buffer;
+    u64 cap;
+    u64 size;
+} oc_io_write_behind;
+
+//NOTE: state of a directory watch. The platform's watcher pushes changes with oc_io_watch_push() from its own thread,
+//      so changes, size and overflow are protected by mutex. changes holds packed oc_io_file_change records.
+typedef struct oc_io_watch
+{
+    oc_file handle;
+    u64 window;
+    oc_file_watch_flags flags;
+
+    oc_mutex* mutex;
+    char* changes;
+    u64 size;
+    u64 cap;
+    u64 lastOffset;
+    bool overflow;
+
+    void* native;
+} oc_io_watch;
+
 typedef struct oc_file_slot
 {
+    u32 index;
     u32 generation;
     oc_io_error error;
     bool fatal;
@@ -32,18 +82,69 @@ typedef struct oc_file_slot
     oc_file_access rights;
     oc_file_desc fd;
 
+    //NOTE: platform directory enumeration state, created by the first OC_IO_READDIR on the file
+    void* dirStream;
+    u64 dirIndex;
+
+    oc_io_read_ahead readAhead;
+    oc_io_write_behind writeBehind;
+    oc_io_watch* watch;
+
+    //NOTE: memory-backed files are read-only views of a buffer owned by the caller, or of a memory source,
+    //      and have no descriptor
+    bool memoryBacked;
+    oc_str8 memory;
+    oc_io_memory_source source;
+    u64 memoryPos;
+
 } oc_file_slot;
 
 enum
 {
-    OC_IO_MAX_FILE_SLOTS = 256,
+    OC_IO_READ_AHEAD_SIZE = 64 << 10,
+    OC_IO_WRITE_BEHIND_MAX_SIZE = 16 << 20,
+    OC_IO_WATCH_MAX_CHANGES_SIZE = 1 << 20,
+
+    //NOTE: slots are allocated in pages as the table grows. Pages never move, so slot pointers stay valid.
+    OC_IO_FILE_SLOT_PAGE_SIZE = 256,
+    OC_IO_MAX_FILE_SLOT_PAGES = 64,
+    OC_IO_MAX_FILE_SLOTS = OC_IO_FILE_SLOT_PAGE_SIZE * OC_IO_MAX_FILE_SLOT_PAGES,
+    OC_IO_DIR_CACHE_SIZE = 64,
+    OC_IO_DIR_CACHE_MAX_PATH = 256,
 };
 
+//NOTE: directories already validated by a restricted open, keyed by the root they were opened from and
+//      their path relative to that root.
+typedef struct oc_io_dir_cache_entry
+{
+    bool used;
+    u64 lastUse;
+
+    oc_file_desc rootFd;
+    u64 rootUID;
+    oc_file_desc fd;
+
+    u32 pathLen;
+    char path[OC_IO_DIR_CACHE_MAX_PATH];
+
+} oc_io_dir_cache_entry;
+
+typedef struct oc_io_dir_cache
+{
+    u64 useCount;
+    oc_io_dir_cache_entry entries[OC_IO_DIR_CACHE_SIZE];
+} oc_io_dir_cache;
+
 typedef struct oc_file_table
 {
-    oc_file_slot slots[OC_IO_MAX_FILE_SLOTS];
+    oc_file_slot* pages[OC_IO_MAX_FILE_SLOT_PAGES];
     u32 nextSlot;
     oc_list freeList;
+
+    oc_io_dir_cache dirCache;
+
+    //NOTE: window of the OC_EVENT_FILE_CHANGE events queued by the table's watches, 0 for all windows
+    u64 watchWindow;
 } oc_file_table;
 
 ORCA_API oc_file_table* oc_file_table_get_global();
@@ -52,8 +153,76 @@ oc_file_slot* oc_file_slot_alloc(oc_file_table* table);
 void oc_file_slot_recycle(oc_file_table* table, oc_file_slot* slot);
 oc_file oc_file_from_slot(oc_file_table* table, oc_file_slot* slot);
 oc_file_slot* oc_file_slot_from_handle(oc_file_table* table, oc_file handle);
+ORCA_API void oc_file_table_close_all(oc_file_table* table);
 
 ORCA_API oc_io_cmp oc_io_wait_single_req_for_table(oc_io_req* req, oc_file_table* table);
+ORCA_API void oc_io_wait_reqs_for_table(u32 count, oc_io_req* reqs, oc_io_cmp* cmps, oc_file_table* table);
+
+//NOTE: per-platform primitives used by the read-ahead and write-behind buffers
+oc_io_cmp oc_io_read(oc_file_slot* slot, oc_io_req* req);
+oc_io_cmp oc_io_write(oc_file_slot* slot, oc_io_req* req);
+oc_io_cmp oc_io_seek(oc_file_slot* slot, oc_io_req* req);
+
+//NOTE: read-ahead wrappers. oc_io_read_ahead_sync() gives the buffered bytes back to the descriptor, and
+//      must be called before requests that use or move the descriptor's position.
+oc_io_cmp oc_io_read_buffered(oc_file_slot* slot, oc_io_req* req);
+oc_io_cmp oc_io_seek_buffered(oc_file_slot* slot, oc_io_req* req);
+void oc_io_read_ahead_sync(oc_file_slot* slot);
+void oc_io_read_ahead_enable(oc_file_slot* slot, bool enable);
+
+//NOTE: write-behind wrappers. oc_io_write_behind_flush() writes the buffered bytes, and must be called before requests
+//      other than OC_IO_WRITE. oc_io_set_write_buffer() and oc_io_flush() implement OC_IO_WRITE_BUFFER and OC_IO_FLUSH
+//      once the buffer is flushed.
+oc_io_cmp oc_io_write_buffered(oc_file_slot* slot, oc_io_req* req);
+oc_io_error oc_io_write_behind_flush(oc_file_slot* slot);
+oc_io_cmp oc_io_set_write_buffer(oc_file_slot* slot, oc_io_req* req);
+oc_io_cmp oc_io_flush(oc_file_slot* slot, oc_io_req* req);
+
+//NOTE: directory watches. oc_io_set_watch() and oc_io_read_changes() implement OC_IO_WATCH and OC_IO_READ_CHANGES, and
+//      oc_io_watch_stop() is called when the slot is recycled. Platforms implement oc_io_raw_watch_start(), which
+//      watches the directory fd according to watch->flags and pushes changes from any thread until
+//      oc_io_raw_watch_stop() returns.
+oc_io_cmp oc_io_set_watch(oc_file_slot* slot, oc_io_req* req, oc_file_table* table);
+oc_io_cmp oc_io_read_changes(oc_file_slot* slot, oc_io_req* req);
+void oc_io_watch_stop(oc_file_slot* slot);
+void oc_io_watch_push(oc_io_watch* watch, oc_file_change_kind kind, oc_str8 path);
+oc_io_error oc_io_raw_watch_start(oc_file_desc fd, oc_io_watch* watch);
+void oc_io_raw_watch_stop(oc_io_watch* watch);
+
+//NOTE: called from a watcher thread when changes become pending on dir. The app layer sets it to queue an
+//      OC_EVENT_FILE_CHANGE event, so that the platform layer doesn't depend on it.
+typedef void (*oc_io_watch_notify_proc)(oc_file dir, u64 window);
+ORCA_API void oc_io_set_watch_notify(oc_io_watch_notify_proc proc);
+
+//NOTE: per-platform primitives for mapping file pages at a fixed address. oc_io_map_fixed() replaces the pages in
+//      [addr, addr + size) with a private mapping of the file at offset, and returns OC_IO_ERR_OP where that isn't
+//      supported. addr, offset and size must be multiples of oc_io_map_granularity(). oc_io_unmap_fixed() puts zeroed
+//      read-write pages back in place of a mapping.
+u64 oc_io_map_granularity(void);
+oc_io_error oc_io_map_fixed(oc_file_slot* slot, u64 offset, u64 size, void* addr);
+void oc_io_unmap_fixed(void* addr, u64 size);
+
+//NOTE: makes [offset, offset + size) of file readable at buffer, clamped to the end of the file. Pages that line up
+//      with the file are mapped instead of copied, the rest is read. The completion's size is the number of bytes
+//      made available. buffer must stay mapped read-write memory, and the file must not shrink while it is mapped.
+ORCA_API oc_io_cmp oc_io_map_at_for_table(oc_file file, i64 offset, u64 size, char* buffer, oc_file_table* table);
+
+//NOTE: opens a read-only file that serves reads from contents, which must stay valid until the file is closed.
+ORCA_API oc_io_cmp oc_io_open_memory_for_table(oc_str8 contents, oc_file_table* table);
+
+//NOTE: opens a read-only file that serves reads from source. If the open fails, source->close is called.
+ORCA_API oc_io_cmp oc_io_open_memory_source_for_table(oc_io_memory_source* source, oc_file_table* table);
+oc_io_cmp oc_io_memory_req(oc_file_slot* slot, oc_io_req* req, oc_file_table* table);
+
+typedef struct oc_io_queue oc_io_queue;
+
+ORCA_API oc_io_queue* oc_io_queue_create(oc_file_table* table);
+ORCA_API void oc_io_queue_destroy(oc_io_queue* queue);
+ORCA_API void oc_io_queue_lock_table(oc_io_queue* queue);
+ORCA_API void oc_io_queue_unlock_table(oc_io_queue* queue);
+ORCA_API oc_io_req_id oc_io_queue_submit(oc_io_queue* queue, oc_io_req* req);
+ORCA_API oc_io_req_id oc_io_queue_submit_completion(oc_io_queue* queue, oc_io_cmp* cmp);
+ORCA_API u32 oc_io_queue_wait(oc_io_queue* queue, u32 max, oc_io_cmp* cmps, f64 timeout);
 
 ORCA_API oc_file oc_file_open_with_request_for_table(oc_str8 path, oc_file_access rights, oc_file_open_flags flags, oc_file_table* table);
 
@@ -87,6 +256,7 @@ oc_io_error oc_io_raw_last_error();
 bool oc_io_raw_file_exists_at(oc_file_desc dirFd, oc_str8 path, oc_file_open_flags openFlags);
 oc_io_error oc_io_raw_fstat(oc_file_desc fd, oc_file_status* status);
 oc_io_error oc_io_raw_fstat_at(oc_file_desc dirFd, oc_str8 path, oc_file_open_flags openFlags, oc_file_status* status);
+oc_io_error oc_io_raw_sync(oc_file_desc fd, oc_file_sync sync);
 
 typedef struct oc_io_raw_read_link_result
 {
@@ -95,3 +265,5 @@ typedef struct oc_io_raw_read_link_result
 } oc_io_raw_read_link_result;
 
 oc_io_raw_read_link_result oc_io_raw_read_link_at(oc_arena* arena, oc_file_desc dirFd, oc_str8 path);
+
+bool oc_io_dir_entry_push(oc_io_req* req, u64* offset, oc_str8 name, oc_file_type type, u64 size, oc_datestamp modificationDate);
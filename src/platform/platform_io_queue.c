@@ -0,0 +1,252 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include "platform/platform_io_internal.h"
+#include "platform/platform_clock.h"
+#include "platform/platform_thread.h"
+
+//-----------------------------------------------------------------------
+// Asynchronous io queue
+//-----------------------------------------------------------------------
+/*NOTE:
+    Requests submitted to a queue are executed in submission order by a single worker thread, using the
+    same synchronous primitives as oc_io_wait_single_req_for_table(). Executing them in order keeps the
+    semantics of requests that depend on the file position (e.g. a seek followed by a read).
+
+    The worker holds the table lock while it executes a request, so code that accesses the queue's file
+    table synchronously must do so between oc_io_queue_lock_table() and oc_io_queue_unlock_table().
+*/
+
+typedef struct oc_io_queue_entry
+{
+    oc_list_elt listElt;
+    oc_io_req req;
+    oc_io_cmp cmp;
+    oc_io_vec* vecs; // copy of the vector array of vectored requests, owned by the entry
+    bool completed;  // the completion was provided at submission, and the request is not executed
+} oc_io_queue_entry;
+
+typedef struct oc_io_queue
+{
+    oc_file_table* table;
+    oc_arena arena;
+
+    oc_mutex* mutex;
+    oc_condition* submitCondition;
+    oc_condition* completeCondition;
+    oc_mutex* tableMutex;
+
+    oc_list freeList;
+    oc_list pending;
+    oc_list completed;
+
+    oc_io_req_id nextId;
+    u64 outstanding; // requests submitted but not yet returned by oc_io_queue_wait()
+    bool quit;
+
+    oc_thread* worker;
+
+} oc_io_queue;
+
+static i32 oc_io_queue_worker(void* user)
+{
+    oc_io_queue* queue = (oc_io_queue*)user;
+
+    oc_mutex_lock(queue->mutex);
+    while(1)
+    {
+        while(!queue->quit && oc_list_empty(queue->pending))
+        {
+            oc_condition_wait(queue->submitCondition, queue->mutex);
+        }
+        if(queue->quit)
+        {
+            break;
+        }
+        oc_io_queue_entry* entry = oc_list_pop_front_entry(&queue->pending, oc_io_queue_entry, listElt);
+        oc_mutex_unlock(queue->mutex);
+
+        if(!entry->completed)
+        {
+            oc_mutex_lock(queue->tableMutex);
+            entry->cmp = oc_io_wait_single_req_for_table(&entry->req, queue->table);
+            oc_mutex_unlock(queue->tableMutex);
+        }
+        entry->cmp.id = entry->req.id;
+
+        if(entry->vecs)
+        {
+            free(entry->vecs);
+            entry->vecs = 0;
+        }
+
+        oc_mutex_lock(queue->mutex);
+        oc_list_push_back(&queue->completed, &entry->listElt);
+        oc_condition_broadcast(queue->completeCondition);
+    }
+    oc_mutex_unlock(queue->mutex);
+    return (0);
+}
+
+oc_io_queue* oc_io_queue_create(oc_file_table* table)
+{
+    oc_arena arena = { 0 };
+    oc_arena_init(&arena);
+
+    oc_io_queue* queue = oc_arena_push_type(&arena, oc_io_queue);
+    memset(queue, 0, sizeof(oc_io_queue));
+
+    queue->arena = arena;
+    queue->table = table;
+    queue->mutex = oc_mutex_create();
+    queue->tableMutex = oc_mutex_create();
+    queue->submitCondition = oc_condition_create();
+    queue->completeCondition = oc_condition_create();
+    queue->nextId = 1;
+
+    oc_thread_options threadOptions = {
+        .name = OC_STR8("io queue"),
+        .priority = OC_THREAD_PRIORITY_UTILITY,
+    };
+    queue->worker = oc_thread_create_with_options(oc_io_queue_worker, queue, &threadOptions);
+
+    return (queue);
+}
+
+void oc_io_queue_destroy(oc_io_queue* queue)
+{
+    //NOTE: the request being executed, if any, finishes before the worker exits. Pending requests are dropped.
+    oc_mutex_lock(queue->mutex);
+    queue->quit = true;
+    oc_condition_signal(queue->submitCondition);
+    oc_mutex_unlock(queue->mutex);
+
+    oc_thread_join(queue->worker, 0);
+
+    oc_list_for(queue->pending, entry, oc_io_queue_entry, listElt)
+    {
+        if(entry->vecs)
+        {
+            free(entry->vecs);
+        }
+    }
+
+    oc_condition_destroy(queue->completeCondition);
+    oc_condition_destroy(queue->submitCondition);
+    oc_mutex_destroy(queue->tableMutex);
+    oc_mutex_destroy(queue->mutex);
+
+    //NOTE: copy the arena out of the queue, since the queue itself is allocated from it
+    oc_arena arena = queue->arena;
+    oc_arena_cleanup(&arena);
+}
+
+void oc_io_queue_lock_table(oc_io_queue* queue)
+{
+    oc_mutex_lock(queue->tableMutex);
+}
+
+void oc_io_queue_unlock_table(oc_io_queue* queue)
+{
+    oc_mutex_unlock(queue->tableMutex);
+}
+
+static oc_io_req_id oc_io_queue_push(oc_io_queue* queue, oc_io_req* req, oc_io_cmp* cmp)
+{
+    oc_mutex_lock(queue->mutex);
+
+    oc_io_queue_entry* entry = oc_list_pop_front_entry(&queue->freeList, oc_io_queue_entry, listElt);
+    if(!entry)
+    {
+        entry = oc_arena_push_type(&queue->arena, oc_io_queue_entry);
+    }
+    memset(entry, 0, sizeof(oc_io_queue_entry));
+
+    if(req)
+    {
+        entry->req = *req;
+
+        //NOTE: the vector array is copied, so that callers can submit vectored requests from temporary memory.
+        //      The buffers it points to must still stay valid until completion.
+        if((req->op == OC_IO_PREADV || req->op == OC_IO_PWRITEV) && req->size)
+        {
+            entry->vecs = malloc(req->size * sizeof(oc_io_vec));
+            if(entry->vecs)
+            {
+                memcpy(entry->vecs, req->buffer, req->size * sizeof(oc_io_vec));
+                entry->req.buffer = (char*)entry->vecs;
+            }
+            else
+            {
+                entry->completed = true;
+                entry->cmp.error = OC_IO_ERR_MEM;
+            }
+        }
+    }
+    if(cmp)
+    {
+        entry->completed = true;
+        entry->cmp = *cmp;
+    }
+    entry->req.id = queue->nextId;
+    queue->nextId++;
+    queue->outstanding++;
+
+    oc_list_push_back(&queue->pending, &entry->listElt);
+    oc_condition_signal(queue->submitCondition);
+
+    oc_mutex_unlock(queue->mutex);
+
+    return (entry->req.id);
+}
+
+oc_io_req_id oc_io_queue_submit(oc_io_queue* queue, oc_io_req* req)
+{
+    return (oc_io_queue_push(queue, req, 0));
+}
+
+oc_io_req_id oc_io_queue_submit_completion(oc_io_queue* queue, oc_io_cmp* cmp)
+{
+    //NOTE: this posts a request that completes with the given completion, in order, without being executed.
+    //      This lets callers report requests they rejected or served themselves through the normal completion path.
+    return (oc_io_queue_push(queue, 0, cmp));
+}
+
+u32 oc_io_queue_wait(oc_io_queue* queue, u32 max, oc_io_cmp* cmps, f64 timeout)
+{
+    u32 count = 0;
+
+    oc_mutex_lock(queue->mutex);
+
+    //NOTE: don't wait if there's nothing in flight, since no completion can arrive
+    if(max && timeout > 0 && queue->outstanding)
+    {
+        f64 deadline = oc_clock_time(OC_CLOCK_MONOTONIC) + timeout;
+        while(oc_list_empty(queue->completed))
+        {
+            f64 remaining = deadline - oc_clock_time(OC_CLOCK_MONOTONIC);
+            if(remaining <= 0)
+            {
+                break;
+            }
+            oc_condition_timedwait(queue->completeCondition, queue->mutex, remaining);
+        }
+    }
+
+    while(count < max && !oc_list_empty(queue->completed))
+    {
+        oc_io_queue_entry* entry = oc_list_pop_front_entry(&queue->completed, oc_io_queue_entry, listElt);
+        cmps[count] = entry->cmp;
+        count++;
+        queue->outstanding--;
+        oc_list_push_front(&queue->freeList, &entry->listElt);
+    }
+
+    oc_mutex_unlock(queue->mutex);
+
+    return (count);
+}
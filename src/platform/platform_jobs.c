@@ -0,0 +1,291 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include "platform_thread.h"
+#include "platform_debug.h"
+
+enum
+{
+    OC_JOB_QUEUE_CAP = 1024, // power of two
+    OC_JOB_MAX_WORKERS = 63,
+    OC_JOB_SHARED_QUEUE = OC_JOB_MAX_WORKERS, // index of the queue of jobs submitted from other threads
+};
+
+typedef struct oc_job
+{
+    oc_job_proc proc;
+    oc_job_range_proc rangeProc;
+    void* user;
+    u64 start;
+    u64 end;
+    oc_job_counter* counter;
+} oc_job;
+
+//NOTE: the owner pushes and pops at the tail, thieves take from the head. Jobs are small and short-lived,
+//      so a ticket lock is enough to protect each queue.
+typedef struct oc_job_queue
+{
+    oc_ticket lock;
+    u64 head;
+    u64 tail;
+    oc_job jobs[OC_JOB_QUEUE_CAP];
+} oc_job_queue;
+
+typedef struct oc_job_system
+{
+    _Atomic(u32) initState; // 0: not started, 1: starting, 2: running
+    u32 workerCount;
+    oc_thread* workers[OC_JOB_MAX_WORKERS];
+    oc_job_queue queues[OC_JOB_MAX_WORKERS + 1];
+
+    //NOTE: idle workers and waiters sleep on condition until jobs are queued or a counter completes
+    oc_mutex* mutex;
+    oc_condition* condition;
+    _Atomic(u64) queuedCount;
+} oc_job_system;
+
+static oc_job_system oc_jobSystem = { 0 };
+static oc_thread_local i32 oc_jobWorkerIndex = -1;
+
+static bool oc_job_queue_push(oc_job_queue* queue, oc_job* job)
+{
+    bool pushed = false;
+    oc_ticket_lock(&queue->lock);
+    if(queue->tail - queue->head < OC_JOB_QUEUE_CAP)
+    {
+        queue->jobs[queue->tail & (OC_JOB_QUEUE_CAP - 1)] = *job;
+        queue->tail++;
+        pushed = true;
+    }
+    oc_ticket_unlock(&queue->lock);
+    return (pushed);
+}
+
+static bool oc_job_queue_pop_tail(oc_job_queue* queue, oc_job* job)
+{
+    bool popped = false;
+    oc_ticket_lock(&queue->lock);
+    if(queue->tail > queue->head)
+    {
+        queue->tail--;
+        *job = queue->jobs[queue->tail & (OC_JOB_QUEUE_CAP - 1)];
+        popped = true;
+    }
+    oc_ticket_unlock(&queue->lock);
+    return (popped);
+}
+
+static bool oc_job_queue_pop_head(oc_job_queue* queue, oc_job* job)
+{
+    bool popped = false;
+    oc_ticket_lock(&queue->lock);
+    if(queue->tail > queue->head)
+    {
+        *job = queue->jobs[queue->head & (OC_JOB_QUEUE_CAP - 1)];
+        queue->head++;
+        popped = true;
+    }
+    oc_ticket_unlock(&queue->lock);
+    return (popped);
+}
+
+static bool oc_job_find(oc_job_system* system, oc_job* job)
+{
+    if(atomic_load_explicit(&system->queuedCount, memory_order_acquire) == 0)
+    {
+        return (false);
+    }
+
+    //NOTE: take our own most recent job first, since its data is likely still in cache. Then take the oldest
+    //      shared job, and finally steal the oldest job of another worker.
+    bool found = false;
+    i32 self = oc_jobWorkerIndex;
+    if(self >= 0)
+    {
+        found = oc_job_queue_pop_tail(&system->queues[self], job);
+    }
+    if(!found)
+    {
+        found = oc_job_queue_pop_head(&system->queues[OC_JOB_SHARED_QUEUE], job);
+    }
+    for(u32 i = 1; !found && i <= system->workerCount; i++)
+    {
+        u32 victim = (u32)(self + i) % system->workerCount;
+        if((i32)victim != self)
+        {
+            found = oc_job_queue_pop_head(&system->queues[victim], job);
+        }
+    }
+    if(found)
+    {
+        atomic_fetch_sub_explicit(&system->queuedCount, 1, memory_order_relaxed);
+    }
+    return (found);
+}
+
+static void oc_job_run(oc_job_system* system, oc_job* job)
+{
+    if(job->rangeProc)
+    {
+        job->rangeProc(job->user, job->start, job->end);
+    }
+    else
+    {
+        job->proc(job->user);
+    }
+
+    if(job->counter && atomic_fetch_sub_explicit(&job->counter->pending, 1, memory_order_acq_rel) == 1)
+    {
+        oc_mutex_lock(system->mutex);
+        oc_condition_broadcast(system->condition);
+        oc_mutex_unlock(system->mutex);
+    }
+}
+
+static i32 oc_job_worker(void* user)
+{
+    oc_job_system* system = &oc_jobSystem;
+    oc_jobWorkerIndex = (i32)(uintptr_t)user;
+
+    while(1)
+    {
+        oc_job job;
+        if(oc_job_find(system, &job))
+        {
+            oc_job_run(system, &job);
+        }
+        else
+        {
+            oc_mutex_lock(system->mutex);
+            if(atomic_load_explicit(&system->queuedCount, memory_order_acquire) == 0)
+            {
+                oc_condition_wait(system->condition, system->mutex);
+            }
+            oc_mutex_unlock(system->mutex);
+        }
+    }
+    return (0);
+}
+
+static oc_job_system* oc_job_system_get(void)
+{
+    oc_job_system* system = &oc_jobSystem;
+
+    u32 expected = 0;
+    if(atomic_compare_exchange_strong(&system->initState, &expected, 1))
+    {
+        system->mutex = oc_mutex_create();
+        system->condition = oc_condition_create();
+
+        u32 cpuCount = oc_cpu_count();
+        system->workerCount = oc_clamp(cpuCount > 1 ? cpuCount - 1 : 1, 1, OC_JOB_MAX_WORKERS);
+
+        for(u32 i = 0; i < system->workerCount; i++)
+        {
+            system->workers[i] = oc_thread_create_with_name(oc_job_worker, (void*)(uintptr_t)i, OC_STR8("job worker"));
+        }
+        atomic_store(&system->initState, 2);
+    }
+    else
+    {
+        while(atomic_load(&system->initState) != 2)
+            ; //spin
+    }
+    return (system);
+}
+
+static void oc_job_push(oc_job_system* system, oc_job* job)
+{
+    if(job->counter)
+    {
+        atomic_fetch_add_explicit(&job->counter->pending, 1, memory_order_relaxed);
+    }
+
+    //NOTE: counts are incremented before the job is visible to other threads, so that they can't drop below zero
+    i32 self = oc_jobWorkerIndex;
+    oc_job_queue* queue = &system->queues[self >= 0 ? self : OC_JOB_SHARED_QUEUE];
+
+    atomic_fetch_add_explicit(&system->queuedCount, 1, memory_order_release);
+    if(!oc_job_queue_push(queue, job))
+    {
+        //NOTE: the queue is full, run the job right away
+        atomic_fetch_sub_explicit(&system->queuedCount, 1, memory_order_relaxed);
+        oc_job_run(system, job);
+    }
+}
+
+void oc_job_submit(oc_job_proc proc, void* user, oc_job_counter* counter)
+{
+    oc_job_system* system = oc_job_system_get();
+
+    oc_job job = {
+        .proc = proc,
+        .user = user,
+        .counter = counter,
+    };
+    oc_job_push(system, &job);
+
+    oc_mutex_lock(system->mutex);
+    oc_condition_signal(system->condition);
+    oc_mutex_unlock(system->mutex);
+}
+
+void oc_job_parallel_for(u64 count, u64 grain, oc_job_range_proc proc, void* user, oc_job_counter* counter)
+{
+    oc_job_system* system = oc_job_system_get();
+
+    if(grain == 0)
+    {
+        //NOTE: a few chunks per thread, so that stealing can even out chunks that take longer
+        grain = oc_max(1, count / (4 * (system->workerCount + 1)));
+    }
+
+    for(u64 start = 0; start < count; start += grain)
+    {
+        oc_job job = {
+            .rangeProc = proc,
+            .user = user,
+            .start = start,
+            .end = oc_min(start + grain, count),
+            .counter = counter,
+        };
+        oc_job_push(system, &job);
+    }
+
+    oc_mutex_lock(system->mutex);
+    oc_condition_broadcast(system->condition);
+    oc_mutex_unlock(system->mutex);
+}
+
+void oc_job_wait(oc_job_counter* counter)
+{
+    oc_job_system* system = oc_job_system_get();
+
+    while(atomic_load_explicit(&counter->pending, memory_order_acquire))
+    {
+        oc_job job;
+        if(oc_job_find(system, &job))
+        {
+            oc_job_run(system, &job);
+        }
+        else
+        {
+            oc_mutex_lock(system->mutex);
+            if(atomic_load_explicit(&counter->pending, memory_order_acquire)
+               && atomic_load_explicit(&system->queuedCount, memory_order_acquire) == 0)
+            {
+                oc_condition_wait(system->condition, system->mutex);
+            }
+            oc_mutex_unlock(system->mutex);
+        }
+    }
+}
+
+u32 oc_job_worker_count(void)
+{
+    return (oc_job_system_get()->workerCount);
+}
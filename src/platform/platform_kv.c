@@ -0,0 +1,687 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform_debug.h"
+#include "platform_kv.h"
+#include "util/hash.h"
+#include "util/hash_map.h"
+
+//------------------------------------------------------------------------------
+// Log format
+//------------------------------------------------------------------------------
+
+enum
+{
+    OC_KV_MAGIC = 0x31564b4f, // 'OKV1'
+    OC_KV_VERSION = 1,
+
+    //NOTE: logs are compacted when they are bigger than this, and more than half of them is dead records
+    OC_KV_COMPACT_MIN_SIZE = 64 << 10,
+    OC_KV_BATCH_MIN_CAP = 4 << 10,
+};
+
+typedef u32 oc_kv_record_kind;
+
+enum oc_kv_record_kind_enum
+{
+    OC_KV_RECORD_PUT = 1,
+    OC_KV_RECORD_DELETE,
+    OC_KV_RECORD_COMMIT,
+};
+
+typedef struct oc_kv_file_header
+{
+    u32 magic;
+    u32 version;
+    u64 generation; // incremented by each compaction, the newest complete file is the current one
+} oc_kv_file_header;
+
+//NOTE: records are a header followed by the key and the value. Commit records have no key, and their value is the
+//      64-bit checksum of the records written since the previous commit.
+typedef struct oc_kv_record_header
+{
+    oc_kv_record_kind kind;
+    u32 keyLen;
+    u32 valueLen;
+    u32 reserved;
+} oc_kv_record_header;
+
+typedef struct oc_kv_entry
+{
+    oc_str8 key; // copied to the store's key arena
+    u64 offset;  // offset of the value in the log. Values of the pending batch are past the end of the log.
+    u64 size;
+    bool deleted;
+} oc_kv_entry;
+
+struct oc_kv_store
+{
+    oc_arena arena; // paths
+    oc_str8 paths[2];
+    u32 slot; // index of the path of the current file
+    oc_file file;
+    u64 generation;
+    u64 end; // end of the last commit, where the pending batch will be written
+
+    oc_str8 mapping; // the start of the log, as of the last time it was opened or compacted
+    bool mapped;     // the mapping comes from oc_file_map(), otherwise it was read in a malloc'd buffer
+    u64 mappedEnd;   // end of the committed records in the mapping. Past it, the file may have been overwritten.
+
+    oc_arena keyArena;
+    oc_hash_map index;
+    u64 liveBytes; // size of the put records of live entries
+
+    char* batch;
+    u64 batchLen;
+    u64 batchCap;
+};
+
+static u64 oc_kv_record_size(u64 keyLen, u64 valueLen)
+{
+    return (sizeof(oc_kv_record_header) + keyLen + valueLen);
+}
+
+static bool oc_kv_key_equal(oc_str8 a, oc_str8 b)
+{
+    return (a.len == b.len && !memcmp(a.ptr, b.ptr, a.len));
+}
+
+//------------------------------------------------------------------------------
+// Index
+//------------------------------------------------------------------------------
+
+/*NOTE:
+	The index maps 64-bit hashes of keys to entries. Keys are hashed with increasing seeds until their entry or a free
+	hash is found, so that keys with colliding hashes get different entries. For the same reason, deleted entries
+	stay in the index as tombstones until the next compaction rebuilds it.
+*/
+static oc_kv_entry* oc_kv_index_find(oc_hash_map* index, oc_str8 key, u64* freeHash)
+{
+    for(u64 seed = 0;; seed++)
+    {
+        u64 hash = oc_hash_xx64_string_seed(key, seed);
+        oc_kv_entry* entry = oc_hash_map_find_type(index, hash, oc_kv_entry);
+        if(!entry)
+        {
+            if(freeHash)
+            {
+                *freeHash = hash;
+            }
+            return (0);
+        }
+        if(oc_kv_key_equal(entry->key, key))
+        {
+            return (entry);
+        }
+    }
+}
+
+//NOTE: returns the entry of key, adding a deleted one if key isn't in the index
+static oc_kv_entry* oc_kv_index_insert(oc_hash_map* index, oc_arena* keyArena, oc_str8 key)
+{
+    u64 hash = 0;
+    oc_kv_entry* entry = oc_kv_index_find(index, key, &hash);
+    if(!entry)
+    {
+        entry = oc_hash_map_insert_type(index, hash, oc_kv_entry, 0);
+        entry->key = oc_str8_push_copy(keyArena, key);
+        entry->deleted = true;
+    }
+    return (entry);
+}
+
+static void oc_kv_index_put(oc_kv_store* store, oc_str8 key, u64 offset, u64 size)
+{
+    oc_kv_entry* entry = oc_kv_index_insert(&store->index, &store->keyArena, key);
+    if(!entry->deleted)
+    {
+        store->liveBytes -= oc_kv_record_size(entry->key.len, entry->size);
+    }
+    entry->offset = offset;
+    entry->size = size;
+    entry->deleted = false;
+    store->liveBytes += oc_kv_record_size(key.len, size);
+}
+
+static bool oc_kv_index_delete(oc_kv_store* store, oc_str8 key)
+{
+    oc_kv_entry* entry = oc_kv_index_find(&store->index, key, 0);
+    if(entry && !entry->deleted)
+    {
+        store->liveBytes -= oc_kv_record_size(entry->key.len, entry->size);
+        entry->deleted = true;
+        return (true);
+    }
+    return (false);
+}
+
+static void oc_kv_index_clear(oc_kv_store* store)
+{
+    oc_hash_map_clear(&store->index);
+    oc_arena_clear(&store->keyArena);
+    store->liveBytes = 0;
+}
+
+//------------------------------------------------------------------------------
+// Log mapping and replay
+//------------------------------------------------------------------------------
+
+static void oc_kv_map(oc_kv_store* store)
+{
+    u64 size = oc_file_size(store->file);
+    store->mapping = (oc_str8){ 0 };
+    store->mapped = false;
+
+#if OC_PLATFORM_ORCA
+    store->mapping = oc_file_map(store->file, 0, size);
+    store->mapped = (store->mapping.len != 0);
+#endif
+
+    //NOTE: host apps can't map an open file, and mappings can fail in the guest. The log is read in memory instead.
+    if(!store->mapped && size)
+    {
+        store->mapping.ptr = malloc(size);
+        if(store->mapping.ptr)
+        {
+            store->mapping.len = oc_file_read_at(store->file, 0, size, store->mapping.ptr);
+        }
+    }
+}
+
+static void oc_kv_unmap(oc_kv_store* store)
+{
+#if OC_PLATFORM_ORCA
+    if(store->mapped)
+    {
+        oc_file_unmap(store->mapping);
+    }
+    else
+#endif
+    {
+        free(store->mapping.ptr);
+    }
+    store->mapping = (oc_str8){ 0 };
+    store->mapped = false;
+    store->mappedEnd = 0;
+}
+
+static void oc_kv_apply(oc_kv_store* store, oc_str8 log, u64 start, u64 end)
+{
+    u64 pos = start;
+    while(pos < end)
+    {
+        oc_kv_record_header header;
+        memcpy(&header, log.ptr + pos, sizeof(header));
+
+        u64 keyOffset = pos + sizeof(header);
+        oc_str8 key = oc_str8_from_buffer(header.keyLen, log.ptr + keyOffset);
+        if(header.kind == OC_KV_RECORD_PUT)
+        {
+            oc_kv_index_put(store, key, keyOffset + header.keyLen, header.valueLen);
+        }
+        else
+        {
+            oc_kv_index_delete(store, key);
+        }
+        pos += oc_kv_record_size(header.keyLen, header.valueLen);
+    }
+}
+
+//NOTE: applies the complete batches of the log to the index, and returns the end of the last one, or 0 if the log
+//      has no complete batch. Replay stops at the first record that is truncated or invalid, or at the first commit
+//      whose checksum doesn't match, which is where the pending batch of a crashed app ends.
+static u64 oc_kv_replay(oc_kv_store* store, oc_str8 log)
+{
+    u64 lastCommitEnd = 0;
+    u64 batchStart = sizeof(oc_kv_file_header);
+    u64 pos = batchStart;
+
+    while(pos < log.len && log.len - pos >= sizeof(oc_kv_record_header))
+    {
+        oc_kv_record_header header;
+        memcpy(&header, log.ptr + pos, sizeof(header));
+
+        u64 recordSize = oc_kv_record_size(header.keyLen, header.valueLen);
+        if(recordSize > log.len - pos)
+        {
+            break;
+        }
+
+        if(header.kind == OC_KV_RECORD_COMMIT)
+        {
+            u64 checksum = 0;
+            if(header.keyLen != 0 || header.valueLen != sizeof(u64))
+            {
+                break;
+            }
+            memcpy(&checksum, log.ptr + pos + sizeof(header), sizeof(u64));
+            if(checksum != oc_hash_xx64_string(oc_str8_slice(log, batchStart, pos)))
+            {
+                break;
+            }
+            oc_kv_apply(store, log, batchStart, pos);
+
+            pos += recordSize;
+            batchStart = pos;
+            lastCommitEnd = pos;
+        }
+        else if(header.kind == OC_KV_RECORD_PUT || header.kind == OC_KV_RECORD_DELETE)
+        {
+            pos += recordSize;
+        }
+        else
+        {
+            break;
+        }
+    }
+    return (lastCommitEnd);
+}
+
+static bool oc_kv_read_header(oc_file file, oc_kv_file_header* header)
+{
+    u64 size = oc_file_read_at(file, 0, sizeof(oc_kv_file_header), (char*)header);
+    return (size == sizeof(oc_kv_file_header)
+            && header->magic == OC_KV_MAGIC
+            && header->version == OC_KV_VERSION);
+}
+
+//------------------------------------------------------------------------------
+// Pending batch
+//------------------------------------------------------------------------------
+
+//NOTE: appends a record to the pending batch, and returns the offset its value will have in the log
+static u64 oc_kv_batch_push(oc_kv_store* store, oc_kv_record_kind kind, oc_str8 key, oc_str8 value)
+{
+    u64 recordSize = oc_kv_record_size(key.len, value.len);
+    if(store->batchLen + recordSize > store->batchCap)
+    {
+        u64 cap = oc_max(oc_max(2 * store->batchCap, store->batchLen + recordSize), OC_KV_BATCH_MIN_CAP);
+        char* batch = realloc(store->batch, cap);
+        if(!batch)
+        {
+            oc_log_error("couldn't grow the pending batch of a key-value store to %llu bytes\n", (unsigned long long)cap);
+            return (0);
+        }
+        store->batch = batch;
+        store->batchCap = cap;
+    }
+
+    oc_kv_record_header header = {
+        .kind = kind,
+        .keyLen = key.len,
+        .valueLen = value.len,
+    };
+    char* record = store->batch + store->batchLen;
+    memcpy(record, &header, sizeof(header));
+    if(key.len)
+    {
+        memcpy(record + sizeof(header), key.ptr, key.len);
+    }
+    if(value.len)
+    {
+        memcpy(record + sizeof(header) + key.len, value.ptr, value.len);
+    }
+
+    u64 valueOffset = store->end + store->batchLen + sizeof(header) + key.len;
+    store->batchLen += recordSize;
+    return (valueOffset);
+}
+
+static void oc_kv_read(oc_kv_store* store, u64 offset, u64 size, char* buffer)
+{
+    if(offset >= store->end)
+    {
+        memcpy(buffer, store->batch + (offset - store->end), size);
+    }
+    else if(offset + size <= store->mappedEnd)
+    {
+        memcpy(buffer, store->mapping.ptr + offset, size);
+    }
+    else
+    {
+        oc_file_read_at(store->file, offset, size, buffer);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Store API
+//------------------------------------------------------------------------------
+
+static oc_file oc_kv_create_file(oc_str8 path, u64 generation)
+{
+    oc_file file = oc_file_open(path, OC_FILE_ACCESS_READ | OC_FILE_ACCESS_WRITE, OC_FILE_OPEN_CREATE | OC_FILE_OPEN_TRUNCATE);
+    if(oc_file_last_error(file) == OC_IO_OK)
+    {
+        oc_kv_file_header header = {
+            .magic = OC_KV_MAGIC,
+            .version = OC_KV_VERSION,
+            .generation = generation,
+        };
+        oc_file_write_at(file, 0, sizeof(header), (char*)&header);
+    }
+    return (file);
+}
+
+oc_kv_store* oc_kv_open(oc_str8 path)
+{
+    oc_kv_store* store = calloc(1, sizeof(oc_kv_store));
+    if(!store)
+    {
+        return (0);
+    }
+    oc_arena_init(&store->arena);
+    oc_arena_init(&store->keyArena);
+    oc_hash_map_init(&store->index, sizeof(oc_kv_entry));
+
+    oc_file files[2] = { 0 };
+    oc_kv_file_header headers[2] = { 0 };
+    bool valid[2] = { 0 };
+    u64 maxGeneration = 0;
+
+    for(u32 i = 0; i < 2; i++)
+    {
+        store->paths[i] = oc_str8_pushf(&store->arena, "%.*s.%u", oc_str8_ip(path), i);
+        files[i] = oc_file_open(store->paths[i], OC_FILE_ACCESS_READ | OC_FILE_ACCESS_WRITE, OC_FILE_OPEN_CREATE);
+        if(oc_file_last_error(files[i]) != OC_IO_OK)
+        {
+            oc_log_error("couldn't open key-value store file %.*s\n", oc_str8_ip(store->paths[i]));
+            for(u32 j = 0; j <= i; j++)
+            {
+                oc_file_close(files[j]);
+            }
+            oc_kv_close(store);
+            return (0);
+        }
+        valid[i] = oc_kv_read_header(files[i], &headers[i]);
+        if(valid[i])
+        {
+            maxGeneration = oc_max(maxGeneration, headers[i].generation);
+        }
+    }
+
+    //NOTE: try the newest file first, and fall back to the other one if it has no complete batch, e.g. because the
+    //      app crashed while compacting into it.
+    u32 newest = (valid[1] && (!valid[0] || headers[1].generation > headers[0].generation)) ? 1 : 0;
+    u32 order[2] = { newest, 1 - newest };
+    bool found = false;
+
+    for(u32 i = 0; i < 2 && !found; i++)
+    {
+        u32 slot = order[i];
+        if(valid[slot])
+        {
+            store->file = files[slot];
+            oc_kv_map(store);
+            store->end = oc_kv_replay(store, store->mapping);
+            if(store->end)
+            {
+                //NOTE: the mapping can hold the torn tail of a batch that wasn't committed before a crash. New
+                //      batches overwrite it in the file, so it must never be read from the mapping.
+                store->mappedEnd = store->end;
+                store->slot = slot;
+                store->generation = headers[slot].generation;
+                found = true;
+            }
+            else
+            {
+                oc_kv_unmap(store);
+                oc_kv_index_clear(store);
+            }
+        }
+    }
+
+    for(u32 slot = 0; slot < 2; slot++)
+    {
+        if(!found || slot != store->slot)
+        {
+            oc_file_close(files[slot]);
+        }
+    }
+
+    if(!found)
+    {
+        //NOTE: start a new log. The file is truncated so that old records can't be replayed after the new header.
+        store->slot = 0;
+        store->generation = maxGeneration + 1;
+        store->file = oc_kv_create_file(store->paths[0], store->generation);
+        store->end = sizeof(oc_kv_file_header);
+
+        if(oc_file_last_error(store->file) != OC_IO_OK)
+        {
+            oc_log_error("couldn't create key-value store file %.*s\n", oc_str8_ip(store->paths[0]));
+            oc_kv_close(store);
+            return (0);
+        }
+    }
+    return (store);
+}
+
+void oc_kv_close(oc_kv_store* store)
+{
+    if(!oc_file_is_nil(store->file))
+    {
+        if(store->batchLen)
+        {
+            oc_io_error error = oc_kv_commit(store, OC_FILE_SYNC_DATA);
+            if(error != OC_IO_OK)
+            {
+                oc_log_error("couldn't commit the pending changes of key-value store %.*s (error %i)\n",
+                             oc_str8_ip(store->paths[store->slot]),
+                             error);
+            }
+        }
+        oc_file_close(store->file);
+    }
+    oc_kv_unmap(store);
+    free(store->batch);
+    oc_hash_map_cleanup(&store->index);
+    oc_arena_cleanup(&store->keyArena);
+    oc_arena_cleanup(&store->arena);
+    free(store);
+}
+
+void oc_kv_put(oc_kv_store* store, oc_str8 key, oc_str8 value)
+{
+    u64 offset = oc_kv_batch_push(store, OC_KV_RECORD_PUT, key, value);
+    if(offset)
+    {
+        oc_kv_index_put(store, key, offset, value.len);
+    }
+}
+
+void oc_kv_delete(oc_kv_store* store, oc_str8 key)
+{
+    oc_kv_entry* entry = oc_kv_index_find(&store->index, key, 0);
+    if(entry && !entry->deleted)
+    {
+        if(oc_kv_batch_push(store, OC_KV_RECORD_DELETE, key, (oc_str8){ 0 }))
+        {
+            oc_kv_index_delete(store, key);
+        }
+    }
+}
+
+oc_str8 oc_kv_get(oc_kv_store* store, oc_arena* arena, oc_str8 key)
+{
+    oc_str8 value = { 0 };
+    oc_kv_entry* entry = oc_kv_index_find(&store->index, key, 0);
+    if(entry && !entry->deleted)
+    {
+        value.ptr = oc_arena_push(arena, entry->size);
+        value.len = entry->size;
+        oc_kv_read(store, entry->offset, entry->size, value.ptr);
+    }
+    return (value);
+}
+
+bool oc_kv_contains(oc_kv_store* store, oc_str8 key)
+{
+    oc_kv_entry* entry = oc_kv_index_find(&store->index, key, 0);
+    return (entry && !entry->deleted);
+}
+
+oc_io_error oc_kv_commit(oc_kv_store* store, oc_file_sync sync)
+{
+    if(!store->batchLen)
+    {
+        return (OC_IO_OK);
+    }
+
+    u64 recordsLen = store->batchLen;
+    u64 checksum = oc_hash_xx64_string(oc_str8_from_buffer(recordsLen, store->batch));
+    if(!oc_kv_batch_push(store, OC_KV_RECORD_COMMIT, (oc_str8){ 0 }, oc_str8_from_buffer(sizeof(u64), (char*)&checksum)))
+    {
+        return (OC_IO_ERR_MEM);
+    }
+
+    oc_io_error error = OC_IO_OK;
+    if(oc_file_write_at(store->file, store->end, store->batchLen, store->batch) != store->batchLen)
+    {
+        error = oc_file_last_error(store->file);
+        error = (error == OC_IO_OK) ? OC_IO_ERR_UNKNOWN : error;
+    }
+    else if(sync != OC_FILE_SYNC_NONE)
+    {
+        error = oc_file_flush(store->file, sync);
+    }
+
+    if(error != OC_IO_OK)
+    {
+        //NOTE: keep the changes pending, so that the commit can be retried. Whatever part of the batch reached the
+        //      file has no valid commit record, and will be overwritten.
+        store->batchLen = recordsLen;
+        return (error);
+    }
+
+    store->end += store->batchLen;
+    store->batchLen = 0;
+
+    u64 logSize = store->end - sizeof(oc_kv_file_header);
+    if(store->end > OC_KV_COMPACT_MIN_SIZE && logSize > 2 * store->liveBytes)
+    {
+        oc_io_error compactError = oc_kv_compact(store);
+        if(compactError != OC_IO_OK)
+        {
+            oc_log_error("couldn't compact key-value store %.*s (error %i)\n",
+                         oc_str8_ip(store->paths[store->slot]),
+                         compactError);
+        }
+    }
+    return (OC_IO_OK);
+}
+
+oc_io_error oc_kv_compact(oc_kv_store* store)
+{
+    //NOTE: commit pending changes first, so that the compacted log only holds committed entries
+    oc_io_error error = oc_kv_commit(store, OC_FILE_SYNC_NONE);
+    if(error != OC_IO_OK)
+    {
+        return (error);
+    }
+
+    u64 commitSize = oc_kv_record_size(0, sizeof(u64));
+    u64 size = sizeof(oc_kv_file_header) + store->liveBytes + commitSize;
+    char* buffer = malloc(size);
+    if(!buffer)
+    {
+        return (OC_IO_ERR_MEM);
+    }
+
+    oc_kv_file_header fileHeader = {
+        .magic = OC_KV_MAGIC,
+        .version = OC_KV_VERSION,
+        .generation = store->generation + 1,
+    };
+    memcpy(buffer, &fileHeader, sizeof(fileHeader));
+
+    //NOTE: the live entries are written as a single batch, and indexed in a new index that replaces the old one,
+    //      without its tombstones, once the new file is synced.
+    oc_hash_map index;
+    oc_arena keyArena;
+    oc_hash_map_init(&index, sizeof(oc_kv_entry));
+    oc_arena_init(&keyArena);
+
+    u64 pos = sizeof(oc_kv_file_header);
+    u64 iterator = 0;
+    oc_kv_entry* entry = 0;
+    while((entry = oc_hash_map_next(&store->index, &iterator, 0)) != 0)
+    {
+        if(entry->deleted)
+        {
+            continue;
+        }
+        oc_kv_record_header header = {
+            .kind = OC_KV_RECORD_PUT,
+            .keyLen = entry->key.len,
+            .valueLen = entry->size,
+        };
+        memcpy(buffer + pos, &header, sizeof(header));
+        memcpy(buffer + pos + sizeof(header), entry->key.ptr, entry->key.len);
+
+        u64 valueOffset = pos + sizeof(header) + entry->key.len;
+        oc_kv_read(store, entry->offset, entry->size, buffer + valueOffset);
+
+        oc_kv_entry* newEntry = oc_kv_index_insert(&index, &keyArena, entry->key);
+        newEntry->offset = valueOffset;
+        newEntry->size = entry->size;
+        newEntry->deleted = false;
+
+        pos = valueOffset + entry->size;
+    }
+
+    u64 checksum = oc_hash_xx64_string(oc_str8_from_buffer(pos - sizeof(oc_kv_file_header), buffer + sizeof(oc_kv_file_header)));
+    oc_kv_record_header commit = {
+        .kind = OC_KV_RECORD_COMMIT,
+        .valueLen = sizeof(u64),
+    };
+    memcpy(buffer + pos, &commit, sizeof(commit));
+    memcpy(buffer + pos + sizeof(commit), &checksum, sizeof(u64));
+
+    u32 newSlot = 1 - store->slot;
+    oc_file file = oc_file_open(store->paths[newSlot], OC_FILE_ACCESS_READ | OC_FILE_ACCESS_WRITE, OC_FILE_OPEN_CREATE | OC_FILE_OPEN_TRUNCATE);
+    error = oc_file_last_error(file);
+    if(error == OC_IO_OK && oc_file_write_at(file, 0, size, buffer) != size)
+    {
+        error = oc_file_last_error(file);
+        error = (error == OC_IO_OK) ? OC_IO_ERR_UNKNOWN : error;
+    }
+    if(error == OC_IO_OK)
+    {
+        error = oc_file_flush(file, OC_FILE_SYNC_FULL);
+    }
+    free(buffer);
+
+    if(error != OC_IO_OK)
+    {
+        oc_file_close(file);
+        oc_hash_map_cleanup(&index);
+        oc_arena_cleanup(&keyArena);
+        return (error);
+    }
+
+    //NOTE: the new file is complete and synced, so the old one can be cleared
+    oc_kv_unmap(store);
+    oc_file_close(store->file);
+    oc_file_close(oc_file_open(store->paths[store->slot], OC_FILE_ACCESS_WRITE, OC_FILE_OPEN_TRUNCATE));
+
+    oc_hash_map_cleanup(&store->index);
+    oc_arena_cleanup(&store->keyArena);
+    store->index = index;
+    store->keyArena = keyArena;
+
+    store->file = file;
+    store->slot = newSlot;
+    store->generation = fileHeader.generation;
+    store->end = size;
+    oc_kv_map(store);
+    store->mappedEnd = oc_min(store->mapping.len, store->end);
+
+    return (OC_IO_OK);
+}
@@ -0,0 +1,62 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "platform_io.h"
+#include "util/memory.h"
+#include "util/strings.h"
+#include "util/typedefs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------
+// Key-value store
+//----------------------------------------------------------------
+
+/*NOTE:
+	A small persistent key-value store, for app state that changes often, built on the file API. Keys and values
+	are arbitrary byte strings.
+
+	Puts and deletes are appended to a pending batch, which oc_kv_commit() writes to the end of a log file in one
+	request, followed by a commit record with a checksum of the batch. A batch is applied entirely or not at all:
+	when the store is opened, the log is replayed up to its last complete commit. Committing once per frame, or
+	after a group of changes, shares a single sync between all of them.
+
+	The log lives in two files, path.0 and path.1. When most of the log is made of overwritten or deleted entries,
+	oc_kv_commit() compacts the live entries into the other file, with a higher generation number. The old file is
+	only cleared once the new one is synced, and opening the store picks the newest complete file, so a crash
+	during compaction loses nothing.
+
+	The index of keys is kept in memory. Values are read from a mapping of the log when the host supports it, or
+	from the file, and values that aren't committed yet are read from the pending batch.
+
+	oc_kv_open() returns 0 if the files can't be opened or created.
+	oc_kv_get() copies the value of key to arena, or returns an empty string with a null pointer if key isn't in
+	the store. Use oc_kv_contains() to tell empty values from missing keys.
+	oc_kv_commit() returns OC_IO_OK if there was nothing to commit. With OC_FILE_SYNC_NONE, a commit is atomic but
+	can be lost if the system crashes before the OS writes it.
+	oc_kv_close() commits pending changes with OC_FILE_SYNC_DATA.
+*/
+typedef struct oc_kv_store oc_kv_store;
+
+ORCA_API oc_kv_store* oc_kv_open(oc_str8 path);
+ORCA_API void oc_kv_close(oc_kv_store* store);
+
+ORCA_API void oc_kv_put(oc_kv_store* store, oc_str8 key, oc_str8 value);
+ORCA_API void oc_kv_delete(oc_kv_store* store, oc_str8 key);
+ORCA_API oc_str8 oc_kv_get(oc_kv_store* store, oc_arena* arena, oc_str8 key);
+ORCA_API bool oc_kv_contains(oc_kv_store* store, oc_str8 key);
+
+ORCA_API oc_io_error oc_kv_commit(oc_kv_store* store, oc_file_sync sync);
+ORCA_API oc_io_error oc_kv_compact(oc_kv_store* store);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -19,13 +19,15 @@ extern "C" {
 //--------------------------------------------------------------------------------
 typedef struct oc_base_allocator oc_base_allocator;
 
+//NOTE: reserve returns null and commit returns false when the OS can't provide the memory
 typedef void* (*oc_mem_reserve_proc)(oc_base_allocator* context, u64 size);
+typedef bool (*oc_mem_commit_proc)(oc_base_allocator* context, void* ptr, u64 size);
 typedef void (*oc_mem_modify_proc)(oc_base_allocator* context, void* ptr, u64 size);
 
 typedef struct oc_base_allocator
 {
     oc_mem_reserve_proc reserve;
-    oc_mem_modify_proc commit;
+    oc_mem_commit_proc commit;
     oc_mem_modify_proc decommit;
     oc_mem_modify_proc release;
 
@@ -33,11 +35,32 @@ typedef struct oc_base_allocator
 
 ORCA_API oc_base_allocator* oc_base_allocator_default(void);
 
+enum
+{
+    OC_BASE_LARGE_PAGE_SIZE = 2 << 20,
+};
+
+/*NOTE: base allocator for big regions that are accessed randomly, like wasm memories, where regular pages cause
+    TLB pressure. Reservations are aligned on OC_BASE_LARGE_PAGE_SIZE and commits are rounded to whole large pages,
+    which the OS can then back with large pages:
+        - Linux: transparent huge pages, through madvise(MADV_HUGEPAGE).
+        - macOS: superpages can't be committed in place inside a reservation, and Apple Silicon has none for user
+          memory, so this only keeps the alignment and rounding.
+        - Windows: large pages must be committed at reservation time by a process with the "lock pages in memory"
+          privilege, which doesn't fit growable reservations, so this is the default allocator.
+    Since commits are rounded, accesses up to the end of the last committed large page don't fault, so it can't be
+    used for guard regions.
+*/
+ORCA_API oc_base_allocator* oc_base_allocator_large_pages(void);
+
 #define oc_base_reserve(base, size) base->reserve(base, size)
 #define oc_base_commit(base, ptr, size) base->commit(base, ptr, size)
 #define oc_base_decommit(base, ptr, size) base->decommit(base, ptr, size)
 #define oc_base_release(base, ptr, size) base->release(base, ptr, size)
 
+//NOTE: returns the number of bytes in [ptr, ptr + size) that are currently backed by physical memory
+ORCA_API u64 oc_base_resident_size(void* ptr, u64 size);
+
 //--------------------------------------------------------------------------------
 //NOTE(martin): malloc/free
 //--------------------------------------------------------------------------------
@@ -0,0 +1,78 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "platform.h"
+#include "util/strings.h"
+#include "util/typedefs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+//----------------------------------------------------------------
+// HTTP fetch
+//----------------------------------------------------------------
+
+typedef struct oc_fetch
+{
+    u64 h;
+} oc_fetch;
+
+typedef i32 oc_fetch_error;
+
+enum oc_fetch_error_enum
+{
+    OC_FETCH_OK = 0,
+    OC_FETCH_ERR_UNKNOWN,
+    OC_FETCH_ERR_ARG,     // malformed url, or unsupported protocol
+    OC_FETCH_ERR_RESOLVE, // host name couldn't be resolved
+    OC_FETCH_ERR_CONNECT, // couldn't connect to the host
+    OC_FETCH_ERR_TLS,     // secure connection couldn't be established
+    OC_FETCH_ERR_TIMEOUT, // the host stopped responding
+    OC_FETCH_ERR_NETWORK, // the connection failed during the transfer
+    OC_FETCH_ERR_MEM,     // the host failed to allocate memory
+};
+
+typedef u32 oc_fetch_event_kind;
+
+enum oc_fetch_event_kind_enum
+{
+    OC_FETCH_EVENT_DATA, // the current buffer is full. The transfer waits for oc_fetch_resume().
+    OC_FETCH_EVENT_DONE, // the transfer completed or failed. The handle is no longer valid.
+};
+
+typedef struct oc_fetch_event
+{
+    oc_fetch fetch;
+    oc_fetch_event_kind kind;
+    u32 status;           // HTTP status of the response, or 0 if no response was received
+    u64 size;             // number of bytes of the response body written at the start of the current buffer
+    oc_fetch_error error; // only set by OC_FETCH_EVENT_DONE
+} oc_fetch_event;
+
+/*NOTE:
+	Fetches run on a host thread and never block the app. oc_fetch_start() starts an HTTP or HTTPS request and
+	returns its handle. method defaults to "GET", or to "POST" if body isn't empty. headers holds "Name: value"
+	lines separated by '\n'. The url, headers and body are copied by the host.
+
+	The response body is written to the size bytes at buffer, which must stay valid until the fetch sends an event.
+	When the buffer is full, the fetch sends an OC_EVENT_FETCH event of kind OC_FETCH_EVENT_DATA, and waits until
+	oc_fetch_resume() gives it the next buffer, which can be the same one. When the transfer ends, the fetch sends
+	an OC_FETCH_EVENT_DONE event with the number of bytes written to its last buffer, and its handle is released.
+
+	oc_fetch_cancel() stops a fetch and releases its handle without sending more events. Events that were already
+	queued are still delivered. If a fetch can't be started, oc_fetch_start() returns a nil handle.
+*/
+ORCA_API oc_fetch oc_fetch_start(oc_str8 method, oc_str8 url, oc_str8 headers, oc_str8 body, u64 size, char* buffer);
+ORCA_API void oc_fetch_resume(oc_fetch fetch, u64 size, char* buffer);
+ORCA_API void oc_fetch_cancel(oc_fetch fetch);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
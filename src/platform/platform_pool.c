@@ -0,0 +1,174 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include "platform_thread.h"
+
+enum
+{
+    OC_SHARED_POOL_DEFAULT_BATCH_SIZE = 64,
+    OC_SHARED_POOL_BLOCK_ALIGNMENT = 16,
+};
+
+//NOTE: free blocks are linked through their first bytes. The first block of a batch also links to the next batch
+//      and holds the number of blocks in its batch.
+struct oc_pool_block
+{
+    oc_pool_block* next;
+    oc_pool_block* nextBatch;
+    u64 count;
+};
+
+void oc_shared_pool_init(oc_shared_pool* pool, u64 blockSize)
+{
+    oc_shared_pool_init_with_options(pool, blockSize, &(oc_shared_pool_options){ 0 });
+}
+
+void oc_shared_pool_init_with_options(oc_shared_pool* pool, u64 blockSize, oc_shared_pool_options* options)
+{
+    memset(pool, 0, sizeof(oc_shared_pool));
+    oc_arena_init_with_options(&pool->arena, &(oc_arena_options){ .base = options->base, .reserve = options->reserve });
+    oc_ticket_init(&pool->arenaLock);
+
+    pool->blockSize = oc_align_up_pow2(oc_clamp_low(blockSize, sizeof(oc_pool_block)), OC_SHARED_POOL_BLOCK_ALIGNMENT);
+    pool->batchSize = options->batchSize ? options->batchSize : OC_SHARED_POOL_DEFAULT_BATCH_SIZE;
+    atomic_init(&pool->batches, 0);
+}
+
+void oc_shared_pool_cleanup(oc_shared_pool* pool)
+{
+    oc_arena_cleanup(&pool->arena);
+    memset(pool, 0, sizeof(oc_shared_pool));
+}
+
+static void oc_shared_pool_push_batches(oc_shared_pool* pool, oc_pool_block* first, oc_pool_block* last)
+{
+    oc_pool_block* head = atomic_load_explicit(&pool->batches, memory_order_relaxed);
+    do
+    {
+        last->nextBatch = head;
+    }
+    while(!atomic_compare_exchange_weak_explicit(&pool->batches, &head, first, memory_order_release, memory_order_relaxed));
+}
+
+static oc_pool_block* oc_shared_pool_pop_batch(oc_shared_pool* pool)
+{
+    //NOTE: popping a single batch with a compare-exchange is subject to the ABA problem, so instead we take the
+    //      whole list and push the other batches back.
+    oc_pool_block* batch = atomic_exchange_explicit(&pool->batches, 0, memory_order_acquire);
+    if(batch && batch->nextBatch)
+    {
+        oc_pool_block* last = batch->nextBatch;
+        while(last->nextBatch)
+        {
+            last = last->nextBatch;
+        }
+        oc_shared_pool_push_batches(pool, batch->nextBatch, last);
+    }
+    return (batch);
+}
+
+static oc_pool_block* oc_shared_pool_grow(oc_shared_pool* pool)
+{
+    oc_ticket_lock(&pool->arenaLock);
+    char* mem = oc_arena_push_aligned(&pool->arena, pool->blockSize * pool->batchSize, OC_SHARED_POOL_BLOCK_ALIGNMENT);
+    oc_ticket_unlock(&pool->arenaLock);
+
+    if(!mem)
+    {
+        return (0);
+    }
+
+    oc_pool_block* batch = (oc_pool_block*)mem;
+    for(u32 i = 0; i < pool->batchSize; i++)
+    {
+        oc_pool_block* block = (oc_pool_block*)(mem + i * pool->blockSize);
+        block->next = (i + 1 < pool->batchSize) ? (oc_pool_block*)(mem + (i + 1) * pool->blockSize) : 0;
+    }
+    batch->count = pool->batchSize;
+    return (batch);
+}
+
+void oc_pool_cache_init(oc_pool_cache* cache, oc_shared_pool* pool)
+{
+    memset(cache, 0, sizeof(oc_pool_cache));
+    cache->pool = pool;
+}
+
+static bool oc_pool_cache_refill(oc_pool_cache* cache)
+{
+    //NOTE: reuse our own recycled blocks first, then a batch given back by another cache, and only then grow the pool
+    if(cache->recycleList)
+    {
+        cache->allocList = cache->recycleList;
+        cache->allocCount = cache->recycleCount;
+        cache->recycleList = 0;
+        cache->recycleCount = 0;
+    }
+    else
+    {
+        oc_pool_block* batch = oc_shared_pool_pop_batch(cache->pool);
+        if(!batch)
+        {
+            batch = oc_shared_pool_grow(cache->pool);
+        }
+        if(batch)
+        {
+            cache->allocList = batch;
+            cache->allocCount = batch->count;
+        }
+    }
+    return (cache->allocList != 0);
+}
+
+void* oc_pool_cache_alloc(oc_pool_cache* cache)
+{
+    if(!cache->allocList && !oc_pool_cache_refill(cache))
+    {
+        return (0);
+    }
+    oc_pool_block* block = cache->allocList;
+    cache->allocList = block->next;
+    cache->allocCount--;
+    return (block);
+}
+
+static void oc_pool_cache_give_back(oc_pool_cache* cache, oc_pool_block* list, u32 count)
+{
+    list->count = count;
+    oc_shared_pool_push_batches(cache->pool, list, list);
+}
+
+void oc_pool_cache_recycle(oc_pool_cache* cache, void* ptr)
+{
+    oc_pool_block* block = (oc_pool_block*)ptr;
+    block->next = cache->recycleList;
+    cache->recycleList = block;
+    cache->recycleCount++;
+
+    if(cache->recycleCount >= cache->pool->batchSize)
+    {
+        oc_pool_cache_give_back(cache, cache->recycleList, cache->recycleCount);
+        cache->recycleList = 0;
+        cache->recycleCount = 0;
+    }
+}
+
+void oc_pool_cache_flush(oc_pool_cache* cache)
+{
+    if(cache->allocList)
+    {
+        oc_pool_cache_give_back(cache, cache->allocList, cache->allocCount);
+    }
+    if(cache->recycleList)
+    {
+        oc_pool_cache_give_back(cache, cache->recycleList, cache->recycleCount);
+    }
+    cache->allocList = 0;
+    cache->allocCount = 0;
+    cache->recycleList = 0;
+    cache->recycleCount = 0;
+}
@@ -42,6 +42,37 @@ ORCA_API int oc_thread_signal(oc_thread* thread, int sig);
 ORCA_API int oc_thread_join(oc_thread* thread, i64* exitCode);
 ORCA_API int oc_thread_detach(oc_thread* thread);
 
+/*NOTE:
+	Thread priorities map to QoS classes on macOS, and to thread priorities on Windows, where frame threads also join
+	the "Games" MMCSS task so that they keep running on time on a busy machine. Threads start with the normal priority.
+
+	On macOS, QoS classes can only be given at creation or by the thread itself, so oc_thread_set_priority() falls back
+	to a scheduling priority when called on another thread. Core affinity is only supported on Windows, macOS doesn't
+	let threads be pinned to a core.
+
+	A null thread designates the calling thread, which lets threads that weren't created by oc_thread_create_xxx(),
+	like the main thread, set their own priority.
+*/
+typedef enum oc_thread_priority
+{
+    OC_THREAD_PRIORITY_NORMAL = 0,
+    OC_THREAD_PRIORITY_BACKGROUND, // work nobody waits on, e.g. decoding ahead or prefetching
+    OC_THREAD_PRIORITY_UTILITY,    // work that is waited on eventually, e.g. I/O
+    OC_THREAD_PRIORITY_HIGH,       // work the current frame waits on, e.g. canvas encoding
+    OC_THREAD_PRIORITY_FRAME,      // threads that handle input or produce frames
+} oc_thread_priority;
+
+typedef struct oc_thread_options
+{
+    oc_str8 name;
+    oc_thread_priority priority;
+    u64 affinityMask; // logical processors the thread can run on, 0 for all
+} oc_thread_options;
+
+ORCA_API oc_thread* oc_thread_create_with_options(oc_thread_start_proc start, void* userPointer, oc_thread_options* options);
+ORCA_API int oc_thread_set_priority(oc_thread* thread, oc_thread_priority priority);
+ORCA_API int oc_thread_set_affinity(oc_thread* thread, u64 affinityMask);
+
 //---------------------------------------------------------------
 // Platform Mutex API
 //---------------------------------------------------------------
@@ -85,6 +116,92 @@ ORCA_API int oc_condition_broadcast(oc_condition* cond);
 //---------------------------------------------------------------
 ORCA_API void oc_sleep_nano(u64 nanoseconds); // sleep for a given number of nanoseconds
 
+ORCA_API u32 oc_cpu_count(void); // number of logical processors available
+
+//---------------------------------------------------------------
+// Job system
+//---------------------------------------------------------------
+/*NOTE:
+	Jobs run on a pool of worker threads, one per logical processor minus one, which is started on the first
+	submission. Each worker has its own queue of jobs: jobs submitted from a worker go to its queue, and idle
+	workers steal jobs from the other queues. Jobs submitted from other threads are shared by all workers.
+
+	Each job decrements its counter when it completes. oc_job_wait() runs queued jobs until the counter reaches
+	zero, so jobs can wait for the jobs they submit. Counters must be zero-initialized, and can be reused once
+	waited on.
+
+	Scratch arenas are per-thread, so jobs can use oc_scratch_begin() as long as they end their scratch scope
+	before returning.
+*/
+typedef void (*oc_job_proc)(void* user);
+typedef void (*oc_job_range_proc)(void* user, u64 start, u64 end);
+
+typedef struct oc_job_counter
+{
+    _Atomic(u64) pending;
+} oc_job_counter;
+
+ORCA_API void oc_job_submit(oc_job_proc proc, void* user, oc_job_counter* counter);
+ORCA_API void oc_job_wait(oc_job_counter* counter);
+
+//NOTE: runs proc on the subranges of [0, count), each at most grain long. A grain of 0 picks one that spreads the
+//      range over the workers. The call returns once the jobs are submitted, wait on counter for their completion.
+ORCA_API void oc_job_parallel_for(u64 count, u64 grain, oc_job_range_proc proc, void* user, oc_job_counter* counter);
+
+ORCA_API u32 oc_job_worker_count(void);
+
+//---------------------------------------------------------------
+// Concurrent pool
+//---------------------------------------------------------------
+/*NOTE:
+	oc_shared_pool hands out fixed-size blocks to several threads. Each thread allocates and recycles through its
+	own oc_pool_cache, which keeps the blocks it recycled and the ones it took from the pool in per-thread lists,
+	so the common path doesn't touch any shared state. A cache that runs out of blocks takes a whole batch from
+	the pool, and a cache that recycled a full batch gives it back, so blocks recycled on another thread than the
+	one that allocated them flow back through the pool. The shared list of batches is lock-free, and the pool
+	only takes a lock to grow its arena.
+
+	A cache must only be used by one thread at a time. Flush it before dropping it, otherwise its blocks are only
+	reclaimed when the pool is cleaned up. oc_pool (in util/memory.h) remains the single-threaded variant.
+*/
+typedef struct oc_pool_block oc_pool_block;
+
+typedef struct oc_shared_pool
+{
+    oc_arena arena;
+    oc_ticket arenaLock;
+    u64 blockSize;
+    u32 batchSize;
+    _Atomic(oc_pool_block*) batches;
+} oc_shared_pool;
+
+typedef struct oc_shared_pool_options
+{
+    oc_base_allocator* base;
+    u64 reserve;
+    u32 batchSize; // blocks moved between a cache and the pool at once, 0 for the default
+} oc_shared_pool_options;
+
+typedef struct oc_pool_cache
+{
+    oc_shared_pool* pool;
+    oc_pool_block* allocList;
+    u32 allocCount;
+    oc_pool_block* recycleList;
+    u32 recycleCount;
+} oc_pool_cache;
+
+ORCA_API void oc_shared_pool_init(oc_shared_pool* pool, u64 blockSize);
+ORCA_API void oc_shared_pool_init_with_options(oc_shared_pool* pool, u64 blockSize, oc_shared_pool_options* options);
+ORCA_API void oc_shared_pool_cleanup(oc_shared_pool* pool);
+
+ORCA_API void oc_pool_cache_init(oc_pool_cache* cache, oc_shared_pool* pool);
+ORCA_API void* oc_pool_cache_alloc(oc_pool_cache* cache);
+ORCA_API void oc_pool_cache_recycle(oc_pool_cache* cache, void* ptr);
+ORCA_API void oc_pool_cache_flush(oc_pool_cache* cache);
+
+#define oc_pool_cache_alloc_type(cache, type) ((type*)oc_pool_cache_alloc(cache))
+
 #ifdef __cplusplus
 } // extern "C"
 #endif // __cplusplus
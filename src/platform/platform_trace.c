@@ -0,0 +1,283 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/memory.h"
+
+#include "platform_clock.h"
+#include "platform_debug.h"
+#include "platform_thread.h"
+#include "platform_trace.h"
+
+typedef enum oc_trace_event_kind
+{
+    OC_TRACE_EVENT_BEGIN,
+    OC_TRACE_EVENT_END,
+    OC_TRACE_EVENT_COMPLETE,
+} oc_trace_event_kind;
+
+typedef struct oc_trace_event
+{
+    const char* name;
+    f64 time;
+    f64 duration;
+    u32 kind;
+    u32 track;
+} oc_trace_event;
+
+enum
+{
+    OC_TRACE_BUFFER_CAP = 1 << 17, // events per thread
+};
+
+//NOTE: each thread writes to its own buffer, and oc_trace_write() is the only reader, so the buffers are
+//      single-producer single-consumer rings that don't need locking. Buffers are allocated the first time
+//      a thread records a zone and are never freed, so that the reader can walk the list at any time.
+typedef struct oc_trace_buffer
+{
+    struct oc_trace_buffer* next;
+    u64 threadId;
+
+    _Atomic(u64) readIndex;
+    _Atomic(u64) writeIndex;
+
+    //NOTE: only touched by the owning thread
+    u32 depth;
+    u32 droppedDepth;
+
+    oc_trace_event events[OC_TRACE_BUFFER_CAP];
+} oc_trace_buffer;
+
+static _Atomic(u32) oc_traceEnabled = 0;
+static _Atomic(oc_trace_buffer*) oc_traceBuffers = 0;
+static _Atomic(u64) oc_traceDroppedCount = 0;
+static f64 oc_traceStartTime = 0;
+static oc_thread_local oc_trace_buffer* oc_traceThreadBuffer = 0;
+
+static oc_trace_buffer* oc_trace_thread_buffer(void)
+{
+    oc_trace_buffer* buffer = oc_traceThreadBuffer;
+    if(!buffer)
+    {
+        buffer = calloc(1, sizeof(oc_trace_buffer));
+        if(buffer)
+        {
+            buffer->threadId = oc_thread_self_id();
+
+            oc_trace_buffer* head = atomic_load(&oc_traceBuffers);
+            do
+            {
+                buffer->next = head;
+            }
+            while(!atomic_compare_exchange_weak(&oc_traceBuffers, &head, buffer));
+
+            oc_traceThreadBuffer = buffer;
+        }
+    }
+    return (buffer);
+}
+
+static bool oc_trace_buffer_push(oc_trace_buffer* buffer, oc_trace_event* event, u64 reserve)
+{
+    u64 writeIndex = atomic_load_explicit(&buffer->writeIndex, memory_order_relaxed);
+    u64 readIndex = atomic_load_explicit(&buffer->readIndex, memory_order_acquire);
+
+    if(OC_TRACE_BUFFER_CAP - (writeIndex - readIndex) <= reserve)
+    {
+        atomic_fetch_add_explicit(&oc_traceDroppedCount, 1, memory_order_relaxed);
+        return (false);
+    }
+    buffer->events[writeIndex & (OC_TRACE_BUFFER_CAP - 1)] = *event;
+    atomic_store_explicit(&buffer->writeIndex, writeIndex + 1, memory_order_release);
+    return (true);
+}
+
+void oc_trace_zone_begin(const char* name)
+{
+    oc_trace_buffer* buffer = oc_traceThreadBuffer;
+    if(buffer && buffer->droppedDepth)
+    {
+        buffer->droppedDepth++;
+        return;
+    }
+    if(!atomic_load_explicit(&oc_traceEnabled, memory_order_relaxed))
+    {
+        return;
+    }
+    buffer = oc_trace_thread_buffer();
+    if(!buffer)
+    {
+        return;
+    }
+
+    oc_trace_event event = {
+        .name = name,
+        .time = oc_clock_time(OC_CLOCK_MONOTONIC),
+        .kind = OC_TRACE_EVENT_BEGIN,
+    };
+
+    //NOTE: keep room for the end events of all open zones, so that recorded begins always get their end.
+    //      If the begin doesn't fit, the zone and all its children are dropped.
+    if(oc_trace_buffer_push(buffer, &event, buffer->depth + 1))
+    {
+        buffer->depth++;
+    }
+    else
+    {
+        buffer->droppedDepth = 1;
+    }
+}
+
+void oc_trace_zone_end(void)
+{
+    oc_trace_buffer* buffer = oc_traceThreadBuffer;
+    if(!buffer)
+    {
+        return;
+    }
+    if(buffer->droppedDepth)
+    {
+        buffer->droppedDepth--;
+        return;
+    }
+    if(buffer->depth)
+    {
+        //NOTE: we record the ends of zones that were opened while tracing was enabled, even if it's not enabled anymore.
+        oc_trace_event event = {
+            .time = oc_clock_time(OC_CLOCK_MONOTONIC),
+            .kind = OC_TRACE_EVENT_END,
+        };
+        oc_trace_buffer_push(buffer, &event, 0);
+        buffer->depth--;
+    }
+}
+
+void oc_trace_zone_complete(const char* name, oc_trace_track track, f64 start, f64 end)
+{
+    if(!atomic_load_explicit(&oc_traceEnabled, memory_order_relaxed))
+    {
+        return;
+    }
+    oc_trace_buffer* buffer = oc_trace_thread_buffer();
+    if(buffer && !buffer->droppedDepth)
+    {
+        oc_trace_event event = {
+            .name = name,
+            .time = start,
+            .duration = end - start,
+            .kind = OC_TRACE_EVENT_COMPLETE,
+            .track = track,
+        };
+        oc_trace_buffer_push(buffer, &event, buffer->depth);
+    }
+}
+
+void oc_trace_start(void)
+{
+    //NOTE: discard events left over from a previous trace
+    for(oc_trace_buffer* buffer = atomic_load(&oc_traceBuffers); buffer; buffer = buffer->next)
+    {
+        atomic_store_explicit(&buffer->readIndex,
+                              atomic_load_explicit(&buffer->writeIndex, memory_order_acquire),
+                              memory_order_release);
+    }
+    atomic_store(&oc_traceDroppedCount, 0);
+    oc_traceStartTime = oc_clock_time(OC_CLOCK_MONOTONIC);
+    atomic_store(&oc_traceEnabled, 1);
+}
+
+void oc_trace_stop(void)
+{
+    atomic_store(&oc_traceEnabled, 0);
+}
+
+bool oc_trace_is_enabled(void)
+{
+    return (atomic_load_explicit(&oc_traceEnabled, memory_order_relaxed) != 0);
+}
+
+bool oc_trace_write(oc_str8 path)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+    const char* pathCStr = oc_str8_to_cstring(scratch.arena, path);
+
+    FILE* file = fopen(pathCStr, "w");
+    if(!file)
+    {
+        oc_log_error("Could not open trace file '%s': %s\n", pathCStr, strerror(errno));
+        oc_scratch_end(scratch);
+        return (false);
+    }
+
+    //NOTE: timestamps and durations are in microseconds, relative to the start of the trace.
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":\"gpu\",\"args\":{\"name\":\"GPU\"}},\n");
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":\"overruns\",\"args\":{\"name\":\"Budget overruns\"}}");
+
+    u64 eventCount = 0;
+    for(oc_trace_buffer* buffer = atomic_load(&oc_traceBuffers); buffer; buffer = buffer->next)
+    {
+        u64 readIndex = atomic_load_explicit(&buffer->readIndex, memory_order_relaxed);
+        u64 writeIndex = atomic_load_explicit(&buffer->writeIndex, memory_order_acquire);
+
+        for(; readIndex < writeIndex; readIndex++)
+        {
+            oc_trace_event* event = &buffer->events[readIndex & (OC_TRACE_BUFFER_CAP - 1)];
+            f64 ts = (event->time - oc_traceStartTime) * 1e6;
+
+            char tid[32];
+            if(event->track == OC_TRACE_TRACK_GPU)
+            {
+                snprintf(tid, sizeof(tid), "\"gpu\"");
+            }
+            else if(event->track == OC_TRACE_TRACK_OVERRUNS)
+            {
+                snprintf(tid, sizeof(tid), "\"overruns\"");
+            }
+            else
+            {
+                snprintf(tid, sizeof(tid), "%llu", (unsigned long long)buffer->threadId);
+            }
+
+            switch(event->kind)
+            {
+                case OC_TRACE_EVENT_BEGIN:
+                    fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"B\",\"pid\":0,\"tid\":%s,\"ts\":%.3f}", event->name, tid, ts);
+                    break;
+                case OC_TRACE_EVENT_END:
+                    fprintf(file, ",\n{\"ph\":\"E\",\"pid\":0,\"tid\":%s,\"ts\":%.3f}", tid, ts);
+                    break;
+                case OC_TRACE_EVENT_COMPLETE:
+                    fprintf(file,
+                            ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%s,\"ts\":%.3f,\"dur\":%.3f}",
+                            event->name,
+                            tid,
+                            ts,
+                            event->duration * 1e6);
+                    break;
+            }
+            eventCount++;
+        }
+        atomic_store_explicit(&buffer->readIndex, readIndex, memory_order_release);
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    u64 droppedCount = atomic_load(&oc_traceDroppedCount);
+    if(droppedCount)
+    {
+        oc_log_warning("trace buffers were full, %llu events were dropped\n", (unsigned long long)droppedCount);
+    }
+    oc_log_info("wrote %llu trace events to '%s'\n", (unsigned long long)eventCount, pathCStr);
+
+    oc_scratch_end(scratch);
+    return (true);
+}
@@ -0,0 +1,57 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "platform.h"
+#include "util/strings.h"
+#include "util/typedefs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+//---------------------------------------------------------------
+// Tracing zones
+//---------------------------------------------------------------
+
+//NOTE: zones are recorded in a per-thread ring buffer while tracing is enabled, and drained by oc_trace_write(),
+//      which outputs a chrome trace event file that can be loaded in chrome://tracing or https://ui.perfetto.dev.
+//      Zone names must be string literals (or otherwise outlive the trace). Zones must be properly nested on
+//      each thread.
+
+typedef enum oc_trace_track
+{
+    OC_TRACE_TRACK_THREAD = 0, // the calling thread's own track
+    OC_TRACE_TRACK_GPU,        // GPU work, placed on the CPU timeline at submission time
+    OC_TRACE_TRACK_OVERRUNS,   // guest callbacks that exceeded their time budget
+} oc_trace_track;
+
+#if !defined(OC_PLATFORM_ORCA) || !OC_PLATFORM_ORCA
+
+ORCA_API void oc_trace_start(void);
+ORCA_API void oc_trace_stop(void);
+ORCA_API bool oc_trace_is_enabled(void);
+ORCA_API bool oc_trace_write(oc_str8 path);
+
+ORCA_API void oc_trace_zone_begin(const char* name);
+ORCA_API void oc_trace_zone_end(void);
+ORCA_API void oc_trace_zone_complete(const char* name, oc_trace_track track, f64 start, f64 end);
+
+    #define OC_TRACE_BEGIN(name) oc_trace_zone_begin(name)
+    #define OC_TRACE_END() oc_trace_zone_end()
+
+#else
+
+    #define OC_TRACE_BEGIN(name)
+    #define OC_TRACE_END()
+
+#endif
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
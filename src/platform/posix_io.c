@@ -6,14 +6,27 @@
 *
 **************************************************************************/
 
+#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "platform_io_common.c"
+#include "platform_kv.c"
 #include "platform_io_internal.c"
+#include "platform_io_queue.c"
+
+#if OC_PLATFORM_MACOS
+    #include <CoreServices/CoreServices.h>
+#elif PLATFORM_LINUX
+    #include <poll.h>
+    #include <stdio.h>
+    #include <sys/inotify.h>
+#endif
 
 oc_file_desc oc_file_desc_nil()
 {
@@ -354,6 +367,18 @@ oc_io_error oc_io_raw_fstat_at(oc_file_desc dirFd, oc_str8 path, oc_file_open_fl
     return (error);
 }
 
+oc_io_error oc_io_raw_sync(oc_file_desc fd, oc_file_sync sync)
+{
+    int r = 0;
+#if OC_PLATFORM_MACOS
+    //NOTE: fsync() doesn't flush the drive's cache on macOS, F_FULLFSYNC does
+    r = (sync == OC_FILE_SYNC_FULL) ? fcntl(fd, F_FULLFSYNC) : fsync(fd);
+#else
+    r = (sync == OC_FILE_SYNC_FULL) ? fsync(fd) : fdatasync(fd);
+#endif
+    return (r ? oc_io_raw_last_error() : OC_IO_OK);
+}
+
 oc_io_raw_read_link_result oc_io_raw_read_link_at(oc_arena* arena, oc_file_desc dirFd, oc_str8 path)
 {
     oc_arena_scope scratch = oc_scratch_begin_next(arena);
@@ -428,6 +453,12 @@ bool oc_io_raw_file_exists_at(oc_file_desc dirFd, oc_str8 path, oc_file_open_fla
 oc_io_cmp oc_io_close(oc_file_slot* slot, oc_io_req* req, oc_file_table* table)
 {
     oc_io_cmp cmp = { 0 };
+    cmp.error = oc_io_write_behind_flush(slot);
+
+    if(slot->dirStream)
+    {
+        closedir((DIR*)slot->dirStream);
+    }
     if(slot->fd >= 0)
     {
         close(slot->fd);
@@ -525,6 +556,713 @@ oc_io_cmp oc_io_write(oc_file_slot* slot, oc_io_req* req)
     return (cmp);
 }
 
+oc_io_cmp oc_io_pread(oc_file_slot* slot, oc_io_req* req)
+{
+    oc_io_cmp cmp = { 0 };
+
+    cmp.result = pread(slot->fd, req->buffer, req->size, req->offset);
+
+    if(cmp.result < 0)
+    {
+        slot->error = oc_io_raw_last_error();
+        cmp.result = 0;
+        cmp.error = slot->error;
+    }
+
+    return (cmp);
+}
+
+oc_io_cmp oc_io_pwrite(oc_file_slot* slot, oc_io_req* req)
+{
+    oc_io_cmp cmp = { 0 };
+
+    cmp.result = pwrite(slot->fd, req->buffer, req->size, req->offset);
+
+    if(cmp.result < 0)
+    {
+        slot->error = oc_io_raw_last_error();
+        cmp.result = 0;
+        cmp.error = slot->error;
+    }
+
+    return (cmp);
+}
+
+oc_io_cmp oc_io_preadv_pwritev(oc_file_slot* slot, oc_io_req* req)
+{
+    oc_io_cmp cmp = { 0 };
+
+    if(req->size > IOV_MAX)
+    {
+        cmp.error = OC_IO_ERR_ARG;
+        return (cmp);
+    }
+
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_io_vec* vecs = (oc_io_vec*)req->buffer;
+    struct iovec* iov = oc_arena_push_array(scratch.arena, struct iovec, req->size);
+    for(u64 i = 0; i < req->size; i++)
+    {
+        iov[i].iov_base = vecs[i].buffer;
+        iov[i].iov_len = vecs[i].size;
+    }
+
+    if(req->op == OC_IO_PREADV)
+    {
+        cmp.result = preadv(slot->fd, iov, (int)req->size, req->offset);
+    }
+    else
+    {
+        cmp.result = pwritev(slot->fd, iov, (int)req->size, req->offset);
+    }
+
+    if(cmp.result < 0)
+    {
+        slot->error = oc_io_raw_last_error();
+        cmp.result = 0;
+        cmp.error = slot->error;
+    }
+
+    oc_scratch_end(scratch);
+    return (cmp);
+}
+
+static bool oc_io_is_dot_entry(const char* name)
+{
+    return (!strcmp(name, ".") || !strcmp(name, ".."));
+}
+
+oc_io_cmp oc_io_read_dir(oc_file_slot* slot, oc_io_req* req)
+{
+    oc_io_cmp cmp = { 0 };
+
+    if(slot->type != OC_FILE_DIRECTORY)
+    {
+        cmp.error = OC_IO_ERR_NOT_DIR;
+        return (cmp);
+    }
+
+    DIR* dir = (DIR*)slot->dirStream;
+    if(!dir)
+    {
+        //NOTE: fdopendir() takes ownership of its descriptor, so give it its own
+        int fd = openat(slot->fd, ".", O_RDONLY | O_DIRECTORY);
+        if(fd >= 0)
+        {
+            dir = fdopendir(fd);
+            if(!dir)
+            {
+                close(fd);
+            }
+        }
+        if(!dir)
+        {
+            slot->error = oc_io_raw_last_error();
+            cmp.error = slot->error;
+            return (cmp);
+        }
+        slot->dirStream = dir;
+        slot->dirIndex = 0;
+    }
+
+    if(req->offset < 0 || (u64)req->offset != slot->dirIndex)
+    {
+        rewinddir(dir);
+        slot->dirIndex = 0;
+
+        struct dirent* ent = 0;
+        while(slot->dirIndex < (u64)req->offset && (ent = readdir(dir)))
+        {
+            if(!oc_io_is_dot_entry(ent->d_name))
+            {
+                slot->dirIndex++;
+            }
+        }
+    }
+
+    u64 offset = 0;
+    while(1)
+    {
+        long pos = telldir(dir);
+        errno = 0;
+        struct dirent* ent = readdir(dir);
+        if(!ent)
+        {
+            if(errno)
+            {
+                slot->error = oc_io_raw_last_error();
+                cmp.error = slot->error;
+            }
+            break;
+        }
+        if(oc_io_is_dot_entry(ent->d_name))
+        {
+            continue;
+        }
+
+        oc_file_type type = OC_FILE_UNKNOWN;
+        u64 size = 0;
+        oc_datestamp modificationDate = { 0 };
+
+        //NOTE: the entry can be removed concurrently. In that case we still list it, with an unknown type.
+        struct stat s;
+        if(!fstatat(dirfd(dir), ent->d_name, &s, AT_SYMLINK_NOFOLLOW))
+        {
+            type = oc_io_convert_type_from_stat(s.st_mode);
+            size = s.st_size;
+            modificationDate = oc_datestamp_from_timespec(s.st_mtimespec);
+        }
+
+        if(!oc_io_dir_entry_push(req, &offset, OC_STR8(ent->d_name), type, size, modificationDate))
+        {
+            //NOTE: leave the entry for the next call
+            seekdir(dir, pos);
+            if(cmp.result == 0)
+            {
+                cmp.error = OC_IO_ERR_ARG;
+            }
+            break;
+        }
+        cmp.result++;
+        slot->dirIndex++;
+    }
+
+    return (cmp);
+}
+
+oc_io_cmp oc_io_advise(oc_file_slot* slot, oc_io_req* req)
+{
+    oc_io_cmp cmp = { 0 };
+
+    if(req->offset < 0 || req->advice > OC_FILE_ADVICE_DONTNEED)
+    {
+        cmp.error = OC_IO_ERR_ARG;
+        return (cmp);
+    }
+    if(slot->type != OC_FILE_REGULAR)
+    {
+        return (cmp);
+    }
+
+    int r = 0;
+#if OC_PLATFORM_MACOS
+    //NOTE: macOS has no posix_fadvise(). Read-ahead is toggled per descriptor, and only prefetching takes a range.
+    switch(req->advice)
+    {
+        case OC_FILE_ADVICE_NORMAL:
+        case OC_FILE_ADVICE_SEQUENTIAL:
+            r = fcntl(slot->fd, F_RDAHEAD, 1);
+            break;
+
+        case OC_FILE_ADVICE_RANDOM:
+            r = fcntl(slot->fd, F_RDAHEAD, 0);
+            break;
+
+        case OC_FILE_ADVICE_WILLNEED:
+        {
+            struct radvisory advisory = {
+                .ra_offset = req->offset,
+                .ra_count = (int)oc_min(req->size ? req->size : INT_MAX, INT_MAX),
+            };
+            r = fcntl(slot->fd, F_RDADVISE, &advisory);
+        }
+        break;
+
+        case OC_FILE_ADVICE_DONTNEED:
+            break;
+    }
+#else
+    static const int advices[] = {
+        [OC_FILE_ADVICE_NORMAL] = POSIX_FADV_NORMAL,
+        [OC_FILE_ADVICE_SEQUENTIAL] = POSIX_FADV_SEQUENTIAL,
+        [OC_FILE_ADVICE_RANDOM] = POSIX_FADV_RANDOM,
+        [OC_FILE_ADVICE_WILLNEED] = POSIX_FADV_WILLNEED,
+        [OC_FILE_ADVICE_DONTNEED] = POSIX_FADV_DONTNEED,
+    };
+    r = posix_fadvise(slot->fd, req->offset, req->size, advices[req->advice]);
+    if(r)
+    {
+        errno = r;
+        r = -1;
+    }
+#endif
+
+    if(r < 0)
+    {
+        //NOTE: advice is only a hint, so a failure is reported but doesn't become the file's last error
+        cmp.error = oc_io_raw_last_error();
+    }
+    else if(req->advice == OC_FILE_ADVICE_NORMAL
+            || req->advice == OC_FILE_ADVICE_SEQUENTIAL
+            || req->advice == OC_FILE_ADVICE_RANDOM)
+    {
+        oc_io_read_ahead_enable(slot, req->advice == OC_FILE_ADVICE_SEQUENTIAL);
+    }
+    return (cmp);
+}
+
+#if OC_PLATFORM_MACOS
+
+typedef struct oc_io_fsevents_watch
+{
+    FSEventStreamRef stream;
+    dispatch_queue_t queue;
+    u64 rootLen;
+    char root[PATH_MAX];
+} oc_io_fsevents_watch;
+
+static void oc_io_fsevents_callback(ConstFSEventStreamRef stream,
+                                    void* user,
+                                    size_t count,
+                                    void* eventPaths,
+                                    const FSEventStreamEventFlags eventFlags[],
+                                    const FSEventStreamEventId eventIds[])
+{
+    oc_io_watch* watch = (oc_io_watch*)user;
+    oc_io_fsevents_watch* native = (oc_io_fsevents_watch*)watch->native;
+    char** paths = (char**)eventPaths;
+
+    for(size_t i = 0; i < count; i++)
+    {
+        FSEventStreamEventFlags flags = eventFlags[i];
+        if(flags & (kFSEventStreamEventFlagMustScanSubDirs
+                    | kFSEventStreamEventFlagUserDropped
+                    | kFSEventStreamEventFlagKernelDropped
+                    | kFSEventStreamEventFlagRootChanged))
+        {
+            oc_io_watch_push(watch, OC_FILE_CHANGE_OVERFLOW, (oc_str8){ 0 });
+            continue;
+        }
+
+        //NOTE: paths are absolute, and the stream also sees the directory itself
+        oc_str8 path = OC_STR8(paths[i]);
+        if(path.len <= native->rootLen + 1
+           || memcmp(path.ptr, native->root, native->rootLen)
+           || path.ptr[native->rootLen] != '/')
+        {
+            continue;
+        }
+        path = oc_str8_slice(path, native->rootLen + 1, path.len);
+
+        if(!(watch->flags & OC_FILE_WATCH_RECURSIVE) && memchr(path.ptr, '/', path.len))
+        {
+            continue;
+        }
+
+        //NOTE: flags accumulate everything that happened to the path since the stream started, so they can't tell
+        //      the last change apart. Whether the file exists now can.
+        oc_file_change_kind kind = OC_FILE_CHANGE_MODIFIED;
+        struct stat s;
+        if(lstat(paths[i], &s))
+        {
+            kind = OC_FILE_CHANGE_REMOVED;
+        }
+        else if(flags & (kFSEventStreamEventFlagItemCreated | kFSEventStreamEventFlagItemRenamed))
+        {
+            kind = OC_FILE_CHANGE_ADDED;
+        }
+        oc_io_watch_push(watch, kind, path);
+    }
+}
+
+static void oc_io_fsevents_drain(void* user)
+{
+}
+
+oc_io_error oc_io_raw_watch_start(oc_file_desc fd, oc_io_watch* watch)
+{
+    oc_io_fsevents_watch* native = malloc(sizeof(oc_io_fsevents_watch));
+    if(!native)
+    {
+        return (OC_IO_ERR_MEM);
+    }
+    memset(native, 0, sizeof(oc_io_fsevents_watch));
+
+    //NOTE: FSEvents watches paths, and reports them with symlinks resolved, like F_GETPATH
+    if(fcntl(fd, F_GETPATH, native->root) < 0)
+    {
+        oc_io_error error = oc_io_raw_last_error();
+        free(native);
+        return (error);
+    }
+    native->rootLen = strlen(native->root);
+    if(native->rootLen && native->root[native->rootLen - 1] == '/')
+    {
+        native->rootLen--;
+    }
+    watch->native = native;
+
+    CFStringRef cfRoot = CFStringCreateWithCString(0, native->root, kCFStringEncodingUTF8);
+    CFArrayRef cfPaths = CFArrayCreate(0, (const void**)&cfRoot, 1, &kCFTypeArrayCallBacks);
+    FSEventStreamContext context = { .info = watch };
+
+    native->stream = FSEventStreamCreate(0,
+                                         oc_io_fsevents_callback,
+                                         &context,
+                                         cfPaths,
+                                         kFSEventStreamEventIdSinceNow,
+                                         0.05,
+                                         kFSEventStreamCreateFlagFileEvents
+                                             | kFSEventStreamCreateFlagNoDefer
+                                             | kFSEventStreamCreateFlagWatchRoot);
+    CFRelease(cfPaths);
+    CFRelease(cfRoot);
+
+    if(!native->stream)
+    {
+        free(native);
+        watch->native = 0;
+        return (OC_IO_ERR_UNKNOWN);
+    }
+
+    native->queue = dispatch_queue_create("orca.io.watch", DISPATCH_QUEUE_SERIAL);
+    FSEventStreamSetDispatchQueue(native->stream, native->queue);
+
+    if(!FSEventStreamStart(native->stream))
+    {
+        FSEventStreamInvalidate(native->stream);
+        FSEventStreamRelease(native->stream);
+        dispatch_release(native->queue);
+        free(native);
+        watch->native = 0;
+        return (OC_IO_ERR_UNKNOWN);
+    }
+    return (OC_IO_OK);
+}
+
+void oc_io_raw_watch_stop(oc_io_watch* watch)
+{
+    oc_io_fsevents_watch* native = (oc_io_fsevents_watch*)watch->native;
+
+    FSEventStreamStop(native->stream);
+    FSEventStreamInvalidate(native->stream);
+    FSEventStreamRelease(native->stream);
+
+    //NOTE: wait for a callback that may already be running on the queue
+    dispatch_sync_f(native->queue, 0, oc_io_fsevents_drain);
+    dispatch_release(native->queue);
+
+    free(native);
+    watch->native = 0;
+}
+
+#elif PLATFORM_LINUX
+
+typedef struct oc_io_inotify_dir
+{
+    int wd;
+    char* path; // relative to the watched directory, empty for the directory itself
+} oc_io_inotify_dir;
+
+typedef struct oc_io_inotify_watch
+{
+    oc_io_watch* watch;
+    int fd;
+    int rootFd;
+    int stopPipe[2];
+    oc_thread* thread;
+
+    u32 dirCount;
+    u32 dirCap;
+    oc_io_inotify_dir* dirs;
+} oc_io_inotify_watch;
+
+#define OC_IO_INOTIFY_MASK (IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR)
+
+static oc_io_inotify_dir* oc_io_inotify_find_dir(oc_io_inotify_watch* native, int wd)
+{
+    for(u32 i = 0; i < native->dirCount; i++)
+    {
+        if(native->dirs[i].wd == wd)
+        {
+            return (&native->dirs[i]);
+        }
+    }
+    return (0);
+}
+
+static void oc_io_inotify_remove_dir(oc_io_inotify_watch* native, oc_io_inotify_dir* dir)
+{
+    free(dir->path);
+    *dir = native->dirs[native->dirCount - 1];
+    native->dirCount--;
+}
+
+//NOTE: inotify isn't recursive, so recursive watches add a watch for each subdirectory
+static bool oc_io_inotify_add_tree(oc_io_inotify_watch* native, const char* path)
+{
+    char procPath[PATH_MAX];
+    int len = path[0]
+                ? snprintf(procPath, PATH_MAX, "/proc/self/fd/%i/%s", native->rootFd, path)
+                : snprintf(procPath, PATH_MAX, "/proc/self/fd/%i", native->rootFd);
+    if(len < 0 || len >= PATH_MAX)
+    {
+        return (false);
+    }
+
+    int wd = inotify_add_watch(native->fd, procPath, OC_IO_INOTIFY_MASK);
+    if(wd < 0)
+    {
+        return (false);
+    }
+
+    //NOTE: inotify gives the same descriptor to a directory that was moved, so update its path
+    oc_io_inotify_dir* dir = oc_io_inotify_find_dir(native, wd);
+    if(!dir)
+    {
+        if(native->dirCount == native->dirCap)
+        {
+            u32 cap = oc_max(native->dirCap * 2, 16);
+            oc_io_inotify_dir* dirs = realloc(native->dirs, cap * sizeof(oc_io_inotify_dir));
+            if(!dirs)
+            {
+                inotify_rm_watch(native->fd, wd);
+                return (false);
+            }
+            native->dirs = dirs;
+            native->dirCap = cap;
+        }
+        dir = &native->dirs[native->dirCount];
+        native->dirCount++;
+        dir->wd = wd;
+        dir->path = 0;
+    }
+    free(dir->path);
+    dir->path = strdup(path);
+
+    if(native->watch->flags & OC_FILE_WATCH_RECURSIVE)
+    {
+        int fd = openat(native->rootFd, path[0] ? path : ".", O_RDONLY | O_DIRECTORY);
+        DIR* stream = (fd >= 0) ? fdopendir(fd) : 0;
+        if(!stream)
+        {
+            if(fd >= 0)
+            {
+                close(fd);
+            }
+        }
+        else
+        {
+            struct dirent* ent = 0;
+            while((ent = readdir(stream)))
+            {
+                if(oc_io_is_dot_entry(ent->d_name))
+                {
+                    continue;
+                }
+                bool isDir = (ent->d_type == DT_DIR);
+                if(ent->d_type == DT_UNKNOWN)
+                {
+                    struct stat s;
+                    isDir = !fstatat(dirfd(stream), ent->d_name, &s, AT_SYMLINK_NOFOLLOW) && S_ISDIR(s.st_mode);
+                }
+                if(isDir)
+                {
+                    char childPath[PATH_MAX];
+                    len = path[0]
+                            ? snprintf(childPath, PATH_MAX, "%s/%s", path, ent->d_name)
+                            : snprintf(childPath, PATH_MAX, "%s", ent->d_name);
+                    if(len > 0 && len < PATH_MAX)
+                    {
+                        oc_io_inotify_add_tree(native, childPath);
+                    }
+                }
+            }
+            closedir(stream);
+        }
+    }
+    return (true);
+}
+
+static void oc_io_inotify_process(oc_io_inotify_watch* native, struct inotify_event* event)
+{
+    oc_io_watch* watch = native->watch;
+
+    if(event->mask & IN_Q_OVERFLOW)
+    {
+        oc_io_watch_push(watch, OC_FILE_CHANGE_OVERFLOW, (oc_str8){ 0 });
+        return;
+    }
+
+    oc_io_inotify_dir* dir = oc_io_inotify_find_dir(native, event->wd);
+    if(!dir)
+    {
+        return;
+    }
+    if(event->mask & IN_IGNORED)
+    {
+        oc_io_inotify_remove_dir(native, dir);
+        return;
+    }
+    if(!event->len)
+    {
+        //NOTE: change to the directory itself, which is reported by its parent
+        return;
+    }
+
+    char path[PATH_MAX];
+    int len = dir->path[0]
+                ? snprintf(path, PATH_MAX, "%s/%s", dir->path, event->name)
+                : snprintf(path, PATH_MAX, "%s", event->name);
+    if(len < 0 || len >= PATH_MAX)
+    {
+        return;
+    }
+
+    oc_file_change_kind kind = OC_FILE_CHANGE_MODIFIED;
+    if(event->mask & (IN_CREATE | IN_MOVED_TO))
+    {
+        kind = OC_FILE_CHANGE_ADDED;
+        if((event->mask & IN_ISDIR) && (watch->flags & OC_FILE_WATCH_RECURSIVE))
+        {
+            oc_io_inotify_add_tree(native, path);
+        }
+    }
+    else if(event->mask & (IN_DELETE | IN_MOVED_FROM))
+    {
+        kind = OC_FILE_CHANGE_REMOVED;
+    }
+    oc_io_watch_push(watch, kind, oc_str8_from_buffer(len, path));
+}
+
+static i32 oc_io_inotify_thread(void* user)
+{
+    oc_io_inotify_watch* native = (oc_io_inotify_watch*)user;
+
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd fds[2] = {
+        { .fd = native->fd, .events = POLLIN },
+        { .fd = native->stopPipe[0], .events = POLLIN },
+    };
+
+    while(1)
+    {
+        if(poll(fds, 2, -1) < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        if(fds[1].revents)
+        {
+            break;
+        }
+
+        ssize_t size = read(native->fd, buffer, sizeof(buffer));
+        if(size < 0 && (errno == EINTR || errno == EAGAIN))
+        {
+            continue;
+        }
+        else if(size <= 0)
+        {
+            break;
+        }
+
+        char* at = buffer;
+        while(at < buffer + size)
+        {
+            struct inotify_event* event = (struct inotify_event*)at;
+            oc_io_inotify_process(native, event);
+            at += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    return (0);
+}
+
+static void oc_io_inotify_destroy(oc_io_inotify_watch* native)
+{
+    for(u32 i = 0; i < native->dirCount; i++)
+    {
+        free(native->dirs[i].path);
+    }
+    free(native->dirs);
+
+    if(native->stopPipe[0] >= 0)
+    {
+        close(native->stopPipe[0]);
+        close(native->stopPipe[1]);
+    }
+    if(native->rootFd >= 0)
+    {
+        close(native->rootFd);
+    }
+    if(native->fd >= 0)
+    {
+        close(native->fd);
+    }
+    free(native);
+}
+
+oc_io_error oc_io_raw_watch_start(oc_file_desc fd, oc_io_watch* watch)
+{
+    oc_io_inotify_watch* native = malloc(sizeof(oc_io_inotify_watch));
+    if(!native)
+    {
+        return (OC_IO_ERR_MEM);
+    }
+    memset(native, 0, sizeof(oc_io_inotify_watch));
+    native->watch = watch;
+    native->fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    native->rootFd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    native->stopPipe[0] = native->stopPipe[1] = -1;
+
+    oc_io_error error = OC_IO_OK;
+    if(native->fd < 0 || native->rootFd < 0 || pipe(native->stopPipe) < 0)
+    {
+        error = oc_io_raw_last_error();
+        native->stopPipe[0] = native->stopPipe[1] = -1;
+    }
+    else if(!oc_io_inotify_add_tree(native, ""))
+    {
+        error = oc_io_raw_last_error();
+    }
+    else
+    {
+        native->thread = oc_thread_create_with_name(oc_io_inotify_thread, native, OC_STR8("io watch"));
+        if(!native->thread)
+        {
+            error = OC_IO_ERR_UNKNOWN;
+        }
+    }
+
+    if(error != OC_IO_OK)
+    {
+        oc_io_inotify_destroy(native);
+        return (error);
+    }
+    watch->native = native;
+    return (OC_IO_OK);
+}
+
+void oc_io_raw_watch_stop(oc_io_watch* watch)
+{
+    oc_io_inotify_watch* native = (oc_io_inotify_watch*)watch->native;
+
+    char byte = 0;
+    while(write(native->stopPipe[1], &byte, 1) < 0 && errno == EINTR)
+    {
+    }
+    oc_thread_join(native->thread, 0);
+    oc_io_inotify_destroy(native);
+    watch->native = 0;
+}
+
+#else
+
+oc_io_error oc_io_raw_watch_start(oc_file_desc fd, oc_io_watch* watch)
+{
+    return (OC_IO_ERR_OP);
+}
+
+void oc_io_raw_watch_stop(oc_io_watch* watch)
+{
+}
+
+#endif
+
 oc_io_cmp oc_io_get_error(oc_file_slot* slot, oc_io_req* req)
 {
     oc_io_cmp cmp = { 0 };
@@ -550,9 +1288,24 @@ oc_io_cmp oc_io_wait_single_req_for_table(oc_io_req* req, oc_file_table* table)
     {
         cmp.error = OC_IO_ERR_PREV;
     }
+    else if(req->op != OC_IO_WRITE && req->op != OC_IO_CLOSE && req->op != OC_OC_IO_ERROR)
+    {
+        //NOTE: other requests see buffered writes as done. Closing flushes them itself.
+        cmp.error = oc_io_write_behind_flush(slot);
+    }
 
-    if(cmp.error == OC_IO_OK)
+    if(cmp.error == OC_IO_OK && slot && slot->memoryBacked)
     {
+        cmp = oc_io_memory_req(slot, req, table);
+    }
+    else if(cmp.error == OC_IO_OK)
+    {
+        if(slot && (req->op == OC_IO_WRITE || req->op == OC_IO_PWRITE || req->op == OC_IO_PWRITEV))
+        {
+            //NOTE: writes use the descriptor's position, or may overwrite bytes in the read-ahead buffer
+            oc_io_read_ahead_sync(slot);
+        }
+
         switch(req->op)
         {
             case OC_IO_OPEN_AT:
@@ -568,15 +1321,52 @@ oc_io_cmp oc_io_wait_single_req_for_table(oc_io_req* req, oc_file_table* table)
                 break;
 
             case OC_IO_READ:
-                cmp = oc_io_read(slot, req);
+                cmp = oc_io_read_buffered(slot, req);
                 break;
 
             case OC_IO_WRITE:
-                cmp = oc_io_write(slot, req);
+                cmp = oc_io_write_buffered(slot, req);
                 break;
 
             case OC_IO_SEEK:
-                cmp = oc_io_seek(slot, req);
+                cmp = oc_io_seek_buffered(slot, req);
+                break;
+
+            case OC_IO_PREAD:
+                cmp = oc_io_pread(slot, req);
+                break;
+
+            case OC_IO_PWRITE:
+                cmp = oc_io_pwrite(slot, req);
+                break;
+
+            case OC_IO_PREADV:
+            case OC_IO_PWRITEV:
+                cmp = oc_io_preadv_pwritev(slot, req);
+                break;
+
+            case OC_IO_READDIR:
+                cmp = oc_io_read_dir(slot, req);
+                break;
+
+            case OC_IO_ADVISE:
+                cmp = oc_io_advise(slot, req);
+                break;
+
+            case OC_IO_WRITE_BUFFER:
+                cmp = oc_io_set_write_buffer(slot, req);
+                break;
+
+            case OC_IO_FLUSH:
+                cmp = oc_io_flush(slot, req);
+                break;
+
+            case OC_IO_WATCH:
+                cmp = oc_io_set_watch(slot, req, table);
+                break;
+
+            case OC_IO_READ_CHANGES:
+                cmp = oc_io_read_changes(slot, req);
                 break;
 
             case OC_OC_IO_ERROR:
@@ -590,3 +1380,59 @@ oc_io_cmp oc_io_wait_single_req_for_table(oc_io_req* req, oc_file_table* table)
     }
     return (cmp);
 }
+
+oc_str8 oc_file_map_read_only(oc_str8 path)
+{
+    oc_str8 mapping = { 0 };
+
+    oc_file_desc fd = oc_io_raw_open_at(oc_file_desc_nil(), path, OC_FILE_ACCESS_READ, OC_FILE_OPEN_NONE);
+    if(!oc_file_desc_is_nil(fd))
+    {
+        oc_file_status status = { 0 };
+        if(oc_io_raw_fstat(fd, &status) == OC_IO_OK && status.size)
+        {
+            void* ptr = mmap(0, status.size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(ptr != MAP_FAILED)
+            {
+                mapping = oc_str8_from_buffer(status.size, ptr);
+            }
+        }
+        //NOTE: the mapping keeps a reference to the file, so we can close the descriptor right away
+        oc_io_raw_close(fd);
+    }
+    return (mapping);
+}
+
+void oc_file_unmap(oc_str8 mapping)
+{
+    if(mapping.ptr)
+    {
+        munmap(mapping.ptr, mapping.len);
+    }
+}
+
+u64 oc_io_map_granularity(void)
+{
+    return (getpagesize());
+}
+
+oc_io_error oc_io_map_fixed(oc_file_slot* slot, u64 offset, u64 size, void* addr)
+{
+    oc_io_error error = OC_IO_OK;
+
+    //NOTE: the mapping is private, so writes to the mapped pages never reach the file
+    void* ptr = mmap(addr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, slot->fd, offset);
+    if(ptr == MAP_FAILED)
+    {
+        error = oc_io_raw_last_error();
+
+        //NOTE: a failed fixed mapping may have removed the pages that were there
+        oc_io_unmap_fixed(addr, size);
+    }
+    return (error);
+}
+
+void oc_io_unmap_fixed(void* addr, u64 size)
+{
+    mmap(addr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED | MAP_ANON, -1, 0);
+}
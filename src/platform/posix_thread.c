@@ -11,6 +11,7 @@
 #include <string.h>
 #include <sys/time.h>
 #include <unistd.h> // nanosleep()
+#include <pthread/qos.h>
 
 #include "platform_thread.h"
 
@@ -24,6 +25,23 @@ struct oc_thread
     char nameBuffer[OC_THREAD_NAME_MAX_SIZE];
 };
 
+static qos_class_t oc_thread_priority_to_qos(oc_thread_priority priority)
+{
+    switch(priority)
+    {
+        case OC_THREAD_PRIORITY_BACKGROUND:
+            return (QOS_CLASS_BACKGROUND);
+        case OC_THREAD_PRIORITY_UTILITY:
+            return (QOS_CLASS_UTILITY);
+        case OC_THREAD_PRIORITY_HIGH:
+            return (QOS_CLASS_USER_INITIATED);
+        case OC_THREAD_PRIORITY_FRAME:
+            return (QOS_CLASS_USER_INTERACTIVE);
+        default:
+            return (QOS_CLASS_DEFAULT);
+    }
+}
+
 static void* oc_thread_bootstrap(void* data)
 {
     oc_thread* thread = (oc_thread*)data;
@@ -35,8 +53,9 @@ static void* oc_thread_bootstrap(void* data)
     return ((void*)(ptrdiff_t)exitCode);
 }
 
-oc_thread* oc_thread_create_with_name(oc_thread_start_proc start, void* userPointer, oc_str8 name)
+oc_thread* oc_thread_create_with_options(oc_thread_start_proc start, void* userPointer, oc_thread_options* options)
 {
+    oc_str8 name = options->name;
     oc_thread* thread = (oc_thread*)malloc(sizeof(oc_thread));
     if(!thread)
     {
@@ -57,7 +76,17 @@ oc_thread* oc_thread_create_with_name(oc_thread_start_proc start, void* userPoin
     thread->start = start;
     thread->userPointer = userPointer;
 
-    if(pthread_create(&thread->pthread, 0, oc_thread_bootstrap, thread) != 0)
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if(options->priority != OC_THREAD_PRIORITY_NORMAL)
+    {
+        pthread_attr_set_qos_class_np(&attr, oc_thread_priority_to_qos(options->priority), 0);
+    }
+
+    int err = pthread_create(&thread->pthread, &attr, oc_thread_bootstrap, thread);
+    pthread_attr_destroy(&attr);
+
+    if(err != 0)
     {
         free(thread);
         return (0);
@@ -69,11 +98,64 @@ oc_thread* oc_thread_create_with_name(oc_thread_start_proc start, void* userPoin
     }
 }
 
+oc_thread* oc_thread_create_with_name(oc_thread_start_proc start, void* userPointer, oc_str8 name)
+{
+    oc_thread_options options = { .name = name };
+    return (oc_thread_create_with_options(start, userPointer, &options));
+}
+
 oc_thread* oc_thread_create(oc_thread_start_proc start, void* userPointer)
 {
     return (oc_thread_create_with_name(start, userPointer, (oc_str8){ 0 }));
 }
 
+int oc_thread_set_priority(oc_thread* thread, oc_thread_priority priority)
+{
+    if(!thread || pthread_equal(thread->pthread, pthread_self()))
+    {
+        return (pthread_set_qos_class_self_np(oc_thread_priority_to_qos(priority), 0) ? -1 : 0);
+    }
+    else
+    {
+        //NOTE: spread the priorities over the range of the default policy, normal being its default priority
+        int policy = 0;
+        struct sched_param param = { 0 };
+        if(pthread_getschedparam(thread->pthread, &policy, &param))
+        {
+            return (-1);
+        }
+        int minPriority = sched_get_priority_min(policy);
+        int maxPriority = sched_get_priority_max(policy);
+        int normalPriority = (minPriority + maxPriority) / 2;
+
+        switch(priority)
+        {
+            case OC_THREAD_PRIORITY_BACKGROUND:
+                param.sched_priority = minPriority;
+                break;
+            case OC_THREAD_PRIORITY_UTILITY:
+                param.sched_priority = (minPriority + normalPriority) / 2;
+                break;
+            case OC_THREAD_PRIORITY_HIGH:
+                param.sched_priority = (normalPriority + maxPriority) / 2;
+                break;
+            case OC_THREAD_PRIORITY_FRAME:
+                param.sched_priority = maxPriority;
+                break;
+            default:
+                param.sched_priority = normalPriority;
+                break;
+        }
+        return (pthread_setschedparam(thread->pthread, policy, &param) ? -1 : 0);
+    }
+}
+
+int oc_thread_set_affinity(oc_thread* thread, u64 affinityMask)
+{
+    //NOTE: macOS has no API to pin a thread to a set of cores
+    return (affinityMask ? -1 : 0);
+}
+
 oc_str8 oc_thread_get_name(oc_thread* thread)
 {
     return (thread->name);
@@ -254,3 +336,9 @@ void oc_sleep_nano(u64 nanoseconds)
     rqtp.tv_nsec = nanoseconds - rqtp.tv_sec * 1000000000;
     nanosleep(&rqtp, 0);
 }
+
+u32 oc_cpu_count(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0 ? (u32)count : 1);
+}
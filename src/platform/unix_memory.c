@@ -7,15 +7,29 @@
 **************************************************************************/
 #include "platform_memory.h"
 #include <sys/mman.h>
+#include <unistd.h>
 
 /*NOTE(martin):
-	Linux and MacOS don't make a distinction between reserved and committed memory, contrary to Windows
+	Linux and MacOS don't make a distinction between reserved and committed memory, contrary to Windows.
+	We reserve inaccessible pages and make them accessible on commit, so that accessing reserved but
+	uncommitted memory faults like it does on Windows. The wasm guard pages mode relies on that.
 */
 void oc_base_nop(oc_base_allocator* context, void* ptr, u64 size) {}
 
 void* oc_base_reserve_mmap(oc_base_allocator* context, u64 size)
 {
-    return (mmap(0, size, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, 0, 0));
+    void* mem = mmap(0, size, PROT_NONE, MAP_ANON | MAP_PRIVATE, -1, 0);
+    return ((mem == MAP_FAILED) ? 0 : mem);
+}
+
+bool oc_base_commit_mprotect(oc_base_allocator* context, void* ptr, u64 size)
+{
+    //NOTE: callers commit in 4K increments, which can be smaller than the OS page size (e.g. 16K on Apple Silicon),
+    //      so we extend the range to page boundaries. Reservations are page aligned so this stays inside the reserved range.
+    u64 pageSize = getpagesize();
+    uintptr_t start = oc_align_down_pow2((uintptr_t)ptr, pageSize);
+    uintptr_t end = oc_align_up_pow2((uintptr_t)ptr + size, pageSize);
+    return (mprotect((void*)start, end - start, PROT_READ | PROT_WRITE) == 0);
 }
 
 void oc_base_release_mmap(oc_base_allocator* context, void* ptr, u64 size)
@@ -23,14 +37,117 @@ void oc_base_release_mmap(oc_base_allocator* context, void* ptr, u64 size)
     munmap(ptr, size);
 }
 
+void oc_base_decommit_madvise(oc_base_allocator* context, void* ptr, u64 size)
+{
+    //NOTE: the range stays mapped and accessible, but its physical pages can be reclaimed by the OS.
+    //      We only touch pages that are entirely inside the range.
+    u64 pageSize = getpagesize();
+    uintptr_t start = oc_align_up_pow2((uintptr_t)ptr, pageSize);
+    uintptr_t end = oc_align_down_pow2((uintptr_t)ptr + size, pageSize);
+    if(start < end)
+    {
+    #ifdef MADV_FREE
+        madvise((void*)start, end - start, MADV_FREE);
+    #else
+        madvise((void*)start, end - start, MADV_DONTNEED);
+    #endif
+    }
+}
+
+u64 oc_base_resident_size(void* ptr, u64 size)
+{
+    u64 pageSize = getpagesize();
+    char* start = (char*)oc_align_down_pow2((uintptr_t)ptr, pageSize);
+    char* end = (char*)oc_align_up_pow2((uintptr_t)ptr + size, pageSize);
+
+    u64 resident = 0;
+    char vec[256];
+    for(char* chunk = start; chunk < end; chunk += sizeof(vec) * pageSize)
+    {
+        u64 chunkSize = oc_min((u64)(end - chunk), sizeof(vec) * pageSize);
+        if(mincore(chunk, chunkSize, (void*)vec) != 0)
+        {
+            break;
+        }
+        for(u64 i = 0; i < chunkSize / pageSize; i++)
+        {
+            if(vec[i] & 1)
+            {
+                resident += pageSize;
+            }
+        }
+    }
+    return (resident);
+}
+
+//------------------------------------------------------------------------------------------------
+// large pages
+//------------------------------------------------------------------------------------------------
+
+void* oc_base_reserve_large_pages(oc_base_allocator* context, u64 size)
+{
+    //NOTE: reserve an extra large page and trim the reservation to a large page boundary
+    size = oc_align_up_pow2(size, OC_BASE_LARGE_PAGE_SIZE);
+
+    char* mem = mmap(0, size + OC_BASE_LARGE_PAGE_SIZE, PROT_NONE, MAP_ANON | MAP_PRIVATE, -1, 0);
+    if(mem == MAP_FAILED)
+    {
+        return (0);
+    }
+    char* aligned = (char*)oc_align_up_pow2((uintptr_t)mem, OC_BASE_LARGE_PAGE_SIZE);
+    if(aligned > mem)
+    {
+        munmap(mem, aligned - mem);
+    }
+    if(aligned + size < mem + size + OC_BASE_LARGE_PAGE_SIZE)
+    {
+        munmap(aligned + size, (mem + size + OC_BASE_LARGE_PAGE_SIZE) - (aligned + size));
+    }
+    return (aligned);
+}
+
+bool oc_base_commit_large_pages(oc_base_allocator* context, void* ptr, u64 size)
+{
+    uintptr_t start = oc_align_down_pow2((uintptr_t)ptr, OC_BASE_LARGE_PAGE_SIZE);
+    uintptr_t end = oc_align_up_pow2((uintptr_t)ptr + size, OC_BASE_LARGE_PAGE_SIZE);
+
+    if(mprotect((void*)start, end - start, PROT_READ | PROT_WRITE) != 0)
+    {
+        return (false);
+    }
+    #ifdef MADV_HUGEPAGE
+    //NOTE: committed ranges are whole, aligned large pages, so the kernel can back them with transparent huge pages
+    madvise((void*)start, end - start, MADV_HUGEPAGE);
+    #endif
+    return (true);
+}
+
+void oc_base_release_large_pages(oc_base_allocator* context, void* ptr, u64 size)
+{
+    munmap(ptr, oc_align_up_pow2(size, OC_BASE_LARGE_PAGE_SIZE));
+}
+
+oc_base_allocator* oc_base_allocator_large_pages()
+{
+    static oc_base_allocator base = {};
+    if(base.reserve == 0)
+    {
+        base.reserve = oc_base_reserve_large_pages;
+        base.commit = oc_base_commit_large_pages;
+        base.decommit = oc_base_decommit_madvise;
+        base.release = oc_base_release_large_pages;
+    }
+    return (&base);
+}
+
 oc_base_allocator* oc_base_allocator_default()
 {
     static oc_base_allocator base = {};
     if(base.reserve == 0)
     {
         base.reserve = oc_base_reserve_mmap;
-        base.commit = oc_base_nop;
-        base.decommit = oc_base_nop;
+        base.commit = oc_base_commit_mprotect;
+        base.decommit = oc_base_decommit_madvise;
         base.release = oc_base_release_mmap;
     }
     return (&base);
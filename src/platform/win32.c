@@ -1,15 +1,16 @@
-/*************************************************************************
-*
-*  Orca
-*  Copyright 2023 Martin Fouilleul and the Orca project contributors
-*  See LICENSE.txt for licensing information
-*
-**************************************************************************/
-
-#include "platform/win32_memory.c"
-#include "platform/win32_clock.c"
-#include "platform/win32_string_helpers.c"
-#include "platform/win32_path.c"
-#include "platform/win32_io.c"
-#include "platform/win32_thread.c"
-#include "platform/win32_platform.c"
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+
+#include "platform/win32_memory.c"
+#include "platform/win32_clock.c"
+#include "platform/win32_string_helpers.c"
+#include "platform/win32_path.c"
+#include "platform/win32_io.c"
+#include "platform/win32_audio.c"
+#include "platform/win32_thread.c"
+#include "platform/win32_platform.c"
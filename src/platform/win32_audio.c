@@ -0,0 +1,259 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#define COBJMACROS
+#include <mmdeviceapi.h>
+#include <audioclient.h>
+#include <avrt.h> // MMCSS
+
+#include "platform_audio_internal.h"
+#include "platform_audio_common.c"
+
+//NOTE: the SDK only declares these GUIDs, so we define our own copies
+static const CLSID OC_CLSID_MMDeviceEnumerator = { 0xbcde0395, 0xe52f, 0x467c, { 0x8e, 0x3d, 0xc4, 0x57, 0x92, 0x91, 0x69, 0x2e } };
+static const IID OC_IID_IMMDeviceEnumerator = { 0xa95664d2, 0x9614, 0x4f35, { 0xa7, 0x46, 0xde, 0x8d, 0xb6, 0x36, 0x17, 0xe6 } };
+static const IID OC_IID_IAudioClient = { 0x1cb9ad4c, 0xdbfa, 0x4c32, { 0xb1, 0x78, 0xc2, 0xf5, 0x68, 0xa7, 0x03, 0xb2 } };
+static const IID OC_IID_IAudioRenderClient = { 0xf294acfc, 0x3146, 0x4483, { 0xa7, 0xbf, 0xad, 0xdc, 0xa7, 0xc2, 0x60, 0xe2 } };
+static const GUID OC_KSDATAFORMAT_SUBTYPE_IEEE_FLOAT = { 0x00000003, 0x0000, 0x0010, { 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71 } };
+
+/*NOTE:
+	WASAPI objects live on the device thread, which initializes COM in the multithreaded apartment regardless of
+	what the app's thread uses. The thread sets up the client and signals readyEvent, then waits for startEvent
+	before it starts pulling frames, so that the queue exists by then.
+*/
+typedef struct oc_audio_win32
+{
+    HANDLE thread;
+    HANDLE readyEvent;
+    HANDLE startEvent;
+    HANDLE stopEvent;
+    HANDLE bufferEvent;
+    bool ok;
+
+    IMMDeviceEnumerator* enumerator;
+    IMMDevice* device;
+    IAudioClient* client;
+    IAudioRenderClient* render;
+} oc_audio_win32;
+
+static bool oc_audio_win32_setup(oc_audio_output* output, oc_audio_win32* native)
+{
+    HRESULT hr = CoCreateInstance(&OC_CLSID_MMDeviceEnumerator, 0, CLSCTX_ALL, &OC_IID_IMMDeviceEnumerator, (void**)&native->enumerator);
+    if(SUCCEEDED(hr))
+    {
+        hr = IMMDeviceEnumerator_GetDefaultAudioEndpoint(native->enumerator, eRender, eConsole, &native->device);
+    }
+    if(SUCCEEDED(hr))
+    {
+        hr = IMMDevice_Activate(native->device, &OC_IID_IAudioClient, CLSCTX_ALL, 0, (void**)&native->client);
+    }
+    if(FAILED(hr))
+    {
+        oc_log_error("couldn't open the default audio endpoint (0x%08lx)\n", hr);
+        return (false);
+    }
+
+    if(!output->sampleRate)
+    {
+        WAVEFORMATEX* mixFormat = 0;
+        if(SUCCEEDED(IAudioClient_GetMixFormat(native->client, &mixFormat)))
+        {
+            output->sampleRate = mixFormat->nSamplesPerSec;
+            CoTaskMemFree(mixFormat);
+        }
+        else
+        {
+            output->sampleRate = 48000;
+        }
+    }
+
+    WAVEFORMATEXTENSIBLE format = {
+        .Format = {
+            .wFormatTag = WAVE_FORMAT_EXTENSIBLE,
+            .nChannels = output->channelCount,
+            .nSamplesPerSec = output->sampleRate,
+            .nAvgBytesPerSec = output->sampleRate * output->frameSize,
+            .nBlockAlign = output->frameSize,
+            .wBitsPerSample = 32,
+            .cbSize = sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX),
+        },
+        .Samples.wValidBitsPerSample = 32,
+        .dwChannelMask = (output->channelCount == 2) ? (SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT) : 0,
+        .SubFormat = OC_KSDATAFORMAT_SUBTYPE_IEEE_FLOAT,
+    };
+
+    //NOTE: let the audio engine convert our format to the mix format. A zero duration picks the engine's period.
+    DWORD flags = AUDCLNT_STREAMFLAGS_EVENTCALLBACK
+                | AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM
+                | AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY;
+
+    hr = IAudioClient_Initialize(native->client, AUDCLNT_SHAREMODE_SHARED, flags, 0, 0, (WAVEFORMATEX*)&format, 0);
+    if(SUCCEEDED(hr))
+    {
+        hr = IAudioClient_SetEventHandle(native->client, native->bufferEvent);
+    }
+    if(SUCCEEDED(hr))
+    {
+        hr = IAudioClient_GetService(native->client, &OC_IID_IAudioRenderClient, (void**)&native->render);
+    }
+    UINT32 deviceFrames = 0;
+    if(SUCCEEDED(hr))
+    {
+        hr = IAudioClient_GetBufferSize(native->client, &deviceFrames);
+    }
+    if(FAILED(hr))
+    {
+        oc_log_error("couldn't set up the audio client (0x%08lx)\n", hr);
+        return (false);
+    }
+    output->deviceFrames = deviceFrames;
+
+    REFERENCE_TIME streamLatency = 0;
+    IAudioClient_GetStreamLatency(native->client, &streamLatency);
+
+    //NOTE: reference times are in 100ns units
+    output->deviceLatency = streamLatency * 1e-7 + (f64)deviceFrames / output->sampleRate;
+    return (true);
+}
+
+static void oc_audio_win32_fill(oc_audio_output* output, oc_audio_win32* native)
+{
+    UINT32 padding = 0;
+    if(SUCCEEDED(IAudioClient_GetCurrentPadding(native->client, &padding)))
+    {
+        UINT32 frameCount = output->deviceFrames - padding;
+        BYTE* data = 0;
+        if(frameCount && SUCCEEDED(IAudioRenderClient_GetBuffer(native->render, frameCount, &data)))
+        {
+            oc_audio_output_pull(output, frameCount, (f32*)data);
+            IAudioRenderClient_ReleaseBuffer(native->render, frameCount, 0);
+        }
+    }
+}
+
+static DWORD WINAPI oc_audio_win32_thread(LPVOID param)
+{
+    oc_audio_output* output = (oc_audio_output*)param;
+    oc_audio_win32* native = (oc_audio_win32*)output->native;
+
+    HRESULT comResult = CoInitializeEx(0, COINIT_MULTITHREADED);
+
+    native->ok = SUCCEEDED(comResult) && oc_audio_win32_setup(output, native);
+    SetEvent(native->readyEvent);
+
+    HANDLE startEvents[2] = { native->stopEvent, native->startEvent };
+    if(native->ok && WaitForMultipleObjects(2, startEvents, FALSE, INFINITE) == WAIT_OBJECT_0 + 1)
+    {
+        DWORD taskIndex = 0;
+        HANDLE mmcssTask = AvSetMmThreadCharacteristicsW(L"Pro Audio", &taskIndex);
+
+        //NOTE: fill the device buffer before starting, so that the first period isn't silent
+        oc_audio_win32_fill(output, native);
+        IAudioClient_Start(native->client);
+
+        HANDLE events[2] = { native->stopEvent, native->bufferEvent };
+        while(WaitForMultipleObjects(2, events, FALSE, INFINITE) == WAIT_OBJECT_0 + 1)
+        {
+            oc_audio_win32_fill(output, native);
+        }
+        IAudioClient_Stop(native->client);
+
+        if(mmcssTask)
+        {
+            AvRevertMmThreadCharacteristics(mmcssTask);
+        }
+    }
+
+    if(native->render)
+    {
+        IAudioRenderClient_Release(native->render);
+    }
+    if(native->client)
+    {
+        IAudioClient_Release(native->client);
+    }
+    if(native->device)
+    {
+        IMMDevice_Release(native->device);
+    }
+    if(native->enumerator)
+    {
+        IMMDeviceEnumerator_Release(native->enumerator);
+    }
+    if(SUCCEEDED(comResult))
+    {
+        CoUninitialize();
+    }
+    return (0);
+}
+
+static void oc_audio_win32_destroy(oc_audio_win32* native)
+{
+    if(native->thread)
+    {
+        SetEvent(native->stopEvent);
+        WaitForSingleObject(native->thread, INFINITE);
+        CloseHandle(native->thread);
+    }
+    HANDLE events[4] = { native->readyEvent, native->startEvent, native->stopEvent, native->bufferEvent };
+    for(int i = 0; i < 4; i++)
+    {
+        if(events[i])
+        {
+            CloseHandle(events[i]);
+        }
+    }
+    free(native);
+}
+
+bool oc_audio_native_open(oc_audio_output* output)
+{
+    oc_audio_win32* native = calloc(1, sizeof(oc_audio_win32));
+    if(!native)
+    {
+        return (false);
+    }
+    output->native = native;
+
+    native->readyEvent = CreateEvent(0, FALSE, FALSE, 0);
+    native->startEvent = CreateEvent(0, FALSE, FALSE, 0);
+    native->stopEvent = CreateEvent(0, FALSE, FALSE, 0);
+    native->bufferEvent = CreateEvent(0, FALSE, FALSE, 0);
+
+    if(native->readyEvent && native->startEvent && native->stopEvent && native->bufferEvent)
+    {
+        native->thread = CreateThread(0, 0, oc_audio_win32_thread, output, 0, 0);
+    }
+    if(native->thread)
+    {
+        WaitForSingleObject(native->readyEvent, INFINITE);
+    }
+
+    if(!native->ok)
+    {
+        oc_audio_win32_destroy(native);
+        output->native = 0;
+        return (false);
+    }
+    return (true);
+}
+
+void oc_audio_native_start(oc_audio_output* output)
+{
+    oc_audio_win32* native = (oc_audio_win32*)output->native;
+    SetEvent(native->startEvent);
+}
+
+void oc_audio_native_close(oc_audio_output* output)
+{
+    oc_audio_win32* native = (oc_audio_win32*)output->native;
+    if(native)
+    {
+        oc_audio_win32_destroy(native);
+        output->native = 0;
+    }
+}
@@ -7,6 +7,10 @@
 **************************************************************************/
 #include <profileapi.h>
 
+#if OC_ARCH_X64
+    #include <intrin.h> // __cpuid(), __rdtsc()
+#endif
+
 #include "platform_clock.h"
 #include "util/typedefs.h"
 
@@ -18,11 +22,95 @@ static u64 __performanceCounterFreq = 0;
 
 const u64 WIN_EPOCH_TO_UNIX_EPOCH_100NS = 116444736000000000; // number of 100ns from Jan 1, 1601 (windows epoch) to  Jan 1, 1970 (unix epoch)
 
+//NOTE: when the CPU has an invariant TSC, the monotonic clock reads it directly instead of calling
+//      QueryPerformanceCounter(), so that it's cheap enough to timestamp trace zones and per-frame work.
+//      The TSC frequency isn't exposed by Windows, so it is calibrated against the performance counter at init.
+//      Like the performance counter, the TSC based time isn't meant to be compared across a system sleep.
+static bool __tscEnabled = false;
+static f64 __tscSecondsPerTick = 0;
+static u64 __tscAnchor = 0;
+static f64 __tscAnchorTime = 0;
+
+static const f64 OC_CLOCK_TSC_CALIBRATION_TIME = 0.005;
+
+#if OC_ARCH_X64
+static bool oc_clock_has_invariant_tsc()
+{
+    int regs[4] = { 0 };
+    __cpuid(regs, 0x80000000);
+    if((u32)regs[0] < 0x80000007)
+    {
+        return (false);
+    }
+    __cpuid(regs, 0x80000007);
+    return ((regs[3] & (1 << 8)) != 0);
+}
+
+//NOTE: reads the performance counter and the TSC at (almost) the same instant, taking the TSC at the middle of
+//      the narrowest bracket out of a few tries, so that a preemption between the two reads doesn't skew calibration
+static void oc_clock_tsc_sample(i64* outCounter, u64* outTsc)
+{
+    u64 bestWidth = ~0ULL;
+    for(int i = 0; i < 8; i++)
+    {
+        LARGE_INTEGER counter;
+        u64 before = __rdtsc();
+        QueryPerformanceCounter(&counter);
+        u64 after = __rdtsc();
+
+        if(after - before < bestWidth)
+        {
+            bestWidth = after - before;
+            *outCounter = counter.QuadPart;
+            *outTsc = before + (after - before) / 2;
+        }
+    }
+}
+
+static void oc_clock_tsc_init()
+{
+    if(!oc_clock_has_invariant_tsc())
+    {
+        return;
+    }
+
+    i64 startCounter = 0;
+    u64 startTsc = 0;
+    oc_clock_tsc_sample(&startCounter, &startTsc);
+
+    i64 endCounter = 0;
+    u64 endTsc = 0;
+    i64 calibrationTicks = (i64)(OC_CLOCK_TSC_CALIBRATION_TIME * __performanceCounterFreq);
+    do
+    {
+        oc_clock_tsc_sample(&endCounter, &endTsc);
+    }
+    while(endCounter - startCounter < calibrationTicks);
+
+    f64 elapsed = (f64)(endCounter - startCounter) / (f64)__performanceCounterFreq;
+    if(endTsc <= startTsc)
+    {
+        return;
+    }
+    __tscSecondsPerTick = elapsed / (f64)(endTsc - startTsc);
+    __tscAnchor = endTsc;
+    __tscAnchorTime = (f64)endCounter / (f64)__performanceCounterFreq;
+    __tscEnabled = true;
+}
+#else
+static void oc_clock_tsc_init()
+{
+    //NOTE: on ARM64, QueryPerformanceCounter() already reads the virtual counter from user mode
+}
+#endif // OC_ARCH_X64
+
 void oc_clock_init()
 {
     LARGE_INTEGER freq;
     QueryPerformanceFrequency(&freq);
     __performanceCounterFreq = freq.QuadPart;
+
+    oc_clock_tsc_init();
 }
 
 f64 oc_clock_time(oc_clock_kind clock)
@@ -31,6 +119,12 @@ f64 oc_clock_time(oc_clock_kind clock)
     {
         case OC_CLOCK_MONOTONIC:
         {
+#if OC_ARCH_X64
+            if(__tscEnabled)
+            {
+                return (__tscAnchorTime + (f64)(i64)(__rdtsc() - __tscAnchor) * __tscSecondsPerTick);
+            }
+#endif
             LARGE_INTEGER counter;
             QueryPerformanceCounter(&counter);
 
@@ -66,6 +160,62 @@ f64 oc_clock_time(oc_clock_kind clock)
     return 0.0;
 }
 
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+    #define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+//NOTE: high resolution timers wake up within about half a millisecond of their due time, but on systems that don't
+//      support them we fall back to a regular timer, which is only as precise as the system timer period.
+static const f64 OC_SLEEP_SPIN_TAIL = 1e-3;
+static const f64 OC_SLEEP_SPIN_TAIL_LOW_RES = 2e-3;
+
+//NOTE: each thread that sleeps lazily creates its own timer, which lives as long as the thread
+static oc_thread_local HANDLE __sleepTimer = 0;
+static oc_thread_local bool __sleepTimerHighRes = false;
+
+void oc_sleep_until(f64 deadline)
+{
+    if(!__sleepTimer)
+    {
+        __sleepTimer = CreateWaitableTimerExW(0, 0, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        __sleepTimerHighRes = (__sleepTimer != 0);
+        if(!__sleepTimer)
+        {
+            __sleepTimer = CreateWaitableTimerExW(0, 0, 0, TIMER_ALL_ACCESS);
+        }
+    }
+    f64 spinTail = __sleepTimerHighRes ? OC_SLEEP_SPIN_TAIL : OC_SLEEP_SPIN_TAIL_LOW_RES;
+
+    f64 remaining = deadline - oc_clock_time(OC_CLOCK_MONOTONIC);
+    if(remaining > spinTail)
+    {
+        if(__sleepTimer)
+        {
+            //NOTE: negative due times are relative, in 100ns units
+            LARGE_INTEGER dueTime;
+            dueTime.QuadPart = -(LONGLONG)((remaining - spinTail) * 1e7);
+            if(SetWaitableTimerEx(__sleepTimer, &dueTime, 0, 0, 0, 0, 0))
+            {
+                WaitForSingleObject(__sleepTimer, INFINITE);
+            }
+        }
+        else
+        {
+            Sleep((DWORD)((remaining - spinTail) * 1000));
+        }
+    }
+
+    while(oc_clock_time(OC_CLOCK_MONOTONIC) < deadline)
+    {
+        YieldProcessor();
+    }
+}
+
+void oc_sleep(f64 seconds)
+{
+    oc_sleep_until(oc_clock_time(OC_CLOCK_MONOTONIC) + seconds);
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -12,7 +12,9 @@
 #include <winioctl.h>
 
 #include "platform_io_common.c"
+#include "platform_kv.c"
 #include "platform_io_internal.c"
+#include "platform_io_queue.c"
 #include "win32_string_helpers.h"
 
 oc_io_error oc_io_raw_last_error()
@@ -350,6 +352,17 @@ oc_io_error oc_io_raw_fstat_at(oc_file_desc dirFd, oc_str8 name, oc_file_open_fl
     return (error);
 }
 
+oc_io_error oc_io_raw_sync(oc_file_desc fd, oc_file_sync sync)
+{
+    //NOTE: FlushFileBuffers() writes both data and metadata, and flushes the drive's cache
+    oc_io_error error = OC_IO_OK;
+    if(!FlushFileBuffers(fd))
+    {
+        error = oc_io_raw_last_error();
+    }
+    return (error);
+}
+
 typedef struct
 {
     ULONG ReparseTag;
@@ -426,6 +439,12 @@ oc_io_raw_read_link_result oc_io_raw_read_link_at(oc_arena* arena, oc_file_desc
 static oc_io_cmp oc_io_close(oc_file_slot* slot, oc_io_req* req, oc_file_table* table)
 {
     oc_io_cmp cmp = { 0 };
+    cmp.error = oc_io_write_behind_flush(slot);
+
+    if(slot->dirStream)
+    {
+        free(slot->dirStream);
+    }
     if(slot->fd)
     {
         CloseHandle(slot->fd);
@@ -450,7 +469,7 @@ static oc_io_cmp oc_io_fstat(oc_file_slot* slot, oc_io_req* req)
     return (cmp);
 }
 
-static oc_io_cmp oc_io_seek(oc_file_slot* slot, oc_io_req* req)
+oc_io_cmp oc_io_seek(oc_file_slot* slot, oc_io_req* req)
 {
     oc_io_cmp cmp = { 0 };
 
@@ -485,7 +504,7 @@ static oc_io_cmp oc_io_seek(oc_file_slot* slot, oc_io_req* req)
     return (cmp);
 }
 
-static oc_io_cmp oc_io_read(oc_file_slot* slot, oc_io_req* req)
+oc_io_cmp oc_io_read(oc_file_slot* slot, oc_io_req* req)
 {
     oc_io_cmp cmp = { 0 };
 
@@ -512,7 +531,7 @@ static oc_io_cmp oc_io_read(oc_file_slot* slot, oc_io_req* req)
     return (cmp);
 }
 
-static oc_io_cmp oc_io_write(oc_file_slot* slot, oc_io_req* req)
+oc_io_cmp oc_io_write(oc_file_slot* slot, oc_io_req* req)
 {
     oc_io_cmp cmp = { 0 };
 
@@ -539,6 +558,433 @@ static oc_io_cmp oc_io_write(oc_file_slot* slot, oc_io_req* req)
     return (cmp);
 }
 
+//NOTE: ReadFile()/WriteFile() with an OVERLAPPED offset on a synchronous handle still move the file pointer,
+//      so positional ops save and restore it to match pread()/pwrite() semantics.
+//      ReadFileScatter()/WriteFileGather() require unbuffered, overlapped handles, so vectored ops issue one
+//      positional transfer per vector instead.
+static oc_io_cmp oc_io_positional(oc_file_slot* slot, oc_io_req* req)
+{
+    oc_io_cmp cmp = { 0 };
+
+    if(slot->type != OC_FILE_REGULAR)
+    {
+        slot->error = OC_IO_ERR_PERM;
+        cmp.error = slot->error;
+        return (cmp);
+    }
+
+    oc_io_vec singleVec = { .buffer = req->buffer, .size = req->size };
+    oc_io_vec* vecs = &singleVec;
+    u64 count = 1;
+    if(req->op == OC_IO_PREADV || req->op == OC_IO_PWRITEV)
+    {
+        vecs = (oc_io_vec*)req->buffer;
+        count = req->size;
+    }
+    bool write = (req->op == OC_IO_PWRITE || req->op == OC_IO_PWRITEV);
+
+    LARGE_INTEGER zero = { 0 };
+    LARGE_INTEGER savedPos = { 0 };
+    if(!SetFilePointerEx(slot->fd, zero, &savedPos, FILE_CURRENT))
+    {
+        slot->error = oc_io_raw_last_error();
+        cmp.error = slot->error;
+        return (cmp);
+    }
+
+    u64 offset = req->offset;
+    for(u64 i = 0; i < count; i++)
+    {
+        if(vecs[i].size > 0xffffffff)
+        {
+            slot->error = OC_IO_ERR_ARG;
+            cmp.error = slot->error;
+            break;
+        }
+
+        OVERLAPPED overlapped = {
+            .Offset = (DWORD)(offset & 0xffffffff),
+            .OffsetHigh = (DWORD)(offset >> 32),
+        };
+        DWORD transferred = 0;
+        BOOL ok = write
+                    ? WriteFile(slot->fd, vecs[i].buffer, (DWORD)vecs[i].size, &transferred, &overlapped)
+                    : ReadFile(slot->fd, vecs[i].buffer, (DWORD)vecs[i].size, &transferred, &overlapped);
+
+        if(!ok)
+        {
+            //NOTE: reading past the end of file is not an error, it just transfers less bytes
+            if(GetLastError() != ERROR_HANDLE_EOF)
+            {
+                slot->error = oc_io_raw_last_error();
+                cmp.error = slot->error;
+            }
+            break;
+        }
+        cmp.result += transferred;
+        offset += transferred;
+
+        if(transferred < vecs[i].size)
+        {
+            break;
+        }
+    }
+
+    SetFilePointerEx(slot->fd, savedPos, NULL, FILE_BEGIN);
+
+    return (cmp);
+}
+
+//NOTE: directory entries are fetched in batches with GetFileInformationByHandleEx(), and kept in the
+//      stream until they fit in a caller buffer.
+typedef struct oc_win32_dir_stream
+{
+    HANDLE handle;
+    u32 pos;
+    u32 len;
+    bool restart;
+    bool end;
+    u64 buffer[(64 << 10) / sizeof(u64)]; // FILE_FULL_DIR_INFO must be 8-byte aligned
+
+} oc_win32_dir_stream;
+
+static FILE_FULL_DIR_INFO* oc_win32_dir_stream_peek(oc_win32_dir_stream* stream, oc_io_error* error)
+{
+    while(stream->pos >= stream->len && !stream->end)
+    {
+        FILE_INFO_BY_HANDLE_CLASS infoClass = stream->restart ? FileFullDirectoryRestartInfo : FileFullDirectoryInfo;
+        stream->restart = false;
+        stream->pos = 0;
+        stream->len = 0;
+        if(!GetFileInformationByHandleEx(stream->handle, infoClass, stream->buffer, sizeof(stream->buffer)))
+        {
+            if(GetLastError() != ERROR_NO_MORE_FILES)
+            {
+                *error = oc_io_raw_last_error();
+            }
+            stream->end = true;
+        }
+        else
+        {
+            stream->len = sizeof(stream->buffer);
+        }
+    }
+    return (stream->pos < stream->len ? (FILE_FULL_DIR_INFO*)((char*)stream->buffer + stream->pos) : 0);
+}
+
+static void oc_win32_dir_stream_advance(oc_win32_dir_stream* stream, FILE_FULL_DIR_INFO* info)
+{
+    if(info->NextEntryOffset)
+    {
+        stream->pos += info->NextEntryOffset;
+    }
+    else
+    {
+        stream->pos = stream->len;
+    }
+}
+
+static bool oc_win32_is_dot_entry(FILE_FULL_DIR_INFO* info)
+{
+    return ((info->FileNameLength == 2 && info->FileName[0] == '.')
+            || (info->FileNameLength == 4 && info->FileName[0] == '.' && info->FileName[1] == '.'));
+}
+
+static oc_io_cmp oc_io_read_dir(oc_file_slot* slot, oc_io_req* req)
+{
+    oc_io_cmp cmp = { 0 };
+
+    if(slot->type != OC_FILE_DIRECTORY)
+    {
+        cmp.error = OC_IO_ERR_NOT_DIR;
+        return (cmp);
+    }
+
+    oc_win32_dir_stream* stream = (oc_win32_dir_stream*)slot->dirStream;
+    if(!stream)
+    {
+        stream = malloc(sizeof(oc_win32_dir_stream));
+        if(!stream)
+        {
+            cmp.error = OC_IO_ERR_MEM;
+            return (cmp);
+        }
+        slot->dirStream = stream;
+        slot->dirIndex = (u64)-1;
+    }
+    stream->handle = slot->fd;
+
+    oc_io_error error = OC_IO_OK;
+
+    if(req->offset < 0 || (u64)req->offset != slot->dirIndex)
+    {
+        memset(stream, 0, offsetof(oc_win32_dir_stream, buffer));
+        stream->handle = slot->fd;
+        stream->restart = true;
+        slot->dirIndex = 0;
+
+        FILE_FULL_DIR_INFO* info = 0;
+        while(slot->dirIndex < (u64)req->offset && (info = oc_win32_dir_stream_peek(stream, &error)))
+        {
+            if(!oc_win32_is_dot_entry(info))
+            {
+                slot->dirIndex++;
+            }
+            oc_win32_dir_stream_advance(stream, info);
+        }
+    }
+
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    u64 offset = 0;
+    FILE_FULL_DIR_INFO* info = 0;
+    while(error == OC_IO_OK && (info = oc_win32_dir_stream_peek(stream, &error)))
+    {
+        if(oc_win32_is_dot_entry(info))
+        {
+            oc_win32_dir_stream_advance(stream, info);
+            continue;
+        }
+
+        oc_file_type type = OC_FILE_REGULAR;
+        if(info->FileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+        {
+            type = OC_FILE_SYMLINK;
+        }
+        else if(info->FileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            type = OC_FILE_DIRECTORY;
+        }
+
+        FILETIME modificationTime = {
+            .dwLowDateTime = info->LastWriteTime.LowPart,
+            .dwHighDateTime = info->LastWriteTime.HighPart,
+        };
+
+        oc_arena_scope nameScope = oc_arena_scope_begin(scratch.arena);
+        oc_str8 name = oc_win32_wide_to_utf8(scratch.arena, oc_str16_from_buffer(info->FileNameLength / sizeof(u16), info->FileName));
+
+        bool pushed = oc_io_dir_entry_push(req,
+                                           &offset,
+                                           name,
+                                           type,
+                                           info->EndOfFile.QuadPart,
+                                           oc_datestamp_from_win32_filetime(modificationTime));
+        oc_arena_scope_end(nameScope);
+
+        if(!pushed)
+        {
+            //NOTE: leave the entry in the stream for the next call
+            if(cmp.result == 0)
+            {
+                error = OC_IO_ERR_ARG;
+            }
+            break;
+        }
+        cmp.result++;
+        slot->dirIndex++;
+        oc_win32_dir_stream_advance(stream, info);
+    }
+
+    oc_scratch_end(scratch);
+
+    if(error)
+    {
+        slot->error = error;
+        cmp.error = error;
+    }
+    return (cmp);
+}
+
+static oc_io_cmp oc_io_advise(oc_file_slot* slot, oc_io_req* req)
+{
+    oc_io_cmp cmp = { 0 };
+
+    if(req->offset < 0 || req->advice > OC_FILE_ADVICE_DONTNEED)
+    {
+        cmp.error = OC_IO_ERR_ARG;
+    }
+    else if(req->advice == OC_FILE_ADVICE_NORMAL
+            || req->advice == OC_FILE_ADVICE_SEQUENTIAL
+            || req->advice == OC_FILE_ADVICE_RANDOM)
+    {
+        //NOTE: Windows has no access hints for an open handle. PrefetchVirtualMemory() only applies to mapped
+        //      views, and the cache manager already detects sequential access on its own, so advice only
+        //      drives the host read-ahead buffer.
+        oc_io_read_ahead_enable(slot, req->advice == OC_FILE_ADVICE_SEQUENTIAL);
+    }
+    return (cmp);
+}
+
+typedef struct oc_win32_watch
+{
+    oc_io_watch* watch;
+    HANDLE dir;
+    HANDLE stopEvent;
+    oc_thread* thread;
+} oc_win32_watch;
+
+static void oc_win32_watch_push_changes(oc_io_watch* watch, FILE_NOTIFY_INFORMATION* info)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+    while(1)
+    {
+        oc_str16 nameW = { .ptr = (u16*)info->FileName, .len = info->FileNameLength / sizeof(WCHAR) };
+        oc_str8 path = oc_win32_wide_to_utf8(scratch.arena, nameW);
+        oc_win32_path_normalize_slash_in_place(path);
+
+        oc_file_change_kind kind = OC_FILE_CHANGE_MODIFIED;
+        switch(info->Action)
+        {
+            case FILE_ACTION_ADDED:
+            case FILE_ACTION_RENAMED_NEW_NAME:
+                kind = OC_FILE_CHANGE_ADDED;
+                break;
+
+            case FILE_ACTION_REMOVED:
+            case FILE_ACTION_RENAMED_OLD_NAME:
+                kind = OC_FILE_CHANGE_REMOVED;
+                break;
+        }
+        oc_io_watch_push(watch, kind, path);
+
+        if(!info->NextEntryOffset)
+        {
+            break;
+        }
+        info = (FILE_NOTIFY_INFORMATION*)((char*)info + info->NextEntryOffset);
+    }
+    oc_scratch_end(scratch);
+}
+
+static i32 oc_win32_watch_thread(void* user)
+{
+    oc_win32_watch* native = (oc_win32_watch*)user;
+    oc_io_watch* watch = native->watch;
+
+    //NOTE: ReadDirectoryChangesW() needs a DWORD-aligned buffer, and fails over the network above 64KB
+    DWORD buffer[(64 << 10) / sizeof(DWORD)];
+    DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME
+                 | FILE_NOTIFY_CHANGE_DIR_NAME
+                 | FILE_NOTIFY_CHANGE_ATTRIBUTES
+                 | FILE_NOTIFY_CHANGE_SIZE
+                 | FILE_NOTIFY_CHANGE_LAST_WRITE
+                 | FILE_NOTIFY_CHANGE_CREATION;
+    BOOL recursive = (watch->flags & OC_FILE_WATCH_RECURSIVE) ? TRUE : FALSE;
+
+    OVERLAPPED overlapped = { .hEvent = CreateEventW(0, TRUE, FALSE, 0) };
+    if(!overlapped.hEvent)
+    {
+        return (-1);
+    }
+    HANDLE events[2] = { overlapped.hEvent, native->stopEvent };
+
+    while(1)
+    {
+        ResetEvent(overlapped.hEvent);
+        if(!ReadDirectoryChangesW(native->dir, buffer, sizeof(buffer), recursive, filter, 0, &overlapped, 0))
+        {
+            break;
+        }
+
+        DWORD size = 0;
+        if(WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0)
+        {
+            CancelIoEx(native->dir, &overlapped);
+            GetOverlappedResult(native->dir, &overlapped, &size, TRUE);
+            break;
+        }
+        if(!GetOverlappedResult(native->dir, &overlapped, &size, FALSE))
+        {
+            //NOTE: the directory was removed
+            break;
+        }
+
+        if(size == 0)
+        {
+            //NOTE: the system's buffer overflowed, and the changes were lost
+            oc_io_watch_push(watch, OC_FILE_CHANGE_OVERFLOW, (oc_str8){ 0 });
+        }
+        else
+        {
+            oc_win32_watch_push_changes(watch, (FILE_NOTIFY_INFORMATION*)buffer);
+        }
+    }
+
+    CloseHandle(overlapped.hEvent);
+    return (0);
+}
+
+oc_io_error oc_io_raw_watch_start(oc_file_desc fd, oc_io_watch* watch)
+{
+    oc_win32_watch* native = malloc(sizeof(oc_win32_watch));
+    if(!native)
+    {
+        return (OC_IO_ERR_MEM);
+    }
+    memset(native, 0, sizeof(oc_win32_watch));
+    native->watch = watch;
+    native->dir = INVALID_HANDLE_VALUE;
+
+    //NOTE: the watcher waits on its own handle, opened for overlapped IO, so that it doesn't block requests on fd
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_str16 pathW = win32_path_from_handle_null_terminated(scratch.arena, fd);
+    if(pathW.len)
+    {
+        native->dir = CreateFileW(pathW.ptr,
+                                  FILE_LIST_DIRECTORY,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                  0,
+                                  OPEN_EXISTING,
+                                  FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+                                  0);
+    }
+    oc_scratch_end(scratch);
+
+    oc_io_error error = OC_IO_OK;
+    if(native->dir == INVALID_HANDLE_VALUE)
+    {
+        error = oc_io_raw_last_error();
+    }
+    else if(!(native->stopEvent = CreateEventW(0, TRUE, FALSE, 0)))
+    {
+        error = oc_io_raw_last_error();
+    }
+    else if(!(native->thread = oc_thread_create_with_name(oc_win32_watch_thread, native, OC_STR8("io watch"))))
+    {
+        error = OC_IO_ERR_UNKNOWN;
+    }
+
+    if(error != OC_IO_OK)
+    {
+        if(native->stopEvent)
+        {
+            CloseHandle(native->stopEvent);
+        }
+        if(native->dir != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(native->dir);
+        }
+        free(native);
+        return (error);
+    }
+    watch->native = native;
+    return (OC_IO_OK);
+}
+
+void oc_io_raw_watch_stop(oc_io_watch* watch)
+{
+    oc_win32_watch* native = (oc_win32_watch*)watch->native;
+
+    SetEvent(native->stopEvent);
+    oc_thread_join(native->thread, 0);
+
+    CloseHandle(native->stopEvent);
+    CloseHandle(native->dir);
+    free(native);
+    watch->native = 0;
+}
+
 static oc_io_cmp oc_io_get_error(oc_file_slot* slot, oc_io_req* req)
 {
     oc_io_cmp cmp = { 0 };
@@ -562,9 +1008,24 @@ oc_io_cmp oc_io_wait_single_req_for_table(oc_io_req* req, oc_file_table* table)
     {
         cmp.error = OC_IO_ERR_PREV;
     }
+    else if(req->op != OC_IO_WRITE && req->op != OC_IO_CLOSE && req->op != OC_OC_IO_ERROR)
+    {
+        //NOTE: other requests see buffered writes as done. Closing flushes them itself.
+        cmp.error = oc_io_write_behind_flush(slot);
+    }
 
-    if(cmp.error == OC_IO_OK)
+    if(cmp.error == OC_IO_OK && slot && slot->memoryBacked)
+    {
+        cmp = oc_io_memory_req(slot, req, table);
+    }
+    else if(cmp.error == OC_IO_OK)
     {
+        if(slot && (req->op == OC_IO_WRITE || req->op == OC_IO_PWRITE || req->op == OC_IO_PWRITEV))
+        {
+            //NOTE: writes use the descriptor's position, or may overwrite bytes in the read-ahead buffer
+            oc_io_read_ahead_sync(slot);
+        }
+
         switch(req->op)
         {
             case OC_IO_OPEN_AT:
@@ -580,15 +1041,46 @@ oc_io_cmp oc_io_wait_single_req_for_table(oc_io_req* req, oc_file_table* table)
                 break;
 
             case OC_IO_READ:
-                cmp = oc_io_read(slot, req);
+                cmp = oc_io_read_buffered(slot, req);
                 break;
 
             case OC_IO_WRITE:
-                cmp = oc_io_write(slot, req);
+                cmp = oc_io_write_buffered(slot, req);
                 break;
 
             case OC_IO_SEEK:
-                cmp = oc_io_seek(slot, req);
+                cmp = oc_io_seek_buffered(slot, req);
+                break;
+
+            case OC_IO_PREAD:
+            case OC_IO_PWRITE:
+            case OC_IO_PREADV:
+            case OC_IO_PWRITEV:
+                cmp = oc_io_positional(slot, req);
+                break;
+
+            case OC_IO_READDIR:
+                cmp = oc_io_read_dir(slot, req);
+                break;
+
+            case OC_IO_ADVISE:
+                cmp = oc_io_advise(slot, req);
+                break;
+
+            case OC_IO_WRITE_BUFFER:
+                cmp = oc_io_set_write_buffer(slot, req);
+                break;
+
+            case OC_IO_FLUSH:
+                cmp = oc_io_flush(slot, req);
+                break;
+
+            case OC_IO_WATCH:
+                cmp = oc_io_set_watch(slot, req, table);
+                break;
+
+            case OC_IO_READ_CHANGES:
+                cmp = oc_io_read_changes(slot, req);
                 break;
 
             case OC_OC_IO_ERROR:
@@ -606,3 +1098,56 @@ oc_io_cmp oc_io_wait_single_req_for_table(oc_io_req* req, oc_file_table* table)
     }
     return (cmp);
 }
+
+oc_str8 oc_file_map_read_only(oc_str8 path)
+{
+    oc_str8 mapping = { 0 };
+
+    oc_file_desc fd = oc_io_raw_open_at(oc_file_desc_nil(), path, OC_FILE_ACCESS_READ, OC_FILE_OPEN_NONE);
+    if(!oc_file_desc_is_nil(fd))
+    {
+        oc_file_status status = { 0 };
+        if(oc_io_raw_fstat(fd, &status) == OC_IO_OK && status.size)
+        {
+            HANDLE mapObject = CreateFileMappingW(fd, NULL, PAGE_READONLY, 0, 0, NULL);
+            if(mapObject)
+            {
+                void* ptr = MapViewOfFile(mapObject, FILE_MAP_READ, 0, 0, status.size);
+                if(ptr)
+                {
+                    mapping = oc_str8_from_buffer(status.size, ptr);
+                }
+                //NOTE: the view keeps a reference to the mapping object and the file
+                CloseHandle(mapObject);
+            }
+        }
+        oc_io_raw_close(fd);
+    }
+    return (mapping);
+}
+
+void oc_file_unmap(oc_str8 mapping)
+{
+    if(mapping.ptr)
+    {
+        UnmapViewOfFile(mapping.ptr);
+    }
+}
+
+u64 oc_io_map_granularity(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (info.dwAllocationGranularity);
+}
+
+oc_io_error oc_io_map_fixed(oc_file_slot* slot, u64 offset, u64 size, void* addr)
+{
+    //NOTE: views can only be placed over committed memory through placeholders, which the wasm memory reservation
+    //      doesn't use, so mappings fall back to copies.
+    return (OC_IO_ERR_OP);
+}
+
+void oc_io_unmap_fixed(void* addr, u64 size)
+{
+}
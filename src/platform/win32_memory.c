@@ -8,6 +8,7 @@
 #define WIN32_LEAN_AND_MEAN
 #include "platform_memory.h"
 #include <windows.h>
+#include <psapi.h>
 
 void* oc_base_reserve_win32(oc_base_allocator* context, u64 size)
 {
@@ -15,9 +16,9 @@ void* oc_base_reserve_win32(oc_base_allocator* context, u64 size)
     return (result);
 }
 
-void oc_base_commit_win32(oc_base_allocator* context, void* ptr, u64 size)
+bool oc_base_commit_win32(oc_base_allocator* context, void* ptr, u64 size)
 {
-    VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE);
+    return (VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != 0);
 }
 
 void oc_base_release_win32(oc_base_allocator* context, void* ptr, u64 size)
@@ -30,6 +31,39 @@ void oc_base_decommit_win32(oc_base_allocator* context, void* ptr, u64 size)
     VirtualFree(ptr, size, MEM_DECOMMIT);
 }
 
+u64 oc_base_resident_size(void* ptr, u64 size)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    u64 pageSize = info.dwPageSize;
+
+    char* start = (char*)oc_align_down_pow2((uintptr_t)ptr, pageSize);
+    char* end = (char*)oc_align_up_pow2((uintptr_t)ptr + size, pageSize);
+
+    u64 resident = 0;
+    PSAPI_WORKING_SET_EX_INFORMATION pages[256];
+    for(char* chunk = start; chunk < end; chunk += oc_array_size(pages) * pageSize)
+    {
+        u64 count = oc_min((u64)(end - chunk) / pageSize, oc_array_size(pages));
+        for(u64 i = 0; i < count; i++)
+        {
+            pages[i].VirtualAddress = chunk + i * pageSize;
+        }
+        if(!QueryWorkingSetEx(GetCurrentProcess(), pages, count * sizeof(PSAPI_WORKING_SET_EX_INFORMATION)))
+        {
+            break;
+        }
+        for(u64 i = 0; i < count; i++)
+        {
+            if(pages[i].VirtualAttributes.Valid)
+            {
+                resident += pageSize;
+            }
+        }
+    }
+    return (resident);
+}
+
 oc_base_allocator* oc_base_allocator_default()
 {
     static oc_base_allocator base = { 0 };
@@ -42,3 +76,10 @@ oc_base_allocator* oc_base_allocator_default()
     }
     return (&base);
 }
+
+oc_base_allocator* oc_base_allocator_large_pages()
+{
+    //NOTE: MEM_LARGE_PAGES needs the whole region to be committed at reservation time, by a process that has the
+    //      "lock pages in memory" privilege, which doesn't fit growable reservations. Use regular pages instead.
+    return (oc_base_allocator_default());
+}
@@ -6,6 +6,7 @@
 *
 **************************************************************************/
 #include <math.h> //INFINITY
+#include <avrt.h> // MMCSS
 #include <processthreadsapi.h>
 #include <synchapi.h>
 #include <winuser.h> // PostMessage
@@ -18,23 +19,57 @@ struct oc_thread
     HANDLE handle;
     DWORD threadId;
     void* userPointer;
+    oc_thread_priority priority; // as given at creation
     oc_str8 name;
     char nameBuffer[OC_THREAD_NAME_MAX_SIZE];
 };
 
+static int oc_thread_priority_to_win32(oc_thread_priority priority)
+{
+    switch(priority)
+    {
+        case OC_THREAD_PRIORITY_BACKGROUND:
+            return (THREAD_PRIORITY_LOWEST);
+        case OC_THREAD_PRIORITY_UTILITY:
+            return (THREAD_PRIORITY_BELOW_NORMAL);
+        case OC_THREAD_PRIORITY_HIGH:
+            return (THREAD_PRIORITY_ABOVE_NORMAL);
+        case OC_THREAD_PRIORITY_FRAME:
+            return (THREAD_PRIORITY_HIGHEST);
+        default:
+            return (THREAD_PRIORITY_NORMAL);
+    }
+}
+
 static DWORD WINAPI oc_thread_bootstrap(LPVOID lpParameter)
 {
     oc_thread* thread = (oc_thread*)lpParameter;
+
+    //NOTE: MMCSS tasks can only be joined by the thread itself
+    HANDLE mmcssTask = 0;
+    if(thread->priority == OC_THREAD_PRIORITY_FRAME)
+    {
+        DWORD taskIndex = 0;
+        mmcssTask = AvSetMmThreadCharacteristicsW(L"Games", &taskIndex);
+    }
+
     i32 exitCode = thread->start(thread->userPointer);
+
+    if(mmcssTask)
+    {
+        AvRevertMmThreadCharacteristics(mmcssTask);
+    }
     return (exitCode);
 }
 
-oc_thread* oc_thread_create_with_name(oc_thread_start_proc start, void* userPointer, oc_str8 name)
+oc_thread* oc_thread_create_with_options(oc_thread_start_proc start, void* userPointer, oc_thread_options* options)
 {
+    oc_str8 name = options->name;
     oc_thread* thread = (oc_thread*)malloc(sizeof(oc_thread));
     thread->start = start;
     thread->handle = INVALID_HANDLE_VALUE;
     thread->userPointer = userPointer;
+    thread->priority = options->priority;
     if(name.len && name.ptr)
     {
         strncpy_s(thread->nameBuffer, OC_THREAD_NAME_MAX_SIZE, name.ptr, oc_min(name.len, OC_THREAD_NAME_MAX_SIZE - 1));
@@ -52,7 +87,7 @@ oc_thread* oc_thread_create_with_name(oc_thread_start_proc start, void* userPoin
         .bInheritHandle = false,
     };
     SIZE_T stackSize = 0; // uses process default
-    DWORD flags = 0;
+    DWORD flags = CREATE_SUSPENDED; // resumed once its priority and affinity are set
     DWORD threadId = 0;
     thread->handle = CreateThread(&childProcessSecurity, stackSize, oc_thread_bootstrap, thread, flags, &threadId);
     if(thread->handle == NULL)
@@ -63,6 +98,15 @@ oc_thread* oc_thread_create_with_name(oc_thread_start_proc start, void* userPoin
 
     thread->threadId = threadId;
 
+    if(options->priority != OC_THREAD_PRIORITY_NORMAL)
+    {
+        SetThreadPriority(thread->handle, oc_thread_priority_to_win32(options->priority));
+    }
+    if(options->affinityMask)
+    {
+        SetThreadAffinityMask(thread->handle, (DWORD_PTR)options->affinityMask);
+    }
+
     if(thread->name.len)
     {
         wchar_t widename[OC_THREAD_NAME_MAX_SIZE];
@@ -73,9 +117,36 @@ oc_thread* oc_thread_create_with_name(oc_thread_start_proc start, void* userPoin
         SetThreadDescription(thread->handle, widename);
     }
 
+    ResumeThread(thread->handle);
+
     return (thread);
 }
 
+oc_thread* oc_thread_create_with_name(oc_thread_start_proc start, void* userPointer, oc_str8 name)
+{
+    oc_thread_options options = { .name = name };
+    return (oc_thread_create_with_options(start, userPointer, &options));
+}
+
+int oc_thread_set_priority(oc_thread* thread, oc_thread_priority priority)
+{
+    HANDLE handle = thread ? thread->handle : GetCurrentThread();
+    return (SetThreadPriority(handle, oc_thread_priority_to_win32(priority)) ? 0 : -1);
+}
+
+int oc_thread_set_affinity(oc_thread* thread, u64 affinityMask)
+{
+    HANDLE handle = thread ? thread->handle : GetCurrentThread();
+    DWORD_PTR mask = (DWORD_PTR)affinityMask;
+    if(!mask)
+    {
+        //NOTE: allow all the processors of the process
+        DWORD_PTR systemMask = 0;
+        GetProcessAffinityMask(GetCurrentProcess(), &mask, &systemMask);
+    }
+    return (SetThreadAffinityMask(handle, mask) ? 0 : -1);
+}
+
 oc_thread* oc_thread_create(oc_thread_start_proc start, void* userPointer)
 {
     return (oc_thread_create_with_name(start, userPointer, (oc_str8){ 0 }));
@@ -233,3 +304,10 @@ int oc_condition_broadcast(oc_condition* cond)
     WakeAllConditionVariable(&cond->cond);
     return (0);
 }
+
+u32 oc_cpu_count(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (info.dwNumberOfProcessors);
+}
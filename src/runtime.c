@@ -15,11 +15,19 @@
 
 //TODO: wgpu-renderer: figure out graphics backends include selection
 #include "graphics/gles_surface.h"
+#include "graphics/wgpu_renderer_debug.h"
 
 #include "runtime.h"
+#include "runtime_archive.c"
 #include "runtime_clipboard.c"
+#include "runtime_input.c"
+#include "runtime_log.c"
 #include "runtime_io.c"
 #include "runtime_memory.c"
+#include "runtime_net.c"
+#include "runtime_profiler.c"
+#include "runtime_gles.c"
+#include "runtime_render.c"
 
 #include "wasm/wasm.c"
 #if OC_WASM_BACKEND_WASM3
@@ -31,6 +39,32 @@
 #endif
 
 static const char* s_test_wasm_module_path = NULL;
+static f64 s_callback_budget_ms = 1000. / 60;
+static bool s_watch_module = false;
+static bool s_render_thread = false;
+static bool s_gles_thread = false;
+static f64 s_compile_budget_ms = 0; // if > 0, module compilation is deferred and done in slices of that duration
+static f64 s_max_fps = 0;            // if > 0, frames are started no faster than this rate
+static bool s_late_frame_start = false; // start frames as late as possible before the vblank they target
+static bool s_large_pages = false;   // back wasm memories with large pages
+static bool s_cpu_canvas = false;    // render canvases on the CPU even if a WebGPU adapter is available
+static bool s_image_cache = false;   // share images decoded from the same data between calls and apps
+static u64 s_image_cache_budget = 0; // bytes of released images kept by the image cache, 0 for the default
+static const char* s_wasm_engine_args[16]; // --wasm-<option> flags, applied on top of the bundle's engine options
+static u32 s_wasm_engine_arg_count = 0;
+static const char* s_app_dirs[OC_RUNTIME_MAX_APPS]; // --app=<dir> flags
+static u32 s_app_dir_count = 0;
+static const char* s_startup_report_path = 0; // --startup-report=<path>, defaults to startup.json next to the runtime
+static bool s_quit_after_startup = false;     // quit once every app has presented its first frame
+static const char* s_hotness_profile_path = 0; // --hotness-profile=<path>, records a hotness profile of the run
+static const char* s_record_input_path = 0;    // --record-input=<path>
+static const char* s_replay_input_path = 0;    // --replay-input=<path>
+static f64 s_replay_step_ms = 1000. / 60;      // --replay-step=<ms>, time step of replayed frames
+static const char* s_replay_report_path = 0;   // --replay-report=<path>, defaults to replay.json next to the runtime
+static oc_runtime_input s_input = { 0 };
+static bool s_sync_log = false;                // --sync-log, write guest log messages on the runloop thread
+static oc_runtime_log s_log = { 0 };
+static oc_runtime_startup s_startup = { 0 };  // shared startup phases, copied to each app before it loads
 
 oc_font orca_font_create(const char* resourcePath)
 {
@@ -69,23 +103,32 @@ oc_font orca_font_create(const char* resourcePath)
     return (font);
 }
 
-oc_runtime __orcaApp = { 0 };
+static oc_runtime s_apps[OC_RUNTIME_MAX_APPS] = { 0 };
+static u32 s_appCount = 0;
+static oc_runtime* s_currentApp = &s_apps[0];
+static oc_runtime_shared s_shared = { 0 };
 
 oc_runtime* oc_runtime_get()
 {
-    return (&__orcaApp);
+    return (s_currentApp);
+}
+
+//NOTE: bindings and memory callbacks act on the current app, so it must be set before calling into an instance
+static void oc_runtime_set_current(oc_runtime* app)
+{
+    s_currentApp = app;
 }
 
 oc_wasm_env* oc_runtime_get_env()
 {
-    return (&__orcaApp.env);
+    return (&oc_runtime_get()->env);
 }
 
 oc_str8 oc_runtime_get_wasm_memory()
 {
     oc_str8 mem = { 0 };
     u32 size = 0;
-    mem = oc_wasm_mem_get(__orcaApp.env.wasm);
+    mem = oc_wasm_mem_get(oc_runtime_get()->env.wasm);
     return (mem);
 }
 
@@ -107,28 +150,78 @@ u64 orca_check_cstring(oc_wasm* wasm, const char* ptr)
     return (len + 1); //include null-terminator
 }
 
+void oc_bridge_assert_fail(oc_wasm_str8 file, oc_wasm_str8 function, int line, oc_wasm_str8 src, oc_wasm_str8 note)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_runtime_app_assert_fail(oc_str8_to_cstring(scratch.arena, oc_wasm_str8_to_native(file)),
+                               oc_str8_to_cstring(scratch.arena, oc_wasm_str8_to_native(function)),
+                               line,
+                               oc_str8_to_cstring(scratch.arena, oc_wasm_str8_to_native(src)),
+                               "%.*s",
+                               oc_str8_ip(oc_wasm_str8_to_native(note)));
+    oc_scratch_end(scratch);
+}
+
+void oc_bridge_abort_ext(oc_wasm_str8 file, oc_wasm_str8 function, int line, oc_wasm_str8 note)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_runtime_app_abort(oc_str8_to_cstring(scratch.arena, oc_wasm_str8_to_native(file)),
+                         oc_str8_to_cstring(scratch.arena, oc_wasm_str8_to_native(function)),
+                         line,
+                         "%.*s",
+                         oc_str8_ip(oc_wasm_str8_to_native(note)));
+    oc_scratch_end(scratch);
+}
+
 void oc_bridge_window_set_title(oc_wasm_str8 title)
 {
     oc_str8 nativeTitle = oc_wasm_str8_to_native(title);
     if(nativeTitle.ptr)
     {
-        oc_window_set_title(__orcaApp.window, nativeTitle);
+        oc_window_set_title(oc_runtime_get()->window, nativeTitle);
     }
 }
 
 void oc_bridge_window_set_size(oc_vec2 size)
 {
-    oc_window_set_content_size(__orcaApp.window, size);
+    oc_window_set_content_size(oc_runtime_get()->window, size);
 }
 
 oc_wasm_str8 oc_bridge_clipboard_get_string(oc_wasm_addr wasmArena)
 {
-    return oc_runtime_clipboard_get_string(&__orcaApp.clipboard, wasmArena);
+    return oc_runtime_clipboard_get_string(&oc_runtime_get()->clipboard, wasmArena);
 }
 
 void oc_bridge_clipboard_set_string(oc_wasm_str8 value)
 {
-    oc_runtime_clipboard_set_string(&__orcaApp.clipboard, value);
+    oc_runtime_clipboard_set_string(&oc_runtime_get()->clipboard, value);
+}
+
+bool oc_bridge_audio_open(oc_audio_config config)
+{
+    oc_runtime* app = oc_runtime_get();
+    oc_audio_output_close(app->audio);
+    app->audio = oc_audio_output_open(config);
+    return (app->audio != 0);
+}
+
+void oc_bridge_audio_close(void)
+{
+    oc_runtime* app = oc_runtime_get();
+    oc_audio_output_close(app->audio);
+    app->audio = 0;
+}
+
+u64 oc_bridge_audio_write(u64 sampleCount, f32* samples)
+{
+    oc_runtime* app = oc_runtime_get();
+    return (app->audio ? oc_audio_output_write(app->audio, sampleCount, samples) : 0);
+}
+
+oc_audio_info oc_bridge_audio_get_info(void)
+{
+    oc_runtime* app = oc_runtime_get();
+    return (app->audio ? oc_audio_output_info(app->audio) : (oc_audio_info){ 0 });
 }
 
 void oc_assert_fail_dialog(const char* file,
@@ -138,6 +231,7 @@ void oc_assert_fail_dialog(const char* file,
                            const char* fmt,
                            ...)
 {
+    oc_runtime_log_flush(&s_log);
     oc_arena_scope scratch = oc_scratch_begin();
 
     va_list ap;
@@ -166,6 +260,7 @@ void oc_assert_fail_dialog(const char* file,
 
 void oc_abort_ext_dialog(const char* file, const char* function, int line, const char* fmt, ...)
 {
+    oc_runtime_log_flush(&s_log);
     oc_arena_scope scratch = oc_scratch_begin();
 
     va_list ap;
@@ -191,50 +286,143 @@ void oc_abort_ext_dialog(const char* file, const char* function, int line, const
     oc_scratch_end(scratch);
 }
 
-void oc_bridge_log(oc_log_level level,
-                   int functionLen,
-                   char* function,
-                   int fileLen,
-                   char* file,
-                   int line,
-                   int msgLen,
-                   char* msg)
+//NOTE: only the first failure of an app is reported, later ones are usually consequences of it. The guest is unwound
+//      when the host call we're in returns, and the app is released at the end of its frame.
+static void oc_runtime_app_fail(oc_str8 title, oc_str8 msg)
 {
-    oc_debug_overlay* debug = &__orcaApp.debugOverlay;
+    oc_runtime* app = oc_runtime_get();
+    if(!app->failed && !app->exited)
+    {
+        app->failed = true;
+        app->exitCode = -1;
 
-    //NOTE: recycle first entry if we exceeded the max entry count
-    debug->entryCount++;
-    if(debug->entryCount > debug->maxEntries)
+        oc_runtime_log_flush(&s_log);
+        oc_log_error(msg.ptr);
+
+        oc_arena_scope scratch = oc_scratch_begin();
+        oc_str8_list options = { 0 };
+        oc_str8_list_push(scratch.arena, &options, OC_STR8("OK"));
+
+        oc_alert_popup(title, msg, options);
+        oc_scratch_end(scratch);
+    }
+    app->quit = true;
+    app->frameRequested = true;
+
+    if(app->env.wasm)
     {
-        log_entry* e = oc_list_pop_front_entry(&debug->logEntries, log_entry, listElt);
-        if(e)
-        {
-            oc_list_push_front(&debug->logFreeList, &e->listElt);
-            debug->entryCount--;
-        }
+        oc_wasm_trap(app->env.wasm, app->exited ? OC_WASM_STATUS_FAIL_TRAP_EXIT : OC_WASM_STATUS_FAIL_TRAP_ABORT);
     }
+}
+
+void oc_runtime_app_abort(const char* file, const char* function, int line, const char* fmt, ...)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    va_list ap;
+    va_start(ap, fmt);
+    oc_str8 note = oc_str8_pushfv(scratch.arena, fmt, ap);
+    va_end(ap);
+
+    oc_str8 msg = oc_str8_pushf(scratch.arena,
+                                "Fatal error in function %s() in file \"%s\", line %i:\n%.*s\n",
+                                function,
+                                file,
+                                line,
+                                oc_str8_ip(note));
+
+    oc_runtime_app_fail(OC_STR8("Fatal Error"), msg);
+
+    oc_scratch_end(scratch);
+}
+
+void oc_runtime_app_assert_fail(const char* file, const char* function, int line, const char* test, const char* fmt, ...)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    va_list ap;
+    va_start(ap, fmt);
+    oc_str8 note = oc_str8_pushfv(scratch.arena, fmt, ap);
+    va_end(ap);
+
+    oc_str8 msg = oc_str8_pushf(scratch.arena,
+                                "Assertion failed in function %s() in file \"%s\", line %i:\n%s\nNote: %.*s\n",
+                                function,
+                                file,
+                                line,
+                                test,
+                                oc_str8_ip(note));
+
+    oc_runtime_app_fail(OC_STR8("Assertion Failed"), msg);
 
-    u64 cap = sizeof(log_entry) + fileLen + functionLen + msgLen;
+    oc_scratch_end(scratch);
+}
+
+log_entry* log_entry_alloc(oc_debug_overlay* debug, u64 size)
+{
+    size = oc_align_up_pow2(size, sizeof(u64));
+    OC_DEBUG_ASSERT(size <= debug->logBufferCap);
 
-    //NOTE: allocate a new entry
-    //TODO: should probably use a buddy allocator over the arena or something
-    log_entry* entry = 0;
-    oc_list_for(debug->logFreeList, elt, log_entry, listElt)
+    u64 offset = 0;
+    while(1)
     {
-        if(elt->cap >= cap)
+        log_entry* oldest = oc_list_first_entry(debug->logEntries, log_entry, listElt);
+        if(!oldest)
         {
-            oc_list_remove(&debug->logFreeList, &elt->listElt);
-            entry = elt;
+            offset = 0;
             break;
         }
-    }
 
-    if(!entry)
-    {
-        char* mem = oc_arena_push(&debug->logArena, cap);
-        entry = (log_entry*)mem;
-        entry->cap = cap;
+        u64 head = (char*)oldest - debug->logBuffer;
+        if(head < debug->logBufferTail)
+        {
+            //NOTE: live entries are in [head, tail), we can write after them or wrap around to the start
+            if(debug->logBufferCap - debug->logBufferTail >= size)
+            {
+                offset = debug->logBufferTail;
+                break;
+            }
+            else if(head >= size)
+            {
+                offset = 0;
+                break;
+            }
+        }
+        else if(head - debug->logBufferTail >= size)
+        {
+            //NOTE: live entries wrapped around, the free space is [tail, head)
+            offset = debug->logBufferTail;
+            break;
+        }
+
+        //NOTE: no room, drop the oldest entry
+        oc_list_pop_front(&debug->logEntries);
+        debug->entryCount--;
     }
+
+    debug->logBufferTail = offset + size;
+    return ((log_entry*)(debug->logBuffer + offset));
+}
+
+void oc_bridge_log(oc_log_level level,
+                   int functionLen,
+                   char* function,
+                   int fileLen,
+                   char* file,
+                   int line,
+                   int msgLen,
+                   char* msg)
+{
+    oc_debug_overlay* debug = &oc_runtime_get()->debugOverlay;
+
+    //NOTE: truncate very long strings so that a single entry can't evict the whole console
+    u64 maxStringLen = debug->logBufferCap / 16;
+    functionLen = oc_min(functionLen, maxStringLen);
+    fileLen = oc_min(fileLen, maxStringLen);
+    msgLen = oc_min(msgLen, maxStringLen);
+
+    u64 size = sizeof(log_entry) + fileLen + functionLen + msgLen;
+    log_entry* entry = log_entry_alloc(debug, size);
     char* payload = (char*)entry + sizeof(log_entry);
 
     entry->function.len = functionLen;
@@ -259,27 +447,74 @@ void oc_bridge_log(oc_log_level level,
     debug->logEntryTotalCount++;
 
     oc_list_push_back(&debug->logEntries, &entry->listElt);
+    debug->entryCount++;
+
+    if(s_log.enabled)
+    {
+        oc_runtime_log_push(&s_log, level, entry->function, entry->file, line, entry->msg);
+    }
+    else
+    {
+        oc_log_ext(level,
+                   function,
+                   file,
+                   line,
+                   "%.*s\n",
+                   msgLen,
+                   msg);
+    }
+}
 
-    oc_log_ext(level,
-               function,
-               file,
-               line,
-               "%.*s\n",
-               msgLen,
-               msg);
+void oc_bridge_log_lines(oc_log_level level, int len, char* text)
+{
+    //NOTE: the guest's stdout and stderr send their buffers here when they are flushed. Each line gets its own entry.
+    oc_str8 stream = OC_STR8((level == OC_LOG_LEVEL_ERROR) ? "stderr" : "stdout");
+
+    int lineStart = 0;
+    for(int i = 0; i < len; i++)
+    {
+        if(text[i] == '\n')
+        {
+            oc_bridge_log(level, 0, "", oc_str8_ip(stream), 0, i - lineStart, text + lineStart);
+            lineStart = i + 1;
+        }
+    }
+    if(lineStart < len)
+    {
+        oc_bridge_log(level, 0, "", oc_str8_ip(stream), 0, len - lineStart, text + lineStart);
+    }
 }
 
+//NOTE: exit() only stops the calling app. The guest is unwound when we return, and the app is released at the end of
+//      its frame.
 void oc_bridge_exit(int ec)
 {
-    //TODO: send a trap exit to oc_wasm to stop interpreter,
-    // then when we return from the trap, quit app
-    // temporarily, we just exit here
-    exit(ec);
+    oc_runtime* app = oc_runtime_get();
+    if(!app->failed && !app->exited)
+    {
+        app->exited = true;
+        app->exitCode = ec;
+    }
+    app->quit = true;
+    app->frameRequested = true;
+
+    oc_wasm_trap(app->env.wasm, OC_WASM_STATUS_FAIL_TRAP_EXIT);
 }
 
 void oc_bridge_request_quit(void)
 {
-    __orcaApp.quit = true;
+    oc_runtime_get()->quit = true;
+}
+
+void oc_bridge_request_frame(void)
+{
+    oc_runtime_get()->frameRequested = true;
+}
+
+void oc_bridge_set_idle_mode(bool enable)
+{
+    oc_runtime_get()->idleMode = enable;
+    oc_runtime_get()->frameRequested = true;
 }
 
 typedef struct orca_surface_create_data
@@ -297,7 +532,10 @@ i32 orca_surface_callback(void* user)
     switch(data->api)
     {
         case OC_SURFACE_CANVAS:
-            data->surface = oc_canvas_surface_create_for_window(__orcaApp.canvasRenderer, data->window);
+            data->surface = oc_canvas_surface_create_for_window(oc_runtime_get()->canvasRenderer, data->window);
+            break;
+        case OC_SURFACE_IMAGE:
+            data->surface = oc_image_surface_create_for_window(data->window);
             break;
         case OC_SURFACE_GLES:
         default:
@@ -322,714 +560,2631 @@ i32 orca_surface_callback(void* user)
     return (0);
 }
 
-oc_surface oc_bridge_gles_surface_create(void)
+static oc_surface oc_runtime_guest_surface_create(oc_surface_api api)
 {
+    oc_runtime* app = oc_runtime_get();
+    if(app->guestSurfaceCount >= OC_RUNTIME_MAX_GUEST_SURFACES)
+    {
+        oc_log_error("couldn't create surface: the app already has %i surfaces\n", OC_RUNTIME_MAX_GUEST_SURFACES);
+        return (oc_surface_nil());
+    }
+
     orca_surface_create_data data = {
         .surface = oc_surface_nil(),
-        .window = __orcaApp.window,
-        .api = OC_SURFACE_GLES
+        .window = app->window,
+        .api = api
     };
+    oc_dispatch_on_main_thread_sync(app->window, orca_surface_callback, (void*)&data);
 
-    oc_dispatch_on_main_thread_sync(__orcaApp.window, orca_surface_callback, (void*)&data);
-    oc_gles_surface_make_current(data.surface);
+    if(!oc_surface_is_nil(data.surface))
+    {
+        app->guestSurfaces[app->guestSurfaceCount] = data.surface;
+        app->guestSurfaceCount++;
+    }
     return (data.surface);
 }
 
-oc_canvas_renderer oc_bridge_canvas_renderer_create(void)
+//NOTE: GL commands recorded by the guest apply to the current context, so they're replayed before it changes or
+//      presents.
+void oc_bridge_gles_surface_make_current(oc_surface surface)
 {
-    return (__orcaApp.canvasRenderer);
+    oc_runtime_gles_command_buffer_flush(false);
+    oc_runtime_get()->glesSurface = surface;
+    if(oc_runtime_get()->glesThread.enabled)
+    {
+        oc_gles_thread_make_current(&oc_runtime_get()->glesThread, surface);
+    }
+    else
+    {
+        oc_gles_surface_make_current(surface);
+    }
 }
 
-oc_surface oc_bridge_canvas_surface_create(oc_canvas_renderer renderer)
+//NOTE: when several apps run in one process, their reports get the app's index appended to the file name, before
+//      its extension
+static oc_str8 oc_runtime_app_report_path(oc_arena* arena, oc_runtime* app, oc_str8 path)
 {
-    orca_surface_create_data data = {
-        .surface = oc_surface_nil(),
-        .window = __orcaApp.window,
-        .api = OC_SURFACE_CANVAS
-    };
-    //TODO: check renderer
-
-    oc_dispatch_on_main_thread_sync(__orcaApp.window, orca_surface_callback, (void*)&data);
-    return (data.surface);
+    if(s_appCount > 1)
+    {
+        oc_str8 filename = oc_path_slice_filename(path);
+        u64 stemLen = path.len;
+        for(u64 i = filename.len; i > 0; i--)
+        {
+            if(filename.ptr[i - 1] == '.')
+            {
+                stemLen = path.len - filename.len + i - 1;
+                break;
+            }
+        }
+        oc_str8 stem = oc_str8_slice(path, 0, stemLen);
+        oc_str8 ext = oc_str8_slice(path, stemLen, path.len);
+        path = oc_str8_pushf(arena, "%.*s_%u%.*s", oc_str8_ip(stem), (u32)(app - s_apps), oc_str8_ip(ext));
+    }
+    return (path);
 }
 
-void oc_bridge_canvas_renderer_submit(oc_canvas_renderer renderer,
-                                      oc_surface surface,
-                                      u32 msaaSampleCount,
-                                      bool clear,
-                                      oc_color clearColor,
-                                      u32 primitiveCount,
-                                      oc_primitive* primitives,
-                                      u32 eltCount,
-                                      oc_path_elt* elements)
+//NOTE: frames are counted as presented when the app asks to present them, since in render thread and GLES thread
+//      mode the actual present happens asynchronously. This feeds the frame work estimate used to predict present
+//      times, and reports the startup timing on the first frame.
+static void oc_runtime_frame_presented(oc_runtime* app)
 {
-    oc_runtime* app = &__orcaApp;
+    //NOTE: replayed frames have a virtual time and aren't paced, so they don't feed the estimate
+    if(app->frameInfo.frameIndex && s_input.mode != OC_RUNTIME_INPUT_REPLAY)
+    {
+        f64 workTime = oc_clock_time(OC_CLOCK_MONOTONIC) - app->frameInfo.time;
+        app->frameWorkTime = app->frameWorkTime ? 0.9 * app->frameWorkTime + 0.1 * workTime : workTime;
+    }
 
-    char* memBase = app->env.wasmMemory.ptr;
-    u32 memSize = app->env.wasmMemory.committed;
-    oc_rect window_content_rect = oc_window_get_content_rect(app->window);
+    if(app->startup.done)
+    {
+        return;
+    }
+    oc_arena_scope scratch = oc_scratch_begin();
 
-    if(((char*)primitives > memBase)
-       && ((char*)primitives + primitiveCount * sizeof(oc_primitive) - memBase <= memSize)
-       && ((char*)elements > memBase)
-       && ((char*)elements + eltCount * sizeof(oc_path_elt) - memBase <= memSize)
-       && window_content_rect.w > 0
-       && window_content_rect.h > 0
-       && oc_window_is_minimized(app->window) == false)
+    oc_str8 path = s_startup_report_path
+                     ? OC_STR8(s_startup_report_path)
+                     : oc_path_executable_relative(scratch.arena, OC_STR8("startup.json"));
+    path = oc_runtime_app_report_path(scratch.arena, app, path);
+    oc_runtime_startup_report(&app->startup, app->appDir, path);
+
+    oc_scratch_end(scratch);
+
+    if(s_quit_after_startup)
     {
-        oc_canvas_renderer_submit(renderer,
-                                  surface,
-                                  msaaSampleCount,
-                                  clear,
-                                  clearColor,
-                                  primitiveCount,
-                                  primitives,
-                                  eltCount,
-                                  elements);
+        app->quit = true;
     }
 }
 
-void debug_overlay_toggle(oc_debug_overlay* overlay)
+void oc_bridge_gles_surface_swap_buffers(oc_surface surface)
 {
-    overlay->show = !overlay->show;
-
-    if(overlay->show)
+    oc_runtime_frame_presented(oc_runtime_get());
+    oc_runtime_gles_command_buffer_flush(false);
+    if(oc_runtime_get()->glesThread.enabled)
     {
-        overlay->logScrollToLast = true;
+        //NOTE: like in render thread mode, only let the guest get one frame ahead of the GL thread
+        oc_gles_thread_swap_buffers(&oc_runtime_get()->glesThread, surface);
+        oc_gles_thread_wait_frames(&oc_runtime_get()->glesThread, 1);
     }
+    else
+    {
+        oc_gles_surface_swap_buffers(surface);
+    }
+    oc_runtime_get()->env.glesFrameIndex++;
 }
 
-void log_entry_ui(oc_debug_overlay* overlay, log_entry* entry)
+static oc_wasm_gles_upload_region* oc_gles_upload_region_from_handle(oc_gles_upload_region handle)
 {
-    oc_arena_scope scratch = oc_scratch_begin();
-
-    static const char* levelNames[] = { "Error: ", "Warning: ", "Info: " };
-    static const oc_color levelColors[] = { { 0.8, 0, 0, 1 },
-                                            { 1, 0.5, 0, 1 },
-                                            { 0, 0.8, 0, 1 } };
-
-    static const oc_color bgColors[3][2] = { //errors
-                                             { { 0.6, 0, 0, 0.5 }, { 0.8, 0, 0, 0.5 } },
-                                             //warning
-                                             { { 0.4, 0.4, 0.4, 0.5 }, { 0.5, 0.5, 0.5, 0.5 } },
-                                             //info
-                                             { { 0.4, 0.4, 0.4, 0.5 }, { 0.5, 0.5, 0.5, 0.5 } }
-    };
-
-    oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
-                                     .size.height = { OC_UI_SIZE_CHILDREN },
-                                     .layout.axis = OC_UI_AXIS_Y,
-                                     .layout.margin.x = 10,
-                                     .layout.margin.y = 5,
-                                     .bgColor = bgColors[entry->level][entry->recordIndex & 1] },
-                     OC_UI_STYLE_SIZE
-                         | OC_UI_STYLE_LAYOUT_AXIS
-                         | OC_UI_STYLE_LAYOUT_MARGINS
-                         | OC_UI_STYLE_BG_COLOR);
-
-    oc_str8 key = oc_str8_pushf(scratch.arena, "%ull", entry->recordIndex);
+    u32 index = (u32)(handle.h & 0xffffffff) - 1;
+    u32 generation = (u32)(handle.h >> 32);
 
-    oc_ui_container_str8(key, OC_UI_FLAG_DRAW_BACKGROUND)
+    oc_wasm_gles_upload_region* region = 0;
+    if(index < OC_WASM_MAX_GLES_UPLOAD_REGIONS)
     {
-        oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
-                                         .size.height = { OC_UI_SIZE_CHILDREN },
-                                         .layout.axis = OC_UI_AXIS_X },
-                         OC_UI_STYLE_SIZE
-                             | OC_UI_STYLE_LAYOUT_AXIS);
-
-        oc_ui_container("header", 0)
+        region = &oc_runtime_get()->env.glesUploadRegions[index];
+        if(!region->mapping || region->generation != generation)
         {
-            oc_ui_style_next(&(oc_ui_style){ .color = levelColors[entry->level],
-                                             .font = overlay->fontBold },
-                             OC_UI_STYLE_COLOR
-                                 | OC_UI_STYLE_FONT);
-            oc_ui_label(levelNames[entry->level]);
-
-            oc_str8 loc = oc_str8_pushf(scratch.arena,
-                                        "%.*s() in %.*s:%i:",
-                                        oc_str8_ip(entry->function),
-                                        oc_str8_ip(entry->file),
-                                        entry->line);
-            oc_ui_label_str8(loc);
+            region = 0;
         }
-        oc_ui_label_str8(entry->msg);
     }
-    oc_scratch_end(scratch);
+    return (region);
 }
 
-char valtype_to_tag(oc_wasm_valtype type)
+oc_gles_upload_region oc_bridge_gles_upload_region_create(u32 slotSize)
 {
-    switch(type)
+    oc_gles_upload_region handle = { 0 };
+
+    u32 index = 0;
+    while(index < OC_WASM_MAX_GLES_UPLOAD_REGIONS && oc_runtime_get()->env.glesUploadRegions[index].mapping)
     {
-        case OC_WASM_VALTYPE_I32:
-            return ('i');
-        case OC_WASM_VALTYPE_I64:
-            return ('I');
+        index++;
+    }
+    if(index >= OC_WASM_MAX_GLES_UPLOAD_REGIONS)
+    {
+        oc_log_error("oc_gles_upload_region_create(): too many upload regions\n");
+        return (handle);
+    }
+
+    slotSize = oc_align_up_pow2(slotSize, 16);
+    if(!slotSize || slotSize > UINT32_MAX / OC_GLES_UPLOAD_REGION_SLOTS)
+    {
+        oc_log_error("oc_gles_upload_region_create(): invalid slot size %u\n", slotSize);
+        return (handle);
+    }
+
+    oc_wasm_mapping_region* mapping = oc_wasm_mapping_region_acquire((u64)slotSize * OC_GLES_UPLOAD_REGION_SLOTS);
+    if(mapping)
+    {
+        oc_wasm_gles_upload_region* region = &oc_runtime_get()->env.glesUploadRegions[index];
+        region->mapping = mapping;
+        region->slotSize = slotSize;
+        handle.h = ((u64)region->generation << 32) | (index + 1);
+    }
+    return (handle);
+}
+
+void oc_bridge_gles_upload_region_destroy(oc_gles_upload_region handle)
+{
+    oc_wasm_gles_upload_region* region = oc_gles_upload_region_from_handle(handle);
+    if(region)
+    {
+        //NOTE: the GL thread may still read the region's slots
+        oc_gles_thread_sync(&oc_runtime_get()->glesThread);
+
+        oc_wasm_mapping_region_release(region->mapping);
+        region->mapping = 0;
+        region->generation++;
+    }
+}
+
+u32 oc_bridge_gles_upload_region_begin(oc_gles_upload_region handle)
+{
+    u32 addr = 0;
+    oc_wasm_gles_upload_region* region = oc_gles_upload_region_from_handle(handle);
+    if(region)
+    {
+        u32 slot = oc_runtime_get()->env.glesFrameIndex % OC_GLES_UPLOAD_REGION_SLOTS;
+        addr = region->mapping->addr + slot * region->slotSize;
+    }
+    return (addr);
+}
+
+void oc_bridge_gles_upload_region_flush(oc_gles_upload_region handle, u32 target, u32 bufferOffset, u32 offset, u32 size)
+{
+    oc_wasm_gles_upload_region* region = oc_gles_upload_region_from_handle(handle);
+    if(!region)
+    {
+        oc_log_error("oc_gles_upload_region_flush(): invalid upload region\n");
+        return;
+    }
+    if(offset > region->slotSize || size > region->slotSize - offset)
+    {
+        oc_log_error("oc_gles_upload_region_flush(): range [%u, %u) is out of the region's slot of %u bytes\n",
+                     offset,
+                     offset + size,
+                     region->slotSize);
+        return;
+    }
+
+    u32 slot = oc_runtime_get()->env.glesFrameIndex % OC_GLES_UPLOAD_REGION_SLOTS;
+    oc_str8 mem = oc_runtime_get_wasm_memory();
+    const char* data = mem.ptr + region->mapping->addr + slot * region->slotSize + offset;
+
+    //NOTE: the upload goes after the commands the guest recorded before it, e.g. binding the target buffer
+    oc_runtime_gles_command_buffer_flush(false);
+    if(oc_runtime_get()->glesThread.enabled)
+    {
+        oc_gles_thread_buffer_sub_data(&oc_runtime_get()->glesThread, target, bufferOffset, size, data);
+    }
+    else
+    {
+        glBufferSubData(target, bufferOffset, size, data);
+    }
+}
+
+oc_surface oc_bridge_gles_surface_create(void)
+{
+    oc_surface surface = oc_runtime_guest_surface_create(OC_SURFACE_GLES);
+    oc_bridge_gles_surface_make_current(surface);
+    return (surface);
+}
+
+//NOTE: in render thread mode, renderer calls other than submissions and presents wait for the queued jobs to
+//      complete, so that they don't run concurrently with them, and apply in the order the guest made them.
+void oc_bridge_canvas_renderer_set_present_mode(oc_canvas_renderer renderer, oc_canvas_present_mode mode, u32 maxFrameLatency)
+{
+    oc_render_thread_sync(&oc_runtime_get()->renderThread);
+    oc_canvas_renderer_set_present_mode(renderer, mode, maxFrameLatency);
+}
+
+void oc_bridge_canvas_renderer_set_dynamic_scale(oc_canvas_renderer renderer, f32 gpuBudget, f32 minScale)
+{
+    oc_render_thread_sync(&oc_runtime_get()->renderThread);
+    oc_canvas_renderer_set_dynamic_scale(renderer, gpuBudget, minScale);
+}
+
+f32 oc_bridge_canvas_renderer_get_render_scale(oc_canvas_renderer renderer)
+{
+    oc_render_thread_sync(&oc_runtime_get()->renderThread);
+    return (oc_canvas_renderer_get_render_scale(renderer));
+}
+
+oc_image oc_bridge_image_create(oc_canvas_renderer renderer, u32 width, u32 height)
+{
+    oc_render_thread_sync(&oc_runtime_get()->renderThread);
+    return (oc_image_create(renderer, width, height));
+}
+
+void oc_bridge_image_destroy(oc_image image)
+{
+    oc_render_thread_sync(&oc_runtime_get()->renderThread);
+    oc_image_destroy(image);
+}
+
+void oc_bridge_image_upload_region_rgba8(oc_image image, oc_rect region, u8* pixels)
+{
+    oc_render_thread_sync(&oc_runtime_get()->renderThread);
+    oc_image_upload_region_rgba8(image, region, pixels);
+}
+
+bool oc_bridge_image_is_ready(oc_image image)
+{
+    //NOTE: this uploads images that finished decoding
+    oc_render_thread_sync(&oc_runtime_get()->renderThread);
+    return (oc_image_is_ready(image));
+}
+
+bool oc_bridge_image_upload_done(oc_image image)
+{
+    oc_render_thread_sync(&oc_runtime_get()->renderThread);
+    return (oc_image_upload_done(image));
+}
+
+oc_image oc_bridge_image_create_render_target(oc_canvas_renderer renderer, u32 width, u32 height)
+{
+    oc_render_thread_sync(&oc_runtime_get()->renderThread);
+    return (oc_image_create_render_target(renderer, width, height));
+}
+
+void oc_bridge_image_readback_region(oc_image image, oc_rect region)
+{
+    oc_render_thread_sync(&oc_runtime_get()->renderThread);
+    oc_image_readback_region(image, region);
+}
+
+bool oc_bridge_image_readback_done(oc_image image)
+{
+    oc_render_thread_sync(&oc_runtime_get()->renderThread);
+    return (oc_image_readback_done(image));
+}
+
+bool oc_bridge_image_readback_get(oc_image image, u64 size, u8* pixels)
+{
+    oc_render_thread_sync(&oc_runtime_get()->renderThread);
+    return (oc_image_readback_get(image, size, pixels));
+}
+
+oc_canvas_renderer oc_bridge_canvas_renderer_create(void)
+{
+    return (oc_runtime_get()->canvasRenderer);
+}
+
+oc_canvas_renderer oc_bridge_canvas_renderer_create_with_options(oc_canvas_renderer_options* options)
+{
+    //NOTE: apps share the renderer created by the runtime, which already chose its adapter. We can still apply the
+    //      presentation options to it.
+    if(options->powerPreference != OC_CANVAS_POWER_HIGH_PERFORMANCE)
+    {
+        oc_log_warning("the canvas renderer's power preference can't be changed by the app, ignoring it.\n");
+    }
+    if(options->backend != OC_CANVAS_BACKEND_DEFAULT)
+    {
+        oc_log_warning("the canvas renderer's backend can't be chosen by the app, ignoring it.\n");
+    }
+    oc_bridge_canvas_renderer_set_present_mode(oc_runtime_get()->canvasRenderer, options->presentMode, options->maxFrameLatency);
+    return (oc_runtime_get()->canvasRenderer);
+}
+
+oc_surface oc_bridge_canvas_surface_create(oc_canvas_renderer renderer)
+{
+    //TODO: check renderer
+    return (oc_runtime_guest_surface_create(OC_SURFACE_CANVAS));
+}
+
+oc_surface oc_bridge_image_surface_create(void)
+{
+    return (oc_runtime_guest_surface_create(OC_SURFACE_IMAGE));
+}
+
+oc_image oc_bridge_image_create_from_memory_async(oc_canvas_renderer renderer, oc_wasm_str8 mem, bool flip)
+{
+    oc_image image = oc_image_nil();
+    oc_str8 nativeMem = oc_wasm_str8_to_native(mem);
+    if(nativeMem.ptr)
+    {
+        oc_render_thread_sync(&oc_runtime_get()->renderThread);
+        image = oc_image_create_from_memory_async(renderer, nativeMem, flip);
+    }
+    return (image);
+}
+
+oc_image oc_bridge_image_create_compressed(oc_canvas_renderer renderer, oc_image_compressed_format format, u32 width, u32 height, oc_wasm_str8 data)
+{
+    oc_image image = oc_image_nil();
+    oc_str8 nativeData = oc_wasm_str8_to_native(data);
+    if(nativeData.ptr)
+    {
+        oc_render_thread_sync(&oc_runtime_get()->renderThread);
+        image = oc_image_create_compressed(renderer, format, width, height, nativeData);
+    }
+    return (image);
+}
+
+oc_image oc_bridge_tiled_image_create(oc_canvas_renderer renderer, u32 width, u32 height)
+{
+    oc_render_thread_sync(&oc_runtime_get()->renderThread);
+    return (oc_tiled_image_create(renderer, width, height));
+}
+
+u32 oc_bridge_tiled_image_requests(oc_image image, u32 maxCount, oc_image_tile* tiles)
+{
+    //NOTE: requests are gathered when frames are encoded, and this also uploads the tiles that finished decoding
+    oc_render_thread_sync(&oc_runtime_get()->renderThread);
+    return (oc_tiled_image_requests(image, maxCount, tiles));
+}
+
+bool oc_bridge_tiled_image_upload_tile(oc_image image, oc_image_tile tile, u8* pixels)
+{
+    oc_render_thread_sync(&oc_runtime_get()->renderThread);
+    return (oc_tiled_image_upload_tile(image, tile, pixels));
+}
+
+void oc_bridge_tiled_image_load_tile_from_memory_async(oc_image image, oc_image_tile tile, oc_wasm_str8 mem, bool flip)
+{
+    oc_str8 nativeMem = oc_wasm_str8_to_native(mem);
+    if(nativeMem.ptr)
+    {
+        oc_render_thread_sync(&oc_runtime_get()->renderThread);
+        oc_tiled_image_load_tile_from_memory_async(image, tile, nativeMem, flip);
+    }
+}
+
+oc_image oc_bridge_image_create_yuv(oc_canvas_renderer renderer,
+                                   oc_image_yuv_format format,
+                                   oc_image_yuv_color_space colorSpace,
+                                   u32 width,
+                                   u32 height)
+{
+    oc_render_thread_sync(&oc_runtime_get()->renderThread);
+    return (oc_image_create_yuv(renderer, format, colorSpace, width, height));
+}
+
+void oc_bridge_image_upload_yuv_plane(oc_image image, u32 plane, u8* pixels)
+{
+    oc_render_thread_sync(&oc_runtime_get()->renderThread);
+    oc_image_upload_yuv_plane(image, plane, pixels);
+}
+
+oc_font oc_bridge_font_host_create(oc_wasm_str8 mem, u32 rangeCount, oc_unicode_range* ranges, bool lazy, u32 maxLoadedOutlines)
+{
+    //NOTE: native copy of a guest font, which the guest uses to measure and outline glyph runs through
+    //      oc_font_glyph_run_metrics() and oc_font_glyph_run_outlines(). Native fonts don't point into guest memory,
+    //      so app instances that create the same font share one copy.
+    oc_font font = oc_font_nil();
+    oc_str8 nativeMem = oc_wasm_str8_to_native(mem);
+    if(nativeMem.ptr)
+    {
+        u64 key = oc_hash_xx64_string(nativeMem);
+        key = oc_hash_xx64_string_seed(oc_str8_from_buffer(rangeCount * sizeof(oc_unicode_range), (char*)ranges), key);
+        key ^= ((u64)maxLoadedOutlines << 1) | (lazy ? 1 : 0);
+
+        oc_list_for(s_shared.fonts, entry, oc_runtime_shared_font, listElt)
+        {
+            if(entry->key == key)
+            {
+                entry->refCount++;
+                return (entry->font);
+            }
+        }
+
+        oc_render_thread_sync(&oc_runtime_get()->renderThread);
+        font = lazy
+                 ? oc_font_create_from_memory_lazy(nativeMem, rangeCount, ranges, maxLoadedOutlines)
+                 : oc_font_create_from_memory(nativeMem, rangeCount, ranges);
+
+        if(!oc_font_is_nil(font))
+        {
+            oc_runtime_shared_font* entry = oc_list_pop_front_entry(&s_shared.fontFreeList, oc_runtime_shared_font, listElt);
+            if(!entry)
+            {
+                entry = oc_arena_push_type(&s_shared.fontArena, oc_runtime_shared_font);
+            }
+            *entry = (oc_runtime_shared_font){ .key = key, .font = font, .refCount = 1 };
+            oc_list_push_back(&s_shared.fonts, &entry->listElt);
+        }
+    }
+    return (font);
+}
+
+void oc_bridge_font_host_destroy(oc_font font)
+{
+    oc_list_for(s_shared.fonts, entry, oc_runtime_shared_font, listElt)
+    {
+        if(entry->font.h == font.h)
+        {
+            entry->refCount--;
+            if(entry->refCount)
+            {
+                return;
+            }
+            oc_list_remove(&s_shared.fonts, &entry->listElt);
+            oc_list_push_back(&s_shared.fontFreeList, &entry->listElt);
+            break;
+        }
+    }
+
+    oc_render_thread_sync(&oc_runtime_get()->renderThread);
+    oc_font_destroy(font);
+}
+
+void oc_bridge_canvas_renderer_submit(oc_canvas_renderer renderer,
+                                      oc_surface surface,
+                                      u32 msaaSampleCount,
+                                      bool clear,
+                                      oc_color clearColor,
+                                      oc_rect damage,
+                                      u32 primitiveCount,
+                                      oc_primitive* primitives,
+                                      u32 attributeCount,
+                                      oc_attributes* attributes,
+                                      u32 eltCount,
+                                      oc_path_elt* elements)
+{
+    oc_runtime* app = oc_runtime_get();
+
+    char* memBase = app->env.wasmMemory.ptr;
+    u32 memSize = app->env.wasmMemory.committed;
+    oc_rect window_content_rect = oc_window_get_content_rect(app->window);
+
+    if(((char*)primitives > memBase)
+       && ((char*)primitives + primitiveCount * sizeof(oc_primitive) - memBase <= memSize)
+       && ((char*)attributes > memBase)
+       && ((char*)attributes + attributeCount * sizeof(oc_attributes) - memBase <= memSize)
+       && ((char*)elements > memBase)
+       && ((char*)elements + eltCount * sizeof(oc_path_elt) - memBase <= memSize)
+       && window_content_rect.w > 0
+       && window_content_rect.h > 0
+       && oc_window_is_minimized(app->window) == false)
+    {
+        if(app->renderThread.enabled)
+        {
+            oc_render_thread_submit(&app->renderThread,
+                                    renderer,
+                                    surface,
+                                    msaaSampleCount,
+                                    clear,
+                                    clearColor,
+                                    damage,
+                                    primitiveCount,
+                                    primitives,
+                                    attributeCount,
+                                    attributes,
+                                    eltCount,
+                                    elements);
+        }
+        else
+        {
+            oc_canvas_renderer_submit(renderer,
+                                      surface,
+                                      msaaSampleCount,
+                                      clear,
+                                      clearColor,
+                                      damage,
+                                      primitiveCount,
+                                      primitives,
+                                      attributeCount,
+                                      attributes,
+                                      eltCount,
+                                      elements);
+        }
+    }
+}
+
+void oc_bridge_canvas_renderer_submit_image(oc_canvas_renderer renderer,
+                                            oc_image image,
+                                            u32 msaaSampleCount,
+                                            bool clear,
+                                            oc_color clearColor,
+                                            u32 primitiveCount,
+                                            oc_primitive* primitives,
+                                            u32 attributeCount,
+                                            oc_attributes* attributes,
+                                            u32 eltCount,
+                                            oc_path_elt* elements)
+{
+    oc_runtime* app = oc_runtime_get();
+
+    char* memBase = app->env.wasmMemory.ptr;
+    u32 memSize = app->env.wasmMemory.committed;
+
+    //NOTE: unlike surfaces, images can be rendered to while the window is minimized
+    if(((char*)primitives > memBase)
+       && ((char*)primitives + primitiveCount * sizeof(oc_primitive) - memBase <= memSize)
+       && ((char*)attributes > memBase)
+       && ((char*)attributes + attributeCount * sizeof(oc_attributes) - memBase <= memSize)
+       && ((char*)elements > memBase)
+       && ((char*)elements + eltCount * sizeof(oc_path_elt) - memBase <= memSize))
+    {
+        if(app->renderThread.enabled)
+        {
+            oc_render_thread_submit_image(&app->renderThread,
+                                          renderer,
+                                          image,
+                                          msaaSampleCount,
+                                          clear,
+                                          clearColor,
+                                          primitiveCount,
+                                          primitives,
+                                          attributeCount,
+                                          attributes,
+                                          eltCount,
+                                          elements);
+        }
+        else
+        {
+            oc_canvas_renderer_submit_image(renderer,
+                                            image,
+                                            msaaSampleCount,
+                                            clear,
+                                            clearColor,
+                                            primitiveCount,
+                                            primitives,
+                                            attributeCount,
+                                            attributes,
+                                            eltCount,
+                                            elements);
+        }
+    }
+}
+
+void oc_bridge_canvas_present(oc_canvas_renderer renderer, oc_surface surface)
+{
+    oc_runtime* app = oc_runtime_get();
+    oc_runtime_frame_presented(app);
+    if(app->renderThread.enabled)
+    {
+        oc_render_thread_present(&app->renderThread, renderer, surface);
+    }
+    else
+    {
+        oc_canvas_present(renderer, surface);
+    }
+}
+
+void debug_overlay_toggle(oc_debug_overlay* overlay)
+{
+    overlay->show = !overlay->show;
+
+    if(overlay->show)
+    {
+        overlay->logScrollToLast = true;
+    }
+}
+
+void log_entry_ui(oc_debug_overlay* overlay, log_entry* entry)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    static const char* levelNames[] = { "Error: ", "Warning: ", "Info: " };
+    static const oc_color levelColors[] = { { 0.8, 0, 0, 1 },
+                                            { 1, 0.5, 0, 1 },
+                                            { 0, 0.8, 0, 1 } };
+
+    static const oc_color bgColors[3][2] = { //errors
+                                             { { 0.6, 0, 0, 0.5 }, { 0.8, 0, 0, 0.5 } },
+                                             //warning
+                                             { { 0.4, 0.4, 0.4, 0.5 }, { 0.5, 0.5, 0.5, 0.5 } },
+                                             //info
+                                             { { 0.4, 0.4, 0.4, 0.5 }, { 0.5, 0.5, 0.5, 0.5 } }
+    };
+
+    oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                     .size.height = { OC_UI_SIZE_CHILDREN },
+                                     .layout.axis = OC_UI_AXIS_Y,
+                                     .layout.margin.x = 10,
+                                     .layout.margin.y = 5,
+                                     .bgColor = bgColors[entry->level][entry->recordIndex & 1] },
+                     OC_UI_STYLE_SIZE
+                         | OC_UI_STYLE_LAYOUT_AXIS
+                         | OC_UI_STYLE_LAYOUT_MARGINS
+                         | OC_UI_STYLE_BG_COLOR);
+
+    oc_str8 key = oc_str8_pushf(scratch.arena, "%ull", entry->recordIndex);
+
+    oc_ui_container_str8(key, OC_UI_FLAG_DRAW_BACKGROUND)
+    {
+        oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                         .size.height = { OC_UI_SIZE_CHILDREN },
+                                         .layout.axis = OC_UI_AXIS_X },
+                         OC_UI_STYLE_SIZE
+                             | OC_UI_STYLE_LAYOUT_AXIS);
+
+        oc_ui_container("header", 0)
+        {
+            oc_ui_style_next(&(oc_ui_style){ .color = levelColors[entry->level],
+                                             .font = overlay->fontBold },
+                             OC_UI_STYLE_COLOR
+                                 | OC_UI_STYLE_FONT);
+            oc_ui_label(levelNames[entry->level]);
+
+            oc_str8 loc = oc_str8_pushf(scratch.arena,
+                                        "%.*s() in %.*s:%i:",
+                                        oc_str8_ip(entry->function),
+                                        oc_str8_ip(entry->file),
+                                        entry->line);
+            oc_ui_label_str8(loc);
+        }
+        oc_ui_label_str8(entry->msg);
+    }
+    oc_scratch_end(scratch);
+}
+
+//NOTE: the log view asks for consecutive rows, so we keep the last entry we visited instead of walking the list
+//      from its start for each row.
+typedef struct log_view_cursor
+{
+    oc_debug_overlay* overlay;
+    log_entry* entry;
+    u64 row;
+} log_view_cursor;
+
+void log_view_row(u64 row, void* user)
+{
+    log_view_cursor* cursor = (log_view_cursor*)user;
+    if(!cursor->entry || row < cursor->row)
+    {
+        cursor->entry = oc_list_first_entry(cursor->overlay->logEntries, log_entry, listElt);
+        cursor->row = 0;
+    }
+    while(cursor->entry && cursor->row < row)
+    {
+        cursor->entry = oc_list_next_entry(cursor->entry, log_entry, listElt);
+        cursor->row++;
+    }
+    if(cursor->entry)
+    {
+        log_entry_ui(cursor->overlay, cursor->entry);
+    }
+}
+
+void call_stats_row_ui(oc_str8 key, oc_str8 name, oc_str8 count, oc_str8 time, oc_str8 mean, oc_str8 max)
+{
+    oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                     .size.height = { OC_UI_SIZE_CHILDREN },
+                                     .layout.axis = OC_UI_AXIS_X },
+                     OC_UI_STYLE_SIZE
+                         | OC_UI_STYLE_LAYOUT_AXIS);
+
+    oc_ui_container_str8(key, 0)
+    {
+        oc_str8 columns[] = { name, count, time, mean, max };
+        f32 widths[] = { 300, 120, 120, 120, 120 };
+
+        for(int i = 0; i < oc_array_size(columns); i++)
+        {
+            oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PIXELS, widths[i] } },
+                             OC_UI_STYLE_SIZE_WIDTH);
+            oc_ui_label_str8(columns[i]);
+        }
+    }
+}
+
+void call_stats_ui(oc_runtime* app)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_runtime_call_stats_summary* summaries = 0;
+    u32 count = oc_runtime_call_stats_summarize(scratch.arena, &app->profiler, &summaries);
+
+    oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                     .size.height = { OC_UI_SIZE_PARENT, 1, 1 },
+                                     .layout.axis = OC_UI_AXIS_Y,
+                                     .layout.margin.x = 10,
+                                     .layout.margin.y = 10,
+                                     .bgColor = { 0, 0, 0, 0.5 } },
+                     OC_UI_STYLE_SIZE
+                         | OC_UI_STYLE_LAYOUT_AXIS
+                         | OC_UI_STYLE_LAYOUT_MARGINS
+                         | OC_UI_STYLE_BG_COLOR);
+
+    oc_ui_panel("call stats", OC_UI_FLAG_DRAW_BACKGROUND | OC_UI_FLAG_SCROLL_WHEEL_Y)
+    {
+        oc_ui_style_next(&(oc_ui_style){ .font = app->debugOverlay.fontBold }, OC_UI_STYLE_FONT);
+        call_stats_row_ui(OC_STR8("header"),
+                          OC_STR8("function"),
+                          OC_STR8("calls/frame"),
+                          OC_STR8("ms/frame"),
+                          OC_STR8("us/call"),
+                          OC_STR8("max ms/frame"));
+
+        for(u32 i = 0; i < count; i++)
+        {
+            oc_runtime_call_stats_summary* summary = &summaries[i];
+            f64 meanCall = summary->meanCount ? (summary->meanTime / summary->meanCount) : 0;
+
+            oc_str8 name = summary->isExport
+                             ? oc_str8_pushf(scratch.arena, "[export] %.*s", oc_str8_ip(summary->name))
+                             : summary->name;
+
+            call_stats_row_ui(oc_str8_pushf(scratch.arena, "%.*s%i", oc_str8_ip(summary->name), summary->isExport),
+                              name,
+                              oc_str8_pushf(scratch.arena, "%.1f", summary->meanCount),
+                              oc_str8_pushf(scratch.arena, "%.3f", summary->meanTime * 1000),
+                              oc_str8_pushf(scratch.arena, "%.2f", meanCall * 1e6),
+                              oc_str8_pushf(scratch.arena, "%.3f", summary->maxTime * 1000));
+        }
+    }
+    oc_scratch_end(scratch);
+}
+
+void heatmap_legend_ui(oc_wgpu_canvas_debug_display_options* options)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                     .size.height = { OC_UI_SIZE_CHILDREN },
+                                     .layout.axis = OC_UI_AXIS_X,
+                                     .layout.spacing = 6,
+                                     .layout.align.y = OC_UI_ALIGN_CENTER,
+                                     .layout.margin.x = 10,
+                                     .layout.margin.y = 4 },
+                     OC_UI_STYLE_SIZE
+                         | OC_UI_STYLE_LAYOUT_AXIS
+                         | OC_UI_STYLE_LAYOUT_SPACING
+                         | OC_UI_STYLE_LAYOUT_ALIGN_Y
+                         | OC_UI_STYLE_LAYOUT_MARGINS);
+
+    oc_ui_container("heatmap legend", 0)
+    {
+        oc_ui_label_str8(oc_str8_pushf(scratch.arena, "%s:", oc_wgpu_canvas_heatmap_name(options->heatmap)));
+
+        //NOTE: one swatch per stop of the ramp, or per color of the batches palette
+        bool batches = (options->heatmap == OC_WGPU_CANVAS_HEATMAP_BATCHES);
+        u32 scale = options->heatmapScale ? options->heatmapScale : oc_wgpu_canvas_heatmap_default_scale(options->heatmap);
+        u32 swatchCount = batches ? OC_WGPU_CANVAS_HEATMAP_BATCH_COLOR_COUNT : 5;
+
+        for(u32 swatchIndex = 0; swatchIndex < swatchCount; swatchIndex++)
+        {
+            u32 count = swatchIndex;
+            oc_str8 text = { 0 };
+            if(batches)
+            {
+                text = oc_str8_pushf(scratch.arena, "batch %u", swatchIndex);
+            }
+            else
+            {
+                count = (u32)(powf(1 + scale, swatchIndex / (f32)(swatchCount - 1)) - 1 + 0.5);
+                text = oc_str8_pushf(scratch.arena, (swatchIndex == swatchCount - 1) ? "%u+" : "%u", count);
+            }
+
+            oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PIXELS, 12 },
+                                             .size.height = { OC_UI_SIZE_PIXELS, 12 },
+                                             .bgColor = oc_wgpu_canvas_heatmap_color(options->heatmap, count, scale) },
+                             OC_UI_STYLE_SIZE
+                                 | OC_UI_STYLE_BG_COLOR);
+
+            oc_ui_box_make_str8(oc_str8_pushf(scratch.arena, "swatch %u", swatchIndex), OC_UI_FLAG_DRAW_BACKGROUND);
+            oc_ui_label_str8(text);
+        }
+    }
+
+    oc_scratch_end(scratch);
+}
+
+void heap_sites_ui(oc_runtime* app)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_runtime_heap_profile profile = oc_runtime_heap_profile_get(scratch.arena);
+
+    oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                     .size.height = { OC_UI_SIZE_PARENT, 1, 1 },
+                                     .layout.axis = OC_UI_AXIS_Y,
+                                     .layout.margin.x = 10,
+                                     .layout.margin.y = 10,
+                                     .bgColor = { 0, 0, 0, 0.5 } },
+                     OC_UI_STYLE_SIZE
+                         | OC_UI_STYLE_LAYOUT_AXIS
+                         | OC_UI_STYLE_LAYOUT_MARGINS
+                         | OC_UI_STYLE_BG_COLOR);
+
+    oc_ui_panel("heap sites", OC_UI_FLAG_DRAW_BACKGROUND | OC_UI_FLAG_SCROLL_WHEEL_Y)
+    {
+        oc_ui_style_next(&(oc_ui_style){ .font = app->debugOverlay.fontBold }, OC_UI_STYLE_FONT);
+        call_stats_row_ui(OC_STR8("header"),
+                          OC_STR8("tag"),
+                          OC_STR8("live KB"),
+                          OC_STR8("peak KB"),
+                          OC_STR8("live allocs"),
+                          OC_STR8("total MB"));
+
+        for(u32 i = 0; i < profile.siteCount; i++)
+        {
+            oc_runtime_heap_site* site = &profile.sites[i];
+            call_stats_row_ui(oc_str8_pushf(scratch.arena, "site %.*s", oc_str8_ip(site->tag)),
+                              site->tag,
+                              oc_str8_pushf(scratch.arena, "%.1f", site->liveBytes / 1024.),
+                              oc_str8_pushf(scratch.arena, "%.1f", site->peakBytes / 1024.),
+                              oc_str8_pushf(scratch.arena, "%llu", (unsigned long long)(site->allocCount - site->freeCount)),
+                              oc_str8_pushf(scratch.arena, "%.2f", site->totalBytes / (f64)(1 << 20)));
+        }
+    }
+    oc_scratch_end(scratch);
+}
+
+void memory_stats_ui(oc_runtime* app)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_canvas_memory_stats stats = oc_canvas_renderer_get_memory_stats(app->canvasRenderer);
+
+    oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                     .size.height = { OC_UI_SIZE_CHILDREN },
+                                     .layout.axis = OC_UI_AXIS_Y,
+                                     .layout.margin.x = 10,
+                                     .layout.margin.y = 10,
+                                     .bgColor = { 0, 0, 0, 0.5 } },
+                     OC_UI_STYLE_SIZE
+                         | OC_UI_STYLE_LAYOUT_AXIS
+                         | OC_UI_STYLE_LAYOUT_MARGINS
+                         | OC_UI_STYLE_BG_COLOR);
+
+    oc_ui_container("renderer memory", OC_UI_FLAG_DRAW_BACKGROUND)
+    {
+        oc_ui_style_next(&(oc_ui_style){ .font = app->debugOverlay.fontBold }, OC_UI_STYLE_FONT);
+        call_stats_row_ui(OC_STR8("header"),
+                          OC_STR8("renderer memory"),
+                          OC_STR8("MB"),
+                          OC_STR8("peak MB"),
+                          OC_STR8(""),
+                          OC_STR8(""));
+
+        struct
+        {
+            const char* name;
+            oc_canvas_memory_usage usage;
+        } rows[] = {
+            { "path buffers", stats.pathBuffers },
+            { "raster buffers", stats.rasterBuffers },
+            { "images", stats.images },
+            { "targets", stats.targets },
+            { "staging", stats.staging },
+            { "total", stats.total },
+        };
+
+        for(int i = 0; i < oc_array_size(rows); i++)
+        {
+            call_stats_row_ui(oc_str8_pushf(scratch.arena, "memory %s", rows[i].name),
+                              OC_STR8(rows[i].name),
+                              oc_str8_pushf(scratch.arena, "%.2f", rows[i].usage.bytes / (f64)(1 << 20)),
+                              oc_str8_pushf(scratch.arena, "%.2f", rows[i].usage.peakBytes / (f64)(1 << 20)),
+                              OC_STR8(""),
+                              OC_STR8(""));
+        }
+    }
+    oc_scratch_end(scratch);
+}
+
+char valtype_to_tag(oc_wasm_valtype type)
+{
+    switch(type)
+    {
+        case OC_WASM_VALTYPE_I32:
+            return ('i');
+        case OC_WASM_VALTYPE_I64:
+            return ('I');
         case OC_WASM_VALTYPE_F32:
             return ('f');
         case OC_WASM_VALTYPE_F64:
             return ('F');
     }
 
-    return ('!');
+    return ('!');
+}
+
+void oc_wasm_env_init(oc_wasm_env* runtime)
+{
+    memset(runtime, 0, sizeof(oc_wasm_env));
+    runtime->wasmMemory.committed = 0;
+#if OC_WASM_GUARD_PAGES
+    //NOTE: large pages are committed whole, so out-of-bounds accesses wouldn't always land on uncommitted pages
+    runtime->wasmMemory.base = oc_base_allocator_default();
+    runtime->wasmMemory.reserved = OC_WASM_GUARD_RESERVE_SIZE;
+#else
+    runtime->wasmMemory.base = s_large_pages ? oc_base_allocator_large_pages() : oc_base_allocator_default();
+    runtime->wasmMemory.reserved = 4ULL << 30;
+#endif
+    runtime->wasmMemory.ptr = oc_base_reserve(runtime->wasmMemory.base, runtime->wasmMemory.reserved);
+}
+
+oc_wasm_status oc_runtime_call_export(oc_runtime* app, guest_export_kind kind, oc_wasm_val* params, size_t countParams, oc_wasm_val* returns, size_t countReturns)
+{
+    f64 start = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+    if(app->failed || app->exited)
+    {
+        //NOTE: a stopped guest may be in an inconsistent state, so it isn't run again
+        return (app->exited ? OC_WASM_STATUS_FAIL_TRAP_EXIT : OC_WASM_STATUS_FAIL_TRAP_ABORT);
+    }
+
+    OC_TRACE_BEGIN(OC_EXPORT_DESC[kind].name.ptr);
+    oc_wasm_call_stub* stub = &app->env.exportStubs[kind];
+    OC_DEBUG_ASSERT(countParams == stub->countParams && countReturns == stub->countReturns);
+    oc_wasm_status status = oc_wasm_call_stub_invoke(app->env.wasm, stub, params, returns);
+    OC_TRACE_END();
+
+    f64 end = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+    oc_runtime_watchdog* watchdog = &app->watchdog;
+    if(watchdog->budget > 0 && end - start > watchdog->budget && kind != OC_EXPORT_ON_INIT && kind != OC_EXPORT_ON_TEST)
+    {
+        watchdog->history[watchdog->historyIndex] = (oc_runtime_overrun){
+            .exportKind = kind,
+            .time = start,
+            .duration = end - start,
+        };
+        watchdog->historyIndex = (watchdog->historyIndex + 1) % OC_RUNTIME_OVERRUN_HISTORY;
+        watchdog->overrunCount++;
+
+        oc_trace_zone_complete(OC_EXPORT_DESC[kind].name.ptr, OC_TRACE_TRACK_OVERRUNS, start, end);
+
+        //NOTE: don't flood the log if the guest overruns every frame
+        if(end - watchdog->lastWarningTime > 1)
+        {
+            oc_log_warning("%.*s() took %.2fms, over the %.2fms callback budget (%llu overruns so far)\n",
+                           oc_str8_ip(OC_EXPORT_DESC[kind].name),
+                           (end - start) * 1000,
+                           watchdog->budget * 1000,
+                           (unsigned long long)watchdog->overrunCount);
+            watchdog->lastWarningTime = end;
+        }
+    }
+    return (status);
+}
+
+void oc_runtime_event_batch_flush(oc_runtime* app, u32* count)
+{
+    if(*count)
+    {
+        oc_wasm_val params[2];
+        params[0].I32 = (i32)app->env.eventBatchOffset;
+        params[1].I32 = (i32)*count;
+
+        oc_wasm_status status = oc_runtime_call_export(app, OC_EXPORT_EVENTS, params, oc_array_size(params), NULL, 0);
+        OC_WASM_TRAP(status);
+
+        *count = 0;
+    }
+    //NOTE: clipboard access granted by a paste event stays allowed until the batch containing it is delivered
+    oc_runtime_clipboard_process_event_end(&app->clipboard);
+}
+
+void oc_runtime_event_batch_push(oc_runtime* app, u32* count, oc_event* event)
+{
+    if(!oc_is_little_endian())
+    {
+        oc_log_error("oc_on_events() is not supported on big endian platforms");
+        return;
+    }
+
+    oc_event* batch = (oc_event*)oc_wasm_address_to_ptr(app->env.eventBatchOffset, OC_EVENT_BATCH_MAX_COUNT * sizeof(oc_event));
+    memcpy(&batch[*count], event, sizeof(oc_event));
+    (*count)++;
+
+    if(*count >= OC_EVENT_BATCH_MAX_COUNT)
+    {
+        oc_runtime_event_batch_flush(app, count);
+    }
+}
+
+//NOTE: keeps the input summary of the frame info up to date. This sees every event, whether the guest handles
+//      it or not.
+void oc_runtime_frame_info_process_event(oc_runtime* app, oc_event* event)
+{
+    oc_frame_info* info = &app->frameInfo;
+
+    switch(event->type)
+    {
+        case OC_EVENT_KEYBOARD_KEY:
+        case OC_EVENT_KEYBOARD_MODS:
+            info->keyMods = event->key.mods;
+            break;
+
+        case OC_EVENT_MOUSE_BUTTON:
+            if(event->key.button < OC_MOUSE_BUTTON_COUNT)
+            {
+                if(event->key.action == OC_KEY_PRESS)
+                {
+                    info->mouseButtons |= 1 << event->key.button;
+                }
+                else if(event->key.action == OC_KEY_RELEASE)
+                {
+                    info->mouseButtons &= ~(1 << event->key.button);
+                }
+            }
+            info->keyMods = event->key.mods;
+            break;
+
+        case OC_EVENT_MOUSE_MOVE:
+            info->mousePos = (oc_vec2){ event->mouse.x, event->mouse.y };
+            info->keyMods = event->mouse.mods;
+            break;
+
+        case OC_EVENT_WINDOW_RESIZE:
+            info->contentSize = (oc_vec2){ event->move.content.w, event->move.content.h };
+            info->contentScaling = oc_surface_contents_scaling(app->debugOverlay.surface).x;
+            break;
+
+        case OC_EVENT_WINDOW_MOVE:
+            //NOTE: the window may have moved to a screen with a different scaling
+            info->contentScaling = oc_surface_contents_scaling(app->debugOverlay.surface).x;
+            break;
+
+        case OC_EVENT_WINDOW_FOCUS:
+            info->focused = 1;
+            break;
+
+        case OC_EVENT_WINDOW_UNFOCUS:
+            //NOTE: releases that happen while the window isn't focused aren't reported
+            info->focused = 0;
+            info->mouseButtons = 0;
+            info->keyMods = 0;
+            break;
+
+        default:
+            break;
+    }
+}
+
+//NOTE: returns the first vblank at or after time
+static f64 oc_runtime_next_vblank(oc_vsync_timing timing, f64 time)
+{
+    return (timing.vblankTime + ceil((time - timing.vblankTime) / timing.refreshPeriod) * timing.refreshPeriod);
+}
+
+//NOTE: starts a new frame in the frame info and copies it to the guest's oc_frameInfo, if it has one
+void oc_runtime_frame_info_write(oc_runtime* app)
+{
+    oc_frame_info* info = &app->frameInfo;
+
+    //NOTE: the window size and scaling are then kept up to date by resize and move events
+    if(info->frameIndex == 0)
+    {
+        oc_rect content = oc_window_get_content_rect(app->window);
+        info->contentSize = (oc_vec2){ content.w, content.h };
+        info->contentScaling = oc_surface_contents_scaling(app->debugOverlay.surface).x;
+    }
+
+    f64 now = (s_input.mode == OC_RUNTIME_INPUT_REPLAY)
+                ? oc_runtime_input_replay_time(&s_input)
+                : oc_clock_time(OC_CLOCK_MONOTONIC);
+    info->deltaTime = info->frameIndex ? now - info->time : 0;
+    info->time = now;
+    info->frameIndex++;
+
+    //NOTE: the frame is displayed at the first vblank after its work is done. In render thread mode it's rendered
+    //      while the guest builds the next frame, which delays it by one more refresh.
+    oc_vsync_timing timing = oc_vsync_get_timing(app->window);
+    info->refreshPeriod = timing.refreshPeriod;
+    info->presentTime = 0;
+    if(timing.refreshPeriod > 0)
+    {
+        info->presentTime = oc_runtime_next_vblank(timing, now + app->frameWorkTime);
+        if(app->renderThread.enabled)
+        {
+            info->presentTime += timing.refreshPeriod;
+        }
+    }
+
+    if(app->env.frameInfoOffset && oc_is_little_endian())
+    {
+        oc_frame_info* guestInfo = (oc_frame_info*)oc_wasm_address_to_ptr(app->env.frameInfoOffset, sizeof(oc_frame_info));
+        memcpy(guestInfo, info, sizeof(oc_frame_info));
+    }
+}
+
+//NOTE: with --late-frame-start, frames start as late as possible while still making the vblank they target, so that
+//      input is sampled closer to the time the frame is displayed. The margin absorbs frame time variance.
+static void oc_runtime_wait_late_frame_start(oc_runtime* firstApp)
+{
+    f64 workTime = 0;
+    for(u32 appIndex = 0; appIndex < s_appCount; appIndex++)
+    {
+        if(!s_apps[appIndex].stopped)
+        {
+            workTime = oc_max(workTime, s_apps[appIndex].frameWorkTime);
+        }
+    }
+    oc_vsync_timing timing = oc_vsync_get_timing(firstApp->window);
+    if(timing.refreshPeriod <= 0 || workTime <= 0)
+    {
+        return;
+    }
+    f64 margin = 0.001 + 0.25 * workTime;
+    f64 now = oc_clock_time(OC_CLOCK_MONOTONIC);
+    oc_sleep_until(oc_runtime_next_vblank(timing, now + workTime + margin) - workTime - margin);
+}
+
+//NOTE: compiles a slice of a module whose compilation was deferred (see --compile-budget). Functions that are called
+//      before their slice is reached are compiled on their first call.
+void oc_runtime_compile_step(oc_runtime* app)
+{
+    OC_TRACE_BEGIN("wasm compile");
+    f64 start = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+    oc_wasm_compile_progress progress = { 0 };
+    oc_wasm_status status = oc_wasm_compile_step(app->env.wasm, s_compile_budget_ms / 1000, &progress);
+    OC_WASM_TRAP(status);
+
+    app->env.compileTime += oc_clock_time(OC_CLOCK_MONOTONIC) - start;
+    OC_TRACE_END();
+
+    if(progress.done)
+    {
+        app->env.compilePending = false;
+        oc_log_info("deferred compilation: %u functions compiled, %.1fms spent in compilation slices\n",
+                    progress.functionCount,
+                    app->env.compileTime * 1000);
+    }
+}
+
+//NOTE: engine options come from the engine.txt file next to the module, which `orca bundle --wasm-engine` writes
+//      with one option per line, and can be overridden with --wasm-<option> flags, e.g. --wasm-vm=register
+oc_wasm_engine_options oc_runtime_engine_options_load(oc_str8 modulePath)
+{
+    oc_wasm_engine_options options = { 0 };
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_str8 path = oc_path_append(scratch.arena, oc_path_slice_directory(modulePath), OC_STR8("engine.txt"));
+    oc_file file = oc_file_open(path, OC_FILE_ACCESS_READ, OC_FILE_OPEN_NONE);
+    u64 size = 0;
+    char* contents = 0;
+    oc_io_error error = oc_file_last_error(file);
+    if(error == OC_IO_OK)
+    {
+        size = oc_file_size(file);
+        contents = oc_arena_push(scratch.arena, size);
+        size = oc_file_read(file, size, contents);
+        error = oc_file_last_error(file);
+    }
+    oc_file_close(file);
+
+    if(error == OC_IO_OK)
+    {
+        oc_str8_list separators = { 0 };
+        oc_str8_list_push(scratch.arena, &separators, OC_STR8("\n"));
+        oc_str8_list_push(scratch.arena, &separators, OC_STR8("\r"));
+        oc_str8_list lines = oc_str8_split(scratch.arena, oc_str8_from_buffer(size, contents), separators);
+
+        oc_str8_list_for(lines, it)
+        {
+            if(it->string.len && !oc_wasm_engine_option_parse(&options, it->string))
+            {
+                oc_log_warning("ignoring unknown wasm engine option %.*s in %.*s\n", oc_str8_ip(it->string), oc_str8_ip(path));
+            }
+        }
+    }
+    else if(error != OC_IO_ERR_NO_ENTRY)
+    {
+        //NOTE: the file is only written for apps bundled with engine options, so a missing file isn't an error
+        oc_log_error("couldn't read wasm engine options file %.*s, using the default options\n", oc_str8_ip(path));
+    }
+
+    for(u32 i = 0; i < s_wasm_engine_arg_count; i++)
+    {
+        if(!oc_wasm_engine_option_parse(&options, OC_STR8(s_wasm_engine_args[i])))
+        {
+            oc_log_warning("ignoring unknown wasm engine option --wasm-%s\n", s_wasm_engine_args[i]);
+        }
+    }
+
+    oc_scratch_end(scratch);
+    return (options);
+}
+
+//NOTE: while replaying input, the guest's monotonic clocks follow the replay's fixed time step
+f64 oc_bridge_clock_time(oc_clock_kind clock)
+{
+    if(s_input.mode == OC_RUNTIME_INPUT_REPLAY && clock != OC_CLOCK_DATE)
+    {
+        return (oc_runtime_input_replay_time(&s_input));
+    }
+    return (oc_clock_time(clock));
+}
+
+#include "wasmbind/audio_api_bind_gen.c"
+#include "wasmbind/clock_api_bind_gen.c"
+#include "wasmbind/core_api_bind_gen.c"
+#include "wasmbind/gles_api_bind_manual.c"
+#include "wasmbind/gles_api_bind_gen.c"
+#include "wasmbind/io_api_bind_gen.c"
+#include "wasmbind/net_api_bind_gen.c"
+#include "wasmbind/surface_api_bind_manual.c"
+#include "wasmbind/surface_api_bind_gen.c"
+
+void oc_runtime_load_module(oc_runtime* app, oc_str8 modulePath)
+{
+    //NOTE: the module is mapped rather than copied, so that only the pages the backend actually reads are loaded.
+    //      The mapping is kept for the lifetime of the instance since backends can keep pointers into the bytecode.
+    app->env.wasmBytecode = oc_file_map_read_only(modulePath);
+    if(!app->env.wasmBytecode.ptr)
+    {
+        OC_ABORT("The application couldn't load: web assembly module '%.*s' not found", oc_str8_ip(modulePath));
+    }
+
+    //NOTE: guest threads (shared memory and atomics) are not supported by the wasm backends yet,
+    //      so reject these modules up front rather than running them with unshared memory.
+    if(oc_wasm_module_uses_shared_memory(app->env.wasmBytecode))
+    {
+        OC_ABORT("The application couldn't load: its web assembly module uses shared memory (wasm threads), which is not supported by this runtime");
+    }
+    oc_runtime_startup_phase_end(&app->startup, OC_RUNTIME_STARTUP_MODULE_READ);
+
+    app->env.wasm = oc_wasm_create();
+
+    //NOTE: host memory will be freed when runtime is freed.
+
+    //NOTE: a module that can't be loaded is fatal, since the app can't run at all
+    oc_wasm_status status = oc_wasm_decode(app->env.wasm, app->env.wasmBytecode);
+    if(oc_wasm_status_is_fail(status))
+    {
+        oc_abort_ext_dialog(__FILE__, __FUNCTION__, __LINE__, "%.*s", oc_str8_ip(oc_wasm_status_str8(status)));
+    }
+    oc_runtime_startup_phase_end(&app->startup, OC_RUNTIME_STARTUP_DECODE);
+
+    //NOTE: bind orca APIs
+    {
+        int err = 0;
+        err |= bindgen_link_core_api(app->env.wasm);
+        err |= bindgen_link_surface_api(app->env.wasm);
+        err |= bindgen_link_clock_api(app->env.wasm);
+        err |= bindgen_link_io_api(app->env.wasm);
+        err |= bindgen_link_net_api(app->env.wasm);
+        err |= bindgen_link_audio_api(app->env.wasm);
+        err |= bindgen_link_gles_api(app->env.wasm);
+        err |= manual_link_gles_api(app->env.wasm);
+
+        if(err)
+        {
+            OC_ABORT("The application couldn't link one or more functions to its web assembly module (see console log for more information)");
+        }
+    }
+    oc_runtime_startup_phase_end(&app->startup, OC_RUNTIME_STARTUP_LINK);
+
+    {
+        oc_wasm_mem_callbacks wasm_mem_callbacks = {
+            .resizeProc = oc_runtime_wasm_memory_resize_callback,
+            .freeProc = oc_runtime_wasm_memory_free_callback,
+            .userdata = &app->env.wasmMemory,
+        };
+
+        oc_wasm_engine_options engineOptions = oc_runtime_engine_options_load(modulePath);
+        if(engineOptions.vm != OC_WASM_VM_DEFAULT || engineOptions.stackSize || engineOptions.debug)
+        {
+            oc_log_info("wasm engine options: vm %.*s, stack size %llu, debug %s\n",
+                        oc_str8_ip(oc_wasm_vm_kind_str8(engineOptions.vm)),
+                        (unsigned long long)engineOptions.stackSize,
+                        engineOptions.debug ? "on" : "off");
+        }
+        oc_wasm_set_engine_options(app->env.wasm, &engineOptions);
+        oc_wasm_set_deferred_compilation(app->env.wasm, s_compile_budget_ms > 0);
+        status = oc_wasm_instantiate(app->env.wasm, OC_STR8("module"), wasm_mem_callbacks);
+        if(oc_wasm_status_is_fail(status))
+        {
+            oc_abort_ext_dialog(__FILE__, __FUNCTION__, __LINE__, "%.*s", oc_str8_ip(oc_wasm_status_str8(status)));
+        }
+        app->env.compilePending = s_compile_budget_ms > 0;
+    }
+    oc_runtime_startup_phase_end(&app->startup, OC_RUNTIME_STARTUP_INSTANTIATE);
+
+    //NOTE: Find and type check event handlers.
+    {
+        oc_arena_scope scratch = oc_scratch_begin();
+
+        for(int i = 0; i < OC_EXPORT_COUNT; i++)
+        {
+            const oc_export_desc* desc = &OC_EXPORT_DESC[i];
+
+            oc_wasm_function_handle* handle = oc_wasm_function_find(app->env.wasm, desc->name);
+            if(handle)
+            {
+                oc_wasm_function_info info = oc_wasm_function_get_info(scratch.arena, app->env.wasm, handle);
+
+                bool checked = false;
+
+                //NOTE: check function signature
+                if(info.countReturns == desc->retTags.len && info.countParams == desc->argTags.len)
+                {
+                    checked = true;
+
+                    for(int retIndex = 0; retIndex < info.countReturns && checked; retIndex++)
+                    {
+                        char tag = valtype_to_tag(info.returns[retIndex]);
+                        if(tag != desc->retTags.ptr[retIndex])
+                        {
+                            checked = false;
+                        }
+                    }
+
+                    for(int argIndex = 0; argIndex < info.countParams && checked; argIndex++)
+                    {
+                        char tag = valtype_to_tag(info.params[argIndex]);
+                        if(tag != desc->argTags.ptr[argIndex])
+                        {
+                            checked = false;
+                        }
+                    }
+                }
+
+                //NOTE: exports are called through pre-bound stubs, so that per-frame callbacks don't pay for
+                //      checking and converting their params on each call
+                if(checked
+                   && !oc_wasm_status_is_fail(oc_wasm_call_stub_bind(app->env.wasm,
+                                                                     handle,
+                                                                     info.params,
+                                                                     info.countParams,
+                                                                     info.returns,
+                                                                     info.countReturns,
+                                                                     &app->env.exportStubs[i])))
+                {
+                    app->env.exports[i] = handle;
+                }
+                else
+                {
+                    oc_log_error("type mismatch for event handler %.*s\n", (int)desc->name.len, desc->name.ptr);
+                }
+            }
+        }
+
+        oc_scratch_end(scratch);
+    }
+
+    //NOTE: get location of the raw event slot
+    {
+        oc_wasm_global_pointer pointer = oc_wasm_global_pointer_find(app->env.wasm, OC_STR8("oc_rawEvent"));
+        if(pointer.handle == NULL)
+        {
+            oc_abort_ext_dialog(__FILE__, __FUNCTION__, __LINE__, "Failed to find raw event global - was this module linked with the Orca wasm runtime?");
+        }
+        app->env.rawEventOffset = pointer.address;
+    }
+
+    //NOTE: get location of the event batch, if the app opted in to batched events
+    if(app->env.exports[OC_EXPORT_EVENTS])
+    {
+        oc_wasm_global_pointer pointer = oc_wasm_global_pointer_find(app->env.wasm, OC_STR8("oc_eventBatch"));
+        if(pointer.handle == NULL)
+        {
+            oc_abort_ext_dialog(__FILE__, __FUNCTION__, __LINE__, "Failed to find event batch global - was this module linked with the Orca wasm runtime?");
+        }
+        app->env.eventBatchOffset = pointer.address;
+
+        //NOTE: oc_on_events() replaces the per-event handlers
+        app->env.exports[OC_EXPORT_RAW_EVENT] = 0;
+        app->env.exports[OC_EXPORT_MOUSE_DOWN] = 0;
+        app->env.exports[OC_EXPORT_MOUSE_UP] = 0;
+        app->env.exports[OC_EXPORT_MOUSE_MOVE] = 0;
+        app->env.exports[OC_EXPORT_MOUSE_WHEEL] = 0;
+        app->env.exports[OC_EXPORT_KEY_DOWN] = 0;
+        app->env.exports[OC_EXPORT_KEY_UP] = 0;
+    }
+
+    //NOTE: get location of the frame info. Modules linked with an older runtime don't have it.
+    {
+        oc_wasm_global_pointer pointer = oc_wasm_global_pointer_find(app->env.wasm, OC_STR8("oc_frameInfo"));
+        app->env.frameInfoOffset = pointer.handle ? pointer.address : 0;
+    }
+    oc_runtime_startup_phase_end(&app->startup, OC_RUNTIME_STARTUP_EXPORTS);
+}
+
+void oc_runtime_call_init_and_resize(oc_runtime* app)
+{
+    if(app->env.exports[OC_EXPORT_ON_INIT])
+    {
+        oc_wasm_status status = oc_runtime_call_export(app, OC_EXPORT_ON_INIT, NULL, 0, NULL, 0);
+        OC_WASM_TRAP(status);
+    }
+
+    if(app->env.exports[OC_EXPORT_FRAME_RESIZE])
+    {
+        oc_rect content = oc_window_get_content_rect(app->window);
+
+        oc_wasm_val params[2];
+        params[0].I32 = (i32)content.w;
+        params[1].I32 = (i32)content.h;
+
+        oc_wasm_status status = oc_runtime_call_export(app, OC_EXPORT_FRAME_RESIZE, params, oc_array_size(params), NULL, 0);
+        OC_WASM_TRAP(status);
+    }
+}
+
+//NOTE: returns false if the module can't be opened, e.g. while it's being rebuilt
+bool oc_runtime_module_modification_date(oc_str8 modulePath, oc_datestamp* date)
+{
+    oc_file file = oc_file_open(modulePath, OC_FILE_ACCESS_READ, OC_FILE_OPEN_NONE);
+    bool result = (oc_file_last_error(file) == OC_IO_OK);
+    if(result)
+    {
+        *date = oc_file_get_status(file).modificationDate;
+        result = (oc_file_last_error(file) == OC_IO_OK);
+    }
+    oc_file_close(file);
+    return (result);
+}
+
+//NOTE: writes the hotness profile recorded with --hotness-profile
+static void oc_runtime_app_hotness_stop(oc_runtime* app)
+{
+    if(app->profiler.hotnessEnabled)
+    {
+        oc_arena_scope scratch = oc_scratch_begin();
+        oc_str8 path = oc_runtime_app_report_path(scratch.arena, app, OC_STR8(s_hotness_profile_path));
+        oc_runtime_hotness_stop(&app->profiler, app->env.wasm, path);
+        oc_scratch_end(scratch);
+    }
+}
+
+//NOTE: hot reload throws away the guest instance and its linear memory, and instantiates the new module in place.
+//      Host resources (window, surfaces, renderer, file table, fonts, debug overlay) are kept as is, and the
+//      new instance goes through oc_on_init() again. Resources the old instance created are not reclaimed.
+void oc_runtime_reload_module(oc_runtime* app, oc_str8 modulePath)
+{
+    f64 startTime = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+    //NOTE: the profiler and call stats reference import names owned by the old instance
+    if(app->profiler.enabled)
+    {
+        oc_arena_scope scratch = oc_scratch_begin();
+        oc_str8 profilePath = oc_path_executable_relative(scratch.arena, OC_STR8("profile.json"));
+        oc_runtime_profiler_stop(&app->profiler, app->env.wasm, profilePath);
+        oc_scratch_end(scratch);
+    }
+    //NOTE: the hotness profile is written before the reload and restarts with the new module, since the old
+    //      module's hot functions may not be the new one's
+    bool hotnessEnabled = app->profiler.hotnessEnabled;
+    oc_runtime_app_hotness_stop(app);
+    bool statsEnabled = app->profiler.statsEnabled;
+    oc_runtime_call_stats_enable(&app->profiler, app->env.wasm, false);
+
+    //NOTE: queued io requests may point into the old linear memory, so drop them before freeing it
+    oc_io_queue_destroy(app->ioQueue);
+    app->ioQueue = oc_io_queue_create(&app->fileTable);
+
+    //NOTE: running fetches write to the old linear memory too. The new module starts its own fetches.
+    oc_runtime_net_destroy(app->net);
+    app->net = 0;
+
+    //NOTE: queued GL jobs may read upload regions in the old linear memory
+    oc_gles_thread_sync(&app->glesThread);
+
+    oc_wasm_destroy(app->env.wasm);
+    if(app->env.wasmMemory.ptr)
+    {
+        oc_runtime_wasm_memory_free_callback(0, &app->env.wasmMemory);
+    }
+    oc_file_unmap(app->env.wasmBytecode);
+
+    oc_wasm_env_init(&app->env);
+    oc_runtime_load_module(app, modulePath);
+
+    oc_runtime_call_stats_enable(&app->profiler, app->env.wasm, statsEnabled);
+    if(hotnessEnabled)
+    {
+        oc_runtime_hotness_start(&app->profiler, app->env.wasm);
+    }
+
+    oc_runtime_call_init_and_resize(app);
+
+    oc_log_info("reloaded web assembly module in %.1fms\n", (oc_clock_time(OC_CLOCK_MONOTONIC) - startTime) * 1000);
+}
+
+//NOTE: opens the app's data directory, which the guest sees as its root directory, and maps its data archive if it
+//      was bundled with one
+void oc_runtime_app_open_data(oc_runtime* app)
+{
+    app->ioQueue = oc_io_queue_create(&app->fileTable);
+
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_str8 localRootPath = oc_path_append(scratch.arena, app->appDir, OC_STR8("data"));
+
+    oc_io_req req = { .op = OC_IO_OPEN_AT,
+                      .open.rights = OC_FILE_ACCESS_READ | OC_FILE_ACCESS_WRITE,
+                      .size = localRootPath.len,
+                      .buffer = localRootPath.ptr };
+    oc_io_cmp cmp = oc_io_wait_single_req_for_table(&req, &app->fileTable);
+    app->rootDir = cmp.handle;
+
+    //NOTE: map the data archive if the app was bundled with one. It stays mapped for the lifetime of the instance,
+    //      since files opened from it point into the mapping.
+    oc_str8 archivePath = oc_path_append(scratch.arena, app->appDir, OC_STR8("data.oca"));
+    app->dataArchive = oc_file_map_read_only(archivePath);
+    if(app->dataArchive.len && !oc_archive_validate(app->dataArchive))
+    {
+        oc_log_error("data archive %.*s is malformed, ignoring it\n", oc_str8_ip(archivePath));
+        oc_file_unmap(app->dataArchive);
+        app->dataArchive = (oc_str8){ 0 };
+    }
+
+    oc_scratch_end(scratch);
+}
+
+//NOTE: reloads the module if it changed on disk, in watch mode
+void oc_runtime_app_watch(oc_runtime* app)
+{
+    f64 now = oc_clock_time(OC_CLOCK_MONOTONIC);
+    if(now - app->lastWatchTime > 0.25)
+    {
+        app->lastWatchTime = now;
+        oc_datestamp date = { 0 };
+        if(!oc_runtime_module_modification_date(app->modulePath, &date))
+        {
+            //NOTE: treat an unreadable module as unchanged, and check again once it can be opened
+            return;
+        }
+
+        if(date.seconds != app->pendingModuleDate.seconds || date.fraction != app->pendingModuleDate.fraction)
+        {
+            app->pendingModuleDate = date;
+            app->pendingModuleTime = now;
+        }
+        else if((date.seconds != app->moduleDate.seconds || date.fraction != app->moduleDate.fraction)
+                && now - app->pendingModuleTime > 0.25)
+        {
+            app->moduleDate = date;
+            oc_runtime_reload_module(app, app->modulePath);
+        }
+    }
+}
+
+//NOTE: an app receives the events of its window, and events that aren't tied to a window, like quit requests
+bool oc_runtime_app_owns_event(oc_runtime* app, oc_event* event)
+{
+    return (event->window.h == 0 || event->window.h == app->window.h);
 }
 
-void oc_wasm_env_init(oc_wasm_env* runtime)
-{
-    memset(runtime, 0, sizeof(oc_wasm_env));
-    oc_base_allocator* allocator = oc_base_allocator_default();
-    runtime->wasmMemory.committed = 0;
-    runtime->wasmMemory.reserved = 4ULL << 30;
-    runtime->wasmMemory.ptr = oc_base_reserve(allocator, runtime->wasmMemory.reserved);
-}
+typedef struct oc_runtime_event_elt
+{
+    oc_list_elt listElt;
+    oc_event* event;
+} oc_runtime_event_elt;
+
+//NOTE: dispatches the app's events from the frame's event list to the guest, runs its frame and draws its debug overlay
+void oc_runtime_app_frame(oc_runtime* app, oc_list* frameEvents)
+{
+    oc_wasm_function_handle** exports = app->env.exports;
+
+    oc_arena_scope scratch = oc_scratch_begin();
+    u32 batchCount = 0;
+
+    oc_ui_set_context(&app->debugOverlay.ui);
+
+    //NOTE: apps share the GL thread state, so restore the context this app was drawing to
+    if(s_appCount > 1 && !oc_surface_is_nil(app->glesSurface))
+    {
+        oc_gles_surface_make_current(app->glesSurface);
+    }
+
+    OC_TRACE_BEGIN("event dispatch");
+
+    oc_list_for(*frameEvents, elt, oc_runtime_event_elt, listElt)
+    {
+        oc_event* event = elt->event;
+        if(!oc_runtime_app_owns_event(app, event))
+        {
+            continue;
+        }
+
+        if(app->debugOverlay.show)
+        {
+            oc_ui_process_event(event);
+        }
+        oc_runtime_frame_info_process_event(app, event);
+
+        if(exports[OC_EXPORT_EVENTS])
+        {
+            oc_event* clipboardEvent = oc_runtime_clipboard_process_event_begin(scratch.arena, &app->clipboard, event);
+            if(clipboardEvent != 0)
+            {
+                oc_runtime_event_batch_push(app, &batchCount, clipboardEvent);
+            }
+            oc_runtime_event_batch_push(app, &batchCount, event);
+        }
+        else if(exports[OC_EXPORT_RAW_EVENT])
+        {
+            oc_event* clipboardEvent = oc_runtime_clipboard_process_event_begin(scratch.arena, &app->clipboard, event);
+            oc_event* events[2];
+            u64 eventsCount;
+            if(clipboardEvent != 0)
+            {
+                events[0] = clipboardEvent;
+                events[1] = event;
+                eventsCount = 2;
+            }
+            else
+            {
+                events[0] = event;
+                eventsCount = 1;
+            }
+
+            for(int i = 0; i < eventsCount; i++)
+            {
+                if(oc_is_little_endian())
+                {
+                    oc_event* eventPtr = (oc_event*)oc_wasm_address_to_ptr(app->env.rawEventOffset, sizeof(oc_event));
+                    memcpy(eventPtr, events[i], sizeof(*events[i]));
+
+                    oc_wasm_val eventOffset = { .I32 = (i32)app->env.rawEventOffset };
+                    oc_wasm_status status = oc_runtime_call_export(app, OC_EXPORT_RAW_EVENT, &eventOffset, 1, NULL, 0);
+                    OC_WASM_TRAP(status);
+                }
+                else
+                {
+                    oc_log_error("oc_on_raw_event() is not supported on big endian platforms");
+                }
+            }
+
+            oc_runtime_clipboard_process_event_end(&app->clipboard);
+        }
+
+        switch(event->type)
+        {
+            case OC_EVENT_WINDOW_CLOSE:
+            case OC_EVENT_QUIT:
+            {
+                app->quit = true;
+            }
+            break;
+
+            case OC_EVENT_WINDOW_RESIZE:
+            {
+                oc_rect frame = { 0, 0, event->move.frame.w, event->move.frame.h };
+
+                if(exports[OC_EXPORT_FRAME_RESIZE] && !exports[OC_EXPORT_EVENTS])
+                {
+                    oc_wasm_val params[2];
+                    params[0].I32 = (i32)event->move.content.w;
+                    params[1].I32 = (i32)event->move.content.h;
+
+                    oc_wasm_status status = oc_runtime_call_export(app, OC_EXPORT_FRAME_RESIZE, params, oc_array_size(params), NULL, 0);
+                    OC_WASM_TRAP(status);
+                }
+            }
+            break;
+
+            case OC_EVENT_MOUSE_BUTTON:
+            {
+                if(event->key.action == OC_KEY_PRESS)
+                {
+                    if(exports[OC_EXPORT_MOUSE_DOWN])
+                    {
+                        oc_wasm_val button = { .I32 = event->key.button };
+
+                        oc_wasm_status status = oc_runtime_call_export(app, OC_EXPORT_MOUSE_DOWN, &button, 1, NULL, 0);
+                        OC_WASM_TRAP(status);
+                    }
+                }
+                else
+                {
+                    if(exports[OC_EXPORT_MOUSE_UP])
+                    {
+                        oc_wasm_val button = { .I32 = event->key.button };
+
+                        oc_wasm_status status = oc_runtime_call_export(app, OC_EXPORT_MOUSE_UP, &button, 1, NULL, 0);
+                        OC_WASM_TRAP(status);
+                    }
+                }
+            }
+            break;
 
-#include "wasmbind/clock_api_bind_gen.c"
-#include "wasmbind/core_api_bind_gen.c"
-#include "wasmbind/gles_api_bind_manual.c"
-#include "wasmbind/gles_api_bind_gen.c"
-#include "wasmbind/io_api_bind_gen.c"
-#include "wasmbind/surface_api_bind_manual.c"
-#include "wasmbind/surface_api_bind_gen.c"
+            case OC_EVENT_MOUSE_WHEEL:
+            {
+                if(exports[OC_EXPORT_MOUSE_WHEEL])
+                {
+                    oc_wasm_val params[2];
+                    params[0].F32 = event->mouse.deltaX;
+                    params[1].F32 = event->mouse.deltaY;
 
-i32 orca_runloop(void* user)
-{
-    oc_runtime* app = &__orcaApp;
+                    oc_wasm_status status = oc_runtime_call_export(app, OC_EXPORT_MOUSE_WHEEL, params, oc_array_size(params), NULL, 0);
+                    OC_WASM_TRAP(status);
+                }
+            }
+            break;
 
-    oc_wasm_env_init(&app->env);
+            case OC_EVENT_MOUSE_MOVE:
+            {
+                if(exports[OC_EXPORT_MOUSE_MOVE])
+                {
+                    oc_wasm_val params[4];
+                    params[0].F32 = event->mouse.x;
+                    params[1].F32 = event->mouse.y;
+                    params[2].F32 = event->mouse.deltaX;
+                    params[3].F32 = event->mouse.deltaY;
+
+                    oc_wasm_status status = oc_runtime_call_export(app, OC_EXPORT_MOUSE_MOVE, params, oc_array_size(params), NULL, 0);
+                    OC_WASM_TRAP(status);
+                }
+            }
+            break;
 
-    //NOTE: loads wasm module
-    {
-        oc_arena_scope scratch = oc_scratch_begin();
+            case OC_EVENT_KEYBOARD_KEY:
+            {
+                if(event->key.action == OC_KEY_PRESS)
+                {
+                    if(event->key.keyCode == OC_KEY_D
+                       && (event->key.mods & OC_KEYMOD_SHIFT)
+                       && (event->key.mods & OC_KEYMOD_MAIN_MODIFIER))
+                    {
+                        debug_overlay_toggle(&app->debugOverlay);
+                    }
+                    else if(event->key.keyCode == OC_KEY_F
+                            && (event->key.mods & OC_KEYMOD_SHIFT)
+                            && (event->key.mods & OC_KEYMOD_MAIN_MODIFIER))
+                    {
+                        //NOTE: capture the next frame, to replay it with the perf driver (see tests/perf)
+                        oc_arena_scope scratch = oc_scratch_begin();
+                        oc_render_thread_sync(&app->renderThread);
+                        oc_wgpu_canvas_debug_capture_next_frame(app->canvasRenderer,
+                                                                oc_path_executable_relative(scratch.arena, OC_STR8("frame.occapture")));
+                        oc_scratch_end(scratch);
+                    }
 
-        oc_str8 modulePath = oc_path_executable_relative(scratch.arena, OC_STR8("../app/wasm/module.wasm"));
-        if(s_test_wasm_module_path)
-        {
-            modulePath = oc_str8_push_copy(scratch.arena, OC_STR8(s_test_wasm_module_path));
-        }
+                    if(exports[OC_EXPORT_KEY_DOWN])
+                    {
+                        oc_wasm_val params[2];
+                        params[0].I32 = event->key.scanCode;
+                        params[1].I32 = event->key.keyCode;
 
-        FILE* file = fopen(modulePath.ptr, "rb");
-        if(!file)
-        {
-            OC_ABORT("The application couldn't load: web assembly module '%s' not found", modulePath.ptr);
-        }
-        oc_scratch_end(scratch);
+                        oc_wasm_status status = oc_runtime_call_export(app, OC_EXPORT_KEY_DOWN, params, oc_array_size(params), NULL, 0);
+                        OC_WASM_TRAP(status);
+                    }
+                }
+                else if(event->key.action == OC_KEY_RELEASE)
+                {
+                    if(exports[OC_EXPORT_KEY_UP])
+                    {
+                        oc_wasm_val params[2];
+                        params[0].I32 = event->key.scanCode;
+                        params[1].I32 = event->key.keyCode;
 
-        fseek(file, 0, SEEK_END);
-        u64 wasmSize = ftell(file);
-        rewind(file);
+                        oc_wasm_status status = oc_runtime_call_export(app, OC_EXPORT_KEY_UP, params, oc_array_size(params), NULL, 0);
+                        OC_WASM_TRAP(status);
+                    }
+                }
+            }
+            break;
 
-        app->env.wasmBytecode.len = wasmSize;
-        app->env.wasmBytecode.ptr = oc_malloc_array(char, wasmSize);
-        fread(app->env.wasmBytecode.ptr, 1, app->env.wasmBytecode.len, file);
-        fclose(file);
+            default:
+                break;
+        }
     }
 
-    app->env.wasm = oc_wasm_create();
-
-    //NOTE: host memory will be freed when runtime is freed.
+    if(exports[OC_EXPORT_EVENTS])
+    {
+        oc_runtime_event_batch_flush(app, &batchCount);
+    }
 
-    OC_WASM_TRAP(oc_wasm_decode(app->env.wasm, app->env.wasmBytecode));
+    OC_TRACE_END();
 
-    //NOTE: bind orca APIs
+    if(exports[OC_EXPORT_FRAME_REFRESH])
     {
-        int err = 0;
-        err |= bindgen_link_core_api(app->env.wasm);
-        err |= bindgen_link_surface_api(app->env.wasm);
-        err |= bindgen_link_clock_api(app->env.wasm);
-        err |= bindgen_link_io_api(app->env.wasm);
-        err |= bindgen_link_gles_api(app->env.wasm);
-        err |= manual_link_gles_api(app->env.wasm);
+        oc_runtime_frame_info_write(app);
 
-        if(err)
-        {
-            OC_ABORT("The application couldn't link one or more functions to its web assembly module (see console log for more information)");
-        }
+        oc_wasm_status status = oc_runtime_call_export(app, OC_EXPORT_FRAME_REFRESH, NULL, 0, NULL, 0);
+        OC_WASM_TRAP(status);
     }
 
+    if(exports[OC_EXPORT_STDIO_FLUSH])
     {
-        oc_wasm_mem_callbacks wasm_mem_callbacks = {
-            .resizeProc = oc_runtime_wasm_memory_resize_callback,
-            .freeProc = oc_runtime_wasm_memory_free_callback,
-            .userdata = &app->env.wasmMemory,
-        };
+        oc_wasm_status status = oc_runtime_call_export(app, OC_EXPORT_STDIO_FLUSH, NULL, 0, NULL, 0);
+        OC_WASM_TRAP(status);
+    }
 
-        OC_WASM_TRAP(oc_wasm_instantiate(app->env.wasm, OC_STR8("module"), wasm_mem_callbacks));
+    if(app->env.compilePending)
+    {
+        oc_runtime_compile_step(app);
     }
 
-    //NOTE: Find and type check event handlers.
+    //NOTE: the overlay context is rendered by the render thread without a copy, so we wait for the previous frame's
+    //      overlay before drawing into it again. This doesn't wait for the frame the guest just submitted.
+    oc_render_thread_wait(&app->renderThread, app->overlayRenderSerial);
+
+    oc_canvas_context_select(app->debugOverlay.context);
+
+    if(app->debugOverlay.show)
     {
-        oc_arena_scope scratch = oc_scratch_begin();
+        if(app->debugOverlay.hidden)
+        {
+            oc_surface_set_hidden(app->debugOverlay.surface, false);
+            app->debugOverlay.hidden = false;
+        }
 
-        for(int i = 0; i < OC_EXPORT_COUNT; i++)
+        //TODO: only move if it's not already on the front?
+        oc_surface_bring_to_front(app->debugOverlay.surface);
+
+        oc_ui_style debugUIDefaultStyle = { .bgColor = { 0 },
+                                            .color = { 1, 1, 1, 1 },
+                                            .font = app->debugOverlay.fontReg,
+                                            .fontSize = 16,
+                                            .borderColor = { 1, 0, 0, 1 },
+                                            .borderSize = 2 };
+
+        oc_ui_style_mask debugUIDefaultMask = OC_UI_STYLE_BG_COLOR
+                                            | OC_UI_STYLE_COLOR
+                                            | OC_UI_STYLE_BORDER_COLOR
+                                            | OC_UI_STYLE_BORDER_SIZE
+                                            | OC_UI_STYLE_FONT
+                                            | OC_UI_STYLE_FONT_SIZE;
+
+        oc_vec2 frameSize = oc_surface_get_size(app->debugOverlay.surface);
+
+        oc_ui_frame(frameSize, &debugUIDefaultStyle, debugUIDefaultMask)
         {
-            const oc_export_desc* desc = &OC_EXPORT_DESC[i];
+            oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                             .size.height = { OC_UI_SIZE_PARENT, 1, 1 } },
+                             OC_UI_STYLE_SIZE);
 
-            oc_wasm_function_handle* handle = oc_wasm_function_find(app->env.wasm, desc->name);
-            if(handle)
+            oc_ui_container("overlay area", 0)
             {
-                oc_wasm_function_info info = oc_wasm_function_get_info(scratch.arena, app->env.wasm, handle);
+                if(app->profiler.statsEnabled)
+                {
+                    call_stats_ui(app);
+                }
+                if(app->debugOverlay.showHeapSites && app->env.mallocTrackingOffset)
+                {
+                    heap_sites_ui(app);
+                }
+                if(app->debugOverlay.showMemoryStats)
+                {
+                    memory_stats_ui(app);
+                }
+            }
 
-                bool checked = false;
+            oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                             .size.height = { OC_UI_SIZE_PARENT, 0.4 },
+                                             .layout.axis = OC_UI_AXIS_Y,
+                                             .bgColor = { 0, 0, 0, 0.5 } },
+                             OC_UI_STYLE_SIZE
+                                 | OC_UI_STYLE_LAYOUT_AXIS
+                                 | OC_UI_STYLE_BG_COLOR);
 
-                //NOTE: check function signature
-                if(info.countReturns == desc->retTags.len && info.countParams == desc->argTags.len)
+            oc_ui_container("log console", OC_UI_FLAG_DRAW_BACKGROUND)
+            {
+                oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                                 .size.height = { OC_UI_SIZE_CHILDREN },
+                                                 .layout.axis = OC_UI_AXIS_X,
+                                                 .layout.spacing = 10,
+                                                 .layout.margin.x = 10,
+                                                 .layout.margin.y = 10 },
+                                 OC_UI_STYLE_SIZE
+                                     | OC_UI_STYLE_LAYOUT);
+
+                oc_wgpu_canvas_debug_display_options displayOptions = oc_wgpu_canvas_debug_get_display_options(app->canvasRenderer);
+
+                oc_ui_container("log toolbar", 0)
                 {
-                    checked = true;
+                    oc_ui_style buttonStyle = { .layout.margin.x = 4,
+                                                .layout.margin.y = 4,
+                                                .roundness = 2,
+                                                .bgColor = { 0, 0, 0, 0.5 },
+                                                .color = { 1, 1, 1, 1 } };
+
+                    oc_ui_style_mask buttonStyleMask = OC_UI_STYLE_LAYOUT_MARGINS
+                                                     | OC_UI_STYLE_ROUNDNESS
+                                                     | OC_UI_STYLE_BG_COLOR
+                                                     | OC_UI_STYLE_COLOR;
+
+                    oc_ui_style_match_after(oc_ui_pattern_all(), &buttonStyle, buttonStyleMask);
+                    if(oc_ui_button("Clear").clicked)
+                    {
+                        oc_list_init(&app->debugOverlay.logEntries);
+                        app->debugOverlay.entryCount = 0;
+                        app->debugOverlay.logBufferTail = 0;
+                    }
 
-                    for(int retIndex = 0; retIndex < info.countReturns && checked; retIndex++)
+                    if(oc_ui_button(app->profiler.enabled ? "Stop profiling" : "Start profiling").clicked)
                     {
-                        char tag = valtype_to_tag(info.returns[retIndex]);
-                        if(tag != desc->retTags.ptr[retIndex])
+                        if(app->profiler.enabled)
                         {
-                            checked = false;
+                            oc_str8 profilePath = oc_path_executable_relative(scratch.arena, OC_STR8("profile.json"));
+                            oc_runtime_profiler_stop(&app->profiler, app->env.wasm, profilePath);
+                        }
+                        else
+                        {
+                            oc_runtime_profiler_start(&app->profiler, app->env.wasm);
                         }
                     }
 
-                    for(int argIndex = 0; argIndex < info.countParams && checked; argIndex++)
+                    if(oc_ui_button(app->profiler.statsEnabled ? "Hide call stats" : "Show call stats").clicked)
                     {
-                        char tag = valtype_to_tag(info.params[argIndex]);
-                        if(tag != desc->argTags.ptr[argIndex])
+                        oc_runtime_call_stats_enable(&app->profiler, app->env.wasm, !app->profiler.statsEnabled);
+                    }
+
+                    if(oc_ui_button(oc_trace_is_enabled() ? "Stop tracing" : "Start tracing").clicked)
+                    {
+                        if(oc_trace_is_enabled())
                         {
-                            checked = false;
+                            oc_trace_stop();
+                            oc_trace_write(oc_path_executable_relative(scratch.arena, OC_STR8("trace.json")));
+                        }
+                        else
+                        {
+                            oc_trace_start();
+                        }
+                    }
+
+                    //NOTE: cycle through the heatmaps of the canvas renderer. The overlay itself is drawn without it.
+                    if(oc_ui_button_str8(oc_str8_pushf(scratch.arena,
+                                                       "Heatmap: %s",
+                                                       oc_wgpu_canvas_heatmap_name(displayOptions.heatmap)))
+                           .clicked)
+                    {
+                        displayOptions.heatmap = (displayOptions.heatmap + 1) % OC_WGPU_CANVAS_HEATMAP_COUNT;
+                        displayOptions.heatmapExclude = app->debugOverlay.surface;
+
+                        oc_render_thread_sync(&app->renderThread);
+                        oc_wgpu_canvas_debug_set_display_options(app->canvasRenderer, &displayOptions);
+                    }
+
+                    if(oc_ui_button(app->debugOverlay.showMemoryStats ? "Hide renderer memory" : "Show renderer memory").clicked)
+                    {
+                        app->debugOverlay.showMemoryStats = !app->debugOverlay.showMemoryStats;
+                    }
+
+                    oc_runtime_watchdog* watchdog = &app->watchdog;
+                    if(watchdog->overrunCount)
+                    {
+                        oc_runtime_overrun* last = &watchdog->history[(watchdog->historyIndex + OC_RUNTIME_OVERRUN_HISTORY - 1) % OC_RUNTIME_OVERRUN_HISTORY];
+                        oc_ui_label_str8(oc_str8_pushf(scratch.arena,
+                                                       "budget overruns: %llu, last: %.*s() %.2fms, %.1fs ago",
+                                                       (unsigned long long)watchdog->overrunCount,
+                                                       oc_str8_ip(OC_EXPORT_DESC[last->exportKind].name),
+                                                       last->duration * 1000,
+                                                       oc_clock_time(OC_CLOCK_MONOTONIC) - last->time));
+                    }
+
+                    oc_wasm_memory_stats memStats = oc_runtime_wasm_memory_stats();
+                    oc_ui_label_str8(oc_str8_pushf(scratch.arena,
+                                                   "wasm memory: %.1f MB resident, %.1f MB committed",
+                                                   memStats.resident / (f64)(1 << 20),
+                                                   memStats.committed / (f64)(1 << 20)));
+
+                    if(app->glesThread.enabled)
+                    {
+                        oc_gles_thread_stats* glesStats = &app->glesThread.stats;
+                        oc_ui_label_str8(oc_str8_pushf(scratch.arena,
+                                                       "gles thread: %llu submits (%.1f MB), %llu stalls (%.1fms)",
+                                                       (unsigned long long)glesStats->submitCount,
+                                                       glesStats->submitWords * sizeof(u32) / (f64)(1 << 20),
+                                                       (unsigned long long)glesStats->stallCount,
+                                                       glesStats->stallTime * 1000));
+                    }
+
+                    //NOTE: only shown when the guest's orca-libc was built with malloc tracking
+                    if(app->env.mallocTrackingOffset)
+                    {
+                        if(oc_ui_button(app->debugOverlay.showHeapSites ? "Hide heap sites" : "Show heap sites").clicked)
+                        {
+                            app->debugOverlay.showHeapSites = !app->debugOverlay.showHeapSites;
+                        }
+                        if(oc_ui_button("Dump heap").clicked)
+                        {
+                            oc_runtime_heap_profile_dump(oc_path_executable_relative(scratch.arena, OC_STR8("heap_profile.csv")));
                         }
+
+                        oc_runtime_heap_profile heapProfile = oc_runtime_heap_profile_get(scratch.arena);
+                        oc_ui_label_str8(oc_str8_pushf(scratch.arena,
+                                                       "guest heap: %.1f MB live, %.1f MB peak",
+                                                       heapProfile.liveBytes / (f64)(1 << 20),
+                                                       heapProfile.peakBytes / (f64)(1 << 20)));
                     }
                 }
 
-                if(checked)
+                if(displayOptions.heatmap != OC_WGPU_CANVAS_HEATMAP_NONE)
                 {
-                    app->env.exports[i] = handle;
+                    heatmap_legend_ui(&displayOptions);
                 }
-                else
+
+                oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                                 .size.height = { OC_UI_SIZE_PARENT, 1, 1 } },
+                                 OC_UI_STYLE_SIZE);
+
+                //TODO: this is annoying to have to do that. Basically there's another 'contents' box inside oc_ui_panel,
+                //      and we need to change that to size according to its parent (whereas the default is sizing according
+                //      to its children)
+                oc_ui_pattern pattern = { 0 };
+                oc_ui_pattern_push(scratch.arena, &pattern, (oc_ui_selector){ .kind = OC_UI_SEL_OWNER });
+                oc_ui_pattern_push(scratch.arena, &pattern, (oc_ui_selector){ .kind = OC_UI_SEL_TEXT, .text = OC_STR8("contents") });
+                oc_ui_style_match_after(pattern, &(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 } }, OC_UI_STYLE_SIZE_WIDTH);
+
+                oc_ui_box* panel = oc_ui_box_lookup("log view");
+                f32 scrollY = 0;
+                if(panel)
                 {
-                    oc_log_error("type mismatch for event handler %.*s\n", (int)desc->name.len, desc->name.ptr);
+                    scrollY = panel->scroll.y;
+                }
+
+                oc_debug_overlay* debug = &app->debugOverlay;
+                log_view_cursor cursor = { .overlay = debug };
+
+                oc_ui_list_info logList = {
+                    .rowCount = debug->entryCount,
+                    .estimatedRowHeight = debug->logRowHeight,
+                    .rowProc = log_view_row,
+                    .user = &cursor,
+                };
+                logList = oc_ui_list("log view", &logList);
+
+                debug->logRowHeight = logList.estimatedRowHeight;
+                panel = logList.panel;
+
+                if(app->debugOverlay.logScrollToLast)
+                {
+                    if(panel->scroll.y >= scrollY)
+                    {
+                        panel->scroll.y = oc_clamp_low(panel->childrenSum[1] - panel->rect.h, 0);
+                    }
+                    else
+                    {
+                        app->debugOverlay.logScrollToLast = false;
+                    }
+                }
+                else if(panel->scroll.y >= (panel->childrenSum[1] - panel->rect.h) - 1)
+                {
+                    app->debugOverlay.logScrollToLast = true;
                 }
             }
         }
 
-        oc_scratch_end(scratch);
+        oc_ui_draw();
+
+        //NOTE: the overlay shows live stats and logs, so keep refreshing while it's visible
+        app->frameRequested = true;
+    }
+    else if(!app->debugOverlay.hidden)
+    {
+        //NOTE: when the overlay is hidden, clear it once so that it doesn't show a stale frame when it's shown again.
+        //      Its surface is then hidden, which releases its swap chain, and it isn't rendered until it's shown.
+        oc_surface_send_to_back(app->debugOverlay.surface);
+        oc_set_color_rgba(0, 0, 0, 0);
+        oc_clear();
     }
 
-    //NOTE: get location of the raw event slot
+    if(!app->debugOverlay.hidden)
     {
-        oc_wasm_global_pointer pointer = oc_wasm_global_pointer_find(app->env.wasm, OC_STR8("oc_rawEvent"));
-        if(pointer.handle == NULL)
+        if(app->renderThread.enabled)
         {
-            oc_abort_ext_dialog(__FILE__, __FUNCTION__, __LINE__, "Failed to find raw event global - was this module linked with the Orca wasm runtime?");
+            app->overlayRenderSerial = oc_render_thread_render_context(&app->renderThread,
+                                                                       app->canvasRenderer,
+                                                                       app->debugOverlay.context,
+                                                                       app->debugOverlay.surface);
+            oc_render_thread_present(&app->renderThread, app->canvasRenderer, app->debugOverlay.surface);
+        }
+        else
+        {
+            oc_canvas_render(app->canvasRenderer, app->debugOverlay.context, app->debugOverlay.surface);
+            oc_canvas_present(app->canvasRenderer, app->debugOverlay.surface);
+        }
+
+        if(!app->debugOverlay.show)
+        {
+            //NOTE: the render thread must be done with the surface before its swap chain is released
+            oc_render_thread_sync(&app->renderThread);
+            oc_surface_set_hidden(app->debugOverlay.surface, true);
+            app->debugOverlay.hidden = true;
         }
-        app->env.rawEventOffset = pointer.address;
     }
 
-    //NOTE: preopen the app local root dir
+    oc_runtime_call_stats_frame_end(&app->profiler);
+
+    oc_scratch_end(scratch);
+}
+
+//NOTE: surfaces and windows are created and destroyed on the main thread
+i32 oc_runtime_app_window_destroy_callback(void* user)
+{
+    oc_runtime* app = (oc_runtime*)user;
+
+    for(u32 i = 0; i < app->guestSurfaceCount; i++)
     {
-        oc_arena_scope scratch = oc_scratch_begin();
+        oc_surface_destroy(app->guestSurfaces[i]);
+    }
+    app->guestSurfaceCount = 0;
+
+    oc_canvas_context_destroy(app->debugOverlay.context);
+    oc_surface_destroy(app->debugOverlay.surface);
+    oc_window_destroy(app->window);
+
+    return (0);
+}
+
+//NOTE: calls the app's terminate handler, unless it failed or exited, and releases the resources of its instance
+void oc_runtime_app_stop(oc_runtime* app)
+{
+    oc_wasm_function_handle** exports = app->env.exports;
+
+    if(exports[OC_EXPORT_TERMINATE])
+    {
+        oc_wasm_status status = oc_runtime_call_export(app, OC_EXPORT_TERMINATE, NULL, 0, NULL, 0);
+        OC_WASM_TRAP(status);
+    }
+    if(exports[OC_EXPORT_STDIO_FLUSH])
+    {
+        oc_wasm_status status = oc_runtime_call_export(app, OC_EXPORT_STDIO_FLUSH, NULL, 0, NULL, 0);
+        OC_WASM_TRAP(status);
+    }
 
-        oc_str8 localRootPath = oc_path_executable_relative(scratch.arena, OC_STR8("../app/data"));
+    oc_render_thread_stop(&app->renderThread);
+    oc_gles_thread_stop(&app->glesThread);
 
-        oc_io_req req = { .op = OC_IO_OPEN_AT,
-                          .open.rights = OC_FILE_ACCESS_READ | OC_FILE_ACCESS_WRITE,
-                          .size = localRootPath.len,
-                          .buffer = localRootPath.ptr };
-        oc_io_cmp cmp = oc_io_wait_single_req_for_table(&req, &app->fileTable);
-        app->rootDir = cmp.handle;
+    oc_io_queue_destroy(app->ioQueue);
+    app->ioQueue = 0;
 
+    oc_runtime_net_destroy(app->net);
+    app->net = 0;
+
+    oc_audio_output_close(app->audio);
+    app->audio = 0;
+
+    if(app->profiler.enabled)
+    {
+        oc_arena_scope scratch = oc_scratch_begin();
+        oc_str8 profilePath = oc_path_executable_relative(scratch.arena, OC_STR8("profile.json"));
+        oc_runtime_profiler_stop(&app->profiler, app->env.wasm, profilePath);
         oc_scratch_end(scratch);
     }
+    oc_runtime_app_hotness_stop(app);
 
-    oc_wasm_function_handle** exports = app->env.exports;
+    //NOTE: close the files the guest left open, including its root directory
+    oc_file_table_close_all(&app->fileTable);
+    app->rootDir = oc_file_nil();
+    oc_file_unmap(app->dataArchive);
+    app->dataArchive = (oc_str8){ 0 };
+
+    oc_wasm_destroy(app->env.wasm);
+    app->env.wasm = 0;
+    if(app->env.wasmMemory.ptr)
+    {
+        oc_runtime_wasm_memory_free_callback(0, &app->env.wasmMemory);
+    }
+    oc_file_unmap(app->env.wasmBytecode);
+    app->env.wasmBytecode = (oc_str8){ 0 };
 
+    oc_dispatch_on_main_thread_sync(app->window, oc_runtime_app_window_destroy_callback, app);
+    app->window = oc_window_null_handle();
+
+    app->stopped = true;
+}
+
+i32 orca_runloop(void* user)
+{
     if(s_test_wasm_module_path)
     {
+        oc_runtime* app = &s_apps[0];
+        oc_wasm_env_init(&app->env);
+        oc_runtime_load_module(app, app->modulePath);
+        oc_runtime_app_open_data(app);
+
+        oc_wasm_function_handle** exports = app->env.exports;
+
         oc_wasm_val returnCode = { 0 };
         if(exports[OC_EXPORT_ON_TEST])
         {
-            oc_wasm_status status = oc_wasm_function_call(app->env.wasm, exports[OC_EXPORT_ON_TEST], NULL, 0, &returnCode, 1);
+            oc_wasm_status status = oc_runtime_call_export(app, OC_EXPORT_ON_TEST, NULL, 0, &returnCode, 1);
             OC_WASM_TRAP(status);
+            if(app->failed || app->exited)
+            {
+                returnCode.I32 = app->exitCode;
+            }
 
             if(returnCode.I32 != 0)
             {
                 oc_log_error("Tests failed. Exit code: %d\n", returnCode.I32);
             }
         }
-        else
+        else
+        {
+            returnCode.I32 = 1;
+            oc_log_error("Failed to find oc_on_test() hook - unable to run tests.\n");
+        }
+        oc_request_quit();
+        return returnCode.I32;
+    }
+
+    for(u32 appIndex = 0; appIndex < s_appCount; appIndex++)
+    {
+        oc_runtime* app = &s_apps[appIndex];
+        oc_runtime_set_current(app);
+
+        //NOTE: startup phases are timed up to the app's first frame, see oc_runtime_frame_presented()
+        app->startup = s_startup;
+        oc_runtime_startup_begin(&app->startup);
+
+        oc_wasm_env_init(&app->env);
+        oc_runtime_load_module(app, app->modulePath);
+
+        if(s_hotness_profile_path)
+        {
+            oc_runtime_hotness_start(&app->profiler, app->env.wasm);
+        }
+
+        oc_runtime_app_open_data(app);
+        oc_runtime_startup_phase_end(&app->startup, OC_RUNTIME_STARTUP_APP_DATA);
+
+        //NOTE: call init and resize handlers
+        oc_runtime_call_init_and_resize(app);
+        oc_runtime_startup_phase_end(&app->startup, OC_RUNTIME_STARTUP_ON_INIT);
+
+        if(s_render_thread)
+        {
+            oc_render_thread_start(&app->renderThread);
+        }
+        if(s_gles_thread)
         {
-            returnCode.I32 = 1;
-            oc_log_error("Failed to find oc_on_test() hook - unable to run tests.\n");
+            oc_gles_thread_start(&app->glesThread);
         }
-        oc_request_quit();
-        return returnCode.I32;
+
+        oc_runtime_module_modification_date(app->modulePath, &app->moduleDate);
+        app->pendingModuleDate = app->moduleDate;
     }
 
-    //NOTE: call init handler
-    if(exports[OC_EXPORT_ON_INIT])
+    if(s_replay_input_path)
     {
-        oc_wasm_status status = oc_wasm_function_call(app->env.wasm, exports[OC_EXPORT_ON_INIT], NULL, 0, NULL, 0);
-        OC_WASM_TRAP(status);
+        if(oc_runtime_input_replay_begin(&s_input, OC_STR8(s_replay_input_path), s_replay_step_ms / 1000))
+        {
+            oc_trace_start();
+        }
     }
-
-    if(exports[OC_EXPORT_FRAME_RESIZE])
+    else if(s_record_input_path)
     {
-        oc_rect content = oc_window_get_content_rect(app->window);
-
-        oc_wasm_val params[2];
-        params[0].I32 = (i32)content.w;
-        params[1].I32 = (i32)content.h;
-
-        oc_wasm_status status = oc_wasm_function_call(app->env.wasm, exports[OC_EXPORT_FRAME_RESIZE], params, oc_array_size(params), NULL, 0);
-        OC_WASM_TRAP(status);
+        oc_runtime_input_record_begin(&s_input, OC_STR8(s_record_input_path));
     }
+    bool replaying = (s_input.mode == OC_RUNTIME_INPUT_REPLAY);
 
-    oc_ui_set_context(&app->debugOverlay.ui);
+    //NOTE: frames are paced on the window of the first app that's still running. Render and GL threads are only used
+    //      with a single app, see main()
+    oc_runtime* firstApp = &s_apps[0];
+    u32 runningCount = s_appCount;
+    f64 frameDeadline = 0;
+    i32 exitCode = 0;
 
-    while(!app->quit)
+    while(runningCount)
     {
-        oc_arena_scope scratch = oc_scratch_begin();
-        oc_event* event = 0;
+        bool idle = true;
+        oc_runtime* compileApp = 0;
 
-        while((event = oc_next_event(scratch.arena)) != 0)
+        for(u32 appIndex = 0; appIndex < s_appCount; appIndex++)
         {
-            if(app->debugOverlay.show)
+            oc_runtime* app = &s_apps[appIndex];
+            if(app->stopped)
             {
-                oc_ui_process_event(event);
+                continue;
             }
+            oc_runtime_set_current(app);
 
-            if(exports[OC_EXPORT_RAW_EVENT])
+            if(s_watch_module)
             {
-                oc_event* clipboardEvent = oc_runtime_clipboard_process_event_begin(scratch.arena, &__orcaApp.clipboard, event);
-                oc_event* events[2];
-                u64 eventsCount;
-                if(clipboardEvent != 0)
-                {
-                    events[0] = clipboardEvent;
-                    events[1] = event;
-                    eventsCount = 2;
-                }
-                else
-                {
-                    events[0] = event;
-                    eventsCount = 1;
-                }
-
-                for(int i = 0; i < eventsCount; i++)
-                {
-                    if(oc_is_little_endian())
-                    {
-                        oc_event* eventPtr = (oc_event*)oc_wasm_address_to_ptr(app->env.rawEventOffset, sizeof(oc_event));
-                        memcpy(eventPtr, events[i], sizeof(*events[i]));
-
-                        oc_wasm_val eventOffset = { .I32 = (i32)app->env.rawEventOffset };
-                        oc_wasm_status status = oc_wasm_function_call(app->env.wasm, exports[OC_EXPORT_RAW_EVENT], &eventOffset, 1, NULL, 0);
-                        OC_WASM_TRAP(status);
-                    }
-                    else
-                    {
-                        oc_log_error("oc_on_raw_event() is not supported on big endian platforms");
-                    }
-                }
-
-                oc_runtime_clipboard_process_event_end(&__orcaApp.clipboard);
+                oc_runtime_app_watch(app);
             }
-
-            switch(event->type)
+            if(!app->idleMode || app->frameRequested)
             {
-                case OC_EVENT_WINDOW_CLOSE:
-                case OC_EVENT_QUIT:
-                {
-                    app->quit = true;
-                }
-                break;
+                idle = false;
+            }
+            if(app->env.compilePending && !compileApp)
+            {
+                compileApp = app;
+            }
+        }
 
-                case OC_EVENT_WINDOW_RESIZE:
-                {
-                    oc_rect frame = { 0, 0, event->move.frame.w, event->move.frame.h };
+        //NOTE: when all apps are in idle mode, sleep until we get events or a frame is requested. In watch mode we
+        //      still wake up periodically to check the modules. Replays run every frame.
+        if(idle && !replaying)
+        {
+            //NOTE: while a module isn't fully compiled, idle time is spent compiling it instead of sleeping
+            f64 timeout = s_watch_module ? 0.25 : -1;
+            if(compileApp)
+            {
+                oc_runtime_set_current(compileApp);
+                oc_runtime_compile_step(compileApp);
+                timeout = 0;
+            }
+            if(!oc_wait_events(timeout))
+            {
+                continue;
+            }
+        }
 
-                    if(exports[OC_EXPORT_FRAME_RESIZE])
-                    {
-                        oc_wasm_val params[2];
-                        params[0].I32 = (i32)event->move.content.w;
-                        params[1].I32 = (i32)event->move.content.h;
+        //NOTE: frames are paced before polling events, so that input is sampled right before the frame that uses it
+        //      instead of aging while previous frames are queued. In render thread mode, the render thread waits for
+        //      the frame latency after each present, and we only let the guest get one frame ahead of it.
+        if(firstApp->renderThread.enabled)
+        {
+            oc_render_thread_wait_frames(&firstApp->renderThread, 1);
+        }
+        else
+        {
+            oc_canvas_renderer_wait_frame_latency(s_shared.canvasRenderer);
+        }
 
-                        oc_wasm_status status = oc_wasm_function_call(app->env.wasm, exports[OC_EXPORT_FRAME_RESIZE], params, oc_array_size(params), NULL, 0);
-                        OC_WASM_TRAP(status);
-                    }
-                }
-                break;
+        if(s_max_fps > 0 && !replaying)
+        {
+            //NOTE: frame starts are spaced by the target period. If we're late, e.g. after waiting for events in idle
+            //      mode, the schedule restarts from now rather than running several frames back to back to catch up.
+            oc_sleep_until(frameDeadline);
+            frameDeadline = oc_max(frameDeadline, oc_clock_time(OC_CLOCK_MONOTONIC)) + 1. / s_max_fps;
+        }
 
-                case OC_EVENT_MOUSE_BUTTON:
-                {
-                    if(event->key.action == OC_KEY_PRESS)
-                    {
-                        if(exports[OC_EXPORT_MOUSE_DOWN])
-                        {
-                            oc_wasm_val button = { .I32 = event->key.button };
+        if(replaying)
+        {
+            //NOTE: replayed frames run back to back
+        }
+        else if(s_late_frame_start)
+        {
+            oc_runtime_wait_late_frame_start(firstApp);
+        }
+#if OC_PLATFORM_WINDOWS
+        else
+        {
+            //NOTE(martin): on windows we set all surfaces to non-synced, and do a single "manual" wait here.
+            //              on macOS each surface is individually synced to the monitor refresh rate but don't block each other
+            oc_vsync_wait(firstApp->window);
+        }
+#endif
 
-                            oc_wasm_status status = oc_wasm_function_call(app->env.wasm, exports[OC_EXPORT_MOUSE_DOWN], &button, 1, NULL, 0);
-                            OC_WASM_TRAP(status);
-                        }
-                    }
-                    else
-                    {
-                        if(exports[OC_EXPORT_MOUSE_UP])
-                        {
-                            oc_wasm_val button = { .I32 = event->key.button };
+        oc_arena_scope scratch = oc_scratch_begin();
 
-                            oc_wasm_status status = oc_wasm_function_call(app->env.wasm, exports[OC_EXPORT_MOUSE_UP], &button, 1, NULL, 0);
-                            OC_WASM_TRAP(status);
-                        }
-                    }
-                }
-                break;
+        OC_TRACE_BEGIN("frame");
 
-                case OC_EVENT_MOUSE_WHEEL:
-                {
-                    if(exports[OC_EXPORT_MOUSE_WHEEL])
-                    {
-                        oc_wasm_val params[2];
-                        params[0].F32 = event->mouse.deltaX;
-                        params[1].F32 = event->mouse.deltaY;
+        //NOTE: events are collected first, and each app then dispatches the ones it owns. Apps in idle mode only run
+        //      a frame if they got events or requested one.
+        oc_list events = { 0 };
+        oc_event* event = 0;
+        while((event = oc_next_event(scratch.arena)) != 0)
+        {
+            //NOTE: real input is ignored while replaying, except quit requests so that a replay can be interrupted
+            if(replaying && event->type != OC_EVENT_QUIT)
+            {
+                continue;
+            }
 
-                        oc_wasm_status status = oc_wasm_function_call(app->env.wasm, exports[OC_EXPORT_MOUSE_WHEEL], params, oc_array_size(params), NULL, 0);
-                        OC_WASM_TRAP(status);
-                    }
-                }
-                break;
+            oc_runtime_event_elt* elt = oc_arena_push_type(scratch.arena, oc_runtime_event_elt);
+            elt->event = event;
+            oc_list_push_back(&events, &elt->listElt);
 
-                case OC_EVENT_MOUSE_MOVE:
+            u32 ownerIndex = OC_RUNTIME_INPUT_NO_APP;
+            for(u32 appIndex = 0; appIndex < s_appCount; appIndex++)
+            {
+                if(oc_runtime_app_owns_event(&s_apps[appIndex], event))
                 {
-                    if(exports[OC_EXPORT_MOUSE_MOVE])
+                    s_apps[appIndex].frameRequested = true;
+                    if(event->window.h)
                     {
-                        oc_wasm_val params[4];
-                        params[0].F32 = event->mouse.x;
-                        params[1].F32 = event->mouse.y;
-                        params[2].F32 = event->mouse.deltaX;
-                        params[3].F32 = event->mouse.deltaY;
-
-                        oc_wasm_status status = oc_wasm_function_call(app->env.wasm, exports[OC_EXPORT_MOUSE_MOVE], params, oc_array_size(params), NULL, 0);
-                        OC_WASM_TRAP(status);
+                        ownerIndex = appIndex;
                     }
                 }
-                break;
+            }
+            oc_runtime_input_record_event(&s_input, event, ownerIndex);
+        }
+
+        if(replaying)
+        {
+            oc_runtime_input_replay_frame_begin(&s_input);
 
-                case OC_EVENT_KEYBOARD_KEY:
+            oc_runtime_input_record* record = 0;
+            while((record = oc_runtime_input_replay_next(&s_input, scratch.arena)) != 0)
+            {
+                event = &record->event;
+                if(record->appIndex != OC_RUNTIME_INPUT_NO_APP)
                 {
-                    if(event->key.action == OC_KEY_PRESS)
+                    if(record->appIndex >= s_appCount)
                     {
-                        if(event->key.keyCode == OC_KEY_D
-                           && (event->key.mods & OC_KEYMOD_SHIFT)
-                           && (event->key.mods & OC_KEYMOD_MAIN_MODIFIER))
-                        {
-                            debug_overlay_toggle(&app->debugOverlay);
-                        }
-
-                        if(exports[OC_EXPORT_KEY_DOWN])
-                        {
-                            oc_wasm_val params[2];
-                            params[0].I32 = event->key.scanCode;
-                            params[1].I32 = event->key.keyCode;
-
-                            oc_wasm_status status = oc_wasm_function_call(app->env.wasm, exports[OC_EXPORT_KEY_DOWN], params, oc_array_size(params), NULL, 0);
-                            OC_WASM_TRAP(status);
-                        }
+                        continue;
                     }
-                    else if(event->key.action == OC_KEY_RELEASE)
-                    {
-                        if(exports[OC_EXPORT_KEY_UP])
-                        {
-                            oc_wasm_val params[2];
-                            params[0].I32 = event->key.scanCode;
-                            params[1].I32 = event->key.keyCode;
+                    event->window = s_apps[record->appIndex].window;
 
-                            oc_wasm_status status = oc_wasm_function_call(app->env.wasm, exports[OC_EXPORT_KEY_UP], params, oc_array_size(params), NULL, 0);
-                            OC_WASM_TRAP(status);
-                        }
+                    //NOTE: resize the window too, so that the app's surfaces have the recorded size. The resize
+                    //      event this generates is ignored like other real input.
+                    if(event->type == OC_EVENT_WINDOW_RESIZE)
+                    {
+                        oc_window_set_content_size(event->window, (oc_vec2){ event->move.content.w, event->move.content.h });
                     }
                 }
-                break;
-
-                default:
-                    break;
+                oc_runtime_event_elt* elt = oc_arena_push_type(scratch.arena, oc_runtime_event_elt);
+                elt->event = event;
+                oc_list_push_back(&events, &elt->listElt);
             }
-        }
 
-        if(exports[OC_EXPORT_FRAME_REFRESH])
-        {
-            oc_wasm_status status = oc_wasm_function_call(app->env.wasm, exports[OC_EXPORT_FRAME_REFRESH], NULL, 0, NULL, 0);
-            OC_WASM_TRAP(status);
+            //NOTE: apps quit after the frame that gets the last recorded events
+            bool done = oc_runtime_input_replay_done(&s_input);
+            for(u32 appIndex = 0; appIndex < s_appCount; appIndex++)
+            {
+                s_apps[appIndex].frameRequested = true;
+                s_apps[appIndex].quit |= done;
+            }
         }
 
-        oc_canvas_context_select(app->debugOverlay.context);
-
-        if(app->debugOverlay.show)
+        for(u32 appIndex = 0; appIndex < s_appCount; appIndex++)
         {
-            //TODO: only move if it's not already on the front?
-            oc_surface_bring_to_front(app->debugOverlay.surface);
-
-            oc_ui_style debugUIDefaultStyle = { .bgColor = { 0 },
-                                                .color = { 1, 1, 1, 1 },
-                                                .font = app->debugOverlay.fontReg,
-                                                .fontSize = 16,
-                                                .borderColor = { 1, 0, 0, 1 },
-                                                .borderSize = 2 };
-
-            oc_ui_style_mask debugUIDefaultMask = OC_UI_STYLE_BG_COLOR
-                                                | OC_UI_STYLE_COLOR
-                                                | OC_UI_STYLE_BORDER_COLOR
-                                                | OC_UI_STYLE_BORDER_SIZE
-                                                | OC_UI_STYLE_FONT
-                                                | OC_UI_STYLE_FONT_SIZE;
+            oc_runtime* app = &s_apps[appIndex];
+            if(app->stopped || (app->idleMode && !app->frameRequested))
+            {
+                continue;
+            }
+            app->frameRequested = false;
 
-            oc_vec2 frameSize = oc_surface_get_size(app->debugOverlay.surface);
+            oc_runtime_set_current(app);
+            oc_runtime_app_frame(app, &events);
 
-            oc_ui_frame(frameSize, &debugUIDefaultStyle, debugUIDefaultMask)
+            if(app->quit)
             {
-                oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
-                                                 .size.height = { OC_UI_SIZE_PARENT, 1, 1 } },
-                                 OC_UI_STYLE_SIZE);
-
-                oc_ui_container("overlay area", 0)
+                oc_runtime_app_stop(app);
+                runningCount--;
+                while(runningCount && firstApp->stopped)
                 {
-                    //...
+                    firstApp++;
                 }
-
-                oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
-                                                 .size.height = { OC_UI_SIZE_PARENT, 0.4 },
-                                                 .layout.axis = OC_UI_AXIS_Y,
-                                                 .bgColor = { 0, 0, 0, 0.5 } },
-                                 OC_UI_STYLE_SIZE
-                                     | OC_UI_STYLE_LAYOUT_AXIS
-                                     | OC_UI_STYLE_BG_COLOR);
-
-                oc_ui_container("log console", OC_UI_FLAG_DRAW_BACKGROUND)
+                //NOTE: the process exits with the code of the last app that exited with an error
+                if(app->exitCode)
                 {
-                    oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
-                                                     .size.height = { OC_UI_SIZE_CHILDREN },
-                                                     .layout.axis = OC_UI_AXIS_X,
-                                                     .layout.spacing = 10,
-                                                     .layout.margin.x = 10,
-                                                     .layout.margin.y = 10 },
-                                     OC_UI_STYLE_SIZE
-                                         | OC_UI_STYLE_LAYOUT);
-
-                    oc_ui_container("log toolbar", 0)
-                    {
-                        oc_ui_style buttonStyle = { .layout.margin.x = 4,
-                                                    .layout.margin.y = 4,
-                                                    .roundness = 2,
-                                                    .bgColor = { 0, 0, 0, 0.5 },
-                                                    .color = { 1, 1, 1, 1 } };
-
-                        oc_ui_style_mask buttonStyleMask = OC_UI_STYLE_LAYOUT_MARGINS
-                                                         | OC_UI_STYLE_ROUNDNESS
-                                                         | OC_UI_STYLE_BG_COLOR
-                                                         | OC_UI_STYLE_COLOR;
-
-                        oc_ui_style_match_after(oc_ui_pattern_all(), &buttonStyle, buttonStyleMask);
-                        if(oc_ui_button("Clear").clicked)
-                        {
-                            oc_list_for_safe(app->debugOverlay.logEntries, entry, log_entry, listElt)
-                            {
-                                oc_list_remove(&app->debugOverlay.logEntries, &entry->listElt);
-                                oc_list_push_front(&app->debugOverlay.logFreeList, &entry->listElt);
-                                app->debugOverlay.entryCount--;
-                            }
-                        }
-                    }
-
-                    oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
-                                                     .size.height = { OC_UI_SIZE_PARENT, 1, 1 } },
-                                     OC_UI_STYLE_SIZE);
-
-                    //TODO: this is annoying to have to do that. Basically there's another 'contents' box inside oc_ui_panel,
-                    //      and we need to change that to size according to its parent (whereas the default is sizing according
-                    //      to its children)
-                    oc_ui_pattern pattern = { 0 };
-                    oc_ui_pattern_push(scratch.arena, &pattern, (oc_ui_selector){ .kind = OC_UI_SEL_OWNER });
-                    oc_ui_pattern_push(scratch.arena, &pattern, (oc_ui_selector){ .kind = OC_UI_SEL_TEXT, .text = OC_STR8("contents") });
-                    oc_ui_style_match_after(pattern, &(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 } }, OC_UI_STYLE_SIZE_WIDTH);
-
-                    oc_ui_box* panel = oc_ui_box_lookup("log view");
-                    f32 scrollY = 0;
-                    if(panel)
-                    {
-                        scrollY = panel->scroll.y;
-                    }
-
-                    oc_ui_panel("log view", OC_UI_FLAG_SCROLL_WHEEL_Y)
-                    {
-                        panel = oc_ui_box_top()->parent;
-
-                        oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
-                                                         .size.height = { OC_UI_SIZE_CHILDREN },
-                                                         .layout.axis = OC_UI_AXIS_Y,
-                                                         .layout.margin.y = 5 },
-                                         OC_UI_STYLE_SIZE
-                                             | OC_UI_STYLE_LAYOUT_AXIS);
-
-                        oc_ui_container("contents", 0)
-                        {
-                            oc_list_for(app->debugOverlay.logEntries, entry, log_entry, listElt)
-                            {
-                                log_entry_ui(&app->debugOverlay, entry);
-                            }
-                        }
-                    }
-                    if(app->debugOverlay.logScrollToLast)
-                    {
-                        if(panel->scroll.y >= scrollY)
-                        {
-                            panel->scroll.y = oc_clamp_low(panel->childrenSum[1] - panel->rect.h, 0);
-                        }
-                        else
-                        {
-                            app->debugOverlay.logScrollToLast = false;
-                        }
-                    }
-                    else if(panel->scroll.y >= (panel->childrenSum[1] - panel->rect.h) - 1)
-                    {
-                        app->debugOverlay.logScrollToLast = true;
-                    }
+                    exitCode = app->exitCode;
                 }
             }
-
-            oc_ui_draw();
         }
-        else
+
+        OC_TRACE_END();
+
+        if(replaying)
         {
-            //TODO: only move if it's not already on the back?
-            oc_surface_send_to_back(app->debugOverlay.surface);
-            oc_set_color_rgba(0, 0, 0, 0);
-            oc_clear();
+            oc_runtime_input_replay_frame_end(&s_input);
         }
 
-        oc_canvas_render(app->canvasRenderer, app->debugOverlay.context, app->debugOverlay.surface);
-        oc_canvas_present(app->canvasRenderer, app->debugOverlay.surface);
-
         oc_scratch_end(scratch);
+    }
 
-#if OC_PLATFORM_WINDOWS
-        //NOTE(martin): on windows we set all surfaces to non-synced, and do a single "manual" wait here.
-        //              on macOS each surface is individually synced to the monitor refresh rate but don't block each other
-        oc_vsync_wait(app->window);
-#endif
+    {
+        oc_arena_scope scratch = oc_scratch_begin();
+        oc_str8 reportPath = s_replay_report_path
+                               ? OC_STR8(s_replay_report_path)
+                               : oc_path_executable_relative(scratch.arena, OC_STR8("replay.json"));
+        oc_runtime_input_end(&s_input, reportPath);
+        oc_scratch_end(scratch);
     }
 
-    if(exports[OC_EXPORT_TERMINATE])
+    if(oc_trace_is_enabled())
     {
-        oc_wasm_status status = oc_wasm_function_call(app->env.wasm, exports[OC_EXPORT_TERMINATE], NULL, 0, NULL, 0);
-        OC_WASM_TRAP(status);
+        oc_arena_scope scratch = oc_scratch_begin();
+        oc_trace_stop();
+        oc_trace_write(oc_path_executable_relative(scratch.arena, OC_STR8("trace.json")));
+        oc_scratch_end(scratch);
     }
 
     oc_request_quit();
 
-    return (0);
+    return (exitCode);
 }
 
 int main(int argc, char** argv)
 {
-    if(argc > 1)
+    for(int i = 1; i < argc; i++)
     {
-        if(strstr(argv[1], "--test="))
+        if(strstr(argv[i], "--test="))
+        {
+            s_test_wasm_module_path = argv[i] + sizeof("--test=") - 1;
+        }
+        else if(!strcmp(argv[i], "--watch"))
+        {
+            s_watch_module = true;
+        }
+        else if(!strcmp(argv[i], "--render-thread"))
+        {
+            s_render_thread = true;
+        }
+        else if(!strcmp(argv[i], "--gles-thread"))
+        {
+            s_gles_thread = true;
+        }
+        else if(!strcmp(argv[i], "--sync-log"))
+        {
+            //NOTE: useful to see the last messages of a guest that crashes the runtime
+            s_sync_log = true;
+        }
+        else if(strstr(argv[i], "--callback-budget="))
+        {
+            //NOTE: in milliseconds, 0 disables overrun reporting
+            s_callback_budget_ms = atof(argv[i] + sizeof("--callback-budget=") - 1);
+        }
+        else if(strstr(argv[i], "--compile-budget="))
+        {
+            //NOTE: in milliseconds per frame, 0 compiles the whole module at load time
+            s_compile_budget_ms = atof(argv[i] + sizeof("--compile-budget=") - 1);
+        }
+        else if(!strcmp(argv[i], "--large-pages"))
+        {
+            //NOTE: reduces TLB misses for guests with big heaps, at the cost of committing memory in 2MB increments
+            s_large_pages = true;
+        }
+        else if(!strcmp(argv[i], "--cpu-canvas"))
+        {
+            s_cpu_canvas = true;
+        }
+        else if(!strcmp(argv[i], "--image-cache"))
+        {
+            s_image_cache = true;
+        }
+        else if(strstr(argv[i], "--image-cache="))
+        {
+            //NOTE: in megabytes of released images kept for reuse
+            s_image_cache = true;
+            s_image_cache_budget = (u64)(atof(argv[i] + sizeof("--image-cache=") - 1) * (1 << 20));
+        }
+        else if(strstr(argv[i], "--startup-report="))
+        {
+            s_startup_report_path = argv[i] + sizeof("--startup-report=") - 1;
+        }
+        else if(strstr(argv[i], "--record-input="))
+        {
+            s_record_input_path = argv[i] + sizeof("--record-input=") - 1;
+        }
+        else if(strstr(argv[i], "--replay-input="))
+        {
+            //NOTE: replays recorded input at a fixed time step, with tracing on, and quits at the end of the
+            //      recording. The trace is written to trace.json next to the runtime
+            s_replay_input_path = argv[i] + sizeof("--replay-input=") - 1;
+        }
+        else if(strstr(argv[i], "--replay-report="))
+        {
+            s_replay_report_path = argv[i] + sizeof("--replay-report=") - 1;
+        }
+        else if(strstr(argv[i], "--replay-step="))
+        {
+            //NOTE: in milliseconds of virtual time per replayed frame
+            s_replay_step_ms = atof(argv[i] + sizeof("--replay-step=") - 1);
+        }
+        else if(strstr(argv[i], "--hotness-profile="))
+        {
+            //NOTE: records the call counts and times of guest exports and host bindings over the whole run, and
+            //      writes them to this path when the app quits. See `orca bundle --hotness-profile`
+            s_hotness_profile_path = argv[i] + sizeof("--hotness-profile=") - 1;
+        }
+        else if(!strcmp(argv[i], "--quit-after-startup"))
+        {
+            //NOTE: used by the startup benchmark, see tests/perf/perf_suite.py
+            s_quit_after_startup = true;
+        }
+        else if(strstr(argv[i], "--max-fps="))
+        {
+            //NOTE: frame rate limit, on top of vsync. 0 disables the limiter
+            s_max_fps = atof(argv[i] + sizeof("--max-fps=") - 1);
+        }
+        else if(!strcmp(argv[i], "--late-frame-start"))
+        {
+            s_late_frame_start = true;
+        }
+        else if(strstr(argv[i], "--app="))
+        {
+            //NOTE: runs the app in this directory, laid out like a bundle's app directory. Can be repeated to run
+            //      several apps in one process.
+            if(s_app_dir_count < OC_RUNTIME_MAX_APPS)
+            {
+                s_app_dirs[s_app_dir_count++] = argv[i] + sizeof("--app=") - 1;
+            }
+        }
+        else if(!strncmp(argv[i], "--wasm-", sizeof("--wasm-") - 1))
         {
-            s_test_wasm_module_path = argv[1] + sizeof("--test=") - 1;
+            //NOTE: wasm engine options, e.g. --wasm-vm=register, --wasm-stack-size=1m or --wasm-debug
+            if(s_wasm_engine_arg_count < oc_array_size(s_wasm_engine_args))
+            {
+                s_wasm_engine_args[s_wasm_engine_arg_count++] = argv[i] + sizeof("--wasm-") - 1;
+            }
         }
     }
 
@@ -1037,45 +3192,120 @@ int main(int argc, char** argv)
 
     oc_init();
     oc_clock_init();
+    s_startup.processStart = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+    //NOTE: without --app, run the app bundled next to the runtime
+    oc_arena appArena;
+    oc_arena_init(&appArena);
+
+    s_appCount = oc_max(s_app_dir_count, 1);
+    if(s_test_wasm_module_path)
+    {
+        s_appCount = 1;
+    }
+    if(s_appCount > 1 && (s_render_thread || s_gles_thread))
+    {
+        //NOTE: apps share the canvas renderer from the runloop thread, so they can't drive it from their own threads
+        oc_log_warning("--render-thread and --gles-thread are ignored when running several apps\n");
+        s_render_thread = false;
+        s_gles_thread = false;
+    }
+
+    for(u32 appIndex = 0; appIndex < s_appCount; appIndex++)
+    {
+        oc_runtime* app = &s_apps[appIndex];
 
-    oc_runtime* app = &__orcaApp;
+        app->appDir = s_app_dir_count
+                        ? oc_str8_push_copy(&appArena, OC_STR8(s_app_dirs[appIndex]))
+                        : oc_path_executable_relative(&appArena, OC_STR8("../app"));
+        app->modulePath = s_test_wasm_module_path
+                            ? oc_str8_push_copy(&appArena, OC_STR8(s_test_wasm_module_path))
+                            : oc_path_append(&appArena, app->appDir, OC_STR8("wasm/module.wasm"));
 
-    app->debugOverlay.maxEntries = 200;
-    oc_arena_init(&app->debugOverlay.logArena);
+        app->watchdog.budget = s_callback_budget_ms / 1000;
+
+        app->debugOverlay.logBufferCap = 1 << 20;
+        app->debugOverlay.logBuffer = malloc(app->debugOverlay.logBufferCap);
+        oc_arena_init(&app->profiler.arena);
+        oc_arena_init(&app->profiler.statsArena);
+    }
 
     if(s_test_wasm_module_path == NULL)
     {
-        //NOTE: create window and surfaces
-        oc_rect windowRect = { .x = 100, .y = 100, .w = 810, .h = 610 };
-        app->window = oc_window_create(windowRect, OC_STR8("orca"), 0);
+        //NOTE: resources shared by all apps
+        oc_canvas_renderer_options rendererOptions = {
+            .powerPreference = OC_CANVAS_POWER_HIGH_PERFORMANCE,
+            .backend = s_cpu_canvas ? OC_CANVAS_BACKEND_CPU : OC_CANVAS_BACKEND_DEFAULT,
+        };
+        oc_runtime_startup_begin(&s_startup);
+        s_shared.canvasRenderer = oc_canvas_renderer_create_with_options(&rendererOptions);
+        if(s_image_cache)
+        {
+            oc_canvas_renderer_enable_image_cache(s_shared.canvasRenderer, s_image_cache_budget);
+        }
+        oc_runtime_startup_phase_end(&s_startup, OC_RUNTIME_STARTUP_RENDERER);
+
+        s_shared.debugFontReg = orca_font_create("../resources/Menlo.ttf");
+        s_shared.debugFontBold = orca_font_create("../resources/Menlo Bold.ttf");
+        oc_arena_init(&s_shared.fontArena);
+        oc_runtime_startup_phase_end(&s_startup, OC_RUNTIME_STARTUP_FONTS);
+
+        for(u32 appIndex = 0; appIndex < s_appCount; appIndex++)
+        {
+            oc_runtime* app = &s_apps[appIndex];
 
-        app->canvasRenderer = oc_canvas_renderer_create();
+            //NOTE: create window and surfaces. Windows of several apps are cascaded.
+            oc_rect windowRect = { .x = 100 + 40 * appIndex, .y = 100 + 40 * appIndex, .w = 810, .h = 610 };
+            app->window = oc_window_create(windowRect, OC_STR8("orca"), 0);
 
-        app->debugOverlay.show = false;
-        app->debugOverlay.surface = oc_canvas_surface_create_for_window(app->canvasRenderer, app->window);
-        app->debugOverlay.context = oc_canvas_context_create();
-        app->debugOverlay.fontReg = orca_font_create("../resources/Menlo.ttf");
-        app->debugOverlay.fontBold = orca_font_create("../resources/Menlo Bold.ttf");
+            //NOTE: route the events of the app's directory watches to its window
+            app->fileTable.watchWindow = app->window.h;
 
-        /*TODO: wgpu-renderer: set swap interval?
+            app->canvasRenderer = s_shared.canvasRenderer;
+
+            app->debugOverlay.show = false;
+            app->debugOverlay.surface = oc_canvas_surface_create_for_window(app->canvasRenderer, app->window);
+            app->debugOverlay.context = oc_canvas_context_create();
+            app->debugOverlay.fontReg = s_shared.debugFontReg;
+            app->debugOverlay.fontBold = s_shared.debugFontBold;
+
+            /*TODO: wgpu-renderer: set swap interval?
 
 #if OC_PLATFORM_WINDOWS
-        //NOTE(martin): on windows we set all surfaces to non-synced, and do a single "manual" wait here.
-        //              on macOS each surface is individually synced to the monitor refresh rate but don't block each other
-        oc_surface_swap_interval(app->debugOverlay.surface, 0);
+            //NOTE(martin): on windows we set all surfaces to non-synced, and do a single "manual" wait here.
+            //              on macOS each surface is individually synced to the monitor refresh rate but don't block each other
+            oc_surface_swap_interval(app->debugOverlay.surface, 0);
 #else
-        oc_surface_swap_interval(app->debugOverlay.surface, 1);
+            oc_surface_swap_interval(app->debugOverlay.surface, 1);
 #endif
-    */
-        oc_ui_init(&app->debugOverlay.ui);
+        */
+            oc_ui_init(&app->debugOverlay.ui);
 
-        //NOTE: show window and start runloop
-        oc_window_bring_to_front(app->window);
-        oc_window_focus(app->window);
-        oc_window_center(app->window);
+            oc_window_bring_to_front(app->window);
+            if(s_appCount == 1)
+            {
+                oc_window_center(app->window);
+            }
+        }
+
+        //NOTE: show windows and start runloop. The first app gets the focus.
+        oc_window_focus(s_apps[0].window);
+        s_apps[0].frameInfo.focused = 1;
+        oc_runtime_startup_phase_end(&s_startup, OC_RUNTIME_STARTUP_WINDOWS);
     }
 
-    oc_thread* runloopThread = oc_thread_create(orca_runloop, 0);
+    //NOTE: the main thread pumps input events, and the runloop thread produces the frames
+    oc_thread_set_priority(0, OC_THREAD_PRIORITY_FRAME);
+
+    oc_thread_options runloopOptions = {
+        .name = OC_STR8("runloop"),
+        .priority = OC_THREAD_PRIORITY_FRAME,
+    };
+    if(!s_sync_log)
+    {
+        oc_runtime_log_start(&s_log);
+    }
+    oc_thread* runloopThread = oc_thread_create_with_options(orca_runloop, 0, &runloopOptions);
 
     while(!oc_should_quit())
     {
@@ -1085,13 +3315,12 @@ int main(int argc, char** argv)
 
     i64 exitCode = 0;
     oc_thread_join(runloopThread, &exitCode);
+    oc_runtime_log_stop(&s_log);
 
     if(s_test_wasm_module_path == NULL)
     {
-        oc_canvas_context_destroy(app->debugOverlay.context);
-        oc_surface_destroy(app->debugOverlay.surface);
-        oc_canvas_renderer_destroy(app->canvasRenderer);
-        oc_window_destroy(app->window);
+        //NOTE: the apps' windows and surfaces were destroyed when they stopped
+        oc_canvas_renderer_destroy(s_shared.canvasRenderer);
     }
 
     oc_terminate();
@@ -7,9 +7,17 @@
 **************************************************************************/
 #pragma once
 
+#include "platform/platform_audio.h"
 #include "platform/platform_io_internal.h"
 #include "runtime_memory.h"
+#include "runtime_net.h"
+#include "runtime_archive.h"
 #include "runtime_clipboard.h"
+#include "runtime_input.h"
+#include "runtime_log.h"
+#include "runtime_profiler.h"
+#include "runtime_gles.h"
+#include "runtime_render.h"
 #include "wasm/wasm.h"
 
 // Note oc_on_test() is a special handler only called for --test modules
@@ -27,8 +35,10 @@
     X(OC_EXPORT_FRAME_REFRESH, "oc_on_frame_refresh", "", "") \
     X(OC_EXPORT_FRAME_RESIZE, "oc_on_resize", "", "ii")       \
     X(OC_EXPORT_RAW_EVENT, "oc_on_raw_event", "", "i")        \
+    X(OC_EXPORT_EVENTS, "oc_on_events", "", "ii")             \
     X(OC_EXPORT_TERMINATE, "oc_on_terminate", "", "")         \
-    X(OC_EXPORT_ARENA_PUSH, "oc_arena_push_stub", "i", "iI")
+    X(OC_EXPORT_ARENA_PUSH, "oc_arena_push_stub", "i", "iI")  \
+    X(OC_EXPORT_STDIO_FLUSH, "oc_stdio_flush_stub", "", "")
 
 typedef enum
 {
@@ -54,14 +64,48 @@ const oc_export_desc OC_EXPORT_DESC[] = {
 #undef OC_STR8_LIT
 };
 
+//NOTE: a region of wasm memory grown by the host to hold file mappings. Regions can't be given back to the
+//      wasm memory, so unmapped regions are reused by later mappings.
+typedef struct oc_wasm_mapping_region
+{
+    oc_wasm_addr addr;
+    u32 size;
+    bool used;
+
+} oc_wasm_mapping_region;
+
+enum
+{
+    OC_WASM_MAX_MAPPING_REGIONS = 64,
+};
+
 typedef struct oc_wasm_memory
 {
+    oc_base_allocator* base;
     char* ptr;
     u64 reserved;
     u64 committed;
 
+    u32 mappingRegionCount;
+    oc_wasm_mapping_region mappingRegions[OC_WASM_MAX_MAPPING_REGIONS];
+
 } oc_wasm_memory;
 
+//NOTE: upload region created by the guest with oc_gles_upload_region_create(). Handles hold the index of the
+//      region plus one in their low bits, and its generation in their high bits.
+typedef struct oc_wasm_gles_upload_region
+{
+    oc_wasm_mapping_region* mapping; // 0 if the region is free
+    u32 slotSize;
+    u32 generation;
+
+} oc_wasm_gles_upload_region;
+
+enum
+{
+    OC_WASM_MAX_GLES_UPLOAD_REGIONS = 16,
+};
+
 typedef struct oc_wasm_env
 {
     oc_str8 wasmBytecode;
@@ -69,13 +113,21 @@ typedef struct oc_wasm_env
 
     oc_wasm* wasm;
     oc_wasm_function_handle* exports[OC_EXPORT_COUNT];
+    oc_wasm_call_stub exportStubs[OC_EXPORT_COUNT]; // exports bound to their signature, see oc_runtime_call_export()
     u32 rawEventOffset;
+    u32 eventBatchOffset;
+    u32 frameInfoOffset; // oc_frameInfo global of the guest, or 0 if the module doesn't have one
+    u32 mallocTrackingOffset; // heap site table of an orca-libc built with malloc tracking, or 0
+    u32 glesCommandBufferOffset; // GL command buffer of a guest built with OC_GLES_COMMAND_BUFFER, or 0
+    oc_wasm_gles_upload_region glesUploadRegions[OC_WASM_MAX_GLES_UPLOAD_REGIONS];
+    u64 glesFrameIndex; // number of GLES buffer swaps, selects the current slot of upload regions
+    bool compilePending; // the module's compilation was deferred and isn't finished
+    f64 compileTime;     // time spent in deferred compilation slices, in seconds
 } oc_wasm_env;
 
 typedef struct log_entry
 {
     oc_list_elt listElt;
-    u64 cap;
 
     oc_log_level level;
     oc_str8 file;
@@ -90,6 +142,7 @@ typedef struct log_entry
 typedef struct oc_debug_overlay
 {
     bool show;
+    bool hidden; // the surface was cleared and hidden, and isn't rendered until the overlay is shown again
     oc_surface surface;
     oc_canvas_context context;
 
@@ -97,34 +150,124 @@ typedef struct oc_debug_overlay
     oc_font fontBold;
     oc_ui_context ui;
 
-    oc_arena logArena;
+    //NOTE: log entries are stored contiguously in a fixed-size ring buffer. When a new entry doesn't fit,
+    //      the oldest entries are dropped.
+    char* logBuffer;
+    u64 logBufferCap;
+    u64 logBufferTail;
     oc_list logEntries;
-    oc_list logFreeList;
     u32 entryCount;
-    u32 maxEntries;
     u64 logEntryTotalCount;
     bool logScrollToLast;
+    f32 logRowHeight; // height of a console row in the previous frame, used to only build the visible rows
+
+    bool showHeapSites;
+    bool showMemoryStats;
 
 } oc_debug_overlay;
 
+enum
+{
+    OC_RUNTIME_OVERRUN_HISTORY = 32,
+};
+
+typedef struct oc_runtime_overrun
+{
+    guest_export_kind exportKind;
+    f64 time;
+    f64 duration;
+} oc_runtime_overrun;
+
+//NOTE: guest callbacks that run longer than budget are recorded in a ring of the last OC_RUNTIME_OVERRUN_HISTORY overruns
+typedef struct oc_runtime_watchdog
+{
+    f64 budget; // seconds, 0 disables the watchdog
+    u64 overrunCount;
+    u32 historyIndex;
+    oc_runtime_overrun history[OC_RUNTIME_OVERRUN_HISTORY];
+    f64 lastWarningTime;
+} oc_runtime_watchdog;
+
+//NOTE: a runtime process can host several app instances (see --app), each with its own wasm instance, window,
+//      file table and debug overlay. They run on the same runloop thread, and share the canvas renderer (and with it
+//      the GPU device and pipelines), the debug overlay fonts, and the native copies of guest fonts that they create
+//      from the same data.
+enum
+{
+    OC_RUNTIME_MAX_APPS = 8,
+    OC_RUNTIME_MAX_GUEST_SURFACES = 16,
+};
+
+typedef struct oc_runtime_shared_font
+{
+    oc_list_elt listElt;
+    u64 key; // hash of the font data and creation options
+    oc_font font;
+    u32 refCount;
+} oc_runtime_shared_font;
+
+typedef struct oc_runtime_shared
+{
+    oc_canvas_renderer canvasRenderer;
+    oc_font debugFontReg;
+    oc_font debugFontBold;
+
+    oc_arena fontArena;
+    oc_list fonts;
+    oc_list fontFreeList;
+} oc_runtime_shared;
+
 typedef struct oc_runtime
 {
     bool quit;
+    bool stopped;        // the instance was terminated, and its resources, window and surfaces were released
+    bool failed;         // the guest trapped, aborted or failed an assertion, and won't be called again
+    bool exited;         // the guest called exit(), and won't be called again
+    i32 exitCode;        // exit() code, or -1 if the guest failed
+    bool idleMode;       // only run frames when there are events or the guest requested one
+    bool frameRequested; // run the next frame even if there are no events
     oc_window window;
     oc_canvas_renderer canvasRenderer;
+    oc_render_thread renderThread; // only used in render thread mode
+    oc_gles_thread glesThread;     // only used in GLES thread mode
     oc_debug_overlay debugOverlay;
+    oc_surface guestSurfaces[OC_RUNTIME_MAX_GUEST_SURFACES]; // surfaces created by the guest, destroyed with the app
+    u32 guestSurfaceCount;
 
     oc_file_table fileTable;
+    oc_io_queue* ioQueue;
+    oc_runtime_net* net;
+    oc_audio_output* audio; // opened by the guest, and kept across module reloads
     oc_file rootDir;
+    oc_str8 dataArchive; // mapped data archive, or empty if the app's data is loose files
 
     oc_wasm_env env;
 
     oc_runtime_clipboard clipboard;
+    oc_runtime_profiler profiler;
+    oc_runtime_watchdog watchdog;
+    oc_runtime_startup startup;
+
+    oc_frame_info frameInfo; // host copy of the frame info, written to the guest before each frame
+    f64 frameWorkTime;       // running average of the time from the start of a frame to its present, in seconds
+
+    oc_str8 appDir; // holds the app's wasm/module.wasm, and its data directory or data.oca archive
+    oc_str8 modulePath;
+    u64 overlayRenderSerial;
+    oc_surface glesSurface; // last GLES surface the guest made current, restored when switching between apps
+
+    //NOTE: in watch mode, the module is reloaded once its modification date has stopped changing for a little while
+    oc_datestamp moduleDate;
+    oc_datestamp pendingModuleDate;
+    f64 lastWatchTime;
+    f64 pendingModuleTime;
 } oc_runtime;
 
+// returns the app instance the runloop is currently running
 oc_runtime* oc_runtime_get(void);
 oc_wasm_env* oc_runtime_get_env(void);
 oc_str8 oc_runtime_get_wasm_memory(void);
+void oc_runtime_gles_command_buffer_flush(bool sync);
 
 void oc_abort_ext_dialog(const char* file, const char* function, int line, const char* fmt, ...);
 void oc_assert_fail_dialog(const char* file, const char* function, int line, const char* test, const char* fmt, ...);
@@ -134,12 +277,16 @@ void oc_assert_fail_dialog(const char* file, const char* function, int line, con
 #define OC_ASSERT_DIALOG(test, ...) \
     _OC_ASSERT_DIALOG_(test, OC_VA_NOPT("", ##__VA_ARGS__) OC_ARG1(__VA_ARGS__) OC_VA_COMMA_TAIL(__VA_ARGS__))
 
-#define OC_WASM_TRAP(status)                                                                                        \
-    do                                                                                                              \
-    {                                                                                                               \
-        if(oc_wasm_status_is_fail(status))                                                                          \
-        {                                                                                                           \
-            oc_abort_ext_dialog(__FILE__, __FUNCTION__, __LINE__, "%.*s", oc_str8_ip(oc_wasm_status_str8(status))); \
-        }                                                                                                           \
-    }                                                                                                               \
+// stop the current app after a trap or a failed guest assertion or abort. The other apps keep running.
+void oc_runtime_app_abort(const char* file, const char* function, int line, const char* fmt, ...);
+void oc_runtime_app_assert_fail(const char* file, const char* function, int line, const char* test, const char* fmt, ...);
+
+#define OC_WASM_TRAP(status)                                                                                         \
+    do                                                                                                               \
+    {                                                                                                                \
+        if(oc_wasm_status_is_fail(status))                                                                           \
+        {                                                                                                            \
+            oc_runtime_app_abort(__FILE__, __FUNCTION__, __LINE__, "%.*s", oc_str8_ip(oc_wasm_status_str8(status))); \
+        }                                                                                                            \
+    }                                                                                                                \
     while(0)
@@ -0,0 +1,290 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include "zlib.h"
+
+#include "runtime_archive.h"
+#include "platform/platform_io_internal.h"
+#include "util/hash.h"
+
+static bool oc_archive_validate_chunks(oc_str8 archive, oc_archive_entry* entry)
+{
+    u64 expectedCount = (entry->size + OC_ARCHIVE_CHUNK_SIZE - 1) / OC_ARCHIVE_CHUNK_SIZE;
+    u64 tableSize = ((u64)entry->chunkCount + 1) * sizeof(u64);
+
+    if(entry->chunkCount != expectedCount
+       || (entry->offset & (_Alignof(u64) - 1))
+       || tableSize > entry->storedSize)
+    {
+        return (false);
+    }
+
+    u64* chunkOffsets = (u64*)(archive.ptr + entry->offset);
+    if(chunkOffsets[0] != tableSize || chunkOffsets[entry->chunkCount] != entry->storedSize)
+    {
+        return (false);
+    }
+    for(u32 i = 0; i < entry->chunkCount; i++)
+    {
+        if(chunkOffsets[i + 1] < chunkOffsets[i])
+        {
+            return (false);
+        }
+    }
+    return (true);
+}
+
+bool oc_archive_validate(oc_str8 archive)
+{
+    if(archive.len < sizeof(oc_archive_header))
+    {
+        return (false);
+    }
+
+    oc_archive_header* header = (oc_archive_header*)archive.ptr;
+    if(memcmp(header->magic, OC_ARCHIVE_MAGIC, sizeof(header->magic))
+       || header->version != OC_ARCHIVE_VERSION)
+    {
+        return (false);
+    }
+
+    u64 indexSize = (u64)header->entryCount * sizeof(oc_archive_entry);
+    if(header->indexOffset > archive.len
+       || indexSize > archive.len - header->indexOffset
+       || header->namesOffset > archive.len
+       || header->namesSize > archive.len - header->namesOffset
+       || (header->indexOffset & (_Alignof(oc_archive_entry) - 1)))
+    {
+        return (false);
+    }
+
+    //NOTE: check every entry once here, so that lookups don't need to
+    oc_archive_entry* entries = (oc_archive_entry*)(archive.ptr + header->indexOffset);
+    for(u32 i = 0; i < header->entryCount; i++)
+    {
+        oc_archive_entry* entry = &entries[i];
+        if((u64)entry->nameOffset + entry->nameLen > header->namesSize
+           || entry->offset > archive.len
+           || entry->storedSize > archive.len - entry->offset
+           || (i && entry->hash < entries[i - 1].hash))
+        {
+            return (false);
+        }
+
+        if(entry->compression == OC_ARCHIVE_COMPRESSION_NONE)
+        {
+            if(entry->chunkCount || entry->storedSize != entry->size)
+            {
+                return (false);
+            }
+        }
+        else if(entry->compression == OC_ARCHIVE_COMPRESSION_DEFLATE)
+        {
+            if(!oc_archive_validate_chunks(archive, entry))
+            {
+                return (false);
+            }
+        }
+        else
+        {
+            return (false);
+        }
+    }
+    return (true);
+}
+
+oc_archive_entry* oc_archive_find(oc_str8 archive, oc_str8 path)
+{
+    oc_archive_entry* result = 0;
+
+    oc_archive_header* header = (oc_archive_header*)archive.ptr;
+    oc_archive_entry* entries = (oc_archive_entry*)(archive.ptr + header->indexOffset);
+    char* names = archive.ptr + header->namesOffset;
+
+    u64 hash = oc_hash_xx64_string(path);
+
+    //NOTE: find the first entry with this hash
+    u32 lo = 0;
+    u32 hi = header->entryCount;
+    while(lo < hi)
+    {
+        u32 mid = lo + (hi - lo) / 2;
+        if(entries[mid].hash < hash)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    for(u32 i = lo; i < header->entryCount && entries[i].hash == hash; i++)
+    {
+        oc_archive_entry* entry = &entries[i];
+        oc_str8 name = oc_str8_from_buffer(entry->nameLen, names + entry->nameOffset);
+        if(!oc_str8_cmp(name, path))
+        {
+            result = entry;
+            break;
+        }
+    }
+    return (result);
+}
+
+//------------------------------------------------------------------------------
+// Compressed entries
+//------------------------------------------------------------------------------
+/*NOTE:
+    Files opened on a deflate entry keep a small cache of decoded chunks, so that sequential reads with small
+    buffers decode each chunk once, and reads that straddle a chunk boundary don't evict the chunk they
+    started in. The cache lives as long as the file. Reads on a file are serialized by the file table lock.
+*/
+
+enum
+{
+    OC_ARCHIVE_CHUNK_CACHE_SIZE = 2,
+};
+
+typedef struct oc_archive_chunk_cache_entry
+{
+    u32 chunk;
+    u32 size; // decoded size, or 0 if the entry is empty
+    u64 lastUse;
+    char* data;
+} oc_archive_chunk_cache_entry;
+
+typedef struct oc_archive_reader
+{
+    oc_str8 archive;
+    oc_archive_entry* entry;
+    u64 useCount;
+    oc_archive_chunk_cache_entry cache[OC_ARCHIVE_CHUNK_CACHE_SIZE];
+} oc_archive_reader;
+
+static void oc_archive_reader_close(void* user)
+{
+    oc_archive_reader* reader = (oc_archive_reader*)user;
+    for(u32 i = 0; i < OC_ARCHIVE_CHUNK_CACHE_SIZE; i++)
+    {
+        free(reader->cache[i].data);
+    }
+    free(reader);
+}
+
+static oc_archive_chunk_cache_entry* oc_archive_reader_get_chunk(oc_archive_reader* reader, u32 chunk, oc_io_error* error)
+{
+    reader->useCount++;
+
+    oc_archive_chunk_cache_entry* victim = &reader->cache[0];
+    for(u32 i = 0; i < OC_ARCHIVE_CHUNK_CACHE_SIZE; i++)
+    {
+        oc_archive_chunk_cache_entry* cached = &reader->cache[i];
+        if(cached->size && cached->chunk == chunk)
+        {
+            cached->lastUse = reader->useCount;
+            return (cached);
+        }
+        if(cached->lastUse < victim->lastUse)
+        {
+            victim = cached;
+        }
+    }
+
+    //NOTE: decode the chunk into the least recently used cache entry
+    oc_archive_entry* entry = reader->entry;
+    u64 chunkStart = (u64)chunk * OC_ARCHIVE_CHUNK_SIZE;
+    u64 expectedSize = oc_min(entry->size - chunkStart, OC_ARCHIVE_CHUNK_SIZE);
+
+    if(!victim->data)
+    {
+        victim->data = malloc(OC_ARCHIVE_CHUNK_SIZE);
+        if(!victim->data)
+        {
+            *error = OC_IO_ERR_MEM;
+            return (0);
+        }
+    }
+
+    char* stored = reader->archive.ptr + entry->offset;
+    u64* chunkOffsets = (u64*)stored;
+
+    uLongf decodedSize = expectedSize;
+    int status = uncompress((Bytef*)victim->data,
+                            &decodedSize,
+                            (Bytef*)(stored + chunkOffsets[chunk]),
+                            chunkOffsets[chunk + 1] - chunkOffsets[chunk]);
+
+    if(status != Z_OK || decodedSize != expectedSize)
+    {
+        oc_log_error("corrupted chunk %u in data archive entry (zlib status %i)\n", chunk, status);
+        victim->size = 0;
+        *error = OC_IO_ERR_PHYSICAL;
+        return (0);
+    }
+
+    victim->chunk = chunk;
+    victim->size = decodedSize;
+    victim->lastUse = reader->useCount;
+    return (victim);
+}
+
+static u64 oc_archive_reader_read(void* user, u64 offset, char* buffer, u64 size, oc_io_error* error)
+{
+    oc_archive_reader* reader = (oc_archive_reader*)user;
+
+    u64 count = 0;
+    while(count < size)
+    {
+        u64 pos = offset + count;
+        u32 chunk = pos / OC_ARCHIVE_CHUNK_SIZE;
+        u64 chunkOffset = pos % OC_ARCHIVE_CHUNK_SIZE;
+
+        oc_archive_chunk_cache_entry* cached = oc_archive_reader_get_chunk(reader, chunk, error);
+        if(!cached)
+        {
+            break;
+        }
+
+        u64 copySize = oc_min(cached->size - chunkOffset, size - count);
+        memcpy(buffer + count, cached->data + chunkOffset, copySize);
+        count += copySize;
+    }
+    return (count);
+}
+
+oc_io_cmp oc_archive_open_entry(oc_str8 archive, oc_archive_entry* entry, oc_file_table* table)
+{
+    oc_io_cmp cmp = { 0 };
+
+    if(entry->compression == OC_ARCHIVE_COMPRESSION_NONE)
+    {
+        cmp = oc_io_open_memory_for_table(oc_str8_from_buffer(entry->size, archive.ptr + entry->offset), table);
+    }
+    else
+    {
+        oc_archive_reader* reader = calloc(1, sizeof(oc_archive_reader));
+        if(!reader)
+        {
+            cmp.error = OC_IO_ERR_MEM;
+        }
+        else
+        {
+            reader->archive = archive;
+            reader->entry = entry;
+
+            oc_io_memory_source source = {
+                .size = entry->size,
+                .user = reader,
+                .read = oc_archive_reader_read,
+                .close = oc_archive_reader_close,
+            };
+            cmp = oc_io_open_memory_source_for_table(&source, table);
+        }
+    }
+    return (cmp);
+}
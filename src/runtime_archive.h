@@ -0,0 +1,90 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "util/strings.h"
+#include "util/typedefs.h"
+
+//------------------------------------------------------------------------------
+// Data archive format
+//------------------------------------------------------------------------------
+/*NOTE:
+    A data archive packs the app's data directory into a single file, produced by `orca bundle --data-archive`.
+    It is laid out as:
+
+        oc_archive_header
+        oc_archive_entry[entryCount]    sorted by (hash, name)
+        names                           concatenated entry names, not null-terminated
+        file contents
+
+    All values are little-endian. Names are relative to the data directory, with '/' separators, and hashed
+    with oc_hash_xx64_string(). Offsets are relative to the start of the archive.
+
+    Uncompressed entries store their contents as is, and storedSize equals size. Deflate entries are split in
+    chunks of OC_ARCHIVE_CHUNK_SIZE bytes that are compressed independently as zlib streams, so that reads at
+    any offset only decode the chunks they touch. Their stored data is laid out as:
+
+        u64[chunkCount + 1]             chunk offsets, relative to the entry's offset. The last one is storedSize.
+        compressed chunks
+*/
+
+#define OC_ARCHIVE_MAGIC "ORCADATA"
+
+enum
+{
+    OC_ARCHIVE_VERSION = 2,
+    OC_ARCHIVE_ALIGNMENT = 16,
+    OC_ARCHIVE_CHUNK_SIZE = 64 << 10,
+};
+
+typedef enum oc_archive_compression
+{
+    OC_ARCHIVE_COMPRESSION_NONE = 0,
+    OC_ARCHIVE_COMPRESSION_DEFLATE = 1,
+} oc_archive_compression;
+
+typedef struct oc_archive_header
+{
+    char magic[8];
+    u32 version;
+    u32 entryCount;
+    u64 indexOffset;
+    u64 namesOffset;
+    u64 namesSize;
+
+} oc_archive_header;
+
+typedef struct oc_archive_entry
+{
+    u64 hash;
+    u32 nameOffset; // relative to namesOffset
+    u32 nameLen;
+    u64 offset;
+    u64 size; // uncompressed size
+    u32 compression;
+    u32 chunkCount; // number of compressed chunks, or 0 for uncompressed entries
+    u64 storedSize; // size of the data stored at offset
+
+} oc_archive_entry;
+
+#if !defined(OC_PLATFORM_ORCA) || !(OC_PLATFORM_ORCA)
+
+//NOTE: checks the header and index of a mapped archive. Returns false if it is malformed.
+bool oc_archive_validate(oc_str8 archive);
+
+//NOTE: returns the entry of the file at path in a validated archive, or null if there is no such file.
+oc_archive_entry* oc_archive_find(oc_str8 archive, oc_str8 path);
+
+typedef struct oc_file_table oc_file_table;
+typedef struct oc_io_cmp oc_io_cmp;
+
+//NOTE: opens a read-only file in table that serves reads from an entry of a validated archive, decoding
+//      compressed entries on demand. The archive must stay mapped until the file is closed.
+oc_io_cmp oc_archive_open_entry(oc_str8 archive, oc_archive_entry* entry, oc_file_table* table);
+
+#endif
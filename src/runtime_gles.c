@@ -0,0 +1,298 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include "runtime_gles.h"
+#include "graphics/gles_surface.h"
+#include "wasmbind/gles_api_replay_gen.c"
+
+static void oc_gles_job_execute(oc_gles_job* job)
+{
+    switch(job->kind)
+    {
+        case OC_GLES_JOB_COMMANDS:
+            if(!oc_gles_command_buffer_replay(job->words, job->wordCount))
+            {
+                oc_log_error("invalid command in GLES command buffer, dropping the rest of the buffer\n");
+            }
+            break;
+
+        case OC_GLES_JOB_MAKE_CURRENT:
+            oc_gles_surface_make_current(job->surface);
+            break;
+
+        case OC_GLES_JOB_RELEASE:
+            oc_gles_surface_make_current(oc_surface_nil());
+            break;
+
+        case OC_GLES_JOB_SWAP_BUFFERS:
+            oc_gles_surface_swap_buffers(job->surface);
+            break;
+
+        case OC_GLES_JOB_BUFFER_SUB_DATA:
+            glBufferSubData(job->target, job->bufferOffset, job->size, job->data);
+            break;
+    }
+}
+
+static i32 oc_gles_thread_proc(void* user)
+{
+    oc_gles_thread* glesThread = (oc_gles_thread*)user;
+
+    oc_mutex_lock(glesThread->mutex);
+    while(1)
+    {
+        oc_gles_job* job = oc_list_pop_front_entry(&glesThread->pending, oc_gles_job, listElt);
+        if(!job)
+        {
+            if(glesThread->quit)
+            {
+                break;
+            }
+            oc_condition_wait(glesThread->workCondition, glesThread->mutex);
+            continue;
+        }
+        oc_mutex_unlock(glesThread->mutex);
+
+        OC_TRACE_BEGIN("gles job");
+        oc_gles_job_execute(job);
+        OC_TRACE_END();
+
+        oc_mutex_lock(glesThread->mutex);
+        glesThread->doneSerial = job->serial;
+        if(job->kind == OC_GLES_JOB_SWAP_BUFFERS)
+        {
+            glesThread->framesInFlight--;
+        }
+        oc_list_push_front(&glesThread->freeJobs, &job->listElt);
+        oc_condition_broadcast(glesThread->doneCondition);
+    }
+    oc_mutex_unlock(glesThread->mutex);
+
+    oc_gles_surface_make_current(oc_surface_nil());
+    return (0);
+}
+
+void oc_gles_thread_start(oc_gles_thread* glesThread)
+{
+    memset(glesThread, 0, sizeof(oc_gles_thread));
+    glesThread->mutex = oc_mutex_create();
+    glesThread->workCondition = oc_condition_create();
+    glesThread->doneCondition = oc_condition_create();
+    oc_list_init(&glesThread->pending);
+    oc_list_init(&glesThread->freeJobs);
+    glesThread->nextSerial = 1;
+    glesThread->surface = oc_surface_nil();
+
+    oc_thread_options threadOptions = {
+        .name = OC_STR8("gles"),
+        .priority = OC_THREAD_PRIORITY_FRAME,
+    };
+    glesThread->thread = oc_thread_create_with_options(oc_gles_thread_proc, glesThread, &threadOptions);
+    glesThread->enabled = true;
+}
+
+void oc_gles_thread_stop(oc_gles_thread* glesThread)
+{
+    if(!glesThread->enabled)
+    {
+        return;
+    }
+
+    //NOTE: the thread executes the jobs that are still queued and releases the context before exiting
+    oc_mutex_lock(glesThread->mutex);
+    glesThread->quit = true;
+    oc_condition_signal(glesThread->workCondition);
+    oc_mutex_unlock(glesThread->mutex);
+
+    oc_thread_join(glesThread->thread, 0);
+
+    oc_list_for_safe(glesThread->freeJobs, job, oc_gles_job, listElt)
+    {
+        free(job->words);
+        free(job);
+    }
+    oc_condition_destroy(glesThread->workCondition);
+    oc_condition_destroy(glesThread->doneCondition);
+    oc_mutex_destroy(glesThread->mutex);
+
+    memset(glesThread, 0, sizeof(oc_gles_thread));
+}
+
+static oc_gles_job* oc_gles_job_alloc(oc_gles_thread* glesThread, oc_gles_job_kind kind)
+{
+    oc_mutex_lock(glesThread->mutex);
+    oc_gles_job* job = oc_list_pop_front_entry(&glesThread->freeJobs, oc_gles_job, listElt);
+    oc_mutex_unlock(glesThread->mutex);
+
+    if(!job)
+    {
+        job = oc_malloc_type(oc_gles_job);
+        memset(job, 0, sizeof(oc_gles_job));
+    }
+
+    u32* words = job->words;
+    u32 wordCap = job->wordCap;
+    memset(job, 0, sizeof(oc_gles_job));
+    job->words = words;
+    job->wordCap = wordCap;
+    job->kind = kind;
+
+    return (job);
+}
+
+static u64 oc_gles_job_push(oc_gles_thread* glesThread, oc_gles_job* job)
+{
+    oc_mutex_lock(glesThread->mutex);
+    job->serial = glesThread->nextSerial;
+    glesThread->nextSerial++;
+    if(job->kind == OC_GLES_JOB_SWAP_BUFFERS)
+    {
+        glesThread->framesInFlight++;
+    }
+    oc_list_push_back(&glesThread->pending, &job->listElt);
+    oc_condition_signal(glesThread->workCondition);
+    oc_mutex_unlock(glesThread->mutex);
+
+    return (job->serial);
+}
+
+static void oc_gles_thread_wait(oc_gles_thread* glesThread, u64 serial)
+{
+    oc_mutex_lock(glesThread->mutex);
+    while(glesThread->doneSerial < serial)
+    {
+        oc_condition_wait(glesThread->doneCondition, glesThread->mutex);
+    }
+    oc_mutex_unlock(glesThread->mutex);
+}
+
+//NOTE: moves the context from the GL thread to the runloop, and returns the time spent waiting for it
+static f64 oc_gles_thread_take_context(oc_gles_thread* glesThread)
+{
+    f64 start = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+    u64 serial = oc_gles_job_push(glesThread, oc_gles_job_alloc(glesThread, OC_GLES_JOB_RELEASE));
+    oc_gles_thread_wait(glesThread, serial);
+    glesThread->threadOwnsContext = false;
+
+    return (oc_clock_time(OC_CLOCK_MONOTONIC) - start);
+}
+
+void oc_gles_thread_make_current(oc_gles_thread* glesThread, oc_surface surface)
+{
+    if(glesThread->threadOwnsContext)
+    {
+        oc_gles_thread_take_context(glesThread);
+    }
+    oc_gles_surface_make_current(surface);
+    glesThread->surface = surface;
+}
+
+void oc_gles_thread_submit(oc_gles_thread* glesThread, const u32* words, u32 wordCount)
+{
+    if(!glesThread->threadOwnsContext && !oc_surface_is_nil(glesThread->surface))
+    {
+        oc_gles_surface_make_current(oc_surface_nil());
+
+        oc_gles_job* job = oc_gles_job_alloc(glesThread, OC_GLES_JOB_MAKE_CURRENT);
+        job->surface = glesThread->surface;
+        oc_gles_job_push(glesThread, job);
+        glesThread->threadOwnsContext = true;
+    }
+
+    oc_gles_job* job = oc_gles_job_alloc(glesThread, OC_GLES_JOB_COMMANDS);
+    if(wordCount > job->wordCap)
+    {
+        u32 cap = oc_max(wordCount, 2 * job->wordCap);
+        u32* newWords = realloc(job->words, cap * sizeof(u32));
+        if(!newWords)
+        {
+            //NOTE: the job still runs, with no commands
+            oc_log_error("couldn't allocate GLES job commands\n");
+            wordCount = 0;
+        }
+        else
+        {
+            job->words = newWords;
+            job->wordCap = cap;
+        }
+    }
+    memcpy(job->words, words, wordCount * sizeof(u32));
+    job->wordCount = wordCount;
+    oc_gles_job_push(glesThread, job);
+
+    glesThread->stats.submitCount++;
+    glesThread->stats.submitWords += wordCount;
+}
+
+void oc_gles_thread_swap_buffers(oc_gles_thread* glesThread, oc_surface surface)
+{
+    if(glesThread->threadOwnsContext)
+    {
+        oc_gles_job* job = oc_gles_job_alloc(glesThread, OC_GLES_JOB_SWAP_BUFFERS);
+        job->surface = surface;
+        oc_gles_job_push(glesThread, job);
+    }
+    else
+    {
+        oc_gles_surface_swap_buffers(surface);
+    }
+}
+
+void oc_gles_thread_buffer_sub_data(oc_gles_thread* glesThread, u32 target, u32 bufferOffset, u32 size, const void* data)
+{
+    if(glesThread->threadOwnsContext)
+    {
+        oc_gles_job* job = oc_gles_job_alloc(glesThread, OC_GLES_JOB_BUFFER_SUB_DATA);
+        job->target = target;
+        job->bufferOffset = bufferOffset;
+        job->size = size;
+        job->data = data;
+        oc_gles_job_push(glesThread, job);
+    }
+    else
+    {
+        glBufferSubData(target, bufferOffset, size, data);
+    }
+}
+
+void oc_gles_thread_acquire(oc_gles_thread* glesThread)
+{
+    if(glesThread->threadOwnsContext)
+    {
+        glesThread->stats.stallTime += oc_gles_thread_take_context(glesThread);
+        glesThread->stats.stallCount++;
+        oc_gles_surface_make_current(glesThread->surface);
+    }
+}
+
+void oc_gles_thread_wait_frames(oc_gles_thread* glesThread, u32 maxFrames)
+{
+    if(!glesThread->enabled)
+    {
+        return;
+    }
+    oc_mutex_lock(glesThread->mutex);
+    while(glesThread->framesInFlight > maxFrames)
+    {
+        oc_condition_wait(glesThread->doneCondition, glesThread->mutex);
+    }
+    oc_mutex_unlock(glesThread->mutex);
+}
+
+void oc_gles_thread_sync(oc_gles_thread* glesThread)
+{
+    if(!glesThread->enabled)
+    {
+        return;
+    }
+    oc_mutex_lock(glesThread->mutex);
+    u64 serial = glesThread->nextSerial - 1;
+    oc_mutex_unlock(glesThread->mutex);
+
+    oc_gles_thread_wait(glesThread, serial);
+}
@@ -0,0 +1,98 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "graphics/graphics.h"
+#include "platform/platform_thread.h"
+
+/*NOTE:
+	In GLES thread mode, the GL commands recorded by guests built with OC_GLES_COMMAND_BUFFER are replayed on a
+	dedicated thread, which owns the guest's GLES context. Flushes copy the recorded commands into a job, so the
+	runloop can go back to interpreting the guest while the driver executes them.
+
+	GL calls that aren't recorded (queries, uploads from guest memory, ...) still run on the runloop. Before them,
+	oc_gles_thread_acquire() waits for the queued jobs and moves the context back to the runloop. This is a stall,
+	which is counted in the thread's stats. The context moves to the GL thread again at the next submission.
+
+	Guests that don't record commands never submit anything, so their context stays on the runloop.
+*/
+typedef enum oc_gles_job_kind
+{
+    OC_GLES_JOB_COMMANDS,
+    OC_GLES_JOB_MAKE_CURRENT,
+    OC_GLES_JOB_RELEASE,
+    OC_GLES_JOB_SWAP_BUFFERS,
+    OC_GLES_JOB_BUFFER_SUB_DATA,
+} oc_gles_job_kind;
+
+typedef struct oc_gles_job
+{
+    oc_list_elt listElt;
+    oc_gles_job_kind kind;
+    u64 serial;
+    oc_surface surface;
+
+    //NOTE: buffer upload from an upload region, which is read in place
+    u32 target;
+    u32 bufferOffset;
+    u32 size;
+    const void* data;
+
+    //NOTE: copy of the recorded commands. It is kept when the job is recycled.
+    u32 wordCount;
+    u32 wordCap;
+    u32* words;
+
+} oc_gles_job;
+
+typedef struct oc_gles_thread_stats
+{
+    u64 submitCount;
+    u64 submitWords;
+    u64 stallCount; // number of times the runloop had to wait for the GL thread to run a synchronous GL call
+    f64 stallTime;
+} oc_gles_thread_stats;
+
+typedef struct oc_gles_thread
+{
+    bool enabled;
+    oc_thread* thread;
+    oc_mutex* mutex;
+    oc_condition* workCondition;
+    oc_condition* doneCondition;
+
+    oc_list pending;
+    oc_list freeJobs;
+    u64 nextSerial;
+    u64 doneSerial;
+    u32 framesInFlight; // swaps that were queued but not executed yet
+    bool quit;
+
+    //NOTE: only accessed by the runloop
+    oc_surface surface; // surface made current by the guest
+    bool threadOwnsContext;
+    oc_gles_thread_stats stats;
+
+} oc_gles_thread;
+
+void oc_gles_thread_start(oc_gles_thread* glesThread);
+void oc_gles_thread_stop(oc_gles_thread* glesThread);
+
+void oc_gles_thread_make_current(oc_gles_thread* glesThread, oc_surface surface);
+void oc_gles_thread_submit(oc_gles_thread* glesThread, const u32* words, u32 wordCount);
+void oc_gles_thread_swap_buffers(oc_gles_thread* glesThread, oc_surface surface);
+void oc_gles_thread_buffer_sub_data(oc_gles_thread* glesThread, u32 target, u32 bufferOffset, u32 size, const void* data);
+
+//NOTE: makes the guest's context current on the runloop, waiting for queued commands if the GL thread owns it
+void oc_gles_thread_acquire(oc_gles_thread* glesThread);
+
+//NOTE: waits until at most maxFrames swaps are queued
+void oc_gles_thread_wait_frames(oc_gles_thread* glesThread, u32 maxFrames);
+
+//NOTE: waits until all queued jobs are done, e.g. before freeing memory they read
+void oc_gles_thread_sync(oc_gles_thread* glesThread);
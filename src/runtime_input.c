@@ -0,0 +1,210 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+
+#include "runtime_input.h"
+
+//NOTE: the file starts with a header, followed by raw records. Events are written as is, so a recording can only be
+//      replayed by a runtime with the same event layout, which the header's event size helps check.
+typedef struct oc_runtime_input_header
+{
+    char magic[4];
+    u32 version;
+    u32 recordSize;
+    u32 eventSize;
+} oc_runtime_input_header;
+
+static const char OC_RUNTIME_INPUT_MAGIC[4] = { 'O', 'C', 'I', 'N' };
+
+enum
+{
+    OC_RUNTIME_INPUT_VERSION = 1,
+};
+
+static bool oc_runtime_input_open(oc_runtime_input* input, oc_str8 path, const char* mode)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+    const char* pathCStr = oc_str8_to_cstring(scratch.arena, path);
+
+    input->file = fopen(pathCStr, mode);
+    if(!input->file)
+    {
+        oc_log_error("Could not open input recording '%s': %s\n", pathCStr, strerror(errno));
+    }
+    oc_scratch_end(scratch);
+    return (input->file != 0);
+}
+
+bool oc_runtime_input_record_begin(oc_runtime_input* input, oc_str8 path)
+{
+    if(!oc_runtime_input_open(input, path, "wb"))
+    {
+        return (false);
+    }
+    oc_runtime_input_header header = {
+        .version = OC_RUNTIME_INPUT_VERSION,
+        .recordSize = sizeof(oc_runtime_input_record),
+        .eventSize = sizeof(oc_event),
+    };
+    memcpy(header.magic, OC_RUNTIME_INPUT_MAGIC, sizeof(header.magic));
+    fwrite(&header, sizeof(header), 1, input->file);
+
+    input->mode = OC_RUNTIME_INPUT_RECORD;
+    input->startTime = oc_clock_time(OC_CLOCK_MONOTONIC);
+    input->eventCount = 0;
+
+    oc_log_info("recording input\n");
+    return (true);
+}
+
+void oc_runtime_input_record_event(oc_runtime_input* input, oc_event* event, u32 appIndex)
+{
+    if(input->mode != OC_RUNTIME_INPUT_RECORD)
+    {
+        return;
+    }
+    switch(event->type)
+    {
+        case OC_EVENT_PATHDROP:
+        case OC_EVENT_FILE_CHANGE:
+        case OC_EVENT_FETCH:
+            return;
+
+        default:
+            break;
+    }
+
+    oc_runtime_input_record record = {
+        .time = oc_clock_time(OC_CLOCK_MONOTONIC) - input->startTime,
+        .appIndex = appIndex,
+        .event = *event,
+    };
+    record.event.window = oc_window_null_handle();
+    fwrite(&record, sizeof(record), 1, input->file);
+    input->eventCount++;
+}
+
+static void oc_runtime_input_read_next(oc_runtime_input* input)
+{
+    input->hasNext = (fread(&input->next, sizeof(input->next), 1, input->file) == 1);
+}
+
+bool oc_runtime_input_replay_begin(oc_runtime_input* input, oc_str8 path, f64 timeStep)
+{
+    if(!oc_runtime_input_open(input, path, "rb"))
+    {
+        return (false);
+    }
+
+    oc_runtime_input_header header = { 0 };
+    if(fread(&header, sizeof(header), 1, input->file) != 1
+       || memcmp(header.magic, OC_RUNTIME_INPUT_MAGIC, sizeof(header.magic))
+       || header.version != OC_RUNTIME_INPUT_VERSION
+       || header.recordSize != sizeof(oc_runtime_input_record)
+       || header.eventSize != sizeof(oc_event))
+    {
+        oc_log_error("Input recording '%.*s' isn't a recording, or was made by an incompatible runtime\n", oc_str8_ip(path));
+        fclose(input->file);
+        input->file = 0;
+        return (false);
+    }
+
+    input->mode = OC_RUNTIME_INPUT_REPLAY;
+    input->startTime = oc_clock_time(OC_CLOCK_MONOTONIC);
+    input->timeStep = timeStep;
+    input->frameCount = 0;
+    input->eventCount = 0;
+    oc_runtime_input_read_next(input);
+
+    oc_log_info("replaying input with a time step of %.2fms\n", timeStep * 1000);
+    return (true);
+}
+
+void oc_runtime_input_replay_frame_begin(oc_runtime_input* input)
+{
+    input->frameCount++;
+    input->frameStart = oc_clock_time(OC_CLOCK_MONOTONIC);
+}
+
+void oc_runtime_input_replay_frame_end(oc_runtime_input* input)
+{
+    f64 frameTime = oc_clock_time(OC_CLOCK_MONOTONIC) - input->frameStart;
+    input->frameTimeSum += frameTime;
+    input->frameTimeMin = (input->frameCount == 1) ? frameTime : oc_min(input->frameTimeMin, frameTime);
+    input->frameTimeMax = oc_max(input->frameTimeMax, frameTime);
+}
+
+oc_runtime_input_record* oc_runtime_input_replay_next(oc_runtime_input* input, oc_arena* arena)
+{
+    oc_runtime_input_record* record = 0;
+    if(input->hasNext && input->next.time < input->frameCount * input->timeStep)
+    {
+        record = oc_arena_push_type(arena, oc_runtime_input_record);
+        *record = input->next;
+        input->eventCount++;
+        oc_runtime_input_read_next(input);
+    }
+    return (record);
+}
+
+bool oc_runtime_input_replay_done(oc_runtime_input* input)
+{
+    return (!input->hasNext);
+}
+
+f64 oc_runtime_input_replay_time(oc_runtime_input* input)
+{
+    return (input->startTime + input->frameCount * input->timeStep);
+}
+
+void oc_runtime_input_end(oc_runtime_input* input, oc_str8 reportPath)
+{
+    if(input->mode == OC_RUNTIME_INPUT_RECORD)
+    {
+        oc_log_info("recorded %llu input events\n", (unsigned long long)input->eventCount);
+    }
+    else if(input->mode == OC_RUNTIME_INPUT_REPLAY)
+    {
+        f64 total = oc_clock_time(OC_CLOCK_MONOTONIC) - input->startTime;
+        f64 frameAvg = input->frameCount ? input->frameTimeSum / input->frameCount : 0;
+
+        oc_log_info("replayed %llu input events in %llu frames, in %.1fms (%.3fms per frame)\n",
+                    (unsigned long long)input->eventCount,
+                    (unsigned long long)input->frameCount,
+                    total * 1000,
+                    frameAvg * 1000);
+
+        oc_arena_scope scratch = oc_scratch_begin();
+        const char* pathCStr = oc_str8_to_cstring(scratch.arena, reportPath);
+        FILE* file = fopen(pathCStr, "w");
+        if(!file)
+        {
+            oc_log_error("Could not open replay report file '%s': %s\n", pathCStr, strerror(errno));
+        }
+        else
+        {
+            //NOTE: durations are in milliseconds
+            fprintf(file,
+                    "{\"version\":1,\"frames\":%llu,\"events\":%llu,\"total\":%.3f,"
+                    "\"frame\":{\"avg\":%.3f,\"min\":%.3f,\"max\":%.3f}}\n",
+                    (unsigned long long)input->frameCount,
+                    (unsigned long long)input->eventCount,
+                    total * 1000,
+                    frameAvg * 1000,
+                    input->frameTimeMin * 1000,
+                    input->frameTimeMax * 1000);
+            fclose(file);
+        }
+        oc_scratch_end(scratch);
+    }
+    if(input->file)
+    {
+        fclose(input->file);
+        input->file = 0;
+    }
+    input->mode = OC_RUNTIME_INPUT_LIVE;
+}
@@ -0,0 +1,80 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "orca.h"
+
+/*NOTE: input recording and replay.
+	With --record-input, the runtime writes the events it gets from oc_next_event() to a file, with their arrival
+	time. With --replay-input, it ignores real input and dispatches the recorded events instead. Frames then run
+	back to back, without waiting for vsync, at a fixed time step. The guest sees time advance by that step each
+	frame, through its frame info and oc_clock_time(), so a session replays identically from one run to the next
+	and can be used to benchmark the same interaction before and after a change.
+
+	Events are recorded with the index of the app whose window they target, and are sent back to that app's window
+	when replayed. Path drops, file changes and fetch completions aren't recorded: the first carry pointers, and the
+	others are results of the guest's own requests, which a replay makes again.
+*/
+typedef enum oc_runtime_input_mode
+{
+    OC_RUNTIME_INPUT_LIVE = 0,
+    OC_RUNTIME_INPUT_RECORD,
+    OC_RUNTIME_INPUT_REPLAY,
+} oc_runtime_input_mode;
+
+enum
+{
+    OC_RUNTIME_INPUT_NO_APP = 0xffffffff,
+};
+
+typedef struct oc_runtime_input_record
+{
+    f64 time;     // seconds since the start of the recording
+    u32 appIndex; // app whose window gets the event, or OC_RUNTIME_INPUT_NO_APP
+    u32 reserved;
+    oc_event event; // the window is replaced by the app's window when replayed
+} oc_runtime_input_record;
+
+typedef struct oc_runtime_input
+{
+    oc_runtime_input_mode mode;
+    FILE* file;
+    f64 startTime;
+
+    f64 timeStep; // seconds per replayed frame
+    u64 frameCount;
+    u64 eventCount;
+    bool hasNext;
+    oc_runtime_input_record next;
+
+    //NOTE: wall clock time of replayed frames, in seconds
+    f64 frameStart;
+    f64 frameTimeSum;
+    f64 frameTimeMin;
+    f64 frameTimeMax;
+
+} oc_runtime_input;
+
+bool oc_runtime_input_record_begin(oc_runtime_input* input, oc_str8 path);
+void oc_runtime_input_record_event(oc_runtime_input* input, oc_event* event, u32 appIndex);
+
+bool oc_runtime_input_replay_begin(oc_runtime_input* input, oc_str8 path, f64 timeStep);
+//NOTE: advances the replay by one time step
+void oc_runtime_input_replay_frame_begin(oc_runtime_input* input);
+void oc_runtime_input_replay_frame_end(oc_runtime_input* input);
+//NOTE: returns the next event recorded before the current replay time, allocated in arena, or 0 once the frame has
+//      no more events
+oc_runtime_input_record* oc_runtime_input_replay_next(oc_runtime_input* input, oc_arena* arena);
+//NOTE: true once every recorded event has been replayed
+bool oc_runtime_input_replay_done(oc_runtime_input* input);
+//NOTE: the replay's virtual time, in seconds, which starts at the time the replay started
+f64 oc_runtime_input_replay_time(oc_runtime_input* input);
+
+//NOTE: ends recording or replay. After a replay, the number of frames and their wall clock times are written as JSON
+//      to reportPath.
+void oc_runtime_input_end(oc_runtime_input* input, oc_str8 reportPath);
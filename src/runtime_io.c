@@ -9,50 +9,240 @@
 #include "runtime.h"
 #include "runtime_memory.h"
 
-oc_io_cmp oc_bridge_io_wait_single_req(oc_io_req* wasmReq)
+//NOTE: converts a request coming from wasm to a native request. Returns an error if the request's buffer
+//      is out of bounds. The native vector array of vectored requests is allocated in arena.
+static oc_io_error oc_bridge_io_req_to_native(oc_arena* arena, oc_io_req* wasmReq, oc_io_req* req)
 {
     oc_runtime* orca = oc_runtime_get();
 
-    oc_io_cmp cmp = { 0 };
-    oc_io_req req = *wasmReq;
+    oc_io_error error = OC_IO_OK;
+    *req = *wasmReq;
 
     //TODO: lookup if operation needs a buffer in a compile-time table
     oc_io_op op = wasmReq->op;
     if(op == OC_IO_OPEN_AT
        || op == OC_IO_FSTAT
        || op == OC_IO_READ
-       || op == OC_IO_WRITE)
+       || op == OC_IO_WRITE
+       || op == OC_IO_PREAD
+       || op == OC_IO_PWRITE
+       || op == OC_IO_READDIR
+       || op == OC_IO_READ_CHANGES)
     {
         //TODO have a separate oc_wasm_io_req struct, and marshall between wasm/native versions
-        void* buffer = oc_wasm_address_to_ptr((oc_wasm_addr)(uintptr_t)req.buffer, req.size);
+        void* buffer = oc_wasm_address_to_ptr((oc_wasm_addr)(uintptr_t)req->buffer, req->size);
         if(buffer)
         {
-            req.buffer = buffer;
+            req->buffer = buffer;
 
             //TODO: lookup in a compile-time table which operations use a 'at' handle that must be replaced by root handle if 0.
-            if(req.op == OC_IO_OPEN_AT)
+            if(req->op == OC_IO_OPEN_AT)
             {
-                if(req.handle.h == 0)
+                if(req->handle.h == 0)
                 {
                     //NOTE: change root to app local folder
-                    req.handle = orca->rootDir;
+                    req->handle = orca->rootDir;
                 }
-                req.open.flags |= OC_FILE_OPEN_RESTRICT;
+                req->open.flags |= OC_FILE_OPEN_RESTRICT;
             }
         }
         else
         {
-            cmp.error = OC_IO_ERR_ARG;
+            error = OC_IO_ERR_ARG;
+        }
+    }
+    else if(op == OC_IO_PREADV || op == OC_IO_PWRITEV)
+    {
+        oc_io_vec* wasmVecs = 0;
+        if(req->size <= UINT32_MAX / sizeof(oc_io_vec))
+        {
+            wasmVecs = oc_wasm_address_to_ptr((oc_wasm_addr)(uintptr_t)req->buffer, req->size * sizeof(oc_io_vec));
+        }
+
+        if(wasmVecs)
+        {
+            oc_io_vec* vecs = oc_arena_push_array(arena, oc_io_vec, req->size);
+            for(u64 i = 0; i < req->size; i++)
+            {
+                vecs[i].size = wasmVecs[i].size;
+                vecs[i].buffer = oc_wasm_address_to_ptr((oc_wasm_addr)(uintptr_t)wasmVecs[i].buffer, wasmVecs[i].size);
+                if(!vecs[i].buffer && vecs[i].size)
+                {
+                    error = OC_IO_ERR_ARG;
+                    break;
+                }
+            }
+            req->buffer = (char*)vecs;
+        }
+        else
+        {
+            error = OC_IO_ERR_ARG;
+        }
+    }
+    return (error);
+}
+
+//NOTE: read-only opens of paths relative to the app root are served from the data archive when it contains them
+static oc_archive_entry* oc_bridge_io_find_archived(oc_io_req* req)
+{
+    oc_runtime* orca = oc_runtime_get();
+
+    if(!orca->dataArchive.len
+       || req->op != OC_IO_OPEN_AT
+       || req->handle.h != orca->rootDir.h
+       || req->open.rights != OC_FILE_ACCESS_READ
+       || (req->open.flags & (OC_FILE_OPEN_CREATE | OC_FILE_OPEN_TRUNCATE | OC_FILE_OPEN_APPEND | OC_FILE_OPEN_SYMLINK)))
+    {
+        return (0);
+    }
+
+    oc_archive_entry* entry = 0;
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    //NOTE: normalize the path the same way the archive names are built. Paths that walk up are left to the
+    //      restricted open, which rejects those that escape the root.
+    oc_str8_list elements = oc_path_split(scratch.arena, oc_str8_from_buffer(req->size, req->buffer));
+    oc_str8_list normalized = { 0 };
+    bool walksUp = false;
+    oc_str8_list_for(elements, elt)
+    {
+        if(!oc_str8_cmp(elt->string, OC_STR8("..")))
+        {
+            walksUp = true;
+            break;
         }
+        else if(oc_str8_cmp(elt->string, OC_STR8(".")))
+        {
+            oc_str8_list_push(scratch.arena, &normalized, elt->string);
+        }
+    }
+    if(!walksUp && !oc_list_empty(normalized.list))
+    {
+        entry = oc_archive_find(orca->dataArchive, oc_path_join(scratch.arena, normalized));
     }
+
+    oc_scratch_end(scratch);
+    return (entry);
+}
+
+//NOTE: executes a native request. The caller must hold the file table lock.
+static oc_io_cmp oc_bridge_io_execute(oc_io_req* req)
+{
+    oc_runtime* orca = oc_runtime_get();
+
+    oc_io_cmp cmp = { 0 };
+    oc_archive_entry* entry = oc_bridge_io_find_archived(req);
+    if(entry)
+    {
+        cmp = oc_archive_open_entry(orca->dataArchive, entry, &orca->fileTable);
+    }
+    else
+    {
+        cmp = oc_io_wait_single_req_for_table(req, &orca->fileTable);
+    }
+    return (cmp);
+}
+
+oc_io_cmp oc_bridge_io_wait_single_req(oc_io_req* wasmReq)
+{
+    oc_runtime* orca = oc_runtime_get();
+
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_io_cmp cmp = { 0 };
+    oc_io_req req = { 0 };
+
+    cmp.error = oc_bridge_io_req_to_native(scratch.arena, wasmReq, &req);
     if(cmp.error == OC_IO_OK)
     {
-        cmp = oc_io_wait_single_req_for_table(&req, &orca->fileTable);
+        OC_TRACE_BEGIN("io request");
+        oc_io_queue_lock_table(orca->ioQueue);
+        cmp = oc_bridge_io_execute(&req);
+        oc_io_queue_unlock_table(orca->ioQueue);
+        OC_TRACE_END();
     }
 
+    oc_scratch_end(scratch);
     return (cmp);
 }
 
+void oc_bridge_io_wait_reqs(u32 count, oc_io_req* wasmReqs, oc_io_cmp* cmps)
+{
+    oc_runtime* orca = oc_runtime_get();
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    //NOTE: validate and convert the whole batch first, then execute the valid requests under a single table lock
+    oc_io_req* reqs = oc_arena_push_array(scratch.arena, oc_io_req, count);
+    for(u32 i = 0; i < count; i++)
+    {
+        memset(&cmps[i], 0, sizeof(oc_io_cmp));
+        cmps[i].id = wasmReqs[i].id;
+        cmps[i].error = oc_bridge_io_req_to_native(scratch.arena, &wasmReqs[i], &reqs[i]);
+    }
+
+    OC_TRACE_BEGIN("io batch");
+    oc_io_queue_lock_table(orca->ioQueue);
+    for(u32 i = 0; i < count; i++)
+    {
+        if(cmps[i].error == OC_IO_OK)
+        {
+            cmps[i] = oc_bridge_io_execute(&reqs[i]);
+            cmps[i].id = wasmReqs[i].id;
+        }
+    }
+    oc_io_queue_unlock_table(orca->ioQueue);
+    OC_TRACE_END();
+
+    oc_scratch_end(scratch);
+}
+
+u32 oc_bridge_io_submit(u32 count, oc_io_req* wasmReqs)
+{
+    oc_runtime* orca = oc_runtime_get();
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    for(u32 i = 0; i < count; i++)
+    {
+        oc_io_req req = { 0 };
+        oc_io_cmp cmp = { 0 };
+        oc_archive_entry* entry = 0;
+
+        cmp.error = oc_bridge_io_req_to_native(scratch.arena, &wasmReqs[i], &req);
+        if(cmp.error == OC_IO_OK && (entry = oc_bridge_io_find_archived(&req)))
+        {
+            //NOTE: archived files don't touch the file system, so open them right away. Compressed entries are
+            //      decoded lazily by later reads.
+            oc_io_queue_lock_table(orca->ioQueue);
+            cmp = oc_archive_open_entry(orca->dataArchive, entry, &orca->fileTable);
+            oc_io_queue_unlock_table(orca->ioQueue);
+
+            wasmReqs[i].id = oc_io_queue_submit_completion(orca->ioQueue, &cmp);
+        }
+        else if(cmp.error == OC_IO_OK)
+        {
+            wasmReqs[i].id = oc_io_queue_submit(orca->ioQueue, &req);
+        }
+        else
+        {
+            wasmReqs[i].id = oc_io_queue_submit_completion(orca->ioQueue, &cmp);
+        }
+    }
+
+    oc_scratch_end(scratch);
+    return (count);
+}
+
+u32 oc_bridge_io_wait(u32 max, oc_io_cmp* cmps, f64 timeout)
+{
+    oc_runtime* orca = oc_runtime_get();
+
+    OC_TRACE_BEGIN("io wait");
+    u32 count = oc_io_queue_wait(orca->ioQueue, max, cmps, timeout);
+    OC_TRACE_END();
+
+    return (count);
+}
+
 oc_file oc_file_open_with_request_bridge(oc_wasm_str8 path, oc_file_access rights, oc_file_open_flags flags)
 {
     oc_file file = oc_file_nil();
@@ -62,11 +252,94 @@ oc_file oc_file_open_with_request_bridge(oc_wasm_str8 path, oc_file_access right
 
     if(nativePath.ptr)
     {
+        oc_io_queue_lock_table(orca->ioQueue);
         file = oc_file_open_with_request_for_table(nativePath, rights, flags, &orca->fileTable);
+        oc_io_queue_unlock_table(orca->ioQueue);
     }
     return (file);
 }
 
+//NOTE: puts zeroed pages back over a region, so that the file isn't kept mapped while the region waits to be reused
+static void oc_bridge_release_mapping_region(oc_wasm_mapping_region* region)
+{
+    oc_str8 mem = oc_runtime_get_wasm_memory();
+    u64 granularity = oc_io_map_granularity();
+    char* start = (char*)oc_align_up_pow2((uintptr_t)(mem.ptr + region->addr), granularity);
+    char* end = (char*)oc_align_down_pow2((uintptr_t)(mem.ptr + region->addr + region->size), granularity);
+    if(start < end)
+    {
+        oc_io_unmap_fixed(start, end - start);
+    }
+    oc_wasm_mapping_region_release(region);
+}
+
+oc_wasm_str8 oc_file_map_bridge(oc_file file, i64 offset, u64 size)
+{
+    oc_runtime* orca = oc_runtime_get();
+    oc_wasm_str8 mapping = { 0 };
+
+    oc_io_queue_lock_table(orca->ioQueue);
+
+    //NOTE: clamp the size first, so that the region isn't sized after a range that runs past the end of the file
+    oc_file_status status = { 0 };
+    oc_io_req statReq = {
+        .op = OC_IO_FSTAT,
+        .handle = file,
+        .size = sizeof(oc_file_status),
+        .buffer = (char*)&status,
+    };
+    oc_io_cmp cmp = oc_io_wait_single_req_for_table(&statReq, &orca->fileTable);
+
+    u64 granularity = oc_io_map_granularity();
+    if(cmp.error == OC_IO_OK && offset >= 0 && (u64)offset < status.size)
+    {
+        size = oc_min(size, status.size - offset);
+    }
+    else
+    {
+        size = 0;
+    }
+
+    //NOTE: the region has room for a start address that lines up with offset on the mapping granularity
+    oc_wasm_mapping_region* region = 0;
+    if(size && size <= UINT32_MAX - 2 * granularity)
+    {
+        region = oc_wasm_mapping_region_acquire(size + granularity);
+    }
+    if(region)
+    {
+        oc_str8 mem = oc_runtime_get_wasm_memory();
+        char* base = mem.ptr + region->addr;
+        char* start = base + (((uintptr_t)offset - (uintptr_t)base) & (granularity - 1));
+
+        OC_TRACE_BEGIN("file map");
+        cmp = oc_io_map_at_for_table(file, offset, size, start, &orca->fileTable);
+        OC_TRACE_END();
+
+        if(cmp.error == OC_IO_OK && cmp.size)
+        {
+            mapping.ptr = start - mem.ptr;
+            mapping.len = cmp.size;
+        }
+        else
+        {
+            oc_bridge_release_mapping_region(region);
+        }
+    }
+
+    oc_io_queue_unlock_table(orca->ioQueue);
+    return (mapping);
+}
+
+void oc_file_unmap_bridge(oc_wasm_str8 mapping)
+{
+    oc_wasm_mapping_region* region = oc_wasm_mapping_region_find(mapping.ptr);
+    if(region)
+    {
+        oc_bridge_release_mapping_region(region);
+    }
+}
+
 typedef struct oc_wasm_file_dialog_desc
 {
     oc_file_dialog_kind kind;
@@ -136,7 +409,10 @@ oc_wasm_file_open_with_dialog_result oc_file_open_with_dialog_bridge(oc_wasm_add
         eltIndex = elt->listElt.next;
     }
 
+    //NOTE: the dialog is modal, so holding the table lock only stalls queued requests while it is shown
+    oc_io_queue_lock_table(orca->ioQueue);
     oc_file_open_with_dialog_result nativeResult = oc_file_open_with_dialog_for_table(scratch.arena, rights, flags, &nativeDesc, &orca->fileTable);
+    oc_io_queue_unlock_table(orca->ioQueue);
 
     oc_wasm_file_open_with_dialog_result result = {
         .button = nativeResult.button,
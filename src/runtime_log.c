@@ -0,0 +1,150 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include "runtime_log.h"
+
+enum
+{
+    OC_RUNTIME_LOG_RING_EXP = 20,
+};
+
+static const f64 OC_RUNTIME_LOG_FLUSH_TIMEOUT = 1; // seconds
+
+static i32 oc_runtime_log_thread_proc(void* user)
+{
+    oc_runtime_log* log = (oc_runtime_log*)user;
+
+    while(1)
+    {
+        oc_runtime_log_record* record = oc_mpsc_ringbuffer_peek(&log->ring, 0);
+        if(!record)
+        {
+            oc_mpsc_ringbuffer_wait(&log->ring, -1);
+            continue;
+        }
+
+        if(record->level == OC_LOG_LEVEL_COUNT)
+        {
+            oc_mpsc_ringbuffer_release(&log->ring);
+            break;
+        }
+
+        char* function = (char*)record + sizeof(oc_runtime_log_record);
+        char* file = function + record->functionLen + 1;
+        char* msg = file + record->fileLen + 1;
+
+        oc_log_ext(record->level, function, file, record->line, "%.*s\n", (int)record->msgLen, msg);
+
+        oc_mpsc_ringbuffer_release(&log->ring);
+        atomic_fetch_add(&log->writeCount, 1);
+    }
+    return (0);
+}
+
+void oc_runtime_log_start(oc_runtime_log* log)
+{
+    memset(log, 0, sizeof(oc_runtime_log));
+    oc_mpsc_ringbuffer_init(&log->ring, OC_RUNTIME_LOG_RING_EXP);
+    log->maxStringLen = (1ULL << OC_RUNTIME_LOG_RING_EXP) / 16;
+
+    log->thread = oc_thread_create_with_name(oc_runtime_log_thread_proc, log, OC_STR8("orca log"));
+    log->enabled = true;
+}
+
+static oc_runtime_log_record* oc_runtime_log_reserve(oc_runtime_log* log, u64 size)
+{
+    //NOTE: the ring is full, wait for the log thread to catch up rather than dropping the message
+    oc_runtime_log_record* record = 0;
+    while(!(record = oc_mpsc_ringbuffer_reserve(&log->ring, size)))
+    {
+        oc_sleep_nano(100000);
+    }
+    return (record);
+}
+
+void oc_runtime_log_stop(oc_runtime_log* log)
+{
+    if(!log->enabled)
+    {
+        return;
+    }
+
+    //NOTE: records are written in order, so the thread quits after the ones that are still pending
+    oc_runtime_log_record* record = oc_runtime_log_reserve(log, sizeof(oc_runtime_log_record));
+    *record = (oc_runtime_log_record){ .level = OC_LOG_LEVEL_COUNT };
+    oc_mpsc_ringbuffer_commit(&log->ring, record);
+
+    oc_thread_join(log->thread, 0);
+    oc_mpsc_ringbuffer_cleanup(&log->ring);
+
+    memset(log, 0, sizeof(oc_runtime_log));
+}
+
+void oc_runtime_log_push(oc_runtime_log* log, oc_log_level level, oc_str8 function, oc_str8 file, int line, oc_str8 msg)
+{
+    function.len = oc_min(function.len, log->maxStringLen);
+    file.len = oc_min(file.len, log->maxStringLen);
+    msg.len = oc_min(msg.len, log->maxStringLen);
+
+    u64 size = sizeof(oc_runtime_log_record) + function.len + file.len + msg.len + 3;
+    oc_runtime_log_record* record = oc_runtime_log_reserve(log, size);
+
+    *record = (oc_runtime_log_record){
+        .level = level,
+        .line = line,
+        .functionLen = function.len,
+        .fileLen = file.len,
+        .msgLen = msg.len,
+    };
+
+    char* payload = (char*)record + sizeof(oc_runtime_log_record);
+    memcpy(payload, function.ptr, function.len);
+    payload[function.len] = '\0';
+    payload += function.len + 1;
+
+    memcpy(payload, file.ptr, file.len);
+    payload[file.len] = '\0';
+    payload += file.len + 1;
+
+    memcpy(payload, msg.ptr, msg.len);
+    payload[msg.len] = '\0';
+
+    oc_mpsc_ringbuffer_commit(&log->ring, record);
+    atomic_fetch_add_explicit(&log->pushCount, 1, memory_order_relaxed);
+}
+
+void oc_runtime_log_flush(oc_runtime_log* log)
+{
+    //NOTE: the log thread can't wait for itself, e.g. when an assert fires while it writes a record
+    if(!log->enabled || oc_thread_self_id() == oc_thread_unique_id(log->thread))
+    {
+        return;
+    }
+
+    //NOTE: give up if the log thread stops making progress, e.g. because it died, so that fatal errors still get
+    //      reported
+    u64 pushCount = atomic_load(&log->pushCount);
+    u64 writeCount = atomic_load(&log->writeCount);
+    f64 lastProgress = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+    while(writeCount < pushCount)
+    {
+        oc_sleep_nano(100000);
+
+        u64 newWriteCount = atomic_load(&log->writeCount);
+        f64 now = oc_clock_time(OC_CLOCK_MONOTONIC);
+        if(newWriteCount != writeCount)
+        {
+            writeCount = newWriteCount;
+            lastProgress = now;
+        }
+        else if(now - lastProgress > OC_RUNTIME_LOG_FLUSH_TIMEOUT)
+        {
+            break;
+        }
+    }
+}
@@ -0,0 +1,57 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "orca.h"
+#include "util/ringbuffer.h"
+
+/*NOTE: deferred guest logging.
+	Writing a log message to the console means formatting its heading and doing blocking I/O, which is too slow for
+	guests that log in hot loops. So oc_bridge_log() only copies the message and its source location into a ring, as
+	a binary record, and the log thread formats and writes the records in order. Pushing a record is a reservation,
+	a copy and a commit, and only touches the log thread's condition variable when it's waiting for records.
+
+	The ring is an oc_mpsc_ringbuffer, so threads other than the runloop can push records too. When it's full, pushes
+	wait for the log thread rather than dropping messages.
+
+	Messages the host logs itself are still written synchronously, so they can appear before guest messages that
+	were logged earlier but not written yet. oc_runtime_log_flush() waits for the records pushed so far, and is called
+	before the runtime exits.
+*/
+typedef struct oc_runtime_log_record
+{
+    oc_log_level level; // OC_LOG_LEVEL_COUNT asks the log thread to quit
+    i32 line;
+    u32 functionLen;
+    u32 fileLen;
+    u32 msgLen;
+    //NOTE: followed by the function, file and message strings, each null-terminated
+
+} oc_runtime_log_record;
+
+typedef struct oc_runtime_log
+{
+    bool enabled;
+    oc_thread* thread;
+    oc_mpsc_ringbuffer ring;
+    u64 maxStringLen;
+
+    _Atomic(u64) pushCount;  // records pushed so far
+    _Atomic(u64) writeCount; // records the log thread has written
+
+} oc_runtime_log;
+
+void oc_runtime_log_start(oc_runtime_log* log);
+//NOTE: writes the pending records, then stops the log thread
+void oc_runtime_log_stop(oc_runtime_log* log);
+
+//NOTE: strings longer than a sixteenth of the ring are truncated
+void oc_runtime_log_push(oc_runtime_log* log, oc_log_level level, oc_str8 function, oc_str8 file, int line, oc_str8 msg);
+//NOTE: waits until the log thread has written every record pushed so far, or until it has made no progress for a
+//      second. Does nothing if the log isn't started, or when called from the log thread.
+void oc_runtime_log_flush(oc_runtime_log* log);
@@ -29,8 +29,13 @@ void* oc_runtime_wasm_memory_resize_callback(void* p, unsigned long newSize, voi
     {
         u32 commitSize = newSize - memory->committed;
 
-        oc_base_allocator* allocator = oc_base_allocator_default();
-        oc_base_commit(allocator, memory->ptr + memory->committed, commitSize);
+        oc_base_allocator* allocator = memory->base;
+        if(!memory->ptr || !oc_base_commit(allocator, memory->ptr + memory->committed, commitSize))
+        {
+            //NOTE: the wasm backend turns this into a failed memory.grow
+            oc_log_error("couldn't commit %u bytes of wasm memory\n", commitSize);
+            return (0);
+        }
         memory->committed += commitSize;
 
         OC_DEBUG_ASSERT((memory->committed & 0xfff) == 0, "Committed pointer is not aligned on page size");
@@ -48,7 +53,7 @@ void oc_runtime_wasm_memory_free_callback(void* p, void* userData)
 {
     oc_wasm_memory* memory = (oc_wasm_memory*)userData;
 
-    oc_base_allocator* allocator = oc_base_allocator_default();
+    oc_base_allocator* allocator = memory->base;
     oc_base_release(allocator, memory->ptr, memory->reserved);
     memset(memory, 0, sizeof(oc_wasm_memory));
 }
@@ -69,7 +74,12 @@ extern u32 oc_mem_grow(u64 size)
     //NOTE: call resize memory, which will call our custom resize callback... this is a bit involved because
     //      wasm3 doesn't allow resizing the memory directly
     oc_wasm_status status = oc_wasm_mem_resize(env->wasm, desiredMemSize / OC_WASM_MEM_PAGE_SIZE);
-    OC_WASM_TRAP(status);
+    if(oc_wasm_status_is_fail(status))
+    {
+        //NOTE: the guest is stopped when we return
+        OC_WASM_TRAP(status);
+        return (0);
+    }
 
     u64 newMemSize = oc_wasm_mem_size(env->wasm);
     OC_DEBUG_ASSERT(oldMemSize + size <= newMemSize, "Memory returned by oc_mem_grow overflows wasm memory");
@@ -77,6 +87,256 @@ extern u32 oc_mem_grow(u64 size)
     return (oldMemSize);
 }
 
+extern void oc_mem_decommit(u32 addr, u64 size)
+{
+    //NOTE: wasm memories can't shrink, so instead we give the physical pages of the range back to the OS while keeping
+    //      it committed. The guest will see zeroed or stale contents next time it touches these pages, which is fine
+    //      since it only decommits memory it doesn't use.
+    //      We align on 16K, the largest OS page size we run on.
+    enum
+    {
+        OC_WASM_DECOMMIT_ALIGN = 16 << 10
+    };
+
+    oc_wasm_env* env = oc_runtime_get_env();
+    oc_wasm_memory* memory = &env->wasmMemory;
+    oc_str8 mem = oc_runtime_get_wasm_memory();
+
+    if(addr > mem.len || size > mem.len - addr)
+    {
+        oc_log_error("oc_mem_decommit(): range [%u, %llu) overflows wasm memory\n", addr, (unsigned long long)addr + size);
+        return;
+    }
+
+    char* start = (char*)oc_align_up_pow2((uintptr_t)(mem.ptr + addr), OC_WASM_DECOMMIT_ALIGN);
+    char* end = (char*)oc_align_down_pow2((uintptr_t)(mem.ptr + addr + size), OC_WASM_DECOMMIT_ALIGN);
+    end = oc_min(end, memory->ptr + memory->committed);
+
+    if(start < end)
+    {
+        oc_base_allocator* allocator = memory->base;
+        oc_base_decommit(allocator, start, end - start);
+        if(!oc_base_commit(allocator, start, end - start))
+        {
+            oc_log_error("oc_mem_decommit(): couldn't recommit range [%u, %llu)\n", addr, (unsigned long long)addr + size);
+        }
+    }
+}
+
+oc_wasm_memory_stats oc_runtime_wasm_memory_stats(void)
+{
+    oc_wasm_memory* memory = &oc_runtime_get_env()->wasmMemory;
+
+    oc_wasm_memory_stats stats = {
+        .reserved = memory->reserved,
+        .committed = memory->committed,
+        .resident = oc_base_resident_size(memory->ptr, memory->committed),
+    };
+    return (stats);
+}
+
+//------------------------------------------------------------------------------------
+// guest heap tracking
+//------------------------------------------------------------------------------------
+
+//NOTE: these mirror struct orca_malloc_site and struct orca_malloc_tracking in orca-libc's malloc.h
+typedef struct oc_wasm_malloc_site
+{
+    u32 tag;
+    u32 tagLen;
+    u64 allocCount;
+    u64 freeCount;
+    u64 totalBytes;
+    u32 liveBytes;
+    u32 peakBytes;
+} oc_wasm_malloc_site;
+
+typedef struct oc_wasm_malloc_tracking
+{
+    u32 siteCount;
+    u32 siteCap;
+    u32 liveBytes;
+    u32 peakBytes;
+    u64 totalBytes;
+    oc_wasm_malloc_site sites[];
+} oc_wasm_malloc_tracking;
+
+//NOTE: the table is written by the guest at any time, so it is validated each time we read it
+static oc_wasm_malloc_tracking* oc_runtime_heap_tracking_get(u32 addr)
+{
+    oc_str8 mem = oc_runtime_get_wasm_memory();
+    if(!addr || (u64)addr + sizeof(oc_wasm_malloc_tracking) > mem.len)
+    {
+        return (0);
+    }
+    oc_wasm_malloc_tracking* tracking = (oc_wasm_malloc_tracking*)(mem.ptr + addr);
+    if(tracking->siteCount > tracking->siteCap
+       || (u64)addr + sizeof(oc_wasm_malloc_tracking) + (u64)tracking->siteCap * sizeof(oc_wasm_malloc_site) > mem.len)
+    {
+        return (0);
+    }
+    return (tracking);
+}
+
+extern void oc_malloc_tracking_register(u32 addr)
+{
+    oc_wasm_env* env = oc_runtime_get_env();
+    if(!oc_runtime_heap_tracking_get(addr))
+    {
+        oc_log_error("oc_malloc_tracking_register(): invalid site table at address %u\n", addr);
+        return;
+    }
+    env->mallocTrackingOffset = addr;
+}
+
+static int oc_runtime_heap_site_cmp(const void* a, const void* b)
+{
+    u32 liveA = ((const oc_runtime_heap_site*)a)->liveBytes;
+    u32 liveB = ((const oc_runtime_heap_site*)b)->liveBytes;
+    return ((liveA < liveB) - (liveA > liveB));
+}
+
+oc_runtime_heap_profile oc_runtime_heap_profile_get(oc_arena* arena)
+{
+    oc_runtime_heap_profile profile = { 0 };
+
+    oc_wasm_malloc_tracking* tracking = oc_runtime_heap_tracking_get(oc_runtime_get_env()->mallocTrackingOffset);
+    if(tracking)
+    {
+        oc_str8 mem = oc_runtime_get_wasm_memory();
+
+        profile.tracking = true;
+        profile.liveBytes = tracking->liveBytes;
+        profile.peakBytes = tracking->peakBytes;
+        profile.totalBytes = tracking->totalBytes;
+        profile.siteCount = tracking->siteCount;
+        profile.sites = oc_arena_push_array(arena, oc_runtime_heap_site, profile.siteCount);
+
+        for(u32 i = 0; i < profile.siteCount; i++)
+        {
+            oc_wasm_malloc_site* src = &tracking->sites[i];
+            oc_str8 tag = OC_STR8("<invalid tag>");
+            if((u64)src->tag + src->tagLen <= mem.len)
+            {
+                tag = oc_str8_push_copy(arena, oc_str8_from_buffer(src->tagLen, mem.ptr + src->tag));
+            }
+            profile.sites[i] = (oc_runtime_heap_site){
+                .tag = tag,
+                .allocCount = src->allocCount,
+                .freeCount = src->freeCount,
+                .totalBytes = src->totalBytes,
+                .liveBytes = src->liveBytes,
+                .peakBytes = src->peakBytes,
+            };
+        }
+        qsort(profile.sites, profile.siteCount, sizeof(oc_runtime_heap_site), oc_runtime_heap_site_cmp);
+    }
+    return (profile);
+}
+
+void oc_runtime_heap_profile_dump(oc_str8 path)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_runtime_heap_profile profile = oc_runtime_heap_profile_get(scratch.arena);
+    if(!profile.tracking)
+    {
+        oc_log_warning("can't dump heap profile: the guest's orca-libc wasn't built with malloc tracking\n");
+    }
+    else
+    {
+        const char* pathCStr = oc_str8_to_cstring(scratch.arena, path);
+        FILE* file = fopen(pathCStr, "w");
+        if(!file)
+        {
+            oc_log_error("Could not open heap profile file '%s': %s\n", pathCStr, strerror(errno));
+        }
+        else
+        {
+            fprintf(file, "tag,live bytes,peak bytes,total bytes,allocs,frees,live allocs\n");
+            fprintf(file,
+                    "<all>,%u,%u,%llu,,,\n",
+                    profile.liveBytes,
+                    profile.peakBytes,
+                    (unsigned long long)profile.totalBytes);
+
+            for(u32 i = 0; i < profile.siteCount; i++)
+            {
+                oc_runtime_heap_site* site = &profile.sites[i];
+                fprintf(file,
+                        "\"%.*s\",%u,%u,%llu,%llu,%llu,%llu\n",
+                        oc_str8_ip(site->tag),
+                        site->liveBytes,
+                        site->peakBytes,
+                        (unsigned long long)site->totalBytes,
+                        (unsigned long long)site->allocCount,
+                        (unsigned long long)site->freeCount,
+                        (unsigned long long)(site->allocCount - site->freeCount));
+            }
+            fclose(file);
+            oc_log_info("wrote heap profile of %u sites to '%s'\n", profile.siteCount, pathCStr);
+        }
+    }
+    oc_scratch_end(scratch);
+}
+
+oc_wasm_mapping_region* oc_wasm_mapping_region_acquire(u64 size)
+{
+    oc_wasm_memory* memory = &oc_runtime_get_env()->wasmMemory;
+
+    //NOTE: reuse the smallest free region that fits
+    oc_wasm_mapping_region* region = 0;
+    for(u32 i = 0; i < memory->mappingRegionCount; i++)
+    {
+        oc_wasm_mapping_region* candidate = &memory->mappingRegions[i];
+        if(!candidate->used
+           && candidate->size >= size
+           && (!region || candidate->size < region->size))
+        {
+            region = candidate;
+        }
+    }
+
+    if(!region)
+    {
+        if(memory->mappingRegionCount >= OC_WASM_MAX_MAPPING_REGIONS)
+        {
+            oc_log_error("oc_wasm_mapping_region_acquire(): too many mapping regions\n");
+            return (0);
+        }
+        region = &memory->mappingRegions[memory->mappingRegionCount];
+        memory->mappingRegionCount++;
+
+        size = oc_align_up_pow2(size, OC_WASM_MEM_PAGE_SIZE);
+        region->addr = oc_mem_grow(size);
+        region->size = size;
+    }
+    region->used = true;
+    return (region);
+}
+
+oc_wasm_mapping_region* oc_wasm_mapping_region_find(oc_wasm_addr addr)
+{
+    oc_wasm_memory* memory = &oc_runtime_get_env()->wasmMemory;
+
+    oc_wasm_mapping_region* region = 0;
+    for(u32 i = 0; i < memory->mappingRegionCount; i++)
+    {
+        oc_wasm_mapping_region* candidate = &memory->mappingRegions[i];
+        if(candidate->used && addr >= candidate->addr && addr - candidate->addr < candidate->size)
+        {
+            region = candidate;
+            break;
+        }
+    }
+    return (region);
+}
+
+void oc_wasm_mapping_region_release(oc_wasm_mapping_region* region)
+{
+    region->used = false;
+}
+
 void* oc_wasm_address_to_ptr(oc_wasm_addr addr, oc_wasm_size size)
 {
     oc_str8 mem = oc_runtime_get_wasm_memory();
@@ -155,8 +415,13 @@ oc_wasm_addr oc_wasm_arena_push(oc_wasm_addr arena, u64 size)
 
     oc_wasm_val returns[1];
 
-    oc_wasm_status status = oc_wasm_function_call(env->wasm, env->exports[OC_EXPORT_ARENA_PUSH], params, 2, returns, 1);
-    OC_WASM_TRAP(status);
+    oc_wasm_status status = oc_wasm_call_stub_invoke(env->wasm, &env->exportStubs[OC_EXPORT_ARENA_PUSH], params, returns);
+    if(oc_wasm_status_is_fail(status))
+    {
+        //NOTE: the guest is stopped when we return
+        OC_WASM_TRAP(status);
+        return (0);
+    }
 
     static_assert(sizeof(oc_wasm_addr) == sizeof(i32), "wasm addres should be 32 bits");
     return (oc_wasm_addr)returns[0].I32;
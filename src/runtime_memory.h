@@ -12,6 +12,51 @@
 void* oc_wasm_address_to_ptr(oc_wasm_addr addr, oc_wasm_size size);
 oc_wasm_addr oc_wasm_address_from_ptr(void* ptr, oc_wasm_size size);
 
+typedef struct oc_wasm_memory_stats
+{
+    u64 reserved;
+    u64 committed;
+    u64 resident;
+} oc_wasm_memory_stats;
+
+oc_wasm_memory_stats oc_runtime_wasm_memory_stats(void);
+
+//------------------------------------------------------------------------------------
+// guest heap tracking
+//------------------------------------------------------------------------------------
+
+//NOTE: per-tag counters of an orca-libc built with ORCA_MALLOC_TRACKING, read from the guest's site table
+typedef struct oc_runtime_heap_site
+{
+    oc_str8 tag;
+    u64 allocCount;
+    u64 freeCount;
+    u64 totalBytes;
+    u32 liveBytes;
+    u32 peakBytes;
+} oc_runtime_heap_site;
+
+typedef struct oc_runtime_heap_profile
+{
+    bool tracking;
+    u32 liveBytes;
+    u32 peakBytes;
+    u64 totalBytes;
+    u32 siteCount;
+    oc_runtime_heap_site* sites; // largest live usage first
+} oc_runtime_heap_profile;
+
+oc_runtime_heap_profile oc_runtime_heap_profile_get(oc_arena* arena);
+void oc_runtime_heap_profile_dump(oc_str8 path);
+
+typedef struct oc_wasm_mapping_region oc_wasm_mapping_region;
+
+//NOTE: oc_wasm_mapping_region_acquire() returns a free region of at least size bytes, growing the wasm memory if
+//      none can be reused, or 0 when all region slots are used.
+oc_wasm_mapping_region* oc_wasm_mapping_region_acquire(u64 size);
+oc_wasm_mapping_region* oc_wasm_mapping_region_find(oc_wasm_addr addr);
+void oc_wasm_mapping_region_release(oc_wasm_mapping_region* region);
+
 //------------------------------------------------------------------------------------
 // oc_wasm_list helpers
 //------------------------------------------------------------------------------------
@@ -0,0 +1,631 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <curl/curl.h>
+
+#include "platform/platform_thread.h"
+#include "runtime.h"
+#include "runtime_net.h"
+
+enum
+{
+    OC_RUNTIME_MAX_FETCHES = 64,
+};
+
+typedef struct oc_runtime_fetch
+{
+    oc_runtime_net* net;
+    oc_fetch handle;
+    u32 generation;
+    bool used;
+
+    CURL* easy;
+    struct curl_slist* headers;
+    bool added;
+
+    //NOTE: the guest buffer the response body is written to
+    char* buffer;
+    u64 cap;
+    u64 size;
+
+    //NOTE: bytes received once the buffer was full, which go to the next buffer
+    char* pending;
+    u64 pendingSize;
+    u64 pendingCap;
+
+    bool paused;         // receiving is paused until the guest resumes the fetch
+    bool awaitingResume; // a DATA event was sent, and the buffer belongs to the guest until it resumes the fetch
+    bool done;
+    CURLcode result;
+} oc_runtime_fetch;
+
+typedef enum oc_runtime_fetch_cmd_kind
+{
+    OC_RUNTIME_FETCH_CMD_START,
+    OC_RUNTIME_FETCH_CMD_RESUME,
+    OC_RUNTIME_FETCH_CMD_CANCEL,
+} oc_runtime_fetch_cmd_kind;
+
+typedef struct oc_runtime_fetch_cmd
+{
+    oc_list_elt listElt;
+    oc_runtime_fetch_cmd_kind kind;
+    oc_fetch fetch;
+    u64 size;
+    char* buffer;
+} oc_runtime_fetch_cmd;
+
+struct oc_runtime_net
+{
+    u64 window;
+    CURLM* multi;
+    oc_thread* thread;
+
+    //NOTE: protects commands, quit, and the used flag and generation of fetches
+    oc_mutex* mutex;
+    oc_list commands;
+    bool quit;
+
+    oc_runtime_fetch fetches[OC_RUNTIME_MAX_FETCHES];
+};
+
+//------------------------------------------------------------------------------------
+// Fetch slots
+//------------------------------------------------------------------------------------
+
+//NOTE: handles hold the slot's index + 1 in their low bits, so that a nil handle is never valid, and the slot's
+//      generation in their high bits, so that stale handles are ignored.
+static oc_runtime_fetch* oc_runtime_fetch_alloc(oc_runtime_net* net)
+{
+    oc_runtime_fetch* fetch = 0;
+
+    oc_mutex_lock(net->mutex);
+    for(u32 index = 0; index < OC_RUNTIME_MAX_FETCHES; index++)
+    {
+        oc_runtime_fetch* slot = &net->fetches[index];
+        if(!slot->used)
+        {
+            u32 generation = slot->generation + 1;
+            memset(slot, 0, sizeof(oc_runtime_fetch));
+
+            slot->net = net;
+            slot->used = true;
+            slot->generation = generation;
+            slot->handle.h = ((u64)generation << 32) | (u64)(index + 1);
+
+            fetch = slot;
+            break;
+        }
+    }
+    oc_mutex_unlock(net->mutex);
+
+    return (fetch);
+}
+
+static oc_runtime_fetch* oc_runtime_fetch_from_handle(oc_runtime_net* net, oc_fetch handle)
+{
+    oc_runtime_fetch* fetch = 0;
+    u64 index = (handle.h & 0xffffffff) - 1;
+    u32 generation = handle.h >> 32;
+
+    if(index < OC_RUNTIME_MAX_FETCHES)
+    {
+        oc_mutex_lock(net->mutex);
+        oc_runtime_fetch* slot = &net->fetches[index];
+        if(slot->used && slot->generation == generation)
+        {
+            fetch = slot;
+        }
+        oc_mutex_unlock(net->mutex);
+    }
+    return (fetch);
+}
+
+static void oc_runtime_fetch_release(oc_runtime_net* net, oc_runtime_fetch* fetch)
+{
+    if(fetch->easy)
+    {
+        if(fetch->added)
+        {
+            curl_multi_remove_handle(net->multi, fetch->easy);
+        }
+        curl_easy_cleanup(fetch->easy);
+    }
+    curl_slist_free_all(fetch->headers);
+    free(fetch->pending);
+
+    oc_mutex_lock(net->mutex);
+    fetch->used = false;
+    oc_mutex_unlock(net->mutex);
+}
+
+//------------------------------------------------------------------------------------
+// Fetch events
+//------------------------------------------------------------------------------------
+
+static oc_fetch_error oc_runtime_fetch_error(CURLcode code)
+{
+    switch(code)
+    {
+        case CURLE_OK:
+            return (OC_FETCH_OK);
+
+        case CURLE_UNSUPPORTED_PROTOCOL:
+        case CURLE_URL_MALFORMAT:
+        case CURLE_TOO_MANY_REDIRECTS:
+            return (OC_FETCH_ERR_ARG);
+
+        case CURLE_COULDNT_RESOLVE_PROXY:
+        case CURLE_COULDNT_RESOLVE_HOST:
+            return (OC_FETCH_ERR_RESOLVE);
+
+        case CURLE_COULDNT_CONNECT:
+            return (OC_FETCH_ERR_CONNECT);
+
+        case CURLE_SSL_CONNECT_ERROR:
+        case CURLE_PEER_FAILED_VERIFICATION:
+        case CURLE_SSL_CERTPROBLEM:
+        case CURLE_SSL_CIPHER:
+        case CURLE_SSL_CACERT_BADFILE:
+            return (OC_FETCH_ERR_TLS);
+
+        case CURLE_OPERATION_TIMEDOUT:
+            return (OC_FETCH_ERR_TIMEOUT);
+
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_GOT_NOTHING:
+        case CURLE_PARTIAL_FILE:
+        case CURLE_HTTP2:
+        case CURLE_HTTP2_STREAM:
+            return (OC_FETCH_ERR_NETWORK);
+
+        //NOTE: the write callback only fails when it can't grow the pending buffer
+        case CURLE_OUT_OF_MEMORY:
+        case CURLE_WRITE_ERROR:
+            return (OC_FETCH_ERR_MEM);
+
+        default:
+            return (OC_FETCH_ERR_UNKNOWN);
+    }
+}
+
+static void oc_runtime_fetch_send_event(oc_runtime_fetch* fetch, oc_fetch_event_kind kind)
+{
+    long status = 0;
+    curl_easy_getinfo(fetch->easy, CURLINFO_RESPONSE_CODE, &status);
+
+    oc_event event = {
+        .window = { .h = fetch->net->window },
+        .type = OC_EVENT_FETCH,
+        .fetch = {
+            .fetch = fetch->handle,
+            .kind = kind,
+            .status = (u32)status,
+            .size = fetch->size,
+            .error = (kind == OC_FETCH_EVENT_DONE) ? oc_runtime_fetch_error(fetch->result) : OC_FETCH_OK,
+        },
+    };
+    oc_queue_event(&event);
+}
+
+static void oc_runtime_fetch_finish(oc_runtime_net* net, oc_runtime_fetch* fetch)
+{
+    oc_runtime_fetch_send_event(fetch, OC_FETCH_EVENT_DONE);
+    oc_runtime_fetch_release(net, fetch);
+}
+
+//------------------------------------------------------------------------------------
+// Transfers
+//------------------------------------------------------------------------------------
+
+static bool oc_runtime_fetch_push_pending(oc_runtime_fetch* fetch, char* data, u64 size)
+{
+    if(fetch->pendingSize + size > fetch->pendingCap)
+    {
+        u64 cap = oc_max(fetch->pendingCap * 2, fetch->pendingSize + size);
+        char* pending = realloc(fetch->pending, cap);
+        if(!pending)
+        {
+            return (false);
+        }
+        fetch->pending = pending;
+        fetch->pendingCap = cap;
+    }
+    memcpy(fetch->pending + fetch->pendingSize, data, size);
+    fetch->pendingSize += size;
+    return (true);
+}
+
+//NOTE: called by curl on the net thread. The pending buffer is only used when the guest buffer is full, and is
+//      bounded by what curl delivers before it sees the pause, which is at most one chunk.
+static size_t oc_runtime_fetch_write(char* data, size_t size, size_t count, void* user)
+{
+    oc_runtime_fetch* fetch = (oc_runtime_fetch*)user;
+    u64 total = size * count;
+    u64 copied = 0;
+
+    if(!fetch->awaitingResume)
+    {
+        copied = oc_min(total, fetch->cap - fetch->size);
+        memcpy(fetch->buffer + fetch->size, data, copied);
+        fetch->size += copied;
+    }
+
+    if(copied < total)
+    {
+        if(!oc_runtime_fetch_push_pending(fetch, data + copied, total - copied))
+        {
+            return (0);
+        }
+    }
+
+    if(fetch->size == fetch->cap && !fetch->awaitingResume)
+    {
+        fetch->awaitingResume = true;
+        oc_runtime_fetch_send_event(fetch, OC_FETCH_EVENT_DATA);
+    }
+
+    if(fetch->awaitingResume && !fetch->paused)
+    {
+        fetch->paused = true;
+        curl_easy_pause(fetch->easy, CURLPAUSE_RECV);
+    }
+    return (total);
+}
+
+static void oc_runtime_fetch_resume(oc_runtime_net* net, oc_runtime_fetch* fetch, u64 cap, char* buffer)
+{
+    if(!fetch->awaitingResume)
+    {
+        //NOTE: the fetch still owns its buffer, so this resume doesn't match a DATA event
+        return;
+    }
+
+    u64 copied = oc_min(fetch->pendingSize, cap);
+    memcpy(buffer, fetch->pending, copied);
+    memmove(fetch->pending, fetch->pending + copied, fetch->pendingSize - copied);
+    fetch->pendingSize -= copied;
+
+    fetch->buffer = buffer;
+    fetch->cap = cap;
+    fetch->size = copied;
+    fetch->awaitingResume = false;
+
+    if(fetch->pendingSize)
+    {
+        fetch->awaitingResume = true;
+        oc_runtime_fetch_send_event(fetch, OC_FETCH_EVENT_DATA);
+    }
+    else if(fetch->done)
+    {
+        oc_runtime_fetch_finish(net, fetch);
+    }
+    else if(fetch->paused)
+    {
+        fetch->paused = false;
+        curl_easy_pause(fetch->easy, CURLPAUSE_CONT);
+    }
+}
+
+static void oc_runtime_net_execute(oc_runtime_net* net, oc_runtime_fetch_cmd* cmd)
+{
+    oc_runtime_fetch* fetch = oc_runtime_fetch_from_handle(net, cmd->fetch);
+    if(fetch)
+    {
+        switch(cmd->kind)
+        {
+            case OC_RUNTIME_FETCH_CMD_START:
+            {
+                if(curl_multi_add_handle(net->multi, fetch->easy) == CURLM_OK)
+                {
+                    fetch->added = true;
+                }
+                else
+                {
+                    fetch->result = CURLE_OUT_OF_MEMORY;
+                    oc_runtime_fetch_finish(net, fetch);
+                }
+            }
+            break;
+
+            case OC_RUNTIME_FETCH_CMD_RESUME:
+                oc_runtime_fetch_resume(net, fetch, cmd->size, cmd->buffer);
+                break;
+
+            case OC_RUNTIME_FETCH_CMD_CANCEL:
+                oc_runtime_fetch_release(net, fetch);
+                break;
+        }
+    }
+}
+
+static i32 oc_runtime_net_thread(void* user)
+{
+    oc_runtime_net* net = (oc_runtime_net*)user;
+
+    while(1)
+    {
+        oc_mutex_lock(net->mutex);
+        oc_list commands = net->commands;
+        oc_list_init(&net->commands);
+        bool quit = net->quit;
+        oc_mutex_unlock(net->mutex);
+
+        oc_list_for_safe(commands, cmd, oc_runtime_fetch_cmd, listElt)
+        {
+            if(!quit)
+            {
+                oc_runtime_net_execute(net, cmd);
+            }
+            free(cmd);
+        }
+        if(quit)
+        {
+            break;
+        }
+
+        int running = 0;
+        curl_multi_perform(net->multi, &running);
+
+        CURLMsg* msg = 0;
+        int left = 0;
+        while((msg = curl_multi_info_read(net->multi, &left)))
+        {
+            if(msg->msg == CURLMSG_DONE)
+            {
+                oc_runtime_fetch* fetch = 0;
+                curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&fetch);
+
+                fetch->done = true;
+                fetch->result = msg->data.result;
+
+                //NOTE: if the guest holds the buffer, the DONE event is sent once it resumes the fetch
+                if(!fetch->awaitingResume)
+                {
+                    oc_runtime_fetch_finish(net, fetch);
+                }
+            }
+        }
+
+        //NOTE: commands wake the loop with curl_multi_wakeup()
+        curl_multi_poll(net->multi, 0, 0, 1000, 0);
+    }
+
+    for(u32 index = 0; index < OC_RUNTIME_MAX_FETCHES; index++)
+    {
+        if(net->fetches[index].used)
+        {
+            oc_runtime_fetch_release(net, &net->fetches[index]);
+        }
+    }
+    return (0);
+}
+
+//------------------------------------------------------------------------------------
+// Net context
+//------------------------------------------------------------------------------------
+
+static oc_runtime_net* oc_runtime_net_create(u64 window)
+{
+    if(curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK)
+    {
+        return (0);
+    }
+
+    oc_runtime_net* net = calloc(1, sizeof(oc_runtime_net));
+    if(net)
+    {
+        net->window = window;
+        net->multi = curl_multi_init();
+        net->mutex = oc_mutex_create();
+        oc_list_init(&net->commands);
+
+        if(net->multi && net->mutex)
+        {
+            net->thread = oc_thread_create_with_name(oc_runtime_net_thread, net, OC_STR8("orca net"));
+        }
+
+        if(!net->thread)
+        {
+            if(net->mutex)
+            {
+                oc_mutex_destroy(net->mutex);
+            }
+            if(net->multi)
+            {
+                curl_multi_cleanup(net->multi);
+            }
+            free(net);
+            net = 0;
+        }
+    }
+    if(!net)
+    {
+        curl_global_cleanup();
+    }
+    return (net);
+}
+
+void oc_runtime_net_destroy(oc_runtime_net* net)
+{
+    if(net)
+    {
+        oc_mutex_lock(net->mutex);
+        net->quit = true;
+        oc_mutex_unlock(net->mutex);
+
+        curl_multi_wakeup(net->multi);
+        oc_thread_join(net->thread, 0);
+
+        oc_list_for_safe(net->commands, cmd, oc_runtime_fetch_cmd, listElt)
+        {
+            free(cmd);
+        }
+        curl_multi_cleanup(net->multi);
+        oc_mutex_destroy(net->mutex);
+        free(net);
+
+        curl_global_cleanup();
+    }
+}
+
+static bool oc_runtime_net_post(oc_runtime_net* net, oc_runtime_fetch_cmd_kind kind, oc_fetch fetch, u64 size, char* buffer)
+{
+    oc_runtime_fetch_cmd* cmd = calloc(1, sizeof(oc_runtime_fetch_cmd));
+    if(cmd)
+    {
+        cmd->kind = kind;
+        cmd->fetch = fetch;
+        cmd->size = size;
+        cmd->buffer = buffer;
+
+        oc_mutex_lock(net->mutex);
+        oc_list_push_back(&net->commands, &cmd->listElt);
+        oc_mutex_unlock(net->mutex);
+
+        curl_multi_wakeup(net->multi);
+    }
+    return (cmd != 0);
+}
+
+//------------------------------------------------------------------------------------
+// Bridge
+//------------------------------------------------------------------------------------
+
+static bool oc_runtime_fetch_setup(oc_runtime_fetch* fetch, oc_str8 method, oc_str8 url, oc_str8 headers, oc_str8 body)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    CURL* easy = curl_easy_init();
+    fetch->easy = easy;
+
+    bool ok = (easy != 0)
+           && curl_easy_setopt(easy, CURLOPT_URL, oc_str8_to_cstring(scratch.arena, url)) == CURLE_OK
+           && curl_easy_setopt(easy, CURLOPT_PROTOCOLS_STR, "http,https") == CURLE_OK
+           && curl_easy_setopt(easy, CURLOPT_REDIR_PROTOCOLS_STR, "http,https") == CURLE_OK;
+
+    if(ok)
+    {
+        curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(easy, CURLOPT_MAXREDIRS, 16L);
+        curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT, 30L);
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, oc_runtime_fetch_write);
+        curl_easy_setopt(easy, CURLOPT_WRITEDATA, fetch);
+        curl_easy_setopt(easy, CURLOPT_PRIVATE, fetch);
+
+        if(body.len)
+        {
+            //NOTE: the size must be set before the body is copied
+            curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)body.len);
+            ok = curl_easy_setopt(easy, CURLOPT_COPYPOSTFIELDS, body.ptr) == CURLE_OK;
+        }
+        if(method.len)
+        {
+            if(!oc_str8_cmp(method, OC_STR8("HEAD")))
+            {
+                curl_easy_setopt(easy, CURLOPT_NOBODY, 1L);
+            }
+            else
+            {
+                curl_easy_setopt(easy, CURLOPT_CUSTOMREQUEST, oc_str8_to_cstring(scratch.arena, method));
+            }
+        }
+
+        oc_str8_list separators = { 0 };
+        oc_str8_list_push(scratch.arena, &separators, OC_STR8("\r\n"));
+        oc_str8_list_push(scratch.arena, &separators, OC_STR8("\n"));
+
+        oc_str8_list lines = oc_str8_split(scratch.arena, headers, separators);
+        oc_str8_list_for(lines, line)
+        {
+            if(line->string.len)
+            {
+                struct curl_slist* list = curl_slist_append(fetch->headers, oc_str8_to_cstring(scratch.arena, line->string));
+                if(!list)
+                {
+                    ok = false;
+                    break;
+                }
+                fetch->headers = list;
+            }
+        }
+        if(fetch->headers)
+        {
+            curl_easy_setopt(easy, CURLOPT_HTTPHEADER, fetch->headers);
+        }
+    }
+
+    oc_scratch_end(scratch);
+    return (ok);
+}
+
+oc_fetch oc_bridge_fetch_start(oc_wasm_str8 method, oc_wasm_str8 url, oc_wasm_str8 headers, oc_wasm_str8 body, u64 size, char* buffer)
+{
+    oc_runtime* app = oc_runtime_get();
+    oc_fetch handle = { 0 };
+
+    oc_str8 nativeMethod = oc_wasm_str8_to_native(method);
+    oc_str8 nativeUrl = oc_wasm_str8_to_native(url);
+    oc_str8 nativeHeaders = oc_wasm_str8_to_native(headers);
+    oc_str8 nativeBody = oc_wasm_str8_to_native(body);
+
+    if((method.len && !nativeMethod.ptr)
+       || !nativeUrl.ptr
+       || (headers.len && !nativeHeaders.ptr)
+       || (body.len && !nativeBody.ptr))
+    {
+        return (handle);
+    }
+
+    if(!app->net)
+    {
+        app->net = oc_runtime_net_create(app->window.h);
+        if(!app->net)
+        {
+            return (handle);
+        }
+    }
+    oc_runtime_net* net = app->net;
+
+    oc_runtime_fetch* fetch = oc_runtime_fetch_alloc(net);
+    if(fetch)
+    {
+        fetch->buffer = buffer;
+        fetch->cap = size;
+
+        if(oc_runtime_fetch_setup(fetch, nativeMethod, nativeUrl, nativeHeaders, nativeBody)
+           && oc_runtime_net_post(net, OC_RUNTIME_FETCH_CMD_START, fetch->handle, 0, 0))
+        {
+            handle = fetch->handle;
+        }
+        else
+        {
+            oc_runtime_fetch_release(net, fetch);
+        }
+    }
+    return (handle);
+}
+
+void oc_bridge_fetch_resume(oc_fetch fetch, u64 size, char* buffer)
+{
+    oc_runtime* app = oc_runtime_get();
+    if(app->net && buffer)
+    {
+        oc_runtime_net_post(app->net, OC_RUNTIME_FETCH_CMD_RESUME, fetch, size, buffer);
+    }
+}
+
+void oc_bridge_fetch_cancel(oc_fetch fetch)
+{
+    oc_runtime* app = oc_runtime_get();
+    if(app->net)
+    {
+        oc_runtime_net_post(app->net, OC_RUNTIME_FETCH_CMD_CANCEL, fetch, 0, 0);
+    }
+}
@@ -0,0 +1,24 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "platform/platform_net.h"
+#include "runtime_memory.h"
+
+//NOTE: an app's fetches, run by a curl multi loop on their own thread, which is started by the app's first fetch.
+//      Response bodies are written directly to the guest's buffers, and fetches report to the app's window through
+//      the event queue.
+typedef struct oc_runtime_net oc_runtime_net;
+
+//NOTE: cancels all fetches, without sending their events. Must be called before the linear memory they write to
+//      is freed.
+void oc_runtime_net_destroy(oc_runtime_net* net);
+
+oc_fetch oc_bridge_fetch_start(oc_wasm_str8 method, oc_wasm_str8 url, oc_wasm_str8 headers, oc_wasm_str8 body, u64 size, char* buffer);
+void oc_bridge_fetch_resume(oc_fetch fetch, u64 size, char* buffer);
+void oc_bridge_fetch_cancel(oc_fetch fetch);
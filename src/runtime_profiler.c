@@ -0,0 +1,475 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+
+#include "runtime_profiler.h"
+
+//NOTE: the backends don't let us walk the guest call stack from another thread, so instead of sampling
+//      we record each call into a guest export and each call from the guest into a host binding.
+//      The resulting trace is written in the chrome trace event format, that can be loaded in
+//      chrome://tracing, https://ui.perfetto.dev or https://www.speedscope.app to get a flamegraph.
+
+enum
+{
+    OC_RUNTIME_PROFILER_MAX_EVENTS = 1 << 20,
+};
+
+//NOTE: writes string as the contents of a JSON string. Names come from the guest module or its bundle, so they can
+//      contain quotes, backslashes or control characters.
+static void oc_runtime_profiler_write_json_string(FILE* file, oc_str8 string)
+{
+    for(u64 i = 0; i < string.len; i++)
+    {
+        unsigned char c = (unsigned char)string.ptr[i];
+        if(c == '"' || c == '\\')
+        {
+            fputc('\\', file);
+            fputc(c, file);
+        }
+        else if(c < 0x20)
+        {
+            fprintf(file, "\\u%04x", c);
+        }
+        else
+        {
+            fputc(c, file);
+        }
+    }
+}
+
+static void oc_runtime_profiler_push_event(oc_runtime_profiler* profiler, oc_str8 name, f64 start, f64 end)
+{
+    if(profiler->eventCount < OC_RUNTIME_PROFILER_MAX_EVENTS)
+    {
+        oc_runtime_profiler_event* event = oc_arena_push_type(&profiler->arena, oc_runtime_profiler_event);
+        event->name = name;
+        event->start = start;
+        event->end = end;
+        oc_list_push_back(&profiler->events, &event->listElt);
+    }
+    profiler->eventCount++;
+}
+
+static oc_str8 oc_runtime_profiler_export_name(oc_wasm_function_handle* handle)
+{
+    oc_wasm_env* env = oc_runtime_get_env();
+
+    oc_str8 name = OC_STR8("<unknown export>");
+    for(int i = 0; i < OC_EXPORT_COUNT; i++)
+    {
+        if(env->exports[i] == handle)
+        {
+            name = OC_EXPORT_DESC[i].name;
+            break;
+        }
+    }
+    return (name);
+}
+
+static bool oc_runtime_call_stats_collecting(oc_runtime_profiler* profiler)
+{
+    return (profiler->statsEnabled || profiler->hotnessEnabled);
+}
+
+//NOTE: stats are keyed by the function handle for exports, and by the import name's pointer for host bindings,
+//      which both stay the same for the lifetime of the module.
+static oc_runtime_call_stats* oc_runtime_call_stats_find(oc_runtime_profiler* profiler, void* key, bool isExport, oc_str8 name)
+{
+    u64 bucketIndex = (((uintptr_t)key) >> 3) % OC_RUNTIME_CALL_STATS_BUCKETS;
+    oc_list* bucket = &profiler->statsBuckets[bucketIndex];
+
+    oc_list_for(*bucket, stats, oc_runtime_call_stats, bucketElt)
+    {
+        if(stats->key == key && stats->isExport == isExport)
+        {
+            return (stats);
+        }
+    }
+
+    oc_runtime_call_stats* stats = oc_arena_push_type(&profiler->statsArena, oc_runtime_call_stats);
+    memset(stats, 0, sizeof(oc_runtime_call_stats));
+    stats->key = key;
+    stats->isExport = isExport;
+    stats->name = isExport ? oc_runtime_profiler_export_name((oc_wasm_function_handle*)key) : name;
+
+    oc_list_push_front(bucket, &stats->bucketElt);
+    oc_list_push_back(&profiler->stats, &stats->listElt);
+    profiler->statsCount++;
+    return (stats);
+}
+
+static void oc_runtime_profiler_function_call(void* user, oc_wasm_function_handle* handle, f64 start, f64 end)
+{
+    oc_runtime_profiler* profiler = (oc_runtime_profiler*)user;
+
+    if(profiler->enabled)
+    {
+        oc_runtime_profiler_push_event(profiler, oc_runtime_profiler_export_name(handle), start, end);
+    }
+    if(oc_runtime_call_stats_collecting(profiler))
+    {
+        oc_runtime_call_stats* stats = oc_runtime_call_stats_find(profiler, handle, true, (oc_str8){ 0 });
+        stats->frameCount++;
+        stats->frameTime += end - start;
+    }
+}
+
+static void oc_runtime_profiler_host_call(void* user, oc_str8 importName, f64 start, f64 end)
+{
+    oc_runtime_profiler* profiler = (oc_runtime_profiler*)user;
+
+    if(profiler->enabled)
+    {
+        oc_runtime_profiler_push_event(profiler, importName, start, end);
+    }
+    if(oc_runtime_call_stats_collecting(profiler))
+    {
+        oc_runtime_call_stats* stats = oc_runtime_call_stats_find(profiler, importName.ptr, false, importName);
+        stats->frameCount++;
+        stats->frameTime += end - start;
+    }
+}
+
+static void oc_runtime_profiler_update_hooks(oc_runtime_profiler* profiler, oc_wasm* wasm)
+{
+    if(profiler->enabled || oc_runtime_call_stats_collecting(profiler))
+    {
+        profiler->hooks = (oc_wasm_profile_hooks){
+            .user = profiler,
+            .functionCall = oc_runtime_profiler_function_call,
+            .hostCall = oc_runtime_profiler_host_call,
+        };
+        oc_wasm_set_profile_hooks(wasm, &profiler->hooks);
+    }
+    else
+    {
+        oc_wasm_set_profile_hooks(wasm, NULL);
+    }
+}
+
+void oc_runtime_profiler_start(oc_runtime_profiler* profiler, oc_wasm* wasm)
+{
+    if(profiler->enabled)
+    {
+        return;
+    }
+    oc_arena_clear(&profiler->arena);
+    oc_list_init(&profiler->events);
+    profiler->eventCount = 0;
+    profiler->startTime = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+    profiler->enabled = true;
+    oc_runtime_profiler_update_hooks(profiler, wasm);
+
+    oc_log_info("profiler started\n");
+}
+
+void oc_runtime_profiler_stop(oc_runtime_profiler* profiler, oc_wasm* wasm, oc_str8 path)
+{
+    if(!profiler->enabled)
+    {
+        return;
+    }
+    profiler->enabled = false;
+    oc_runtime_profiler_update_hooks(profiler, wasm);
+
+    if(profiler->eventCount > OC_RUNTIME_PROFILER_MAX_EVENTS)
+    {
+        oc_log_warning("profiler dropped %llu events past the limit of %i\n",
+                       (unsigned long long)(profiler->eventCount - OC_RUNTIME_PROFILER_MAX_EVENTS),
+                       OC_RUNTIME_PROFILER_MAX_EVENTS);
+    }
+
+    oc_arena_scope scratch = oc_scratch_begin();
+    const char* pathCStr = oc_str8_to_cstring(scratch.arena, path);
+
+    FILE* file = fopen(pathCStr, "w");
+    if(!file)
+    {
+        oc_log_error("Could not open profile file '%s': %s\n", pathCStr, strerror(errno));
+    }
+    else
+    {
+        //NOTE: timestamps and durations are in microseconds. Events are all on the same thread,
+        //      and nested host calls are contained in their enclosing export call, so the viewer
+        //      can stack them.
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+        bool first = true;
+        oc_list_for(profiler->events, event, oc_runtime_profiler_event, listElt)
+        {
+            fprintf(file, "%s\n{\"name\":\"", first ? "" : ",");
+            oc_runtime_profiler_write_json_string(file, event->name);
+            fprintf(file,
+                    "\",\"cat\":\"wasm\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}",
+                    (event->start - profiler->startTime) * 1e6,
+                    (event->end - event->start) * 1e6);
+            first = false;
+        }
+        fprintf(file, "\n]}\n");
+        fclose(file);
+
+        oc_log_info("profiler stopped, wrote %llu events to '%s'\n",
+                    (unsigned long long)oc_min(profiler->eventCount, OC_RUNTIME_PROFILER_MAX_EVENTS),
+                    pathCStr);
+    }
+    oc_scratch_end(scratch);
+
+    oc_arena_clear(&profiler->arena);
+    oc_list_init(&profiler->events);
+}
+
+//------------------------------------------------------------------------------------
+// call stats
+//------------------------------------------------------------------------------------
+
+//NOTE: the displayed call stats and the hotness profile share the same records, which are only reset when neither
+//      of them was collecting
+static void oc_runtime_call_stats_set(oc_runtime_profiler* profiler, oc_wasm* wasm, bool stats, bool hotness)
+{
+    if(!oc_runtime_call_stats_collecting(profiler) && (stats || hotness))
+    {
+        oc_arena_clear(&profiler->statsArena);
+        oc_list_init(&profiler->stats);
+        profiler->statsCount = 0;
+        for(int i = 0; i < OC_RUNTIME_CALL_STATS_BUCKETS; i++)
+        {
+            oc_list_init(&profiler->statsBuckets[i]);
+        }
+        profiler->statsFrameIndex = 0;
+        profiler->statsFrameCount = 0;
+        profiler->hotnessFrameCount = 0;
+    }
+    profiler->statsEnabled = stats;
+    profiler->hotnessEnabled = hotness;
+    oc_runtime_profiler_update_hooks(profiler, wasm);
+}
+
+void oc_runtime_call_stats_enable(oc_runtime_profiler* profiler, oc_wasm* wasm, bool enable)
+{
+    if(enable == profiler->statsEnabled)
+    {
+        return;
+    }
+    oc_runtime_call_stats_set(profiler, wasm, enable, profiler->hotnessEnabled);
+}
+
+void oc_runtime_call_stats_frame_end(oc_runtime_profiler* profiler)
+{
+    if(!oc_runtime_call_stats_collecting(profiler))
+    {
+        return;
+    }
+    oc_list_for(profiler->stats, stats, oc_runtime_call_stats, listElt)
+    {
+        stats->historyCount[profiler->statsFrameIndex] = stats->frameCount;
+        stats->historyTime[profiler->statsFrameIndex] = stats->frameTime;
+        stats->totalCount += stats->frameCount;
+        stats->totalTime += stats->frameTime;
+        stats->frameCount = 0;
+        stats->frameTime = 0;
+    }
+    profiler->statsFrameIndex = (profiler->statsFrameIndex + 1) % OC_RUNTIME_CALL_STATS_HISTORY;
+    profiler->statsFrameCount = oc_min(profiler->statsFrameCount + 1, OC_RUNTIME_CALL_STATS_HISTORY);
+    profiler->hotnessFrameCount++;
+}
+
+static int oc_runtime_call_stats_summary_cmp(const void* a, const void* b)
+{
+    f64 timeA = ((const oc_runtime_call_stats_summary*)a)->meanTime;
+    f64 timeB = ((const oc_runtime_call_stats_summary*)b)->meanTime;
+    return ((timeA < timeB) - (timeA > timeB));
+}
+
+u32 oc_runtime_call_stats_summarize(oc_arena* arena, oc_runtime_profiler* profiler, oc_runtime_call_stats_summary** summaries)
+{
+    u32 count = profiler->statsCount;
+    *summaries = oc_arena_push_array(arena, oc_runtime_call_stats_summary, count);
+
+    u32 index = 0;
+    oc_list_for(profiler->stats, stats, oc_runtime_call_stats, listElt)
+    {
+        oc_runtime_call_stats_summary* summary = &(*summaries)[index];
+        *summary = (oc_runtime_call_stats_summary){
+            .name = stats->name,
+            .isExport = stats->isExport,
+        };
+        for(u32 frame = 0; frame < profiler->statsFrameCount; frame++)
+        {
+            summary->meanCount += stats->historyCount[frame];
+            summary->meanTime += stats->historyTime[frame];
+            summary->maxTime = oc_max(summary->maxTime, stats->historyTime[frame]);
+        }
+        if(profiler->statsFrameCount)
+        {
+            summary->meanCount /= profiler->statsFrameCount;
+            summary->meanTime /= profiler->statsFrameCount;
+        }
+        index++;
+    }
+
+    //NOTE: most expensive first
+    qsort(*summaries, count, sizeof(oc_runtime_call_stats_summary), oc_runtime_call_stats_summary_cmp);
+    return (count);
+}
+
+//------------------------------------------------------------------------------------
+// hotness profile
+//------------------------------------------------------------------------------------
+
+void oc_runtime_hotness_start(oc_runtime_profiler* profiler, oc_wasm* wasm)
+{
+    if(profiler->hotnessEnabled)
+    {
+        return;
+    }
+    oc_runtime_call_stats_set(profiler, wasm, profiler->statsEnabled, true);
+}
+
+static int oc_runtime_hotness_cmp(const void* a, const void* b)
+{
+    f64 timeA = (*(oc_runtime_call_stats* const*)a)->totalTime;
+    f64 timeB = (*(oc_runtime_call_stats* const*)b)->totalTime;
+    return ((timeA < timeB) - (timeA > timeB));
+}
+
+void oc_runtime_hotness_stop(oc_runtime_profiler* profiler, oc_wasm* wasm, oc_str8 path)
+{
+    if(!profiler->hotnessEnabled)
+    {
+        return;
+    }
+
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    //NOTE: calls of the last, unfinished frame are counted too
+    oc_runtime_call_stats** sorted = oc_arena_push_array(scratch.arena, oc_runtime_call_stats*, profiler->statsCount);
+    u32 count = 0;
+    oc_list_for(profiler->stats, stats, oc_runtime_call_stats, listElt)
+    {
+        stats->totalCount += stats->frameCount;
+        stats->totalTime += stats->frameTime;
+        stats->frameCount = 0;
+        stats->frameTime = 0;
+        sorted[count++] = stats;
+    }
+    qsort(sorted, count, sizeof(oc_runtime_call_stats*), oc_runtime_hotness_cmp);
+
+    const char* pathCStr = oc_str8_to_cstring(scratch.arena, path);
+    FILE* file = fopen(pathCStr, "w");
+    if(!file)
+    {
+        oc_log_error("Could not open hotness profile file '%s': %s\n", pathCStr, strerror(errno));
+    }
+    else
+    {
+        fprintf(file, "# orca hotness profile, %llu frames\n", (unsigned long long)profiler->hotnessFrameCount);
+        for(u32 i = 0; i < count; i++)
+        {
+            fprintf(file,
+                    "%s %llu %.6f %.*s\n",
+                    sorted[i]->isExport ? "export" : "host",
+                    (unsigned long long)sorted[i]->totalCount,
+                    sorted[i]->totalTime,
+                    oc_str8_ip(sorted[i]->name));
+        }
+        fclose(file);
+
+        oc_log_info("wrote hotness profile of %u functions over %llu frames to '%s'\n",
+                    count,
+                    (unsigned long long)profiler->hotnessFrameCount,
+                    pathCStr);
+    }
+    oc_scratch_end(scratch);
+
+    oc_runtime_call_stats_set(profiler, wasm, profiler->statsEnabled, false);
+}
+
+//------------------------------------------------------------------------------------
+// startup timing
+//------------------------------------------------------------------------------------
+
+static const char* OC_RUNTIME_STARTUP_PHASE_NAMES[OC_RUNTIME_STARTUP_PHASE_COUNT] = {
+    [OC_RUNTIME_STARTUP_RENDERER] = "renderer",
+    [OC_RUNTIME_STARTUP_FONTS] = "fonts",
+    [OC_RUNTIME_STARTUP_WINDOWS] = "windows",
+    [OC_RUNTIME_STARTUP_MODULE_READ] = "module_read",
+    [OC_RUNTIME_STARTUP_DECODE] = "decode",
+    [OC_RUNTIME_STARTUP_LINK] = "link",
+    [OC_RUNTIME_STARTUP_INSTANTIATE] = "instantiate",
+    [OC_RUNTIME_STARTUP_EXPORTS] = "exports",
+    [OC_RUNTIME_STARTUP_APP_DATA] = "app_data",
+    [OC_RUNTIME_STARTUP_ON_INIT] = "on_init",
+    [OC_RUNTIME_STARTUP_FIRST_FRAME] = "first_frame",
+};
+
+void oc_runtime_startup_begin(oc_runtime_startup* startup)
+{
+    startup->phaseStart = oc_clock_time(OC_CLOCK_MONOTONIC);
+}
+
+void oc_runtime_startup_phase_end(oc_runtime_startup* startup, oc_runtime_startup_phase phase)
+{
+    //NOTE: phases run again on hot reload, they're only accumulated until the report
+    if(startup->done)
+    {
+        return;
+    }
+    f64 now = oc_clock_time(OC_CLOCK_MONOTONIC);
+    startup->phases[phase] += now - startup->phaseStart;
+    startup->phaseStart = now;
+}
+
+void oc_runtime_startup_report(oc_runtime_startup* startup, oc_str8 appName, oc_str8 path)
+{
+    if(startup->done)
+    {
+        return;
+    }
+    oc_runtime_startup_phase_end(startup, OC_RUNTIME_STARTUP_FIRST_FRAME);
+    startup->done = true;
+
+    //NOTE: time not covered by any phase, e.g. argument parsing, thread creation, or other apps starting first
+    f64 total = startup->phaseStart - startup->processStart;
+    f64 other = total;
+    for(int i = 0; i < OC_RUNTIME_STARTUP_PHASE_COUNT; i++)
+    {
+        other -= startup->phases[i];
+    }
+
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_str8_list list = { 0 };
+    oc_str8_list_pushf(scratch.arena, &list, "startup of %.*s in %.1fms:", oc_str8_ip(appName), total * 1000);
+    for(int i = 0; i < OC_RUNTIME_STARTUP_PHASE_COUNT; i++)
+    {
+        oc_str8_list_pushf(scratch.arena, &list, " %s %.1fms,", OC_RUNTIME_STARTUP_PHASE_NAMES[i], startup->phases[i] * 1000);
+    }
+    oc_str8_list_pushf(scratch.arena, &list, " other %.1fms\n", other * 1000);
+    oc_str8 line = oc_str8_list_join(scratch.arena, list);
+    oc_log_info("%.*s", oc_str8_ip(line));
+
+    const char* pathCStr = oc_str8_to_cstring(scratch.arena, path);
+    FILE* file = fopen(pathCStr, "w");
+    if(!file)
+    {
+        oc_log_error("Could not open startup report file '%s': %s\n", pathCStr, strerror(errno));
+    }
+    else
+    {
+        //NOTE: durations are in milliseconds
+        fprintf(file, "{\"version\":1,\"app\":\"");
+        oc_runtime_profiler_write_json_string(file, appName);
+        fprintf(file, "\",\"total\":%.3f,\"phases\":{", total * 1000);
+        for(int i = 0; i < OC_RUNTIME_STARTUP_PHASE_COUNT; i++)
+        {
+            fprintf(file, "\"%s\":%.3f,", OC_RUNTIME_STARTUP_PHASE_NAMES[i], startup->phases[i] * 1000);
+        }
+        fprintf(file, "\"other\":%.3f}}\n", other * 1000);
+        fclose(file);
+    }
+    oc_scratch_end(scratch);
+}
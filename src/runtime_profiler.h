@@ -0,0 +1,123 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "wasm/wasm.h"
+
+typedef struct oc_runtime_profiler_event
+{
+    oc_list_elt listElt;
+    oc_str8 name;
+    f64 start;
+    f64 end;
+} oc_runtime_profiler_event;
+
+enum
+{
+    OC_RUNTIME_CALL_STATS_HISTORY = 64,
+    OC_RUNTIME_CALL_STATS_BUCKETS = 512,
+};
+
+//NOTE: per-frame call counts and times of a guest export or host binding, over the last OC_RUNTIME_CALL_STATS_HISTORY frames
+typedef struct oc_runtime_call_stats
+{
+    oc_list_elt listElt;
+    oc_list_elt bucketElt;
+    void* key;
+    oc_str8 name;
+    bool isExport;
+
+    u64 frameCount;
+    f64 frameTime;
+
+    u64 historyCount[OC_RUNTIME_CALL_STATS_HISTORY];
+    f64 historyTime[OC_RUNTIME_CALL_STATS_HISTORY];
+
+    u64 totalCount;
+    f64 totalTime;
+} oc_runtime_call_stats;
+
+typedef struct oc_runtime_call_stats_summary
+{
+    oc_str8 name;
+    bool isExport;
+    f64 meanCount; // calls per frame
+    f64 meanTime;  // seconds per frame
+    f64 maxTime;   // seconds, worst frame in the history
+} oc_runtime_call_stats_summary;
+
+typedef struct oc_runtime_profiler
+{
+    bool enabled;
+    oc_arena arena;
+    oc_list events;
+    u64 eventCount;
+    f64 startTime;
+
+    bool statsEnabled;
+    oc_arena statsArena;
+    oc_list stats;
+    u32 statsCount;
+    oc_list statsBuckets[OC_RUNTIME_CALL_STATS_BUCKETS];
+    u32 statsFrameIndex;
+    u32 statsFrameCount;
+
+    bool hotnessEnabled;
+    u64 hotnessFrameCount;
+
+    oc_wasm_profile_hooks hooks;
+} oc_runtime_profiler;
+
+void oc_runtime_profiler_start(oc_runtime_profiler* profiler, oc_wasm* wasm);
+void oc_runtime_profiler_stop(oc_runtime_profiler* profiler, oc_wasm* wasm, oc_str8 path);
+
+void oc_runtime_call_stats_enable(oc_runtime_profiler* profiler, oc_wasm* wasm, bool enable);
+void oc_runtime_call_stats_frame_end(oc_runtime_profiler* profiler);
+u32 oc_runtime_call_stats_summarize(oc_arena* arena, oc_runtime_profiler* profiler, oc_runtime_call_stats_summary** summaries);
+
+//NOTE: the hotness profile accumulates call counts and times of guest exports and host bindings over a whole run,
+//      on top of the call stats. It is written as text, one line per function, from the hottest to the coldest:
+//
+//          # orca hotness profile, <frames> frames
+//          <export|host> <calls> <seconds> <name>
+//
+//      `orca bundle --hotness-profile` merges the profiles of representative runs to tune the module optimizer.
+void oc_runtime_hotness_start(oc_runtime_profiler* profiler, oc_wasm* wasm);
+void oc_runtime_hotness_stop(oc_runtime_profiler* profiler, oc_wasm* wasm, oc_str8 path);
+
+//NOTE: startup phases, from the start of the process to the first frame an app presents. The first three are done
+//      once for all apps, before their modules are loaded.
+typedef enum oc_runtime_startup_phase
+{
+    OC_RUNTIME_STARTUP_RENDERER,    // canvas renderer creation, including pipeline compilation
+    OC_RUNTIME_STARTUP_FONTS,       // debug overlay fonts
+    OC_RUNTIME_STARTUP_WINDOWS,     // windows, debug overlay surfaces and UI
+    OC_RUNTIME_STARTUP_MODULE_READ, // mapping the module
+    OC_RUNTIME_STARTUP_DECODE,      // oc_wasm_decode()
+    OC_RUNTIME_STARTUP_LINK,        // linking host bindings
+    OC_RUNTIME_STARTUP_INSTANTIATE, // oc_wasm_instantiate()
+    OC_RUNTIME_STARTUP_EXPORTS,     // finding and type checking exports and globals
+    OC_RUNTIME_STARTUP_APP_DATA,    // opening the app's data directory
+    OC_RUNTIME_STARTUP_ON_INIT,     // oc_on_init() and the first oc_on_resize()
+    OC_RUNTIME_STARTUP_FIRST_FRAME, // from the end of init to the first present
+    OC_RUNTIME_STARTUP_PHASE_COUNT,
+} oc_runtime_startup_phase;
+
+typedef struct oc_runtime_startup
+{
+    f64 processStart;
+    f64 phaseStart;
+    f64 phases[OC_RUNTIME_STARTUP_PHASE_COUNT]; // seconds
+    bool done;
+
+} oc_runtime_startup;
+
+void oc_runtime_startup_begin(oc_runtime_startup* startup);
+void oc_runtime_startup_phase_end(oc_runtime_startup* startup, oc_runtime_startup_phase phase);
+//NOTE: ends the first frame phase, logs the breakdown and writes it as JSON to path
+void oc_runtime_startup_report(oc_runtime_startup* startup, oc_str8 appName, oc_str8 path);
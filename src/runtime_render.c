@@ -0,0 +1,327 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include "runtime_render.h"
+
+static void oc_render_job_execute(oc_render_job* job)
+{
+    switch(job->kind)
+    {
+        case OC_RENDER_JOB_SUBMIT:
+            oc_canvas_renderer_submit(job->renderer,
+                                      job->surface,
+                                      job->msaaSampleCount,
+                                      job->clear,
+                                      job->clearColor,
+                                      job->damage,
+                                      job->primitiveCount,
+                                      job->primitives,
+                                      job->attributeCount,
+                                      job->attributes,
+                                      job->eltCount,
+                                      job->elements);
+            break;
+
+        case OC_RENDER_JOB_SUBMIT_IMAGE:
+            oc_canvas_renderer_submit_image(job->renderer,
+                                            job->image,
+                                            job->msaaSampleCount,
+                                            job->clear,
+                                            job->clearColor,
+                                            job->primitiveCount,
+                                            job->primitives,
+                                            job->attributeCount,
+                                            job->attributes,
+                                            job->eltCount,
+                                            job->elements);
+            break;
+
+        case OC_RENDER_JOB_RENDER_CONTEXT:
+            oc_canvas_render(job->renderer, job->context, job->surface);
+            break;
+
+        case OC_RENDER_JOB_PRESENT:
+            oc_canvas_present(job->renderer, job->surface);
+            oc_canvas_renderer_wait_frame_latency(job->renderer);
+            break;
+    }
+}
+
+static i32 oc_render_thread_proc(void* user)
+{
+    oc_render_thread* renderThread = (oc_render_thread*)user;
+
+    oc_mutex_lock(renderThread->mutex);
+    while(1)
+    {
+        oc_render_job* job = oc_list_pop_front_entry(&renderThread->pending, oc_render_job, listElt);
+        if(!job)
+        {
+            if(renderThread->quit)
+            {
+                break;
+            }
+            oc_condition_wait(renderThread->workCondition, renderThread->mutex);
+            continue;
+        }
+        oc_mutex_unlock(renderThread->mutex);
+
+        OC_TRACE_BEGIN("render job");
+        oc_render_job_execute(job);
+        OC_TRACE_END();
+
+        oc_mutex_lock(renderThread->mutex);
+        renderThread->doneSerial = job->serial;
+        if(job->kind == OC_RENDER_JOB_PRESENT)
+        {
+            renderThread->framesInFlight--;
+        }
+        oc_list_push_front(&renderThread->freeJobs, &job->listElt);
+        oc_condition_broadcast(renderThread->doneCondition);
+    }
+    oc_mutex_unlock(renderThread->mutex);
+    return (0);
+}
+
+void oc_render_thread_start(oc_render_thread* renderThread)
+{
+    memset(renderThread, 0, sizeof(oc_render_thread));
+    renderThread->mutex = oc_mutex_create();
+    renderThread->workCondition = oc_condition_create();
+    renderThread->doneCondition = oc_condition_create();
+    oc_list_init(&renderThread->pending);
+    oc_list_init(&renderThread->freeJobs);
+    renderThread->nextSerial = 1;
+
+    oc_thread_options threadOptions = {
+        .name = OC_STR8("render"),
+        .priority = OC_THREAD_PRIORITY_FRAME,
+    };
+    renderThread->thread = oc_thread_create_with_options(oc_render_thread_proc, renderThread, &threadOptions);
+    renderThread->enabled = true;
+}
+
+void oc_render_thread_stop(oc_render_thread* renderThread)
+{
+    if(!renderThread->enabled)
+    {
+        return;
+    }
+
+    //NOTE: the thread executes the jobs that are still queued before exiting
+    oc_mutex_lock(renderThread->mutex);
+    renderThread->quit = true;
+    oc_condition_signal(renderThread->workCondition);
+    oc_mutex_unlock(renderThread->mutex);
+
+    oc_thread_join(renderThread->thread, 0);
+
+    oc_list_for_safe(renderThread->freeJobs, job, oc_render_job, listElt)
+    {
+        free(job->data);
+        free(job);
+    }
+    oc_condition_destroy(renderThread->workCondition);
+    oc_condition_destroy(renderThread->doneCondition);
+    oc_mutex_destroy(renderThread->mutex);
+
+    memset(renderThread, 0, sizeof(oc_render_thread));
+}
+
+static oc_render_job* oc_render_job_alloc(oc_render_thread* renderThread, oc_render_job_kind kind)
+{
+    oc_mutex_lock(renderThread->mutex);
+    oc_render_job* job = oc_list_pop_front_entry(&renderThread->freeJobs, oc_render_job, listElt);
+    oc_mutex_unlock(renderThread->mutex);
+
+    if(!job)
+    {
+        job = oc_malloc_type(oc_render_job);
+        memset(job, 0, sizeof(oc_render_job));
+    }
+
+    char* data = job->data;
+    u64 dataCap = job->dataCap;
+    memset(job, 0, sizeof(oc_render_job));
+    job->data = data;
+    job->dataCap = dataCap;
+    job->kind = kind;
+
+    return (job);
+}
+
+static void oc_render_job_copy_commands(oc_render_job* job,
+                                        u32 primitiveCount,
+                                        oc_primitive* primitives,
+                                        u32 attributeCount,
+                                        oc_attributes* attributes,
+                                        u32 eltCount,
+                                        oc_path_elt* elements)
+{
+    u64 primitivesSize = oc_align_up_pow2(primitiveCount * sizeof(oc_primitive), 16);
+    u64 attributesSize = oc_align_up_pow2(attributeCount * sizeof(oc_attributes), 16);
+    u64 elementsSize = eltCount * sizeof(oc_path_elt);
+    u64 size = primitivesSize + attributesSize + elementsSize;
+
+    if(size > job->dataCap)
+    {
+        u64 cap = oc_max(size, 2 * job->dataCap);
+        char* data = realloc(job->data, cap);
+        if(!data)
+        {
+            //NOTE: the job still runs, with an empty command stream
+            oc_log_error("couldn't allocate render job commands\n");
+            return;
+        }
+        job->data = data;
+        job->dataCap = cap;
+    }
+
+    job->primitives = (oc_primitive*)job->data;
+    job->attributes = (oc_attributes*)(job->data + primitivesSize);
+    job->elements = (oc_path_elt*)(job->data + primitivesSize + attributesSize);
+
+    memcpy(job->primitives, primitives, primitiveCount * sizeof(oc_primitive));
+    memcpy(job->attributes, attributes, attributeCount * sizeof(oc_attributes));
+    memcpy(job->elements, elements, eltCount * sizeof(oc_path_elt));
+
+    job->primitiveCount = primitiveCount;
+    job->attributeCount = attributeCount;
+    job->eltCount = eltCount;
+}
+
+static u64 oc_render_job_push(oc_render_thread* renderThread, oc_render_job* job)
+{
+    oc_mutex_lock(renderThread->mutex);
+    job->serial = renderThread->nextSerial;
+    renderThread->nextSerial++;
+    if(job->kind == OC_RENDER_JOB_PRESENT)
+    {
+        renderThread->framesInFlight++;
+    }
+    oc_list_push_back(&renderThread->pending, &job->listElt);
+    oc_condition_signal(renderThread->workCondition);
+    oc_mutex_unlock(renderThread->mutex);
+
+    return (job->serial);
+}
+
+u64 oc_render_thread_submit(oc_render_thread* renderThread,
+                            oc_canvas_renderer renderer,
+                            oc_surface surface,
+                            u32 msaaSampleCount,
+                            bool clear,
+                            oc_color clearColor,
+                            oc_rect damage,
+                            u32 primitiveCount,
+                            oc_primitive* primitives,
+                            u32 attributeCount,
+                            oc_attributes* attributes,
+                            u32 eltCount,
+                            oc_path_elt* elements)
+{
+    oc_render_job* job = oc_render_job_alloc(renderThread, OC_RENDER_JOB_SUBMIT);
+    job->renderer = renderer;
+    job->surface = surface;
+    job->msaaSampleCount = msaaSampleCount;
+    job->clear = clear;
+    job->clearColor = clearColor;
+    job->damage = damage;
+
+    OC_TRACE_BEGIN("render job copy");
+    oc_render_job_copy_commands(job, primitiveCount, primitives, attributeCount, attributes, eltCount, elements);
+    OC_TRACE_END();
+
+    return (oc_render_job_push(renderThread, job));
+}
+
+u64 oc_render_thread_submit_image(oc_render_thread* renderThread,
+                                  oc_canvas_renderer renderer,
+                                  oc_image image,
+                                  u32 msaaSampleCount,
+                                  bool clear,
+                                  oc_color clearColor,
+                                  u32 primitiveCount,
+                                  oc_primitive* primitives,
+                                  u32 attributeCount,
+                                  oc_attributes* attributes,
+                                  u32 eltCount,
+                                  oc_path_elt* elements)
+{
+    oc_render_job* job = oc_render_job_alloc(renderThread, OC_RENDER_JOB_SUBMIT_IMAGE);
+    job->renderer = renderer;
+    job->image = image;
+    job->msaaSampleCount = msaaSampleCount;
+    job->clear = clear;
+    job->clearColor = clearColor;
+
+    OC_TRACE_BEGIN("render job copy");
+    oc_render_job_copy_commands(job, primitiveCount, primitives, attributeCount, attributes, eltCount, elements);
+    OC_TRACE_END();
+
+    return (oc_render_job_push(renderThread, job));
+}
+
+u64 oc_render_thread_render_context(oc_render_thread* renderThread, oc_canvas_renderer renderer, oc_canvas_context context, oc_surface surface)
+{
+    oc_render_job* job = oc_render_job_alloc(renderThread, OC_RENDER_JOB_RENDER_CONTEXT);
+    job->renderer = renderer;
+    job->context = context;
+    job->surface = surface;
+    return (oc_render_job_push(renderThread, job));
+}
+
+u64 oc_render_thread_present(oc_render_thread* renderThread, oc_canvas_renderer renderer, oc_surface surface)
+{
+    oc_render_job* job = oc_render_job_alloc(renderThread, OC_RENDER_JOB_PRESENT);
+    job->renderer = renderer;
+    job->surface = surface;
+    return (oc_render_job_push(renderThread, job));
+}
+
+void oc_render_thread_wait(oc_render_thread* renderThread, u64 serial)
+{
+    if(!renderThread->enabled)
+    {
+        return;
+    }
+    oc_mutex_lock(renderThread->mutex);
+    while(renderThread->doneSerial < serial)
+    {
+        oc_condition_wait(renderThread->doneCondition, renderThread->mutex);
+    }
+    oc_mutex_unlock(renderThread->mutex);
+}
+
+void oc_render_thread_sync(oc_render_thread* renderThread)
+{
+    if(!renderThread->enabled)
+    {
+        return;
+    }
+    oc_mutex_lock(renderThread->mutex);
+    u64 serial = renderThread->nextSerial - 1;
+    while(renderThread->doneSerial < serial)
+    {
+        oc_condition_wait(renderThread->doneCondition, renderThread->mutex);
+    }
+    oc_mutex_unlock(renderThread->mutex);
+}
+
+void oc_render_thread_wait_frames(oc_render_thread* renderThread, u32 maxFrames)
+{
+    if(!renderThread->enabled)
+    {
+        return;
+    }
+    oc_mutex_lock(renderThread->mutex);
+    while(renderThread->framesInFlight > maxFrames)
+    {
+        oc_condition_wait(renderThread->doneCondition, renderThread->mutex);
+    }
+    oc_mutex_unlock(renderThread->mutex);
+}
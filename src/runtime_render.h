@@ -0,0 +1,116 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "graphics/graphics_common.h"
+#include "platform/platform_thread.h"
+
+/*NOTE:
+	In render thread mode, canvas submissions and presents made by the runloop are queued as jobs, and a dedicated
+	thread executes them in order. Submissions copy the frame's command stream, so the guest can start building
+	the next frame while the previous one is encoded and presented.
+
+	Any other use of the renderer from the runloop must first call oc_render_thread_sync(), so that it doesn't
+	overlap or reorder with queued jobs.
+*/
+typedef enum oc_render_job_kind
+{
+    OC_RENDER_JOB_SUBMIT,
+    OC_RENDER_JOB_SUBMIT_IMAGE,
+    OC_RENDER_JOB_RENDER_CONTEXT,
+    OC_RENDER_JOB_PRESENT,
+} oc_render_job_kind;
+
+typedef struct oc_render_job
+{
+    oc_list_elt listElt;
+    oc_render_job_kind kind;
+    u64 serial;
+
+    oc_canvas_renderer renderer;
+    oc_surface surface;
+    oc_image image;
+    oc_canvas_context context;
+
+    u32 msaaSampleCount;
+    bool clear;
+    oc_color clearColor;
+    oc_rect damage;
+
+    u32 primitiveCount;
+    oc_primitive* primitives;
+    u32 attributeCount;
+    oc_attributes* attributes;
+    u32 eltCount;
+    oc_path_elt* elements;
+
+    //NOTE: copy of the command stream, which the arrays above point into. It is kept when the job is recycled.
+    char* data;
+    u64 dataCap;
+
+} oc_render_job;
+
+typedef struct oc_render_thread
+{
+    bool enabled;
+    oc_thread* thread;
+    oc_mutex* mutex;
+    oc_condition* workCondition;
+    oc_condition* doneCondition;
+
+    oc_list pending;
+    oc_list freeJobs;
+    u64 nextSerial;
+    u64 doneSerial;
+    u32 framesInFlight; // presents that were queued but not executed yet
+    bool quit;
+
+} oc_render_thread;
+
+void oc_render_thread_start(oc_render_thread* renderThread);
+void oc_render_thread_stop(oc_render_thread* renderThread);
+
+//NOTE: these queue a job and return its serial, which can be passed to oc_render_thread_wait()
+u64 oc_render_thread_submit(oc_render_thread* renderThread,
+                            oc_canvas_renderer renderer,
+                            oc_surface surface,
+                            u32 msaaSampleCount,
+                            bool clear,
+                            oc_color clearColor,
+                            oc_rect damage,
+                            u32 primitiveCount,
+                            oc_primitive* primitives,
+                            u32 attributeCount,
+                            oc_attributes* attributes,
+                            u32 eltCount,
+                            oc_path_elt* elements);
+
+u64 oc_render_thread_submit_image(oc_render_thread* renderThread,
+                                  oc_canvas_renderer renderer,
+                                  oc_image image,
+                                  u32 msaaSampleCount,
+                                  bool clear,
+                                  oc_color clearColor,
+                                  u32 primitiveCount,
+                                  oc_primitive* primitives,
+                                  u32 attributeCount,
+                                  oc_attributes* attributes,
+                                  u32 eltCount,
+                                  oc_path_elt* elements);
+
+//NOTE: renders context on the render thread without copying it. The context must not be used until the job is done.
+u64 oc_render_thread_render_context(oc_render_thread* renderThread, oc_canvas_renderer renderer, oc_canvas_context context, oc_surface surface);
+
+//NOTE: presents surface, then waits for the renderer's frame latency on the render thread
+u64 oc_render_thread_present(oc_render_thread* renderThread, oc_canvas_renderer renderer, oc_surface surface);
+
+void oc_render_thread_wait(oc_render_thread* renderThread, u64 serial);
+void oc_render_thread_sync(oc_render_thread* renderThread);
+
+//NOTE: waits until at most maxFrames presents are queued
+void oc_render_thread_wait_frames(oc_render_thread* renderThread, u32 maxFrames);
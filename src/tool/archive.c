@@ -0,0 +1,302 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "zlib.h"
+
+#include "archive.h"
+#include "runtime_archive.h"
+#include "system.h"
+
+typedef struct archive_file
+{
+    oc_list_elt node;
+    oc_str8 name;
+    oc_str8 source;
+    u64 hash;
+} archive_file;
+
+static void archive_add_file(oc_arena* a, oc_list* files, oc_str8 name, oc_str8 source)
+{
+    u64 hash = oc_hash_xx64_string(name);
+
+    //NOTE: files added later replace files with the same name, like when copying them to the data directory
+    oc_list_for(*files, file, archive_file, node)
+    {
+        if(file->hash == hash && !oc_str8_cmp(file->name, name))
+        {
+            file->source = source;
+            return;
+        }
+    }
+
+    archive_file* file = oc_arena_push_type(a, archive_file);
+    file->name = name;
+    file->source = source;
+    file->hash = hash;
+    oc_list_push_back(files, &file->node);
+}
+
+static void archive_add_dir(oc_arena* a, oc_list* files, oc_str8 prefix, oc_str8 dir)
+{
+    oc_list entries = oc_sys_read_dir(a, dir);
+    oc_list_for(entries, entry, oc_sys_dir_entry, node)
+    {
+        oc_str8 source = oc_path_append(a, dir, entry->name);
+        oc_str8 name = prefix.len
+                         ? oc_str8_pushf(a, "%.*s/%.*s", oc_str8_ip(prefix), oc_str8_ip(entry->name))
+                         : entry->name;
+
+        if(entry->is_dir)
+        {
+            archive_add_dir(a, files, name, source);
+        }
+        else
+        {
+            archive_add_file(a, files, name, source);
+        }
+    }
+}
+
+//NOTE: compresses contents in independent chunks, laid out as described in runtime_archive.h. Returns an
+//      empty string if compression doesn't save at least an eighth of the size, so the entry is stored as is.
+static oc_str8 archive_deflate(oc_arena* a, oc_str8 contents, u32* chunkCount)
+{
+    *chunkCount = (contents.len + OC_ARCHIVE_CHUNK_SIZE - 1) / OC_ARCHIVE_CHUNK_SIZE;
+
+    u64 tableSize = ((u64)*chunkCount + 1) * sizeof(u64);
+    u64 capacity = tableSize + (u64)*chunkCount * compressBound(OC_ARCHIVE_CHUNK_SIZE);
+    u64 maxSize = contents.len - contents.len / 8;
+
+    if(!contents.len || tableSize >= maxSize)
+    {
+        return ((oc_str8){ 0 });
+    }
+
+    oc_arena_scope scratch = oc_scratch_begin_next(a);
+    char* stored = oc_arena_push(scratch.arena, capacity);
+    u64* chunkOffsets = (u64*)stored;
+    u64 storedSize = tableSize;
+
+    for(u32 i = 0; i < *chunkCount; i++)
+    {
+        u64 chunkStart = (u64)i * OC_ARCHIVE_CHUNK_SIZE;
+        uLongf compressedSize = capacity - storedSize;
+
+        chunkOffsets[i] = storedSize;
+        if(compress2((Bytef*)(stored + storedSize),
+                     &compressedSize,
+                     (const Bytef*)(contents.ptr + chunkStart),
+                     oc_min(contents.len - chunkStart, OC_ARCHIVE_CHUNK_SIZE),
+                     Z_BEST_COMPRESSION)
+           != Z_OK)
+        {
+            oc_scratch_end(scratch);
+            return ((oc_str8){ 0 });
+        }
+        storedSize += compressedSize;
+    }
+    chunkOffsets[*chunkCount] = storedSize;
+
+    oc_str8 result = { 0 };
+    if(storedSize < maxSize)
+    {
+        result = oc_str8_push_buffer(a, storedSize, stored);
+    }
+    oc_scratch_end(scratch);
+    return (result);
+}
+
+static int archive_entry_compare(const void* a, const void* b)
+{
+    const oc_archive_entry* entryA = (const oc_archive_entry*)a;
+    const oc_archive_entry* entryB = (const oc_archive_entry*)b;
+    return (entryA->hash < entryB->hash ? -1 : (entryA->hash > entryB->hash ? 1 : 0));
+}
+
+static bool archive_write_padding(FILE* out, u64* offset)
+{
+    static const char zeros[OC_ARCHIVE_ALIGNMENT] = { 0 };
+    u64 padding = oc_align_up_pow2(*offset, OC_ARCHIVE_ALIGNMENT) - *offset;
+    *offset += padding;
+    return (fwrite(zeros, 1, padding, out) == padding);
+}
+
+bool archive_write(oc_arena* a, oc_str8_list resource_files, oc_str8_list resource_dirs, oc_str8 outPath)
+{
+    oc_list files = { 0 };
+    u32 fileCount = 0;
+
+    //NOTE: collect files with the same layout as the data directory would have
+    oc_str8_list_for(resource_files, it)
+    {
+        oc_str8 resource_file = it->string;
+        if(oc_sys_isdir(resource_file))
+        {
+            printf("Error: Got %.*s as a resource file, but it is a directory. Ignoring.",
+                   oc_str8_ip(resource_file));
+        }
+        else
+        {
+            archive_add_file(a, &files, oc_path_slice_filename(resource_file), resource_file);
+        }
+    }
+
+    oc_str8_list_for(resource_dirs, it)
+    {
+        oc_str8 resource_dir = it->string;
+        if(oc_sys_isdir(resource_dir))
+        {
+            archive_add_dir(a, &files, (oc_str8){ 0 }, resource_dir);
+        }
+        else
+        {
+            printf("Error: Got %.*s as a resource dir, but it is not a directory. Ignoring.",
+                   oc_str8_ip(resource_dir));
+        }
+    }
+
+    oc_list_for(files, file, archive_file, node)
+    {
+        fileCount++;
+    }
+
+    //NOTE: build the index and name table. Contents are laid out in the order files were collected.
+    oc_archive_entry* entries = oc_arena_push_array(a, oc_archive_entry, fileCount);
+    oc_str8* sources = oc_arena_push_array(a, oc_str8, fileCount);
+    oc_str8_list names = { 0 };
+    u64 namesSize = 0;
+    {
+        u32 index = 0;
+        oc_list_for(files, file, archive_file, node)
+        {
+            entries[index] = (oc_archive_entry){
+                .hash = file->hash,
+                .nameOffset = namesSize,
+                .nameLen = file->name.len,
+                .compression = OC_ARCHIVE_COMPRESSION_NONE,
+                //NOTE: stash the source index in offset until contents are written
+                .offset = index,
+            };
+            sources[index] = file->source;
+            oc_str8_list_push(a, &names, file->name);
+            namesSize += file->name.len;
+            index++;
+        }
+    }
+
+    oc_archive_header header = {
+        .version = OC_ARCHIVE_VERSION,
+        .entryCount = fileCount,
+        .indexOffset = oc_align_up_pow2(sizeof(oc_archive_header), OC_ARCHIVE_ALIGNMENT),
+    };
+    memcpy(header.magic, OC_ARCHIVE_MAGIC, sizeof(header.magic));
+    header.namesOffset = header.indexOffset + fileCount * sizeof(oc_archive_entry);
+    header.namesSize = namesSize;
+
+    //NOTE: load and compress contents to compute their offsets, then sort the index by hash
+    oc_str8* stored = oc_arena_push_array(a, oc_str8, fileCount);
+    u64 dataOffset = oc_align_up_pow2(header.namesOffset + namesSize, OC_ARCHIVE_ALIGNMENT);
+    for(u32 i = 0; i < fileCount; i++)
+    {
+        oc_file file = oc_file_open(sources[i], OC_FILE_ACCESS_READ, OC_FILE_OPEN_NONE);
+        if(oc_file_last_error(file) != OC_IO_OK)
+        {
+            oc_file_close(file);
+            snprintf(oc_sys_err.msg, OC_SYS_MAX_ERROR, "failed to open resource file \"%.*s\"", oc_str8_ip(sources[i]));
+            oc_sys_err.code = 1;
+            return false;
+        }
+        u64 size = oc_file_size(file);
+        oc_str8 contents = oc_str8_from_buffer(size, oc_arena_push(a, size));
+        u64 readSize = size ? oc_file_read(file, size, contents.ptr) : 0;
+        oc_file_close(file);
+
+        if(readSize != size)
+        {
+            snprintf(oc_sys_err.msg, OC_SYS_MAX_ERROR, "failed to read resource file \"%.*s\"", oc_str8_ip(sources[i]));
+            oc_sys_err.code = 1;
+            return false;
+        }
+
+        u32 chunkCount = 0;
+        oc_str8 compressed = archive_deflate(a, contents, &chunkCount);
+        if(compressed.len)
+        {
+            entries[i].compression = OC_ARCHIVE_COMPRESSION_DEFLATE;
+            entries[i].chunkCount = chunkCount;
+            stored[i] = compressed;
+        }
+        else
+        {
+            stored[i] = contents;
+        }
+
+        entries[i].offset = dataOffset;
+        entries[i].size = size;
+        entries[i].storedSize = stored[i].len;
+        dataOffset = oc_align_up_pow2(dataOffset + stored[i].len, OC_ARCHIVE_ALIGNMENT);
+    }
+
+    oc_archive_entry* sortedEntries = oc_arena_push_array(a, oc_archive_entry, fileCount);
+    memcpy(sortedEntries, entries, fileCount * sizeof(oc_archive_entry));
+    qsort(sortedEntries, fileCount, sizeof(oc_archive_entry), archive_entry_compare);
+
+    //NOTE: write the archive
+    oc_arena_scope scratch = oc_scratch_begin_next(a);
+    char* outPathCStr = oc_str8_to_cstring(scratch.arena, outPath);
+    FILE* out = fopen(outPathCStr, "wb");
+    if(!out)
+    {
+        snprintf(oc_sys_err.msg, OC_SYS_MAX_ERROR, "failed to create data archive \"%.*s\"", oc_str8_ip(outPath));
+        oc_sys_err.code = 1;
+        oc_scratch_end(scratch);
+        return false;
+    }
+
+    bool ok = true;
+    u64 offset = 0;
+
+    ok = ok && fwrite(&header, sizeof(header), 1, out) == 1;
+    offset += sizeof(header);
+    ok = ok && archive_write_padding(out, &offset);
+
+    ok = ok && (fileCount == 0 || fwrite(sortedEntries, sizeof(oc_archive_entry), fileCount, out) == fileCount);
+    offset += fileCount * sizeof(oc_archive_entry);
+
+    oc_str8_list_for(names, it)
+    {
+        ok = ok && fwrite(it->string.ptr, 1, it->string.len, out) == it->string.len;
+        offset += it->string.len;
+    }
+    ok = ok && archive_write_padding(out, &offset);
+
+    for(u32 i = 0; ok && i < fileCount; i++)
+    {
+        OC_ASSERT(offset == entries[i].offset);
+
+        ok = ok && fwrite(stored[i].ptr, 1, stored[i].len, out) == stored[i].len;
+        offset += stored[i].len;
+        ok = ok && archive_write_padding(out, &offset);
+    }
+
+    if(fclose(out))
+    {
+        ok = false;
+    }
+
+    if(!ok)
+    {
+        snprintf(oc_sys_err.msg, OC_SYS_MAX_ERROR, "failed to write data archive \"%.*s\"", oc_str8_ip(outPath));
+        oc_sys_err.code = 1;
+    }
+
+    oc_scratch_end(scratch);
+    return ok;
+}
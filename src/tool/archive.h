@@ -0,0 +1,13 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "orca.h"
+
+// Packs resource files and the contents of resource directories into a single data archive at outPath.
+bool archive_write(oc_arena* a, oc_str8_list resource_files, oc_str8_list resource_dirs, oc_str8 outPath);
@@ -9,10 +9,13 @@
 //#include <processenv.h>
 #include <stdio.h>
 
+#include "archive.h"
+#include "bundle_manifest.h"
 #include "flag.h"
 #include "orca.h"
 #include "util.h"
 #include "system.h"
+#include "wasm_strip.h"
 
 #if OC_PLATFORM_WINDOWS
     #include "win32_icon.c"
@@ -25,6 +28,13 @@ int winBundle(
     oc_str8 version,
     oc_str8_list resource_files,
     oc_str8_list resource_dirs,
+    bool dataArchive,
+    bool clean,
+    bool hardlink,
+    bool stripWasm,
+    bool optimizeWasm,
+    oc_str8_list hotnessProfiles,
+    oc_str8_list engineOptions,
     oc_str8 app_version,
     oc_str8 outDir,
     oc_str8 module);
@@ -36,6 +46,13 @@ int macBundle(
     oc_str8 version,
     oc_str8_list resource_files,
     oc_str8_list resource_dirs,
+    bool dataArchive,
+    bool clean,
+    bool hardlink,
+    bool stripWasm,
+    bool optimizeWasm,
+    oc_str8_list hotnessProfiles,
+    oc_str8_list engineOptions,
     oc_str8 app_version,
     oc_str8 outDir,
     oc_str8 module,
@@ -56,6 +73,13 @@ int bundle(int argc, char** argv)
     char** version = flag_str(&c, "v", "version", NULL, "select a specific version of the Orca SDK (default is latest version)");
     oc_str8_list* resource_files = flag_strs(&c, "d", "resource", "copy a file to the app's resource directory");
     oc_str8_list* resource_dirs = flag_strs(&c, "D", "resource-dir", "copy the contents of a folder to the app's resource directory");
+    bool* dataArchive = flag_bool(&c, "A", "data-archive", false, "pack resources into a single indexed archive instead of copying them as loose files. Compressible files are stored deflated");
+    bool* clean = flag_bool(&c, NULL, "clean", false, "rebuild the bundle from scratch instead of only copying files that changed since the last bundle");
+    bool* hardlink = flag_bool(&c, "L", "hardlink", false, "hardlink runtime files and resources into the bundle instead of copying them, when possible (Windows only, files are cloned on macOS). Files written to the bundle also modify the originals");
+    bool* stripWasm = flag_bool(&c, NULL, "strip-wasm", false, "remove custom sections (debug info, names...) from the wasm module. The name section is saved to a separate module.names.wasm file");
+    bool* optimizeWasm = flag_bool(&c, NULL, "optimize-wasm", false, "optimize the wasm module with wasm-opt, which must be in your PATH (see https://github.com/WebAssembly/binaryen)");
+    oc_str8_list* hotnessProfiles = flag_strs(&c, NULL, "hotness-profile", "a hotness profile written by the runtime's --hotness-profile flag, used to tune --optimize-wasm (can be repeated to merge several runs)");
+    oc_str8_list* engineOptions = flag_strs(&c, NULL, "wasm-engine", "set an option of the runtime's wasm engine, e.g. vm=register, stack-size=1m or debug (can be repeated)");
     char** app_version = flag_str(&c, NULL, "app-version", "0.0.0", "a version number to embed in the application bundle");
     char** outDir = flag_str(&c, "C", "out-dir", NULL, "where to place the final application bundle (defaults to the current directory)");
     bool* mtlEnableCapture = flag_bool(&c, "M", "mtl-enable-capture", false, "enable Metal frame capture in Xcode for the application bundle (macOS only)");
@@ -88,6 +112,13 @@ int bundle(int argc, char** argv)
         OC_STR8(*version),
         *resource_files,
         *resource_dirs,
+        *dataArchive,
+        *clean,
+        *hardlink,
+        *stripWasm,
+        *optimizeWasm,
+        *hotnessProfiles,
+        *engineOptions,
         OC_STR8(*app_version),
         OC_STR8(*outDir),
         OC_STR8(*module));
@@ -99,6 +130,13 @@ int bundle(int argc, char** argv)
         OC_STR8(*version),
         *resource_files,
         *resource_dirs,
+        *dataArchive,
+        *clean,
+        *hardlink,
+        *stripWasm,
+        *optimizeWasm,
+        *hotnessProfiles,
+        *engineOptions,
         OC_STR8(*app_version),
         OC_STR8(*outDir),
         OC_STR8(*module),
@@ -108,6 +146,166 @@ int bundle(int argc, char** argv)
 #endif
 }
 
+//NOTE: writes the wasm engine options to wasmDir/engine.txt, one per line, where the runtime reads them. Without
+//      options the file isn't written, so that a previous one is removed as stale.
+static int bundle_wasm_engine_options(oc_arena* a, bundle_manifest* manifest, oc_str8 wasmDir, oc_str8_list engineOptions)
+{
+    if(engineOptions.eltCount == 0)
+    {
+        return 0;
+    }
+
+    oc_str8 optionsPath = oc_path_append(a, wasmDir, OC_STR8("engine.txt"));
+    oc_str8 contents = oc_str8_list_collate(a, engineOptions, OC_STR8(""), OC_STR8("\n"), OC_STR8("\n"));
+
+    oc_str8 path = oc_path_append(a, manifest->bundleDir, optionsPath);
+    oc_file file = oc_file_open(path, OC_FILE_ACCESS_WRITE, OC_FILE_OPEN_CREATE | OC_FILE_OPEN_TRUNCATE);
+    if(oc_file_last_error(file) != OC_IO_OK)
+    {
+        fprintf(stderr, "Error: failed to create wasm engine options file \"%.*s\"\n", oc_str8_ip(path));
+        oc_file_close(file);
+        return 1;
+    }
+    oc_file_write(file, contents.len, contents.ptr);
+    oc_io_error error = oc_file_last_error(file);
+    oc_file_close(file);
+    if(error != OC_IO_OK)
+    {
+        fprintf(stderr, "Error: failed to write wasm engine options file \"%.*s\"\n", oc_str8_ip(path));
+        return 1;
+    }
+    bundle_manifest_add_generated(manifest, optionsPath);
+    return 0;
+}
+
+//NOTE: merges the hotness profiles of representative runs, and picks wasm-opt's optimization level from the share of
+//      time spent in guest code. Host binding calls are nested in the export calls that make them, so the guest's own
+//      time is the exports' time minus the host bindings' time. When the guest's own code dominates, -O3 trades size
+//      for speed with more inlining and unrolling. When most of the time is spent in host bindings, -Os makes the
+//      module smaller and faster to load and compile, and loses little. Without usable profiles this is -O2.
+static bool bundle_hotness_opt_level(oc_arena* a, oc_str8_list profiles, const char** level)
+{
+    *level = "-O2";
+    if(profiles.eltCount == 0)
+    {
+        return true;
+    }
+
+    f64 exportTime = 0;
+    f64 hostTime = 0;
+    u64 frameCount = 0;
+
+    oc_str8_list_for(profiles, it)
+    {
+        oc_file file = oc_file_open(it->string, OC_FILE_ACCESS_READ, OC_FILE_OPEN_NONE);
+        if(oc_file_last_error(file) != OC_IO_OK)
+        {
+            fprintf(stderr, "error: failed to open hotness profile \"%.*s\"\n", oc_str8_ip(it->string));
+            oc_file_close(file);
+            return false;
+        }
+        u64 size = oc_file_size(file);
+        char* contents = oc_arena_push(a, size);
+        size = oc_file_read(file, size, contents);
+        oc_file_close(file);
+
+        oc_str8_list separators = { 0 };
+        oc_str8_list_push(a, &separators, OC_STR8("\n"));
+        oc_str8_list_push(a, &separators, OC_STR8("\r"));
+        oc_str8_list lines = oc_str8_split(a, oc_str8_from_buffer(size, contents), separators);
+
+        oc_str8_list_for(lines, line)
+        {
+            const char* lineCStr = oc_str8_to_cstring(a, line->string);
+            char kind[16];
+            unsigned long long calls = 0;
+            double seconds = 0;
+            unsigned long long frames = 0;
+
+            if(sscanf(lineCStr, "# orca hotness profile, %llu frames", &frames) == 1)
+            {
+                frameCount += frames;
+            }
+            else if(line->string.len && line->string.ptr[0] != '#')
+            {
+                if(sscanf(lineCStr, "%15s %llu %lf", kind, &calls, &seconds) != 3)
+                {
+                    fprintf(stderr, "warning: ignoring malformed line in hotness profile \"%.*s\": %s\n", oc_str8_ip(it->string), lineCStr);
+                }
+                else if(!strcmp(kind, "export"))
+                {
+                    exportTime += seconds;
+                }
+                else if(!strcmp(kind, "host"))
+                {
+                    hostTime += seconds;
+                }
+            }
+        }
+    }
+
+    if(exportTime <= 0)
+    {
+        fprintf(stderr, "warning: hotness profiles don't record any time in guest code, optimizing with -O2\n");
+        return true;
+    }
+
+    f64 guestShare = oc_clamp_low((exportTime - hostTime) / exportTime, 0);
+    *level = guestShare >= 0.5 ? "-O3" : "-Os";
+
+    printf("hotness profiles: %llu frames, %.1f%% of guest time in guest code, optimizing with %s\n",
+           (unsigned long long)frameCount,
+           guestShare * 100,
+           *level);
+    return true;
+}
+
+//NOTE: copies the wasm module to wasmDir/module.wasm, optionally optimizing it and stripping its custom sections
+static int bundle_wasm_module(oc_arena* a, bundle_manifest* manifest, oc_str8 module, oc_str8 wasmDir, bool strip, bool optimize, oc_str8_list hotnessProfiles)
+{
+    oc_str8 modulePath = oc_path_append(a, wasmDir, OC_STR8("module.wasm"));
+    if(!strip && !optimize)
+    {
+        TRY(bundle_copy_file(manifest, module, modulePath, BUNDLE_COPY_NONE, 0, 0));
+        return 0;
+    }
+
+    oc_str8 moduleOut = oc_path_append(a, manifest->bundleDir, modulePath);
+    oc_str8 strip_input = module;
+    if(optimize)
+    {
+        const char* level = 0;
+        TRY(bundle_hotness_opt_level(a, hotnessProfiles, &level));
+
+        //NOTE: keep the name section if we're going to strip the module, so that it can be saved separately
+        oc_str8 cmd = oc_str8_pushf(a,
+                                    "wasm-opt %s %s \"%.*s\" -o \"%.*s\"",
+                                    level,
+                                    strip ? "--debuginfo" : "",
+                                    oc_str8_ip(module),
+                                    oc_str8_ip(moduleOut));
+        if(system(cmd.ptr))
+        {
+            fprintf(stderr, "error: failed to optimize wasm module \"%.*s\". Make sure wasm-opt is in your PATH.\n", oc_str8_ip(module));
+            return 1;
+        }
+        strip_input = moduleOut;
+    }
+
+    if(strip)
+    {
+        oc_str8 namesPath = oc_path_append(a, wasmDir, OC_STR8("module.names.wasm"));
+        bool hasNames = false;
+        TRY(wasm_strip(a, strip_input, moduleOut, oc_path_append(a, manifest->bundleDir, namesPath), &hasNames));
+        if(hasNames)
+        {
+            bundle_manifest_add_generated(manifest, namesPath);
+        }
+    }
+    bundle_manifest_add_generated(manifest, modulePath);
+    return 0;
+}
+
 #if OC_PLATFORM_WINDOWS
 
 int winBundle(
@@ -117,6 +315,13 @@ int winBundle(
     oc_str8 version,
     oc_str8_list resource_files,
     oc_str8_list resource_dirs,
+    bool dataArchive,
+    bool clean,
+    bool hardlink,
+    bool stripWasm,
+    bool optimizeWasm,
+    oc_str8_list hotnessProfiles,
+    oc_str8_list engineOptions,
     oc_str8 app_version,
     oc_str8 outDir,
     oc_str8 module)
@@ -125,22 +330,25 @@ int winBundle(
     //NOTE: make bundle directory structure
     //-----------------------------------------------------------
     oc_str8 bundleDir = oc_path_append(a, outDir, name);
-    oc_str8 exeDir = oc_path_append(a, bundleDir, OC_STR8("bin"));
-    oc_str8 resDir = oc_path_append(a, bundleDir, OC_STR8("resources"));
-    oc_str8 guestDir = oc_path_append(a, bundleDir, OC_STR8("app"));
+    oc_str8 exeDir = OC_STR8("bin");
+    oc_str8 resDir = OC_STR8("resources");
+    oc_str8 guestDir = OC_STR8("app");
     oc_str8 wasmDir = oc_path_append(a, guestDir, OC_STR8("wasm"));
     oc_str8 dataDir = oc_path_append(a, guestDir, OC_STR8("data"));
 
-    if(oc_sys_exists(bundleDir))
+    if(clean && oc_sys_exists(bundleDir))
     {
         TRY(oc_sys_rmdir(bundleDir));
     }
-    TRY(oc_sys_mkdirs(bundleDir));
-    TRY(oc_sys_mkdirs(exeDir));
-    TRY(oc_sys_mkdirs(resDir));
-    TRY(oc_sys_mkdirs(guestDir));
-    TRY(oc_sys_mkdirs(wasmDir));
-    TRY(oc_sys_mkdirs(dataDir));
+
+    //NOTE: the manifest records what's already in the bundle, so that we only copy files that changed
+    bundle_manifest manifest = { 0 };
+    TRY(bundle_manifest_open(a, &manifest, bundleDir, hardlink));
+    TRY(bundle_make_dir(&manifest, exeDir));
+    TRY(bundle_make_dir(&manifest, resDir));
+    TRY(bundle_make_dir(&manifest, guestDir));
+    TRY(bundle_make_dir(&manifest, wasmDir));
+    TRY(bundle_make_dir(&manifest, dataDir));
 
     oc_str8 sdkDir = version.len > 0
                        ? get_version_dir(a, version, true)
@@ -151,29 +359,17 @@ int winBundle(
     //-----------------------------------------------------------
     {
         oc_str8 exe_in = oc_path_append(a, sdkDir, OC_STR8("bin/orca_runtime.exe"));
-        oc_str8 exe_out = oc_path_append(a, exeDir, oc_str8_pushf(a, "%.*s.exe", oc_str8_ip(name)));
-        TRY(oc_sys_copy(exe_in, exe_out));
+        oc_str8 exe_path = oc_path_append(a, exeDir, oc_str8_pushf(a, "%.*s.exe", oc_str8_ip(name)));
+        oc_str8 exe_out = oc_path_append(a, bundleDir, exe_path);
 
-        oc_str8 temp_dir = oc_path_append(a, outDir, OC_STR8("temporary"));
+        bool hasIcon = false;
+        u64 iconHash = 0;
         if(icon.len > 0)
         {
             if(oc_sys_exists(icon))
             {
-                if(oc_sys_exists(temp_dir))
-                {
-                    TRY(oc_sys_rmdir(temp_dir));
-                }
-                TRY(oc_sys_mkdirs(temp_dir));
-                oc_str8 ico_path = oc_path_append(a, temp_dir, OC_STR8("icon.ico"));
-                if(!icon_from_image(a, icon, ico_path))
-                {
-                    fprintf(stderr, "failed to create windows icon for \"%.*s\"\n", oc_str8_ip(icon));
-                }
-
-                if(!embed_icon_into_exe(a, exe_out, ico_path))
-                {
-                    fprintf(stderr, "failed to embed icon into exe file %.*s", (int)exe_out.len, exe_out.ptr);
-                }
+                TRY(bundle_hash_file(icon, &iconHash));
+                hasIcon = true;
             }
             else
             {
@@ -181,6 +377,31 @@ int winBundle(
             }
         }
 
+        //NOTE: the icon is embedded into the copied exe, so the copy can't be a hardlink and must be redone
+        //      when the icon changes
+        bool exeUpdated = false;
+        TRY(bundle_copy_file(&manifest, exe_in, exe_path, BUNDLE_COPY_NO_LINK, iconHash, &exeUpdated));
+
+        oc_str8 temp_dir = oc_path_append(a, outDir, OC_STR8("temporary"));
+        if(hasIcon && exeUpdated)
+        {
+            if(oc_sys_exists(temp_dir))
+            {
+                TRY(oc_sys_rmdir(temp_dir));
+            }
+            TRY(oc_sys_mkdirs(temp_dir));
+            oc_str8 ico_path = oc_path_append(a, temp_dir, OC_STR8("icon.ico"));
+            if(!icon_from_image(a, icon, ico_path))
+            {
+                fprintf(stderr, "failed to create windows icon for \"%.*s\"\n", oc_str8_ip(icon));
+            }
+
+            if(!embed_icon_into_exe(a, exe_out, ico_path))
+            {
+                fprintf(stderr, "failed to embed icon into exe file %.*s", (int)exe_out.len, exe_out.ptr);
+            }
+        }
+
         if(oc_sys_exists(temp_dir))
         {
             oc_sys_rmdir(temp_dir);
@@ -190,54 +411,77 @@ int winBundle(
     //-----------------------------------------------------------
     //NOTE: copy orca libraries
     //-----------------------------------------------------------
-    oc_str8 orcaLib = oc_path_append(a, sdkDir, OC_STR8("bin/orca.dll"));
-    oc_str8 glesLib = oc_path_append(a, sdkDir, OC_STR8("bin/libGLESv2.dll"));
-    oc_str8 eglLib = oc_path_append(a, sdkDir, OC_STR8("bin/libEGL.dll"));
-    oc_str8 wgpuLib = oc_path_append(a, sdkDir, OC_STR8("bin/webgpu.dll"));
-
-    TRY(oc_sys_copy(orcaLib, exeDir));
-    TRY(oc_sys_copy(glesLib, exeDir));
-    TRY(oc_sys_copy(eglLib, exeDir));
-    TRY(oc_sys_copy(wgpuLib, exeDir));
+    oc_str8 libs[] = {
+        OC_STR8("bin/orca.dll"),
+        OC_STR8("bin/libGLESv2.dll"),
+        OC_STR8("bin/libEGL.dll"),
+        OC_STR8("bin/webgpu.dll"),
+    };
+    for(int i = 0; i < oc_array_size(libs); i++)
+    {
+        oc_str8 lib = oc_path_append(a, sdkDir, libs[i]);
+        TRY(bundle_copy_file(&manifest, lib, oc_path_append(a, exeDir, oc_path_slice_filename(lib)), BUNDLE_COPY_NONE, 0, 0));
+    }
 
     //-----------------------------------------------------------
     //NOTE: copy wasm module and data
     //-----------------------------------------------------------
-    TRY(oc_sys_copy(module, oc_path_append(a, wasmDir, OC_STR8("/module.wasm"))));
-
-    oc_str8_list_for(resource_files, it)
+    int wasmResult = bundle_wasm_module(a, &manifest, module, wasmDir, stripWasm, optimizeWasm || hotnessProfiles.eltCount, hotnessProfiles);
+    if(wasmResult)
     {
-        oc_str8 resource_file = it->string;
-        if(oc_sys_isdir(resource_file))
-        {
-            printf("Error: Got %.*s as a resource file, but it is a directory. Ignoring.",
-                   oc_str8_ip(resource_file));
-        }
-        else
-        {
-            TRY(oc_sys_copy(resource_file, dataDir));
-        }
+        return wasmResult;
+    }
+    int engineResult = bundle_wasm_engine_options(a, &manifest, wasmDir, engineOptions);
+    if(engineResult)
+    {
+        return engineResult;
     }
 
-    oc_str8_list_for(resource_dirs, it)
+    if(dataArchive)
     {
-        oc_str8 resource_dir = it->string;
-        if(oc_sys_isdir(resource_dir))
+        oc_str8 archivePath = oc_path_append(a, guestDir, OC_STR8("data.oca"));
+        TRY(archive_write(a, resource_files, resource_dirs, oc_path_append(a, bundleDir, archivePath)));
+        bundle_manifest_add_generated(&manifest, archivePath);
+    }
+    else
+    {
+        oc_str8_list_for(resource_files, it)
         {
-            TRY(oc_sys_copytree(resource_dir, dataDir));
+            oc_str8 resource_file = it->string;
+            if(oc_sys_isdir(resource_file))
+            {
+                printf("Error: Got %.*s as a resource file, but it is a directory. Ignoring.",
+                       oc_str8_ip(resource_file));
+            }
+            else
+            {
+                oc_str8 path = oc_path_append(a, dataDir, oc_path_slice_filename(resource_file));
+                TRY(bundle_copy_file(&manifest, resource_file, path, BUNDLE_COPY_NONE, 0, 0));
+            }
         }
-        else
+
+        oc_str8_list_for(resource_dirs, it)
         {
-            printf("Error: Got %.*s as a resource dir, but it is not a directory. Ignoring.",
-                   oc_str8_ip(resource_dir));
+            oc_str8 resource_dir = it->string;
+            if(oc_sys_isdir(resource_dir))
+            {
+                TRY(bundle_copy_dir(&manifest, resource_dir, dataDir));
+            }
+            else
+            {
+                printf("Error: Got %.*s as a resource dir, but it is not a directory. Ignoring.",
+                       oc_str8_ip(resource_dir));
+            }
         }
     }
 
     //-----------------------------------------------------------
     //NOTE: copy runtime resources
     //-----------------------------------------------------------
-    TRY(oc_sys_copy(oc_path_append(a, sdkDir, OC_STR8("resources/Menlo.ttf")), resDir));
-    TRY(oc_sys_copy(oc_path_append(a, sdkDir, OC_STR8("resources/Menlo Bold.ttf")), resDir));
+    TRY(bundle_copy_file(&manifest, oc_path_append(a, sdkDir, OC_STR8("resources/Menlo.ttf")), oc_path_append(a, resDir, OC_STR8("Menlo.ttf")), BUNDLE_COPY_NONE, 0, 0));
+    TRY(bundle_copy_file(&manifest, oc_path_append(a, sdkDir, OC_STR8("resources/Menlo Bold.ttf")), oc_path_append(a, resDir, OC_STR8("Menlo Bold.ttf")), BUNDLE_COPY_NONE, 0, 0));
+
+    TRY(bundle_manifest_save(&manifest));
 
     return 0;
 }
@@ -250,6 +494,13 @@ int macBundle(
     oc_str8 version,
     oc_str8_list resource_files,
     oc_str8_list resource_dirs,
+    bool dataArchive,
+    bool clean,
+    bool hardlink,
+    bool stripWasm,
+    bool optimizeWasm,
+    oc_str8_list hotnessProfiles,
+    oc_str8_list engineOptions,
     oc_str8 app_version,
     oc_str8 outDir,
     oc_str8 module,
@@ -264,24 +515,27 @@ int macBundle(
     name = oc_str8_list_join(a, list);
 
     oc_str8 bundleDir = oc_path_append(a, outDir, name);
-    oc_str8 contentsDir = oc_path_append(a, bundleDir, OC_STR8("Contents"));
+    oc_str8 contentsDir = OC_STR8("Contents");
     oc_str8 exeDir = oc_path_append(a, contentsDir, OC_STR8("MacOS"));
     oc_str8 resDir = oc_path_append(a, contentsDir, OC_STR8("resources"));
     oc_str8 guestDir = oc_path_append(a, contentsDir, OC_STR8("app"));
     oc_str8 wasmDir = oc_path_append(a, guestDir, OC_STR8("wasm"));
     oc_str8 dataDir = oc_path_append(a, guestDir, OC_STR8("data"));
 
-    if(oc_sys_exists(bundleDir))
+    if(clean && oc_sys_exists(bundleDir))
     {
         TRY(oc_sys_rmdir(bundleDir));
     }
-    TRY(oc_sys_mkdirs(bundleDir));
-    TRY(oc_sys_mkdirs(contentsDir));
-    TRY(oc_sys_mkdirs(exeDir));
-    TRY(oc_sys_mkdirs(resDir));
-    TRY(oc_sys_mkdirs(guestDir));
-    TRY(oc_sys_mkdirs(wasmDir));
-    TRY(oc_sys_mkdirs(dataDir));
+
+    //NOTE: the manifest records what's already in the bundle, so that we only copy files that changed
+    bundle_manifest manifest = { 0 };
+    TRY(bundle_manifest_open(a, &manifest, bundleDir, hardlink));
+    TRY(bundle_make_dir(&manifest, contentsDir));
+    TRY(bundle_make_dir(&manifest, exeDir));
+    TRY(bundle_make_dir(&manifest, resDir));
+    TRY(bundle_make_dir(&manifest, guestDir));
+    TRY(bundle_make_dir(&manifest, wasmDir));
+    TRY(bundle_make_dir(&manifest, dataDir));
 
     oc_str8 sdkDir = version.len > 0 ? get_version_dir(a, version, true)
                                      : current_version_dir(a, true);
@@ -289,59 +543,76 @@ int macBundle(
     //-----------------------------------------------------------
     //NOTE: copy orca runtime executable and libraries
     //-----------------------------------------------------------
-    oc_str8 orcaExe = oc_path_append(a, sdkDir, OC_STR8("bin/orca_runtime"));
-    oc_str8 orcaLib = oc_path_append(a, sdkDir, OC_STR8("bin/liborca.dylib"));
-    oc_str8 glesLib = oc_path_append(a, sdkDir, OC_STR8("bin/libGLESv2.dylib"));
-    oc_str8 eglLib = oc_path_append(a, sdkDir, OC_STR8("bin/libEGL.dylib"));
-    oc_str8 wgpu_lib = oc_path_append(a, sdkDir, OC_STR8("bin/libwebgpu.dylib"));
-
-    TRY(oc_sys_copy(orcaExe, exeDir));
-    TRY(oc_sys_copy(orcaLib, exeDir));
-    TRY(oc_sys_copy(glesLib, exeDir));
-    TRY(oc_sys_copy(eglLib, exeDir));
-    TRY(oc_sys_copy(wgpu_lib, exeDir));
+    oc_str8 bins[] = {
+        OC_STR8("bin/orca_runtime"),
+        OC_STR8("bin/liborca.dylib"),
+        OC_STR8("bin/libGLESv2.dylib"),
+        OC_STR8("bin/libEGL.dylib"),
+        OC_STR8("bin/libwebgpu.dylib"),
+    };
+    for(int i = 0; i < oc_array_size(bins); i++)
+    {
+        oc_str8 bin = oc_path_append(a, sdkDir, bins[i]);
+        TRY(bundle_copy_file(&manifest, bin, oc_path_append(a, exeDir, oc_path_slice_filename(bin)), BUNDLE_COPY_NONE, 0, 0));
+    }
 
     //-----------------------------------------------------------
     //NOTE: copy wasm module and data
     //-----------------------------------------------------------
-    TRY(oc_sys_copy(module, oc_path_append(a, wasmDir, OC_STR8("/module.wasm"))));
-
-    oc_str8_list_for(resource_files, it)
+    int wasmResult = bundle_wasm_module(a, &manifest, module, wasmDir, stripWasm, optimizeWasm || hotnessProfiles.eltCount, hotnessProfiles);
+    if(wasmResult)
     {
-        oc_str8 resource_file = it->string;
-        if(oc_sys_isdir(resource_file))
-        {
-            printf("Error: Got %.*s as a resource file, but it is a directory. Ignoring.",
-                   oc_str8_ip(resource_file));
-        }
-        else
-        {
-            TRY(oc_sys_copy(resource_file, dataDir));
-        }
+        return wasmResult;
+    }
+    int engineResult = bundle_wasm_engine_options(a, &manifest, wasmDir, engineOptions);
+    if(engineResult)
+    {
+        return engineResult;
     }
 
-    oc_str8_list_for(resource_dirs, it)
+    if(dataArchive)
+    {
+        oc_str8 archivePath = oc_path_append(a, guestDir, OC_STR8("data.oca"));
+        TRY(archive_write(a, resource_files, resource_dirs, oc_path_append(a, bundleDir, archivePath)));
+        bundle_manifest_add_generated(&manifest, archivePath);
+    }
+    else
     {
-        oc_str8 resource_dir = it->string;
-        if(oc_sys_isdir(resource_dir))
+        oc_str8_list_for(resource_files, it)
         {
-            // NOTE(shaw): trailing slash means that contents are copied rather
-            // than the directory itself
-            oc_str8 resource_dir_slash = oc_path_append(a, resource_dir, OC_STR8("/"));
-            TRY(oc_sys_copytree(resource_dir_slash, dataDir));
+            oc_str8 resource_file = it->string;
+            if(oc_sys_isdir(resource_file))
+            {
+                printf("Error: Got %.*s as a resource file, but it is a directory. Ignoring.",
+                       oc_str8_ip(resource_file));
+            }
+            else
+            {
+                oc_str8 path = oc_path_append(a, dataDir, oc_path_slice_filename(resource_file));
+                TRY(bundle_copy_file(&manifest, resource_file, path, BUNDLE_COPY_NONE, 0, 0));
+            }
         }
-        else
+
+        oc_str8_list_for(resource_dirs, it)
         {
-            printf("Error: Got %.*s as a resource dir, but it is not a directory. Ignoring.",
-                   oc_str8_ip(resource_dir));
+            oc_str8 resource_dir = it->string;
+            if(oc_sys_isdir(resource_dir))
+            {
+                TRY(bundle_copy_dir(&manifest, resource_dir, dataDir));
+            }
+            else
+            {
+                printf("Error: Got %.*s as a resource dir, but it is not a directory. Ignoring.",
+                       oc_str8_ip(resource_dir));
+            }
         }
     }
 
     //-----------------------------------------------------------
     //NOTE: copy runtime resources
     //-----------------------------------------------------------
-    TRY(oc_sys_copy(oc_path_append(a, sdkDir, OC_STR8("resources/Menlo.ttf")), resDir));
-    TRY(oc_sys_copy(oc_path_append(a, sdkDir, OC_STR8("resources/Menlo Bold.ttf")), resDir));
+    TRY(bundle_copy_file(&manifest, oc_path_append(a, sdkDir, OC_STR8("resources/Menlo.ttf")), oc_path_append(a, resDir, OC_STR8("Menlo.ttf")), BUNDLE_COPY_NONE, 0, 0));
+    TRY(bundle_copy_file(&manifest, oc_path_append(a, sdkDir, OC_STR8("resources/Menlo Bold.ttf")), oc_path_append(a, resDir, OC_STR8("Menlo Bold.ttf")), BUNDLE_COPY_NONE, 0, 0));
 
     //-----------------------------------------------------------
     //NOTE make icon
@@ -383,13 +654,15 @@ int macBundle(
                 size *= 2;
             }
 
-            oc_str8 icon_out = oc_path_append(a, resDir, OC_STR8("icon.icns"));
+            oc_str8 icon_path = oc_path_append(a, resDir, OC_STR8("icon.icns"));
+            oc_str8 icon_out = oc_path_append(a, bundleDir, icon_path);
             oc_str8 cmd = oc_str8_pushf(a, "iconutil -c icns -o %s %s", icon_out.ptr, iconset.ptr);
             i32 result = system(cmd.ptr);
             if(result)
             {
                 fprintf(stderr, "failed to generate app icon from %.*s", oc_str8_ip(icon));
             }
+            bundle_manifest_add_generated(&manifest, icon_path);
             TRY(oc_sys_rmdir(iconset));
         }
         else
@@ -436,8 +709,8 @@ int macBundle(
                                            oc_str8_ip(bundle_sig),
                                            mtlEnableCapture ? "<key>MetalCaptureEnabled</key><true/>" : "");
 
-    oc_str8 plist_path = oc_path_append(a, contentsDir, OC_STR8("Info.plist"));
-    oc_file plist_file = oc_file_open(plist_path, OC_FILE_ACCESS_WRITE, OC_FILE_OPEN_CREATE);
+    oc_str8 plist_path = oc_path_append(a, bundleDir, OC_STR8("Contents/Info.plist"));
+    oc_file plist_file = oc_file_open(plist_path, OC_FILE_ACCESS_WRITE, OC_FILE_OPEN_CREATE | OC_FILE_OPEN_TRUNCATE);
     if(oc_file_is_nil(plist_file))
     {
         fprintf(stderr, "Error: failed to create plist file \"%.*s\"\n",
@@ -447,6 +720,9 @@ int macBundle(
     }
     oc_file_write(plist_file, plist_contents.len, plist_contents.ptr);
     oc_file_close(plist_file);
+    bundle_manifest_add_generated(&manifest, OC_STR8("Contents/Info.plist"));
+
+    TRY(bundle_manifest_save(&manifest));
 
     return 0;
 }
@@ -0,0 +1,315 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bundle_manifest.h"
+#include "system.h"
+
+#define BUNDLE_MANIFEST_NAME ".orca_bundle"
+#define BUNDLE_MANIFEST_VERSION "orca bundle manifest 1"
+
+enum
+{
+    BUNDLE_HASH_CHUNK_SIZE = 4 << 20,
+    BUNDLE_MANIFEST_MAX_LINE = 3 * 4096,
+};
+
+static bundle_manifest_entry* bundle_manifest_find(oc_hash_map* map, oc_str8 path)
+{
+    bundle_manifest_entry* entry = oc_hash_map_find_type(map, oc_hash_xx64_string(path), bundle_manifest_entry);
+    if(entry && oc_str8_cmp(entry->path, path))
+    {
+        entry = 0;
+    }
+    return (entry);
+}
+
+static bool bundle_manifest_load(bundle_manifest* manifest, oc_str8 manifestPath)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+    FILE* file = fopen(oc_str8_to_cstring(scratch.arena, manifestPath), "rb");
+    oc_scratch_end(scratch);
+    if(!file)
+    {
+        return (false);
+    }
+
+    char* line = oc_arena_push(manifest->arena, BUNDLE_MANIFEST_MAX_LINE);
+    bool valid = fgets(line, BUNDLE_MANIFEST_MAX_LINE, file)
+              && !strncmp(line, BUNDLE_MANIFEST_VERSION "\n", BUNDLE_MANIFEST_MAX_LINE);
+
+    //NOTE: entries are "hash extraHash size seconds fraction path source", separated by tabs
+    while(valid && fgets(line, BUNDLE_MANIFEST_MAX_LINE, file))
+    {
+        bundle_manifest_entry entry = { 0 };
+        unsigned long long hash, extraHash, size, fraction;
+        long long seconds;
+        int fieldsLen = 0;
+
+        if(sscanf(line, "%llx\t%llx\t%llu\t%lld\t%llu\t%n", &hash, &extraHash, &size, &seconds, &fraction, &fieldsLen) != 5
+           || fieldsLen == 0)
+        {
+            valid = false;
+            break;
+        }
+        oc_str8 paths = OC_STR8(line + fieldsLen);
+        u64 separator = oc_str8_find(paths, OC_STR8("\t"));
+        if(separator >= paths.len || paths.len < 1 || paths.ptr[paths.len - 1] != '\n')
+        {
+            valid = false;
+            break;
+        }
+
+        entry.path = oc_str8_push_slice(manifest->arena, paths, 0, separator);
+        entry.source = oc_str8_push_slice(manifest->arena, paths, separator + 1, paths.len - 1);
+        entry.hash = hash;
+        entry.extraHash = extraHash;
+        entry.size = size;
+        entry.date.seconds = seconds;
+        entry.date.fraction = fraction;
+
+        *oc_hash_map_insert_type(&manifest->oldEntries, oc_hash_xx64_string(entry.path), bundle_manifest_entry, 0) = entry;
+    }
+    fclose(file);
+
+    if(!valid)
+    {
+        oc_hash_map_clear(&manifest->oldEntries);
+    }
+    return (valid);
+}
+
+bool bundle_manifest_open(oc_arena* a, bundle_manifest* manifest, oc_str8 bundleDir, bool hardlink)
+{
+    memset(manifest, 0, sizeof(bundle_manifest));
+    manifest->arena = a;
+    manifest->bundleDir = bundleDir;
+    manifest->hardlink = hardlink;
+    oc_hash_map_init_with_options(&manifest->oldEntries, sizeof(bundle_manifest_entry), &(oc_hash_map_options){ .arena = a });
+    oc_hash_map_init_with_options(&manifest->entries, sizeof(bundle_manifest_entry), &(oc_hash_map_options){ .arena = a });
+
+    if(oc_sys_exists(bundleDir))
+    {
+        //NOTE: we don't know which files of a bundle without a valid manifest are stale, so start from scratch
+        oc_str8 manifestPath = oc_path_append(a, bundleDir, OC_STR8(BUNDLE_MANIFEST_NAME));
+        if(!bundle_manifest_load(manifest, manifestPath))
+        {
+            if(!oc_sys_rmdir(bundleDir))
+            {
+                return (false);
+            }
+        }
+    }
+    return (oc_sys_exists(bundleDir) || oc_sys_mkdirs(bundleDir));
+}
+
+bool bundle_manifest_save(bundle_manifest* manifest)
+{
+    u64 index = 0;
+    bundle_manifest_entry* old = 0;
+    while((old = oc_hash_map_next(&manifest->oldEntries, &index, 0)) != 0)
+    {
+        if(!bundle_manifest_find(&manifest->entries, old->path))
+        {
+            oc_arena_scope scratch = oc_scratch_begin();
+            oc_str8 path = oc_path_append(scratch.arena, manifest->bundleDir, old->path);
+            if(oc_sys_exists(path) && !oc_sys_isdir(path))
+            {
+                remove(oc_str8_to_cstring(scratch.arena, path));
+                manifest->removeCount++;
+            }
+            oc_scratch_end(scratch);
+        }
+    }
+
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_str8 manifestPath = oc_path_append(scratch.arena, manifest->bundleDir, OC_STR8(BUNDLE_MANIFEST_NAME));
+    FILE* file = fopen(oc_str8_to_cstring(scratch.arena, manifestPath), "wb");
+    oc_scratch_end(scratch);
+    if(!file)
+    {
+        snprintf(oc_sys_err.msg, OC_SYS_MAX_ERROR, "failed to write bundle manifest \"%.*s\"", oc_str8_ip(manifestPath));
+        oc_sys_err.code = 1;
+        return (false);
+    }
+
+    fprintf(file, BUNDLE_MANIFEST_VERSION "\n");
+
+    index = 0;
+    bundle_manifest_entry* entry = 0;
+    while((entry = oc_hash_map_next(&manifest->entries, &index, 0)) != 0)
+    {
+        fprintf(file,
+                "%016llx\t%016llx\t%llu\t%lld\t%llu\t%.*s\t%.*s\n",
+                (unsigned long long)entry->hash,
+                (unsigned long long)entry->extraHash,
+                (unsigned long long)entry->size,
+                (long long)entry->date.seconds,
+                (unsigned long long)entry->date.fraction,
+                oc_str8_ip(entry->path),
+                oc_str8_ip(entry->source));
+    }
+    fclose(file);
+
+    printf("bundle: %u files copied, %u up to date, %u removed\n",
+           manifest->copyCount,
+           manifest->skipCount,
+           manifest->removeCount);
+
+    return (true);
+}
+
+bool bundle_make_dir(bundle_manifest* manifest, oc_str8 path)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_str8 fullPath = oc_path_append(scratch.arena, manifest->bundleDir, path);
+    bool result = oc_sys_isdir(fullPath) || oc_sys_mkdirs(fullPath);
+    oc_scratch_end(scratch);
+    return (result);
+}
+
+bool bundle_hash_file(oc_str8 path, u64* hash)
+{
+    oc_file file = oc_file_open(path, OC_FILE_ACCESS_READ, OC_FILE_OPEN_NONE);
+    if(oc_file_last_error(file) != OC_IO_OK)
+    {
+        oc_file_close(file);
+        snprintf(oc_sys_err.msg, OC_SYS_MAX_ERROR, "failed to open file \"%.*s\"", oc_str8_ip(path));
+        oc_sys_err.code = 1;
+        return (false);
+    }
+
+    //NOTE: hash in chunks so that large files don't have to be loaded in memory at once
+    oc_arena_scope scratch = oc_scratch_begin();
+    char* buffer = oc_arena_push(scratch.arena, BUNDLE_HASH_CHUNK_SIZE);
+    u64 size = oc_file_size(file);
+    u64 offset = 0;
+    *hash = 0;
+    while(offset < size)
+    {
+        u64 chunkSize = oc_min(size - offset, BUNDLE_HASH_CHUNK_SIZE);
+        if(oc_file_read(file, chunkSize, buffer) != chunkSize)
+        {
+            break;
+        }
+        *hash = oc_hash_xx64_string_seed(oc_str8_from_buffer(chunkSize, buffer), *hash);
+        offset += chunkSize;
+    }
+    oc_scratch_end(scratch);
+    oc_file_close(file);
+
+    if(offset != size)
+    {
+        snprintf(oc_sys_err.msg, OC_SYS_MAX_ERROR, "failed to read file \"%.*s\"", oc_str8_ip(path));
+        oc_sys_err.code = 1;
+        return (false);
+    }
+    return (true);
+}
+
+bool bundle_copy_file(bundle_manifest* manifest, oc_str8 src, oc_str8 path, bundle_copy_flags flags, u64 extraHash, bool* updated)
+{
+    if(updated)
+    {
+        *updated = false;
+    }
+
+    oc_file file = oc_file_open(src, OC_FILE_ACCESS_READ, OC_FILE_OPEN_NONE);
+    oc_file_status status = oc_file_get_status(file);
+    bool opened = (oc_file_last_error(file) == OC_IO_OK);
+    oc_file_close(file);
+    if(!opened)
+    {
+        snprintf(oc_sys_err.msg, OC_SYS_MAX_ERROR, "failed to open file \"%.*s\"", oc_str8_ip(src));
+        oc_sys_err.code = 1;
+        return (false);
+    }
+
+    bundle_manifest_entry entry = {
+        .path = oc_str8_push_copy(manifest->arena, path),
+        .source = oc_str8_push_copy(manifest->arena, src),
+        .extraHash = extraHash,
+        .size = status.size,
+        .date = status.modificationDate,
+    };
+
+    //NOTE: only read the source if it changed since it was last copied
+    bundle_manifest_entry* old = bundle_manifest_find(&manifest->oldEntries, path);
+    if(old
+       && !oc_str8_cmp(old->source, src)
+       && old->size == status.size
+       && old->date.seconds == status.modificationDate.seconds
+       && old->date.fraction == status.modificationDate.fraction)
+    {
+        entry.hash = old->hash;
+    }
+    else if(!bundle_hash_file(src, &entry.hash))
+    {
+        return (false);
+    }
+
+    oc_str8 dst = oc_path_append(manifest->arena, manifest->bundleDir, path);
+    if(old && old->hash == entry.hash && old->extraHash == extraHash && oc_sys_exists(dst))
+    {
+        manifest->skipCount++;
+    }
+    else
+    {
+        if(oc_sys_exists(dst))
+        {
+            oc_arena_scope scratch = oc_scratch_begin();
+            remove(oc_str8_to_cstring(scratch.arena, dst));
+            oc_scratch_end(scratch);
+        }
+        if(!oc_sys_clone(src, dst, manifest->hardlink && !(flags & BUNDLE_COPY_NO_LINK)))
+        {
+            return (false);
+        }
+        manifest->copyCount++;
+        if(updated)
+        {
+            *updated = true;
+        }
+    }
+
+    *oc_hash_map_insert_type(&manifest->entries, oc_hash_xx64_string(entry.path), bundle_manifest_entry, 0) = entry;
+    return (true);
+}
+
+bool bundle_copy_dir(bundle_manifest* manifest, oc_str8 srcDir, oc_str8 dir)
+{
+    if(!bundle_make_dir(manifest, dir))
+    {
+        return (false);
+    }
+
+    oc_list entries = oc_sys_read_dir(manifest->arena, srcDir);
+    oc_list_for(entries, entry, oc_sys_dir_entry, node)
+    {
+        oc_str8 src = oc_path_append(manifest->arena, srcDir, entry->name);
+        oc_str8 path = oc_path_append(manifest->arena, dir, entry->name);
+
+        bool result = entry->is_dir
+                        ? bundle_copy_dir(manifest, src, path)
+                        : bundle_copy_file(manifest, src, path, BUNDLE_COPY_NONE, 0, 0);
+        if(!result)
+        {
+            return (false);
+        }
+    }
+    return (true);
+}
+
+void bundle_manifest_add_generated(bundle_manifest* manifest, oc_str8 path)
+{
+    bundle_manifest_entry entry = {
+        .path = oc_str8_push_copy(manifest->arena, path),
+    };
+    *oc_hash_map_insert_type(&manifest->entries, oc_hash_xx64_string(entry.path), bundle_manifest_entry, 0) = entry;
+}
@@ -0,0 +1,69 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "orca.h"
+
+/*NOTE:
+    The bundle manifest lets `orca bundle` update an existing bundle instead of rebuilding it from scratch. It records
+    the content hash of each file copied to the bundle, along with the size and modification date of its source, so
+    that unchanged sources don't even have to be read again. Files that are in the old manifest but weren't written
+    by the current run are removed from the bundle when the manifest is saved.
+*/
+
+typedef struct bundle_manifest_entry
+{
+    oc_str8 path; // relative to the bundle directory
+    oc_str8 source;
+    u64 hash;
+    u64 extraHash;
+    u64 size;
+    oc_datestamp date;
+} bundle_manifest_entry;
+
+typedef enum
+{
+    BUNDLE_COPY_NONE = 0,
+    BUNDLE_COPY_NO_LINK = 1 << 0, // the copy is modified afterwards, so it can't be a hardlink to its source
+} bundle_copy_flags;
+
+typedef struct bundle_manifest
+{
+    oc_arena* arena;
+    oc_str8 bundleDir;
+    oc_hash_map oldEntries; // bundle_manifest_entry, keyed by path hash
+    oc_hash_map entries;
+    bool hardlink;
+
+    u32 copyCount;
+    u32 skipCount;
+    u32 removeCount;
+} bundle_manifest;
+
+// Loads the manifest of bundleDir. If the bundle exists but has no manifest, it is removed so that it can be rebuilt.
+bool bundle_manifest_open(oc_arena* a, bundle_manifest* manifest, oc_str8 bundleDir, bool hardlink);
+
+// Removes stale files and writes the new manifest to the bundle directory.
+bool bundle_manifest_save(bundle_manifest* manifest);
+
+// Creates path (relative to the bundle directory) if it doesn't exist yet. The parent directory must exist.
+bool bundle_make_dir(bundle_manifest* manifest, oc_str8 path);
+
+// Copies src to path (relative to the bundle directory) unless the bundle already has the same contents.
+// extraHash is for copies that depend on other inputs, the file is copied again if it changes. If updated
+// is not null, it is set to whether the file was written.
+bool bundle_copy_file(bundle_manifest* manifest, oc_str8 src, oc_str8 path, bundle_copy_flags flags, u64 extraHash, bool* updated);
+
+// Copies the contents of srcDir into dir (relative to the bundle directory).
+bool bundle_copy_dir(bundle_manifest* manifest, oc_str8 srcDir, oc_str8 dir);
+
+// Records a file that was written directly into the bundle, so that it isn't removed as stale.
+void bundle_manifest_add_generated(bundle_manifest* manifest, oc_str8 path);
+
+// Hashes the contents of a file. Returns false if the file can't be read.
+bool bundle_hash_file(oc_str8 path, u64* hash);
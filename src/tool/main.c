@@ -1,9 +1,9 @@
-/*************************************************************************
-*
-*  Orca
-*  Copyright 2023 Martin Fouilleul and the Orca project contributors
-*  See LICENSE.txt for licensing information
-*
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
 **************************************************************************/
 
 #ifdef _MSC_VER
@@ -26,9 +26,13 @@
 #include "version.c"
 #include "sdk_path.c"
 #include "install_path.c"
+#include "archive.c"
+#include "bundle_manifest.c"
+#include "wasm_strip.c"
 #include "bundle.c"
 #include "microtar.c"
 #include "tarball.c"
+#include "sha256.c"
 #include "update.c"
 #include "list.c"
 #include "system.c"
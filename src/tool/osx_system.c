@@ -157,6 +157,31 @@ bool oc_sys_copy(oc_str8 src, oc_str8 dst)
     return true;
 }
 
+// NOTE: dst must be a file path. On APFS the copy is a copy-on-write clone that shares storage with src, so we
+// don't need hardlinks.
+bool oc_sys_clone(oc_str8 src, oc_str8 dst, bool hardlink)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+    const char* csrc = oc_str8_to_cstring(scratch.arena, src);
+    const char* cdst = oc_str8_to_cstring(scratch.arena, dst);
+
+    // NOTE: COPYFILE_CLONE falls back to a regular copy if the filesystem can't clone files
+    int result = copyfile(csrc, cdst, 0, COPYFILE_ALL | COPYFILE_CLONE);
+
+    oc_scratch_end(scratch);
+
+    if(result)
+    {
+        snprintf(oc_sys_err.msg, OC_SYS_MAX_ERROR,
+                 "failed to copy file \"%.*s\" to \"%.*s\"",
+                 oc_str8_ip(src), oc_str8_ip(dst));
+        oc_sys_err.code = result;
+        return false;
+    }
+
+    return true;
+}
+
 bool oc_sys_copytree(oc_str8 src, oc_str8 dst)
 {
     if(!oc_sys_isdir(src))
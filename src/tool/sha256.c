@@ -0,0 +1,164 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2024 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include "sha256.h"
+
+//NOTE: SHA-256 as specified in FIPS 180-4
+
+static const u32 SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static u32 sha256_rotr(u32 x, u32 n)
+{
+    return ((x >> n) | (x << (32 - n)));
+}
+
+static void sha256_compress(sha256_context* ctx, const u8* block)
+{
+    u32 w[64];
+    for(int i = 0; i < 16; i++)
+    {
+        w[i] = ((u32)block[4 * i] << 24)
+             | ((u32)block[4 * i + 1] << 16)
+             | ((u32)block[4 * i + 2] << 8)
+             | ((u32)block[4 * i + 3]);
+    }
+    for(int i = 16; i < 64; i++)
+    {
+        u32 s0 = sha256_rotr(w[i - 15], 7) ^ sha256_rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        u32 s1 = sha256_rotr(w[i - 2], 17) ^ sha256_rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    u32 a = ctx->state[0];
+    u32 b = ctx->state[1];
+    u32 c = ctx->state[2];
+    u32 d = ctx->state[3];
+    u32 e = ctx->state[4];
+    u32 f = ctx->state[5];
+    u32 g = ctx->state[6];
+    u32 h = ctx->state[7];
+
+    for(int i = 0; i < 64; i++)
+    {
+        u32 s1 = sha256_rotr(e, 6) ^ sha256_rotr(e, 11) ^ sha256_rotr(e, 25);
+        u32 ch = (e & f) ^ (~e & g);
+        u32 t1 = h + s1 + ch + SHA256_K[i] + w[i];
+        u32 s0 = sha256_rotr(a, 2) ^ sha256_rotr(a, 13) ^ sha256_rotr(a, 22);
+        u32 maj = (a & b) ^ (a & c) ^ (b & c);
+        u32 t2 = s0 + maj;
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    ctx->state[0] += a;
+    ctx->state[1] += b;
+    ctx->state[2] += c;
+    ctx->state[3] += d;
+    ctx->state[4] += e;
+    ctx->state[5] += f;
+    ctx->state[6] += g;
+    ctx->state[7] += h;
+}
+
+void sha256_init(sha256_context* ctx)
+{
+    static const u32 init[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memset(ctx, 0, sizeof(sha256_context));
+    memcpy(ctx->state, init, sizeof(init));
+}
+
+void sha256_update(sha256_context* ctx, const void* data, u64 size)
+{
+    const u8* bytes = (const u8*)data;
+    ctx->length += size;
+
+    if(ctx->blockLen)
+    {
+        u32 count = (u32)oc_min(size, SHA256_BLOCK_SIZE - ctx->blockLen);
+        memcpy(ctx->block + ctx->blockLen, bytes, count);
+        ctx->blockLen += count;
+        bytes += count;
+        size -= count;
+
+        if(ctx->blockLen < SHA256_BLOCK_SIZE)
+        {
+            return;
+        }
+        sha256_compress(ctx, ctx->block);
+        ctx->blockLen = 0;
+    }
+
+    for(; size >= SHA256_BLOCK_SIZE; size -= SHA256_BLOCK_SIZE, bytes += SHA256_BLOCK_SIZE)
+    {
+        sha256_compress(ctx, bytes);
+    }
+
+    memcpy(ctx->block, bytes, size);
+    ctx->blockLen = (u32)size;
+}
+
+void sha256_final(sha256_context* ctx, u8 digest[SHA256_DIGEST_SIZE])
+{
+    u64 bitLength = ctx->length * 8;
+
+    //NOTE: pad with a 1 bit, then zeros up to 56 bytes mod 64, then the big-endian bit length
+    ctx->block[ctx->blockLen++] = 0x80;
+    if(ctx->blockLen > SHA256_BLOCK_SIZE - 8)
+    {
+        memset(ctx->block + ctx->blockLen, 0, SHA256_BLOCK_SIZE - ctx->blockLen);
+        sha256_compress(ctx, ctx->block);
+        ctx->blockLen = 0;
+    }
+    memset(ctx->block + ctx->blockLen, 0, SHA256_BLOCK_SIZE - 8 - ctx->blockLen);
+    for(int i = 0; i < 8; i++)
+    {
+        ctx->block[SHA256_BLOCK_SIZE - 1 - i] = (u8)(bitLength >> (8 * i));
+    }
+    sha256_compress(ctx, ctx->block);
+
+    for(int i = 0; i < 8; i++)
+    {
+        digest[4 * i] = (u8)(ctx->state[i] >> 24);
+        digest[4 * i + 1] = (u8)(ctx->state[i] >> 16);
+        digest[4 * i + 2] = (u8)(ctx->state[i] >> 8);
+        digest[4 * i + 3] = (u8)(ctx->state[i]);
+    }
+}
+
+oc_str8 sha256_to_hex(oc_arena* arena, u8 digest[SHA256_DIGEST_SIZE])
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    oc_str8 hex = {
+        .ptr = oc_arena_push(arena, 2 * SHA256_DIGEST_SIZE + 1),
+        .len = 2 * SHA256_DIGEST_SIZE,
+    };
+    for(int i = 0; i < SHA256_DIGEST_SIZE; i++)
+    {
+        hex.ptr[2 * i] = hexDigits[digest[i] >> 4];
+        hex.ptr[2 * i + 1] = hexDigits[digest[i] & 0xf];
+    }
+    hex.ptr[hex.len] = '\0';
+    return (hex);
+}
@@ -0,0 +1,31 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2024 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "orca.h"
+
+enum
+{
+    SHA256_DIGEST_SIZE = 32,
+    SHA256_BLOCK_SIZE = 64,
+};
+
+typedef struct sha256_context
+{
+    u32 state[8];
+    u64 length; // total bytes hashed
+    u8 block[SHA256_BLOCK_SIZE];
+    u32 blockLen;
+} sha256_context;
+
+void sha256_init(sha256_context* ctx);
+void sha256_update(sha256_context* ctx, const void* data, u64 size);
+void sha256_final(sha256_context* ctx, u8 digest[SHA256_DIGEST_SIZE]);
+
+// Writes the digest as 64 lowercase hex digits, like sha256sum and scripts/checksum.py
+oc_str8 sha256_to_hex(oc_arena* arena, u8 digest[SHA256_DIGEST_SIZE]);
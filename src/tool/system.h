@@ -34,6 +34,7 @@ bool oc_sys_mkdirs(oc_str8 path);
 bool oc_sys_rmdir(oc_str8 path);
 bool oc_sys_copy(oc_str8 src, oc_str8 dst);
 bool oc_sys_copytree(oc_str8 src, oc_str8 dst);
+bool oc_sys_clone(oc_str8 src, oc_str8 dst, bool hardlink);
 bool oc_sys_move(oc_str8 src, oc_str8 dst);
 oc_list oc_sys_read_dir(oc_arena* a, oc_str8 path);
 
@@ -21,135 +21,185 @@
 #include "orca.h"
 
 #define CHUNK_SIZE 262144
+#define TAR_BLOCK_SIZE 512
 
-static int custom_file_write(mtar_t* tar, const void* data, unsigned size)
+//NOTE: microtar expects a seekable stream, but we feed it directly from the gzip stream so that the archive
+//      doesn't need to be decompressed to a temporary file first. microtar only seeks back to the start of
+//      the last header it read, so we keep a copy of that block, and forward seeks skip compressed data.
+typedef struct tar_gz_stream
 {
-    size_t res = fwrite(data, 1, size, tar->stream);
-    return (res == size) ? MTAR_ESUCCESS : MTAR_EWRITEFAIL;
-}
+    gzFile file;
+    u64 streamPos; // position of the next byte from the gzip stream
+    u64 headerPos;
+    bool headerValid;
+    char header[TAR_BLOCK_SIZE];
+} tar_gz_stream;
 
-static int custom_file_read(mtar_t* tar, void* data, unsigned size)
+static int tar_gz_stream_read(mtar_t* tar, void* data, unsigned size)
 {
-    size_t res = fread(data, 1, size, tar->stream);
-    return (res == size) ? MTAR_ESUCCESS : MTAR_EREADFAIL;
+    tar_gz_stream* stream = (tar_gz_stream*)tar->stream;
+    u64 pos = tar->pos;
+
+    if(stream->headerValid && pos >= stream->headerPos && pos + size <= stream->headerPos + TAR_BLOCK_SIZE)
+    {
+        memcpy(data, stream->header + (pos - stream->headerPos), size);
+        return MTAR_ESUCCESS;
+    }
+    if(pos < stream->streamPos)
+    {
+        return MTAR_ESEEKFAIL;
+    }
+    if(pos > stream->streamPos)
+    {
+        if(gzseek(stream->file, pos - stream->streamPos, SEEK_CUR) == -1)
+        {
+            return MTAR_ESEEKFAIL;
+        }
+        stream->streamPos = pos;
+    }
+
+    int res = gzread(stream->file, data, size);
+    if(res != (int)size)
+    {
+        return MTAR_EREADFAIL;
+    }
+    stream->streamPos += size;
+
+    //NOTE: entry data is read while remaining_data is non-zero, anything else is a header
+    if(size == TAR_BLOCK_SIZE && tar->remaining_data == 0)
+    {
+        memcpy(stream->header, data, TAR_BLOCK_SIZE);
+        stream->headerPos = pos;
+        stream->headerValid = true;
+    }
+    return MTAR_ESUCCESS;
 }
 
-static int custom_file_seek(mtar_t* tar, unsigned offset)
+static int tar_gz_stream_seek(mtar_t* tar, unsigned offset)
 {
-    int res = fseek(tar->stream, offset, SEEK_SET);
-    return (res == 0) ? MTAR_ESUCCESS : MTAR_ESEEKFAIL;
+    //NOTE: the actual seek is deferred to the next read, mtar_seek() updates tar->pos
+    tar_gz_stream* stream = (tar_gz_stream*)tar->stream;
+    if(offset < stream->streamPos && !(stream->headerValid && offset >= stream->headerPos))
+    {
+        return MTAR_ESEEKFAIL;
+    }
+    return MTAR_ESUCCESS;
 }
 
-static int custom_file_close(mtar_t* tar)
+static int tar_gz_stream_close(mtar_t* tar)
 {
-    fclose(tar->stream);
     return MTAR_ESUCCESS;
 }
 
 #if OC_PLATFORM_WINDOWS
-static bool write_file_from_tar(oc_str8 path, mtar_header_t* header, char* buf, u64 size)
+typedef oc_file tar_out_file;
+
+static bool tar_out_file_open(tar_out_file* out, oc_str8 path, mtar_header_t* header)
 {
     (void)header;
-    oc_file file = oc_file_open(path, OC_FILE_ACCESS_WRITE, OC_FILE_OPEN_CREATE);
-    u64 written = oc_file_write(file, size, buf);
-    oc_file_close(file);
-    if(written != size)
+    *out = oc_file_open(path, OC_FILE_ACCESS_WRITE, OC_FILE_OPEN_CREATE | OC_FILE_OPEN_TRUNCATE);
+    if(oc_file_last_error(*out) != OC_IO_OK)
     {
+        oc_file_close(*out);
         return false;
     }
     return true;
 }
+
+static bool tar_out_file_write(tar_out_file* out, char* buf, u64 size)
+{
+    return (oc_file_write(*out, size, buf) == size);
+}
+
+static bool tar_out_file_close(tar_out_file* out)
+{
+    oc_file_close(*out);
+    return true;
+}
 #elif OC_PLATFORM_MACOS
+typedef int tar_out_file;
+
 // NOTE(shaw): open() is used here because some files extracted from an archive
 // need execute permissions which is not possible with oc_file_open or fopen
-static bool write_file_from_tar(oc_str8 path, mtar_header_t* header, char* buf, u64 size)
+static bool tar_out_file_open(tar_out_file* out, oc_str8 path, mtar_header_t* header)
 {
     oc_arena_scope scratch = oc_scratch_begin();
     char* cpath = oc_str8_to_cstring(scratch.arena, path);
-    int fd = open(cpath, O_WRONLY | O_CREAT, header->mode);
+    *out = open(cpath, O_WRONLY | O_CREAT | O_TRUNC, header->mode);
+    oc_scratch_end(scratch);
+    return (*out != -1);
+}
 
-    bool write_success = true;
+static bool tar_out_file_write(tar_out_file* out, char* buf, u64 size)
+{
     ssize_t bytes_written = 0;
     for(u64 off = 0; off < size; off += bytes_written)
     {
-        bytes_written = write(fd, buf + off, size - off);
+        bytes_written = write(*out, buf + off, size - off);
         if(bytes_written == 0 || bytes_written == -1)
         {
-            write_success = false;
-            break;
+            return false;
         }
     }
+    return true;
+}
 
-    int err = close(fd);
-    oc_scratch_end(scratch);
-    if(err == -1)
-    {
-        return false;
-    }
-
-    return write_success;
+static bool tar_out_file_close(tar_out_file* out)
+{
+    return (close(*out) != -1);
 }
 #else
-    #error write_file_from_tar() not implemented on this platform.
+    #error tar_out_file not implemented on this platform.
 #endif
 
-int gzip_decompress(gzFile in_file, FILE* out_file)
+//NOTE: copies the data of the current entry to a file, one chunk at a time
+static int write_file_from_tar(mtar_t* tar, mtar_header_t* header, oc_str8 path, char* buf)
 {
-    oc_arena_scope scratch = oc_scratch_begin();
-    char* out = oc_arena_push(scratch.arena, CHUNK_SIZE);
-    int uncompressed_bytes = 0;
-    int bytes_written = 0;
-    int result = Z_OK;
+    tar_out_file out;
+    if(!tar_out_file_open(&out, path, header))
+    {
+        return MTAR_EWRITEFAIL;
+    }
 
-    for(;;)
+    int err = MTAR_ESUCCESS;
+    for(u64 off = 0; off < header->size;)
     {
-        uncompressed_bytes = gzread(in_file, out, CHUNK_SIZE);
-        if(uncompressed_bytes == -1)
+        unsigned size = (unsigned)oc_min(header->size - off, CHUNK_SIZE);
+        err = mtar_read_data(tar, buf, size);
+        if(err != MTAR_ESUCCESS)
         {
-            result = Z_STREAM_ERROR;
             break;
         }
-
-        bytes_written = (int)fwrite(out, 1, uncompressed_bytes, out_file);
-        if(bytes_written != uncompressed_bytes || ferror(out_file))
+        if(!tar_out_file_write(&out, buf, size))
         {
-            result = Z_ERRNO;
+            err = MTAR_EWRITEFAIL;
             break;
         }
+        off += size;
+    }
 
-        if(uncompressed_bytes < CHUNK_SIZE)
-        {
-            break;
-        }
+    if(!tar_out_file_close(&out) && err == MTAR_ESUCCESS)
+    {
+        err = MTAR_EWRITEFAIL;
     }
-    oc_scratch_end(scratch);
-    return result;
+    return err;
 }
 
-int untar(FILE* file, oc_str8 out_dir)
+static int untar(mtar_t* tar, oc_str8 out_dir)
 {
-    if(fseek(file, 0, SEEK_SET) != 0)
-    {
-        return MTAR_ESEEKFAIL;
-    }
+    oc_arena_scope scratch = oc_scratch_begin();
+    char* buf = oc_arena_push(scratch.arena, CHUNK_SIZE);
 
     mtar_header_t h;
-    mtar_t tar = { 0 };
-    tar.write = custom_file_write;
-    tar.read = custom_file_read;
-    tar.seek = custom_file_seek;
-    tar.close = custom_file_close;
-    tar.stream = file;
-
-    int err = mtar_read_header(&tar, &h);
+    int err = mtar_read_header(tar, &h);
     while(err == MTAR_ESUCCESS)
     {
         if(h.type == MTAR_TDIR)
         {
-            oc_arena_scope scratch = oc_scratch_begin();
-            oc_str8 dir_path = oc_path_append(scratch.arena, out_dir, OC_STR8(h.name));
+            oc_arena_scope pathScratch = oc_scratch_begin_next(scratch.arena);
+            oc_str8 dir_path = oc_path_append(pathScratch.arena, out_dir, OC_STR8(h.name));
             bool ok = oc_sys_mkdirs(dir_path);
-            oc_scratch_end(scratch);
+            oc_scratch_end(pathScratch);
             if(!ok)
             {
                 err = MTAR_EWRITEFAIL;
@@ -158,21 +208,12 @@ int untar(FILE* file, oc_str8 out_dir)
         }
         else if(h.type == MTAR_TREG)
         {
-            oc_arena_scope scratch = oc_scratch_begin();
-            char* buf = oc_arena_push(scratch.arena, h.size + 1);
-            err = mtar_read_data(&tar, buf, h.size);
+            oc_arena_scope pathScratch = oc_scratch_begin_next(scratch.arena);
+            oc_str8 path = oc_path_append(pathScratch.arena, out_dir, OC_STR8(h.name));
+            err = write_file_from_tar(tar, &h, path, buf);
+            oc_scratch_end(pathScratch);
             if(err != MTAR_ESUCCESS)
             {
-                oc_scratch_end(scratch);
-                break;
-            }
-
-            oc_str8 path = oc_path_append(scratch.arena, out_dir, OC_STR8(h.name));
-            bool ok = write_file_from_tar(path, &h, buf, h.size);
-            oc_scratch_end(scratch);
-            if(!ok)
-            {
-                err = MTAR_EWRITEFAIL;
                 break;
             }
         }
@@ -181,9 +222,13 @@ int untar(FILE* file, oc_str8 out_dir)
             // skip unknown / unhandled file types
         }
 
-        mtar_next(&tar);
-        err = mtar_read_header(&tar, &h);
+        err = mtar_next(tar);
+        if(err == MTAR_ESUCCESS)
+        {
+            err = mtar_read_header(tar, &h);
+        }
     }
+    oc_scratch_end(scratch);
 
     if(err == MTAR_ENULLRECORD)
     {
@@ -197,24 +242,9 @@ bool tarball_extract(oc_str8 filepath, oc_str8 out_dir)
 {
     bool result = true;
     oc_arena_scope scratch = oc_scratch_begin();
-
-    oc_str8 filename = oc_path_slice_filename(filepath);
-    oc_str8 gz_ext = OC_STR8(".gz");
-    oc_str8 tar_path = { 0 };
-    if(oc_str8_ends_with(filename, gz_ext))
-    {
-        oc_str8 tar_name = oc_str8_slice(filename, 0, filename.len - gz_ext.len);
-        tar_path = oc_path_append(scratch.arena, out_dir, tar_name);
-    }
-    else
-    {
-        tar_path = oc_path_append(scratch.arena, out_dir, OC_STR8("temp.tar"));
-    }
-
-    char* tar_path_cstr = oc_str8_to_cstring(scratch.arena, tar_path);
     char* filepath_cstr = oc_str8_to_cstring(scratch.arena, filepath);
-    FILE* tar_file = NULL;
 
+    //NOTE: gzopen() also reads uncompressed files, so plain .tar archives go through the same path
     gzFile in_file = gzopen(filepath_cstr, "rb");
     if(!in_file)
     {
@@ -228,22 +258,15 @@ bool tarball_extract(oc_str8 filepath, oc_str8 out_dir)
         goto cleanup;
     }
 
-    tar_file = fopen(tar_path_cstr, "wb+");
-    if(!tar_file)
-    {
-        result = false;
-        goto cleanup;
-    }
-
-    int err = gzip_decompress(in_file, tar_file);
-    if(err != Z_OK)
-    {
-        result = false;
-        goto cleanup;
-    }
+    tar_gz_stream stream = { .file = in_file };
+    mtar_t tar = {
+        .read = tar_gz_stream_read,
+        .seek = tar_gz_stream_seek,
+        .close = tar_gz_stream_close,
+        .stream = &stream,
+    };
 
-    err = untar(tar_file, out_dir);
-    if(err != MTAR_ESUCCESS)
+    if(untar(&tar, out_dir) != MTAR_ESUCCESS)
     {
         result = false;
     }
@@ -253,11 +276,6 @@ cleanup:
     {
         gzclose(in_file);
     }
-    if(tar_file)
-    {
-        fclose(tar_file);
-        remove(tar_path_cstr);
-    }
     oc_scratch_end(scratch);
     return result;
 }
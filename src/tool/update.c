@@ -12,6 +12,7 @@
 #include "flag.h"
 #include "util.h"
 #include "tarball.h"
+#include "sha256.h"
 #include "orca.h"
 
 #if OC_PLATFORM_WINDOWS
@@ -31,9 +32,39 @@
 
 static char curl_errbuf[CURL_ERROR_SIZE]; // buffer for last curl error message
 
-static size_t curl_callback_write_to_file(char* data, size_t size, size_t nmemb, void* userdata);
+enum
+{
+    DOWNLOAD_MAX_ATTEMPTS = 8,
+    DOWNLOAD_LOW_SPEED_TIME = 30, // seconds under DOWNLOAD_LOW_SPEED_LIMIT before a transfer is considered stalled
+    DOWNLOAD_LOW_SPEED_LIMIT = 64,
+    DOWNLOAD_HASH_CHUNK_SIZE = 1 << 20,
+};
+
+//NOTE: a file downloaded by download_files(). Data goes to path.part, which is renamed to path once complete,
+//      so that an interrupted download can be resumed by a later run.
+typedef struct download
+{
+    oc_str8 url;
+    oc_str8 path;
+    bool optional; // a missing file is not an error, found is set to false instead
+
+    // results
+    bool found;
+    u8 sha256[SHA256_DIGEST_SIZE]; // digest of the whole file, computed while it is written
+
+    // internal state
+    CURL* handle;
+    char errbuf[CURL_ERROR_SIZE];
+    oc_str8 partPath;
+    oc_file file; // nil when the part file isn't open
+    u64 offset;
+    bool checkedStatus;
+    sha256_context sha;
+    u32 attempts;
+} download;
+
 static const char* curl_last_error(CURLcode code);
-static CURLcode download_file(CURL* handle, oc_str8 url, oc_str8 out_path);
+static bool download_files(oc_arena* arena, download* downloads, u32 count);
 static bool overwrite_current_version(oc_str8 new_version);
 static int replace_yourself_and_update(CURL* curl, oc_str8 repo_url_base, oc_str8 orca_dir, oc_str8 old_version, oc_str8 new_version);
 
@@ -129,26 +160,87 @@ int update(int argc, char** argv)
             oc_str8 release_tarname = oc_str8_pushf(&arena, "%.*s.tar.gz",
                                                     oc_str8_ip(RELEASE_FILENAME));
 
-            oc_str8 release_url = oc_str8_pushf(&arena, "/releases/latest/download/%.*s",
+            //NOTE: download from the version's release rather than from the latest one, so that a partial
+            //      download resumed by a later run can't mix two versions
+            oc_str8 release_url = oc_str8_pushf(&arena, "/releases/download/%.*s/%.*s",
+                                                oc_str8_ip(version),
                                                 oc_str8_ip(release_tarname));
 
             release_url = oc_path_append(&arena, repo_url_base, release_url);
-            oc_str8 release_filepath = oc_path_append(&arena, temp_dir, release_tarname);
 
-            curl_code = download_file(curl, release_url, release_filepath);
-            if(curl_code != CURLE_OK)
+            //NOTE: the tarball is downloaded outside of the temporary directory, which is cleared on each run,
+            //      so that it can be resumed if the download is interrupted
+            oc_str8 download_dir = oc_path_append(&arena, orca_dir, OC_STR8("downloads"));
+            if(!oc_sys_exists(download_dir))
+            {
+                TRY(oc_sys_mkdirs(download_dir));
+            }
+            oc_str8 release_filepath = oc_path_append(&arena,
+                                                      download_dir,
+                                                      oc_str8_pushf(&arena, "%.*s-%.*s",
+                                                                    oc_str8_ip(version),
+                                                                    oc_str8_ip(release_tarname)));
+
+            //NOTE: releases that predate checksum files don't have one, in which case we can't verify the tarball
+            download downloads[2] = {
+                {
+                    .url = release_url,
+                    .path = release_filepath,
+                },
+                {
+                    .url = oc_str8_pushf(&arena, "%.*s.sha256", oc_str8_ip(release_url)),
+                    .path = oc_path_append(&arena, temp_dir, oc_str8_pushf(&arena, "%.*s.sha256", oc_str8_ip(release_tarname))),
+                    .optional = true,
+                },
+            };
+            if(!download_files(&arena, downloads, oc_array_size(downloads)))
             {
-                fprintf(stderr, "error: failed to download file %s: %s\n",
-                        release_url.ptr, curl_last_error(curl_code));
                 return 1;
             }
 
+            oc_str8 tarball_sha = sha256_to_hex(&arena, downloads[0].sha256);
+            if(downloads[1].found)
+            {
+                oc_str8 expected_sha = { 0 };
+                oc_file sha_file = oc_file_open(downloads[1].path, OC_FILE_ACCESS_READ, OC_FILE_OPEN_NONE);
+                if(oc_file_last_error(sha_file) == OC_IO_OK)
+                {
+                    //NOTE: sha256sum format, the hex digest comes first
+                    expected_sha.len = oc_min(oc_file_size(sha_file), tarball_sha.len);
+                    expected_sha.ptr = oc_arena_push(&arena, expected_sha.len + 1);
+                    expected_sha.len = oc_file_read(sha_file, expected_sha.len, expected_sha.ptr);
+                }
+                oc_io_error sha_error = oc_file_last_error(sha_file);
+                oc_file_close(sha_file);
+
+                if(sha_error != OC_IO_OK)
+                {
+                    fprintf(stderr, "error: failed to read checksum file %.*s\n", oc_str8_ip(downloads[1].path));
+                    remove(release_filepath.ptr);
+                    return 1;
+                }
+
+                if(oc_str8_cmp(expected_sha, tarball_sha))
+                {
+                    fprintf(stderr, "error: checksum mismatch for %s\n", release_url.ptr);
+                    fprintf(stderr, "    expected: %.*s\n", oc_str8_ip(expected_sha));
+                    fprintf(stderr, "         got: %.*s\n", oc_str8_ip(tarball_sha));
+                    remove(release_filepath.ptr);
+                    return 1;
+                }
+            }
+            else
+            {
+                printf("warning: no checksum published for %.*s, skipping verification\n", oc_str8_ip(release_tarname));
+            }
+
             printf("Extracting Orca SDK...\n");
             if(!tarball_extract(release_filepath, temp_dir))
             {
                 fprintf(stderr, "error: failed to extract files from %s\n", release_filepath.ptr);
                 return 1;
             }
+            remove(release_filepath.ptr);
         }
     }
     else
@@ -267,12 +359,6 @@ end:
     return 0;
 }
 
-static size_t curl_callback_write_to_file(char* data, size_t size, size_t nmemb, void* userdata)
-{
-    oc_file* file = (oc_file*)userdata;
-    return oc_file_write(*file, size * nmemb, data);
-}
-
 static const char* curl_last_error(CURLcode code)
 {
     // if there is no message in curl_errbuf, then fall back to the less
@@ -281,25 +367,280 @@ static const char* curl_last_error(CURLcode code)
     return len ? curl_errbuf : curl_easy_strerror(code);
 }
 
-static CURLcode download_file(CURL* handle, oc_str8 url, oc_str8 out_path)
+static bool download_open_part(download* d, bool resume)
 {
-    oc_file file = oc_file_open(out_path, OC_FILE_ACCESS_WRITE, OC_FILE_OPEN_CREATE | OC_FILE_OPEN_TRUNCATE);
-    if(oc_file_is_nil(file))
+    d->offset = 0;
+    d->checkedStatus = false;
+    sha256_init(&d->sha);
+
+    if(resume && oc_sys_exists(d->partPath))
     {
+        //NOTE: the digest covers the whole file, so hash what we already have before appending to it
+        oc_file file = oc_file_open(d->partPath, OC_FILE_ACCESS_READ, OC_FILE_OPEN_NONE);
+        if(oc_file_last_error(file) == OC_IO_OK)
+        {
+            oc_arena_scope scratch = oc_scratch_begin();
+            char* buffer = oc_arena_push(scratch.arena, DOWNLOAD_HASH_CHUNK_SIZE);
+            u64 size = oc_file_size(file);
+            while(d->offset < size)
+            {
+                u64 chunkSize = oc_min(size - d->offset, DOWNLOAD_HASH_CHUNK_SIZE);
+                if(oc_file_read(file, chunkSize, buffer) != chunkSize)
+                {
+                    break;
+                }
+                sha256_update(&d->sha, buffer, chunkSize);
+                d->offset += chunkSize;
+            }
+            oc_scratch_end(scratch);
+            if(d->offset != size)
+            {
+                d->offset = 0;
+            }
+        }
         oc_file_close(file);
-        return CURLE_WRITE_ERROR;
+
+        if(d->offset)
+        {
+            //NOTE: if the part file can't be reopened for appending, fall back to a fresh download
+            d->file = oc_file_open(d->partPath, OC_FILE_ACCESS_WRITE, OC_FILE_OPEN_APPEND);
+            if(oc_file_last_error(d->file) == OC_IO_OK)
+            {
+                oc_file_seek(d->file, d->offset, OC_FILE_SEEK_SET);
+                if(oc_file_last_error(d->file) == OC_IO_OK)
+                {
+                    return true;
+                }
+            }
+            oc_file_close(d->file);
+            d->file = oc_file_nil();
+        }
     }
 
-    curl_easy_reset(handle);
-    curl_easy_setopt(handle, CURLOPT_ERRORBUFFER, curl_errbuf);
-    curl_easy_setopt(handle, CURLOPT_FAILONERROR, 1);
-    curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1);
-    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, curl_callback_write_to_file);
-    curl_easy_setopt(handle, CURLOPT_WRITEDATA, &file);
-    curl_easy_setopt(handle, CURLOPT_URL, url.ptr);
-    CURLcode err = curl_easy_perform(handle);
-    oc_file_close(file);
-    return err;
+    d->offset = 0;
+    sha256_init(&d->sha);
+    d->file = oc_file_open(d->partPath, OC_FILE_ACCESS_WRITE, OC_FILE_OPEN_CREATE | OC_FILE_OPEN_TRUNCATE);
+    if(oc_file_last_error(d->file) != OC_IO_OK)
+    {
+        oc_file_close(d->file);
+        d->file = oc_file_nil();
+        return false;
+    }
+    return true;
+}
+
+static size_t curl_callback_write_download(char* data, size_t size, size_t nmemb, void* userdata)
+{
+    download* d = (download*)userdata;
+
+    if(!d->checkedStatus)
+    {
+        //NOTE: a server that ignores the range request sends the whole file again
+        long status = 0;
+        curl_easy_getinfo(d->handle, CURLINFO_RESPONSE_CODE, &status);
+        if(d->offset && status != 206)
+        {
+            oc_file_close(d->file);
+            d->file = oc_file_nil();
+            if(!download_open_part(d, false))
+            {
+                return 0;
+            }
+        }
+        d->checkedStatus = true;
+    }
+
+    u64 written = oc_file_write(d->file, size * nmemb, data);
+    sha256_update(&d->sha, data, written);
+    d->offset += written;
+    return written;
+}
+
+static bool download_start(CURLM* multi, download* d)
+{
+    d->attempts++;
+    if(!download_open_part(d, true))
+    {
+        fprintf(stderr, "error: failed to open file %.*s\n", oc_str8_ip(d->partPath));
+        return false;
+    }
+
+    d->errbuf[0] = '\0';
+    curl_easy_reset(d->handle);
+    curl_easy_setopt(d->handle, CURLOPT_ERRORBUFFER, d->errbuf);
+    curl_easy_setopt(d->handle, CURLOPT_FAILONERROR, 1);
+    curl_easy_setopt(d->handle, CURLOPT_FOLLOWLOCATION, 1);
+    curl_easy_setopt(d->handle, CURLOPT_WRITEFUNCTION, curl_callback_write_download);
+    curl_easy_setopt(d->handle, CURLOPT_WRITEDATA, d);
+    curl_easy_setopt(d->handle, CURLOPT_PRIVATE, d);
+    curl_easy_setopt(d->handle, CURLOPT_URL, d->url.ptr);
+    curl_easy_setopt(d->handle, CURLOPT_RESUME_FROM_LARGE, (curl_off_t)d->offset);
+    curl_easy_setopt(d->handle, CURLOPT_LOW_SPEED_LIMIT, (long)DOWNLOAD_LOW_SPEED_LIMIT);
+    curl_easy_setopt(d->handle, CURLOPT_LOW_SPEED_TIME, (long)DOWNLOAD_LOW_SPEED_TIME);
+
+    if(d->offset)
+    {
+        printf("Resuming download of %.*s at %llu bytes...\n",
+               oc_str8_ip(oc_path_slice_filename(d->path)),
+               (unsigned long long)d->offset);
+    }
+    return (curl_multi_add_handle(multi, d->handle) == CURLM_OK);
+}
+
+static bool download_should_retry(download* d, CURLcode code)
+{
+    if(d->attempts >= DOWNLOAD_MAX_ATTEMPTS)
+    {
+        return false;
+    }
+    switch(code)
+    {
+        case CURLE_COULDNT_RESOLVE_HOST:
+        case CURLE_COULDNT_CONNECT:
+        case CURLE_PARTIAL_FILE:
+        case CURLE_OPERATION_TIMEDOUT:
+        case CURLE_SSL_CONNECT_ERROR:
+        case CURLE_GOT_NOTHING:
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_HTTP2:
+        case CURLE_HTTP2_STREAM:
+            return true;
+        default:
+            return false;
+    }
+}
+
+//NOTE: returns true if the download is finished, or false if it must be retried or failed (in which case
+//      *failed is set)
+static bool download_finish(download* d, CURLcode code, bool* failed)
+{
+    long status = 0;
+    curl_easy_getinfo(d->handle, CURLINFO_RESPONSE_CODE, &status);
+    oc_file_close(d->file);
+    d->file = oc_file_nil();
+
+    //NOTE: a 416 on a resumed download means the part file was already complete
+    if(code == CURLE_HTTP_RETURNED_ERROR && status == 416 && d->offset)
+    {
+        code = CURLE_OK;
+    }
+
+    if(code == CURLE_OK)
+    {
+        sha256_final(&d->sha, d->sha256);
+        remove(d->path.ptr);
+        if(!oc_sys_move(d->partPath, d->path))
+        {
+            fprintf(stderr, "error: failed to move %s to %s\n", d->partPath.ptr, d->path.ptr);
+            *failed = true;
+            return false;
+        }
+        d->found = true;
+        return true;
+    }
+    else if(code == CURLE_HTTP_RETURNED_ERROR && status == 404 && d->optional)
+    {
+        remove(d->partPath.ptr);
+        d->found = false;
+        return true;
+    }
+    else if(download_should_retry(d, code))
+    {
+        fprintf(stderr, "warning: download of %s interrupted (%s), retrying...\n",
+                d->url.ptr, d->errbuf[0] ? d->errbuf : curl_easy_strerror(code));
+        return false;
+    }
+    else
+    {
+        fprintf(stderr, "error: failed to download file %s: %s\n",
+                d->url.ptr, d->errbuf[0] ? d->errbuf : curl_easy_strerror(code));
+        *failed = true;
+        return false;
+    }
+}
+
+//NOTE: downloads all files concurrently. Interrupted transfers are resumed with range requests, including
+//      part files left by a previous run.
+static bool download_files(oc_arena* arena, download* downloads, u32 count)
+{
+    CURLM* multi = curl_multi_init();
+    if(!multi)
+    {
+        fprintf(stderr, "error: failed to initialize curl\n");
+        return false;
+    }
+
+    bool failed = false;
+    u32 pending = 0;
+    for(u32 i = 0; i < count && !failed; i++)
+    {
+        download* d = &downloads[i];
+        d->partPath = oc_str8_pushf(arena, "%.*s.part", oc_str8_ip(d->path));
+        d->handle = curl_easy_init();
+        if(!d->handle || !download_start(multi, d))
+        {
+            failed = true;
+            break;
+        }
+        pending++;
+    }
+
+    while(pending && !failed)
+    {
+        int running = 0;
+        if(curl_multi_perform(multi, &running) != CURLM_OK)
+        {
+            failed = true;
+            break;
+        }
+
+        CURLMsg* msg = 0;
+        int queued = 0;
+        while((msg = curl_multi_info_read(multi, &queued)) != 0)
+        {
+            if(msg->msg != CURLMSG_DONE)
+            {
+                continue;
+            }
+            download* d = 0;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&d);
+            CURLcode code = msg->data.result;
+            curl_multi_remove_handle(multi, d->handle);
+
+            if(download_finish(d, code, &failed))
+            {
+                pending--;
+            }
+            else if(!failed && !download_start(multi, d))
+            {
+                failed = true;
+            }
+        }
+
+        if(pending && !failed && curl_multi_poll(multi, 0, 0, 1000, 0) != CURLM_OK)
+        {
+            failed = true;
+        }
+    }
+
+    for(u32 i = 0; i < count; i++)
+    {
+        download* d = &downloads[i];
+        if(d->handle)
+        {
+            curl_multi_remove_handle(multi, d->handle);
+            curl_easy_cleanup(d->handle);
+            d->handle = 0;
+        }
+        if(!oc_file_is_nil(d->file))
+        {
+            oc_file_close(d->file);
+        }
+    }
+    curl_multi_cleanup(multi);
+
+    return (!failed);
 }
 
 static bool overwrite_current_version(oc_str8 new_version)
@@ -0,0 +1,139 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2024 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <stdio.h>
+
+#include "wasm_strip.h"
+#include "system.h"
+
+enum
+{
+    WASM_HEADER_SIZE = 8,
+    WASM_SECTION_CUSTOM = 0,
+};
+
+static const char WASM_HEADER[WASM_HEADER_SIZE] = { 0x00, 'a', 's', 'm', 0x01, 0x00, 0x00, 0x00 };
+
+static bool wasm_read_leb128_u32(oc_str8 blob, u64* offset, u32* value)
+{
+    *value = 0;
+    for(u32 shift = 0; shift < 35; shift += 7)
+    {
+        if(*offset >= blob.len)
+        {
+            return false;
+        }
+        u8 byte = blob.ptr[(*offset)++];
+        *value |= (u32)(byte & 0x7f) << shift;
+        if(!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool wasm_strip_error(const char* msg, oc_str8 path)
+{
+    snprintf(oc_sys_err.msg, OC_SYS_MAX_ERROR, "%s \"%.*s\"", msg, oc_str8_ip(path));
+    oc_sys_err.code = 1;
+    return false;
+}
+
+bool wasm_strip(oc_arena* a, oc_str8 inPath, oc_str8 outPath, oc_str8 namesPath, bool* hasNames)
+{
+    *hasNames = false;
+
+    oc_file file = oc_file_open(inPath, OC_FILE_ACCESS_READ, OC_FILE_OPEN_NONE);
+    if(oc_file_last_error(file) != OC_IO_OK)
+    {
+        oc_file_close(file);
+        return wasm_strip_error("failed to open wasm module", inPath);
+    }
+    oc_str8 blob = { .len = oc_file_size(file) };
+    blob.ptr = oc_arena_push(a, blob.len);
+    u64 readSize = blob.len ? oc_file_read(file, blob.len, blob.ptr) : 0;
+    oc_file_close(file);
+
+    if(readSize != blob.len)
+    {
+        return wasm_strip_error("failed to read wasm module", inPath);
+    }
+    if(blob.len < WASM_HEADER_SIZE || memcmp(blob.ptr, WASM_HEADER, WASM_HEADER_SIZE))
+    {
+        return wasm_strip_error("invalid wasm module header in", inPath);
+    }
+
+    //NOTE: sections are copied as is, since none of them refer to the offsets of other sections
+    oc_str8_list sections = { 0 };
+    oc_str8 nameSection = { 0 };
+    oc_str8_list_push(a, &sections, oc_str8_slice(blob, 0, WASM_HEADER_SIZE));
+
+    u64 offset = WASM_HEADER_SIZE;
+    while(offset < blob.len)
+    {
+        u64 sectionStart = offset;
+        u8 id = blob.ptr[offset++];
+        u32 size = 0;
+        if(!wasm_read_leb128_u32(blob, &offset, &size) || size > blob.len - offset)
+        {
+            return wasm_strip_error("malformed section in wasm module", inPath);
+        }
+        u64 sectionEnd = offset + size;
+
+        if(id == WASM_SECTION_CUSTOM)
+        {
+            u32 nameLen = 0;
+            if(!wasm_read_leb128_u32(blob, &offset, &nameLen) || nameLen > sectionEnd - offset)
+            {
+                return wasm_strip_error("malformed custom section in wasm module", inPath);
+            }
+            oc_str8 name = oc_str8_slice(blob, offset, offset + nameLen);
+            if(!oc_str8_cmp(name, OC_STR8("name")))
+            {
+                nameSection = oc_str8_slice(blob, sectionStart, sectionEnd);
+            }
+        }
+        else
+        {
+            oc_str8_list_push(a, &sections, oc_str8_slice(blob, sectionStart, sectionEnd));
+        }
+        offset = sectionEnd;
+    }
+
+    oc_str8 stripped = oc_str8_list_join(a, sections);
+
+    FILE* out = fopen(oc_str8_to_cstring(a, outPath), "wb");
+    if(!out)
+    {
+        return wasm_strip_error("failed to create wasm module", outPath);
+    }
+    bool ok = (fwrite(stripped.ptr, 1, stripped.len, out) == stripped.len);
+    fclose(out);
+    if(!ok)
+    {
+        return wasm_strip_error("failed to write wasm module", outPath);
+    }
+
+    if(nameSection.len && namesPath.len)
+    {
+        out = fopen(oc_str8_to_cstring(a, namesPath), "wb");
+        if(!out)
+        {
+            return wasm_strip_error("failed to create names file", namesPath);
+        }
+        ok = (fwrite(WASM_HEADER, 1, WASM_HEADER_SIZE, out) == WASM_HEADER_SIZE)
+          && (fwrite(nameSection.ptr, 1, nameSection.len, out) == nameSection.len);
+        fclose(out);
+        if(!ok)
+        {
+            return wasm_strip_error("failed to write names file", namesPath);
+        }
+        *hasNames = true;
+    }
+    return true;
+}
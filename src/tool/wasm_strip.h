@@ -0,0 +1,15 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2024 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "orca.h"
+
+// Copies the wasm module at inPath to outPath without its custom sections (names, DWARF, producers...). inPath
+// and outPath can be the same file. If the module has a name section and namesPath is not empty, the name
+// section is written to namesPath as a module that only contains that section, which wasm tools can read.
+bool wasm_strip(oc_arena* a, oc_str8 inPath, oc_str8 outPath, oc_str8 namesPath, bool* hasNames);
@@ -1,9 +1,9 @@
-/*************************************************************************
-*
-*  Orca
-*  Copyright 2023 Martin Fouilleul and the Orca project contributors
-*  See LICENSE.txt for licensing information
-*
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
 **************************************************************************/
 
 #include <processenv.h>
@@ -148,6 +148,41 @@ bool oc_sys_copy(oc_str8 src, oc_str8 dst)
     return true;
 }
 
+// NOTE: dst must be a file path that doesn't exist yet. If hardlink is true, we try to make dst a hardlink
+// to src and fall back to copying it, e.g. if they are on different volumes. Files written through
+// a hardlink also modify the original.
+bool oc_sys_clone(oc_str8 src, oc_str8 dst, bool hardlink)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_str8 full_src = oc_path_canonical(scratch.arena, src);
+    oc_str8 full_dst = oc_path_canonical(scratch.arena, dst);
+    char* full_src_cstr = oc_str8_to_cstring(scratch.arena, full_src);
+    char* full_dst_cstr = oc_str8_to_cstring(scratch.arena, full_dst);
+
+    BOOL result = false;
+    if(hardlink)
+    {
+        result = CreateHardLink(full_dst_cstr, full_src_cstr, NULL);
+    }
+    if(!result)
+    {
+        result = CopyFile(full_src_cstr, full_dst_cstr, false);
+    }
+
+    oc_scratch_end(scratch);
+
+    if(!result)
+    {
+        snprintf(oc_sys_err.msg, OC_SYS_MAX_ERROR,
+                 "failed to copy file \"%.*s\" to \"%.*s\"",
+                 oc_str8_ip(src), oc_str8_ip(dst));
+        oc_sys_err.code = GetLastError();
+        return false;
+    }
+
+    return true;
+}
+
 bool oc_sys_copytree(oc_str8 src, oc_str8 dst)
 {
     if(!oc_sys_isdir(src))
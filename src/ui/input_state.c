@@ -85,6 +85,35 @@ static void oc_update_mouse_move(oc_input_state* state, f32 x, f32 y, f32 deltaX
     mouse->delta.y += deltaY;
 }
 
+static void oc_update_pointer_history(oc_input_state* state, oc_mouse_event* event)
+{
+    u64 frameCounter = state->frameCounter;
+    oc_pointer_state* pointer = &state->pointer;
+    if(pointer->lastUpdate != frameCounter)
+    {
+        pointer->count = 0;
+        pointer->droppedCount = 0;
+        pointer->lastUpdate = frameCounter;
+    }
+
+    oc_pointer_sample sample = {
+        .pos = { event->x, event->y },
+        .pressure = event->pressure,
+        .time = event->time,
+    };
+
+    if(pointer->count < OC_INPUT_POINTER_HISTORY_SIZE)
+    {
+        pointer->samples[pointer->count] = sample;
+        pointer->count++;
+    }
+    else
+    {
+        pointer->samples[OC_INPUT_POINTER_HISTORY_SIZE - 1] = sample;
+        pointer->droppedCount++;
+    }
+}
+
 static void oc_update_mouse_leave(oc_input_state* state)
 {
     u64 frameCounter = state->frameCounter;
@@ -166,6 +195,7 @@ void oc_input_process_event(oc_arena* arena, oc_input_state* state, oc_event* ev
 
         case OC_EVENT_MOUSE_MOVE:
             oc_update_mouse_move(state, event->mouse.x, event->mouse.y, event->mouse.deltaX, event->mouse.deltaY);
+            oc_update_pointer_history(state, &event->mouse);
             break;
 
         case OC_EVENT_MOUSE_LEAVE:
@@ -399,6 +429,18 @@ oc_vec2 oc_mouse_wheel(oc_input_state* input)
     }
 }
 
+oc_pointer_history oc_mouse_history(oc_input_state* input)
+{
+    oc_pointer_history history = { 0 };
+    if(input->pointer.lastUpdate == input->frameCounter)
+    {
+        history.count = input->pointer.count;
+        history.droppedCount = input->pointer.droppedCount;
+        history.samples = input->pointer.samples;
+    }
+    return (history);
+}
+
 oc_str32 oc_input_text_utf32(oc_arena* arena, oc_input_state* input)
 {
     oc_str32 res = { 0 };
@@ -70,6 +70,37 @@ typedef struct oc_text_state
     oc_str32 codePoints;
 } oc_text_state;
 
+enum
+{
+    OC_INPUT_POINTER_HISTORY_SIZE = 256
+};
+
+typedef struct oc_pointer_sample
+{
+    oc_vec2 pos;
+    f32 pressure;
+    f64 time;
+} oc_pointer_sample;
+
+//NOTE: every pointer position received during the frame, in order. When the backing array is full, the last sample is
+//      overwritten so that the history always ends at the latest position, and droppedCount is incremented.
+//      On Windows, positions between two cursor moves are reconstructed from raw mouse packets, so high-rate mice
+//      report more than one sample per message pump.
+typedef struct oc_pointer_state
+{
+    u64 lastUpdate;
+    u32 count;
+    u32 droppedCount;
+    oc_pointer_sample samples[OC_INPUT_POINTER_HISTORY_SIZE];
+} oc_pointer_state;
+
+typedef struct oc_pointer_history
+{
+    u32 count;
+    u32 droppedCount;
+    oc_pointer_sample* samples;
+} oc_pointer_history;
+
 typedef struct oc_clipboard_state
 {
     u64 lastUpdate;
@@ -81,6 +112,7 @@ typedef struct oc_input_state
     u64 frameCounter;
     oc_keyboard_state keyboard;
     oc_mouse_state mouse;
+    oc_pointer_state pointer;
     oc_text_state text;
     oc_clipboard_state clipboard;
 } oc_input_state;
@@ -108,6 +140,9 @@ ORCA_API oc_vec2 oc_mouse_position(oc_input_state* state);
 ORCA_API oc_vec2 oc_mouse_delta(oc_input_state* state);
 ORCA_API oc_vec2 oc_mouse_wheel(oc_input_state* state);
 
+//NOTE: the returned samples point into the input state and are valid until the next frame
+ORCA_API oc_pointer_history oc_mouse_history(oc_input_state* state);
+
 ORCA_API oc_str32 oc_input_text_utf32(oc_arena* arena, oc_input_state* state);
 ORCA_API oc_str8 oc_input_text_utf8(oc_arena* arena, oc_input_state* state);
 
@@ -195,30 +195,150 @@ oc_ui_key oc_ui_key_make_path(oc_str8_list path)
     return (key);
 }
 
+u64 oc_ui_hash_str8(oc_str8 string)
+{
+    return (oc_ui_hash_cstring(string.ptr, string.len));
+}
+
+oc_ui_key oc_ui_key_make_hash(u64 hash)
+{
+    u64 seed = 0;
+    oc_ui_box* parent = oc_ui_box_top();
+    if(parent)
+    {
+        seed = parent->key.hash;
+    }
+
+    //NOTE: combine with the parent's key, then mix with the splitmix64 finalizer so that sibling keys don't
+    //      differ in a few bits only
+    u64 h = seed ^ (hash + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    h = h ^ (h >> 31);
+
+    oc_ui_key key = { h };
+    return (key);
+}
+
 bool oc_ui_key_equal(oc_ui_key a, oc_ui_key b)
 {
     return (a.hash == b.hash);
 }
 
-void oc_ui_box_cache(oc_ui_context* ui, oc_ui_box* box)
+//NOTE: the box map is an open addressing table using robin hood probing. Entries are kept sorted by their distance to
+//      their home slot, so that lookups can stop early, and removals shift the following entries back instead of
+//      leaving tombstones.
+static u64 oc_ui_box_map_distance(oc_ui_context* ui, u64 hash, u64 slot)
 {
-    u64 index = box->key.hash & (OC_UI_BOX_MAP_BUCKET_COUNT - 1);
-    oc_list_push_back(&(ui->boxMap[index]), &box->bucketElt);
+    return ((slot - hash) & (ui->boxMapCap - 1));
 }
 
-oc_ui_box* oc_ui_box_lookup_key(oc_ui_key key)
+static void oc_ui_box_map_insert(oc_ui_context* ui, oc_ui_box_map_entry entry)
 {
-    oc_ui_context* ui = oc_ui_get_context();
-    u64 index = key.hash & (OC_UI_BOX_MAP_BUCKET_COUNT - 1);
+    u64 mask = ui->boxMapCap - 1;
+    u64 slot = entry.hash & mask;
+    u64 distance = 0;
 
-    oc_list_for(ui->boxMap[index], box, oc_ui_box, bucketElt)
+    while(ui->boxMap[slot].box)
     {
-        if(oc_ui_key_equal(key, box->key))
+        u64 otherDistance = oc_ui_box_map_distance(ui, ui->boxMap[slot].hash, slot);
+        if(otherDistance < distance)
         {
-            return (box);
+            oc_ui_box_map_entry tmp = ui->boxMap[slot];
+            ui->boxMap[slot] = entry;
+            entry = tmp;
+            distance = otherDistance;
         }
+        slot = (slot + 1) & mask;
+        distance++;
+    }
+    ui->boxMap[slot] = entry;
+    ui->boxMapCount++;
+}
+
+static i64 oc_ui_box_map_find_slot(oc_ui_context* ui, u64 hash)
+{
+    if(!ui->boxMapCap)
+    {
+        return (-1);
     }
-    return (0);
+    u64 mask = ui->boxMapCap - 1;
+    u64 slot = hash & mask;
+    u64 distance = 0;
+
+    while(ui->boxMap[slot].box)
+    {
+        if(ui->boxMap[slot].hash == hash)
+        {
+            return ((i64)slot);
+        }
+        if(oc_ui_box_map_distance(ui, ui->boxMap[slot].hash, slot) < distance)
+        {
+            break;
+        }
+        slot = (slot + 1) & mask;
+        distance++;
+    }
+    return (-1);
+}
+
+static void oc_ui_box_map_remove(oc_ui_context* ui, u64 hash)
+{
+    i64 found = oc_ui_box_map_find_slot(ui, hash);
+    if(found < 0)
+    {
+        return;
+    }
+    u64 mask = ui->boxMapCap - 1;
+    u64 slot = (u64)found;
+    u64 next = (slot + 1) & mask;
+
+    while(ui->boxMap[next].box && oc_ui_box_map_distance(ui, ui->boxMap[next].hash, next) != 0)
+    {
+        ui->boxMap[slot] = ui->boxMap[next];
+        slot = next;
+        next = (next + 1) & mask;
+    }
+    ui->boxMap[slot] = (oc_ui_box_map_entry){ 0 };
+    ui->boxMapCount--;
+}
+
+static void oc_ui_box_map_grow(oc_ui_context* ui)
+{
+    oc_ui_box_map_entry* oldMap = ui->boxMap;
+    u64 oldCap = ui->boxMapCap;
+
+    ui->boxMapCap = oldCap ? oldCap * 2 : OC_UI_BOX_MAP_MIN_CAP;
+    ui->boxMap = malloc(ui->boxMapCap * sizeof(oc_ui_box_map_entry));
+    memset(ui->boxMap, 0, ui->boxMapCap * sizeof(oc_ui_box_map_entry));
+    ui->boxMapCount = 0;
+
+    for(u64 i = 0; i < oldCap; i++)
+    {
+        if(oldMap[i].box)
+        {
+            oc_ui_box_map_insert(ui, oldMap[i]);
+        }
+    }
+    free(oldMap);
+}
+
+void oc_ui_box_cache(oc_ui_context* ui, oc_ui_box* box)
+{
+    //NOTE: keep the load factor under 3/4
+    if(4 * (ui->boxMapCount + 1) > 3 * ui->boxMapCap)
+    {
+        oc_ui_box_map_grow(ui);
+    }
+    oc_ui_box_map_insert(ui, (oc_ui_box_map_entry){ .hash = box->key.hash, .box = box });
+    oc_list_push_front(&ui->boxCache, &box->cacheElt);
+}
+
+oc_ui_box* oc_ui_box_lookup_key(oc_ui_key key)
+{
+    oc_ui_context* ui = oc_ui_get_context();
+    i64 slot = oc_ui_box_map_find_slot(ui, key.hash);
+    return (slot < 0 ? 0 : ui->boxMap[slot].box);
 }
 
 oc_ui_box* oc_ui_box_lookup_str8(oc_str8 string)
@@ -227,6 +347,77 @@ oc_ui_box* oc_ui_box_lookup_str8(oc_str8 string)
     return (oc_ui_box_lookup_key(key));
 }
 
+oc_ui_box* oc_ui_box_lookup_hash(u64 hash)
+{
+    oc_ui_key key = oc_ui_key_make_hash(hash);
+    return (oc_ui_box_lookup_key(key));
+}
+
+//-----------------------------------------------------------------------------
+// text metrics cache
+//-----------------------------------------------------------------------------
+
+typedef struct oc_ui_text_metrics_entry
+{
+    oc_list_elt bucketElt;
+    u64 frameCounter;
+    u64 hash;
+    oc_font font;
+    f32 fontSize;
+    oc_text_metrics metrics;
+
+} oc_ui_text_metrics_entry;
+
+oc_text_metrics oc_ui_text_metrics(oc_ui_context* ui, oc_font font, f32 fontSize, oc_str8 text)
+{
+    //NOTE: measurements are cached by (font, size, string hash), and entries that were not used
+    //      during a frame are evicted at the end of that frame.
+    u64 hash = oc_hash_xx64_string_seed(text, font.h);
+    u64 index = hash & (OC_UI_TEXT_METRICS_MAP_BUCKET_COUNT - 1);
+
+    oc_list_for(ui->textMetricsMap[index], entry, oc_ui_text_metrics_entry, bucketElt)
+    {
+        if(entry->hash == hash
+           && entry->font.h == font.h
+           && entry->fontSize == fontSize)
+        {
+            entry->frameCounter = ui->frameCounter;
+            return (entry->metrics);
+        }
+    }
+
+    oc_text_metrics metrics = oc_font_text_metrics(font, fontSize, text);
+
+    oc_ui_text_metrics_entry* entry = oc_pool_alloc_type(&ui->textMetricsPool, oc_ui_text_metrics_entry);
+    if(entry)
+    {
+        ui->frameStats.textMetricsAllocs++;
+        entry->frameCounter = ui->frameCounter;
+        entry->hash = hash;
+        entry->font = font;
+        entry->fontSize = fontSize;
+        entry->metrics = metrics;
+        oc_list_push_front(&ui->textMetricsMap[index], &entry->bucketElt);
+    }
+    return (metrics);
+}
+
+void oc_ui_text_metrics_prune(oc_ui_context* ui)
+{
+    for(int i = 0; i < OC_UI_TEXT_METRICS_MAP_BUCKET_COUNT; i++)
+    {
+        oc_list_for_safe(ui->textMetricsMap[i], entry, oc_ui_text_metrics_entry, bucketElt)
+        {
+            if(entry->frameCounter < ui->frameCounter)
+            {
+                oc_list_remove(&ui->textMetricsMap[i], &entry->bucketElt);
+                oc_pool_recycle(&ui->textMetricsPool, entry);
+                ui->frameStats.textMetricsRecycles++;
+            }
+        }
+    }
+}
+
 //-----------------------------------------------------------------------------
 // styling
 //-----------------------------------------------------------------------------
@@ -254,16 +445,33 @@ oc_ui_pattern oc_ui_pattern_owner(void)
     return (pattern);
 }
 
+//NOTE: a rule and its style are allocated together, so that each rule costs a single frame arena push
+typedef struct oc_ui_style_rule_storage
+{
+    oc_ui_style_rule rule;
+    oc_ui_style style;
+} oc_ui_style_rule_storage;
+
+oc_ui_style_rule* oc_ui_style_rule_make(oc_ui_context* ui, oc_ui_pattern pattern, oc_ui_style* style, oc_ui_style_mask mask)
+{
+    oc_ui_style_rule_storage* storage = oc_arena_push_type(&ui->frameArena, oc_ui_style_rule_storage);
+    oc_ui_style_rule* rule = &storage->rule;
+    memset(rule, 0, sizeof(oc_ui_style_rule));
+    rule->pattern = pattern;
+    rule->mask = mask;
+    rule->style = &storage->style;
+    *rule->style = *style;
+
+    ui->frameStats.ruleCount++;
+    return (rule);
+}
+
 void oc_ui_style_match_before(oc_ui_pattern pattern, oc_ui_style* style, oc_ui_style_mask mask)
 {
     oc_ui_context* ui = oc_ui_get_context();
     if(ui)
     {
-        oc_ui_style_rule* rule = oc_arena_push_type(&ui->frameArena, oc_ui_style_rule);
-        rule->pattern = pattern;
-        rule->mask = mask;
-        rule->style = oc_arena_push_type(&ui->frameArena, oc_ui_style);
-        *rule->style = *style;
+        oc_ui_style_rule* rule = oc_ui_style_rule_make(ui, pattern, style, mask);
 
         oc_list_push_back(&ui->nextBoxBeforeRules, &rule->boxElt);
     }
@@ -274,11 +482,7 @@ void oc_ui_style_match_after(oc_ui_pattern pattern, oc_ui_style* style, oc_ui_st
     oc_ui_context* ui = oc_ui_get_context();
     if(ui)
     {
-        oc_ui_style_rule* rule = oc_arena_push_type(&ui->frameArena, oc_ui_style_rule);
-        rule->pattern = pattern;
-        rule->mask = mask;
-        rule->style = oc_arena_push_type(&ui->frameArena, oc_ui_style);
-        *rule->style = *style;
+        oc_ui_style_rule* rule = oc_ui_style_rule_make(ui, pattern, style, mask);
 
         oc_list_push_back(&ui->nextBoxAfterRules, &rule->boxElt);
     }
@@ -294,11 +498,7 @@ void oc_ui_style_box_before(oc_ui_box* box, oc_ui_pattern pattern, oc_ui_style*
     oc_ui_context* ui = oc_ui_get_context();
     if(ui)
     {
-        oc_ui_style_rule* rule = oc_arena_push_type(&ui->frameArena, oc_ui_style_rule);
-        rule->pattern = pattern;
-        rule->mask = mask;
-        rule->style = oc_arena_push_type(&ui->frameArena, oc_ui_style);
-        *rule->style = *style;
+        oc_ui_style_rule* rule = oc_ui_style_rule_make(ui, pattern, style, mask);
 
         oc_list_push_back(&box->beforeRules, &rule->boxElt);
         rule->owner = box;
@@ -310,11 +510,7 @@ void oc_ui_style_box_after(oc_ui_box* box, oc_ui_pattern pattern, oc_ui_style* s
     oc_ui_context* ui = oc_ui_get_context();
     if(ui)
     {
-        oc_ui_style_rule* rule = oc_arena_push_type(&ui->frameArena, oc_ui_style_rule);
-        rule->pattern = pattern;
-        rule->mask = mask;
-        rule->style = oc_arena_push_type(&ui->frameArena, oc_ui_style);
-        *rule->style = *style;
+        oc_ui_style_rule* rule = oc_ui_style_rule_make(ui, pattern, style, mask);
 
         oc_list_push_back(&box->afterRules, &rule->boxElt);
         rule->owner = box;
@@ -368,24 +564,28 @@ bool oc_ui_box_hovering(oc_ui_box* box, oc_vec2 p)
 {
     oc_ui_context* ui = oc_ui_get_context();
 
-    oc_rect clip = oc_ui_clip_top();
-    oc_rect rect = oc_ui_intersect_rects(clip, box->rect);
-    bool hit = oc_ui_rect_hit(rect, p);
-    bool result = hit && (!ui->hovered || box->z >= ui->hovered->z);
+    //NOTE: boxes below the hovered box can't be hovering, so we don't need to test their rect
+    bool result = false;
+    if(!ui->hovered || box->z >= ui->hovered->z)
+    {
+        oc_rect clip = oc_ui_clip_top();
+        oc_rect rect = oc_ui_intersect_rects(clip, box->rect);
+        result = oc_ui_rect_hit(rect, p);
+    }
     return (result);
 }
 
-oc_ui_box* oc_ui_box_make_str8(oc_str8 string, oc_ui_flags flags)
+static oc_ui_box* oc_ui_box_make_key(oc_str8 string, oc_ui_key key, oc_ui_flags flags)
 {
     oc_ui_context* ui = oc_ui_get_context();
 
-    oc_ui_key key = oc_ui_key_make_str8(string);
     oc_ui_box* box = oc_ui_box_lookup_key(key);
 
     if(!box)
     {
         box = oc_pool_alloc_type(&ui->boxPool, oc_ui_box);
         memset(box, 0, sizeof(oc_ui_box));
+        ui->frameStats.boxAllocs++;
 
         box->key = key;
         box->fresh = true;
@@ -394,10 +594,27 @@ oc_ui_box* oc_ui_box_make_str8(oc_str8 string, oc_ui_flags flags)
     else
     {
         box->fresh = false;
+
+        //NOTE: keep the cache list sorted by last use, so that stale boxes can be pruned from its tail
+        oc_list_remove(&ui->boxCache, &box->cacheElt);
+        oc_list_push_front(&ui->boxCache, &box->cacheElt);
     }
 
     box->flags = flags;
-    box->string = oc_str8_push_copy(&ui->frameArena, string);
+    ui->frameStats.boxCount++;
+
+    //NOTE: the box owns a copy of its string, which is only updated when the string changes, so that boxes made
+    //      every frame don't copy their string into the frame arena.
+    if(box->string.len != string.len || (string.len && memcmp(box->string.ptr, string.ptr, string.len)))
+    {
+        if(string.len > box->stringCap)
+        {
+            box->stringCap = oc_max(string.len, 16);
+            box->string.ptr = realloc(box->string.ptr, box->stringCap);
+        }
+        memcpy(box->string.ptr, string.ptr, string.len);
+        box->string.len = string.len;
+    }
 
     //NOTE: setup hierarchy
     if(box->frameCounter != ui->frameCounter)
@@ -424,7 +641,6 @@ oc_ui_box* oc_ui_box_make_str8(oc_str8 string, oc_ui_flags flags)
     box->frameCounter = ui->frameCounter;
 
     //NOTE: create style and setup non-inherited attributes to default values
-    box->targetStyle = oc_arena_push_type(&ui->frameArena, oc_ui_style);
     oc_ui_style defaultStyle = {
         .size.width = { .kind = OC_UI_SIZE_CHILDREN,
                         .value = 0,
@@ -440,7 +656,7 @@ oc_ui_box* oc_ui_box_make_str8(oc_str8 string, oc_ui_flags flags)
         .color = ui->theme->text0,
         .fontSize = 14,
     };
-    oc_ui_apply_style_with_mask(box->targetStyle, &defaultStyle, ~0ULL);
+    oc_ui_apply_style_with_mask(&box->targetStyle, &defaultStyle, ~0ULL);
 
     //NOTE: set tags, before rules and last box
     box->tags = ui->nextBoxTags;
@@ -476,6 +692,23 @@ oc_ui_box* oc_ui_box_make_str8(oc_str8 string, oc_ui_flags flags)
     return (box);
 }
 
+oc_ui_box* oc_ui_box_make_str8(oc_str8 string, oc_ui_flags flags)
+{
+    return (oc_ui_box_make_key(string, oc_ui_key_make_str8(string), flags));
+}
+
+oc_ui_box* oc_ui_box_make_hash(oc_str8 string, u64 hash, oc_ui_flags flags)
+{
+    return (oc_ui_box_make_key(string, oc_ui_key_make_hash(hash), flags));
+}
+
+oc_ui_box* oc_ui_box_begin_hash(oc_str8 string, u64 hash, oc_ui_flags flags)
+{
+    oc_ui_box* box = oc_ui_box_make_hash(string, hash, flags);
+    oc_ui_box_push(box);
+    return (box);
+}
+
 oc_ui_box* oc_ui_box_begin_str8(oc_str8 string, oc_ui_flags flags)
 {
     oc_ui_context* ui = oc_ui_get_context();
@@ -629,7 +862,9 @@ void oc_ui_animate_f32(oc_ui_context* ui, f32* value, f32 target, f32 animationT
         f32 alpha = 3 / animationTime;
         f32 dt = ui->lastFrameDuration;
 
-        *value += (target - *value) * alpha * dt;
+        //NOTE: dt can be long after the app was idle, so clamp the step to avoid overshooting the target
+        *value += (target - *value) * oc_min(alpha * dt, 1);
+        ui->animating = true;
     }
 }
 
@@ -650,13 +885,12 @@ void oc_ui_animate_oc_ui_size(oc_ui_context* ui, oc_ui_size* size, oc_ui_size ta
 
 void oc_ui_box_animate_style(oc_ui_context* ui, oc_ui_box* box)
 {
-    oc_ui_style* targetStyle = box->targetStyle;
-    OC_DEBUG_ASSERT(targetStyle);
+    oc_ui_style* targetStyle = &box->targetStyle;
 
     f32 animationTime = targetStyle->animationTime;
 
     //NOTE: interpolate based on transition values
-    oc_ui_style_mask mask = box->targetStyle->animationMask;
+    oc_ui_style_mask mask = box->targetStyle.animationMask;
 
     if(box->fresh)
     {
@@ -887,7 +1121,79 @@ bool oc_ui_style_selector_match(oc_ui_box* box, oc_ui_style_rule* rule, oc_ui_se
     return (res);
 }
 
-void oc_ui_style_rule_match(oc_ui_context* ui, oc_ui_box* box, oc_ui_style_rule* rule, oc_list* buildList, oc_list* tmpList)
+//NOTE: rules are indexed on their first selector, so that each box only tests the rules that can match it. Rules
+//      whose first selector is a tag, key or text go in buckets keyed by its hash, others go in a list that is tested
+//      against every box. Rules keep an order number, so that matches are applied in the order they would have in a
+//      single list: ancestors' before rules first, then the box's own before rules, and the box's own after rules
+//      before ancestors' after rules. Derived rules are always appended last.
+enum
+{
+    OC_UI_RULE_INDEX_BUCKET_COUNT = 64,
+};
+
+typedef struct oc_ui_rule_index
+{
+    i64 firstOrder;
+    i64 lastOrder;
+    u64 textRuleCount;
+
+    oc_list anyRules;
+    oc_list tagRules[OC_UI_RULE_INDEX_BUCKET_COUNT];
+    oc_list keyRules[OC_UI_RULE_INDEX_BUCKET_COUNT];
+    oc_list textRules[OC_UI_RULE_INDEX_BUCKET_COUNT];
+} oc_ui_rule_index;
+
+static oc_list* oc_ui_rule_index_bucket(oc_ui_rule_index* index, oc_ui_style_rule* rule)
+{
+    oc_ui_selector* selector = oc_list_first_entry(rule->pattern.l, oc_ui_selector, listElt);
+    u64 mask = OC_UI_RULE_INDEX_BUCKET_COUNT - 1;
+
+    switch(selector->kind)
+    {
+        case OC_UI_SEL_TAG:
+            return (&index->tagRules[selector->tag.hash & mask]);
+
+        case OC_UI_SEL_KEY:
+            return (&index->keyRules[selector->key.hash & mask]);
+
+        case OC_UI_SEL_TEXT:
+            return (&index->textRules[oc_hash_xx64_string(selector->text) & mask]);
+
+        default:
+            return (&index->anyRules);
+    }
+}
+
+static void oc_ui_rule_index_insert(oc_ui_rule_index* index, oc_ui_style_rule* rule, bool front)
+{
+    rule->bucket = oc_ui_rule_index_bucket(index, rule);
+    if(rule->bucket >= index->textRules && rule->bucket < index->textRules + OC_UI_RULE_INDEX_BUCKET_COUNT)
+    {
+        index->textRuleCount++;
+    }
+
+    if(front)
+    {
+        rule->order = --index->firstOrder;
+        oc_list_push_front(rule->bucket, &rule->buildElt);
+    }
+    else
+    {
+        rule->order = ++index->lastOrder;
+        oc_list_push_back(rule->bucket, &rule->buildElt);
+    }
+}
+
+static void oc_ui_rule_index_remove(oc_ui_rule_index* index, oc_ui_style_rule* rule)
+{
+    if(rule->bucket >= index->textRules && rule->bucket < index->textRules + OC_UI_RULE_INDEX_BUCKET_COUNT)
+    {
+        index->textRuleCount--;
+    }
+    oc_list_remove(rule->bucket, &rule->buildElt);
+}
+
+void oc_ui_style_rule_match(oc_ui_context* ui, oc_ui_box* box, oc_ui_style_rule* rule, oc_ui_rule_index* index, oc_list* tmpList)
 {
     oc_ui_selector* selector = oc_list_first_entry(rule->pattern.l, oc_ui_selector, listElt);
     bool match = oc_ui_style_selector_match(box, rule, selector);
@@ -903,29 +1209,101 @@ void oc_ui_style_rule_match(oc_ui_context* ui, oc_ui_box* box, oc_ui_style_rule*
     {
         if(!selector)
         {
-            oc_ui_apply_style_with_mask(box->targetStyle, rule->style, rule->mask);
+            oc_ui_apply_style_with_mask(&box->targetStyle, rule->style, rule->mask);
         }
         else
         {
             //NOTE create derived rule if there's more than one selector
             oc_ui_style_rule* derived = oc_arena_push_type(&ui->frameArena, oc_ui_style_rule);
+            memset(derived, 0, sizeof(oc_ui_style_rule));
             derived->mask = rule->mask;
             derived->style = rule->style;
             derived->pattern.l = (oc_list){ &selector->listElt, rule->pattern.l.last };
 
-            oc_list_push_back(buildList, &derived->buildElt);
+            oc_ui_rule_index_insert(index, derived, false);
             oc_list_push_back(tmpList, &derived->tmpElt);
         }
     }
 }
 
-void oc_ui_styling_prepass(oc_ui_context* ui, oc_ui_box* box, oc_list* before, oc_list* after)
+void oc_ui_rule_index_match(oc_ui_context* ui, oc_ui_box* box, oc_ui_rule_index* index, oc_list* tmpList)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    //NOTE: collect the buckets that can hold rules matching this box
+    u64 maxBucketCount = 3;
+    oc_list_for(box->tags, elt, oc_ui_tag_elt, listElt)
+    {
+        maxBucketCount++;
+    }
+    oc_list** buckets = oc_arena_push_array(scratch.arena, oc_list*, maxBucketCount);
+    u64 bucketCount = 0;
+    u64 mask = OC_UI_RULE_INDEX_BUCKET_COUNT - 1;
+
+    buckets[bucketCount++] = &index->anyRules;
+    buckets[bucketCount++] = &index->keyRules[box->key.hash & mask];
+    if(index->textRuleCount)
+    {
+        buckets[bucketCount++] = &index->textRules[oc_hash_xx64_string(box->string) & mask];
+    }
+    oc_list_for(box->tags, elt, oc_ui_tag_elt, listElt)
+    {
+        oc_list* bucket = &index->tagRules[elt->tag.hash & mask];
+        bool found = false;
+        for(u64 i = 0; i < bucketCount; i++)
+        {
+            if(buckets[i] == bucket)
+            {
+                found = true;
+                break;
+            }
+        }
+        if(!found)
+        {
+            buckets[bucketCount++] = bucket;
+        }
+    }
+
+    //NOTE: merge the buckets by rule order. We keep the last visited rule of each bucket rather than the next one,
+    //      so that we don't miss derived rules appended to a bucket we already went through.
+    oc_list_elt** visited = oc_arena_push_array(scratch.arena, oc_list_elt*, bucketCount);
+    memset(visited, 0, bucketCount * sizeof(oc_list_elt*));
+
+    while(1)
+    {
+        oc_ui_style_rule* next = 0;
+        u64 nextBucket = 0;
+        for(u64 i = 0; i < bucketCount; i++)
+        {
+            oc_list_elt* elt = visited[i] ? visited[i]->next : buckets[i]->first;
+            if(elt)
+            {
+                oc_ui_style_rule* rule = oc_list_entry(elt, oc_ui_style_rule, buildElt);
+                if(!next || rule->order < next->order)
+                {
+                    next = rule;
+                    nextBucket = i;
+                }
+            }
+        }
+        if(!next)
+        {
+            break;
+        }
+        visited[nextBucket] = &next->buildElt;
+        oc_ui_style_rule_match(ui, box, next, index, tmpList);
+    }
+
+    oc_scratch_end(scratch);
+}
+
+void oc_ui_styling_prepass(oc_ui_context* ui, oc_ui_box* box, oc_ui_rule_index* before, oc_ui_rule_index* after)
 {
     //NOTE: inherit style from parent
     if(box->parent)
     {
-        oc_ui_apply_style_with_mask(box->targetStyle,
-                                    box->parent->targetStyle,
+        oc_ui_apply_style_with_mask(&box->targetStyle,
+                                    &box->parent->targetStyle,
                                     OC_UI_STYLE_MASK_INHERITED);
     }
 
@@ -933,28 +1311,22 @@ void oc_ui_styling_prepass(oc_ui_context* ui, oc_ui_box* box, oc_list* before, o
     oc_list tmpBefore = { 0 };
     oc_list_for(box->beforeRules, rule, oc_ui_style_rule, boxElt)
     {
-        oc_list_push_back(before, &rule->buildElt);
+        oc_ui_rule_index_insert(before, rule, false);
         oc_list_push_back(&tmpBefore, &rule->tmpElt);
     }
     //NOTE: match before rules
-    oc_list_for(*before, rule, oc_ui_style_rule, buildElt)
-    {
-        oc_ui_style_rule_match(ui, box, rule, before, &tmpBefore);
-    }
+    oc_ui_rule_index_match(ui, box, before, &tmpBefore);
 
     //NOTE: prepend box after rules to after and append them to tmp
     oc_list tmpAfter = { 0 };
     oc_list_for_reverse(box->afterRules, rule, oc_ui_style_rule, boxElt)
     {
-        oc_list_push_front(after, &rule->buildElt);
+        oc_ui_rule_index_insert(after, rule, true);
         oc_list_push_back(&tmpAfter, &rule->tmpElt);
     }
 
     //NOTE: match after rules
-    oc_list_for(*after, rule, oc_ui_style_rule, buildElt)
-    {
-        oc_ui_style_rule_match(ui, box, rule, after, &tmpAfter);
-    }
+    oc_ui_rule_index_match(ui, box, after, &tmpAfter);
 
     //NOTE: compute static sizes
     oc_ui_box_animate_style(ui, box);
@@ -973,7 +1345,7 @@ void oc_ui_styling_prepass(oc_ui_context* ui, oc_ui_box* box, oc_list* before, o
     if(desiredSize[OC_UI_AXIS_X].kind == OC_UI_SIZE_TEXT
        || desiredSize[OC_UI_AXIS_Y].kind == OC_UI_SIZE_TEXT)
     {
-        textBox = oc_font_text_metrics(style->font, style->fontSize, box->string).logical;
+        textBox = oc_ui_text_metrics(ui, style->font, style->fontSize, box->string).logical;
     }
 
     for(int i = 0; i < OC_UI_AXIS_COUNT; i++)
@@ -983,11 +1355,11 @@ void oc_ui_styling_prepass(oc_ui_context* ui, oc_ui_box* box, oc_list* before, o
         if(size.kind == OC_UI_SIZE_TEXT)
         {
             f32 margin = style->layout.margin.c[i];
-            box->rect.c[2 + i] = textBox.c[2 + i] + margin * 2;
+            box->layoutCache.staticSize[i] = textBox.c[2 + i] + margin * 2;
         }
         else if(size.kind == OC_UI_SIZE_PIXELS)
         {
-            box->rect.c[2 + i] = size.value;
+            box->layoutCache.staticSize[i] = size.value;
         }
     }
 
@@ -1000,55 +1372,109 @@ void oc_ui_styling_prepass(oc_ui_context* ui, oc_ui_box* box, oc_list* before, o
     //NOTE: remove temporary rules
     oc_list_for(tmpBefore, rule, oc_ui_style_rule, tmpElt)
     {
-        oc_list_remove(before, &rule->buildElt);
+        oc_ui_rule_index_remove(before, rule);
     }
     oc_list_for(tmpAfter, rule, oc_ui_style_rule, tmpElt)
     {
-        oc_list_remove(after, &rule->buildElt);
+        oc_ui_rule_index_remove(after, rule);
     }
 }
 
-bool oc_ui_layout_downward_dependency(oc_ui_box* child, int axis)
+void oc_ui_layout_nodes_reserve(oc_ui_layout_nodes* layout, u32 count)
 {
-    return (!oc_ui_box_hidden(child)
-            && !child->style.floating.c[axis]
-            && child->style.size.c[axis].kind != OC_UI_SIZE_PARENT
-            && child->style.size.c[axis].kind != OC_UI_SIZE_PARENT_MINUS_PIXELS);
+    if(count > layout->cap)
+    {
+        u32 cap = oc_max(count, 2 * layout->cap);
+        cap = oc_max(cap, 256);
+        layout->nodes = realloc(layout->nodes, cap * sizeof(oc_ui_layout_node));
+        layout->boxes = realloc(layout->boxes, cap * sizeof(oc_ui_box*));
+        layout->cap = cap;
+    }
+}
+
+//NOTE: appends the node of a visible box. Its results start with the box's values of the last frame, which are still
+//      valid in the subtrees that the layout passes skip.
+u32 oc_ui_layout_node_push(oc_ui_context* ui, oc_ui_box* box)
+{
+    oc_ui_layout_nodes* layout = &ui->layoutNodes;
+    oc_ui_layout_nodes_reserve(layout, layout->count + 1);
+
+    u32 index = layout->count;
+    layout->count++;
+
+    layout->boxes[index] = box;
+    layout->nodes[index] = (oc_ui_layout_node){
+        .flags = box->flags,
+        .layoutAxis = box->style.layout.axis,
+        .layoutSpacing = box->style.layout.spacing,
+        .margin = { box->style.layout.margin.x, box->style.layout.margin.y },
+        .size = { box->style.size.c[OC_UI_AXIS_X], box->style.size.c[OC_UI_AXIS_Y] },
+        .floating = { box->style.floating.c[OC_UI_AXIS_X], box->style.floating.c[OC_UI_AXIS_Y] },
+        .rect = box->rect,
+        .minSize = { box->minSize[0], box->minSize[1] },
+        .spacing = { box->spacing[0], box->spacing[1] },
+        .childrenSum = { box->childrenSum[0], box->childrenSum[1] },
+    };
+    box->layoutIndex = index;
+    return (index);
+}
+
+//NOTE: iterates over the nodes of the visible children of a node. The root is never a child, so 0 ends the list.
+#define oc_ui_layout_node_for_children(nodes, node, child)                                  \
+    for(oc_ui_layout_node* child = (node)->firstChild ? &(nodes)[(node)->firstChild] : 0; \
+        child != 0;                                                                         \
+        child = child->nextSibling ? &(nodes)[child->nextSibling] : 0)
+
+bool oc_ui_layout_downward_dependency(oc_ui_layout_node* child, int axis)
+{
+    return (!child->floating[axis]
+            && child->size[axis].kind != OC_UI_SIZE_PARENT
+            && child->size[axis].kind != OC_UI_SIZE_PARENT_MINUS_PIXELS);
 }
 
-void oc_ui_layout_downward_dependent_size(oc_ui_context* ui, oc_ui_box* box, int axis)
+void oc_ui_layout_downward_dependent_size(oc_ui_context* ui, u32 index, int axis)
 {
+    oc_ui_layout_node* nodes = ui->layoutNodes.nodes;
+    oc_ui_layout_node* node = &nodes[index];
+    oc_ui_layout_cache* cache = &ui->layoutNodes.boxes[index]->layoutCache;
+    if(cache->clean)
+    {
+        //NOTE: the subtree didn't change, so its downward sizes are the same as last frame. Children are left in their
+        //      final state of last frame, and only get their downward sizes back if we need to redo the upward pass.
+        node->rect.c[2 + axis] = cache->downSize[axis];
+        node->minSize[axis] = cache->downMinSize[axis];
+        return;
+    }
+
     //NOTE: layout children and compute spacing and minimum size
     i32 count = 0;
     f32 minSum = 0;
 
-    oc_list_for(box->children, child, oc_ui_box, listElt)
+    oc_ui_layout_node_for_children(nodes, node, child)
     {
-        if(!oc_ui_box_hidden(child))
-        {
-            oc_ui_layout_downward_dependent_size(ui, child, axis);
+        oc_ui_layout_downward_dependent_size(ui, child - nodes, axis);
 
-            if(!child->style.floating.c[axis])
+        if(!child->floating[axis])
+        {
+            if(node->layoutAxis == axis)
             {
-                if(box->style.layout.axis == axis)
-                {
-                    count++;
-                    minSum += child->minSize[axis];
-                }
-                else
-                {
-                    minSum = oc_max(minSum, child->minSize[axis]);
-                }
+                count++;
+                minSum += child->minSize[axis];
+            }
+            else
+            {
+                minSum = oc_max(minSum, child->minSize[axis]);
             }
         }
     }
-    box->spacing[axis] = oc_max(0, count - 1) * box->style.layout.spacing;
+    node->spacing[axis] = oc_max(0, count - 1) * node->layoutSpacing;
 
-    switch(box->style.size.c[axis].kind)
+    switch(node->size[axis].kind)
     {
         case OC_UI_SIZE_TEXT:
         case OC_UI_SIZE_PIXELS:
-            box->minSize[axis] = box->rect.c[2 + axis];
+            node->rect.c[2 + axis] = cache->staticSize[axis];
+            node->minSize[axis] = cache->staticSize[axis];
             break;
 
         case OC_UI_SIZE_CHILDREN:
@@ -1057,25 +1483,25 @@ void oc_ui_layout_downward_dependent_size(oc_ui_context* ui, oc_ui_box* box, int
         {
             int overflowFlag = (OC_UI_FLAG_OVERFLOW_ALLOW_X << axis);
 
-            if(!(box->flags & overflowFlag))
+            if(!(node->flags & overflowFlag))
             {
-                box->minSize[axis] = minSum + box->spacing[axis] + 2 * box->style.layout.margin.c[axis];
+                node->minSize[axis] = minSum + node->spacing[axis] + 2 * node->margin.c[axis];
             }
         }
         break;
     }
-    box->minSize[axis] = oc_max(box->minSize[axis], box->style.size.c[axis].minSize);
+    node->minSize[axis] = oc_max(node->minSize[axis], node->size[axis].minSize);
 
-    oc_ui_size* size = &box->style.size.c[axis];
+    oc_ui_size* size = &node->size[axis];
     if(size->kind == OC_UI_SIZE_CHILDREN)
     {
         //NOTE: if box is dependent on children, compute children's size. If we're in the layout
         //      axis this is the sum of each child size, otherwise it is the maximum child size
         f32 sum = 0;
 
-        if(box->style.layout.axis == axis)
+        if(node->layoutAxis == axis)
         {
-            oc_list_for(box->children, child, oc_ui_box, listElt)
+            oc_ui_layout_node_for_children(nodes, node, child)
             {
                 if(oc_ui_layout_downward_dependency(child, axis))
                 {
@@ -1085,7 +1511,7 @@ void oc_ui_layout_downward_dependent_size(oc_ui_context* ui, oc_ui_box* box, int
         }
         else
         {
-            oc_list_for(box->children, child, oc_ui_box, listElt)
+            oc_ui_layout_node_for_children(nodes, node, child)
             {
                 if(oc_ui_layout_downward_dependency(child, axis))
                 {
@@ -1093,21 +1519,53 @@ void oc_ui_layout_downward_dependent_size(oc_ui_context* ui, oc_ui_box* box, int
                 }
             }
         }
-        f32 margin = box->style.layout.margin.c[axis];
-        box->rect.c[2 + axis] = sum + box->spacing[axis] + 2 * margin;
+        f32 margin = node->margin.c[axis];
+        node->rect.c[2 + axis] = sum + node->spacing[axis] + 2 * margin;
     }
+
+    cache->downSize[axis] = node->rect.c[2 + axis];
+    cache->downMinSize[axis] = node->minSize[axis];
 }
 
-void oc_ui_layout_upward_dependent_size(oc_ui_context* ui, oc_ui_box* box, int axis)
+void oc_ui_layout_upward_dependent_size(oc_ui_context* ui, u32 index, int axis)
 {
+    oc_ui_layout_node* nodes = ui->layoutNodes.nodes;
+    oc_ui_box** boxes = ui->layoutNodes.boxes;
+    oc_ui_layout_node* node = &nodes[index];
+    oc_ui_layout_cache* cache = &boxes[index]->layoutCache;
+    if(cache->clean
+       && cache->upSize[axis] == node->rect.c[2 + axis]
+       && cache->upMinSize[axis] == node->minSize[axis])
+    {
+        //NOTE: same subtree and same constraints from the parent, the children already hold the right sizes
+        node->rect.c[2 + axis] = cache->finalSize[axis];
+        node->minSize[axis] = cache->finalMinSize[axis];
+        cache->upwardReused[axis] = true;
+        return;
+    }
+    cache->upwardReused[axis] = false;
+    cache->upSize[axis] = node->rect.c[2 + axis];
+    cache->upMinSize[axis] = node->minSize[axis];
+
+    if(cache->clean)
+    {
+        //NOTE: the downward pass was skipped for the children, restore its results before solving them again
+        oc_ui_layout_node_for_children(nodes, node, child)
+        {
+            oc_ui_layout_cache* childCache = &boxes[child - nodes]->layoutCache;
+            child->rect.c[2 + axis] = childCache->downSize[axis];
+            child->minSize[axis] = childCache->downMinSize[axis];
+        }
+    }
+
     //NOTE: re-compute/set size of children that depend on box's size
 
-    f32 margin = box->style.layout.margin.c[axis];
-    f32 availableSize = oc_max(0, box->rect.c[2 + axis] - box->spacing[axis] - 2 * margin);
+    f32 margin = node->margin.c[axis];
+    f32 availableSize = oc_max(0, node->rect.c[2 + axis] - node->spacing[axis] - 2 * margin);
 
-    oc_list_for(box->children, child, oc_ui_box, listElt)
+    oc_ui_layout_node_for_children(nodes, node, child)
     {
-        oc_ui_size* size = &child->style.size.c[axis];
+        oc_ui_size* size = &child->size[axis];
         if(size->kind == OC_UI_SIZE_PARENT)
         {
             child->rect.c[2 + axis] = oc_max(child->minSize[axis], availableSize * size->value);
@@ -1121,21 +1579,20 @@ void oc_ui_layout_upward_dependent_size(oc_ui_context* ui, oc_ui_box* box, int a
     //NOTE: solve downward conflicts
     int overflowFlag = (OC_UI_FLAG_OVERFLOW_ALLOW_X << axis);
 
-    if(!(box->flags & overflowFlag))
+    if(!(node->flags & overflowFlag))
     {
-        if(box->style.layout.axis == axis)
+        if(node->layoutAxis == axis)
         {
             f32 prevSum = FLT_MAX;
             int count = 0;
 
             //NOTE: take into account the _original size_ minus the _original slack_ in minimum size. This way the widget
             //      never gives up more than wantedSize * relax.
-            oc_list_for(box->children, child, oc_ui_box, listElt)
+            oc_ui_layout_node_for_children(nodes, node, child)
             {
-                if(!oc_ui_box_hidden(child)
-                   && !child->style.floating.c[axis])
+                if(!child->floating[axis])
                 {
-                    child->minSize[axis] = oc_max(child->minSize[axis], child->rect.c[2 + axis] * (1 - child->style.size.c[axis].relax));
+                    child->minSize[axis] = oc_max(child->minSize[axis], child->rect.c[2 + axis] * (1 - child->size[axis].relax));
                 }
             }
 
@@ -1147,13 +1604,12 @@ void oc_ui_layout_upward_dependent_size(oc_ui_context* ui, oc_ui_box* box, int a
                 f32 sum = 0;
                 f32 slack = 0;
 
-                oc_list_for(box->children, child, oc_ui_box, listElt)
+                oc_ui_layout_node_for_children(nodes, node, child)
                 {
-                    if(!oc_ui_box_hidden(child)
-                       && !child->style.floating.c[axis])
+                    if(!child->floating[axis])
                     {
                         sum += child->rect.c[2 + axis];
-                        slack += oc_min(child->rect.c[2 + axis] * child->style.size.c[axis].relax,
+                        slack += oc_min(child->rect.c[2 + axis] * child->size[axis].relax,
                                         child->rect.c[2 + axis] - child->minSize[axis]);
                     }
                 }
@@ -1165,15 +1621,15 @@ void oc_ui_layout_upward_dependent_size(oc_ui_context* ui, oc_ui_box* box, int a
                 prevSum = sum;
 
                 //NOTE: then remove excess proportionally to each box slack
-                f32 totalContents = sum + box->spacing[axis] + 2 * box->style.layout.margin.c[axis];
-                f32 excess = oc_clamp_low(totalContents - box->rect.c[2 + axis], 0);
+                f32 totalContents = sum + node->spacing[axis] + 2 * node->margin.c[axis];
+                f32 excess = oc_clamp_low(totalContents - node->rect.c[2 + axis], 0);
                 f32 alpha = oc_clamp(excess / slack, 0, 1);
 
-                oc_list_for(box->children, child, oc_ui_box, listElt)
+                oc_ui_layout_node_for_children(nodes, node, child)
                 {
-                    if(!oc_ui_box_hidden(child) && !child->style.floating.c[axis])
+                    if(!child->floating[axis])
                     {
-                        f32 relax = child->style.size.c[axis].relax;
+                        f32 relax = child->size[axis].relax;
                         f32 minSize = child->minSize[axis];
                         f32 remove = alpha * oc_clamp(child->rect.c[2 + axis] * relax, 0, child->rect.c[2 + axis] - child->minSize[axis]);
 
@@ -1186,13 +1642,13 @@ void oc_ui_layout_upward_dependent_size(oc_ui_context* ui, oc_ui_box* box, int a
         {
             //NOTE: if we're solving on the secondary axis, we remove excess to each box individually
             //      according to its own slack.
-            oc_list_for(box->children, child, oc_ui_box, listElt)
+            oc_ui_layout_node_for_children(nodes, node, child)
             {
-                if(!oc_ui_box_hidden(child) && !child->style.floating.c[axis])
+                if(!child->floating[axis])
                 {
-                    f32 totalContents = child->rect.c[2 + axis] + 2 * box->style.layout.margin.c[axis];
-                    f32 excess = oc_clamp_low(totalContents - box->rect.c[2 + axis], 0);
-                    f32 relax = child->style.size.c[axis].relax;
+                    f32 totalContents = child->rect.c[2 + axis] + 2 * node->margin.c[axis];
+                    f32 excess = oc_clamp_low(totalContents - node->rect.c[2 + axis], 0);
+                    f32 relax = child->size[axis].relax;
                     f32 minSize = child->minSize[axis];
                     f32 remove = oc_min(excess, child->rect.c[2 + axis] * relax);
 
@@ -1201,19 +1657,18 @@ void oc_ui_layout_upward_dependent_size(oc_ui_context* ui, oc_ui_box* box, int a
             }
         }
     }
-    box->rect.c[2 + axis] = oc_max(box->minSize[axis], box->rect.c[2 + axis]);
+    node->rect.c[2 + axis] = oc_max(node->minSize[axis], node->rect.c[2 + axis]);
 
     f32 sum = 0;
 
     //NOTE: recurse in children and recompute children sum
-    oc_list_for(box->children, child, oc_ui_box, listElt)
+    oc_ui_layout_node_for_children(nodes, node, child)
     {
-        oc_ui_layout_upward_dependent_size(ui, child, axis);
+        oc_ui_layout_upward_dependent_size(ui, child - nodes, axis);
 
-        if(!oc_ui_box_hidden(child)
-           && !child->style.floating.c[axis])
+        if(!child->floating[axis])
         {
-            if(box->style.layout.axis == axis)
+            if(node->layoutAxis == axis)
             {
                 sum += child->rect.c[2 + axis];
             }
@@ -1223,15 +1678,18 @@ void oc_ui_layout_upward_dependent_size(oc_ui_context* ui, oc_ui_box* box, int a
             }
         }
     }
-    box->childrenSum[axis] = sum;
+    node->childrenSum[axis] = sum;
+
+    cache->finalSize[axis] = node->rect.c[2 + axis];
+    cache->finalMinSize[axis] = node->minSize[axis];
 
-    OC_ASSERT(box->rect.c[2 + axis] >= box->minSize[axis], "parent->string = %.*s, box->string = %.*s, axis = %i, box->size[axis].kind = %i, box->rect.c[2+axis] = %f, box->minSize[axis] = %f",
-              oc_str8_ip(box->parent->string),
-              oc_str8_ip(box->string),
+    OC_ASSERT(node->rect.c[2 + axis] >= node->minSize[axis], "parent->string = %.*s, box->string = %.*s, axis = %i, box->size[axis].kind = %i, box->rect.c[2+axis] = %f, box->minSize[axis] = %f",
+              oc_str8_ip(boxes[index]->parent->string),
+              oc_str8_ip(boxes[index]->string),
               axis,
-              box->style.size.c[axis].kind,
-              box->rect.c[2 + axis],
-              box->minSize[axis]);
+              node->size[axis].kind,
+              node->rect.c[2 + axis],
+              node->minSize[axis]);
     /*
     if(!(box->flags & overflowFlag) && !oc_list_empty(box->children))
     {
@@ -1318,30 +1776,54 @@ void oc_ui_layout_upward_dependent_fixup(oc_ui_context* ui, oc_ui_box* box, int
     }
 }
 
-void oc_ui_layout_compute_rect(oc_ui_context* ui, oc_ui_box* box, oc_vec2 pos)
+void oc_ui_layout_compute_rect(oc_ui_context* ui, u32 index, oc_vec2 pos)
 {
-    if(oc_ui_box_hidden(box))
-    {
+    oc_ui_layout_node* nodes = ui->layoutNodes.nodes;
+    oc_ui_box** boxes = ui->layoutNodes.boxes;
+    oc_ui_layout_node* node = &nodes[index];
+    oc_ui_box* box = boxes[index];
+
+    oc_ui_layout_cache* cache = &box->layoutCache;
+    if(cache->clean
+       && cache->upwardReused[OC_UI_AXIS_X]
+       && cache->upwardReused[OC_UI_AXIS_Y]
+       && cache->pos.x == pos.x
+       && cache->pos.y == pos.y
+       && cache->z == ui->z)
+    {
+        //NOTE: the subtree is sized and placed as last frame, its rects are still valid
+        ui->z = cache->zEnd;
         return;
     }
+    cache->pos = pos;
+    cache->z = ui->z;
+    cache->rectGeneration++;
 
-    box->rect.x = pos.x;
-    box->rect.y = pos.y;
+    node->rect.x = pos.x;
+    node->rect.y = pos.y;
     box->z = ui->z;
     ui->z++;
 
-    oc_ui_axis layoutAxis = box->style.layout.axis;
+    //NOTE: copy the results of the layout passes back to the box
+    box->rect = node->rect;
+    for(int i = 0; i < OC_UI_AXIS_COUNT; i++)
+    {
+        box->minSize[i] = node->minSize[i];
+        box->spacing[i] = node->spacing[i];
+        box->childrenSum[i] = node->childrenSum[i];
+    }
+
+    oc_ui_axis layoutAxis = node->layoutAxis;
     oc_ui_axis secondAxis = (layoutAxis == OC_UI_AXIS_X) ? OC_UI_AXIS_Y : OC_UI_AXIS_X;
-    f32 spacing = box->style.layout.spacing;
+    f32 spacing = node->layoutSpacing;
 
     oc_ui_align* align = box->style.layout.align.c;
 
-    oc_vec2 origin = { box->rect.x,
-                       box->rect.y };
+    oc_vec2 origin = { node->rect.x,
+                       node->rect.y };
     oc_vec2 currentPos = origin;
 
-    oc_vec2 margin = { box->style.layout.margin.x,
-                       box->style.layout.margin.y };
+    oc_vec2 margin = node->margin;
 
     currentPos.x += margin.x;
     currentPos.y += margin.y;
@@ -1350,47 +1832,48 @@ void oc_ui_layout_compute_rect(oc_ui_context* ui, oc_ui_box* box, oc_vec2 pos)
     {
         if(align[i] == OC_UI_ALIGN_END)
         {
-            currentPos.c[i] = origin.c[i] + box->rect.c[2 + i] - (box->childrenSum[i] + box->spacing[i] + margin.c[i]);
+            currentPos.c[i] = origin.c[i] + node->rect.c[2 + i] - (node->childrenSum[i] + node->spacing[i] + margin.c[i]);
         }
     }
     if(align[layoutAxis] == OC_UI_ALIGN_CENTER)
     {
         currentPos.c[layoutAxis] = origin.c[layoutAxis]
-                                 + 0.5 * (box->rect.c[2 + layoutAxis] - (box->childrenSum[layoutAxis] + box->spacing[layoutAxis]));
+                                 + 0.5 * (node->rect.c[2 + layoutAxis] - (node->childrenSum[layoutAxis] + node->spacing[layoutAxis]));
     }
 
     currentPos.x -= box->scroll.x;
     currentPos.y -= box->scroll.y;
 
-    oc_list_for(box->children, child, oc_ui_box, listElt)
+    oc_ui_layout_node_for_children(nodes, node, child)
     {
         if(align[secondAxis] == OC_UI_ALIGN_CENTER)
         {
-            currentPos.c[secondAxis] = origin.c[secondAxis] + 0.5 * (box->rect.c[2 + secondAxis] - child->rect.c[2 + secondAxis]);
+            currentPos.c[secondAxis] = origin.c[secondAxis] + 0.5 * (node->rect.c[2 + secondAxis] - child->rect.c[2 + secondAxis]);
         }
 
         oc_vec2 childPos = currentPos;
         for(int i = 0; i < OC_UI_AXIS_COUNT; i++)
         {
-            if(child->style.floating.c[i])
+            if(child->floating[i])
             {
-                oc_ui_style* style = child->targetStyle;
-                if((child->targetStyle->animationMask & (OC_UI_STYLE_FLOAT_X << i))
-                   && !child->fresh)
+                oc_ui_box* childBox = boxes[child - nodes];
+                oc_ui_style* style = &childBox->targetStyle;
+                if((childBox->targetStyle.animationMask & (OC_UI_STYLE_FLOAT_X << i))
+                   && !childBox->fresh)
                 {
-                    oc_ui_animate_f32(ui, &child->floatPos.c[i], child->style.floatTarget.c[i], style->animationTime);
+                    oc_ui_animate_f32(ui, &childBox->floatPos.c[i], childBox->style.floatTarget.c[i], style->animationTime);
                 }
                 else
                 {
-                    child->floatPos.c[i] = child->style.floatTarget.c[i];
+                    childBox->floatPos.c[i] = childBox->style.floatTarget.c[i];
                 }
-                childPos.c[i] = origin.c[i] + child->floatPos.c[i];
+                childPos.c[i] = origin.c[i] + childBox->floatPos.c[i];
             }
         }
 
-        oc_ui_layout_compute_rect(ui, child, childPos);
+        oc_ui_layout_compute_rect(ui, child - nodes, childPos);
 
-        if(!child->style.floating.c[layoutAxis])
+        if(!child->floating[layoutAxis])
         {
             currentPos.c[layoutAxis] += child->rect.c[2 + layoutAxis] + spacing;
         }
@@ -1400,11 +1883,136 @@ void oc_ui_layout_compute_rect(oc_ui_context* ui, oc_ui_box* box, oc_vec2 pos)
         oc_log_error("error in box %.*s\n", oc_str8_ip(box->string));
         OC_ASSERT(0);
     }
+    cache->zEnd = ui->z;
+
+    //NOTE: compute the bounds of the subtree, for culling. Children of clipping boxes are within the box's rect.
+    f32 halfBorder = 0.5 * box->style.borderSize;
+    oc_rect bounds = {
+        box->rect.x - halfBorder,
+        box->rect.y - halfBorder,
+        box->rect.w + 2 * halfBorder,
+        box->rect.h + 2 * halfBorder,
+    };
+    if(!(box->flags & OC_UI_FLAG_CLIP))
+    {
+        oc_ui_layout_node_for_children(nodes, node, child)
+        {
+            oc_rect childBounds = boxes[child - nodes]->layoutCache.bounds;
+            f32 x0 = oc_min(bounds.x, childBounds.x);
+            f32 y0 = oc_min(bounds.y, childBounds.y);
+            f32 x1 = oc_max(bounds.x + bounds.w, childBounds.x + childBounds.w);
+            f32 y1 = oc_max(bounds.y + bounds.h, childBounds.y + childBounds.h);
+            bounds = (oc_rect){ x0, y0, x1 - x0, y1 - y0 };
+        }
+    }
+    cache->bounds = bounds;
 }
+//NOTE: layout inputs of a box. This is hashed as raw bytes, so it must be zeroed before being filled.
+typedef struct oc_ui_layout_key
+{
+    oc_ui_box_size size;
+    oc_ui_layout layout;
+    oc_vec2 floatTarget;
+    oc_vec2 floatPos;
+    oc_vec2 scroll;
+    oc_font font;
+    f32 fontSize;
+    f32 borderSize;
+    u64 stringHash;
+    u64 childrenHash;
+    u32 flags;
+    bool floating[2];
+    bool hidden;
+} oc_ui_layout_key;
+
+//NOTE: inputs of the draw commands of a box that aren't already part of its layout key
+typedef struct oc_ui_draw_key
+{
+    u64 layoutHash;
+    u64 childrenHash;
+    oc_color color;
+    oc_color bgColor;
+    oc_color borderColor;
+    f32 roundness;
+} oc_ui_draw_key;
+
+u64 oc_ui_layout_update_hash(oc_ui_context* ui, oc_ui_box* box)
+{
+    oc_ui_layout_key key;
+    memset(&key, 0, sizeof(key));
+
+    oc_ui_draw_key drawKey;
+    memset(&drawKey, 0, sizeof(drawKey));
+
+    key.hidden = oc_ui_box_hidden(box);
+    key.flags = box->flags;
+
+    //NOTE: styles of hidden boxes aren't computed, and their subtree isn't laid out
+    if(!key.hidden)
+    {
+        //NOTE: nodes are pushed in depth-first order, so that the layout passes walk the node array mostly forward
+        u32 index = oc_ui_layout_node_push(ui, box);
+        u32 prevChild = 0;
+
+        key.size = box->style.size;
+        key.layout = box->style.layout;
+        key.floatTarget = box->style.floatTarget;
+        key.floatPos = box->floatPos;
+        key.scroll = box->scroll;
+        key.font = box->style.font;
+        key.fontSize = box->style.fontSize;
+        key.borderSize = box->style.borderSize;
+        key.floating[0] = box->style.floating.c[0];
+        key.floating[1] = box->style.floating.c[1];
+        key.stringHash = oc_hash_xx64_string(box->string);
+
+        key.childrenHash = box->key.hash;
+        oc_list_for(box->children, child, oc_ui_box, listElt)
+        {
+            u64 childHash = oc_ui_layout_update_hash(ui, child);
+            key.childrenHash = oc_hash_xx64_string_seed((oc_str8){ .ptr = (char*)&childHash, .len = sizeof(u64) }, key.childrenHash);
+
+            if(!oc_ui_box_hidden(child))
+            {
+                //NOTE: the node array may have been reallocated by the children, so we link nodes by index
+                if(prevChild)
+                {
+                    ui->layoutNodes.nodes[prevChild].nextSibling = child->layoutIndex;
+                }
+                else
+                {
+                    ui->layoutNodes.nodes[index].firstChild = child->layoutIndex;
+                }
+                prevChild = child->layoutIndex;
+            }
+
+            u64 childDrawHash = child->layoutCache.drawHash;
+            drawKey.childrenHash = oc_hash_xx64_string_seed((oc_str8){ .ptr = (char*)&childDrawHash, .len = sizeof(u64) }, drawKey.childrenHash);
+        }
+        drawKey.color = box->style.color;
+        drawKey.bgColor = box->style.bgColor;
+        drawKey.borderColor = box->style.borderColor;
+        drawKey.roundness = box->style.roundness;
+    }
+
+    u64 hash = oc_hash_xx64_string_seed((oc_str8){ .ptr = (char*)&key, .len = sizeof(key) }, box->key.hash);
+
+    drawKey.layoutHash = hash;
+    box->layoutCache.drawHash = oc_hash_xx64_string_seed((oc_str8){ .ptr = (char*)&drawKey, .len = sizeof(drawKey) }, 0);
 
+    //NOTE: fresh boxes have no cached layout
+    box->layoutCache.clean = !box->fresh && (hash == box->layoutCache.hash);
+    box->layoutCache.hash = hash;
+    return (hash);
+}
+
+//NOTE: the subtree bounds computed by oc_ui_layout_compute_rect() contain the rects of every box of the subtree, so
+//      they form a bounding volume hierarchy over the box tree, and we skip the subtrees whose bounds don't contain p.
+//      Bounds of subtrees whose layout is reused are kept from the previous frame, so the hierarchy is only rebuilt
+//      where the layout changed. Boxes are visited in z order, so the last box hit is the topmost one.
 void oc_ui_layout_find_next_hovered_recursive(oc_ui_context* ui, oc_ui_box* box, oc_vec2 p)
 {
-    if(oc_ui_box_hidden(box))
+    if(oc_ui_box_hidden(box) || !oc_ui_rect_hit(box->layoutCache.bounds, p))
     {
         return;
     }
@@ -1431,11 +2039,18 @@ void oc_ui_layout_find_next_hovered(oc_ui_context* ui, oc_vec2 p)
 
 void oc_ui_solve_layout(oc_ui_context* ui)
 {
-    oc_list beforeRules = { 0 };
-    oc_list afterRules = { 0 };
+    f64 startTime = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+    oc_ui_rule_index* beforeRules = oc_arena_push_type(&ui->frameArena, oc_ui_rule_index);
+    oc_ui_rule_index* afterRules = oc_arena_push_type(&ui->frameArena, oc_ui_rule_index);
+    memset(beforeRules, 0, sizeof(oc_ui_rule_index));
+    memset(afterRules, 0, sizeof(oc_ui_rule_index));
 
     //NOTE: style and compute static sizes
-    oc_ui_styling_prepass(ui, ui->root, &beforeRules, &afterRules);
+    oc_ui_styling_prepass(ui, ui->root, beforeRules, afterRules);
+
+    f64 stylingEndTime = oc_clock_time(OC_CLOCK_MONOTONIC);
+    ui->frameStats.stylingTime = stylingEndTime - startTime;
 
     //NOTE: reparent overlay boxes
     oc_list_for(ui->overlayList, box, oc_ui_box, overlayElt)
@@ -1447,18 +2062,27 @@ void oc_ui_solve_layout(oc_ui_context* ui)
         }
     }
 
-    //NOTE: compute layout
-    for(int axis = 0; axis < OC_UI_AXIS_COUNT; axis++)
+    //NOTE: find subtrees whose layout can be reused from the previous frame, and gather the layout nodes
+    ui->layoutNodes.count = 0;
+    oc_ui_layout_update_hash(ui, ui->root);
+
+    //NOTE: compute layout, starting from the root's node
+    if(ui->layoutNodes.count)
     {
-        oc_ui_layout_downward_dependent_size(ui, ui->root, axis);
-        oc_ui_layout_upward_dependent_size(ui, ui->root, axis);
+        for(int axis = 0; axis < OC_UI_AXIS_COUNT; axis++)
+        {
+            oc_ui_layout_downward_dependent_size(ui, 0, axis);
+            oc_ui_layout_upward_dependent_size(ui, 0, axis);
 
-        //        oc_ui_layout_upward_dependent_fixup(ui, ui->root, axis);
+            //        oc_ui_layout_upward_dependent_fixup(ui, ui->root, axis);
+        }
+        oc_ui_layout_compute_rect(ui, 0, (oc_vec2){ 0, 0 });
     }
-    oc_ui_layout_compute_rect(ui, ui->root, (oc_vec2){ 0, 0 });
 
     oc_vec2 p = oc_ui_mouse_position();
     oc_ui_layout_find_next_hovered(ui, p);
+
+    ui->frameStats.layoutTime = oc_clock_time(OC_CLOCK_MONOTONIC) - stylingEndTime;
 }
 
 //-----------------------------------------------------------------------------
@@ -1489,6 +2113,16 @@ void oc_ui_rectangle_stroke(oc_rect rect, f32 roundness)
     }
 }
 
+static bool oc_ui_rect_outside_clip(oc_rect rect, oc_rect clip)
+{
+    return ((rect.x + rect.w < clip.x)
+            || (rect.y + rect.h < clip.y)
+            || (rect.x > clip.x + clip.w)
+            || (rect.y > clip.y + clip.h));
+}
+
+void oc_ui_draw_box_commands(oc_ui_box* box);
+
 void oc_ui_draw_box(oc_ui_box* box)
 {
     if(oc_ui_box_hidden(box))
@@ -1496,26 +2130,72 @@ void oc_ui_draw_box(oc_ui_box* box)
         return;
     }
 
+    //NOTE: skip the whole subtree if nothing it draws is visible
+    oc_rect clip = oc_clip_top();
+    if(oc_ui_rect_outside_clip(box->layoutCache.bounds, clip))
+    {
+        return;
+    }
+
+    if(!(box->flags & OC_UI_FLAG_CACHE_DRAW))
+    {
+        oc_ui_draw_box_commands(box);
+        return;
+    }
+
+    oc_ui_context* ui = oc_ui_get_context();
+    oc_mat2x3 identity = { 1, 0, 0,
+                           0, 1, 0 };
+
+    if(!oc_display_list_is_nil(box->drawList)
+       && box->drawListHash == box->layoutCache.drawHash
+       && box->drawListRectGeneration == box->layoutCache.rectGeneration
+       && !memcmp(&box->drawListClip, &clip, sizeof(oc_rect)))
+    {
+        oc_display_list_draw(box->drawList, identity);
+        return;
+    }
+
+    if(!oc_display_list_is_nil(box->drawList))
+    {
+        oc_display_list_destroy(box->drawList);
+        box->drawList = oc_display_list_nil();
+    }
+
+    if(ui->drawRecording)
+    {
+        //NOTE: an enclosing box is already recording, its list will hold our commands
+        oc_ui_draw_box_commands(box);
+        return;
+    }
+
+    ui->drawRecording = true;
+    oc_display_list_begin_record();
+    oc_ui_draw_box_commands(box);
+    box->drawList = oc_display_list_end_record();
+    ui->drawRecording = false;
+
+    box->drawListHash = box->layoutCache.drawHash;
+    box->drawListRectGeneration = box->layoutCache.rectGeneration;
+    box->drawListClip = clip;
+
+    oc_display_list_draw(box->drawList, identity);
+}
+
+void oc_ui_draw_box_commands(oc_ui_box* box)
+{
     oc_ui_style* style = &box->style;
 
     bool draw = true;
 
     {
-        oc_rect clip = oc_clip_top();
         oc_rect expRect = {
             box->rect.x - 0.5 * style->borderSize,
             box->rect.y - 0.5 * style->borderSize,
             box->rect.w + style->borderSize,
             box->rect.h + style->borderSize
         };
-
-        if((expRect.x + expRect.w < clip.x)
-           || (expRect.y + expRect.h < clip.y)
-           || (expRect.x > clip.x + clip.w)
-           || (expRect.y > clip.y + clip.h))
-        {
-            draw = false;
-        }
+        draw = !oc_ui_rect_outside_clip(expRect, oc_clip_top());
     }
 
     if(box->flags & OC_UI_FLAG_CLIP)
@@ -1543,7 +2223,7 @@ void oc_ui_draw_box(oc_ui_box* box)
 
     if(draw && (box->flags & OC_UI_FLAG_DRAW_TEXT))
     {
-        oc_rect textBox = oc_font_text_metrics(style->font, style->fontSize, box->string).logical;
+        oc_rect textBox = oc_ui_text_metrics(oc_ui_get_context(), style->font, style->fontSize, box->string).logical;
 
         f32 x = 0;
         f32 y = 0;
@@ -1636,6 +2316,7 @@ void oc_ui_begin_frame(oc_vec2 size, oc_ui_style* defaultStyle, oc_ui_style_mask
 
     ui->clipStack = 0;
     ui->z = 0;
+    ui->animating = false;
 
     defaultMask &= OC_UI_STYLE_COLOR
                  | OC_UI_STYLE_BG_COLOR
@@ -1648,7 +2329,7 @@ void oc_ui_begin_frame(oc_vec2 size, oc_ui_style* defaultStyle, oc_ui_style_mask
                                      .size.height = { OC_UI_SIZE_PIXELS, size.y } },
                      OC_UI_STYLE_SIZE);
 
-    ui->root = oc_ui_box_begin("_root_", 0);
+    ui->root = oc_ui_box_begin_static("_root_", 0);
 
     oc_ui_style_mask contentStyleMask = OC_UI_STYLE_SIZE
                                       | OC_UI_STYLE_LAYOUT
@@ -1661,14 +2342,14 @@ void oc_ui_begin_frame(oc_vec2 size, oc_ui_style* defaultStyle, oc_ui_style_mask
                                      .floatTarget = { 0, 0 } },
                      contentStyleMask);
 
-    oc_ui_box* contents = oc_ui_box_make("_contents_", 0);
+    oc_ui_box* contents = oc_ui_box_make_static("_contents_", 0);
 
     oc_ui_style_next(&(oc_ui_style){ .layout = { OC_UI_AXIS_Y, OC_UI_ALIGN_START, OC_UI_ALIGN_START },
                                      .floating = { true, true },
                                      .floatTarget = { 0, 0 } },
                      OC_UI_STYLE_LAYOUT | OC_UI_STYLE_FLOAT_X | OC_UI_STYLE_FLOAT_Y);
 
-    ui->overlay = oc_ui_box_make("_overlay_", 0);
+    ui->overlay = oc_ui_box_make_static("_overlay_", 0);
     ui->overlayList = (oc_list){ 0 };
 
     ui->nextBoxBeforeRules = (oc_list){ 0 };
@@ -1692,22 +2373,61 @@ void oc_ui_end_frame(void)
     //NOTE: layout
     oc_ui_solve_layout(ui);
 
-    //NOTE: prune unused boxes
-    for(int i = 0; i < OC_UI_BOX_MAP_BUCKET_COUNT; i++)
+    //NOTE: prune unused boxes. Boxes made this frame are at the front of the cache list, so we only visit stale ones.
+    while(1)
     {
-        oc_list_for_safe(ui->boxMap[i], box, oc_ui_box, bucketElt)
+        oc_ui_box* stale = oc_list_last_entry(ui->boxCache, oc_ui_box, cacheElt);
+        if(!stale || stale->frameCounter >= ui->frameCounter)
         {
-            if(box->frameCounter < ui->frameCounter)
-            {
-                oc_list_remove(&ui->boxMap[i], &box->bucketElt);
-            }
+            break;
+        }
+        oc_list_remove(&ui->boxCache, &stale->cacheElt);
+        oc_ui_box_map_remove(ui, stale->key.hash);
+
+        if(!oc_display_list_is_nil(stale->drawList))
+        {
+            oc_display_list_destroy(stale->drawList);
+        }
+        if(ui->focus == stale)
+        {
+            ui->focus = 0;
         }
+        if(ui->hovered == stale)
+        {
+            ui->hovered = 0;
+        }
+        free(stale->string.ptr);
+        oc_pool_recycle(&ui->boxPool, stale);
+        ui->frameStats.boxRecycles++;
+    }
+
+    //NOTE: prune unused text metrics
+    oc_ui_text_metrics_prune(ui);
+
+#if OC_PLATFORM_ORCA
+    //NOTE: in idle mode the runtime only runs frames on events, so ask for the next one while we're animating
+    if(ui->animating)
+    {
+        oc_request_frame();
     }
+#endif
+
+    oc_arena_stats arenaStats = oc_arena_get_stats(&ui->frameArena);
+    ui->frameStats.frameArenaBytes = arenaStats.used;
+    ui->frameStats.frameArenaChunks = arenaStats.chunkCount;
+    ui->lastFrameStats = ui->frameStats;
+    memset(&ui->frameStats, 0, sizeof(oc_ui_frame_stats));
 
     oc_arena_clear(&ui->frameArena);
     oc_input_next_frame(&ui->input);
 }
 
+oc_ui_frame_stats oc_ui_get_frame_stats(void)
+{
+    oc_ui_context* ui = oc_ui_get_context();
+    return (ui->lastFrameStats);
+}
+
 //-----------------------------------------------------------------------------
 // Init / cleanup
 //-----------------------------------------------------------------------------
@@ -1718,6 +2438,7 @@ void oc_ui_init(oc_ui_context* ui)
     memset(ui, 0, sizeof(oc_ui_context));
     oc_arena_init(&ui->frameArena);
     oc_pool_init(&ui->boxPool, sizeof(oc_ui_box));
+    oc_pool_init(&ui->textMetricsPool, sizeof(oc_ui_text_metrics_entry));
     ui->init = true;
 
     oc_ui_set_context(ui);
@@ -1729,8 +2450,31 @@ void oc_ui_init(oc_ui_context* ui)
 void oc_ui_cleanup(void)
 {
     oc_ui_context* ui = oc_ui_get_context();
+
+    oc_list_for(ui->boxCache, box, oc_ui_box, cacheElt)
+    {
+        if(!oc_display_list_is_nil(box->drawList))
+        {
+            oc_display_list_destroy(box->drawList);
+        }
+        free(box->string.ptr);
+    }
+
+    free(ui->editLayout.codepoints);
+    free(ui->editLayout.offsets);
+    memset(&ui->editLayout, 0, sizeof(oc_ui_edit_layout));
+
+    free(ui->layoutNodes.nodes);
+    free(ui->layoutNodes.boxes);
+    memset(&ui->layoutNodes, 0, sizeof(oc_ui_layout_nodes));
+
     oc_arena_cleanup(&ui->frameArena);
     oc_pool_cleanup(&ui->boxPool);
+    oc_pool_cleanup(&ui->textMetricsPool);
+    free(ui->boxMap);
+    ui->boxMap = 0;
+    ui->boxMapCap = 0;
+    ui->boxMapCount = 0;
     ui->init = false;
 }
 
@@ -2044,7 +2788,7 @@ oc_ui_box* oc_ui_slider_str8(oc_str8 name, f32* value)
         oc_ui_style_mask styleFloatMask = styleMask | OC_UI_STYLE_FLOAT;
 
         oc_ui_style_next(&trackStyle, styleFloatMask);
-        oc_ui_box* track = oc_ui_box_make("track", OC_UI_FLAG_DRAW_BACKGROUND);
+        oc_ui_box* track = oc_ui_box_make_static("track", OC_UI_FLAG_DRAW_BACKGROUND);
         oc_ui_tag_box(track, "track");
 
         if(trackAxis == OC_UI_AXIS_X)
@@ -2058,7 +2802,7 @@ oc_ui_box* oc_ui_slider_str8(oc_str8 name, f32* value)
                                            .bgColor = theme->primary,
                                            .roundness = trackThickness / 2 };
             oc_ui_style_next(&trackFillStyle, styleFloatMask);
-            oc_ui_box* trackFill = oc_ui_box_make("track_fill", OC_UI_FLAG_DRAW_BACKGROUND);
+            oc_ui_box* trackFill = oc_ui_box_make_static("track_fill", OC_UI_FLAG_DRAW_BACKGROUND);
             oc_ui_tag_box(trackFill, "track_fill");
         }
         else
@@ -2072,14 +2816,14 @@ oc_ui_box* oc_ui_slider_str8(oc_str8 name, f32* value)
                                            .bgColor = theme->primary,
                                            .roundness = trackThickness / 2 };
             oc_ui_style_next(&trackFillStyle, styleFloatMask);
-            oc_ui_box* trackFill = oc_ui_box_make("track_fill", OC_UI_FLAG_DRAW_BACKGROUND);
+            oc_ui_box* trackFill = oc_ui_box_make_static("track_fill", OC_UI_FLAG_DRAW_BACKGROUND);
             oc_ui_tag_box(trackFill, "track_fill");
         }
 
         oc_ui_style beforeSpacerStyle = { 0 };
         beforeSpacerStyle.size.c[trackAxis] = (oc_ui_size){ OC_UI_SIZE_PARENT, beforeRatio };
         oc_ui_style_next(&beforeSpacerStyle, OC_UI_STYLE_SIZE);
-        oc_ui_box* beforeSpacer = oc_ui_box_make("before_spacer", 0);
+        oc_ui_box* beforeSpacer = oc_ui_box_make_static("before_spacer", 0);
 
         oc_ui_style thumbStyle = { .size.width = (oc_ui_size){ OC_UI_SIZE_PIXELS, thumbSize },
                                    .size.height = (oc_ui_size){ OC_UI_SIZE_PIXELS, thumbSize },
@@ -2106,13 +2850,13 @@ oc_ui_box* oc_ui_slider_str8(oc_str8 name, f32* value)
         oc_ui_flags thumbFlags = OC_UI_FLAG_CLICKABLE
                                | OC_UI_FLAG_DRAW_BACKGROUND
                                | OC_UI_FLAG_DRAW_BORDER;
-        oc_ui_box* thumb = oc_ui_box_make("thumb", thumbFlags);
+        oc_ui_box* thumb = oc_ui_box_make_static("thumb", thumbFlags);
         oc_ui_tag_box(thumb, "thumb");
 
         oc_ui_style afterSpacerStyle = { 0 };
         afterSpacerStyle.size.c[trackAxis] = (oc_ui_size){ OC_UI_SIZE_PARENT, afterRatio };
         oc_ui_style_next(&afterSpacerStyle, OC_UI_STYLE_SIZE);
-        oc_ui_box* afterSpacer = oc_ui_box_make("after_spacer", 0);
+        oc_ui_box* afterSpacer = oc_ui_box_make_static("after_spacer", 0);
 
         //NOTE: interaction
         oc_ui_sig thumbSig = oc_ui_box_sig(thumb);
@@ -2214,11 +2958,11 @@ oc_ui_box* oc_ui_scrollbar_str8(oc_str8 name, f32 thumbRatio, f32* scrollValue)
                                | OC_UI_FLAG_ACTIVE_ANIMATION;
 
         oc_ui_style_next(&trackStyle, trackStyleMask);
-        oc_ui_box* track = oc_ui_box_begin("track", trackFlags);
+        oc_ui_box* track = oc_ui_box_begin_static("track", trackFlags);
         oc_ui_tag_box(track, "track");
 
         oc_ui_style_next(&beforeSpacerStyle, OC_UI_STYLE_SIZE);
-        oc_ui_box* beforeSpacer = oc_ui_box_make("before_spacer", 0);
+        oc_ui_box* beforeSpacer = oc_ui_box_make_static("before_spacer", 0);
 
         oc_ui_style thumbHoverActiveStyle = { .bgColor = theme->fill1 };
         oc_ui_pattern thumbHoverPattern = { 0 };
@@ -2246,11 +2990,11 @@ oc_ui_box* oc_ui_scrollbar_str8(oc_str8 name, f32 thumbRatio, f32* scrollValue)
                                | OC_UI_FLAG_ACTIVE_ANIMATION;
 
         oc_ui_style_next(&thumbStyle, thumbStyleMask);
-        oc_ui_box* thumb = oc_ui_box_make("thumb", thumbFlags);
+        oc_ui_box* thumb = oc_ui_box_make_static("thumb", thumbFlags);
         oc_ui_tag_box(thumb, "thumb");
 
         oc_ui_style_next(&afterSpacerStyle, OC_UI_STYLE_SIZE);
-        oc_ui_box* afterSpacer = oc_ui_box_make("after_spacer", 0);
+        oc_ui_box* afterSpacer = oc_ui_box_make_static("after_spacer", 0);
 
         oc_ui_box_end();
 
@@ -2331,7 +3075,7 @@ void oc_ui_panel_begin_str8(oc_str8 str, oc_ui_flags flags)
                                      .size.height = { OC_UI_SIZE_PARENT, 1 } },
                      OC_UI_STYLE_SIZE);
 
-    oc_ui_box_begin("contents", 0);
+    oc_ui_box_begin_static("contents", 0);
 }
 
 void oc_ui_panel_begin(const char* str, oc_ui_flags flags)
@@ -2405,6 +3149,96 @@ void oc_ui_panel_end(void)
     oc_ui_box_end(); // panel
 }
 
+//------------------------------------------------------------------------------
+// virtualized list
+//------------------------------------------------------------------------------
+
+oc_ui_list_info oc_ui_list_str8(oc_str8 name, oc_ui_list_info* info)
+{
+    oc_ui_list_info result = *info;
+    oc_ui_context* ui = oc_ui_get_context();
+
+    //NOTE: the view is computed from the panel's scroll and size in the previous frame
+    oc_ui_box* panel = oc_ui_box_lookup_str8(name);
+    f32 scrollY = panel ? panel->scroll.y : 0;
+    f32 viewHeight = panel ? panel->rect.h : 0;
+
+    f32 rowHeight = (info->rowHeight > 0) ? info->rowHeight : info->estimatedRowHeight;
+    u64 firstRow = 0;
+    u64 endRow = oc_min(info->rowCount, 1);
+    if(rowHeight > 0)
+    {
+        firstRow = (u64)oc_clamp((i64)(scrollY / rowHeight) - 1, 0, (i64)info->rowCount);
+        endRow = (u64)oc_clamp((i64)firstRow + (i64)(viewHeight / rowHeight) + 3, 0, (i64)info->rowCount);
+    }
+
+    oc_ui_panel_begin_str8(name, 0);
+    {
+        result.panel = oc_ui_box_top()->parent;
+
+        oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                         .size.height = { OC_UI_SIZE_CHILDREN },
+                                         .layout.axis = OC_UI_AXIS_Y,
+                                         .layout.spacing = 0,
+                                         .layout.margin.x = 0,
+                                         .layout.margin.y = 0 },
+                         OC_UI_STYLE_SIZE
+                             | OC_UI_STYLE_LAYOUT_AXIS
+                             | OC_UI_STYLE_LAYOUT_SPACING
+                             | OC_UI_STYLE_LAYOUT_MARGINS);
+
+        oc_ui_container_static("rows", 0)
+        {
+            oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                             .size.height = { OC_UI_SIZE_PIXELS, firstRow * rowHeight } },
+                             OC_UI_STYLE_SIZE);
+            oc_ui_box_make_static("spacer before", 0);
+
+            for(u64 row = firstRow; row < endRow; row++)
+            {
+                oc_ui_size height = { OC_UI_SIZE_CHILDREN };
+                if(info->rowHeight > 0)
+                {
+                    height = (oc_ui_size){ OC_UI_SIZE_PIXELS, info->rowHeight };
+                }
+                oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                                 .size.height = height },
+                                 OC_UI_STYLE_SIZE);
+
+                oc_str8 key = oc_str8_pushf(&ui->frameArena, "row %llu", row);
+                oc_ui_box* rowBox = oc_ui_box_begin_str8(key, 0);
+                {
+                    //NOTE: the box keeps its layout from the previous frame
+                    if(info->rowHeight <= 0 && rowBox->rect.h > 0)
+                    {
+                        result.estimatedRowHeight = rowBox->rect.h;
+                    }
+                    if(info->rowProc)
+                    {
+                        info->rowProc(row, info->user);
+                    }
+                }
+                oc_ui_box_end();
+            }
+
+            oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                             .size.height = { OC_UI_SIZE_PIXELS, (info->rowCount - endRow) * rowHeight } },
+                             OC_UI_STYLE_SIZE);
+            oc_ui_box_make_static("spacer after", 0);
+        }
+    }
+    oc_ui_panel_end();
+
+    result.firstRow = firstRow;
+    result.endRow = endRow;
+    return (result);
+}
+
+oc_ui_list_info oc_ui_list(const char* name, oc_ui_list_info* info)
+{
+    return (oc_ui_list_str8(OC_STR8(name), info));
+}
+
 //------------------------------------------------------------------------------
 // tooltips
 //------------------------------------------------------------------------------
@@ -2456,7 +3290,7 @@ void oc_ui_tooltip_str8(oc_str8 label)
                                    | OC_UI_STYLE_BG_COLOR;
         oc_ui_style_next(&arrowStyle, arrowMask);
 
-        oc_ui_box* arrow = oc_ui_box_make("arrow", OC_UI_FLAG_DRAW_PROC);
+        oc_ui_box* arrow = oc_ui_box_make_static("arrow", OC_UI_FLAG_DRAW_PROC);
         oc_ui_box_set_draw_proc(arrow, oc_ui_tooltip_arrow_draw, 0);
 
         oc_ui_style contentsStyle = { .size.width = { OC_UI_SIZE_CHILDREN },
@@ -2477,7 +3311,7 @@ void oc_ui_tooltip_str8(oc_str8 label)
                                       | OC_UI_STYLE_ROUNDNESS;
         oc_ui_style_next(&contentsStyle, contentsMask);
 
-        oc_ui_box* contents = oc_ui_box_begin("contents", OC_UI_FLAG_DRAW_BACKGROUND);
+        oc_ui_box* contents = oc_ui_box_begin_static("contents", OC_UI_FLAG_DRAW_BACKGROUND);
 
         oc_ui_label_str8(label);
 
@@ -2549,7 +3383,7 @@ void oc_ui_menu_begin_str8(oc_str8 label)
     oc_ui_style activeStyle = { .bgColor = theme->fill2 };
     oc_ui_style_match_before(activePattern, &activeStyle, OC_UI_STYLE_BG_COLOR);
 
-    oc_ui_box* button = oc_ui_box_begin("button", OC_UI_FLAG_CLICKABLE | OC_UI_FLAG_DRAW_BACKGROUND);
+    oc_ui_box* button = oc_ui_box_begin_static("button", OC_UI_FLAG_CLICKABLE | OC_UI_FLAG_DRAW_BACKGROUND);
 
     oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_TEXT },
                                      .size.height = { OC_UI_SIZE_TEXT } },
@@ -2588,7 +3422,7 @@ void oc_ui_menu_begin_str8(oc_str8 label)
                       | OC_UI_FLAG_DRAW_BORDER;
 
     oc_ui_style_next(&style, mask);
-    oc_ui_box* menu = oc_ui_box_make("panel", flags);
+    oc_ui_box* menu = oc_ui_box_make_static("panel", flags);
 
     if(oc_ui_box_active(bar))
     {
@@ -2756,7 +3590,7 @@ oc_ui_select_popup_info oc_ui_select_popup_str8(oc_str8 name, oc_ui_select_popup
                                        .borderSize = 1 };
         oc_ui_style_match_after(mouseDownPattern, &mouseDownStyle, OC_UI_STYLE_BG_COLOR | OC_UI_STYLE_BORDER_COLOR | OC_UI_STYLE_BORDER_SIZE);
 
-        oc_ui_box* button = oc_ui_box_make("button",
+        oc_ui_box* button = oc_ui_box_make_static("button",
                                            OC_UI_FLAG_CLICKABLE
                                                | OC_UI_FLAG_DRAW_BACKGROUND
                                                | OC_UI_FLAG_DRAW_BORDER
@@ -2768,7 +3602,7 @@ oc_ui_select_popup_info oc_ui_select_popup_str8(oc_str8 name, oc_ui_select_popup
         oc_rect bbox = { 0 };
         for(int i = 0; i < info->optionCount; i++)
         {
-            bbox = oc_font_text_metrics(button->style.font, button->style.fontSize, info->options[i]).logical;
+            bbox = oc_ui_text_metrics(ui, button->style.font, button->style.fontSize, info->options[i]).logical;
             maxOptionWidth = oc_max(maxOptionWidth, bbox.w);
         }
         f32 buttonWidth = maxOptionWidth + 2 * button->style.layout.margin.x + button->rect.h;
@@ -2789,7 +3623,7 @@ oc_ui_select_popup_info oc_ui_select_popup_str8(oc_str8 name, oc_ui_select_popup
 
         oc_ui_box_push(button);
         {
-            oc_ui_container("selected_option", 0)
+            oc_ui_container_static("selected_option", 0)
             {
                 if(info->selectedIndex == -1)
                 {
@@ -2813,13 +3647,13 @@ oc_ui_select_popup_info oc_ui_select_popup_str8(oc_str8 name, oc_ui_select_popup
                                  | OC_UI_STYLE_FLOAT
                                  | OC_UI_STYLE_COLOR);
 
-            oc_ui_box* arrow = oc_ui_box_make("arrow", OC_UI_FLAG_DRAW_PROC);
+            oc_ui_box* arrow = oc_ui_box_make_static("arrow", OC_UI_FLAG_DRAW_PROC);
             oc_ui_box_set_draw_proc(arrow, oc_ui_select_popup_draw_arrow, 0);
         }
         oc_ui_box_pop();
 
         //panel
-        oc_ui_box* panel = oc_ui_box_make("panel",
+        oc_ui_box* panel = oc_ui_box_make_static("panel",
                                           OC_UI_FLAG_DRAW_BACKGROUND
                                               | OC_UI_FLAG_DRAW_BORDER
                                               | OC_UI_FLAG_BLOCK_MOUSE
@@ -2893,7 +3727,7 @@ oc_ui_select_popup_info oc_ui_select_popup_str8(oc_str8 name, oc_ui_select_popup
                                                      .size.height = { OC_UI_SIZE_PIXELS, checkmarkSize },
                                                      .color = theme->text2 },
                                      OC_UI_STYLE_SIZE | OC_UI_STYLE_COLOR);
-                    oc_ui_box* checkmark = oc_ui_box_make("checkmark", OC_UI_FLAG_DRAW_PROC);
+                    oc_ui_box* checkmark = oc_ui_box_make_static("checkmark", OC_UI_FLAG_DRAW_PROC);
                     oc_ui_box_set_draw_proc(checkmark, oc_ui_select_popup_draw_checkmark, 0);
                 }
                 else
@@ -2901,10 +3735,10 @@ oc_ui_select_popup_info oc_ui_select_popup_str8(oc_str8 name, oc_ui_select_popup
                     oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PIXELS, checkmarkSize },
                                                      .size.height = { OC_UI_SIZE_PIXELS, checkmarkSize } },
                                      OC_UI_STYLE_SIZE);
-                    oc_ui_box* spacer = oc_ui_box_make("spacer", 0);
+                    oc_ui_box* spacer = oc_ui_box_make_static("spacer", 0);
                 }
 
-                oc_ui_container("label", 0)
+                oc_ui_container_static("label", 0)
                 {
                     oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PIXELS, maxOptionWidth },
                                                      .size.height = { OC_UI_SIZE_TEXT } },
@@ -2993,7 +3827,7 @@ oc_ui_radio_group_info oc_ui_radio_group_str8(oc_str8 name, oc_ui_radio_group_in
                                  | OC_UI_STYLE_LAYOUT_ALIGN_Y);
             oc_ui_box* row = oc_ui_box_begin_str8(info->options[i], OC_UI_FLAG_CLICKABLE);
             oc_ui_flags flags = OC_UI_FLAG_DRAW_BACKGROUND | OC_UI_FLAG_DRAW_BORDER | OC_UI_FLAG_DRAW_PROC;
-            oc_ui_box* radio = oc_ui_box_make("radio", flags);
+            oc_ui_box* radio = oc_ui_box_make_static("radio", flags);
             oc_ui_box_set_draw_proc(radio, oc_ui_radio_indicator_draw, 0);
 
             oc_ui_sig sig = oc_ui_box_sig(row);
@@ -3067,7 +3901,7 @@ oc_ui_radio_group_info oc_ui_radio_group_str8(oc_str8 name, oc_ui_radio_group_in
             oc_ui_style selectedActiveStyle = { .bgColor = theme->primaryActive };
             oc_ui_style_box_after(radio, selectedActivePattern, &selectedActiveStyle, OC_UI_STYLE_BG_COLOR);
 
-            oc_ui_container("label", 0)
+            oc_ui_container_static("label", 0)
             {
                 oc_ui_tag_next("label");
                 oc_ui_label_str8(info->options[i]);
@@ -3088,6 +3922,116 @@ oc_ui_radio_group_info oc_ui_radio_group(const char* name, oc_ui_radio_group_inf
 //------------------------------------------------------------------------------
 // text box
 //------------------------------------------------------------------------------
+f32 oc_ui_edit_glyph_advance(oc_font font, f32 fontSize, oc_utf32 codepoint)
+{
+    return (oc_font_text_metrics_utf32(font, fontSize, (oc_str32){ .ptr = &codepoint, .len = 1 }).logical.w);
+}
+
+void oc_ui_edit_layout_reserve(oc_ui_edit_layout* layout, u32 len)
+{
+    if(len + 1 > layout->cap)
+    {
+        u32 cap = oc_max(len + 1, 2 * layout->cap);
+        cap = oc_max(cap, 64);
+        layout->codepoints = realloc(layout->codepoints, cap * sizeof(oc_utf32));
+        layout->offsets = realloc(layout->offsets, cap * sizeof(f32));
+        layout->cap = cap;
+    }
+}
+
+//NOTE: returns the layout of codepoints for the given text box, only measuring glyphs if the text, font or box changed
+oc_ui_edit_layout* oc_ui_edit_layout_sync(oc_ui_context* ui, oc_ui_key key, oc_font font, f32 fontSize, oc_str32 codepoints)
+{
+    oc_ui_edit_layout* layout = &ui->editLayout;
+
+    if(!oc_ui_key_equal(layout->key, key)
+       || layout->font.h != font.h
+       || layout->fontSize != fontSize
+       || layout->len != codepoints.len
+       || (codepoints.len && memcmp(layout->codepoints, codepoints.ptr, codepoints.len * sizeof(oc_utf32))))
+    {
+        oc_ui_edit_layout_reserve(layout, codepoints.len);
+        layout->key = key;
+        layout->font = font;
+        layout->fontSize = fontSize;
+        layout->len = codepoints.len;
+
+        if(codepoints.len)
+        {
+            memcpy(layout->codepoints, codepoints.ptr, codepoints.len * sizeof(oc_utf32));
+        }
+        f32 x = 0;
+        for(u32 i = 0; i < codepoints.len; i++)
+        {
+            layout->offsets[i] = x;
+            x += oc_ui_edit_glyph_advance(font, fontSize, codepoints.ptr[i]);
+        }
+        layout->offsets[codepoints.len] = x;
+    }
+    layout->frameCounter = ui->frameCounter;
+    return (layout);
+}
+
+//NOTE: updates the layout after [start, end) was replaced by input, only measuring the new glyphs
+void oc_ui_edit_layout_replace(oc_ui_context* ui, oc_str32 codepoints, u32 start, u32 end, oc_str32 input)
+{
+    oc_ui_edit_layout* layout = &ui->editLayout;
+    if(layout->frameCounter != ui->frameCounter || layout->len != codepoints.len || end > layout->len)
+    {
+        return;
+    }
+
+    u32 newLen = layout->len - (end - start) + input.len;
+    oc_ui_edit_layout_reserve(layout, newLen);
+
+    f32 oldWidth = layout->offsets[end] - layout->offsets[start];
+    f32 newWidth = 0;
+    for(u32 i = 0; i < input.len; i++)
+    {
+        newWidth += oc_ui_edit_glyph_advance(layout->font, layout->fontSize, input.ptr[i]);
+    }
+
+    memmove(layout->codepoints + start + input.len, layout->codepoints + end, (layout->len - end) * sizeof(oc_utf32));
+    memmove(layout->offsets + start + input.len, layout->offsets + end, (layout->len - end + 1) * sizeof(f32));
+
+    f32 x = layout->offsets[start];
+    for(u32 i = 0; i < input.len; i++)
+    {
+        layout->codepoints[start + i] = input.ptr[i];
+        layout->offsets[start + i] = x;
+        x += oc_ui_edit_glyph_advance(layout->font, layout->fontSize, input.ptr[i]);
+    }
+
+    f32 shift = newWidth - oldWidth;
+    for(u32 i = start + input.len; i <= newLen; i++)
+    {
+        layout->offsets[i] += shift;
+    }
+    layout->len = newLen;
+}
+
+//NOTE: returns the first codepoint at or after first whose middle is right of x, where x is relative to first
+u32 oc_ui_edit_layout_hit(oc_ui_edit_layout* layout, u32 first, f32 x)
+{
+    f32 target = layout->offsets[first] + x;
+    u32 lo = first;
+    u32 hi = layout->len;
+    while(lo < hi)
+    {
+        u32 mid = lo + (hi - lo) / 2;
+        f32 middle = 0.5 * (layout->offsets[mid] + layout->offsets[mid + 1]);
+        if(middle > target)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+    return (lo);
+}
+
 oc_str32 oc_ui_edit_replace_selection_with_codepoints(oc_ui_context* ui, oc_str32 codepoints, oc_str32 input)
 {
     u32 start = oc_min(ui->editCursor, ui->editMark);
@@ -3101,6 +4045,7 @@ oc_str32 oc_ui_edit_replace_selection_with_codepoints(oc_ui_context* ui, oc_str3
     oc_str32_list_push(&ui->frameArena, &list, input);
     oc_str32_list_push(&ui->frameArena, &list, after);
 
+    oc_ui_edit_layout_replace(ui, codepoints, start, end, input);
     codepoints = oc_str32_list_join(&ui->frameArena, list);
 
     ui->editCursor = start + input.len;
@@ -3775,95 +4720,77 @@ i32 oc_ui_edit_find_word_end(oc_ui_context* ui, oc_str32 codepoints, i32 startCh
     return c;
 }
 
+typedef struct oc_ui_text_box_render_data
+{
+    oc_str32 codepoints;
+    f32* offsets; // glyph offsets if the box is being edited, null otherwise
+} oc_ui_text_box_render_data;
+
 void oc_ui_text_box_render(oc_ui_box* box, void* data)
 {
-    oc_str32 codepoints = *(oc_str32*)data;
+    oc_ui_text_box_render_data* renderData = (oc_ui_text_box_render_data*)data;
+    oc_str32 codepoints = renderData->codepoints;
+    f32* offsets = renderData->offsets;
     oc_ui_context* ui = oc_ui_get_context();
 
     u32 firstDisplayedChar = 0;
-    if(oc_ui_box_active(box))
+    if(oc_ui_box_active(box) && offsets)
     {
-        firstDisplayedChar = ui->editFirstDisplayedChar;
+        firstDisplayedChar = oc_min(ui->editFirstDisplayedChar, codepoints.len);
     }
 
     oc_ui_style* style = &box->style;
     oc_font_metrics extents = oc_font_get_metrics(style->font, style->fontSize);
     f32 lineHeight = extents.ascent + extents.descent;
 
-    oc_str32 before = oc_str32_slice(codepoints, 0, firstDisplayedChar);
-    oc_rect beforeBox = oc_font_text_metrics_utf32(style->font, style->fontSize, before).logical;
-
-    f32 textX = box->rect.x - beforeBox.w;
     f32 textTop = box->rect.y + 0.5 * (box->rect.h - lineHeight);
     f32 textY = textTop + extents.ascent;
 
-    if(box->active)
+    //NOTE: only draw the codepoints that are visible in the box
+    u32 endDisplayedChar = firstDisplayedChar;
+    if(offsets)
     {
-        u32 selectStart = oc_min(ui->editCursor, ui->editMark);
-        u32 selectEnd = oc_max(ui->editCursor, ui->editMark);
-
-        oc_str32 beforeSelect = oc_str32_slice(codepoints, 0, selectStart);
-        oc_rect beforeSelectBox = oc_font_text_metrics_utf32(style->font, style->fontSize, beforeSelect).logical;
-        beforeSelectBox.x += textX;
-        beforeSelectBox.y += textY;
-
-        if(selectStart != selectEnd)
+        while(endDisplayedChar < codepoints.len && offsets[endDisplayedChar] - offsets[firstDisplayedChar] < box->rect.w)
         {
-            oc_str32 select = oc_str32_slice(codepoints, selectStart, selectEnd);
-            oc_str32 afterSelect = oc_str32_slice(codepoints, selectEnd, codepoints.len);
-            oc_rect selectBox = oc_font_text_metrics_utf32(style->font, style->fontSize, select).logical;
-            oc_rect afterSelectBox = oc_font_text_metrics_utf32(style->font, style->fontSize, afterSelect).logical;
-
-            selectBox.x += beforeSelectBox.x + beforeSelectBox.w;
-            selectBox.y += textY;
-
-            oc_set_color(ui->theme->palette->blue2);
-            oc_rectangle_fill(selectBox.x, selectBox.y, selectBox.w, lineHeight);
-
-            oc_set_font(style->font);
-            oc_set_font_size(style->fontSize);
-            oc_set_color(style->color);
+            endDisplayedChar++;
+        }
+    }
+    else
+    {
+        f32 x = 0;
+        while(endDisplayedChar < codepoints.len && x < box->rect.w)
+        {
+            x += oc_ui_edit_glyph_advance(style->font, style->fontSize, codepoints.ptr[endDisplayedChar]);
+            endDisplayedChar++;
+        }
+    }
 
-            oc_move_to(textX, textY);
-            oc_codepoints_outlines(beforeSelect);
-            oc_fill();
+    oc_set_font(style->font);
+    oc_set_font_size(style->fontSize);
 
-            oc_set_color(box->style.color);
-            oc_codepoints_outlines(select);
-            oc_fill();
+    if(box->active && offsets)
+    {
+        u32 selectStart = oc_clamp(oc_min(ui->editCursor, ui->editMark), firstDisplayedChar, endDisplayedChar);
+        u32 selectEnd = oc_clamp(oc_max(ui->editCursor, ui->editMark), firstDisplayedChar, endDisplayedChar);
+        f32 textX = box->rect.x - offsets[firstDisplayedChar];
 
-            oc_set_color(style->color);
-            oc_codepoints_outlines(afterSelect);
-            oc_fill();
+        if(ui->editCursor != ui->editMark)
+        {
+            oc_set_color(ui->theme->palette->blue2);
+            oc_rectangle_fill(textX + offsets[selectStart], textTop, offsets[selectEnd] - offsets[selectStart], lineHeight);
         }
-        else
+        else if(!((u64)(2 * (ui->frameTime - ui->editCursorBlinkStart)) & 1))
         {
-            if(!((u64)(2 * (ui->frameTime - ui->editCursorBlinkStart)) & 1))
-            {
-                f32 caretX = box->rect.x - beforeBox.w + beforeSelectBox.w;
-                f32 caretY = textTop;
-                oc_set_color(style->color);
-                oc_rectangle_fill(caretX, caretY, 1, lineHeight);
-            }
-            oc_set_font(style->font);
-            oc_set_font_size(style->fontSize);
+            f32 caretX = textX + offsets[oc_clamp(ui->editCursor, 0, (i32)codepoints.len)];
             oc_set_color(style->color);
-
-            oc_move_to(textX, textY);
-            oc_codepoints_outlines(codepoints);
-            oc_fill();
+            oc_rectangle_fill(caretX, textTop, 1, lineHeight);
         }
     }
-    else
-    {
-        oc_set_font(style->font);
-        oc_set_font_size(style->fontSize);
-        oc_set_color(style->color);
 
-        oc_move_to(textX, textY);
-        oc_codepoints_outlines(codepoints);
-        oc_fill();
-    }
+    oc_set_color(style->color);
+    oc_move_to(box->rect.x, textY);
+    oc_codepoints_outlines(oc_str32_slice(codepoints, firstDisplayedChar, endDisplayedChar));
+    oc_fill();
 }
 
 oc_ui_text_box_result oc_ui_text_box_str8(oc_str8 name, oc_arena* arena, oc_str8 text)
@@ -3912,7 +4839,7 @@ oc_ui_text_box_result oc_ui_text_box_str8(oc_str8 name, oc_arena* arena, oc_str8
                               .size.height = (oc_ui_size){ OC_UI_SIZE_PARENT, 1 } };
     oc_ui_style_next(&textStyle, OC_UI_STYLE_SIZE);
 
-    oc_ui_box* textBox = oc_ui_box_make("text", OC_UI_FLAG_CLIP | OC_UI_FLAG_DRAW_PROC);
+    oc_ui_box* textBox = oc_ui_box_make_static("text", OC_UI_FLAG_CLIP | OC_UI_FLAG_DRAW_PROC);
     result.textBox = textBox;
     oc_ui_tag_box(textBox, "text");
 
@@ -3943,26 +4870,18 @@ oc_ui_text_box_result oc_ui_text_box_str8(oc_str8 name, oc_arena* arena, oc_str8
         f32 cursorX = pos.x - textBox->rect.x;
 
         oc_str32 codepoints = oc_utf8_push_to_codepoints(&ui->frameArena, text);
-        i32 newCursor = 0;
+        oc_ui_edit_layout* layout = oc_ui_edit_layout_sync(ui, frame->key, font, fontSize, codepoints);
+
+        u32 firstDisplayedChar = oc_min(ui->editFirstDisplayedChar, codepoints.len);
+        i32 newCursor = oc_ui_edit_layout_hit(layout, firstDisplayedChar, cursorX);
         i32 hoveredChar = 0;
-        f32 x = 0;
-        for(int i = ui->editFirstDisplayedChar; i < codepoints.len; i++)
+        if(newCursor < (i32)codepoints.len && layout->offsets[newCursor] - layout->offsets[firstDisplayedChar] < cursorX)
         {
-            oc_rect bbox = oc_font_text_metrics_utf32(font, fontSize, oc_str32_slice(codepoints, i, i + 1)).logical;
-            if(x < cursorX)
-            {
-                hoveredChar = i;
-            }
-            if(x + 0.5 * bbox.w > cursorX)
-            {
-                newCursor = i;
-                break;
-            }
-            if(i == codepoints.len - 1)
-            {
-                newCursor = codepoints.len;
-            }
-            x += bbox.w;
+            hoveredChar = newCursor;
+        }
+        else if(newCursor > (i32)firstDisplayedChar)
+        {
+            hoveredChar = newCursor - 1;
         }
 
         if(sig.doubleClicked)
@@ -4004,8 +4923,8 @@ oc_ui_text_box_result oc_ui_text_box_str8(oc_str8 name, oc_arena* arena, oc_str8
         }
         else if(ui->editSelectionMode == OC_UI_EDIT_MOVE_LINE)
         {
-            oc_rect bbox = oc_font_text_metrics_utf32(font, fontSize, codepoints).logical;
-            if(fabsf(bbox.w - cursorX) < fabsf(cursorX))
+            f32 width = layout->offsets[codepoints.len];
+            if(fabsf(width - cursorX) < fabsf(cursorX))
             {
                 ui->editCursor = codepoints.len;
                 ui->editMark = 0;
@@ -4021,10 +4940,8 @@ oc_ui_text_box_result oc_ui_text_box_str8(oc_str8 name, oc_arena* arena, oc_str8
             if(oc_min(ui->editCursor, ui->editMark) == oc_min(ui->editWordSelectionInitialCursor, ui->editWordSelectionInitialMark)
                && oc_max(ui->editCursor, ui->editMark) == oc_max(ui->editWordSelectionInitialCursor, ui->editWordSelectionInitialMark))
             {
-                oc_rect editCursorPrefixBbox = oc_font_text_metrics_utf32(font, fontSize, oc_str32_slice(codepoints, 0, ui->editCursor)).logical;
-                oc_rect editMarkPrefixBbox = oc_font_text_metrics_utf32(font, fontSize, oc_str32_slice(codepoints, 0, ui->editMark)).logical;
-                f32 editCursorX = editCursorPrefixBbox.w;
-                f32 editMarkX = editMarkPrefixBbox.w;
+                f32 editCursorX = layout->offsets[oc_clamp(ui->editCursor, 0, (i32)codepoints.len)];
+                f32 editMarkX = layout->offsets[oc_clamp(ui->editMark, 0, (i32)codepoints.len)];
                 if(fabsf(cursorX - editMarkX) < fabsf(cursorX - editCursorX))
                 {
                     i32 tmp = ui->editMark;
@@ -4085,6 +5002,9 @@ oc_ui_text_box_result oc_ui_text_box_str8(oc_str8 name, oc_arena* arena, oc_str8
         ui->editCursor = oc_clamp(ui->editCursor, 0, (i32)codepoints.len);
         ui->editMark = oc_clamp(ui->editMark, 0, (i32)codepoints.len);
 
+        //NOTE: edits below keep the layout in sync with codepoints
+        oc_ui_edit_layout* layout = oc_ui_edit_layout_sync(ui, frame->key, font, fontSize, codepoints);
+
         //NOTE replace selection with input codepoints
         oc_str32 input = oc_input_text_utf32(&ui->frameArena, &ui->input);
         if(input.len)
@@ -4156,31 +5076,34 @@ oc_ui_text_box_result oc_ui_text_box_str8(oc_str8 name, oc_arena* arena, oc_str8
             else
             {
                 i32 firstDisplayedChar = ui->editFirstDisplayedChar;
-                oc_str32 firstToCursor = oc_str32_slice(codepoints, firstDisplayedChar, ui->editCursor);
-                oc_rect firstToCursorBox = oc_font_text_metrics_utf32(font, fontSize, firstToCursor).logical;
+                f32 cursorX = layout->offsets[ui->editCursor];
 
-                while(firstToCursorBox.w > textBox->rect.w)
+                while(cursorX - layout->offsets[firstDisplayedChar] > textBox->rect.w)
                 {
                     firstDisplayedChar++;
-                    firstToCursor = oc_str32_slice(codepoints, firstDisplayedChar, ui->editCursor);
-                    firstToCursorBox = oc_font_text_metrics_utf32(font, fontSize, firstToCursor).logical;
                 }
 
                 ui->editFirstDisplayedChar = firstDisplayedChar;
             }
         }
 
-        //NOTE: set renderer
-        oc_str32* renderCodepoints = oc_arena_push_type(&ui->frameArena, oc_str32);
-        *renderCodepoints = oc_str32_push_copy(&ui->frameArena, codepoints);
-        oc_ui_box_set_draw_proc(textBox, oc_ui_text_box_render, renderCodepoints);
+        //NOTE: keep frames coming so that the caret blinks
+        ui->animating = true;
+
+        //NOTE: set renderer. The layout is copied, since another text box could use it before we're drawn.
+        oc_ui_text_box_render_data* renderData = oc_arena_push_type(&ui->frameArena, oc_ui_text_box_render_data);
+        renderData->codepoints = oc_str32_push_copy(&ui->frameArena, codepoints);
+        renderData->offsets = oc_arena_push_array(&ui->frameArena, f32, codepoints.len + 1);
+        memcpy(renderData->offsets, layout->offsets, (codepoints.len + 1) * sizeof(f32));
+        oc_ui_box_set_draw_proc(textBox, oc_ui_text_box_render, renderData);
     }
     else
     {
         //NOTE: set renderer
-        oc_str32* renderCodepoints = oc_arena_push_type(&ui->frameArena, oc_str32);
-        *renderCodepoints = oc_utf8_push_to_codepoints(&ui->frameArena, text);
-        oc_ui_box_set_draw_proc(textBox, oc_ui_text_box_render, renderCodepoints);
+        oc_ui_text_box_render_data* renderData = oc_arena_push_type(&ui->frameArena, oc_ui_text_box_render_data);
+        renderData->codepoints = oc_utf8_push_to_codepoints(&ui->frameArena, text);
+        renderData->offsets = 0;
+        oc_ui_box_set_draw_proc(textBox, oc_ui_text_box_render, renderData);
     }
 
     oc_ui_box_end(); // frame
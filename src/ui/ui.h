@@ -438,6 +438,10 @@ typedef struct oc_ui_style_rule
     oc_list_elt buildElt;
     oc_list_elt tmpElt;
 
+    // rule index bucket and application order, set while styling
+    oc_list* bucket;
+    i64 order;
+
     oc_ui_box* owner;
     oc_ui_pattern pattern;
     oc_ui_style_mask mask;
@@ -468,6 +472,59 @@ typedef struct oc_ui_sig
 
 typedef void (*oc_ui_box_draw_proc)(oc_ui_box* box, void* data);
 
+//NOTE: layout results of a box, kept across frames so that subtrees whose layout inputs didn't change can be skipped
+typedef struct oc_ui_layout_cache
+{
+    u64 hash;  // hash of the layout inputs of the box and its subtree
+    bool clean; // hash is the same as in the previous frame
+    bool upwardReused[2];
+
+    f32 staticSize[2]; // size of text and pixel-sized boxes
+    f32 downSize[2];
+    f32 downMinSize[2];
+    f32 upSize[2];
+    f32 upMinSize[2];
+    f32 finalSize[2];
+    f32 finalMinSize[2];
+
+    oc_vec2 pos;
+    u32 z;
+    u32 zEnd;
+    u64 rectGeneration; // incremented each time the rects of the subtree are recomputed
+    oc_rect bounds;     // bounds of everything drawn by the subtree, used for culling and hit testing
+
+    u64 drawHash; // hash of the draw inputs of the box and its subtree
+} oc_ui_layout_cache;
+
+//NOTE: layout inputs and results of a visible box. The layout passes work on a contiguous array of these, rebuilt in
+//      depth-first order at each frame, rather than on the boxes themselves, which are much larger. The results are
+//      copied back to the boxes' rects once their position is computed.
+typedef struct oc_ui_layout_node
+{
+    u32 firstChild;  // index of the first visible child, 0 if none
+    u32 nextSibling; // index of the next visible sibling, 0 if none
+
+    u32 flags;
+    oc_ui_axis layoutAxis;
+    f32 layoutSpacing;
+    oc_vec2 margin;
+    oc_ui_size size[2];
+    bool floating[2];
+
+    oc_rect rect;
+    f32 minSize[2];
+    f32 spacing[2];
+    f32 childrenSum[2];
+} oc_ui_layout_node;
+
+typedef struct oc_ui_layout_nodes
+{
+    u32 count;
+    u32 cap;
+    oc_ui_layout_node* nodes;
+    oc_ui_box** boxes; // box of each node
+} oc_ui_layout_nodes;
+
 typedef enum
 {
     OC_UI_FLAG_NONE = 0,
@@ -487,6 +544,9 @@ typedef enum
     OC_UI_FLAG_DRAW_BORDER = (1 << 11),
     OC_UI_FLAG_DRAW_TEXT = (1 << 12),
     OC_UI_FLAG_DRAW_PROC = (1 << 13),
+    //NOTE: keep the canvas commands of the box and its subtree in a display list, and replay them as long as the
+    //      subtree's style and rects don't change. Draw procs in the subtree are only called when the list is rebuilt.
+    OC_UI_FLAG_CACHE_DRAW = (1 << 14),
 
     OC_UI_FLAG_OVERLAY = (1 << 16),
 } oc_ui_flags;
@@ -501,13 +561,14 @@ struct oc_ui_box
     oc_list_elt overlayElt;
 
     // keying and caching
-    oc_list_elt bucketElt;
+    oc_list_elt cacheElt;
     oc_ui_key key;
     u64 frameCounter;
 
     // builder-provided info
     oc_ui_flags flags;
-    oc_str8 string;
+    oc_str8 string; // owned by the box
+    u64 stringCap;
     oc_list tags;
 
     oc_ui_box_draw_proc drawProc;
@@ -517,7 +578,7 @@ struct oc_ui_box
     oc_list beforeRules;
     oc_list afterRules;
 
-    oc_ui_style* targetStyle;
+    oc_ui_style targetStyle;
     oc_ui_style style;
     u32 z;
 
@@ -526,6 +587,14 @@ struct oc_ui_box
     f32 spacing[2];
     f32 minSize[2];
     oc_rect rect;
+    oc_ui_layout_cache layoutCache;
+    u32 layoutIndex; // index of the box's node in the context's layout nodes, valid during layout
+
+    // retained draw commands, see OC_UI_FLAG_CACHE_DRAW
+    oc_display_list drawList;
+    u64 drawListHash;
+    u64 drawListRectGeneration;
+    oc_rect drawListClip;
 
     // signals
     oc_ui_sig* sig;
@@ -583,9 +652,16 @@ typedef struct oc_ui_tag_elt
 
 enum
 {
-    OC_UI_BOX_MAP_BUCKET_COUNT = 1024
+    OC_UI_BOX_MAP_MIN_CAP = 1024,
+    OC_UI_TEXT_METRICS_MAP_BUCKET_COUNT = 1024,
 };
 
+typedef struct oc_ui_box_map_entry
+{
+    u64 hash;
+    oc_ui_box* box; // null if the slot is empty
+} oc_ui_box_map_entry;
+
 typedef enum
 {
     OC_UI_EDIT_MOVE_NONE = 0,
@@ -594,6 +670,37 @@ typedef enum
     OC_UI_EDIT_MOVE_LINE
 } oc_ui_edit_move;
 
+//NOTE: glyph offsets of the text being edited, kept across frames and updated on each edit so that caret placement,
+//      hit testing and drawing don't have to measure the whole text
+typedef struct oc_ui_edit_layout
+{
+    oc_ui_key key; // frame of the text box the layout belongs to
+    oc_font font;
+    f32 fontSize;
+    u64 frameCounter; // last frame in which the layout was checked against the text
+
+    u32 len;
+    u32 cap;
+    oc_utf32* codepoints;
+    f32* offsets; // x offset of each codepoint from the start of the text, and of the end of the text (len + 1 entries)
+} oc_ui_edit_layout;
+
+//NOTE: allocation counters and timings of a ui frame, to check that steady-state frames don't churn memory
+typedef struct oc_ui_frame_stats
+{
+    u64 frameArenaBytes; // bytes pushed on the frame arena
+    u64 frameArenaChunks;
+    u64 boxCount;
+    u64 boxAllocs; // boxes allocated from the pool
+    u64 boxRecycles;
+    u64 ruleCount;
+    u64 textMetricsAllocs;
+    u64 textMetricsRecycles;
+
+    f64 stylingTime; // seconds spent matching style rules and computing static sizes
+    f64 layoutTime;  // seconds spent computing the layout and finding the hovered box
+} oc_ui_frame_stats;
+
 typedef struct oc_ui_context
 {
     bool init;
@@ -606,7 +713,13 @@ typedef struct oc_ui_context
 
     oc_arena frameArena;
     oc_pool boxPool;
-    oc_list boxMap[OC_UI_BOX_MAP_BUCKET_COUNT];
+    oc_ui_box_map_entry* boxMap; // open addressing, robin hood probing
+    u64 boxMapCap;
+    u64 boxMapCount;
+    oc_list boxCache; // cached boxes, most recently made first
+
+    oc_pool textMetricsPool;
+    oc_list textMetricsMap[OC_UI_TEXT_METRICS_MAP_BUCKET_COUNT];
 
     oc_ui_box* root;
     oc_ui_box* overlay;
@@ -618,8 +731,11 @@ typedef struct oc_ui_context
     oc_list nextBoxAfterRules;
     oc_list nextBoxTags;
 
+    oc_ui_layout_nodes layoutNodes;
+
     u32 z;
     oc_ui_box* hovered;
+    bool drawRecording;
 
     oc_ui_box* focus;
     i32 editCursor;
@@ -629,6 +745,12 @@ typedef struct oc_ui_context
     oc_ui_edit_move editSelectionMode;
     i32 editWordSelectionInitialCursor;
     i32 editWordSelectionInitialMark;
+    oc_ui_edit_layout editLayout;
+
+    bool animating; // an animation or a blinking caret needs another frame
+
+    oc_ui_frame_stats frameStats;     // stats of the frame being built
+    oc_ui_frame_stats lastFrameStats; // stats of the last completed frame
 
     oc_ui_theme* theme;
 } oc_ui_context;
@@ -646,6 +768,9 @@ ORCA_API void oc_ui_end_frame(void);
 ORCA_API void oc_ui_draw(void);
 ORCA_API void oc_ui_set_theme(oc_ui_theme* theme);
 
+//NOTE: returns the allocation counters of the last completed frame
+ORCA_API oc_ui_frame_stats oc_ui_get_frame_stats(void);
+
 #define oc_ui_frame(size, style, mask) oc_defer_loop(oc_ui_begin_frame((size), (style), (mask)), oc_ui_end_frame())
 
 //-------------------------------------------------------------------------------------
@@ -657,15 +782,44 @@ ORCA_API oc_ui_key oc_ui_key_make_path(oc_str8_list path);
 // C-string helper
 #define oc_ui_key_make(s) oc_ui_key_make_str8(OC_STR8(s))
 
+/*NOTE:
+	Keys made from a precomputed label hash only combine that hash with the parent's key, instead of hashing the
+	whole label every frame. OC_UI_HASH() hashes a string literal, which compilers fold to a constant, and
+	oc_ui_hash_str8() hashes a dynamic label once, so that the caller can keep the hash across frames.
+
+	These keys aren't the same as the keys oc_ui_key_make_str8() makes from the same label, so a box made from a
+	hash must be looked up with that hash.
+*/
+static inline u64 oc_ui_hash_cstring(const char* s, u64 len)
+{
+    //NOTE: FNV-1a, which is simple enough to be constant-folded for literals
+    u64 hash = 0xcbf29ce484222325ULL;
+    for(u64 i = 0; i < len; i++)
+    {
+        hash = (hash ^ (u8)s[i]) * 0x100000001b3ULL;
+    }
+    return (hash);
+}
+
+#define OC_UI_HASH(s) oc_ui_hash_cstring((s), sizeof(s) - 1)
+
+ORCA_API u64 oc_ui_hash_str8(oc_str8 string);
+ORCA_API oc_ui_key oc_ui_key_make_hash(u64 hash);
+
 //-------------------------------------------------------------------------------------
 // Box hierarchy building
 //-------------------------------------------------------------------------------------
 ORCA_API oc_ui_box* oc_ui_box_make_str8(oc_str8 string, oc_ui_flags flags);
 ORCA_API oc_ui_box* oc_ui_box_begin_str8(oc_str8 string, oc_ui_flags flags);
 
+//NOTE: the box's key is made from a precomputed hash of its label, see oc_ui_key_make_hash()
+ORCA_API oc_ui_box* oc_ui_box_make_hash(oc_str8 string, u64 hash, oc_ui_flags flags);
+ORCA_API oc_ui_box* oc_ui_box_begin_hash(oc_str8 string, u64 hash, oc_ui_flags flags);
+
 ORCA_API oc_ui_box* oc_ui_box_end(void);
 #define oc_ui_container(name, flags) oc_defer_loop(oc_ui_box_begin(name, flags), oc_ui_box_end())
 #define oc_ui_container_str8(name, flags) oc_defer_loop(oc_ui_box_begin_str8(name, flags), oc_ui_box_end())
+#define oc_ui_container_static(name, flags) oc_defer_loop(oc_ui_box_begin_static(name, flags), oc_ui_box_end())
 
 ORCA_API void oc_ui_box_push(oc_ui_box* box);
 ORCA_API void oc_ui_box_pop(void);
@@ -673,6 +827,7 @@ ORCA_API oc_ui_box* oc_ui_box_top(void);
 
 ORCA_API oc_ui_box* oc_ui_box_lookup_key(oc_ui_key key);
 ORCA_API oc_ui_box* oc_ui_box_lookup_str8(oc_str8 string);
+ORCA_API oc_ui_box* oc_ui_box_lookup_hash(u64 hash);
 
 ORCA_API void oc_ui_box_set_draw_proc(oc_ui_box* box, oc_ui_box_draw_proc proc, void* data);
 
@@ -681,6 +836,11 @@ ORCA_API void oc_ui_box_set_draw_proc(oc_ui_box* box, oc_ui_box_draw_proc proc,
 #define oc_ui_box_make(s, flags) oc_ui_box_make_str8(OC_STR8(s), flags)
 #define oc_ui_box_begin(s, flags) oc_ui_box_begin_str8(OC_STR8(s), flags)
 
+// string literal helpers, whose label hash is computed at compile time
+#define oc_ui_box_lookup_static(s) oc_ui_box_lookup_hash(OC_UI_HASH(s))
+#define oc_ui_box_make_static(s, flags) oc_ui_box_make_hash((oc_str8)OC_STR8_LIT(s), OC_UI_HASH(s), flags)
+#define oc_ui_box_begin_static(s, flags) oc_ui_box_begin_hash((oc_str8)OC_STR8_LIT(s), OC_UI_HASH(s), flags)
+
 //-------------------------------------------------------------------------------------
 // Box status and signals
 //-------------------------------------------------------------------------------------
@@ -746,6 +906,29 @@ ORCA_API void oc_ui_panel_begin_str8(oc_str8 name, oc_ui_flags flags);
 ORCA_API void oc_ui_panel_end(void);
 #define oc_ui_panel(s, f) oc_defer_loop(oc_ui_panel_begin(s, f), oc_ui_panel_end())
 
+//NOTE: a scrolling list that only builds the rows in view. rowProc is called for each visible row, inside a box that
+//      spans the list's width. Rows above and below the view are replaced by spacers, so that scrollbars reflect the
+//      whole list. If rowHeight is 0, rows are sized by their contents and estimatedRowHeight is updated with the
+//      height of the last row that was laid out. Store the returned info back into info to keep the estimate.
+typedef void (*oc_ui_list_row_proc)(u64 row, void* user);
+
+typedef struct oc_ui_list_info
+{
+    u64 rowCount;
+    f32 rowHeight;
+    f32 estimatedRowHeight;
+    oc_ui_list_row_proc rowProc;
+    void* user;
+
+    // outputs
+    oc_ui_box* panel;
+    u64 firstRow; // rows built this frame are in [firstRow, endRow)
+    u64 endRow;
+} oc_ui_list_info;
+
+ORCA_API oc_ui_list_info oc_ui_list(const char* name, oc_ui_list_info* info);
+ORCA_API oc_ui_list_info oc_ui_list_str8(oc_str8 name, oc_ui_list_info* info);
+
 ORCA_API void oc_ui_menu_bar_begin(const char* name);
 ORCA_API void oc_ui_menu_bar_begin_str8(oc_str8 name);
 ORCA_API void oc_ui_menu_bar_end(void);
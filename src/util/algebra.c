@@ -8,6 +8,8 @@
 #include <math.h>
 #include "algebra.h"
 
+#include "simd_f32x4.h"
+
 bool oc_vec2_equal(oc_vec2 v0, oc_vec2 v1)
 {
     return (v0.x == v1.x && v0.y == v1.y);
@@ -74,3 +76,191 @@ oc_mat2x3 oc_mat2x3_translate(f32 x, f32 y)
     };
     return translate;
 }
+
+oc_vec4 oc_mat4x4_mul(oc_mat4x4 m, oc_vec4 v)
+{
+    oc_vec4 res;
+    for(int row = 0; row < 4; row++)
+    {
+        res.c[row] = v.x * m.m[4 * row] + v.y * m.m[4 * row + 1] + v.z * m.m[4 * row + 2] + v.w * m.m[4 * row + 3];
+    }
+    return (res);
+}
+
+oc_mat4x4 oc_mat4x4_mul_m(oc_mat4x4 lhs, oc_mat4x4 rhs)
+{
+    oc_mat4x4 res;
+    oc_mat4x4_mul_m_array(lhs, 1, &rhs, &res);
+    return (res);
+}
+
+//-----------------------------------------------------------------
+// batched operations
+//-----------------------------------------------------------------
+
+//NOTE: the SIMD loops multiply and add in the same order as the scalar code that handles the remaining elements,
+//      so that results don't depend on an element's position in the array.
+
+void oc_mat2x3_transform_points(oc_mat2x3 m, u64 count, oc_vec2* src, oc_vec2* dst)
+{
+    u64 i = 0;
+
+#if OC_F32X4_SIMD
+    //NOTE: two points per vector, interleaved as (x0, y0, x1, y1)
+    const oc_f32x4 m0 = oc_f32x4_set(m.m[0], m.m[3], m.m[0], m.m[3]);
+    const oc_f32x4 m1 = oc_f32x4_set(m.m[1], m.m[4], m.m[1], m.m[4]);
+    const oc_f32x4 m2 = oc_f32x4_set(m.m[2], m.m[5], m.m[2], m.m[5]);
+
+    for(; i + 2 <= count; i += 2)
+    {
+        oc_f32x4 v = oc_f32x4_load(&src[i].x);
+        oc_f32x4 x = oc_f32x4_even(v);
+        oc_f32x4 y = oc_f32x4_odd(v);
+        oc_f32x4_store(&dst[i].x, oc_f32x4_add(oc_f32x4_add(oc_f32x4_mul(x, m0), oc_f32x4_mul(y, m1)), m2));
+    }
+#endif
+
+    for(; i < count; i++)
+    {
+        dst[i] = oc_mat2x3_mul(m, src[i]);
+    }
+}
+
+void oc_mat4x4_transform_vec4s(oc_mat4x4 m, u64 count, oc_vec4* src, oc_vec4* dst)
+{
+    u64 i = 0;
+
+#if OC_F32X4_SIMD
+    const oc_f32x4 c0 = oc_f32x4_set(m.m[0], m.m[4], m.m[8], m.m[12]);
+    const oc_f32x4 c1 = oc_f32x4_set(m.m[1], m.m[5], m.m[9], m.m[13]);
+    const oc_f32x4 c2 = oc_f32x4_set(m.m[2], m.m[6], m.m[10], m.m[14]);
+    const oc_f32x4 c3 = oc_f32x4_set(m.m[3], m.m[7], m.m[11], m.m[15]);
+
+    for(; i < count; i++)
+    {
+        oc_f32x4 v = oc_f32x4_load(src[i].c);
+        oc_f32x4 res = oc_f32x4_mul(oc_f32x4_lane(v, 0), c0);
+        res = oc_f32x4_add(res, oc_f32x4_mul(oc_f32x4_lane(v, 1), c1));
+        res = oc_f32x4_add(res, oc_f32x4_mul(oc_f32x4_lane(v, 2), c2));
+        res = oc_f32x4_add(res, oc_f32x4_mul(oc_f32x4_lane(v, 3), c3));
+        oc_f32x4_store(dst[i].c, res);
+    }
+#endif
+
+    for(; i < count; i++)
+    {
+        dst[i] = oc_mat4x4_mul(m, src[i]);
+    }
+}
+
+void oc_mat4x4_mul_m_array(oc_mat4x4 lhs, u64 count, oc_mat4x4* rhs, oc_mat4x4* dst)
+{
+    u64 i = 0;
+
+#if OC_F32X4_SIMD
+    //NOTE: each row of the result is a combination of the rows of rhs, weighted by the elements of the row of lhs
+    oc_f32x4 weights[16];
+    for(int k = 0; k < 16; k++)
+    {
+        weights[k] = oc_f32x4_splat(lhs.m[k]);
+    }
+
+    for(; i < count; i++)
+    {
+        oc_f32x4 rows[4];
+        for(int k = 0; k < 4; k++)
+        {
+            rows[k] = oc_f32x4_load(&rhs[i].m[4 * k]);
+        }
+        for(int row = 0; row < 4; row++)
+        {
+            oc_f32x4 res = oc_f32x4_mul(weights[4 * row], rows[0]);
+            res = oc_f32x4_add(res, oc_f32x4_mul(weights[4 * row + 1], rows[1]));
+            res = oc_f32x4_add(res, oc_f32x4_mul(weights[4 * row + 2], rows[2]));
+            res = oc_f32x4_add(res, oc_f32x4_mul(weights[4 * row + 3], rows[3]));
+            oc_f32x4_store(&dst[i].m[4 * row], res);
+        }
+    }
+#endif
+
+    for(; i < count; i++)
+    {
+        oc_mat4x4 res;
+        for(int row = 0; row < 4; row++)
+        {
+            for(int col = 0; col < 4; col++)
+            {
+                res.m[4 * row + col] = lhs.m[4 * row] * rhs[i].m[col]
+                                     + lhs.m[4 * row + 1] * rhs[i].m[4 + col]
+                                     + lhs.m[4 * row + 2] * rhs[i].m[8 + col]
+                                     + lhs.m[4 * row + 3] * rhs[i].m[12 + col];
+            }
+        }
+        dst[i] = res;
+    }
+}
+
+//NOTE: vec2 arrays are processed as flat arrays of 2 * count floats
+void oc_vec2_array_add(u64 count, oc_vec2* a, oc_vec2* b, oc_vec2* dst)
+{
+    f32* fa = (f32*)a;
+    f32* fb = (f32*)b;
+    f32* fdst = (f32*)dst;
+    u64 n = 2 * count;
+    u64 i = 0;
+
+#if OC_F32X4_SIMD
+    for(; i + 4 <= n; i += 4)
+    {
+        oc_f32x4_store(fdst + i, oc_f32x4_add(oc_f32x4_load(fa + i), oc_f32x4_load(fb + i)));
+    }
+#endif
+
+    for(; i < n; i++)
+    {
+        fdst[i] = fa[i] + fb[i];
+    }
+}
+
+void oc_vec2_array_scale(u64 count, oc_vec2* src, f32 f, oc_vec2* dst)
+{
+    f32* fsrc = (f32*)src;
+    f32* fdst = (f32*)dst;
+    u64 n = 2 * count;
+    u64 i = 0;
+
+#if OC_F32X4_SIMD
+    const oc_f32x4 scale = oc_f32x4_splat(f);
+    for(; i + 4 <= n; i += 4)
+    {
+        oc_f32x4_store(fdst + i, oc_f32x4_mul(oc_f32x4_load(fsrc + i), scale));
+    }
+#endif
+
+    for(; i < n; i++)
+    {
+        fdst[i] = fsrc[i] * f;
+    }
+}
+
+void oc_vec2_array_mul_add(u64 count, oc_vec2* a, f32 f, oc_vec2* b, oc_vec2* dst)
+{
+    f32* fa = (f32*)a;
+    f32* fb = (f32*)b;
+    f32* fdst = (f32*)dst;
+    u64 n = 2 * count;
+    u64 i = 0;
+
+#if OC_F32X4_SIMD
+    const oc_f32x4 scale = oc_f32x4_splat(f);
+    for(; i + 4 <= n; i += 4)
+    {
+        oc_f32x4_store(fdst + i, oc_f32x4_add(oc_f32x4_load(fa + i), oc_f32x4_mul(oc_f32x4_load(fb + i), scale)));
+    }
+#endif
+
+    for(; i < n; i++)
+    {
+        fdst[i] = fa[i] + fb[i] * f;
+    }
+}
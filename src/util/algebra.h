@@ -25,6 +25,22 @@ ORCA_API oc_mat2x3 oc_mat2x3_inv(oc_mat2x3 x);
 ORCA_API oc_mat2x3 oc_mat2x3_rotate(f32 radians);
 ORCA_API oc_mat2x3 oc_mat2x3_translate(f32 x, f32 y);
 
+ORCA_API oc_vec4 oc_mat4x4_mul(oc_mat4x4 m, oc_vec4 v);
+ORCA_API oc_mat4x4 oc_mat4x4_mul_m(oc_mat4x4 lhs, oc_mat4x4 rhs);
+
+/*NOTE:
+	Batched versions of the above, for transforming many points or matrices at once. They use SIMD instructions
+	where they're available: SSE2 or NEON on the host, and SIMD128 in apps built with -msimd128. Destination arrays
+	can be the same as source arrays.
+*/
+ORCA_API void oc_mat2x3_transform_points(oc_mat2x3 m, u64 count, oc_vec2* src, oc_vec2* dst);
+ORCA_API void oc_mat4x4_transform_vec4s(oc_mat4x4 m, u64 count, oc_vec4* src, oc_vec4* dst);
+ORCA_API void oc_mat4x4_mul_m_array(oc_mat4x4 lhs, u64 count, oc_mat4x4* rhs, oc_mat4x4* dst);
+
+ORCA_API void oc_vec2_array_add(u64 count, oc_vec2* a, oc_vec2* b, oc_vec2* dst);
+ORCA_API void oc_vec2_array_scale(u64 count, oc_vec2* src, f32 f, oc_vec2* dst);
+ORCA_API void oc_vec2_array_mul_add(u64 count, oc_vec2* a, f32 f, oc_vec2* b, oc_vec2* dst);
+
 //TODO: complete
 
 #ifdef __cplusplus
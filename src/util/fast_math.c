@@ -0,0 +1,380 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <math.h>
+#include <string.h>
+#include "fast_math.h"
+#include "simd_f32x4.h"
+
+/*NOTE:
+	The scalar functions and the 4-lane kernels below implement the same algorithms with the same constants, so that
+	the array functions can process their remaining elements with the scalar ones.
+
+	Sine and cosine reduce their argument to [-pi/4, pi/4] by subtracting a multiple of pi/2 split in three parts,
+	and evaluate the minimax polynomials of cephes' sinf/cosf on the reduced argument. The exponential reduces its
+	argument by a multiple of ln(2) and scales the polynomial by 2^n through the exponent bits. The logarithm splits
+	its argument in a mantissa in [sqrt(1/2), sqrt(2)) and an exponent, and evaluates a polynomial of the mantissa.
+*/
+
+static const f32 OC_FAST_2_OVER_PI = 0.636619772367581343f;
+static const f32 OC_FAST_PIO2_1 = 1.5703125f;
+static const f32 OC_FAST_PIO2_2 = 4.837512969970703125e-4f;
+static const f32 OC_FAST_PIO2_3 = 7.54978995489188216e-8f;
+
+static const f32 OC_FAST_SIN_1 = -1.6666654611e-1f;
+static const f32 OC_FAST_SIN_2 = 8.3321608736e-3f;
+static const f32 OC_FAST_SIN_3 = -1.9515295891e-4f;
+static const f32 OC_FAST_COS_1 = 4.166664568298827e-2f;
+static const f32 OC_FAST_COS_2 = -1.388731625493765e-3f;
+static const f32 OC_FAST_COS_3 = 2.443315711809948e-5f;
+
+//NOTE: the exponential is clamped so that 2^n stays a normal float, and saturates to 0 or infinity beyond that
+static const f32 OC_FAST_EXP_MIN = -87.33654f;
+static const f32 OC_FAST_EXP_MAX = 88.72283f;
+static const f32 OC_FAST_LOG2E = 1.44269504088896341f;
+static const f32 OC_FAST_LN2_1 = 0.693359375f;
+static const f32 OC_FAST_LN2_2 = -2.12194440e-4f;
+
+static const f32 OC_FAST_EXP_0 = 1.9875691500e-4f;
+static const f32 OC_FAST_EXP_1 = 1.3981999507e-3f;
+static const f32 OC_FAST_EXP_2 = 8.3334519073e-3f;
+static const f32 OC_FAST_EXP_3 = 4.1665795894e-2f;
+static const f32 OC_FAST_EXP_4 = 1.6666665459e-1f;
+static const f32 OC_FAST_EXP_5 = 5.0000001201e-1f;
+
+static const f32 OC_FAST_SQRTHF = 0.707106781186547524f;
+static const f32 OC_FAST_MIN_NORMAL = 1.17549435e-38f;
+
+static const f32 OC_FAST_LOG_0 = 7.0376836292e-2f;
+static const f32 OC_FAST_LOG_1 = -1.1514610310e-1f;
+static const f32 OC_FAST_LOG_2 = 1.1676998740e-1f;
+static const f32 OC_FAST_LOG_3 = -1.2420140846e-1f;
+static const f32 OC_FAST_LOG_4 = 1.4249322787e-1f;
+static const f32 OC_FAST_LOG_5 = -1.6668057665e-1f;
+static const f32 OC_FAST_LOG_6 = 2.0000714765e-1f;
+static const f32 OC_FAST_LOG_7 = -2.4999993993e-1f;
+static const f32 OC_FAST_LOG_8 = 3.3333331174e-1f;
+
+//-----------------------------------------------------------------
+// scalar functions
+//-----------------------------------------------------------------
+
+static inline u32 oc_fast_f32_bits(f32 f)
+{
+    u32 bits;
+    memcpy(&bits, &f, sizeof(u32));
+    return (bits);
+}
+
+static inline f32 oc_fast_f32_from_bits(u32 bits)
+{
+    f32 f;
+    memcpy(&f, &bits, sizeof(f32));
+    return (f);
+}
+
+//NOTE: rounds to the nearest integer, ties to even like the SIMD conversions. Only valid for |f| < 2^22.
+static inline i32 oc_fast_round(f32 f)
+{
+    const f32 magic = 12582912.f; // 1.5 * 2^23
+    return ((i32)((f + magic) - magic));
+}
+
+static f32 oc_fast_sincos(f32 x, i32 quadrantOffset)
+{
+    i32 j = oc_fast_round(x * OC_FAST_2_OVER_PI);
+    f32 fj = (f32)j;
+    f32 r = ((x - fj * OC_FAST_PIO2_1) - fj * OC_FAST_PIO2_2) - fj * OC_FAST_PIO2_3;
+    f32 r2 = r * r;
+
+    f32 s = r + (r * r2) * (OC_FAST_SIN_1 + r2 * (OC_FAST_SIN_2 + r2 * OC_FAST_SIN_3));
+    f32 c = (1.f - 0.5f * r2) + (r2 * r2) * (OC_FAST_COS_1 + r2 * (OC_FAST_COS_2 + r2 * OC_FAST_COS_3));
+
+    i32 q = j + quadrantOffset;
+    f32 res = (q & 1) ? c : s;
+    return ((q & 2) ? -res : res);
+}
+
+f32 oc_fast_sinf(f32 x)
+{
+    return (oc_fast_sincos(x, 0));
+}
+
+f32 oc_fast_cosf(f32 x)
+{
+    return (oc_fast_sincos(x, 1));
+}
+
+f32 oc_fast_expf(f32 x)
+{
+    f32 xc = (x < OC_FAST_EXP_MIN) ? OC_FAST_EXP_MIN : ((x > OC_FAST_EXP_MAX) ? OC_FAST_EXP_MAX : x);
+
+    //NOTE: n is capped to 127 so that 2^n is finite. Close to the overflow threshold this leaves a reduced
+    //      argument up to ln(2) instead of ln(2)/2, which the polynomial still covers with a slightly bigger error.
+    f32 t = xc * OC_FAST_LOG2E;
+    i32 n = oc_fast_round((t > 127.f) ? 127.f : t);
+    f32 fn = (f32)n;
+    f32 r = (xc - fn * OC_FAST_LN2_1) - fn * OC_FAST_LN2_2;
+    f32 r2 = r * r;
+
+    f32 p = ((((OC_FAST_EXP_0 * r + OC_FAST_EXP_1) * r + OC_FAST_EXP_2) * r + OC_FAST_EXP_3) * r + OC_FAST_EXP_4) * r + OC_FAST_EXP_5;
+    f32 y = ((p * r2) + r) + 1.f;
+    y = y * oc_fast_f32_from_bits((u32)(n + 127) << 23);
+
+    if(x > OC_FAST_EXP_MAX)
+    {
+        y = INFINITY;
+    }
+    if(x < OC_FAST_EXP_MIN)
+    {
+        y = 0;
+    }
+    return (y);
+}
+
+f32 oc_fast_logf(f32 x)
+{
+    u32 bits = oc_fast_f32_bits(x);
+    f32 fe = (f32)((i32)((bits >> 23) & 0xff) - 126);
+    f32 m = oc_fast_f32_from_bits((bits & 0x7fffff) + 0x3f000000);
+
+    if(m < OC_FAST_SQRTHF)
+    {
+        fe = fe - 1.f;
+        m = m + m;
+    }
+    m = m - 1.f;
+    f32 z = m * m;
+
+    f32 p = ((((((((OC_FAST_LOG_0 * m + OC_FAST_LOG_1) * m + OC_FAST_LOG_2) * m + OC_FAST_LOG_3) * m + OC_FAST_LOG_4) * m + OC_FAST_LOG_5) * m + OC_FAST_LOG_6) * m + OC_FAST_LOG_7) * m + OC_FAST_LOG_8);
+    f32 y = (m * z) * p;
+    y = y + fe * OC_FAST_LN2_2;
+    y = y - 0.5f * z;
+    f32 res = m + y;
+    res = res + fe * OC_FAST_LN2_1;
+
+    if(x < OC_FAST_MIN_NORMAL)
+    {
+        res = -INFINITY;
+    }
+    return (res);
+}
+
+f32 oc_fast_powf(f32 x, f32 y)
+{
+    if(y == 0)
+    {
+        return (1);
+    }
+    return (oc_fast_expf(y * oc_fast_logf(x)));
+}
+
+f32 oc_fast_sqrtf(f32 x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (__builtin_sqrtf(x));
+#else
+    return (sqrtf(x));
+#endif
+}
+
+//-----------------------------------------------------------------
+// 4-lane kernels
+//-----------------------------------------------------------------
+
+#if OC_F32X4_SIMD
+
+static inline oc_f32x4 oc_fast_sincos_f32x4(oc_f32x4 x, i32 quadrantOffset)
+{
+    oc_i32x4 j = oc_f32x4_round_i32x4(oc_f32x4_mul(x, oc_f32x4_splat(OC_FAST_2_OVER_PI)));
+    oc_f32x4 fj = oc_i32x4_to_f32x4(j);
+    oc_f32x4 r = oc_f32x4_sub(x, oc_f32x4_mul(fj, oc_f32x4_splat(OC_FAST_PIO2_1)));
+    r = oc_f32x4_sub(r, oc_f32x4_mul(fj, oc_f32x4_splat(OC_FAST_PIO2_2)));
+    r = oc_f32x4_sub(r, oc_f32x4_mul(fj, oc_f32x4_splat(OC_FAST_PIO2_3)));
+    oc_f32x4 r2 = oc_f32x4_mul(r, r);
+
+    oc_f32x4 s = oc_f32x4_add(oc_f32x4_mul(r2, oc_f32x4_splat(OC_FAST_SIN_3)), oc_f32x4_splat(OC_FAST_SIN_2));
+    s = oc_f32x4_add(oc_f32x4_mul(r2, s), oc_f32x4_splat(OC_FAST_SIN_1));
+    s = oc_f32x4_add(r, oc_f32x4_mul(oc_f32x4_mul(r, r2), s));
+
+    oc_f32x4 c = oc_f32x4_add(oc_f32x4_mul(r2, oc_f32x4_splat(OC_FAST_COS_3)), oc_f32x4_splat(OC_FAST_COS_2));
+    c = oc_f32x4_add(oc_f32x4_mul(r2, c), oc_f32x4_splat(OC_FAST_COS_1));
+    c = oc_f32x4_add(oc_f32x4_sub(oc_f32x4_splat(1.f), oc_f32x4_mul(oc_f32x4_splat(0.5f), r2)),
+                     oc_f32x4_mul(oc_f32x4_mul(r2, r2), c));
+
+    //NOTE: bit 0 of the quadrant picks the cosine polynomial, and bit 1 flips the sign
+    oc_i32x4 q = oc_i32x4_add(j, oc_i32x4_splat(quadrantOffset));
+    oc_f32x4 cosMask = oc_i32x4_as_f32x4(oc_i32x4_shr(oc_i32x4_shl(q, 31), 31));
+    oc_f32x4 signBit = oc_i32x4_as_f32x4(oc_i32x4_and(oc_i32x4_shl(q, 30), oc_i32x4_splat(INT32_MIN)));
+
+    return (oc_f32x4_xor(oc_f32x4_select(cosMask, c, s), signBit));
+}
+
+static inline oc_f32x4 oc_fast_expf_f32x4(oc_f32x4 x)
+{
+    oc_f32x4 xc = oc_f32x4_min(oc_f32x4_max(x, oc_f32x4_splat(OC_FAST_EXP_MIN)), oc_f32x4_splat(OC_FAST_EXP_MAX));
+
+    oc_f32x4 t = oc_f32x4_min(oc_f32x4_mul(xc, oc_f32x4_splat(OC_FAST_LOG2E)), oc_f32x4_splat(127.f));
+    oc_i32x4 n = oc_f32x4_round_i32x4(t);
+    oc_f32x4 fn = oc_i32x4_to_f32x4(n);
+    oc_f32x4 r = oc_f32x4_sub(xc, oc_f32x4_mul(fn, oc_f32x4_splat(OC_FAST_LN2_1)));
+    r = oc_f32x4_sub(r, oc_f32x4_mul(fn, oc_f32x4_splat(OC_FAST_LN2_2)));
+    oc_f32x4 r2 = oc_f32x4_mul(r, r);
+
+    oc_f32x4 p = oc_f32x4_add(oc_f32x4_mul(oc_f32x4_splat(OC_FAST_EXP_0), r), oc_f32x4_splat(OC_FAST_EXP_1));
+    p = oc_f32x4_add(oc_f32x4_mul(p, r), oc_f32x4_splat(OC_FAST_EXP_2));
+    p = oc_f32x4_add(oc_f32x4_mul(p, r), oc_f32x4_splat(OC_FAST_EXP_3));
+    p = oc_f32x4_add(oc_f32x4_mul(p, r), oc_f32x4_splat(OC_FAST_EXP_4));
+    p = oc_f32x4_add(oc_f32x4_mul(p, r), oc_f32x4_splat(OC_FAST_EXP_5));
+
+    oc_f32x4 y = oc_f32x4_add(oc_f32x4_add(oc_f32x4_mul(p, r2), r), oc_f32x4_splat(1.f));
+    y = oc_f32x4_mul(y, oc_i32x4_as_f32x4(oc_i32x4_shl(oc_i32x4_add(n, oc_i32x4_splat(127)), 23)));
+
+    y = oc_f32x4_select(oc_f32x4_gt(x, oc_f32x4_splat(OC_FAST_EXP_MAX)), oc_f32x4_splat(INFINITY), y);
+    y = oc_f32x4_select(oc_f32x4_lt(x, oc_f32x4_splat(OC_FAST_EXP_MIN)), oc_f32x4_splat(0), y);
+    return (y);
+}
+
+static inline oc_f32x4 oc_fast_logf_f32x4(oc_f32x4 x)
+{
+    oc_f32x4 one = oc_f32x4_splat(1.f);
+
+    oc_i32x4 bits = oc_f32x4_as_i32x4(x);
+    oc_i32x4 e = oc_i32x4_sub(oc_i32x4_and(oc_i32x4_shr(bits, 23), oc_i32x4_splat(0xff)), oc_i32x4_splat(126));
+    oc_f32x4 fe = oc_i32x4_to_f32x4(e);
+    oc_f32x4 m = oc_i32x4_as_f32x4(oc_i32x4_add(oc_i32x4_and(bits, oc_i32x4_splat(0x7fffff)), oc_i32x4_splat(0x3f000000)));
+
+    oc_f32x4 mask = oc_f32x4_lt(m, oc_f32x4_splat(OC_FAST_SQRTHF));
+    fe = oc_f32x4_sub(fe, oc_f32x4_and(mask, one));
+    m = oc_f32x4_add(m, oc_f32x4_and(mask, m));
+    m = oc_f32x4_sub(m, one);
+    oc_f32x4 z = oc_f32x4_mul(m, m);
+
+    oc_f32x4 p = oc_f32x4_add(oc_f32x4_mul(oc_f32x4_splat(OC_FAST_LOG_0), m), oc_f32x4_splat(OC_FAST_LOG_1));
+    p = oc_f32x4_add(oc_f32x4_mul(p, m), oc_f32x4_splat(OC_FAST_LOG_2));
+    p = oc_f32x4_add(oc_f32x4_mul(p, m), oc_f32x4_splat(OC_FAST_LOG_3));
+    p = oc_f32x4_add(oc_f32x4_mul(p, m), oc_f32x4_splat(OC_FAST_LOG_4));
+    p = oc_f32x4_add(oc_f32x4_mul(p, m), oc_f32x4_splat(OC_FAST_LOG_5));
+    p = oc_f32x4_add(oc_f32x4_mul(p, m), oc_f32x4_splat(OC_FAST_LOG_6));
+    p = oc_f32x4_add(oc_f32x4_mul(p, m), oc_f32x4_splat(OC_FAST_LOG_7));
+    p = oc_f32x4_add(oc_f32x4_mul(p, m), oc_f32x4_splat(OC_FAST_LOG_8));
+
+    oc_f32x4 y = oc_f32x4_mul(oc_f32x4_mul(m, z), p);
+    y = oc_f32x4_add(y, oc_f32x4_mul(fe, oc_f32x4_splat(OC_FAST_LN2_2)));
+    y = oc_f32x4_sub(y, oc_f32x4_mul(oc_f32x4_splat(0.5f), z));
+    oc_f32x4 res = oc_f32x4_add(m, y);
+    res = oc_f32x4_add(res, oc_f32x4_mul(fe, oc_f32x4_splat(OC_FAST_LN2_1)));
+
+    return (oc_f32x4_select(oc_f32x4_lt(x, oc_f32x4_splat(OC_FAST_MIN_NORMAL)), oc_f32x4_splat(-INFINITY), res));
+}
+
+#endif // OC_F32X4_SIMD
+
+//-----------------------------------------------------------------
+// array functions
+//-----------------------------------------------------------------
+
+void oc_fast_sinf_array(u64 count, f32* src, f32* dst)
+{
+    u64 i = 0;
+#if OC_F32X4_SIMD
+    for(; i + 4 <= count; i += 4)
+    {
+        oc_f32x4_store(dst + i, oc_fast_sincos_f32x4(oc_f32x4_load(src + i), 0));
+    }
+#endif
+    for(; i < count; i++)
+    {
+        dst[i] = oc_fast_sinf(src[i]);
+    }
+}
+
+void oc_fast_cosf_array(u64 count, f32* src, f32* dst)
+{
+    u64 i = 0;
+#if OC_F32X4_SIMD
+    for(; i + 4 <= count; i += 4)
+    {
+        oc_f32x4_store(dst + i, oc_fast_sincos_f32x4(oc_f32x4_load(src + i), 1));
+    }
+#endif
+    for(; i < count; i++)
+    {
+        dst[i] = oc_fast_cosf(src[i]);
+    }
+}
+
+void oc_fast_expf_array(u64 count, f32* src, f32* dst)
+{
+    u64 i = 0;
+#if OC_F32X4_SIMD
+    for(; i + 4 <= count; i += 4)
+    {
+        oc_f32x4_store(dst + i, oc_fast_expf_f32x4(oc_f32x4_load(src + i)));
+    }
+#endif
+    for(; i < count; i++)
+    {
+        dst[i] = oc_fast_expf(src[i]);
+    }
+}
+
+void oc_fast_logf_array(u64 count, f32* src, f32* dst)
+{
+    u64 i = 0;
+#if OC_F32X4_SIMD
+    for(; i + 4 <= count; i += 4)
+    {
+        oc_f32x4_store(dst + i, oc_fast_logf_f32x4(oc_f32x4_load(src + i)));
+    }
+#endif
+    for(; i < count; i++)
+    {
+        dst[i] = oc_fast_logf(src[i]);
+    }
+}
+
+void oc_fast_powf_array(u64 count, f32* src, f32 y, f32* dst)
+{
+    if(y == 0)
+    {
+        for(u64 i = 0; i < count; i++)
+        {
+            dst[i] = 1;
+        }
+        return;
+    }
+
+    u64 i = 0;
+#if OC_F32X4_SIMD
+    oc_f32x4 exponent = oc_f32x4_splat(y);
+    for(; i + 4 <= count; i += 4)
+    {
+        oc_f32x4 logs = oc_fast_logf_f32x4(oc_f32x4_load(src + i));
+        oc_f32x4_store(dst + i, oc_fast_expf_f32x4(oc_f32x4_mul(exponent, logs)));
+    }
+#endif
+    for(; i < count; i++)
+    {
+        dst[i] = oc_fast_powf(src[i], y);
+    }
+}
+
+void oc_fast_sqrtf_array(u64 count, f32* src, f32* dst)
+{
+    u64 i = 0;
+#if OC_F32X4_SIMD
+    for(; i + 4 <= count; i += 4)
+    {
+        oc_f32x4_store(dst + i, oc_f32x4_sqrt(oc_f32x4_load(src + i)));
+    }
+#endif
+    for(; i < count; i++)
+    {
+        dst[i] = oc_fast_sqrtf(src[i]);
+    }
+}
@@ -0,0 +1,54 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "platform/platform.h"
+#include "typedefs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*NOTE:
+	Fast approximations of common libm functions, for code that evaluates them in hot loops, e.g. simulations,
+	animation curves or color conversions. They trade the exact rounding and the special cases of orca-libc's math
+	functions for straight-line code, and the array versions process 4 elements at a time with SIMD instructions when
+	they're available (SIMD128 in apps built with -msimd128, SSE2 or NEON on the host). Destination arrays can be the
+	same as source arrays.
+
+	Error bounds, measured against double precision results:
+	- oc_fast_sinf(), oc_fast_cosf(): absolute error below 1e-7 for |x| <= 1e4, and below 1e-6 for |x| <= 1e5. The
+	  error grows with |x| beyond that, and results are unspecified for |x| > 2^22.
+	- oc_fast_expf(): relative error below 3.5e-7. Returns 0 for x < -87.33654 instead of a subnormal result, and
+	  infinity for x > 88.72283.
+	- oc_fast_logf(): absolute error below 5e-7 for 1e-3 <= x < 10, and relative error below 1e-7 for other normal
+	  inputs. Returns -infinity for 0 and subnormal inputs. Negative inputs also return -infinity instead of NaN.
+	- oc_fast_powf(): computed as exp(y * log(x)), so the relative error is about 1.5e-7 * (1 + |y * log(x)|).
+	  x must be positive or zero. powf(x, 0) returns 1, and powf(0, y) returns 0 for y > 0 and infinity for y < 0.
+	- oc_fast_sqrtf(): correctly rounded. It uses the hardware instruction, whereas orca-libc's sqrtf() is a software
+	  implementation when the compiler doesn't inline it.
+
+	Results for infinite or NaN inputs are unspecified, except for oc_fast_sqrtf().
+*/
+ORCA_API f32 oc_fast_sinf(f32 x);
+ORCA_API f32 oc_fast_cosf(f32 x);
+ORCA_API f32 oc_fast_expf(f32 x);
+ORCA_API f32 oc_fast_logf(f32 x);
+ORCA_API f32 oc_fast_powf(f32 x, f32 y);
+ORCA_API f32 oc_fast_sqrtf(f32 x);
+
+ORCA_API void oc_fast_sinf_array(u64 count, f32* src, f32* dst);
+ORCA_API void oc_fast_cosf_array(u64 count, f32* src, f32* dst);
+ORCA_API void oc_fast_expf_array(u64 count, f32* src, f32* dst);
+ORCA_API void oc_fast_logf_array(u64 count, f32* src, f32* dst);
+ORCA_API void oc_fast_powf_array(u64 count, f32* src, f32 y, f32* dst);
+ORCA_API void oc_fast_sqrtf_array(u64 count, f32* src, f32* dst);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
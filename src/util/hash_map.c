@@ -0,0 +1,304 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <stdlib.h> // malloc, free
+#include <string.h>
+#include "hash_map.h"
+#include "macros.h"
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+//NOTE: control bytes are either the low 7 bits of the hash of a full slot, or one of these markers. Markers have their
+//      high bit set, so that a group can be tested for full slots without looking at each byte.
+enum
+{
+    OC_HASH_MAP_EMPTY = 0x80,
+    OC_HASH_MAP_DELETED = 0xfe,
+    OC_HASH_MAP_GROUP_WIDTH = 8,
+    OC_HASH_MAP_MIN_CAPACITY = 16,
+};
+
+static const u64 OC_HASH_MAP_LSBS = 0x0101010101010101ULL;
+static const u64 OC_HASH_MAP_MSBS = 0x8080808080808080ULL;
+
+static u64 oc_hash_map_mix(u64 key)
+{
+    //NOTE: keys are often indices or handles, so mix their bits before using them as hashes (splitmix64 finalizer)
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return (key);
+}
+
+static u32 oc_hash_map_lowest_byte(u64 mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return (index >> 3);
+#else
+    return (__builtin_ctzll(mask) >> 3);
+#endif
+}
+
+static u64 oc_hash_map_load_group(oc_hash_map* map, u64 pos)
+{
+    u64 group;
+    memcpy(&group, map->ctrl + pos, sizeof(u64));
+    return (group);
+}
+
+//NOTE: these return a mask with the high bit set in each matching byte. The h2 match can have false positives in the
+//      byte following a true match, which is fine since keys are compared afterwards.
+static u64 oc_hash_map_match_h2(u64 group, u8 h2)
+{
+    u64 x = group ^ (OC_HASH_MAP_LSBS * h2);
+    return ((x - OC_HASH_MAP_LSBS) & ~x & OC_HASH_MAP_MSBS);
+}
+
+static u64 oc_hash_map_match_empty(u64 group)
+{
+    return (group & ~(group << 6) & OC_HASH_MAP_MSBS);
+}
+
+static u64 oc_hash_map_match_free(u64 group)
+{
+    return (group & OC_HASH_MAP_MSBS);
+}
+
+static u64* oc_hash_map_slot_key(oc_hash_map* map, u64 index)
+{
+    return ((u64*)(map->slots + index * map->slotSize));
+}
+
+static void* oc_hash_map_slot_value(oc_hash_map* map, u64 index)
+{
+    return (map->slots + index * map->slotSize + sizeof(u64));
+}
+
+static u64 oc_hash_map_max_load(u64 capacity)
+{
+    //NOTE: 7/8 maximum load factor
+    return (capacity - capacity / 8);
+}
+
+static void oc_hash_map_alloc_table(oc_hash_map* map, u64 capacity)
+{
+    u64 ctrlSize = oc_align_up_pow2(capacity, 8);
+    u64 size = ctrlSize + capacity * map->slotSize;
+
+    char* mem = map->arena ? oc_arena_push_aligned(map->arena, size, 8) : malloc(size);
+    OC_ASSERT(mem, "couldn't allocate hash map table");
+
+    map->ctrl = (u8*)mem;
+    map->slots = mem + ctrlSize;
+    map->capacity = capacity;
+    map->count = 0;
+    map->growthLeft = oc_hash_map_max_load(capacity);
+    memset(map->ctrl, OC_HASH_MAP_EMPTY, capacity);
+}
+
+void oc_hash_map_init(oc_hash_map* map, u32 valueSize)
+{
+    oc_hash_map_init_with_options(map, valueSize, &(oc_hash_map_options){ 0 });
+}
+
+void oc_hash_map_init_with_options(oc_hash_map* map, u32 valueSize, oc_hash_map_options* options)
+{
+    memset(map, 0, sizeof(oc_hash_map));
+    map->arena = options->arena;
+    map->valueSize = valueSize;
+    map->slotSize = sizeof(u64) + oc_align_up_pow2(valueSize, 8);
+
+    //NOTE: size the table so that the expected number of entries fits under the maximum load
+    u64 capacity = OC_HASH_MAP_MIN_CAPACITY;
+    while(oc_hash_map_max_load(capacity) < options->capacity)
+    {
+        capacity *= 2;
+    }
+    oc_hash_map_alloc_table(map, capacity);
+}
+
+void oc_hash_map_cleanup(oc_hash_map* map)
+{
+    if(!map->arena)
+    {
+        free(map->ctrl);
+    }
+    memset(map, 0, sizeof(oc_hash_map));
+}
+
+void oc_hash_map_clear(oc_hash_map* map)
+{
+    memset(map->ctrl, OC_HASH_MAP_EMPTY, map->capacity);
+    map->count = 0;
+    map->growthLeft = oc_hash_map_max_load(map->capacity);
+}
+
+//NOTE: groups are probed in triangular order, which visits every group once when the group count is a power of two
+static u64 oc_hash_map_find_index(oc_hash_map* map, u64 key, u64 hash)
+{
+    u64 groupMask = map->capacity / OC_HASH_MAP_GROUP_WIDTH - 1;
+    u64 group = (hash >> 7) & groupMask;
+    u8 h2 = hash & 0x7f;
+
+    for(u64 step = 1; step <= groupMask + 1; step++)
+    {
+        u64 pos = group * OC_HASH_MAP_GROUP_WIDTH;
+        u64 ctrl = oc_hash_map_load_group(map, pos);
+
+        for(u64 match = oc_hash_map_match_h2(ctrl, h2); match; match &= match - 1)
+        {
+            u64 index = pos + oc_hash_map_lowest_byte(match);
+            if(map->ctrl[index] == h2 && *oc_hash_map_slot_key(map, index) == key)
+            {
+                return (index);
+            }
+        }
+        if(oc_hash_map_match_empty(ctrl))
+        {
+            break;
+        }
+        group = (group + step) & groupMask;
+    }
+    return (map->capacity);
+}
+
+static u64 oc_hash_map_find_free(oc_hash_map* map, u64 hash)
+{
+    u64 groupMask = map->capacity / OC_HASH_MAP_GROUP_WIDTH - 1;
+    u64 group = (hash >> 7) & groupMask;
+
+    for(u64 step = 1;; step++)
+    {
+        u64 pos = group * OC_HASH_MAP_GROUP_WIDTH;
+        u64 match = oc_hash_map_match_free(oc_hash_map_load_group(map, pos));
+        if(match)
+        {
+            return (pos + oc_hash_map_lowest_byte(match));
+        }
+        group = (group + step) & groupMask;
+    }
+}
+
+static void oc_hash_map_rehash(oc_hash_map* map, u64 capacity)
+{
+    oc_hash_map old = *map;
+    oc_hash_map_alloc_table(map, capacity);
+
+    for(u64 i = 0; i < old.capacity; i++)
+    {
+        if(!(old.ctrl[i] & 0x80))
+        {
+            u64 key = *oc_hash_map_slot_key(&old, i);
+            u64 hash = oc_hash_map_mix(key);
+            u64 index = oc_hash_map_find_free(map, hash);
+
+            map->ctrl[index] = hash & 0x7f;
+            memcpy(oc_hash_map_slot_key(map, index), oc_hash_map_slot_key(&old, i), map->slotSize);
+        }
+    }
+    map->count = old.count;
+    map->growthLeft -= old.count;
+
+    if(!map->arena)
+    {
+        free(old.ctrl);
+    }
+}
+
+void* oc_hash_map_find(oc_hash_map* map, u64 key)
+{
+    u64 index = oc_hash_map_find_index(map, key, oc_hash_map_mix(key));
+    return ((index < map->capacity) ? oc_hash_map_slot_value(map, index) : 0);
+}
+
+void* oc_hash_map_insert(oc_hash_map* map, u64 key, bool* inserted)
+{
+    u64 hash = oc_hash_map_mix(key);
+    u64 index = oc_hash_map_find_index(map, key, hash);
+    if(index < map->capacity)
+    {
+        if(inserted)
+        {
+            *inserted = false;
+        }
+        return (oc_hash_map_slot_value(map, index));
+    }
+
+    index = oc_hash_map_find_free(map, hash);
+    if(map->ctrl[index] == OC_HASH_MAP_EMPTY && map->growthLeft == 0)
+    {
+        //NOTE: grow if the table is mostly full of live entries, otherwise rehash in place to purge deleted slots
+        u64 capacity = (map->count >= map->capacity / 2) ? map->capacity * 2 : map->capacity;
+        oc_hash_map_rehash(map, capacity);
+        index = oc_hash_map_find_free(map, hash);
+    }
+
+    if(map->ctrl[index] == OC_HASH_MAP_EMPTY)
+    {
+        map->growthLeft--;
+    }
+    map->ctrl[index] = hash & 0x7f;
+    map->count++;
+
+    *oc_hash_map_slot_key(map, index) = key;
+    void* value = oc_hash_map_slot_value(map, index);
+    memset(value, 0, map->valueSize);
+
+    if(inserted)
+    {
+        *inserted = true;
+    }
+    return (value);
+}
+
+bool oc_hash_map_remove(oc_hash_map* map, u64 key)
+{
+    u64 index = oc_hash_map_find_index(map, key, oc_hash_map_mix(key));
+    if(index >= map->capacity)
+    {
+        return (false);
+    }
+
+    //NOTE: if the slot's group still has an empty slot, no probe sequence went past it, so the slot can be made empty
+    //      again instead of leaving a tombstone.
+    u64 pos = index & ~(u64)(OC_HASH_MAP_GROUP_WIDTH - 1);
+    if(oc_hash_map_match_empty(oc_hash_map_load_group(map, pos)))
+    {
+        map->ctrl[index] = OC_HASH_MAP_EMPTY;
+        map->growthLeft++;
+    }
+    else
+    {
+        map->ctrl[index] = OC_HASH_MAP_DELETED;
+    }
+    map->count--;
+    return (true);
+}
+
+void* oc_hash_map_next(oc_hash_map* map, u64* index, u64* key)
+{
+    for(; *index < map->capacity; (*index)++)
+    {
+        if(!(map->ctrl[*index] & 0x80))
+        {
+            u64 slot = *index;
+            (*index)++;
+            if(key)
+            {
+                *key = *oc_hash_map_slot_key(map, slot);
+            }
+            return (oc_hash_map_slot_value(map, slot));
+        }
+    }
+    return (0);
+}
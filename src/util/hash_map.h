@@ -0,0 +1,65 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "memory.h"
+#include "typedefs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------------------------------
+//NOTE: open-addressing hash map with u64 keys
+//--------------------------------------------------------------------------------
+/*NOTE:
+	Values are fixed-size and stored inline next to their key. Each slot also has a control byte holding either
+	7 bits of the key's hash or an empty/deleted marker. Lookups scan groups of 8 control bytes at once, and only
+	compare keys of slots whose hash bits match.
+
+	Pointers returned by oc_hash_map_find() and oc_hash_map_insert() are invalidated by the next insertion, which
+	can grow the table. When the map has an arena, tables are allocated from it and old tables are left there when
+	the map grows. Otherwise they are allocated with malloc() and freed by oc_hash_map_cleanup().
+*/
+
+typedef struct oc_hash_map
+{
+    oc_arena* arena;
+    u8* ctrl;
+    char* slots;
+    u32 valueSize;
+    u32 slotSize;
+    u64 capacity; // number of slots, a power of two
+    u64 count;
+    u64 growthLeft; // insertions into empty slots before the table must be rehashed
+} oc_hash_map;
+
+typedef struct oc_hash_map_options
+{
+    oc_arena* arena;
+    u64 capacity; // expected number of entries
+} oc_hash_map_options;
+
+ORCA_API void oc_hash_map_init(oc_hash_map* map, u32 valueSize);
+ORCA_API void oc_hash_map_init_with_options(oc_hash_map* map, u32 valueSize, oc_hash_map_options* options);
+ORCA_API void oc_hash_map_cleanup(oc_hash_map* map);
+ORCA_API void oc_hash_map_clear(oc_hash_map* map);
+
+ORCA_API void* oc_hash_map_find(oc_hash_map* map, u64 key);
+ORCA_API void* oc_hash_map_insert(oc_hash_map* map, u64 key, bool* inserted); // returns the value of key, adding a zeroed one if needed
+ORCA_API bool oc_hash_map_remove(oc_hash_map* map, u64 key);
+
+//NOTE: iterates over the entries, in no particular order. Start with *index = 0, returns 0 once all entries were visited.
+ORCA_API void* oc_hash_map_next(oc_hash_map* map, u64* index, u64* key);
+
+#define oc_hash_map_find_type(map, key, type) ((type*)oc_hash_map_find(map, key))
+#define oc_hash_map_insert_type(map, key, type, inserted) ((type*)oc_hash_map_insert(map, key, inserted))
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -25,6 +25,7 @@ enum
 enum
 {
     OC_ARENA_COMMIT_ALIGNMENT = 4 << 10,
+    OC_ARENA_LARGE_PAGES_MIN_RESERVE = 64 << 20,
 };
 
 //--------------------------------------------------------------------------------
@@ -37,7 +38,10 @@ oc_arena_chunk* oc_arena_chunk_alloc(oc_arena* arena, u64 chunkMinSize)
     u64 commitSize = oc_align_up_pow2(sizeof(oc_arena_chunk), OC_ARENA_COMMIT_ALIGNMENT);
 
     char* mem = oc_base_reserve(arena->base, reserveSize);
-    oc_base_commit(arena->base, mem, commitSize);
+    if(!mem || !oc_base_commit(arena->base, mem, commitSize))
+    {
+        OC_ABORT("Out of memory: couldn't allocate an arena chunk of %llu bytes", (unsigned long long)reserveSize);
+    }
 
     oc_arena_chunk* chunk = (oc_arena_chunk*)mem;
 
@@ -48,6 +52,11 @@ oc_arena_chunk* oc_arena_chunk_alloc(oc_arena* arena, u64 chunkMinSize)
 
     oc_list_push_back(&arena->chunks, &chunk->listElt);
 
+    arena->stats.chunkCount++;
+    arena->stats.chunkAllocs++;
+    arena->stats.reserved += reserveSize;
+    arena->stats.committed += commitSize;
+
     return (chunk);
 }
 
@@ -60,10 +69,23 @@ void oc_arena_init_with_options(oc_arena* arena, oc_arena_options* options)
 {
     memset(arena, 0, sizeof(oc_arena));
 
-    arena->base = options->base ? options->base : oc_base_allocator_default();
+    arena->retain = options->retain;
 
     u64 reserveSize = options->reserve ? (options->reserve + sizeof(oc_arena_chunk)) : OC_ARENA_DEFAULT_RESERVE_SIZE;
 
+    if(options->base)
+    {
+        arena->base = options->base;
+    }
+    else if(options->largePages && reserveSize >= OC_ARENA_LARGE_PAGES_MIN_RESERVE)
+    {
+        arena->base = oc_base_allocator_large_pages();
+    }
+    else
+    {
+        arena->base = oc_base_allocator_default();
+    }
+
     arena->currentChunk = oc_arena_chunk_alloc(arena, reserveSize);
 }
 
@@ -118,6 +140,28 @@ void* oc_arena_push_aligned(oc_arena* arena, u64 size, u32 alignment)
     }
     OC_ASSERT(nextOffset <= chunk->cap);
 
+    //NOTE: the end of the chunks we skipped counts as used until the next clear
+    if(chunk == arena->currentChunk)
+    {
+        arena->stats.used += nextOffset - chunk->offset;
+    }
+    else
+    {
+        arena->stats.used += arena->currentChunk->cap - arena->currentChunk->offset
+                           + nextOffset - sizeof(oc_arena_chunk);
+        for(oc_arena_chunk* skipped = oc_list_next_entry(arena->currentChunk, oc_arena_chunk, listElt);
+            skipped && skipped != chunk;
+            skipped = oc_list_next_entry(skipped, oc_arena_chunk, listElt))
+        {
+            arena->stats.used += skipped->cap - skipped->offset;
+            skipped->offset = skipped->cap;
+        }
+        arena->currentChunk->offset = arena->currentChunk->cap;
+    }
+    arena->stats.peak = oc_max(arena->stats.peak, arena->stats.used);
+    arena->stats.pushed += size;
+    arena->stats.pushCount++;
+
     arena->currentChunk = chunk;
 
     if(nextOffset > chunk->committed)
@@ -125,8 +169,12 @@ void* oc_arena_push_aligned(oc_arena* arena, u64 size, u32 alignment)
         u64 nextCommitted = oc_align_up_pow2(nextOffset, OC_ARENA_COMMIT_ALIGNMENT);
         nextCommitted = oc_clamp_high(nextCommitted, chunk->cap);
         u64 commitSize = nextCommitted - chunk->committed;
-        oc_base_commit(arena->base, chunk->ptr + chunk->committed, commitSize);
+        if(!oc_base_commit(arena->base, chunk->ptr + chunk->committed, commitSize))
+        {
+            OC_ABORT("Out of memory: couldn't commit %llu bytes in arena chunk", (unsigned long long)commitSize);
+        }
         chunk->committed = nextCommitted;
+        arena->stats.committed += commitSize;
     }
     char* p = chunk->ptr + alignedOffset;
     chunk->offset = nextOffset;
@@ -134,6 +182,26 @@ void* oc_arena_push_aligned(oc_arena* arena, u64 size, u32 alignment)
     return (p);
 }
 
+static void oc_arena_trim(oc_arena* arena)
+{
+    //NOTE: chunks are kept reserved, since the wasm base allocator can't release memory, but their pages past the first
+    //      'retain' bytes of the arena are decommitted. Each chunk keeps the page holding its header.
+    u64 retained = 0;
+    oc_list_for(arena->chunks, chunk, oc_arena_chunk, listElt)
+    {
+        u64 keep = (retained < arena->retain) ? (arena->retain - retained) : 0;
+        keep = oc_align_up_pow2(oc_max(keep, sizeof(oc_arena_chunk)), OC_ARENA_COMMIT_ALIGNMENT);
+
+        if(chunk->committed > keep)
+        {
+            oc_base_decommit(arena->base, chunk->ptr + keep, chunk->committed - keep);
+            arena->stats.committed -= chunk->committed - keep;
+            chunk->committed = keep;
+        }
+        retained += chunk->committed;
+    }
+}
+
 void oc_arena_clear(oc_arena* arena)
 {
     oc_list_for(arena->chunks, chunk, oc_arena_chunk, listElt)
@@ -141,6 +209,12 @@ void oc_arena_clear(oc_arena* arena)
         chunk->offset = sizeof(oc_arena_chunk);
     }
     arena->currentChunk = oc_list_first_entry(arena->chunks, oc_arena_chunk, listElt);
+    arena->stats.used = 0;
+
+    if(arena->retain && arena->stats.committed > arena->retain)
+    {
+        oc_arena_trim(arena);
+    }
 }
 
 oc_arena_scope oc_arena_scope_begin(oc_arena* arena)
@@ -153,16 +227,33 @@ oc_arena_scope oc_arena_scope_begin(oc_arena* arena)
 
 void oc_arena_scope_end(oc_arena_scope scope)
 {
+    oc_arena_stats* stats = &scope.arena->stats;
     for(oc_arena_chunk* chunk = scope.arena->currentChunk;
         chunk != 0 && chunk != scope.chunk;
         chunk = oc_list_prev_entry(chunk, oc_arena_chunk, listElt))
     {
+        stats->used -= chunk->offset - sizeof(oc_arena_chunk);
         chunk->offset = sizeof(oc_arena_chunk);
     }
+    //NOTE: chunks skipped at the end of the scope's chunk were filled up to their capacity
+    stats->used -= scope.chunk->offset - scope.offset;
+
     scope.arena->currentChunk = scope.chunk;
     scope.arena->currentChunk->offset = scope.offset;
 }
 
+oc_arena_stats oc_arena_get_stats(oc_arena* arena)
+{
+    return (arena->stats);
+}
+
+void oc_arena_stats_reset(oc_arena* arena)
+{
+    arena->stats.peak = arena->stats.used;
+    arena->stats.pushed = 0;
+    arena->stats.pushCount = 0;
+}
+
 //--------------------------------------------------------------------------------
 //NOTE(martin): memory pool
 //--------------------------------------------------------------------------------
@@ -28,12 +28,31 @@ typedef struct oc_arena_chunk
     u64 cap;
 } oc_arena_chunk;
 
+//NOTE: usage counters of an arena. 'used' counts the bytes pushed since the last clear, including alignment padding
+//      and the bytes skipped at the end of a chunk that couldn't fit a push. 'peak', 'pushed' and 'pushCount' cover the
+//      lifetime of the arena, or the time since the last call to oc_arena_stats_reset().
+typedef struct oc_arena_stats
+{
+    u64 used;
+    u64 peak;
+    u64 pushed;
+    u64 pushCount;
+
+    u64 chunkCount;
+    u64 chunkAllocs; // chunks reserved since init. If this keeps growing, the arena reserves and commits fresh memory.
+    u64 reserved;
+    u64 committed;
+} oc_arena_stats;
+
 typedef struct oc_arena
 {
     oc_base_allocator* base;
     oc_list chunks;
     oc_arena_chunk* currentChunk;
 
+    u64 retain;
+    oc_arena_stats stats;
+
 } oc_arena;
 
 typedef struct oc_arena_scope
@@ -47,6 +66,16 @@ typedef struct oc_arena_options
 {
     oc_base_allocator* base;
     u64 reserve;
+
+    //NOTE: chunks stay reserved and committed across clears, and are reused by later pushes. If retain is not 0,
+    //      oc_arena_clear() decommits the memory committed past the first 'retain' bytes, so that a spike doesn't
+    //      keep physical memory around forever.
+    u64 retain;
+
+    //NOTE: if set, arenas that reserve at least 64MB are backed by large pages
+    //      (see oc_base_allocator_large_pages()). Smaller arenas ignore it, since they commit memory in large page
+    //      increments. Ignored if base is set.
+    bool largePages;
 } oc_arena_options;
 
 ORCA_API void oc_arena_init(oc_arena* arena);
@@ -60,6 +89,9 @@ ORCA_API void oc_arena_clear(oc_arena* arena);
 ORCA_API oc_arena_scope oc_arena_scope_begin(oc_arena* arena);
 ORCA_API void oc_arena_scope_end(oc_arena_scope scope);
 
+ORCA_API oc_arena_stats oc_arena_get_stats(oc_arena* arena);
+ORCA_API void oc_arena_stats_reset(oc_arena* arena);
+
 #define oc_arena_push_type(arena, type) ((type*)oc_arena_push_aligned(arena, sizeof(type), _Alignof(type)))
 #define oc_arena_push_array(arena, type, count) ((type*)oc_arena_push_aligned(arena, sizeof(type) * (count), _Alignof(type)))
 
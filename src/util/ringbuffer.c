@@ -35,7 +35,7 @@ u64 oc_ringbuffer_write_available(oc_ringbuffer* ring)
     return (((ring->readIndex - ring->reserveIndex) & ring->mask) - 1);
 }
 
-u64 oc_ringbuffer_read(oc_ringbuffer* ring, u64 size, u8* data)
+u64 oc_ringbuffer_peek(oc_ringbuffer* ring, u64 size, u8* data)
 {
     u64 read = ring->readIndex;
     u64 write = ring->writeIndex;
@@ -59,7 +59,13 @@ u64 oc_ringbuffer_read(oc_ringbuffer* ring, u64 size, u8* data)
         copyCount = size - copyCount;
         memcpy(data, ring->buffer, copyCount);
     }
-    ring->readIndex = (read + size) & ring->mask;
+    return (size);
+}
+
+u64 oc_ringbuffer_read(oc_ringbuffer* ring, u64 size, u8* data)
+{
+    size = oc_ringbuffer_peek(ring, size, data);
+    ring->readIndex = (ring->readIndex + size) & ring->mask;
     return (size);
 }
 
@@ -109,3 +115,201 @@ void oc_ringbuffer_rewind(oc_ringbuffer* ring)
 {
     ring->reserveIndex = ring->writeIndex;
 }
+
+#if !defined(OC_PLATFORM_ORCA) || !OC_PLATFORM_ORCA
+
+#include "platform/platform_clock.h"
+
+//--------------------------------------------------------------------------------
+// multi-producer, single-consumer ringbuffer
+//--------------------------------------------------------------------------------
+/*NOTE:
+	Record headers hold the payload size and two flags. The consumer zeroes records as it releases them, so a header
+	slot that a producer has reserved but not committed yet always reads as zero, and stale bytes from a previous
+	lap are never taken for a header.
+*/
+enum
+{
+    OC_MPSC_HEADER_SIZE = sizeof(u64),
+};
+
+static const u64 OC_MPSC_COMMITTED = 1ULL << 63;
+static const u64 OC_MPSC_PADDING = 1ULL << 62;
+static const u64 OC_MPSC_SIZE_MASK = (1ULL << 62) - 1;
+
+static _Atomic(u64)* oc_mpsc_ringbuffer_header(oc_mpsc_ringbuffer* ring, u64 index)
+{
+    return ((_Atomic(u64)*)(ring->buffer + (index & ring->mask)));
+}
+
+static u64 oc_mpsc_ringbuffer_record_size(u64 size)
+{
+    return (OC_MPSC_HEADER_SIZE + oc_align_up_pow2(size, 8));
+}
+
+void oc_mpsc_ringbuffer_init(oc_mpsc_ringbuffer* ring, u8 capExp)
+{
+    u64 cap = 1ULL << oc_max(capExp, 4);
+    ring->mask = cap - 1;
+    atomic_init(&ring->reserveIndex, 0);
+    atomic_init(&ring->readIndex, 0);
+    ring->buffer = (u8*)calloc(cap, 1);
+
+    ring->mutex = oc_mutex_create();
+    ring->cond = oc_condition_create();
+    atomic_init(&ring->waiting, 0);
+}
+
+void oc_mpsc_ringbuffer_cleanup(oc_mpsc_ringbuffer* ring)
+{
+    oc_condition_destroy(ring->cond);
+    oc_mutex_destroy(ring->mutex);
+    free(ring->buffer);
+}
+
+void* oc_mpsc_ringbuffer_reserve(oc_mpsc_ringbuffer* ring, u64 size)
+{
+    u64 cap = ring->mask + 1;
+    u64 recordSize = oc_mpsc_ringbuffer_record_size(size);
+    if(recordSize > cap)
+    {
+        return (0);
+    }
+
+    u64 reserve = atomic_load_explicit(&ring->reserveIndex, memory_order_relaxed);
+    u64 padding = 0;
+    do
+    {
+        //NOTE: records are contiguous, so skip the end of the buffer if the record doesn't fit there
+        u64 offset = reserve & ring->mask;
+        padding = (offset + recordSize > cap) ? cap - offset : 0;
+
+        u64 read = atomic_load_explicit(&ring->readIndex, memory_order_acquire);
+        if(reserve + padding + recordSize - read > cap)
+        {
+            return (0);
+        }
+    }
+    while(!atomic_compare_exchange_weak_explicit(&ring->reserveIndex,
+                                                 &reserve,
+                                                 reserve + padding + recordSize,
+                                                 memory_order_relaxed,
+                                                 memory_order_relaxed));
+
+    if(padding)
+    {
+        atomic_store_explicit(oc_mpsc_ringbuffer_header(ring, reserve),
+                              (padding - OC_MPSC_HEADER_SIZE) | OC_MPSC_PADDING | OC_MPSC_COMMITTED,
+                              memory_order_release);
+        reserve += padding;
+    }
+    _Atomic(u64)* header = oc_mpsc_ringbuffer_header(ring, reserve);
+    atomic_store_explicit(header, size, memory_order_relaxed);
+    return ((u8*)header + OC_MPSC_HEADER_SIZE);
+}
+
+void oc_mpsc_ringbuffer_commit(oc_mpsc_ringbuffer* ring, void* record)
+{
+    _Atomic(u64)* header = (_Atomic(u64)*)((u8*)record - OC_MPSC_HEADER_SIZE);
+    atomic_fetch_or(header, OC_MPSC_COMMITTED);
+
+    //NOTE: the consumer's check for records is an acquire load, which can be ordered before its store to waiting
+    //      on some architectures, e.g. with ldapr on ARM. The fences here and in oc_mpsc_ringbuffer_wait() order
+    //      each side's store before its load, so either we see the consumer waiting or it sees our record.
+    atomic_thread_fence(memory_order_seq_cst);
+    if(atomic_load(&ring->waiting))
+    {
+        oc_mutex_lock(ring->mutex);
+        oc_condition_signal(ring->cond);
+        oc_mutex_unlock(ring->mutex);
+    }
+}
+
+u64 oc_mpsc_ringbuffer_write(oc_mpsc_ringbuffer* ring, u64 size, u8* data)
+{
+    void* record = oc_mpsc_ringbuffer_reserve(ring, size);
+    if(!record)
+    {
+        return (0);
+    }
+    memcpy(record, data, size);
+    oc_mpsc_ringbuffer_commit(ring, record);
+    return (size);
+}
+
+void* oc_mpsc_ringbuffer_peek(oc_mpsc_ringbuffer* ring, u64* size)
+{
+    while(1)
+    {
+        u64 read = atomic_load_explicit(&ring->readIndex, memory_order_relaxed);
+        _Atomic(u64)* header = oc_mpsc_ringbuffer_header(ring, read);
+        u64 value = atomic_load_explicit(header, memory_order_acquire);
+
+        if(!(value & OC_MPSC_COMMITTED))
+        {
+            return (0);
+        }
+        else if(value & OC_MPSC_PADDING)
+        {
+            oc_mpsc_ringbuffer_release(ring);
+        }
+        else
+        {
+            if(size)
+            {
+                *size = value & OC_MPSC_SIZE_MASK;
+            }
+            return ((u8*)header + OC_MPSC_HEADER_SIZE);
+        }
+    }
+}
+
+void oc_mpsc_ringbuffer_release(oc_mpsc_ringbuffer* ring)
+{
+    u64 read = atomic_load_explicit(&ring->readIndex, memory_order_relaxed);
+    _Atomic(u64)* header = oc_mpsc_ringbuffer_header(ring, read);
+    u64 value = atomic_load_explicit(header, memory_order_relaxed);
+    OC_DEBUG_ASSERT(value & OC_MPSC_COMMITTED, "releasing a record that isn't committed");
+
+    u64 recordSize = oc_mpsc_ringbuffer_record_size(value & OC_MPSC_SIZE_MASK);
+    memset((u8*)header, 0, recordSize);
+    atomic_store_explicit(&ring->readIndex, read + recordSize, memory_order_release);
+}
+
+bool oc_mpsc_ringbuffer_wait(oc_mpsc_ringbuffer* ring, f64 timeout)
+{
+    if(oc_mpsc_ringbuffer_peek(ring, 0))
+    {
+        return (true);
+    }
+
+    f64 deadline = (timeout >= 0) ? oc_clock_time(OC_CLOCK_MONOTONIC) + timeout : 0;
+    bool available = false;
+
+    oc_mutex_lock(ring->mutex);
+    atomic_store(&ring->waiting, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    while(!(available = (oc_mpsc_ringbuffer_peek(ring, 0) != 0)))
+    {
+        if(timeout < 0)
+        {
+            oc_condition_wait(ring->cond, ring->mutex);
+        }
+        else
+        {
+            f64 remaining = deadline - oc_clock_time(OC_CLOCK_MONOTONIC);
+            if(remaining <= 0)
+            {
+                break;
+            }
+            oc_condition_timedwait(ring->cond, ring->mutex, remaining);
+        }
+    }
+
+    atomic_store(&ring->waiting, 0);
+    oc_mutex_unlock(ring->mutex);
+    return (available);
+}
+
+#endif // !OC_PLATFORM_ORCA
@@ -9,8 +9,13 @@
 
 #include <stdatomic.h>
 
+#include "platform/platform.h"
 #include "typedefs.h"
 
+#if !defined(OC_PLATFORM_ORCA) || !OC_PLATFORM_ORCA
+    #include "platform/platform_thread.h"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -31,11 +36,57 @@ void oc_ringbuffer_cleanup(oc_ringbuffer* ring);
 u64 oc_ringbuffer_read_available(oc_ringbuffer* ring);
 u64 oc_ringbuffer_write_available(oc_ringbuffer* ring);
 u64 oc_ringbuffer_read(oc_ringbuffer* ring, u64 size, u8* data);
+u64 oc_ringbuffer_peek(oc_ringbuffer* ring, u64 size, u8* data);
 u64 oc_ringbuffer_write(oc_ringbuffer* ring, u64 size, u8* data);
 u64 oc_ringbuffer_reserve(oc_ringbuffer* ring, u64 size, u8* data);
 void oc_ringbuffer_commit(oc_ringbuffer* ring);
 void oc_ringbuffer_rewind(oc_ringbuffer* ring);
 
+#if !defined(OC_PLATFORM_ORCA) || !OC_PLATFORM_ORCA
+
+//--------------------------------------------------------------------------------
+//NOTE: multi-producer, single-consumer ringbuffer
+//--------------------------------------------------------------------------------
+/*NOTE:
+	oc_ringbuffer can only have one writer, since reservations go through a single reserveIndex. oc_mpsc_ringbuffer
+	lets any number of threads write records concurrently, and one thread read them in reservation order.
+
+	A producer reserves a contiguous record with oc_mpsc_ringbuffer_reserve(), fills it, and publishes it with
+	oc_mpsc_ringbuffer_commit(). Reservations are a single compare-exchange, so producers don't wait on each other,
+	but the consumer stops at the oldest record that isn't committed yet. Records are 8-byte aligned and preceded by
+	an 8-byte header, and a record that doesn't fit before the end of the buffer is moved to its start.
+
+	The consumer takes records with oc_mpsc_ringbuffer_peek() and oc_mpsc_ringbuffer_release(), and can block until
+	a record is available with oc_mpsc_ringbuffer_wait(). Producers only touch the condition variable when the
+	consumer is actually waiting.
+*/
+typedef struct oc_mpsc_ringbuffer
+{
+    u64 mask;
+    _Atomic(u64) reserveIndex; // indices grow monotonically, and are masked on access
+    _Atomic(u64) readIndex;
+    u8* buffer;
+
+    oc_mutex* mutex;
+    oc_condition* cond;
+    _Atomic(u32) waiting;
+} oc_mpsc_ringbuffer;
+
+void oc_mpsc_ringbuffer_init(oc_mpsc_ringbuffer* ring, u8 capExp);
+void oc_mpsc_ringbuffer_cleanup(oc_mpsc_ringbuffer* ring);
+
+//NOTE: producer side. reserve returns 0 if there is not enough room for the record.
+void* oc_mpsc_ringbuffer_reserve(oc_mpsc_ringbuffer* ring, u64 size);
+void oc_mpsc_ringbuffer_commit(oc_mpsc_ringbuffer* ring, void* record);
+u64 oc_mpsc_ringbuffer_write(oc_mpsc_ringbuffer* ring, u64 size, u8* data); // returns size, or 0 if the record didn't fit
+
+//NOTE: consumer side. peek returns the oldest committed record, or 0 if there is none.
+void* oc_mpsc_ringbuffer_peek(oc_mpsc_ringbuffer* ring, u64* size);
+void oc_mpsc_ringbuffer_release(oc_mpsc_ringbuffer* ring);
+bool oc_mpsc_ringbuffer_wait(oc_mpsc_ringbuffer* ring, f64 timeout); // a negative timeout waits indefinitely
+
+#endif // !OC_PLATFORM_ORCA
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -0,0 +1,143 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "typedefs.h"
+
+/*NOTE:
+	Internal 4-lane float helpers, shared by the util functions that process arrays of floats. They map to SIMD128
+	in apps built with -msimd128, and to SSE2 or NEON on the host. OC_F32X4_SIMD is 0 when none is available, and
+	callers then only use their scalar code.
+
+	Masks returned by comparisons are f32x4 values with all bits of a lane set when the comparison is true, and can
+	be passed to oc_f32x4_select() or oc_f32x4_and(). Integer lanes are signed 32-bit integers.
+*/
+
+#if defined(__wasm_simd128__)
+    #include <wasm_simd128.h>
+    #define OC_F32X4_WASM 1
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    #include <emmintrin.h>
+    #define OC_F32X4_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    #include <arm_neon.h>
+    #define OC_F32X4_NEON 1
+#endif
+
+#define OC_F32X4_SIMD (OC_F32X4_WASM || OC_F32X4_SSE2 || OC_F32X4_NEON)
+
+#if OC_F32X4_WASM
+typedef v128_t oc_f32x4;
+typedef v128_t oc_i32x4;
+
+    #define oc_f32x4_load(p) wasm_v128_load(p)
+    #define oc_f32x4_store(p, v) wasm_v128_store(p, v)
+    #define oc_f32x4_set(a, b, c, d) wasm_f32x4_make(a, b, c, d)
+    #define oc_f32x4_splat(f) wasm_f32x4_splat(f)
+    #define oc_f32x4_add(a, b) wasm_f32x4_add(a, b)
+    #define oc_f32x4_sub(a, b) wasm_f32x4_sub(a, b)
+    #define oc_f32x4_mul(a, b) wasm_f32x4_mul(a, b)
+    #define oc_f32x4_min(a, b) wasm_f32x4_pmin(a, b)
+    #define oc_f32x4_max(a, b) wasm_f32x4_pmax(a, b)
+    #define oc_f32x4_sqrt(v) wasm_f32x4_sqrt(v)
+    #define oc_f32x4_lane(v, i) wasm_i32x4_shuffle(v, v, i, i, i, i)
+    #define oc_f32x4_even(v) wasm_i32x4_shuffle(v, v, 0, 0, 2, 2)
+    #define oc_f32x4_odd(v) wasm_i32x4_shuffle(v, v, 1, 1, 3, 3)
+
+    #define oc_f32x4_lt(a, b) wasm_f32x4_lt(a, b)
+    #define oc_f32x4_gt(a, b) wasm_f32x4_gt(a, b)
+    #define oc_f32x4_and(a, b) wasm_v128_and(a, b)
+    #define oc_f32x4_xor(a, b) wasm_v128_xor(a, b)
+    #define oc_f32x4_select(mask, a, b) wasm_v128_bitselect(a, b, mask)
+
+    #define oc_f32x4_as_i32x4(v) (v)
+    #define oc_i32x4_as_f32x4(v) (v)
+    #define oc_f32x4_round_i32x4(v) wasm_i32x4_trunc_sat_f32x4(wasm_f32x4_nearest(v))
+    #define oc_i32x4_to_f32x4(v) wasm_f32x4_convert_i32x4(v)
+    #define oc_i32x4_splat(i) wasm_i32x4_splat(i)
+    #define oc_i32x4_add(a, b) wasm_i32x4_add(a, b)
+    #define oc_i32x4_sub(a, b) wasm_i32x4_sub(a, b)
+    #define oc_i32x4_and(a, b) wasm_v128_and(a, b)
+    #define oc_i32x4_shl(v, n) wasm_i32x4_shl(v, n)
+    #define oc_i32x4_shr(v, n) wasm_i32x4_shr(v, n)
+
+#elif OC_F32X4_SSE2
+typedef __m128 oc_f32x4;
+typedef __m128i oc_i32x4;
+
+    #define oc_f32x4_load(p) _mm_loadu_ps(p)
+    #define oc_f32x4_store(p, v) _mm_storeu_ps(p, v)
+    #define oc_f32x4_set(a, b, c, d) _mm_setr_ps(a, b, c, d)
+    #define oc_f32x4_splat(f) _mm_set1_ps(f)
+    #define oc_f32x4_add(a, b) _mm_add_ps(a, b)
+    #define oc_f32x4_sub(a, b) _mm_sub_ps(a, b)
+    #define oc_f32x4_mul(a, b) _mm_mul_ps(a, b)
+    #define oc_f32x4_min(a, b) _mm_min_ps(a, b)
+    #define oc_f32x4_max(a, b) _mm_max_ps(a, b)
+    #define oc_f32x4_sqrt(v) _mm_sqrt_ps(v)
+    #define oc_f32x4_lane(v, i) _mm_shuffle_ps(v, v, _MM_SHUFFLE(i, i, i, i))
+    #define oc_f32x4_even(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 0, 0))
+    #define oc_f32x4_odd(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 1, 1))
+
+    #define oc_f32x4_lt(a, b) _mm_cmplt_ps(a, b)
+    #define oc_f32x4_gt(a, b) _mm_cmpgt_ps(a, b)
+    #define oc_f32x4_and(a, b) _mm_and_ps(a, b)
+    #define oc_f32x4_xor(a, b) _mm_xor_ps(a, b)
+    #define oc_f32x4_select(mask, a, b) _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b))
+
+    #define oc_f32x4_as_i32x4(v) _mm_castps_si128(v)
+    #define oc_i32x4_as_f32x4(v) _mm_castsi128_ps(v)
+    #define oc_f32x4_round_i32x4(v) _mm_cvtps_epi32(v)
+    #define oc_i32x4_to_f32x4(v) _mm_cvtepi32_ps(v)
+    #define oc_i32x4_splat(i) _mm_set1_epi32(i)
+    #define oc_i32x4_add(a, b) _mm_add_epi32(a, b)
+    #define oc_i32x4_sub(a, b) _mm_sub_epi32(a, b)
+    #define oc_i32x4_and(a, b) _mm_and_si128(a, b)
+    #define oc_i32x4_shl(v, n) _mm_slli_epi32(v, n)
+    #define oc_i32x4_shr(v, n) _mm_srai_epi32(v, n)
+
+#elif OC_F32X4_NEON
+typedef float32x4_t oc_f32x4;
+typedef int32x4_t oc_i32x4;
+
+static inline oc_f32x4 oc_f32x4_set(f32 a, f32 b, f32 c, f32 d)
+{
+    const f32 lanes[4] = { a, b, c, d };
+    return (vld1q_f32(lanes));
+}
+
+    #define oc_f32x4_load(p) vld1q_f32(p)
+    #define oc_f32x4_store(p, v) vst1q_f32(p, v)
+    #define oc_f32x4_splat(f) vdupq_n_f32(f)
+    #define oc_f32x4_add(a, b) vaddq_f32(a, b)
+    #define oc_f32x4_sub(a, b) vsubq_f32(a, b)
+    #define oc_f32x4_mul(a, b) vmulq_f32(a, b)
+    #define oc_f32x4_min(a, b) vminq_f32(a, b)
+    #define oc_f32x4_max(a, b) vmaxq_f32(a, b)
+    #define oc_f32x4_sqrt(v) vsqrtq_f32(v)
+    #define oc_f32x4_lane(v, i) vdupq_laneq_f32(v, i)
+    #define oc_f32x4_even(v) vtrn1q_f32(v, v)
+    #define oc_f32x4_odd(v) vtrn2q_f32(v, v)
+
+    #define oc_f32x4_lt(a, b) vreinterpretq_f32_u32(vcltq_f32(a, b))
+    #define oc_f32x4_gt(a, b) vreinterpretq_f32_u32(vcgtq_f32(a, b))
+    #define oc_f32x4_and(a, b) vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)))
+    #define oc_f32x4_xor(a, b) vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)))
+    #define oc_f32x4_select(mask, a, b) vbslq_f32(vreinterpretq_u32_f32(mask), a, b)
+
+    #define oc_f32x4_as_i32x4(v) vreinterpretq_s32_f32(v)
+    #define oc_i32x4_as_f32x4(v) vreinterpretq_f32_s32(v)
+    #define oc_f32x4_round_i32x4(v) vcvtnq_s32_f32(v)
+    #define oc_i32x4_to_f32x4(v) vcvtq_f32_s32(v)
+    #define oc_i32x4_splat(i) vdupq_n_s32(i)
+    #define oc_i32x4_add(a, b) vaddq_s32(a, b)
+    #define oc_i32x4_sub(a, b) vsubq_s32(a, b)
+    #define oc_i32x4_and(a, b) vandq_s32(a, b)
+    #define oc_i32x4_shl(v, n) vshlq_n_s32(v, n)
+    #define oc_i32x4_shr(v, n) vshrq_n_s32(v, n)
+#endif
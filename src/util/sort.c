@@ -0,0 +1,206 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <string.h>
+#include "sort.h"
+#include "memory.h"
+
+enum
+{
+    //NOTE: below this count, an insertion sort beats clearing and scanning the histograms
+    OC_RADIX_SORT_MIN_COUNT = 64,
+};
+
+//NOTE: generates a stable LSD radix sort on 8-bit digits, for keys of the given unsigned type, with optional u32 values
+#define OC_RADIX_SORT_IMPL(name, type)                                                                    \
+    static void name(type* keys, u32* values, u64 count)                                                  \
+    {                                                                                                     \
+        if(count < OC_RADIX_SORT_MIN_COUNT)                                                               \
+        {                                                                                                 \
+            for(u64 i = 1; i < count; i++)                                                                \
+            {                                                                                             \
+                type key = keys[i];                                                                       \
+                u32 value = values ? values[i] : 0;                                                       \
+                u64 j = i;                                                                                \
+                for(; j > 0 && keys[j - 1] > key; j--)                                                    \
+                {                                                                                         \
+                    keys[j] = keys[j - 1];                                                                \
+                    if(values)                                                                            \
+                    {                                                                                     \
+                        values[j] = values[j - 1];                                                        \
+                    }                                                                                     \
+                }                                                                                         \
+                keys[j] = key;                                                                            \
+                if(values)                                                                                \
+                {                                                                                         \
+                    values[j] = value;                                                                    \
+                }                                                                                         \
+            }                                                                                             \
+            return;                                                                                       \
+        }                                                                                                 \
+                                                                                                          \
+        const u32 passCount = sizeof(type);                                                               \
+        oc_arena_scope scratch = oc_scratch_begin();                                                      \
+        type* tmpKeys = oc_arena_push_array(scratch.arena, type, count);                                  \
+        u32* tmpValues = values ? oc_arena_push_array(scratch.arena, u32, count) : 0;                     \
+        u64* histograms = oc_arena_push_array(scratch.arena, u64, passCount * 256);                       \
+        memset(histograms, 0, passCount * 256 * sizeof(u64));                                            \
+                                                                                                          \
+        for(u64 i = 0; i < count; i++)                                                                    \
+        {                                                                                                 \
+            type key = keys[i];                                                                           \
+            for(u32 pass = 0; pass < passCount; pass++)                                                   \
+            {                                                                                             \
+                histograms[pass * 256 + ((key >> (pass * 8)) & 0xff)]++;                                  \
+            }                                                                                             \
+        }                                                                                                 \
+                                                                                                          \
+        type* srcKeys = keys;                                                                             \
+        type* dstKeys = tmpKeys;                                                                          \
+        u32* srcValues = values;                                                                          \
+        u32* dstValues = tmpValues;                                                                       \
+                                                                                                          \
+        for(u32 pass = 0; pass < passCount; pass++)                                                       \
+        {                                                                                                 \
+            u64* histogram = histograms + pass * 256;                                                     \
+            u32 shift = pass * 8;                                                                         \
+            if(histogram[(srcKeys[0] >> shift) & 0xff] == count)                                          \
+            {                                                                                             \
+                continue;                                                                                 \
+            }                                                                                             \
+                                                                                                          \
+            u64 offset = 0;                                                                               \
+            for(u32 digit = 0; digit < 256; digit++)                                                      \
+            {                                                                                             \
+                u64 digitCount = histogram[digit];                                                        \
+                histogram[digit] = offset;                                                                \
+                offset += digitCount;                                                                     \
+            }                                                                                             \
+                                                                                                          \
+            for(u64 i = 0; i < count; i++)                                                                \
+            {                                                                                             \
+                u64 dst = histogram[(srcKeys[i] >> shift) & 0xff]++;                                      \
+                dstKeys[dst] = srcKeys[i];                                                                \
+                if(values)                                                                                \
+                {                                                                                         \
+                    dstValues[dst] = srcValues[i];                                                        \
+                }                                                                                         \
+            }                                                                                             \
+                                                                                                          \
+            type* tk = srcKeys;                                                                           \
+            srcKeys = dstKeys;                                                                            \
+            dstKeys = tk;                                                                                 \
+            u32* tv = srcValues;                                                                          \
+            srcValues = dstValues;                                                                        \
+            dstValues = tv;                                                                               \
+        }                                                                                                 \
+                                                                                                          \
+        if(srcKeys != keys)                                                                               \
+        {                                                                                                 \
+            memcpy(keys, srcKeys, count * sizeof(type));                                                  \
+            if(values)                                                                                    \
+            {                                                                                             \
+                memcpy(values, srcValues, count * sizeof(u32));                                           \
+            }                                                                                             \
+        }                                                                                                 \
+        oc_scratch_end(scratch);                                                                          \
+    }
+
+OC_RADIX_SORT_IMPL(oc_radix_sort_u32, u32)
+OC_RADIX_SORT_IMPL(oc_radix_sort_u64, u64)
+
+#undef OC_RADIX_SORT_IMPL
+
+//NOTE: maps f32 bits to u32 keys that sort in the same order. Negative floats have all their bits flipped, so that
+//      larger magnitudes come first, and positive floats have their sign bit set, so that they come after negatives.
+static void oc_sort_f32_to_keys(f32* floats, u64 count)
+{
+    u32* bits = (u32*)floats;
+    for(u64 i = 0; i < count; i++)
+    {
+        u32 mask = (u32)(-(i32)(bits[i] >> 31)) | 0x80000000;
+        bits[i] ^= mask;
+    }
+}
+
+static void oc_sort_f32_from_keys(f32* floats, u64 count)
+{
+    u32* bits = (u32*)floats;
+    for(u64 i = 0; i < count; i++)
+    {
+        u32 mask = ((bits[i] >> 31) - 1) | 0x80000000;
+        bits[i] ^= mask;
+    }
+}
+
+void oc_sort_u32(u32* keys, u64 count)
+{
+    oc_radix_sort_u32(keys, 0, count);
+}
+
+void oc_sort_u64(u64* keys, u64 count)
+{
+    oc_radix_sort_u64(keys, 0, count);
+}
+
+void oc_sort_f32(f32* keys, u64 count)
+{
+    oc_sort_f32_to_keys(keys, count);
+    oc_radix_sort_u32((u32*)keys, 0, count);
+    oc_sort_f32_from_keys(keys, count);
+}
+
+void oc_sort_u32_pairs(u32* keys, u32* values, u64 count)
+{
+    oc_radix_sort_u32(keys, values, count);
+}
+
+void oc_sort_u64_pairs(u64* keys, u32* values, u64 count)
+{
+    oc_radix_sort_u64(keys, values, count);
+}
+
+void oc_sort_f32_pairs(f32* keys, u32* values, u64 count)
+{
+    oc_sort_f32_to_keys(keys, count);
+    oc_radix_sort_u32((u32*)keys, values, count);
+    oc_sort_f32_from_keys(keys, count);
+}
+
+//NOTE: branchless binary search. The candidate range is [base, base + n], and each step halves it with a select
+//      instead of a branch, so that the loop has a fixed number of iterations for a given count.
+#define OC_LOWER_BOUND_IMPL(type)                       \
+    if(!count)                                          \
+    {                                                   \
+        return (0);                                     \
+    }                                                   \
+    const type* base = keys;                            \
+    u64 n = count;                                      \
+    while(n > 1)                                        \
+    {                                                   \
+        u64 half = n / 2;                               \
+        base = (base[half] < key) ? base + half : base; \
+        n -= half;                                      \
+    }                                                   \
+    return ((base - keys) + (*base < key));
+
+u64 oc_lower_bound_u32(const u32* keys, u64 count, u32 key)
+{
+    OC_LOWER_BOUND_IMPL(u32)
+}
+
+u64 oc_lower_bound_u64(const u64* keys, u64 count, u64 key)
+{
+    OC_LOWER_BOUND_IMPL(u64)
+}
+
+u64 oc_lower_bound_f32(const f32* keys, u64 count, f32 key)
+{
+    OC_LOWER_BOUND_IMPL(f32)
+}
+
+#undef OC_LOWER_BOUND_IMPL
@@ -0,0 +1,45 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#pragma once
+
+#include "typedefs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------------------------------
+//NOTE: sorting and searching arrays of numeric keys
+//--------------------------------------------------------------------------------
+/*NOTE:
+	These sort keys in ascending order with a least significant digit radix sort, which doesn't call a comparison
+	function and runs in linear time. Passes where all keys share the same digit are skipped, so keys that only use
+	their low bits are cheap to sort. The _pairs variants are stable, and reorder values along with their keys, e.g.
+	to sort draw items by depth, with their index as value. Temporary buffers are taken from the scratch arena.
+
+	f32 keys are ordered by value, with -0 before +0. NaNs are sorted after +inf, or before -inf when their sign bit
+	is set.
+
+	oc_lower_bound_xxx() return the index of the first key that is not less than key in a sorted array, or count if
+	there is none.
+*/
+ORCA_API void oc_sort_u32(u32* keys, u64 count);
+ORCA_API void oc_sort_u64(u64* keys, u64 count);
+ORCA_API void oc_sort_f32(f32* keys, u64 count);
+
+ORCA_API void oc_sort_u32_pairs(u32* keys, u32* values, u64 count);
+ORCA_API void oc_sort_u64_pairs(u64* keys, u32* values, u64 count);
+ORCA_API void oc_sort_f32_pairs(f32* keys, u32* values, u64 count);
+
+ORCA_API u64 oc_lower_bound_u32(const u32* keys, u64 count, u32 key);
+ORCA_API u64 oc_lower_bound_u64(const u64* keys, u64 count, u64 key);
+ORCA_API u64 oc_lower_bound_f32(const f32* keys, u64 count, f32 key);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
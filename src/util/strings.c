@@ -99,6 +99,97 @@ int oc_str8_cmp(oc_str8 s1, oc_str8 s2)
     return (res);
 }
 
+//----------------------------------------------------------------------------------
+// searching
+//----------------------------------------------------------------------------------
+/*NOTE:
+	Searches look for candidate bytes with memchr() when there is a single one, which is vectorized by the C library
+	(and by orca-libc in SIMD128 builds). With several candidate bytes, they use a 256-entry lookup table instead of
+	comparing each byte of the string against each candidate.
+*/
+
+typedef struct oc_str8_byte_set
+{
+    u32 count;
+    char first;
+    bool member[256];
+} oc_str8_byte_set;
+
+static void oc_str8_byte_set_add(oc_str8_byte_set* set, char c)
+{
+    if(!set->member[(u8)c])
+    {
+        set->member[(u8)c] = true;
+        if(!set->count)
+        {
+            set->first = c;
+        }
+        set->count++;
+    }
+}
+
+static u64 oc_str8_byte_set_scan(oc_str8_byte_set* set, oc_str8 s, u64 offset)
+{
+    if(offset >= s.len)
+    {
+        return (s.len);
+    }
+    else if(set->count == 1)
+    {
+        char* found = memchr(s.ptr + offset, set->first, s.len - offset);
+        return (found ? found - s.ptr : s.len);
+    }
+    else if(set->count)
+    {
+        for(; offset < s.len; offset++)
+        {
+            if(set->member[(u8)s.ptr[offset]])
+            {
+                return (offset);
+            }
+        }
+    }
+    return (s.len);
+}
+
+u64 oc_str8_find(oc_str8 s, oc_str8 needle)
+{
+    if(needle.len > s.len)
+    {
+        return (s.len);
+    }
+    if(needle.len == 0)
+    {
+        return (0);
+    }
+
+    u64 last = s.len - needle.len;
+    for(u64 offset = 0; offset <= last; offset++)
+    {
+        char* found = memchr(s.ptr + offset, needle.ptr[0], last + 1 - offset);
+        if(!found)
+        {
+            break;
+        }
+        offset = found - s.ptr;
+        if(!memcmp(found + 1, needle.ptr + 1, needle.len - 1))
+        {
+            return (offset);
+        }
+    }
+    return (s.len);
+}
+
+u64 oc_str8_find_any(oc_str8 s, oc_str8 bytes)
+{
+    oc_str8_byte_set set = { 0 };
+    for(u64 i = 0; i < bytes.len; i++)
+    {
+        oc_str8_byte_set_add(&set, bytes.ptr[i]);
+    }
+    return (oc_str8_byte_set_scan(&set, s, 0));
+}
+
 //----------------------------------------------------------------------------------
 // string lists
 //----------------------------------------------------------------------------------
@@ -173,28 +264,28 @@ oc_str8_list oc_str8_split(oc_arena* arena, oc_str8 str, oc_str8_list separators
     oc_str8_list list = { 0 };
     oc_list_init(&list.list);
 
-    char* ptr = str.ptr;
-    char* end = str.ptr + str.len;
-    char* subStart = ptr;
-    for(; ptr < end; ptr++)
+    //NOTE: only offsets holding the first byte of a separator can start a match, so we scan for those and then
+    //      try the separators in order. Empty separators never match.
+    oc_str8_byte_set firstBytes = { 0 };
+    oc_list_for(separators.list, elt, oc_str8_elt, listElt)
+    {
+        if(elt->string.len)
+        {
+            oc_str8_byte_set_add(&firstBytes, elt->string.ptr[0]);
+        }
+    }
+
+    u64 subStart = 0;
+    u64 offset = oc_str8_byte_set_scan(&firstBytes, str, 0);
+    while(offset < str.len)
     {
-        //NOTE(martin): search all separators and try to match them to the current ptr
         oc_str8* foundSep = 0;
         oc_list_for(separators.list, elt, oc_str8_elt, listElt)
         {
             oc_str8* separator = &elt->string;
-            bool equal = true;
-            for(u64 offset = 0;
-                (offset < separator->len) && (ptr + offset < end);
-                offset++)
-            {
-                if(separator->ptr[offset] != ptr[offset])
-                {
-                    equal = false;
-                    break;
-                }
-            }
-            if(equal)
+            if(separator->len
+               && separator->len <= str.len - offset
+               && !memcmp(str.ptr + offset, separator->ptr, separator->len))
             {
                 foundSep = separator;
                 break;
@@ -202,14 +293,19 @@ oc_str8_list oc_str8_split(oc_arena* arena, oc_str8 str, oc_str8_list separators
         }
         if(foundSep)
         {
-            oc_str8 sub = oc_str8_from_buffer(ptr - subStart, subStart);
+            oc_str8 sub = oc_str8_slice(str, subStart, offset);
             oc_str8_list_push(arena, &list, sub);
-            ptr += foundSep->len - 1; //NOTE(martin): ptr is incremented at the end of the loop
-            subStart = ptr + 1;
+            offset += foundSep->len;
+            subStart = offset;
+        }
+        else
+        {
+            offset++;
         }
+        offset = oc_str8_byte_set_scan(&firstBytes, str, offset);
     }
     //NOTE(martin): emit the last substring
-    oc_str8 sub = oc_str8_from_buffer(ptr - subStart, subStart);
+    oc_str8 sub = oc_str8_slice(str, subStart, str.len);
     oc_str8_list_push(arena, &list, sub);
 
     return (list);
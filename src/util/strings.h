@@ -61,6 +61,10 @@ ORCA_API oc_str8 oc_str8_pushf(oc_arena* arena, const char* format, ...);
 
 ORCA_API int oc_str8_cmp(oc_str8 s1, oc_str8 s2);
 
+//NOTE: these return the offset of the first match, or s.len if there is none
+ORCA_API u64 oc_str8_find(oc_str8 s, oc_str8 needle);
+ORCA_API u64 oc_str8_find_any(oc_str8 s, oc_str8 bytes); // first byte of s that is one of bytes
+
 ORCA_API char* oc_str8_to_cstring(oc_arena* arena, oc_str8 string);
 
 //----------------------------------------------------------------------------------
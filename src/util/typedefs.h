@@ -81,6 +81,11 @@ typedef struct oc_mat2x3
     f32 m[6];
 } oc_mat2x3;
 
+typedef struct oc_mat4x4
+{
+    f32 m[16];
+} oc_mat4x4;
+
 typedef union
 {
     struct
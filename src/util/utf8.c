@@ -6,8 +6,23 @@
 *
 **************************************************************************/
 
+#include <string.h>
 #include "utf8.h"
 
+#if defined(__wasm_simd128__)
+    #include <wasm_simd128.h>
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    #include <emmintrin.h>
+    #define OC_UTF8_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    #include <arm_neon.h>
+    #define OC_UTF8_NEON 1
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
 //-----------------------------------------------------------------
 //	utf-8 gore
 //-----------------------------------------------------------------
@@ -27,6 +42,88 @@ static const char trailingBytesForUTF8[256] = {
     2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5
 };
 
+//-----------------------------------------------------------------
+//NOTE: ascii runs
+//-----------------------------------------------------------------
+/*NOTE:
+	Most strings going through the decoding functions are ASCII, or mostly ASCII. oc_utf8_ascii_run() returns the
+	length of the run of ASCII bytes at the start of a buffer, checking 16 bytes at a time with SSE2, NEON or wasm
+	SIMD128 when available, or 8 bytes at a time otherwise. Zero bytes end the run, so that callers that stop at a
+	zero terminator can handle it on the scalar path.
+*/
+
+static const u64 OC_UTF8_LSBS = 0x0101010101010101ULL;
+static const u64 OC_UTF8_MSBS = 0x8080808080808080ULL;
+
+static u32 oc_utf8_lowest_bit(u64 mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return (index);
+#else
+    return (__builtin_ctzll(mask));
+#endif
+}
+
+static u64 oc_utf8_ascii_run(const char* ptr, u64 len)
+{
+    const u8* bytes = (const u8*)ptr;
+    u64 offset = 0;
+
+#if defined(__wasm_simd128__)
+    for(; offset + 16 <= len; offset += 16)
+    {
+        v128_t v = wasm_v128_load(bytes + offset);
+        u32 mask = wasm_i8x16_bitmask(wasm_v128_or(v, wasm_i8x16_eq(v, wasm_i8x16_splat(0))));
+        if(mask)
+        {
+            return (offset + oc_utf8_lowest_bit(mask));
+        }
+    }
+#elif OC_UTF8_SSE2
+    for(; offset + 16 <= len; offset += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(bytes + offset));
+        u32 mask = _mm_movemask_epi8(_mm_or_si128(v, _mm_cmpeq_epi8(v, _mm_setzero_si128())));
+        if(mask)
+        {
+            return (offset + oc_utf8_lowest_bit(mask));
+        }
+    }
+#elif OC_UTF8_NEON
+    for(; offset + 16 <= len; offset += 16)
+    {
+        uint8x16_t v = vld1q_u8(bytes + offset);
+        uint8x16_t stop = vorrq_u8(vcgeq_u8(v, vdupq_n_u8(0x80)), vceqzq_u8(v));
+        if(vmaxvq_u8(stop))
+        {
+            //NOTE: let the 8-byte loop below locate the stop byte
+            break;
+        }
+    }
+#endif
+
+    for(; offset + 8 <= len; offset += 8)
+    {
+        //NOTE: flags bytes with their high bit set, and zero bytes. The zero test can have false positives, but only
+        //      in bytes following a true zero, so the lowest flagged byte is always correct.
+        u64 word;
+        memcpy(&word, bytes + offset, sizeof(u64));
+        u64 mask = (word | ((word - OC_UTF8_LSBS) & ~word)) & OC_UTF8_MSBS;
+        if(mask)
+        {
+            return (offset + (oc_utf8_lowest_bit(mask) >> 3));
+        }
+    }
+
+    while(offset < len && bytes[offset] && bytes[offset] < 0x80)
+    {
+        offset++;
+    }
+    return (offset);
+}
+
 //-----------------------------------------------------------------
 //NOTE: getting sizes / offsets / indices
 //-----------------------------------------------------------------
@@ -61,12 +158,19 @@ u64 oc_utf8_codepoint_count_for_string(oc_str8 string)
 {
     u64 byteOffset = 0;
     u64 codePointIndex = 0;
-    for(;
-        (byteOffset < string.len) && (string.ptr[byteOffset] != 0);
-        codePointIndex++)
+    while(byteOffset < string.len)
     {
+        u64 run = oc_utf8_ascii_run(string.ptr + byteOffset, string.len - byteOffset);
+        byteOffset += run;
+        codePointIndex += run;
+
+        if(byteOffset >= string.len || string.ptr[byteOffset] == 0)
+        {
+            break;
+        }
         oc_utf8_dec decode = oc_utf8_decode_at(string, byteOffset);
         byteOffset += decode.size;
+        codePointIndex++;
     }
     return (codePointIndex);
 }
@@ -129,7 +233,12 @@ oc_utf8_dec oc_utf8_decode_at(oc_str8 string, u64 offset)
     //TODO(martin): check for utf-16 surrogate pairs
     oc_utf8_dec res = { .status = OC_UTF8_OK };
 
-    if(offset >= string.len)
+    if(offset < string.len && (unsigned char)string.ptr[offset] < 0x80)
+    {
+        res.codepoint = string.ptr[offset];
+        res.size = 1;
+    }
+    else if(offset >= string.len)
     {
         res.status = OC_UTF8_OUT_OF_BOUNDS;
         res.size = 1;
@@ -251,11 +360,25 @@ oc_str32 oc_utf8_to_codepoints(u64 maxCount, oc_utf32* backing, oc_str8 string)
 {
     u64 codePointIndex = 0;
     u64 byteOffset = 0;
-    for(; codePointIndex < maxCount && byteOffset < string.len; codePointIndex++)
+    while(codePointIndex < maxCount && byteOffset < string.len)
     {
-        oc_utf8_dec decode = oc_utf8_decode_at(string, byteOffset);
-        backing[codePointIndex] = decode.codepoint;
-        byteOffset += decode.size;
+        //NOTE: widen ascii runs directly, and only decode the other sequences one at a time
+        u64 run = oc_utf8_ascii_run(string.ptr + byteOffset, oc_min(string.len - byteOffset, maxCount - codePointIndex));
+        const u8* bytes = (const u8*)string.ptr + byteOffset;
+        for(u64 i = 0; i < run; i++)
+        {
+            backing[codePointIndex + i] = bytes[i];
+        }
+        codePointIndex += run;
+        byteOffset += run;
+
+        if(codePointIndex < maxCount && byteOffset < string.len)
+        {
+            oc_utf8_dec decode = oc_utf8_decode_at(string, byteOffset);
+            backing[codePointIndex] = decode.codepoint;
+            byteOffset += decode.size;
+            codePointIndex++;
+        }
     }
     oc_str32 res = { .ptr = backing, .len = codePointIndex };
     return (res);
@@ -267,6 +390,11 @@ oc_str8 oc_utf8_from_codepoints(u64 maxBytes, char* backing, oc_str32 codePoints
     for(u64 codePointIndex = 0; (codePointIndex < codePoints.len); codePointIndex++)
     {
         oc_utf32 codePoint = codePoints.ptr[codePointIndex];
+        if(codePoint < 0x80 && byteOffset < maxBytes)
+        {
+            backing[byteOffset++] = (char)codePoint;
+            continue;
+        }
         u32 byteCount = oc_utf8_codepoint_size(codePoint);
         if(byteOffset + byteCount > maxBytes)
         {
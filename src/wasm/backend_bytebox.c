@@ -12,6 +12,7 @@
 
 typedef struct oc_wasm_binding_bytebox
 {
+    oc_str8 importName;
     oc_wasm_host_proc proc;
     oc_wasm* wasm;
     i16 countParams;
@@ -33,6 +34,13 @@ typedef struct oc_wasm
     bb_import_package* imports;
     bb_module_definition* definition;
     bb_module_instance* instance;
+
+    oc_wasm_engine_options engineOptions;
+    oc_wasm_profile_hooks* profileHooks;
+
+    //NOTE: set by oc_wasm_trap() from a host call. Bytebox host functions can't unwind the guest, so the guest
+    //      runs until it returns, and the call that entered it then fails with this status.
+    oc_wasm_status pendingTrap;
 } oc_wasm;
 
 typedef union
@@ -104,27 +112,22 @@ static bb_val oc_wasm_val_to_bytebox_val(oc_wasm_val val)
 
 static void oc_wasm_binding_bytebox_thunk(void* userdata, bb_module_instance* module, const bb_val* params, bb_val* returns)
 {
+    static_assert(sizeof(oc_wasm_slot) == sizeof(bb_val), "oc_wasm_slot must match the size of bytebox values");
+
     bb_slice mem = bb_module_instance_mem_all(module);
 
     oc_wasm_binding_bytebox* binding = userdata;
 
-    // we have to do a temp translation due to bb_val being 128 bits in size, but the orca wasm layer expects 64-bit sized values
-    i64 orca_params[255];
-    i64 orca_returns[255];
-
-    OC_ASSERT(binding->countParams <= oc_array_size(orca_params));
-    OC_ASSERT(binding->countReturns <= oc_array_size(orca_returns));
-
-    for(int i = 0; i < binding->countParams; ++i)
+    oc_wasm_profile_hooks* hooks = binding->wasm->profileHooks;
+    if(hooks)
     {
-        orca_params[i] = params[i].i64_val;
+        f64 start = oc_clock_time(OC_CLOCK_MONOTONIC);
+        binding->proc((const oc_wasm_slot*)params, (oc_wasm_slot*)returns, (u8*)mem.data, binding->wasm);
+        hooks->hostCall(hooks->user, binding->importName, start, oc_clock_time(OC_CLOCK_MONOTONIC));
     }
-
-    binding->proc((const i64*)orca_params, (i64*)orca_returns, (u8*)mem.data, binding->wasm);
-
-    for(int i = 0; i < binding->countReturns; ++i)
+    else
     {
-        returns[i].i64_val = orca_returns[i];
+        binding->proc((const oc_wasm_slot*)params, (oc_wasm_slot*)returns, (u8*)mem.data, binding->wasm);
     }
 }
 
@@ -166,6 +169,7 @@ oc_wasm_status oc_wasm_add_binding(oc_wasm* wasm, oc_wasm_binding* binding)
     oc_wasm_binding_elt_bytebox* elt = oc_arena_push_type(&wasm->arena, oc_wasm_binding_elt_bytebox);
     oc_list_push(&wasm->bindings, &elt->listElt);
 
+    elt->binding.importName = oc_str8_push_copy(&wasm->arena, binding->importName);
     elt->binding.proc = binding->proc;
     elt->binding.countParams = binding->countParams;
     elt->binding.countReturns = binding->countReturns;
@@ -208,7 +212,8 @@ oc_wasm_status oc_wasm_instantiate(oc_wasm* wasm, oc_str8 moduleDebugName, oc_wa
     OC_ASSERT(memCallbacks.resizeProc);
     OC_ASSERT(memCallbacks.freeProc);
 
-    wasm->instance = bb_module_instance_create(wasm->definition);
+    bb_vm_type vmType = (wasm->engineOptions.vm == OC_WASM_VM_REGISTER) ? BB_VM_TYPE_REGISTER : BB_VM_TYPE_STACK;
+    wasm->instance = bb_module_instance_create_vm(wasm->definition, vmType);
     wasm->memCallbacks = memCallbacks;
 
     bb_wasm_memory_config memconfig = {
@@ -221,14 +226,17 @@ oc_wasm_status oc_wasm_instantiate(oc_wasm* wasm, oc_str8 moduleDebugName, oc_wa
         .packages = &wasm->imports,
         .num_packages = 1,
         .wasm_memory_config = memconfig,
-        .stack_size = 65536,
-        .enable_debug = false,
+        .stack_size = wasm->engineOptions.stackSize ? wasm->engineOptions.stackSize : 65536,
+        .enable_debug = wasm->engineOptions.debug,
     };
 
     bb_error err = bb_module_instance_instantiate(wasm->instance, opts);
     if(err != BB_ERROR_OK)
     {
-        oc_log_error("caught error instaniating module: %s\n", bb_error_str(err));
+        //NOTE: the register VM is still a work in progress in bytebox, and may not be able to run the module
+        oc_log_error("caught error instaniating module with the %.*s VM: %s\n",
+                     oc_str8_ip(oc_wasm_vm_kind_str8(vmType == BB_VM_TYPE_REGISTER ? OC_WASM_VM_REGISTER : OC_WASM_VM_STACK)),
+                     bb_error_str(err));
         return OC_WASM_STATUS_FAIL_INSTANTIATE;
     }
 
@@ -326,7 +334,22 @@ oc_wasm_status oc_wasm_function_call(oc_wasm* wasm, oc_wasm_function_handle* han
         bbParams[i] = oc_wasm_val_to_bytebox_val(params[i]);
     }
 
+    oc_wasm_profile_hooks* hooks = wasm->profileHooks;
+    f64 start = hooks ? oc_clock_time(OC_CLOCK_MONOTONIC) : 0;
+
     bb_error err = bb_module_instance_invoke(wasm->instance, convert.bb, bbParams, countParams, bbReturns, countReturns, (bb_module_instance_invoke_opts){ 0 });
+
+    if(hooks)
+    {
+        hooks->functionCall(hooks->user, handle, start, oc_clock_time(OC_CLOCK_MONOTONIC));
+    }
+
+    if(wasm->pendingTrap != OC_WASM_STATUS_SUCCESS)
+    {
+        oc_wasm_status status = wasm->pendingTrap;
+        wasm->pendingTrap = OC_WASM_STATUS_SUCCESS;
+        return status;
+    }
     if(err != BB_ERROR_OK)
     {
         oc_log_error("caught error invoking function: %s\n", bb_error_str(err));
@@ -341,6 +364,126 @@ oc_wasm_status oc_wasm_function_call(oc_wasm* wasm, oc_wasm_function_handle* han
     return OC_WASM_STATUS_SUCCESS;
 }
 
+enum
+{
+    OC_WASM_BYTEBOX_STUB_MAX_VALUES = 16,
+};
+
+oc_wasm_status oc_wasm_call_stub_bind(oc_wasm* wasm, oc_wasm_function_handle* handle, oc_wasm_valtype* params, u32 countParams, oc_wasm_valtype* returns, u32 countReturns, oc_wasm_call_stub* stub)
+{
+    *stub = (oc_wasm_call_stub){ 0 };
+
+    if(handle == NULL)
+    {
+        return OC_WASM_STATUS_SUCCESS;
+    }
+
+    oc_wasm_bytebox_func_handle_convert convert;
+    convert.oc = handle;
+
+    bb_func_info bbInfo = bb_module_instance_func_info(wasm->instance, convert.bb);
+    bool checked = (bbInfo.num_params == countParams
+                    && bbInfo.num_returns == countReturns
+                    && countParams <= OC_WASM_BYTEBOX_STUB_MAX_VALUES
+                    && countReturns <= OC_WASM_BYTEBOX_STUB_MAX_VALUES);
+
+    for(u32 i = 0; i < countParams && checked; i++)
+    {
+        checked = (bbInfo.params[i] == oc_wasm_valtype_to_bytebox_valtype(params[i]));
+    }
+    for(u32 i = 0; i < countReturns && checked; i++)
+    {
+        checked = (bbInfo.returns[i] == oc_wasm_valtype_to_bytebox_valtype(returns[i]));
+    }
+    if(!checked)
+    {
+        oc_log_error("Can't bind call stub: signature mismatch\n");
+        return OC_WASM_STATUS_FAIL_UNKNOWN;
+    }
+
+    //NOTE: bytebox takes params and returns in caller-provided arrays, so there's nothing else to prepare
+    stub->handle = handle;
+    stub->countParams = countParams;
+    stub->countReturns = countReturns;
+
+    return OC_WASM_STATUS_SUCCESS;
+}
+
+oc_wasm_status oc_wasm_call_stub_invoke(oc_wasm* wasm, oc_wasm_call_stub* stub, oc_wasm_val* params, oc_wasm_val* returns)
+{
+    if(stub->handle == NULL)
+    {
+        return OC_WASM_STATUS_SUCCESS;
+    }
+
+    oc_wasm_bytebox_func_handle_convert convert;
+    convert.oc = stub->handle;
+
+    //NOTE: the stub's signature was checked when it was bound, so values are copied without looking at their types
+    bb_val bbParams[OC_WASM_BYTEBOX_STUB_MAX_VALUES];
+    bb_val bbReturns[OC_WASM_BYTEBOX_STUB_MAX_VALUES];
+
+    for(u32 i = 0; i < stub->countParams; i++)
+    {
+        bbParams[i] = oc_wasm_val_to_bytebox_val(params[i]);
+    }
+
+    oc_wasm_profile_hooks* hooks = wasm->profileHooks;
+    f64 start = hooks ? oc_clock_time(OC_CLOCK_MONOTONIC) : 0;
+
+    bb_error err = bb_module_instance_invoke(wasm->instance, convert.bb, bbParams, stub->countParams, bbReturns, stub->countReturns, (bb_module_instance_invoke_opts){ 0 });
+
+    if(hooks)
+    {
+        hooks->functionCall(hooks->user, stub->handle, start, oc_clock_time(OC_CLOCK_MONOTONIC));
+    }
+
+    if(wasm->pendingTrap != OC_WASM_STATUS_SUCCESS)
+    {
+        oc_wasm_status status = wasm->pendingTrap;
+        wasm->pendingTrap = OC_WASM_STATUS_SUCCESS;
+        return status;
+    }
+    if(err != BB_ERROR_OK)
+    {
+        oc_log_error("caught error invoking function: %s\n", bb_error_str(err));
+        return OC_WASM_STATUS_FAIL_UNKNOWN;
+    }
+
+    for(u32 i = 0; i < stub->countReturns; i++)
+    {
+        returns[i] = bytebox_val_to_oc_val(bbReturns[i]);
+    }
+
+    return OC_WASM_STATUS_SUCCESS;
+}
+
+void oc_wasm_trap(oc_wasm* wasm, oc_wasm_status status)
+{
+    wasm->pendingTrap = status;
+}
+
+void oc_wasm_set_engine_options(oc_wasm* wasm, oc_wasm_engine_options* options)
+{
+    wasm->engineOptions = *options;
+}
+
+void oc_wasm_set_deferred_compilation(oc_wasm* wasm, bool deferred)
+{
+    //NOTE: bytebox always prepares the whole module when it is instantiated
+}
+
+oc_wasm_status oc_wasm_compile_step(oc_wasm* wasm, f64 budget, oc_wasm_compile_progress* progress)
+{
+    *progress = (oc_wasm_compile_progress){ .done = true };
+    return OC_WASM_STATUS_SUCCESS;
+}
+
+void oc_wasm_set_profile_hooks(oc_wasm* wasm, oc_wasm_profile_hooks* hooks)
+{
+    wasm->profileHooks = hooks;
+}
+
 oc_wasm_global_handle* oc_wasm_global_find(oc_wasm* wasm, oc_str8 exportName, oc_wasm_valtype expectedType)
 {
     bb_global global = bb_module_instance_find_global(wasm->instance, exportName.ptr);
@@ -12,6 +12,18 @@
 #include "m3_env.h"
 #include "wasm3.h"
 
+#if OC_WASM_GUARD_PAGES
+    #if OC_PLATFORM_WINDOWS
+        #define WIN32_LEAN_AND_MEAN
+        #include <windows.h>
+        #undef interface
+    #else
+        #include <pthread.h>
+        #include <setjmp.h>
+        #include <signal.h>
+    #endif
+#endif
+
 typedef struct oc_wasm_binding_wasm3
 {
     oc_wasm_binding info;
@@ -33,6 +45,14 @@ typedef struct oc_wasm
     IM3Environment m3Env;
     IM3Runtime m3Runtime;
     IM3Module m3Module;
+
+    bool deferredCompilation;
+    u32 compileCursor; // functions before this index have been compiled
+
+    oc_wasm_profile_hooks* profileHooks;
+
+    //NOTE: set by oc_wasm_trap() from a host call, and returned by the call that entered the guest
+    oc_wasm_status pendingTrap;
 } oc_wasm;
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -229,10 +249,176 @@ static const void* oc_wasm_binding_wasm3_thunk(IM3Runtime runtime, IM3ImportCont
     void* params = ((char*)stack) + binding->paramsStackOffset;
     void* returns = stack;
 
-    binding->info.proc((const i64*)params, (i64*)returns, mem, binding->wasm);
+    oc_wasm_profile_hooks* hooks = binding->wasm->profileHooks;
+    if(hooks)
+    {
+        f64 start = oc_clock_time(OC_CLOCK_MONOTONIC);
+        binding->info.proc((const oc_wasm_slot*)params, (oc_wasm_slot*)returns, mem, binding->wasm);
+        hooks->hostCall(hooks->user, binding->info.importName, start, oc_clock_time(OC_CLOCK_MONOTONIC));
+    }
+    else
+    {
+        binding->info.proc((const oc_wasm_slot*)params, (oc_wasm_slot*)returns, mem, binding->wasm);
+    }
+    if(binding->wasm->pendingTrap != OC_WASM_STATUS_SUCCESS)
+    {
+        //NOTE: unwinds the guest. The call that entered it replaces this with the pending status.
+        return (m3Err_trapAbort);
+    }
     return (0);
 }
 
+//NOTE: runs a function whose params were already written on the VM stack by a call stub. This is what m3_Call()
+//      does after checking and copying its arguments.
+static M3Result oc_wasm3_run_prebound(IM3Function m3Func)
+{
+    IM3Module module = m3Func->module;
+    IM3Runtime runtime = module->runtime;
+
+    if(module->startFunction >= 0)
+    {
+        M3Result res = m3_RunStart(module);
+        if(res)
+        {
+            return (res);
+        }
+    }
+
+#if d_m3RecordBacktraces
+    ClearBacktrace(runtime);
+#endif
+    m3StackCheckInit();
+
+    M3Result res = (M3Result)RunCode(m3Func->compiled, (m3stack_t)(runtime->stack), runtime->memory.mallocated, d_m3OpDefaultArgs);
+    runtime->lastCalled = res ? NULL : m3Func;
+    return (res);
+}
+
+//NOTE: valuePtrs is null when the params were written by a call stub
+static M3Result oc_wasm3_call(IM3Function m3Func, size_t countParams, const void** valuePtrs)
+{
+    return (valuePtrs ? m3_Call(m3Func, countParams, valuePtrs) : oc_wasm3_run_prebound(m3Func));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Guard pages
+
+#if OC_WASM_GUARD_PAGES
+
+//NOTE: wasm3 is built without memory bounds checks in this mode. Out-of-bounds accesses fault on the uncommitted
+//      pages that follow the wasm memory, and we turn these faults into traps when they happen inside a wasm call.
+
+static bool oc_wasm_guard_contains(oc_wasm* wasm, void* address)
+{
+    char* base = (char*)wasm->m3Runtime->memory.mallocated;
+    return (base
+            && (char*)address >= base
+            && (char*)address < base + OC_WASM_GUARD_RESERVE_SIZE);
+}
+
+    #if OC_PLATFORM_WINDOWS
+
+static int oc_wasm_guard_filter(oc_wasm* wasm, EXCEPTION_POINTERS* info)
+{
+    EXCEPTION_RECORD* record = info->ExceptionRecord;
+    if(record->ExceptionCode == EXCEPTION_ACCESS_VIOLATION
+       && record->NumberParameters >= 2
+       && oc_wasm_guard_contains(wasm, (void*)record->ExceptionInformation[1]))
+    {
+        return (EXCEPTION_EXECUTE_HANDLER);
+    }
+    return (EXCEPTION_CONTINUE_SEARCH);
+}
+
+static M3Result oc_wasm_guarded_call(oc_wasm* wasm, IM3Function m3Func, size_t countParams, const void** valuePtrs, bool* outOfBounds)
+{
+    M3Result res = m3Err_none;
+    __try
+    {
+        res = oc_wasm3_call(m3Func, countParams, valuePtrs);
+    }
+    __except(oc_wasm_guard_filter(wasm, GetExceptionInformation()))
+    {
+        *outOfBounds = true;
+    }
+    return (res);
+}
+
+    #else
+
+typedef struct oc_wasm_guard_scope
+{
+    struct oc_wasm_guard_scope* parent;
+    oc_wasm* wasm;
+    sigjmp_buf jmp;
+} oc_wasm_guard_scope;
+
+static _Thread_local oc_wasm_guard_scope* oc_wasmGuardScope = 0;
+
+//NOTE: the handlers that were installed before ours, e.g. by a crash reporter or a debugger
+static struct sigaction oc_wasmGuardPrevSegv;
+static struct sigaction oc_wasmGuardPrevBus;
+
+static void oc_wasm_guard_signal_handler(int sig, siginfo_t* info, void* context)
+{
+    oc_wasm_guard_scope* scope = oc_wasmGuardScope;
+    if(scope && oc_wasm_guard_contains(scope->wasm, info->si_addr))
+    {
+        siglongjmp(scope->jmp, 1);
+    }
+
+    //NOTE: not a wasm memory access, chain to the previous handler. If it was the default action (or ignoring the
+    //      signal), reinstall it so that the fault is raised again with that action when we return.
+    struct sigaction* prev = (sig == SIGBUS) ? &oc_wasmGuardPrevBus : &oc_wasmGuardPrevSegv;
+    if(prev->sa_flags & SA_SIGINFO)
+    {
+        prev->sa_sigaction(sig, info, context);
+    }
+    else if(prev->sa_handler == SIG_DFL || prev->sa_handler == SIG_IGN)
+    {
+        sigaction(sig, prev, 0);
+    }
+    else
+    {
+        prev->sa_handler(sig);
+    }
+}
+
+static void oc_wasm_guard_install_handlers(void)
+{
+    struct sigaction action = { 0 };
+    action.sa_sigaction = oc_wasm_guard_signal_handler;
+    action.sa_flags = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV, &action, &oc_wasmGuardPrevSegv);
+    sigaction(SIGBUS, &action, &oc_wasmGuardPrevBus);
+}
+
+static M3Result oc_wasm_guarded_call(oc_wasm* wasm, IM3Function m3Func, size_t countParams, const void** valuePtrs, bool* outOfBounds)
+{
+    //NOTE: instances can run on several threads, and installing the handlers twice would chain ours to itself
+    static pthread_once_t installOnce = PTHREAD_ONCE_INIT;
+    pthread_once(&installOnce, oc_wasm_guard_install_handlers);
+
+    //NOTE: scopes are chained to support guest -> host -> guest calls
+    oc_wasm_guard_scope scope = { .parent = oc_wasmGuardScope, .wasm = wasm };
+    M3Result res = m3Err_none;
+
+    if(sigsetjmp(scope.jmp, 1) == 0)
+    {
+        oc_wasmGuardScope = &scope;
+        res = oc_wasm3_call(m3Func, countParams, valuePtrs);
+    }
+    else
+    {
+        *outOfBounds = true;
+    }
+    oc_wasmGuardScope = scope.parent;
+    return (res);
+}
+    #endif // OC_PLATFORM_WINDOWS
+#endif     // OC_WASM_GUARD_PAGES
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // Wasm3 implementation of interface functions
 
@@ -331,6 +517,9 @@ oc_wasm_status oc_wasm_instantiate(oc_wasm* wasm, oc_str8 moduleDebugName, oc_wa
         }
     }
 
+    //NOTE: with deferred compilation, wasm3 compiles functions on their first call, and oc_wasm_compile_step()
+    //      compiles the others
+    if(!wasm->deferredCompilation)
     {
         M3Result res = m3_CompileModule(wasm->m3Module);
         if(res)
@@ -347,6 +536,63 @@ oc_wasm_status oc_wasm_instantiate(oc_wasm* wasm, oc_str8 moduleDebugName, oc_wa
     return OC_WASM_STATUS_SUCCESS;
 }
 
+void oc_wasm_set_engine_options(oc_wasm* wasm, oc_wasm_engine_options* options)
+{
+    //NOTE: wasm3 only has its own interpreter, so only the stack size applies. The runtime doesn't hold a module
+    //      or memory before oc_wasm_instantiate(), so it can be recreated with the new stack size.
+    if(options->stackSize)
+    {
+        m3_FreeRuntime(wasm->m3Runtime);
+        wasm->m3Runtime = m3_NewRuntime(wasm->m3Env, (u32)options->stackSize, NULL);
+    }
+}
+
+void oc_wasm_set_deferred_compilation(oc_wasm* wasm, bool deferred)
+{
+    wasm->deferredCompilation = deferred;
+}
+
+oc_wasm_status oc_wasm_compile_step(oc_wasm* wasm, f64 budget, oc_wasm_compile_progress* progress)
+{
+    IM3Module module = wasm->m3Module;
+    f64 start = oc_clock_time(OC_CLOCK_MONOTONIC);
+    bool compiledAny = false;
+
+    for(; wasm->compileCursor < module->numFunctions; wasm->compileCursor++)
+    {
+        IM3Function function = &module->functions[wasm->compileCursor];
+        if(function->wasm && !function->compiled)
+        {
+            if(compiledAny && oc_clock_time(OC_CLOCK_MONOTONIC) - start > budget)
+            {
+                break;
+            }
+            compiledAny = true;
+
+            M3Result res = CompileFunction(function);
+            if(res)
+            {
+                return oc_wasm_handle_wasm3_result(wasm, res, "The application couldn't compile its web assembly module");
+            }
+        }
+    }
+
+    *progress = (oc_wasm_compile_progress){
+        .done = (wasm->compileCursor >= module->numFunctions),
+    };
+    for(u32 i = 0; i < module->numFunctions; i++)
+    {
+        IM3Function function = &module->functions[i];
+        if(function->wasm)
+        {
+            progress->functionCount++;
+            progress->compiledCount += function->compiled ? 1 : 0;
+        }
+    }
+
+    return OC_WASM_STATUS_SUCCESS;
+}
+
 u64 oc_wasm_mem_size(oc_wasm* wasm)
 {
     return m3_GetMemorySize(wasm->m3Runtime);
@@ -416,12 +662,8 @@ oc_wasm_function_info oc_wasm_function_get_info(oc_arena* scratch, oc_wasm* wasm
     return info;
 }
 
-oc_wasm_status oc_wasm_function_call(oc_wasm* wasm, oc_wasm_function_handle* handle, oc_wasm_val* params, size_t countParams, oc_wasm_val* returns, size_t countReturns)
+static oc_wasm_status oc_wasm_function_call_wasm3(oc_wasm* wasm, oc_wasm_function_handle* handle, oc_wasm_val* params, size_t countParams, oc_wasm_val* returns, size_t countReturns)
 {
-    if(handle == NULL)
-    {
-        return OC_WASM_STATUS_SUCCESS;
-    }
 
     IM3Function m3Func = (IM3Function)handle;
 
@@ -433,7 +675,23 @@ oc_wasm_status oc_wasm_function_call(oc_wasm* wasm, oc_wasm_function_handle* han
         valuePtrs[i] = &params[i];
     }
 
+#if OC_WASM_GUARD_PAGES
+    bool outOfBounds = false;
+    M3Result res = oc_wasm_guarded_call(wasm, m3Func, countParams, valuePtrs, &outOfBounds);
+    if(outOfBounds)
+    {
+        oc_log_error("Function call failed: out of bounds memory access\n");
+        return OC_WASM_STATUS_FAIL_TRAP_OUTOFBOUNDSMEMORYACCESS;
+    }
+#else
     M3Result res = m3_Call(m3Func, countParams, valuePtrs);
+#endif
+    if(res && wasm->pendingTrap != OC_WASM_STATUS_SUCCESS)
+    {
+        oc_wasm_status status = wasm->pendingTrap;
+        wasm->pendingTrap = OC_WASM_STATUS_SUCCESS;
+        return status;
+    }
     if(res)
     {
         return oc_wasm_handle_wasm3_result(wasm, res, "Function call failed");
@@ -458,6 +716,137 @@ oc_wasm_status oc_wasm_function_call(oc_wasm* wasm, oc_wasm_function_handle* han
     return OC_WASM_STATUS_SUCCESS;
 }
 
+oc_wasm_status oc_wasm_function_call(oc_wasm* wasm, oc_wasm_function_handle* handle, oc_wasm_val* params, size_t countParams, oc_wasm_val* returns, size_t countReturns)
+{
+    if(handle == NULL)
+    {
+        return OC_WASM_STATUS_SUCCESS;
+    }
+
+    oc_wasm_profile_hooks* hooks = wasm->profileHooks;
+    if(hooks)
+    {
+        f64 start = oc_clock_time(OC_CLOCK_MONOTONIC);
+        oc_wasm_status status = oc_wasm_function_call_wasm3(wasm, handle, params, countParams, returns, countReturns);
+        hooks->functionCall(hooks->user, handle, start, oc_clock_time(OC_CLOCK_MONOTONIC));
+        return status;
+    }
+    return oc_wasm_function_call_wasm3(wasm, handle, params, countParams, returns, countReturns);
+}
+
+oc_wasm_status oc_wasm_call_stub_bind(oc_wasm* wasm, oc_wasm_function_handle* handle, oc_wasm_valtype* params, u32 countParams, oc_wasm_valtype* returns, u32 countReturns, oc_wasm_call_stub* stub)
+{
+    *stub = (oc_wasm_call_stub){ 0 };
+
+    IM3Function m3Func = (IM3Function)handle;
+    if(m3Func == NULL)
+    {
+        return OC_WASM_STATUS_SUCCESS;
+    }
+
+    IM3FuncType ftype = m3Func->funcType;
+    bool checked = (ftype->numArgs == countParams && ftype->numRets == countReturns);
+
+    for(u32 i = 0; i < countParams && checked; i++)
+    {
+        checked = (wasm3_valuetype_to_valtype(d_FuncArgType(ftype, i)) == params[i]);
+    }
+    for(u32 i = 0; i < countReturns && checked; i++)
+    {
+        checked = (wasm3_valuetype_to_valtype(d_FuncRetType(ftype, i)) == returns[i]);
+    }
+    if(!checked)
+    {
+        oc_log_error("Can't bind call stub: signature mismatch\n");
+        return OC_WASM_STATUS_FAIL_UNKNOWN;
+    }
+
+    //NOTE: m3_FindFunction() compiles the function, even when compilation is deferred
+    if(!m3Func->compiled)
+    {
+        M3Result res = CompileFunction(m3Func);
+        if(res)
+        {
+            return oc_wasm_handle_wasm3_result(wasm, res, "Can't bind call stub.");
+        }
+    }
+
+    stub->handle = handle;
+    stub->countParams = countParams;
+    stub->countReturns = countReturns;
+
+    //NOTE: the VM stack doesn't move, and calls take their returns in the first slots of the stack, followed by
+    //      their params. Each value takes a 64-bit slot.
+    stub->slots = wasm->m3Runtime->stack;
+
+    return OC_WASM_STATUS_SUCCESS;
+}
+
+static oc_wasm_status oc_wasm_call_stub_invoke_wasm3(oc_wasm* wasm, oc_wasm_call_stub* stub, oc_wasm_val* params, oc_wasm_val* returns)
+{
+    IM3Function m3Func = (IM3Function)stub->handle;
+
+    static_assert(sizeof(oc_wasm_val) == sizeof(u64), "oc_wasm_val must match the size of wasm3 stack slots");
+
+    //NOTE: the stub's signature was checked when it was bound, so we can copy whole slots regardless of their type
+    u64* slots = stub->slots;
+    for(u32 i = 0; i < stub->countParams; i++)
+    {
+        slots[stub->countReturns + i] = (u64)params[i].I64;
+    }
+
+#if OC_WASM_GUARD_PAGES
+    bool outOfBounds = false;
+    M3Result res = oc_wasm_guarded_call(wasm, m3Func, stub->countParams, NULL, &outOfBounds);
+    if(outOfBounds)
+    {
+        oc_log_error("Function call failed: out of bounds memory access\n");
+        return OC_WASM_STATUS_FAIL_TRAP_OUTOFBOUNDSMEMORYACCESS;
+    }
+#else
+    M3Result res = oc_wasm3_run_prebound(m3Func);
+#endif
+    if(res && wasm->pendingTrap != OC_WASM_STATUS_SUCCESS)
+    {
+        oc_wasm_status status = wasm->pendingTrap;
+        wasm->pendingTrap = OC_WASM_STATUS_SUCCESS;
+        return status;
+    }
+    if(res)
+    {
+        return oc_wasm_handle_wasm3_result(wasm, res, "Function call failed");
+    }
+
+    for(u32 i = 0; i < stub->countReturns; i++)
+    {
+        returns[i].I64 = (i64)slots[i];
+    }
+    return OC_WASM_STATUS_SUCCESS;
+}
+
+oc_wasm_status oc_wasm_call_stub_invoke(oc_wasm* wasm, oc_wasm_call_stub* stub, oc_wasm_val* params, oc_wasm_val* returns)
+{
+    if(stub->handle == NULL)
+    {
+        return OC_WASM_STATUS_SUCCESS;
+    }
+
+    oc_wasm_profile_hooks* hooks = wasm->profileHooks;
+    if(hooks)
+    {
+        f64 start = oc_clock_time(OC_CLOCK_MONOTONIC);
+        oc_wasm_status status = oc_wasm_call_stub_invoke_wasm3(wasm, stub, params, returns);
+        hooks->functionCall(hooks->user, stub->handle, start, oc_clock_time(OC_CLOCK_MONOTONIC));
+        return status;
+    }
+    return oc_wasm_call_stub_invoke_wasm3(wasm, stub, params, returns);
+}
+
+void oc_wasm_set_profile_hooks(oc_wasm* wasm, oc_wasm_profile_hooks* hooks)
+{
+    wasm->profileHooks = hooks;
+}
+
 oc_wasm_global_handle* oc_wasm_global_find(oc_wasm* wasm, oc_str8 exportName, oc_wasm_valtype expectedType)
 {
     IM3Global m3Global = m3_FindGlobal(wasm->m3Module, exportName.ptr);
@@ -504,8 +893,17 @@ oc_wasm_global_pointer oc_wasm_global_pointer_find(oc_wasm* wasm, oc_str8 export
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // implementation creation / destruction
 
+void oc_wasm_trap(oc_wasm* wasm, oc_wasm_status status)
+{
+    wasm->pendingTrap = status;
+}
+
 void oc_wasm_destroy(oc_wasm* wasm)
 {
+    //NOTE: this releases the loaded module and the linear memory through the free callback
+    m3_FreeRuntime(wasm->m3Runtime);
+    m3_FreeEnvironment(wasm->m3Env);
+
     oc_arena arena = wasm->arena;
     oc_arena_cleanup(&arena);
 }
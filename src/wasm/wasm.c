@@ -88,3 +88,249 @@ oc_str8 oc_wasm_status_str8(oc_wasm_status status)
 
     return OC_STR8("unknown");
 }
+
+//------------------------------------------------------------------------------------
+// Module feature detection
+//------------------------------------------------------------------------------------
+
+static bool oc_wasm_read_leb_u32(oc_str8 blob, u64* offset, u32* result)
+{
+    u32 value = 0;
+    for(u32 shift = 0; shift < 35; shift += 7)
+    {
+        if(*offset >= blob.len)
+        {
+            return (false);
+        }
+        u8 byte = blob.ptr[*offset];
+        (*offset)++;
+        value |= (u32)(byte & 0x7f) << shift;
+        if(!(byte & 0x80))
+        {
+            *result = value;
+            return (true);
+        }
+    }
+    return (false);
+}
+
+static bool oc_wasm_read_limits_shared(oc_str8 blob, u64* offset, bool* shared)
+{
+    if(*offset >= blob.len)
+    {
+        return (false);
+    }
+    u8 flags = blob.ptr[*offset];
+    (*offset)++;
+
+    u32 unused;
+    if(!oc_wasm_read_leb_u32(blob, offset, &unused))
+    {
+        return (false);
+    }
+    if((flags & 0x01) && !oc_wasm_read_leb_u32(blob, offset, &unused))
+    {
+        return (false);
+    }
+    *shared = *shared || (flags & 0x02);
+    return (true);
+}
+
+bool oc_wasm_module_uses_shared_memory(oc_str8 wasmBlob)
+{
+    //NOTE: walk the import and memory sections looking for a memory whose limits have the shared flag set,
+    //      which is how modules built for the threads proposal declare their linear memory.
+    enum
+    {
+        OC_WASM_SECTION_IMPORT = 2,
+        OC_WASM_SECTION_MEMORY = 5,
+        OC_WASM_IMPORT_FUNC = 0,
+        OC_WASM_IMPORT_TABLE = 1,
+        OC_WASM_IMPORT_MEMORY = 2,
+        OC_WASM_IMPORT_GLOBAL = 3,
+    };
+
+    bool shared = false;
+    u64 offset = 8; // skip magic and version
+
+    while(offset < wasmBlob.len)
+    {
+        u8 sectionId = wasmBlob.ptr[offset];
+        offset++;
+
+        u32 sectionSize = 0;
+        if(!oc_wasm_read_leb_u32(wasmBlob, &offset, &sectionSize) || offset + sectionSize > wasmBlob.len)
+        {
+            break;
+        }
+        u64 sectionEnd = offset + sectionSize;
+        oc_str8 section = oc_str8_slice(wasmBlob, 0, sectionEnd);
+
+        if(sectionId == OC_WASM_SECTION_IMPORT)
+        {
+            u32 count = 0;
+            oc_wasm_read_leb_u32(section, &offset, &count);
+            for(u32 i = 0; i < count; i++)
+            {
+                u32 len = 0;
+                // module and field names
+                if(!oc_wasm_read_leb_u32(section, &offset, &len))
+                {
+                    break;
+                }
+                offset += len;
+                if(!oc_wasm_read_leb_u32(section, &offset, &len))
+                {
+                    break;
+                }
+                offset += len;
+
+                if(offset >= section.len)
+                {
+                    break;
+                }
+                u8 kind = section.ptr[offset];
+                offset++;
+
+                bool ok = true;
+                switch(kind)
+                {
+                    case OC_WASM_IMPORT_FUNC:
+                        ok = oc_wasm_read_leb_u32(section, &offset, &len);
+                        break;
+                    case OC_WASM_IMPORT_TABLE:
+                    {
+                        bool tableShared = false;
+                        offset++; // reference type
+                        ok = oc_wasm_read_limits_shared(section, &offset, &tableShared);
+                    }
+                    break;
+                    case OC_WASM_IMPORT_MEMORY:
+                        ok = oc_wasm_read_limits_shared(section, &offset, &shared);
+                        break;
+                    case OC_WASM_IMPORT_GLOBAL:
+                        offset += 2; // value type and mutability
+                        break;
+                    default:
+                        ok = false;
+                        break;
+                }
+                if(!ok)
+                {
+                    break;
+                }
+            }
+        }
+        else if(sectionId == OC_WASM_SECTION_MEMORY)
+        {
+            u32 count = 0;
+            oc_wasm_read_leb_u32(section, &offset, &count);
+            for(u32 i = 0; i < count; i++)
+            {
+                if(!oc_wasm_read_limits_shared(section, &offset, &shared))
+                {
+                    break;
+                }
+            }
+            // memories are declared after imports, no need to look further
+            break;
+        }
+        offset = sectionEnd;
+    }
+    return (shared);
+}
+
+//------------------------------------------------------------------------------------
+// Engine options
+//------------------------------------------------------------------------------------
+
+oc_str8 oc_wasm_vm_kind_str8(oc_wasm_vm_kind vm)
+{
+    switch(vm)
+    {
+        case OC_WASM_VM_DEFAULT:
+            return OC_STR8("default");
+        case OC_WASM_VM_STACK:
+            return OC_STR8("stack");
+        case OC_WASM_VM_REGISTER:
+            return OC_STR8("register");
+    }
+    return OC_STR8("unknown");
+}
+
+static bool oc_wasm_engine_option_parse_u64(oc_str8 value, u64* result)
+{
+    //NOTE: accepts an optional k/m suffix, e.g. stack-size=512k
+    u64 multiplier = 1;
+    if(value.len && (value.ptr[value.len - 1] == 'k' || value.ptr[value.len - 1] == 'K'))
+    {
+        multiplier = 1 << 10;
+        value.len--;
+    }
+    else if(value.len && (value.ptr[value.len - 1] == 'm' || value.ptr[value.len - 1] == 'M'))
+    {
+        multiplier = 1 << 20;
+        value.len--;
+    }
+
+    if(value.len == 0)
+    {
+        return (false);
+    }
+
+    u64 n = 0;
+    for(u64 i = 0; i < value.len; i++)
+    {
+        if(value.ptr[i] < '0' || value.ptr[i] > '9')
+        {
+            return (false);
+        }
+        n = n * 10 + (value.ptr[i] - '0');
+    }
+    *result = n * multiplier;
+    return (true);
+}
+
+bool oc_wasm_engine_option_parse(oc_wasm_engine_options* options, oc_str8 option)
+{
+    u64 sep = oc_str8_find(option, OC_STR8("="));
+    oc_str8 name = oc_str8_slice(option, 0, sep);
+    oc_str8 value = (sep < option.len) ? oc_str8_slice(option, sep + 1, option.len) : (oc_str8){ 0 };
+
+    if(!oc_str8_cmp(name, OC_STR8("vm")))
+    {
+        if(!oc_str8_cmp(value, OC_STR8("stack")))
+        {
+            options->vm = OC_WASM_VM_STACK;
+            return (true);
+        }
+        else if(!oc_str8_cmp(value, OC_STR8("register")))
+        {
+            options->vm = OC_WASM_VM_REGISTER;
+            return (true);
+        }
+        else if(!oc_str8_cmp(value, OC_STR8("default")))
+        {
+            options->vm = OC_WASM_VM_DEFAULT;
+            return (true);
+        }
+    }
+    else if(!oc_str8_cmp(name, OC_STR8("stack-size")))
+    {
+        return (oc_wasm_engine_option_parse_u64(value, &options->stackSize));
+    }
+    else if(!oc_str8_cmp(name, OC_STR8("debug")))
+    {
+        if(value.len == 0 || !oc_str8_cmp(value, OC_STR8("1")))
+        {
+            options->debug = true;
+            return (true);
+        }
+        else if(!oc_str8_cmp(value, OC_STR8("0")))
+        {
+            options->debug = false;
+            return (true);
+        }
+    }
+    return (false);
+}
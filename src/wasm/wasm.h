@@ -15,6 +15,21 @@
     #error OC_WASM_BACKEND_BYTEBOX must be defined to 0 or 1
 #endif
 
+#ifndef OC_WASM_GUARD_PAGES
+    #define OC_WASM_GUARD_PAGES 0
+#endif
+
+#if OC_WASM_GUARD_PAGES
+    #if !OC_WASM_BACKEND_WASM3
+        #error OC_WASM_GUARD_PAGES is only supported by the wasm3 backend
+    #endif
+
+//NOTE: wasm effective addresses are a 32-bit base plus a 32-bit offset, so reserving 8GB (plus some room for the
+//      backend's memory header) past the start of the memory guarantees that any out-of-bounds access lands on
+//      uncommitted pages and faults, instead of having to be bounds checked.
+    #define OC_WASM_GUARD_RESERVE_SIZE ((8ULL << 30) + (64ULL << 10))
+#endif
+
 typedef enum oc_wasm_status
 {
     OC_WASM_STATUS_SUCCESS,
@@ -60,7 +75,20 @@ typedef struct oc_wasm_val_tagged
 struct oc_wasm;
 typedef struct oc_wasm oc_wasm;
 
-typedef void (*oc_wasm_host_proc)(const i64* restrict params, i64* restrict returns, u8* memory, oc_wasm* wasm);
+//NOTE: host procs read their arguments and write their returns directly in the backend's value stack,
+//      so the size of a value slot depends on the backend. Procs should only access the low 64 bits of
+//      each slot, e.g. with *(i32*)&params[i].
+#if OC_WASM_BACKEND_BYTEBOX
+typedef struct oc_wasm_slot
+{
+    i64 val;
+    i64 high; // bytebox values are 128 bits wide
+} oc_wasm_slot;
+#else
+typedef i64 oc_wasm_slot;
+#endif
+
+typedef void (*oc_wasm_host_proc)(const oc_wasm_slot* restrict params, oc_wasm_slot* restrict returns, u8* memory, oc_wasm* wasm);
 
 typedef struct oc_wasm_binding
 {
@@ -113,12 +141,71 @@ typedef struct oc_wasm_global_pointer
 
 typedef struct oc_wasm oc_wasm;
 
+//NOTE: profiling hooks are called with the start and end times of guest function calls made through
+//      oc_wasm_function_call(), and of host binding calls made by the guest.
+typedef void (*oc_wasm_profile_function_proc)(void* user, oc_wasm_function_handle* handle, f64 start, f64 end);
+typedef void (*oc_wasm_profile_host_proc)(void* user, oc_str8 importName, f64 start, f64 end);
+
+typedef struct oc_wasm_profile_hooks
+{
+    void* user;
+    oc_wasm_profile_function_proc functionCall;
+    oc_wasm_profile_host_proc hostCall;
+} oc_wasm_profile_hooks;
+
+//NOTE: by default the whole module is compiled by oc_wasm_instantiate(). With deferred compilation, functions are
+//      compiled when they're first called, and oc_wasm_compile_step() compiles the remaining ones in time-budgeted
+//      slices, e.g. in idle frame time. Backends that compile modules ahead of time ignore this.
+//NOTE: a call stub binds a guest function to a signature once, so that calling it doesn't check or convert its
+//      params on each call. Hosts bind stubs for functions they call every frame, like event handlers. Stubs must
+//      be called with the number of params and returns they were bound with.
+typedef struct oc_wasm_call_stub
+{
+    oc_wasm_function_handle* handle;
+    u32 countParams;
+    u32 countReturns;
+    void* slots; // where the backend takes the params and returns of the call, if it has a fixed location
+
+} oc_wasm_call_stub;
+
+typedef struct oc_wasm_compile_progress
+{
+    u32 functionCount; // functions defined by the module
+    u32 compiledCount; // functions compiled so far, including those compiled on first call
+    bool done;
+
+} oc_wasm_compile_progress;
+
+//NOTE: engine options tune how a backend runs the module. Zero fields keep the backend's defaults, and options
+//      a backend doesn't have are ignored: the VM kind only applies to bytebox, which has a stack VM and an
+//      experimental register VM, and debug enables bytebox's debug traps and backtraces.
+typedef enum oc_wasm_vm_kind
+{
+    OC_WASM_VM_DEFAULT = 0,
+    OC_WASM_VM_STACK,
+    OC_WASM_VM_REGISTER,
+} oc_wasm_vm_kind;
+
+typedef struct oc_wasm_engine_options
+{
+    oc_wasm_vm_kind vm;
+    u64 stackSize; // size of the VM stack, in bytes for wasm3 and in value slots for bytebox
+    bool debug;
+
+} oc_wasm_engine_options;
+
 bool oc_wasm_status_is_fail(oc_wasm_status status);
 oc_str8 oc_wasm_status_str8(oc_wasm_status status);
 
 size_t oc_wasm_valtype_size(oc_wasm_valtype valtype);
 oc_str8 oc_wasm_valtype_str8(oc_wasm_valtype valtype);
 
+bool oc_wasm_module_uses_shared_memory(oc_str8 wasmBlob);
+
+// parses a "name=value" engine option (vm=stack|register, stack-size=<bytes>, debug[=0|1]) into options
+bool oc_wasm_engine_option_parse(oc_wasm_engine_options* options, oc_str8 option);
+oc_str8 oc_wasm_vm_kind_str8(oc_wasm_vm_kind vm);
+
 oc_wasm* oc_wasm_create(void);
 void oc_wasm_destroy(oc_wasm* wasm);
 
@@ -126,6 +213,13 @@ oc_wasm_status oc_wasm_decode(oc_wasm* wasm, oc_str8 wasmBlob);
 oc_wasm_status oc_wasm_add_binding(oc_wasm* wasm, oc_wasm_binding* binding);
 oc_wasm_status oc_wasm_instantiate(oc_wasm* wasm, oc_str8 moduleDebugName, oc_wasm_mem_callbacks memCallbacks);
 
+// must be called before oc_wasm_instantiate()
+void oc_wasm_set_engine_options(oc_wasm* wasm, oc_wasm_engine_options* options);
+// must be called before oc_wasm_instantiate()
+void oc_wasm_set_deferred_compilation(oc_wasm* wasm, bool deferred);
+// compiles functions for up to budget seconds (at least one function is compiled per call)
+oc_wasm_status oc_wasm_compile_step(oc_wasm* wasm, f64 budget, oc_wasm_compile_progress* progress);
+
 u64 oc_wasm_mem_size(oc_wasm* wasm);
 oc_str8 oc_wasm_mem_get(oc_wasm* wasm);
 oc_wasm_status oc_wasm_mem_resize(oc_wasm* wasm, u32 countPages);
@@ -134,6 +228,17 @@ oc_wasm_function_handle* oc_wasm_function_find(oc_wasm* wasm, oc_str8 exportName
 oc_wasm_function_info oc_wasm_function_get_info(oc_arena* scratch, oc_wasm* wasm, oc_wasm_function_handle* handle);
 oc_wasm_status oc_wasm_function_call(oc_wasm* wasm, oc_wasm_function_handle* handle, oc_wasm_val* params, size_t countParams, oc_wasm_val* returns, size_t countReturns);
 
+// fails if the function doesn't have this signature. A NULL handle binds a stub that does nothing when invoked.
+oc_wasm_status oc_wasm_call_stub_bind(oc_wasm* wasm, oc_wasm_function_handle* handle, oc_wasm_valtype* params, u32 countParams, oc_wasm_valtype* returns, u32 countReturns, oc_wasm_call_stub* stub);
+oc_wasm_status oc_wasm_call_stub_invoke(oc_wasm* wasm, oc_wasm_call_stub* stub, oc_wasm_val* params, oc_wasm_val* returns);
+
+// called from a host binding: stops the guest once the binding returns, and makes the call that entered the guest
+// fail with status
+void oc_wasm_trap(oc_wasm* wasm, oc_wasm_status status);
+
+// pass NULL to disable profiling. The hooks must stay valid while profiling is enabled.
+void oc_wasm_set_profile_hooks(oc_wasm* wasm, oc_wasm_profile_hooks* hooks);
+
 oc_wasm_global_handle* oc_wasm_global_find(oc_wasm* wasm, oc_str8 exportName, oc_wasm_valtype expectedType);
 oc_wasm_val oc_wasm_global_get_value(oc_wasm_global_handle* global);
 void oc_wasm_global_set_value(oc_wasm_global_handle* global, oc_wasm_val value);
@@ -793,42 +793,11 @@ u64 orca_glGetUniformLocation_name_length(oc_wasm* wasm, const GLchar* name)
     return (orca_check_cstring(wasm, name));
 }
 
-//------------------------------------------------------------------------
-// Draw indirect length checks
-//------------------------------------------------------------------------
-
-typedef struct
-{
-    u32 count;
-    u32 primCount;
-    u32 first;
-    u32 reserved;
-} DrawArraysIndirectCommand;
-
-u64 orca_glDrawArraysIndirect_indirect_length(oc_wasm* wasm, const void* indirect)
-{
-    return (sizeof(DrawArraysIndirectCommand));
-}
-
-typedef struct
-{
-    u32 count;
-    u32 instanceCount;
-    u32 firstIndex;
-    i32 baseVertex;
-    u32 reservedMustBeZero;
-} DrawElementsIndirectCommand;
-
-u64 orca_glDrawElementsIndirect_indirect_length(oc_wasm* wasm, const void* indirect)
-{
-    return (sizeof(DrawElementsIndirectCommand));
-}
-
 //------------------------------------------------------------------------
 // Fully manual bindings
 //------------------------------------------------------------------------
 
-void glShaderSource_stub(const i64* restrict _params, i64* restrict _returns, u8* _mem, oc_wasm* _wasm)
+void glShaderSource_stub(const oc_wasm_slot* restrict _params, oc_wasm_slot* restrict _returns, u8* _mem, oc_wasm* _wasm)
 {
     i32 shader = *(i32*)&_params[0];
     i32 count = *(i32*)&_params[1];
@@ -851,7 +820,7 @@ void glShaderSource_stub(const i64* restrict _params, i64* restrict _returns, u8
     oc_scratch_end(scratch);
 }
 
-void glGetVertexAttribPointerv_stub(const i64* restrict _params, i64* restrict _returns, u8* _mem, oc_wasm* _wasm)
+void glGetVertexAttribPointerv_stub(const oc_wasm_slot* restrict _params, oc_wasm_slot* restrict _returns, u8* _mem, oc_wasm* _wasm)
 {
     GLuint index = *(i32*)&_params[0];
     GLenum pname = *(i32*)&_params[1];
@@ -871,7 +840,7 @@ void glGetVertexAttribPointerv_stub(const i64* restrict _params, i64* restrict _
     *pointer = (i32)(intptr_t)rawPointer;
 }
 
-void glVertexAttribPointer_stub(const i64* restrict _params, i64* restrict _returns, u8* _mem, oc_wasm* _wasm)
+void glVertexAttribPointer_stub(const oc_wasm_slot* restrict _params, oc_wasm_slot* restrict _returns, u8* _mem, oc_wasm* _wasm)
 {
     GLuint index = *(u32*)&_params[0];
     GLint size = *(i32*)&_params[1];
@@ -900,7 +869,82 @@ void glVertexAttribPointer_stub(const i64* restrict _params, i64* restrict _retu
     }
 }
 
-void glVertexAttribIPointer_stub(const i64* restrict _params, i64* restrict _returns, u8* _mem, oc_wasm* _wasm)
+//NOTE: in GLES 3.1, indirect draw commands are always read from the buffer bound to GL_DRAW_INDIRECT_BUFFER, and
+//      indirect is an offset in that buffer. So we pass it through instead of converting it to a host pointer.
+static bool orca_gl_draw_indirect_buffer_bound(const char* procName)
+{
+    GLint boundBuffer = 0;
+    glGetIntegerv(GL_DRAW_INDIRECT_BUFFER_BINDING, &boundBuffer);
+    if(boundBuffer == 0)
+    {
+        oc_log_error("Calling %s with a GL_DRAW_INDIRECT_BUFFER binding of 0 is not supported.\n", procName);
+    }
+    return (boundBuffer != 0);
+}
+
+void glDrawArraysIndirect_stub(const oc_wasm_slot* restrict _params, oc_wasm_slot* restrict _returns, u8* _mem, oc_wasm* _wasm)
+{
+    GLenum mode = *(i32*)&_params[0];
+    const void* indirect = (void*)(intptr_t) * (u32*)&_params[1];
+
+    if(orca_gl_draw_indirect_buffer_bound("glDrawArraysIndirect"))
+    {
+        glDrawArraysIndirect(mode, indirect);
+    }
+}
+
+void glDrawElementsIndirect_stub(const oc_wasm_slot* restrict _params, oc_wasm_slot* restrict _returns, u8* _mem, oc_wasm* _wasm)
+{
+    GLenum mode = *(i32*)&_params[0];
+    GLenum type = *(i32*)&_params[1];
+    const void* indirect = (void*)(intptr_t) * (u32*)&_params[2];
+
+    if(orca_gl_draw_indirect_buffer_bound("glDrawElementsIndirect"))
+    {
+        glDrawElementsIndirect(mode, type, indirect);
+    }
+}
+
+void glCreateShaderProgramv_stub(const oc_wasm_slot* restrict _params, oc_wasm_slot* restrict _returns, u8* _mem, oc_wasm* _wasm)
+{
+    GLenum type = *(i32*)&_params[0];
+    i32 count = *(i32*)&_params[1];
+    u32 stringArrayOffset = *(u32*)&_params[2];
+
+    u64 memSize = oc_wasm_mem_size(_wasm);
+    *(u32*)&_returns[0] = 0;
+
+    if(count < 0 || (u64)stringArrayOffset + (u64)count * sizeof(u32) > memSize)
+    {
+        oc_log_error("glCreateShaderProgramv: parameter 'strings' is out of bounds\n");
+        return;
+    }
+
+    //NOTE: strings are null-terminated, so check that each of them ends inside wasm memory
+    oc_arena_scope scratch = oc_scratch_begin();
+    const char** stringArray = (const char**)oc_arena_push_array(scratch.arena, char*, count);
+    u32* stringOffsetArray = (u32*)((char*)_mem + stringArrayOffset);
+    bool valid = true;
+    for(int i = 0; i < count; i++)
+    {
+        u32 offset = stringOffsetArray[i];
+        if(offset >= memSize || !memchr((char*)_mem + offset, 0, memSize - offset))
+        {
+            oc_log_error("glCreateShaderProgramv: string %i is out of bounds\n", i);
+            valid = false;
+            break;
+        }
+        stringArray[i] = (char*)_mem + offset;
+    }
+
+    if(valid)
+    {
+        *(u32*)&_returns[0] = glCreateShaderProgramv(type, count, stringArray);
+    }
+    oc_scratch_end(scratch);
+}
+
+void glVertexAttribIPointer_stub(const oc_wasm_slot* restrict _params, oc_wasm_slot* restrict _returns, u8* _mem, oc_wasm* _wasm)
 {
     GLuint index = *(u32*)&_params[0];
     GLint size = *(i32*)&_params[1];
@@ -927,7 +971,7 @@ void glVertexAttribIPointer_stub(const i64* restrict _params, i64* restrict _ret
     }
 }
 
-void glGetUniformIndices_stub(const i64* restrict _params, i64* restrict _returns, u8* _mem, oc_wasm* _wasm)
+void glGetUniformIndices_stub(const oc_wasm_slot* restrict _params, oc_wasm_slot* restrict _returns, u8* _mem, oc_wasm* _wasm)
 {
     GLuint program = (GLuint) * (i32*)&_params[0];
     GLsizei uniformCount = (GLsizei) * (i32*)&_params[1];
@@ -1063,7 +1107,7 @@ void orca_gl_getstring_init(orca_gl_getstring_info* info, char* memory)
     info->init = true;
 }
 
-void glGetString_stub(const i64* restrict _params, i64* restrict _returns, u8* _mem, oc_wasm* _wasm)
+void glGetString_stub(const oc_wasm_slot* restrict _params, oc_wasm_slot* restrict _returns, u8* _mem, oc_wasm* _wasm)
 {
     if(!__orcaGLGetStringInfo.init)
     {
@@ -1086,7 +1130,7 @@ void glGetString_stub(const i64* restrict _params, i64* restrict _returns, u8* _
     glGetString(name);
 }
 
-void glGetStringi_stub(const i64* restrict _params, i64* restrict _returns, u8* _mem, oc_wasm* _wasm)
+void glGetStringi_stub(const oc_wasm_slot* restrict _params, oc_wasm_slot* restrict _returns, u8* _mem, oc_wasm* _wasm)
 {
     if(!__orcaGLGetStringInfo.init)
     {
@@ -1107,6 +1151,106 @@ void glGetStringi_stub(const i64* restrict _params, i64* restrict _returns, u8*
     glGetStringi(name, index);
 }
 
+//------------------------------------------------------------------------
+// Command buffer
+//------------------------------------------------------------------------
+
+//NOTE: guests built with OC_GLES_COMMAND_BUFFER record GL commands that don't return anything or access guest memory
+//      in this buffer, and send it here in bulk. The opcodes are generated by gen_gles_command_buffer() in
+//      scripts/gles_gen.py, along with a hash of the command table so that mismatched guests are rejected.
+//      The runtime sets 'synced' when the guest's context is current on the runloop, so that the guest can skip
+//      syncing before GL calls that aren't recorded.
+typedef struct oc_wasm_gles_command_buffer
+{
+    u32 tableHash;
+    u32 count;
+    u32 cap;
+    u32 synced;
+    u32 words[];
+} oc_wasm_gles_command_buffer;
+
+static oc_wasm_gles_command_buffer* oc_gles_command_buffer_get(u32 addr)
+{
+    oc_str8 mem = oc_runtime_get_wasm_memory();
+    if(!addr || (u64)addr + sizeof(oc_wasm_gles_command_buffer) > mem.len)
+    {
+        return (0);
+    }
+    oc_wasm_gles_command_buffer* buffer = (oc_wasm_gles_command_buffer*)(mem.ptr + addr);
+    if(buffer->count > buffer->cap
+       || (u64)addr + sizeof(oc_wasm_gles_command_buffer) + (u64)buffer->cap * sizeof(u32) > mem.len)
+    {
+        return (0);
+    }
+    return (buffer);
+}
+
+void oc_runtime_gles_command_buffer_flush(bool sync)
+{
+    oc_wasm_env* env = oc_runtime_get_env();
+    oc_gles_thread* glesThread = &oc_runtime_get()->glesThread;
+    if(!env->glesCommandBufferOffset)
+    {
+        return;
+    }
+
+    oc_wasm_gles_command_buffer* buffer = oc_gles_command_buffer_get(env->glesCommandBufferOffset);
+    if(!buffer)
+    {
+        oc_log_error("GLES command buffer is corrupted, dropping it\n");
+        env->glesCommandBufferOffset = 0;
+        return;
+    }
+    if(buffer->count)
+    {
+        if(glesThread->enabled)
+        {
+            oc_gles_thread_submit(glesThread, buffer->words, buffer->count);
+        }
+        else if(!oc_gles_command_buffer_replay(buffer->words, buffer->count))
+        {
+            oc_log_error("invalid command in GLES command buffer, dropping the rest of the buffer\n");
+        }
+    }
+    buffer->count = 0;
+
+    if(sync && glesThread->enabled)
+    {
+        oc_gles_thread_acquire(glesThread);
+    }
+    buffer->synced = !glesThread->threadOwnsContext;
+}
+
+void oc_gles_command_buffer_register_stub(const oc_wasm_slot* restrict _params, oc_wasm_slot* restrict _returns, u8* _mem, oc_wasm* _wasm)
+{
+    u32 addr = *(u32*)&_params[0];
+
+    oc_wasm_gles_command_buffer* buffer = oc_gles_command_buffer_get(addr);
+    if(!buffer)
+    {
+        oc_log_error("oc_gles_command_buffer_register(): invalid command buffer at address %u\n", addr);
+        return;
+    }
+    if(buffer->tableHash != OC_GLES_COMMAND_TABLE_HASH)
+    {
+        oc_log_error("oc_gles_command_buffer_register(): the application's GLES command table doesn't match the runtime's, "
+                     "rebuild it with the current SDK\n");
+        return;
+    }
+    oc_runtime_get_env()->glesCommandBufferOffset = addr;
+    buffer->synced = !oc_runtime_get()->glesThread.threadOwnsContext;
+}
+
+void oc_gles_command_buffer_flush_stub(const oc_wasm_slot* restrict _params, oc_wasm_slot* restrict _returns, u8* _mem, oc_wasm* _wasm)
+{
+    oc_runtime_gles_command_buffer_flush(false);
+}
+
+void oc_gles_command_buffer_sync_stub(const oc_wasm_slot* restrict _params, oc_wasm_slot* restrict _returns, u8* _mem, oc_wasm* _wasm)
+{
+    oc_runtime_gles_command_buffer_flush(true);
+}
+
 int manual_link_gles_api(oc_wasm* wasm)
 {
 #define BINDING_ERROR_HANDLING(name)                                                                        \
@@ -1175,6 +1319,48 @@ int manual_link_gles_api(oc_wasm* wasm)
     status = oc_wasm_add_binding(wasm, &binding);
     BINDING_ERROR_HANDLING(glVertexAttribIPointer)
 
+    binding.importName = OC_STR8("glDrawArraysIndirect");
+    binding.proc = glDrawArraysIndirect_stub;
+    binding.countParams = 2;
+    binding.countReturns = 0;
+    status = oc_wasm_add_binding(wasm, &binding);
+    BINDING_ERROR_HANDLING(glDrawArraysIndirect)
+
+    binding.importName = OC_STR8("glDrawElementsIndirect");
+    binding.proc = glDrawElementsIndirect_stub;
+    binding.countParams = 3;
+    binding.countReturns = 0;
+    status = oc_wasm_add_binding(wasm, &binding);
+    BINDING_ERROR_HANDLING(glDrawElementsIndirect)
+
+    binding.importName = OC_STR8("glCreateShaderProgramv");
+    binding.proc = glCreateShaderProgramv_stub;
+    binding.countParams = 3;
+    binding.countReturns = 1;
+    status = oc_wasm_add_binding(wasm, &binding);
+    BINDING_ERROR_HANDLING(glCreateShaderProgramv)
+
+    binding.importName = OC_STR8("oc_gles_command_buffer_register");
+    binding.proc = oc_gles_command_buffer_register_stub;
+    binding.countParams = 1;
+    binding.countReturns = 0;
+    status = oc_wasm_add_binding(wasm, &binding);
+    BINDING_ERROR_HANDLING(oc_gles_command_buffer_register)
+
+    binding.importName = OC_STR8("oc_gles_command_buffer_flush");
+    binding.proc = oc_gles_command_buffer_flush_stub;
+    binding.countParams = 0;
+    binding.countReturns = 0;
+    status = oc_wasm_add_binding(wasm, &binding);
+    BINDING_ERROR_HANDLING(oc_gles_command_buffer_flush)
+
+    binding.importName = OC_STR8("oc_gles_command_buffer_sync");
+    binding.proc = oc_gles_command_buffer_sync_stub;
+    binding.countParams = 0;
+    binding.countReturns = 0;
+    status = oc_wasm_add_binding(wasm, &binding);
+    BINDING_ERROR_HANDLING(oc_gles_command_buffer_sync)
+
 #undef BINDING_ERROR_HANDLING
 
     return (ret);
@@ -16,3 +16,23 @@ u64 orca_image_upload_region_rgba8_length(oc_wasm* wasm, oc_rect rect)
     u64 len = rect.w * rect.h * pixelFormatWidth;
     return len;
 }
+
+u64 orca_tiled_image_upload_tile_length(oc_wasm* wasm, oc_image image, oc_image_tile tile)
+{
+    oc_rect rect = oc_tiled_image_tile_rect(image, tile);
+    u64 len = rect.w * rect.h * sizeof(u8) * 4;
+    return len;
+}
+
+u64 orca_image_upload_yuv_plane_length(oc_wasm* wasm, oc_image image, u32 plane)
+{
+    oc_vec2 size = oc_image_yuv_plane_size(image, plane);
+    u64 len = size.x * size.y * sizeof(u8);
+    return len;
+}
+
+u64 orca_image_surface_upload_rgba8_length(oc_wasm* wasm, u32 width, u32 height)
+{
+    u64 len = (u64)width * height * sizeof(u8) * 4;
+    return len;
+}
@@ -618,6 +618,222 @@ int test_rights()
     return (0);
 }
 
+//NOTE: key-value store tests. The store's log format is internal to platform_kv.c, which is part of this unity
+//      build, so the tests can forge a torn log file.
+
+static oc_str8 kv_test_value(oc_arena* arena, u32 batch, u32 key)
+{
+    return (oc_str8_pushf(arena, "value %u of key %u, padded to span a few records", batch, key));
+}
+
+static u64 kv_test_file_size(oc_str8 path)
+{
+    oc_file f = oc_file_open(path, OC_FILE_ACCESS_READ, 0);
+    u64 size = oc_file_size(f);
+    oc_file_close(f);
+    return (size);
+}
+
+static int kv_test_truncate(oc_str8 path, u64 size)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+    char* buffer = oc_arena_push(scratch.arena, size);
+
+    oc_file f = oc_file_open(path, OC_FILE_ACCESS_READ, 0);
+    u64 read = oc_file_read(f, size, buffer);
+    oc_file_close(f);
+
+    f = oc_file_open(path, OC_FILE_ACCESS_WRITE, OC_FILE_OPEN_TRUNCATE);
+    u64 written = oc_file_write(f, read, buffer);
+    oc_file_close(f);
+
+    oc_scratch_end(scratch);
+    return ((read == size && written == size) ? 0 : -1);
+}
+
+//NOTE: checks that keys [0, count) have the value of the batch in expected, or are missing if it is 0
+static int kv_test_check(oc_kv_store* store, u32 count, u32* expected)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+    int result = 0;
+
+    for(u32 key = 0; key < count && !result; key++)
+    {
+        oc_str8 keyStr = oc_str8_pushf(scratch.arena, "key %u", key);
+        oc_str8 value = oc_kv_get(store, scratch.arena, keyStr);
+
+        if(expected[key] == 0)
+        {
+            if(oc_kv_contains(store, keyStr))
+            {
+                oc_log_error("key %u should be missing\n", key);
+                result = -1;
+            }
+        }
+        else if(oc_str8_cmp(value, kv_test_value(scratch.arena, expected[key], key)))
+        {
+            oc_log_error("key %u has value '%.*s', expected the value of batch %u\n", key, oc_str8_ip(value), expected[key]);
+            result = -1;
+        }
+    }
+    oc_scratch_end(scratch);
+    return (result);
+}
+
+//NOTE: puts keys [first, first + count) with the value of batch, and commits them
+static int kv_test_put_batch(oc_kv_store* store, u32 batch, u32 first, u32 count, u32* expected)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+    for(u32 key = first; key < first + count; key++)
+    {
+        oc_kv_put(store, oc_str8_pushf(scratch.arena, "key %u", key), kv_test_value(scratch.arena, batch, key));
+        expected[key] = batch;
+    }
+    oc_scratch_end(scratch);
+
+    return (oc_kv_commit(store, OC_FILE_SYNC_NONE) == OC_IO_OK ? 0 : -1);
+}
+
+int test_kv()
+{
+    oc_log_info("key-value store\n");
+
+    oc_str8 path = OC_STR8("./data/kv_test");
+    oc_str8 paths[2] = { OC_STR8("./data/kv_test.0"), OC_STR8("./data/kv_test.1") };
+    remove(paths[0].ptr);
+    remove(paths[1].ptr);
+
+    enum
+    {
+        KEY_COUNT = 64,
+    };
+    u32 expected[KEY_COUNT] = { 0 };
+
+    //NOTE: commit two batches, then truncate the log in the middle of the second one, as if the app crashed while
+    //      writing it
+    oc_kv_store* store = oc_kv_open(path);
+    if(!store
+       || kv_test_put_batch(store, 1, 0, 32, expected)
+       || kv_test_check(store, KEY_COUNT, expected))
+    {
+        oc_log_error("couldn't put and commit the first batch\n");
+        return (-1);
+    }
+    oc_kv_close(store);
+
+    u64 firstBatchEnd = kv_test_file_size(paths[0]);
+    u32 committed[KEY_COUNT];
+    memcpy(committed, expected, sizeof(expected));
+
+    store = oc_kv_open(path);
+    if(!store || kv_test_put_batch(store, 2, 16, 32, expected))
+    {
+        oc_log_error("couldn't put and commit the second batch\n");
+        return (-1);
+    }
+    oc_kv_close(store);
+
+    u64 secondBatchEnd = kv_test_file_size(paths[0]);
+    if(kv_test_truncate(paths[0], firstBatchEnd + (secondBatchEnd - firstBatchEnd) / 2))
+    {
+        oc_log_error("couldn't truncate the log\n");
+        return (-1);
+    }
+
+    //NOTE: the torn batch is dropped, and new values written over it must not be read from the old log
+    memcpy(expected, committed, sizeof(expected));
+
+    store = oc_kv_open(path);
+    if(!store || kv_test_check(store, KEY_COUNT, expected))
+    {
+        oc_log_error("reopening a torn log should only keep the committed batch\n");
+        return (-1);
+    }
+    if(kv_test_put_batch(store, 3, 8, 48, expected) || kv_test_check(store, KEY_COUNT, expected))
+    {
+        oc_log_error("values committed after reopening a torn log are wrong\n");
+        return (-1);
+    }
+    oc_kv_delete(store, OC_STR8("key 9"));
+    expected[9] = 0;
+    if(oc_kv_commit(store, OC_FILE_SYNC_NONE) != OC_IO_OK || kv_test_check(store, KEY_COUNT, expected))
+    {
+        oc_log_error("couldn't delete a key\n");
+        return (-1);
+    }
+    oc_kv_close(store);
+
+    store = oc_kv_open(path);
+    if(!store || kv_test_check(store, KEY_COUNT, expected))
+    {
+        oc_log_error("values are wrong after reopening the store\n");
+        return (-1);
+    }
+    oc_kv_close(store);
+
+    //NOTE: forge a newer file with a torn batch, as if the app crashed while compacting into it. The store must fall
+    //      back to the older file.
+    {
+        oc_kv_file_header header = {
+            .magic = OC_KV_MAGIC,
+            .version = OC_KV_VERSION,
+            .generation = 1000,
+        };
+        oc_kv_record_header record = {
+            .kind = OC_KV_RECORD_PUT,
+            .keyLen = 5,
+            .valueLen = 4096,
+        };
+        oc_file f = oc_file_open(paths[1], OC_FILE_ACCESS_WRITE, OC_FILE_OPEN_CREATE | OC_FILE_OPEN_TRUNCATE);
+        oc_file_write(f, sizeof(header), (char*)&header);
+        oc_file_write(f, sizeof(record), (char*)&record);
+        oc_file_write(f, 5, "key 0");
+        oc_file_close(f);
+    }
+
+    store = oc_kv_open(path);
+    if(!store || kv_test_check(store, KEY_COUNT, expected))
+    {
+        oc_log_error("the store should fall back to the older file when the newer one has no complete batch\n");
+        return (-1);
+    }
+
+    //NOTE: overwrite the keys until the log is mostly dead records, so that commits compact it into the other file
+    for(u32 batch = 4; batch < 100; batch++)
+    {
+        if(kv_test_put_batch(store, batch, 0, KEY_COUNT / 2, expected))
+        {
+            oc_log_error("couldn't commit batch %u\n", batch);
+            return (-1);
+        }
+    }
+    if(kv_test_check(store, KEY_COUNT, expected))
+    {
+        oc_log_error("values are wrong after compaction\n");
+        return (-1);
+    }
+    oc_kv_close(store);
+
+    //NOTE: without compaction, the log would be several times that size
+    if(kv_test_file_size(paths[0]) + kv_test_file_size(paths[1]) > OC_KV_COMPACT_MIN_SIZE)
+    {
+        oc_log_error("the log wasn't compacted\n");
+        return (-1);
+    }
+
+    store = oc_kv_open(path);
+    if(!store || kv_test_check(store, KEY_COUNT, expected))
+    {
+        oc_log_error("values are wrong after reopening a compacted store\n");
+        return (-1);
+    }
+    oc_kv_close(store);
+
+    remove(paths[0].ptr);
+    remove(paths[1].ptr);
+    return (0);
+}
+
 int main(int argc, char** argv)
 {
     oc_arena_scope scratch = oc_scratch_begin();
@@ -655,6 +871,10 @@ int main(int argc, char** argv)
     {
         return (-1);
     }
+    if(test_kv())
+    {
+        return (-1);
+    }
 
     remove("./data/write_test.txt");
 
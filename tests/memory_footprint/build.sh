@@ -0,0 +1,17 @@
+#!/bin/bash
+
+BINDIR=bin
+LIBDIR=../../build/bin
+SRCDIR=../../src
+
+INCLUDES="-I$SRCDIR"
+LIBS="-L$LIBDIR -lorca"
+FLAGS="-mmacos-version-min=13.0.0 -DOC_DEBUG -DLOG_COMPILE_DEBUG"
+
+mkdir -p $BINDIR
+
+clang -g -O2 $FLAGS $LIBS $INCLUDES -o $BINDIR/test_memory_footprint main.c
+install_name_tool -add_rpath "@executable_path" $BINDIR/test_memory_footprint
+
+cp $LIBDIR/liborca.dylib $BINDIR/
+cp $LIBDIR/libwebgpu.dylib $BINDIR/
@@ -0,0 +1,460 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2024 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "orca.h"
+
+#if OC_PLATFORM_MACOS
+    #include <mach/mach.h>
+#elif OC_PLATFORM_WINDOWS
+    #include <psapi.h>
+#endif
+
+//NOTE: creates N objects of each subsystem and checks the resulting memory growth of the process against a budget per
+//      object recorded in budgets.txt:
+//
+//          ./bin/test_memory_footprint [--record] [--budgets path]
+//
+//      RSS is the resident size of the process. Committed memory is the memory the process is charged for whether
+//      it's resident or not: the physical footprint on macOS (which also counts GPU allocations on unified memory),
+//      the private commit charge on Windows. Each case runs once before being measured, so that one time costs (e.g.
+//      font library or renderer pipelines setup) aren't charged to it. --record writes the measured figures as the new
+//      budgets.
+
+//------------------------------------------------------------------------------------------
+// Process memory
+//------------------------------------------------------------------------------------------
+
+typedef struct footprint_snapshot
+{
+    i64 resident;
+    i64 committed;
+} footprint_snapshot;
+
+static footprint_snapshot footprint_snapshot_take(void)
+{
+    footprint_snapshot snapshot = { 0 };
+#if OC_PLATFORM_MACOS
+    task_vm_info_data_t info = { 0 };
+    mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+    if(task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&info, &count) == KERN_SUCCESS)
+    {
+        snapshot.resident = info.resident_size;
+        snapshot.committed = info.phys_footprint;
+    }
+#elif OC_PLATFORM_WINDOWS
+    PROCESS_MEMORY_COUNTERS_EX counters = { 0 };
+    if(GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&counters, sizeof(counters)))
+    {
+        snapshot.resident = counters.WorkingSetSize;
+        snapshot.committed = counters.PrivateUsage;
+    }
+#endif
+    return (snapshot);
+}
+
+//------------------------------------------------------------------------------------------
+// Cases
+//------------------------------------------------------------------------------------------
+
+enum
+{
+    FOOTPRINT_MAX_INSTANCES = 256,
+};
+
+typedef struct footprint_env
+{
+    oc_canvas_renderer renderer;
+    oc_str8 fontPath;
+    oc_str8 filePath;
+    oc_font uiFont;
+} footprint_env;
+
+//NOTE: each case creates 'count' objects in create(), and releases them in destroy()
+typedef struct footprint_case
+{
+    const char* name;
+    u32 count;
+    bool (*create)(footprint_env* env, u32 count, void** objects);
+    void (*destroy)(footprint_env* env, u32 count, void** objects);
+} footprint_case;
+
+static bool footprint_canvas_context_create(footprint_env* env, u32 count, void** objects)
+{
+    for(u32 i = 0; i < count; i++)
+    {
+        oc_canvas_context context = oc_canvas_context_create();
+        if(oc_canvas_context_is_nil(context))
+        {
+            return (false);
+        }
+        objects[i] = (void*)context.h;
+    }
+    return (true);
+}
+
+static void footprint_canvas_context_destroy(footprint_env* env, u32 count, void** objects)
+{
+    for(u32 i = 0; i < count; i++)
+    {
+        oc_canvas_context_destroy((oc_canvas_context){ (u64)objects[i] });
+    }
+}
+
+static bool footprint_font_create(footprint_env* env, u32 count, void** objects, u32 rangeCount, oc_unicode_range* ranges)
+{
+    for(u32 i = 0; i < count; i++)
+    {
+        oc_font font = oc_font_create_from_path(env->fontPath, rangeCount, ranges);
+        if(oc_font_is_nil(font))
+        {
+            return (false);
+        }
+        objects[i] = (void*)font.h;
+    }
+    return (true);
+}
+
+static bool footprint_font_latin_create(footprint_env* env, u32 count, void** objects)
+{
+    oc_unicode_range ranges[] = { OC_UNICODE_BASIC_LATIN };
+    return (footprint_font_create(env, count, objects, 1, ranges));
+}
+
+static bool footprint_font_extended_create(footprint_env* env, u32 count, void** objects)
+{
+    oc_unicode_range ranges[] = {
+        OC_UNICODE_BASIC_LATIN,
+        OC_UNICODE_C1_CONTROLS_AND_LATIN_1_SUPPLEMENT,
+        OC_UNICODE_LATIN_EXTENDED_A,
+        OC_UNICODE_LATIN_EXTENDED_B,
+        OC_UNICODE_GREEK_COPTIC,
+        OC_UNICODE_CYRILLIC,
+        OC_UNICODE_GENERAL_PUNCTUATION,
+        OC_UNICODE_SPECIALS,
+    };
+    return (footprint_font_create(env, count, objects, sizeof(ranges) / sizeof(oc_unicode_range), ranges));
+}
+
+static bool footprint_font_lazy_create(footprint_env* env, u32 count, void** objects)
+{
+    oc_unicode_range ranges[] = {
+        OC_UNICODE_BASIC_LATIN,
+        OC_UNICODE_C1_CONTROLS_AND_LATIN_1_SUPPLEMENT,
+        OC_UNICODE_LATIN_EXTENDED_A,
+        OC_UNICODE_LATIN_EXTENDED_B,
+        OC_UNICODE_SPECIALS,
+    };
+    for(u32 i = 0; i < count; i++)
+    {
+        oc_font font = oc_font_create_from_path_lazy(env->fontPath, sizeof(ranges) / sizeof(oc_unicode_range), ranges, 64);
+        if(oc_font_is_nil(font))
+        {
+            return (false);
+        }
+        objects[i] = (void*)font.h;
+    }
+    return (true);
+}
+
+static void footprint_font_destroy(footprint_env* env, u32 count, void** objects)
+{
+    for(u32 i = 0; i < count; i++)
+    {
+        oc_font_destroy((oc_font){ (u64)objects[i] });
+    }
+}
+
+static bool footprint_image_create(footprint_env* env, u32 count, void** objects)
+{
+    for(u32 i = 0; i < count; i++)
+    {
+        oc_image image = oc_image_create(env->renderer, 256, 256);
+        if(oc_image_is_nil(image))
+        {
+            return (false);
+        }
+        objects[i] = (void*)image.h;
+    }
+    return (true);
+}
+
+static void footprint_image_destroy(footprint_env* env, u32 count, void** objects)
+{
+    for(u32 i = 0; i < count; i++)
+    {
+        oc_image_destroy((oc_image){ (u64)objects[i] });
+    }
+}
+
+//NOTE: a UI context only allocates its pools and maps when it builds a frame, so each context builds a small panel
+static bool footprint_ui_context_create(footprint_env* env, u32 count, void** objects)
+{
+    oc_ui_style defaultStyle = { .font = env->uiFont, .fontSize = 14, .color = { 1, 1, 1, 1 } };
+    oc_ui_style_mask defaultMask = OC_UI_STYLE_FONT | OC_UI_STYLE_FONT_SIZE | OC_UI_STYLE_COLOR;
+
+    for(u32 i = 0; i < count; i++)
+    {
+        oc_ui_context* ui = oc_malloc_type(oc_ui_context);
+        oc_ui_init(ui);
+        objects[i] = ui;
+
+        oc_vec2 size = { 800, 600 };
+        oc_ui_frame(size, &defaultStyle, defaultMask)
+        {
+            for(u32 j = 0; j < 32; j++)
+            {
+                oc_ui_label("footprint");
+            }
+        }
+    }
+    return (true);
+}
+
+static void footprint_ui_context_destroy(footprint_env* env, u32 count, void** objects)
+{
+    for(u32 i = 0; i < count; i++)
+    {
+        oc_ui_set_context((oc_ui_context*)objects[i]);
+        oc_ui_cleanup();
+        free(objects[i]);
+    }
+}
+
+static bool footprint_file_create(footprint_env* env, u32 count, void** objects)
+{
+    for(u32 i = 0; i < count; i++)
+    {
+        oc_file file = oc_file_open(env->filePath, OC_FILE_ACCESS_READ, OC_FILE_OPEN_NONE);
+        if(oc_file_last_error(file) != OC_IO_OK)
+        {
+            oc_file_close(file);
+            return (false);
+        }
+        objects[i] = (void*)file.h;
+    }
+    return (true);
+}
+
+static void footprint_file_destroy(footprint_env* env, u32 count, void** objects)
+{
+    for(u32 i = 0; i < count; i++)
+    {
+        oc_file_close((oc_file){ (u64)objects[i] });
+    }
+}
+
+static footprint_case FOOTPRINT_CASES[] = {
+    { "canvas_context", 16, footprint_canvas_context_create, footprint_canvas_context_destroy },
+    { "font_latin", 8, footprint_font_latin_create, footprint_font_destroy },
+    { "font_extended", 8, footprint_font_extended_create, footprint_font_destroy },
+    { "font_lazy", 8, footprint_font_lazy_create, footprint_font_destroy },
+    { "image_256", 32, footprint_image_create, footprint_image_destroy },
+    { "ui_context", 8, footprint_ui_context_create, footprint_ui_context_destroy },
+    { "file_handle", 256, footprint_file_create, footprint_file_destroy },
+};
+
+static const u32 FOOTPRINT_CASE_COUNT = sizeof(FOOTPRINT_CASES) / sizeof(footprint_case);
+
+//------------------------------------------------------------------------------------------
+// Budgets
+//------------------------------------------------------------------------------------------
+
+//NOTE: budgets.txt holds one line per case: name, resident bytes and committed bytes per object. Lines starting with
+//      '#' are comments.
+typedef struct footprint_budget
+{
+    bool found;
+    i64 resident;
+    i64 committed;
+} footprint_budget;
+
+static footprint_budget footprint_budget_find(oc_arena* arena, oc_str8 budgets, const char* name)
+{
+    footprint_budget budget = { 0 };
+
+    oc_str8_list separators = { 0 };
+    oc_str8_list_push(arena, &separators, OC_STR8("\n"));
+    oc_str8_list lines = oc_str8_split(arena, budgets, separators);
+
+    oc_str8_list_for(lines, elt)
+    {
+        oc_str8 line = elt->string;
+        if(!line.len || line.ptr[0] == '#')
+        {
+            continue;
+        }
+        char* cline = oc_str8_to_cstring(arena, line);
+        char lineName[64];
+        long long resident = 0;
+        long long committed = 0;
+        if(sscanf(cline, "%63s %lld %lld", lineName, &resident, &committed) == 3 && !strcmp(lineName, name))
+        {
+            budget.found = true;
+            budget.resident = resident;
+            budget.committed = committed;
+            break;
+        }
+    }
+    return (budget);
+}
+
+static oc_str8 footprint_budgets_read(oc_arena* arena, oc_str8 path)
+{
+    oc_str8 contents = { 0 };
+    oc_file file = oc_file_open(path, OC_FILE_ACCESS_READ, OC_FILE_OPEN_NONE);
+    if(oc_file_last_error(file) == OC_IO_OK)
+    {
+        u64 size = oc_file_size(file);
+        contents.ptr = oc_arena_push(arena, size);
+        contents.len = oc_file_read(file, size, contents.ptr);
+    }
+    oc_file_close(file);
+    return (contents);
+}
+
+//------------------------------------------------------------------------------------------
+// Driver
+//------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    oc_log_set_level(OC_LOG_LEVEL_WARNING);
+
+    bool record = false;
+    oc_str8 budgetsPath = OC_STR8("./budgets.txt");
+    //NOTE: objects are allowed to use this much more than their budget, to absorb allocator noise
+    f64 tolerance = 0.1;
+
+    for(int argIndex = 1; argIndex < argc; argIndex++)
+    {
+        if(!strcmp(argv[argIndex], "--record"))
+        {
+            record = true;
+        }
+        else if(!strcmp(argv[argIndex], "--budgets") && argIndex + 1 < argc)
+        {
+            argIndex++;
+            budgetsPath = OC_STR8(argv[argIndex]);
+        }
+        else
+        {
+            oc_log_error("usage: %s [--record] [--budgets path]\n", argv[0]);
+            return (-1);
+        }
+    }
+
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_init();
+
+    footprint_env env = {
+        .fontPath = OC_STR8("../perf/resources/CMUSerif-Roman.ttf"),
+        .filePath = OC_STR8("./main.c"),
+    };
+    env.renderer = oc_canvas_renderer_create();
+    if(oc_canvas_renderer_is_nil(env.renderer))
+    {
+        oc_log_error("couldn't create renderer\n");
+        return (-1);
+    }
+
+    oc_unicode_range uiRanges[] = { OC_UNICODE_BASIC_LATIN };
+    env.uiFont = oc_font_create_from_path(env.fontPath, 1, uiRanges);
+    if(oc_font_is_nil(env.uiFont))
+    {
+        oc_log_error("couldn't create font\n");
+        return (-1);
+    }
+
+    oc_str8 budgets = footprint_budgets_read(scratch.arena, budgetsPath);
+    oc_str8_list recorded = { 0 };
+    oc_str8_list_push(scratch.arena, &recorded, OC_STR8("# name, resident bytes and committed bytes per object\n"));
+
+    void** objects = oc_arena_push_array(scratch.arena, void*, FOOTPRINT_MAX_INSTANCES);
+    int result = 0;
+
+    printf("%-16s %6s %14s %14s %14s %14s\n", "case", "count", "resident/obj", "budget", "committed/obj", "budget");
+
+    for(u32 caseIndex = 0; caseIndex < FOOTPRINT_CASE_COUNT; caseIndex++)
+    {
+        footprint_case* test = &FOOTPRINT_CASES[caseIndex];
+
+        //NOTE: warm up
+        if(!test->create(&env, test->count, objects))
+        {
+            oc_log_error("%s: couldn't create objects\n", test->name);
+            result = -1;
+            continue;
+        }
+        test->destroy(&env, test->count, objects);
+
+        footprint_snapshot before = footprint_snapshot_take();
+        test->create(&env, test->count, objects);
+        footprint_snapshot after = footprint_snapshot_take();
+        test->destroy(&env, test->count, objects);
+
+        i64 resident = oc_max(after.resident - before.resident, 0) / test->count;
+        i64 committed = oc_max(after.committed - before.committed, 0) / test->count;
+
+        oc_str8_list_pushf(scratch.arena, &recorded, "%s %lld %lld\n", test->name, (long long)resident, (long long)committed);
+
+        footprint_budget budget = footprint_budget_find(scratch.arena, budgets, test->name);
+        const char* status = "";
+        if(!budget.found)
+        {
+            status = "  (no budget)";
+        }
+        else if(resident > budget.resident * (1 + tolerance) || committed > budget.committed * (1 + tolerance))
+        {
+            status = "  OVER BUDGET";
+            if(!record)
+            {
+                result = -1;
+            }
+        }
+
+        printf("%-16s %6u %14lld %14lld %14lld %14lld%s\n",
+               test->name,
+               test->count,
+               (long long)resident,
+               (long long)budget.resident,
+               (long long)committed,
+               (long long)budget.committed,
+               status);
+    }
+
+    if(record)
+    {
+        oc_str8 contents = oc_str8_list_join(scratch.arena, recorded);
+        oc_file file = oc_file_open(budgetsPath, OC_FILE_ACCESS_WRITE, OC_FILE_OPEN_CREATE | OC_FILE_OPEN_TRUNCATE);
+        oc_file_write(file, contents.len, contents.ptr);
+        if(oc_file_last_error(file) != OC_IO_OK)
+        {
+            oc_log_error("couldn't write budgets to %.*s\n", oc_str8_ip(budgetsPath));
+            result = -1;
+        }
+        else
+        {
+            printf("recorded budgets to %.*s\n", oc_str8_ip(budgetsPath));
+        }
+        oc_file_close(file);
+    }
+
+    oc_font_destroy(env.uiFont);
+    oc_canvas_renderer_destroy(env.renderer);
+    oc_scratch_end(scratch);
+
+    if(result == 0)
+    {
+        printf("OK\n");
+    }
+    return (result);
+}
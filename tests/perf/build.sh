@@ -13,6 +13,9 @@ mkdir -p $BINDIR
 clang -g -O3 $FLAGS $LIBS $INCLUDES -o $BINDIR/driver driver.c
 install_name_tool -add_rpath "@executable_path" $BINDIR/driver
 
+clang -g -O3 $FLAGS $LIBS $INCLUDES -o $BINDIR/ui_driver ui_driver.c
+install_name_tool -add_rpath "@executable_path" $BINDIR/ui_driver
+
 cp Info.plist $BINDIR/
 cp $LIBDIR/liborca.dylib $BINDIR/
 cp $LIBDIR/libwebgpu.dylib $BINDIR/
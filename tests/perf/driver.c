@@ -20,10 +20,12 @@ typedef struct perf_test perf_test;
 
 typedef perf_test (*test_init_proc)(oc_arena* arena, oc_rect contentRect, oc_canvas_renderer renderer, int argc, char** argv);
 typedef void (*test_draw_proc)(void* user);
+typedef void (*test_render_proc)(void* user, oc_canvas_renderer renderer, oc_surface surface);
 
 struct perf_test
 {
     test_draw_proc draw;
+    test_render_proc render; // submits the frame itself instead of rendering the canvas context, if not null
     void* data;
 };
 
@@ -40,6 +42,7 @@ typedef struct shape_test_data
 {
     u32 count;
     f32 size;
+    f32 lineWidth;
     bool stroke;
     bool textured;
     bool translucent;
@@ -64,6 +67,7 @@ perf_test shapes_init(oc_arena* arena,
     test_draw_proc draw = triangles_draw;
     data->count = 10000;
     data->size = 30;
+    data->lineWidth = 1;
 
     bool error = false;
     for(int argIndex = 0; argIndex < argc; argIndex++)
@@ -128,6 +132,24 @@ perf_test shapes_init(oc_arena* arena,
                 break;
             }
         }
+        else if(!strcmp(argv[argIndex], "-w") || !strcmp(argv[argIndex], "--line-width"))
+        {
+            if(argIndex + 1 >= argc || argv[argIndex + 1][0] == '-')
+            {
+                oc_log_error("option %s needs an argument\n", argv[argIndex]);
+                error = true;
+                break;
+            }
+            argIndex++;
+            char* end = 0;
+            data->lineWidth = strtof(argv[argIndex], &end);
+            if(end == argv[argIndex] || end[0] != '\0')
+            {
+                oc_log_error("option %s should be a number\n", argv[argIndex - 1]);
+                error = true;
+                break;
+            }
+        }
         else if(!strcmp(argv[argIndex], "--stroke"))
         {
             data->stroke = true;
@@ -188,6 +210,7 @@ void triangles_draw(void* user)
 
     oc_set_color_rgba(0, 1, 1, 1);
     oc_clear();
+    oc_set_width(data->lineWidth);
 
     for(int i = 0; i < data->count; i++)
     {
@@ -225,6 +248,7 @@ void circles_draw(void* user)
 
     oc_set_color_rgba(0, 1, 1, 1);
     oc_clear();
+    oc_set_width(data->lineWidth);
 
     for(int i = 0; i < data->count; i++)
     {
@@ -468,6 +492,121 @@ void image_batches_draw(void* user)
     }
 }
 
+//------------------------------------------------------------------------------------------
+// Clip Stack Test
+//------------------------------------------------------------------------------------------
+
+typedef struct clip_stack_data
+{
+    u32 count;
+    u32 depth;
+    oc_rect* rects;
+    oc_color* colors;
+
+} clip_stack_data;
+
+void clip_stack_draw(void* user);
+
+perf_test clip_stack_init(oc_arena* arena,
+                          oc_rect contentRect,
+                          oc_canvas_renderer renderer,
+                          int argc,
+                          char** argv)
+{
+    clip_stack_data* data = oc_arena_push_type(arena, clip_stack_data);
+    memset(data, 0, sizeof(clip_stack_data));
+
+    //defaults
+    data->count = 200;
+    data->depth = 16;
+
+    bool error = false;
+    for(int argIndex = 0; argIndex < argc; argIndex++)
+    {
+        u32* value = 0;
+        if(!strcmp(argv[argIndex], "-c") || !strcmp(argv[argIndex], "--count"))
+        {
+            value = &data->count;
+        }
+        else if(!strcmp(argv[argIndex], "-d") || !strcmp(argv[argIndex], "--depth"))
+        {
+            value = &data->depth;
+        }
+        else
+        {
+            continue;
+        }
+
+        if(argIndex + 1 >= argc || argv[argIndex + 1][0] == '-')
+        {
+            oc_log_error("option %s needs an argument\n", argv[argIndex]);
+            error = true;
+            break;
+        }
+        argIndex++;
+        char* end = 0;
+        *value = strtoul(argv[argIndex], &end, 10);
+        if(end == argv[argIndex] || end[0] != '\0')
+        {
+            oc_log_error("option %s should be an integer\n", argv[argIndex - 1]);
+            error = true;
+            break;
+        }
+    }
+    if(error)
+    {
+        return ((perf_test){ 0 });
+    }
+
+    //NOTE: each stack is a chain of overlapping clip rects that shrink and drift towards a random corner
+    data->rects = oc_arena_push_array(arena, oc_rect, data->count);
+    data->colors = oc_arena_push_array(arena, oc_color, data->count);
+    for(int i = 0; i < data->count; i++)
+    {
+        data->rects[i] = (oc_rect){
+            rand() % (u32)contentRect.w,
+            rand() % (u32)contentRect.h,
+            100 + rand() % 200,
+            100 + rand() % 200,
+        };
+        data->colors[i] = (oc_color){
+            (rand() % 255) / 255.,
+            (rand() % 255) / 255.,
+            (rand() % 255) / 255.,
+            1,
+        };
+    }
+
+    perf_test test = { .draw = clip_stack_draw, .data = data };
+    return (test);
+}
+
+void clip_stack_draw(void* user)
+{
+    clip_stack_data* data = (clip_stack_data*)user;
+
+    oc_set_color_rgba(0, 1, 1, 1);
+    oc_clear();
+
+    for(int i = 0; i < data->count; i++)
+    {
+        oc_rect rect = data->rects[i];
+        for(int level = 0; level < data->depth; level++)
+        {
+            f32 inset = level * 2;
+            oc_clip_push(rect.x + inset, rect.y + inset * 0.5, rect.w - inset, rect.h - inset);
+        }
+
+        oc_set_color(data->colors[i]);
+        oc_circle_fill(rect.x + rect.w / 2, rect.y + rect.h / 2, rect.w / 2);
+
+        for(int level = 0; level < data->depth; level++)
+        {
+            oc_clip_pop();
+        }
+    }
+}
+
 //------------------------------------------------------------------------------------------
 // Wall of Text Test
 //------------------------------------------------------------------------------------------
@@ -613,7 +752,13 @@ void wall_text_draw(void* user)
 
 #include "tiger_cmd.c"
 
+typedef struct svg_test_data
+{
+    oc_display_list displayList;
+} svg_test_data;
+
 void svg_draw_tiger(void* user);
+void svg_draw_tiger_display_list(void* user);
 
 perf_test svg_init(oc_arena* arena,
                    oc_rect contentRect,
@@ -622,8 +767,27 @@ perf_test svg_init(oc_arena* arena,
                    char** argv)
 {
     //TODO: later add other test svg
+    svg_test_data* data = oc_arena_push_type(arena, svg_test_data);
+    memset(data, 0, sizeof(svg_test_data));
+
     test_draw_proc draw = svg_draw_tiger;
-    perf_test test = { .draw = draw, .data = 0 };
+
+    for(int argIndex = 0; argIndex < argc; argIndex++)
+    {
+        if(!strcmp(argv[argIndex], "--display-list"))
+        {
+            draw = svg_draw_tiger_display_list;
+        }
+    }
+
+    if(draw == svg_draw_tiger_display_list)
+    {
+        oc_display_list_begin_record();
+        draw_tiger();
+        data->displayList = oc_display_list_end_record();
+    }
+
+    perf_test test = { .draw = draw, .data = data };
     return (test);
 }
 
@@ -641,6 +805,83 @@ void svg_draw_tiger(void* user)
     oc_matrix_pop();
 }
 
+void svg_draw_tiger_display_list(void* user)
+{
+    svg_test_data* data = (svg_test_data*)user;
+
+    oc_set_color_rgba(0, 1, 1, 1);
+    oc_clear();
+
+    f32 startX = 300, startY = 200;
+    oc_display_list_draw(data->displayList,
+                         (oc_mat2x3){ 1, 0, startX,
+                                      0, 1, startY });
+}
+
+//------------------------------------------------------------------------------------------
+// Replay Test
+//------------------------------------------------------------------------------------------
+
+typedef struct replay_test_data
+{
+    oc_wgpu_canvas_capture capture;
+    bool sizeChecked;
+} replay_test_data;
+
+void replay_draw(void* user);
+void replay_render(void* user, oc_canvas_renderer renderer, oc_surface surface);
+
+perf_test replay_init(oc_arena* arena,
+                      oc_rect contentRect,
+                      oc_canvas_renderer renderer,
+                      int argc,
+                      char** argv)
+{
+    perf_test test = { 0 };
+
+    if(argc < 1)
+    {
+        oc_log_error("replay needs a capture file\n");
+        return (test);
+    }
+
+    replay_test_data* data = oc_arena_push_type(arena, replay_test_data);
+    memset(data, 0, sizeof(replay_test_data));
+
+    data->capture = oc_wgpu_canvas_capture_load(arena, renderer, OC_STR8(argv[0]));
+    if(!data->capture.mapping.ptr)
+    {
+        return (test);
+    }
+
+    test = (perf_test){ .draw = replay_draw, .render = replay_render, .data = data };
+    return (test);
+}
+
+void replay_draw(void* user)
+{
+}
+
+void replay_render(void* user, oc_canvas_renderer renderer, oc_surface surface)
+{
+    replay_test_data* data = (replay_test_data*)user;
+
+    //NOTE: the frame is replayed with the captured settings, only the window size comes from the driver's options
+    if(!data->sizeChecked)
+    {
+        oc_vec2 size = oc_surface_get_size(surface);
+        oc_vec2 scale = oc_surface_contents_scaling(surface);
+        if(data->capture.surfaceSize.x != size.x * scale.x || data->capture.surfaceSize.y != size.y * scale.y)
+        {
+            oc_log_warning("capture was made on a %.0fx%.0f pixels surface, use --resolution to replay it at the same size\n",
+                           data->capture.surfaceSize.x,
+                           data->capture.surfaceSize.y);
+        }
+        data->sizeChecked = true;
+    }
+    oc_wgpu_canvas_capture_replay(renderer, surface, &data->capture);
+}
+
 //------------------------------------------------------------------------------------------
 // Tests table
 //------------------------------------------------------------------------------------------
@@ -661,8 +902,10 @@ test_entry TESTS[] = {
     TEST(shapes),
     TEST(full_screen_quads),
     TEST(image_batches),
+    TEST(clip_stack),
     TEST(wall_text),
     TEST(svg),
+    TEST(replay),
 };
 const u32 TEST_COUNT = sizeof(TESTS) / sizeof(perf_test);
 
@@ -670,12 +913,123 @@ const u32 TEST_COUNT = sizeof(TESTS) / sizeof(perf_test);
 // Driver
 //------------------------------------------------------------------------------------------
 
+void print_stats_text(oc_wgpu_canvas_frame_stats* stats)
+{
+    printf("GPU Frame Time\n"
+           "  smp: %llu\n"
+           "  min: %.2fms\n"
+           "  max: %.2fms\n"
+           "  avg: %.2fms\n"
+           "  std: %.2f\n"
+           "CPU Encode Time\n"
+           "  smp: %llu\n"
+           "  min: %.2fms\n"
+           "  max: %.2fms\n"
+           "  avg: %.2fms\n"
+           "  std: %.2f\n"
+           "CPU Frame Time\n"
+           "  smp: %llu\n"
+           "  min: %.2fms (%.0ffps)\n"
+           "  max: %.2fms (%.0ffps)\n"
+           "  avg: %.2fms (%.0ffps)\n"
+           "  std: %.2f\n",
+           stats->gpuTime.sampleCount,
+           stats->gpuTime.minSample,
+           stats->gpuTime.maxSample,
+           stats->gpuTime.avg,
+           stats->gpuTime.std,
+           stats->cpuEncodeTime.sampleCount,
+           stats->cpuEncodeTime.minSample,
+           stats->cpuEncodeTime.maxSample,
+           stats->cpuEncodeTime.avg,
+           stats->cpuEncodeTime.std,
+           stats->cpuFrameTime.sampleCount,
+           stats->cpuFrameTime.minSample,
+           1000 / stats->cpuFrameTime.minSample,
+           stats->cpuFrameTime.maxSample,
+           1000 / stats->cpuFrameTime.maxSample,
+           stats->cpuFrameTime.avg,
+           1000 / stats->cpuFrameTime.avg,
+           stats->cpuFrameTime.std);
+
+    printf("GPU Passes (avg)\n");
+    for(int passIndex = 0; passIndex < OC_WGPU_CANVAS_PASS_COUNT; passIndex++)
+    {
+        printf("  %s: %.3fms\n", oc_wgpu_canvas_pass_name(passIndex), stats->passTime[passIndex].avg);
+    }
+    printf("Memory\n"
+           "  buffers: %.2fMB\n"
+           "  image array: %.2fMB\n",
+           stats->bufferMemory / (1024. * 1024.),
+           stats->imageArrayMemory / (1024. * 1024.));
+}
+
+void print_stats_csv(oc_wgpu_canvas_frame_stats* stats)
+{
+    printf("%llu ; %.2f ; %.2f ; %.2f ; %.2f ; %llu ; %.2f ; %.2f ; %.2f ; %.2f ; %llu ; %.2f ; %.2f ; %.2f ; %.2f \n",
+           stats->gpuTime.sampleCount,
+           stats->gpuTime.minSample,
+           stats->gpuTime.maxSample,
+           stats->gpuTime.avg,
+           stats->gpuTime.std,
+           stats->cpuEncodeTime.sampleCount,
+           stats->cpuEncodeTime.minSample,
+           stats->cpuEncodeTime.maxSample,
+           stats->cpuEncodeTime.avg,
+           stats->cpuEncodeTime.std,
+           stats->cpuFrameTime.sampleCount,
+           stats->cpuFrameTime.minSample,
+           stats->cpuFrameTime.maxSample,
+           stats->cpuFrameTime.avg,
+           stats->cpuFrameTime.std);
+}
+
+void print_stats_json_entry(const char* name, oc_wgpu_canvas_stats* stats, bool last)
+{
+    printf("\"%s\": {\"smp\": %llu, \"min\": %.4f, \"max\": %.4f, \"avg\": %.4f, \"std\": %.4f}%s",
+           name,
+           stats->sampleCount,
+           stats->sampleCount ? stats->minSample : 0,
+           stats->sampleCount ? stats->maxSample : 0,
+           stats->avg,
+           stats->std,
+           last ? "" : ", ");
+}
+
+//NOTE: prints one JSON object per run, which perf_suite.py collects into a results file
+void print_stats_json(const char* testName, oc_vec2 size, u32 msaaSampleCount, oc_wgpu_canvas_frame_stats* stats)
+{
+    printf("{\"test\": \"%s\", \"width\": %.0f, \"height\": %.0f, \"msaa\": %u, ",
+           testName,
+           size.x,
+           size.y,
+           (msaaSampleCount == OC_CANVAS_SAMPLE_COUNT_ANALYTIC) ? 0 : msaaSampleCount);
+
+    print_stats_json_entry("gpu", &stats->gpuTime, false);
+    print_stats_json_entry("cpu_encode", &stats->cpuEncodeTime, false);
+    print_stats_json_entry("cpu_frame", &stats->cpuFrameTime, false);
+
+    printf("\"passes\": {");
+    for(int passIndex = 0; passIndex < OC_WGPU_CANVAS_PASS_COUNT; passIndex++)
+    {
+        print_stats_json_entry(oc_wgpu_canvas_pass_name(passIndex),
+                               &stats->passTime[passIndex],
+                               passIndex == OC_WGPU_CANVAS_PASS_COUNT - 1);
+    }
+    printf("}, \"memory\": {\"buffers\": %llu, \"image_array\": %llu}}\n",
+           (unsigned long long)stats->bufferMemory,
+           (unsigned long long)stats->imageArrayMemory);
+}
+
 int main(int argc, char** argv)
 {
     oc_log_set_level(OC_LOG_LEVEL_WARNING);
     bool autoMode = false;
     bool csvOutput = false;
+    bool jsonOutput = false;
     int autoCount = 100;
+    u32 msaaSampleCount = 8;
+    oc_vec2 windowSize = { 800, 600 };
     int argIndex = 1;
     for(; argIndex < argc; argIndex++)
     {
@@ -686,6 +1040,7 @@ int main(int argc, char** argv)
             if(argIndex >= argc)
             {
                 oc_log_error("option %s should have an integer argument\n", argv[argIndex - 1]);
+                return (-1);
             }
             char* end = 0;
             autoCount = strtoul(argv[argIndex], &end, 10);
@@ -699,6 +1054,51 @@ int main(int argc, char** argv)
         {
             csvOutput = true;
         }
+        else if(!strcmp(argv[argIndex], "--json"))
+        {
+            jsonOutput = true;
+        }
+        else if(!strcmp(argv[argIndex], "--msaa"))
+        {
+            argIndex++;
+            char* end = 0;
+            if(argIndex < argc && !strcmp(argv[argIndex], "analytic"))
+            {
+                msaaSampleCount = OC_CANVAS_SAMPLE_COUNT_ANALYTIC;
+            }
+            else
+            {
+                if(argIndex < argc)
+                {
+                    msaaSampleCount = strtoul(argv[argIndex], &end, 10);
+                }
+                if(argIndex >= argc
+                   || end == argv[argIndex]
+                   || end[0] != '\0'
+                   || (msaaSampleCount != 1 && msaaSampleCount != 2 && msaaSampleCount != 4 && msaaSampleCount != 8))
+                {
+                    oc_log_error("option %s should be 1, 2, 4, 8 or analytic\n", argv[argIndex - 1]);
+                    return (-1);
+                }
+            }
+        }
+        else if(!strcmp(argv[argIndex], "--resolution"))
+        {
+            argIndex++;
+            u32 width = 0;
+            u32 height = 0;
+            int len = 0;
+            if(argIndex >= argc
+               || sscanf(argv[argIndex], "%ux%u%n", &width, &height, &len) != 2
+               || argv[argIndex][len] != '\0'
+               || !width
+               || !height)
+            {
+                oc_log_error("option %s should have a <width>x<height> argument\n", argv[argIndex - 1]);
+                return (-1);
+            }
+            windowSize = (oc_vec2){ width, height };
+        }
         else
         {
             break;
@@ -734,7 +1134,7 @@ int main(int argc, char** argv)
     //NOTE: create window renderer, surface, and context
     oc_init();
 
-    oc_rect windowRect = { .x = 100, .y = 100, .w = 800, .h = 600 };
+    oc_rect windowRect = { .x = 100, .y = 100, .w = windowSize.x, .h = windowSize.y };
     oc_window window = oc_window_create(windowRect, OC_STR8("renderer perf tests"), 0);
     oc_rect contentRect = oc_window_get_content_rect(window);
 
@@ -749,7 +1149,7 @@ int main(int argc, char** argv)
         renderer,
         &(oc_wgpu_canvas_record_options){
             .maxRecordCount = autoCount,
-            .timingFlags = OC_WGPU_CANVAS_TIMING_FRAME,
+            .timingFlags = OC_WGPU_CANVAS_TIMING_ALL,
         });
 
     oc_surface surface = oc_canvas_surface_create_for_window(renderer, window);
@@ -765,15 +1165,12 @@ int main(int argc, char** argv)
         oc_log_error("Error: couldn't create canvas\n");
         return (-1);
     }
+    oc_canvas_context_set_msaa_sample_count(context, msaaSampleCount);
 
     // start app
     oc_window_bring_to_front(window);
     oc_window_focus(window);
 
-    f64 frameTime = 0;
-
-    const u32 SHAPE_COUNT = 100000;
-
     perf_test test = testEntry->init(programScratch.arena, contentRect, renderer, argc - argIndex, argv + argIndex);
     if(!test.draw)
     {
@@ -786,7 +1183,6 @@ int main(int argc, char** argv)
     while(!oc_should_quit())
     {
         oc_arena_scope frameScratch = oc_scratch_begin();
-        f64 startTime = oc_clock_time(OC_CLOCK_MONOTONIC);
 
         oc_pump_events(0);
         oc_event* event = 0;
@@ -807,7 +1203,14 @@ int main(int argc, char** argv)
 
         test.draw(test.data);
 
-        oc_canvas_render(renderer, context, surface);
+        if(test.render)
+        {
+            test.render(test.data, renderer, surface);
+        }
+        else
+        {
+            oc_canvas_render(renderer, context, surface);
+        }
         oc_canvas_present(renderer, surface);
 
         oc_scratch_end(frameScratch);
@@ -825,42 +1228,7 @@ int main(int argc, char** argv)
         }
         else if(!autoMode)
         {
-            printf("GPU Frame Time\n"
-                   "  smp: %llu\n"
-                   "  min: %.2fms\n"
-                   "  max: %.2fms\n"
-                   "  avg: %.2fms\n"
-                   "  std: %.2f\n"
-                   "CPU Encode Time\n"
-                   "  smp: %llu\n"
-                   "  min: %.2fms\n"
-                   "  max: %.2fms\n"
-                   "  avg: %.2fms\n"
-                   "  std: %.2f\n"
-                   "CPU Frame Time\n"
-                   "  smp: %llu\n"
-                   "  min: %.2fms (%.0ffps)\n"
-                   "  max: %.2fms (%.0ffps)\n"
-                   "  avg: %.2fms (%.0ffps)\n"
-                   "  std: %.2f\n",
-                   stats.gpuTime.sampleCount,
-                   stats.gpuTime.minSample,
-                   stats.gpuTime.maxSample,
-                   stats.gpuTime.avg,
-                   stats.gpuTime.std,
-                   stats.cpuEncodeTime.sampleCount,
-                   stats.cpuEncodeTime.minSample,
-                   stats.cpuEncodeTime.maxSample,
-                   stats.cpuEncodeTime.avg,
-                   stats.cpuEncodeTime.std,
-                   stats.cpuFrameTime.sampleCount,
-                   stats.cpuFrameTime.minSample,
-                   1000 / (stats.cpuFrameTime.minSample),
-                   stats.cpuFrameTime.maxSample,
-                   1000 / (stats.cpuFrameTime.maxSample),
-                   stats.cpuFrameTime.avg,
-                   1000 / (stats.cpuFrameTime.avg),
-                   stats.cpuFrameTime.std);
+            print_stats_text(&stats);
         }
     }
 
@@ -868,63 +1236,17 @@ int main(int argc, char** argv)
     {
         oc_wgpu_canvas_frame_stats stats = oc_wgpu_canvas_get_frame_stats(renderer, autoCount);
 
-        if(csvOutput)
-        {
-            printf("%llu ; %.2f ; %.2f ; %.2f ; %.2f ; %llu ; %.2f ; %.2f ; %.2f ; %.2f ; %llu ; %.2f ; %.2f ; %.2f ; %.2f \n",
-                   stats.gpuTime.sampleCount,
-                   stats.gpuTime.minSample,
-                   stats.gpuTime.maxSample,
-                   stats.gpuTime.avg,
-                   stats.gpuTime.std,
-                   stats.cpuEncodeTime.sampleCount,
-                   stats.cpuEncodeTime.minSample,
-                   stats.cpuEncodeTime.maxSample,
-                   stats.cpuEncodeTime.avg,
-                   stats.cpuEncodeTime.std,
-                   stats.cpuFrameTime.sampleCount,
-                   stats.cpuFrameTime.minSample,
-                   stats.cpuFrameTime.maxSample,
-                   stats.cpuFrameTime.avg,
-                   stats.cpuFrameTime.std);
+        if(jsonOutput)
+        {
+            print_stats_json(testName, (oc_vec2){ contentRect.w, contentRect.h }, msaaSampleCount, &stats);
+        }
+        else if(csvOutput)
+        {
+            print_stats_csv(&stats);
         }
         else
         {
-            printf("GPU Frame Time\n"
-                   "  smp: %llu\n"
-                   "  min: %.2fms\n"
-                   "  max: %.2fms\n"
-                   "  avg: %.2fms\n"
-                   "  std: %.2f\n"
-                   "CPU Encode Time\n"
-                   "  smp: %llu\n"
-                   "  min: %.2fms\n"
-                   "  max: %.2fms\n"
-                   "  avg: %.2fms\n"
-                   "  std: %.2f\n"
-                   "CPU Frame Time\n"
-                   "  smp: %llu\n"
-                   "  min: %.2fms (%.0ffps)\n"
-                   "  max: %.2fms (%.0ffps)\n"
-                   "  avg: %.2fms (%.0ffps)\n"
-                   "  std: %.2f\n",
-                   stats.gpuTime.sampleCount,
-                   stats.gpuTime.minSample,
-                   stats.gpuTime.maxSample,
-                   stats.gpuTime.avg,
-                   stats.gpuTime.std,
-                   stats.cpuEncodeTime.sampleCount,
-                   stats.cpuEncodeTime.minSample,
-                   stats.cpuEncodeTime.maxSample,
-                   stats.cpuEncodeTime.avg,
-                   stats.cpuEncodeTime.std,
-                   stats.cpuFrameTime.sampleCount,
-                   stats.cpuFrameTime.minSample,
-                   1000 / stats.cpuFrameTime.minSample,
-                   stats.cpuFrameTime.maxSample,
-                   1000 / stats.cpuFrameTime.maxSample,
-                   stats.cpuFrameTime.avg,
-                   1000 / stats.cpuFrameTime.avg,
-                   stats.cpuFrameTime.std);
+            print_stats_text(&stats);
         }
     }
 
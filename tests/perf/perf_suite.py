@@ -0,0 +1,457 @@
+# Runs the renderer benchmark scenarios through ./bin/driver, the wasm backend benchmarks through
+# ./bin/wasm_bench_<backend> (see wasm/build.sh), the util primitives benchmarks through ./bin/util_bench
+# (see util/build.sh), the startup of an app bundle, or input recorded with the runtime's --record-input flag, and
+# flags regressions against a baseline:
+#
+#   python3 perf_suite.py run --out results.json [--csv results.csv] [--capture frame.occapture ...]
+#   python3 perf_suite.py run-wasm --out wasm_results.json [--csv wasm_results.csv] [--engine vm=register ...]
+#   python3 perf_suite.py run-util --out util_results.json [--csv util_results.csv] [--filter hash]
+#   python3 perf_suite.py run-startup path/to/App.app/Contents/MacOS/orca_runtime --out startup_results.json
+#                         [--runs 10] [--flush-command "sudo purge"] [--arg --cpu-canvas ...]
+#   python3 perf_suite.py run-replay path/to/App.app/Contents/MacOS/orca_runtime session.ocinput
+#                         --out replay_results.json [--runs 5] [--step 16.667] [--arg --cpu-canvas ...]
+#   python3 perf_suite.py compare baseline.json results.json
+#
+# compare exits with a non-zero status if any timing or memory figure regressed.
+
+import argparse
+import csv
+import json
+import os
+import subprocess
+import sys
+
+# Named scenarios, each run at every resolution and MSAA sample count below.
+scenarios = [
+    [
+        'text_heavy',
+        ["wall_text"],
+    ],
+    [
+        'stroke_heavy',
+        ["shapes", "--shape", "circle", "--stroke", "--line-width", "2", "-c", "5000"],
+    ],
+    [
+        'image_heavy',
+        ["image_batches", "--image-count", "20", "-c", "2000"],
+    ],
+    [
+        'clip_stack',
+        ["clip_stack", "--depth", "32", "-c", "200"],
+    ],
+    [
+        'small_paths',
+        ["shapes", "--shape", "triangle", "--size", "4", "-c", "50000"],
+    ],
+    [
+        'tiger',
+        ["svg"],
+    ],
+]
+
+resolutions = ["800x600", "1920x1080"]
+# "analytic" runs with analytic coverage, and is reported as msaa 0
+msaa_counts = [1, 4, 8, "analytic"]
+
+wasm_backends = ["wasm3", "bytebox"]
+
+timing_keys = ["gpu", "cpu_encode", "cpu_frame"]
+
+# wasm results are keyed by backend and engine options instead of resolution and MSAA, util results by target and
+# input size, startup results by mode
+def result_key(result):
+    if "backend" in result:
+        return (result["scenario"], result["backend"], result.get("engine", ""))
+    if "target" in result:
+        return (result["scenario"], result["target"], result["size"])
+    if "mode" in result:
+        return (result["scenario"], result["mode"])
+    return (result["scenario"], result["width"], result["height"], result["msaa"])
+
+def result_label(result):
+    if "backend" in result:
+        label = "%s %s" % (result["scenario"], result["backend"])
+        if result.get("engine"):
+            label += " [%s]" % result["engine"]
+        return label
+    if "target" in result:
+        return "%s %s size %d" % result_key(result)
+    if "mode" in result:
+        return "%s %s" % result_key(result)
+    return "%s %dx%d msaa %d" % result_key(result)
+
+def write_results(args, results, csv_writer):
+    with open(args.out, "w") as f:
+        json.dump({"version": 1, "frames": args.frames, "results": results}, f, indent=2)
+    print("wrote " + args.out)
+
+    if args.csv:
+        csv_writer(results, args.csv)
+        print("wrote " + args.csv)
+
+def run_suite(args):
+    selected = [s for s in scenarios if not args.scenario or s[0] in args.scenario]
+    # frame captures are replayed with their own MSAA sample count
+    captures = [["capture_" + os.path.splitext(os.path.basename(path))[0], ["replay", path]] for path in (args.capture or [])]
+    results = []
+    failed = False
+
+    for scenario in selected + captures:
+        for resolution in resolutions:
+            for msaa in (msaa_counts if scenario[1][0] != "replay" else [None]):
+                print("running %s at %s, msaa %s" % (scenario[0], resolution, msaa or "from capture"))
+                res = subprocess.run(["./bin/driver",
+                                      "--auto", str(args.frames),
+                                      "--json",
+                                      "--resolution", resolution,
+                                      *(["--msaa", str(msaa)] if msaa else []),
+                                      *scenario[1]],
+                                      stdout=subprocess.PIPE)
+
+                lines = res.stdout.decode().strip().splitlines()
+                if res.returncode != 0 or len(lines) == 0:
+                    print("error running scenario " + scenario[0])
+                    print(res)
+                    failed = True
+                    continue
+
+                result = json.loads(lines[-1])
+                result["scenario"] = scenario[0]
+                result["args"] = scenario[1]
+                results.append(result)
+
+    write_results(args, results, write_csv)
+    return 1 if failed else 0
+
+def run_wasm_suite(args):
+    results = []
+    failed = False
+
+    for backend in args.backend or wasm_backends:
+        binary = "./bin/wasm_bench_" + backend
+        if not os.path.exists(binary):
+            print("%s not found, skipping the %s backend" % (binary, backend))
+            continue
+
+        # each engine configuration is run separately, so that the fastest one can be picked for an app
+        for engine in args.engine or [""]:
+            label = backend + (" [%s]" % engine if engine else "")
+            print("running wasm benchmarks on " + label)
+            cmd = [binary, "--json", "--samples", str(args.frames)]
+            if engine:
+                cmd += ["--engine", engine]
+            res = subprocess.run(cmd, stdout=subprocess.PIPE)
+
+            # a benchmark that traps is reported on stderr, the others are still collected
+            lines = res.stdout.decode().strip().splitlines()
+            if res.returncode != 0:
+                print("error running wasm benchmarks on " + label)
+                print(res)
+                failed = True
+
+            for line in lines:
+                result = json.loads(line)
+                result["scenario"] = result["test"]
+                results.append(result)
+
+    write_results(args, results, write_wasm_csv)
+    return 1 if failed else 0
+
+def run_util_suite(args):
+    binary = "./bin/util_bench"
+    cmd = [binary, "--json", "--samples", str(args.frames)]
+    if args.filter:
+        cmd += ["--filter", args.filter]
+
+    print("running util benchmarks")
+    res = subprocess.run(cmd, stdout=subprocess.PIPE)
+    lines = res.stdout.decode().strip().splitlines()
+    if res.returncode != 0:
+        print("error running util benchmarks")
+        print(res)
+
+    results = []
+    for line in lines:
+        result = json.loads(line)
+        result["scenario"] = result["test"]
+        results.append(result)
+
+    write_results(args, results, write_util_csv)
+    return 1 if res.returncode != 0 else 0
+
+def timing_stats(samples):
+    count = len(samples)
+    avg = sum(samples) / count if count else 0
+    std = (sum((x - avg) ** 2 for x in samples) / count) ** 0.5 if count else 0
+    return {"smp": count,
+            "avg": avg,
+            "std": std,
+            "min": min(samples) if count else 0,
+            "max": max(samples) if count else 0}
+
+def run_startup_suite(args):
+    # the first launch is reported as cold (the OS file cache may still hold the bundle from a previous session,
+    # use --flush-command to drop it), the following ones as warm
+    reports = []
+    failed = False
+    reportPath = os.path.abspath(args.out + ".startup.tmp.json")
+
+    for run in range(args.runs):
+        if run == 0 and args.flush_command:
+            subprocess.run(args.flush_command, shell=True)
+
+        print("launching %s (%d/%d)" % (args.runtime, run + 1, args.runs))
+        if os.path.exists(reportPath):
+            os.remove(reportPath)
+
+        res = subprocess.run([args.runtime,
+                              "--quit-after-startup",
+                              "--startup-report=" + reportPath,
+                              *(args.arg or [])])
+
+        if res.returncode != 0 or not os.path.exists(reportPath):
+            print("error launching " + args.runtime)
+            print(res)
+            failed = True
+            continue
+
+        with open(reportPath, "r") as f:
+            reports.append((run == 0, json.load(f)))
+        os.remove(reportPath)
+
+    results = []
+    for mode, cold in [("cold", True), ("warm", False)]:
+        selected = [report for isCold, report in reports if isCold == cold]
+        if not len(selected):
+            continue
+        phaseNames = list(selected[0]["phases"].keys())
+        results.append({"scenario": "startup",
+                        "mode": mode,
+                        "app": selected[0]["app"],
+                        "total": timing_stats([r["total"] for r in selected]),
+                        "phases": {name: timing_stats([r["phases"].get(name, 0) for r in selected]) for name in phaseNames}})
+
+    args.frames = args.runs
+    write_results(args, results, write_startup_csv)
+    return 1 if failed else 0
+
+def run_replay_suite(args):
+    # the runtime replays the recorded events at a fixed time step, with frames running back to back, so that each
+    # run does the same work, and reports the wall clock time of the replayed frames
+    reports = []
+    failed = False
+    reportPath = os.path.abspath(args.out + ".replay.tmp.json")
+
+    for run in range(args.runs):
+        print("replaying %s with %s (%d/%d)" % (args.recording, args.runtime, run + 1, args.runs))
+        if os.path.exists(reportPath):
+            os.remove(reportPath)
+
+        res = subprocess.run([args.runtime,
+                              "--replay-input=" + os.path.abspath(args.recording),
+                              "--replay-step=" + str(args.step),
+                              "--replay-report=" + reportPath,
+                              *(args.arg or [])])
+
+        if res.returncode != 0 or not os.path.exists(reportPath):
+            print("error replaying " + args.recording)
+            print(res)
+            failed = True
+            continue
+
+        with open(reportPath, "r") as f:
+            reports.append(json.load(f))
+        os.remove(reportPath)
+
+    results = []
+    if len(reports):
+        results.append({"scenario": "replay",
+                        "mode": os.path.basename(args.recording),
+                        "frames": reports[0]["frames"],
+                        "total": timing_stats([r["total"] for r in reports]),
+                        "frame": timing_stats([r["frame"]["avg"] for r in reports]),
+                        "frame_max": timing_stats([r["frame"]["max"] for r in reports])})
+
+    args.frames = args.runs
+    write_results(args, results, write_replay_csv)
+    return 1 if failed else 0
+
+def write_csv(results, outName):
+    pass_names = list(results[0]["passes"].keys()) if len(results) else []
+
+    with open(outName, "w", newline="") as f:
+        writer = csv.writer(f, delimiter=';')
+        writer.writerow(["scenario", "width", "height", "msaa"]
+                        + [key + " " + stat for key in timing_keys for stat in ["avg", "std"]]
+                        + ["pass " + name + " avg" for name in pass_names]
+                        + ["buffer bytes", "image array bytes"])
+
+        for result in results:
+            writer.writerow([result["scenario"], result["width"], result["height"], result["msaa"]]
+                            + [result[key][stat] for key in timing_keys for stat in ["avg", "std"]]
+                            + [result["passes"][name]["avg"] for name in pass_names]
+                            + [result["memory"]["buffers"], result["memory"]["image_array"]])
+
+def write_wasm_csv(results, outName):
+    with open(outName, "w", newline="") as f:
+        writer = csv.writer(f, delimiter=';')
+        writer.writerow(["scenario", "backend", "engine", "avg", "std", "min", "max", "ns per op"])
+
+        for result in results:
+            time = result["time"]
+            writer.writerow([result["scenario"], result["backend"], result.get("engine", ""),
+                             time["avg"], time["std"], time["min"], time["max"], result["op_ns"]])
+
+def write_util_csv(results, outName):
+    with open(outName, "w", newline="") as f:
+        writer = csv.writer(f, delimiter=';')
+        writer.writerow(["scenario", "target", "size", "unit", "avg", "std", "min", "max", "ns per op"])
+
+        for result in results:
+            time = result["time"]
+            writer.writerow([result["scenario"], result["target"], result["size"], result["unit"],
+                             time["avg"], time["std"], time["min"], time["max"], result["op_ns"]])
+
+def write_startup_csv(results, outName):
+    phase_names = list(results[0]["phases"].keys()) if len(results) else []
+
+    with open(outName, "w", newline="") as f:
+        writer = csv.writer(f, delimiter=';')
+        writer.writerow(["scenario", "mode", "runs", "total avg", "total std", "total min", "total max"]
+                        + [name + " avg" for name in phase_names])
+
+        for result in results:
+            total = result["total"]
+            writer.writerow([result["scenario"], result["mode"], total["smp"],
+                             total["avg"], total["std"], total["min"], total["max"]]
+                            + [result["phases"][name]["avg"] for name in phase_names])
+
+def write_replay_csv(results, outName):
+    with open(outName, "w", newline="") as f:
+        writer = csv.writer(f, delimiter=';')
+        writer.writerow(["scenario", "recording", "frames", "runs", "total avg", "frame avg", "frame std", "frame max avg"])
+
+        for result in results:
+            writer.writerow([result["scenario"], result["mode"], result["frames"], result["total"]["smp"],
+                             result["total"]["avg"], result["frame"]["avg"], result["frame"]["std"],
+                             result["frame_max"]["avg"]])
+
+def load_results(inName):
+    with open(inName, "r") as f:
+        data = json.load(f)
+    return {result_key(r): r for r in data["results"]}
+
+def compare_timing(label, name, base, new, args, regressions):
+    # timings without samples (e.g. GPU times on adapters without timestamp queries) can't be compared
+    if base["smp"] == 0 or new["smp"] == 0:
+        return
+    delta = new["avg"] - base["avg"]
+    if delta > args.min_delta and delta > base["avg"] * args.threshold:
+        regressions.append("%s: %s %.3fms -> %.3fms (%+.1f%%)"
+                           % (label, name, base["avg"], new["avg"], 100 * delta / base["avg"]))
+
+def compare(args):
+    baseline = load_results(args.baseline)
+    current = load_results(args.results)
+    regressions = []
+    comparedCount = 0
+
+    for key, new in current.items():
+        label = result_label(new)
+        base = baseline.get(key)
+        if base is None:
+            print("%s: not in baseline" % label)
+            continue
+        comparedCount += 1
+
+        # any field holding sample statistics is a timing: the canvas driver's gpu/cpu times, the wasm benchmarks' time
+        for name, stats in new.items():
+            if isinstance(stats, dict) and "smp" in stats and name in base:
+                compare_timing(label, name, base[name], stats, args, regressions)
+
+        for name, stats in new.get("passes", {}).items():
+            if name in base["passes"]:
+                compare_timing(label, "pass " + name, base["passes"][name], stats, args, regressions)
+
+        for name, stats in new.get("phases", {}).items():
+            if name in base["phases"]:
+                compare_timing(label, "phase " + name, base["phases"][name], stats, args, regressions)
+
+        for name, size in new.get("memory", {}).items():
+            baseSize = base["memory"].get(name, 0)
+            if size > baseSize * (1 + args.threshold):
+                regressions.append("%s: %s memory %d -> %d bytes" % (label, name, baseSize, size))
+
+    for key, base in baseline.items():
+        if key not in current:
+            print("%s: missing from results" % result_label(base))
+
+    for regression in regressions:
+        print("REGRESSION " + regression)
+    print("%d configurations compared, %d regressions" % (comparedCount, len(regressions)))
+
+    return 1 if len(regressions) else 0
+
+def main():
+    parser = argparse.ArgumentParser(description="Canvas renderer and wasm backend benchmark suite")
+    subparsers = parser.add_subparsers(dest="command", required=True)
+
+    run_parser = subparsers.add_parser("run", help="run the benchmark scenarios")
+    run_parser.add_argument("--out", default="perf_results.json", help="JSON results file")
+    run_parser.add_argument("--csv", help="also write the results as CSV")
+    run_parser.add_argument("--frames", type=int, default=120, help="number of frames measured per run")
+    run_parser.add_argument("--scenario", action="append", help="only run this scenario (can be repeated)")
+    run_parser.add_argument("--capture", action="append", help="also replay this frame capture (can be repeated)")
+
+    wasm_parser = subparsers.add_parser("run-wasm", help="run the wasm backend benchmarks")
+    wasm_parser.add_argument("--out", default="wasm_perf_results.json", help="JSON results file")
+    wasm_parser.add_argument("--csv", help="also write the results as CSV")
+    wasm_parser.add_argument("--frames", type=int, default=30, help="number of samples measured per benchmark")
+    wasm_parser.add_argument("--backend", action="append", choices=wasm_backends, help="only run this backend (can be repeated)")
+    wasm_parser.add_argument("--engine", action="append", help="comma separated engine options to run the benchmarks with, e.g. vm=register,stack-size=1m (can be repeated)")
+
+    util_parser = subparsers.add_parser("run-util", help="run the util primitives benchmarks")
+    util_parser.add_argument("--out", default="util_perf_results.json", help="JSON results file")
+    util_parser.add_argument("--csv", help="also write the results as CSV")
+    util_parser.add_argument("--frames", type=int, default=30, help="number of samples measured per benchmark and size")
+    util_parser.add_argument("--filter", help="only run benchmarks whose name contains this string")
+
+    startup_parser = subparsers.add_parser("run-startup", help="launch an app bundle repeatedly and time its startup phases")
+    startup_parser.add_argument("runtime", help="runtime executable of the app bundle")
+    startup_parser.add_argument("--out", default="startup_results.json", help="JSON results file")
+    startup_parser.add_argument("--csv", help="also write the results as CSV")
+    startup_parser.add_argument("--runs", type=int, default=10, help="number of launches, the first one is the cold start")
+    startup_parser.add_argument("--flush-command", help="shell command dropping the OS file cache before the cold start, e.g. 'sudo purge'")
+    startup_parser.add_argument("--arg", action="append", help="extra runtime argument (can be repeated)")
+
+    replay_parser = subparsers.add_parser("run-replay", help="replay recorded input in an app bundle and time its frames")
+    replay_parser.add_argument("runtime", help="runtime executable of the app bundle")
+    replay_parser.add_argument("recording", help="input recorded with the runtime's --record-input flag")
+    replay_parser.add_argument("--out", default="replay_results.json", help="JSON results file")
+    replay_parser.add_argument("--csv", help="also write the results as CSV")
+    replay_parser.add_argument("--runs", type=int, default=5, help="number of replays")
+    replay_parser.add_argument("--step", type=float, default=1000 / 60, help="time step of replayed frames, in milliseconds")
+    replay_parser.add_argument("--arg", action="append", help="extra runtime argument (can be repeated)")
+
+    compare_parser = subparsers.add_parser("compare", help="flag regressions against a baseline")
+    compare_parser.add_argument("baseline", help="baseline JSON results file")
+    compare_parser.add_argument("results", help="JSON results file to check")
+    compare_parser.add_argument("--threshold", type=float, default=0.1, help="relative increase flagged as a regression")
+    compare_parser.add_argument("--min-delta", type=float, default=0.05, help="smallest increase in ms flagged as a regression")
+
+    args = parser.parse_args()
+    if args.command == "run":
+        return run_suite(args)
+    elif args.command == "run-wasm":
+        return run_wasm_suite(args)
+    elif args.command == "run-util":
+        return run_util_suite(args)
+    elif args.command == "run-startup":
+        return run_startup_suite(args)
+    elif args.command == "run-replay":
+        return run_replay_suite(args)
+    else:
+        return compare(args)
+
+if __name__ == "__main__":
+    sys.exit(main())
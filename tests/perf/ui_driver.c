@@ -0,0 +1,727 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "orca.h"
+#include "graphics/wgpu_renderer_debug.h"
+
+//------------------------------------------------------------------------------------------
+// Test struct
+//------------------------------------------------------------------------------------------
+typedef struct ui_test ui_test;
+
+typedef ui_test (*ui_test_init_proc)(oc_arena* arena, int argc, char** argv);
+typedef void (*ui_test_build_proc)(void* user, u64 frameIndex);
+
+struct ui_test
+{
+    ui_test_build_proc build;
+    void* data;
+};
+
+//NOTE: parses an integer option value, returns false and logs an error if it's missing or malformed
+bool ui_test_parse_count(int argc, char** argv, int* argIndex, u32* count)
+{
+    if(*argIndex + 1 >= argc || argv[*argIndex + 1][0] == '-')
+    {
+        oc_log_error("option %s needs an argument\n", argv[*argIndex]);
+        return (false);
+    }
+    (*argIndex)++;
+    char* end = 0;
+    *count = strtoul(argv[*argIndex], &end, 10);
+    if(end == argv[*argIndex] || end[0] != '\0')
+    {
+        oc_log_error("option %s should be an integer\n", argv[*argIndex - 1]);
+        return (false);
+    }
+    return (true);
+}
+
+typedef struct ui_test_count_data
+{
+    u32 count;
+} ui_test_count_data;
+
+ui_test_count_data* ui_test_count_init(oc_arena* arena, int argc, char** argv, u32 defaultCount)
+{
+    ui_test_count_data* data = oc_arena_push_type(arena, ui_test_count_data);
+    data->count = defaultCount;
+
+    for(int argIndex = 0; argIndex < argc; argIndex++)
+    {
+        if(!strcmp(argv[argIndex], "-c") || !strcmp(argv[argIndex], "--count"))
+        {
+            if(!ui_test_parse_count(argc, argv, &argIndex, &data->count))
+            {
+                return (0);
+            }
+        }
+    }
+    return (data);
+}
+
+//------------------------------------------------------------------------------------------
+// Deep tree test
+//------------------------------------------------------------------------------------------
+void deep_tree_build(void* user, u64 frameIndex)
+{
+    ui_test_count_data* data = (ui_test_count_data*)user;
+
+    for(u32 i = 0; i < data->count; i++)
+    {
+        oc_ui_style_next(&(oc_ui_style){ .layout.margin.x = 1,
+                                         .layout.margin.y = 1,
+                                         .borderSize = 1,
+                                         .borderColor = { 0.5, 0.5, 0.5, 1 } },
+                         OC_UI_STYLE_LAYOUT_MARGINS
+                             | OC_UI_STYLE_BORDER_SIZE
+                             | OC_UI_STYLE_BORDER_COLOR);
+
+        oc_ui_box_begin("level", OC_UI_FLAG_DRAW_BORDER);
+    }
+
+    oc_ui_label("leaf");
+
+    for(u32 i = 0; i < data->count; i++)
+    {
+        oc_ui_box_end();
+    }
+}
+
+ui_test deep_tree_init(oc_arena* arena, int argc, char** argv)
+{
+    ui_test_count_data* data = ui_test_count_init(arena, argc, argv, 200);
+    return ((ui_test){ .build = data ? deep_tree_build : 0, .data = data });
+}
+
+//------------------------------------------------------------------------------------------
+// Wide list test
+//------------------------------------------------------------------------------------------
+void wide_list_build(void* user, u64 frameIndex)
+{
+    ui_test_count_data* data = (ui_test_count_data*)user;
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_ui_style_next(&(oc_ui_style){ .layout.axis = OC_UI_AXIS_X,
+                                     .layout.spacing = 4 },
+                     OC_UI_STYLE_LAYOUT_AXIS
+                         | OC_UI_STYLE_LAYOUT_SPACING);
+
+    oc_ui_container("list", 0)
+    {
+        for(u32 i = 0; i < data->count; i++)
+        {
+            oc_ui_label_str8(oc_str8_pushf(scratch.arena, "item %u", i));
+        }
+    }
+
+    oc_scratch_end(scratch);
+}
+
+ui_test wide_list_init(oc_arena* arena, int argc, char** argv)
+{
+    ui_test_count_data* data = ui_test_count_init(arena, argc, argv, 5000);
+    return ((ui_test){ .build = data ? wide_list_build : 0, .data = data });
+}
+
+//------------------------------------------------------------------------------------------
+// Heavy rule set test
+//------------------------------------------------------------------------------------------
+typedef struct rules_data
+{
+    u32 count;
+    u32 ruleCount;
+} rules_data;
+
+void rules_build(void* user, u64 frameIndex)
+{
+    rules_data* data = (rules_data*)user;
+    oc_ui_context* ui = oc_ui_get_context();
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_ui_container("rules", 0)
+    {
+        //NOTE: rules match tags, text and descendant patterns, so that all kinds of rule buckets are exercised.
+        //      Selector strings are matched at the end of the frame, so they live on the frame arena.
+        for(u32 i = 0; i < data->ruleCount; i++)
+        {
+            oc_ui_pattern pattern = { 0 };
+            switch(i % 3)
+            {
+                case 0:
+                    oc_ui_pattern_push(&ui->frameArena, &pattern, (oc_ui_selector){ .kind = OC_UI_SEL_TAG, .tag = oc_ui_tag_make_str8(oc_str8_pushf(scratch.arena, "tag%u", i % 16)) });
+                    break;
+                case 1:
+                    oc_ui_pattern_push(&ui->frameArena, &pattern, (oc_ui_selector){ .kind = OC_UI_SEL_TEXT, .text = oc_str8_pushf(&ui->frameArena, "item %u", i % data->count) });
+                    break;
+                default:
+                    oc_ui_pattern_push(&ui->frameArena, &pattern, (oc_ui_selector){ .kind = OC_UI_SEL_TAG, .tag = oc_ui_tag_make_str8(oc_str8_pushf(scratch.arena, "tag%u", i % 16)) });
+                    oc_ui_pattern_push(&ui->frameArena, &pattern, (oc_ui_selector){ .kind = OC_UI_SEL_ANY });
+                    break;
+            }
+            oc_ui_style_match_after(pattern,
+                                    &(oc_ui_style){ .bgColor = { (i % 7) / 7., (i % 5) / 5., (i % 3) / 3., 1 } },
+                                    OC_UI_STYLE_BG_COLOR);
+        }
+
+        for(u32 i = 0; i < data->count; i++)
+        {
+            oc_ui_tag_next_str8(oc_str8_pushf(scratch.arena, "tag%u", i % 16));
+            oc_ui_box_make_str8(oc_str8_pushf(scratch.arena, "item %u", i), OC_UI_FLAG_DRAW_BACKGROUND);
+        }
+    }
+
+    oc_scratch_end(scratch);
+}
+
+ui_test rules_init(oc_arena* arena, int argc, char** argv)
+{
+    rules_data* data = oc_arena_push_type(arena, rules_data);
+    data->count = 1000;
+    data->ruleCount = 500;
+
+    for(int argIndex = 0; argIndex < argc; argIndex++)
+    {
+        if(!strcmp(argv[argIndex], "-c") || !strcmp(argv[argIndex], "--count"))
+        {
+            if(!ui_test_parse_count(argc, argv, &argIndex, &data->count))
+            {
+                return ((ui_test){ 0 });
+            }
+        }
+        else if(!strcmp(argv[argIndex], "-r") || !strcmp(argv[argIndex], "--rule-count"))
+        {
+            if(!ui_test_parse_count(argc, argv, &argIndex, &data->ruleCount))
+            {
+                return ((ui_test){ 0 });
+            }
+        }
+    }
+    data->count = oc_max(data->count, 1);
+
+    return ((ui_test){ .build = rules_build, .data = data });
+}
+
+//------------------------------------------------------------------------------------------
+// Text box test
+//------------------------------------------------------------------------------------------
+typedef struct text_box_data
+{
+    oc_arena textArena[2];
+    u32 textIndex;
+    oc_str8 text;
+} text_box_data;
+
+void text_box_build(void* user, u64 frameIndex)
+{
+    text_box_data* data = (text_box_data*)user;
+
+    //NOTE: click in the text box on the first frames to focus it, so that we measure the editing path
+    if(frameIndex < 2)
+    {
+        oc_event move = { .type = OC_EVENT_MOUSE_MOVE, .mouse = { .x = 20, .y = 10 } };
+        oc_ui_process_event(&move);
+
+        oc_event click = { .type = OC_EVENT_MOUSE_BUTTON,
+                           .key = { .action = (frameIndex == 0) ? OC_KEY_PRESS : OC_KEY_RELEASE,
+                                    .button = OC_MOUSE_LEFT,
+                                    .clickCount = 1 } };
+        oc_ui_process_event(&click);
+    }
+
+    //NOTE: results are double buffered, since the text box reads the previous text while it builds the new one
+    oc_arena* arena = &data->textArena[data->textIndex];
+    oc_arena_clear(arena);
+
+    oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 } },
+                     OC_UI_STYLE_SIZE_WIDTH);
+
+    oc_ui_text_box_result result = oc_ui_text_box("text", arena, data->text);
+    if(result.changed)
+    {
+        data->text = result.text;
+        data->textIndex = 1 - data->textIndex;
+    }
+}
+
+ui_test text_box_init(oc_arena* arena, int argc, char** argv)
+{
+    text_box_data* data = oc_arena_push_type(arena, text_box_data);
+    memset(data, 0, sizeof(text_box_data));
+
+    u32 length = 100000;
+    for(int argIndex = 0; argIndex < argc; argIndex++)
+    {
+        if(!strcmp(argv[argIndex], "-l") || !strcmp(argv[argIndex], "--length"))
+        {
+            if(!ui_test_parse_count(argc, argv, &argIndex, &length))
+            {
+                return ((ui_test){ 0 });
+            }
+        }
+    }
+
+    oc_arena_init(&data->textArena[0]);
+    oc_arena_init(&data->textArena[1]);
+
+    const char* words[] = { "lorem ", "ipsum ", "dolor ", "sit ", "amet ", "consectetur ", "adipiscing ", "elit " };
+    char* buffer = oc_arena_push_array(arena, char, length);
+    for(u32 i = 0; i < length; i++)
+    {
+        const char* word = words[(i / 8) % oc_array_size(words)];
+        buffer[i] = word[i % strlen(word)];
+    }
+    data->text = oc_str8_from_buffer(length, buffer);
+
+    return ((ui_test){ .build = text_box_build, .data = data });
+}
+
+//------------------------------------------------------------------------------------------
+// Animation test
+//------------------------------------------------------------------------------------------
+void animation_build(void* user, u64 frameIndex)
+{
+    ui_test_count_data* data = (ui_test_count_data*)user;
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_ui_style_next(&(oc_ui_style){ .layout.axis = OC_UI_AXIS_X,
+                                     .layout.spacing = 2 },
+                     OC_UI_STYLE_LAYOUT_AXIS
+                         | OC_UI_STYLE_LAYOUT_SPACING);
+
+    oc_ui_container("animated", 0)
+    {
+        for(u32 i = 0; i < data->count; i++)
+        {
+            //NOTE: targets flip every 30 frames, with staggered phases, so that animations never settle
+            bool flip = ((frameIndex + i) / 30) & 1;
+            oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PIXELS, flip ? 40 : 10 },
+                                             .size.height = { OC_UI_SIZE_PIXELS, 10 },
+                                             .bgColor = { flip, 0.5, 1 - flip, 1 },
+                                             .roundness = flip ? 5 : 0,
+                                             .animationTime = 0.5,
+                                             .animationMask = OC_UI_STYLE_SIZE_WIDTH
+                                                            | OC_UI_STYLE_BG_COLOR
+                                                            | OC_UI_STYLE_ROUNDNESS },
+                             OC_UI_STYLE_SIZE
+                                 | OC_UI_STYLE_BG_COLOR
+                                 | OC_UI_STYLE_ROUNDNESS
+                                 | OC_UI_STYLE_ANIMATION_TIME
+                                 | OC_UI_STYLE_ANIMATION_MASK);
+
+            oc_ui_box_make_str8(oc_str8_pushf(scratch.arena, "box %u", i), OC_UI_FLAG_DRAW_BACKGROUND);
+        }
+    }
+
+    oc_scratch_end(scratch);
+}
+
+ui_test animation_init(oc_arena* arena, int argc, char** argv)
+{
+    ui_test_count_data* data = ui_test_count_init(arena, argc, argv, 2000);
+    return ((ui_test){ .build = data ? animation_build : 0, .data = data });
+}
+
+//------------------------------------------------------------------------------------------
+// Tests table
+//------------------------------------------------------------------------------------------
+
+typedef struct ui_test_entry
+{
+    const char* name;
+    ui_test_init_proc init;
+
+} ui_test_entry;
+
+#define UI_TEST(t)                            \
+    {                                         \
+        .name = #t, .init = OC_CAT2(t, _init) \
+    }
+
+ui_test_entry UI_TESTS[] = {
+    UI_TEST(deep_tree),
+    UI_TEST(wide_list),
+    UI_TEST(rules),
+    UI_TEST(text_box),
+    UI_TEST(animation),
+};
+const u32 UI_TEST_COUNT = sizeof(UI_TESTS) / sizeof(ui_test_entry);
+
+//------------------------------------------------------------------------------------------
+// Phase stats
+//------------------------------------------------------------------------------------------
+
+//NOTE: per-phase samples are resolved like the renderer's frame stats, so that the output of both drivers can be compared
+typedef enum ui_phase
+{
+    UI_PHASE_BUILD,   // from oc_ui_begin_frame() to oc_ui_end_frame(), excluding styling and layout
+    UI_PHASE_STYLING, // style rule matching and static sizes
+    UI_PHASE_LAYOUT,  // layout passes
+    UI_PHASE_DRAW,    // oc_ui_draw()
+    UI_PHASE_RENDER,  // oc_canvas_render() and oc_canvas_present()
+    UI_PHASE_COUNT,
+} ui_phase;
+
+const char* UI_PHASE_NAMES[UI_PHASE_COUNT] = {
+    "build",
+    "styling",
+    "layout",
+    "draw",
+    "render",
+};
+
+typedef struct ui_stats_buffer
+{
+    u32 sampleCount;
+    u32 nextSample;
+    f64* samples;
+    u32 cap;
+} ui_stats_buffer;
+
+void ui_stats_add_sample(ui_stats_buffer* buffer, f64 sample)
+{
+    buffer->samples[buffer->nextSample] = sample;
+    buffer->nextSample = (buffer->nextSample + 1) % buffer->cap;
+    buffer->sampleCount = oc_min(buffer->sampleCount + 1, buffer->cap);
+}
+
+oc_wgpu_canvas_stats ui_stats_resolve(ui_stats_buffer* buffer)
+{
+    oc_wgpu_canvas_stats result = { 0 };
+    if(buffer->sampleCount)
+    {
+        f64 sum = 0;
+        f64 sum2 = 0;
+        f64 minSample = DBL_MAX;
+        f64 maxSample = 0;
+
+        for(u32 i = 0; i < buffer->sampleCount; i++)
+        {
+            f64 sample = buffer->samples[i];
+            minSample = oc_min(minSample, sample);
+            maxSample = oc_max(maxSample, sample);
+            sum += sample;
+            sum2 += sample * sample;
+        }
+        result.sampleCount = buffer->sampleCount;
+        result.minSample = minSample;
+        result.maxSample = maxSample;
+        result.avg = sum / buffer->sampleCount;
+        result.std = sqrt(oc_max(sum2 / buffer->sampleCount - result.avg * result.avg, 0));
+    }
+    return (result);
+}
+
+typedef enum ui_output_format
+{
+    UI_OUTPUT_TEXT,
+    UI_OUTPUT_CSV,
+    UI_OUTPUT_JSON,
+} ui_output_format;
+
+void ui_stats_print(const char* testName, ui_output_format format, oc_wgpu_canvas_stats* phases, oc_wgpu_canvas_stats gpuTime)
+{
+    switch(format)
+    {
+        case UI_OUTPUT_CSV:
+        {
+            printf("%s", testName);
+            for(int i = 0; i < UI_PHASE_COUNT; i++)
+            {
+                printf(" ; %llu ; %.3f ; %.3f ; %.3f ; %.3f",
+                       phases[i].sampleCount,
+                       phases[i].minSample,
+                       phases[i].maxSample,
+                       phases[i].avg,
+                       phases[i].std);
+            }
+            printf(" ; %llu ; %.3f ; %.3f ; %.3f ; %.3f\n",
+                   gpuTime.sampleCount,
+                   gpuTime.minSample,
+                   gpuTime.maxSample,
+                   gpuTime.avg,
+                   gpuTime.std);
+        }
+        break;
+
+        case UI_OUTPUT_JSON:
+        {
+            printf("{\"test\": \"%s\"", testName);
+            for(int i = 0; i <= UI_PHASE_COUNT; i++)
+            {
+                oc_wgpu_canvas_stats* stats = (i < UI_PHASE_COUNT) ? &phases[i] : &gpuTime;
+                printf(", \"%s\": {\"smp\": %llu, \"min\": %.3f, \"max\": %.3f, \"avg\": %.3f, \"std\": %.3f}",
+                       (i < UI_PHASE_COUNT) ? UI_PHASE_NAMES[i] : "gpu",
+                       stats->sampleCount,
+                       stats->minSample,
+                       stats->maxSample,
+                       stats->avg,
+                       stats->std);
+            }
+            printf("}\n");
+        }
+        break;
+
+        default:
+        {
+            for(int i = 0; i <= UI_PHASE_COUNT; i++)
+            {
+                oc_wgpu_canvas_stats* stats = (i < UI_PHASE_COUNT) ? &phases[i] : &gpuTime;
+                printf("%s\n"
+                       "  smp: %llu\n"
+                       "  min: %.3fms\n"
+                       "  max: %.3fms\n"
+                       "  avg: %.3fms\n"
+                       "  std: %.3f\n",
+                       (i < UI_PHASE_COUNT) ? UI_PHASE_NAMES[i] : "gpu",
+                       stats->sampleCount,
+                       stats->minSample,
+                       stats->maxSample,
+                       stats->avg,
+                       stats->std);
+            }
+        }
+        break;
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// Driver
+//------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    oc_log_set_level(OC_LOG_LEVEL_WARNING);
+    bool autoMode = false;
+    ui_output_format format = UI_OUTPUT_TEXT;
+    int autoCount = 100;
+    int argIndex = 1;
+    for(; argIndex < argc; argIndex++)
+    {
+        if(!strcmp(argv[argIndex], "--auto"))
+        {
+            autoMode = true;
+            argIndex++;
+            if(argIndex >= argc)
+            {
+                oc_log_error("option %s should have an integer argument\n", argv[argIndex - 1]);
+                return (-1);
+            }
+            char* end = 0;
+            autoCount = strtoul(argv[argIndex], &end, 10);
+            if(end == argv[argIndex] || end[0] != '\0' || autoCount <= 0)
+            {
+                oc_log_error("option %s should have an integer argument\n", argv[argIndex - 1]);
+                return (-1);
+            }
+        }
+        else if(!strcmp(argv[argIndex], "--csv"))
+        {
+            format = UI_OUTPUT_CSV;
+        }
+        else if(!strcmp(argv[argIndex], "--json"))
+        {
+            format = UI_OUTPUT_JSON;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if(argIndex >= argc)
+    {
+        oc_log_error("test name required\n");
+        return (-1);
+    }
+    const char* testName = argv[argIndex];
+    argIndex++;
+
+    ui_test_entry* testEntry = 0;
+    for(int i = 0; i < UI_TEST_COUNT; i++)
+    {
+        if(!strcmp(UI_TESTS[i].name, testName))
+        {
+            testEntry = &UI_TESTS[i];
+            break;
+        }
+    }
+
+    if(!testEntry)
+    {
+        oc_log_error("test %s not found\n", testName);
+        return (-1);
+    }
+
+    oc_arena_scope programScratch = oc_scratch_begin();
+
+    //NOTE: create window renderer, surface, and context
+    oc_init();
+
+    oc_rect windowRect = { .x = 100, .y = 100, .w = 800, .h = 600 };
+    oc_window window = oc_window_create(windowRect, OC_STR8("ui perf tests"), 0);
+    oc_rect contentRect = oc_window_get_content_rect(window);
+
+    oc_canvas_renderer renderer = oc_canvas_renderer_create();
+    if(oc_canvas_renderer_is_nil(renderer))
+    {
+        oc_log_error("Error: couldn't create renderer\n");
+        return (-1);
+    }
+
+    oc_wgpu_canvas_debug_set_record_options(
+        renderer,
+        &(oc_wgpu_canvas_record_options){
+            .maxRecordCount = autoCount,
+            .timingFlags = OC_WGPU_CANVAS_TIMING_FRAME,
+        });
+
+    oc_surface surface = oc_canvas_surface_create_for_window(renderer, window);
+    if(oc_surface_is_nil(surface))
+    {
+        oc_log_error("Error: couldn't create surface\n");
+        return (-1);
+    }
+
+    oc_canvas_context context = oc_canvas_context_create();
+    if(oc_canvas_context_is_nil(context))
+    {
+        oc_log_error("Error: couldn't create canvas\n");
+        return (-1);
+    }
+
+    oc_unicode_range ranges[5] = { OC_UNICODE_BASIC_LATIN,
+                                   OC_UNICODE_C1_CONTROLS_AND_LATIN_1_SUPPLEMENT,
+                                   OC_UNICODE_LATIN_EXTENDED_A,
+                                   OC_UNICODE_LATIN_EXTENDED_B,
+                                   OC_UNICODE_SPECIALS };
+    oc_font font = oc_font_create_from_path(OC_STR8("./resources/CMUSerif-Roman.ttf"), 5, ranges);
+    if(oc_font_is_nil(font))
+    {
+        oc_log_error("Error: couldn't create font\n");
+        return (-1);
+    }
+
+    oc_ui_context ui;
+    oc_ui_init(&ui);
+
+    ui_test test = testEntry->init(programScratch.arena, argc - argIndex, argv + argIndex);
+    if(!test.build)
+    {
+        return (-1);
+    }
+
+    // start app
+    oc_window_bring_to_front(window);
+    oc_window_focus(window);
+
+    ui_stats_buffer phaseStats[UI_PHASE_COUNT] = { 0 };
+    for(int i = 0; i < UI_PHASE_COUNT; i++)
+    {
+        phaseStats[i].cap = autoCount;
+        phaseStats[i].samples = oc_arena_push_array(programScratch.arena, f64, autoCount);
+    }
+
+    u64 frameCount = 0;
+    u32 warmupCount = 180;
+
+    oc_ui_style defaultStyle = { .font = font,
+                                 .fontSize = 14,
+                                 .color = { 1, 1, 1, 1 } };
+    oc_ui_style_mask defaultMask = OC_UI_STYLE_FONT
+                                 | OC_UI_STYLE_FONT_SIZE
+                                 | OC_UI_STYLE_COLOR;
+
+    while(!oc_should_quit())
+    {
+        oc_arena_scope frameScratch = oc_scratch_begin();
+
+        oc_pump_events(0);
+        oc_event* event = 0;
+        while((event = oc_next_event(frameScratch.arena)) != 0)
+        {
+            switch(event->type)
+            {
+                case OC_EVENT_WINDOW_CLOSE:
+                {
+                    oc_request_quit();
+                }
+                break;
+
+                default:
+                    break;
+            }
+        }
+
+        f64 buildStart = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+        oc_ui_frame(contentRect.wh, &defaultStyle, defaultMask)
+        {
+            test.build(test.data, frameCount);
+        }
+
+        f64 drawStart = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+        oc_canvas_context_select(context);
+        oc_set_color_rgba(0.1, 0.1, 0.1, 1);
+        oc_clear();
+        oc_ui_draw();
+
+        f64 renderStart = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+        oc_canvas_render(renderer, context, surface);
+        oc_canvas_present(renderer, surface);
+
+        f64 renderEnd = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+        oc_scratch_end(frameScratch);
+
+        frameCount++;
+
+        if(frameCount > warmupCount)
+        {
+            oc_ui_frame_stats uiStats = oc_ui_get_frame_stats();
+            f64 buildTime = (drawStart - buildStart) - uiStats.stylingTime - uiStats.layoutTime;
+
+            ui_stats_add_sample(&phaseStats[UI_PHASE_BUILD], buildTime * 1000);
+            ui_stats_add_sample(&phaseStats[UI_PHASE_STYLING], uiStats.stylingTime * 1000);
+            ui_stats_add_sample(&phaseStats[UI_PHASE_LAYOUT], uiStats.layoutTime * 1000);
+            ui_stats_add_sample(&phaseStats[UI_PHASE_DRAW], (renderStart - drawStart) * 1000);
+            ui_stats_add_sample(&phaseStats[UI_PHASE_RENDER], (renderEnd - renderStart) * 1000);
+        }
+
+        if(autoMode && frameCount >= autoCount + warmupCount)
+        {
+            break;
+        }
+    }
+
+    oc_wgpu_canvas_stats phases[UI_PHASE_COUNT];
+    for(int i = 0; i < UI_PHASE_COUNT; i++)
+    {
+        phases[i] = ui_stats_resolve(&phaseStats[i]);
+    }
+    oc_wgpu_canvas_frame_stats rendererStats = oc_wgpu_canvas_get_frame_stats(renderer, autoCount);
+
+    ui_stats_print(testName, format, phases, rendererStats.gpuTime);
+
+    oc_font_destroy(font);
+    oc_canvas_context_destroy(context);
+    oc_surface_destroy(surface);
+    oc_canvas_renderer_destroy(renderer);
+
+    oc_terminate();
+
+    return (0);
+}
@@ -0,0 +1,44 @@
+#!/bin/bash
+
+set -euo pipefail
+
+BINDIR=../bin
+LIBDIR=../../../build/bin
+SRCDIR=../../../src
+
+INCLUDES="-I$SRCDIR"
+LIBS="-L$LIBDIR -lorca"
+FLAGS="-mmacos-version-min=13.0.0"
+
+mkdir -p $BINDIR
+
+# native benchmarks, linked against the runtime's liborca
+clang -g -O3 $FLAGS $INCLUDES $LIBS -o $BINDIR/util_bench main.c
+install_name_tool -add_rpath "@executable_path" $BINDIR/util_bench
+cp $LIBDIR/liborca.dylib $BINDIR/
+
+# the same benchmarks as a guest module, linked against the orca wasm library and bundled as an app. The app logs
+# its results and quits, run it with ../bin/UtilBench.app/Contents/MacOS/orca_runtime
+if command -v orca > /dev/null; then
+  ORCA_DIR=$(orca sdk-path)
+
+  if [[ -x /usr/local/opt/llvm/bin/clang ]]; then
+    WASMCLANG=/usr/local/opt/llvm/bin/clang
+  elif [[ -x /opt/homebrew/opt/llvm/bin/clang ]]; then
+    WASMCLANG=/opt/homebrew/opt/llvm/bin/clang
+  else
+    echo "Could not find Homebrew clang; the guest module will probably not build."
+    WASMCLANG=clang
+  fi
+
+  $WASMCLANG --target=wasm32 -mbulk-memory -O2 \
+      -Wl,--no-entry -Wl,--export-dynamic \
+      --sysroot "$ORCA_DIR"/orca-libc \
+      -I "$ORCA_DIR"/src -I "$ORCA_DIR"/src/ext \
+      -L "$ORCA_DIR"/bin -lorca_wasm \
+      -o $BINDIR/util_bench.wasm main.c
+
+  orca bundle --name UtilBench --out-dir $BINDIR $BINDIR/util_bench.wasm
+else
+  echo "orca not found, skipping the wasm guest benchmark"
+fi
@@ -0,0 +1,686 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2024 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "orca.h"
+#include "util/ringbuffer.h"
+
+//NOTE: the same benchmarks are built as a native executable (./bin/util_bench) and as a guest module run by the
+//      runtime (./bin/UtilBench.app), so that the util primitives can be compared on the host and in wasm.
+#if OC_PLATFORM_ORCA
+    #define BENCH_TARGET_NAME "wasm"
+#else
+    #define BENCH_TARGET_NAME "native"
+#endif
+
+//------------------------------------------------------------------------------------------
+// Inputs
+//------------------------------------------------------------------------------------------
+
+enum
+{
+    BENCH_MAX_SIZE = 64 << 10,
+    BENCH_RING_CAP_EXP = 16,
+    BENCH_RING_RECORD_SIZE = 64,
+};
+
+//NOTE: input sizes are either bytes or element counts, depending on the benchmark
+static const u64 BENCH_SIZES[] = { 16, 256, 4 << 10, 64 << 10 };
+static const u32 BENCH_SIZE_COUNT = sizeof(BENCH_SIZES) / sizeof(u64);
+
+typedef struct bench_list_item
+{
+    oc_list_elt listElt;
+    u64 value;
+} bench_list_item;
+
+typedef struct bench_inputs
+{
+    oc_arena arena;   // pushed to by the arena benchmarks, cleared after each sample
+    oc_pool pool;     // 64-byte blocks
+    oc_hash_map map;  // u64 values
+    oc_ringbuffer ring;
+
+    char* ascii;      // words of latin letters separated by spaces
+    char* mixed;      // text mixing 1 to 4 byte utf8 sequences
+    u64 mixedLen;
+    oc_utf32* codePoints;
+    u64 codePointCount;
+    char* utf8Backing;
+    oc_utf32* utf32Backing;
+    void** blocks;
+    bench_list_item* items;
+    f32* angles;     // in [-100, 100]
+    f32* exponents;  // in [-10, 10]
+    f32* unitFloats; // in (0, 1]
+    f32* floatOut;
+} bench_inputs;
+
+static bench_inputs bench;
+
+//NOTE: results are accumulated here so that the compiler can't drop the benchmarked calls
+static volatile u64 bench_sink = 0;
+
+static void bench_inputs_init(oc_arena* arena)
+{
+    oc_arena_init(&bench.arena);
+    oc_pool_init(&bench.pool, 64);
+    oc_hash_map_init(&bench.map, sizeof(u64));
+    oc_ringbuffer_init(&bench.ring, BENCH_RING_CAP_EXP);
+
+    //NOTE: a fixed pseudo-random sequence, so that runs get the same inputs
+    u64 seed = 0x9e3779b97f4a7c15;
+
+    bench.ascii = oc_arena_push_array(arena, char, BENCH_MAX_SIZE);
+    for(u64 i = 0; i < BENCH_MAX_SIZE; i++)
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        bench.ascii[i] = ((seed >> 33) % 6 == 0) ? ' ' : 'a' + (seed >> 40) % 26;
+    }
+
+    static const oc_utf32 MIXED_CODEPOINTS[] = { 'o', 'r', 'c', 'a', ' ', 0xe9, 0x3b1, 0x4e2d, 0x6587, 0x1f600 };
+    bench.codePoints = oc_arena_push_array(arena, oc_utf32, BENCH_MAX_SIZE);
+    bench.mixed = oc_arena_push_array(arena, char, BENCH_MAX_SIZE + 4);
+    bench.mixedLen = 0;
+    bench.codePointCount = 0;
+    while(bench.mixedLen + 4 <= BENCH_MAX_SIZE)
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        oc_utf32 codePoint = MIXED_CODEPOINTS[(seed >> 33) % (sizeof(MIXED_CODEPOINTS) / sizeof(oc_utf32))];
+        bench.codePoints[bench.codePointCount] = codePoint;
+        bench.codePointCount++;
+        bench.mixedLen += oc_utf8_encode(bench.mixed + bench.mixedLen, codePoint).len;
+    }
+
+    bench.utf8Backing = oc_arena_push_array(arena, char, 4 * BENCH_MAX_SIZE);
+    bench.utf32Backing = oc_arena_push_array(arena, oc_utf32, BENCH_MAX_SIZE);
+    bench.blocks = oc_arena_push_array(arena, void*, BENCH_MAX_SIZE);
+    bench.items = oc_arena_push_array(arena, bench_list_item, BENCH_MAX_SIZE);
+
+    bench.angles = oc_arena_push_array(arena, f32, BENCH_MAX_SIZE);
+    bench.exponents = oc_arena_push_array(arena, f32, BENCH_MAX_SIZE);
+    bench.unitFloats = oc_arena_push_array(arena, f32, BENCH_MAX_SIZE);
+    bench.floatOut = oc_arena_push_array(arena, f32, BENCH_MAX_SIZE);
+    for(u64 i = 0; i < BENCH_MAX_SIZE; i++)
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        f32 unit = ((seed >> 40) + 1) / (f32)(1 << 24);
+        bench.angles[i] = 200 * unit - 100;
+        bench.exponents[i] = 20 * unit - 10;
+        bench.unitFloats[i] = unit;
+    }
+}
+
+static void bench_inputs_cleanup(void)
+{
+    oc_ringbuffer_cleanup(&bench.ring);
+    oc_hash_map_cleanup(&bench.map);
+    oc_pool_cleanup(&bench.pool);
+    oc_arena_cleanup(&bench.arena);
+}
+
+//NOTE: the utf8 benchmarks cut the mixed text on a sequence boundary
+static oc_str8 bench_mixed_text(u64 size)
+{
+    u64 len = oc_min(size, bench.mixedLen);
+    while(len < bench.mixedLen && !oc_utf8_is_start_byte(bench.mixed[len]))
+    {
+        len--;
+    }
+    return (oc_str8_from_buffer(len, bench.mixed));
+}
+
+//------------------------------------------------------------------------------------------
+// Benchmarks
+//------------------------------------------------------------------------------------------
+
+//NOTE: each benchmark runs once on an input of the given size, and returns the number of operations it did, which is
+//      used to report the time of one operation (one push, one byte hashed, one element inserted, ...)
+typedef u64 (*bench_proc)(u64 size);
+
+static u64 bench_arena_push(u64 count)
+{
+    for(u64 i = 0; i < count; i++)
+    {
+        u64* p = oc_arena_push_type(&bench.arena, u64);
+        *p = i;
+    }
+    oc_arena_clear(&bench.arena);
+    return (count);
+}
+
+static u64 bench_arena_push_large(u64 count)
+{
+    //NOTE: 4KB pushes keep committing new pages until the arena stops growing
+    for(u64 i = 0; i < count; i++)
+    {
+        char* p = oc_arena_push(&bench.arena, 4 << 10);
+        p[0] = (char)i;
+    }
+    oc_arena_clear(&bench.arena);
+    return (count);
+}
+
+static u64 bench_arena_scope(u64 count)
+{
+    for(u64 i = 0; i < count; i++)
+    {
+        oc_arena_scope scope = oc_arena_scope_begin(&bench.arena);
+        u64* p = oc_arena_push_array(&bench.arena, u64, 8);
+        p[0] = i;
+        oc_arena_scope_end(scope);
+    }
+    return (count);
+}
+
+static u64 bench_scratch_scope(u64 count)
+{
+    for(u64 i = 0; i < count; i++)
+    {
+        oc_arena_scope scratch = oc_scratch_begin();
+        u64* p = oc_arena_push_array(scratch.arena, u64, 8);
+        p[0] = i;
+        oc_scratch_end(scratch);
+    }
+    return (count);
+}
+
+static u64 bench_pool_alloc_recycle(u64 count)
+{
+    for(u64 i = 0; i < count; i++)
+    {
+        bench.blocks[i] = oc_pool_alloc(&bench.pool);
+    }
+    for(u64 i = 0; i < count; i++)
+    {
+        oc_pool_recycle(&bench.pool, bench.blocks[i]);
+    }
+    return (count);
+}
+
+static u64 bench_hash_xx64(u64 size)
+{
+    //NOTE: short strings are hashed repeatedly, so that every sample hashes about the same number of bytes
+    u64 repeat = oc_max(1, BENCH_MAX_SIZE / size);
+    u64 hash = 0;
+    for(u64 i = 0; i < repeat; i++)
+    {
+        hash ^= oc_hash_xx64_string_seed(oc_str8_from_buffer(size, bench.ascii), i);
+    }
+    bench_sink += hash;
+    return (repeat * size);
+}
+
+static u64 bench_hash_map_insert_find(u64 count)
+{
+    for(u64 i = 0; i < count; i++)
+    {
+        u64* value = oc_hash_map_insert_type(&bench.map, i * 0x9e3779b97f4a7c15, u64, 0);
+        *value = i;
+    }
+    u64 sum = 0;
+    for(u64 i = 0; i < count; i++)
+    {
+        u64* value = oc_hash_map_find_type(&bench.map, i * 0x9e3779b97f4a7c15, u64);
+        sum += *value;
+    }
+    oc_hash_map_clear(&bench.map);
+    bench_sink += sum;
+    return (2 * count);
+}
+
+static u64 bench_utf8_codepoint_count(u64 size)
+{
+    oc_str8 text = bench_mixed_text(size);
+    bench_sink += oc_utf8_codepoint_count_for_string(text);
+    return (text.len);
+}
+
+static u64 bench_utf8_to_codepoints(u64 size)
+{
+    oc_str8 text = bench_mixed_text(size);
+    oc_str32 codePoints = oc_utf8_to_codepoints(BENCH_MAX_SIZE, bench.utf32Backing, text);
+    bench_sink += codePoints.len;
+    return (text.len);
+}
+
+static u64 bench_utf8_from_codepoints(u64 count)
+{
+    oc_str32 codePoints = oc_str32_from_buffer(oc_min(count, bench.codePointCount), bench.codePoints);
+    oc_str8 text = oc_utf8_from_codepoints(4 * BENCH_MAX_SIZE, bench.utf8Backing, codePoints);
+    bench_sink += text.len;
+    return (codePoints.len);
+}
+
+static u64 bench_str8_split(u64 size)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_str8_list separators = { 0 };
+    oc_str8_list_push(scratch.arena, &separators, OC_STR8(" "));
+    oc_str8_list words = oc_str8_split(scratch.arena, oc_str8_from_buffer(size, bench.ascii), separators);
+    bench_sink += words.eltCount;
+
+    oc_scratch_end(scratch);
+    return (size);
+}
+
+static u64 bench_ringbuffer_write_read(u64 size)
+{
+    //NOTE: records are written and read back in batches that fit in the ring, like the runtime's event queues
+    u8 record[BENCH_RING_RECORD_SIZE] = { 0 };
+    u64 recordCount = oc_max(1, size / BENCH_RING_RECORD_SIZE);
+    u64 batchSize = (1 << BENCH_RING_CAP_EXP) / BENCH_RING_RECORD_SIZE / 2;
+    u64 read = 0;
+
+    for(u64 i = 0; i < recordCount; i += batchSize)
+    {
+        u64 batchCount = oc_min(batchSize, recordCount - i);
+        for(u64 j = 0; j < batchCount; j++)
+        {
+            record[0] = (u8)j;
+            oc_ringbuffer_write(&bench.ring, BENCH_RING_RECORD_SIZE, record);
+        }
+        for(u64 j = 0; j < batchCount; j++)
+        {
+            read += oc_ringbuffer_read(&bench.ring, BENCH_RING_RECORD_SIZE, record);
+        }
+    }
+    bench_sink += read;
+    return (recordCount * BENCH_RING_RECORD_SIZE);
+}
+
+static u64 bench_list_push_pop(u64 count)
+{
+    oc_list list = { 0 };
+    for(u64 i = 0; i < count; i++)
+    {
+        bench.items[i].value = i;
+        oc_list_push_back(&list, &bench.items[i].listElt);
+    }
+    u64 sum = 0;
+    bench_list_item* item = 0;
+    while((item = oc_list_pop_front_entry(&list, bench_list_item, listElt)) != 0)
+    {
+        sum += item->value;
+    }
+    bench_sink += sum;
+    return (2 * count);
+}
+
+static u64 bench_list_iterate(u64 count)
+{
+    oc_list list = { 0 };
+    for(u64 i = 0; i < count; i++)
+    {
+        bench.items[i].value = i;
+        oc_list_push_back(&list, &bench.items[i].listElt);
+    }
+    u64 sum = 0;
+    oc_list_for(list, item, bench_list_item, listElt)
+    {
+        sum += item->value;
+    }
+    bench_sink += sum;
+    return (count);
+}
+
+//NOTE: the libm benchmarks call orca-libc's functions in the guest, and the host's libm in the native executable
+static u64 bench_libm_sinf(u64 count)
+{
+    for(u64 i = 0; i < count; i++)
+    {
+        bench.floatOut[i] = sinf(bench.angles[i]);
+    }
+    bench_sink += (u64)bench.floatOut[count / 2];
+    return (count);
+}
+
+static u64 bench_fast_sinf(u64 count)
+{
+    for(u64 i = 0; i < count; i++)
+    {
+        bench.floatOut[i] = oc_fast_sinf(bench.angles[i]);
+    }
+    bench_sink += (u64)bench.floatOut[count / 2];
+    return (count);
+}
+
+static u64 bench_fast_sinf_array(u64 count)
+{
+    oc_fast_sinf_array(count, bench.angles, bench.floatOut);
+    bench_sink += (u64)bench.floatOut[count / 2];
+    return (count);
+}
+
+static u64 bench_libm_expf(u64 count)
+{
+    for(u64 i = 0; i < count; i++)
+    {
+        bench.floatOut[i] = expf(bench.exponents[i]);
+    }
+    bench_sink += (u64)bench.floatOut[count / 2];
+    return (count);
+}
+
+static u64 bench_fast_expf_array(u64 count)
+{
+    oc_fast_expf_array(count, bench.exponents, bench.floatOut);
+    bench_sink += (u64)bench.floatOut[count / 2];
+    return (count);
+}
+
+static u64 bench_libm_logf(u64 count)
+{
+    for(u64 i = 0; i < count; i++)
+    {
+        bench.floatOut[i] = logf(bench.unitFloats[i]);
+    }
+    bench_sink += (u64)bench.floatOut[count / 2];
+    return (count);
+}
+
+static u64 bench_fast_logf_array(u64 count)
+{
+    oc_fast_logf_array(count, bench.unitFloats, bench.floatOut);
+    bench_sink += (u64)bench.floatOut[count / 2];
+    return (count);
+}
+
+//NOTE: a gamma curve, as in color conversions
+static u64 bench_libm_powf(u64 count)
+{
+    for(u64 i = 0; i < count; i++)
+    {
+        bench.floatOut[i] = powf(bench.unitFloats[i], 2.2f);
+    }
+    bench_sink += (u64)bench.floatOut[count / 2];
+    return (count);
+}
+
+static u64 bench_fast_powf_array(u64 count)
+{
+    oc_fast_powf_array(count, bench.unitFloats, 2.2f, bench.floatOut);
+    bench_sink += (u64)bench.floatOut[count / 2];
+    return (count);
+}
+
+static u64 bench_libm_sqrtf(u64 count)
+{
+    for(u64 i = 0; i < count; i++)
+    {
+        bench.floatOut[i] = sqrtf(bench.unitFloats[i]);
+    }
+    bench_sink += (u64)bench.floatOut[count / 2];
+    return (count);
+}
+
+static u64 bench_fast_sqrtf_array(u64 count)
+{
+    oc_fast_sqrtf_array(count, bench.unitFloats, bench.floatOut);
+    bench_sink += (u64)bench.floatOut[count / 2];
+    return (count);
+}
+
+typedef struct bench_entry
+{
+    const char* name;
+    bench_proc proc;
+    const char* unit; // what the size and operation count are measured in
+} bench_entry;
+
+static bench_entry BENCHMARKS[] = {
+    { "arena_push", bench_arena_push, "push" },
+    { "arena_push_4k", bench_arena_push_large, "push" },
+    { "arena_scope", bench_arena_scope, "scope" },
+    { "scratch_scope", bench_scratch_scope, "scope" },
+    { "pool_alloc_recycle", bench_pool_alloc_recycle, "block" },
+    { "hash_xx64", bench_hash_xx64, "byte" },
+    { "hash_map_insert_find", bench_hash_map_insert_find, "op" },
+    { "utf8_codepoint_count", bench_utf8_codepoint_count, "byte" },
+    { "utf8_to_codepoints", bench_utf8_to_codepoints, "byte" },
+    { "utf8_from_codepoints", bench_utf8_from_codepoints, "codepoint" },
+    { "str8_split", bench_str8_split, "byte" },
+    { "ringbuffer_write_read", bench_ringbuffer_write_read, "byte" },
+    { "list_push_pop", bench_list_push_pop, "op" },
+    { "list_iterate", bench_list_iterate, "element" },
+    { "libm_sinf", bench_libm_sinf, "element" },
+    { "fast_sinf", bench_fast_sinf, "element" },
+    { "fast_sinf_array", bench_fast_sinf_array, "element" },
+    { "libm_expf", bench_libm_expf, "element" },
+    { "fast_expf_array", bench_fast_expf_array, "element" },
+    { "libm_logf", bench_libm_logf, "element" },
+    { "fast_logf_array", bench_fast_logf_array, "element" },
+    { "libm_powf", bench_libm_powf, "element" },
+    { "fast_powf_array", bench_fast_powf_array, "element" },
+    { "libm_sqrtf", bench_libm_sqrtf, "element" },
+    { "fast_sqrtf_array", bench_fast_sqrtf_array, "element" },
+};
+
+static const u32 BENCHMARK_COUNT = sizeof(BENCHMARKS) / sizeof(bench_entry);
+
+//------------------------------------------------------------------------------------------
+// Driver
+//------------------------------------------------------------------------------------------
+
+typedef struct bench_options
+{
+    u32 sampleCount;
+    u32 warmupCount;
+    f64 minSampleTime; // in seconds, fast benchmarks repeat until a sample takes at least that long
+    bool jsonOutput;
+    const char* filter;
+} bench_options;
+
+typedef struct bench_stats
+{
+    u64 sampleCount;
+    f64 minSample;
+    f64 maxSample;
+    f64 avg;
+    f64 std;
+} bench_stats;
+
+static bench_stats bench_stats_compute(u32 sampleCount, f64* samples)
+{
+    bench_stats stats = { .sampleCount = sampleCount, .minSample = samples[0], .maxSample = samples[0] };
+    f64 sum = 0;
+    f64 sum2 = 0;
+    for(u32 i = 0; i < sampleCount; i++)
+    {
+        stats.minSample = oc_min(stats.minSample, samples[i]);
+        stats.maxSample = oc_max(stats.maxSample, samples[i]);
+        sum += samples[i];
+        sum2 += samples[i] * samples[i];
+    }
+    stats.avg = sum / sampleCount;
+    stats.std = sqrt(oc_max(sum2 / sampleCount - stats.avg * stats.avg, 0));
+    return (stats);
+}
+
+static void bench_print(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+#if OC_PLATFORM_ORCA
+    //NOTE: the guest has no stdout, results go to the runtime's log
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_str8 line = oc_str8_pushfv(scratch.arena, format, args);
+    oc_log_info("%.*s", oc_str8_ip(line));
+    oc_scratch_end(scratch);
+#else
+    vprintf(format, args);
+    fflush(stdout);
+#endif
+    va_end(args);
+}
+
+static void bench_run_all(bench_options* options)
+{
+    oc_arena arena;
+    oc_arena_init(&arena);
+    bench_inputs_init(&arena);
+
+    f64* samples = oc_arena_push_array(&arena, f64, options->sampleCount);
+
+    for(u32 benchIndex = 0; benchIndex < BENCHMARK_COUNT; benchIndex++)
+    {
+        bench_entry* entry = &BENCHMARKS[benchIndex];
+        if(options->filter && !strstr(entry->name, options->filter))
+        {
+            continue;
+        }
+
+        for(u32 sizeIndex = 0; sizeIndex < BENCH_SIZE_COUNT; sizeIndex++)
+        {
+            u64 size = BENCH_SIZES[sizeIndex];
+
+            //NOTE: warm up, so that arenas, pools and maps have grown and the caches are hot. The warm up also picks
+            //      how many times each sample repeats the benchmark, so that timer resolution doesn't dominate.
+            u64 repeat = 1;
+            for(u32 i = 0; i < options->warmupCount; i++)
+            {
+                f64 start = oc_clock_time(OC_CLOCK_MONOTONIC);
+                for(u64 j = 0; j < repeat; j++)
+                {
+                    entry->proc(size);
+                }
+                f64 elapsed = oc_clock_time(OC_CLOCK_MONOTONIC) - start;
+                if(elapsed < options->minSampleTime)
+                {
+                    repeat = (elapsed > 0)
+                             ? (u64)ceil(repeat * options->minSampleTime / elapsed)
+                             : repeat * 16;
+                }
+            }
+
+            u64 opCount = 0;
+            for(u32 sampleIndex = 0; sampleIndex < options->sampleCount; sampleIndex++)
+            {
+                opCount = 0;
+                f64 start = oc_clock_time(OC_CLOCK_MONOTONIC);
+                for(u64 j = 0; j < repeat; j++)
+                {
+                    opCount += entry->proc(size);
+                }
+                samples[sampleIndex] = (oc_clock_time(OC_CLOCK_MONOTONIC) - start) * 1000.;
+            }
+
+            bench_stats stats = bench_stats_compute(options->sampleCount, samples);
+            f64 opTime = stats.avg * 1000000. / oc_max(opCount, 1);
+
+            if(options->jsonOutput)
+            {
+                //NOTE: same layout as the wasm backend benchmarks, so that perf_suite.py can compare them
+                bench_print("{\"test\": \"%s\", \"target\": \"%s\", \"size\": %llu, \"unit\": \"%s\", \"ops\": %llu, "
+                            "\"time\": {\"smp\": %llu, \"min\": %.4f, \"max\": %.4f, \"avg\": %.4f, \"std\": %.4f}, "
+                            "\"op_ns\": %.3f}\n",
+                            entry->name,
+                            BENCH_TARGET_NAME,
+                            (unsigned long long)size,
+                            entry->unit,
+                            (unsigned long long)opCount,
+                            (unsigned long long)stats.sampleCount,
+                            stats.minSample,
+                            stats.maxSample,
+                            stats.avg,
+                            stats.std,
+                            opTime);
+            }
+            else
+            {
+                bench_print("%-22s %6llu  avg %8.3fms  min %8.3fms  max %8.3fms  std %6.3f  %10.3fns/%s\n",
+                            entry->name,
+                            (unsigned long long)size,
+                            stats.avg,
+                            stats.minSample,
+                            stats.maxSample,
+                            stats.std,
+                            opTime,
+                            entry->unit);
+            }
+        }
+    }
+
+    bench_inputs_cleanup();
+    oc_arena_cleanup(&arena);
+}
+
+#if OC_PLATFORM_ORCA
+
+ORCA_EXPORT void oc_on_init(void)
+{
+    //NOTE: the guest can't take arguments, it runs every benchmark with the default options and quits
+    bench_options options = {
+        .sampleCount = 30,
+        .warmupCount = 3,
+        .minSampleTime = 0.001,
+        .jsonOutput = true,
+    };
+    bench_run_all(&options);
+    oc_request_quit();
+}
+
+#else
+
+int main(int argc, char** argv)
+{
+    oc_log_set_level(OC_LOG_LEVEL_WARNING);
+    oc_clock_init();
+
+    bench_options options = {
+        .sampleCount = 30,
+        .warmupCount = 3,
+        .minSampleTime = 0.001,
+    };
+
+    for(int argIndex = 1; argIndex < argc; argIndex++)
+    {
+        if(!strcmp(argv[argIndex], "--json"))
+        {
+            options.jsonOutput = true;
+        }
+        else if(!strcmp(argv[argIndex], "--filter") && argIndex + 1 < argc)
+        {
+            argIndex++;
+            options.filter = argv[argIndex];
+        }
+        else if((!strcmp(argv[argIndex], "--samples") || !strcmp(argv[argIndex], "--warmup")) && argIndex + 1 < argc)
+        {
+            argIndex++;
+            char* end = 0;
+            u32 value = strtoul(argv[argIndex], &end, 10);
+            if(end == argv[argIndex] || end[0] != '\0' || value == 0)
+            {
+                oc_log_error("option %s should be a positive integer\n", argv[argIndex - 1]);
+                return (-1);
+            }
+            if(!strcmp(argv[argIndex - 1], "--samples"))
+            {
+                options.sampleCount = value;
+            }
+            else
+            {
+                options.warmupCount = value;
+            }
+        }
+        else
+        {
+            oc_log_error("usage: %s [--json] [--filter name] [--samples count] [--warmup count]\n", argv[0]);
+            return (-1);
+        }
+    }
+
+    bench_run_all(&options);
+    return (0);
+}
+
+#endif // OC_PLATFORM_ORCA
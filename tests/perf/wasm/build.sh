@@ -0,0 +1,47 @@
+#!/bin/bash
+
+set -euo pipefail
+
+BINDIR=../bin
+LIBDIR=../../../build/bin
+WASM3LIB=../../../build/lib/libwasm3.a
+BYTEBOXLIB=../../../build/bin/libbytebox.a
+SRCDIR=../../../src
+
+if [[ -x /usr/local/opt/llvm/bin/clang ]]; then
+  WASMCLANG=/usr/local/opt/llvm/bin/clang
+elif [[ -x /opt/homebrew/opt/llvm/bin/clang ]]; then
+  WASMCLANG=/opt/homebrew/opt/llvm/bin/clang
+else
+  echo "Could not find Homebrew clang; the guest module will probably not build."
+  WASMCLANG=clang
+fi
+
+INCLUDES="-I$SRCDIR"
+LIBS="-L$LIBDIR -lorca"
+FLAGS="-mmacos-version-min=13.0.0"
+
+mkdir -p $BINDIR
+
+# guest module, shared by all backends
+$WASMCLANG --target=wasm32 --no-standard-libraries -O2 -mbulk-memory -Wl,--no-entry \
+    -o $BINDIR/wasm_bench_guest.wasm guest.c
+
+# one host per backend. The backend libraries are built by `orca dev build-runtime --wasm-backend <backend>`
+if [[ -f $WASM3LIB ]]; then
+  clang -g -O3 $FLAGS $INCLUDES -I$SRCDIR/ext/wasm3/source -DOC_WASM_BACKEND_WASM3=1 -DOC_WASM_BACKEND_BYTEBOX=0 \
+      $LIBS $WASM3LIB -o $BINDIR/wasm_bench_wasm3 main.c
+  install_name_tool -add_rpath "@executable_path" $BINDIR/wasm_bench_wasm3
+else
+  echo "$WASM3LIB not found, skipping the wasm3 benchmark"
+fi
+
+if [[ -f $BYTEBOXLIB ]]; then
+  clang -g -O3 $FLAGS $INCLUDES -I$SRCDIR/ext/bytebox/zig-out/include -DOC_WASM_BACKEND_WASM3=0 -DOC_WASM_BACKEND_BYTEBOX=1 \
+      $LIBS $BYTEBOXLIB -o $BINDIR/wasm_bench_bytebox main.c
+  install_name_tool -add_rpath "@executable_path" $BINDIR/wasm_bench_bytebox
+else
+  echo "$BYTEBOXLIB not found, skipping the bytebox benchmark"
+fi
+
+cp $LIBDIR/liborca.dylib $BINDIR/
@@ -0,0 +1,181 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2024 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+
+//NOTE: the guest is freestanding so that it measures the backends and the host calls, not orca-libc. Every loop feeds
+//      its results back to the host, so that the compiler can't drop it.
+
+#define WASM_EXPORT(name) __attribute__((export_name(name)))
+#define WASM_IMPORT(name) __attribute__((import_module("env"), import_name(name)))
+
+WASM_IMPORT("bench_host_empty") void bench_host_empty(void);
+WASM_IMPORT("bench_host_i32x1") int32_t bench_host_i32x1(int32_t a);
+WASM_IMPORT("bench_host_i32x4") int32_t bench_host_i32x4(int32_t a, int32_t b, int32_t c, int32_t d);
+WASM_IMPORT("bench_host_i32x8") int32_t bench_host_i32x8(int32_t a, int32_t b, int32_t c, int32_t d,
+                                                         int32_t e, int32_t f, int32_t g, int32_t h);
+WASM_IMPORT("bench_host_i32x16") int32_t bench_host_i32x16(int32_t a, int32_t b, int32_t c, int32_t d,
+                                                           int32_t e, int32_t f, int32_t g, int32_t h,
+                                                           int32_t i, int32_t j, int32_t k, int32_t l,
+                                                           int32_t m, int32_t n, int32_t o, int32_t p);
+WASM_IMPORT("bench_host_mixed") double bench_host_mixed(int32_t a, int64_t b, float c, double d,
+                                                        int32_t e, int64_t f, float g, double h);
+WASM_IMPORT("bench_host_buffer") int32_t bench_host_buffer(const void* ptr, int32_t len);
+
+void* memset(void* b, int c, size_t n)
+{
+    return (__builtin_memset(b, c, n));
+}
+
+void* memcpy(void* dst, const void* src, size_t n)
+{
+    return (__builtin_memcpy(dst, src, n));
+}
+
+enum
+{
+    BUFFER_SIZE = 4 << 20,
+};
+
+static uint8_t bufferA[BUFFER_SIZE];
+static uint8_t bufferB[BUFFER_SIZE];
+
+//------------------------------------------------------------------------------------------
+// Host calls
+//------------------------------------------------------------------------------------------
+
+WASM_EXPORT("bench_host_calls_empty") int32_t bench_host_calls_empty(int32_t count)
+{
+    for(int32_t i = 0; i < count; i++)
+    {
+        bench_host_empty();
+    }
+    return (count);
+}
+
+WASM_EXPORT("bench_host_calls_i32x1") int32_t bench_host_calls_i32x1(int32_t count)
+{
+    int32_t acc = 0;
+    for(int32_t i = 0; i < count; i++)
+    {
+        acc += bench_host_i32x1(i);
+    }
+    return (acc);
+}
+
+WASM_EXPORT("bench_host_calls_i32x4") int32_t bench_host_calls_i32x4(int32_t count)
+{
+    int32_t acc = 0;
+    for(int32_t i = 0; i < count; i++)
+    {
+        acc += bench_host_i32x4(i, i + 1, i + 2, i + 3);
+    }
+    return (acc);
+}
+
+WASM_EXPORT("bench_host_calls_i32x8") int32_t bench_host_calls_i32x8(int32_t count)
+{
+    int32_t acc = 0;
+    for(int32_t i = 0; i < count; i++)
+    {
+        acc += bench_host_i32x8(i, i + 1, i + 2, i + 3, i + 4, i + 5, i + 6, i + 7);
+    }
+    return (acc);
+}
+
+WASM_EXPORT("bench_host_calls_i32x16") int32_t bench_host_calls_i32x16(int32_t count)
+{
+    int32_t acc = 0;
+    for(int32_t i = 0; i < count; i++)
+    {
+        acc += bench_host_i32x16(i, i + 1, i + 2, i + 3, i + 4, i + 5, i + 6, i + 7,
+                                 i + 8, i + 9, i + 10, i + 11, i + 12, i + 13, i + 14, i + 15);
+    }
+    return (acc);
+}
+
+WASM_EXPORT("bench_host_calls_mixed") int32_t bench_host_calls_mixed(int32_t count)
+{
+    double acc = 0;
+    for(int32_t i = 0; i < count; i++)
+    {
+        acc += bench_host_mixed(i, (int64_t)i << 32, i * 0.5f, i * 0.25, i + 1, i + 2, i * 2.f, i * 4.);
+    }
+    return ((int32_t)acc);
+}
+
+WASM_EXPORT("bench_host_calls_buffer") int32_t bench_host_calls_buffer(int32_t count, int32_t size)
+{
+    int32_t acc = 0;
+    for(int32_t i = 0; i < count; i++)
+    {
+        acc += bench_host_buffer(bufferA, size);
+    }
+    return (acc);
+}
+
+//------------------------------------------------------------------------------------------
+// Guest calls
+//------------------------------------------------------------------------------------------
+
+WASM_EXPORT("bench_empty") void bench_empty(void)
+{
+}
+
+WASM_EXPORT("bench_i32x4") int32_t bench_i32x4(int32_t a, int32_t b, int32_t c, int32_t d)
+{
+    return (a + b + c + d);
+}
+
+//------------------------------------------------------------------------------------------
+// Memory
+//------------------------------------------------------------------------------------------
+
+WASM_EXPORT("bench_mem_loop") int32_t bench_mem_loop(int32_t size, int32_t count)
+{
+    //NOTE: a dependent read-modify-write walk over the buffer, to exercise the backends' loads, stores and bounds checks
+    uint32_t mask = (uint32_t)size - 1;
+    uint32_t acc = 0;
+    uint32_t* words = (uint32_t*)bufferA;
+    uint32_t wordCount = (uint32_t)size / sizeof(uint32_t);
+
+    for(int32_t pass = 0; pass < count; pass++)
+    {
+        for(uint32_t i = 0; i < wordCount; i++)
+        {
+            uint32_t j = (i * 7 + acc) & (mask / sizeof(uint32_t));
+            words[i] = words[i] * 31 + words[j] + 1;
+            acc ^= words[i];
+        }
+    }
+    return ((int32_t)acc);
+}
+
+WASM_EXPORT("bench_memset") int32_t bench_memset(int32_t size, int32_t count)
+{
+    for(int32_t i = 0; i < count; i++)
+    {
+        memset(bufferA, i, size);
+    }
+    return (bufferA[size - 1]);
+}
+
+WASM_EXPORT("bench_memcpy") int32_t bench_memcpy(int32_t size, int32_t count)
+{
+    for(int32_t i = 0; i < count; i++)
+    {
+        bufferA[i & (size - 1)] = (uint8_t)i;
+        memcpy(bufferB, bufferA, size);
+    }
+    return (bufferB[(count - 1) & (size - 1)]);
+}
+
+WASM_EXPORT("bench_buffer_size") int32_t bench_buffer_size(void)
+{
+    return (BUFFER_SIZE);
+}
@@ -0,0 +1,455 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2024 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "orca.h"
+
+#include "wasm/wasm.c"
+#if OC_WASM_BACKEND_WASM3
+    #include "wasm/backend_wasm3.c"
+    #define BENCH_BACKEND_NAME "wasm3"
+#elif OC_WASM_BACKEND_BYTEBOX
+    #include "wasm/backend_bytebox.c"
+    #define BENCH_BACKEND_NAME "bytebox"
+#else
+    #error "Unknown wasm backend"
+#endif
+
+//------------------------------------------------------------------------------------------
+// Host bindings
+//------------------------------------------------------------------------------------------
+
+static void bench_host_empty_stub(const oc_wasm_slot* restrict params, oc_wasm_slot* restrict returns, u8* memory, oc_wasm* wasm)
+{
+}
+
+static void bench_host_i32_sum_stub(const oc_wasm_slot* restrict params, oc_wasm_slot* restrict returns, u8* memory, oc_wasm* wasm, u32 count)
+{
+    i32 sum = 0;
+    for(u32 i = 0; i < count; i++)
+    {
+        sum += *(i32*)&params[i];
+    }
+    *(i32*)&returns[0] = sum;
+}
+
+static void bench_host_i32x1_stub(const oc_wasm_slot* restrict params, oc_wasm_slot* restrict returns, u8* memory, oc_wasm* wasm)
+{
+    bench_host_i32_sum_stub(params, returns, memory, wasm, 1);
+}
+
+static void bench_host_i32x4_stub(const oc_wasm_slot* restrict params, oc_wasm_slot* restrict returns, u8* memory, oc_wasm* wasm)
+{
+    bench_host_i32_sum_stub(params, returns, memory, wasm, 4);
+}
+
+static void bench_host_i32x8_stub(const oc_wasm_slot* restrict params, oc_wasm_slot* restrict returns, u8* memory, oc_wasm* wasm)
+{
+    bench_host_i32_sum_stub(params, returns, memory, wasm, 8);
+}
+
+static void bench_host_i32x16_stub(const oc_wasm_slot* restrict params, oc_wasm_slot* restrict returns, u8* memory, oc_wasm* wasm)
+{
+    bench_host_i32_sum_stub(params, returns, memory, wasm, 16);
+}
+
+static void bench_host_mixed_stub(const oc_wasm_slot* restrict params, oc_wasm_slot* restrict returns, u8* memory, oc_wasm* wasm)
+{
+    f64 sum = *(i32*)&params[0]
+            + *(i64*)&params[1]
+            + *(f32*)&params[2]
+            + *(f64*)&params[3]
+            + *(i32*)&params[4]
+            + *(i64*)&params[5]
+            + *(f32*)&params[6]
+            + *(f64*)&params[7];
+    *(f64*)&returns[0] = sum;
+}
+
+static void bench_host_buffer_stub(const oc_wasm_slot* restrict params, oc_wasm_slot* restrict returns, u8* memory, oc_wasm* wasm)
+{
+    //NOTE: do the same bounds check as the generated bindings do for pointer arguments
+    u32 ptr = *(u32*)&params[0];
+    u32 len = *(u32*)&params[1];
+    i32 result = 0;
+    if(len && (u64)ptr + len <= oc_wasm_mem_size(wasm))
+    {
+        result = memory[ptr] + memory[ptr + len - 1];
+    }
+    *(i32*)&returns[0] = result;
+}
+
+typedef struct bench_binding
+{
+    const char* name;
+    oc_wasm_host_proc proc;
+    u32 countParams;
+    oc_wasm_valtype params[16];
+    u32 countReturns;
+    oc_wasm_valtype returns[1];
+} bench_binding;
+
+//NOTE: zeroed param types are i32
+static bench_binding BENCH_BINDINGS[] = {
+    { "bench_host_empty", bench_host_empty_stub, 0, { 0 }, 0, { 0 } },
+    { "bench_host_i32x1", bench_host_i32x1_stub, 1, { OC_WASM_VALTYPE_I32 }, 1, { OC_WASM_VALTYPE_I32 } },
+    { "bench_host_i32x4", bench_host_i32x4_stub, 4, { 0 }, 1, { OC_WASM_VALTYPE_I32 } },
+    { "bench_host_i32x8", bench_host_i32x8_stub, 8, { 0 }, 1, { OC_WASM_VALTYPE_I32 } },
+    { "bench_host_i32x16", bench_host_i32x16_stub, 16, { 0 }, 1, { OC_WASM_VALTYPE_I32 } },
+    {
+        "bench_host_mixed",
+        bench_host_mixed_stub,
+        8,
+        {
+            OC_WASM_VALTYPE_I32,
+            OC_WASM_VALTYPE_I64,
+            OC_WASM_VALTYPE_F32,
+            OC_WASM_VALTYPE_F64,
+            OC_WASM_VALTYPE_I32,
+            OC_WASM_VALTYPE_I64,
+            OC_WASM_VALTYPE_F32,
+            OC_WASM_VALTYPE_F64,
+        },
+        1,
+        { OC_WASM_VALTYPE_F64 },
+    },
+    { "bench_host_buffer", bench_host_buffer_stub, 2, { 0 }, 1, { OC_WASM_VALTYPE_I32 } },
+};
+
+static const u32 BENCH_BINDING_COUNT = sizeof(BENCH_BINDINGS) / sizeof(bench_binding);
+
+//------------------------------------------------------------------------------------------
+// Benchmarks table
+//------------------------------------------------------------------------------------------
+
+typedef struct bench_entry
+{
+    const char* name;
+    const char* function;
+    u32 countParams;
+    i32 params[4];
+    u32 countReturns;
+    u64 opCount;   // operations per sample, used to report the time of one operation
+    u32 hostCalls; // if not 0, the host calls the function that many times per sample, otherwise the guest loops
+} bench_entry;
+
+enum
+{
+    BENCH_HOST_CALL_COUNT = 100000,
+    BENCH_GUEST_CALL_COUNT = 10000,
+};
+
+static bench_entry BENCHMARKS[] = {
+    // host calls made by the guest
+    { "host_call_empty", "bench_host_calls_empty", 1, { BENCH_HOST_CALL_COUNT }, 1, BENCH_HOST_CALL_COUNT },
+    { "host_call_i32x1", "bench_host_calls_i32x1", 1, { BENCH_HOST_CALL_COUNT }, 1, BENCH_HOST_CALL_COUNT },
+    { "host_call_i32x4", "bench_host_calls_i32x4", 1, { BENCH_HOST_CALL_COUNT }, 1, BENCH_HOST_CALL_COUNT },
+    { "host_call_i32x8", "bench_host_calls_i32x8", 1, { BENCH_HOST_CALL_COUNT }, 1, BENCH_HOST_CALL_COUNT },
+    { "host_call_i32x16", "bench_host_calls_i32x16", 1, { BENCH_HOST_CALL_COUNT }, 1, BENCH_HOST_CALL_COUNT },
+    { "host_call_mixed", "bench_host_calls_mixed", 1, { BENCH_HOST_CALL_COUNT }, 1, BENCH_HOST_CALL_COUNT },
+    { "host_call_buffer", "bench_host_calls_buffer", 2, { BENCH_HOST_CALL_COUNT, 4096 }, 1, BENCH_HOST_CALL_COUNT },
+
+    // guest calls made by the host through oc_wasm_function_call()
+    { "guest_call_empty", "bench_empty", 0, { 0 }, 0, BENCH_GUEST_CALL_COUNT, BENCH_GUEST_CALL_COUNT },
+    { "guest_call_i32x4", "bench_i32x4", 4, { 1, 2, 3, 4 }, 1, BENCH_GUEST_CALL_COUNT, BENCH_GUEST_CALL_COUNT },
+
+    // memory-intensive guest loops, in 32-bit words processed
+    { "mem_loop_64k", "bench_mem_loop", 2, { 64 << 10, 64 }, 1, 64 * (64 << 10) / 4 },
+    { "mem_loop_4m", "bench_mem_loop", 2, { 4 << 20, 1 }, 1, (4 << 20) / 4 },
+
+    // bulk memory, in calls to memset/memcpy
+    { "memset_64", "bench_memset", 2, { 64, 10000 }, 1, 10000 },
+    { "memset_4k", "bench_memset", 2, { 4 << 10, 1000 }, 1, 1000 },
+    { "memset_1m", "bench_memset", 2, { 1 << 20, 16 }, 1, 16 },
+    { "memcpy_64", "bench_memcpy", 2, { 64, 10000 }, 1, 10000 },
+    { "memcpy_4k", "bench_memcpy", 2, { 4 << 10, 1000 }, 1, 1000 },
+    { "memcpy_1m", "bench_memcpy", 2, { 1 << 20, 16 }, 1, 16 },
+};
+
+static const u32 BENCHMARK_COUNT = sizeof(BENCHMARKS) / sizeof(bench_entry);
+
+//------------------------------------------------------------------------------------------
+// Driver
+//------------------------------------------------------------------------------------------
+
+typedef struct bench_stats
+{
+    u64 sampleCount;
+    f64 minSample;
+    f64 maxSample;
+    f64 avg;
+    f64 std;
+} bench_stats;
+
+static bench_stats bench_stats_compute(u32 sampleCount, f64* samples)
+{
+    bench_stats stats = { .sampleCount = sampleCount, .minSample = samples[0], .maxSample = samples[0] };
+    f64 sum = 0;
+    f64 sum2 = 0;
+    for(u32 i = 0; i < sampleCount; i++)
+    {
+        stats.minSample = oc_min(stats.minSample, samples[i]);
+        stats.maxSample = oc_max(stats.maxSample, samples[i]);
+        sum += samples[i];
+        sum2 += samples[i] * samples[i];
+    }
+    stats.avg = sum / sampleCount;
+    stats.std = sqrt(oc_max(sum2 / sampleCount - stats.avg * stats.avg, 0));
+    return (stats);
+}
+
+static void* bench_mem_resize(void* p, unsigned long newSize, void* userdata)
+{
+    return (realloc(p, newSize));
+}
+
+static void bench_mem_free(void* p, void* userdata)
+{
+    free(p);
+}
+
+static oc_wasm* bench_load_module(oc_arena* arena, oc_str8 path, oc_wasm_engine_options* engineOptions)
+{
+    oc_file file = oc_file_open(path, OC_FILE_ACCESS_READ, OC_FILE_OPEN_NONE);
+    if(oc_file_last_error(file) != OC_IO_OK)
+    {
+        oc_log_error("couldn't open module %.*s\n", oc_str8_ip(path));
+        oc_file_close(file);
+        return (0);
+    }
+    u64 size = oc_file_size(file);
+    char* contents = oc_arena_push(arena, size);
+    u64 read = oc_file_read(file, size, contents);
+    oc_file_close(file);
+    if(read != size)
+    {
+        oc_log_error("couldn't read module %.*s\n", oc_str8_ip(path));
+        return (0);
+    }
+
+    oc_wasm* wasm = oc_wasm_create();
+    oc_wasm_status status = oc_wasm_decode(wasm, oc_str8_from_buffer(size, contents));
+    if(oc_wasm_status_is_fail(status))
+    {
+        oc_log_error("couldn't decode module: %.*s\n", oc_str8_ip(oc_wasm_status_str8(status)));
+        return (0);
+    }
+
+    for(u32 i = 0; i < BENCH_BINDING_COUNT; i++)
+    {
+        bench_binding* entry = &BENCH_BINDINGS[i];
+        oc_wasm_binding binding = {
+            .importName = OC_STR8(entry->name),
+            .proc = entry->proc,
+            .params = entry->params,
+            .returns = entry->returns,
+            .countParams = entry->countParams,
+            .countReturns = entry->countReturns,
+        };
+        status = oc_wasm_add_binding(wasm, &binding);
+        if(oc_wasm_status_is_fail(status))
+        {
+            oc_log_error("couldn't add binding %s\n", entry->name);
+            return (0);
+        }
+    }
+
+    oc_wasm_mem_callbacks memCallbacks = {
+        .resizeProc = bench_mem_resize,
+        .freeProc = bench_mem_free,
+    };
+    oc_wasm_set_engine_options(wasm, engineOptions);
+    status = oc_wasm_instantiate(wasm, OC_STR8("wasm_bench"), memCallbacks);
+    if(oc_wasm_status_is_fail(status))
+    {
+        oc_log_error("couldn't instantiate module: %.*s\n", oc_str8_ip(oc_wasm_status_str8(status)));
+        return (0);
+    }
+    return (wasm);
+}
+
+static bool bench_run_sample(oc_wasm* wasm, oc_wasm_function_handle* handle, bench_entry* bench)
+{
+    oc_wasm_val params[4] = { 0 };
+    for(u32 i = 0; i < bench->countParams; i++)
+    {
+        params[i].I32 = bench->params[i];
+    }
+    oc_wasm_val returns[1] = { 0 };
+
+    u32 callCount = bench->hostCalls ? bench->hostCalls : 1;
+    for(u32 i = 0; i < callCount; i++)
+    {
+        oc_wasm_status status = oc_wasm_function_call(wasm, handle, params, bench->countParams, returns, bench->countReturns);
+        if(oc_wasm_status_is_fail(status))
+        {
+            oc_log_error("%s trapped: %.*s\n", bench->name, oc_str8_ip(oc_wasm_status_str8(status)));
+            return (false);
+        }
+    }
+    return (true);
+}
+
+int main(int argc, char** argv)
+{
+    oc_log_set_level(OC_LOG_LEVEL_WARNING);
+    oc_clock_init();
+
+    oc_str8 modulePath = OC_STR8("./bin/wasm_bench_guest.wasm");
+    u32 sampleCount = 30;
+    bool jsonOutput = false;
+    const char* filter = 0;
+    oc_wasm_engine_options engineOptions = { 0 };
+    const char* engineName = "";
+
+    for(int argIndex = 1; argIndex < argc; argIndex++)
+    {
+        if(!strcmp(argv[argIndex], "--json"))
+        {
+            jsonOutput = true;
+        }
+        else if(!strcmp(argv[argIndex], "--module") && argIndex + 1 < argc)
+        {
+            argIndex++;
+            modulePath = OC_STR8(argv[argIndex]);
+        }
+        else if(!strcmp(argv[argIndex], "--filter") && argIndex + 1 < argc)
+        {
+            argIndex++;
+            filter = argv[argIndex];
+        }
+        else if(!strcmp(argv[argIndex], "--samples") && argIndex + 1 < argc)
+        {
+            argIndex++;
+            char* end = 0;
+            sampleCount = strtoul(argv[argIndex], &end, 10);
+            if(end == argv[argIndex] || end[0] != '\0' || sampleCount == 0)
+            {
+                oc_log_error("option %s should be a positive integer\n", argv[argIndex - 1]);
+                return (-1);
+            }
+        }
+        else if(!strcmp(argv[argIndex], "--engine") && argIndex + 1 < argc)
+        {
+            //NOTE: comma separated engine options, e.g. vm=register,stack-size=1m
+            argIndex++;
+            engineName = argv[argIndex];
+
+            oc_str8 options = OC_STR8(engineName);
+            while(options.len)
+            {
+                u64 sep = oc_str8_find(options, OC_STR8(","));
+                oc_str8 option = oc_str8_slice(options, 0, sep);
+                if(!oc_wasm_engine_option_parse(&engineOptions, option))
+                {
+                    oc_log_error("unknown engine option %.*s\n", oc_str8_ip(option));
+                    return (-1);
+                }
+                options = oc_str8_slice(options, oc_min(sep + 1, options.len), options.len);
+            }
+        }
+        else
+        {
+            oc_log_error("usage: %s [--json] [--module path] [--filter name] [--samples count] [--engine options]\n", argv[0]);
+            return (-1);
+        }
+    }
+
+    oc_arena arena;
+    oc_arena_init(&arena);
+
+    oc_wasm* wasm = bench_load_module(&arena, modulePath, &engineOptions);
+    if(!wasm)
+    {
+        return (-1);
+    }
+
+    f64* samples = oc_arena_push_array(&arena, f64, sampleCount);
+    int result = 0;
+
+    for(u32 benchIndex = 0; benchIndex < BENCHMARK_COUNT; benchIndex++)
+    {
+        bench_entry* bench = &BENCHMARKS[benchIndex];
+        if(filter && !strstr(bench->name, filter))
+        {
+            continue;
+        }
+
+        oc_wasm_function_handle* handle = oc_wasm_function_find(wasm, OC_STR8(bench->function));
+        if(!handle)
+        {
+            oc_log_error("function %s not found in module\n", bench->function);
+            result = -1;
+            continue;
+        }
+
+        //NOTE: warm up once, so that lazily compiled functions and memory growth aren't measured
+        if(!bench_run_sample(wasm, handle, bench))
+        {
+            result = -1;
+            continue;
+        }
+
+        bool failed = false;
+        for(u32 sampleIndex = 0; sampleIndex < sampleCount; sampleIndex++)
+        {
+            f64 start = oc_clock_time(OC_CLOCK_MONOTONIC);
+            if(!bench_run_sample(wasm, handle, bench))
+            {
+                failed = true;
+                break;
+            }
+            samples[sampleIndex] = (oc_clock_time(OC_CLOCK_MONOTONIC) - start) * 1000.;
+        }
+        if(failed)
+        {
+            result = -1;
+            continue;
+        }
+
+        bench_stats stats = bench_stats_compute(sampleCount, samples);
+        f64 opTime = stats.avg * 1000000. / bench->opCount;
+
+        if(jsonOutput)
+        {
+            //NOTE: same layout as the canvas driver's results, so that perf_suite.py can compare them
+            printf("{\"test\": \"%s\", \"backend\": \"%s\", \"engine\": \"%s\", \"ops\": %llu, "
+                   "\"time\": {\"smp\": %llu, \"min\": %.4f, \"max\": %.4f, \"avg\": %.4f, \"std\": %.4f}, "
+                   "\"op_ns\": %.3f}\n",
+                   bench->name,
+                   BENCH_BACKEND_NAME,
+                   engineName,
+                   (unsigned long long)bench->opCount,
+                   (unsigned long long)stats.sampleCount,
+                   stats.minSample,
+                   stats.maxSample,
+                   stats.avg,
+                   stats.std,
+                   opTime);
+        }
+        else
+        {
+            printf("%-20s avg %8.3fms  min %8.3fms  max %8.3fms  std %6.3f  %10.2fns/op\n",
+                   bench->name,
+                   stats.avg,
+                   stats.minSample,
+                   stats.maxSample,
+                   stats.std,
+                   opTime);
+        }
+        fflush(stdout);
+    }
+
+    oc_wasm_destroy(wasm);
+    oc_arena_cleanup(&arena);
+
+    return (result);
+}
@@ -0,0 +1,56 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+
+// NOTE: pull in the orca-libc implementations, compiled with -msimd128 so that they take their SIMD paths
+#include "../../src/orca-libc/src/string/memchr.c"
+#include "../../src/orca-libc/src/string/strlen.c"
+
+#ifndef __wasm_simd128__
+    #error "this test must be compiled with -msimd128"
+#endif
+
+int _start()
+{
+    _Alignas(16) char buffer[256];
+
+    // check every alignment and length combination, so that we cover heads, tails and block boundaries
+    for(size_t offset = 0; offset < 32; offset++)
+    {
+        for(size_t len = 0; len < 128; len++)
+        {
+            for(size_t i = 0; i < sizeof(buffer); i++)
+            {
+                buffer[i] = 'a';
+            }
+            //NOTE: put a decoy before the string to check that the first block is masked
+            if(offset)
+            {
+                buffer[offset - 1] = 0;
+            }
+            buffer[offset + len] = 0;
+
+            if(strlen(buffer + offset) != len)
+            {
+                __builtin_trap();
+            }
+
+            buffer[offset + len] = 'b';
+            if(memchr(buffer + offset, 'b', len) != 0)
+            {
+                __builtin_trap();
+            }
+            if(memchr(buffer + offset, 'b', len + 1) != buffer + offset + len)
+            {
+                __builtin_trap();
+            }
+        }
+    }
+    return (0);
+}
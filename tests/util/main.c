@@ -0,0 +1,594 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2024 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+
+#define OC_NO_APP_LAYER
+#include "orca.c"
+
+//NOTE: orca-libc's qsort() is only built into the guest library, so its introsort is compiled here under another
+//      name, to be checked against the host's qsort()
+#define hidden static
+#define weak_alias(old, new)
+#define __qsort_r test_introsort_r
+#define __qsort test_introsort
+#include "orca-libc/src/stdlib/qsort.c"
+#undef hidden
+#undef weak_alias
+#undef __qsort_r
+#undef __qsort
+
+//NOTE: a fixed pseudo-random sequence, so that failures can be reproduced
+static u64 test_random(u64* state)
+{
+    u64 z = (*state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return (z ^ (z >> 31));
+}
+
+//------------------------------------------------------------------------------------------
+// Hash map
+//------------------------------------------------------------------------------------------
+
+enum
+{
+    HASH_MAP_TEST_KEY_COUNT = 2048,
+    HASH_MAP_TEST_OP_COUNT = 200000,
+    HASH_MAP_TEST_CHECK_PERIOD = 4096,
+};
+
+//NOTE: the reference is a plain array indexed by the position of the key in the key table
+typedef struct hash_map_test_ref
+{
+    u64 keys[HASH_MAP_TEST_KEY_COUNT];
+    u64 values[HASH_MAP_TEST_KEY_COUNT];
+    bool present[HASH_MAP_TEST_KEY_COUNT];
+    u64 count;
+} hash_map_test_ref;
+
+static int hash_map_test_check(oc_hash_map* map, hash_map_test_ref* ref)
+{
+    if(map->count != ref->count)
+    {
+        oc_log_error("map has %llu entries instead of %llu\n", map->count, ref->count);
+        return (-1);
+    }
+
+    for(u32 i = 0; i < HASH_MAP_TEST_KEY_COUNT; i++)
+    {
+        u64* value = oc_hash_map_find_type(map, ref->keys[i], u64);
+        if(ref->present[i] != (value != 0))
+        {
+            oc_log_error("key %llx should %s\n", ref->keys[i], ref->present[i] ? "be found" : "not be found");
+            return (-1);
+        }
+        if(value && *value != ref->values[i])
+        {
+            oc_log_error("key %llx has value %llx instead of %llx\n", ref->keys[i], *value, ref->values[i]);
+            return (-1);
+        }
+    }
+
+    //NOTE: iteration must visit each entry exactly once. Values hold the index of their key in the upper bits, so
+    //      that visited keys can be looked up in the reference.
+    u64 visited = 0;
+    u64 index = 0;
+    u64 key = 0;
+    u64* value = 0;
+    while((value = oc_hash_map_next(map, &index, &key)) != 0)
+    {
+        u32 i = (u32)(*value >> 48);
+        if(i >= HASH_MAP_TEST_KEY_COUNT || ref->keys[i] != key || !ref->present[i] || ref->values[i] != *value)
+        {
+            oc_log_error("iteration visited key %llx, which isn't in the map\n", key);
+            return (-1);
+        }
+        visited++;
+    }
+    if(visited != ref->count)
+    {
+        oc_log_error("iteration visited %llu entries instead of %llu\n", visited, ref->count);
+        return (-1);
+    }
+    return (0);
+}
+
+static int hash_map_test_run(oc_hash_map* map, u64 seed)
+{
+    hash_map_test_ref* ref = oc_malloc_type(hash_map_test_ref);
+    memset(ref, 0, sizeof(hash_map_test_ref));
+
+    //NOTE: half the keys are small consecutive integers, like indices or handles, and half are random. 0 and ~0 are
+    //      valid keys too.
+    u64 rng = seed;
+    for(u32 i = 0; i < HASH_MAP_TEST_KEY_COUNT; i++)
+    {
+        ref->keys[i] = (i < HASH_MAP_TEST_KEY_COUNT / 2) ? i : test_random(&rng);
+    }
+    ref->keys[HASH_MAP_TEST_KEY_COUNT - 1] = ~0ULL;
+
+    int result = 0;
+    for(u32 op = 0; op < HASH_MAP_TEST_OP_COUNT && !result; op++)
+    {
+        //NOTE: alternate phases that mostly insert and phases that mostly remove, so that the map grows, fills up
+        //      with tombstones, and gets rehashed in place
+        u64 r = test_random(&rng);
+        bool growing = (op / 16384) % 2 == 0;
+        u32 insertChance = growing ? 3 : 1;
+        u32 i = (u32)((r >> 8) % HASH_MAP_TEST_KEY_COUNT);
+        u64 key = ref->keys[i];
+
+        if((r & 0x3) < insertChance)
+        {
+            bool inserted = false;
+            u64* value = oc_hash_map_insert_type(map, key, u64, &inserted);
+            if(inserted == ref->present[i] || (inserted && *value != 0))
+            {
+                oc_log_error("inserting key %llx: inserted is %i, value is %llx\n", key, inserted, *value);
+                result = -1;
+                break;
+            }
+            if(inserted)
+            {
+                ref->present[i] = true;
+                ref->count++;
+            }
+            ref->values[i] = ((u64)i << 48) | (test_random(&rng) >> 16);
+            *value = ref->values[i];
+        }
+        else
+        {
+            if(oc_hash_map_remove(map, key) != ref->present[i])
+            {
+                oc_log_error("removing key %llx returned %i\n", key, !ref->present[i]);
+                result = -1;
+                break;
+            }
+            if(ref->present[i])
+            {
+                ref->present[i] = false;
+                ref->count--;
+            }
+        }
+
+        if((op % HASH_MAP_TEST_CHECK_PERIOD) == 0)
+        {
+            result = hash_map_test_check(map, ref);
+        }
+    }
+
+    if(!result)
+    {
+        result = hash_map_test_check(map, ref);
+    }
+    if(!result)
+    {
+        oc_hash_map_clear(map);
+        memset(ref->present, 0, sizeof(ref->present));
+        ref->count = 0;
+        result = hash_map_test_check(map, ref);
+    }
+
+    free(ref);
+    return (result);
+}
+
+int test_hash_map()
+{
+    oc_log_info("hash map\n");
+
+    oc_hash_map map;
+    oc_hash_map_init(&map, sizeof(u64));
+    int result = hash_map_test_run(&map, 1);
+    oc_hash_map_cleanup(&map);
+    if(result)
+    {
+        oc_log_error("hash map test failed\n");
+        return (-1);
+    }
+
+    //NOTE: same with tables allocated from an arena, and a starting capacity
+    oc_arena arena;
+    oc_arena_init(&arena);
+    oc_hash_map_options options = {
+        .arena = &arena,
+        .capacity = 100,
+    };
+    oc_hash_map_init_with_options(&map, sizeof(u64), &options);
+    result = hash_map_test_run(&map, 2);
+    oc_hash_map_cleanup(&map);
+    oc_arena_cleanup(&arena);
+    if(result)
+    {
+        oc_log_error("hash map test with an arena failed\n");
+        return (-1);
+    }
+    return (0);
+}
+
+//------------------------------------------------------------------------------------------
+// Sorts
+//------------------------------------------------------------------------------------------
+
+enum
+{
+    SORT_TEST_MAX_COUNT = 50000,
+};
+
+//NOTE: counts around OC_RADIX_SORT_MIN_COUNT and INSERTION_SORT_THRESHOLD, where the sorts switch algorithms
+static const u64 SORT_TEST_COUNTS[] = { 0, 1, 2, 16, 17, 63, 64, 65, 1000, SORT_TEST_MAX_COUNT };
+static const u32 SORT_TEST_COUNT_COUNT = sizeof(SORT_TEST_COUNTS) / sizeof(u64);
+
+typedef enum sort_test_input
+{
+    SORT_TEST_RANDOM,
+    SORT_TEST_FEW_VALUES,
+    SORT_TEST_ASCENDING,
+    SORT_TEST_DESCENDING,
+    SORT_TEST_EQUAL,
+    SORT_TEST_INPUT_COUNT,
+} sort_test_input;
+
+static const char* SORT_TEST_INPUT_NAMES[SORT_TEST_INPUT_COUNT] = {
+    "random",
+    "few values",
+    "ascending",
+    "descending",
+    "equal",
+};
+
+typedef enum sort_test_type
+{
+    SORT_TEST_U32,
+    SORT_TEST_U64,
+    SORT_TEST_F32,
+    SORT_TEST_TYPE_COUNT,
+} sort_test_type;
+
+static const char* SORT_TEST_TYPE_NAMES[SORT_TEST_TYPE_COUNT] = {
+    "u32",
+    "u64",
+    "f32",
+};
+
+typedef struct sort_test_item
+{
+    u64 key;
+    u32 index;
+    u32 check;
+} sort_test_item;
+
+typedef struct sort_test_buffers
+{
+    u64* keys;
+    sort_test_item* ref;
+    sort_test_item* items;
+    u64* sorted;
+    u32* values;
+    u8* seen;
+} sort_test_buffers;
+
+//NOTE: u32 and f32 keys are the low 32 bits of the generated keys. Repeated bytes in the few values input make every
+//      radix pass matter, and the random f32 keys include zeros, infinities and NaNs of both signs.
+static void sort_test_generate(sort_test_input input, u64* keys, u64 count, u64* rng)
+{
+    static const u64 specials[] = { 0x00000000, 0x80000000, 0x7f800000, 0xff800000, 0x7fc00000, 0xffc00000 };
+
+    for(u64 i = 0; i < count; i++)
+    {
+        switch(input)
+        {
+            case SORT_TEST_RANDOM:
+                keys[i] = (i % 97 == 0) ? specials[(i / 97) % 6] : test_random(rng);
+                break;
+            case SORT_TEST_FEW_VALUES:
+                keys[i] = (test_random(rng) % 7) * 0x0101010101010101;
+                break;
+            case SORT_TEST_ASCENDING:
+                keys[i] = i * 0x0001000100010001;
+                break;
+            case SORT_TEST_DESCENDING:
+                keys[i] = (count - i) * 0x0001000100010001;
+                break;
+            default:
+                keys[i] = 0x4242424242424242;
+                break;
+        }
+    }
+}
+
+//NOTE: returns a u64 that orders like the key does as the given type. For f32 that's the order documented in
+//      util/sort.h: -0 before +0, and NaNs after +inf, or before -inf when their sign bit is set.
+static u64 sort_test_order_key(sort_test_type type, u64 key)
+{
+    switch(type)
+    {
+        case SORT_TEST_U32:
+            return ((u32)key);
+        case SORT_TEST_U64:
+            return (key);
+        default:
+        {
+            u32 bits = (u32)key;
+            return ((bits & 0x80000000) ? ~bits : (bits | 0x80000000));
+        }
+    }
+}
+
+static void sort_test_store(sort_test_type type, void* buffer, u64 index, u64 key)
+{
+    if(type == SORT_TEST_U64)
+    {
+        memcpy((char*)buffer + index * sizeof(u64), &key, sizeof(u64));
+    }
+    else
+    {
+        u32 bits = (u32)key;
+        memcpy((char*)buffer + index * sizeof(u32), &bits, sizeof(u32));
+    }
+}
+
+static u64 sort_test_load(sort_test_type type, void* buffer, u64 index)
+{
+    if(type == SORT_TEST_U64)
+    {
+        u64 key;
+        memcpy(&key, (char*)buffer + index * sizeof(u64), sizeof(u64));
+        return (key);
+    }
+    else
+    {
+        u32 bits;
+        memcpy(&bits, (char*)buffer + index * sizeof(u32), sizeof(u32));
+        return (bits);
+    }
+}
+
+static int sort_test_compare_stable(const void* a, const void* b)
+{
+    const sort_test_item* itemA = (const sort_test_item*)a;
+    const sort_test_item* itemB = (const sort_test_item*)b;
+    if(itemA->key != itemB->key)
+    {
+        return ((itemA->key < itemB->key) ? -1 : 1);
+    }
+    return ((itemA->index < itemB->index) ? -1 : (itemA->index > itemB->index));
+}
+
+static int sort_test_compare_key(const void* a, const void* b)
+{
+    const sort_test_item* itemA = (const sort_test_item*)a;
+    const sort_test_item* itemB = (const sort_test_item*)b;
+    return ((itemA->key < itemB->key) ? -1 : (itemA->key > itemB->key));
+}
+
+static int sort_test_compare_u64(const void* a, const void* b)
+{
+    u64 keyA = *(const u64*)a;
+    u64 keyB = *(const u64*)b;
+    return ((keyA < keyB) ? -1 : (keyA > keyB));
+}
+
+static int sort_test_compare_u32(const void* a, const void* b)
+{
+    u32 keyA = *(const u32*)a;
+    u32 keyB = *(const u32*)b;
+    return ((keyA < keyB) ? -1 : (keyA > keyB));
+}
+
+static int sort_test_compare_u32_r(const void* a, const void* b, void* arg)
+{
+    (*(u64*)arg)++;
+    u32 keyA = *(const u32*)a;
+    u32 keyB = *(const u32*)b;
+    return ((keyA < keyB) ? -1 : (keyA > keyB));
+}
+
+//NOTE: the reference is qsort() on (key, original index), which is the only order a stable sort can produce. Sorted
+//      values must be the original indices in that order.
+static int sort_test_radix(sort_test_type type, sort_test_buffers* buffers, u64 count)
+{
+    for(u64 i = 0; i < count; i++)
+    {
+        buffers->ref[i] = (sort_test_item){
+            .key = sort_test_order_key(type, buffers->keys[i]),
+            .index = (u32)i,
+        };
+    }
+    qsort(buffers->ref, count, sizeof(sort_test_item), sort_test_compare_stable);
+
+    for(u32 pairs = 0; pairs < 2; pairs++)
+    {
+        void* sorted = buffers->sorted;
+        for(u64 i = 0; i < count; i++)
+        {
+            sort_test_store(type, sorted, i, buffers->keys[i]);
+            buffers->values[i] = (u32)i;
+        }
+
+        if(pairs)
+        {
+            switch(type)
+            {
+                case SORT_TEST_U32:
+                    oc_sort_u32_pairs(sorted, buffers->values, count);
+                    break;
+                case SORT_TEST_U64:
+                    oc_sort_u64_pairs(sorted, buffers->values, count);
+                    break;
+                default:
+                    oc_sort_f32_pairs(sorted, buffers->values, count);
+                    break;
+            }
+        }
+        else
+        {
+            switch(type)
+            {
+                case SORT_TEST_U32:
+                    oc_sort_u32(sorted, count);
+                    break;
+                case SORT_TEST_U64:
+                    oc_sort_u64(sorted, count);
+                    break;
+                default:
+                    oc_sort_f32(sorted, count);
+                    break;
+            }
+        }
+
+        for(u64 i = 0; i < count; i++)
+        {
+            u32 index = buffers->ref[i].index;
+            u64 expected = (type == SORT_TEST_U64) ? buffers->keys[index] : (u32)buffers->keys[index];
+            if(sort_test_load(type, sorted, i) != expected)
+            {
+                oc_log_error("key %llu is out of order\n", i);
+                return (-1);
+            }
+            if(pairs && buffers->values[i] != index)
+            {
+                oc_log_error("value %llu is %u instead of %u, the sort isn't stable\n", i, buffers->values[i], index);
+                return (-1);
+            }
+        }
+    }
+    return (0);
+}
+
+//NOTE: the introsort isn't stable, so items are checked for order against qsort() and to be a permutation of the
+//      input. Arrays of u32 and u64 go through its swap fast paths, and qsort_r() passes its argument through.
+static int sort_test_introsort(sort_test_buffers* buffers, u64 count)
+{
+    for(u64 i = 0; i < count; i++)
+    {
+        buffers->items[i] = (sort_test_item){
+            .key = buffers->keys[i],
+            .index = (u32)i,
+            .check = ~(u32)i,
+        };
+        buffers->ref[i] = buffers->items[i];
+        buffers->seen[i] = 0;
+    }
+    qsort(buffers->ref, count, sizeof(sort_test_item), sort_test_compare_key);
+    test_introsort(buffers->items, count, sizeof(sort_test_item), sort_test_compare_key);
+
+    for(u64 i = 0; i < count; i++)
+    {
+        sort_test_item* item = &buffers->items[i];
+        if(item->key != buffers->ref[i].key)
+        {
+            oc_log_error("item %llu is out of order\n", i);
+            return (-1);
+        }
+        if(item->index >= count
+           || buffers->seen[item->index]
+           || item->check != ~item->index
+           || item->key != buffers->keys[item->index])
+        {
+            oc_log_error("item %llu was lost or corrupted\n", i);
+            return (-1);
+        }
+        buffers->seen[item->index] = 1;
+    }
+
+    u64* ref64 = (u64*)buffers->ref;
+    memcpy(ref64, buffers->keys, count * sizeof(u64));
+    memcpy(buffers->sorted, buffers->keys, count * sizeof(u64));
+    qsort(ref64, count, sizeof(u64), sort_test_compare_u64);
+    test_introsort(buffers->sorted, count, sizeof(u64), sort_test_compare_u64);
+    if(memcmp(ref64, buffers->sorted, count * sizeof(u64)))
+    {
+        oc_log_error("u64 keys are out of order\n");
+        return (-1);
+    }
+
+    u32* ref32 = (u32*)buffers->ref;
+    u32* sorted32 = (u32*)buffers->sorted;
+    for(u64 i = 0; i < count; i++)
+    {
+        ref32[i] = sorted32[i] = (u32)buffers->keys[i];
+    }
+    qsort(ref32, count, sizeof(u32), sort_test_compare_u32);
+    u64 compareCount = 0;
+    test_introsort_r(sorted32, count, sizeof(u32), sort_test_compare_u32_r, &compareCount);
+    if(memcmp(ref32, sorted32, count * sizeof(u32)) || (count > 1 && !compareCount))
+    {
+        oc_log_error("u32 keys are out of order\n");
+        return (-1);
+    }
+    return (0);
+}
+
+int test_sort()
+{
+    oc_log_info("sort\n");
+
+    sort_test_buffers buffers = {
+        .keys = oc_malloc_array(u64, SORT_TEST_MAX_COUNT),
+        .ref = oc_malloc_array(sort_test_item, SORT_TEST_MAX_COUNT),
+        .items = oc_malloc_array(sort_test_item, SORT_TEST_MAX_COUNT),
+        .sorted = oc_malloc_array(u64, SORT_TEST_MAX_COUNT),
+        .values = oc_malloc_array(u32, SORT_TEST_MAX_COUNT),
+        .seen = oc_malloc_array(u8, SORT_TEST_MAX_COUNT),
+    };
+
+    int result = 0;
+    u64 rng = 3;
+    for(u32 countIndex = 0; countIndex < SORT_TEST_COUNT_COUNT && !result; countIndex++)
+    {
+        u64 count = SORT_TEST_COUNTS[countIndex];
+        for(u32 input = 0; input < SORT_TEST_INPUT_COUNT && !result; input++)
+        {
+            sort_test_generate(input, buffers.keys, count, &rng);
+
+            for(u32 type = 0; type < SORT_TEST_TYPE_COUNT && !result; type++)
+            {
+                result = sort_test_radix(type, &buffers, count);
+                if(result)
+                {
+                    oc_log_error("radix sort of %llu %s %s keys failed\n",
+                                 count,
+                                 SORT_TEST_INPUT_NAMES[input],
+                                 SORT_TEST_TYPE_NAMES[type]);
+                }
+            }
+            if(!result)
+            {
+                result = sort_test_introsort(&buffers, count);
+                if(result)
+                {
+                    oc_log_error("introsort of %llu %s keys failed\n", count, SORT_TEST_INPUT_NAMES[input]);
+                }
+            }
+        }
+    }
+
+    free(buffers.keys);
+    free(buffers.ref);
+    free(buffers.items);
+    free(buffers.sorted);
+    free(buffers.values);
+    free(buffers.seen);
+    return (result);
+}
+
+int main(int argc, char** argv)
+{
+    if(test_hash_map())
+    {
+        return (-1);
+    }
+    if(test_sort())
+    {
+        return (-1);
+    }
+
+    oc_log_info("OK\n");
+
+    return (0);
+}